@@ -22,6 +22,15 @@ WORKSPACE="${4:-${GITHUB_WORKSPACE:-$(pwd)}}"
 
 [[ -f "$CONFIG_YAML" ]] || { log_err "config not found: $CONFIG_YAML"; exit 1; }
 [[ -d "$HEAD_PATH"   ]] || { log_err "HEAD_PATH not a directory: $HEAD_PATH"; exit 1; }
+
+# `armor select-headers` expands the patterns in one parallel walk of the tree,
+# writing the same lists; the yq/find loops below are used without it
+ARMOR_CMD="${ARMOR_CMD:-${ARMOR_BINS_PATH:-armor}}"
+if "$ARMOR_CMD" select-headers --help 2>/dev/null | grep -q -- '--changed-files'; then
+  log_info "[parse_headers] expanding with $ARMOR_CMD select-headers"
+  exec "$ARMOR_CMD" select-headers --workspace "$WORKSPACE" "$CONFIG_YAML" "$BRANCH" "$HEAD_PATH"
+fi
+
 command -v yq >/dev/null 2>&1 || { log_err "yq is required but not installed"; exit 1; }
 
 mkdir -p "$WORKSPACE"
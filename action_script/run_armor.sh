@@ -11,13 +11,37 @@ set -euo pipefail
 #
 # Environment (optional):
 #   PROJECT, BRANCH, GITHUB_EVENT, PR_NUMBER, HEADER_DIR, INCLUDE_PATHS, MACRO_FLAGS,
-#   REPORT_FORMAT=json, LOG_LEVEL, DUMP_AST_DIFF, ARMOR_CMD, HEAD_SHA, BASE_SHA
+#   REPORT_FORMAT=json, LOG_LEVEL, DUMP_AST_DIFF, ARMOR_CMD, HEAD_SHA, BASE_SHA,
+#   CHANGED_RANGES_ONLY=true (only diff declarations touched by git diff -U0 hunks)
+#   TRACE_OUT_DIR (write a Chrome trace-event file per armor run into this directory)
+#   SHARD=i/N (only compare this runner's share of the headers; combine with armor merge)
+#   JOBS=auto, MAX_MEMORY=auto (--jobs and --max-memory; auto reads the container's cgroup limits)
+#
+# With a non-empty blocking_headers_final.txt, every round writes the gate verdict of its
+# blocking headers to ${OUT_ROOT}/gate_round<N>.json before it compares the others.
 # ==============================================================================
 
 log()  { printf "\033[1;34m[INFO]\033[0m %s\n" "$*" >&2; }
 warn() { printf "\033[1;33m[WARN]\033[0m %s\n" "$*" >&2; }
 die()  { printf "\033[1;31m[ERR]\033[0m %s\n" "$*" >&2; exit 1; }
 
+# Writes the --changed-ranges JSON of one header from its -U0 hunks.
+# A hunk with no lines on one side is recorded as the line it follows.
+changed_ranges_json() {
+  local old="$1" new="$2" key="$3"
+  { git diff --no-index -U0 -- "$old" "$new" 2>/dev/null || true; } | awk -v key="$key" '
+    function span(spec,   parts, n, start, count) {
+      n = split(spec, parts, ","); start = parts[1] + 0; count = (n > 1) ? parts[2] + 0 : 1
+      if (count == 0) count = 1
+      return "[" start "," start + count - 1 "]"
+    }
+    /^@@/ {
+      o = span(substr($2, 2)); w = span(substr($3, 2))
+      olds = olds (olds ? "," : "") o; news = news (news ? "," : "") w
+    }
+    END { printf "{\"%s\":{\"old\":[%s],\"new\":[%s]}}\n", key, olds, news }'
+}
+
 BASE_PATH="${1:-}"; HEAD_PATH="${2:-}"; INTERSECTION_FILE="${3:-}"; ARMOR_BINS_PATH="${4:-}"
 [[ -d "$BASE_PATH" ]] || die "BASE_PATH not a directory"
 [[ -d "$HEAD_PATH" ]] || die "HEAD_PATH not a directory"
@@ -31,6 +55,11 @@ workflow_url="${workflow_url:-}"
 REPORT_FORMAT="${REPORT_FORMAT:-json}"
 LOG_LEVEL="${LOG_LEVEL:-INFO}"
 DUMP_AST_DIFF="${DUMP_AST_DIFF:-false}"
+CHANGED_RANGES_ONLY="${CHANGED_RANGES_ONLY:-false}"
+TRACE_OUT_DIR="${TRACE_OUT_DIR:-}"
+SHARD="${SHARD:-}"
+# Absolute, as armor runs inside a per-round work directory
+[[ -n "$TRACE_OUT_DIR" ]] && TRACE_OUT_DIR="$(mkdir -p "$TRACE_OUT_DIR" && cd "$TRACE_OUT_DIR" && pwd)"
 HEADER_DIR="${HEADER_DIR:-}"
 INCLUDE_PATHS="${INCLUDE_PATHS:-}"
 MACRO_FLAGS="${MACRO_FLAGS:-}"
@@ -58,64 +87,86 @@ mapfile -t HEADERS < <(grep -v '^[[:space:]]*$' "$INTERSECTION_FILE" || true)
 METADATA_NDJSON="${OUT_ROOT}/.headers.ndjson"; : > "$METADATA_NDJSON"
 
 for header in "${HEADERS[@]}"; do
-  hdr_arg="$header"; [[ -n "$HEADER_DIR" ]] && hdr_arg="$(basename "$header")"
-  safe="$(echo "$header" | sed 's/[^A-Za-z0-9_.-]/_/g')"
-  WORK_DIR="$(mktemp -d "${GITHUB_WORKSPACE}/.armor_${safe}.XXXXXX")"
+  for root in "$BASE_PATH" "$HEAD_PATH"; do
+    if [[ ! -f "$root/$header" ]]; then
+      log "Header missing; creating empty placeholder: $root/$header"
+      mkdir -p "$(dirname "$root/$header")"
+      : > "$root/$header"
+    fi
+  done
+done
+
+# Reports are named after the header's basename, so headers sharing one go to
+# separate rounds; every round is a single armor process over all its headers
+declare -A name_rounds=() round_headers=()
+rounds=0
+for header in "${HEADERS[@]}"; do
+  name="$(basename "$header")"
+  round=$(( ${name_rounds[$name]:-0} + 1 )); name_rounds[$name]=$round
+  (( round > rounds )) && rounds=$round
+  round_headers[$round]+="$header"$'\n'
+done
+
+for (( round = 1; round <= rounds; round++ )); do
+  WORK_DIR="$(mktemp -d "${GITHUB_WORKSPACE}/.armor_round${round}.XXXXXX")"
   pushd "$WORK_DIR" >/dev/null
+  printf '%s' "${round_headers[$round]}" > headers.txt
+  if [[ -n "$HEADER_DIR" ]]; then
+    sed 's#.*/##' headers.txt > headers_list.txt
+  else
+    cp headers.txt headers_list.txt
+  fi
 
-  args=(-r "$REPORT_FORMAT" --log-level "$LOG_LEVEL")
+  args=(-r "$REPORT_FORMAT" --log-level "$LOG_LEVEL"
+        --headers-from "$WORK_DIR/headers_list.txt" --ndjson-out "$WORK_DIR/headers.ndjson"
+        --output-dir "$WORK_DIR" --jobs "${JOBS:-auto}")
+  [[ -n "${MAX_MEMORY-auto}" ]] && args+=(--max-memory "${MAX_MEMORY-auto}")
   [[ "$DUMP_AST_DIFF" == "true" ]] && args+=(--dump-ast-diff)
   [[ -n "$HEADER_DIR" ]] && args+=(--header-dir "$HEADER_DIR")
   [[ -n "$INCLUDE_PATHS" ]] && args+=($INCLUDE_PATHS)
   [[ -n "$MACRO_FLAGS" ]] && args+=(-m $MACRO_FLAGS)
-
-  base_header_path="$BASE_PATH/$header"
-  if [[ ! -f "$base_header_path" ]]; then
-    log "Base header missing; creating empty placeholder: $base_header_path"
-    mkdir -p "$(dirname "$base_header_path")"
-    : > "$base_header_path"
+  [[ -n "$TRACE_OUT_DIR" ]] && args+=(--trace-out "$TRACE_OUT_DIR/trace_round${round}.json")
+  [[ -n "$SHARD" ]] && args+=(--shard "$SHARD")
+  # Blocking headers go first; their verdict is written as soon as they are done
+  if [[ -s "$BLOCKING_FILE" ]]; then
+    args+=(--blocking-headers "$BLOCKING_FILE" --gate-out "${OUT_ROOT}/gate_round${round}.json")
   fi
 
-  head_header_path="$HEAD_PATH/$header"
-  if [[ ! -f "$head_header_path" ]]; then
-    log "HEAD header missing; creating empty placeholder: $head_header_path"
-    mkdir -p "$(dirname "$head_header_path")"
-    : > "$head_header_path"
+  if [[ "$CHANGED_RANGES_ONLY" == "true" ]]; then
+    while IFS= read -r header; do
+      changed_ranges_json "$BASE_PATH/$header" "$HEAD_PATH/$header" "$header"
+    done < headers.txt | jq -s 'add // {}' > "$WORK_DIR/changed_ranges.json"
+    args+=(--changed-ranges "$WORK_DIR/changed_ranges.json")
   fi
 
-  "$ARMOR_CMD" "$BASE_PATH" "$HEAD_PATH" "$hdr_arg" "${args[@]}" || warn "armor failed for $header"
-
-  json_report="$WORK_DIR/armor_reports/json_reports/api_diff_report_$(basename "$hdr_arg").json"
-  api_names=(); compatibility="backward_compatible"; header_status="Unknown"
-  if [[ -f "$json_report" ]]; then
-    while IFS= read -r line; do
-      comp="$(jq -r '.compatibility' <<<"$line")"
-      name="$(jq -r '.name' <<<"$line")"
-      [[ "$comp" == "backward_incompatible" ]] && compatibility="backward_incompatible"
-      [[ -n "$name" && "$name" != "null" ]] && api_names+=("$name")
-    done < <(jq -c '.api_diff[]' "$json_report")
-    header_status=$(jq -r '.overall_status // "unknown"' "$json_report")
+  "$ARMOR_CMD" "$BASE_PATH" "$HEAD_PATH" "${args[@]}" || warn "armor failed for some headers of round $round"
+
+  # One record per header; a run that died before writing them leaves the headers Unknown.
+  # A shard only writes the records of its own headers, possibly none.
+  if [[ -s headers.ndjson || ( -n "$SHARD" && -f headers.ndjson ) ]]; then
+    cat headers.ndjson >> "$METADATA_NDJSON"
+  else
+    while IFS= read -r header; do
+      jq -nc --arg header "$header" '{header:$header, api_names:[], compatibility:"Unknown"}' >> "$METADATA_NDJSON"
+    done < headers.txt
   fi
 
-  api_json="$(printf '%s\0' "${api_names[@]}" | awk -v RS='\0' 'BEGIN{print "["} {if(NR>1) printf ","; printf "\"" $0 "\""} END{print "]"}')"
-  jq -n \
-    --arg header "$header" \
-    --argjson api_names "$api_json" \
-    --arg comp "$header_status" \
-    '{header:$header, api_names:$api_names, compatibility:$comp}' >> "$METADATA_NDJSON"
+  dest="${OUT_ROOT}/round${round}"
+  mkdir -p "$dest"
+  tar -cf - . 2>/dev/null | tar -xf - -C "$dest" 2>/dev/null || true
+  popd >/dev/null; rm -rf "$WORK_DIR"
+done
 
+while IFS= read -r record; do
+  header="$(jq -r '.header' <<<"$record")"
+  header_status="$(jq -r '.compatibility' <<<"$record")"
   if [[ "$header_status" == "BACKWARD_INCOMPATIBLE" ]]; then
     [[ -f "$BLOCKING_FILE" && -s "$BLOCKING_FILE" ]] && grep -Fxq "$header" "$BLOCKING_FILE" && echo "[BACKWARD_INCOMPATIBLE]$header" >> "$INCOMPATIBLE_BLOCKING"
     [[ -f "$NONBLOCKING_FILE" && -s "$NONBLOCKING_FILE" ]] && grep -Fxq "$header" "$NONBLOCKING_FILE" && echo "[BACKWARD_INCOMPATIBLE]$header" >> "$INCOMPATIBLE_NONBLOCKING"
   else
     echo "[$header_status]$header" >> "$OTHERS_FILE"
   fi
-
-  dest="${OUT_ROOT}/${safe}"
-  mkdir -p "$dest"
-  tar -cf - . 2>/dev/null | tar -xf - -C "$dest" 2>/dev/null || true
-  popd >/dev/null; rm -rf "$WORK_DIR"
-done
+done < "$METADATA_NDJSON"
 
 sort -u -o "$INCOMPATIBLE_BLOCKING" "$INCOMPATIBLE_BLOCKING"
 sort -u -o "$INCOMPATIBLE_NONBLOCKING" "$INCOMPATIBLE_NONBLOCKING"
@@ -0,0 +1,78 @@
+#!/bin/bash
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+set -euo pipefail
+
+# ==============================================================================
+# Builds a release armor optimized from profiles of its own runs:
+#   1. an instrumented build (-DARMOR_PGO=GENERATE) of armor and armor_header_gen,
+#   2. training runs over the functional fixtures and generated large headers,
+#   3. a rebuild of armor in the same directory from the profiles (-DARMOR_PGO=USE).
+#
+# Environment (optional):
+#   BUILD_DIR=build-pgo, CXX_COMPILER=/usr/bin/g++-11,
+#   LLVM_PROFDATA (merges the profiles of a clang build; llvm-profdata-14 by default)
+# ==============================================================================
+
+BUILD_DIR="${BUILD_DIR:-build-pgo}"
+CXX_COMPILER="${CXX_COMPILER:-/usr/bin/g++-11}"
+LLVM_PROFDATA="${LLVM_PROFDATA:-llvm-profdata-14}"
+SOURCE_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+mkdir -p "$BUILD_DIR"
+BUILD_DIR="$(cd "$BUILD_DIR" && pwd)"
+PROFILE_DIR="$BUILD_DIR/pgo-profiles"
+ARMOR="$BUILD_DIR/src/armor/armor"
+TRAIN_DIR="$(mktemp -d)"
+trap 'rm -rf "$TRAIN_DIR"' EXIT
+
+configure() {
+    cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" \
+        -DCMAKE_BUILD_TYPE=Release \
+        -DCMAKE_CXX_COMPILER="$CXX_COMPILER" \
+        -DARMOR_BUILD_BENCHMARKS=ON \
+        -DARMOR_PGO="$1" \
+        -DARMOR_PGO_DIR="$PROFILE_DIR"
+}
+
+# Compares every header of `v1` and `v2` under $1
+train_pair() {
+    local dir="$1"
+    local headers=()
+    while IFS= read -r header; do
+        headers+=("$header")
+    done < <(cd "$dir/v1" && find . -name '*.h' -o -name '*.hpp' | sed 's#^\./##' | sort)
+    [[ ${#headers[@]} -gt 0 ]] || return 0
+    # Changed headers make armor exit non-zero; only the profile matters here
+    "$ARMOR" "$dir/v1" "$dir/v2" "${headers[@]}" -r json -j "$(nproc)" \
+        --output-dir "$TRAIN_DIR/out" >/dev/null 2>&1 || true
+}
+
+echo "🔧 Building instrumented armor..."
+rm -rf "$PROFILE_DIR"
+configure GENERATE
+cmake --build "$BUILD_DIR" --parallel "$(nproc)" --target armor armor_header_gen
+
+echo "🏋️ Training on the functional fixtures..."
+for fixture in "$SOURCE_DIR"/src/tests/*/functional/*/; do
+    [[ -d "$fixture/v1" && -d "$fixture/v2" ]] && train_pair "$fixture"
+done
+
+echo "🏋️ Training on generated large headers..."
+"$BUILD_DIR/src/tests/benchmarks/armor_header_gen" "$TRAIN_DIR/wide" --decls 5000 --depth 4 --overloads 6 \
+    --template-ratio 0.3 --change-rate 0.05 >/dev/null
+train_pair "$TRAIN_DIR/wide"
+"$BUILD_DIR/src/tests/benchmarks/armor_header_gen" "$TRAIN_DIR/deep" --decls 2000 --depth 12 --overloads 2 \
+    --template-ratio 0.6 --change-rate 0.2 >/dev/null
+train_pair "$TRAIN_DIR/deep"
+
+if [[ "$("$CXX_COMPILER" --version)" == *clang* ]]; then
+    "$LLVM_PROFDATA" merge -output="$PROFILE_DIR/armor.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "🔧 Rebuilding armor from the profiles..."
+configure USE
+cmake --build "$BUILD_DIR" --parallel "$(nproc)" --target armor
+
+echo "✅ Profile-guided armor built at $ARMOR"
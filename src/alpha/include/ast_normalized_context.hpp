@@ -3,10 +3,10 @@
 #pragma once
 
 #include "node.hpp"
+#include "node_index.hpp"
 #include "clang/AST/ASTContext.h"
 #include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/ADT/StringRef.h>
-#include <llvm-14/llvm/ADT/StringSet.h>
 
 namespace alpha{
 
@@ -69,9 +69,9 @@ private:
  * This class serves as the central repository for all unique API nodes found during
  * an AST traversal. It maintains two primary data structures:
  *
- * 1. A map (`normalizedTree`) from a unique identifier (like a USR) to the
- *    corresponding `APINode`. This ensures that each API entity is represented by
- *    a single, unique object, preventing duplication.
+ * 1. An index (`apiNodesMap`) from the key of each top-level node, its kind
+ *    and qualified name, to the corresponding `APINode`. This ensures that each
+ *    API entity is represented by a single, unique object, preventing duplication.
  *
  * 2. A vector (`rootApiNodes`) of nodes that are considered top-level or
  *    "root" elements of the API (e.g., free functions, global variables, or
@@ -87,15 +87,13 @@ public:
     ASTNormalizedContext();
 
     /**
-     * @brief Adds a new node to the normalized tree.
+     * @brief Adds a new node to the normalized tree, under its NodeKey.
      *
      * If a node with the same key already exists, it is not replaced.
-     * Use addOrUpdateNode if overwriting is desired.
      *
-     * @param key The unique string identifier for the node (e.g., USR).
      * @param node A shared pointer to the APINode.
      */
-    void addNode(llvm::StringRef key,const std::shared_ptr<const APINode> node);
+    void addNode(std::shared_ptr<const APINode> node);
 
     /**
      * @brief Adds a node to the list of root API nodes.
@@ -107,7 +105,7 @@ public:
     /**
      * @brief Returns a const reference to the entire normalized tree map.
      */
-    const llvm::StringMap<std::shared_ptr<const APINode>>& getTree() const;
+    const NodeIndex& getTree() const;
 
     /**
      * @brief Returns a const reference to the list of root API nodes.
@@ -129,6 +127,23 @@ public:
 
     clang::ASTContext* getClangASTContext() const;
 
+    /**
+     * @brief Restricts the context to `file`, for a translation unit parsing several headers.
+     *
+     * Until set, the context owns the main file of its translation unit.
+     */
+    void setOwnedFile(clang::FileID file);
+
+    /**
+     * @brief Returns the file the context normalizes in the translation unit of `SM`.
+     */
+    clang::FileID getOwnedFile(const clang::SourceManager& SM) const;
+
+    /**
+     * @brief Whether `loc`, at its expansion point, lies in the owned file.
+     */
+    bool ownsLocation(const clang::SourceManager& SM, clang::SourceLocation loc) const;
+
     /**
      * @brief Returns a reference to the source range tracker.
      */
@@ -139,15 +154,17 @@ public:
      */
     const SourceRangeTracker& getSourceRangeTracker() const;
 
-    llvm::StringSet<> excludeNodes;
-    llvm::StringSet<> hashSet;
+    NodeKeySet excludeNodes;
+    NodeKeySet hashSet;
 
 private:
-    llvm::StringMap<std::shared_ptr<const APINode>> apiNodesMap;
+    NodeIndex apiNodesMap;
     llvm::SmallVector<std::shared_ptr<const APINode>,64> apiNodes;
 
     SourceRangeTracker sourceRangeTracker;
     clang::ASTContext* clangContext;
+    // Invalid for the main file
+    clang::FileID ownedFile;
 };
 
 }
\ No newline at end of file
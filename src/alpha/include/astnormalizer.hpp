@@ -24,6 +24,12 @@ class ASTNormalize : public clang::RecursiveASTVisitor<ASTNormalize> {
 
         ASTNormalize(alpha::APISession* session, alpha::ASTNormalizedContext* context, clang::ASTContext* clangContext);
 
+        /**
+         * @brief Skips, without visiting, namespace-scope declarations written outside
+         *        the context's owned file, which the TreeBuilder would reject anyway,
+         *        and declarations the session's ApiFilter excludes.
+         */
+        bool TraverseDecl(clang::Decl *Decl);
         bool TraverseNamespaceDecl(clang::NamespaceDecl *Decl);
         bool TraverseRecordDecl(clang::RecordDecl *Decl);
         bool TraverseCXXRecordDecl(clang::CXXRecordDecl *Decl);
@@ -2,11 +2,39 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "comm_def.hpp"
+#include "output_paths.hpp"
 #include "session.hpp"
 
+/**
+ * @brief Alpha contexts of a header pair, parsed and not yet reported.
+ */
+struct ParsedHeaderPairAlpha {
+    std::unique_ptr<alpha::APISession> session;
+    // Owned by `session`; nullptr when the session lost them
+    const alpha::ASTNormalizedContext* context1 = nullptr;
+    const alpha::ASTNormalizedContext* context2 = nullptr;
+    PARSING_STATUS status = FATAL_ERRORS;
+};
+
+/**
+ * @brief Parses both versions of a header with the alpha parser, without diffing or reporting.
+ *
+ * The first half of processHeaderPairAlpha. Callers trying the beta parser
+ * next report the alpha contexts (reportHeaderPairAlpha) only when beta
+ * cannot compare the pair, as the beta report would replace them.
+ */
+ParsedHeaderPairAlpha parseHeaderPairAlpha(const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& projectRoot2,
+                       const std::string& file2,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang);
+
 PARSING_STATUS processHeaderPairAlpha(const std::string& projectRoot1,
                        const std::string& file1,
                        const std::string& projectRoot2,
@@ -14,4 +42,44 @@ PARSING_STATUS processHeaderPairAlpha(const std::string& projectRoot1,
                        const std::string& reportFormat,
                        const std::vector<std::string>& IncludePaths,
                        const std::vector<std::string>& macroFlags,
-                       const LANG_OPTIONS lang);
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff);
+
+/**
+ * @brief Diffs two already normalized alpha contexts and writes the reports.
+ *
+ * This is the second half of processHeaderPairAlpha, usable by callers that
+ * populated the contexts through their own frontend run.
+ *
+ * @param projectRoot1 Project root of the older version (used to trim report paths).
+ * @param file1        Older header path; its basename names the report files.
+ * @param reportFormat "html", or "json", "cbor" or "msgpack" for a JSON report in that format too.
+ * @param context1     Normalized context of the older header.
+ * @param context2     Normalized context of the newer header.
+ * @param dumpAstDiff  Also write the raw diff to debug_output/ast_diffs, in the report format.
+ * @param outputs      Where the reports and the dump are written.
+ */
+void reportHeaderPairAlpha(const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& reportFormat,
+                       const alpha::ASTNormalizedContext* context1,
+                       const alpha::ASTNormalizedContext* context2,
+                       bool dumpAstDiff,
+                       const armor::OutputPaths& outputs = {});
+
+/**
+ * @brief Overall status of two already normalized alpha contexts, without writing reports.
+ *
+ * The --verdict-only form of reportHeaderPairAlpha: the overall status is
+ * recorded in ReportSummaries, as a written report's would be, and no
+ * records, descriptions or reports are made.
+ *
+ * @param projectRoot1 Project root of the older version (used to trim the header path).
+ * @param file1        Older header path.
+ * @param context1     Normalized context of the older header.
+ * @param context2     Normalized context of the newer header.
+ */
+void reportHeaderPairVerdictAlpha(const std::string& projectRoot1,
+                       const std::string& file1,
+                       const alpha::ASTNormalizedContext* context1,
+                       const alpha::ASTNormalizedContext* context2);
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <cstdint>
 #include <llvm-14/llvm/ADT/SmallString.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringMap.h>
@@ -17,7 +18,8 @@ namespace alpha{
 
 struct APINode {
     NodeKind kind = NodeKind::Unknown;
-    std::string hash;
+    // generateHash() of kind and qualifiedName, see NodeKey
+    uint64_t hash = 0;
     std::string qualifiedName;
     std::string dataType;         // Underlying datatype of variables .... (int/float/...)
     bool isInclined = false;
@@ -0,0 +1,132 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "comm_def.hpp"
+#include "node.hpp"
+
+namespace alpha {
+
+/**
+ * @brief What identifies an alpha node within its scope: its kind and qualified name.
+ *
+ * `hash` is generateHash() of the two. Containers index keys by it and
+ * compare the kind and name to settle collisions, so two keys are only ever
+ * taken as equal when they are.
+ */
+struct NodeKey {
+    NodeKind kind;
+    llvm::StringRef qualifiedName;
+    uint64_t hash;
+
+    NodeKey(NodeKind kind, llvm::StringRef qualifiedName);
+
+    /** @brief The key of `node`, from the hash it was built with. */
+    static NodeKey of(const APINode& node) { return NodeKey(node.kind, node.qualifiedName, node.hash); }
+
+    bool operator==(const NodeKey& other) const {
+        return hash == other.hash && kind == other.kind && qualifiedName == other.qualifiedName;
+    }
+
+private:
+    NodeKey(NodeKind kind, llvm::StringRef qualifiedName, uint64_t hash)
+        : kind(kind), qualifiedName(qualifiedName), hash(hash) {}
+};
+
+namespace detail {
+
+    /**
+     * Slots of entries by their key hash. Entries sharing a hash, which hold
+     * distinct keys, are chained behind the latest of them.
+     */
+    class HashChains {
+        public:
+            static constexpr uint32_t NONE = UINT32_MAX;
+
+            uint32_t first(uint64_t hash) const {
+                auto it = heads.find(hash);
+                return it == heads.end() ? NONE : it->second;
+            }
+            uint32_t next(uint32_t slot) const { return nexts[slot]; }
+
+            // `slot` is the number of entries added before it
+            void add(uint64_t hash, uint32_t slot) {
+                auto [it, inserted] = heads.try_emplace(hash, slot);
+                nexts.push_back(inserted ? NONE : it->second);
+                it->second = slot;
+            }
+
+            void clear() {
+                heads.clear();
+                nexts.clear();
+            }
+
+        private:
+            llvm::DenseMap<uint64_t, uint32_t> heads;
+            std::vector<uint32_t> nexts;
+    };
+
+}
+
+/**
+ * @brief Nodes by key, first added wins; iterates in insertion order.
+ */
+class NodeIndex {
+public:
+    using const_iterator = std::vector<std::shared_ptr<const APINode>>::const_iterator;
+
+    /** @return false, leaving the index unchanged, if a node of the same key is present. */
+    bool insert(std::shared_ptr<const APINode> node);
+
+    /** @return The node of `key`, or nullptr. */
+    const std::shared_ptr<const APINode>& find(const NodeKey& key) const;
+
+    bool contains(const NodeKey& key) const { return find(key) != nullptr; }
+    size_t size() const { return nodes.size(); }
+    bool empty() const { return nodes.empty(); }
+    void clear();
+
+    const_iterator begin() const { return nodes.begin(); }
+    const_iterator end() const { return nodes.end(); }
+
+private:
+    std::vector<std::shared_ptr<const APINode>> nodes;
+    detail::HashChains chains;
+};
+
+/**
+ * @brief Set of node keys, which need not belong to any node; iterates in insertion order.
+ */
+class NodeKeySet {
+public:
+    struct Entry {
+        NodeKind kind;
+        std::string qualifiedName;
+    };
+    using const_iterator = std::vector<Entry>::const_iterator;
+
+    /** @return true if `key` was not present yet. */
+    bool insert(const NodeKey& key);
+
+    bool contains(const NodeKey& key) const;
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear();
+
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+private:
+    std::vector<Entry> entries;
+    detail::HashChains chains;
+};
+
+}
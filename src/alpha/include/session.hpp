@@ -2,6 +2,9 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <mutex>
+
+#include "api_filter.hpp"
 #include "ast_normalized_context.hpp"
 #include "clang/Tooling/CompilationDatabase.h"
 
@@ -32,7 +35,8 @@ public:
      * @brief Processes a source file, normalizing its AST and storing the context.
      *
      * Runs a Clang tool on the specified file, populates an ASTNormalizedContext,
-     * and stores it in the session, mapped by the filename.
+     * and stores it in the session, mapped by the filename. Different files may
+     * be processed concurrently on the same session.
      *
      * @param filename The path to the source file to process.
      */
@@ -51,9 +55,24 @@ public:
 
     void createNormalizedASTContext(const std::string& key);
 
+    /**
+     * @brief Frees the context of `fileName` once its pair is reported; pointers to it dangle.
+     */
+    void removeContext(const std::string& fileName);
+
+    /**
+     * @brief Drops the declarations `filter` excludes, see beta::APISession::setApiFilter.
+     */
+    void setApiFilter(const armor::ApiFilter* filter);
+
+    const armor::ApiFilter* getApiFilter() const;
+
 private:
     // A map from a filename to its fully normalized AST context
+    // Guards m_contexts so both versions of a header can be parsed concurrently
+    mutable std::mutex m_contextsMutex;
     llvm::StringMap<std::unique_ptr<ASTNormalizedContext>> m_contexts;
+    const armor::ApiFilter* m_apiFilter = nullptr;
 };
 
 }
\ No newline at end of file
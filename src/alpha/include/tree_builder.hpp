@@ -41,7 +41,7 @@ public:
     // Name management
     void PushName(llvm::StringRef name);
     void PopName();
-    const std::string GetCurrentQualifiedName();
+    std::string GetCurrentQualifiedName();
 
     // Utility methods
     bool IsFromMainFileAndNotLocal(const clang::Decl* Decl);
@@ -2,11 +2,12 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #include "node.hpp"
 #include "ast_normalized_context.hpp"
+#include "clang/Basic/SourceManager.h"
 
 alpha::ASTNormalizedContext::ASTNormalizedContext() = default;
 
-void alpha::ASTNormalizedContext::addNode(llvm::StringRef key, std::shared_ptr<const alpha::APINode> node) {
-    apiNodesMap.try_emplace(key, std::move(node));
+void alpha::ASTNormalizedContext::addNode(std::shared_ptr<const alpha::APINode> node) {
+    apiNodesMap.insert(std::move(node));
 }
 
 void alpha::ASTNormalizedContext::addRootNode(std::shared_ptr<const alpha::APINode> rootNode) {
@@ -15,7 +16,7 @@ void alpha::ASTNormalizedContext::addRootNode(std::shared_ptr<const alpha::APINo
     }
 }
 
-const llvm::StringMap<std::shared_ptr<const alpha::APINode>>& alpha::ASTNormalizedContext::getTree() const {
+const alpha::NodeIndex& alpha::ASTNormalizedContext::getTree() const {
     return apiNodesMap;
 }
 
@@ -31,6 +32,7 @@ void alpha::ASTNormalizedContext::clear() {
     apiNodesMap.clear();
     apiNodes.clear();
     sourceRangeTracker.clear();
+    ownedFile = clang::FileID();
 }
 
 void alpha::ASTNormalizedContext::addClangASTContext(clang::ASTContext *ASTContext){
@@ -41,6 +43,21 @@ clang::ASTContext* alpha::ASTNormalizedContext::getClangASTContext() const {
     return clangContext; 
 }
 
+void alpha::ASTNormalizedContext::setOwnedFile(clang::FileID file) {
+    ownedFile = file;
+}
+
+clang::FileID alpha::ASTNormalizedContext::getOwnedFile(const clang::SourceManager& SM) const {
+    return ownedFile.isValid() ? ownedFile : SM.getMainFileID();
+}
+
+bool alpha::ASTNormalizedContext::ownsLocation(const clang::SourceManager& SM, clang::SourceLocation loc) const {
+    if (!ownedFile.isValid()) {
+        return SM.isInMainFile(loc);
+    }
+    return loc.isValid() && SM.getFileID(SM.getExpansionLoc(loc)) == ownedFile;
+}
+
 alpha::SourceRangeTracker& alpha::ASTNormalizedContext::getSourceRangeTracker() {
     return sourceRangeTracker;
 }
@@ -59,6 +59,24 @@ std::unique_ptr<clang::FrontendAction> alpha::NormalizeActionFactory::create() {
 }
 
 // === Visit and Traverse Methods ===
+bool alpha::ASTNormalize::TraverseDecl(clang::Decl *Decl) {
+    // Same pruning as the beta visitor: nothing below a foreign namespace-scope
+    // declaration passes IsFromMainFileAndNotLocal
+    if (Decl && !llvm::isa<clang::TranslationUnitDecl>(Decl)) {
+        const clang::DeclContext* lexicalContext = Decl->getLexicalDeclContext();
+        if (lexicalContext && lexicalContext->getRedeclContext()->isFileContext() &&
+            !context->ownsLocation(clangContext->getSourceManager(), Decl->getLocation())) {
+            return true;
+        }
+        // Excluded subtrees are never visited, so no node of them is built
+        const armor::ApiFilter* filter = session->getApiFilter();
+        if (filter && filter->excludes(Decl)) {
+            return true;
+        }
+    }
+    return RecursiveASTVisitor<alpha::ASTNormalize>::TraverseDecl(Decl);
+}
+
 bool alpha::ASTNormalize::TraverseNamespaceDecl(clang::NamespaceDecl *Decl) {
     RecursiveASTVisitor<alpha::ASTNormalize>::TraverseNamespaceDecl(Decl);
     return true;
@@ -1,36 +1,57 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Hashing.h>
 #include <llvm/ADT/SmallVector.h>
 
 #include "diffengine.hpp"
 #include "diff_utils.hpp"
 #include "logger.hpp"
+#include "node_index.hpp"
+#include "subtree_summary.hpp"
 
 using json = nlohmann::json;
 
-auto byHash = [](const std::shared_ptr<const alpha::APINode>& node) -> const std::string& {
-    return node->hash;
-};
+using NodesByHash = std::unordered_multimap<uint64_t, std::shared_ptr<const alpha::APINode>>;
+
+NodesByHash indexByHash(const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& nodes) {
+    NodesByHash map;
+    map.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        map.emplace(node->hash, node);
+    }
+    return map;
+}
+
+// Nodes of one hash may still differ in key; only a node of the same key matches.
+NodesByHash::iterator findSameKey(NodesByHash& map, const alpha::APINode& node) {
+    const alpha::NodeKey key = alpha::NodeKey::of(node);
+    auto [it, last] = map.equal_range(node.hash);
+    for (; it != last; ++it) {
+        if (alpha::NodeKey::of(*it->second) == key) {
+            return it;
+        }
+    }
+    return map.end();
+}
 
-template<typename KeyFunc>
 std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<const alpha::APINode>>> intersection(
     const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& a,
-    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& b,
-    KeyFunc&& keyFunc
+    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& b
 ) {
-    std::unordered_multimap<std::string, std::shared_ptr<const alpha::APINode>> map_b;
-    map_b.reserve(b.size());
-    for (const auto& node : b) {
-        map_b.emplace(keyFunc(node), node);
-    }
+    NodesByHash map_b = indexByHash(b);
 
     std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<const alpha::APINode>>> result;
     result.reserve(std::min(a.size(), b.size()));
 
     for (const auto& node_a : a) {
-        const auto& key = keyFunc(node_a);
-        auto it = map_b.find(key);
+        auto it = findSameKey(map_b, *node_a);
         if (it != map_b.end()) {
             result.emplace_back(node_a, std::move(it->second));
             map_b.erase(it);
@@ -41,24 +62,17 @@ std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<con
 
 }
 
-template<typename KeyFunc>
 std::vector<std::shared_ptr<const alpha::APINode>> difference(
     const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& a,
-    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& b,
-    KeyFunc&& keyFunc
+    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& b
 ) {
-    std::unordered_multimap<std::string, std::shared_ptr<const alpha::APINode>> map_b;
-    map_b.reserve(b.size());
-    for (const auto& node : b) {
-        map_b.emplace(keyFunc(node), node);
-    }
+    NodesByHash map_b = indexByHash(b);
 
     std::vector<std::shared_ptr<const alpha::APINode>> result;
     result.reserve(std::min(a.size(), b.size()));
 
     for (const auto& node : a) {
-        const auto& key = keyFunc(node);
-        auto it = map_b.find(key);
+        auto it = findSameKey(map_b, *node);
         if (it != map_b.end()) {
             map_b.erase(it);  // remove one occurrence
         } else {
@@ -78,119 +92,234 @@ const bool inline hasChildren(const std::shared_ptr<const alpha::APINode>& node)
 }
 
 namespace{
-    const json toJson(const std::shared_ptr<const alpha::APINode>& node) {
-    
-        json json_node;
+    // Summarizes the subtree of `root` into `json_node` if it declares more
+    // than SUMMARIZED_SUBTREE_SIZE nodes
+    bool summarize(const alpha::APINode& root, json& json_node) {
+        SubtreeSummary summary;
+        llvm::SmallVector<const alpha::APINode*, 32> pending;
+        pending.push_back(&root);
+        while (!pending.empty()) {
+            const alpha::APINode* node = pending.pop_back_val();
+            if (node != &root) {
+                summary.count(node->kind);
+            }
+            if (node->children != nullptr) {
+                for (const auto& childNode : *node->children) {
+                    pending.push_back(childNode.get());
+                }
+            }
+        }
+        if (summary.size() <= SUMMARIZED_SUBTREE_SIZE) {
+            return false;
+        }
+        for (size_t i = 0; i < root.children->size() && i < SUMMARY_LISTED_NAMES; ++i) {
+            summary.name((*root.children)[i]->qualifiedName);
+        }
 
-        if(!node->qualifiedName.empty()) json_node[QUALIFIED_NAME] = node->qualifiedName;
-        json_node[NODE_TYPE] = serialize(node->kind);
+        if(!root.qualifiedName.empty()) json_node[QUALIFIED_NAME] = root.qualifiedName;
+        json_node[NODE_TYPE] = serialize(root.kind);
+        if(!root.dataType.empty()) json_node[DATA_TYPE] = root.dataType;
+        json_node[SUMMARY] = summary.toJson();
+        return true;
+    }
 
-        if(hasChildren(node)) {
-            json_node[CHILDREN] = json::array();
-            for (const auto& childNode : *node->children) {
-                json_node[CHILDREN].emplace_back(toJson(childNode));
-            }
+    // Each children array is sized up front and filled in place from an
+    // explicit stack, so deep nesting costs no call stack; a large subtree
+    // is summarized instead, see SubtreeSummary
+    json toJson(const std::shared_ptr<const alpha::APINode>& root) {
+
+        json result;
+        if (!isSubtreeExpansionEnabled() && summarize(*root, result)) {
+            return result;
         }
+        llvm::SmallVector<std::pair<const alpha::APINode*, json*>, 32> pending{{root.get(), &result}};
+        while (!pending.empty()) {
+            auto [node, json_node] = pending.pop_back_val();
+
+            if(!node->qualifiedName.empty()) (*json_node)[QUALIFIED_NAME] = node->qualifiedName;
+            (*json_node)[NODE_TYPE] = serialize(node->kind);
+
+            if(node->children != nullptr && !node->children->empty()) {
+                json& children = (*json_node)[CHILDREN] = json::array();
+                children.get_ref<json::array_t&>().reserve(node->children->size());
+                for (const auto& childNode : *node->children) {
+                    pending.emplace_back(childNode.get(), &children.emplace_back());
+                }
+            }
 
-        if(!node->dataType.empty()) json_node[DATA_TYPE] = node->dataType;
+            if(!node->dataType.empty()) (*json_node)[DATA_TYPE] = node->dataType;
+        }
 
-        return json_node;
+        return result;
     }
 
-    const json get_json_from_node(const std::shared_ptr<const alpha::APINode> node, const std::string& tag) {
+    json get_json_from_node(const std::shared_ptr<const alpha::APINode>& node, std::string_view tag) {
         json json_node = toJson(node);
         json_node[TAG] = tag;
         return json_node;
     }
 
-    const json createHeaderResolutionFailures(const alpha::SourceRangeTracker& tracker) {
+    json createHeaderResolutionFailures(const alpha::SourceRangeTracker& tracker) {
         json failures = json::array();
         for (const auto& directive : tracker.getFatalDirectives()) {
             json failure;
             failure["header"] = directive.Header;
             failure["file"] = directive.File;
-            failures.emplace_back(failure);
+            failures.emplace_back(std::move(failure));
         }
         return failures;
     }
 }
 
 
-json diffNodes(
-    const std::shared_ptr<const alpha::APINode>& a, 
-    const std::shared_ptr<const alpha::APINode>& b
-){
-    
-    // Any node can have children.
+namespace {
+
+    /*
+        Structural hashes of the subtrees of one diff run, computed once per
+        node on first use. Each covers the key and every field APINode::diff
+        compares, and the children in order, so a pair with equal hashes has
+        no diff: an unchanged subtree costs one comparison rather than a walk
+        of its children, and no node is hashed twice.
+    */
+    class SubtreeHashes {
+        public:
+            uint64_t of(const alpha::APINode& root) {
+                auto known = hashes.find(&root);
+                if (known != hashes.end()) {
+                    return known->second;
+                }
+                // Children first, from an explicit stack like diffNodes
+                llvm::SmallVector<std::pair<const alpha::APINode*, bool>, 32> pending{{&root, false}};
+                while (!pending.empty()) {
+                    auto [node, childrenDone] = pending.pop_back_val();
+                    if (!childrenDone) {
+                        if (hashes.count(node) == 0) {
+                            pending.emplace_back(node, true);
+                            if (node->children != nullptr) {
+                                for (const auto& child : *node->children) {
+                                    pending.emplace_back(child.get(), false);
+                                }
+                            }
+                        }
+                        continue;
+                    }
+                    llvm::hash_code hash = llvm::hash_combine(node->hash, node->kind, llvm::StringRef(node->dataType),
+                                                              node->storage, node->isInclined, node->isConstExpr);
+                    if (node->children != nullptr) {
+                        for (const auto& child : *node->children) {
+                            hash = llvm::hash_combine(hash, hashes.lookup(child.get()));
+                        }
+                    }
+                    hashes[node] = static_cast<uint64_t>(hash);
+                }
+                return hashes.lookup(&root);
+            }
+
+        private:
+            llvm::DenseMap<const alpha::APINode*, uint64_t> hashes;
+    };
+
+    // Appends `diff`, an entry or an array of them as APINode::diff returns, to the array `out`
+    void appendDiff(json& out, json&& diff) {
+        if (diff.is_null() || diff.empty()) {
+            return;
+        }
+        if (diff.is_array()) {
+            for (json& entry : diff) {
+                out.emplace_back(std::move(entry));
+            }
+        }
+        else out.emplace_back(std::move(diff));
+    }
 
-    if ( hasChildren(a) && hasChildren(b) ) {
-        
+    using NodePair = std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<const alpha::APINode>>;
+
+    // A pair of nodes with children on both sides whose common children are diffed from `next`
+    struct DiffFrame {
+        DiffFrame(const std::shared_ptr<const alpha::APINode>& a, const std::shared_ptr<const alpha::APINode>& b,
+                  json& out)
+            : a(a), b(b), out(out) {}
+
+        const std::shared_ptr<const alpha::APINode>& a;
+        const std::shared_ptr<const alpha::APINode>& b;
+        // The children of the frame below, or the caller's array
+        json& out;
         json childrenDiff = json::array();
+        std::vector<NodePair> common;
+        size_t next = 0;
+    };
+
+    // Diffs a pair without children on both sides into `out`, or pushes it to be walked
+    void enterPair(const std::shared_ptr<const alpha::APINode>& a, const std::shared_ptr<const alpha::APINode>& b,
+                   json& out, std::deque<DiffFrame>& frames, SubtreeHashes& subtreeHashes) {
+
+        if (subtreeHashes.of(*a) == subtreeHashes.of(*b)) {
+            return;
+        }
+
+        if (!hasChildren(a) || !hasChildren(b)) {
+            appendDiff(out, a->diff(b));
+            return;
+        }
+
+        DiffFrame& frame = frames.emplace_back(a, b, out);
 
-        const std::vector<std::shared_ptr<const alpha::APINode>> removed_nodes = difference(
-            *a->children, 
-            *b->children,
-            byHash
-        );
-        const std::vector<std::shared_ptr<const alpha::APINode>> added_nodes = difference(
-            *b->children, 
-            *a->children,
-            byHash
-        );
-
-        const std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<const alpha::APINode>>> common_nodes = intersection(
-            *a->children, 
-            *b->children, 
-            byHash
-        );
-
-        for (const auto& removedNode : removed_nodes) {
-            childrenDiff.emplace_back(get_json_from_node(removedNode, REMOVED));
+        for (const auto& removedNode : difference(*a->children, *b->children)) {
+            frame.childrenDiff.emplace_back(get_json_from_node(removedNode, REMOVED));
         }
 
-        for (const auto& addedNode : added_nodes) {
-            childrenDiff.emplace_back(get_json_from_node(addedNode, ADDED));
+        for (const auto& addedNode : difference(*b->children, *a->children)) {
+            frame.childrenDiff.emplace_back(get_json_from_node(addedNode, ADDED));
         }
 
-        for (const auto& commonNodePair : common_nodes) {
+        frame.common = intersection(*a->children, *b->children);
+    }
+
+}
+
+/*
+    Appends the diff of `a` and `b` to the array `out`. The trees are walked
+    with an explicit stack, so nesting costs no call stack, and each entry is
+    appended once to the children of the entry it belongs to.
+*/
+void diffNodes(
+    const std::shared_ptr<const alpha::APINode>& a, 
+    const std::shared_ptr<const alpha::APINode>& b,
+    json& out,
+    SubtreeHashes& subtreeHashes
+){
+
+    // std::deque keeps the frames below in place, for the `out` of the frames above
+    std::deque<DiffFrame> frames;
+    enterPair(a, b, out, frames, subtreeHashes);
+
+    while (!frames.empty()) {
+        DiffFrame& frame = frames.back();
+
+        if (frame.next < frame.common.size()) {
             /*
                 Comparing nodes of same scope. No name conflicts for const alpha::APINodes in same scope.
                 Here scope can be Main Header file or inside a CXXRecordDecl, EnumDecl, FunctionDecl
             */
-            json sameScopeDiff = diffNodes(commonNodePair.first,commonNodePair.second);
-            
-            if(!sameScopeDiff.is_null() && !sameScopeDiff.empty()){
-                if(sameScopeDiff.is_array()){
-                    childrenDiff.insert(childrenDiff.end(), sameScopeDiff.begin(), sameScopeDiff.end());
-                }
-                else childrenDiff.emplace_back(sameScopeDiff);
-            }
+            const NodePair& commonNodePair = frame.common[frame.next++];
+            enterPair(commonNodePair.first, commonNodePair.second, frame.childrenDiff, frames, subtreeHashes);
+            continue;
         }
 
         // For functions,  we check return type and for other future use-cases.
-    
-        json APINodeDiff = a->diff(b);
-        if (!APINodeDiff.empty()) {
-            if(APINodeDiff.is_array()){
-                childrenDiff.insert(childrenDiff.end(), APINodeDiff.begin(), APINodeDiff.end());
-            }
-            else childrenDiff.emplace_back(APINodeDiff);
-        }
+        appendDiff(frame.childrenDiff, frame.a->diff(frame.b));
 
-        if(!childrenDiff.empty()){
+        if(!frame.childrenDiff.empty()){
             json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
-            diff[NODE_TYPE] = serialize(a->kind);
-            if(!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
+            diff[QUALIFIED_NAME] = frame.a->qualifiedName;
+            diff[NODE_TYPE] = serialize(frame.a->kind);
+            diff[CHILDREN] = std::move(frame.childrenDiff);
             diff[TAG] = MODIFIED;
-            return json::array().emplace_back(diff);
+            frame.out.emplace_back(std::move(diff));
         }
-
+        frames.pop_back();
     }
-    else return a->diff(b);
 
-    return json::array();
-    
 }
 
 
@@ -200,44 +329,41 @@ json diffTrees(
 ) {
 
     json astDiffs = json::array();
-    llvm::StringMap<std::shared_ptr<const alpha::APINode>> tree1 = context1->getTree();
-    llvm::StringMap<std::shared_ptr<const alpha::APINode>> tree2 = context2->getTree();
+    SubtreeHashes subtreeHashes;
+    const alpha::NodeIndex& tree1 = context1->getTree();
+    const alpha::NodeIndex& tree2 = context2->getTree();
 
     for (auto const &rootNode1 : context1->getRootNodes()) {
 
-        if(context1->excludeNodes.count(rootNode1->hash) || context2->excludeNodes.count(rootNode1->hash)){
-            armor::info() << "Excluding : " << rootNode1->hash << "\n";
+        const alpha::NodeKey key = alpha::NodeKey::of(*rootNode1);
+        if(context1->excludeNodes.contains(key) || context2->excludeNodes.contains(key)){
+            armor::info() << "Excluding : " << rootNode1->qualifiedName << "\n";
             continue;
         }
 
-        if (tree2.find(rootNode1->hash) == tree2.end()) {
+        const std::shared_ptr<const alpha::APINode>& rootNode2 = tree2.find(key);
+        if (rootNode2 == nullptr) {
             astDiffs.emplace_back(get_json_from_node(rootNode1, REMOVED));
         }
         else {
-            const std::shared_ptr<const alpha::APINode> rootNode2 = tree2.find(rootNode1->hash)->second;
-            json sameScopeDiff = diffNodes(rootNode1, rootNode2);
             /*
                 Comparing nodes of same scope. No name conflicts for alpha::APINodes in same scope.
                 Here scope can be Main Header file or inside a CXXRecordDecl
             */
-            if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()){
-                if (sameScopeDiff.is_array()){
-                    astDiffs.insert(astDiffs.end(), sameScopeDiff.begin(), sameScopeDiff.end());
-                }
-                else astDiffs.emplace_back(sameScopeDiff);
-            }
+            diffNodes(rootNode1, rootNode2, astDiffs, subtreeHashes);
         }
 
     }
 
     for (const auto & rootNode2 : context2->getRootNodes()) {
 
-        if(context1->excludeNodes.count(rootNode2->hash) || context2->excludeNodes.count(rootNode2->hash)){
-            armor::info() << "Excluding : " << rootNode2->hash << "\n";
+        const alpha::NodeKey key = alpha::NodeKey::of(*rootNode2);
+        if(context1->excludeNodes.contains(key) || context2->excludeNodes.contains(key)){
+            armor::info() << "Excluding : " << rootNode2->qualifiedName << "\n";
             continue;
         }
 
-        if (tree1.find(rootNode2->hash) == tree1.end()) {
+        if (!tree1.contains(key)) {
             astDiffs.emplace_back(get_json_from_node(rootNode2, ADDED));
         }
     }
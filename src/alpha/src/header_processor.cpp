@@ -19,12 +19,17 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include "comm_def.hpp"
+#include "compressed_output.hpp"
 #include "node.hpp"
 #include "session.hpp"
 #include "report_generator.hpp"
 #include "report_utils.hpp"
 #include "diffengine.hpp"
 #include "logger.hpp"
+#include "output_writer.hpp"
+#include "profiler.hpp"
+#include "report_format.hpp"
+#include "compile_flags.hpp"
 #include "header_processor.hpp"
 #include "session.hpp"
 
@@ -33,100 +38,97 @@ using namespace clang;
 using namespace clang::tooling;
 using namespace llvm;
 
-namespace {
-
-    std::vector<std::string> getClangFlags(const std::vector<std::string>& includePaths,
-                                           const std::vector<std::string>& macroFlags,
-                                           const LANG_OPTIONS lang) {
-        std::vector<std::string> flags;
-
-        const char* rawFlags;
-        switch (lang) {
-            case LANG_OPTIONS::C:
-                rawFlags = CLANG_FLAGS_C;
-                break;
-            case LANG_OPTIONS::CPP:
-                rawFlags = CLANG_FLAGS_CPP;
-                break;
-            default:
-                rawFlags = CLANG_FLAGS_CPP;
-                break;
-        }
-        
-        std::istringstream iss(rawFlags);
-        std::string flag;
-        while (iss >> flag) {
-            flags.emplace_back(std::move(flag));
-        }
+void reportHeaderPairAlpha(const std::string& project1,
+                       const std::string& file1,
+                       const std::string& reportFormat,
+                       const alpha::ASTNormalizedContext* context1,
+                       const alpha::ASTNormalizedContext* context2,
+                       bool dumpAstDiff,
+                       const armor::OutputPaths& outputs) {
+
+    // Perform the diff using the retrieved contexts
+    nlohmann::json diffResult;
+    {
+        armor::profile::PhaseTimer timer(armor::profile::Phase::DIFF_TREES);
+        diffResult = diffTrees(context1, context2);
+    }
 
-        // Add runtime include paths
-        for (const auto& path : includePaths) {
-            flags.emplace_back("-I" + path);
-        }
+    std::string headerName = std::filesystem::path(file1).filename().string();
 
-        // Add full macro flags directly
-        for (const auto& macro : macroFlags) {
-            flags.emplace_back(macro);
+    // The diff is handed to the report generator in memory; the JSON dump is a
+    // debugging aid only
+    if (dumpAstDiff && !diffResult.empty()) {
+        armor::ReportFormat dumpFormat = armor::reportFormatOf(reportFormat);
+        std::string outputFile = outputs.astDiffFile(headerName, dumpFormat);
+        try {
+            armor::OutputFile out(outputFile, true);
+            if (outputs.compressDebugOutput) {
+                armor::GzipOStream compressed(out.stream());
+                armor::writeReportDocument(compressed, diffResult, dumpFormat);
+                compressed.finish();
+            }
+            else {
+                armor::writeReportDocument(out.stream(), diffResult, dumpFormat);
+            }
+            out.close();
+        }
+        catch (const std::exception& e) {
+            armor::user_error() << "Error generating AST diff: " << e.what() << "\n";
         }
-
-        return flags;
     }
 
-
-    std::vector<std::string> resolveInternalIncludePaths(const std::vector<std::string>& internalPaths,
-                                                         const std::string& workspacePath) {
-
-        std::vector<std::string> resolvedPaths;
-        for (const auto& path : internalPaths) {
-            resolvedPaths.push_back(workspacePath + "/" + path);
+    if (!outputs.writeReports) {
+        if (!diffResult.empty()) {
+            report_generator(diffResult, fs::relative(file1, project1).string(), "", "", ALPHA_PARSER);
         }
-        return resolvedPaths;
+        return;
     }
 
-    std::vector<std::string> generateIncludePaths(const std::string& projectPath, const std::string& headerPath) {
-        std::vector<std::string> includePaths;
+    // The report directories are created as the reports are written
+    std::string htmlReportFile = outputs.htmlReportFile(headerName);
 
-        // Ensure the header path starts with the project path
-        if (headerPath.find(projectPath) != 0) {
-            armor::user_error() << "Warning: Header file " << headerPath << " is not within project path " << projectPath << "\n";
-            return includePaths;
+    if (!diffResult.empty()) {
+        bool generate_json = (reportFormat != "html");
+        std::string jsonReportFile;
+        if (generate_json) {
+            jsonReportFile = outputs.jsonReportFile(headerName, armor::reportFormatOf(reportFormat));
         }
-
-        // Get the directory of the header file
-        llvm::SmallString<256> headerDir(headerPath);
-        llvm::sys::path::remove_filename(headerDir);
-
-        // Start with the directory containing the header file
-        llvm::SmallString<256> currentPath = headerDir;
-
-        // Add all parent directories up to and including the project path
-        while (llvm::StringRef(currentPath).str().length() >= projectPath.length()) {
-            includePaths.push_back("-I" + llvm::StringRef(currentPath).str());
-
-            // Move up one directory
-            llvm::sys::path::remove_filename(currentPath);
-
-            // If we've reached the root directory, break
-            if (currentPath.empty()) {
-                break;
-            }
+        fs::path relative_path = fs::relative(file1, project1);
+        std::string trimmed_path = relative_path.string();
+        report_generator(diffResult, trimmed_path, htmlReportFile, jsonReportFile, ALPHA_PARSER, generate_json);
+    }
+    else {
+        try {
+            std::vector<json> emptyData;
+            // generate_html_report(emptyData, htmlReportFile, BETA_PARSER);
+            armor::user_print() << "HTML report generated at: " << htmlReportFile << "\n";
+        } catch (const std::exception& e) {
+            armor::user_error() << "Failed to generate HTML report: " << e.what() << "\n";
         }
+    }
+}
 
-        // Make sure the project path itself is included
-        if (std::find(includePaths.begin(), includePaths.end(), "-I" + projectPath) == includePaths.end()) {
-            includePaths.push_back("-I" + projectPath);
-        }
+void reportHeaderPairVerdictAlpha(const std::string& project1,
+                       const std::string& file1,
+                       const alpha::ASTNormalizedContext* context1,
+                       const alpha::ASTNormalizedContext* context2) {
 
-        return includePaths;
+    nlohmann::json diffResult;
+    {
+        armor::profile::PhaseTimer timer(armor::profile::Phase::DIFF_TREES);
+        diffResult = diffTrees(context1, context2);
     }
-}
 
+    // As reportHeaderPairAlpha writes no report for an empty diff
+    if (!diffResult.empty()) {
+        report_verdict(diffResult, fs::relative(file1, project1).string());
+    }
+}
 
-PARSING_STATUS processHeaderPairAlpha(const std::string& project1,
+ParsedHeaderPairAlpha parseHeaderPairAlpha(const std::string& project1,
                        const std::string& file1,
                        const std::string& project2,
                        const std::string& file2,
-                       const std::string& reportFormat,
                        const std::vector<std::string>& IncludePaths,
                        const std::vector<std::string>& macroFlags,
                        const LANG_OPTIONS lang) {
@@ -135,22 +137,14 @@ PARSING_STATUS processHeaderPairAlpha(const std::string& project1,
         armor::user_error() << "Failed to open diagnostics log <" << LOG_FILE_PATH << ">, using stderr\n";
     }
 
-    std::vector<std::string> inclusion_paths1 = generateIncludePaths(project1, file1);
-    std::vector<std::string> inclusion_paths2 = generateIncludePaths(project2, file2);
-
-    std::vector<std::string> inclusionPaths1 = resolveInternalIncludePaths(IncludePaths, project1);
-    std::vector<std::string> inclusionPaths2 = resolveInternalIncludePaths(IncludePaths, project2);
-
-    std::vector<std::string> Flags1 = getClangFlags(inclusionPaths1, macroFlags, lang);
-    std::vector<std::string> Flags2 = getClangFlags(inclusionPaths2, macroFlags, lang);
-
-    Flags1.insert(Flags1.end(), inclusion_paths1.begin(), inclusion_paths1.end());
-    Flags2.insert(Flags2.end(), inclusion_paths2.begin(), inclusion_paths2.end());
+    std::vector<std::string> Flags1 = armor::buildCompileFlags(project1, file1, IncludePaths, macroFlags, lang);
+    std::vector<std::string> Flags2 = armor::buildCompileFlags(project2, file2, IncludePaths, macroFlags, lang);
 
     // 1. Set up the Session
     auto compDB1 = std::make_unique<FixedCompilationDatabase>(project1, Flags1);
     auto compDB2 = std::make_unique<FixedCompilationDatabase>(project2, Flags2);
-    auto session = std::make_unique<alpha::APISession>();
+    ParsedHeaderPairAlpha parsed;
+    parsed.session = std::make_unique<alpha::APISession>();
 
     armor::info() << "Processing File1 : " << file1 << "\n";
     for (auto& x : Flags1) {
@@ -158,74 +152,45 @@ PARSING_STATUS processHeaderPairAlpha(const std::string& project1,
     }
 
     // 2. Process the files. The session handles the tools and contexts.
-    PARSING_STATUS header1ParsingStatus = session->processFile(file1, std::move(compDB1));
+    PARSING_STATUS header1ParsingStatus = parsed.session->processFile(file1, std::move(compDB1));
 
     armor::info() << "Processing File2 : " << file2 << "\n";
     for (auto& x : Flags2) {
         armor::info() << "Clang search path : " << x << "\n";
     }
 
-    PARSING_STATUS header2ParsingStatus = session->processFile(file2, std::move(compDB2));
+    PARSING_STATUS header2ParsingStatus = parsed.session->processFile(file2, std::move(compDB2));
 
     // 3. Retrieve the results from the session
-    const alpha::ASTNormalizedContext* context1 = session->getContext(file1);
-    const alpha::ASTNormalizedContext* context2 = session->getContext(file2);
-
-    PARSING_STATUS finalParsingStatus = header1ParsingStatus == header2ParsingStatus ? header1ParsingStatus : FATAL_ERRORS;
-
-    if (!context1 || !context2) {
+    parsed.context1 = parsed.session->getContext(file1);
+    parsed.context2 = parsed.session->getContext(file2);
+    parsed.status = header1ParsingStatus == header2ParsingStatus ? header1ParsingStatus : FATAL_ERRORS;
+    if (!parsed.context1 || !parsed.context2) {
         armor::user_error() << "Failed to retrieve processing results from session\n";
-        return FATAL_ERRORS;
+        parsed.status = FATAL_ERRORS;
     }
+    return parsed;
+}
 
-    // 4. Perform the diff using the retrieved contexts
-    nlohmann::json diffResult = diffTrees(context1, context2);
-
-    std::string headerName = std::filesystem::path(file1).filename().string();
-
-    std::string dumpDir = "debug_output/ast_diffs";
-    std::filesystem::create_directories(dumpDir);
-    std::string outputFile = dumpDir + "/ast_diff_output_" + headerName + ".json";
+PARSING_STATUS processHeaderPairAlpha(const std::string& project1,
+                       const std::string& file1,
+                       const std::string& project2,
+                       const std::string& file2,
+                       const std::string& reportFormat,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff) {
 
-    try {
-        if (!diffResult.empty()) {
-            std::ofstream out(outputFile);
-            out << diffResult.dump(4);
-            out.close();
-        }
-    }
-    catch (const std::exception& e) {
-        armor::user_error() << "Error generating AST diff: " << e.what() << "\n";
+    ParsedHeaderPairAlpha parsed = parseHeaderPairAlpha(project1, file1, project2, file2, IncludePaths, macroFlags, lang);
+    if (!parsed.context1 || !parsed.context2) {
+        return FATAL_ERRORS;
     }
 
-    std::string reportDir = "armor_reports/html_reports";
-    std::filesystem::create_directories(reportDir);
-    std::string htmlReportFile = reportDir + "/api_diff_report_" + headerName + ".html";
-
-    if (!diffResult.empty()) {
-        bool generate_json = (reportFormat == "json");
-        std::string jsonReportFile;
-        if (generate_json) {
-            std::string jsonReportDir = "armor_reports/json_reports";
-            std::filesystem::create_directories(jsonReportDir);
-            jsonReportFile = jsonReportDir + "/api_diff_report_" + headerName + ".json";
-        }
-        fs::path relative_path = fs::relative(file1, project1);
-        std::string trimmed_path = relative_path.string();
-        report_generator(outputFile, trimmed_path, htmlReportFile, jsonReportFile, ALPHA_PARSER, generate_json);
-    }
-    else {
-        try {
-            std::vector<json> emptyData;
-            // generate_html_report(emptyData, htmlReportFile, BETA_PARSER);
-            armor::user_print() << "HTML report generated at: " << htmlReportFile << "\n";
-        } catch (const std::exception& e) {
-            armor::user_error() << "Failed to generate HTML report: " << e.what() << "\n";
-        }
-    }
+    reportHeaderPairAlpha(project1, file1, reportFormat, parsed.context1, parsed.context2, dumpAstDiff);
 
     DebugConfig::getInstance().flush();
 
-    return finalParsingStatus;
+    return parsed.status;
 
-}
\ No newline at end of file
+}
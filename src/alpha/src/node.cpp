@@ -13,7 +13,7 @@ nlohmann::json alpha::APINode::diff(const std::shared_ptr<const alpha::APINode>&
     };
 
     // Define a lambda function to compare fields
-    auto compare = [&](const std::string& field, const auto &lhs, const auto &rhs, const auto &emptyValue) {
+    auto compare = [&](std::string_view field, const auto &lhs, const auto &rhs, const auto &emptyValue) {
         if (lhs != rhs) {
             if (lhs != emptyValue) {
                 removed[field] = serialize(lhs);
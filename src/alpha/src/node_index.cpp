@@ -0,0 +1,55 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include "node_index.hpp"
+#include "tree_builder_utils.hpp"
+
+alpha::NodeKey::NodeKey(NodeKind kind, llvm::StringRef qualifiedName)
+    : NodeKey(kind, qualifiedName, generateHash(qualifiedName, kind)) {}
+
+bool alpha::NodeIndex::insert(std::shared_ptr<const APINode> node) {
+    if (contains(NodeKey::of(*node))) {
+        return false;
+    }
+    chains.add(node->hash, static_cast<uint32_t>(nodes.size()));
+    nodes.push_back(std::move(node));
+    return true;
+}
+
+const std::shared_ptr<const alpha::APINode>& alpha::NodeIndex::find(const NodeKey& key) const {
+    static const std::shared_ptr<const APINode> none;
+    for (uint32_t slot = chains.first(key.hash); slot != detail::HashChains::NONE; slot = chains.next(slot)) {
+        if (NodeKey::of(*nodes[slot]) == key) {
+            return nodes[slot];
+        }
+    }
+    return none;
+}
+
+void alpha::NodeIndex::clear() {
+    nodes.clear();
+    chains.clear();
+}
+
+bool alpha::NodeKeySet::insert(const NodeKey& key) {
+    if (contains(key)) {
+        return false;
+    }
+    chains.add(key.hash, static_cast<uint32_t>(entries.size()));
+    entries.push_back({key.kind, key.qualifiedName.str()});
+    return true;
+}
+
+bool alpha::NodeKeySet::contains(const NodeKey& key) const {
+    for (uint32_t slot = chains.first(key.hash); slot != detail::HashChains::NONE; slot = chains.next(slot)) {
+        const Entry& entry = entries[slot];
+        if (entry.kind == key.kind && entry.qualifiedName == key.qualifiedName) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void alpha::NodeKeySet::clear() {
+    entries.clear();
+    chains.clear();
+}
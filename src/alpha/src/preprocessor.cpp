@@ -36,7 +36,7 @@ void ASTNormalizerPreprocessor::InclusionDirective(
             clang::PresumedLoc PLoc = SM->getPresumedLoc(HashLoc);
             if (PLoc.isValid()) {
                 if(llvm::StringRef fileName = PLoc.getFilename(); !fileName.empty() && !RelativePath.empty()){
-                    armor::debug() << "Failed include - RelativePath: " << RelativePath << " at " << PLoc.getFilename() << "\n";
+                    ARMOR_DEBUG_LOG << "Failed include - RelativePath: " << RelativePath << " at " << PLoc.getFilename() << "\n";
                     context->getSourceRangeTracker().addFatalDirective(RelativePath,PLoc.getFilename());
                 }
             }
@@ -19,12 +19,13 @@ alpha::TreeBuilder::TreeBuilder(alpha::ASTNormalizedContext* context): context(c
 
 inline bool alpha::TreeBuilder::IsFromMainFileAndNotLocal(const clang::Decl* Decl) {
     clang::ASTContext* clangContext = &Decl->getASTContext();
-    return clangContext->getSourceManager().isInMainFile(Decl->getLocation()) && Decl->getParentFunctionOrMethod() == nullptr;
+    return context->ownsLocation(clangContext->getSourceManager(), Decl->getLocation()) &&
+           Decl->getParentFunctionOrMethod() == nullptr;
 }
 
 inline void alpha::TreeBuilder::AddNode(const std::shared_ptr<APINode>& node) {
 
-    assert(!node->hash.empty());
+    assert(node->hash != 0 && "node key was never hashed");
 
     if (!nodeStack.empty()) {
         if (nodeStack.back()->children == nullptr) {
@@ -34,7 +35,7 @@ inline void alpha::TreeBuilder::AddNode(const std::shared_ptr<APINode>& node) {
     }
     else context->addRootNode(node);
     
-    if (nodeStack.empty()) context->addNode(node->hash, node);
+    if (nodeStack.empty()) context->addNode(node);
 }
 
 inline void alpha::TreeBuilder::PushNode(const std::shared_ptr<APINode>& node) {
@@ -55,7 +56,7 @@ inline void alpha::TreeBuilder::PopName() {
     qualifiedNames.pop();
 }
 
-inline const std::string alpha::TreeBuilder::GetCurrentQualifiedName() {
+inline std::string alpha::TreeBuilder::GetCurrentQualifiedName() {
     return qualifiedNames.getAsString();
 }
 
@@ -69,7 +70,7 @@ void alpha::TreeBuilder::BuildReturnTypeNode(clang::QualType type) {
     AddNode(returnNode);
     PopName();
 
-    armor::debug() << "BuildReturnType : " << returnNode->dataType << "\n";
+    ARMOR_DEBUG_LOG << "BuildReturnType : " << returnNode->dataType << "\n";
 }
 
 void alpha::TreeBuilder::normalizeFunctionPointerType(const std::string& dataType, clang::FunctionProtoTypeLoc FTL) {
@@ -127,18 +128,18 @@ void alpha::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, un
     } 
     else return;
 
-    const std::string dataType = Decl->isInvalidDecl() ? DATA_TYPE_PLACE_HOLDER : unDecayedDeclType.getAsString();
+    const std::string dataType = Decl->isInvalidDecl() ? std::string(DATA_TYPE_PLACE_HOLDER) : unDecayedDeclType.getAsString();
     ValueNode->qualifiedName = GetCurrentQualifiedName();
     ValueNode->hash = generateHash(ValueNode->qualifiedName, ValueNode->kind);
 
     if (llvm::isa<clang::ParmVarDecl>(Decl)) {
-        armor::debug() << "VisitParamDecl : " << ValueNode->qualifiedName << "\n";
+        ARMOR_DEBUG_LOG << "VisitParamDecl : " << ValueNode->qualifiedName << "\n";
     } 
     else if (llvm::isa<clang::FieldDecl>(Decl)) {
-        armor::debug() << "VisitFieldDecl : " << ValueNode->qualifiedName << "\n";
+        ARMOR_DEBUG_LOG << "VisitFieldDecl : " << ValueNode->qualifiedName << "\n";
     } 
     else if (llvm::isa<clang::VarDecl>(Decl)) {
-        armor::debug() << "VisitVarDecl : " << ValueNode->qualifiedName << "\n";
+        ARMOR_DEBUG_LOG << "VisitVarDecl : " << ValueNode->qualifiedName << "\n";
     } 
 
     AddNode(ValueNode);
@@ -182,7 +183,7 @@ bool alpha::TreeBuilder::BuildRecordNode(clang::RecordDecl* Decl) {
 
     recordNode->qualifiedName = qualifiedName;
 
-    armor::debug() << "VisitRecordDecl (C): " << qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitRecordDecl (C): " << qualifiedName << "\n";
 
     if (Decl->isStruct()) {
         recordNode->kind = NodeKind::Struct;
@@ -221,7 +222,7 @@ bool alpha::TreeBuilder::BuildCXXRecordNode(clang::CXXRecordDecl* Decl) {
 
     cxxRecordNode->qualifiedName = qualifiedName;
 
-    armor::debug() << "VisitCxxRecordDecl : " << qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitCxxRecordDecl : " << qualifiedName << "\n";
 
     if( Decl->isStruct() ){
         cxxRecordNode->kind = NodeKind::Struct;
@@ -279,7 +280,7 @@ bool alpha::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
         enumNode->qualifiedName = GetCurrentQualifiedName();
     }
 
-    armor::debug() << "VisitEnumDecl: " << enumNode->qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitEnumDecl: " << enumNode->qualifiedName << "\n";
 
     enumNode->kind = NodeKind::Enum;
     enumNode->hash = generateHash(enumNode->qualifiedName, NodeKind::Enum);
@@ -287,7 +288,7 @@ bool alpha::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
     if(!Decl->enumerators().empty()) nodeStack.push_back(enumNode);
 
     const clang::QualType enumType = Decl->getIntegerType();
-    std::string enumaratorDataType = Decl->isInvalidDecl() ? DATA_TYPE_PLACE_HOLDER : enumType.getAsString();
+    std::string enumaratorDataType = Decl->isInvalidDecl() ? std::string(DATA_TYPE_PLACE_HOLDER) : enumType.getAsString();
      
     for (const auto* EnumConstDecl : Decl->enumerators()) {
         auto enumValNode = std::make_shared<APINode>();
@@ -325,23 +326,23 @@ bool alpha::TreeBuilder::BuildFunctionNode(clang::FunctionDecl* Decl){
     Decl->printName(OS);
     PushName(nameBuf);
     std::string qualifiedName = GetCurrentQualifiedName();
-    std::string hash = generateHash(qualifiedName, NodeKind::Function);
+    NodeKey key(NodeKind::Function, qualifiedName);
     
-    if(context->hashSet.contains(hash)){
-        context->excludeNodes.insert(hash);
-        armor::debug() << "Excluding Function Overloads : " << qualifiedName << "\n";
+    if(context->hashSet.contains(key)){
+        context->excludeNodes.insert(key);
+        ARMOR_DEBUG_LOG << "Excluding Function Overloads : " << qualifiedName << "\n";
         PopName();
         return true;
     }
     
     functionNode->qualifiedName = qualifiedName;
     functionNode->kind = NodeKind::Function;
-    functionNode->hash = hash;
+    functionNode->hash = key.hash;
     functionNode->storage = getStorageClass(Decl->getStorageClass());
     functionNode->isInclined = Decl->isInlined();
 
-    armor::debug() << "VisitFunctionDecl : " << functionNode->qualifiedName << "\n";
-    context->hashSet.try_emplace(hash);
+    ARMOR_DEBUG_LOG << "VisitFunctionDecl : " << functionNode->qualifiedName << "\n";
+    context->hashSet.insert(key);
 
     AddNode(functionNode);
     PushNode(functionNode);
@@ -410,9 +411,7 @@ bool alpha::TreeBuilder::BuildTypedefDecl(clang::TypedefDecl *Decl) {
                 kind = NodeKind::Class;
             }
 
-            std::string hash = generateHash(GetCurrentQualifiedName(), kind);
-
-            context->excludeNodes.try_emplace(hash);
+            context->excludeNodes.insert(NodeKey(kind, GetCurrentQualifiedName()));
             PopName();
         }
     }
@@ -421,8 +420,7 @@ bool alpha::TreeBuilder::BuildTypedefDecl(clang::TypedefDecl *Decl) {
         if (unwrappedTL.getAs<clang::FunctionProtoTypeLoc>()) {
             Decl->printName(OS);
             PushName(nameBuf);
-            std::string hash = generateHash(GetCurrentQualifiedName(), NodeKind::Typedef);
-            context->excludeNodes.try_emplace(hash);
+            context->excludeNodes.insert(NodeKey(NodeKind::Typedef, GetCurrentQualifiedName()));
             PopName();
         }
     }
@@ -0,0 +1,83 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace clang {
+    class ASTUnit;
+}
+
+namespace armor {
+
+/**
+ * @class AstCache
+ * @brief Serialized clang ASTs of clean parses, kept under a cache directory (--ast-cache).
+ *
+ * Context cache entries are keyed by the tool version, so an upgrade of
+ * armor invalidates all of them at once. The AST a clang frontend run built
+ * for a header depends on the compiler, not on the normalizers, so its
+ * entries here are keyed by the clang version, the command line, whether
+ * foreign bodies were skipped and the header bytes only: after an upgrade a
+ * header is loaded from its AST file and normalized again, without
+ * preprocessing or semantic analysis.
+ *
+ * An entry is the AST file, as a PCH is written, and a small file listing
+ * every file the parse read with a hash of its contents, written after the
+ * AST so its presence means the AST is complete. An entry is only loaded
+ * while all of those files are unchanged. Units built with a PCH or clang
+ * modules import other AST files and are never stored.
+ *
+ * Files are written to a temporary file and renamed into place, so several
+ * armor processes may share one cache directory.
+ */
+class AstCache {
+public:
+    /**
+     * @brief Creates a cache under `cacheDir`; the directory is created on first store.
+     * @param skipForeignBodies Whether foreign function bodies are skipped, which leaves them
+     *                          out of the AST; such parses never share entries with full ones.
+     */
+    AstCache(const std::string& cacheDir, bool skipForeignBodies);
+
+    /**
+     * @brief Whether units compiled with `commandLine` can be stored: those
+     *        importing a PCH (-include-pch) or clang modules (-fmodules) cannot.
+     */
+    static bool canStore(const std::vector<std::string>& commandLine);
+
+    /**
+     * @brief Loads the AST stored for `fileName` parsed with `commandLine`.
+     *
+     * @param dependencies If not null, set on a hit to the files the stored parse read.
+     * @return The loaded unit, or nullptr on a missing, stale or unreadable entry.
+     */
+    std::unique_ptr<clang::ASTUnit> load(const std::string& fileName,
+                                         const std::vector<std::string>& commandLine,
+                                         std::vector<std::string>* dependencies = nullptr) const;
+
+    /**
+     * @brief Stores the serialized AST of a clean parse of `fileName`.
+     *
+     * Failures are logged and otherwise ignored.
+     *
+     * @param dependencies Every file read by the translation unit, including `fileName`.
+     */
+    void store(const std::string& fileName,
+               const std::vector<std::string>& commandLine,
+               const std::vector<std::string>& dependencies,
+               llvm::StringRef ast) const;
+
+private:
+    bool entryPaths(const std::string& fileName, const std::vector<std::string>& commandLine,
+                    std::string& astPath, std::string& dependencyPath) const;
+
+    std::string astDir;
+    bool skipForeignBodies;
+};
+
+}
@@ -0,0 +1,84 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor chain` subcommand.
+ */
+bool isChainInvocation(int argc, const char** argv);
+
+/**
+ * @brief Compares a train of releases, parsing every version of a header once.
+ *
+ * Usage: armor chain [options] <root1> <root2> ... <rootN> <header>...
+ *
+ * The leading arguments naming directories are the project roots, oldest
+ * first; the rest are headers relative to them. Each adjacent pair of
+ * versions is compared as `armor <rootK> <rootK+1>` would, with
+ * chain/vK_vK+1 under the output directory as its output root, and the
+ * first version against the last into chain/v1_vN. Only the contexts of the
+ * version being parsed, of the one before it and of the first version are
+ * resident at a time.
+ *
+ * The overall status of every header in every comparison is written to
+ * armor_reports/chain_report.json under the output directory. A header
+ * missing from the newer version of a comparison is backward incompatible,
+ * one missing from the older version backward compatible.
+ *
+ * @return false if the command line is invalid or a header changed backward
+ *         incompatibly in any comparison.
+ */
+bool runArmorChain(int argc, const char** argv);
+
+/**
+ * @brief Checks whether the command line is the `armor multibase` subcommand.
+ */
+bool isMultiBaseInvocation(int argc, const char** argv);
+
+/**
+ * @brief Compares one head against several base versions, parsing the head once.
+ *
+ * Usage: armor multibase [options] --base <root>... <headroot> <header>...
+ *
+ * Takes the options of `armor chain`. The head is parsed first and kept;
+ * each base is then parsed, compared against it into multibase/base<K>
+ * under the output directory, and freed. Every comparison's statuses and,
+ * per header, the worst of them are written to
+ * armor_reports/multibase_report.json under the output directory.
+ *
+ * @return false if the command line is invalid or a header is backward
+ *         incompatible with any base.
+ */
+bool runArmorMultiBase(int argc, const char** argv);
+
+/**
+ * @brief Checks whether the command line is the `armor whatif` subcommand.
+ */
+bool isWhatIfInvocation(int argc, const char** argv);
+
+/**
+ * @brief Decides which of several candidate patches keep a base compatible.
+ *
+ * Usage: armor whatif [options] --base <root> --patch <diff>... [<header>...]
+ *
+ * Takes the options of `armor chain`. The base is parsed once and kept.
+ * Each patch, a unified diff with paths as `patch -p1` takes them, is
+ * applied in memory and layered over the base as SourceBuffers, so no copy
+ * of the tree is written; the candidates are parsed in parallel and each is
+ * compared against the base into whatif/patch<K> under the output
+ * directory. The headers default to the .h and .hpp files the patches
+ * touch. A header a patch deletes is missing from its candidate, but an
+ * include of it is still read from disk.
+ *
+ * The statuses of every candidate and, per candidate, the worst of them are
+ * written to armor_reports/whatif_report.json under the output directory.
+ *
+ * @return false if the command line is invalid, a patch does not apply or
+ *         the report cannot be written; a candidate's verdict, incompatible
+ *         included, does not fail the command.
+ */
+bool runArmorWhatIf(int argc, const char** argv);
+
+}
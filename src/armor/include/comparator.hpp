@@ -0,0 +1,146 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api_filter.hpp"
+#include "comm_def.hpp"
+#include "diff_utils.hpp"
+#include "report_utils.hpp"
+
+namespace armor {
+
+/**
+ * @struct HeaderPair
+ * @brief The two versions of one header: `header`, relative to each project root.
+ */
+struct HeaderPair {
+    std::string projectRoot1;
+    std::string projectRoot2;
+    std::string header;
+    // Unsaved contents of files under projectRoot2, by path relative to it, read in place of
+    // the files on disk; `header` may be among them, with or without a file of its own
+    std::map<std::string, std::string> buffers2;
+};
+
+/**
+ * @struct CompareOptions
+ * @brief The options of Comparator, named after the command line options they stand for.
+ */
+struct CompareOptions {
+    // -I
+    std::vector<std::string> includePaths;
+    // --macro-flags, one flag per element
+    std::vector<std::string> macroFlags;
+    // --lang
+    LANG_OPTIONS lang = LANG_OPTIONS::CPP;
+    // --mode
+    PARSE_MODE parseMode = FULL_MODE;
+    // --skip-foreign-bodies
+    bool skipForeignBodies = false;
+    // --verdict-only: only CompareResult::overallStatus is set, from diffs stopped at their first incompatible change
+    bool verdictOnly = false;
+    // --api-filter; null keeps every declaration
+    std::shared_ptr<const ApiFilter> apiFilter;
+    // --cache-dir; empty disables the persistent cache
+    std::string cacheDir;
+    // --output-dir; when empty no reports or dumps are written
+    std::string outputDir;
+    // --report-format of the reports written under outputDir
+    std::string reportFormat = "html";
+    // --log-file; when empty nothing is logged
+    std::string logFile;
+};
+
+/**
+ * @enum CompareOutcome
+ * @brief How far the comparison of a pair got.
+ */
+enum class CompareOutcome {
+    // Both versions were parsed and diffed
+    COMPARED,
+    // Byte-identical versions, not parsed
+    IDENTICAL,
+    // Only the newer version exists; backward compatible
+    MISSING_IN_OLDER,
+    // Only the older version exists; backward incompatible
+    MISSING_IN_NEWER,
+    // Neither version exists, or the comparison threw; see CompareResult::error
+    FAILED
+};
+
+/**
+ * @struct CompareResult
+ * @brief What the report of a pair says, as typed values.
+ */
+struct CompareResult {
+    CompareOutcome outcome = CompareOutcome::FAILED;
+    // The header, relative to its project root, as reports name it
+    std::string header;
+    // As getOverAllCategory() names it, e.g. "BACKWARD_INCOMPATIBLE"; empty if nothing was reported
+    std::string overallStatus;
+    bool backwardIncompatible = false;
+    ParsedDiffStatus parsedStatus = ParsedDiffStatus::NON_FUNCTIONAL_CHANGES;
+    UnParsedDiffStatus unparsedStatus = UnParsedDiffStatus::UN_CHANGED;
+    // Parser whose diff was reported: BETA_PARSER, or ALPHA_PARSER for headers that failed to compile
+    PARSER parser = NO_PARSER;
+    // One row per changed API, as in the reports; not set with CompareOptions::verdictOnly
+    std::vector<ChangeRecord> changes;
+    std::string error;
+};
+
+/**
+ * @class Comparator
+ * @brief Compares header pairs in process, the embeddable form of `armor`.
+ *
+ * Each compare() runs the pipeline of a header on the command line (one
+ * clang parse per version feeding both parsers, then the diff) and returns
+ * the report as a CompareResult instead of files. Reports are only written
+ * when CompareOptions::outputDir is set.
+ *
+ * Included files read by one comparison are kept in memory for the next, as
+ * in `armor serve`; refresh() drops those that changed on disk since.
+ *
+ * A candidate version that only exists in memory, such as an editor's
+ * unsaved buffer or a patch under review, is compared through
+ * HeaderPair::buffers2 without writing it out: the buffers are layered over
+ * projectRoot2 for that comparison alone. With CompareOptions::cacheDir set,
+ * the older version is then loaded from the cache, so each candidate costs
+ * a single parse.
+ * Comparisons may run concurrently on different threads as long as they
+ * compare headers with different relative paths, whose results are told
+ * apart by that path.
+ */
+class Comparator {
+public:
+    explicit Comparator(CompareOptions options);
+
+    Comparator(const Comparator&) = delete;
+    Comparator& operator=(const Comparator&) = delete;
+
+    /**
+     * @brief Compares the two versions of `pair.header`.
+     *
+     * Never throws for a header that fails to compare: the result is then
+     * FAILED with its error.
+     */
+    CompareResult compare(const HeaderPair& pair) const;
+
+    /**
+     * @brief Forgets the cached contents of files changed since they were read.
+     *
+     * Must not run while a compare() does.
+     */
+    void refresh();
+
+    const CompareOptions& getOptions() const { return options; }
+
+private:
+    CompareOptions options;
+};
+
+}
@@ -0,0 +1,106 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api_filter.hpp"
+#include "comm_def.hpp"
+#include "alpha/include/ast_normalized_context.hpp"
+#include "beta/include/ast_normalized_context.hpp"
+
+namespace armor {
+
+class RemoteCache;
+
+/**
+ * @class ContextCache
+ * @brief Persistent on-disk cache of the normalized contexts of a header.
+ *
+ * An entry holds the alpha and beta contexts of one clean parse: the alpha
+ * context as CBOR, the beta context as a flat image that is mapped and read
+ * in place (see readFlatBetaContext), so loading a large baseline costs
+ * little more than mapping the file. It is keyed by a hash of the tool version, the parse mode, the
+ * compiler command line and the header bytes, and records every file the translation unit
+ * read together with a hash of its contents. An entry is only served while
+ * all of those files are unchanged, so editing a transitively included
+ * header invalidates it.
+ *
+ * Stores are written to a temporary file and renamed into place, so several
+ * armor processes may share one cache directory. With a RemoteCache attached,
+ * local misses are looked up remotely under the same key and every store is
+ * published to it, so machines share entries; a fetched entry is validated
+ * against the local files like a local one before it is used or kept. The
+ * remote store holds entries as chunks (see ChunkedRemoteCache), while the
+ * local entry files stay whole so they can be mapped.
+ */
+class ContextCache {
+public:
+    /**
+     * @brief Creates a cache rooted at `cacheDir`; the directory is created on first store.
+     * @param parseMode Mode the cached contexts were normalized in; modes never share entries.
+     * @param skipForeignBodies Whether foreign function bodies were skipped, which can hide
+     *                    errors in included code; such parses never share entries with full ones.
+     * @param remote      Shared store consulted on local misses (--remote-cache), or nullptr.
+     * @param apiFilter   Filter the contexts were normalized with (--api-filter), or nullptr;
+     *                    only parses with equal filters share entries.
+     */
+    explicit ContextCache(std::string cacheDir, PARSE_MODE parseMode = FULL_MODE, bool skipForeignBodies = false,
+                          std::shared_ptr<RemoteCache> remote = nullptr, const ApiFilter* apiFilter = nullptr);
+
+    /**
+     * @brief Loads the contexts cached for `fileName` parsed with `commandLine`.
+     *
+     * The output contexts are only assigned on a hit; a missing, stale or
+     * unreadable entry leaves them untouched.
+     *
+     * @param dependencies If not null, set on a hit to the files the cached parse read.
+     * @return true on a cache hit.
+     */
+    bool load(const std::string& fileName,
+              const std::vector<std::string>& commandLine,
+              alpha::ASTNormalizedContext& alphaContext,
+              beta::ASTNormalizedContext& betaContext,
+              std::vector<std::string>* dependencies = nullptr) const;
+
+    /**
+     * @brief Stores the contexts of a clean parse of `fileName`.
+     *
+     * Must be called before the contexts are diffed, since the beta diff
+     * consumes the unhandled declaration hashes of the newer context.
+     * Failures are logged and otherwise ignored.
+     *
+     * @param dependencies Every file read by the translation unit, including `fileName`.
+     */
+    void store(const std::string& fileName,
+               const std::vector<std::string>& commandLine,
+               const std::vector<std::string>& dependencies,
+               const alpha::ASTNormalizedContext& alphaContext,
+               const beta::ASTNormalizedContext& betaContext) const;
+
+    /**
+     * @brief Keeps the entries read or written by every cache of this process in memory.
+     *
+     * Used by the long-running --serve mode so a warm entry is not read and
+     * decoded from disk again. Dependencies are still rehashed on every load,
+     * so edits are picked up as without it. Also enables the
+     * beta::DeclSubtreeCache, so the declarations an edit left alone are
+     * copied from the parse before rather than walked again, and the
+     * ConditionalBlockCache, so are the hashes of the conditional branches
+     * it left alone.
+     */
+    static void keepEntriesInMemory();
+
+    const std::string& getDirectory() const { return cacheDir; }
+
+private:
+    std::string cacheDir;
+    PARSE_MODE parseMode;
+    bool skipForeignBodies;
+    std::shared_ptr<RemoteCache> remote;
+    std::string apiFilterKey;
+};
+
+}
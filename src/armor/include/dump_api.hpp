@@ -0,0 +1,33 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor dump-api` subcommand.
+ */
+bool isDumpApiInvocation(int argc, const char** argv);
+
+/**
+ * @brief Exports the normalized API of headers of one project version, without comparing anything.
+ *
+ * Usage: armor dump-api [options] <root> <header>...
+ *
+ * Every header is parsed once, in api-only mode, into the beta tree a
+ * comparison would diff. Its nodes are written in pre-order as a
+ * ColumnTable to armor_reports/api_dump/api_dump_<header>.<ext> under the
+ * output directory: parent row (-1 for a root), kind, qualified name, name,
+ * written and canonical type, access, storage, virtual and inline/constexpr
+ * qualifiers, record layout (with --record-layouts), USR, NSR and main
+ * file lines. `-I`, `-m`, `--lang`, `--skip-foreign-bodies`, `--api-filter`,
+ * `-j`, `--output-dir` and `--log-file` work as for `armor chain`; `-r`
+ * picks JSON (default), CBOR or MessagePack. The headers are split over
+ * `-j` sessions, each parsing and writing its own.
+ *
+ * @return false if the command line is invalid, or a header is missing,
+ *         fails to parse or cannot be written.
+ */
+bool runArmorDumpApi(int argc, const char** argv);
+
+}
@@ -0,0 +1,43 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "beta/include/ast_normalized_context.hpp"
+
+namespace armor {
+
+/**
+ * @brief Serializes `context` into a flat, offset-based image.
+ *
+ * The image is a fixed header followed by 8-byte aligned arrays: node
+ * records whose children and statement hashes are index ranges into shared
+ * arrays, the root list, the NSR tree and USR index as (string, node range)
+ * records, the unsupported USRs, the three hash multisets of the
+ * SourceRangeTracker as (hash, count) pairs, and one table holding every
+ * distinct string once. Strings are (offset, length) references into that
+ * table and nodes are referenced by index.
+ */
+std::string writeFlatBetaContext(const beta::ASTNormalizedContext& context);
+
+/**
+ * @brief Loads an image written by writeFlatBetaContext into `context`.
+ *
+ * The records are read in place, without a parsing step, and the node
+ * strings reference the string table of `image` rather than being copied;
+ * `storage`, which owns the bytes of `image`, is retained by the context so
+ * those references stay valid for its lifetime. An image not aligned to 8
+ * bytes is copied once first. Fingerprints are recomputed, as they are only
+ * stable within one build.
+ *
+ * @return false, leaving `context` in an unspecified state, for a truncated
+ *         or malformed image, including one whose children form a cycle.
+ */
+bool readFlatBetaContext(llvm::StringRef image, std::shared_ptr<const void> storage,
+                         beta::ASTNormalizedContext& context);
+
+}
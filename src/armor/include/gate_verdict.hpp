@@ -0,0 +1,52 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace armor {
+
+/**
+ * @brief How one header pair of a --blocking-headers run settled.
+ */
+struct GateHeader {
+    std::string header;
+    bool blocking = false;
+    bool backwardIncompatible = false;
+    bool failed = false;
+};
+
+/**
+ * @brief The gate verdict of the blocking headers of a run.
+ */
+struct GateVerdict {
+    std::size_t blockingHeaders = 0;
+    std::vector<std::string> incompatibleHeaders;
+    std::vector<std::string> failedHeaders;
+
+    /**
+     * @brief The exit status of a gate step reading the verdict: 1 when a
+     *        blocking header is backward incompatible or failed, 0 otherwise.
+     */
+    int exitCode() const;
+
+    /**
+     * @brief The verdict as printed and written to --gate-out:
+     *        {"backward_incompatible": false, "blocking_headers": 12, "headers": [], "failed": []}
+     */
+    nlohmann::json toJson() const;
+};
+
+/**
+ * @brief Decides the gate verdict from the settled pairs, in order.
+ *
+ * Only blocking pairs count. A backward incompatible pair is listed under
+ * "headers" even if it also failed; any other failed one under "failed".
+ */
+GateVerdict decideGateVerdict(const std::vector<GateHeader>& headers);
+
+}
@@ -0,0 +1,29 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor history` subcommand.
+ */
+bool isHistoryInvocation(int argc, const char** argv);
+
+/**
+ * @brief Prints the results recorded in a --history file, without comparing anything.
+ *
+ * Usage: armor history [--header H]... [--last N] [--records] <history-file>
+ *
+ * Prints one JSON line per recorded entry, oldest first:
+ *
+ *     {"header": "include/foo.h", "base": "v1.2", "head": "v1.3", "time": 1760000000,
+ *      "seconds": 2.5, "compatibility": "BACKWARD_INCOMPATIBLE", "api_names": [...]}
+ *
+ * restricted to the given headers and to the last N entries of each header,
+ * with the change records of every API under "records" if asked for.
+ *
+ * @return false if the file cannot be read or the command line is invalid.
+ */
+bool runArmorHistory(int argc, const char** argv);
+
+}
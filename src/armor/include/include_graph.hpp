@@ -0,0 +1,74 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace armor {
+
+/**
+ * @class IncludeGraph
+ * @brief Persistent record of the files each header's translation unit read.
+ *
+ * A record holds the resolved include closure of one clean parse of a
+ * header with one set of compile flags, with a hash of every file's
+ * contents; it lives under `<cacheDir>/includes` and is replaced on every
+ * clean parse. A byte-identical header whose included files changed between
+ * the two versions still has to be compared, which is what the record is
+ * consulted for before the header is skipped.
+ */
+class IncludeGraph {
+public:
+    explicit IncludeGraph(std::string cacheDir);
+
+    /**
+     * @brief Records that a clean parse of `header` with `flags` read `files`.
+     *
+     * Failures are logged and otherwise ignored; the header is then compared
+     * again next time.
+     */
+    void record(const std::string& header, const std::vector<std::string>& flags,
+                const std::vector<std::string>& files) const;
+
+    /**
+     * @brief Whether everything `header` includes is the same in both versions.
+     *
+     * True only if a record for `header` parsed with `flags` exists, every
+     * file it lists still has the recorded contents, so the closure is
+     * current, and every listed file under `root` has an identical
+     * counterpart under `otherRoot`. Files outside `root`, such as system
+     * headers, are the same file for both versions.
+     *
+     * A file that only exists under `otherRoot` and would be found first on
+     * the include path is not noticed; neither is a change of the
+     * --pch-header includes, which are taken as system headers.
+     */
+    bool closureUnchanged(const std::string& header, const std::vector<std::string>& flags,
+                          const std::string& root, const std::string& otherRoot) const;
+
+    /**
+     * @brief Digest of the include closure of `header` parsed with `flags`,
+     * for a DigestManifest.
+     *
+     * Covers every file of the record and its contents, the files under
+     * `root` by their path relative to it, so the two versions of an
+     * unchanged closure have the same digest. False if there is no record,
+     * or it is not current.
+     */
+    bool closureDigest(const std::string& header, const std::vector<std::string>& flags,
+                       const std::string& root, uint64_t& digest) const;
+
+private:
+    std::string recordPath(const std::string& header, const std::vector<std::string>& flags) const;
+
+    // The files of the record and their hashes; false if there is none or it is not current
+    bool readRecord(const std::string& header, const std::vector<std::string>& flags,
+                    std::vector<std::pair<std::string, uint64_t>>& files) const;
+
+    std::string graphDir;
+};
+
+}
@@ -0,0 +1,59 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor lock` subcommand.
+ */
+bool isLockInvocation(int argc, const char** argv);
+
+/**
+ * @brief Snapshots the normalized API of headers of one project version into a lock file.
+ *
+ * Usage: armor lock [options] <root> <header>... -o <lockfile>
+ *
+ * Every header is parsed once into the beta tree a comparison would diff,
+ * and the lock file keeps it as the flat image the context cache stores
+ * (see writeFlatBetaContext): the normalized nodes and the comment,
+ * unsupported and statement hash multisets. The compile flags (`-I`
+ * relative to the root, `-m`, `--lang`), `--mode`, `--skip-foreign-bodies`
+ * and the fingerprint of `--api-filter` are recorded with them, so
+ * `armor check` parses the head version the same way. `-j`, `--output-dir`
+ * and `--log-file` work as for `armor chain`.
+ *
+ * @return false if the command line is invalid, or a header is missing,
+ *         fails to parse or the lock file cannot be written.
+ */
+bool runArmorLock(int argc, const char** argv);
+
+/**
+ * @brief Checks whether the command line is the `armor check` subcommand.
+ */
+bool isCheckInvocation(int argc, const char** argv);
+
+/**
+ * @brief Compares the head version of a project against a lock file written by `armor lock`.
+ *
+ * Usage: armor check --lock <lockfile> [options] <root>
+ *
+ * Only the headers of the lock are parsed, under `root` and with the flags
+ * the lock recorded; the locked side is loaded from the lock file in place
+ * of a second checkout. Each header is reported as by a regular comparison,
+ * with the lock as the older version, and a locked header missing from
+ * `root` is backward incompatible. `--api-filter` must be the filter the
+ * lock was written with, if any. `-r`, `--verdict-only`, `-j`,
+ * `--output-dir` and `--log-file` work as for `armor chain`, and every
+ * status is summarized in armor_reports/check_report.json.
+ *
+ * A lock holds beta trees only, so a header the beta normalizer cannot
+ * handle is not reported through the alpha fallback; the lock is refused
+ * by an armor of another version.
+ *
+ * @return false if the command line or the lock is invalid, a header fails
+ *         to parse, or any header is backward incompatible.
+ */
+bool runArmorCheck(int argc, const char** argv);
+
+}
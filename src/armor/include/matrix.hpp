@@ -0,0 +1,58 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line asks for a --macro-matrix run.
+ */
+bool isMatrixInvocation(int argc, const char** argv);
+
+/**
+ * @brief Compares the headers under every configuration of a macro matrix.
+ *
+ * Usage: armor <regular arguments> --macro-matrix <file.yaml>
+ *
+ * The file lists configurations (see loadMacroMatrix). Each one runs in
+ * this process like `armor <regular arguments>`, with its macro-flags added
+ * to --macro-flags, `-r json` used unless a JSON, CBOR or MessagePack format
+ * is given, and configurations/<name> under the output directory as its
+ * output root. The stat and include cache (see SharedFileCache) is shared
+ * by all runs. Their findings are then combined (see MatrixReport) into
+ * armor_reports/matrix_report.{html,json} under the output directory.
+ *
+ * @return false if the matrix file is invalid, a configuration wrote no
+ *         report, or a finding of any configuration is backward incompatible.
+ */
+bool runArmorMatrix(int argc, const char** argv);
+
+/**
+ * @brief Checks whether the command line asks for a --pairs-file run.
+ */
+bool isPairsInvocation(int argc, const char** argv);
+
+/**
+ * @brief Compares the headers of every project of a pairs file.
+ *
+ * Usage: armor <regular options> --pairs-file <file.yaml>
+ *
+ * The file lists projects, each with its own two roots, headers or header
+ * directory, include paths, macro flags and language (see loadProjectPairs).
+ * Each one runs in this process like `armor <root1> <root2> <headers>
+ * <regular options>`, with its include paths added to -I, its macro-flags
+ * to --macro-flags, its lang replacing --lang, `-r json` used unless a JSON,
+ * CBOR or MessagePack format is given, and projects/<name> under the output
+ * directory as its output root. A project with a header-dir and no headers
+ * compares every header below it (--recursive). The stat and include cache
+ * (see SharedFileCache) is shared by all runs, so system and SDK headers
+ * common to the projects are read once. Their reports are then combined
+ * (see MergedReports) into armor_reports/summary_report.{html,json} under
+ * the output directory.
+ *
+ * @return false if the pairs file is invalid, a project wrote no report, or
+ *         a report of any project is backward incompatible.
+ */
+bool runArmorPairs(int argc, const char** argv);
+
+}
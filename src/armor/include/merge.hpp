@@ -0,0 +1,27 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor merge` subcommand.
+ */
+bool isMergeInvocation(int argc, const char** argv);
+
+/**
+ * @brief Combines the reports of several runs into one summary report.
+ *
+ * Usage: armor merge [--output-dir DIR] <shard-output-dir>...
+ *
+ * Each argument is the --output-dir of one run, typically one --shard of a
+ * sweep run with `-r json`. Their JSON reports are combined (see
+ * MergedReports) into armor_reports/summary_report.html and
+ * armor_reports/summary_report.json under the output directory.
+ *
+ * @return false if a report is malformed, no run wrote a JSON report, or the
+ *         command line is invalid.
+ */
+bool runArmorMerge(int argc, const char** argv);
+
+}
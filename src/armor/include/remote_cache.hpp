@@ -0,0 +1,115 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Program.h"
+
+#include "chunk_store.hpp"
+
+namespace armor {
+
+/**
+ * @class RemoteCache
+ * @brief Content-addressed store of cache entries shared between machines.
+ *
+ * Entries are opaque bytes under the key ContextCache computes for them;
+ * the local cache stays authoritative for validating an entry, so a remote
+ * store only has to return what was published under a key. Thread-safe.
+ */
+class RemoteCache {
+public:
+    virtual ~RemoteCache() = default;
+
+    /**
+     * @brief Fetches the entry published under `key`.
+     * @return true and the entry in `bytes` on a hit; misses and errors return false.
+     */
+    virtual bool fetch(const std::string& key, std::string& bytes) = 0;
+
+    /**
+     * @brief Publishes `bytes` under `key`; may complete after the call returns.
+     *        Failures are logged and otherwise ignored.
+     */
+    virtual void publish(const std::string& key, llvm::StringRef bytes) = 0;
+};
+
+/**
+ * @brief HTTP remote cache: GET and PUT of `<url>/<key>`, as served by
+ *        bazel-remote, nginx WebDAV or an S3-compatible bucket endpoint.
+ *
+ * Transfers run through the curl program, which also supplies credentials
+ * from ~/.netrc. Uploads run in the background and are waited for when the
+ * cache is destroyed.
+ */
+class HttpRemoteCache : public RemoteCache {
+public:
+    /** @throws std::runtime_error if curl is not found in PATH. */
+    explicit HttpRemoteCache(std::string url, unsigned timeoutSeconds = DEFAULT_TIMEOUT_SECONDS);
+
+    /** Waits for the pending uploads. */
+    ~HttpRemoteCache() override;
+
+    static constexpr unsigned DEFAULT_TIMEOUT_SECONDS = 10;
+
+    bool fetch(const std::string& key, std::string& bytes) override;
+    void publish(const std::string& key, llvm::StringRef bytes) override;
+
+    HttpRemoteCache(const HttpRemoteCache&) = delete;
+    HttpRemoteCache& operator=(const HttpRemoteCache&) = delete;
+
+private:
+    struct Upload {
+        llvm::sys::ProcessInfo process;
+        std::string bodyFile;
+    };
+
+    std::vector<std::string> curlArgs(const std::string& key) const;
+    // Caller holds `mutex`
+    void reapUploads(bool wait);
+
+    std::string url;
+    std::string curl;
+    unsigned timeoutSeconds;
+
+    std::mutex mutex;
+    std::vector<Upload> uploads;
+};
+
+/**
+ * @class ChunkedRemoteCache
+ * @brief Publishes entries to another remote cache as chunks shared between entries.
+ *
+ * An entry is published as a manifest under its key and each of its chunks
+ * under the chunk's own key (see ChunkStore), so the entries of consecutive
+ * versions of a header, which differ in a few chunks, share the rest in the
+ * remote store. Chunks are kept under chunks/ of the local cache directory:
+ * publishing uploads only those not held locally yet, and fetching downloads
+ * only the manifest and the chunks not held. A chunk is not uploaded again
+ * while held, even if its first upload failed; entries needing it then miss
+ * on other machines until it is evicted here.
+ */
+class ChunkedRemoteCache : public RemoteCache {
+public:
+    ChunkedRemoteCache(std::shared_ptr<RemoteCache> inner, const std::string& cacheDir);
+
+    bool fetch(const std::string& key, std::string& bytes) override;
+    void publish(const std::string& key, llvm::StringRef bytes) override;
+
+private:
+    std::shared_ptr<RemoteCache> inner;
+    ChunkStore chunks;
+};
+
+/**
+ * @brief Remote cache for `url` (http:// or https://).
+ * @throws std::runtime_error for an unsupported scheme or a missing transfer tool.
+ */
+std::shared_ptr<RemoteCache> createRemoteCache(const std::string& url);
+
+}
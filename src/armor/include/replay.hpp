@@ -0,0 +1,28 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is `armor --replay`.
+ */
+bool isReplayInvocation(int argc, const char** argv);
+
+/**
+ * @brief Parses and compares the header pairs of a repro bundle again, offline.
+ *
+ * Usage: armor --replay [--output-dir DIR] [-r FORMAT] <bundle-dir>
+ *
+ * Every pair recorded by --capture-bundle is parsed with its recorded flags
+ * from the files in the bundle, which appear at their original paths (see
+ * ReproBundle), and reported as in the captured run. The project roots are
+ * created empty where they do not exist, as the compile commands run there.
+ * Profiling is on: the phase times are printed, and written per header to
+ * armor_reports/profiles, next to the times the bundle recorded.
+ *
+ * @return false if the bundle cannot be read or a pair cannot be replayed.
+ */
+bool runArmorReplay(int argc, const char** argv);
+
+}
@@ -0,0 +1,29 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor select-headers` subcommand.
+ */
+bool isSelectHeadersInvocation(int argc, const char** argv);
+
+/**
+ * @brief Expands the header patterns of a branch config, as
+ *        action_script/parse_headers.sh does, without comparing anything.
+ *
+ * Usage: armor select-headers [--workspace DIR] [--changed-files FILE] [-j N]
+ *                             <config.yml> <branch> <root>...
+ *
+ * The roots are walked once, in parallel (see selectHeaders), and the
+ * headers are written one per line, sorted, to blocking_headers_final.txt,
+ * nonblocking_headers_final.txt and headers.txt (both) in the workspace.
+ * With --changed-files, the selected headers listed in that file are
+ * written to updated_headers_PR.txt too.
+ *
+ * @return false if the config cannot be read or a list cannot be written.
+ */
+bool runArmorSelectHeaders(int argc, const char** argv);
+
+}
@@ -0,0 +1,67 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line asks for the --serve mode.
+ */
+bool isServeInvocation(int argc, const char** argv);
+
+/**
+ * @brief Runs armor as a long-running daemon answering compare requests on a Unix socket.
+ *
+ * Usage: armor --serve <socket> [--cache-dir DIR] [--workers N] [--metrics-file PATH]
+ *
+ * Each connection carries one request, a JSON object on a single line:
+ *
+ *     {"cwd": "/path/to/workdir", "args": ["<projectroot1>", "<projectroot2>", "foo.h", ...]}
+ *
+ * `args` are the regular command line arguments. The request runs in `cwd`
+ * exactly like `armor <args>`, with `-r json` added if no report format is
+ * given and the daemon's cache directory used if `--cache-dir` is not. The
+ * reply is a single line:
+ *
+ *     {"ok": true, "reports": {"api_diff_report_foo.h.json": {...}}}
+ *
+ * holding the JSON reports the request wrote. `{"command": "shutdown"}`
+ * stops the daemon.
+ *
+ * A request may instead compare one header whose newer version is held in
+ * memory, such as an editor's unsaved buffer or a candidate patch:
+ *
+ *     {"cwd": "...", "compare": {"project_root1": "v1", "project_root2": "v2", "header": "foo.h",
+ *                                "buffers": {"foo.h": "<contents>"}, "include_paths": [...]}}
+ *
+ * `buffers` maps paths relative to `project_root2` to contents read in place
+ * of those files (see armor::Comparator), so nothing is written to disk.
+ * `macro_flags`, `lang`, `mode` and `verdict_only` may be given too, as the
+ * command line options of the same names. The reply carries the result
+ * itself rather than reports:
+ *
+ *     {"ok": true, "outcome": "COMPARED", "header": "foo.h", "overall_status": "...",
+ *      "backward_incompatible": false, "changes": [...]}
+ *
+ * Normalized contexts stay warm between requests: cache entries are kept in
+ * memory (see ContextCache::keepEntriesInMemory), so an unchanged baseline
+ * header is neither re-parsed nor re-read from disk. Requests are served one
+ * at a time, since each one runs in its own working directory.
+ *
+ * With `--workers N` that many processes are forked after the socket is set
+ * up and accept on it side by side. Each keeps its own memory tier, but its
+ * entries are read-only mappings of the entry files, so a baseline is held
+ * once in the page cache however many workers use it. A worker that dies is
+ * replaced; a shutdown request to any of them stops all.
+ *
+ * `{"command": "metrics"}` is answered with the armor::Metrics of the
+ * process that accepted it, as `{"ok": true, "metrics": "<Prometheus text>"}`.
+ * With `--metrics-file` every process also rewrites them to a file after
+ * each request, for the node_exporter textfile collector; worker N writes
+ * its own, with `.workerN` before the extension, labelled `worker="N"`.
+ *
+ * @return false if the socket could not be set up or stopped accepting.
+ */
+bool runArmorServer(int argc, const char** argv);
+
+}
@@ -0,0 +1,354 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+
+#include "api_filter.hpp"
+#include "ast_cache.hpp"
+#include "changed_ranges.hpp"
+#include "comm_def.hpp"
+#include "context_cache.hpp"
+#include "output_paths.hpp"
+#include "precompiled_header.hpp"
+#include "repro_bundle.hpp"
+#include "source_buffers.hpp"
+#include "alpha/include/session.hpp"
+#include "beta/include/diffengine.hpp"
+#include "beta/include/session.hpp"
+
+namespace armor {
+
+/**
+ * @brief Seconds the frontend run of one header may take (--header-timeout);
+ *        0, the default, leaves it unbounded.
+ *
+ * The run is cancelled cooperatively: once the time is up, the next file it
+ * enters or declaration it completes raises a fatal error, after which clang
+ * enters no more includes and instantiates no more templates, and the rest of
+ * the header is parsed without them. The parse then counts as failed and the
+ * session remembers it as timed out. Umbrella units (--umbrella) are not
+ * bounded. Meant to be set before any header is parsed.
+ */
+void setHeaderTimeout(double seconds);
+
+/**
+ * @brief Retries a pair whose parse failed on missing includes, once, with
+ *        -I flags for the directories of its root that hold them (see
+ *        IncludeResolver). Off by default. Meant to be set before any header is parsed.
+ */
+void setIncludeResolution(bool enabled);
+
+/**
+ * @brief Normalizes a parsed unit for alpha on a second thread while beta
+ *        normalizes it, rather than one after the other. Off by default.
+ *
+ * Only C units parsed without a PCH or modules qualify; the others are
+ * normalized in turn as before.
+ * Units with errors are only normalized for alpha either way. Meant to be
+ * set before any header is parsed.
+ */
+void setConcurrentNormalize(bool enabled);
+
+/**
+ * @brief Also keeps the serialized clang AST of every clean parse under the
+ *        cache directory (--ast-cache), see AstCache. Off by default.
+ *
+ * Only sessions with a ContextCache in API_ONLY_MODE use it, as the comment
+ * handler and preprocessor callbacks of a full parse never see a loaded AST.
+ * A header missing from the context cache, as after an armor upgrade, is
+ * then loaded from its AST and normalized again without being parsed, and
+ * the contexts are stored back into the context cache. Writing the AST
+ * makes a parse slower. Meant to be set before any header is parsed.
+ */
+void setAstCache(bool enabled);
+
+/**
+ * @class SinglePassSession
+ * @brief Normalizes a header for both parsers from a single clang frontend run.
+ *
+ * The alpha fatal-directive tracking and the beta normalizer (visitor, comment
+ * handler and preprocessor callbacks) are attached to the same
+ * CompilerInstance, so each header version is parsed exactly once. The beta
+ * visitor is skipped for translation units that failed to compile, matching
+ * the two-pass flow where beta only ran after a clean alpha pass.
+ *
+ * With a ContextCache attached, unchanged headers are loaded from it instead
+ * of being parsed, and clean parses are stored back into it. Headers under
+ * the root of the session's SourceBuffers bypass the cache, as does any
+ * parse that read a buffer, since the cache validates entries against disk.
+ *
+ * In API_ONLY_MODE the beta comment handler and preprocessor callbacks are
+ * not attached; the alpha callbacks are, since alpha needs them to report.
+ */
+class SinglePassSession {
+public:
+    SinglePassSession() = default;
+
+    /**
+     * @brief Creates a session backed by `cache`, which must outlive it.
+     * @param parseMode What the beta normalizer tracks, see beta::APISession::setParseMode.
+     * @param skipForeignBodies Skip bodies outside the main file, see beta::APISession::setSkipForeignBodies.
+     * @param apiFilter Declarations left out of both contexts, see beta::APISession::setApiFilter.
+     */
+    explicit SinglePassSession(const ContextCache* cache, PARSE_MODE parseMode = FULL_MODE,
+                               bool skipForeignBodies = false, const ApiFilter* apiFilter = nullptr);
+
+    /**
+     * @brief Parses `fileName` once and populates both normalized contexts.
+     * @param fileName Header to parse.
+     * @param compDB   Compilation database providing the command line.
+     * @return PARSING_STATUS of the frontend run; NO_FATAL_ERRORS on a cache hit.
+     */
+    PARSING_STATUS processFile(const std::string& fileName,
+                               std::unique_ptr<clang::tooling::FixedCompilationDatabase> compDB);
+
+    /**
+     * @brief Parses several headers through one ClangTool, sharing its FileManager.
+     * @param fileNames Headers to parse.
+     * @param compDB    Database with a compile command for every header.
+     * @return The status of every header, in the order of `fileNames`.
+     */
+    std::vector<PARSING_STATUS> processFiles(const std::vector<std::string>& fileNames,
+                                             const clang::tooling::CompilationDatabase& compDB);
+
+    /**
+     * @brief Parses headers of one project version as a single umbrella translation unit.
+     *
+     * A generated source including every header, in order, is parsed once, and
+     * each header's declarations, comments and preprocessor regions are given
+     * to its own contexts by FileID. A header sees the macros and declarations
+     * of those included before it. The cache is not consulted.
+     *
+     * @param fileNames    Headers to parse.
+     * @param umbrellaName Path the generated source is parsed as; it is never written.
+     * @param compDB       Database with the compile command of `umbrellaName`.
+     * @return FATAL_ERRORS if the umbrella failed to compile or a header was never
+     *         entered; the contexts are then incomplete and must be discarded.
+     */
+    PARSING_STATUS processUmbrella(const std::vector<std::string>& fileNames, const std::string& umbrellaName,
+                                   const clang::tooling::CompilationDatabase& compDB);
+
+    alpha::ASTNormalizedContext* getAlphaContext(const std::string& fileName) const;
+
+    beta::ASTNormalizedContext* getBetaContext(const std::string& fileName) const;
+
+    /**
+     * @brief Files the translation unit of `fileName` read, `fileName` included.
+     *
+     * Only known for clean parses and cache hits of a session with a cache;
+     * empty otherwise. The precompiled header, if any, is not listed.
+     */
+    std::vector<std::string> getReadFiles(const std::string& fileName) const;
+
+    /**
+     * @brief Diffs the beta roots of `fileName` while it is parsed, see RootDiffPipeline.
+     *
+     * Called before `fileName` is processed; its caller gives the returned
+     * pipeline the older version once that is complete. A cache hit leaves the
+     * pipeline idle. Owned by the session until releaseContexts(fileName).
+     */
+    RootDiffPipeline& pipelineDiff(const std::string& fileName);
+
+    /**
+     * @brief Frees both contexts, the pipeline and the read files of `fileName` once its pair is reported.
+     */
+    void releaseContexts(const std::string& fileName);
+
+    /** @brief Whether the last parse of `fileName` ran past the header timeout (see setHeaderTimeout). */
+    bool timedOut(const std::string& fileName) const;
+
+    /**
+     * @brief Parses every header with `buffers` layered over the files on disk.
+     *
+     * `buffers` must outlive the session; nullptr, the default, reads from disk only.
+     */
+    void setSourceBuffers(const SourceBuffers* buffers) { this->buffers = buffers; }
+
+private:
+    // Normalizes `fileName` from its stored AST; false on an AstCache miss
+    bool normalizeStoredAst(const std::string& fileName, const std::vector<std::string>& commandLine);
+
+    void rememberReadFiles(const std::string& fileName, std::vector<std::string> files,
+                           const std::vector<std::string>& commandLine);
+
+    const ContextCache* cache = nullptr;
+    // Set while setAstCache is on, for sessions that qualify
+    std::unique_ptr<AstCache> astCache;
+    const SourceBuffers* buffers = nullptr;
+    // Files read by every clean or cached translation unit; both versions may be parsed at once
+    mutable std::mutex readFilesMutex;
+    llvm::StringMap<std::vector<std::string>> readFiles;
+    mutable std::mutex timedOutMutex;
+    llvm::StringSet<> timedOutFiles;
+    alpha::APISession alphaSession;
+    beta::APISession betaSession;
+    // Destroyed before the contexts their workers read
+    mutable std::mutex pipelinesMutex;
+    llvm::StringMap<std::unique_ptr<RootDiffPipeline>> pipelines;
+};
+
+/**
+ * @brief Single-parse replacement for processHeaderPairAlpha + processHeaderPairBeta.
+ *
+ * Produces the same reports as the two-pass flow: the beta report when both
+ * versions parsed without fatal errors, the alpha report otherwise. The
+ * two-pass flow writes the alpha report first in every case, but the beta
+ * report replaces it, so the alpha diff is not made when beta runs. A pair
+ * either of whose versions timed out is reported by reportTimedOutHeaderPair.
+ *
+ * @param dumpAstDiff Also write the raw diffs to debug_output/ast_diffs.
+ * @param verdictOnly --verdict-only: only the overall status of the pair is recorded in
+ *                    ReportSummaries, from the beta diff ended at its first backward
+ *                    incompatible entry, or from the alpha diff if beta does not run.
+ *                    No reports or dumps are written.
+ * @param cacheDir    Persistent normalized-API cache directory; empty disables it.
+ * @param remoteCache Shared cache behind `cacheDir` (--remote-cache), or nullptr.
+ * @param pchCache    Shared prefix PCH force-included into both versions, or nullptr.
+ * @param changedRanges Changed lines per header (--changed-ranges); the beta diff of a
+ *                    header listed there skips declarations no change touches. May be nullptr.
+ * @param apiFilter   Declarations that are not public API (--api-filter), left out of both
+ *                    parsers' trees; nullptr keeps every declaration.
+ * @param parseMode   API_ONLY_MODE (--mode=api-only) compares the beta node trees without
+ *                    tracking comments and preprocessor regions.
+ * @param skipForeignBodies --skip-foreign-bodies: function bodies outside each header are not parsed.
+ * @param diffJobs    Threads the beta diff may spread the pair's matched roots over (see beta diffTrees).
+ * @param outputs     Where the reports and dumps are written (--output-dir).
+ * @param buffers     Unsaved files under `projectRoot2` parsed in place of the disk ones
+ *                    (see SourceBuffers), `file2` possibly among them; nullptr reads from
+ *                    disk only. The older version never sees them and still loads from
+ *                    the cache, so both versions may be the same file of the same root.
+ * @return PARSING_STATUS the alpha status of the pair.
+ */
+PARSING_STATUS processHeaderPairSinglePass(const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& projectRoot2,
+                       const std::string& file2,
+                       const std::string& reportFormat,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff,
+                       bool verdictOnly,
+                       const std::string& cacheDir,
+                       const std::shared_ptr<RemoteCache>& remoteCache,
+                       PrecompiledHeaderCache* pchCache,
+                       const ChangedRanges* changedRanges,
+                       const ApiFilter* apiFilter,
+                       PARSE_MODE parseMode,
+                       bool skipForeignBodies,
+                       unsigned diffJobs,
+                       const OutputPaths& outputs,
+                       const SourceBuffers* buffers = nullptr);
+
+/**
+ * @brief processHeaderPairSinglePass for a pair of a repro bundle (armor --replay).
+ *
+ * Parses both versions with the flags recorded for them, without a cache,
+ * and writes the same reports. The files are read wherever the tool file
+ * system finds them, from the bundle once ReproBundle::createFileSystem is
+ * set as the overlay.
+ */
+PARSING_STATUS replayHeaderPairSinglePass(const ReproBundle::HeaderPair& pair,
+                       const std::string& reportFormat,
+                       PARSE_MODE parseMode,
+                       bool skipForeignBodies,
+                       const OutputPaths& outputs);
+
+/**
+ * @brief Reports a header pair that was not compared because parsing it ran
+ *        past the header timeout.
+ *
+ * Records TIMED_OUT in ReportSummaries and, unless `verdictOnly`, writes
+ * reports with that overall status and `reason` and no API rows.
+ */
+void reportTimedOutHeaderPair(const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& reason,
+                       const std::string& reportFormat,
+                       bool verdictOnly,
+                       const OutputPaths& outputs);
+
+/**
+ * @brief Reports a header pair whose versions were already parsed, `file1`
+ *        by `session1` and `file2` by `session2` (which may be the same).
+ *
+ * Writes the same reports as processHeaderPairSinglePass, from the beta
+ * contexts when both parses succeeded and from the alpha ones otherwise, and
+ * leaves the contexts in their sessions. Lets a caller that parses each
+ * version once compare it against several others (see `armor chain`).
+ *
+ * @param status1 PARSING_STATUS of the parse of `file1`, as processFiles returned it.
+ * @param status2 PARSING_STATUS of the parse of `file2`.
+ * @return PARSING_STATUS of the pair: FATAL_ERRORS unless both parses succeeded.
+ */
+PARSING_STATUS reportHeaderPairSinglePass(const SinglePassSession& session1,
+                       const SinglePassSession& session2,
+                       const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& file2,
+                       PARSING_STATUS status1,
+                       PARSING_STATUS status2,
+                       const std::string& reportFormat,
+                       bool verdictOnly,
+                       unsigned diffJobs,
+                       const OutputPaths& outputs);
+
+/**
+ * @brief Batch form of processHeaderPairSinglePass for many header pairs.
+ *
+ * Each version's headers are split into max(1, jobs/2) groups, and every
+ * group is parsed through one ClangTool (SinglePassSession::processFiles),
+ * so tool setup and the FileManager's caches are shared by the group. Both
+ * versions of a group parse concurrently; the pairs are then reported in
+ * parallel with the same reports as processHeaderPairSinglePass. With fewer
+ * pairs than workers, the idle workers are shared out to the pairs' diffs.
+ *
+ * With `umbrella`, all headers of a version are parsed as one translation
+ * unit instead (SinglePassSession::processUmbrella), so their shared includes
+ * are parsed once per version. If either umbrella fails to compile, the pairs
+ * are parsed in groups as above, so every header reports its own errors.
+ *
+ * The contexts of a pair are freed as soon as it is reported. With
+ * `maxMemoryBytes`, the groups parse the pairs in waves instead of all at
+ * once, each wave reported before the next is parsed: the first wave holds
+ * one pair per group and measures how much memory a pair takes, and later
+ * waves hold as many pairs as fit under the limit, but at least one per
+ * group. Umbrella parses are not split.
+ *
+ * @param headerPairs (older, newer) header paths, both of which must exist.
+ * @param jobs        Worker count as for --jobs (0 picks the core count).
+ * @param outputs     Where the reports and dumps are written (--output-dir).
+ * @param maxMemoryBytes Resident memory the waves are sized for (--max-memory); 0 parses all pairs at once.
+ * @return PARSING_STATUS of every pair, in the order of `headerPairs`.
+ */
+std::vector<PARSING_STATUS> processHeaderPairsSinglePass(const std::string& projectRoot1,
+                       const std::string& projectRoot2,
+                       const std::vector<std::pair<std::string, std::string>>& headerPairs,
+                       const std::string& reportFormat,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff,
+                       bool verdictOnly,
+                       const std::string& cacheDir,
+                       const std::shared_ptr<RemoteCache>& remoteCache,
+                       PrecompiledHeaderCache* pchCache,
+                       const ChangedRanges* changedRanges,
+                       const ApiFilter* apiFilter,
+                       PARSE_MODE parseMode,
+                       bool skipForeignBodies,
+                       bool umbrella,
+                       unsigned jobs,
+                       const OutputPaths& outputs,
+                       std::size_t maxMemoryBytes = 0);
+
+}
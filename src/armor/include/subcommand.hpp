@@ -0,0 +1,21 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "CLI/CLI.hpp"
+
+namespace armor {
+
+/**
+ * @brief Parses the arguments of an `armor <subcommand>` command line into `app`.
+ *
+ * The subcommand name stands in for the program name, so usage and errors
+ * name the subcommand rather than armor.
+ *
+ * @param succeeded Set, when parsing ends the run, to whether it ended well:
+ *                  true after --help, false after an invalid command line.
+ * @return false if the subcommand is to return `succeeded` without running.
+ */
+bool parseSubcommand(CLI::App& app, int argc, const char** argv, bool& succeeded);
+
+}
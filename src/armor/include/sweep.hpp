@@ -0,0 +1,39 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor bench-sweep` subcommand.
+ */
+bool isBenchSweepInvocation(int argc, const char** argv);
+
+/**
+ * @brief Runs the CI flow over a recorded corpus and measures it end to end.
+ *
+ * Usage: armor bench-sweep [-j N] [--repeat N] [--output-dir DIR] <config.yaml>
+ *
+ * The config names the corpus and its fixed settings (see
+ * loadBenchSweepConfig); -j and --repeat override its jobs and repeat.
+ * Every run does what action_script/parse_headers.sh and run_armor.sh do:
+ * the patterns of the branch select the headers (see selectHeaders), those
+ * present under both roots are scheduled into rounds by basename (see
+ * scheduleHeaderRounds), and each round runs in this process like
+ * `armor <base> <head> --headers-from <round> --blocking-headers ... -r json
+ * --ndjson-out ... --profile`, under sweep/run<R>/round<N> of the output
+ * directory. Unlike run_armor.sh, headers missing from a root are left out
+ * rather than created, so the corpus stays as recorded.
+ *
+ * Printed and written to armor_reports/sweep_report.json: the headers per
+ * second of each run and their median, the p50, p95 and p99 latency of a
+ * header over all runs, and the peak RSS of the process. A header's latency
+ * is the wall time from the start of its first parse to the end of its
+ * reports, as its profile records it.
+ *
+ * @return false if the config or header config cannot be read, no header
+ *         is selected, or the summary cannot be written.
+ */
+bool runArmorBenchSweep(int argc, const char** argv);
+
+}
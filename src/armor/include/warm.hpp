@@ -0,0 +1,37 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace armor {
+
+/**
+ * @brief Checks whether the command line is the `armor warm` subcommand.
+ */
+bool isWarmInvocation(int argc, const char** argv);
+
+/**
+ * @brief Fills the context cache with the headers of one project version.
+ *
+ * Usage: armor warm --cache-dir <dir> [options] <root> [<header>...]
+ *
+ * Meant to run on the base branch after every merge, so the comparisons of
+ * the next pull requests load the base from the cache. Each header is
+ * looked up in the cache and, on a miss, parsed and stored, as the older
+ * version of a regular run with the same --cache-dir would be; with
+ * --remote-cache the stores are published there too. The headers are paths
+ * under --header-dir if given, else under the root; without any, every .h
+ * and .hpp file below that directory is warmed. `-I`, `-m`, `--lang`,
+ * `--mode`, `--skip-foreign-bodies` and `--api-filter` must be those of the
+ * runs that are to hit the entries, which are keyed by the command line and
+ * so by the path of the root too.
+ *
+ * Headers are parsed in batches sharing one ClangTool, on up to -j threads.
+ * One that fails to parse is reported and not cached, as a regular run
+ * would not cache it either.
+ *
+ * @return false if the command line is invalid, a named header is missing
+ *         or no header could be warmed.
+ */
+bool runArmorWarm(int argc, const char** argv);
+
+}
@@ -0,0 +1,193 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Serialization/PCHContainerOperations.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+#include "ast_cache.hpp"
+#include "cache_directory.hpp"
+#include "logger.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+    // Bump whenever the entry layout or the way the AST is written changes
+    constexpr uint32_t AST_CACHE_FORMAT_VERSION = 2;
+
+    bool hashFile(const std::string& path, uint64_t& hash) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+            llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if (!buffer) {
+            return false;
+        }
+        hash = llvm::xxHash64((*buffer)->getBuffer());
+        return true;
+    }
+
+    bool writeAtomically(const std::string& path, llvm::StringRef bytes, const std::string& fileName) {
+        std::string error;
+        if (!armor::publishCacheFile(path, bytes, error)) {
+            ARMOR_DEBUG_LOG << "Cannot store the AST of " << fileName << " : " << error << "\n";
+            return false;
+        }
+        return true;
+    }
+
+}
+
+armor::AstCache::AstCache(const std::string& cacheDir, bool skipForeignBodies) : skipForeignBodies(skipForeignBodies) {
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(path, "asts");
+    astDir = path.str().str();
+}
+
+bool armor::AstCache::canStore(const std::vector<std::string>& commandLine) {
+    return std::none_of(commandLine.begin(), commandLine.end(), [](const std::string& arg) {
+        return arg == "-include-pch" || arg == "-fmodules";
+    });
+}
+
+bool armor::AstCache::entryPaths(const std::string& fileName, const std::vector<std::string>& commandLine,
+                                 std::string& astPath, std::string& dependencyPath) const {
+    uint64_t headerHash = 0;
+    if (!hashFile(fileName, headerHash)) {
+        return false;
+    }
+    // The tool version is left out on purpose: the AST only depends on the compiler
+    std::string material = clang::getClangFullRepositoryVersion();
+    material += '\0';
+    material += std::to_string(AST_CACHE_FORMAT_VERSION);
+    material += '\0';
+    material += skipForeignBodies ? '1' : '0';
+    material += '\0';
+    for (const auto& arg : commandLine) {
+        material += arg;
+        material += '\0';
+    }
+    material += llvm::utohexstr(headerHash);
+
+    llvm::SmallString<256> path(astDir);
+    llvm::sys::path::append(path, llvm::utohexstr(llvm::xxHash64(material)));
+    astPath = (path + ".ast").str();
+    dependencyPath = (path + ".deps").str();
+    return true;
+}
+
+std::unique_ptr<clang::ASTUnit> armor::AstCache::load(const std::string& fileName,
+                                                      const std::vector<std::string>& commandLine,
+                                                      std::vector<std::string>* dependencies) const {
+    std::string astPath;
+    std::string dependencyPath;
+    if (!canStore(commandLine) || !entryPaths(fileName, commandLine, astPath, dependencyPath)) {
+        return nullptr;
+    }
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(dependencyPath);
+    if (!buffer) {
+        return nullptr;
+    }
+
+    std::vector<std::string> files;
+    try {
+        json entry = json::from_cbor((*buffer)->getBuffer().begin(), (*buffer)->getBuffer().end());
+        if (entry.at("commandLine").get<std::vector<std::string>>() != commandLine) {
+            return nullptr;
+        }
+        // The reader trusts the file it is given, so a truncated or corrupted AST is caught here
+        uint64_t astHash = 0;
+        if (!hashFile(astPath, astHash) || astHash != entry.at("ast").get<uint64_t>()) {
+            ARMOR_DEBUG_LOG << "Removing corrupt AST cache entry " << astPath << "\n";
+            llvm::sys::fs::remove(dependencyPath);
+            llvm::sys::fs::remove(astPath);
+            return nullptr;
+        }
+        for (const json& dependency : entry.at("dependencies")) {
+            std::string file = dependency.at(0).get<std::string>();
+            uint64_t hash = 0;
+            if (!hashFile(file, hash) || hash != dependency.at(1).get<uint64_t>()) {
+                ARMOR_DEBUG_LOG << "Stored AST of " << fileName << " is stale: " << file << " changed\n";
+                return nullptr;
+            }
+            files.push_back(std::move(file));
+        }
+    }
+    catch (const std::exception& e) {
+        ARMOR_DEBUG_LOG << "Ignoring unreadable AST cache entry " << dependencyPath << " : " << e.what() << "\n";
+        return nullptr;
+    }
+
+    // The unit's reader keeps a reference to the container reader
+    static const clang::RawPCHContainerReader containerReader;
+    // Contents were checked above; the AST was written without timestamps, so
+    // the reader only compares sizes and a fresh checkout does not invalidate it
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diagnostics = clang::CompilerInstance::createDiagnostics(
+        new clang::DiagnosticOptions(), new clang::IgnoringDiagConsumer(), /*ShouldOwnClient=*/true);
+    std::unique_ptr<clang::ASTUnit> unit = clang::ASTUnit::LoadFromASTFile(
+        astPath, containerReader, clang::ASTUnit::LoadEverything, diagnostics,
+        clang::FileSystemOptions());
+    if (!unit || diagnostics->hasErrorOccurred()) {
+        ARMOR_DEBUG_LOG << "Cannot load the stored AST of " << fileName << " from " << astPath << "\n";
+        return nullptr;
+    }
+    armor::touchCacheFile(dependencyPath);
+    armor::touchCacheFile(astPath);
+    armor::info() << "Loaded the AST of " << fileName << " from " << astPath << "\n";
+    if (dependencies) {
+        *dependencies = std::move(files);
+    }
+    return unit;
+}
+
+void armor::AstCache::store(const std::string& fileName,
+                            const std::vector<std::string>& commandLine,
+                            const std::vector<std::string>& dependencies,
+                            llvm::StringRef ast) const {
+    std::string astPath;
+    std::string dependencyPath;
+    if (ast.empty() || !canStore(commandLine) || !entryPaths(fileName, commandLine, astPath, dependencyPath)) {
+        return;
+    }
+    json dependencyHashes = json::array();
+    for (const auto& dependency : dependencies) {
+        uint64_t hash = 0;
+        if (!hashFile(dependency, hash)) {
+            ARMOR_DEBUG_LOG << "Not storing the AST of " << fileName << " : cannot read " << dependency << "\n";
+            return;
+        }
+        dependencyHashes.push_back({dependency, hash});
+    }
+    if (std::error_code ec = llvm::sys::fs::create_directories(astDir)) {
+        ARMOR_DEBUG_LOG << "Cannot create AST cache directory " << astDir << " : " << ec.message() << "\n";
+        return;
+    }
+
+    std::vector<std::uint8_t> cbor = json::to_cbor(json{
+        {"commandLine", commandLine},
+        {"dependencies", std::move(dependencyHashes)},
+        {"ast", llvm::xxHash64(ast)}});
+    // The dependency list publishes the entry, so it goes last
+    if (writeAtomically(astPath, ast, fileName)) {
+        writeAtomically(dependencyPath,
+                        llvm::StringRef(reinterpret_cast<const char*>(cbor.data()), cbor.size()), fileName);
+    }
+}
@@ -0,0 +1,600 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <nlohmann/json.hpp>
+
+#include "api_filter.hpp"
+#include "categorization.hpp"
+#include "chain.hpp"
+#include "comm_def.hpp"
+#include "compile_flags.hpp"
+#include "header_compilation_database.hpp"
+#include "logger.hpp"
+#include "output_paths.hpp"
+#include "report_format.hpp"
+#include "report_utils.hpp"
+#include "single_pass.hpp"
+#include "source_buffers.hpp"
+#include "subcommand.hpp"
+#include "unified_patch.hpp"
+#include "work_pool.hpp"
+
+namespace {
+
+    /**
+     * One version of the chain, parsed once. Its headers are split over
+     * sessions parsed side by side; a header's contexts live in the session
+     * at its index in `headerSession`.
+     */
+    struct ChainVersion {
+        std::string root;
+        std::vector<std::unique_ptr<armor::SinglePassSession>> sessions;
+        // Per header: whether the version has it, the session holding it and its status
+        std::vector<bool> present;
+        std::vector<std::size_t> headerSession;
+        std::vector<PARSING_STATUS> statuses;
+
+        std::string file(const std::string& header) const { return root + "/" + header; }
+    };
+
+    struct ChainOptions {
+        std::vector<std::string> includePaths;
+        std::vector<std::string> macros;
+        LANG_OPTIONS lang = LANG_OPTIONS::CPP;
+        PARSE_MODE parseMode = FULL_MODE;
+        bool skipForeignBodies = false;
+        const armor::ApiFilter* apiFilter = nullptr;
+        std::string reportFormat;
+        bool verdictOnly = false;
+        unsigned workerCount = 1;
+    };
+
+    /**
+     * Parses `headers` of the version at `root`. With `buffers`, every session
+     * reads them over the files on disk, and a header is present if buffered
+     * or on disk and not among `removed`.
+     */
+    std::unique_ptr<ChainVersion> parseVersion(const std::string& root, const std::vector<std::string>& headers,
+                                               const ChainOptions& opts, const armor::SourceBuffers* buffers = nullptr,
+                                               const std::set<std::string>* removed = nullptr) {
+        auto version = std::make_unique<ChainVersion>();
+        version->root = root;
+        version->present.assign(headers.size(), false);
+        version->headerSession.assign(headers.size(), 0);
+        version->statuses.assign(headers.size(), FATAL_ERRORS);
+
+        std::vector<std::size_t> parsed;
+        armor::HeaderCompilationDatabase compDB;
+        for (std::size_t h = 0; h < headers.size(); ++h) {
+            std::string file = version->file(headers[h]);
+            bool exists = (buffers && buffers->find(file)) || std::filesystem::is_regular_file(file);
+            if (!exists || (removed && removed->count(headers[h]))) {
+                continue;
+            }
+            version->present[h] = true;
+            parsed.push_back(h);
+            compDB.addHeader(file, root, armor::buildCompileFlags(root, file, opts.includePaths, opts.macros, opts.lang));
+        }
+        if (parsed.empty()) {
+            return version;
+        }
+
+        std::size_t groupCount = std::max<std::size_t>(1, std::min<std::size_t>(opts.workerCount, parsed.size()));
+        std::vector<std::vector<std::string>> groupFiles(groupCount);
+        std::vector<std::vector<std::size_t>> groupHeaders(groupCount);
+        for (std::size_t p = 0; p < parsed.size(); ++p) {
+            version->headerSession[parsed[p]] = p % groupCount;
+            groupFiles[p % groupCount].push_back(version->file(headers[parsed[p]]));
+            groupHeaders[p % groupCount].push_back(parsed[p]);
+        }
+        for (std::size_t g = 0; g < groupCount; ++g) {
+            version->sessions.push_back(std::make_unique<armor::SinglePassSession>(
+                nullptr, opts.parseMode, opts.skipForeignBodies, opts.apiFilter));
+            version->sessions.back()->setSourceBuffers(buffers);
+        }
+        armor::parallelFor(groupCount, opts.workerCount, [&](std::size_t g) {
+            std::vector<PARSING_STATUS> statuses = version->sessions[g]->processFiles(groupFiles[g], compDB);
+            for (std::size_t slot = 0; slot < statuses.size(); ++slot) {
+                version->statuses[groupHeaders[g][slot]] = statuses[slot];
+            }
+        });
+        return version;
+    }
+
+    /**
+     * Compares every header of `older` with `newer` into `outputs`.
+     * @return The overall status of every header, in the order of `headers`.
+     */
+    std::vector<std::string> compareVersions(const ChainVersion& older, const ChainVersion& newer,
+                                             const std::vector<std::string>& headers, const ChainOptions& opts,
+                                             const armor::OutputPaths& outputs) {
+        std::vector<std::string> verdicts(headers.size());
+        unsigned diffJobs = std::max<unsigned>(1, opts.workerCount / std::max<std::size_t>(1, headers.size()));
+        armor::parallelFor(headers.size(), opts.workerCount, [&](std::size_t h) {
+            if (!older.present[h] || !newer.present[h]) {
+                // A header neither version has gets no status
+                if (older.present[h] || newer.present[h]) {
+                    verdicts[h] = serialize(older.present[h] ? OverAllStatus::BACKWARD_INCOMPATIBLE
+                                                             : OverAllStatus::BACKWARD_COMPATIABLE);
+                }
+                return;
+            }
+            const armor::SinglePassSession& olderSession = *older.sessions[older.headerSession[h]];
+            const armor::SinglePassSession& newerSession = *newer.sessions[newer.headerSession[h]];
+            std::string file1 = older.file(headers[h]);
+            std::string file2 = newer.file(headers[h]);
+            try {
+                armor::reportHeaderPairSinglePass(olderSession, newerSession, older.root, file1, file2,
+                                                  older.statuses[h], newer.statuses[h], opts.reportFormat,
+                                                  opts.verdictOnly, diffJobs, outputs);
+            } catch (const std::exception& e) {
+                armor::user_error() << "Failed to report " << file1 << " : " << e.what() << "\n";
+                return;
+            }
+            ReportSummaries::Summary summary;
+            if (ReportSummaries::getInstance().take(headers[h], summary)) {
+                verdicts[h] = summary.overallStatus;
+            }
+        });
+        return verdicts;
+    }
+
+
+    // Options common to the subcommands, as the command line gives them
+    struct ChainArguments {
+        std::string macroFlags;
+        std::string language = LANG_CPP;
+        std::string mode = MODE_FULL;
+        std::string apiFilterFile;
+        std::string outputDir;
+        std::string logFile;
+        unsigned jobs = 1;
+        ChainOptions opts;
+        std::unique_ptr<armor::ApiFilter> apiFilter;
+    };
+
+    void addCommonOptions(CLI::App& app, ChainArguments& args) {
+        args.opts.reportFormat = "html";
+        app.add_option("-I,--include-paths", args.opts.includePaths, "Include paths for header dependencies");
+        app.add_option("-m,--macro-flags", args.macroFlags, "Macro flags to be passed for headers");
+        app.add_option("--lang,-l", args.language, "Language mode: cpp (default) or c")
+            ->transform(CLI::IsMember({LANG_C, LANG_CPP}, CLI::ignore_case));
+        app.add_option("--mode", args.mode, "Parse mode: full (default) or api-only")
+            ->check(CLI::IsMember({MODE_FULL, MODE_API_ONLY}));
+        app.add_flag("--skip-foreign-bodies", args.opts.skipForeignBodies,
+            "Do not parse function bodies outside the compared headers");
+        app.add_option("--report-format,-r", args.opts.reportFormat, "Report format of every comparison: html (default)")
+            ->check(CLI::IsMember({"html", "json", "cbor", "msgpack"}));
+        app.add_flag("--verdict-only", args.opts.verdictOnly,
+            "Only decide the overall status of every header, writing no per-header reports");
+        app.add_option("--api-filter", args.apiFilterFile, "Only compare the declarations the filter file selects")
+            ->check(CLI::ExistingFile);
+        app.add_option("-j,--jobs", args.jobs, "Headers parsed and compared in parallel (default 1, 0 for all cores)")
+            ->check(CLI::NonNegativeNumber);
+        app.add_option("--output-dir", args.outputDir,
+            "Directory receiving the reports of every comparison (default: the working directory)");
+        app.add_option("--log-file", args.logFile,
+            "Diagnostics log of the run (default: debug_output/logs/diagnostics.log under --output-dir)");
+    }
+
+    // Completes args.opts from the parsed command line and opens the log
+    bool resolveOptions(ChainArguments& args, const armor::OutputPaths& outputs) {
+        if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+            armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+        }
+        std::istringstream iss(args.macroFlags);
+        std::string flag;
+        while (iss >> flag) {
+            args.opts.macros.push_back(flag);
+        }
+        args.opts.lang = args.language == LANG_C ? LANG_OPTIONS::C : LANG_OPTIONS::CPP;
+        args.opts.parseMode = args.mode == MODE_API_ONLY ? API_ONLY_MODE : FULL_MODE;
+        args.opts.workerCount = armor::resolveJobCount(args.jobs);
+        if (!args.apiFilterFile.empty()) {
+            try {
+                args.apiFilter = std::make_unique<armor::ApiFilter>(armor::ApiFilter::load(args.apiFilterFile));
+            } catch (const std::exception& e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+            args.opts.apiFilter = args.apiFilter.get();
+        }
+        ReportSummaries::getInstance().clear();
+        return true;
+    }
+
+    // Header path as the reports name it, relative to the project root
+    std::string reportedHeader(const std::string& header) {
+        return std::filesystem::path(header).lexically_normal().string();
+    }
+
+    nlohmann::json statusesToJson(const std::vector<std::string>& headers, const std::vector<std::string>& verdicts) {
+        nlohmann::json statuses = nlohmann::json::object();
+        for (std::size_t h = 0; h < headers.size(); ++h) {
+            statuses[headers[h]] = verdicts[h].empty() ? nlohmann::json() : nlohmann::json(verdicts[h]);
+        }
+        return statuses;
+    }
+
+    bool writeSummary(const std::string& file, const nlohmann::json& report) {
+        std::filesystem::create_directories(std::filesystem::path(file).parent_path());
+        std::ofstream out(file);
+        if (!out) {
+            armor::user_error() << "Failed to write " << file << "\n";
+            return false;
+        }
+        armor::writeReportDocument(out, report, armor::ReportFormat::JSON);
+        return true;
+    }
+
+    const std::string INCOMPATIBLE = serialize(OverAllStatus::BACKWARD_INCOMPATIBLE);
+
+    /**
+     * Folds `verdict` into `combined`, the worst status so far: incompatible,
+     * else failed to parse, else compatible, keeping a status every verdict
+     * agrees on. An empty verdict, a header with no status, changes nothing.
+     */
+    void combineVerdict(std::string& combined, const std::string& verdict) {
+        auto severity = [](const std::string& status) {
+            return status == INCOMPATIBLE ? 2 : status == serialize(OverAllStatus::FATAL_ERRORS) ? 1 : 0;
+        };
+        if (verdict.empty() || verdict == combined) {
+            return;
+        }
+        if (combined.empty() || severity(verdict) > severity(combined)) {
+            combined = verdict;
+        }
+        else if (severity(verdict) == 0 && severity(combined) == 0) {
+            combined = serialize(OverAllStatus::BACKWARD_COMPATIABLE);
+        }
+    }
+
+
+    // The base of `armor whatif` with one patch applied in memory
+    struct WhatIfCandidate {
+        std::string patchFile;
+        std::unique_ptr<armor::SourceBuffers> buffers;
+        // Paths relative to the base root: those the patch deletes, and every one it touches
+        std::set<std::string> removed;
+        std::vector<std::string> paths;
+    };
+
+    std::string readWholeFile(const std::string& file) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(file);
+        if (!buffer) {
+            throw std::runtime_error("Failed to read " + file + " : " + buffer.getError().message());
+        }
+        return (*buffer)->getBuffer().str();
+    }
+
+    /**
+     * Applies `patchFile`, a unified diff with paths as `patch -p1` takes
+     * them, to the files of `root`, buffering the results.
+     * @throws std::exception if the patch does not parse or apply.
+     */
+    WhatIfCandidate loadCandidate(const std::string& root, const std::string& patchFile) {
+        WhatIfCandidate candidate;
+        candidate.patchFile = patchFile;
+        candidate.buffers = std::make_unique<armor::SourceBuffers>(root);
+        for (const armor::FilePatch& patch : armor::parseUnifiedDiff(readWholeFile(patchFile))) {
+            std::string path = reportedHeader(patch.path());
+            candidate.paths.push_back(path);
+            if (patch.deletesFile()) {
+                candidate.removed.insert(path);
+                continue;
+            }
+            // A file patched before, or renamed here, is patched from what the candidate holds
+            std::string original;
+            std::string source = patch.createsFile() ? path : reportedHeader(patch.oldPath);
+            if (const std::string* buffered = candidate.buffers->find(source)) {
+                original = *buffered;
+            }
+            else if (!patch.createsFile()) {
+                original = readWholeFile(root + "/" + source);
+            }
+            candidate.buffers->add(path, armor::applyFilePatch(original, patch));
+            candidate.removed.erase(path);
+            if (source != path) {
+                candidate.removed.insert(source);
+            }
+        }
+        return candidate;
+    }
+
+}
+
+bool armor::isChainInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "chain";
+}
+
+bool armor::runArmorChain(int argc, const char** argv) {
+    CLI::App app{"ARMOR chain"};
+    std::vector<std::string> arguments;
+    ChainArguments args;
+    app.add_option("arguments", arguments,
+        "Project roots of the versions, oldest first, then the headers relative to them")
+        ->required();
+    addCommonOptions(app, args);
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    std::vector<std::string> roots;
+    std::vector<std::string> headers;
+    for (const std::string& argument : arguments) {
+        if (headers.empty() && std::filesystem::is_directory(argument)) {
+            roots.push_back(argument);
+        }
+        else {
+            headers.push_back(reportedHeader(argument));
+        }
+    }
+    if (roots.size() < 2 || headers.empty()) {
+        armor::user_error() << "armor chain needs at least two project roots followed by headers\n";
+        return false;
+    }
+
+    armor::OutputPaths outputs{args.outputDir, args.logFile};
+    if (!resolveOptions(args, outputs)) {
+        return false;
+    }
+    const ChainOptions& opts = args.opts;
+
+    nlohmann::json report{{"versions", roots}, {"headers", headers}, {"comparisons", nlohmann::json::array()}};
+    bool backwardIncompatible = false;
+    auto compare = [&](const ChainVersion& older, const ChainVersion& newer, std::size_t from, std::size_t to) {
+        std::string name = "v" + std::to_string(from + 1) + "_v" + std::to_string(to + 1);
+        std::vector<std::string> verdicts =
+            compareVersions(older, newer, headers, opts, armor::OutputPaths{outputs.chainStepRoot(name), outputs.logFile()});
+        backwardIncompatible |= std::count(verdicts.begin(), verdicts.end(), INCOMPATIBLE) > 0;
+        report["comparisons"].push_back({{"name", name},
+                                         {"older", roots[from]},
+                                         {"newer", roots[to]},
+                                         {"output_root", outputs.chainStepRoot(name)},
+                                         {"statuses", statusesToJson(headers, verdicts)}});
+    };
+
+    // The first version stays for the cumulative comparison; of the others only
+    // the two a step compares are resident
+    std::unique_ptr<ChainVersion> first;
+    std::unique_ptr<ChainVersion> previous;
+    try {
+        for (std::size_t k = 0; k < roots.size(); ++k) {
+            armor::user_print() << "Parsing version " << k + 1 << " : " << roots[k] << "\n";
+            std::unique_ptr<ChainVersion> current = parseVersion(roots[k], headers, opts);
+            if (k == 0) {
+                first = std::move(current);
+                continue;
+            }
+            compare(previous ? *previous : *first, *current, k - 1, k);
+            previous = std::move(current);
+        }
+        if (roots.size() > 2) {
+            compare(*first, *previous, 0, roots.size() - 1);
+        }
+    } catch (const std::exception& e) {
+        armor::user_error() << "Failed to compare the chain : " << e.what() << "\n";
+        return false;
+    }
+
+    if (!writeSummary(outputs.chainJsonFile(), report)) {
+        return false;
+    }
+    armor::user_print() << "Chain report of " << roots.size() << " versions : " << outputs.chainJsonFile() << "\n";
+    return !backwardIncompatible;
+}
+
+bool armor::isMultiBaseInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "multibase";
+}
+
+bool armor::runArmorMultiBase(int argc, const char** argv) {
+    CLI::App app{"ARMOR multibase"};
+    std::vector<std::string> bases;
+    std::string headRoot;
+    std::vector<std::string> headers;
+    ChainArguments args;
+    app.add_option("--base", bases, "Project root of a maintained release the head must stay compatible with")
+        ->required()
+        ->allow_extra_args(false)
+        ->check(CLI::ExistingDirectory);
+    app.add_option("headroot", headRoot, "Project root of the head version")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    app.add_option("headers", headers, "Headers relative to the project roots")->required();
+    addCommonOptions(app, args);
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    for (std::string& header : headers) {
+        header = reportedHeader(header);
+    }
+    armor::OutputPaths outputs{args.outputDir, args.logFile};
+    if (!resolveOptions(args, outputs)) {
+        return false;
+    }
+    const ChainOptions& opts = args.opts;
+
+    // The head is parsed once and only read by the comparisons; each base is
+    // freed once compared, so the head and one base are resident at a time
+    std::vector<std::vector<std::string>> verdicts;
+    nlohmann::json comparisons = nlohmann::json::array();
+    try {
+        armor::user_print() << "Parsing head : " << headRoot << "\n";
+        std::unique_ptr<ChainVersion> head = parseVersion(headRoot, headers, opts);
+        for (std::size_t b = 0; b < bases.size(); ++b) {
+            armor::user_print() << "Parsing base " << b + 1 << " : " << bases[b] << "\n";
+            std::unique_ptr<ChainVersion> base = parseVersion(bases[b], headers, opts);
+            std::string name = "base" + std::to_string(b + 1);
+            verdicts.push_back(compareVersions(*base, *head, headers, opts,
+                                               armor::OutputPaths{outputs.multiBaseRoot(name), outputs.logFile()}));
+            comparisons.push_back({{"name", name},
+                                   {"base", bases[b]},
+                                   {"output_root", outputs.multiBaseRoot(name)},
+                                   {"statuses", statusesToJson(headers, verdicts.back())}});
+        }
+    } catch (const std::exception& e) {
+        armor::user_error() << "Failed to compare against the bases : " << e.what() << "\n";
+        return false;
+    }
+
+    // A header is as compatible as its worst comparison
+    std::vector<std::string> combined(headers.size());
+    bool backwardIncompatible = false;
+    for (std::size_t h = 0; h < headers.size(); ++h) {
+        for (const std::vector<std::string>& baseVerdicts : verdicts) {
+            combineVerdict(combined[h], baseVerdicts[h]);
+        }
+        backwardIncompatible |= combined[h] == INCOMPATIBLE;
+    }
+
+    nlohmann::json report{{"head", headRoot},
+                          {"bases", bases},
+                          {"headers", headers},
+                          {"comparisons", std::move(comparisons)},
+                          {"statuses", statusesToJson(headers, combined)}};
+    if (!writeSummary(outputs.multiBaseJsonFile(), report)) {
+        return false;
+    }
+    armor::user_print() << "Report against " << bases.size() << " bases : " << outputs.multiBaseJsonFile() << "\n";
+    return !backwardIncompatible;
+}
+
+bool armor::isWhatIfInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "whatif";
+}
+
+bool armor::runArmorWhatIf(int argc, const char** argv) {
+    CLI::App app{"ARMOR whatif"};
+    std::string baseRoot;
+    std::vector<std::string> patches;
+    std::vector<std::string> headers;
+    ChainArguments args;
+    app.add_option("--base", baseRoot, "Project root the patches apply to")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    app.add_option("--patch", patches, "Unified diff of a candidate change to the base, with paths as patch -p1 takes them")
+        ->required()
+        ->allow_extra_args(false)
+        ->check(CLI::ExistingFile);
+    app.add_option("headers", headers,
+        "Headers relative to the base root (default: the .h and .hpp files the patches touch)");
+    addCommonOptions(app, args);
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::OutputPaths outputs{args.outputDir, args.logFile};
+    if (!resolveOptions(args, outputs)) {
+        return false;
+    }
+    const ChainOptions& opts = args.opts;
+
+    std::vector<WhatIfCandidate> candidates;
+    for (const std::string& patch : patches) {
+        try {
+            candidates.push_back(loadCandidate(baseRoot, patch));
+        } catch (const std::exception& e) {
+            armor::user_error() << "Failed to apply " << patch << " to " << baseRoot << " : " << e.what() << "\n";
+            return false;
+        }
+    }
+    if (headers.empty()) {
+        std::set<std::string> touched;
+        for (const WhatIfCandidate& candidate : candidates) {
+            for (const std::string& path : candidate.paths) {
+                std::string extension = std::filesystem::path(path).extension().string();
+                if (extension == ".h" || extension == ".hpp") {
+                    touched.insert(path);
+                }
+            }
+        }
+        headers.assign(touched.begin(), touched.end());
+    }
+    for (std::string& header : headers) {
+        header = reportedHeader(header);
+    }
+    if (headers.empty()) {
+        armor::user_error() << "armor whatif found no headers among the patched files; name the headers to compare\n";
+        return false;
+    }
+
+    std::unique_ptr<ChainVersion> base;
+    try {
+        armor::user_print() << "Parsing base : " << baseRoot << "\n";
+        base = parseVersion(baseRoot, headers, opts);
+    } catch (const std::exception& e) {
+        armor::user_error() << "Failed to parse the base : " << e.what() << "\n";
+        return false;
+    }
+
+    // Candidates are parsed side by side against the base, which is only read.
+    // Their diffs take turns, as the summaries they record are keyed by header,
+    // and each candidate is freed once compared.
+    std::vector<std::vector<std::string>> verdicts(candidates.size());
+    std::vector<std::string> errors(candidates.size());
+    ChainOptions candidateOpts = opts;
+    candidateOpts.workerCount = std::max<unsigned>(1, opts.workerCount / candidates.size());
+    std::mutex compareMutex;
+    armor::parallelFor(candidates.size(), opts.workerCount, [&](std::size_t c) {
+        std::string name = "patch" + std::to_string(c + 1);
+        try {
+            std::unique_ptr<ChainVersion> candidate =
+                parseVersion(baseRoot, headers, candidateOpts, candidates[c].buffers.get(), &candidates[c].removed);
+            std::scoped_lock<std::mutex> lock(compareMutex);
+            verdicts[c] = compareVersions(*base, *candidate, headers, candidateOpts,
+                                          armor::OutputPaths{outputs.whatIfRoot(name), outputs.logFile()});
+        } catch (const std::exception& e) {
+            errors[c] = e.what();
+        }
+        candidates[c].buffers.reset();
+    });
+
+    nlohmann::json report{{"base", baseRoot}, {"headers", headers}, {"candidates", nlohmann::json::array()}};
+    for (std::size_t c = 0; c < candidates.size(); ++c) {
+        std::string name = "patch" + std::to_string(c + 1);
+        std::string status;
+        for (const std::string& verdict : verdicts[c]) {
+            combineVerdict(status, verdict);
+        }
+        nlohmann::json entry{{"name", name},
+                             {"patch", candidates[c].patchFile},
+                             {"output_root", outputs.whatIfRoot(name)},
+                             {"statuses", errors[c].empty() ? statusesToJson(headers, verdicts[c]) : nlohmann::json()},
+                             {"status", status.empty() ? nlohmann::json() : nlohmann::json(status)}};
+        if (!errors[c].empty()) {
+            entry["error"] = errors[c];
+            armor::user_error() << "Failed to compare " << candidates[c].patchFile << " : " << errors[c] << "\n";
+        }
+        else {
+            armor::user_print() << name << " (" << candidates[c].patchFile << ") : "
+                                << (status.empty() ? "no status" : status) << "\n";
+        }
+        report["candidates"].push_back(std::move(entry));
+    }
+
+    if (!writeSummary(outputs.whatIfJsonFile(), report)) {
+        return false;
+    }
+    armor::user_print() << "Report of " << candidates.size() << " candidates : " << outputs.whatIfJsonFile() << "\n";
+    return true;
+}
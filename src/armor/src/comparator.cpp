@@ -0,0 +1,113 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "categorization.hpp"
+#include "comparator.hpp"
+#include "file_cache.hpp"
+#include "file_compare.hpp"
+#include "output_paths.hpp"
+#include "single_pass.hpp"
+#include "source_buffers.hpp"
+
+namespace {
+
+    // Where an empty --log-file sends the log
+    constexpr const char* NO_LOG_FILE = "/dev/null";
+
+    // Whether the file at `file` holds exactly `contents`
+    bool fileHolds(const std::string& file, const std::string& contents) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(file);
+        return buffer && (*buffer)->getBuffer() == contents;
+    }
+
+}
+
+armor::Comparator::Comparator(CompareOptions options) : options(std::move(options)) {
+    // The summaries are what compare() returns
+    ReportSummaries::getInstance().keepRecords(true);
+}
+
+armor::CompareResult armor::Comparator::compare(const HeaderPair& pair) const {
+    CompareResult result;
+    result.header = pair.header;
+    std::string file1 = pair.projectRoot1 + "/" + pair.header;
+    std::string file2 = pair.projectRoot2 + "/" + pair.header;
+
+    SourceBuffers buffers(pair.projectRoot2);
+    try {
+        for (const auto& [path, contents] : pair.buffers2) {
+            buffers.add(path, contents);
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+        return result;
+    }
+    const std::string* buffered2 = buffers.find(file2);
+
+    bool file1Exists = std::filesystem::exists(file1);
+    bool file2Exists = buffered2 || std::filesystem::exists(file2);
+    if (!file1Exists || !file2Exists) {
+        if (!file1Exists && !file2Exists) {
+            result.error = "Missing old and new versions of header " + pair.header;
+            return result;
+        }
+        // As the reports of a missing header say
+        result.outcome = file1Exists ? CompareOutcome::MISSING_IN_NEWER : CompareOutcome::MISSING_IN_OLDER;
+        result.backwardIncompatible = file1Exists;
+        result.overallStatus = file1Exists ? "BACKWARD_INCOMPATIBLE" : "BACKWARD_COMPATIBLE";
+        result.parsedStatus = ParsedDiffStatus::SUPPORTED_UPDATES;
+        return result;
+    }
+    if (buffered2 ? fileHolds(file1, *buffered2) : !filesDiffer(file1, file2)) {
+        result.outcome = CompareOutcome::IDENTICAL;
+        result.overallStatus = getOverAllCategory(static_cast<unsigned>(result.parsedStatus),
+                                                  static_cast<unsigned>(result.unparsedStatus), true);
+        return result;
+    }
+
+    OutputPaths outputs{options.outputDir, options.logFile.empty() ? NO_LOG_FILE : options.logFile};
+    outputs.writeReports = !options.outputDir.empty();
+    try {
+        processHeaderPairSinglePass(pair.projectRoot1, file1, pair.projectRoot2, file2, options.reportFormat,
+                                    options.includePaths, options.macroFlags, options.lang, false,
+                                    options.verdictOnly, options.cacheDir, nullptr, nullptr, nullptr,
+                                    options.apiFilter.get(), options.parseMode, options.skipForeignBodies, 1,
+                                    outputs, buffers.empty() ? nullptr : &buffers);
+    } catch (const std::exception& e) {
+        result.error = e.what();
+        return result;
+    }
+
+    result.outcome = CompareOutcome::COMPARED;
+    // Reports name the header by its path from the project root
+    std::string reported = std::filesystem::relative(file1, pair.projectRoot1).string();
+    ReportSummaries::Summary summary;
+    if (!ReportSummaries::getInstance().take(reported, summary)) {
+        return result;
+    }
+    result.overallStatus = std::move(summary.overallStatus);
+    result.backwardIncompatible = result.overallStatus == serialize(OverAllStatus::BACKWARD_INCOMPATIBLE);
+    if (!options.verdictOnly) {
+        result.parsedStatus = static_cast<ParsedDiffStatus>(summary.parsedStatus);
+        result.unparsedStatus = static_cast<UnParsedDiffStatus>(summary.unparsedStatus);
+        result.parser = summary.parser;
+        result.changes = std::move(summary.records);
+        // Of every change, where the overall status of a --baseline report only judges the new ones
+        result.backwardIncompatible = result.backwardIncompatible ||
+            std::any_of(result.changes.begin(), result.changes.end(),
+                        [](const ChangeRecord& record) { return record.backwardIncompatible; });
+    }
+    return result;
+}
+
+void armor::Comparator::refresh() {
+    SharedFileCache::getInstance().revalidate();
+}
@@ -0,0 +1,569 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+#include "cache_directory.hpp"
+#include "conditional_block_index.hpp"
+#include "context_cache.hpp"
+#include "flat_context.hpp"
+#include "remote_cache.hpp"
+#include "alpha/include/node.hpp"
+#include "alpha/include/node_index.hpp"
+#include "beta/include/decl_subtree_cache.hpp"
+#include "beta/include/diffengine.hpp"
+#include "beta/include/node.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+
+#ifndef TOOL_VERSION
+#define TOOL_VERSION ""
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+    // Bump whenever the serialized layout or the normalizers' output changes
+    constexpr uint32_t CACHE_FORMAT_VERSION = 9;
+
+    constexpr char ENTRY_MAGIC[4] = {'A', 'R', 'C', 'E'};
+
+    /**
+     * An entry file is this header, the CBOR metadata (format, command line,
+     * dependencies and the alpha context), padding to 8 bytes and the flat
+     * beta image (see writeFlatBetaContext), which is read in place. The
+     * checksum covers everything after the header.
+     */
+    struct EntryHeader {
+        char magic[4];
+        uint32_t format;
+        uint64_t metadataSize;
+        uint64_t checksum;
+    };
+
+    constexpr size_t IMAGE_ALIGNMENT = 8;
+
+    size_t imageOffset(uint64_t metadataSize) {
+        return (sizeof(EntryHeader) + metadataSize + IMAGE_ALIGNMENT - 1) & ~(IMAGE_ALIGNMENT - 1);
+    }
+
+    // An entry file as read, with its metadata decoded
+    struct CachedEntry {
+        json metadata;
+        std::shared_ptr<const llvm::MemoryBuffer> buffer;
+        llvm::StringRef betaImage;
+    };
+
+    // Throws on a truncated, corrupted or foreign file
+    std::shared_ptr<const CachedEntry> decodeEntry(std::unique_ptr<llvm::MemoryBuffer> buffer) {
+        llvm::StringRef bytes = buffer->getBuffer();
+        EntryHeader header{};
+        if (bytes.size() < sizeof(EntryHeader)) {
+            throw std::runtime_error("truncated entry");
+        }
+        std::memcpy(&header, bytes.data(), sizeof(EntryHeader));
+        if (std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 || header.format != CACHE_FORMAT_VERSION) {
+            throw std::runtime_error("not a cache entry of this format");
+        }
+        if (header.metadataSize > bytes.size() || imageOffset(header.metadataSize) > bytes.size()) {
+            throw std::runtime_error("truncated entry");
+        }
+        if (llvm::xxHash64(bytes.drop_front(sizeof(EntryHeader))) != header.checksum) {
+            throw std::runtime_error("checksum mismatch");
+        }
+        auto entry = std::make_shared<CachedEntry>();
+        llvm::StringRef metadata = bytes.substr(sizeof(EntryHeader), header.metadataSize);
+        entry->metadata = json::from_cbor(metadata.begin(), metadata.end());
+        entry->betaImage = bytes.substr(imageOffset(header.metadataSize));
+        entry->buffer = std::move(buffer);
+        return entry;
+    }
+
+    std::string encodeEntry(const json& metadata, llvm::StringRef betaImage) {
+        std::vector<std::uint8_t> cbor = json::to_cbor(metadata);
+        EntryHeader header{};
+        std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+        header.format = CACHE_FORMAT_VERSION;
+        header.metadataSize = cbor.size();
+
+        std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+        bytes.append(reinterpret_cast<const char*>(cbor.data()), cbor.size());
+        bytes.resize(imageOffset(cbor.size()), '\0');
+        bytes.append(betaImage.data(), betaImage.size());
+        uint64_t checksum = llvm::xxHash64(llvm::StringRef(bytes).drop_front(sizeof(EntryHeader)));
+        std::memcpy(&bytes[offsetof(EntryHeader, checksum)], &checksum, sizeof(checksum));
+        return bytes;
+    }
+
+    // Every edit of a header creates a new entry, so a long-running process
+    // drops the whole tier once it holds this many
+    constexpr size_t MEMORY_TIER_CAPACITY = 256;
+
+    // Decoded entries shared by all caches once keepEntriesInMemory() was called
+    struct MemoryTier {
+        std::mutex mutex;
+        bool enabled = false;
+        llvm::StringMap<std::shared_ptr<const CachedEntry>> entries;
+    };
+
+    MemoryTier& memoryTier() {
+        static MemoryTier tier;
+        return tier;
+    }
+
+    bool isMemoryTierEnabled() {
+        MemoryTier& tier = memoryTier();
+        std::scoped_lock<std::mutex> lock(tier.mutex);
+        return tier.enabled;
+    }
+
+    std::shared_ptr<const CachedEntry> findMemoryEntry(const std::string& entryPath) {
+        MemoryTier& tier = memoryTier();
+        std::scoped_lock<std::mutex> lock(tier.mutex);
+        auto it = tier.entries.find(entryPath);
+        return it == tier.entries.end() ? nullptr : it->second;
+    }
+
+    void rememberEntry(const std::string& entryPath, std::shared_ptr<const CachedEntry> entry) {
+        MemoryTier& tier = memoryTier();
+        std::scoped_lock<std::mutex> lock(tier.mutex);
+        if (!tier.enabled) {
+            return;
+        }
+        if (tier.entries.size() >= MEMORY_TIER_CAPACITY && tier.entries.find(entryPath) == tier.entries.end()) {
+            tier.entries.clear();
+        }
+        tier.entries.insert_or_assign(entryPath, std::move(entry));
+    }
+
+    bool hashFile(const std::string& path, uint64_t& hash) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+            llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if (!buffer) {
+            return false;
+        }
+        hash = llvm::xxHash64((*buffer)->getBuffer());
+        return true;
+    }
+
+    // The entry's file name, which is also its key in a remote cache
+    bool computeEntryKey(PARSE_MODE parseMode,
+                         bool skipForeignBodies,
+                         const std::string& apiFilterKey,
+                         const std::string& fileName,
+                         const std::vector<std::string>& commandLine,
+                         std::string& entryKey) {
+        uint64_t headerHash = 0;
+        if (!hashFile(fileName, headerHash)) {
+            return false;
+        }
+
+        std::string material = TOOL_VERSION;
+        material += '\0';
+        material += std::to_string(CACHE_FORMAT_VERSION);
+        material += '\0';
+        // API-only parses leave the comment and preprocessor trackers empty
+        material += std::to_string(parseMode);
+        material += '\0';
+        // A skipped body is never checked, so a broken include may parse cleanly
+        material += skipForeignBodies ? '1' : '0';
+        material += '\0';
+        // Records are only laid out while layouts are compared
+        material += isRecordLayoutEnabled() ? '1' : '0';
+        material += '\0';
+        // Filtered declarations are missing from the contexts
+        material += apiFilterKey;
+        material += '\0';
+        for (const auto& arg : commandLine) {
+            material += arg;
+            material += '\0';
+        }
+        material += llvm::utohexstr(headerHash);
+
+        entryKey = llvm::utohexstr(llvm::xxHash64(material)) + ".cbor";
+        return true;
+    }
+
+    std::string entryPathOf(const std::string& cacheDir, const std::string& entryKey) {
+        llvm::SmallString<256> path(cacheDir);
+        llvm::sys::path::append(path, entryKey);
+        return path.str().str();
+    }
+
+    // False if the entry was not published
+    bool writeEntryFile(const std::string& cacheDir, const std::string& entryPath, llvm::StringRef bytes,
+                        const std::string& fileName) {
+        if (std::error_code ec = llvm::sys::fs::create_directories(cacheDir)) {
+            ARMOR_DEBUG_LOG << "Cannot create cache directory " << cacheDir << " : " << ec.message() << "\n";
+            return false;
+        }
+        std::string error;
+        if (!armor::publishCacheFile(entryPath, bytes, error)) {
+            ARMOR_DEBUG_LOG << "Cannot publish cache entry for " << fileName << " : " << error << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Maps an entry file read-only, so the processes sharing a cache directory share its pages
+    std::shared_ptr<const CachedEntry> mapEntryFile(const std::string& entryPath) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+            llvm::MemoryBuffer::getFile(entryPath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if (!buffer) {
+            return nullptr;
+        }
+        return decodeEntry(std::move(*buffer));
+    }
+
+    // Remembers a just published entry as mapped; false if it cannot be mapped back
+    bool rememberPublishedEntry(const std::string& entryPath, const std::string& fileName) {
+        try {
+            std::shared_ptr<const CachedEntry> mapped = mapEntryFile(entryPath);
+            if (!mapped) {
+                return false;
+            }
+            rememberEntry(entryPath, std::move(mapped));
+            return true;
+        }
+        catch (const std::exception& e) {
+            ARMOR_DEBUG_LOG << "Cannot map the cache entry of " << fileName << " : " << e.what() << "\n";
+            return false;
+        }
+    }
+
+    json keySetToJson(const alpha::NodeKeySet& set) {
+        json out = json::array();
+        for (const auto& entry : set) {
+            out.push_back({static_cast<int>(entry.kind), entry.qualifiedName});
+        }
+        return out;
+    }
+
+    void keySetFromJson(const json& in, alpha::NodeKeySet& set) {
+        for (const json& entry : in) {
+            std::string qualifiedName = entry.at(1).get<std::string>();
+            set.insert(alpha::NodeKey(static_cast<NodeKind>(entry.at(0).get<int>()), qualifiedName));
+        }
+    }
+
+    // --- Per-parser node fields ---
+
+    json nodeFields(const alpha::APINode& node) {
+        return {
+            {"kind", static_cast<int>(node.kind)},
+            {"hash", node.hash},
+            {"qualifiedName", node.qualifiedName},
+            {"dataType", node.dataType},
+            {"inlined", node.isInclined},
+            {"constexpr", node.isConstExpr},
+            {"storage", static_cast<int>(node.storage)}
+        };
+    }
+
+    void readNodeFields(const json& in, alpha::APINode& node) {
+        node.kind = static_cast<NodeKind>(in.at("kind").get<int>());
+        node.hash = in.at("hash").get<uint64_t>();
+        node.qualifiedName = in.at("qualifiedName").get<std::string>();
+        node.dataType = in.at("dataType").get<std::string>();
+        node.isInclined = in.at("inlined").get<bool>();
+        node.isConstExpr = in.at("constexpr").get<bool>();
+        node.storage = static_cast<APINodeStorageClass>(in.at("storage").get<int>());
+    }
+
+    // --- Node graphs ---
+
+    /**
+     * Flattens an alpha node graph into an array; nodes reachable from several
+     * maps are written once and referenced by index so identity survives a reload.
+     */
+    class NodeWriter {
+        public:
+            json idOf(const alpha::APINode* node) {
+                if (node == nullptr) {
+                    return nullptr;
+                }
+                auto it = ids.find(node);
+                if (it != ids.end()) {
+                    return it->second;
+                }
+                size_t id = nodes.size();
+                ids.try_emplace(node, id);
+                nodes.push_back(nullptr);
+
+                json fields = nodeFields(*node);
+                // An alpha node only has a child list once a child was added
+                if (node->children != nullptr) {
+                    json children = json::array();
+                    for (const auto& child : *node->children) {
+                        children.push_back(idOf(child.get()));
+                    }
+                    fields["children"] = std::move(children);
+                }
+                nodes[id] = std::move(fields);
+                return id;
+            }
+
+            json takeNodes() { return std::move(nodes); }
+
+        private:
+            llvm::DenseMap<const alpha::APINode*, size_t> ids;
+            json nodes = json::array();
+    };
+
+    std::vector<std::shared_ptr<alpha::APINode>> readAlphaNodes(const json& in) {
+        using ChildList = llvm::SmallVector<std::shared_ptr<const alpha::APINode>,16>;
+
+        std::vector<std::shared_ptr<alpha::APINode>> nodes;
+        nodes.reserve(in.size());
+        for (size_t i = 0; i < in.size(); ++i) {
+            nodes.push_back(std::make_shared<alpha::APINode>());
+        }
+        for (size_t i = 0; i < in.size(); ++i) {
+            const json& fields = in[i];
+            alpha::APINode& node = *nodes[i];
+            readNodeFields(fields, node);
+            auto children = fields.find("children");
+            if (children != fields.end()) {
+                node.children = std::make_unique<ChildList>();
+                for (const json& id : *children) {
+                    node.children->push_back(nodes.at(id.get<size_t>()));
+                }
+            }
+        }
+        return nodes;
+    }
+
+    template <typename NodeRef>
+    NodeRef nodeAt(const std::vector<NodeRef>& nodes, const json& id) {
+        return id.is_null() ? nullptr : nodes.at(id.get<size_t>());
+    }
+
+    // --- Contexts ---
+
+    json alphaContextToJson(const alpha::ASTNormalizedContext& context) {
+        NodeWriter writer;
+        json roots = json::array();
+        for (const auto& root : context.getRootNodes()) {
+            roots.push_back(writer.idOf(root.get()));
+        }
+        json tree = json::array();
+        for (const auto& node : context.getTree()) {
+            tree.push_back(writer.idOf(node.get()));
+        }
+        json fatalDirectives = json::array();
+        for (const auto& directive : context.getSourceRangeTracker().getFatalDirectives()) {
+            fatalDirectives.push_back({directive.Header, directive.File});
+        }
+        return {
+            {"nodes", writer.takeNodes()},
+            {"roots", std::move(roots)},
+            {"tree", std::move(tree)},
+            {"excludeNodes", keySetToJson(context.excludeNodes)},
+            {"hashSet", keySetToJson(context.hashSet)},
+            {"fatalDirectives", std::move(fatalDirectives)}
+        };
+    }
+
+    void alphaContextFromJson(const json& in, alpha::ASTNormalizedContext& context) {
+        std::vector<std::shared_ptr<alpha::APINode>> nodes = readAlphaNodes(in.at("nodes"));
+        for (const json& id : in.at("roots")) {
+            context.addRootNode(nodeAt(nodes, id));
+        }
+        for (const json& id : in.at("tree")) {
+            context.addNode(nodeAt(nodes, id));
+        }
+        keySetFromJson(in.at("excludeNodes"), context.excludeNodes);
+        keySetFromJson(in.at("hashSet"), context.hashSet);
+        for (const json& directive : in.at("fatalDirectives")) {
+            context.getSourceRangeTracker().addFatalDirective(directive.at(0).get<std::string>(),
+                                                              directive.at(1).get<std::string>());
+        }
+        context.addClangASTContext(nullptr);
+    }
+
+
+}
+
+armor::ContextCache::ContextCache(std::string cacheDir, PARSE_MODE parseMode, bool skipForeignBodies,
+                                  std::shared_ptr<RemoteCache> remote, const ApiFilter* apiFilter)
+    : cacheDir(std::move(cacheDir)), parseMode(parseMode), skipForeignBodies(skipForeignBodies),
+      remote(remote ? std::make_shared<ChunkedRemoteCache>(std::move(remote), this->cacheDir) : nullptr),
+      apiFilterKey(apiFilter ? apiFilter->fingerprint() : std::string()) {}
+
+void armor::ContextCache::keepEntriesInMemory() {
+    MemoryTier& tier = memoryTier();
+    std::scoped_lock<std::mutex> lock(tier.mutex);
+    tier.enabled = true;
+    beta::DeclSubtreeCache::getInstance().setEnabled(true);
+    ConditionalBlockCache::getInstance().setEnabled(true);
+}
+
+bool armor::ContextCache::load(const std::string& fileName,
+                               const std::vector<std::string>& commandLine,
+                               alpha::ASTNormalizedContext& alphaContext,
+                               beta::ASTNormalizedContext& betaContext,
+                               std::vector<std::string>* dependencies) const {
+    std::string entryKey;
+    if (!computeEntryKey(parseMode, skipForeignBodies, apiFilterKey, fileName, commandLine, entryKey)) {
+        return false;
+    }
+    std::string entryPath = entryPathOf(cacheDir, entryKey);
+
+    // An entry that only the remote cache had, written locally once it validated
+    bool fetchedRemotely = false;
+    // The tiers looked in, in order; only the last can have served the entry, and only if it validated
+    llvm::SmallVector<armor::Metrics::CacheTier, 3> tiers;
+    bool loaded = false;
+    auto countLookups = llvm::make_scope_exit([&tiers, &loaded]() {
+        for (size_t i = 0; i < tiers.size(); ++i) {
+            armor::Metrics::getInstance().countCache(tiers[i], loaded && i + 1 == tiers.size());
+        }
+    });
+    std::shared_ptr<const CachedEntry> cached;
+    try {
+        if (isMemoryTierEnabled()) {
+            tiers.push_back(armor::Metrics::CacheTier::MEMORY);
+            cached = findMemoryEntry(entryPath);
+        }
+        if (!cached) {
+            // Mapped rather than read where the platform allows, as the beta image is used in place
+            tiers.push_back(armor::Metrics::CacheTier::DISK);
+            try {
+                cached = mapEntryFile(entryPath);
+            }
+            catch (const std::exception& e) {
+                // Removed so the next store replaces it rather than every run rereading it
+                ARMOR_DEBUG_LOG << "Removing corrupt cache entry " << entryPath << " : " << e.what() << "\n";
+                llvm::sys::fs::remove(entryPath);
+            }
+            std::string remoteBytes;
+            if (!cached) {
+                if (!remote) {
+                    return false;
+                }
+                tiers.push_back(armor::Metrics::CacheTier::REMOTE);
+                if (!remote->fetch(entryKey, remoteBytes)) {
+                    return false;
+                }
+                cached = decodeEntry(llvm::MemoryBuffer::getMemBufferCopy(remoteBytes, entryKey));
+                fetchedRemotely = true;
+            }
+            rememberEntry(entryPath, cached);
+        }
+        const json& entry = cached->metadata;
+
+        if (entry.at("commandLine").get<std::vector<std::string>>() != commandLine) {
+            return false;
+        }
+
+        std::vector<std::string> files;
+        for (const json& dependency : entry.at("dependencies")) {
+            files.push_back(dependency.at(0).get<std::string>());
+            uint64_t hash = 0;
+            if (!hashFile(dependency.at(0).get<std::string>(), hash) || hash != dependency.at(1).get<uint64_t>()) {
+                ARMOR_DEBUG_LOG << "Cache entry for " << fileName << " is stale: "
+                               << dependency.at(0).get<std::string>() << " changed\n";
+                return false;
+            }
+        }
+
+        // Decode into scratch contexts so a malformed entry never leaves the
+        // caller's contexts half filled
+        alpha::ASTNormalizedContext alphaLoaded;
+        beta::ASTNormalizedContext betaLoaded;
+        alphaContextFromJson(entry.at("alpha"), alphaLoaded);
+        // The beta nodes' strings point into the entry, which the context keeps alive
+        if (!readFlatBetaContext(cached->betaImage, cached, betaLoaded)) {
+            throw std::runtime_error("malformed beta image");
+        }
+
+        alphaContext = std::move(alphaLoaded);
+        betaContext = std::move(betaLoaded);
+        if (dependencies) {
+            *dependencies = std::move(files);
+        }
+    }
+    catch (const std::exception& e) {
+        ARMOR_DEBUG_LOG << "Ignoring unreadable cache entry " << entryPath << " : " << e.what() << "\n";
+        return false;
+    }
+
+    loaded = true;
+    // Only entries that validated here are kept, so a bad remote entry is fetched but never stored
+    if (fetchedRemotely) {
+        if (writeEntryFile(cacheDir, entryPath, cached->buffer->getBuffer(), fileName) && isMemoryTierEnabled()) {
+            rememberPublishedEntry(entryPath, fileName);
+        }
+        armor::info() << "Loaded normalized contexts of " << fileName << " from the remote cache\n";
+        return true;
+    }
+    armor::touchCacheFile(entryPath);
+    armor::info() << "Loaded normalized contexts of " << fileName << " from " << entryPath << "\n";
+    return true;
+}
+
+void armor::ContextCache::store(const std::string& fileName,
+                                const std::vector<std::string>& commandLine,
+                                const std::vector<std::string>& dependencies,
+                                const alpha::ASTNormalizedContext& alphaContext,
+                                const beta::ASTNormalizedContext& betaContext) const {
+    std::string entryKey;
+    if (!computeEntryKey(parseMode, skipForeignBodies, apiFilterKey, fileName, commandLine, entryKey)) {
+        return;
+    }
+    std::string entryPath = entryPathOf(cacheDir, entryKey);
+
+    json dependencyHashes = json::array();
+    for (const auto& dependency : dependencies) {
+        uint64_t hash = 0;
+        if (!hashFile(dependency, hash)) {
+            ARMOR_DEBUG_LOG << "Not caching " << fileName << " : cannot read dependency " << dependency << "\n";
+            return;
+        }
+        dependencyHashes.push_back({dependency, hash});
+    }
+
+    json metadata = {
+        {"commandLine", commandLine},
+        {"dependencies", std::move(dependencyHashes)},
+        {"alpha", alphaContextToJson(alphaContext)}
+    };
+    std::string betaImage = writeFlatBetaContext(betaContext);
+    std::string bytes = encodeEntry(metadata, betaImage);
+
+    bool published = writeEntryFile(cacheDir, entryPath, bytes, fileName);
+    // Kept as a mapping of the published file rather than a copy of it, so
+    // the workers of a daemon (--serve --workers) share one copy of a baseline
+    if (isMemoryTierEnabled() && !(published && rememberPublishedEntry(entryPath, fileName))) {
+        auto cached = std::make_shared<CachedEntry>();
+        cached->metadata = std::move(metadata);
+        cached->buffer = llvm::MemoryBuffer::getMemBufferCopy(bytes, entryKey);
+        cached->betaImage = cached->buffer->getBuffer().take_back(betaImage.size());
+        rememberEntry(entryPath, std::move(cached));
+    }
+
+    if (remote) {
+        remote->publish(entryKey, bytes);
+    }
+}
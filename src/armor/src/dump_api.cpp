@@ -0,0 +1,233 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "api_filter.hpp"
+#include "column_table.hpp"
+#include "comm_def.hpp"
+#include "compile_flags.hpp"
+#include "diff_utils.hpp"
+#include "dump_api.hpp"
+#include "header_compilation_database.hpp"
+#include "logger.hpp"
+#include "output_paths.hpp"
+#include "report_format.hpp"
+#include "single_pass.hpp"
+#include "subcommand.hpp"
+#include "work_pool.hpp"
+#include "beta/include/node.hpp"
+
+namespace {
+
+    const char* accessName(AccessSpec access) {
+        switch (access) {
+            case AccessSpec::Public: return "public";
+            case AccessSpec::Protected: return "protected";
+            case AccessSpec::Private: return "private";
+            case AccessSpec::None: break;
+        }
+        return "";
+    }
+
+    // The nodes under `roots` in pre-order, one row each; a row's parent precedes it
+    armor::ColumnTable apiColumns(llvm::ArrayRef<const beta::APINode*> roots) {
+        armor::ColumnTable table;
+        const std::size_t parent = table.addIntColumn("parent");
+        const std::size_t kind = table.addStringColumn("kind");
+        const std::size_t qualifiedName = table.addStringColumn("qualified_name");
+        const std::size_t name = table.addStringColumn("name");
+        const std::size_t dataType = table.addStringColumn("data_type");
+        const std::size_t canonicalType = table.addStringColumn("canonical_type");
+        const std::size_t access = table.addStringColumn("access");
+        const std::size_t storage = table.addStringColumn("storage");
+        const std::size_t virtualQualifier = table.addStringColumn("virtual");
+        const std::size_t isInline = table.addIntColumn("inline");
+        const std::size_t isConstExpr = table.addIntColumn("constexpr");
+        const std::size_t layout = table.addStringColumn("layout");
+        const std::size_t usr = table.addStringColumn("usr");
+        const std::size_t nsr = table.addStringColumn("nsr");
+        const std::size_t beginLine = table.addIntColumn("begin_line");
+        const std::size_t endLine = table.addIntColumn("end_line");
+
+        // Nodes still to write, with the row of their parent
+        llvm::SmallVector<std::pair<const beta::APINode*, int64_t>, 64> pending;
+        for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+            pending.emplace_back(*it, -1);
+        }
+        while (!pending.empty()) {
+            auto [node, parentRow] = pending.pop_back_val();
+            int64_t row = static_cast<int64_t>(table.rows());
+            table.append(parent, parentRow);
+            table.append(kind, serialize(node->kind));
+            table.append(qualifiedName, node->getQualifiedName());
+            table.append(name, node->name);
+            table.append(dataType, node->dataType);
+            table.append(canonicalType, node->caonicalType);
+            table.append(access, accessName(node->access));
+            table.append(storage, serialize(node->storage));
+            table.append(virtualQualifier, serialize(node->virtualQualifier));
+            table.append(isInline, int64_t{node->isInclined});
+            table.append(isConstExpr, int64_t{node->isConstExpr});
+            table.append(layout, node->layout);
+            table.append(usr, node->USR);
+            table.append(nsr, node->NSR);
+            table.append(beginLine, int64_t{node->beginLine});
+            table.append(endLine, int64_t{node->endLine});
+            for (auto it = node->children.end(); it != node->children.begin();) {
+                pending.emplace_back(*--it, row);
+            }
+        }
+        return table;
+    }
+
+    bool writeDump(const std::string& file, const nlohmann::json& dump, armor::ReportFormat format) {
+        std::filesystem::create_directories(std::filesystem::path(file).parent_path());
+        std::ofstream out(file, std::ios::binary);
+        if (out) {
+            armor::writeReportDocument(out, dump, format);
+        }
+        if (!out) {
+            armor::user_error() << "Failed to write " << file << "\n";
+            return false;
+        }
+        return true;
+    }
+
+}
+
+bool armor::isDumpApiInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "dump-api";
+}
+
+bool armor::runArmorDumpApi(int argc, const char** argv) {
+    CLI::App app{"ARMOR dump-api"};
+    std::string root;
+    std::vector<std::string> headers;
+    std::vector<std::string> includePaths;
+    std::string macroFlags;
+    std::string language = LANG_CPP;
+    bool skipForeignBodies = false;
+    bool recordLayouts = false;
+    std::string apiFilterFile;
+    std::string reportFormat = "json";
+    unsigned jobs = 1;
+    std::string outputDir;
+    std::string logFile;
+    app.add_option("root", root, "Project root of the version")->required()->check(CLI::ExistingDirectory);
+    app.add_option("headers", headers, "Headers relative to the project root")->required();
+    app.add_option("-I,--include-paths", includePaths, "Include paths for header dependencies");
+    app.add_option("-m,--macro-flags", macroFlags, "Macro flags to be passed for headers");
+    app.add_option("--lang,-l", language, "Language mode: cpp (default) or c")
+        ->transform(CLI::IsMember({LANG_C, LANG_CPP}, CLI::ignore_case));
+    app.add_flag("--skip-foreign-bodies", skipForeignBodies, "Do not parse function bodies outside the headers");
+    app.add_flag("--record-layouts", recordLayouts,
+        "Fill the layout column with the size, alignment and field offsets of complete records");
+    app.add_option("--api-filter", apiFilterFile, "Only dump the declarations the filter file selects")
+        ->check(CLI::ExistingFile);
+    app.add_option("--report-format,-r", reportFormat, "Encoding of the dumps: json (default), cbor or msgpack")
+        ->check(CLI::IsMember({"json", "cbor", "msgpack"}));
+    app.add_option("-j,--jobs", jobs, "Headers parsed and written in parallel (default 1, 0 for all cores)")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--output-dir", outputDir, "Directory receiving the dumps (default: the working directory)");
+    app.add_option("--log-file", logFile,
+        "Diagnostics log of the run (default: debug_output/logs/diagnostics.log under --output-dir)");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::OutputPaths outputs{outputDir, logFile};
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+    std::vector<std::string> macros;
+    std::istringstream iss(macroFlags);
+    std::string flag;
+    while (iss >> flag) {
+        macros.push_back(flag);
+    }
+    LANG_OPTIONS lang = language == LANG_C ? LANG_OPTIONS::C : LANG_OPTIONS::CPP;
+    std::unique_ptr<armor::ApiFilter> apiFilter;
+    if (!apiFilterFile.empty()) {
+        try {
+            apiFilter = std::make_unique<armor::ApiFilter>(armor::ApiFilter::load(apiFilterFile));
+        } catch (const std::exception& e) {
+            armor::user_error() << e.what() << "\n";
+            return false;
+        }
+    }
+    armor::ReportFormat format = armor::reportFormatOf(reportFormat);
+    setRecordLayouts(recordLayouts);
+
+    std::atomic<bool> complete{true};
+    std::vector<std::string> files;
+    armor::HeaderCompilationDatabase compDB;
+    for (std::string& header : headers) {
+        header = std::filesystem::path(header).lexically_normal().string();
+        std::string file = root + "/" + header;
+        if (!std::filesystem::is_regular_file(file)) {
+            armor::user_error() << "No header " << header << " under " << root << "\n";
+            complete = false;
+            continue;
+        }
+        compDB.addHeader(file, root, armor::buildCompileFlags(root, file, includePaths, macros, lang));
+        files.push_back(std::move(file));
+    }
+
+    // Each session parses its share of the headers through one ClangTool and
+    // writes them, freeing every header's contexts once it is written
+    unsigned workerCount = armor::resolveJobCount(jobs);
+    std::size_t groupCount = std::max<std::size_t>(1, std::min<std::size_t>(workerCount, files.size()));
+    std::vector<std::vector<std::string>> groupFiles(groupCount);
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        groupFiles[f % groupCount].push_back(files[f]);
+    }
+    std::atomic<std::size_t> nodes{0};
+    armor::parallelFor(groupCount, workerCount, [&](std::size_t g) {
+        if (groupFiles[g].empty()) {
+            return;
+        }
+        armor::SinglePassSession session(nullptr, API_ONLY_MODE, skipForeignBodies, apiFilter.get());
+        std::vector<PARSING_STATUS> statuses = session.processFiles(groupFiles[g], compDB);
+        for (std::size_t i = 0; i < groupFiles[g].size(); ++i) {
+            const std::string& file = groupFiles[g][i];
+            const beta::ASTNormalizedContext* context = session.getBetaContext(file);
+            if (statuses[i] != NO_FATAL_ERRORS || context == nullptr) {
+                armor::user_error() << "Failed to parse " << file << "\n";
+                complete = false;
+                session.releaseContexts(file);
+                continue;
+            }
+            armor::ColumnTable table = apiColumns(context->getRootNodes());
+            nodes += table.rows();
+            nlohmann::json dump = table.toJson();
+            dump["header"] = std::filesystem::path(file).lexically_relative(root).generic_string();
+            dump["root"] = root;
+            session.releaseContexts(file);
+            std::string headerName = std::filesystem::path(file).filename().string();
+            if (!writeDump(outputs.apiDumpFile(headerName, format), dump, format)) {
+                complete = false;
+            }
+        }
+    });
+
+    armor::user_print() << "API of " << files.size() << " headers, " << nodes << " nodes : "
+                        << std::filesystem::path(outputs.apiDumpFile("", format)).parent_path().string() << "\n";
+    return complete;
+}
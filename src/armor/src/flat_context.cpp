@@ -0,0 +1,500 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "flat_context.hpp"
+
+namespace {
+
+    constexpr char FLAT_MAGIC[4] = {'A', 'B', 'F', 'C'};
+    // Read back in native byte order, so an image of another byte order fails this check
+    constexpr uint32_t FLAT_VERSION = 5;
+    constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+    enum Section : unsigned {
+        NODES,
+        CHILDREN,
+        STMT_HASHES,
+        ROOTS,
+        TREE,
+        TREE_NODES,
+        USRS,
+        UNSUPPORTED_USRS,
+        UNHANDLED_DECLS,
+        INACTIVE_UNHANDLED_DECLS,
+        COMMENTS,
+        MACROS,
+        MACRO_DIRECTIVES,
+        STRINGS,
+        SECTION_COUNT
+    };
+
+    struct FlatString {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct FlatNode {
+        FlatString name;
+        FlatString dataType;
+        FlatString canonicalType;
+        FlatString usr;
+        FlatString nsr;
+        FlatString layout;
+        uint32_t firstChild;
+        uint32_t childCount;
+        uint32_t firstStmtHash;
+        uint32_t stmtHashCount;
+        uint32_t beginLine;
+        uint32_t endLine;
+        uint32_t scope;
+        uint16_t kind;
+        uint8_t access;
+        uint8_t storage;
+        uint8_t virtualQualifier;
+        uint8_t flags;
+        uint8_t padding[2];
+    };
+
+    constexpr uint8_t FLAG_INLINED = 1;
+    constexpr uint8_t FLAG_CONSTEXPR = 2;
+
+    // A tree key covers `count` entries of TREE_NODES from `first`; a USR maps to node `first`
+    struct FlatRange {
+        FlatString key;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    struct FlatHashCount {
+        uint64_t hash;
+        int64_t count;
+    };
+
+    struct FlatMacro {
+        FlatString name;
+        uint64_t definitionHash;
+    };
+
+    struct FlatHeader {
+        char magic[4];
+        uint32_t version;
+        // Elements per section; bytes for STRINGS
+        uint32_t counts[SECTION_COUNT];
+    };
+
+    static_assert(std::is_trivially_copyable<FlatNode>::value, "FlatNode is read in place");
+
+    constexpr size_t ELEMENT_SIZES[SECTION_COUNT] = {
+        sizeof(FlatNode), sizeof(uint32_t), sizeof(uint64_t), sizeof(uint32_t), sizeof(FlatRange),
+        sizeof(uint32_t), sizeof(FlatRange), sizeof(FlatString), sizeof(FlatHashCount), sizeof(FlatHashCount),
+        sizeof(FlatHashCount), sizeof(FlatMacro), sizeof(uint64_t), 1
+    };
+
+    constexpr size_t ALIGNMENT = 8;
+
+    size_t alignUp(size_t offset) {
+        return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    class StringTable {
+        public:
+            FlatString add(llvm::StringRef value) {
+                if (value.empty()) {
+                    return {0, 0};
+                }
+                auto inserted = offsets.try_emplace(value, static_cast<uint32_t>(blob.size()));
+                if (inserted.second) {
+                    blob.append(value.data(), value.size());
+                }
+                return {inserted.first->second, static_cast<uint32_t>(value.size())};
+            }
+
+            const std::string& bytes() const { return blob; }
+
+        private:
+            llvm::StringMap<uint32_t> offsets;
+            std::string blob;
+    };
+
+    // Numbers the nodes reachable from the roots and indexes in visiting order
+    class NodeNumbering {
+        public:
+            uint32_t idOf(const beta::APINode* node) {
+                if (node == nullptr) {
+                    return NO_NODE;
+                }
+                auto inserted = ids.try_emplace(node, static_cast<uint32_t>(nodes.size()));
+                if (inserted.second) {
+                    nodes.push_back(node);
+                }
+                return inserted.first->second;
+            }
+
+            // Children are numbered as they are written, so this also covers them
+            const std::vector<const beta::APINode*>& ordered() const { return nodes; }
+
+        private:
+            llvm::DenseMap<const beta::APINode*, uint32_t> ids;
+            std::vector<const beta::APINode*> nodes;
+    };
+
+    template <typename T>
+    void appendSection(std::string& out, const std::vector<T>& items) {
+        out.append(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+        out.resize(alignUp(out.size()), '\0');
+    }
+
+    std::vector<FlatHashCount> hashCounts(const HashMultiset& map) {
+        std::vector<FlatHashCount> out;
+        out.reserve(map.size());
+        for (const auto& entry : map) {
+            out.push_back({entry.first, entry.second});
+        }
+        return out;
+    }
+
+    class ImageReader {
+        public:
+            explicit ImageReader(llvm::StringRef image) : image(image) {}
+
+            bool mapSections() {
+                if (image.size() < sizeof(FlatHeader)) {
+                    return false;
+                }
+                std::memcpy(&header, image.data(), sizeof(FlatHeader));
+                if (std::memcmp(header.magic, FLAT_MAGIC, sizeof(FLAT_MAGIC)) != 0 || header.version != FLAT_VERSION) {
+                    return false;
+                }
+                size_t offset = alignUp(sizeof(FlatHeader));
+                for (unsigned section = 0; section < SECTION_COUNT; ++section) {
+                    offsets[section] = offset;
+                    offset = alignUp(offset + static_cast<size_t>(header.counts[section]) * ELEMENT_SIZES[section]);
+                    if (offset > image.size()) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            template <typename T>
+            const T* section(Section which) const {
+                return reinterpret_cast<const T*>(image.data() + offsets[which]);
+            }
+
+            uint32_t count(Section which) const { return header.counts[which]; }
+
+            bool string(const FlatString& ref, llvm::StringRef& out) const {
+                if (static_cast<uint64_t>(ref.offset) + ref.length > count(STRINGS)) {
+                    return false;
+                }
+                out = llvm::StringRef(section<char>(STRINGS) + ref.offset, ref.length);
+                return true;
+            }
+
+            bool range(uint32_t first, uint32_t length, Section which) const {
+                return static_cast<uint64_t>(first) + length <= count(which);
+            }
+
+        private:
+            llvm::StringRef image;
+            FlatHeader header{};
+            size_t offsets[SECTION_COUNT] = {};
+    };
+
+    /**
+     * Whether the child ranges of `nodes`, already checked to hold valid ids,
+     * form no cycle; computeFingerprints would recurse forever around one.
+     */
+    bool childrenAcyclic(uint32_t nodeCount, const FlatNode* nodes, const uint32_t* children) {
+        enum : uint8_t { UNSEEN, ON_PATH, DONE };
+        std::vector<uint8_t> state(nodeCount, UNSEEN);
+        // The nodes of the path walked, each with the index of its next child
+        std::vector<std::pair<uint32_t, uint32_t>> path;
+        for (uint32_t start = 0; start < nodeCount; ++start) {
+            if (state[start] != UNSEEN) {
+                continue;
+            }
+            state[start] = ON_PATH;
+            path.emplace_back(start, 0);
+            while (!path.empty()) {
+                const FlatNode& flat = nodes[path.back().first];
+                if (path.back().second == flat.childCount) {
+                    state[path.back().first] = DONE;
+                    path.pop_back();
+                    continue;
+                }
+                uint32_t child = children[flat.firstChild + path.back().second++];
+                if (state[child] == ON_PATH) {
+                    return false;
+                }
+                if (state[child] == UNSEEN) {
+                    state[child] = ON_PATH;
+                    path.emplace_back(child, 0);
+                }
+            }
+        }
+        return true;
+    }
+
+    // The fingerprint is rebuilt by the insertions, so it never comes from the image
+    bool readHashCounts(const ImageReader& reader, Section which, HashMultiset& out) {
+        const FlatHashCount* entries = reader.section<FlatHashCount>(which);
+        out.clear();
+        for (uint32_t i = 0; i < reader.count(which); ++i) {
+            if (entries[i].count <= 0 || entries[i].count > std::numeric_limits<int>::max()) {
+                return false;
+            }
+            out.insert(entries[i].hash, static_cast<int>(entries[i].count));
+        }
+        return true;
+    }
+
+}
+
+std::string armor::writeFlatBetaContext(const beta::ASTNormalizedContext& context) {
+    StringTable strings;
+    NodeNumbering numbering;
+
+    std::vector<uint32_t> roots;
+    for (const beta::APINode* root : context.getRootNodes()) {
+        roots.push_back(numbering.idOf(root));
+    }
+    std::vector<FlatRange> tree;
+    std::vector<uint32_t> treeNodes;
+    for (const auto& entry : context.getTree()) {
+        FlatRange range{strings.add(entry.getKey()), static_cast<uint32_t>(treeNodes.size()),
+                        static_cast<uint32_t>(entry.getValue().size())};
+        for (const beta::APINode* node : entry.getValue()) {
+            treeNodes.push_back(numbering.idOf(node));
+        }
+        tree.push_back(range);
+    }
+    std::vector<FlatRange> usrs;
+    context.forEachUSR([&](llvm::StringRef usr, const beta::APINode* node) {
+        usrs.push_back({strings.add(usr), numbering.idOf(node), 1});
+    });
+    std::vector<FlatString> unsupported;
+    context.forEachUnsupportedUSR([&](llvm::StringRef usr) { unsupported.push_back(strings.add(usr)); });
+
+    // Numbering children as their parents are written appends them behind
+    // the nodes seen so far, so one pass reaches every node
+    std::vector<FlatNode> nodes;
+    std::vector<uint32_t> children;
+    std::vector<uint64_t> stmtHashes;
+    for (size_t i = 0; i < numbering.ordered().size(); ++i) {
+        const beta::APINode& node = *numbering.ordered()[i];
+        FlatNode flat{};
+        flat.name = strings.add(node.name);
+        flat.scope = numbering.idOf(node.scope);
+        flat.dataType = strings.add(node.dataType);
+        flat.canonicalType = strings.add(node.caonicalType);
+        flat.usr = strings.add(node.USR);
+        flat.nsr = strings.add(node.NSR);
+        flat.layout = strings.add(node.layout);
+        flat.firstChild = static_cast<uint32_t>(children.size());
+        flat.childCount = static_cast<uint32_t>(node.children.size());
+        for (const beta::APINode* child : node.children) {
+            children.push_back(numbering.idOf(child));
+        }
+        flat.firstStmtHash = static_cast<uint32_t>(stmtHashes.size());
+        flat.stmtHashCount = static_cast<uint32_t>(node.stmtHashes.size());
+        stmtHashes.insert(stmtHashes.end(), node.stmtHashes.begin(), node.stmtHashes.end());
+        flat.beginLine = node.beginLine;
+        flat.endLine = node.endLine;
+        flat.kind = static_cast<uint16_t>(node.kind);
+        flat.access = static_cast<uint8_t>(node.access);
+        flat.storage = static_cast<uint8_t>(node.storage);
+        flat.virtualQualifier = static_cast<uint8_t>(node.virtualQualifier);
+        flat.flags = (node.isInclined ? FLAG_INLINED : 0) | (node.isConstExpr ? FLAG_CONSTEXPR : 0);
+        nodes.push_back(flat);
+    }
+
+    const beta::SourceRangeTracker& tracker = context.getSourceRangeTracker();
+    std::vector<FlatHashCount> unhandled = hashCounts(tracker.getUnhandledDeclsHashMap());
+    std::vector<FlatHashCount> inactiveUnhandled = hashCounts(tracker.getInactiveUnhandledDeclsHashMap());
+    std::vector<FlatHashCount> comments = hashCounts(tracker.getCommentsHashMap());
+    std::vector<FlatMacro> macros;
+    tracker.getMacros().forEach([&](llvm::StringRef name, uint64_t definitionHash) {
+        macros.push_back({strings.add(name), definitionHash});
+    });
+    const std::vector<uint64_t>& macroDirectives = tracker.getMacros().getDirectiveHashes();
+    std::vector<char> stringBytes(strings.bytes().begin(), strings.bytes().end());
+
+    FlatHeader header{};
+    std::memcpy(header.magic, FLAT_MAGIC, sizeof(FLAT_MAGIC));
+    header.version = FLAT_VERSION;
+    header.counts[NODES] = static_cast<uint32_t>(nodes.size());
+    header.counts[CHILDREN] = static_cast<uint32_t>(children.size());
+    header.counts[STMT_HASHES] = static_cast<uint32_t>(stmtHashes.size());
+    header.counts[ROOTS] = static_cast<uint32_t>(roots.size());
+    header.counts[TREE] = static_cast<uint32_t>(tree.size());
+    header.counts[TREE_NODES] = static_cast<uint32_t>(treeNodes.size());
+    header.counts[USRS] = static_cast<uint32_t>(usrs.size());
+    header.counts[UNSUPPORTED_USRS] = static_cast<uint32_t>(unsupported.size());
+    header.counts[UNHANDLED_DECLS] = static_cast<uint32_t>(unhandled.size());
+    header.counts[INACTIVE_UNHANDLED_DECLS] = static_cast<uint32_t>(inactiveUnhandled.size());
+    header.counts[COMMENTS] = static_cast<uint32_t>(comments.size());
+    header.counts[MACROS] = static_cast<uint32_t>(macros.size());
+    header.counts[MACRO_DIRECTIVES] = static_cast<uint32_t>(macroDirectives.size());
+    header.counts[STRINGS] = static_cast<uint32_t>(stringBytes.size());
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.resize(alignUp(out.size()), '\0');
+    // In Section order
+    appendSection(out, nodes);
+    appendSection(out, children);
+    appendSection(out, stmtHashes);
+    appendSection(out, roots);
+    appendSection(out, tree);
+    appendSection(out, treeNodes);
+    appendSection(out, usrs);
+    appendSection(out, unsupported);
+    appendSection(out, unhandled);
+    appendSection(out, inactiveUnhandled);
+    appendSection(out, comments);
+    appendSection(out, macros);
+    appendSection(out, macroDirectives);
+    appendSection(out, stringBytes);
+    return out;
+}
+
+bool armor::readFlatBetaContext(llvm::StringRef image, std::shared_ptr<const void> storage,
+                                beta::ASTNormalizedContext& context) {
+    // The records are read in place, which needs their natural alignment
+    if (reinterpret_cast<uintptr_t>(image.data()) % ALIGNMENT != 0) {
+        auto copy = std::make_shared<std::vector<uint64_t>>(alignUp(image.size()) / sizeof(uint64_t));
+        std::memcpy(copy->data(), image.data(), image.size());
+        image = llvm::StringRef(reinterpret_cast<const char*>(copy->data()), image.size());
+        storage = std::move(copy);
+    }
+
+    ImageReader reader(image);
+    if (!reader.mapSections()) {
+        return false;
+    }
+
+    const uint32_t nodeCount = reader.count(NODES);
+    const FlatNode* flatNodes = reader.section<FlatNode>(NODES);
+    const uint32_t* children = reader.section<uint32_t>(CHILDREN);
+    const uint64_t* stmtHashes = reader.section<uint64_t>(STMT_HASHES);
+
+    std::vector<beta::APINode*> nodes;
+    nodes.reserve(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        nodes.push_back(context.createNode());
+    }
+    auto validId = [nodeCount](uint32_t id) { return id == NO_NODE || id < nodeCount; };
+    auto nodeAt = [&nodes](uint32_t id) { return id == NO_NODE ? nullptr : nodes[id]; };
+
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const FlatNode& flat = flatNodes[i];
+        beta::APINode& node = *nodes[i];
+        if (!reader.string(flat.name, node.name) || !validId(flat.scope) ||
+            !reader.string(flat.dataType, node.dataType) || !reader.string(flat.canonicalType, node.caonicalType) ||
+            !reader.string(flat.usr, node.USR) || !reader.string(flat.nsr, node.NSR) ||
+            !reader.string(flat.layout, node.layout) ||
+            !reader.range(flat.firstChild, flat.childCount, CHILDREN) ||
+            !reader.range(flat.firstStmtHash, flat.stmtHashCount, STMT_HASHES)) {
+            return false;
+        }
+        node.kind = static_cast<NodeKind>(flat.kind);
+        node.access = static_cast<AccessSpec>(flat.access);
+        node.storage = static_cast<APINodeStorageClass>(flat.storage);
+        node.virtualQualifier = static_cast<VirtualQualifier>(flat.virtualQualifier);
+        node.isInclined = (flat.flags & FLAG_INLINED) != 0;
+        node.isConstExpr = (flat.flags & FLAG_CONSTEXPR) != 0;
+        node.beginLine = flat.beginLine;
+        node.endLine = flat.endLine;
+        node.scope = nodeAt(flat.scope);
+        node.stmtHashes.append(stmtHashes + flat.firstStmtHash, stmtHashes + flat.firstStmtHash + flat.stmtHashCount);
+        for (uint32_t c = flat.firstChild; c < flat.firstChild + flat.childCount; ++c) {
+            if (children[c] == NO_NODE || !validId(children[c])) {
+                return false;
+            }
+            context.addChild(node, nodeAt(children[c]));
+        }
+    }
+    if (!childrenAcyclic(nodeCount, flatNodes, children)) {
+        return false;
+    }
+
+    const uint32_t* roots = reader.section<uint32_t>(ROOTS);
+    for (uint32_t i = 0; i < reader.count(ROOTS); ++i) {
+        if (!validId(roots[i])) {
+            return false;
+        }
+        context.addRootNode(nodeAt(roots[i]));
+    }
+
+    const FlatRange* tree = reader.section<FlatRange>(TREE);
+    const uint32_t* treeNodes = reader.section<uint32_t>(TREE_NODES);
+    for (uint32_t i = 0; i < reader.count(TREE); ++i) {
+        llvm::StringRef key;
+        if (!reader.string(tree[i].key, key) || !reader.range(tree[i].first, tree[i].count, TREE_NODES)) {
+            return false;
+        }
+        for (uint32_t n = tree[i].first; n < tree[i].first + tree[i].count; ++n) {
+            if (!validId(treeNodes[n])) {
+                return false;
+            }
+            context.addNode(key, nodeAt(treeNodes[n]));
+        }
+    }
+
+    const FlatRange* usrs = reader.section<FlatRange>(USRS);
+    for (uint32_t i = 0; i < reader.count(USRS); ++i) {
+        llvm::StringRef key;
+        if (!reader.string(usrs[i].key, key) || !validId(usrs[i].first)) {
+            return false;
+        }
+        context.usrNodeMap.insert_or_assign(key, nodeAt(usrs[i].first));
+    }
+
+    const FlatString* unsupported = reader.section<FlatString>(UNSUPPORTED_USRS);
+    for (uint32_t i = 0; i < reader.count(UNSUPPORTED_USRS); ++i) {
+        llvm::StringRef usr;
+        if (!reader.string(unsupported[i], usr)) {
+            return false;
+        }
+        context.unSupportedUsrNodeMap.insert(usr);
+    }
+
+    beta::SourceRangeTracker& tracker = context.getSourceRangeTracker();
+    if (!readHashCounts(reader, UNHANDLED_DECLS, tracker.getUnhandledDeclsHashMap()) ||
+        !readHashCounts(reader, INACTIVE_UNHANDLED_DECLS, tracker.getInactiveUnhandledDeclsHashMap()) ||
+        !readHashCounts(reader, COMMENTS, tracker.getCommentsHashMap())) {
+        return false;
+    }
+
+    MacroTable& macroTable = tracker.getMacros();
+    const FlatMacro* macros = reader.section<FlatMacro>(MACROS);
+    for (uint32_t i = 0; i < reader.count(MACROS); ++i) {
+        llvm::StringRef name;
+        if (!reader.string(macros[i].name, name) || name.empty()) {
+            return false;
+        }
+        macroTable.define(name, macros[i].definitionHash);
+    }
+    const uint64_t* macroDirectives = reader.section<uint64_t>(MACRO_DIRECTIVES);
+    for (uint32_t i = 0; i < reader.count(MACRO_DIRECTIVES); ++i) {
+        macroTable.addDirectiveHash(macroDirectives[i]);
+    }
+
+    context.retainStorage(std::move(storage));
+    context.computeFingerprints();
+    context.freeze();
+    context.addClangASTContext(nullptr);
+    return true;
+}
@@ -0,0 +1,35 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include "gate_verdict.hpp"
+
+namespace armor {
+
+int GateVerdict::exitCode() const {
+    return incompatibleHeaders.empty() && failedHeaders.empty() ? 0 : 1;
+}
+
+nlohmann::json GateVerdict::toJson() const {
+    return nlohmann::json{{"backward_incompatible", !incompatibleHeaders.empty()},
+                          {"blocking_headers", blockingHeaders},
+                          {"headers", incompatibleHeaders},
+                          {"failed", failedHeaders}};
+}
+
+GateVerdict decideGateVerdict(const std::vector<GateHeader>& headers) {
+    GateVerdict verdict;
+    for (const GateHeader& header : headers) {
+        if (!header.blocking) {
+            continue;
+        }
+        ++verdict.blockingHeaders;
+        if (header.backwardIncompatible) {
+            verdict.incompatibleHeaders.push_back(header.header);
+        }
+        else if (header.failed) {
+            verdict.failedHeaders.push_back(header.header);
+        }
+    }
+    return verdict;
+}
+
+}
@@ -0,0 +1,81 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstddef>
+#include <exception>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <nlohmann/json.hpp>
+
+#include "history.hpp"
+#include "logger.hpp"
+#include "result_history.hpp"
+#include "subcommand.hpp"
+
+bool armor::isHistoryInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "history";
+}
+
+bool armor::runArmorHistory(int argc, const char** argv) {
+    CLI::App app{"ARMOR history"};
+    std::string historyFile;
+    std::vector<std::string> headers;
+    std::size_t last = 0;
+    bool records = false;
+    app.add_option("historyfile", historyFile, "History file written by --history")
+        ->required()
+        ->check(CLI::ExistingFile);
+    app.add_option("--header", headers, "Only print entries of this header, relative to the project root");
+    app.add_option("--last", last, "Only print the last N entries of each header");
+    app.add_flag("--records", records, "Include the change records of every API");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::ResultHistory history;
+    try {
+        history = armor::ResultHistory::load(historyFile);
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+    if (history.getSkippedLines() > 0) {
+        armor::user_error() << "Skipped " << history.getSkippedLines() << " unreadable lines of " << historyFile << "\n";
+    }
+
+    std::set<std::string> selected(headers.begin(), headers.end());
+    const std::vector<armor::HistoryEntry>& entries = history.getEntries();
+    // Entries each header has after the current one, to keep only its last N
+    std::map<std::string, std::size_t> remaining;
+    for (const armor::HistoryEntry& entry : entries) {
+        ++remaining[entry.header];
+    }
+    for (const armor::HistoryEntry& entry : entries) {
+        std::size_t after = --remaining[entry.header];
+        if ((!selected.empty() && !selected.count(entry.header)) || (last > 0 && after >= last)) {
+            continue;
+        }
+        nlohmann::json line{{"header", entry.header},
+                            {"base", entry.base},
+                            {"head", entry.head},
+                            {"time", entry.time},
+                            {"seconds", entry.seconds},
+                            {"compatibility", entry.overallStatus}};
+        nlohmann::json apiNames = nlohmann::json::array();
+        for (const ChangeRecord& record : entry.records) {
+            apiNames.push_back(record.name);
+        }
+        line["api_names"] = std::move(apiNames);
+        if (records) {
+            line["records"] = entry.toJson()["records"];
+        }
+        llvm::outs() << line.dump() << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,177 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+#include "cache_directory.hpp"
+#include "include_graph.hpp"
+#include "logger.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+    constexpr int GRAPH_FORMAT_VERSION = 1;
+
+    bool hashFile(const std::string& path, uint64_t& hash) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+            llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if (!buffer) {
+            return false;
+        }
+        hash = llvm::xxHash64((*buffer)->getBuffer());
+        return true;
+    }
+
+    std::string normalized(const std::string& path) {
+        std::error_code ec;
+        std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+        return (ec ? std::filesystem::path(path) : absolute).lexically_normal().string();
+    }
+
+    // `file` relative to `root`, false if it lies outside it
+    bool relativeTo(const std::string& file, const std::string& root, std::string& relative) {
+        llvm::StringRef rest(file);
+        llvm::StringRef prefix(root);
+        prefix.consume_back("/");
+        if (!rest.consume_front(prefix) || !rest.consume_front("/")) {
+            return false;
+        }
+        relative = rest.str();
+        return true;
+    }
+
+}
+
+armor::IncludeGraph::IncludeGraph(std::string cacheDir) {
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(path, "includes");
+    graphDir = path.str().str();
+}
+
+std::string armor::IncludeGraph::recordPath(const std::string& header, const std::vector<std::string>& flags) const {
+    std::string material = normalized(header);
+    material += '\0';
+    for (const auto& flag : flags) {
+        material += flag;
+        material += '\0';
+    }
+    llvm::SmallString<256> path(graphDir);
+    llvm::sys::path::append(path, llvm::utohexstr(llvm::xxHash64(material)) + ".json");
+    return path.str().str();
+}
+
+void armor::IncludeGraph::record(const std::string& header, const std::vector<std::string>& flags,
+                                 const std::vector<std::string>& files) const {
+    json closure = json::array();
+    for (const auto& file : files) {
+        uint64_t hash = 0;
+        std::string path = normalized(file);
+        if (!hashFile(path, hash)) {
+            ARMOR_DEBUG_LOG << "Not recording the includes of " << header << " : cannot read " << path << "\n";
+            return;
+        }
+        closure.push_back({path, hash});
+    }
+    json entry = {{"format", GRAPH_FORMAT_VERSION}, {"header", normalized(header)}, {"files", std::move(closure)}};
+
+    if (std::error_code ec = llvm::sys::fs::create_directories(graphDir)) {
+        ARMOR_DEBUG_LOG << "Cannot create include graph directory " << graphDir << " : " << ec.message() << "\n";
+        return;
+    }
+    // Published atomically, as processes may share the cache directory
+    std::string error;
+    if (!publishCacheFile(recordPath(header, flags), entry.dump(), error)) {
+        ARMOR_DEBUG_LOG << "Cannot record the includes of " << header << " : " << error << "\n";
+    }
+}
+
+bool armor::IncludeGraph::readRecord(const std::string& header, const std::vector<std::string>& flags,
+                                     std::vector<std::pair<std::string, uint64_t>>& files) const {
+    std::string path = recordPath(header, flags);
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        return false;
+    }
+    json entry = json::parse((*buffer)->getBuffer().begin(), (*buffer)->getBuffer().end(), nullptr,
+                             /*allow_exceptions=*/false);
+    if (entry.is_discarded() || entry.value("format", 0) != GRAPH_FORMAT_VERSION || !entry.contains("files")) {
+        return false;
+    }
+    try {
+        for (const json& file : entry.at("files")) {
+            std::string included = file.at(0).get<std::string>();
+            uint64_t recorded = file.at(1).get<uint64_t>();
+            uint64_t hash = 0;
+            if (!hashFile(included, hash) || hash != recorded) {
+                ARMOR_DEBUG_LOG << "Include record of " << header << " is stale: " << included << " changed\n";
+                return false;
+            }
+            files.emplace_back(std::move(included), recorded);
+        }
+    }
+    catch (const std::exception& e) {
+        ARMOR_DEBUG_LOG << "Ignoring unreadable include record of " << header << " : " << e.what() << "\n";
+        return false;
+    }
+    touchCacheFile(path);
+    return true;
+}
+
+bool armor::IncludeGraph::closureUnchanged(const std::string& header, const std::vector<std::string>& flags,
+                                           const std::string& root, const std::string& otherRoot) const {
+    std::vector<std::pair<std::string, uint64_t>> files;
+    if (!readRecord(header, flags, files)) {
+        return false;
+    }
+    std::string rootPath = normalized(root);
+    std::string otherRootPath = normalized(otherRoot);
+    for (const auto& [path, recorded] : files) {
+        std::string relative;
+        if (!relativeTo(path, rootPath, relative)) {
+            continue;
+        }
+        llvm::SmallString<256> counterpart(otherRootPath);
+        llvm::sys::path::append(counterpart, relative);
+        uint64_t hash = 0;
+        if (!hashFile(counterpart.str().str(), hash) || hash != recorded) {
+            armor::info() << header << " is unchanged, but its include " << relative << " differs\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool armor::IncludeGraph::closureDigest(const std::string& header, const std::vector<std::string>& flags,
+                                        const std::string& root, uint64_t& digest) const {
+    std::vector<std::pair<std::string, uint64_t>> files;
+    if (!readRecord(header, flags, files)) {
+        return false;
+    }
+    std::string rootPath = normalized(root);
+    std::string material;
+    for (const auto& [path, recorded] : files) {
+        std::string relative;
+        material += relativeTo(path, rootPath, relative) ? relative : path;
+        material += '\0';
+        material += llvm::utohexstr(recorded);
+        material += '\0';
+    }
+    digest = llvm::xxHash64(material);
+    return true;
+}
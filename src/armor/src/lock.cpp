@@ -0,0 +1,469 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <nlohmann/json.hpp>
+
+#include "api_filter.hpp"
+#include "categorization.hpp"
+#include "comm_def.hpp"
+#include "compile_flags.hpp"
+#include "flat_context.hpp"
+#include "header_compilation_database.hpp"
+#include "lock.hpp"
+#include "logger.hpp"
+#include "output_paths.hpp"
+#include "report_format.hpp"
+#include "report_utils.hpp"
+#include "single_pass.hpp"
+#include "subcommand.hpp"
+#include "work_pool.hpp"
+#include "beta/include/ast_normalized_context.hpp"
+#include "beta/include/header_processor.hpp"
+
+#ifndef TOOL_VERSION
+#define TOOL_VERSION ""
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+
+    // Bump whenever the layout of the lock file changes; the flat images are
+    // guarded by the tool version, as they change with the normalizers
+    constexpr uint32_t LOCK_FORMAT_VERSION = 1;
+
+    constexpr char LOCK_MAGIC[4] = {'A', 'R', 'L', 'K'};
+
+    /**
+     * A lock file is this header, the CBOR metadata (tool version, flags and
+     * the offset and size of every header's image), padding to 8 bytes and
+     * the flat beta images (see writeFlatBetaContext), each padded to 8
+     * bytes and read in place.
+     */
+    struct LockHeader {
+        char magic[4];
+        uint32_t format;
+        uint64_t metadataSize;
+    };
+
+    constexpr std::size_t IMAGE_ALIGNMENT = 8;
+
+    std::size_t aligned(std::size_t size) {
+        return (size + IMAGE_ALIGNMENT - 1) & ~(IMAGE_ALIGNMENT - 1);
+    }
+
+    // A lock file as read: its metadata and the image of every header
+    struct LockFile {
+        json metadata;
+        std::shared_ptr<const llvm::MemoryBuffer> buffer;
+        std::vector<std::string> headers;
+        std::vector<llvm::StringRef> images;
+    };
+
+    // `images` holds (header, flat image) pairs; their offsets are relative to the first image
+    std::string encodeLock(json metadata, const std::vector<std::pair<std::string, std::string>>& images) {
+        metadata["headers"] = json::array();
+        std::size_t offset = 0;
+        for (const auto& [header, image] : images) {
+            metadata["headers"].push_back({{"header", header}, {"offset", offset}, {"size", image.size()}});
+            offset += aligned(image.size());
+        }
+        std::vector<std::uint8_t> cbor = json::to_cbor(metadata);
+        LockHeader header{};
+        std::memcpy(header.magic, LOCK_MAGIC, sizeof(LOCK_MAGIC));
+        header.format = LOCK_FORMAT_VERSION;
+        header.metadataSize = cbor.size();
+
+        std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+        bytes.append(reinterpret_cast<const char*>(cbor.data()), cbor.size());
+        bytes.resize(aligned(bytes.size()), '\0');
+        for (const auto& entry : images) {
+            bytes.append(entry.second);
+            bytes.resize(aligned(bytes.size()), '\0');
+        }
+        return bytes;
+    }
+
+    // Throws on a missing, truncated or foreign file
+    LockFile readLock(const std::string& path) {
+        auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if (!buffer) {
+            throw std::runtime_error("cannot read " + path + " : " + buffer.getError().message());
+        }
+        llvm::StringRef bytes = (*buffer)->getBuffer();
+        LockHeader header{};
+        if (bytes.size() < sizeof(LockHeader)) {
+            throw std::runtime_error(path + " is truncated");
+        }
+        std::memcpy(&header, bytes.data(), sizeof(LockHeader));
+        if (std::memcmp(header.magic, LOCK_MAGIC, sizeof(LOCK_MAGIC)) != 0 || header.format != LOCK_FORMAT_VERSION) {
+            throw std::runtime_error(path + " is not a lock file of this format");
+        }
+        if (header.metadataSize > bytes.size() || aligned(sizeof(LockHeader) + header.metadataSize) > bytes.size()) {
+            throw std::runtime_error(path + " is truncated");
+        }
+        LockFile lock;
+        llvm::StringRef metadata = bytes.substr(sizeof(LockHeader), header.metadataSize);
+        lock.metadata = json::from_cbor(metadata.begin(), metadata.end());
+        if (lock.metadata.value("tool_version", "") != TOOL_VERSION) {
+            throw std::runtime_error(path + " was written by armor " + lock.metadata.value("tool_version", "") +
+                                     ", lock the API again with this version");
+        }
+        llvm::StringRef images = bytes.substr(aligned(sizeof(LockHeader) + header.metadataSize));
+        for (const json& entry : lock.metadata.at("headers")) {
+            std::size_t offset = entry.at("offset").get<std::size_t>();
+            std::size_t size = entry.at("size").get<std::size_t>();
+            if (offset > images.size() || size > images.size() - offset) {
+                throw std::runtime_error(path + " is truncated");
+            }
+            lock.headers.push_back(entry.at("header").get<std::string>());
+            lock.images.push_back(images.substr(offset, size));
+        }
+        lock.buffer = std::move(*buffer);
+        return lock;
+    }
+
+    // Written next to `path` and renamed, so a failed run leaves the previous lock
+    bool writeLock(const std::string& path, const std::string& bytes) {
+        std::filesystem::path target(path);
+        if (target.has_parent_path()) {
+            std::filesystem::create_directories(target.parent_path());
+        }
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!out) {
+                armor::user_error() << "Failed to write " << temporary << "\n";
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        if (ec) {
+            armor::user_error() << "Failed to write " << path << " : " << ec.message() << "\n";
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<std::string> splitMacroFlags(const std::string& macroFlags) {
+        std::vector<std::string> macros;
+        std::istringstream iss(macroFlags);
+        std::string flag;
+        while (iss >> flag) {
+            macros.push_back(flag);
+        }
+        return macros;
+    }
+
+    std::unique_ptr<armor::ApiFilter> loadApiFilter(const std::string& apiFilterFile) {
+        if (apiFilterFile.empty()) {
+            return nullptr;
+        }
+        return std::make_unique<armor::ApiFilter>(armor::ApiFilter::load(apiFilterFile));
+    }
+
+    // Header path as the reports name it, relative to the project root
+    std::string reportedHeader(const std::string& header) {
+        return std::filesystem::path(header).lexically_normal().string();
+    }
+
+    bool writeSummary(const std::string& file, const json& report) {
+        std::filesystem::create_directories(std::filesystem::path(file).parent_path());
+        std::ofstream out(file);
+        if (!out) {
+            armor::user_error() << "Failed to write " << file << "\n";
+            return false;
+        }
+        armor::writeReportDocument(out, report, armor::ReportFormat::JSON);
+        return true;
+    }
+
+    // The files of `files` split over at most `workerCount` sessions, round robin
+    std::vector<std::vector<std::size_t>> groupsOf(std::size_t files, unsigned workerCount) {
+        std::size_t groupCount = std::max<std::size_t>(1, std::min<std::size_t>(workerCount, files));
+        std::vector<std::vector<std::size_t>> groups(groupCount);
+        for (std::size_t f = 0; f < files; ++f) {
+            groups[f % groupCount].push_back(f);
+        }
+        return groups;
+    }
+
+}
+
+bool armor::isLockInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "lock";
+}
+
+bool armor::runArmorLock(int argc, const char** argv) {
+    CLI::App app{"ARMOR lock"};
+    std::string root;
+    std::vector<std::string> headers;
+    std::string lockFile;
+    std::vector<std::string> includePaths;
+    std::string macroFlags;
+    std::string language = LANG_CPP;
+    std::string mode = MODE_FULL;
+    bool skipForeignBodies = false;
+    std::string apiFilterFile;
+    unsigned jobs = 1;
+    std::string outputDir;
+    std::string logFile;
+    app.add_option("root", root, "Project root of the version")->required()->check(CLI::ExistingDirectory);
+    app.add_option("headers", headers, "Headers relative to the project root")->required();
+    app.add_option("-o,--output", lockFile, "Lock file to write")->required();
+    app.add_option("-I,--include-paths", includePaths, "Include paths for header dependencies");
+    app.add_option("-m,--macro-flags", macroFlags, "Macro flags to be passed for headers");
+    app.add_option("--lang,-l", language, "Language mode: cpp (default) or c")
+        ->transform(CLI::IsMember({LANG_C, LANG_CPP}, CLI::ignore_case));
+    app.add_option("--mode", mode, "Parse mode: full (default) or api-only")
+        ->check(CLI::IsMember({MODE_FULL, MODE_API_ONLY}));
+    app.add_flag("--skip-foreign-bodies", skipForeignBodies, "Do not parse function bodies outside the headers");
+    app.add_option("--api-filter", apiFilterFile, "Only lock the declarations the filter file selects")
+        ->check(CLI::ExistingFile);
+    app.add_option("-j,--jobs", jobs, "Headers parsed in parallel (default 1, 0 for all cores)")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--output-dir", outputDir, "Directory receiving the diagnostics (default: the working directory)");
+    app.add_option("--log-file", logFile,
+        "Diagnostics log of the run (default: debug_output/logs/diagnostics.log under --output-dir)");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::OutputPaths outputs{outputDir, logFile};
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+    std::vector<std::string> macros = splitMacroFlags(macroFlags);
+    LANG_OPTIONS lang = language == LANG_C ? LANG_OPTIONS::C : LANG_OPTIONS::CPP;
+    PARSE_MODE parseMode = mode == MODE_API_ONLY ? API_ONLY_MODE : FULL_MODE;
+    std::unique_ptr<armor::ApiFilter> apiFilter;
+    try {
+        apiFilter = loadApiFilter(apiFilterFile);
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+
+    std::vector<std::string> files;
+    armor::HeaderCompilationDatabase compDB;
+    for (std::string& header : headers) {
+        header = reportedHeader(header);
+        std::string file = root + "/" + header;
+        if (!std::filesystem::is_regular_file(file)) {
+            armor::user_error() << "No header " << header << " under " << root << "\n";
+            return false;
+        }
+        compDB.addHeader(file, root, armor::buildCompileFlags(root, file, includePaths, macros, lang));
+        files.push_back(std::move(file));
+    }
+
+    // Each session parses its share of the headers through one ClangTool and
+    // keeps only their images
+    unsigned workerCount = armor::resolveJobCount(jobs);
+    std::vector<std::vector<std::size_t>> groups = groupsOf(files.size(), workerCount);
+    std::vector<std::pair<std::string, std::string>> images(files.size());
+    std::atomic<bool> complete{true};
+    armor::parallelFor(groups.size(), workerCount, [&](std::size_t g) {
+        if (groups[g].empty()) {
+            return;
+        }
+        std::vector<std::string> groupFiles;
+        for (std::size_t f : groups[g]) {
+            groupFiles.push_back(files[f]);
+        }
+        armor::SinglePassSession session(nullptr, parseMode, skipForeignBodies, apiFilter.get());
+        std::vector<PARSING_STATUS> statuses = session.processFiles(groupFiles, compDB);
+        for (std::size_t i = 0; i < groupFiles.size(); ++i) {
+            const beta::ASTNormalizedContext* context = session.getBetaContext(groupFiles[i]);
+            if (statuses[i] != NO_FATAL_ERRORS || context == nullptr) {
+                armor::user_error() << "Failed to parse " << groupFiles[i] << "\n";
+                complete = false;
+            }
+            else {
+                images[groups[g][i]] = {headers[groups[g][i]], armor::writeFlatBetaContext(*context)};
+            }
+            session.releaseContexts(groupFiles[i]);
+        }
+    });
+    if (!complete) {
+        return false;
+    }
+
+    json metadata{{"tool_version", TOOL_VERSION},
+                  {"lang", language},
+                  {"mode", mode},
+                  {"skip_foreign_bodies", skipForeignBodies},
+                  {"include_paths", includePaths},
+                  {"macro_flags", macros},
+                  {"api_filter", apiFilter ? json(apiFilter->fingerprint()) : json()}};
+    if (!writeLock(lockFile, encodeLock(std::move(metadata), images))) {
+        return false;
+    }
+    armor::user_print() << "Locked the API of " << files.size() << " headers : " << lockFile << "\n";
+    return true;
+}
+
+bool armor::isCheckInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "check";
+}
+
+bool armor::runArmorCheck(int argc, const char** argv) {
+    CLI::App app{"ARMOR check"};
+    std::string root;
+    std::string lockFile;
+    std::string apiFilterFile;
+    std::string reportFormat = "html";
+    bool verdictOnly = false;
+    unsigned jobs = 1;
+    std::string outputDir;
+    std::string logFile;
+    app.add_option("root", root, "Project root of the head version")->required()->check(CLI::ExistingDirectory);
+    app.add_option("--lock", lockFile, "Lock file written by armor lock")->required()->check(CLI::ExistingFile);
+    app.add_option("--api-filter", apiFilterFile, "The filter file the lock was written with")
+        ->check(CLI::ExistingFile);
+    app.add_option("--report-format,-r", reportFormat, "Report format of every header: html (default)")
+        ->check(CLI::IsMember({"html", "json", "cbor", "msgpack"}));
+    app.add_flag("--verdict-only", verdictOnly,
+        "Only decide the overall status of every header, writing no per-header reports");
+    app.add_option("-j,--jobs", jobs, "Headers parsed and compared in parallel (default 1, 0 for all cores)")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--output-dir", outputDir, "Directory receiving the reports (default: the working directory)");
+    app.add_option("--log-file", logFile,
+        "Diagnostics log of the run (default: debug_output/logs/diagnostics.log under --output-dir)");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::OutputPaths outputs{outputDir, logFile};
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+
+    // The head version is parsed with the flags of the lock
+    LockFile lock;
+    std::vector<std::string> includePaths;
+    std::vector<std::string> macros;
+    LANG_OPTIONS lang = LANG_OPTIONS::CPP;
+    PARSE_MODE parseMode = FULL_MODE;
+    bool skipForeignBodies = false;
+    std::unique_ptr<armor::ApiFilter> apiFilter;
+    try {
+        lock = readLock(lockFile);
+        const json& metadata = lock.metadata;
+        includePaths = metadata.at("include_paths").get<std::vector<std::string>>();
+        macros = metadata.at("macro_flags").get<std::vector<std::string>>();
+        lang = metadata.at("lang").get<std::string>() == LANG_C ? LANG_OPTIONS::C : LANG_OPTIONS::CPP;
+        parseMode = metadata.at("mode").get<std::string>() == MODE_API_ONLY ? API_ONLY_MODE : FULL_MODE;
+        skipForeignBodies = metadata.at("skip_foreign_bodies").get<bool>();
+        apiFilter = loadApiFilter(apiFilterFile);
+        json lockedFilter = metadata.at("api_filter");
+        if (lockedFilter.is_null() != (apiFilter == nullptr) ||
+            (apiFilter && lockedFilter.get<std::string>() != apiFilter->fingerprint())) {
+            throw std::runtime_error("--api-filter must be the filter " + lockFile + " was written with");
+        }
+    } catch (const std::exception& e) {
+        armor::user_error() << "Invalid lock file : " << e.what() << "\n";
+        return false;
+    }
+    ReportSummaries::getInstance().clear();
+
+    // Per locked header: its index among the parsed files, or none when head lacks it
+    const std::vector<std::string>& headers = lock.headers;
+    std::vector<std::string> verdicts(headers.size());
+    std::vector<std::size_t> parsed;
+    armor::HeaderCompilationDatabase compDB;
+    for (std::size_t h = 0; h < headers.size(); ++h) {
+        std::string file = root + "/" + headers[h];
+        if (!std::filesystem::is_regular_file(file)) {
+            verdicts[h] = serialize(OverAllStatus::BACKWARD_INCOMPATIBLE);
+            continue;
+        }
+        compDB.addHeader(file, root, armor::buildCompileFlags(root, file, includePaths, macros, lang));
+        parsed.push_back(h);
+    }
+
+    unsigned workerCount = armor::resolveJobCount(jobs);
+    unsigned diffJobs = std::max<unsigned>(1, workerCount / std::max<std::size_t>(1, parsed.size()));
+    std::vector<std::vector<std::size_t>> groups = groupsOf(parsed.size(), workerCount);
+    std::atomic<bool> complete{true};
+    armor::parallelFor(groups.size(), workerCount, [&](std::size_t g) {
+        if (groups[g].empty()) {
+            return;
+        }
+        std::vector<std::string> groupFiles;
+        for (std::size_t p : groups[g]) {
+            groupFiles.push_back(root + "/" + headers[parsed[p]]);
+        }
+        armor::SinglePassSession session(nullptr, parseMode, skipForeignBodies, apiFilter.get());
+        std::vector<PARSING_STATUS> statuses = session.processFiles(groupFiles, compDB);
+        for (std::size_t i = 0; i < groupFiles.size(); ++i) {
+            const std::string& file = groupFiles[i];
+            std::size_t h = parsed[groups[g][i]];
+            beta::ASTNormalizedContext* head = session.getBetaContext(file);
+            beta::ASTNormalizedContext locked;
+            if (statuses[i] != NO_FATAL_ERRORS || head == nullptr) {
+                armor::user_error() << "Failed to parse " << file << "\n";
+                complete = false;
+            }
+            else if (!armor::readFlatBetaContext(lock.images[h], lock.buffer, locked)) {
+                armor::user_error() << "Malformed image of " << headers[h] << " in " << lockFile << "\n";
+                complete = false;
+            }
+            else {
+                try {
+                    if (verdictOnly) {
+                        reportHeaderPairVerdictBeta(root, file, &locked, head, nullptr, diffJobs);
+                    }
+                    else {
+                        reportHeaderPairBeta(root, file, reportFormat, &locked, head, false, nullptr, outputs,
+                                             diffJobs);
+                    }
+                    ReportSummaries::Summary summary;
+                    if (ReportSummaries::getInstance().take(headers[h], summary)) {
+                        verdicts[h] = summary.overallStatus;
+                    }
+                } catch (const std::exception& e) {
+                    armor::user_error() << "Failed to report " << file << " : " << e.what() << "\n";
+                    complete = false;
+                }
+            }
+            session.releaseContexts(file);
+        }
+    });
+
+    json report{{"lock", lockFile}, {"root", root}, {"statuses", json::object()}};
+    bool backwardIncompatible = false;
+    for (std::size_t h = 0; h < headers.size(); ++h) {
+        backwardIncompatible |= verdicts[h] == serialize(OverAllStatus::BACKWARD_INCOMPATIBLE);
+        report["statuses"][headers[h]] = verdicts[h].empty() ? json() : json(verdicts[h]);
+    }
+    if (!writeSummary(outputs.checkJsonFile(), report)) {
+        return false;
+    }
+    armor::user_print() << "Checked " << headers.size() << " headers against " << lockFile << " : "
+                        << outputs.checkJsonFile() << "\n";
+    return complete && !backwardIncompatible;
+}
@@ -1,8 +1,64 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
+#include "chain.hpp"
+#include "dump_api.hpp"
+#include "history.hpp"
+#include "lock.hpp"
+#include "matrix.hpp"
+#include "merge.hpp"
 #include "options_handler.hpp"
+#include "replay.hpp"
+#include "select_headers.hpp"
+#include "server.hpp"
+#include "sweep.hpp"
+#include "warm.hpp"
 
 int main(int argc, const char **argv) {
+    if (armor::isMergeInvocation(argc, argv)) {
+        return armor::runArmorMerge(argc, argv) ? 0 : 1;
+    }
+    if (armor::isHistoryInvocation(argc, argv)) {
+        return armor::runArmorHistory(argc, argv) ? 0 : 1;
+    }
+    if (armor::isChainInvocation(argc, argv)) {
+        return armor::runArmorChain(argc, argv) ? 0 : 1;
+    }
+    if (armor::isMultiBaseInvocation(argc, argv)) {
+        return armor::runArmorMultiBase(argc, argv) ? 0 : 1;
+    }
+    if (armor::isWhatIfInvocation(argc, argv)) {
+        return armor::runArmorWhatIf(argc, argv) ? 0 : 1;
+    }
+    if (armor::isSelectHeadersInvocation(argc, argv)) {
+        return armor::runArmorSelectHeaders(argc, argv) ? 0 : 1;
+    }
+    if (armor::isDumpApiInvocation(argc, argv)) {
+        return armor::runArmorDumpApi(argc, argv) ? 0 : 1;
+    }
+    if (armor::isPairsInvocation(argc, argv)) {
+        return armor::runArmorPairs(argc, argv) ? 0 : 1;
+    }
+    if (armor::isMatrixInvocation(argc, argv)) {
+        return armor::runArmorMatrix(argc, argv) ? 0 : 1;
+    }
+    if (armor::isLockInvocation(argc, argv)) {
+        return armor::runArmorLock(argc, argv) ? 0 : 1;
+    }
+    if (armor::isCheckInvocation(argc, argv)) {
+        return armor::runArmorCheck(argc, argv) ? 0 : 1;
+    }
+    if (armor::isReplayInvocation(argc, argv)) {
+        return armor::runArmorReplay(argc, argv) ? 0 : 1;
+    }
+    if (armor::isWarmInvocation(argc, argv)) {
+        return armor::runArmorWarm(argc, argv) ? 0 : 1;
+    }
+    if (armor::isBenchSweepInvocation(argc, argv)) {
+        return armor::runArmorBenchSweep(argc, argv) ? 0 : 1;
+    }
+    if (armor::isServeInvocation(argc, argv)) {
+        return armor::runArmorServer(argc, argv) ? 0 : 1;
+    }
     if (!runArmorTool(argc, argv)) {
         return 1;
     }
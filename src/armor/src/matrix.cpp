@@ -0,0 +1,249 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "logger.hpp"
+#include "macro_matrix.hpp"
+#include "matrix.hpp"
+#include "options_handler.hpp"
+#include "output_paths.hpp"
+#include "project_pairs.hpp"
+#include "report_merge.hpp"
+
+namespace {
+
+    struct MatrixArguments {
+        std::string matrixFile;
+        std::string pairsFile;
+        std::string outputDir;
+        std::string macroFlags;
+        std::string reportFormat;
+        std::string lang;
+        // Every other argument, passed on to each configuration's run
+        std::vector<std::string> passed;
+    };
+
+    // Value of `arg` if it is one of the given spellings of an option, taking
+    // the next argument for the separate form
+    bool takeOption(llvm::StringRef arg, int& i, int argc, const char** argv,
+                    llvm::StringRef longName, llvm::StringRef shortName, std::string& value) {
+        if (arg == longName || (!shortName.empty() && arg == shortName)) {
+            if (i + 1 < argc) {
+                value = argv[++i];
+            }
+            return true;
+        }
+        if (arg.consume_front((longName + "=").str())) {
+            value = arg.str();
+            return true;
+        }
+        if (!shortName.empty() && arg.consume_front(shortName)) {
+            value = arg.str();
+            return true;
+        }
+        return false;
+    }
+
+    MatrixArguments parseArguments(int argc, const char** argv) {
+        MatrixArguments arguments;
+        for (int i = 1; i < argc; ++i) {
+            llvm::StringRef arg(argv[i]);
+            if (takeOption(arg, i, argc, argv, "--macro-matrix", "", arguments.matrixFile) ||
+                takeOption(arg, i, argc, argv, "--pairs-file", "", arguments.pairsFile) ||
+                takeOption(arg, i, argc, argv, "--output-dir", "", arguments.outputDir) ||
+                takeOption(arg, i, argc, argv, "--macro-flags", "-m", arguments.macroFlags) ||
+                takeOption(arg, i, argc, argv, "--report-format", "-r", arguments.reportFormat) ||
+                takeOption(arg, i, argc, argv, "--lang", "-l", arguments.lang)) {
+                continue;
+            }
+            arguments.passed.push_back(arg.str());
+        }
+        return arguments;
+    }
+
+    std::string joinMacroFlags(const std::string& common, const std::string& own) {
+        if (own.empty()) {
+            return common;
+        }
+        return common.empty() ? own : common + " " + own;
+    }
+
+    bool isInvocationOf(int argc, const char** argv, llvm::StringRef option) {
+        for (int i = 1; i < argc; ++i) {
+            llvm::StringRef arg(argv[i]);
+            if (arg == option || arg.startswith((option + "=").str())) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
+
+bool armor::isMatrixInvocation(int argc, const char** argv) {
+    return isInvocationOf(argc, argv, "--macro-matrix");
+}
+
+bool armor::isPairsInvocation(int argc, const char** argv) {
+    return isInvocationOf(argc, argv, "--pairs-file");
+}
+
+bool armor::runArmorMatrix(int argc, const char** argv) {
+    MatrixArguments arguments = parseArguments(argc, argv);
+    if (arguments.matrixFile.empty()) {
+        armor::user_error() << "--macro-matrix needs a file\n";
+        return false;
+    }
+    std::vector<MacroConfiguration> configurations;
+    try {
+        configurations = loadMacroMatrix(arguments.matrixFile);
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+    // The merged report is built from the JSON reports of the runs
+    if (arguments.reportFormat.empty() || arguments.reportFormat == "html") {
+        arguments.reportFormat = "json";
+    }
+
+    armor::OutputPaths outputs{arguments.outputDir};
+    armor::MatrixReport report;
+    bool complete = true;
+    for (const MacroConfiguration& configuration : configurations) {
+        std::string root = outputs.configurationRoot(configuration.name);
+        std::string macroFlags = joinMacroFlags(arguments.macroFlags, configuration.macroFlags);
+
+        std::vector<std::string> args = arguments.passed;
+        args.insert(args.end(), {"--output-dir", root, "-r", arguments.reportFormat});
+        if (!arguments.lang.empty()) {
+            args.insert(args.end(), {"--lang", arguments.lang});
+        }
+        if (!macroFlags.empty()) {
+            args.insert(args.end(), {"--macro-flags", macroFlags});
+        }
+        std::vector<const char*> runArgv{argv[0]};
+        for (const auto& arg : args) {
+            runArgv.push_back(arg.c_str());
+        }
+
+        armor::user_print() << "Configuration " << configuration.name << " : " << macroFlags << "\n";
+        // false also when the run found incompatible changes, which the matrix report shows
+        runArmorTool(static_cast<int>(runArgv.size()), runArgv.data());
+        try {
+            if (report.addConfiguration(configuration.name, root) == 0) {
+                armor::user_error() << "Configuration " << configuration.name << " wrote no reports\n";
+                complete = false;
+            }
+        } catch (const std::exception& e) {
+            armor::user_error() << e.what() << "\n";
+            return false;
+        }
+    }
+
+    // The runs logged under their own roots
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+    try {
+        report.write(outputs);
+    } catch (const std::exception& e) {
+        armor::user_error() << "Failed to write the matrix report : " << e.what() << "\n";
+        return false;
+    }
+    armor::user_print() << "Matrix report of " << configurations.size() << " configurations, "
+                        << report.findingCount() << " findings : " << outputs.matrixHtmlFile() << " and "
+                        << outputs.matrixJsonFile() << "\n";
+    return complete && !report.hasBackwardIncompatible();
+}
+
+bool armor::runArmorPairs(int argc, const char** argv) {
+    MatrixArguments arguments = parseArguments(argc, argv);
+    if (arguments.pairsFile.empty()) {
+        armor::user_error() << "--pairs-file needs a file\n";
+        return false;
+    }
+    if (!arguments.matrixFile.empty()) {
+        armor::user_error() << "--pairs-file cannot be used with --macro-matrix\n";
+        return false;
+    }
+    std::vector<ProjectPair> projects;
+    try {
+        projects = loadProjectPairs(arguments.pairsFile);
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+    // The summary report is built from the JSON reports of the runs
+    if (arguments.reportFormat.empty() || arguments.reportFormat == "html") {
+        arguments.reportFormat = "json";
+    }
+
+    armor::OutputPaths outputs{arguments.outputDir};
+    armor::MergedReports merged;
+    bool complete = true;
+    for (const ProjectPair& project : projects) {
+        std::string root = outputs.pairsProjectRoot(project.name);
+        std::string macroFlags = joinMacroFlags(arguments.macroFlags, project.macroFlags);
+        std::string lang = project.lang.empty() ? arguments.lang : project.lang;
+
+        // Positionals first, as the vector options of the command line would take them
+        std::vector<std::string> args{project.root1, project.root2};
+        args.insert(args.end(), project.headers.begin(), project.headers.end());
+        args.insert(args.end(), arguments.passed.begin(), arguments.passed.end());
+        args.insert(args.end(), {"--output-dir", root, "-r", arguments.reportFormat});
+        if (!project.headerDir.empty()) {
+            args.insert(args.end(), {"--header-dir", project.headerDir});
+            if (project.headers.empty()) {
+                args.push_back("--recursive");
+            }
+        }
+        for (const auto& includePath : project.includePaths) {
+            args.insert(args.end(), {"-I", includePath});
+        }
+        if (!macroFlags.empty()) {
+            args.insert(args.end(), {"--macro-flags", macroFlags});
+        }
+        if (!lang.empty()) {
+            args.insert(args.end(), {"--lang", lang});
+        }
+        std::vector<const char*> runArgv{argv[0]};
+        for (const auto& arg : args) {
+            runArgv.push_back(arg.c_str());
+        }
+
+        armor::user_print() << "Project " << project.name << " : " << project.root1 << " -> " << project.root2 << "\n";
+        // false also when the run found incompatible changes, which the summary report shows
+        runArmorTool(static_cast<int>(runArgv.size()), runArgv.data());
+        try {
+            if (merged.addRun(root) == 0) {
+                armor::user_error() << "Project " << project.name << " wrote no reports\n";
+                complete = false;
+            }
+        } catch (const std::exception& e) {
+            armor::user_error() << e.what() << "\n";
+            return false;
+        }
+    }
+
+    // The runs logged under their own roots
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+    if (merged.reportCount() == 0) {
+        armor::user_error() << "No project wrote a report\n";
+        return false;
+    }
+    try {
+        merged.write(outputs);
+    } catch (const std::exception& e) {
+        armor::user_error() << "Failed to write the summary report : " << e.what() << "\n";
+        return false;
+    }
+    armor::user_print() << "Summary of " << merged.reportCount() << " reports of " << projects.size() << " projects : "
+                        << outputs.summaryHtmlFile() << " and " << outputs.summaryJsonFile() << "\n";
+    return complete && !merged.hasBackwardIncompatible() && !merged.getGroups().hasBackwardIncompatible();
+}
@@ -0,0 +1,64 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+
+#include "merge.hpp"
+#include "logger.hpp"
+#include "output_paths.hpp"
+#include "report_merge.hpp"
+#include "subcommand.hpp"
+
+bool armor::isMergeInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "merge";
+}
+
+bool armor::runArmorMerge(int argc, const char** argv) {
+    CLI::App app{"ARMOR merge"};
+    std::vector<std::string> runDirs;
+    std::string outputDir;
+    app.add_option("rundirs", runDirs, "Output directories of the runs to combine, e.g. one per --shard")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    app.add_option("--output-dir", outputDir,
+        "Directory receiving armor_reports/summary_report.{html,json} (default: the working directory)");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::OutputPaths outputs{outputDir};
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+    armor::MergedReports merged;
+    try {
+        for (const auto& runDir : runDirs) {
+            if (merged.addRun(runDir) == 0) {
+                armor::user_error() << "No JSON reports found in " << runDir
+                                    << "; was it run with -r json, cbor or msgpack?\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+    if (merged.reportCount() == 0) {
+        armor::user_error() << "Nothing to merge\n";
+        return false;
+    }
+
+    try {
+        merged.write(outputs);
+    } catch (const std::exception& e) {
+        armor::user_error() << "Failed to write the merged report : " << e.what() << "\n";
+        return false;
+    }
+    armor::user_print() << "Merged " << merged.reportCount() << " reports of " << runDirs.size() << " runs into "
+                        << outputs.summaryHtmlFile() << " and " << outputs.summaryJsonFile() << "\n";
+    return true;
+}
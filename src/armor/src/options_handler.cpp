@@ -4,20 +4,77 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <functional>
+#include <fstream>
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+#include <utility>
 #include "CLI/CLI.hpp"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Support/raw_ostream.h"
 #include "comm_def.hpp"
+#include "categorization.hpp"
 #include "options_handler.hpp"
 
 #include <session.hpp>
 
 #include "alpha/include/header_processor.hpp"
 #include "beta/include/header_processor.hpp"
+#include "beta/include/decl_subtree_cache.hpp"
+#include "beta/include/diffengine.hpp"
+#include "single_pass.hpp"
+#include "report_generator.hpp"
 #include "report_utils.hpp"
+#include "result_cache.hpp"
+#include "cache_directory.hpp"
+#include "result_history.hpp"
+#include "baseline_findings.hpp"
 #include "diff_utils.hpp"
 #include "logger.hpp"
+#include "file_compare.hpp"
+#include "work_pool.hpp"
+#include "precompiled_header.hpp"
+#include "changed_ranges.hpp"
+#include "conditional_block_index.hpp"
+#include "api_filter.hpp"
+#include "profiler.hpp"
+#include "stack_sampler.hpp"
+#include "clang_tool_runner.hpp"
+#include "file_cache.hpp"
+#include "git_tree.hpp"
+#include "output_paths.hpp"
+#include "output_writer.hpp"
+#include "remote_cache.hpp"
+#include "include_graph.hpp"
+#include "include_prefetch.hpp"
+#include "compile_flags.hpp"
+#include "header_costs.hpp"
+#include "digest_manifest.hpp"
+#include "gate_verdict.hpp"
+#include "header_selection.hpp"
+#include "process_pool.hpp"
+#include "file_watch.hpp"
+#include "context_cache.hpp"
+#include "event_stream.hpp"
+#include "repro_bundle.hpp"
+#include "subtree_summary.hpp"
+#include "resource_limits.hpp"
+#include "lexical_edit.hpp"
+#include "simd_dispatch.hpp"
+#include "declaration_segments.hpp"
+#include "metrics.hpp"
 
 #ifndef TOOL_VERSION
 #define TOOL_VERSION ""
@@ -38,293 +95,2420 @@ LANG_OPTIONS stringToLangOption(const std::string& lang) {
 }
 
 bool filesAreDifferentUsingDiff(const std::string &file1, const std::string &file2) {
-    std::string command = "diff -q " + file1 + " " + file2 + " > /dev/null";
-    return std::system(command.c_str()) != 0;
+    return armor::filesDiffer(file1, file2);
+}
+
+namespace {
+
+    enum class PairOutcome {
+        PROCESSED,
+        // Reported from the --history entry of the same inputs
+        FROM_HISTORY,
+        // Reported from the --result-cache entry of the same inputs and includes
+        FROM_RESULT_CACHE,
+        IDENTICAL,
+        MISSING,
+        FAILED,
+        // Reported from the comparison of a byte-identical copy at another path (--dedup-headers)
+        ALIASED,
+        // Reported unparsed, as the versions only differ in comments or whitespace
+        LEXICAL
+    };
+
+    // As --events names it
+    const char* outcomeName(PairOutcome outcome) {
+        switch (outcome) {
+            case PairOutcome::PROCESSED:    return "processed";
+            case PairOutcome::FROM_HISTORY: return "from_history";
+            case PairOutcome::FROM_RESULT_CACHE: return "from_result_cache";
+            case PairOutcome::IDENTICAL:    return "identical";
+            case PairOutcome::MISSING:      return "missing";
+            case PairOutcome::FAILED:       return "failed";
+            case PairOutcome::ALIASED:      return "aliased";
+            case PairOutcome::LEXICAL:      return "lexical";
+        }
+        return "unknown";
+    }
+
+    struct HeaderPairTask {
+        std::string file1;
+        std::string file2;
+    };
+
+    // Where the two versions are read from: disk, or two mounted git revisions
+    struct VersionSources {
+        std::shared_ptr<const armor::GitRevisionTree> tree1;
+        std::shared_ptr<const armor::GitRevisionTree> tree2;
+
+        bool exists(const std::string& file, bool newer) const {
+            const armor::GitRevisionTree* tree = newer ? tree2.get() : tree1.get();
+            if (!tree) {
+                return std::filesystem::exists(file);
+            }
+            const armor::GitRevisionTree::Entry* entry = tree->lookup(file);
+            return entry && !entry->isDirectory;
+        }
+
+        bool differ(const std::string& file1, const std::string& file2) const {
+            if (!tree1) {
+                return filesAreDifferentUsingDiff(file1, file2);
+            }
+            // Equal blob ids are equal contents, without reading either
+            return tree1->lookup(file1)->oid != tree2->lookup(file2)->oid;
+        }
+
+        // Hash of the contents of an existing version of a header
+        bool hash(const std::string& file, bool newer, uint64_t& contentHash) const {
+            const armor::GitRevisionTree* tree = newer ? tree2.get() : tree1.get();
+            if (tree) {
+                contentHash = llvm::xxHash64(tree->readFile(*tree->lookup(file)));
+                return true;
+            }
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(file);
+            if (!buffer) {
+                return false;
+            }
+            contentHash = llvm::xxHash64((*buffer)->getBuffer());
+            return true;
+        }
+
+        // Contents of an existing version of a header
+        bool read(const std::string& file, bool newer, std::string& contents) const {
+            const armor::GitRevisionTree* tree = newer ? tree2.get() : tree1.get();
+            if (tree) {
+                contents = tree->readFile(*tree->lookup(file)).str();
+                return true;
+            }
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(file);
+            if (!buffer) {
+                return false;
+            }
+            contents = (*buffer)->getBuffer().str();
+            return true;
+        }
+    };
+
+    // Where a project root given inside a revision appears under its mount point
+    std::string mountedRoot(const armor::GitRevisionTree& tree, const std::string& root) {
+        std::string mounted = (std::filesystem::path(tree.getMountPoint()) / root).lexically_normal().string();
+        if (mounted.size() > 1 && mounted.back() == '/') {
+            mounted.pop_back();
+        }
+        return mounted;
+    }
+
+    struct RunOptions {
+        std::string projectRoot1;
+        std::string projectRoot2;
+        std::string reportFormat;
+        std::vector<std::string> includePaths;
+        std::vector<std::string> macros;
+        LANG_OPTIONS lang;
+        bool dumpAstDiff;
+        bool verdictOnly;
+        std::string cacheDir;
+        std::shared_ptr<armor::RemoteCache> remoteCache;
+        armor::PrecompiledHeaderCache* pchCache;
+        const armor::ChangedRanges* changedRanges;
+        const armor::ApiFilter* apiFilter;
+        PARSE_MODE parseMode;
+        bool skipForeignBodies;
+        const VersionSources* sources;
+        armor::OutputPaths outputs;
+        // Threads each pair's beta diff may use, from the workers the pairs leave idle
+        unsigned diffJobs = 1;
+        // Results of earlier runs (--history, --result-cache), and the options of this run shaping a result
+        const armor::ResultHistory* history = nullptr;
+        const armor::ResultCache* resultCache = nullptr;
+        std::string resultKey;
+        // Digests of the older version's headers written by an earlier run (--base-manifest)
+        const armor::DigestManifest* baseManifest = nullptr;
+    };
+
+    // Header path relative to the project root, as the reports name it
+    std::string reportedHeader(const HeaderPairTask& task, const std::string& projectRoot1) {
+        return std::filesystem::relative(task.file1, projectRoot1).string();
+    }
+
+    void reportMissingHeader(const std::string& presentFile, bool olderMissing, const std::string& reportedName,
+                             const RunOptions& opts) {
+        const char* compatibility = olderMissing ? "backward_compatible" : "backward_incompatible";
+        const char* overallStatus = olderMissing ? "BACKWARD_COMPATIBLE" : "BACKWARD_INCOMPATIBLE";
+        const char* reason = olderMissing ? "Missing header in older version" : "Missing header in newer version";
+        ReportSummaries::getInstance().record(reportedName, {overallStatus, {}});
+        if (opts.verdictOnly) {
+            return;
+        }
+        std::string headerName = std::filesystem::path(presentFile).filename().string();
+        const auto& [jsonReportFile, htmlReportFile] =
+            prepare_report_output_dirs(headerName, opts.outputs, armor::reportFormatOf(opts.reportFormat));
+        CombinedHtmlReport& combined = CombinedHtmlReport::getInstance();
+        if (combined.isOpen()) {
+            combined.addMissingHeader(reportedName, overallStatus, reason);
+        }
+        generate_json_report(
+                ApiChangeGroups(reportedName),
+                  jsonReportFile,
+                  static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                  static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                  compatibility,
+                  overallStatus,
+                  reason
+                  );
+        if (combined.isOpen()) {
+            return;
+        }
+        generate_html_report(
+            ApiChangeGroups(reportedName),
+                  htmlReportFile,
+                  NO_PARSER,
+                  static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                  static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                  compatibility,
+                  overallStatus,
+                  reason,
+                  {!olderMissing, olderMissing}
+                );
+    }
+
+    // Whether the headers a byte-identical pair includes are identical too, from the include
+    // records of an earlier clean parse of either version
+    bool includesUnchanged(const HeaderPairTask& task, const RunOptions& opts) {
+        armor::IncludeGraph includeGraph(opts.cacheDir);
+        std::vector<std::string> flags1 =
+            armor::buildCompileFlags(opts.projectRoot1, task.file1, opts.includePaths, opts.macros, opts.lang);
+        if (includeGraph.closureUnchanged(task.file1, flags1, opts.projectRoot1, opts.projectRoot2)) {
+            return true;
+        }
+        std::vector<std::string> flags2 =
+            armor::buildCompileFlags(opts.projectRoot2, task.file2, opts.includePaths, opts.macros, opts.lang);
+        return includeGraph.closureUnchanged(task.file2, flags2, opts.projectRoot2, opts.projectRoot1);
+    }
+
+    // The --base-manifest entry of a header, from the newer version: its digest, and the
+    // digest of its include closure when the run tracks includes (--cache-dir)
+    bool manifestEntry(const HeaderPairTask& task, const RunOptions& opts, armor::DigestManifest::Entry& entry) {
+        if (!opts.sources->exists(task.file2, true) || !opts.sources->hash(task.file2, true, entry.digest)) {
+            return false;
+        }
+        if (!opts.cacheDir.empty()) {
+            std::vector<std::string> flags2 =
+                armor::buildCompileFlags(opts.projectRoot2, task.file2, opts.includePaths, opts.macros, opts.lang);
+            entry.hasClosure = armor::IncludeGraph(opts.cacheDir).closureDigest(task.file2, flags2, opts.projectRoot2,
+                                                                                entry.closure);
+        }
+        return true;
+    }
+
+    // Whether the newer version of a header matches the older one as --base-manifest recorded
+    // it; the older version is not read. A run tracking includes also needs both closures known
+    bool unchangedSinceBaseManifest(const HeaderPairTask& task, const RunOptions& opts) {
+        armor::DigestManifest::Entry base;
+        armor::DigestManifest::Entry head;
+        if (!opts.baseManifest->find(reportedHeader(task, opts.projectRoot1), base) ||
+            !manifestEntry(task, opts, head) || head.digest != base.digest) {
+            return false;
+        }
+        return opts.cacheDir.empty() || (base.hasClosure && head.hasClosure && head.closure == base.closure);
+    }
+
+    // Digest of the inputs of a pair's result for --history: both versions of the
+    // header and the options of the run. Empty if a version cannot be read, or
+    // if the versions are identical and only compared for their includes, which
+    // the digest does not cover
+    std::string pairDigest(const HeaderPairTask& task, const RunOptions& opts) {
+        uint64_t hash1 = 0;
+        uint64_t hash2 = 0;
+        if (!opts.sources->hash(task.file1, false, hash1) || !opts.sources->hash(task.file2, true, hash2) ||
+            hash1 == hash2) {
+            return std::string();
+        }
+        std::string material = opts.resultKey;
+        material += reportedHeader(task, opts.projectRoot1);
+        material += '\0';
+        material += llvm::utohexstr(hash1);
+        material += '\0';
+        material += llvm::utohexstr(hash2);
+        return llvm::utohexstr(llvm::xxHash64(material));
+    }
+
+    // Digest of the inputs of a pair's result for --result-cache: both versions' include
+    // closures, header included, as their last clean parses recorded them, and the options
+    // of the run. Empty while either closure is unknown or out of date
+    std::string resultCacheKey(const HeaderPairTask& task, const RunOptions& opts) {
+        armor::IncludeGraph includeGraph(opts.cacheDir);
+        uint64_t closure1 = 0;
+        uint64_t closure2 = 0;
+        std::vector<std::string> flags1 =
+            armor::buildCompileFlags(opts.projectRoot1, task.file1, opts.includePaths, opts.macros, opts.lang);
+        std::vector<std::string> flags2 =
+            armor::buildCompileFlags(opts.projectRoot2, task.file2, opts.includePaths, opts.macros, opts.lang);
+        if (!includeGraph.closureDigest(task.file1, flags1, opts.projectRoot1, closure1) ||
+            !includeGraph.closureDigest(task.file2, flags2, opts.projectRoot2, closure2)) {
+            return std::string();
+        }
+        std::string material = opts.resultKey;
+        material += reportedHeader(task, opts.projectRoot1);
+        material += '\0';
+        material += llvm::utohexstr(closure1);
+        material += '\0';
+        material += llvm::utohexstr(closure2);
+        return llvm::utohexstr(llvm::xxHash64(material));
+    }
+
+    // Writes the reports of a pair from an earlier result of the same inputs
+    void reportFromEntry(const HeaderPairTask& task, const RunOptions& opts, const armor::HistoryEntry& entry,
+                         const char* origin) {
+        std::string header = reportedHeader(task, opts.projectRoot1);
+        armor::user_print() << "Reporting " << header << " from its " << origin << " comparing "
+                            << entry.base << " and " << entry.head << "\n";
+        if (opts.verdictOnly) {
+            bool backwardIncompatible = std::any_of(entry.records.begin(), entry.records.end(),
+                [](const ChangeRecord& record) { return record.backwardIncompatible; });
+            report_verdict(header, entry.parsedStatus, entry.unparsedStatus, backwardIncompatible);
+            return;
+        }
+
+        ApiChangeGroups groups(header);
+        for (const ChangeRecord& record : entry.records) {
+            groups.addRecord(ChangeRecord(record));
+        }
+        std::string headerName = std::filesystem::path(task.file1).filename().string();
+        std::filesystem::create_directories(opts.outputs.htmlReportDir());
+        bool generateJson = opts.reportFormat != "html";
+        std::string jsonReportFile;
+        if (generateJson) {
+            std::filesystem::create_directories(opts.outputs.jsonReportDir());
+            jsonReportFile = opts.outputs.jsonReportFile(headerName, armor::reportFormatOf(opts.reportFormat));
+        }
+        submit_report(std::move(groups), entry.parsedStatus, entry.unparsedStatus,
+                      opts.outputs.htmlReportFile(headerName), jsonReportFile, entry.parser, generateJson);
+    }
+
+    // Reports a pair from its --history entry, or failing that its --result-cache entry.
+    // `digest` is set to the pairDigest of the pair when the run keeps a history
+    PairOutcome reportFromEarlierResult(const HeaderPairTask& task, const RunOptions& opts, std::string& digest) {
+        if (opts.history) {
+            digest = pairDigest(task, opts);
+            const armor::HistoryEntry* entry =
+                digest.empty() ? nullptr : opts.history->find(reportedHeader(task, opts.projectRoot1), digest);
+            if (entry) {
+                reportFromEntry(task, opts, *entry, "history entry");
+                return PairOutcome::FROM_HISTORY;
+            }
+        }
+        if (opts.resultCache) {
+            std::string key = resultCacheKey(task, opts);
+            armor::HistoryEntry entry;
+            bool cached = !key.empty() && opts.resultCache->load(key, entry);
+            armor::Metrics::getInstance().countCache(armor::Metrics::CacheTier::RESULT, cached);
+            if (cached) {
+                reportFromEntry(task, opts, entry, "cached result");
+                return PairOutcome::FROM_RESULT_CACHE;
+            }
+        }
+        return PairOutcome::PROCESSED;
+    }
+
+    // Key of what a pair's result depends on besides the run's options, for --dedup-headers:
+    // both versions' contents and, for a version including other files, the flags resolving
+    // them, which name the header's own directories. Empty for a pair that needs no parse
+    std::string aliasKey(const HeaderPairTask& task, const RunOptions& opts) {
+        std::string contents1;
+        std::string contents2;
+        if (!opts.sources->exists(task.file1, false) || !opts.sources->exists(task.file2, true) ||
+            !opts.sources->read(task.file1, false, contents1) || !opts.sources->read(task.file2, true, contents2) ||
+            contents1 == contents2) {
+            return std::string();
+        }
+        std::string key = llvm::utohexstr(llvm::xxHash64(contents1));
+        key += '\0';
+        key += llvm::utohexstr(llvm::xxHash64(contents2));
+        for (int version = 0; version < 2; ++version) {
+            const std::string& contents = version == 0 ? contents1 : contents2;
+            if (armor::countIncludeDirectives(contents) == 0) {
+                continue;
+            }
+            const std::string& root = version == 0 ? opts.projectRoot1 : opts.projectRoot2;
+            const std::string& file = version == 0 ? task.file1 : task.file2;
+            key += '\1';
+            for (const std::string& flag : armor::buildCompileFlags(root, file, opts.includePaths, opts.macros,
+                                                                    opts.lang)) {
+                key += flag;
+                key += '\0';
+            }
+        }
+        return key;
+    }
+
+    // Reports a pair from the result of `copy`, the pair compared in its place as they share an
+    // aliasKey; `others` names the rest of the group, `copy` included
+    PairOutcome reportFromCopy(const HeaderPairTask& task, const HeaderPairTask& copy, PairOutcome copyOutcome,
+                               const std::vector<std::string>& others, const RunOptions& opts) {
+        std::string header = reportedHeader(task, opts.projectRoot1);
+        std::string copyHeader = reportedHeader(copy, opts.projectRoot1);
+        if (copyOutcome == PairOutcome::IDENTICAL) {
+            armor::user_print() << "No differences found between: " << task.file1 << " and " << task.file2
+                                << ", as for its copy " << copyHeader << "\n";
+            return PairOutcome::IDENTICAL;
+        }
+        ReportSummaries::Summary summary;
+        if (copyOutcome == PairOutcome::FAILED || copyOutcome == PairOutcome::MISSING ||
+            !ReportSummaries::getInstance().find(copyHeader, summary)) {
+            armor::user_error() << "Failed to process " << task.file1 << " : its copy " << copyHeader
+                                << " was not compared\n";
+            return PairOutcome::FAILED;
+        }
+        armor::user_print() << "Reporting " << header << " from its byte-identical copy " << copyHeader << "\n";
+        for (ChangeRecord& record : summary.records) {
+            if (record.headerfile == copyHeader) {
+                record.headerfile = header;
+            }
+        }
+        if (opts.verdictOnly) {
+            ReportSummaries::getInstance().record(header, std::move(summary));
+            return PairOutcome::ALIASED;
+        }
+
+        ApiChangeGroups groups(header);
+        for (ChangeRecord& record : summary.records) {
+            groups.addRecord(std::move(record));
+        }
+        std::string note = "Same contents as";
+        for (const std::string& other : others) {
+            note += (&other == &others.front() ? " " : ", ") + other;
+        }
+        groups.setNote(note + "; compared once for all of them.");
+        std::string headerName = std::filesystem::path(task.file1).filename().string();
+        std::filesystem::create_directories(opts.outputs.htmlReportDir());
+        bool generateJson = opts.reportFormat != "html";
+        std::string jsonReportFile;
+        if (generateJson) {
+            std::filesystem::create_directories(opts.outputs.jsonReportDir());
+            jsonReportFile = opts.outputs.jsonReportFile(headerName, armor::reportFormatOf(opts.reportFormat));
+        }
+        submit_report(std::move(groups), summary.parsedStatus, summary.unparsedStatus,
+                      opts.outputs.htmlReportFile(headerName), jsonReportFile, summary.parser, generateJson);
+        return PairOutcome::ALIASED;
+    }
+
+    // A ReportSummaries entry, as a --isolate worker hands it back
+    nlohmann::json summaryToJson(const ReportSummaries::Summary& summary) {
+        nlohmann::json records = nlohmann::json::array();
+        for (const ChangeRecord& record : summary.records) {
+            records.push_back(record.toJson());
+        }
+        return {{"overall_status",  summary.overallStatus},
+                {"api_names",       summary.apiNames},
+                {"parsed_status",   summary.parsedStatus},
+                {"unparsed_status", summary.unparsedStatus},
+                {"parser",          static_cast<int>(summary.parser)},
+                {"records",         std::move(records)}};
+    }
+
+    ReportSummaries::Summary summaryFromJson(const nlohmann::json& summaryJson) {
+        ReportSummaries::Summary summary;
+        summary.overallStatus = summaryJson.at("overall_status").get<std::string>();
+        summary.apiNames = summaryJson.at("api_names").get<std::vector<std::string>>();
+        summary.parsedStatus = summaryJson.at("parsed_status").get<int>();
+        summary.unparsedStatus = summaryJson.at("unparsed_status").get<int>();
+        summary.parser = static_cast<PARSER>(summaryJson.at("parser").get<int>());
+        for (const nlohmann::json& record : summaryJson.at("records")) {
+            summary.records.push_back(ChangeRecord::fromJson(record));
+        }
+        return summary;
+    }
+
+    // The headers of a --headers-from or --blocking-headers file, one per line; blank lines are skipped
+    std::vector<std::string> readHeaderList(const std::string& path) {
+        std::vector<std::string> headers;
+        std::ifstream list(path);
+        std::string line;
+        while (std::getline(list, line)) {
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos) {
+                continue;
+            }
+            size_t last = line.find_last_not_of(" \t\r");
+            headers.push_back(line.substr(first, last - first + 1));
+        }
+        return headers;
+    }
+
+    // `i/N` of --shard
+    bool parseShard(llvm::StringRef spec, unsigned& index, unsigned& count) {
+        auto [indexText, countText] = spec.split('/');
+        return !indexText.getAsInteger(10, index) && !countText.getAsInteger(10, count) && count > 0 && index < count;
+    }
+
+    // Share of the cgroup memory limit --max-memory auto budgets for, leaving room for report rendering
+    constexpr double AUTO_MEMORY_SHARE = 0.8;
+
+    // "<MiB>" or "auto", the cgroup's limit; an empty spec and a missing limit are 0, no limit
+    bool parseMaxMemory(llvm::StringRef spec, std::size_t& bytes) {
+        if (spec.empty()) {
+            bytes = 0;
+            return true;
+        }
+        if (spec.equals_insensitive("auto")) {
+            bytes = static_cast<std::size_t>(static_cast<double>(armor::cgroupMemoryLimit()) * AUTO_MEMORY_SHARE);
+            return true;
+        }
+        unsigned mebibytes = 0;
+        if (spec.getAsInteger(10, mebibytes)) {
+            return false;
+        }
+        bytes = std::size_t(mebibytes) << 20;
+        return true;
+    }
+
+    // Estimated cost of comparing a pair, from the newer version, or the older if it is missing
+    double estimatePairCost(const HeaderPairTask& task, const VersionSources& sources) {
+        bool newer = sources.exists(task.file2, true);
+        const std::string& file = newer ? task.file2 : task.file1;
+        const armor::GitRevisionTree* tree = newer ? sources.tree2.get() : sources.tree1.get();
+        if (tree) {
+            // Blobs are not read just for an estimate; the size is in the listing
+            const armor::GitRevisionTree::Entry* entry = tree->lookup(file);
+            return entry ? armor::estimateHeaderCost(entry->size, 0) : 0;
+        }
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(file);
+        if (!buffer) {
+            return 0;
+        }
+        return armor::estimateHeaderCost((*buffer)->getBufferSize(),
+                                         armor::countIncludeDirectives((*buffer)->getBuffer()));
+    }
+
+    // Reports a pair whose versions lex to the same tokens, without parsing either: a parse would
+    // only find comments or whitespace changed. PROCESSED if the pair needs the parse after all
+    PairOutcome reportLexicalEdit(const HeaderPairTask& task, const RunOptions& opts) {
+        // The AST dump needs the parse, a filter reports the comments of what it keeps only, and
+        // a changed include closure may change what the same tokens declare
+        if (opts.dumpAstDiff || opts.apiFilter || (!opts.cacheDir.empty() && !includesUnchanged(task, opts))) {
+            return PairOutcome::PROCESSED;
+        }
+        std::string text1;
+        std::string text2;
+        if (!opts.sources->read(task.file1, false, text1) || !opts.sources->read(task.file2, true, text2)) {
+            return PairOutcome::PROCESSED;
+        }
+        armor::LexicalEdit edit = armor::classifyLexicalEdit(text1, text2);
+        if (edit == armor::LexicalEdit::TOKENS) {
+            return PairOutcome::PROCESSED;
+        }
+        bool comments = edit == armor::LexicalEdit::COMMENTS;
+        armor::user_print() << "Only " << (comments ? "comments" : "whitespace") << " changed between: "
+                            << task.file1 << " and " << task.file2 << ", reported without parsing\n";
+        int parsedStatus = static_cast<int>(comments ? ParsedDiffStatus::COMMENTS_UPDATED
+                                                     : ParsedDiffStatus::NON_FUNCTIONAL_CHANGES);
+        int unparsedStatus = static_cast<int>(UnParsedDiffStatus::UN_CHANGED);
+        std::string header = reportedHeader(task, opts.projectRoot1);
+        if (opts.verdictOnly) {
+            report_verdict(header, parsedStatus, unparsedStatus, false);
+            return PairOutcome::LEXICAL;
+        }
+
+        std::string headerName = std::filesystem::path(task.file1).filename().string();
+        std::filesystem::create_directories(opts.outputs.htmlReportDir());
+        bool generateJson = opts.reportFormat != "html";
+        std::string jsonReportFile;
+        if (generateJson) {
+            std::filesystem::create_directories(opts.outputs.jsonReportDir());
+            jsonReportFile = opts.outputs.jsonReportFile(headerName, armor::reportFormatOf(opts.reportFormat));
+        }
+        submit_report(ApiChangeGroups(header), parsedStatus, unparsedStatus, opts.outputs.htmlReportFile(headerName),
+                      jsonReportFile, BETA_PARSER, generateJson);
+        return PairOutcome::LEXICAL;
+    }
+
+    nlohmann::json segmentsToJson(const std::vector<armor::DeclarationSegment>& segments) {
+        nlohmann::json result = nlohmann::json::array();
+        for (const armor::DeclarationSegment& segment : segments) {
+            result.push_back({{"name", segment.name}, {"kind", segment.kind}, {"line", segment.line}});
+        }
+        return result;
+    }
+
+    // --quick: compares the top-level declarations of each pair by their tokens alone and prints
+    // one JSON line per changed header; false if any header removed or modified a declaration
+    bool runQuickComparison(const std::vector<HeaderPairTask>& tasks, const VersionSources& sources,
+                            const std::string& projectRoot1) {
+        bool compatible = true;
+        std::vector<std::string> touched;
+        for (const auto& task : tasks) {
+            std::string header = reportedHeader(task, projectRoot1);
+            // A missing version declares nothing
+            std::string text1;
+            std::string text2;
+            bool exists1 = sources.exists(task.file1, false) && sources.read(task.file1, false, text1);
+            bool exists2 = sources.exists(task.file2, true) && sources.read(task.file2, true, text2);
+            if (!exists1 && !exists2) {
+                armor::user_error() << "Header missing in both versions: " << header << "\n";
+                compatible = false;
+                continue;
+            }
+            if (exists1 && exists2 && text1 == text2) {
+                continue;
+            }
+            armor::QuickDiff diff = armor::quickDiff(text1, text2);
+            if (diff.added.empty() && diff.removed.empty() && diff.modified.empty()) {
+                continue;
+            }
+            touched.push_back(header);
+            compatible &= diff.removed.empty() && diff.modified.empty();
+            armor::user_print() << nlohmann::json{{"header", header},
+                                                  {"approximate", true},
+                                                  {"added", segmentsToJson(diff.added)},
+                                                  {"removed", segmentsToJson(diff.removed)},
+                                                  {"modified", segmentsToJson(diff.modified)}}.dump() << "\n";
+        }
+        armor::user_print() << nlohmann::json{{"approximate", true},
+                                              {"headers", tasks.size()},
+                                              {"touched", touched}}.dump() << "\n";
+        return compatible;
+    }
+
+    // Settles pairs that need no parsing; PROCESSED means both versions exist and differ
+    PairOutcome triageHeaderPair(const HeaderPairTask& task, const RunOptions& opts) {
+        const std::string& file1 = task.file1;
+        const std::string& file2 = task.file2;
+        const VersionSources& sources = *opts.sources;
+        armor::user_print() << "Processing files: " << file1 << " " << file2 << "\n";
+        if (opts.baseManifest && unchangedSinceBaseManifest(task, opts)) {
+            armor::user_print() << "No differences found between: " << file1 << " and " << file2
+                                << ", per the digests of --base-manifest\n";
+            return PairOutcome::IDENTICAL;
+        }
+        bool file1Exists = sources.exists(file1, false);
+        bool file2Exists = sources.exists(file2, true);
+        if (!file1Exists && !file2Exists) {
+            armor::user_error() << "Missing old and new versions of header : \n" << file1 << "\n" << file2 << "\n";
+            if (!opts.verdictOnly) {
+                std::filesystem::create_directories(opts.outputs.htmlReportDir());
+                std::filesystem::create_directories(opts.outputs.jsonReportDir());
+            }
+            return PairOutcome::MISSING;
+        }
+        if (!file1Exists) {
+            armor::user_error() << "Missing header in older version: " << file1 << "\n";
+            reportMissingHeader(file2, true, reportedHeader(task, opts.projectRoot1), opts);
+            return PairOutcome::MISSING;
+        }
+        if (!file2Exists) {
+            armor::user_error() << "Missing header in newer version: " << file2 << "\n";
+            reportMissingHeader(file1, false, reportedHeader(task, opts.projectRoot1), opts);
+            return PairOutcome::MISSING;
+        }
+        if (!sources.differ(file1, file2)) {
+            if (!opts.cacheDir.empty() && !includesUnchanged(task, opts)) {
+                armor::user_print() << "No differences found between: " << file1 << " and " << file2
+                                    << ", but its includes changed or are not known yet\n";
+                return PairOutcome::PROCESSED;
+            }
+            armor::user_print() << "No differences found between: " << file1 << " and " << file2 << "\n";
+            return PairOutcome::IDENTICAL;
+        }
+        return reportLexicalEdit(task, opts);
+    }
+
+    // `digest` is set to the pairDigest of a compared pair when the run keeps a history
+    PairOutcome processHeaderPair(const HeaderPairTask& task, const RunOptions& opts, std::string& digest) {
+        PairOutcome outcome = triageHeaderPair(task, opts);
+        if (outcome != PairOutcome::PROCESSED) {
+            return outcome;
+        }
+        outcome = reportFromEarlierResult(task, opts, digest);
+        if (outcome != PairOutcome::PROCESSED) {
+            return outcome;
+        }
+
+        const std::string& file1 = task.file1;
+        const std::string& file2 = task.file2;
+
+        // One frontend run per version feeds both the alpha and beta normalizers
+        armor::processHeaderPairSinglePass(opts.projectRoot1, file1, opts.projectRoot2, file2,
+                        opts.reportFormat, opts.includePaths, opts.macros, opts.lang, opts.dumpAstDiff,
+                        opts.verdictOnly, opts.cacheDir, opts.remoteCache, opts.pchCache, opts.changedRanges, opts.apiFilter, opts.parseMode,
+                        opts.skipForeignBodies, opts.diffJobs, opts.outputs);
+        return PairOutcome::PROCESSED;
+    }
+
+
+    // The header pairs to compare: the headers arguments, or the headers of --header-dir
+    struct HeaderSelection {
+        std::vector<std::string> headers;
+        std::string headersFrom;
+        std::string headerSubDir;
+        bool recursive = false;
+        std::vector<std::string> headerExtensions = {".h", ".hpp"};
+        std::vector<std::string> ignorePatterns;
+    };
+
+    void addHeaderSelectionOptions(CLI::App& app, HeaderSelection& options) {
+        app.add_option("headers", options.headers,
+            "List of header files to compare between the two versions.\n"
+            "\n"
+            "Header path interpretation depends on whether --header-dir is provided:\n"
+            "\n"
+            "  With --header-dir:\n"
+            "      Headers are treated as basenames (e.g., \"foo.h\") under the specified subdirectory.\n"
+            "      Example:\n"
+            "        --header-dir include/api foo.h bar.hpp\n"
+            "\n"
+            "  • Without --header-dir:\n"
+            "      Headers must be relative paths from the project root.\n"
+            "      Example:\n"
+            "        include/api/foo.h include/api/bar.hpp\n"
+        );
+        CLI::Option* headerDirOption = app.add_option("--header-dir", options.headerSubDir,
+            "Subdirectory under each project root containing headers");
+        CLI::Option* recursiveFlag = app.add_flag("--recursive", options.recursive,
+            "With --header-dir and no headers given, compare the headers of every subdirectory too,\n"
+            "found by one parallel walk of both versions. Headers only in the newer version are\n"
+            "reported as added, those only in the older one as removed.")
+            ->needs(headerDirOption);
+        app.add_option("--header-ext", options.headerExtensions,
+            "With --recursive, endings of the files compared as headers (default: .h .hpp)")
+            ->needs(recursiveFlag);
+        app.add_option("--ignore", options.ignorePatterns,
+            "With --recursive, leave out headers and directories whose path under --header-dir,\n"
+            "or whose name, matches this glob, e.g. --ignore 'detail' --ignore '*_generated.h'")
+            ->needs(recursiveFlag);
+        app.add_option("--headers-from", options.headersFrom,
+            "File listing headers to compare, one per line, read like the headers arguments.\n"
+            "Blank lines are skipped. Lets one run compare every header of a change.")
+            ->check(CLI::ExistingFile);
+    }
+
+    // The pairs of the headers given, or else of the headers under --header-dir
+    bool selectHeaderPairs(const HeaderSelection& selection, const std::string& projectRoot1,
+                           const std::string& projectRoot2, const VersionSources& sources, unsigned jobs,
+                           std::vector<HeaderPairTask>& tasks) {
+        if (!selection.headers.empty()) {
+            for (const auto &header : selection.headers) {
+                if (!selection.headerSubDir.empty()) {
+                    tasks.push_back({projectRoot1 + "/" + selection.headerSubDir + "/" + header,
+                                     projectRoot2 + "/" + selection.headerSubDir + "/" + header});
+                }
+                else {
+                    tasks.push_back({projectRoot1 + "/" + header, projectRoot2 + "/" + header});
+                }
+            }
+            return true;
+        }
+        if (selection.headerSubDir.empty()) {
+            return true;
+        }
+        std::string dir1 = projectRoot1 + "/" + selection.headerSubDir;
+        std::string dir2 = projectRoot2 + "/" + selection.headerSubDir;
+        std::vector<std::string> headersToCompare;
+        auto isHeader = [](const std::filesystem::path& path) {
+            return path.extension() == ".h" || path.extension() == ".hpp";
+        };
+        if (selection.recursive) {
+            armor::HeaderDiscovery discovery;
+            try {
+                discovery = armor::discoverHeaderPairs(dir1, dir2, selection.headerExtensions,
+                                                       selection.ignorePatterns, armor::resolveJobCount(jobs));
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+            armor::user_print() << discovery.common.size() << " headers in both versions, "
+                                << discovery.added.size() << " added, " << discovery.removed.size() << " removed\n";
+            // The pairs missing a version are reported as such by the triage
+            for (const std::vector<std::string>* list : {&discovery.common, &discovery.removed, &discovery.added}) {
+                headersToCompare.insert(headersToCompare.end(), list->begin(), list->end());
+            }
+        }
+        else if (sources.tree1) {
+            for (const auto &name : sources.tree1->listFiles(dir1)) {
+                if (isHeader(name)) {
+                    headersToCompare.push_back(name);
+                }
+            }
+        }
+        else {
+            for (const auto &entry : std::filesystem::directory_iterator(dir1)) {
+                if (isHeader(entry.path())) {
+                    headersToCompare.push_back(entry.path().filename().string());
+                }
+            }
+        }
+        armor::user_print() << "List of headers to process:\n";
+        for (const auto &h : headersToCompare) {
+            armor::user_print() << "  " << h << "\n";
+            tasks.push_back({dir1 + "/" + h, dir2 + "/" + h});
+        }
+        return true;
+    }
+
+    // --blocking-headers and where its gate verdict goes
+    struct GateOptions {
+        std::string blockingHeadersFile;
+        std::string gateOut;
+    };
+
+    void addGateOptions(CLI::App& app, GateOptions& options) {
+        CLI::Option* blockingHeadersOption = app.add_option("--blocking-headers", options.blockingHeadersFile,
+            "File listing the headers that gate a change, one per line as the reports name them, e.g.\n"
+            "blocking_headers_final.txt. They are compared first, on every worker, and the run prints the\n"
+            "gate verdict of them as soon as they are done, then goes on with the other headers.")
+            ->check(CLI::ExistingFile);
+        app.add_option("--gate-out", options.gateOut,
+            "Also write the gate verdict of --blocking-headers to this file, once they are done:\n"
+            "  {\"backward_incompatible\": false, \"blocking_headers\": 12, \"headers\": [], \"failed\": []}")
+            ->needs(blockingHeadersOption);
+    }
+
+    // Marks the pairs of the headers `path` lists as blocking; returns how many are
+    std::size_t markBlockingPairs(const std::string& path, const std::vector<HeaderPairTask>& tasks,
+                                  const std::string& projectRoot1, std::vector<char>& blocking) {
+        std::vector<std::string> listed = readHeaderList(path);
+        std::set<std::string> blockingHeaders(listed.begin(), listed.end());
+        std::size_t blockingCount = 0;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            blocking[i] = blockingHeaders.count(reportedHeader(tasks[i], projectRoot1)) > 0;
+            blockingCount += blocking[i];
+        }
+        armor::info() << blockingCount << " of " << tasks.size() << " header pairs are blocking\n";
+        return blockingCount;
+    }
+
+    // Of the blocking pairs and their aliases, all settled
+    void emitGateVerdict(const std::vector<HeaderPairTask>& tasks, const std::vector<char>& blocking,
+                         std::size_t blockingCount, const std::vector<PairOutcome>& outcomes,
+                         const std::string& projectRoot1, const std::string& gateOut) {
+        std::vector<armor::GateHeader> headers;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            armor::GateHeader gateHeader;
+            gateHeader.header = reportedHeader(tasks[i], projectRoot1);
+            gateHeader.blocking = blocking[i];
+            ReportSummaries::Summary summary;
+            gateHeader.backwardIncompatible = ReportSummaries::getInstance().find(gateHeader.header, summary) &&
+                summary.overallStatus == serialize(OverAllStatus::BACKWARD_INCOMPATIBLE);
+            gateHeader.failed = outcomes[i] == PairOutcome::FAILED;
+            headers.push_back(std::move(gateHeader));
+        }
+        armor::GateVerdict gateVerdict = armor::decideGateVerdict(headers);
+        nlohmann::json verdict = gateVerdict.toJson();
+        armor::user_print() << "Gate verdict of " << blockingCount << " blocking headers ("
+                            << (gateVerdict.exitCode() == 0 ? "passes" : "fails") << "): " << verdict.dump() << "\n";
+        armor::EventStream::getInstance().emit("gate_verdict", verdict);
+        if (gateOut.empty()) {
+            return;
+        }
+        // Written next to the file and renamed, so a reader polling for it never sees a partial one
+        std::string tempPath = gateOut + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::trunc);
+            out << verdict.dump() << "\n";
+            if (!out) {
+                armor::user_error() << "Failed to write " << gateOut << "\n";
+                return;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tempPath, gateOut, ec);
+        if (ec) {
+            std::filesystem::remove(tempPath, ec);
+            armor::user_error() << "Failed to write " << gateOut << "\n";
+        }
+    }
+
+    // What a run writes, and how
+    struct ReportOptions {
+        std::string reportFormat = "html";
+        std::string ndjsonOut;
+        bool combinedReport = false;
+        std::string htmlMode = "table";
+        bool dumpAstDiff = false;
+        bool compressDebugOutput = false;
+        bool verdictOnly = false;
+        bool quick = false;
+        unsigned renderJobs = 0;
+        bool asyncOutput = false;
+        std::string outputDir;
+        std::string logFile;
+    };
+
+    void addReportOptions(CLI::App& app, ReportOptions& options) {
+        app.add_option("--ndjson-out", options.ndjsonOut,
+            "Write one JSON line per compared header, in the order given:\n"
+            "  {\"header\": \"include/foo.h\", \"api_names\": [...], \"compatibility\": \"BACKWARD_COMPATIBLE\"}\n"
+            "compatibility is the overall status of the header's report, or Unknown if none was written.");
+        app.add_option("--report-format,-r", options.reportFormat, "Report format: html (default).\n"
+                                                                   "If json is provided, both html and json reports will be generated.\n"
+                                                                   "cbor and msgpack write the JSON report, and the --dump-ast-diff\n"
+                                                                   "files, in that binary encoding instead.")
+            ->check(CLI::IsMember({"html", "json", "cbor", "msgpack"}));
+        CLI::Option* combinedReportFlag = app.add_flag("--combined-report", options.combinedReport,
+            "Write one armor_reports/api_diff_report.html with an index of every header's status\n"
+            "and a section per header, instead of one HTML file per header. JSON reports are unchanged.");
+        CLI::Option* htmlModeOption = app.add_option("--html-mode", options.htmlMode,
+            "How HTML reports hold their rows: table (default), lazy or auto.\n"
+            "lazy embeds the rows as compact, compressed JSON that the page renders as they scroll into\n"
+            "view and filters in the browser; auto does so for headers with 10000 or more changed APIs.\n"
+            "--combined-report sections always use table.")
+            ->check(CLI::IsMember({"table", "lazy", "auto"}));
+        CLI::Option* dumpAstDiffFlag = app.add_flag("--dump-ast-diff", options.dumpAstDiff,
+                                                    "Dump AST diff JSON files for debugging");
+        app.add_flag("--compress-debug-output", options.compressDebugOutput,
+            "Write the --dump-ast-diff files and the diagnostics log gzip-compressed, with .gz appended to their names");
+        app.add_flag("--verdict-only", options.verdictOnly,
+            "Only decide whether any header changed backward incompatibly, for CI gating.\n"
+            "Each diff stops at its first incompatible change and no reports are written; the\n"
+            "run prints one JSON line and exits non-zero if any header is backward incompatible.")
+            ->excludes(dumpAstDiffFlag)
+            ->excludes(combinedReportFlag)
+            ->excludes(htmlModeOption);
+        app.add_flag("--quick", options.quick,
+            "Approximate pre-commit check: cut both versions of each header into top-level declarations by\n"
+            "their braces and semicolons, without preprocessing or parsing, and print one JSON line per header\n"
+            "naming the declarations added, removed or modified. Exits non-zero if any was removed or modified.\n"
+            "Macros can hide or fake declarations, so a run without --quick remains the authoritative check.")
+            ->excludes(dumpAstDiffFlag)
+            ->excludes(combinedReportFlag)
+            ->excludes(htmlModeOption);
+        app.add_option("--render-jobs", options.renderJobs,
+            "Threads writing the reports, fed by the jobs comparing headers through a bounded queue,\n"
+            "so parsing never waits on report I/O (default 0: each job writes its own reports).");
+        app.add_flag("--async-output", options.asyncOutput,
+            "Write report and AST diff files on a background thread: jobs hand over finished files\n"
+            "and go on, and directories are created once rather than per file.");
+        app.add_option("--output-dir", options.outputDir,
+            "Directory receiving armor_reports/ and debug_output/ (default: the working directory).\n"
+            "Runs with distinct output directories can share a working directory.");
+        app.add_option("--log-file", options.logFile,
+            "Diagnostics log of the run (default: debug_output/logs/diagnostics.log under --output-dir)");
+    }
+
+    // --ndjson-out: one line per pair, in the order given; false if the file could not be written
+    bool writeNdjson(const std::string& path, const std::vector<HeaderPairTask>& tasks, const std::string& projectRoot1) {
+        std::ofstream out(path, std::ios::trunc);
+        for (const auto& task : tasks) {
+            std::string header = reportedHeader(task, projectRoot1);
+            ReportSummaries::Summary summary;
+            if (!ReportSummaries::getInstance().find(header, summary)) {
+                summary.overallStatus = "Unknown";
+            }
+            out << nlohmann::json{{"header", header},
+                                  {"api_names", summary.apiNames},
+                                  {"compatibility", summary.overallStatus}}.dump() << "\n";
+        }
+        if (!out) {
+            armor::user_error() << "Failed to write " << path << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    // --verdict-only: prints the backward incompatible headers; a header missing from the newer
+    // version counts, as its report would say. True if there is any
+    bool printVerdict(const std::vector<HeaderPairTask>& tasks, const std::string& projectRoot1) {
+        std::vector<std::string> incompatibleHeaders;
+        for (const auto& task : tasks) {
+            std::string header = reportedHeader(task, projectRoot1);
+            ReportSummaries::Summary summary;
+            if (ReportSummaries::getInstance().find(header, summary) &&
+                summary.overallStatus == serialize(OverAllStatus::BACKWARD_INCOMPATIBLE)) {
+                incompatibleHeaders.push_back(header);
+            }
+        }
+        bool backwardIncompatible = !incompatibleHeaders.empty();
+        armor::user_print() << nlohmann::json{{"backward_incompatible", backwardIncompatible},
+                                              {"headers", incompatibleHeaders}}.dump() << "\n";
+        return backwardIncompatible;
+    }
+
+    // How each version of a header is parsed, and its pair diffed
+    struct ParseOptions {
+        std::string language = LANG_CPP; // default to C++
+        std::string mode = MODE_FULL;
+        bool skipForeignBodies = false;
+        bool macroDiff = false;
+        unsigned collapseTypeChanges = 0;
+        bool pipelineDiff = false;
+        bool recordLayouts = false;
+        unsigned treeBuildJobs = 1;
+        bool resolveIncludes = false;
+        bool concurrentNormalize = false;
+        bool leanFrontend = false;
+        std::string simd = "auto";
+        bool expandSubtrees = false;
+        std::vector<std::string> includePaths;
+        std::string macroFlags;
+        double headerTimeout = 0;
+    };
+
+    void addParseOptions(CLI::App& app, ParseOptions& options) {
+        app.add_option("--lang,-l", options.language, "Language mode: cpp (default) or c.\n"
+                                                      "Use 'c' for C headers, 'cpp' for C++ headers.")
+            ->transform(CLI::IsMember({LANG_C, LANG_CPP}, CLI::ignore_case));
+        app.add_option("--mode", options.mode, "Parse mode: full (default) or api-only.\n"
+                                               "api-only compares the normalized API nodes alone, skipping comment and\n"
+                                               "preprocessor region tracking for faster parsing with less memory.")
+            ->check(CLI::IsMember({MODE_FULL, MODE_API_ONLY}));
+        app.add_flag("--skip-foreign-bodies", options.skipForeignBodies,
+            "Do not parse function bodies outside the compared headers.\n"
+            "Bodies inside each header are still parsed and hashed. Errors in skipped bodies of included code go unreported.");
+        app.add_flag("--macro-diff", options.macroDiff,
+            "Report macros added, removed or redefined in each header as Macro entries, by name,\n"
+            "rather than counting #define and #undef lines as unsupported updates (beta parser).");
+        app.add_option("--collapse-type-changes", options.collapseTypeChanges,
+            "Report a type name that at least N declarations spelled and the newer version no longer\n"
+            "spells as one change listing the declarations it affects, rather than one data type\n"
+            "change per declaration (beta parser). 0, the default, reports each declaration.")
+            ->check(CLI::NonNegativeNumber);
+        app.add_flag("--pipeline-diff", options.pipelineDiff,
+            "Normalize the newer version of each header one declaration at a time as clang completes it,\n"
+            "and diff each against the older version on a thread of its own while the rest is parsed\n"
+            "(beta parser). Reports are unchanged.");
+        app.add_flag("--record-layouts", options.recordLayouts,
+            "Compare the size, alignment and field offsets of complete structs, classes and unions, and\n"
+            "report a changed record layout, even one caused by a type defined in an include (beta parser).\n"
+            "Records are laid out while each header is parsed; only those that changed are compared.");
+        app.add_option("--tree-build-jobs", options.treeBuildJobs,
+            "Threads building the tree of each header once clang has parsed it (beta parser, default 1).\n"
+            "Declarations are built ahead on the others and taken in order, so reports are unchanged.\n"
+            "Use 0 to pick the number of CPUs available. Every one of --jobs starts that many.")
+            ->check(CLI::NonNegativeNumber);
+        app.add_flag("--resolve-includes", options.resolveIncludes,
+            "When a header fails to parse on includes the -I list misses, look them up among the headers\n"
+            "under its project root and parse the pair once more with -I for the directories found.\n"
+            "The directories added are printed, to copy into -I.");
+        app.add_flag("--concurrent-normalize", options.concurrentNormalize,
+            "Normalize each parsed C header for the alpha parser on a second thread while the beta parser\n"
+            "normalizes it. C++ headers and headers parsed with --pch-header or --clang-modules are\n"
+            "normalized in turn. Reports are unchanged.");
+        app.add_flag("--lean-frontend", options.leanFrontend,
+            "Parse without the clang analyses armor discards: warnings, typo correction on errors and the\n"
+            "notes of macro and template backtraces. Headers that parse cleanly are reported the same.");
+        app.add_option("--simd", options.simd,
+            "Vector instructions the byte scanners of normalized hashing and HTML escaping use: auto\n"
+            "(default), the best this CPU has, or off, plain scalar loops. Results are the same either way.")
+            ->check(CLI::IsMember({"auto", "off"}));
+        app.add_flag("--expand-subtrees", options.expandSubtrees,
+            "List every declaration of an added or removed namespace or class in the diff. By default one\n"
+            "declaring more than 256 others is reported as a summary: its counts by kind and first names.");
+        app.add_option("-I,--include-paths", options.includePaths,
+            "Include paths for header dependencies.\n"
+            "Example: -I path/to/include1 -I path/to/include2");
+        app.add_option("-m,--macro-flags", options.macroFlags,
+            "Macro flags to be passed for headers.\n");
+        app.add_option("--header-timeout", options.headerTimeout,
+            "Seconds parsing one version of a header may take; a parse running longer is cancelled,\n"
+            "the header is reported as TIMED_OUT and the run goes on. With --isolate, a worker still\n"
+            "busy with a header after twice this time is killed. Default 0, unbounded.")
+            ->check(CLI::NonNegativeNumber);
+    }
+
+    // Hands the parse and diff options to the frontend and the normalizers, which read them per header
+    void applyParseOptions(const ParseOptions& options) {
+        armor::setHeaderTimeout(options.headerTimeout);
+        armor::setIncludeResolution(options.resolveIncludes);
+        armor::setConcurrentNormalize(options.concurrentNormalize);
+        armor::setLeanFrontend(options.leanFrontend);
+        armor::simd::setKernel(options.simd == "off" ? armor::simd::Kernel::SCALAR : armor::simd::detectedKernel());
+        armor::info() << "SIMD kernel: " << armor::simd::kernelName(armor::simd::activeKernel()) << "\n";
+        setSubtreeExpansion(options.expandSubtrees);
+        setMacroDiff(options.macroDiff);
+        setTypeChangeCollapsing(options.collapseTypeChanges);
+        setPipelinedDiff(options.pipelineDiff);
+        setRecordLayouts(options.recordLayouts);
+        setTreeBuildJobs(armor::resolveJobCount(options.treeBuildJobs));
+    }
+
+    // Everything besides the two header versions that changes what a header reports, for the
+    // keys of --history and --result-cache
+    std::string resultKeyOf(const RunOptions& opts, const ParseOptions& parse, const std::string& pchHeader,
+                            bool umbrella) {
+        std::string key;
+        for (const std::string& part : {std::string(TOOL_VERSION), std::to_string(opts.lang), std::to_string(opts.parseMode),
+                                        std::string(opts.skipForeignBodies ? "1" : "0"),
+                                        std::string(umbrella ? "umbrella" : ""), pchHeader,
+                                        opts.apiFilter ? opts.apiFilter->fingerprint() : std::string()}) {
+            key += part;
+            key += '\0';
+        }
+        // Only runs with --macro-diff add it, so earlier entries keep their keys
+        if (parse.macroDiff) {
+            key += "macro-diff";
+            key += '\0';
+        }
+        if (parse.collapseTypeChanges > 0) {
+            key += "collapse-type-changes=" + std::to_string(parse.collapseTypeChanges);
+            key += '\0';
+        }
+        if (parse.recordLayouts) {
+            key += "record-layouts";
+            key += '\0';
+        }
+        if (parse.resolveIncludes) {
+            key += "resolve-includes";
+            key += '\0';
+        }
+        if (parse.expandSubtrees) {
+            key += "expand-subtrees";
+            key += '\0';
+        }
+        for (const std::vector<std::string>* list : {&opts.includePaths, &opts.macros}) {
+            for (const std::string& item : *list) {
+                key += item;
+                key += '\0';
+            }
+            key += '\1';
+        }
+        return key;
+    }
+
+    // Logging, profiling and the progress a run streams to others
+    struct DiagnosticsOptions {
+        std::string debugLevel = "";
+        std::string profileMode;
+        std::string traceOut;
+        std::string events;
+        std::string eventsOut = "-";
+        std::string metricsFile;
+    };
+
+    void addDiagnosticsOptions(CLI::App& app, DiagnosticsOptions& options) {
+        app.add_option("--log-level", options.debugLevel, "Set debug log level: ERROR, LOG, INFO (default), DEBUG")
+            ->check(CLI::IsMember({"ERROR", "LOG", "INFO", "DEBUG"}));
+        app.add_flag("--profile{time}", options.profileMode,
+            "Print time spent per phase and pipeline counters after the run,\n"
+            "and write a JSON profile per header to armor_reports/profiles under --output-dir.\n"
+            "--profile=mem also accounts allocations, peak RSS and nodes per kind per phase;\n"
+            "--profile=hw reads cycles, instructions, cache and branch misses per phase;\n"
+            "--profile=sample also samples call stacks and writes them folded, for flamegraphs.")
+            ->check(CLI::IsMember({"time", "mem", "hw", "sample"}));
+        app.add_option("--trace-out", options.traceOut,
+            "Write a Chrome / Perfetto trace-event JSON file of the run, one track per worker,\n"
+            "spanning the parses, diffs and reports of every header.");
+        CLI::Option* eventsOption = app.add_option("--events", options.events,
+            "Stream lifecycle events of the run for an orchestrator, one JSON object per line:\n"
+            "run_start, header_queued, cache_hit, parse_start, parse_end, diff_done, header_done, run_end.\n"
+            "Every event has \"event\" and \"time\", seconds since the run started.")
+            ->check(CLI::IsMember({"ndjson"}));
+        app.add_option("--events-out", options.eventsOut,
+            "Where --events go: - for stdout (default), or a file or FIFO, appended to")
+            ->needs(eventsOption);
+        app.add_option("--metrics-file", options.metricsFile,
+            "Write Prometheus metrics of the run to this file when it ends, replacing it atomically, for the\n"
+            "node_exporter textfile collector: cache lookups by tier, parse failures and phase latencies.");
+    }
+
+    void setDebugLevel(const std::string& debugLevel) {
+        DebugConfig& debugConfig = DebugConfig::getInstance();
+        if (debugLevel == "DEBUG") {
+            debugConfig.setLevel(DebugConfig::Level::DEBUG);
+            armor::info() << "Debug level set to DEBUG\n";
+            if (!DebugConfig::isCompiledIn(DebugConfig::Level::DEBUG)) {
+                armor::user_error() << "Debug records are compiled out of this build; "
+                                    << "reconfigure with -DARMOR_MAX_LOG_LEVEL=DEBUG to get them\n";
+            }
+        } else if (debugLevel == "INFO") {
+            debugConfig.setLevel(DebugConfig::Level::INFO);
+            armor::info() << "Debug level set to INFO\n";
+        } else if (debugLevel == "LOG") {
+            debugConfig.setLevel(DebugConfig::Level::WARNING);
+            armor::info() << "Debug level set to LOG (WARNING)\n";
+        } else if (debugLevel == "ERROR") {
+            debugConfig.setLevel(DebugConfig::Level::ERROR);
+            armor::info() << "Debug level set to ERROR\n";
+        }
+        else{
+            #ifdef TESTING_ENABLED
+                llvm::outs()<<"Enabled Testing \n";
+            #endif
+            debugConfig.setLevel(DebugConfig::Level::NONE);
+        }
+    }
+
+    // Starts what --profile and --trace-out record; a repro bundle carries the phase times of every header
+    void startProfiling(const DiagnosticsOptions& options, bool capturing) {
+        armor::profile::Profiler& profiler = armor::profile::Profiler::getInstance();
+        profiler.reset();
+        profiler.setEnabled(!options.profileMode.empty() || capturing);
+        profiler.setMemoryProfiling(options.profileMode == "mem");
+        profiler.setHardwareProfiling(options.profileMode == "hw");
+        profiler.setTracing(!options.traceOut.empty());
+        armor::profile::StackSampler& sampler = armor::profile::StackSampler::getInstance();
+        if (options.profileMode == "sample" && !sampler.start()) {
+            armor::user_error() << "Failed to start sampling call stacks: " << sampler.getError() << "\n";
+        }
+    }
+
+    // Prints and writes what --profile and --trace-out recorded, and stops recording
+    void finishProfiling(const DiagnosticsOptions& options, const armor::OutputPaths& outputs) {
+        armor::profile::Profiler& profiler = armor::profile::Profiler::getInstance();
+        armor::profile::StackSampler& sampler = armor::profile::StackSampler::getInstance();
+        if (!options.profileMode.empty()) {
+            profiler.printSummary();
+            profiler.writeReports(outputs.profileDir());
+        }
+        if (sampler.isRunning()) {
+            sampler.stop();
+            std::string foldedFile = outputs.profileDir() + "/stacks.folded";
+            std::error_code ec;
+            std::filesystem::create_directories(outputs.profileDir(), ec);
+            if (sampler.writeFolded(foldedFile)) {
+                armor::user_print() << "Folded stacks of " << sampler.getSampleCount() << " samples written to "
+                                    << foldedFile;
+                if (size_t dropped = sampler.getDroppedCount()) {
+                    armor::user_print() << " (" << dropped << " more dropped)";
+                }
+                armor::user_print() << "\n";
+            }
+            else {
+                armor::user_error() << "Failed to write " << foldedFile << "\n";
+            }
+        }
+        profiler.setEnabled(false);
+        profiler.setMemoryProfiling(false);
+        profiler.setHardwareProfiling(false);
+        if (!options.traceOut.empty()) {
+            if (profiler.writeTrace(options.traceOut)) {
+                armor::user_print() << "Trace written to " << options.traceOut << "\n";
+            }
+            profiler.setTracing(false);
+        }
+    }
+
+    // The caches shared across runs, and what is kept in them
+    struct CacheOptions {
+        std::string cacheDir;
+        uint64_t cacheMaxSize = 0;
+        double cacheMaxAge = 0;
+        std::string remoteCacheUrl;
+        bool resultCache = false;
+        bool astCache = false;
+        std::string pchHeader;
+        bool clangModules = false;
+    };
+
+    void addCacheOptions(CLI::App& app, CacheOptions& options) {
+        app.add_option("--cache-dir", options.cacheDir,
+            "Directory for the persistent normalized-API cache.\n"
+            "Headers whose contents, includes and flags are unchanged are loaded from it instead of being re-parsed.");
+        app.add_option("--cache-max-size", options.cacheMaxSize,
+            "Bound --cache-dir to this many MiB. Once a minute at most, whatever the number of processes\n"
+            "sharing it, the least recently used entries are evicted in the background down to 90% of it.")
+            ->needs("--cache-dir");
+        app.add_option("--cache-max-age", options.cacheMaxAge,
+            "Evict entries of --cache-dir unused for this many days, the same way as --cache-max-size.")
+            ->check(CLI::NonNegativeNumber)
+            ->needs("--cache-dir");
+        app.add_option("--remote-cache", options.remoteCacheUrl,
+            "HTTP(S) URL of a cache shared between machines, e.g. a bazel-remote or S3 bucket endpoint.\n"
+            "Local misses are fetched from it and new entries are uploaded to it.")
+            ->needs("--cache-dir");
+        app.add_flag("--result-cache", options.resultCache,
+            "Also keep the result of every compared header under --cache-dir, keyed by both versions'\n"
+            "include closures and the options of the run. A later run with the same inputs, such as a\n"
+            "retried job, reports the header from it without parsing or diffing.")
+            ->needs("--cache-dir");
+        app.add_flag("--ast-cache", options.astCache,
+            "Also keep the clang AST of every clean parse under --cache-dir, keyed by the clang version rather\n"
+            "than armor's. After an armor upgrade, headers are normalized again from their ASTs instead of\n"
+            "being re-parsed. Requires --mode=api-only.")
+            ->needs("--cache-dir");
+        app.add_option("--pch-header", options.pchHeader,
+            "Prefix header of system/SDK includes, precompiled once per project root\n"
+            "and force-included into every header. Only list includes every compared header tolerates seeing first.")
+            ->check(CLI::ExistingFile);
+        app.add_flag("--clang-modules", options.clangModules,
+            "Import dependencies that ship module maps as clang modules instead of including them.\n"
+            "Module files are built once and kept under <cache-dir>/modules across runs.");
+    }
+
+    // Adds the flags importing modules to `macros`; returns the module cache directory
+    std::string enableClangModules(const std::string& cacheDir, const armor::OutputPaths& outputs,
+                                   std::vector<std::string>& macros) {
+        std::string moduleCache = std::filesystem::absolute(
+            cacheDir.empty() ? outputs.scratchDir("modules") : cacheDir + "/modules").string();
+        std::error_code ec;
+        std::filesystem::create_directories(moduleCache, ec);
+        for (const char* flag : {"-fmodules", "-fimplicit-module-maps"}) {
+            macros.emplace_back(flag);
+        }
+        macros.push_back("-fmodules-cache-path=" + moduleCache);
+        armor::info() << "Clang module cache: " << moduleCache << "\n";
+        return moduleCache;
+    }
+
+    // The eviction bounding --cache-dir and the --remote-cache behind it
+    bool openCaches(const CacheOptions& options, std::unique_ptr<armor::BackgroundEviction>& eviction,
+                    std::shared_ptr<armor::RemoteCache>& remoteCache) {
+        // Evicts while the run goes on; readers take no lock, so a header whose entry is evicted just misses
+        armor::CacheLimits cacheLimits{options.cacheMaxSize << 20,
+                                       std::chrono::seconds(static_cast<int64_t>(options.cacheMaxAge * 24 * 3600))};
+        if (!options.cacheDir.empty() && cacheLimits.bounded()) {
+            eviction = std::make_unique<armor::BackgroundEviction>(options.cacheDir, cacheLimits);
+        }
+        if (!options.remoteCacheUrl.empty()) {
+            try {
+                remoteCache = armor::createRemoteCache(options.remoteCacheUrl);
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Results of earlier runs a run reports from or against
+    struct EarlierResultOptions {
+        std::string historyFile;
+        std::string baseManifestFile;
+        std::string baselinePath;
+    };
+
+    void addEarlierResultOptions(CLI::App& app, EarlierResultOptions& options) {
+        app.add_option("--history", options.historyFile,
+            "JSON lines file of per-header results, appended to by every run without --verdict-only.\n"
+            "Headers whose versions and options match a recorded result are reported from it\n"
+            "instead of being compared; 'armor history' prints the recorded results.");
+        app.add_option("--base-manifest", options.baseManifestFile,
+            "Digest manifest an earlier run wrote for its newer version (armor_reports/digest_manifest.json),\n"
+            "when that version is projectroot1 of this run. Headers whose digests still match are taken as\n"
+            "unchanged without reading projectroot1; with --cache-dir, their include closures must match too.")
+            ->check(CLI::ExistingFile);
+        app.add_option("--baseline", options.baselinePath,
+            "Output directory or report file of an accepted earlier run. Reports only show the changes\n"
+            "it does not have, and list the ones it has that are gone as resolved.");
+    }
+
+    // What --history, --result-cache and --base-manifest hold of earlier runs
+    struct EarlierResults {
+        std::unique_ptr<armor::ResultHistory> history;
+        std::unique_ptr<armor::ResultCache> resultCache;
+        std::unique_ptr<armor::DigestManifest> baseManifest;
+    };
+
+    // Loads --baseline into BaselineFindings, and the rest into `earlier`; false on a failure,
+    // or where results of this run would not match those of a full run
+    bool loadEarlierResults(const EarlierResultOptions& options, const CacheOptions& cache, bool changedRanges,
+                            bool verdictOnly, EarlierResults& earlier) {
+        armor::BaselineFindings& baselineFindings = armor::BaselineFindings::getInstance();
+        baselineFindings.clear();
+        if (!options.baselinePath.empty()) {
+            if (verdictOnly) {
+                armor::user_error() << "--baseline compares the changes of every header and cannot be used with --verdict-only\n";
+                return false;
+            }
+            try {
+                if (baselineFindings.load(options.baselinePath) == 0) {
+                    armor::user_error() << "No JSON reports found in " << options.baselinePath
+                                        << "; was it run with -r json, cbor or msgpack?\n";
+                }
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+        }
+
+        if (!options.historyFile.empty()) {
+            if (changedRanges) {
+                armor::user_error() << "--history cannot be used with --changed-ranges, whose results only cover the changed lines\n";
+                return false;
+            }
+            try {
+                earlier.history = std::make_unique<armor::ResultHistory>(armor::ResultHistory::load(options.historyFile));
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+            if (earlier.history->getSkippedLines() > 0) {
+                armor::user_error() << "Skipped " << earlier.history->getSkippedLines() << " unreadable lines of "
+                                    << options.historyFile << "\n";
+            }
+        }
+
+        if (cache.resultCache) {
+            if (changedRanges) {
+                armor::user_error() << "--result-cache cannot be used with --changed-ranges, whose results only cover the changed lines\n";
+                return false;
+            }
+            earlier.resultCache = std::make_unique<armor::ResultCache>(cache.cacheDir);
+        }
+
+        if (!options.baseManifestFile.empty()) {
+            try {
+                earlier.baseManifest = std::make_unique<armor::DigestManifest>(
+                    armor::DigestManifest::load(options.baseManifestFile));
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Records the compared pairs in --history and --result-cache; verdicts stop short of the
+    // records a report needs, so a --verdict-only run records none
+    void storeResults(const std::vector<HeaderPairTask>& tasks, const RunOptions& opts,
+                      const std::vector<PairOutcome>& outcomes, const std::vector<double>& seconds,
+                      const std::vector<std::string>& digests, const std::string& historyFile, const std::string& base,
+                      const std::string& head, unsigned workerCount) {
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::vector<armor::HistoryEntry> entries(tasks.size());
+        std::vector<char> hasEntry(tasks.size(), 0);
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            std::string header = reportedHeader(tasks[i], opts.projectRoot1);
+            ReportSummaries::Summary summary;
+            if (outcomes[i] != PairOutcome::PROCESSED || !ReportSummaries::getInstance().find(header, summary)) {
+                continue;
+            }
+            armor::HistoryEntry& entry = entries[i];
+            entry.header = header;
+            entry.digest = digests[i];
+            entry.base = base;
+            entry.head = head;
+            entry.time = now;
+            entry.seconds = seconds[i];
+            // Of every change, where the summary of a --baseline run only judges the new ones
+            bool incompatible = std::any_of(summary.records.begin(), summary.records.end(),
+                [](const ChangeRecord& record) { return record.backwardIncompatible; });
+            entry.overallStatus = getOverAllCategory(static_cast<unsigned>(summary.parsedStatus),
+                                                     static_cast<unsigned>(summary.unparsedStatus), !incompatible);
+            entry.parsedStatus = summary.parsedStatus;
+            entry.unparsedStatus = summary.unparsedStatus;
+            entry.parser = summary.parser;
+            entry.records = std::move(summary.records);
+            hasEntry[i] = 1;
+        }
+        if (opts.resultCache) {
+            // Keyed by the closures the parses of this run just recorded
+            armor::parallelFor(tasks.size(), workerCount, [&](std::size_t i) {
+                if (!hasEntry[i]) {
+                    return;
+                }
+                std::string key = resultCacheKey(tasks[i], opts);
+                if (!key.empty()) {
+                    opts.resultCache->store(key, entries[i]);
+                }
+            });
+        }
+        if (opts.history) {
+            std::vector<armor::HistoryEntry> appended;
+            for (std::size_t i = 0; i < tasks.size(); ++i) {
+                if (hasEntry[i] && !digests[i].empty()) {
+                    appended.push_back(std::move(entries[i]));
+                }
+            }
+            try {
+                armor::ResultHistory::append(historyFile, appended);
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+            }
+        }
+    }
+
+    // For a later run comparing against this newer version with --base-manifest
+    void writeDigestManifest(const std::vector<HeaderPairTask>& tasks, const RunOptions& opts, unsigned workerCount) {
+        std::vector<armor::DigestManifest::Entry> manifestEntries(tasks.size());
+        std::vector<char> hasManifestEntry(tasks.size(), 0);
+        armor::parallelFor(tasks.size(), workerCount, [&](std::size_t i) {
+            hasManifestEntry[i] = manifestEntry(tasks[i], opts, manifestEntries[i]);
+        });
+        armor::DigestManifest manifest;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            if (hasManifestEntry[i]) {
+                manifest.record(reportedHeader(tasks[i], opts.projectRoot1), manifestEntries[i]);
+            }
+        }
+        try {
+            std::filesystem::create_directories(std::filesystem::path(opts.outputs.digestManifestFile()).parent_path());
+            manifest.save(opts.outputs.digestManifestFile());
+        } catch (const std::exception &e) {
+            armor::user_error() << e.what() << "\n";
+        }
+    }
+
+    // --changed-ranges, --api-filter and --symbol, narrowing what each header compares
+    struct ApiSelectionOptions {
+        std::string changedRangesFile;
+        std::string apiFilterFile;
+        std::vector<std::string> symbols;
+    };
+
+    void addApiSelectionOptions(CLI::App& app, ApiSelectionOptions& options) {
+        app.add_option("--changed-ranges", options.changedRangesFile,
+            "JSON file of changed line ranges per header, e.g. from git diff -U0:\n"
+            "  {\"include/foo.h\": {\"old\": [[10, 12]], \"new\": [[10, 14]]}}\n"
+            "Declarations of a listed header that no change touches are only checked for being added or removed.")
+            ->check(CLI::ExistingFile);
+        app.add_option("--api-filter", options.apiFilterFile,
+            "JSON file selecting the public API; other declarations are never built, diffed or reported:\n"
+            "  {\"include\": [\"mylib::*\"], \"exclude\": [\"*::detail\", \"_*\"],\n"
+            "   \"excludeHidden\": true, \"exportMacros\": [\"MYLIB_API\"]}\n"
+            "Globs match qualified names; an excluded namespace or class drops everything inside it.")
+            ->check(CLI::ExistingFile);
+        app.add_option("--symbol", options.symbols,
+            "Only compare the declarations with this qualified name, e.g. ns::Foo::bar (repeatable).\n"
+            "Other declarations outside the scopes enclosing them are never built or diffed.");
+    }
+
+    bool loadApiSelection(const ApiSelectionOptions& options, std::unique_ptr<armor::ChangedRanges>& changedRanges,
+                          std::unique_ptr<armor::ApiFilter>& apiFilter) {
+        if (!options.changedRangesFile.empty()) {
+            try {
+                changedRanges = std::make_unique<armor::ChangedRanges>(
+                    armor::ChangedRanges::load(options.changedRangesFile));
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+        }
+        if (!options.apiFilterFile.empty()) {
+            try {
+                apiFilter = std::make_unique<armor::ApiFilter>(armor::ApiFilter::load(options.apiFilterFile));
+            } catch (const std::exception &e) {
+                armor::user_error() << e.what() << "\n";
+                return false;
+            }
+        }
+        if (!options.symbols.empty() && !apiFilter) {
+            apiFilter = std::make_unique<armor::ApiFilter>();
+        }
+        for (const std::string& symbol : options.symbols) {
+            apiFilter->addSymbol(symbol);
+        }
+        return true;
+    }
+
+    // How the pairs are spread over jobs, worker processes and nodes
+    struct SchedulingOptions {
+        unsigned jobs = 1;
+        unsigned prefetchIncludes = 0;
+        std::string costHistoryFile;
+        std::string shard;
+        bool dedupHeaders = false;
+        bool batch = false;
+        std::string maxMemory;
+        bool umbrella = false;
+        bool isolate = false;
+    };
+
+    // After the report and diagnostics options, which --isolate excludes
+    void addSchedulingOptions(CLI::App& app, SchedulingOptions& options) {
+        app.add_option("-j,--jobs", options.jobs,
+            "Number of header pairs processed in parallel (default 1).\n"
+            "Use 0 or auto to pick the number of CPUs available, within a container's CPU quota.")
+            ->transform(CLI::Transformer(std::map<std::string, std::string>{{"auto", "0"}}, CLI::ignore_case))
+            ->check(CLI::NonNegativeNumber);
+        app.add_option("--prefetch-includes", options.prefetchIncludes,
+            "Read the include closures of the next N headers to parse on a thread of its own while the\n"
+            "current ones parse, so cold network file systems stall the parsers less (default 0: off).")
+            ->check(CLI::NonNegativeNumber);
+        app.add_option("--cost-history", options.costHistoryFile,
+            "JSON file of the time each header took to compare, read by every run and updated by runs\n"
+            "without --batch or --verdict-only.\n"
+            "With several jobs, the headers expected to take longest are started first.");
+        app.add_option("--shard", options.shard,
+            "Only compare this node's share of the headers, given as i/N with 0 <= i < N.\n"
+            "Headers are split by estimated cost, the same way on every node given the same\n"
+            "checkouts and --cost-history; combine the runs with 'armor merge'.");
+        app.add_flag("--dedup-headers", options.dedupHeaders,
+            "Compare header pairs whose two versions are byte-identical to those of another pair, such as\n"
+            "per-platform copies, only once, and report every copy from that comparison with a note naming\n"
+            "the others. Copies that include other files must also be parsed with the same flags.");
+        CLI::Option* batchFlag = app.add_flag("--batch", options.batch,
+            "Parse all headers of each version through shared clang tools\n"
+            "(one per two jobs) instead of one tool per header.");
+        app.add_option("--max-memory", options.maxMemory,
+            "Resident memory in MiB to stay under, or auto for 80% of the container's memory limit.\n"
+            "With --batch, headers are parsed in waves sized to fit, each wave reported and freed\n"
+            "before the next is parsed. Otherwise jobs start no new header while memory is above 90%\n"
+            "of it, unless no other header is in progress.");
+        app.add_flag("--umbrella", options.umbrella,
+            "With --batch, parse all headers of each version as one translation unit, so their\n"
+            "shared includes are parsed once. Headers see the macros of those before them;\n"
+            "if the combined unit fails to compile, the headers are parsed separately.")
+            ->needs(batchFlag);
+        app.add_flag("--isolate", options.isolate,
+            "Compare headers in --jobs worker processes, forked once setup is done and reused, so a\n"
+            "header crashing the compiler fails alone: its worker is replaced and the run goes on.\n"
+            "Workers log to diagnostics.worker<N>.log next to the diagnostics log.")
+            ->excludes(batchFlag)
+            ->excludes("--combined-report")
+            ->excludes("--render-jobs")
+            ->excludes("--async-output")
+            ->excludes("--profile")
+            ->excludes("--trace-out");
+    }
+
+    // --max-memory in bytes, 0 for no limit
+    bool resolveMaxMemory(const std::string& maxMemory, std::size_t& maxMemoryBytes) {
+        if (!parseMaxMemory(maxMemory, maxMemoryBytes)) {
+            armor::user_error() << "Invalid --max-memory " << maxMemory << ", expected MiB or auto\n";
+            return false;
+        }
+        if (llvm::StringRef(maxMemory).equals_insensitive("auto")) {
+            if (maxMemoryBytes == 0) {
+                armor::info() << "No container memory limit found, --max-memory auto sets none\n";
+            }
+            else {
+                armor::info() << "Memory budget from the container limit: " << (maxMemoryBytes >> 20) << " MiB\n";
+            }
+        }
+        return true;
+    }
+
+    std::vector<double> predictPairCosts(const std::vector<HeaderPairTask>& tasks, const VersionSources& sources,
+                                         const std::string& projectRoot1,
+                                         const armor::HeaderCostHistory& costHistory) {
+        std::vector<std::string> names;
+        std::vector<double> estimates;
+        for (const auto& task : tasks) {
+            names.push_back(reportedHeader(task, projectRoot1));
+            estimates.push_back(estimatePairCost(task, sources));
+        }
+        return armor::predictHeaderCosts(names, estimates, costHistory);
+    }
+
+    // Keeps the pairs of --shard `shardIndex`, and their costs
+    void keepShard(unsigned shardIndex, unsigned shardCount, std::vector<HeaderPairTask>& tasks,
+                   std::vector<double>& costs) {
+        std::vector<unsigned> shards = armor::partitionByCost(costs, shardCount);
+        std::vector<HeaderPairTask> shardTasks;
+        std::vector<double> shardCosts;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            if (shards[i] == shardIndex) {
+                shardTasks.push_back(std::move(tasks[i]));
+                shardCosts.push_back(costs[i]);
+            }
+        }
+        armor::user_print() << "Shard " << shardIndex << "/" << shardCount << " compares " << shardTasks.size()
+                            << " of " << tasks.size() << " header pairs\n";
+        tasks = std::move(shardTasks);
+        costs = std::move(shardCosts);
+    }
+
+    // Of --dedup-headers: a pair sharing its aliasKey with an earlier one is its alias, reported
+    // from that one's result. `representatives` holds the pair compared for each, `aliases` the
+    // aliases of each pair compared for others
+    void findAliases(const std::vector<HeaderPairTask>& tasks, const RunOptions& opts, const std::vector<char>& blocking,
+                     unsigned workerCount, std::vector<std::size_t>& representatives,
+                     std::map<std::size_t, std::vector<std::size_t>>& aliases) {
+        std::vector<std::string> keys(tasks.size());
+        armor::parallelFor(tasks.size(), workerCount, [&](std::size_t i) {
+            try {
+                keys[i] = aliasKey(tasks[i], opts);
+                // A blocking copy is never reported from one compared after the gate verdict
+                if (!keys[i].empty() && blocking[i]) {
+                    keys[i] += "\2blocking";
+                }
+            } catch (const std::exception &e) {
+                ARMOR_DEBUG_LOG << "Not deduplicating " << tasks[i].file1 << " : " << e.what() << "\n";
+            }
+        });
+        std::unordered_map<std::string, std::size_t> firstWithKey;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            if (keys[i].empty()) {
+                continue;
+            }
+            representatives[i] = firstWithKey.try_emplace(keys[i], i).first->second;
+            if (representatives[i] != i) {
+                aliases[representatives[i]].push_back(i);
+            }
+        }
+        for (const auto& [representative, copies] : aliases) {
+            armor::user_print() << "Comparing " << reportedHeader(tasks[representative], opts.projectRoot1)
+                                << " once for " << copies.size() << " byte-identical copies\n";
+        }
+    }
+
+    // Reports the aliases of the pairs of `order` from their copies' summaries, once recorded;
+    // rendered here, as the render threads are gone
+    void reportAliases(const std::vector<std::size_t>& order, const std::map<std::size_t, std::vector<std::size_t>>& aliases,
+                       const std::vector<HeaderPairTask>& tasks, const RunOptions& opts,
+                       std::vector<PairOutcome>& outcomes, const std::function<void(std::size_t)>& headerDone) {
+        for (std::size_t representative : order) {
+            auto it = aliases.find(representative);
+            if (it == aliases.end()) {
+                continue;
+            }
+            const std::vector<std::size_t>& copies = it->second;
+            std::vector<std::string> group{reportedHeader(tasks[representative], opts.projectRoot1)};
+            for (std::size_t i : copies) {
+                group.push_back(reportedHeader(tasks[i], opts.projectRoot1));
+            }
+            for (std::size_t k = 0; k < copies.size(); ++k) {
+                std::size_t i = copies[k];
+                std::vector<std::string> others(group);
+                others.erase(others.begin() + 1 + k);
+                try {
+                    outcomes[i] = reportFromCopy(tasks[i], tasks[representative], outcomes[representative], others,
+                                                 opts);
+                } catch (const std::exception &e) {
+                    armor::user_error() << "Failed to process " << tasks[i].file1 << " : " << e.what() << "\n";
+                    outcomes[i] = PairOutcome::FAILED;
+                }
+                headerDone(i);
+            }
+        }
+    }
+
+    // What comparing the pairs settled, one slot per pair; each worker writes only the slots of its pairs
+    struct PairResults {
+        std::vector<PairOutcome> outcomes;
+        std::vector<double> seconds;
+        std::vector<std::string> digests;
+    };
+
+    // --batch: parses the pairs of `order` that need it through shared clang tools
+    void compareBatch(const std::vector<std::size_t>& order, const std::vector<HeaderPairTask>& tasks,
+                      const RunOptions& opts, bool umbrella, unsigned workerCount, std::size_t maxMemoryBytes,
+                      PairResults& results, const std::function<void(std::size_t)>& headerDone) {
+        std::vector<std::size_t> pending;
+        std::vector<std::pair<std::string, std::string>> pendingPairs;
+        for (std::size_t i : order) {
+            try {
+                results.outcomes[i] = triageHeaderPair(tasks[i], opts);
+                if (results.outcomes[i] == PairOutcome::PROCESSED) {
+                    results.outcomes[i] = reportFromEarlierResult(tasks[i], opts, results.digests[i]);
+                }
+            } catch (const std::exception &e) {
+                armor::user_error() << "Failed to process " << tasks[i].file1 << " : " << e.what() << "\n";
+                results.outcomes[i] = PairOutcome::FAILED;
+            }
+            if (results.outcomes[i] == PairOutcome::PROCESSED) {
+                pending.push_back(i);
+                pendingPairs.emplace_back(tasks[i].file1, tasks[i].file2);
+            }
+        }
+        try {
+            armor::processHeaderPairsSinglePass(opts.projectRoot1, opts.projectRoot2, pendingPairs, opts.reportFormat,
+                                                opts.includePaths, opts.macros, opts.lang, opts.dumpAstDiff,
+                                                opts.verdictOnly, opts.cacheDir, opts.remoteCache, opts.pchCache,
+                                                opts.changedRanges, opts.apiFilter, opts.parseMode,
+                                                opts.skipForeignBodies, umbrella, workerCount, opts.outputs,
+                                                maxMemoryBytes);
+        } catch (const std::exception &e) {
+            armor::user_error() << "Failed to process header batch : " << e.what() << "\n";
+            for (std::size_t i : pending) {
+                results.outcomes[i] = PairOutcome::FAILED;
+            }
+        }
+        // Batched pairs share their parses, so none has a time of its own
+        for (std::size_t i : order) {
+            headerDone(i);
+        }
+    }
+
+    // --isolate: compares the pairs of `order` in worker processes; false if they failed
+    bool compareIsolated(const std::vector<std::size_t>& order, const std::vector<HeaderPairTask>& tasks,
+                         RunOptions& opts, unsigned workerCount, double headerTimeout, PairResults& results,
+                         const std::function<void(std::size_t)>& headerDone) {
+        // Of the run; each worker points opts.outputs at its own log
+        const armor::OutputPaths outputs = opts.outputs;
+        if (!order.empty()) {
+            opts.diffJobs = std::max<unsigned>(1, workerCount / order.size());
+        }
+        // Built once here rather than once by every worker
+        if (opts.pchCache) {
+            for (const std::string& root : {opts.projectRoot1, opts.projectRoot2}) {
+                opts.pchCache->get(root, armor::buildBaseCompileFlags(root, opts.includePaths, opts.macros, opts.lang));
+            }
+        }
+        armor::ProcessPool pool(std::min<std::size_t>(workerCount, std::max<std::size_t>(order.size(), 1)),
+            [&](std::size_t i) {
+                auto start = std::chrono::steady_clock::now();
+                std::string digest;
+                PairOutcome outcome = processHeaderPair(tasks[i], opts, digest);
+                nlohmann::json result{
+                    {"outcome", static_cast<int>(outcome)},
+                    {"digest",  digest},
+                    {"seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()}};
+                ReportSummaries::Summary summary;
+                if (ReportSummaries::getInstance().find(reportedHeader(tasks[i], opts.projectRoot1), summary)) {
+                    result["summary"] = summaryToJson(summary);
+                }
+                return result.dump();
+            },
+            [&](unsigned worker) {
+                // Every header reopens opts.outputs.logFile(), which is now the worker's
+                opts.outputs.logPath = outputs.workerLogFile(worker);
+                if (!DebugConfig::getInstance().initialize(opts.outputs.logFile())) {
+                    armor::user_error() << "Failed to open diagnostics log <" << opts.outputs.logFile()
+                                        << ">, using stderr\n";
+                }
+            });
+        // Past its own cancellation, a header may still hang in the diff or a stuck frontend
+        if (headerTimeout > 0) {
+            pool.setTaskTimeout(std::chrono::milliseconds(static_cast<int64_t>(2000 * headerTimeout)));
+        }
+        try {
+            pool.run(order, [&](std::size_t i, const std::string* result, const std::string& failure) {
+                if (!result && failure == armor::ProcessPool::TIMEOUT_FAILURE) {
+                    armor::reportTimedOutHeaderPair(opts.projectRoot1, tasks[i].file1,
+                                                    "Comparing it ran past twice --header-timeout, its worker was stopped",
+                                                    opts.reportFormat, opts.verdictOnly, outputs);
+                    results.outcomes[i] = PairOutcome::FAILED;
+                    headerDone(i);
+                    return;
+                }
+                if (!result) {
+                    armor::user_error() << "Failed to process " << tasks[i].file1 << " : " << failure << "\n";
+                    results.outcomes[i] = PairOutcome::FAILED;
+                    headerDone(i);
+                    return;
+                }
+                nlohmann::json resultJson = nlohmann::json::parse(*result);
+                results.outcomes[i] = static_cast<PairOutcome>(resultJson.at("outcome").get<int>());
+                results.digests[i] = resultJson.at("digest").get<std::string>();
+                results.seconds[i] = resultJson.at("seconds").get<double>();
+                if (resultJson.contains("summary")) {
+                    ReportSummaries::getInstance().record(reportedHeader(tasks[i], opts.projectRoot1),
+                                                          summaryFromJson(resultJson.at("summary")));
+                }
+                headerDone(i);
+            });
+        } catch (const std::exception &e) {
+            armor::user_error() << "Failed to run worker processes : " << e.what() << "\n";
+            return false;
+        }
+        if (pool.getRestarts() > 0) {
+            armor::user_error() << pool.getRestarts() << " worker processes died and were replaced\n";
+        }
+        if (pool.getTimeouts() > 0) {
+            armor::user_error() << pool.getTimeouts() << " worker processes ran past --header-timeout and were replaced\n";
+        }
+        return true;
+    }
+
+    // Compares the pairs of `order` on `workerCount` threads of this process
+    void compareParallel(const std::vector<std::size_t>& order, const std::vector<HeaderPairTask>& tasks,
+                         RunOptions& opts, unsigned workerCount, std::size_t maxMemoryBytes, unsigned prefetchIncludes,
+                         PairResults& results, const std::function<void(std::size_t)>& headerDone) {
+        if (!order.empty()) {
+            opts.diffJobs = std::max<unsigned>(1, workerCount / order.size());
+        }
+        armor::MemoryGate memoryGate(workerCount > 1 ? maxMemoryBytes : 0);
+        // Both versions of the pairs in flight and of the next --prefetch-includes are read ahead
+        std::unique_ptr<armor::IncludePrefetcher> prefetcher;
+        if (prefetchIncludes > 0 && order.size() > 1) {
+            std::string directory = std::filesystem::current_path().string();
+            std::vector<armor::IncludePrefetcher::Header> scheduled;
+            for (std::size_t i : order) {
+                for (const auto& [root, file] : {std::make_pair(opts.projectRoot1, tasks[i].file1),
+                                                 std::make_pair(opts.projectRoot2, tasks[i].file2)}) {
+                    std::vector<std::string> flags = armor::buildCompileFlags(root, file, opts.includePaths, opts.macros,
+                                                                              opts.lang);
+                    scheduled.push_back({file, armor::includeDirsOf(flags, directory)});
+                }
+            }
+            prefetcher = std::make_unique<armor::IncludePrefetcher>(std::move(scheduled),
+                                                                    2 * (std::size_t{workerCount} + prefetchIncludes));
+        }
+        armor::parallelFor(order.size(), workerCount, [&](std::size_t k) {
+            std::size_t i = order[k];
+            armor::MemoryGate::Entry entry(memoryGate);
+            auto start = std::chrono::steady_clock::now();
+            try {
+                results.outcomes[i] = processHeaderPair(tasks[i], opts, results.digests[i]);
+            } catch (const std::exception &e) {
+                armor::user_error() << "Failed to process " << tasks[i].file1 << " : " << e.what() << "\n";
+                results.outcomes[i] = PairOutcome::FAILED;
+            }
+            results.seconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (prefetcher) {
+                // Once per version, as `scheduled` lists both versions of each pair
+                prefetcher->headerDone();
+                prefetcher->headerDone();
+            }
+            headerDone(i);
+        });
+        if (memoryGate.getThrottled() > 0) {
+            armor::info() << memoryGate.getThrottled() << " headers waited for memory under --max-memory\n";
+        }
+    }
+
+    // --git-repo and the two revisions compared
+    struct GitSourceOptions {
+        std::string gitRepo;
+        std::string baseRev;
+        std::string headRev;
+    };
+
+    void addGitSourceOptions(CLI::App& app, GitSourceOptions& options) {
+        CLI::Option* gitRepoOption = app.add_option("--git-repo", options.gitRepo,
+            "Read both versions from the objects of this git repository, without a checkout.\n"
+            "projectroot1 and projectroot2 are then paths inside the revisions, e.g. '.'.")
+            ->check(CLI::ExistingDirectory)
+            ->excludes("--recursive");
+        CLI::Option* baseRevOption = app.add_option("--base-rev", options.baseRev,
+            "With --git-repo, revision of the older version (branch, tag or commit)")
+            ->needs(gitRepoOption);
+        CLI::Option* headRevOption = app.add_option("--head-rev", options.headRev,
+            "With --git-repo, revision of the newer version (branch, tag or commit)")
+            ->needs(gitRepoOption);
+        gitRepoOption->needs(baseRevOption)->needs(headRevOption);
+    }
+
+    // Mounts both revisions and points the project roots, given inside them, at their mounts.
+    // Only the files clang opens are read from the object store; the trees are mounted at
+    // empty directories so the compile directories exist on disk
+    bool mountRevisions(const GitSourceOptions& options, const armor::OutputPaths& outputs, VersionSources& sources,
+                        std::string& projectRoot1, std::string& projectRoot2) {
+        try {
+            auto store = std::make_shared<armor::GitObjectStore>(options.gitRepo);
+            std::filesystem::path mountRoot = std::filesystem::absolute(outputs.scratchDir("git"));
+            std::filesystem::remove_all(mountRoot);
+            std::filesystem::create_directories(mountRoot / "base");
+            std::filesystem::create_directories(mountRoot / "head");
+            sources.tree1 = std::make_shared<armor::GitRevisionTree>(store, options.baseRev, (mountRoot / "base").string());
+            sources.tree2 = std::make_shared<armor::GitRevisionTree>(store, options.headRev, (mountRoot / "head").string());
+        } catch (const std::exception &e) {
+            armor::user_error() << "Cannot read revisions from " << options.gitRepo << ": " << e.what() << "\n";
+            return false;
+        }
+        projectRoot1 = mountedRoot(*sources.tree1, projectRoot1);
+        projectRoot2 = mountedRoot(*sources.tree2, projectRoot2);
+        for (const auto& [tree, root] : {std::make_pair(sources.tree1.get(), projectRoot1),
+                                         std::make_pair(sources.tree2.get(), projectRoot2)}) {
+            const armor::GitRevisionTree::Entry* entry = tree->lookup(root);
+            if (!entry || !entry->isDirectory) {
+                armor::user_error() << "Project root is not a directory of its revision: " << root << "\n";
+                return false;
+            }
+            // Compile commands run in the project root, which has to exist
+            std::filesystem::create_directories(root);
+        }
+        armor::setToolFileSystemOverlay([tree1 = sources.tree1, tree2 = sources.tree2] {
+            auto trees = llvm::makeIntrusiveRefCnt<llvm::vfs::OverlayFileSystem>(armor::createGitTreeFileSystem(tree1));
+            trees->pushOverlay(armor::createGitTreeFileSystem(tree2));
+            return llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(trees);
+        });
+        armor::info() << "Reading " << options.baseRev << " and " << options.headRev << " from " << options.gitRepo << "\n";
+        return true;
+    }
+
+    // --watch: runs this command line without --watch each time a file under projectroot2 changes.
+    // Its parses are kept by the context cache, in memory, so the versions a save did not touch
+    // are not parsed again
+    bool watchAndCompare(int argc, const char **argv, const std::string& cacheDir, const armor::OutputPaths& outputs,
+                         const std::string& projectRoot2) {
+        std::vector<const char*> runArgs;
+        for (int i = 0; i < argc; ++i) {
+            if (std::string(argv[i]) != "--watch") {
+                runArgs.push_back(argv[i]);
+            }
+        }
+        std::string watchCacheDir = cacheDir.empty() ? outputs.scratchDir("watch_cache") : cacheDir;
+        if (cacheDir.empty()) {
+            runArgs.push_back("--cache-dir");
+            runArgs.push_back(watchCacheDir.c_str());
+        }
+        armor::ContextCache::keepEntriesInMemory();
+        std::vector<std::string> written{std::filesystem::path(outputs.astDiffDir()).parent_path().string(),
+                                         std::filesystem::path(outputs.htmlReportDir()).parent_path().string(),
+                                         std::filesystem::path(outputs.logFile()).parent_path().string(),
+                                         watchCacheDir};
+        bool watched = armor::watchAndRerun(projectRoot2, written, [&](const std::vector<std::string>& changed) {
+            if (!changed.empty()) {
+                armor::user_print() << changed.size() << " file(s) changed, e.g. " << changed.front() << "\n";
+            }
+            runArmorTool(static_cast<int>(runArgs.size()), runArgs.data());
+            armor::user_print() << "Watching " << projectRoot2 << " for changes, Ctrl-C to stop\n";
+            return true;
+        });
+        if (!watched) {
+            armor::user_error() << "Cannot watch " << projectRoot2 << " for changes\n";
+        }
+        return watched;
+    }
+
+    // --capture-bundle: the files and flags the parses used, with the time of every pair
+    void saveReproBundle(const std::string& captureBundle, const std::vector<HeaderPairTask>& tasks,
+                         const std::string& projectRoot1, const std::vector<double>& seconds, int argc,
+                         const char **argv, const ParseOptions& parse) {
+        armor::BundleCapture& capture = armor::BundleCapture::getInstance();
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            capture.recordSeconds(reportedHeader(tasks[i], projectRoot1), seconds[i]);
+        }
+        armor::ReproBundle bundle = capture.finish();
+        bundle.arguments.assign(argv, argv + argc);
+        bundle.parseMode = parse.mode;
+        bundle.skipForeignBodies = parse.skipForeignBodies;
+        try {
+            bundle.save(captureBundle);
+            armor::profile::Profiler::getInstance().writeReports((std::filesystem::path(captureBundle) / "profiles").string());
+            armor::user_print() << "Repro bundle of " << bundle.pairs.size() << " header pairs and "
+                                << bundle.files.size() << " files written to " << captureBundle << "\n";
+        } catch (const std::exception &e) {
+            armor::user_error() << e.what() << "\n";
+        }
+    }
+
+    // Hits of the in-process caches, for the diagnostics log
+    void logCacheCounters(const armor::SharedFileCache& fileCache) {
+        armor::info() << "File cache: " << fileCache.getHits() << " stats and opens served from memory, "
+                      << fileCache.getMisses() << " from disk, " << fileCache.getBufferBytes() << " bytes cached\n";
+        beta::DeclSubtreeCache& declCache = beta::DeclSubtreeCache::getInstance();
+        if (declCache.isEnabled()) {
+            armor::info() << "Declaration cache: " << declCache.getHits() << " hits, " << declCache.getMisses() << " misses\n";
+        }
+        ConditionalBlockCache& blockCache = ConditionalBlockCache::getInstance();
+        if (blockCache.isEnabled()) {
+            armor::info() << "Conditional blocks: " << blockCache.getReusedBranches() << " reused, "
+                          << blockCache.getHashedBranches() << " rehashed\n";
+        }
+    }
+
+    // The last event of --events: how the pairs were settled and the run's result
+    void emitRunEnd(const std::vector<HeaderPairTask>& tasks, const std::vector<PairOutcome>& outcomes,
+                    const std::string& projectRoot1, std::chrono::steady_clock::time_point runStart, bool succeeded) {
+        nlohmann::json counts = nlohmann::json::object();
+        for (PairOutcome outcome : outcomes) {
+            counts[outcomeName(outcome)] = counts.value(outcomeName(outcome), 0) + 1;
+        }
+        std::size_t incompatible = 0;
+        for (const auto& task : tasks) {
+            ReportSummaries::Summary summary;
+            if (ReportSummaries::getInstance().find(reportedHeader(task, projectRoot1), summary) &&
+                summary.overallStatus == serialize(OverAllStatus::BACKWARD_INCOMPATIBLE)) {
+                ++incompatible;
+            }
+        }
+        armor::EventStream::getInstance().emit("run_end", {
+            {"seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count()},
+            {"outcomes", std::move(counts)},
+            {"backward_incompatible", incompatible},
+            {"success", succeeded}});
+    }
+
 }
 
 bool runArmorTool(int argc, const char **argv) {
     CLI::App app{"ARMOR"};
     std::string projectRoot1;
     std::string projectRoot2;
-    std::vector<std::string> headers;
-    std::string headerSubDir;
-    std::string reportFormat = "html";
-    std::string language = LANG_CPP; // default to C++
-    bool dumpAstDiff = false;
-    std::string debugLevel = "";
-    std::vector<std::string> IncludePaths;
-    std::vector<std::string> macros;
-    std::string macroFlags;
+    HeaderSelection selection;
+    GateOptions gate;
+    ReportOptions report;
+    ParseOptions parse;
+    DiagnosticsOptions diagnostics;
+    CacheOptions cache;
+    EarlierResultOptions earlierResults;
+    ApiSelectionOptions apiSelection;
+    SchedulingOptions scheduling;
+    GitSourceOptions git;
+    bool watch = false;
+    std::string captureBundle;
     auto fmt = std::make_shared<CLI::Formatter>();
     fmt->column_width(40);
     app.formatter(fmt);
     // Positional arguments
     app.add_option("projectroot1", projectRoot1, "Path to the project root dir of the older version")->required();
     app.add_option("projectroot2", projectRoot2, "Path to the project root dir of the newer version")->required();
-    app.add_option("headers", headers,
-        "List of header files to compare between the two versions.\n"
-        "\n"
-        "Header path interpretation depends on whether --header-dir is provided:\n"
-        "\n"
-        "  With --header-dir:\n"
-        "      Headers are treated as basenames (e.g., \"foo.h\") under the specified subdirectory.\n"
-        "      Example:\n"
-        "        --header-dir include/api foo.h bar.hpp\n"
-        "\n"
-        "  • Without --header-dir:\n"
-        "      Headers must be relative paths from the project root.\n"
-        "      Example:\n"
-        "        include/api/foo.h include/api/bar.hpp\n"
-    );
+    addHeaderSelectionOptions(app, selection);
     // Optional arguments
-    app.add_option("--header-dir", headerSubDir, "Subdirectory under each project root containing headers");
-    app.add_option("--report-format,-r", reportFormat, "Report format: html (default).\n"
-                                                       "If json is provided, both html and json reports will be generated.")
-        ->check(CLI::IsMember({"html", "json"}));
-    app.add_option("--lang,-l", language, "Language mode: cpp (default) or c.\n"
-                                          "Use 'c' for C headers, 'cpp' for C++ headers.")
-        ->transform(CLI::IsMember({LANG_C, LANG_CPP}, CLI::ignore_case));
-    app.add_flag("--dump-ast-diff", dumpAstDiff, "Dump AST diff JSON files for debugging");
+    addGateOptions(app, gate);
+    addReportOptions(app, report);
+    addParseOptions(app, parse);
     app.set_version_flag("--version,-v", TOOL_VERSION);
-    app.add_option("--log-level", debugLevel, "Set debug log level: ERROR, LOG, INFO (default), DEBUG")
-        ->check(CLI::IsMember({"ERROR", "LOG", "INFO", "DEBUG"}));
-
-    app.add_option("-I,--include-paths", IncludePaths,
-        "Include paths for header dependencies.\n"
-        "Example: -I path/to/include1 -I path/to/include2");
-    app.add_option("-m,--macro-flags", macroFlags,
-        "Macro flags to be passed for headers.\n");
+    addDiagnosticsOptions(app, diagnostics);
+    addCacheOptions(app, cache);
+    addEarlierResultOptions(app, earlierResults);
+    addApiSelectionOptions(app, apiSelection);
+    addSchedulingOptions(app, scheduling);
+    addGitSourceOptions(app, git);
+    // Both exclude options of every other group, so they come last
+    app.add_flag("--watch", watch,
+        "Compare again each time a file under projectroot2 changes, until interrupted.\n"
+        "Parsed contexts stay in memory, so a save re-parses only the headers it touched.")
+        ->excludes("--git-repo");
+    app.add_option("--capture-bundle", captureBundle,
+        "Write a repro bundle of the run to this directory: a copy of every file the parses read,\n"
+        "as a VFS overlay, the exact compile flags of every header and per-phase timings.\n"
+        "'armor --replay DIR' parses and compares the headers again from it, offline.")
+        ->excludes("--batch")
+        ->excludes("--isolate")
+        ->excludes("--git-repo")
+        ->excludes("--cache-dir")
+        ->excludes("--pch-header")
+        ->excludes("--clang-modules")
+        ->excludes("--watch");
     CLI11_PARSE(app, argc, argv);
-    std::istringstream iss(macroFlags);
+    if (!selection.headersFrom.empty()) {
+        std::vector<std::string> listed = readHeaderList(selection.headersFrom);
+        selection.headers.insert(selection.headers.end(), listed.begin(), listed.end());
+    }
+    std::vector<std::string> macros;
+    std::istringstream iss(parse.macroFlags);
     std::string flag;
     while (iss >> flag) {
         macros.push_back(flag);
     }
-    // Set level and announce (now goes to the file)
-    
-    DebugConfig& debugConfig = DebugConfig::getInstance();
-    debugConfig.initialize();
-
-    if (debugLevel == "DEBUG") {
-        debugConfig.setLevel(DebugConfig::Level::DEBUG);
-        armor::info() << "Debug level set to DEBUG\n";
-    } else if (debugLevel == "INFO") {
-        debugConfig.setLevel(DebugConfig::Level::INFO);
-        armor::info() << "Debug level set to INFO\n";
-    } else if (debugLevel == "LOG") {
-        debugConfig.setLevel(DebugConfig::Level::WARNING);
-        armor::info() << "Debug level set to LOG (WARNING)\n";
-    } else if (debugLevel == "ERROR") {
-        debugConfig.setLevel(DebugConfig::Level::ERROR);
-        armor::info() << "Debug level set to ERROR\n";
-    }
-    else{
-        #ifdef TESTING_ENABLED
-            llvm::outs()<<"Enabled Testing \n";
-        #endif
-        debugConfig.setLevel(DebugConfig::Level::NONE);
+    armor::OutputPaths outputs{report.outputDir, report.logFile, report.compressDebugOutput};
+    if (watch) {
+        return watchAndCompare(argc, argv, cache.cacheDir, outputs, projectRoot2);
     }
+    // Opened by the first record, or by the first pair that needs parsing; a run
+    // whose headers are all unchanged logs nothing at the default level
+    DebugConfig::getInstance().initializeOnFirstRecord(outputs.logFile());
+    setDebugLevel(diagnostics.debugLevel);
 
     // Convert language string to LANG_OPTIONS enum
-    LANG_OPTIONS langOption = stringToLangOption(language);
-    armor::info() << "Language mode set to: " << language << "\n";
-
-    bool processed = false;
-    std::vector<std::string> headersToCompare;
-    if (!headers.empty()) {
-        for (const auto &header : headers) {
-            std::string file1, file2;
-            if (!headerSubDir.empty()) {
-                file1 = projectRoot1 + "/" + headerSubDir + "/" + header;
-                file2 = projectRoot2 + "/" + headerSubDir + "/" + header;
-            } 
-            else {
-                file1 = projectRoot1 + "/" + header;
-                file2 = projectRoot2 + "/" + header;
-            }
-            armor::user_print() << "Processing files: " << file1 << " " << file2 << "\n";
-            if ( !std::filesystem::exists(file1) && !std::filesystem::exists(file2) ){
-                armor::user_error() << "Missing old and new versions of header : \n" << file1 << "\n" << file2 << "\n";
-                std::filesystem::create_directories("armor_reports/html_reports");
-                std::filesystem::create_directories("armor_reports/json_reports");
-            }
-            else if (!std::filesystem::exists(file1)) {
-                armor::user_error() << "Missing header in older version: " << file1 << "\n";
-                std::string headerName = std::filesystem::path(file2).filename().string();
-                const auto& [jsonReportFile, htmlReportFile] = prepare_report_output_dirs(headerName);
-                generate_json_report(
-                        {},
-                          jsonReportFile,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_compatible",
-                          "BACKWARD_COMPATIBLE",
-                          "Missing header in older version"
-                          );
-                generate_html_report(
-                    {},
-                          htmlReportFile,
-                          NO_PARSER,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_compatible",
-                          "BACKWARD_COMPATIBLE",
-                          "Missing header in older version",
-                          {false, true}
-                        );
-            } 
-            else if (!std::filesystem::exists(file2)) {
-                armor::user_error() << "Missing header in newer version: " << file2 << "\n";
-                std::string headerName = std::filesystem::path(file1).filename().string();
-                const auto& [jsonReportFile, htmlReportFile] = prepare_report_output_dirs(headerName);
-                generate_json_report(
-                        {},
-                          jsonReportFile,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_incompatible",
-                          "BACKWARD_INCOMPATIBLE",
-                          "Missing header in newer version"
-                          );
-                generate_html_report(
-                    {},
-                          htmlReportFile,
-                          NO_PARSER,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_incompatible",
-                          "BACKWARD_INCOMPATIBLE",
-                          "Missing header in newer version",
-                          {true, false}
-                        );
-            }
-            else{ 
-                if (filesAreDifferentUsingDiff(file1, file2)) {
-                    PARSING_STATUS parsingStatus = processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                    IncludePaths, macros, langOption);
-                    switch (parsingStatus) {
-                        case NO_FATAL_ERRORS:
-                            armor::info() << "Processing Headers again via beta parser\n";
-                            processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                        IncludePaths, macros, langOption);
-                            break;
-                        case FATAL_ERRORS:
-                            armor::info() << "Processing Headers stopped at alpha parser\n";
-                            break;
-                    }
-                    processed = true;
-                } 
-                else {
-                    armor::user_print() << "No differences found between: " << file1 << " and " << file2 << "\n";
-                    return true;
-                }
-            }
+    LANG_OPTIONS langOption = stringToLangOption(parse.language);
+    armor::info() << "Language mode set to: " << parse.language << "\n";
+
+    startProfiling(diagnostics, !captureBundle.empty());
+    auto stopSampling = llvm::make_scope_exit([]() { armor::profile::StackSampler::getInstance().reset(); });
+    armor::Metrics& metrics = armor::Metrics::getInstance();
+    metrics.beginBusy();
+    auto endBusy = llvm::make_scope_exit([&metrics]() { metrics.endBusy(); });
+    ReportSummaries::getInstance().clear();
+    // Copies of a header are reported from the records of the one compared
+    ReportSummaries::getInstance().keepRecords(
+        (!earlierResults.historyFile.empty() || cache.resultCache || scheduling.dedupHeaders) && !report.verdictOnly);
+    setHtmlReportMode(report.htmlMode == "lazy" ? HtmlReportMode::LAZY
+                      : report.htmlMode == "auto" ? HtmlReportMode::AUTO
+                                                  : HtmlReportMode::TABLE);
+    applyParseOptions(parse);
+    armor::setAstCache(cache.astCache);
+    armor::setIncludePrefetchDepth(scheduling.prefetchIncludes);
+
+    armor::EventStream& eventStream = armor::EventStream::getInstance();
+    if (!diagnostics.events.empty()) {
+        try {
+            eventStream.open(diagnostics.eventsOut);
+        } catch (const std::exception &e) {
+            armor::user_error() << e.what() << "\n";
+            return false;
         }
     }
-    else if (!headerSubDir.empty()) {
-        std::string dir1 = projectRoot1 + "/" + headerSubDir;
-        std::string dir2 = projectRoot2 + "/" + headerSubDir;
-        for (const auto &entry : std::filesystem::directory_iterator(dir1)) {
-            if (entry.path().extension() == ".h" || entry.path().extension() == ".hpp") {
-                headersToCompare.push_back(entry.path().filename().string());
+    auto closeEvents = llvm::make_scope_exit([&eventStream]() { eventStream.close(); });
+
+    armor::BundleCapture& capture = armor::BundleCapture::getInstance();
+    if (!captureBundle.empty()) {
+        capture.start();
+    }
+    // Whatever a failed run captured is dropped
+    auto stopCapture = llvm::make_scope_exit([&capture]() {
+        if (capture.isCapturing()) {
+            capture.finish();
+        }
+    });
+
+    PARSE_MODE parseMode = parse.mode == MODE_API_ONLY ? API_ONLY_MODE : FULL_MODE;
+    armor::info() << "Parse mode set to: " << parse.mode << "\n";
+    if (cache.astCache && parseMode != API_ONLY_MODE) {
+        armor::user_error() << "--ast-cache requires --mode=api-only, as comments and preprocessor regions "
+                               "are only tracked while parsing\n";
+        return false;
+    }
+
+    VersionSources sources;
+    armor::setToolFileSystemOverlay(nullptr);
+    // Files changed since an earlier run of this process (armor serve) are read again
+    armor::SharedFileCache& fileCache = armor::SharedFileCache::getInstance();
+    fileCache.clearListedTrees();
+    fileCache.revalidate();
+    if (!git.gitRepo.empty()) {
+        if (!cache.cacheDir.empty() || !cache.pchHeader.empty() || cache.clangModules) {
+            armor::user_error() << "--cache-dir, --pch-header and --clang-modules read files from disk and cannot be used with --git-repo\n";
+            return false;
+        }
+        if (!mountRevisions(git, outputs, sources, projectRoot1, projectRoot2)) {
+            return false;
+        }
+    }
+    else if (!report.quick) {
+        // Each header searches the chain of its ancestor directories; misses under the
+        // roots are answered from directory listings, except where this run writes
+        std::vector<std::string> written{std::filesystem::path(outputs.astDiffDir()).parent_path().string(),
+                                         std::filesystem::path(outputs.htmlReportDir()).parent_path().string(),
+                                         std::filesystem::path(outputs.logFile()).parent_path().string()};
+        for (const std::string& root : {projectRoot1, projectRoot2}) {
+            fileCache.listTree(root, written);
+        }
+    }
+
+    // Module files are written while headers parse, so they are looked up on disk every time
+    std::vector<std::string> uncached;
+    if (cache.clangModules) {
+        uncached.push_back(enableClangModules(cache.cacheDir, outputs, macros));
+    }
+    fileCache.setUncachedTrees(uncached);
+
+    std::unique_ptr<armor::PrecompiledHeaderCache> pchCache;
+    if (!cache.pchHeader.empty()) {
+        pchCache = std::make_unique<armor::PrecompiledHeaderCache>(cache.pchHeader, outputs.scratchDir("pch"));
+    }
+
+    std::unique_ptr<armor::ChangedRanges> changedRanges;
+    std::unique_ptr<armor::ApiFilter> apiFilter;
+    if (!loadApiSelection(apiSelection, changedRanges, apiFilter)) {
+        return false;
+    }
+
+    EarlierResults earlier;
+    if (!loadEarlierResults(earlierResults, cache, changedRanges != nullptr, report.verdictOnly, earlier)) {
+        return false;
+    }
+
+    if (scheduling.dedupHeaders && changedRanges) {
+        armor::user_error() << "--dedup-headers cannot be used with --changed-ranges, whose ranges differ between copies\n";
+        return false;
+    }
+
+    std::unique_ptr<armor::BackgroundEviction> eviction;
+    std::shared_ptr<armor::RemoteCache> remoteCache;
+    if (!openCaches(cache, eviction, remoteCache)) {
+        return false;
+    }
+
+    RunOptions runOptions{projectRoot1, projectRoot2, report.reportFormat, parse.includePaths, macros, langOption,
+                          report.dumpAstDiff, report.verdictOnly, cache.cacheDir, remoteCache, pchCache.get(),
+                          changedRanges.get(), apiFilter.get(), parseMode, parse.skipForeignBodies, &sources, outputs};
+    runOptions.baseManifest = earlier.baseManifest.get();
+    runOptions.history = earlier.history.get();
+    runOptions.resultCache = earlier.resultCache.get();
+    if (earlier.history || earlier.resultCache) {
+        runOptions.resultKey = resultKeyOf(runOptions, parse, cache.pchHeader, scheduling.batch && scheduling.umbrella);
+    }
+
+    std::vector<HeaderPairTask> tasks;
+    if (!selectHeaderPairs(selection, projectRoot1, projectRoot2, sources, scheduling.jobs, tasks)) {
+        return false;
+    }
+
+    if (report.quick) {
+        bool compatible = runQuickComparison(tasks, sources, projectRoot1);
+        armor::setToolFileSystemOverlay(nullptr);
+        return compatible;
+    }
+
+    armor::HeaderCostHistory costHistory;
+    if (!scheduling.costHistoryFile.empty()) {
+        try {
+            costHistory = armor::HeaderCostHistory::load(scheduling.costHistoryFile);
+        } catch (const std::exception &e) {
+            armor::user_error() << e.what() << "\n";
+            return false;
+        }
+    }
+
+    std::size_t maxMemoryBytes = 0;
+    if (!resolveMaxMemory(scheduling.maxMemory, maxMemoryBytes)) {
+        return false;
+    }
+
+    unsigned shardIndex = 0;
+    unsigned shardCount = 1;
+    if (!scheduling.shard.empty() && !parseShard(scheduling.shard, shardIndex, shardCount)) {
+        armor::user_error() << "Invalid --shard " << scheduling.shard << ", expected i/N with 0 <= i < N\n";
+        return false;
+    }
+
+    unsigned workerCount = armor::resolveJobCount(scheduling.jobs);
+    std::vector<double> costs;
+    if (shardCount > 1 || (workerCount > 1 && tasks.size() > 1)) {
+        costs = predictPairCosts(tasks, sources, projectRoot1, costHistory);
+    }
+    if (shardCount > 1) {
+        keepShard(shardIndex, shardCount, tasks, costs);
+    }
+
+    std::vector<char> blocking(tasks.size(), 0);
+    std::size_t blockingCount = 0;
+    if (!gate.blockingHeadersFile.empty()) {
+        blockingCount = markBlockingPairs(gate.blockingHeadersFile, tasks, projectRoot1, blocking);
+    }
+
+    std::vector<std::size_t> representatives(tasks.size());
+    std::iota(representatives.begin(), representatives.end(), 0);
+    std::map<std::size_t, std::vector<std::size_t>> aliases;
+    if (scheduling.dedupHeaders && tasks.size() > 1) {
+        findAliases(tasks, runOptions, blocking, workerCount, representatives, aliases);
+    }
+
+    // Pairs are handed to the workers longest first, so a large header never starts last
+    std::vector<std::size_t> order(tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (workerCount > 1 && tasks.size() > 1) {
+        armor::info() << "Processing " << tasks.size() << " header pairs with " << workerCount << " jobs\n";
+        order = armor::longestFirstOrder(costs);
+    }
+    order.erase(std::remove_if(order.begin(), order.end(), [&](std::size_t i) { return representatives[i] != i; }),
+                order.end());
+    // Blocking pairs (--blocking-headers) first, each class still longest first
+    auto firstOther = std::stable_partition(order.begin(), order.end(), [&](std::size_t i) { return blocking[i]; });
+    std::size_t blockingPairs = firstOther - order.begin();
+
+    CombinedHtmlReport& combined = CombinedHtmlReport::getInstance();
+    if (report.combinedReport) {
+        try {
+            combined.open(outputs.combinedHtmlFile());
+        } catch (const std::exception &e) {
+            armor::user_error() << e.what() << "\n";
+            return false;
+        }
+    }
+
+    if (report.renderJobs > 0 && !report.verdictOnly) {
+        start_report_rendering(report.renderJobs, 2 * std::max(workerCount, report.renderJobs));
+    }
+    if (report.asyncOutput && !report.verdictOnly) {
+        armor::OutputWriter::getInstance().start();
+    }
+
+    PairResults results{std::vector<PairOutcome>(tasks.size(), PairOutcome::MISSING),
+                        std::vector<double>(tasks.size(), 0), std::vector<std::string>(tasks.size())};
+    std::vector<PairOutcome>& outcomes = results.outcomes;
+
+    auto runStart = std::chrono::steady_clock::now();
+    eventStream.emit("run_start", {{"headers", tasks.size()}, {"jobs", workerCount},
+                                   {"mode", scheduling.batch ? "batch" : scheduling.isolate ? "isolate" : "parallel"}});
+    // Aliases last, as they are settled once their copies are
+    std::vector<std::size_t> queued(order);
+    for (const auto& [representative, copies] : aliases) {
+        queued.insert(queued.end(), copies.begin(), copies.end());
+    }
+    std::atomic<std::size_t> queueDepth{queued.size()};
+    metrics.setQueueDepth(queued.size());
+    for (std::size_t i : queued) {
+        eventStream.emit("header_queued", {{"header", reportedHeader(tasks[i], projectRoot1)},
+                                           {"file1", tasks[i].file1}, {"file2", tasks[i].file2}});
+    }
+    // Called by whichever thread settled pair i
+    auto emitHeaderDone = [&](std::size_t i) {
+        metrics.setQueueDepth(queueDepth.fetch_sub(1, std::memory_order_relaxed) - 1);
+        if (!eventStream.isOpen()) {
+            return;
+        }
+        std::string header = reportedHeader(tasks[i], projectRoot1);
+        nlohmann::json fields{{"header", header}, {"outcome", outcomeName(outcomes[i])},
+                              {"seconds", results.seconds[i]}};
+        ReportSummaries::Summary summary;
+        if (ReportSummaries::getInstance().find(header, summary)) {
+            fields["compatibility"] = summary.overallStatus;
+        }
+        eventStream.emit("header_done", std::move(fields));
+    };
+
+    // The blocking pairs on every worker, then the rest; every phase ends with its reports
+    // rendered, so the gate verdict is read from complete summaries
+    std::vector<std::vector<std::size_t>> phases;
+    if (blockingCount > 0) {
+        phases.emplace_back(order.begin(), order.begin() + blockingPairs);
+        phases.emplace_back(order.begin() + blockingPairs, order.end());
+    }
+    else {
+        phases.push_back(order);
+    }
+    for (std::size_t phase = 0; phase < phases.size(); ++phase) {
+        if (phase > 0 && report.renderJobs > 0 && !report.verdictOnly) {
+            start_report_rendering(report.renderJobs, 2 * std::max(workerCount, report.renderJobs));
+        }
+        if (scheduling.batch) {
+            compareBatch(phases[phase], tasks, runOptions, scheduling.umbrella, workerCount, maxMemoryBytes, results,
+                         emitHeaderDone);
+        }
+        else if (scheduling.isolate) {
+            if (!compareIsolated(phases[phase], tasks, runOptions, workerCount, parse.headerTimeout, results,
+                                 emitHeaderDone)) {
+                return false;
             }
         }
-        armor::user_print() << "List of headers to process:\n";
-        for (const auto &h : headersToCompare) {
-            armor::user_print() << "  " << h << "\n";
+        else {
+            compareParallel(phases[phase], tasks, runOptions, workerCount, maxMemoryBytes, scheduling.prefetchIncludes,
+                            results, emitHeaderDone);
         }
-        for (const auto &header : headersToCompare) {
-            std::string file1 = dir1 + "/" + header;
-            std::string file2 = dir2 + "/" + header;
-            armor::user_print() << "Processing files: " << file1 << " " << file2 << "\n";
-            if ( !std::filesystem::exists(file1) && !std::filesystem::exists(file2) ){
-                armor::user_error() << "Missing old and new versions of header : \n" << file1 << "\n" << file2 << "\n";
-            }
-            else if (!std::filesystem::exists(file1)) {
-                armor::user_error() << "Missing header in older version: " << file1 << "\n";
-                std::string headerName = std::filesystem::path(file2).filename().string();
-                const auto& [jsonReportFile, htmlReportFile] = prepare_report_output_dirs(headerName);
-                generate_json_report(
-                        {},
-                          jsonReportFile,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_compatible",
-                          "BACKWARD_COMPATIBLE",
-                          "Missing header in older version"
-                          );
-                generate_html_report(
-                    {},
-                          htmlReportFile,
-                          NO_PARSER,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_compatible",
-                          "BACKWARD_COMPATIBLE",
-                          "Missing header in older version",
-                          {false, true}
-                        );
-            } else if (!std::filesystem::exists(file2)) {
-                armor::user_error() << "Missing header in newer version: " << file2 << "\n";
-                std::string headerName = std::filesystem::path(file1).filename().string();
-                const auto& [jsonReportFile, htmlReportFile] = prepare_report_output_dirs(headerName);
-                generate_json_report(
-                        {},
-                          jsonReportFile,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_incompatible",
-                          "BACKWARD_INCOMPATIBLE",
-                          "Missing header in newer version"
-                          );
-                generate_html_report(
-                    {},
-                          htmlReportFile,
-                          NO_PARSER,
-                          static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
-                          static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
-                          "backward_incompatible",
-                          "BACKWARD_INCOMPATIBLE",
-                          "Missing header in newer version",
-                          {true, false}
-                        );
-            } 
-            else{ 
-                if (filesAreDifferentUsingDiff(file1, file2)) {
-                    PARSING_STATUS parsingStatus = processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                    IncludePaths, macros, langOption);
-                    switch (parsingStatus) {
-                        case NO_FATAL_ERRORS:
-                            armor::info() << "Processing Headers again via v2\n";
-                            processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                        IncludePaths, macros, langOption);
-                            break;
-                        case FATAL_ERRORS:
-                            armor::info() << "Processing Headers stopped at v1\n";
-                            break;
-                    }
-                    processed = true;
-                } 
-                else {
-                    llvm::outs()<<"No diff beta\n";
-                    armor::user_print() << "No differences found between: " << file1 << " and " << file2 << "\n";
-                    return true;
-                }
+        // The aliases and the gate verdict read the summaries the reports record
+        if (std::size_t failed = finish_report_rendering()) {
+            armor::user_error() << failed << " reports could not be rendered\n";
+        }
+        reportAliases(phases[phase], aliases, tasks, runOptions, outcomes, emitHeaderDone);
+        if (phase == 0 && blockingCount > 0) {
+            emitGateVerdict(tasks, blocking, blockingCount, outcomes, projectRoot1, gate.gateOut);
+        }
+    }
+    if (std::size_t failed = armor::OutputWriter::getInstance().finish()) {
+        armor::user_error() << failed << " report files could not be written\n";
+    }
+
+    // Batched headers share their parses and have no time of their own, and
+    // verdicts stop short of the full comparison a later run would repeat
+    if (!scheduling.costHistoryFile.empty() && !scheduling.batch && !report.verdictOnly) {
+        // Identical headers keep their last time, as they cost it again once they change
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            if (outcomes[i] == PairOutcome::PROCESSED) {
+                costHistory.record(reportedHeader(tasks[i], projectRoot1), results.seconds[i]);
             }
         }
+        try {
+            costHistory.save(scheduling.costHistoryFile);
+        } catch (const std::exception &e) {
+            armor::user_error() << e.what() << "\n";
+        }
+    }
+
+    if ((earlier.history || earlier.resultCache) && !report.verdictOnly) {
+        storeResults(tasks, runOptions, outcomes, results.seconds, results.digests, earlierResults.historyFile,
+                     git.gitRepo.empty() ? projectRoot1 : git.baseRev, git.gitRepo.empty() ? projectRoot2 : git.headRev,
+                     workerCount);
+    }
+
+    writeDigestManifest(tasks, runOptions, workerCount);
+
+    if (!captureBundle.empty()) {
+        saveReproBundle(captureBundle, tasks, projectRoot1, results.seconds, argc, argv, parse);
     }
-    if (processed && !dumpAstDiff) {
+
+    bool combinedWritten = true;
+    if (report.combinedReport) {
+        combinedWritten = combined.close();
+        if (combinedWritten) {
+            armor::user_print() << "Combined HTML report generated at: " << outputs.combinedHtmlFile() << "\n";
+        }
+        else {
+            armor::user_error() << "Failed to write " << outputs.combinedHtmlFile() << "\n";
+        }
+    }
+
+    bool processed = std::any_of(outcomes.begin(), outcomes.end(), [](PairOutcome o) {
+        return o == PairOutcome::PROCESSED || o == PairOutcome::FROM_HISTORY || o == PairOutcome::FROM_RESULT_CACHE ||
+               o == PairOutcome::ALIASED || o == PairOutcome::LEXICAL;
+    });
+    bool identical = std::any_of(outcomes.begin(), outcomes.end(),
+                                 [](PairOutcome o) { return o == PairOutcome::IDENTICAL; });
+
+    bool ndjsonWritten = report.ndjsonOut.empty() || writeNdjson(report.ndjsonOut, tasks, projectRoot1);
+    bool backwardIncompatible = report.verdictOnly && printVerdict(tasks, projectRoot1);
+
+    if (processed && !report.dumpAstDiff) {
         try {
-            std::filesystem::remove_all("debug_output/ast_diffs");
+            std::filesystem::remove_all(outputs.astDiffDir());
         } catch (const std::exception &e) {
             armor::user_error() << "Failed to remove debug_output directory: " << e.what() << "\n";
         }
     }
-    if (!processed && headers.empty() && headerSubDir.empty()) {
+    finishProfiling(diagnostics, outputs);
+    if (!processed && selection.headers.empty() && selection.headerSubDir.empty()) {
         const std::string argv0 = argv[0] ? std::string(argv[0]) : std::string("armor");
         armor::user_error() << "Usage: " << argv0 << " <projectroot1> <projectroot2> <header1> <header2> ...\n"
             << "Or use --header-dir to compare all headers in a subdirectory.\n"
             << "Try '" << argv0 << " --help' for more information.\n";
     }
-    return processed;
+    // Lets the object store and its git process go
+    armor::setToolFileSystemOverlay(nullptr);
+    logCacheCounters(fileCache);
+    // A shard can be left without headers when there are fewer headers than shards
+    bool emptyShard = shardCount > 1 && tasks.empty();
+    bool succeeded = (processed || identical || emptyShard) && ndjsonWritten && combinedWritten && !backwardIncompatible;
+    if (eventStream.isOpen()) {
+        emitRunEnd(tasks, outcomes, projectRoot1, runStart, succeeded);
+    }
+    metrics.setQueueDepth(0);
+    if (!diagnostics.metricsFile.empty() && !metrics.writeTextfile(diagnostics.metricsFile)) {
+        armor::user_error() << "Failed to write metrics to " << diagnostics.metricsFile << "\n";
+    }
+    return succeeded;
 }
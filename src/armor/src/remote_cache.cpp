@@ -0,0 +1,198 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "remote_cache.hpp"
+#include "logger.hpp"
+
+namespace {
+
+    // Uploads in flight before publish waits for the oldest, so a batch of
+    // fresh headers does not spawn one transfer per header at once
+    constexpr size_t MAX_PENDING_UPLOADS = 8;
+
+    bool createTempFile(const char* prefix, std::string& path) {
+        llvm::SmallString<256> tempPath;
+        if (std::error_code ec = llvm::sys::fs::createTemporaryFile(prefix, "cbor", tempPath)) {
+            ARMOR_DEBUG_LOG << "Cannot create a temporary file for the remote cache : " << ec.message() << "\n";
+            return false;
+        }
+        path = tempPath.str().str();
+        return true;
+    }
+
+    bool runCurl(const std::string& curl, const std::vector<std::string>& args, unsigned timeoutSeconds) {
+        std::vector<llvm::StringRef> argv(args.begin(), args.end());
+        llvm::Optional<llvm::StringRef> redirects[] = {llvm::StringRef(""), llvm::StringRef(""), llvm::StringRef("")};
+        std::string errorMessage;
+        // curl enforces --max-time itself; this only bounds a hung process
+        int rc = llvm::sys::ExecuteAndWait(curl, argv, llvm::None, redirects, timeoutSeconds * 2, 0, &errorMessage);
+        if (rc < 0) {
+            ARMOR_DEBUG_LOG << "curl did not complete : " << errorMessage << "\n";
+        }
+        return rc == 0;
+    }
+
+}
+
+armor::HttpRemoteCache::HttpRemoteCache(std::string url, unsigned timeoutSeconds)
+    : url(std::move(url)), timeoutSeconds(timeoutSeconds) {
+    while (!this->url.empty() && this->url.back() == '/') {
+        this->url.pop_back();
+    }
+    llvm::ErrorOr<std::string> program = llvm::sys::findProgramByName("curl");
+    if (!program) {
+        throw std::runtime_error("curl not found in PATH, required by --remote-cache");
+    }
+    curl = *program;
+}
+
+armor::HttpRemoteCache::~HttpRemoteCache() {
+    std::scoped_lock<std::mutex> lock(mutex);
+    reapUploads(/*wait=*/true);
+}
+
+std::vector<std::string> armor::HttpRemoteCache::curlArgs(const std::string& key) const {
+    // --fail turns HTTP errors, a 404 miss included, into a non-zero exit
+    return {"curl", "--silent", "--fail", "--location", "--netrc-optional",
+            "--max-time", std::to_string(timeoutSeconds), url + "/" + key};
+}
+
+bool armor::HttpRemoteCache::fetch(const std::string& key, std::string& bytes) {
+    std::string outFile;
+    if (!createTempFile("armor-remote", outFile)) {
+        return false;
+    }
+    std::vector<std::string> args = curlArgs(key);
+    args.insert(args.end() - 1, {"--output", outFile});
+
+    bool hit = false;
+    if (runCurl(curl, args, timeoutSeconds)) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+            llvm::MemoryBuffer::getFile(outFile, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if (buffer && (*buffer)->getBufferSize() != 0) {
+            bytes = (*buffer)->getBuffer().str();
+            hit = true;
+        }
+    }
+    llvm::sys::fs::remove(outFile);
+    return hit;
+}
+
+void armor::HttpRemoteCache::publish(const std::string& key, llvm::StringRef bytes) {
+    std::string bodyFile;
+    if (!createTempFile("armor-upload", bodyFile)) {
+        return;
+    }
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream out(bodyFile, ec);
+        if (!ec) {
+            out << bytes;
+            out.close();
+        }
+        if (ec || out.has_error()) {
+            ARMOR_DEBUG_LOG << "Cannot stage upload of " << key << " : "
+                           << (ec ? ec.message() : out.error().message()) << "\n";
+            out.clear_error();
+            llvm::sys::fs::remove(bodyFile);
+            return;
+        }
+    }
+
+    std::vector<std::string> args = curlArgs(key);
+    args.insert(args.end() - 1, {"--upload-file", bodyFile});
+    std::vector<llvm::StringRef> argv(args.begin(), args.end());
+    llvm::Optional<llvm::StringRef> redirects[] = {llvm::StringRef(""), llvm::StringRef(""), llvm::StringRef("")};
+
+    std::scoped_lock<std::mutex> lock(mutex);
+    reapUploads(/*wait=*/false);
+    while (uploads.size() >= MAX_PENDING_UPLOADS) {
+        llvm::sys::Wait(uploads.front().process, 0, /*WaitUntilTerminates=*/true);
+        llvm::sys::fs::remove(uploads.front().bodyFile);
+        uploads.erase(uploads.begin());
+    }
+
+    std::string errorMessage;
+    bool failed = false;
+    llvm::sys::ProcessInfo process =
+        llvm::sys::ExecuteNoWait(curl, argv, llvm::None, redirects, 0, &errorMessage, &failed);
+    if (failed) {
+        ARMOR_DEBUG_LOG << "Cannot upload cache entry " << key << " : " << errorMessage << "\n";
+        llvm::sys::fs::remove(bodyFile);
+        return;
+    }
+    uploads.push_back({process, std::move(bodyFile)});
+}
+
+void armor::HttpRemoteCache::reapUploads(bool wait) {
+    std::vector<Upload> running;
+    for (Upload& upload : uploads) {
+        llvm::sys::ProcessInfo result = llvm::sys::Wait(upload.process, 0, wait);
+        if (result.Pid == 0) {
+            running.push_back(std::move(upload));
+            continue;
+        }
+        if (result.ReturnCode != 0) {
+            ARMOR_DEBUG_LOG << "Upload to the remote cache exited with " << result.ReturnCode << "\n";
+        }
+        llvm::sys::fs::remove(upload.bodyFile);
+    }
+    uploads = std::move(running);
+}
+
+armor::ChunkedRemoteCache::ChunkedRemoteCache(std::shared_ptr<RemoteCache> inner, const std::string& cacheDir)
+    : inner(std::move(inner)), chunks(cacheDir) {}
+
+bool armor::ChunkedRemoteCache::fetch(const std::string& key, std::string& bytes) {
+    std::string manifest;
+    if (!inner->fetch(key, manifest)) {
+        return false;
+    }
+    std::size_t fetched = 0;
+    bool assembled = chunks.assemble(manifest, [this](const std::string& chunkKey, std::string& chunk) {
+        return inner->fetch(chunkKey, chunk);
+    }, bytes, &fetched);
+    if (!assembled) {
+        ARMOR_DEBUG_LOG << "Remote cache entry " << key << " cannot be assembled from its chunks\n";
+        return false;
+    }
+    ARMOR_DEBUG_LOG << "Assembled remote cache entry " << key << ", fetching " << fetched << " of its chunks\n";
+    return true;
+}
+
+void armor::ChunkedRemoteCache::publish(const std::string& key, llvm::StringRef bytes) {
+    std::vector<llvm::StringRef> entryChunks;
+    std::string manifest = ChunkStore::manifestOf(bytes, entryChunks);
+    for (llvm::StringRef chunk : entryChunks) {
+        std::string chunkKey = ChunkStore::keyOf(chunk);
+        if (!chunks.contains(chunkKey)) {
+            inner->publish(chunkKey, chunk);
+            chunks.store(chunk);
+        }
+    }
+    // After its chunks, so a machine that finds the manifest finds them too once their uploads complete
+    inner->publish(key, manifest);
+}
+
+std::shared_ptr<armor::RemoteCache> armor::createRemoteCache(const std::string& url) {
+    llvm::StringRef ref(url);
+    if (ref.startswith("http://") || ref.startswith("https://")) {
+        return std::make_shared<HttpRemoteCache>(url);
+    }
+    throw std::runtime_error("Unsupported remote cache URL <" + url + ">, expected http:// or https://");
+}
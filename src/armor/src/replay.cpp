@@ -0,0 +1,93 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+
+#include "clang_tool_runner.hpp"
+#include "comm_def.hpp"
+#include "logger.hpp"
+#include "output_paths.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "report_utils.hpp"
+#include "repro_bundle.hpp"
+#include "single_pass.hpp"
+#include "subcommand.hpp"
+
+bool armor::isReplayInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "--replay";
+}
+
+bool armor::runArmorReplay(int argc, const char** argv) {
+    CLI::App app{"ARMOR replay"};
+    std::string bundleDir;
+    std::string outputDir;
+    std::string reportFormat = "html";
+    app.add_option("bundle", bundleDir, "Directory written by --capture-bundle")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    app.add_option("--output-dir", outputDir,
+        "Directory receiving armor_reports/ and debug_output/ (default: the working directory)");
+    app.add_option("--report-format,-r", reportFormat, "Report format, as for a comparison (default: html)");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::ReproBundle bundle;
+    try {
+        bundle = armor::ReproBundle::load(bundleDir);
+        // Read once here, so a broken overlay fails before any parse
+        armor::ReproBundle::createFileSystem(bundleDir);
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+    for (const armor::ReproBundle::HeaderPair& pair : bundle.pairs) {
+        for (const std::string& root : {pair.older.projectRoot, pair.newer.projectRoot}) {
+            std::error_code ec;
+            std::filesystem::create_directories(root, ec);
+            if (ec) {
+                armor::user_error() << "Cannot create project root " << root << ": " << ec.message() << "\n";
+                return false;
+            }
+        }
+    }
+
+    armor::OutputPaths outputs{outputDir};
+    armor::profile::Profiler& profiler = armor::profile::Profiler::getInstance();
+    profiler.reset();
+    profiler.setEnabled(true);
+    ReportSummaries::getInstance().clear();
+    armor::setToolFileSystemOverlay([bundleDir] { return armor::ReproBundle::createFileSystem(bundleDir); });
+    PARSE_MODE parseMode = bundle.parseMode == MODE_API_ONLY ? API_ONLY_MODE : FULL_MODE;
+
+    bool parsed = true;
+    for (const armor::ReproBundle::HeaderPair& pair : bundle.pairs) {
+        auto start = std::chrono::steady_clock::now();
+        PARSING_STATUS status = FATAL_ERRORS;
+        try {
+            status = armor::replayHeaderPairSinglePass(pair, reportFormat, parseMode, bundle.skipForeignBodies,
+                                                       outputs);
+        } catch (const std::exception& e) {
+            armor::user_error() << "Failed to replay " << pair.header << " : " << e.what() << "\n";
+            parsed = false;
+            continue;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        armor::user_print() << pair.header << ": " << seconds << " s, " << pair.seconds << " s when captured"
+                            << (status == NO_FATAL_ERRORS ? "" : ", with fatal errors") << "\n";
+    }
+    armor::setToolFileSystemOverlay(nullptr);
+
+    profiler.printSummary();
+    profiler.writeReports(outputs.profileDir());
+    profiler.setEnabled(false);
+    return parsed;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+
+#include "header_selection.hpp"
+#include "logger.hpp"
+#include "select_headers.hpp"
+#include "subcommand.hpp"
+#include "work_pool.hpp"
+
+namespace {
+
+    bool writeList(const std::filesystem::path& file, const std::vector<std::string>& headers) {
+        std::ofstream out(file);
+        for (const std::string& header : headers) {
+            out << header << "\n";
+        }
+        if (!out) {
+            armor::user_error() << "Failed to write " << file.string() << "\n";
+            return false;
+        }
+        armor::user_print() << file.filename().string() << " : " << headers.size() << " entries\n";
+        return true;
+    }
+
+}
+
+bool armor::isSelectHeadersInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "select-headers";
+}
+
+bool armor::runArmorSelectHeaders(int argc, const char** argv) {
+    CLI::App app{"ARMOR select-headers"};
+    std::string configFile;
+    std::string branch;
+    std::vector<std::string> roots;
+    std::string workspace = ".";
+    std::string changedFiles;
+    unsigned jobs = 0;
+    app.add_option("config", configFile, "Header config of the action, listing patterns per branch and mode")
+        ->required()
+        ->check(CLI::ExistingFile);
+    app.add_option("branch", branch, "Branch whose patterns are expanded")->required();
+    app.add_option("roots", roots, "Project roots whose headers the patterns select, e.g. head and base")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    app.add_option("--workspace", workspace, "Directory receiving the header lists (default: the working directory)");
+    app.add_option("--changed-files", changedFiles,
+        "File listing the paths a change touched; the selected ones are written to updated_headers_PR.txt")
+        ->check(CLI::ExistingFile);
+    app.add_option("-j,--jobs", jobs, "Threads walking the roots (default 0, the number of CPU cores)")
+        ->check(CLI::NonNegativeNumber);
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::HeaderSelection selection;
+    try {
+        selection = armor::selectHeaders(armor::loadHeaderPatterns(configFile, branch), roots,
+                                         armor::resolveJobCount(jobs));
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+
+    std::filesystem::path dir(workspace);
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    bool written = writeList(dir / "blocking_headers_final.txt", selection.blocking) &&
+                   writeList(dir / "nonblocking_headers_final.txt", selection.nonBlocking) &&
+                   writeList(dir / "headers.txt", selection.headers);
+    if (!written || changedFiles.empty()) {
+        return written;
+    }
+
+    std::set<std::string> changed;
+    std::ifstream list(changedFiles);
+    std::string line;
+    while (std::getline(list, line)) {
+        changed.insert(llvm::StringRef(line).trim().str());
+    }
+    std::vector<std::string> updated;
+    std::copy_if(selection.headers.begin(), selection.headers.end(), std::back_inserter(updated),
+                 [&](const std::string& header) { return changed.count(header) > 0; });
+    return writeList(dir / "updated_headers_PR.txt", updated);
+}
@@ -0,0 +1,525 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "server.hpp"
+#include "options_handler.hpp"
+#include "comparator.hpp"
+#include "context_cache.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "output_paths.hpp"
+#include "report_format.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+    // Requests are small, or carry the buffers of a few headers; anything larger is not a request
+    constexpr size_t MAX_REQUEST_SIZE = 64 << 20;
+
+    class SocketHandle {
+        public:
+            explicit SocketHandle(int fd) : fd(fd) {}
+            ~SocketHandle() {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+            SocketHandle(const SocketHandle&) = delete;
+            SocketHandle& operator=(const SocketHandle&) = delete;
+
+            int get() const { return fd; }
+
+        private:
+            int fd;
+    };
+
+    bool readRequest(int fd, std::string& request) {
+        char buffer[4096];
+        while (request.size() < MAX_REQUEST_SIZE) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                return false;
+            }
+            if (n == 0) {
+                return !request.empty();
+            }
+            request.append(buffer, static_cast<size_t>(n));
+            size_t newline = request.find('\n');
+            if (newline != std::string::npos) {
+                request.resize(newline);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void sendReply(int fd, const json& reply) {
+        std::string payload = reply.dump();
+        payload += '\n';
+        size_t sent = 0;
+        while (sent < payload.size()) {
+            ssize_t n = send(fd, payload.data() + sent, payload.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                armor::user_error() << "Failed to send reply : " << std::strerror(errno) << "\n";
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    bool hasOption(const std::vector<std::string>& args, llvm::StringRef longName, llvm::StringRef shortName = "") {
+        for (const auto& arg : args) {
+            llvm::StringRef ref(arg);
+            if (ref == longName || ref.startswith((longName + "=").str()) ||
+                (!shortName.empty() && ref.startswith(shortName))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string optionValue(const std::vector<std::string>& args, llvm::StringRef longName) {
+        for (size_t i = 0; i < args.size(); ++i) {
+            llvm::StringRef ref(args[i]);
+            if (ref == longName && i + 1 < args.size()) {
+                return args[i + 1];
+            }
+            if (ref.consume_front((longName + "=").str())) {
+                return ref.str();
+            }
+        }
+        return "";
+    }
+
+    using ReportTimes = std::map<std::string, std::filesystem::file_time_type>;
+
+    ReportTimes snapshotReports(const std::string& reportDir) {
+        ReportTimes times;
+        std::error_code ec;
+        if (!std::filesystem::is_directory(reportDir, ec)) {
+            return times;
+        }
+        for (const auto& entry : std::filesystem::directory_iterator(reportDir, ec)) {
+            if (armor::isReportFile(entry.path().string())) {
+                times.try_emplace(entry.path().string(), entry.last_write_time(ec));
+            }
+        }
+        return times;
+    }
+
+    // Reports the request wrote are the ones that are new or were rewritten since `before`
+    json collectReports(const std::string& reportDir, const ReportTimes& before) {
+        json reports = json::object();
+        for (const auto& [path, time] : snapshotReports(reportDir)) {
+            auto it = before.find(path);
+            if (it != before.end() && it->second == time) {
+                continue;
+            }
+            try {
+                reports[std::filesystem::path(path).filename().string()] = armor::readReportDocument(path);
+            }
+            catch (const std::exception&) {
+                // Skipped like a report still being written
+            }
+        }
+        return reports;
+    }
+
+    json runRequest(const json& request, const std::string& cacheDir) {
+        std::vector<std::string> args = request.at("args").get<std::vector<std::string>>();
+        if (!hasOption(args, "--report-format", "-r")) {
+            args.emplace_back("-r");
+            args.emplace_back("json");
+        }
+        if (!cacheDir.empty() && !hasOption(args, "--cache-dir")) {
+            args.emplace_back("--cache-dir");
+            args.push_back(cacheDir);
+        }
+
+        std::error_code ec;
+        std::filesystem::path daemonDir = std::filesystem::current_path();
+        if (request.contains("cwd")) {
+            std::filesystem::current_path(request.at("cwd").get<std::string>(), ec);
+            if (ec) {
+                return {{"ok", false}, {"error", "Cannot enter " + request.at("cwd").get<std::string>() + " : " +
+                                                 ec.message()}};
+            }
+        }
+
+        std::vector<const char*> argv{"armor"};
+        for (const auto& arg : args) {
+            argv.push_back(arg.c_str());
+        }
+
+        std::string reportDir = armor::OutputPaths{optionValue(args, "--output-dir")}.jsonReportDir();
+        ReportTimes before = snapshotReports(reportDir);
+        json reply;
+        try {
+            bool ok = runArmorTool(static_cast<int>(argv.size()), argv.data());
+            reply = {{"ok", ok}, {"reports", collectReports(reportDir, before)}};
+        } catch (const std::exception& e) {
+            reply = {{"ok", false}, {"error", e.what()}};
+        }
+
+        std::filesystem::current_path(daemonDir, ec);
+        return reply;
+    }
+
+    const char* outcomeName(armor::CompareOutcome outcome) {
+        switch (outcome) {
+            case armor::CompareOutcome::COMPARED:         return "COMPARED";
+            case armor::CompareOutcome::IDENTICAL:        return "IDENTICAL";
+            case armor::CompareOutcome::MISSING_IN_OLDER: return "MISSING_IN_OLDER";
+            case armor::CompareOutcome::MISSING_IN_NEWER: return "MISSING_IN_NEWER";
+            case armor::CompareOutcome::FAILED:           return "FAILED";
+        }
+        return "FAILED";
+    }
+
+    // A "compare" request: one header pair through a Comparator, the newer version possibly from buffers
+    json runCompare(const json& request, const std::string& cacheDir) {
+        const json& compare = request.at("compare");
+        std::filesystem::path cwd = request.contains("cwd") ? std::filesystem::path(request.at("cwd").get<std::string>())
+                                                            : std::filesystem::current_path();
+
+        armor::CompareOptions options;
+        options.includePaths = compare.value("include_paths", std::vector<std::string>());
+        options.macroFlags = compare.value("macro_flags", std::vector<std::string>());
+        options.lang = compare.value("lang", LANG_CPP) == LANG_C ? LANG_OPTIONS::C : LANG_OPTIONS::CPP;
+        options.parseMode = compare.value("mode", MODE_FULL) == MODE_API_ONLY ? API_ONLY_MODE : FULL_MODE;
+        options.verdictOnly = compare.value("verdict_only", false);
+        options.cacheDir = cacheDir;
+
+        armor::HeaderPair pair{(cwd / compare.at("project_root1").get<std::string>()).string(),
+                               (cwd / compare.at("project_root2").get<std::string>()).string(),
+                               compare.at("header").get<std::string>(),
+                               compare.value("buffers", std::map<std::string, std::string>())};
+        armor::CompareResult result = armor::Comparator(std::move(options)).compare(pair);
+
+        json changes = json::array();
+        for (const ChangeRecord& record : result.changes) {
+            changes.push_back(record.toJson());
+        }
+        json reply = {{"ok", result.outcome != armor::CompareOutcome::FAILED},
+                      {"outcome", outcomeName(result.outcome)},
+                      {"header", result.header},
+                      {"overall_status", result.overallStatus},
+                      {"backward_incompatible", result.backwardIncompatible},
+                      {"changes", std::move(changes)}};
+        if (!result.error.empty()) {
+            reply["error"] = result.error;
+        }
+        return reply;
+    }
+
+    int openListeningSocket(const std::string& socketPath) {
+        sockaddr_un address{};
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            armor::user_error() << "Socket path too long: " << socketPath << "\n";
+            return -1;
+        }
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            armor::user_error() << "Cannot create socket : " << std::strerror(errno) << "\n";
+            return -1;
+        }
+        // A previous daemon that did not shut down cleanly leaves its socket behind; anything else stays
+        struct stat existing;
+        if (lstat(socketPath.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                armor::user_error() << "Cannot listen on " << socketPath << " : not a socket\n";
+                close(fd);
+                return -1;
+            }
+            unlink(socketPath.c_str());
+        }
+        // Requests run armor as this user, so only this user may connect
+        mode_t previousMask = umask(077);
+        int bound = bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        umask(previousMask);
+        if (bound < 0 || listen(fd, SOMAXCONN) < 0) {
+            armor::user_error() << "Cannot listen on " << socketPath << " : " << std::strerror(errno) << "\n";
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    struct ServeOptions {
+        std::string cacheDir;
+        // --metrics-file; workers write their own, see metricsFileOf
+        std::string metricsFile;
+    };
+
+    // Worker 0 is the daemon serving alone; the others write next to --metrics-file under their number
+    std::string metricsFileOf(const std::string& metricsFile, unsigned worker) {
+        if (worker == 0) {
+            return metricsFile;
+        }
+        std::filesystem::path path(metricsFile);
+        return (path.parent_path() / (path.stem().string() + ".worker" + std::to_string(worker) +
+                                      path.extension().string())).string();
+    }
+
+    std::map<std::string, std::string> metricsLabels(unsigned worker) {
+        if (worker == 0) {
+            return {};
+        }
+        return {{"worker", std::to_string(worker)}};
+    }
+
+    void writeMetrics(const ServeOptions& options, unsigned worker) {
+        if (options.metricsFile.empty()) {
+            return;
+        }
+        std::string path = metricsFileOf(options.metricsFile, worker);
+        if (!armor::Metrics::getInstance().writeTextfile(path, metricsLabels(worker))) {
+            armor::user_error() << "Failed to write metrics to " << path << "\n";
+        }
+    }
+
+    // Answers connections until a shutdown request; false if accepting failed
+    bool serveConnections(int listener, const ServeOptions& options, unsigned worker) {
+        armor::Metrics& metrics = armor::Metrics::getInstance();
+        writeMetrics(options, worker);
+        while (true) {
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                armor::user_error() << "Failed to accept connection : " << std::strerror(errno) << "\n";
+                return false;
+            }
+            SocketHandle client(connection);
+            auto start = std::chrono::steady_clock::now();
+            metrics.beginBusy();
+
+            std::string payload;
+            bool complete = readRequest(client.get(), payload);
+            json request = complete ? json::parse(payload, nullptr, /*allow_exceptions=*/false) : json();
+            const char* kind = "invalid";
+            json reply;
+            if (!complete) {
+                reply = {{"ok", false}, {"error", "Incomplete request"}};
+            }
+            else if (request.is_discarded() || !request.is_object()) {
+                reply = {{"ok", false}, {"error", "Request is not a JSON object"}};
+            }
+            else if (request.contains("command") && !request.at("command").is_string()) {
+                reply = {{"ok", false}, {"error", "Request \"command\" is not a string"}};
+            }
+            else if (request.value("command", "") == "shutdown") {
+                metrics.endBusy();
+                sendReply(client.get(), {{"ok", true}});
+                return true;
+            }
+            else if (request.value("command", "") == "metrics") {
+                metrics.endBusy();
+                sendReply(client.get(), {{"ok", true}, {"metrics", metrics.render(metricsLabels(worker))}});
+                continue;
+            }
+            else if (request.contains("compare")) {
+                kind = "compare";
+                try {
+                    reply = runCompare(request, options.cacheDir);
+                } catch (const std::exception& e) {
+                    reply = {{"ok", false}, {"error", e.what()}};
+                }
+            }
+            else if (!request.contains("args") || !request.at("args").is_array()) {
+                reply = {{"ok", false}, {"error", "Request has no \"args\" array"}};
+            }
+            else {
+                kind = "args";
+                try {
+                    reply = runRequest(request, options.cacheDir);
+                } catch (const std::exception& e) {
+                    reply = {{"ok", false}, {"error", e.what()}};
+                }
+            }
+            sendReply(client.get(), reply);
+            metrics.endBusy();
+            metrics.countRequest(kind, reply.value("ok", false), std::chrono::steady_clock::now() - start);
+            writeMetrics(options, worker);
+        }
+    }
+
+    // How a worker process of the daemon ended its accept loop
+    enum WorkerExit { WORKER_SHUT_DOWN = 0, WORKER_LISTENER_FAILED = 1 };
+
+    // -1 if the process could not be started; `worker` numbers it from 1
+    pid_t startWorker(int listener, const ServeOptions& options, unsigned worker) {
+        DebugConfig& debugConfig = DebugConfig::getInstance();
+        llvm::outs().flush();
+        llvm::errs().flush();
+        debugConfig.prepareFork();
+        pid_t pid = fork();
+        if (pid == 0) {
+            debugConfig.afterForkInChild();
+            bool shutDown = serveConnections(listener, options, worker);
+            // Static destructors and the socket file belong to the daemon process
+            llvm::outs().flush();
+            llvm::errs().flush();
+            DebugConfig::getInstance().closeLogFile();
+            _exit(shutDown ? WORKER_SHUT_DOWN : WORKER_LISTENER_FAILED);
+        }
+        debugConfig.afterForkInParent();
+        if (pid < 0) {
+            armor::user_error() << "Cannot start a server worker : " << std::strerror(errno) << "\n";
+        }
+        return pid;
+    }
+
+    // Slots of workers that are not running hold -1
+    void stopWorkers(const std::vector<pid_t>& workers) {
+        for (pid_t pid : workers) {
+            if (pid > 0) {
+                kill(pid, SIGTERM);
+            }
+        }
+        for (pid_t pid : workers) {
+            while (pid > 0 && waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+            }
+        }
+    }
+
+    // Keeps `workerCount` workers accepting until one of them saw a shutdown request.
+    // A replacement takes the number of the worker it replaces, and so its metrics file
+    bool superviseWorkers(int listener, const ServeOptions& options, unsigned workerCount) {
+        std::vector<pid_t> workers;
+        for (unsigned i = 0; i < workerCount; ++i) {
+            pid_t pid = startWorker(listener, options, i + 1);
+            if (pid < 0) {
+                stopWorkers(workers);
+                return false;
+            }
+            workers.push_back(pid);
+        }
+
+        bool served = true;
+        while (true) {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                served = false;
+                break;
+            }
+            auto worker = std::find(workers.begin(), workers.end(), pid);
+            if (worker == workers.end()) {
+                continue;
+            }
+            *worker = -1;
+            if (WIFEXITED(status) && WEXITSTATUS(status) == WORKER_SHUT_DOWN) {
+                break;
+            }
+            if (WIFEXITED(status) && WEXITSTATUS(status) == WORKER_LISTENER_FAILED) {
+                served = false;
+                break;
+            }
+            if (WIFSIGNALED(status)) {
+                armor::user_error() << "Server worker " << pid << " was killed by signal " << WTERMSIG(status)
+                                    << " (" << strsignal(WTERMSIG(status)) << "), starting another\n";
+            } else {
+                armor::user_error() << "Server worker " << pid << " exited with status " << WEXITSTATUS(status)
+                                    << ", starting another\n";
+            }
+            pid_t replacement = startWorker(listener, options, static_cast<unsigned>(worker - workers.begin()) + 1);
+            if (replacement < 0) {
+                served = false;
+                break;
+            }
+            *worker = replacement;
+        }
+        stopWorkers(workers);
+        return served;
+    }
+
+}
+
+bool armor::isServeInvocation(int argc, const char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        llvm::StringRef arg(argv[i]);
+        if (arg == "--serve" || arg.startswith("--serve=")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool armor::runArmorServer(int argc, const char** argv) {
+    CLI::App app{"ARMOR server"};
+    std::string socketPath;
+    std::string cacheDir;
+    std::string metricsFile;
+    unsigned workerCount = 1;
+    app.add_option("--serve", socketPath, "Unix socket to answer compare requests on")->required();
+    app.add_option("--cache-dir", cacheDir,
+        "Directory for the persistent normalized-API cache, used by requests that do not pass their own.");
+    app.add_option("--workers", workerCount,
+        "Worker processes answering requests side by side. Workers map cached baselines read-only, so they "
+        "share one copy of each.")->check(CLI::PositiveNumber);
+    app.add_option("--metrics-file", metricsFile,
+        "Prometheus metrics file for the node_exporter textfile collector, rewritten after every request. "
+        "With --workers, worker N writes its own with .workerN before the extension, labelled worker=\"N\".");
+    CLI11_PARSE(app, argc, argv);
+
+    DebugConfig::getInstance().initialize();
+    armor::ContextCache::keepEntriesInMemory();
+    if (!cacheDir.empty()) {
+        cacheDir = std::filesystem::absolute(cacheDir).string();
+    }
+    // Requests run in their own working directories
+    if (!metricsFile.empty()) {
+        metricsFile = std::filesystem::absolute(metricsFile).string();
+    }
+
+    SocketHandle listener(openListeningSocket(socketPath));
+    if (listener.get() < 0) {
+        return false;
+    }
+    armor::user_print() << "Serving compare requests on " << socketPath << "\n";
+
+    ServeOptions options{cacheDir, metricsFile};
+    bool served = workerCount <= 1 ? serveConnections(listener.get(), options, 0)
+                                   : superviseWorkers(listener.get(), options, workerCount);
+
+    unlink(socketPath.c_str());
+    return served;
+}
@@ -0,0 +1,1360 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/MultiplexConsumer.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Serialization/ASTReader.h"
+#include "clang/Serialization/ASTWriter.h"
+#include "clang/Serialization/ModuleFile.h"
+#include "clang/Serialization/PCHContainerOperations.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+
+#include "single_pass.hpp"
+#include "alpha/include/astnormalizer.hpp"
+#include "alpha/include/preprocesor.hpp"
+#include "alpha/include/header_processor.hpp"
+#include "beta/include/astnormalizer.hpp"
+#include "beta/include/comment_handler.hpp"
+#include "beta/include/preprocesor.hpp"
+#include "beta/include/header_processor.hpp"
+#include "categorization.hpp"
+#include "clang_tool_runner.hpp"
+#include "compile_flags.hpp"
+#include "diff_utils.hpp"
+#include "event_stream.hpp"
+#include "header_compilation_database.hpp"
+#include "include_graph.hpp"
+#include "include_resolver.hpp"
+#include "logger.hpp"
+#include "memory_usage.hpp"
+#include "metrics.hpp"
+#include "profiler.hpp"
+#include "repro_bundle.hpp"
+#include "report_format.hpp"
+#include "report_utils.hpp"
+#include "sharded_string_cache.hpp"
+#include "work_pool.hpp"
+
+namespace {
+
+    // --header-timeout, in seconds; 0 leaves frontend runs unbounded
+    double& headerTimeoutSeconds() {
+        static double sSeconds = 0;
+        return sSeconds;
+    }
+
+    // --resolve-includes
+    bool& includeResolutionEnabled() {
+        static bool sEnabled = false;
+        return sEnabled;
+    }
+
+    // --concurrent-normalize
+    bool& concurrentNormalizeEnabled() {
+        static bool sEnabled = false;
+        return sEnabled;
+    }
+
+    // --ast-cache
+    bool& astCacheEnabled() {
+        static bool sEnabled = false;
+        return sEnabled;
+    }
+
+    /**
+     * Whether alpha may walk `clangContext` while beta walks it too. Both only
+     * read the AST, but clang creates types as it prints C++ template
+     * arguments and loads declarations of a PCH or module as they are first
+     * reached, neither of them thread-safe. A C unit read without either does
+     * neither; beta alone lays out records.
+     */
+    bool canNormalizeConcurrently(const clang::ASTContext& clangContext) {
+        return concurrentNormalizeEnabled() && !clangContext.getLangOpts().CPlusPlus &&
+               !clangContext.getExternalSource();
+    }
+
+    /**
+     * The end of the time one frontend run may take. Checked as the run
+     * enters files and completes declarations; the first check past the end
+     * raises a fatal error, which stops clang from entering further includes
+     * and instantiating further templates.
+     */
+    class FrontendDeadline {
+        public:
+            FrontendDeadline(clang::DiagnosticsEngine& diagnostics, double seconds)
+                : diagnostics(diagnostics), seconds(seconds),
+                  end(std::chrono::steady_clock::now() +
+                      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                          std::chrono::duration<double>(seconds))) {}
+
+            void check() {
+                if (expired || std::chrono::steady_clock::now() < end) {
+                    return;
+                }
+                expired = true;
+                unsigned id = diagnostics.getCustomDiagID(clang::DiagnosticsEngine::Fatal,
+                                                          "parsing ran past --header-timeout of %0 seconds");
+                std::ostringstream limit;
+                limit << seconds;
+                diagnostics.Report(id) << llvm::StringRef(limit.str());
+            }
+
+            bool hasExpired() const { return expired; }
+
+        private:
+            clang::DiagnosticsEngine& diagnostics;
+            double seconds;
+            std::chrono::steady_clock::time_point end;
+            bool expired = false;
+    };
+
+    class DeadlineCallbacks : public clang::PPCallbacks {
+        public:
+            explicit DeadlineCallbacks(std::shared_ptr<FrontendDeadline> deadline) : deadline(std::move(deadline)) {}
+
+            void FileChanged(clang::SourceLocation, FileChangeReason, clang::SrcMgr::CharacteristicKind,
+                             clang::FileID) override {
+                deadline->check();
+            }
+
+        private:
+            std::shared_ptr<FrontendDeadline> deadline;
+    };
+
+    class SinglePassConsumer : public clang::ASTConsumer {
+        public:
+            // `deadline` may be null
+            SinglePassConsumer(std::unique_ptr<alpha::ASTNormalizeConsumer> alphaConsumer,
+                               std::unique_ptr<clang::ASTConsumer> betaConsumer,
+                               beta::ASTNormalizedContext* betaContext,
+                               std::shared_ptr<FrontendDeadline> deadline)
+                : alphaConsumer(std::move(alphaConsumer)), betaConsumer(std::move(betaConsumer)),
+                  betaContext(betaContext), deadline(std::move(deadline)) {}
+
+            // Only beta reads declarations before the end of the unit, and only
+            // with --pipeline-diff; these also give the deadline a chance between declarations
+            bool HandleTopLevelDecl(clang::DeclGroupRef group) override {
+                checkDeadline();
+                return betaConsumer->HandleTopLevelDecl(group);
+            }
+
+            void HandleTagDeclDefinition(clang::TagDecl*) override {
+                checkDeadline();
+            }
+
+            void HandleCXXImplicitFunctionInstantiation(clang::FunctionDecl*) override {
+                checkDeadline();
+            }
+
+            void HandleTranslationUnit(clang::ASTContext& clangContext) override {
+                armor::profile::PhaseTimer timer(armor::profile::Phase::HANDLE_TRANSLATION_UNIT);
+                if (clangContext.getDiagnostics().hasErrorOccurred()) {
+                    {
+                        armor::profile::TraceSpan span("alpha_normalize");
+                        alphaConsumer->HandleTranslationUnit(clangContext);
+                    }
+                    // The beta result is discarded for broken TUs; only register the
+                    // ASTContext so EndSourceFileAction can still finalize its trackers
+                    betaContext->addClangASTContext(&clangContext);
+                    return;
+                }
+                // A unit without errors is normalized by both, so alpha need not
+                // finish before beta starts
+                std::future<void> alpha;
+                if (canNormalizeConcurrently(clangContext)) {
+                    alpha = std::async(std::launch::async, [this, &clangContext]() {
+                        armor::profile::TraceSpan span("alpha_normalize");
+                        alphaConsumer->HandleTranslationUnit(clangContext);
+                    });
+                }
+                else {
+                    armor::profile::TraceSpan span("alpha_normalize");
+                    alphaConsumer->HandleTranslationUnit(clangContext);
+                }
+                {
+                    armor::profile::TraceSpan span("beta_normalize");
+                    betaConsumer->HandleTranslationUnit(clangContext);
+                }
+                if (alpha.valid()) {
+                    alpha.get();
+                }
+            }
+
+            // Neither normalizer reads bodies outside the main file
+            bool shouldSkipFunctionBody(clang::Decl* D) override {
+                return betaConsumer->shouldSkipFunctionBody(D);
+            }
+
+        private:
+            void checkDeadline() {
+                if (deadline) {
+                    deadline->check();
+                }
+            }
+
+            std::unique_ptr<alpha::ASTNormalizeConsumer> alphaConsumer;
+            std::unique_ptr<clang::ASTConsumer> betaConsumer;
+            beta::ASTNormalizedContext* betaContext;
+            std::shared_ptr<FrontendDeadline> deadline;
+    };
+
+    // Told the file key of each frontend run that ran past the header timeout
+    using TimeoutHandler = std::function<void(const std::string& fileKey)>;
+
+    // Handed the serialized AST of each clean frontend run, once its dependencies are listed
+    using AstHandler = std::function<void(const std::string& fileKey, llvm::StringRef ast)>;
+
+    // Contexts are looked up from the header each action is handed, so one
+    // factory can serve a whole batch
+    class SinglePassAction : public beta::NormalizeAction {
+        public:
+            // `onAst`, if set, has the AST serialized as the unit is normalized
+            SinglePassAction(alpha::APISession* alphaSession, beta::APISession* betaSession,
+                             const llvm::StringMap<std::string>& fileKeys,
+                             llvm::StringMap<std::vector<std::string>>* dependencies,
+                             const TimeoutHandler& onTimeout, const AstHandler& onAst)
+                : beta::NormalizeAction(betaSession, nullptr),
+                  alphaSession(alphaSession), alphaContext(nullptr), fileKeys(fileKeys), dependencies(dependencies),
+                  onTimeout(onTimeout), onAst(onAst) {}
+
+            std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance& CI, clang::StringRef inFile) override {
+                fileKey = fileKeys.lookup(inFile);
+                parseStart = std::chrono::steady_clock::now();
+                armor::EventStream::getInstance().emit("parse_start", {{"file", fileKey}});
+                // The frontend run of this file is profiled until EndSourceFileAction
+                headerScope.emplace(fileKey);
+                processTimer.emplace(armor::profile::Phase::PROCESS_FILE);
+                alphaContext = alphaSession->getContext(fileKey);
+                context = session->getContext(fileKey);
+
+                // Registers the beta comment handler and preprocessor callbacks, unless API-only
+                std::unique_ptr<clang::ASTConsumer> betaConsumer = beta::NormalizeAction::CreateASTConsumer(CI, inFile);
+
+                CI.getPreprocessor().addPPCallbacks(
+                    std::make_unique<alpha::ASTNormalizerPreprocessor>(&CI.getSourceManager(), alphaContext));
+
+                if (headerTimeoutSeconds() > 0) {
+                    deadline = std::make_shared<FrontendDeadline>(CI.getDiagnostics(), headerTimeoutSeconds());
+                    CI.getPreprocessor().addPPCallbacks(std::make_unique<DeadlineCallbacks>(deadline));
+                }
+
+                auto consumer = std::make_unique<SinglePassConsumer>(
+                    std::make_unique<alpha::ASTNormalizeConsumer>(alphaSession, alphaContext),
+                    std::move(betaConsumer), context, deadline);
+                if (!onAst) {
+                    return consumer;
+                }
+                // Written as a PCH is, after the normalizers; without timestamps, so that only
+                // the contents of the files it read, which AstCache checks, decide if it is current
+                astBuffer = std::make_shared<clang::PCHBuffer>();
+                std::vector<std::unique_ptr<clang::ASTConsumer>> consumers;
+                consumers.push_back(std::move(consumer));
+                consumers.push_back(std::make_unique<clang::PCHGenerator>(
+                    CI.getPreprocessor(), CI.getModuleCache(), fileKey + ".ast", /*isysroot=*/"", astBuffer,
+                    llvm::ArrayRef<std::shared_ptr<clang::ModuleFileExtension>>(),
+                    /*AllowASTWithErrors=*/false, /*IncludeTimestamps=*/false));
+                return std::make_unique<clang::MultiplexConsumer>(std::move(consumers));
+            }
+
+            void EndSourceFileAction() override {
+                // Every file the translation unit read, for validating cache entries
+                if (dependencies) {
+                    std::vector<std::string>& files = (*dependencies)[fileKey];
+                    const clang::SourceManager& SM = getCompilerInstance().getSourceManager();
+                    for (auto it = SM.fileinfo_begin(); it != SM.fileinfo_end(); ++it) {
+                        files.emplace_back(it->first->getName().str());
+                    }
+                    // Headers imported from implicit modules (--clang-modules) were never entered
+                    if (clang::ASTReader* reader = getCompilerInstance().getASTReader().get()) {
+                        for (clang::serialization::ModuleFile& module : reader->getModuleManager()) {
+                            if (module.Kind != clang::serialization::MK_ImplicitModule) {
+                                continue;
+                            }
+                            reader->visitInputFiles(module, /*IncludeSystem=*/true, /*Complain=*/false,
+                                                    [&files](const clang::serialization::InputFile& input, bool) {
+                                                        if (auto file = input.getFile()) {
+                                                            files.emplace_back(file->getName().str());
+                                                        }
+                                                    });
+                        }
+                    }
+                }
+                beta::NormalizeAction::EndSourceFileAction();
+                bool expired = deadline && deadline->hasExpired();
+                if (expired) {
+                    armor::user_error() << "Parsing " << fileKey << " ran past --header-timeout, cancelled\n";
+                    onTimeout(fileKey);
+                }
+                else if (astBuffer && astBuffer->IsComplete &&
+                         !getCompilerInstance().getDiagnostics().hasErrorOccurred()) {
+                    onAst(fileKey, llvm::StringRef(astBuffer->Data.data(), astBuffer->Data.size()));
+                }
+                astBuffer.reset();
+                bool errors = getCompilerInstance().getDiagnostics().hasErrorOccurred();
+                std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - parseStart;
+                armor::Metrics& metrics = armor::Metrics::getInstance();
+                metrics.observe(armor::Metrics::Phase::PARSE, elapsed);
+                if (errors || expired) {
+                    metrics.countParseFailure(expired);
+                }
+                armor::EventStream::getInstance().emit("parse_end", {
+                    {"file", fileKey},
+                    {"errors", errors},
+                    {"timed_out", expired},
+                    {"seconds", std::chrono::duration<double>(elapsed).count()}});
+                deadline.reset();
+                processTimer.reset();
+                headerScope.reset();
+            }
+
+        private:
+            alpha::APISession* alphaSession;
+            alpha::ASTNormalizedContext* alphaContext;
+            const llvm::StringMap<std::string>& fileKeys;
+            llvm::StringMap<std::vector<std::string>>* dependencies;
+            const TimeoutHandler& onTimeout;
+            const AstHandler& onAst;
+            std::shared_ptr<clang::PCHBuffer> astBuffer;
+            std::shared_ptr<FrontendDeadline> deadline;
+            std::string fileKey;
+            std::chrono::steady_clock::time_point parseStart;
+            std::optional<armor::profile::HeaderScope> headerScope;
+            std::optional<armor::profile::PhaseTimer> processTimer;
+    };
+
+    class SinglePassActionFactory : public clang::tooling::FrontendActionFactory {
+        public:
+            SinglePassActionFactory(alpha::APISession* alphaSession, beta::APISession* betaSession,
+                                    const llvm::StringMap<std::string>& fileKeys,
+                                    llvm::StringMap<std::vector<std::string>>* dependencies,
+                                    TimeoutHandler onTimeout, AstHandler onAst = nullptr)
+                : alphaSession(alphaSession), betaSession(betaSession), fileKeys(fileKeys),
+                  dependencies(dependencies), onTimeout(std::move(onTimeout)), onAst(std::move(onAst)) {}
+
+            std::unique_ptr<clang::FrontendAction> create() override {
+                return std::make_unique<SinglePassAction>(alphaSession, betaSession, fileKeys, dependencies, onTimeout,
+                                                          onAst);
+            }
+
+        private:
+            alpha::APISession* alphaSession;
+            beta::APISession* betaSession;
+            const llvm::StringMap<std::string>& fileKeys;
+            llvm::StringMap<std::vector<std::string>>* dependencies;
+            TimeoutHandler onTimeout;
+            AstHandler onAst;
+    };
+
+    // One header of an umbrella translation unit and what is attached for it
+    struct UmbrellaHeader {
+        std::string fileName;
+        // What the umbrella includes; relative names would resolve against the compile directory
+        std::string absolutePath;
+        alpha::ASTNormalizedContext* alphaContext;
+        beta::ASTNormalizedContext* betaContext;
+        // Owned here; removed from the preprocessor before deletion
+        beta::CommentHandler* commentHandler = nullptr;
+        // Owned by the preprocessor
+        beta::ASTNormalizerPreprocessor* preprocessor = nullptr;
+        bool entered = false;
+    };
+
+    struct UmbrellaState {
+        std::vector<UmbrellaHeader> headers;
+        llvm::DenseMap<const clang::FileEntry*, size_t> owners;
+        llvm::DenseSet<clang::FileID> ownedFiles;
+    };
+
+    // Gives each header the FileID of its first entry, before any of its
+    // comments or directives reach the callbacks; include guards keep later
+    // inclusions from entering it again. Added after the headers' callbacks,
+    // so that it runs first and their FileChanged sees the FileID set
+    class OwnedFileTracker : public clang::PPCallbacks {
+        public:
+            OwnedFileTracker(clang::SourceManager& SM, UmbrellaState& state) : SM(SM), state(state) {}
+
+            void FileChanged(clang::SourceLocation loc, FileChangeReason reason,
+                             clang::SrcMgr::CharacteristicKind, clang::FileID) override {
+                if (reason != EnterFile) {
+                    return;
+                }
+                clang::FileID file = SM.getFileID(loc);
+                auto it = state.owners.find(SM.getFileEntryForID(file));
+                if (it == state.owners.end()) {
+                    return;
+                }
+                UmbrellaHeader& header = state.headers[it->second];
+                if (header.entered) {
+                    return;
+                }
+                header.entered = true;
+                header.alphaContext->setOwnedFile(file);
+                header.betaContext->setOwnedFile(file);
+                state.ownedFiles.insert(file);
+            }
+
+        private:
+            clang::SourceManager& SM;
+            UmbrellaState& state;
+    };
+
+    class UmbrellaConsumer : public clang::ASTConsumer {
+        public:
+            UmbrellaConsumer(alpha::APISession* alphaSession, beta::APISession* betaSession, UmbrellaState& state)
+                : alphaSession(alphaSession), betaSession(betaSession), state(state) {}
+
+            void HandleTranslationUnit(clang::ASTContext& clangContext) override {
+                armor::profile::PhaseTimer timer(armor::profile::Phase::HANDLE_TRANSLATION_UNIT);
+                if (clangContext.getDiagnostics().hasErrorOccurred()) {
+                    // The caller re-parses the headers one by one; only let EndSourceFileAction finalize
+                    for (UmbrellaHeader& header : state.headers) {
+                        header.betaContext->addClangASTContext(&clangContext);
+                    }
+                    return;
+                }
+                // One pass per header; TraverseDecl prunes the other headers' subtrees
+                for (UmbrellaHeader& header : state.headers) {
+                    armor::profile::HeaderScope headerScope(header.fileName);
+                    {
+                        armor::profile::TraceSpan span("alpha_normalize");
+                        alpha::ASTNormalizeConsumer(alphaSession, header.alphaContext).HandleTranslationUnit(clangContext);
+                    }
+                    armor::profile::TraceSpan span("beta_normalize");
+                    beta::ASTNormalizeConsumer(betaSession, header.betaContext).HandleTranslationUnit(clangContext);
+                }
+            }
+
+            bool shouldSkipFunctionBody(clang::Decl* D) override {
+                const clang::SourceManager& SM = D->getASTContext().getSourceManager();
+                return !state.ownedFiles.count(SM.getFileID(SM.getExpansionLoc(D->getLocation())));
+            }
+
+        private:
+            alpha::APISession* alphaSession;
+            beta::APISession* betaSession;
+            UmbrellaState& state;
+    };
+
+    // Parses the generated umbrella source and attributes its headers' contents
+    // to their own contexts; the alpha fatal-directive callbacks are left out,
+    // since a failed include fails the umbrella and its headers are re-parsed alone
+    class UmbrellaAction : public clang::ASTFrontendAction {
+        public:
+            UmbrellaAction(alpha::APISession* alphaSession, beta::APISession* betaSession, UmbrellaState& state)
+                : alphaSession(alphaSession), betaSession(betaSession), state(state) {}
+
+            std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance& CI, clang::StringRef inFile) override {
+                // The shared parse is profiled under the umbrella, each header's normalization under the header
+                headerScope.emplace(inFile);
+                processTimer.emplace(armor::profile::Phase::PROCESS_FILE);
+                if (betaSession->getSkipForeignBodies()) {
+                    CI.getFrontendOpts().SkipFunctionBodies = true;
+                }
+
+                clang::SourceManager& SM = CI.getSourceManager();
+                for (size_t i = 0; i < state.headers.size(); ++i) {
+                    UmbrellaHeader& header = state.headers[i];
+                    if (auto entry = CI.getFileManager().getFile(header.absolutePath)) {
+                        state.owners.try_emplace(*entry, i);
+                    }
+                    if (betaSession->getParseMode() == FULL_MODE) {
+                        auto preprocessor = std::make_unique<beta::ASTNormalizerPreprocessor>(&SM, CI.getLangOpts(), header.betaContext);
+                        header.preprocessor = preprocessor.get();
+                        CI.getPreprocessor().addPPCallbacks(std::move(preprocessor));
+                        header.commentHandler = new beta::CommentHandler(&SM, header.betaContext, header.preprocessor);
+                        CI.getPreprocessor().addCommentHandler(header.commentHandler);
+                    }
+                }
+                CI.getPreprocessor().addPPCallbacks(std::make_unique<OwnedFileTracker>(SM, state));
+
+                return std::make_unique<UmbrellaConsumer>(alphaSession, betaSession, state);
+            }
+
+            void EndSourceFileAction() override {
+                clang::CompilerInstance& CI = getCompilerInstance();
+                for (UmbrellaHeader& header : state.headers) {
+                    if (header.preprocessor) {
+                        header.preprocessor->finalize();
+                        header.preprocessor = nullptr;
+                    }
+                    if (header.commentHandler) {
+                        header.commentHandler->finalize();
+                        CI.getPreprocessor().removeCommentHandler(header.commentHandler);
+                        delete header.commentHandler;
+                        header.commentHandler = nullptr;
+                    }
+                    header.betaContext->getSourceRangeTracker().releaseSourceHashIndex();
+                    header.betaContext->getSourceRangeTracker().releaseRanges();
+                    header.betaContext->clearASTCaches();
+                    header.betaContext->freeze();
+                }
+                clang::ASTFrontendAction::EndSourceFileAction();
+                processTimer.reset();
+                headerScope.reset();
+            }
+
+        private:
+            alpha::APISession* alphaSession;
+            beta::APISession* betaSession;
+            UmbrellaState& state;
+            std::optional<armor::profile::HeaderScope> headerScope;
+            std::optional<armor::profile::PhaseTimer> processTimer;
+    };
+
+    class UmbrellaActionFactory : public clang::tooling::FrontendActionFactory {
+        public:
+            UmbrellaActionFactory(alpha::APISession* alphaSession, beta::APISession* betaSession, UmbrellaState& state)
+                : alphaSession(alphaSession), betaSession(betaSession), state(state) {}
+
+            std::unique_ptr<clang::FrontendAction> create() override {
+                return std::make_unique<UmbrellaAction>(alphaSession, betaSession, state);
+            }
+
+        private:
+            alpha::APISession* alphaSession;
+            beta::APISession* betaSession;
+            UmbrellaState& state;
+    };
+
+    // Parsed as the project root's umbrella source; only ever mapped in memory
+    constexpr const char* UMBRELLA_SOURCE = "armor_umbrella.h";
+
+    // The base flags, every header's include directory chain in first-seen
+    // order, then the version's PCH
+    std::vector<std::string> umbrellaCompileFlags(const std::string& project,
+                                                  const std::vector<std::string>& files,
+                                                  const std::vector<std::string>& includePaths,
+                                                  const std::vector<std::string>& macroFlags,
+                                                  LANG_OPTIONS lang,
+                                                  const std::string& pch) {
+        std::vector<std::string> flags = armor::buildBaseCompileFlags(project, includePaths, macroFlags, lang);
+        size_t baseSize = flags.size();
+        llvm::StringSet<> seen;
+        for (const auto& file : files) {
+            std::vector<std::string> headerFlags = armor::buildCompileFlags(project, file, includePaths, macroFlags, lang);
+            for (size_t k = baseSize; k < headerFlags.size(); ++k) {
+                if (seen.insert(headerFlags[k]).second) {
+                    flags.push_back(std::move(headerFlags[k]));
+                }
+            }
+        }
+        armor::PrecompiledHeaderCache::addIncludeFlags(flags, pch);
+        return flags;
+    }
+
+    std::vector<std::string> commandLineOf(const clang::tooling::CompilationDatabase& compDB,
+                                           const std::string& fileName) {
+        std::vector<clang::tooling::CompileCommand> commands = compDB.getCompileCommands(fileName);
+        return commands.empty() ? std::vector<std::string>() : std::move(commands.front().CommandLine);
+    }
+
+    // The contexts of `file1` are read from `session1` and those of `file2` from `session2`
+    PARSING_STATUS reportParsedHeaderPair(const armor::SinglePassSession& session1,
+                                          const armor::SinglePassSession& session2,
+                                          const std::string& project1,
+                                          const std::string& file1,
+                                          const std::string& file2,
+                                          const std::string& reportFormat,
+                                          PARSING_STATUS header1ParsingStatus,
+                                          PARSING_STATUS header2ParsingStatus,
+                                          bool dumpAstDiff,
+                                          bool verdictOnly,
+                                          const armor::HeaderChanges* changes,
+                                          const armor::OutputPaths& outputs,
+                                          unsigned diffJobs) {
+        bool timedOut1 = session1.timedOut(file1);
+        bool timedOut2 = session2.timedOut(file2);
+        if (timedOut1 || timedOut2) {
+            const char* version = timedOut1 && timedOut2 ? "both versions" : timedOut1 ? "the older version"
+                                                                                       : "the newer version";
+            armor::reportTimedOutHeaderPair(project1, file1,
+                                            std::string("Parsing ") + version + " ran past --header-timeout",
+                                            reportFormat, verdictOnly, outputs);
+            return FATAL_ERRORS;
+        }
+
+        PARSING_STATUS finalParsingStatus = header1ParsingStatus == header2ParsingStatus ? header1ParsingStatus : FATAL_ERRORS;
+        armor::profile::HeaderScope profileScope(file1);
+        auto start = std::chrono::steady_clock::now();
+        auto emitReported = [&]() {
+            armor::Metrics::getInstance().observe(armor::Metrics::Phase::DIFF, std::chrono::steady_clock::now() - start);
+            armor::EventStream& events = armor::EventStream::getInstance();
+            if (!events.isOpen()) {
+                return;
+            }
+            std::string header = std::filesystem::relative(file1, project1).string();
+            ReportSummaries::Summary summary;
+            nlohmann::json fields{
+                {"header",  header},
+                {"parser",  finalParsingStatus == NO_FATAL_ERRORS ? "beta" : "alpha"},
+                {"report",  !verdictOnly && outputs.writeReports},
+                {"seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()}};
+            if (ReportSummaries::getInstance().find(header, summary)) {
+                fields["compatibility"] = summary.overallStatus;
+            }
+            events.emit("diff_done", std::move(fields));
+        };
+
+        if (verdictOnly) {
+            armor::profile::TraceSpan span("verdict");
+            if (finalParsingStatus == NO_FATAL_ERRORS) {
+                reportHeaderPairVerdictBeta(project1, file1, session1.getBetaContext(file1),
+                                            session2.getBetaContext(file2), changes, diffJobs);
+            }
+            else {
+                reportHeaderPairVerdictAlpha(project1, file1, session1.getAlphaContext(file1),
+                                             session2.getAlphaContext(file2));
+            }
+            emitReported();
+            return finalParsingStatus;
+        }
+
+        // The beta report and dump overwrite the alpha ones, so the alpha diff
+        // is only made for the pairs beta cannot compare
+        if (finalParsingStatus == NO_FATAL_ERRORS) {
+            armor::info() << "Reporting Headers via beta parser\n";
+            armor::profile::TraceSpan span("beta_report");
+            reportHeaderPairBeta(project1, file1, reportFormat,
+                                 session1.getBetaContext(file1), session2.getBetaContext(file2), dumpAstDiff, changes,
+                                 outputs, diffJobs);
+        }
+        else {
+            armor::info() << "Processing Headers stopped at alpha parser\n";
+            armor::profile::TraceSpan span("alpha_report");
+            reportHeaderPairAlpha(project1, file1, reportFormat,
+                                  session1.getAlphaContext(file1), session2.getAlphaContext(file2), dumpAstDiff,
+                                  outputs);
+        }
+        emitReported();
+        return finalParsingStatus;
+    }
+
+    // `flags` are the header's own compile flags, without the PCH, as the triage looks them up
+    void recordIncludes(const armor::IncludeGraph& includeGraph, const armor::SinglePassSession& session,
+                        const std::string& fileName, const std::vector<std::string>& flags) {
+        std::vector<std::string> files = session.getReadFiles(fileName);
+        if (!files.empty()) {
+            includeGraph.record(fileName, flags, files);
+        }
+    }
+
+    /**
+     * The -I flags that let the includes `fileName` failed on resolve against
+     * the headers of `project`, leaving out directories `flags` already has.
+     */
+    std::vector<std::string> resolveFailedIncludes(const armor::SinglePassSession& session,
+                                                   const std::string& project, const std::string& fileName,
+                                                   const std::vector<std::string>& flags) {
+        std::vector<std::string> added;
+        alpha::ASTNormalizedContext* context = session.getAlphaContext(fileName);
+        if (!context || context->getSourceRangeTracker().getFatalDirectives().empty()) {
+            return added;
+        }
+        std::shared_ptr<const armor::IncludeResolver> resolver = armor::IncludeResolver::forRoot(project);
+        for (const auto& directive : context->getSourceRangeTracker().getFatalDirectives()) {
+            std::string dir = resolver->resolve(directive.Header, directive.File);
+            if (dir.empty()) {
+                continue;
+            }
+            std::string flag = "-I" + dir;
+            if (std::find(flags.begin(), flags.end(), flag) == flags.end() &&
+                std::find(added.begin(), added.end(), flag) == added.end()) {
+                added.push_back(std::move(flag));
+            }
+        }
+        return added;
+    }
+
+    // Parses both versions of a pair with their full compile flags, the older into `session1`, the newer into `session2`
+    std::pair<PARSING_STATUS, PARSING_STATUS> parseHeaderPair(armor::SinglePassSession& session1,
+                                                              armor::SinglePassSession& session2,
+                                                              const std::string& project1, const std::string& file1,
+                                                              const std::vector<std::string>& flags1,
+                                                              const std::string& project2, const std::string& file2,
+                                                              const std::vector<std::string>& flags2) {
+        auto compDB1 = std::make_unique<clang::tooling::FixedCompilationDatabase>(project1, flags1);
+        auto compDB2 = std::make_unique<clang::tooling::FixedCompilationDatabase>(project2, flags2);
+
+        armor::info() << "Processing File1 : " << file1 << "\n";
+        for (auto& x : flags1) {
+            armor::info() << "Clang search path : " << x << "\n";
+        }
+        armor::info() << "Processing File2 : " << file2 << "\n";
+        for (auto& x : flags2) {
+            armor::info() << "Clang search path : " << x << "\n";
+        }
+
+        RootDiffPipeline* pipeline = isPipelinedDiffEnabled() ? &session2.pipelineDiff(file2) : nullptr;
+
+        // The two translation units share no state, so the
+        //    newer version is parsed on a second thread while this one parses the older.
+        std::future<PARSING_STATUS> header2Future = std::async(std::launch::async,
+            [&session2, &file2, compDB = std::move(compDB2)]() mutable {
+                return session2.processFile(file2, std::move(compDB));
+            });
+        PARSING_STATUS header1ParsingStatus = session1.processFile(file1, std::move(compDB1));
+        if (pipeline) {
+            // Parsed or loaded, the older version is complete; the beta diff never reads a broken one
+            pipeline->setBaseline(header1ParsingStatus == NO_FATAL_ERRORS ? session1.getBetaContext(file1) : nullptr);
+        }
+        return {header1ParsingStatus, header2Future.get()};
+    }
+
+}
+
+void armor::setHeaderTimeout(double seconds) {
+    headerTimeoutSeconds() = seconds;
+}
+
+void armor::setIncludeResolution(bool enabled) {
+    includeResolutionEnabled() = enabled;
+}
+
+void armor::setConcurrentNormalize(bool enabled) {
+    concurrentNormalizeEnabled() = enabled;
+}
+
+void armor::setAstCache(bool enabled) {
+    astCacheEnabled() = enabled;
+}
+
+armor::SinglePassSession::SinglePassSession(const ContextCache* cache, PARSE_MODE parseMode, bool skipForeignBodies,
+                                            const ApiFilter* apiFilter)
+    : cache(cache) {
+    if (cache && astCacheEnabled() && parseMode == API_ONLY_MODE) {
+        astCache = std::make_unique<AstCache>(cache->getDirectory(), skipForeignBodies);
+    }
+    betaSession.setParseMode(parseMode);
+    betaSession.setSkipForeignBodies(skipForeignBodies);
+    alphaSession.setApiFilter(apiFilter);
+    betaSession.setApiFilter(apiFilter);
+}
+
+PARSING_STATUS armor::SinglePassSession::processFile(const std::string& fileName,
+                                                     std::unique_ptr<clang::tooling::FixedCompilationDatabase> compDB) {
+    return processFiles({fileName}, *compDB).front();
+}
+
+std::vector<PARSING_STATUS> armor::SinglePassSession::processFiles(const std::vector<std::string>& fileNames,
+                                                                   const clang::tooling::CompilationDatabase& compDB) {
+    std::vector<PARSING_STATUS> statuses(fileNames.size(), NO_FATAL_ERRORS);
+    std::vector<std::string> toParse;
+    std::vector<size_t> parsedIndex;
+    std::vector<std::vector<std::string>> commandLines(fileNames.size());
+
+    for (size_t i = 0; i < fileNames.size(); ++i) {
+        const std::string& fileName = fileNames[i];
+        alphaSession.createNormalizedASTContext(fileName);
+        betaSession.createNormalizedASTContext(fileName);
+        {
+            std::lock_guard<std::mutex> lock(pipelinesMutex);
+            auto pipeline = pipelines.find(fileName);
+            if (pipeline != pipelines.end()) {
+                betaSession.getContext(fileName)->setDiffPipeline(pipeline->second.get());
+            }
+        }
+        // A buffered version is not what the cache validates its entries against
+        if (cache && !(buffers && buffers->covers(fileName))) {
+            commandLines[i] = commandLineOf(compDB, fileName);
+            armor::profile::HeaderScope profileScope(fileName);
+            armor::profile::PhaseTimer timer(armor::profile::Phase::CACHE_LOAD);
+            armor::MetricsTimer metricsTimer(armor::Metrics::Phase::CACHE_LOAD);
+            std::vector<std::string> files;
+            if (cache->load(fileName, commandLines[i], *alphaSession.getContext(fileName),
+                            *betaSession.getContext(fileName), &files)) {
+                rememberReadFiles(fileName, std::move(files), commandLines[i]);
+                armor::EventStream::getInstance().emit("cache_hit", {{"file", fileName}});
+                continue;
+            }
+            if (astCache) {
+                bool stored = normalizeStoredAst(fileName, commandLines[i]);
+                armor::Metrics::getInstance().countCache(armor::Metrics::CacheTier::AST, stored);
+                if (stored) {
+                    armor::EventStream::getInstance().emit("cache_hit", {{"file", fileName}, {"ast", true}});
+                    continue;
+                }
+            }
+        }
+        toParse.push_back(fileName);
+        parsedIndex.push_back(i);
+    }
+    if (toParse.empty()) {
+        return statuses;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(timedOutMutex);
+        for (const std::string& fileName : toParse) {
+            timedOutFiles.erase(fileName);
+        }
+    }
+    llvm::StringMap<std::string> fileKeys = armor::mapBatchInputs(toParse);
+    llvm::StringMap<std::vector<std::string>> dependencies;
+    // Whether a parse read a buffered file, which the caches validate nothing against
+    auto readsBuffer = [this](const std::string& fileName, const std::vector<std::string>& files) {
+        return buffers && (buffers->covers(fileName) ||
+                           std::any_of(files.begin(), files.end(),
+                                       [this](const std::string& file) { return buffers->find(file) != nullptr; }));
+    };
+    AstHandler onAst;
+    if (astCache) {
+        onAst = [&](const std::string& fileKey, llvm::StringRef ast) {
+            auto index = std::find(fileNames.begin(), fileNames.end(), fileKey);
+            const std::vector<std::string>& files = dependencies[fileKey];
+            if (index != fileNames.end() && !readsBuffer(fileKey, files)) {
+                astCache->store(fileKey, commandLines[index - fileNames.begin()], files, ast);
+            }
+        };
+    }
+    SinglePassActionFactory factory(&alphaSession, &betaSession, fileKeys, cache ? &dependencies : nullptr,
+                                    [this](const std::string& fileKey) {
+                                        std::lock_guard<std::mutex> lock(timedOutMutex);
+                                        timedOutFiles.insert(fileKey);
+                                    },
+                                    std::move(onAst));
+    std::vector<PARSING_STATUS> parsed = armor::runFrontendActionBatch(toParse, compDB, factory, buffers);
+
+    for (size_t j = 0; j < toParse.size(); ++j) {
+        size_t i = parsedIndex[j];
+        statuses[i] = parsed[j];
+
+        // Only clean parses are cached; broken ones must keep reporting their errors
+        if (!cache || parsed[j] != NO_FATAL_ERRORS) {
+            continue;
+        }
+        const std::vector<std::string>& commandLine = commandLines[i];
+        std::vector<std::string>& files = dependencies[fileNames[i]];
+        rememberReadFiles(fileNames[i], files, commandLine);
+        if (readsBuffer(fileNames[i], files)) {
+            continue;
+        }
+
+        // Files behind a PCH are not read by the TU; the PCH itself stands in for them
+        auto pchFlag = std::find(commandLine.begin(), commandLine.end(), "-include-pch");
+        if (pchFlag != commandLine.end() && std::next(pchFlag) != commandLine.end()) {
+            files.push_back(*std::next(pchFlag));
+        }
+        cache->store(fileNames[i], commandLine, files,
+                     *alphaSession.getContext(fileNames[i]), *betaSession.getContext(fileNames[i]));
+    }
+    return statuses;
+}
+
+bool armor::SinglePassSession::normalizeStoredAst(const std::string& fileName,
+                                                  const std::vector<std::string>& commandLine) {
+    armor::profile::HeaderScope profileScope(fileName);
+    std::vector<std::string> files;
+    std::unique_ptr<clang::ASTUnit> unit;
+    {
+        armor::profile::PhaseTimer timer(armor::profile::Phase::CACHE_LOAD);
+        unit = astCache->load(fileName, commandLine, &files);
+    }
+    if (!unit) {
+        return false;
+    }
+    alpha::ASTNormalizedContext* alphaContext = alphaSession.getContext(fileName);
+    beta::ASTNormalizedContext* betaContext = betaSession.getContext(fileName);
+    {
+        // The loaded unit was clean when stored; API-only contexts need no preprocessor callbacks
+        armor::profile::PhaseTimer timer(armor::profile::Phase::HANDLE_TRANSLATION_UNIT);
+        clang::ASTContext& clangContext = unit->getASTContext();
+        {
+            armor::profile::TraceSpan span("alpha_normalize");
+            alpha::ASTNormalizeConsumer(&alphaSession, alphaContext).HandleTranslationUnit(clangContext);
+        }
+        armor::profile::TraceSpan span("beta_normalize");
+        beta::ASTNormalizeConsumer(&betaSession, betaContext).HandleTranslationUnit(clangContext);
+    }
+    betaContext->getSourceRangeTracker().releaseSourceHashIndex();
+    betaContext->getSourceRangeTracker().releaseRanges();
+    betaContext->clearASTCaches();
+    betaContext->freeze();
+
+    // Entries of this version are written back, so the next run loads the contexts themselves
+    cache->store(fileName, commandLine, files, *alphaContext, *betaContext);
+    rememberReadFiles(fileName, std::move(files), commandLine);
+    return true;
+}
+
+PARSING_STATUS armor::SinglePassSession::processUmbrella(const std::vector<std::string>& fileNames,
+                                                         const std::string& umbrellaName,
+                                                         const clang::tooling::CompilationDatabase& compDB) {
+    UmbrellaState state;
+    std::string contents;
+    // The headers' contexts normalize one AST, so its USRs and type strings are computed once for all
+    auto sharedStrings = std::make_shared<armor::ShardedStringCache>();
+    for (const auto& fileName : fileNames) {
+        alphaSession.createNormalizedASTContext(fileName);
+        betaSession.createNormalizedASTContext(fileName);
+        betaSession.getContext(fileName)->shareASTStrings(sharedStrings);
+        std::string absolutePath = clang::tooling::getAbsolutePath(fileName);
+        contents += "#include \"" + absolutePath + "\"\n";
+        state.headers.push_back({fileName, std::move(absolutePath), alphaSession.getContext(fileName),
+                                 betaSession.getContext(fileName)});
+    }
+
+    UmbrellaActionFactory factory(&alphaSession, &betaSession, state);
+    PARSING_STATUS status = armor::runFrontendActionOnBuffer(umbrellaName, contents, compDB, factory);
+    for (const UmbrellaHeader& header : state.headers) {
+        if (!header.entered) {
+            // Its include guard was already defined elsewhere; it has no file of its own here
+            armor::info() << "Umbrella " << umbrellaName << " never entered " << header.fileName << "\n";
+            status = FATAL_ERRORS;
+        }
+    }
+    return status;
+}
+
+alpha::ASTNormalizedContext* armor::SinglePassSession::getAlphaContext(const std::string& fileName) const {
+    return alphaSession.getContext(fileName);
+}
+
+beta::ASTNormalizedContext* armor::SinglePassSession::getBetaContext(const std::string& fileName) const {
+    return betaSession.getContext(fileName);
+}
+
+std::vector<std::string> armor::SinglePassSession::getReadFiles(const std::string& fileName) const {
+    std::lock_guard<std::mutex> lock(readFilesMutex);
+    auto it = readFiles.find(fileName);
+    return it == readFiles.end() ? std::vector<std::string>() : it->second;
+}
+
+RootDiffPipeline& armor::SinglePassSession::pipelineDiff(const std::string& fileName) {
+    std::lock_guard<std::mutex> lock(pipelinesMutex);
+    std::unique_ptr<RootDiffPipeline>& pipeline = pipelines[fileName];
+    if (!pipeline) {
+        pipeline = std::make_unique<RootDiffPipeline>();
+    }
+    return *pipeline;
+}
+
+void armor::SinglePassSession::releaseContexts(const std::string& fileName) {
+    {
+        std::lock_guard<std::mutex> lock(pipelinesMutex);
+        pipelines.erase(fileName);
+    }
+    alphaSession.removeContext(fileName);
+    betaSession.removeContext(fileName);
+    std::lock_guard<std::mutex> lock(readFilesMutex);
+    readFiles.erase(fileName);
+}
+
+bool armor::SinglePassSession::timedOut(const std::string& fileName) const {
+    std::lock_guard<std::mutex> lock(timedOutMutex);
+    return timedOutFiles.count(fileName) > 0;
+}
+
+void armor::SinglePassSession::rememberReadFiles(const std::string& fileName, std::vector<std::string> files,
+                                                 const std::vector<std::string>& commandLine) {
+    // A cached entry lists the PCH it was parsed against, which is not an include
+    auto pchFlag = std::find(commandLine.begin(), commandLine.end(), "-include-pch");
+    if (pchFlag != commandLine.end() && std::next(pchFlag) != commandLine.end()) {
+        files.erase(std::remove(files.begin(), files.end(), *std::next(pchFlag)), files.end());
+    }
+    std::lock_guard<std::mutex> lock(readFilesMutex);
+    readFiles[fileName] = std::move(files);
+}
+
+PARSING_STATUS armor::processHeaderPairSinglePass(const std::string& project1,
+                       const std::string& file1,
+                       const std::string& project2,
+                       const std::string& file2,
+                       const std::string& reportFormat,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff,
+                       bool verdictOnly,
+                       const std::string& cacheDir,
+                       const std::shared_ptr<RemoteCache>& remoteCache,
+                       PrecompiledHeaderCache* pchCache,
+                       const ChangedRanges* changedRanges,
+                       const ApiFilter* apiFilter,
+                       PARSE_MODE parseMode,
+                       bool skipForeignBodies,
+                       unsigned diffJobs,
+                       const OutputPaths& outputs,
+                       const SourceBuffers* buffers) {
+
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+
+    armor::profile::HeaderScope profileScope(file1);
+    armor::profile::TraceSpan span("compare_header");
+
+    std::vector<std::string> Flags1 = armor::buildCompileFlags(project1, file1, IncludePaths, macroFlags, lang);
+    std::vector<std::string> Flags2 = armor::buildCompileFlags(project2, file2, IncludePaths, macroFlags, lang);
+    std::vector<std::string> headerFlags1 = Flags1;
+    std::vector<std::string> headerFlags2 = Flags2;
+    if (pchCache) {
+        PrecompiledHeaderCache::addIncludeFlags(Flags1,
+            pchCache->get(project1, armor::buildBaseCompileFlags(project1, IncludePaths, macroFlags, lang)));
+        PrecompiledHeaderCache::addIncludeFlags(Flags2,
+            pchCache->get(project2, armor::buildBaseCompileFlags(project2, IncludePaths, macroFlags, lang)));
+    }
+
+    armor::BundleCapture& capture = armor::BundleCapture::getInstance();
+    if (capture.isCapturing()) {
+        capture.recordPair({std::filesystem::relative(file1, project1).string(),
+                            {project1, file1, Flags1}, {project2, file2, Flags2}});
+    }
+
+    std::unique_ptr<ContextCache> cache = cacheDir.empty() ? nullptr : std::make_unique<ContextCache>(cacheDir, parseMode, skipForeignBodies, remoteCache, apiFilter);
+    auto session = std::make_unique<SinglePassSession>(cache.get(), parseMode, skipForeignBodies, apiFilter);
+    // A buffered version parses in a session of its own, so its buffers stay out of the older
+    // version's parse, and its contexts apart from the older one's when both share a root and path
+    std::unique_ptr<SinglePassSession> bufferedSession;
+    if (buffers) {
+        bufferedSession = std::make_unique<SinglePassSession>(cache.get(), parseMode, skipForeignBodies, apiFilter);
+        bufferedSession->setSourceBuffers(buffers);
+    }
+    SinglePassSession& session2 = bufferedSession ? *bufferedSession : *session;
+    auto [header1ParsingStatus, header2ParsingStatus] =
+        parseHeaderPair(*session, session2, project1, file1, Flags1, project2, file2, Flags2);
+
+    // Includes the -I list misses are looked up among the headers of each
+    // root, and the pair parsed once more with the directories found
+    if (includeResolutionEnabled() &&
+        (header1ParsingStatus == FATAL_ERRORS || header2ParsingStatus == FATAL_ERRORS)) {
+        std::vector<std::string> added1 = resolveFailedIncludes(*session, project1, file1, Flags1);
+        std::vector<std::string> added2 = resolveFailedIncludes(session2, project2, file2, Flags2);
+        if (!added1.empty() || !added2.empty()) {
+            for (const std::string& flag : added1) {
+                armor::user_print() << "Resolved an include of " << file1 << " with " << flag << "\n";
+            }
+            for (const std::string& flag : added2) {
+                armor::user_print() << "Resolved an include of " << file2 << " with " << flag << "\n";
+            }
+            Flags1.insert(Flags1.end(), added1.begin(), added1.end());
+            headerFlags1.insert(headerFlags1.end(), added1.begin(), added1.end());
+            Flags2.insert(Flags2.end(), added2.begin(), added2.end());
+            headerFlags2.insert(headerFlags2.end(), added2.begin(), added2.end());
+            session->releaseContexts(file1);
+            session2.releaseContexts(file2);
+            std::tie(header1ParsingStatus, header2ParsingStatus) =
+                parseHeaderPair(*session, session2, project1, file1, Flags1, project2, file2, Flags2);
+        }
+    }
+
+    if (cache) {
+        armor::IncludeGraph includeGraph(cacheDir);
+        recordIncludes(includeGraph, *session, file1, headerFlags1);
+        // What a buffered version includes is not what the disk holds
+        if (!buffers) {
+            recordIncludes(includeGraph, *session, file2, headerFlags2);
+        }
+    }
+
+    PARSING_STATUS finalParsingStatus = reportParsedHeaderPair(*session, session2, project1, file1, file2, reportFormat,
+                                                               header1ParsingStatus, header2ParsingStatus, dumpAstDiff,
+                                                               verdictOnly,
+                                                               changedRanges ? changedRanges->find(project2, file2) : nullptr,
+                                                               outputs, diffJobs);
+
+    return finalParsingStatus;
+}
+
+PARSING_STATUS armor::replayHeaderPairSinglePass(const ReproBundle::HeaderPair& pair,
+                       const std::string& reportFormat,
+                       PARSE_MODE parseMode,
+                       bool skipForeignBodies,
+                       const OutputPaths& outputs) {
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+
+    const ReproBundle::Version& older = pair.older;
+    const ReproBundle::Version& newer = pair.newer;
+    armor::profile::HeaderScope profileScope(older.file);
+    armor::profile::TraceSpan span("compare_header");
+
+    SinglePassSession session(nullptr, parseMode, skipForeignBodies, nullptr);
+    auto [status1, status2] = parseHeaderPair(session, session, older.projectRoot, older.file, older.flags,
+                                              newer.projectRoot, newer.file, newer.flags);
+    return reportParsedHeaderPair(session, session, older.projectRoot, older.file, newer.file, reportFormat,
+                                  status1, status2, false, false, nullptr, outputs, 1);
+}
+
+void armor::reportTimedOutHeaderPair(const std::string& project1,
+                       const std::string& file1,
+                       const std::string& reason,
+                       const std::string& reportFormat,
+                       bool verdictOnly,
+                       const OutputPaths& outputs) {
+    std::string header = std::filesystem::relative(file1, project1).string();
+    const char* overallStatus = serialize(OverAllStatus::TIMED_OUT);
+    armor::user_error() << "Not comparing " << header << ": " << reason << "\n";
+    ReportSummaries::getInstance().record(header, {overallStatus, {}});
+    if (verdictOnly || !outputs.writeReports) {
+        return;
+    }
+    std::string headerName = std::filesystem::path(file1).filename().string();
+    const auto& [jsonReportFile, htmlReportFile] =
+        prepare_report_output_dirs(headerName, outputs, armor::reportFormatOf(reportFormat));
+    generate_json_report(ApiChangeGroups(header), jsonReportFile,
+                         static_cast<int>(ParsedDiffStatus::FATAL_ERRORS),
+                         static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                         "unknown", overallStatus, reason.c_str());
+    CombinedHtmlReport& combined = CombinedHtmlReport::getInstance();
+    if (combined.isOpen()) {
+        combined.addHeader(ApiChangeGroups(header), overallStatus, reason.c_str());
+        return;
+    }
+    generate_html_report(ApiChangeGroups(header), htmlReportFile, NO_PARSER,
+                         static_cast<int>(ParsedDiffStatus::FATAL_ERRORS),
+                         static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                         "unknown", overallStatus, reason.c_str());
+}
+
+PARSING_STATUS armor::reportHeaderPairSinglePass(const SinglePassSession& session1,
+                       const SinglePassSession& session2,
+                       const std::string& project1,
+                       const std::string& file1,
+                       const std::string& file2,
+                       PARSING_STATUS status1,
+                       PARSING_STATUS status2,
+                       const std::string& reportFormat,
+                       bool verdictOnly,
+                       unsigned diffJobs,
+                       const OutputPaths& outputs) {
+    return reportParsedHeaderPair(session1, session2, project1, file1, file2, reportFormat, status1, status2, false,
+                                  verdictOnly, nullptr, outputs, diffJobs);
+}
+
+std::vector<PARSING_STATUS> armor::processHeaderPairsSinglePass(const std::string& project1,
+                       const std::string& project2,
+                       const std::vector<std::pair<std::string, std::string>>& headerPairs,
+                       const std::string& reportFormat,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff,
+                       bool verdictOnly,
+                       const std::string& cacheDir,
+                       const std::shared_ptr<RemoteCache>& remoteCache,
+                       PrecompiledHeaderCache* pchCache,
+                       const ChangedRanges* changedRanges,
+                       const ApiFilter* apiFilter,
+                       PARSE_MODE parseMode,
+                       bool skipForeignBodies,
+                       bool umbrella,
+                       unsigned jobs,
+                       const OutputPaths& outputs,
+                       std::size_t maxMemoryBytes) {
+
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+
+    unsigned workerCount = resolveJobCount(jobs);
+
+    std::string pch1;
+    std::string pch2;
+    if (pchCache) {
+        pch1 = pchCache->get(project1, armor::buildBaseCompileFlags(project1, IncludePaths, macroFlags, lang));
+        pch2 = pchCache->get(project2, armor::buildBaseCompileFlags(project2, IncludePaths, macroFlags, lang));
+    }
+
+    // A header listed twice is parsed once; its duplicates reuse the first result
+    std::vector<size_t> firstOccurrence(headerPairs.size());
+    std::vector<size_t> uniquePairs;
+    llvm::StringMap<size_t> seen;
+    for (size_t i = 0; i < headerPairs.size(); ++i) {
+        auto inserted = seen.try_emplace(headerPairs[i].first, i);
+        firstOccurrence[i] = inserted.first->second;
+        if (inserted.second) {
+            uniquePairs.push_back(i);
+        }
+    }
+
+    HeaderCompilationDatabase compDB1;
+    HeaderCompilationDatabase compDB2;
+    std::vector<std::vector<std::string>> headerFlags1(headerPairs.size());
+    std::vector<std::vector<std::string>> headerFlags2(headerPairs.size());
+    for (size_t i : uniquePairs) {
+        const auto& [file1, file2] = headerPairs[i];
+        std::vector<std::string> Flags1 = armor::buildCompileFlags(project1, file1, IncludePaths, macroFlags, lang);
+        std::vector<std::string> Flags2 = armor::buildCompileFlags(project2, file2, IncludePaths, macroFlags, lang);
+        headerFlags1[i] = Flags1;
+        headerFlags2[i] = Flags2;
+        PrecompiledHeaderCache::addIncludeFlags(Flags1, pch1);
+        PrecompiledHeaderCache::addIncludeFlags(Flags2, pch2);
+        armor::info() << "Processing File1 : " << file1 << "\n";
+        armor::info() << "Processing File2 : " << file2 << "\n";
+        compDB1.addHeader(file1, project1, Flags1);
+        compDB2.addHeader(file2, project2, Flags2);
+    }
+
+    std::unique_ptr<ContextCache> cache = cacheDir.empty() ? nullptr : std::make_unique<ContextCache>(cacheDir, parseMode, skipForeignBodies, remoteCache, apiFilter);
+    std::unique_ptr<IncludeGraph> includeGraph = cache ? std::make_unique<IncludeGraph>(cacheDir) : nullptr;
+    std::vector<std::unique_ptr<SinglePassSession>> sessions;
+    // Per unique pair: the session holding its contexts and the statuses of its two parses
+    std::vector<size_t> pairSession(uniquePairs.size(), 0);
+    std::vector<PARSING_STATUS> pairStatus1(uniquePairs.size(), FATAL_ERRORS);
+    std::vector<PARSING_STATUS> pairStatus2(uniquePairs.size(), FATAL_ERRORS);
+    std::vector<PARSING_STATUS> statuses(headerPairs.size(), FATAL_ERRORS);
+
+    // Reports the unique pairs [first, last), parsed by now, and frees their contexts
+    auto reportPairs = [&](size_t first, size_t last) {
+        if (includeGraph) {
+            for (size_t u = first; u < last; ++u) {
+                size_t i = uniquePairs[u];
+                const SinglePassSession& session = *sessions[pairSession[u]];
+                recordIncludes(*includeGraph, session, headerPairs[i].first, headerFlags1[i]);
+                recordIncludes(*includeGraph, session, headerPairs[i].second, headerFlags2[i]);
+            }
+        }
+        // Workers left over when there are fewer pairs than workers diff the roots of a pair
+        unsigned diffJobs = std::max<unsigned>(1, workerCount / (last - first));
+        armor::parallelFor(last - first, workerCount, [&](std::size_t offset) {
+            size_t u = first + offset;
+            size_t i = uniquePairs[u];
+            const auto& [file1, file2] = headerPairs[i];
+            SinglePassSession& session = *sessions[pairSession[u]];
+            try {
+                statuses[i] = reportParsedHeaderPair(session, session, project1, file1, file2, reportFormat,
+                                                     pairStatus1[u], pairStatus2[u], dumpAstDiff,
+                                                     verdictOnly,
+                                                     changedRanges ? changedRanges->find(project2, file2) : nullptr,
+                                                     outputs, diffJobs);
+            } catch (const std::exception& e) {
+                armor::user_error() << "Failed to report " << file1 << " : " << e.what() << "\n";
+            }
+            session.releaseContexts(file1);
+            session.releaseContexts(file2);
+        });
+    };
+
+    if (umbrella && !uniquePairs.empty()) {
+        std::vector<std::string> files1;
+        std::vector<std::string> files2;
+        for (size_t i : uniquePairs) {
+            files1.push_back(headerPairs[i].first);
+            files2.push_back(headerPairs[i].second);
+        }
+        std::string umbrella1 = project1 + "/" + UMBRELLA_SOURCE;
+        std::string umbrella2 = project2 + "/" + UMBRELLA_SOURCE;
+        clang::tooling::FixedCompilationDatabase umbrellaDB1(
+            project1, umbrellaCompileFlags(project1, files1, IncludePaths, macroFlags, lang, pch1));
+        clang::tooling::FixedCompilationDatabase umbrellaDB2(
+            project2, umbrellaCompileFlags(project2, files2, IncludePaths, macroFlags, lang, pch2));
+
+        // Umbrella contexts are never cached: an entry depends on every header before it
+        auto session = std::make_unique<SinglePassSession>(nullptr, parseMode, skipForeignBodies, apiFilter);
+        PARSING_STATUS status1 = FATAL_ERRORS;
+        PARSING_STATUS status2 = FATAL_ERRORS;
+        armor::parallelFor(2, workerCount, [&](std::size_t t) {
+            if (t == 0) {
+                status1 = session->processUmbrella(files1, umbrella1, umbrellaDB1);
+            }
+            else {
+                status2 = session->processUmbrella(files2, umbrella2, umbrellaDB2);
+            }
+        });
+
+        if (status1 == NO_FATAL_ERRORS && status2 == NO_FATAL_ERRORS) {
+            sessions.push_back(std::move(session));
+            pairStatus1.assign(uniquePairs.size(), NO_FATAL_ERRORS);
+            pairStatus2.assign(uniquePairs.size(), NO_FATAL_ERRORS);
+            reportPairs(0, uniquePairs.size());
+        }
+        else {
+            armor::user_print() << "Umbrella translation unit failed to compile, parsing the headers separately\n";
+        }
+    }
+
+    if (sessions.empty() && !uniquePairs.empty()) {
+        // Each version's headers are split over jobs/2 tools, so both versions of
+        // every group parse side by side and all workers stay busy
+        size_t groupCount = std::max<size_t>(1, std::min<size_t>(workerCount / 2, uniquePairs.size()));
+        for (size_t g = 0; g < groupCount; ++g) {
+            sessions.push_back(std::make_unique<SinglePassSession>(cache.get(), parseMode, skipForeignBodies, apiFilter));
+        }
+
+        size_t baseline = maxMemoryBytes ? residentBytes() : 0;
+        size_t bytesPerPair = 0;
+        for (size_t first = 0; first < uniquePairs.size();) {
+            size_t waveSize = uniquePairs.size() - first;
+            if (maxMemoryBytes) {
+                // The memory of a reported wave is reused by the next, so each wave gets all the room
+                size_t room = maxMemoryBytes > baseline ? maxMemoryBytes - baseline : 0;
+                size_t fitting = bytesPerPair ? room / bytesPerPair : 0;
+                waveSize = std::min(waveSize, std::max(groupCount, fitting));
+            }
+            size_t last = first + waveSize;
+
+            std::vector<std::vector<std::string>> groupFiles1(groupCount);
+            std::vector<std::vector<std::string>> groupFiles2(groupCount);
+            for (size_t u = first; u < last; ++u) {
+                pairSession[u] = (u - first) % groupCount;
+                groupFiles1[pairSession[u]].push_back(headerPairs[uniquePairs[u]].first);
+                groupFiles2[pairSession[u]].push_back(headerPairs[uniquePairs[u]].second);
+            }
+
+            size_t before = maxMemoryBytes ? residentBytes() : 0;
+            std::vector<std::vector<PARSING_STATUS>> groupStatuses1(groupCount);
+            std::vector<std::vector<PARSING_STATUS>> groupStatuses2(groupCount);
+            armor::parallelFor(2 * groupCount, workerCount, [&](std::size_t t) {
+                size_t g = t / 2;
+                if (groupFiles1[g].empty()) {
+                    return;
+                }
+                if (t % 2 == 0) {
+                    groupStatuses1[g] = sessions[g]->processFiles(groupFiles1[g], compDB1);
+                }
+                else {
+                    groupStatuses2[g] = sessions[g]->processFiles(groupFiles2[g], compDB2);
+                }
+            });
+            if (maxMemoryBytes) {
+                size_t after = residentBytes();
+                if (after > before) {
+                    bytesPerPair = std::max(bytesPerPair, (after - before) / waveSize);
+                }
+                armor::info() << "Parsed a wave of " << waveSize << " header pairs, resident memory "
+                              << (after >> 20) << " MiB\n";
+            }
+
+            for (size_t u = first; u < last; ++u) {
+                size_t slot = (u - first) / groupCount;
+                pairStatus1[u] = groupStatuses1[pairSession[u]][slot];
+                pairStatus2[u] = groupStatuses2[pairSession[u]][slot];
+            }
+            reportPairs(first, last);
+            first = last;
+        }
+    }
+
+    for (size_t i = 0; i < headerPairs.size(); ++i) {
+        statuses[i] = statuses[firstOccurrence[i]];
+    }
+
+    DebugConfig::getInstance().flush();
+
+    return statuses;
+}
@@ -0,0 +1,14 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include "subcommand.hpp"
+
+bool armor::parseSubcommand(CLI::App& app, int argc, const char** argv, bool& succeeded) {
+    try {
+        app.parse(argc - 1, argv + 1);
+    } catch (const CLI::ParseError& e) {
+        // Prints the help or the error, and the exit code says which
+        succeeded = app.exit(e) == 0;
+        return false;
+    }
+    return true;
+}
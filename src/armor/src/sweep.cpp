@@ -0,0 +1,233 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
+#include <nlohmann/json.hpp>
+
+#include "bench_sweep.hpp"
+#include "header_selection.hpp"
+#include "logger.hpp"
+#include "memory_usage.hpp"
+#include "options_handler.hpp"
+#include "output_paths.hpp"
+#include "profiler.hpp"
+#include "report_format.hpp"
+#include "subcommand.hpp"
+#include "sweep.hpp"
+#include "work_pool.hpp"
+
+namespace {
+
+    bool writeList(const std::string& file, const std::vector<std::string>& lines) {
+        std::ofstream out(file);
+        for (const std::string& line : lines) {
+            out << line << "\n";
+        }
+        if (!out) {
+            armor::user_error() << "Failed to write " << file << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        size_t middle = values.size() / 2;
+        return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+    }
+
+    // One run of an armor process over `headers`, as run_armor.sh runs a round
+    void runRound(const char* argv0, const armor::BenchSweepConfig& config, const std::vector<std::string>& headers,
+                  const std::string& blockingFile, const std::string& root) {
+        std::vector<std::string> listed;
+        for (const std::string& header : headers) {
+            // With a header directory the headers are named relative to it, by basename
+            listed.push_back(config.headerDir.empty() ? header : llvm::sys::path::filename(header).str());
+        }
+        std::string headersFile = root + "/headers_list.txt";
+        if (!writeList(headersFile, listed)) {
+            return;
+        }
+
+        std::vector<std::string> args{config.base, config.head,
+                                      "-r", "json",
+                                      "--headers-from", headersFile,
+                                      "--ndjson-out", root + "/headers.ndjson",
+                                      "--output-dir", root,
+                                      "--jobs", std::to_string(config.jobs),
+                                      "--profile"};
+        if (!blockingFile.empty()) {
+            args.insert(args.end(), {"--blocking-headers", blockingFile, "--gate-out", root + "/gate.json"});
+        }
+        if (!config.headerDir.empty()) {
+            args.insert(args.end(), {"--header-dir", config.headerDir});
+        }
+        for (const std::string& includePath : config.includePaths) {
+            args.insert(args.end(), {"-I", includePath});
+        }
+        if (!config.macroFlags.empty()) {
+            args.insert(args.end(), {"--macro-flags", config.macroFlags});
+        }
+        if (!config.lang.empty()) {
+            args.insert(args.end(), {"--lang", config.lang});
+        }
+        std::vector<const char*> runArgv{argv0};
+        for (const auto& arg : args) {
+            runArgv.push_back(arg.c_str());
+        }
+        // false also when the run found incompatible changes, which are not what is measured
+        runArmorTool(static_cast<int>(runArgv.size()), runArgv.data());
+    }
+
+}
+
+bool armor::isBenchSweepInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "bench-sweep";
+}
+
+bool armor::runArmorBenchSweep(int argc, const char** argv) {
+    CLI::App app{"ARMOR bench-sweep"};
+    std::string configFile;
+    std::string outputDir;
+    unsigned jobs = 0;
+    unsigned repeat = 0;
+    app.add_option("config", configFile, "Sweep config naming the corpus and its settings")
+        ->required()
+        ->check(CLI::ExistingFile);
+    CLI::Option* jobsOption = app.add_option("-j,--jobs", jobs,
+        "--jobs of every armor run, replacing the config's; 0 picks the CPUs available")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--repeat", repeat, "Times the sweep is run, replacing the config's")
+        ->check(CLI::PositiveNumber);
+    app.add_option("--output-dir", outputDir,
+        "Directory receiving sweep/ and armor_reports/sweep_report.json (default: the working directory)");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::BenchSweepConfig config;
+    armor::HeaderPatterns patterns;
+    try {
+        config = armor::loadBenchSweepConfig(configFile);
+        patterns = armor::loadHeaderPatterns(config.headerConfig, config.branch);
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+    if (jobsOption->count() > 0) {
+        config.jobs = jobs;
+    }
+    if (repeat > 0) {
+        config.repeat = repeat;
+    }
+    // Fixed for every run, so runs of one setting compare
+    config.jobs = armor::resolveJobCount(config.jobs);
+
+    armor::OutputPaths outputs{outputDir};
+    nlohmann::json runs = nlohmann::json::array();
+    std::vector<double> throughputs;
+    std::vector<double> latencies;
+    size_t headerCount = 0;
+    size_t roundCount = 0;
+    for (unsigned run = 1; run <= config.repeat; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        armor::HeaderSelection selection =
+            armor::selectHeaders(patterns, {config.base, config.head}, config.jobs);
+        std::vector<std::string> headers;
+        std::copy_if(selection.headers.begin(), selection.headers.end(), std::back_inserter(headers),
+                     [&config](const std::string& header) {
+                         std::error_code ec;
+                         return std::filesystem::is_regular_file(config.base + "/" + header, ec) &&
+                                std::filesystem::is_regular_file(config.head + "/" + header, ec);
+                     });
+        double selectionSeconds = secondsSince(start);
+        if (headers.empty()) {
+            armor::user_error() << "The patterns of " << config.branch << " select no header under both roots\n";
+            return false;
+        }
+        std::vector<std::vector<std::string>> rounds = armor::scheduleHeaderRounds(headers);
+
+        for (size_t round = 0; round < rounds.size(); ++round) {
+            std::string root = outputs.sweepRoundRoot(run, static_cast<unsigned>(round + 1));
+            std::error_code ec;
+            std::filesystem::create_directories(root, ec);
+            std::string blockingFile;
+            if (!selection.blocking.empty()) {
+                blockingFile = root + "/blocking_headers_final.txt";
+                if (!writeList(blockingFile, selection.blocking)) {
+                    blockingFile.clear();
+                }
+            }
+            runRound(argv[0], config, rounds[round], blockingFile, root);
+            // The profiles of the round live until the next run resets them
+            armor::profile::Profiler::getInstance().forEachProfile(
+                [&latencies](const armor::profile::HeaderProfile& profile) {
+                    if (uint64_t nanos = profile.getWallNanos()) {
+                        latencies.push_back(nanos / 1e6);
+                    }
+                });
+        }
+
+        double seconds = secondsSince(start);
+        double throughput = headers.size() / seconds;
+        throughputs.push_back(throughput);
+        headerCount = headers.size();
+        roundCount = rounds.size();
+        runs.push_back({{"seconds", seconds},
+                        {"selection_ms", selectionSeconds * 1e3},
+                        {"headers_per_second", throughput}});
+        armor::user_print() << "Run " << run << " : " << headers.size() << " headers in " << rounds.size()
+                            << " rounds, " << llvm::format("%.3f s, %.2f headers/s", seconds, throughput) << "\n";
+    }
+
+    // The runs logged under their own roots
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+    armor::LatencySummary latency = armor::summarizeLatencies(latencies);
+    size_t peakResident = armor::peakResidentBytes();
+    nlohmann::json report = {
+        {"config", configFile},
+        {"jobs", config.jobs},
+        {"headers", headerCount},
+        {"rounds", roundCount},
+        {"runs", runs},
+        {"headers_per_second", median(throughputs)},
+        {"latency_ms", {{"count", latency.count}, {"p50", latency.p50}, {"p95", latency.p95},
+                        {"p99", latency.p99}, {"max", latency.max}}},
+        {"peak_rss_bytes", peakResident}
+    };
+    armor::user_print() << llvm::format("Median %.2f headers/s with %u jobs; latency p50 %.1f ms, p95 %.1f ms, "
+                                        "p99 %.1f ms; peak RSS %.1f MiB\n",
+                                        median(throughputs), config.jobs, latency.p50, latency.p95, latency.p99,
+                                        peakResident / 1048576.0);
+
+    std::string file = outputs.sweepJsonFile();
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(file).parent_path(), ec);
+    std::ofstream out(file);
+    if (!out) {
+        armor::user_error() << "Failed to write " << file << "\n";
+        return false;
+    }
+    armor::writeReportDocument(out, report, armor::ReportFormat::JSON);
+    armor::user_print() << "Sweep report : " << file << "\n";
+    return true;
+}
@@ -0,0 +1,161 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "llvm/ADT/StringRef.h"
+
+#include "api_filter.hpp"
+#include "comm_def.hpp"
+#include "compile_flags.hpp"
+#include "context_cache.hpp"
+#include "header_compilation_database.hpp"
+#include "header_selection.hpp"
+#include "logger.hpp"
+#include "output_paths.hpp"
+#include "remote_cache.hpp"
+#include "single_pass.hpp"
+#include "subcommand.hpp"
+#include "warm.hpp"
+#include "work_pool.hpp"
+
+namespace {
+
+    // Headers parsed through one ClangTool; a batch's contexts are resident until it is stored
+    constexpr std::size_t WARM_BATCH_SIZE = 32;
+
+    const std::vector<std::string> WARM_EXTENSIONS = {".h", ".hpp"};
+
+}
+
+bool armor::isWarmInvocation(int argc, const char** argv) {
+    return argc > 1 && llvm::StringRef(argv[1]) == "warm";
+}
+
+bool armor::runArmorWarm(int argc, const char** argv) {
+    CLI::App app{"ARMOR warm"};
+    std::string root;
+    std::vector<std::string> headers;
+    std::string headerSubDir;
+    std::string cacheDir;
+    std::string remoteCacheUrl;
+    std::vector<std::string> includePaths;
+    std::string macroFlags;
+    std::string language = LANG_CPP;
+    std::string mode = MODE_FULL;
+    bool skipForeignBodies = false;
+    std::string apiFilterFile;
+    unsigned jobs = 1;
+    std::string outputDir;
+    std::string logFile;
+    app.add_option("root", root, "Project root of the version to warm, as the comparisons will name it")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    app.add_option("headers", headers,
+        "Headers relative to --header-dir or the root (default: every .h and .hpp file below it)");
+    app.add_option("--header-dir", headerSubDir, "Subdirectory of the root the headers are relative to");
+    app.add_option("--cache-dir", cacheDir, "Directory of the persistent normalized-API cache to fill")->required();
+    app.add_option("--remote-cache", remoteCacheUrl,
+        "HTTP(S) URL of a cache shared between machines; new entries are uploaded to it");
+    app.add_option("-I,--include-paths", includePaths, "Include paths for header dependencies");
+    app.add_option("-m,--macro-flags", macroFlags, "Macro flags to be passed for headers");
+    app.add_option("--lang,-l", language, "Language mode: cpp (default) or c")
+        ->transform(CLI::IsMember({LANG_C, LANG_CPP}, CLI::ignore_case));
+    app.add_option("--mode", mode, "Parse mode: full (default) or api-only")
+        ->check(CLI::IsMember({MODE_FULL, MODE_API_ONLY}));
+    app.add_flag("--skip-foreign-bodies", skipForeignBodies, "Do not parse function bodies outside the headers");
+    app.add_option("--api-filter", apiFilterFile, "Only keep the declarations the filter file selects")
+        ->check(CLI::ExistingFile);
+    app.add_option("-j,--jobs", jobs, "Headers parsed in parallel (default 1, 0 for all cores)")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--output-dir", outputDir, "Directory receiving the diagnostics (default: the working directory)");
+    app.add_option("--log-file", logFile,
+        "Diagnostics log of the run (default: debug_output/logs/diagnostics.log under --output-dir)");
+    bool succeeded = false;
+    if (!armor::parseSubcommand(app, argc, argv, succeeded)) {
+        return succeeded;
+    }
+
+    armor::OutputPaths outputs{outputDir, logFile};
+    if (!DebugConfig::getInstance().initialize(outputs.logFile())) {
+        armor::user_error() << "Failed to open diagnostics log <" << outputs.logFile() << ">, using stderr\n";
+    }
+    std::vector<std::string> macros;
+    std::istringstream iss(macroFlags);
+    std::string flag;
+    while (iss >> flag) {
+        macros.push_back(flag);
+    }
+    LANG_OPTIONS lang = language == LANG_C ? LANG_OPTIONS::C : LANG_OPTIONS::CPP;
+    PARSE_MODE parseMode = mode == MODE_API_ONLY ? API_ONLY_MODE : FULL_MODE;
+    unsigned workerCount = armor::resolveJobCount(jobs);
+    std::unique_ptr<armor::ApiFilter> apiFilter;
+    std::shared_ptr<armor::RemoteCache> remoteCache;
+    try {
+        if (!apiFilterFile.empty()) {
+            apiFilter = std::make_unique<armor::ApiFilter>(armor::ApiFilter::load(apiFilterFile));
+        }
+        if (!remoteCacheUrl.empty()) {
+            remoteCache = armor::createRemoteCache(remoteCacheUrl);
+        }
+    } catch (const std::exception& e) {
+        armor::user_error() << e.what() << "\n";
+        return false;
+    }
+
+    // Paths as a regular run builds them, since the cache is keyed by the command line
+    std::string dir = headerSubDir.empty() ? root : root + "/" + headerSubDir;
+    if (headers.empty()) {
+        if (!std::filesystem::is_directory(dir)) {
+            armor::user_error() << "No directory " << dir << "\n";
+            return false;
+        }
+        headers = armor::walkHeaderFiles({dir}, WARM_EXTENSIONS, workerCount);
+    }
+    std::vector<std::string> files;
+    armor::HeaderCompilationDatabase compDB;
+    for (const std::string& header : headers) {
+        std::string file = dir + "/" + header;
+        if (!std::filesystem::is_regular_file(file)) {
+            armor::user_error() << "No header " << header << " under " << dir << "\n";
+            return false;
+        }
+        compDB.addHeader(file, root, armor::buildCompileFlags(root, file, includePaths, macros, lang));
+        files.push_back(std::move(file));
+    }
+    if (files.empty()) {
+        armor::user_error() << "No headers to warm under " << dir << "\n";
+        return false;
+    }
+
+    // Sorted neighbours tend to share includes, which a batch's ClangTool reads once
+    armor::ContextCache cache(cacheDir, parseMode, skipForeignBodies, remoteCache, apiFilter.get());
+    std::size_t batchCount = (files.size() + WARM_BATCH_SIZE - 1) / WARM_BATCH_SIZE;
+    std::atomic<std::size_t> failed{0};
+    armor::user_print() << "Warming " << files.size() << " headers of " << root << " into " << cacheDir << "\n";
+    armor::parallelFor(batchCount, workerCount, [&](std::size_t b) {
+        auto first = files.begin() + b * WARM_BATCH_SIZE;
+        std::vector<std::string> batch(first, first + std::min(WARM_BATCH_SIZE, files.size() - b * WARM_BATCH_SIZE));
+        armor::SinglePassSession session(&cache, parseMode, skipForeignBodies, apiFilter.get());
+        std::vector<PARSING_STATUS> statuses = session.processFiles(batch, compDB);
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            if (statuses[i] != NO_FATAL_ERRORS) {
+                armor::user_error() << "Failed to parse " << batch[i] << ", not cached\n";
+                ++failed;
+            }
+            session.releaseContexts(batch[i]);
+        }
+    });
+
+    std::size_t warmed = files.size() - failed;
+    armor::user_print() << "Warmed " << warmed << " of " << files.size() << " headers into " << cacheDir << "\n";
+    return warmed > 0;
+}
@@ -3,11 +3,19 @@
 #pragma once
 
 #include "node.hpp"
+#include "hash_multiset.hpp"
+#include "macro_table.hpp"
+#include "range_digests.hpp"
+#include "sharded_string_cache.hpp"
+#include "source_hash_index.hpp"
+#include "type_usage_index.hpp"
 #include "clang/AST/ASTContext.h"
 #include "clang/Basic/SourceLocation.h"
 #include <cstddef>
 #include <cstdint>
+#include <llvm-14/llvm/ADT/ArrayRef.h>
 #include <llvm-14/llvm/ADT/DenseMap.h>
+#include <llvm-14/llvm/ADT/STLFunctionalExtras.h>
 #include <llvm-14/llvm/ADT/SmallString.h>
 #include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/ADT/StringMap.h>
@@ -15,7 +23,12 @@
 #include <llvm-14/llvm/ADT/StringSet.h>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <utility>
+#include <vector>
+
+class RootDiffPipeline;
 
 namespace beta{
 
@@ -36,9 +49,22 @@ namespace beta{
  * - Comments
  * - Preprocessor directives (active and inactive)
  * - Unhandled declarations
+ * - Macros left defined, by name (see MacroTable)
+ *
+ * Comments are kept as ranges until a diff asks for their hashes, see
+ * getCommentsHashMap.
+ *
+ * The ranges behind the hashes are also recorded in RangeDigests, which
+ * keeps the main file's text when the index is released, so that matching
+ * hashes of two versions can be confirmed with 128-bit digests.
  *
  * Each category maintains both ranges (valid during AST lifetime) and
- * hash maps (valid after AST destruction) for efficient deduplication.
+ * hash multisets (valid after AST destruction) for efficient deduplication;
+ * their fingerprints make comparing two trackers' categories O(1).
+ *
+ * The tracker also owns the SourceHashIndex of the main file, shared by
+ * every producer of those hashes; like the ranges it refers to the source
+ * buffer and is released before the AST goes away.
  */
 class SourceRangeTracker {
 public:
@@ -48,32 +74,33 @@ public:
     SourceRangeTracker() = default;
 
     /**
-     * @brief Returns all comment source ranges.
+     * @brief Returns the comment source ranges not hashed yet, see getCommentsHashMap.
      */
     const llvm::SmallVector<beta::Range, 32>& getComments() const;
 
     /**
-     * @brief Returns all inactive preprocessor directive source ranges.
+     * @brief Returns all inactive preprocessor directive source ranges,
+     *        disjoint and sorted by start offset.
      */
-    const std::map<unsigned, beta::Range>& getInactivePPDirectives() const;
-
-    std::map<unsigned, beta::Range>& getInactivePPDirectives();
+    const llvm::SmallVector<beta::Range, 16>& getInactivePPDirectives() const;
 
-    void moveInactivePPDirectives(std::map<unsigned int, beta::Range>& map);
+    llvm::SmallVector<beta::Range, 16>& getInactivePPDirectives();
 
-    void moveComments(llvm::SmallVector<beta::Range, 32>& ranges);
+    void moveInactivePPDirectives(llvm::SmallVector<beta::Range, 16>& ranges);
 
     /**
-     * @brief Moves inactive unhandled declarations hash map into the tracker.
-     * @param hashMap The hash map to move from.
+     * @brief Takes the comment ranges of `mainBuffer`, to be hashed on demand.
+     *
+     * The buffer must stay alive until releaseSourceHashIndex, which keeps a
+     * copy of it while the comments are not hashed.
      */
-    void moveInactiveUnhandledDeclsHashMap(llvm::DenseMap<uint64_t, int>& hashMap);
+    void moveComments(llvm::SmallVector<beta::Range, 32>& ranges, llvm::StringRef mainBuffer);
 
     /**
-     * @brief Moves comments hash map into the tracker.
+     * @brief Moves inactive unhandled declarations hash map into the tracker.
      * @param hashMap The hash map to move from.
      */
-    void moveCommentsHashMap(llvm::DenseMap<uint64_t, int>& hashMap);
+    void moveInactiveUnhandledDeclsHashMap(HashMultiset& hashMap);
 
     /**
      * @brief Adds a hash to the unhandled declarations hash map.
@@ -84,32 +111,70 @@ public:
     /**
      * @brief Returns all unhandled declaration hashes (mutable).
      */
-    llvm::DenseMap<uint64_t, int>& getUnhandledDeclsHashMap();
+    HashMultiset& getUnhandledDeclsHashMap();
 
     /**
      * @brief Returns all unhandled declaration hashes (const).
      */
-    const llvm::DenseMap<uint64_t, int>& getUnhandledDeclsHashMap() const;
+    const HashMultiset& getUnhandledDeclsHashMap() const;
 
     /**
      * @brief Returns all inactive unhandled declaration hashes (mutable).
      */
-    llvm::DenseMap<uint64_t, int>& getInactiveUnhandledDeclsHashMap();
+    HashMultiset& getInactiveUnhandledDeclsHashMap();
 
     /**
      * @brief Returns all inactive unhandled declaration hashes (const).
      */
-    const llvm::DenseMap<uint64_t, int>& getInactiveUnhandledDeclsHashMap() const;
+    const HashMultiset& getInactiveUnhandledDeclsHashMap() const;
 
     /**
      * @brief Returns all comments hashes (mutable).
+     *
+     * Comments only decide a verdict when nothing else changed, so they are
+     * hashed on the first call rather than during the parse; comments inside
+     * inactive regions are left out.
      */
-    llvm::DenseMap<uint64_t, int>& getCommentsHashMap();
+    HashMultiset& getCommentsHashMap();
 
     /**
-     * @brief Returns all comments hashes (const).
+     * @brief Returns all comments hashes (const), hashing them on the first call.
      */
-    const llvm::DenseMap<uint64_t, int>& getCommentsHashMap() const;
+    const HashMultiset& getCommentsHashMap() const;
+
+    /**
+     * @brief Returns the macros defined in the main file, with the hashes of its #define and #undef lines.
+     */
+    MacroTable& getMacros();
+
+    const MacroTable& getMacros() const;
+
+    /**
+     * @brief Returns the ranges behind the hashes, for confirming matches across versions.
+     */
+    RangeDigests& getRangeDigests();
+
+    const RangeDigests& getRangeDigests() const;
+
+    /**
+     * @brief Returns the range hash index of `mainBuffer`, building it on first use.
+     *
+     * A different buffer replaces the current index.
+     */
+    SourceHashIndex& getSourceHashIndex(llvm::StringRef mainBuffer);
+
+    /**
+     * @brief Drops the range hash index, once no more ranges will be hashed.
+     *
+     * The text of the main file is kept for the range digests, if any range was recorded.
+     */
+    void releaseSourceHashIndex();
+
+    /**
+     * @brief Drops the comment and inactive region ranges, unless comments
+     *        are still to be hashed; the hash multisets stay.
+     */
+    void releaseRanges();
 
     /**
      * @brief Clears all tracked source ranges.
@@ -123,12 +188,94 @@ public:
     bool empty() const;
 
 private:
-    llvm::SmallVector<beta::Range, 32> comments;
-    std::map<unsigned,beta::Range> inactivePPDirectives;
+    void hashComments() const;
+
+    // Until hashComments; the comment ranges are what it consumes
+    mutable llvm::SmallVector<beta::Range, 32> comments;
+    mutable llvm::SmallVector<beta::Range, 16> inactivePPDirectives;
+
+    HashMultiset unhandledDeclsHashMap;
+    mutable HashMultiset commentsHashMap;
+    HashMultiset inactiveUnhandledDeclsHashMap;
+    MacroTable macros;
+    mutable RangeDigests rangeDigests;
 
-    llvm::DenseMap<uint64_t, int> unhandledDeclsHashMap;
-    llvm::DenseMap<uint64_t, int> commentsHashMap;
-    llvm::DenseMap<uint64_t, int> inactiveUnhandledDeclsHashMap;
+    // The main file while it is alive, for comments hashed before releaseSourceHashIndex
+    llvm::StringRef commentBuffer;
+    mutable bool commentsPending = false;
+    // Contexts may be diffed from several threads at once
+    mutable std::mutex commentsMutex;
+
+    std::unique_ptr<SourceHashIndex> sourceHashIndex;
+};
+
+/**
+ * @class NSRNodeMap
+ * @brief Nodes by NSR key; almost every key has one node, overloads have several.
+ *
+ * An open-addressing table whose slot holds a key's node inline. Only a key
+ * given a second node moves its nodes to a spill list, so the common case
+ * costs one slot rather than a heap entry with a reserved node vector. Keys
+ * are not copied: they must reference storage that outlives the map, such as
+ * the string pool of the owning context.
+ */
+class NSRNodeMap {
+    struct Slot {
+        APINode* node;
+        // Index into spills once the key has more than one node
+        uint32_t spill;
+    };
+    using SlotMap = llvm::DenseMap<llvm::StringRef, Slot>;
+
+public:
+    static constexpr uint32_t NO_SPILL = UINT32_MAX;
+
+    /**
+     * @brief A key with its nodes, in insertion order.
+     */
+    struct Entry {
+        llvm::StringRef key;
+        llvm::ArrayRef<APINode*> nodes;
+
+        llvm::StringRef getKey() const { return key; }
+        llvm::ArrayRef<APINode*> getValue() const { return nodes; }
+    };
+
+    class const_iterator {
+        public:
+            const_iterator(SlotMap::const_iterator it, const NSRNodeMap& map) : it(it), map(&map) {}
+
+            Entry operator*() const { return {it->first, map->nodesOf(it->second)}; }
+            const_iterator& operator++() { ++it; return *this; }
+            bool operator==(const const_iterator& other) const { return it == other.it; }
+            bool operator!=(const const_iterator& other) const { return it != other.it; }
+
+        private:
+            SlotMap::const_iterator it;
+            const NSRNodeMap* map;
+    };
+
+    void insert(llvm::StringRef key, APINode* node);
+
+    /**
+     * @brief The nodes of `key` in insertion order; empty if none. Valid until the next insert.
+     */
+    llvm::ArrayRef<APINode*> find(llvm::StringRef key) const;
+
+    size_t size() const { return slots.size(); }
+    bool empty() const { return slots.empty(); }
+    void clear();
+
+    const_iterator begin() const { return const_iterator(slots.begin(), *this); }
+    const_iterator end() const { return const_iterator(slots.end(), *this); }
+
+private:
+    llvm::ArrayRef<APINode*> nodesOf(const Slot& slot) const {
+        return slot.spill == NO_SPILL ? llvm::ArrayRef<APINode*>(slot.node) : llvm::ArrayRef<APINode*>(spills[slot.spill]);
+    }
+
+    SlotMap slots;
+    std::vector<llvm::SmallVector<APINode*, 4>> spills;
 };
 
 /**
@@ -138,9 +285,9 @@ private:
  * This class serves as the central repository for all unique API nodes found during
  * an AST traversal. It maintains two primary data structures:
  *
- * 1. A map (`apiNodesMap`) from a unique identifier (like a USR) to the
- *    corresponding `APINode`. This ensures that each API entity is represented by
- *    a single, unique object, preventing duplication.
+ * 1. A multimap (`apiNodesMap`) from the NSR of each top-level node to the
+ *    nodes declared under it; several nodes only share an NSR when they are
+ *    overloads, which are told apart by USR.
  *
  * 2. A vector (`apiNodes`) of nodes that are considered top-level or
  *    "root" elements of the API (e.g., free functions, global variables, or
@@ -158,30 +305,187 @@ public:
     /**
      * @brief Adds a new node to the normalized tree.
      *
-     * If a node with the same key already exists, it is not replaced.
-     * Use addOrUpdateNode if overwriting is desired.
+     * Nodes sharing a key are kept in insertion order.
      *
-     * @param key The unique string identifier for the node (e.g., USR).
-     * @param node A shared pointer to the APINode.
+     * @param key The NSR of the node, in storage that outlives the context
+     *            (the context's string pool or retained storage).
+     * @param node A node allocated with createNode().
      */
-    void addNode(llvm::StringRef key, const std::shared_ptr<APINode> node);
+    void addNode(llvm::StringRef key, APINode* node);
 
     /**
      * @brief Adds a node to the list of root API nodes.
      *
-     * @param rootNode A const shared pointer to the APINode.
+     * @param rootNode A node allocated with createNode().
+     */
+    void addRootNode(const APINode* rootNode);
+
+    /**
+     * @brief Allocates a node owned by this context.
+     *
+     * The node stays valid until the context is cleared or destroyed.
+     */
+    APINode* createNode();
+
+    /**
+     * @brief Appends `child` to the children of `parent`.
+     */
+    void addChild(APINode& parent, APINode* child);
+
+    /**
+     * @brief Returns the copy of `value` pooled in this context, for APINode string fields.
+     */
+    llvm::StringRef intern(llvm::StringRef value);
+
+    /**
+     * @brief Keeps `storage` alive for the lifetime of the context.
+     *
+     * For node strings that reference external bytes instead of the pool,
+     * such as a mapped cache entry; released by clear().
      */
-    void addRootNode(const std::shared_ptr<const APINode> rootNode);
+    void retainStorage(std::shared_ptr<const void> storage);
+
+    /**
+     * @brief Returns the interned USR of `Decl`, generated once per declaration.
+     *
+     * Redeclarations share the entry of their canonical declaration, whose
+     * location USRs are generated from anyway. Outside overloadable functions
+     * and templates, whose parameter types and arguments only the USR spells,
+     * the USR of a declaration is its NSR and is not generated again.
+     */
+    llvm::StringRef getUSR(const clang::NamedDecl* Decl);
+
+    /**
+     * @brief Returns the interned NSR of `Decl`, generated once per declaration.
+     */
+    llvm::StringRef getNSR(const clang::NamedDecl* Decl);
+
+    /**
+     * @brief Returns the interned type strings of `T`: as written and canonical.
+     *
+     * Each string is printed once per type, as getTypesWithAndWithoutTypeResolution
+     * would print it. Written spellings are keyed by `T` itself, canonical ones
+     * by its canonical type, so every sugar of a type shares one canonical entry.
+     */
+    std::pair<llvm::StringRef, llvm::StringRef> getTypeStrings(clang::QualType T, const clang::ASTContext& Ctx);
+
+    /**
+     * @brief Shares the USR/NSR and type string caches with the other contexts normalizing the current AST.
+     *
+     * Strings another context already computed are looked up in `cache`
+     * rather than generated again, and those computed here are published to
+     * it. The context keeps `cache` alive while its nodes reference it.
+     */
+    void shareASTStrings(std::shared_ptr<armor::ShardedStringCache> cache);
+
+    bool sharesASTStrings() const { return sharedStrings != nullptr; }
+
+    /**
+     * @brief Drops the USR/NSR and type string caches, which are keyed by nodes of the current AST,
+     *        and stops sharing them.
+     */
+    void clearASTCaches();
+
+    /**
+     * @brief Returns an empty context normalizing the same file of the same AST,
+     *        sharing this context's AST strings, for a builder beside this one's.
+     *
+     * It must not outlive this context.
+     */
+    std::unique_ptr<ASTNormalizedContext> createSibling() const;
+
+    /**
+     * @brief Sets the mutex held around what fills caches of the AST while
+     *        builders of several contexts walk it on threads of their own:
+     *        the TypePrinter, line lookups and record layouts. nullptr, the
+     *        default, holds none.
+     */
+    void setASTMutex(std::mutex* mutex) { astMutex = mutex; }
+
+    std::mutex* getASTMutex() const { return astMutex; }
 
     /**
      * @brief Returns a const reference to the entire normalized tree map.
      */
-    const llvm::StringMap<llvm::SmallVector<std::shared_ptr<APINode>,16>>& getTree() const;
+    const NSRNodeMap& getTree() const;
+
+    /**
+     * @brief Returns the number of nodes registered under an NSR key.
+     *
+     * Read-only lookup: unlike StringMap::operator[] it never inserts an empty
+     * bucket for a missing key.
+     */
+    size_t countNodes(llvm::StringRef nsr) const;
+
+    /**
+     * @brief Returns the nodes registered under an NSR key; empty if none.
+     */
+    llvm::ArrayRef<APINode*> findNodes(llvm::StringRef nsr) const;
+
+    /**
+     * @brief Returns the node registered under a USR, or nullptr if none.
+     */
+    const APINode* findNodeByUSR(llvm::StringRef usr) const;
+
+    /**
+     * @brief Calls `visit` with every USR and its node, by USR once frozen.
+     */
+    void forEachUSR(llvm::function_ref<void(llvm::StringRef, const APINode*)> visit) const;
+
+    /**
+     * @brief Calls `visit` with every USR of an unsupported declaration, sorted once frozen.
+     */
+    void forEachUnsupportedUSR(llvm::function_ref<void(llvm::StringRef)> visit) const;
+
+    /**
+     * @brief Turns the USR maps into read-only indices once the tree is complete.
+     *
+     * usrNodeMap and unSupportedUsrNodeMap are emptied: their entries move to
+     * sorted arrays whose keys borrow the string pool, with an open-addressing
+     * table of slot indices for findNodeByUSR. The build-time maps keep a heap
+     * entry per key; the frozen ones cost a few words per key and are probed
+     * in one or two cache lines. Nothing may be added to the maps afterwards;
+     * clear() thaws the context.
+     */
+    void freeze();
+
+    bool isFrozen() const { return frozen; }
+
+    /**
+     * @brief Computes the fingerprints of every node once the tree is complete.
+     *
+     * Must run after the last node is added, since records are reopened on
+     * redeclaration and receive children late. Also indexes the type names
+     * the nodes spell when diffs collapse type changes (see setTypeChangeCollapsing).
+     */
+    void computeFingerprints();
+
+    /**
+     * @brief Computes the fingerprints of the roots from index `first` on, as far as the tree is built.
+     *
+     * For a RootDiffPipeline diffing the roots while the tree grows;
+     * computeFingerprints still runs once it is complete.
+     */
+    void fingerprintRoots(size_t first);
+
+    /**
+     * @brief Hands the roots of this context to `pipeline` as the normalizer builds them; nullptr, the default, does not.
+     *
+     * The pipeline must outlive the parse and every diff of the context.
+     */
+    void setDiffPipeline(RootDiffPipeline* pipeline);
+
+    RootDiffPipeline* getDiffPipeline() const;
+
+    /**
+     * @brief Declarations per type name of the complete tree; empty unless diffs collapse type changes.
+     */
+    const TypeUsageIndex& getTypeUsageIndex() const;
 
     /**
      * @brief Returns a const reference to the list of root API nodes.
      */
-    const llvm::SmallVector<std::shared_ptr<const APINode>,64>& getRootNodes() const;
+    const llvm::SmallVector<const APINode*,64>& getRootNodes() const;
 
     /**
      * @brief Checks if the context contains any nodes.
@@ -198,6 +502,26 @@ public:
 
     clang::ASTContext* getClangASTContext() const;
 
+    /**
+     * @brief Restricts the context to `file`, for a translation unit parsing several headers.
+     *
+     * Until set, the context owns the main file of its translation unit.
+     */
+    void setOwnedFile(clang::FileID file);
+
+    /**
+     * @brief Returns the file the context normalizes in the translation unit of `SM`.
+     */
+    clang::FileID getOwnedFile(const clang::SourceManager& SM) const;
+
+    /**
+     * @brief Whether `loc`, at its expansion point, lies in the owned file.
+     *
+     * Compares the location's offset against the owned file's, which are
+     * looked up once per SourceManager, rather than finding its FileID.
+     */
+    bool ownsLocation(const clang::SourceManager& SM, clang::SourceLocation loc) const;
+
     /**
      * @brief Returns a reference to the source range tracker (mutable).
      */
@@ -208,15 +532,63 @@ public:
      */
     const SourceRangeTracker& getSourceRangeTracker() const;
 
-    llvm::StringMap<std::shared_ptr<APINode>> usrNodeMap;
+    // Written while the tree is built; empty once frozen
+    llvm::StringMap<APINode*> usrNodeMap;
     llvm::StringSet<> unSupportedUsrNodeMap;
 
 private:
-    llvm::StringMap<llvm::SmallVector<std::shared_ptr<APINode>,16>> apiNodesMap;
-    llvm::SmallVector<std::shared_ptr<const APINode>,64> apiNodes;
+    struct FrozenUSR {
+        uint64_t hash;
+        llvm::StringRef usr;
+        APINode* node;
+    };
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    // Sorted by USR, see freeze
+    std::vector<FrozenUSR> frozenUSRs;
+    // Indices into frozenUSRs by hash, linearly probed; a power of two at least twice as large
+    std::vector<uint32_t> usrSlots;
+    std::vector<llvm::StringRef> frozenUnsupportedUSRs;
+    bool frozen = false;
+
+    APINodeArena nodeArena;
+    NSRNodeMap apiNodesMap;
+    llvm::SmallVector<const APINode*,64> apiNodes;
+
+    // Keyed by canonical declaration; the strings live in nodeArena, or in sharedStrings
+    llvm::DenseMap<const clang::Decl*, llvm::StringRef> usrCache;
+    llvm::DenseMap<const clang::Decl*, llvm::StringRef> nsrCache;
+    // Keyed by QualType::getAsOpaquePtr(); one table per printing policy
+    llvm::DenseMap<void*, llvm::StringRef> writtenTypeCache;
+    llvm::DenseMap<void*, llvm::StringRef> canonicalTypeCache;
+    // Scratch buffer the type printer writes into before interning
+    llvm::SmallString<256> typeBuffer;
+    // Shared with the other contexts of the current AST, see shareASTStrings; owned through retainedStorage
+    armor::ShardedStringCache* sharedStrings = nullptr;
+
+    // Scratch buffers of the USR and NSR generated together
+    llvm::SmallString<256> usrBuffer;
+    llvm::SmallString<256> nsrBuffer;
+    // Backs node strings that are not in nodeArena, see retainStorage
+    std::vector<std::shared_ptr<const void>> retainedStorage;
 
     SourceRangeTracker sourceRangeTracker;
+    TypeUsageIndex typeUsageIndex;
     clang::ASTContext* clangContext;
+    RootDiffPipeline* diffPipeline = nullptr;
+    std::mutex* astMutex = nullptr;
+    // Invalid for the main file
+    clang::FileID ownedFile;
+    // The owned file's offsets in ownedRangeSM, see ownsLocation; unused unless exact
+    mutable const clang::SourceManager* ownedRangeSM = nullptr;
+    mutable unsigned ownedBegin = 0;
+    mutable unsigned ownedSize = 0;
+    mutable bool ownedRangeExact = false;
+
+    // The string of `key` in `table` of the shared cache, if one is shared and holds it
+    std::optional<llvm::StringRef> findShared(const void* key, unsigned table) const;
+    // Stores `value` for `key` in the shared cache if there is one, else interns it here
+    llvm::StringRef internAST(const void* key, unsigned table, llvm::StringRef value);
 };
 
 }
\ No newline at end of file
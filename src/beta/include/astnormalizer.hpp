@@ -15,11 +15,22 @@
 #include "session.hpp"
 #include "tree_builder.hpp"
 #include "comment_handler.hpp"
+#include "language_policy.hpp"
 #include "preprocesor.hpp"
 
 namespace beta{
 
-class ASTNormalize : public clang::RecursiveASTVisitor<ASTNormalize> {
+/**
+ * @brief Walks a unit and builds its tree with a TreeBuilder.
+ *
+ * Instantiated for CLanguage and CxxLanguage: the C visitor compiles out the
+ * traversal of C++-only declarations and the TreeBuilder's scope and
+ * template checks, which a C unit never needs.
+ */
+template <typename Language>
+class ASTNormalize : public clang::RecursiveASTVisitor<ASTNormalize<Language>> {
+    using Base = clang::RecursiveASTVisitor<ASTNormalize<Language>>;
+
     public:
 
         beta::APISession* session;
@@ -29,6 +40,26 @@ class ASTNormalize : public clang::RecursiveASTVisitor<ASTNormalize> {
        
         ASTNormalize(beta::APISession* session, beta::ASTNormalizedContext* context, clang::ASTContext* clangContext);
 
+        /**
+         * @brief Only written declarations are normalized: primary templates,
+         *        explicit specializations and explicit instantiations, never
+         *        what inline code instantiates implicitly.
+         */
+        bool shouldVisitTemplateInstantiations() const { return false; }
+        bool shouldVisitImplicitCode() const { return false; }
+
+        /**
+         * @brief Skips, without visiting, namespace-scope declarations written outside
+         *        the context's owned file: the STL, LLVM and -I dependency subtrees the TreeBuilder
+         *        would otherwise walk only to reject every node. Declarations the
+         *        session's ApiFilter excludes are skipped the same way, as are
+         *        implicit instantiations reached through a declaration context.
+         */
+        bool TraverseDecl(clang::Decl *Decl);
+
+        // Whether TraverseDecl passes over `Decl` without visiting it, as above
+        bool skipsDecl(clang::Decl *Decl);
+
         bool TraverseNamespaceDecl(clang::NamespaceDecl *Decl);
         bool TraverseRecordDecl(clang::RecordDecl *Decl);
         bool TraverseCXXRecordDecl(clang::CXXRecordDecl *Decl);
@@ -85,9 +116,49 @@ class ASTNormalizeConsumer : public clang::ASTConsumer {
     public:
         beta::APISession* session;
         ASTNormalizedContext* context;
-        ASTNormalize *visitor;
         ASTNormalizeConsumer(beta::APISession* session, beta::ASTNormalizedContext* context);
+
+        /**
+         * @brief Normalizes each declaration of the unit as soon as clang completes it,
+         *        when the context has a RootDiffPipeline, and hands the new roots to it.
+         *
+         * Declarations are taken in the order the unit lists them, as a traversal
+         * of the whole unit would, so the tree is the same. Once the unit has an
+         * error the rest is left to HandleTranslationUnit, since broken units are
+         * discarded.
+         */
+        bool HandleTopLevelDecl(clang::DeclGroupRef group) override;
+
+        /**
+         * @brief Normalizes whatever was not handed over declaration by declaration,
+         *        the whole unit without a pipeline, then fingerprints the tree.
+         */
         void HandleTranslationUnit(clang::ASTContext &Context) override;
+
+        /**
+         * @brief Lets the parser skip bodies outside the owned file.
+         *
+         * Only consulted when FrontendOptions::SkipFunctionBodies is set, see
+         * APISession::setSkipForeignBodies.
+         */
+        bool shouldSkipFunctionBody(clang::Decl *D) override;
+
+    private:
+        // Created by the first declaration normalized, for the unit's language
+        void startVisitor(clang::ASTContext& clangContext);
+        // Traverses `Decl` with the visitor of the unit's language
+        void traverse(clang::Decl* Decl);
+        // Normalizes the declarations `unit` lists after lastNormalized
+        void normalizeUnitFrom(clang::TranslationUnitDecl* unit);
+        // Traverses `unit` with the declarations built ahead on `jobs` threads, see setTreeBuildJobs
+        void buildInParallel(clang::TranslationUnitDecl* unit, unsigned jobs);
+
+        // One of the two is created
+        std::unique_ptr<ASTNormalize<CLanguage>> cVisitor;
+        std::unique_ptr<ASTNormalize<CxxLanguage>> cxxVisitor;
+        // The last declaration of the unit normalized by HandleTopLevelDecl
+        clang::Decl* lastNormalized = nullptr;
+        bool chunkingStopped = false;
 };
        
 
@@ -114,4 +185,18 @@ class NormalizeActionFactory : public clang::tooling::FrontendActionFactory {
         std::unique_ptr<clang::FrontendAction> create() override;
 };
 
+/**
+ * @brief Factory for batch runs, where one factory serves many files.
+ *
+ * Each action looks up its context from the file it is handed; `fileKeys`
+ * maps those absolute paths back to the session's context keys.
+ */
+class BatchNormalizeActionFactory : public clang::tooling::FrontendActionFactory {
+    public:
+        beta::APISession* session;
+        const llvm::StringMap<std::string>& fileKeys;
+        BatchNormalizeActionFactory(beta::APISession* session, const llvm::StringMap<std::string>& fileKeys);
+        std::unique_ptr<clang::FrontendAction> create() override;
+};
+
 }
\ No newline at end of file
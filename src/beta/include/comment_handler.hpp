@@ -8,6 +8,7 @@
 #include <string>
 
 #include "ast_normalized_context.hpp"
+#include "preprocesor.hpp"
 
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
@@ -15,27 +16,28 @@
 
 namespace beta {
 
-void filterCommentsInInactiveRegions(beta::ASTNormalizedContext* context, clang::SourceManager* SM);
-
 class CommentHandler : public clang::CommentHandler {
 
     public:
-        explicit CommentHandler(clang::SourceManager* SM, beta::ASTNormalizedContext* context);
+        /**
+         * @param preprocessor The callbacks of the same parse, whose FileChanged
+         *        state tells comments of the owned file from the rest.
+         */
+        CommentHandler(clang::SourceManager* SM, beta::ASTNormalizedContext* context,
+                       const beta::ASTNormalizerPreprocessor* preprocessor);
         
         bool HandleComment(clang::Preprocessor& PP, clang::SourceRange Comment) override;
 
-        uint64_t generateHashFromSourceRange(clang::SourceRange Range);
-        uint64_t generateHashFromOffsets(unsigned startOffset, unsigned endOffset);
-
+        /** @brief Hands the comment ranges and the main file to the tracker, which hashes them on demand. */
         void finalize();
 
     private:
 
         llvm::SmallVector<beta::Range, 32> comments;
-        llvm::DenseMap<uint64_t, int> commentsHashMap;
         
         clang::SourceManager* SM;
         beta::ASTNormalizedContext* context;
+        const beta::ASTNormalizerPreprocessor* preprocessor;
 };
 
 } 
\ No newline at end of file
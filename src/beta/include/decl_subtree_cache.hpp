@@ -0,0 +1,132 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "node.hpp"
+
+namespace beta {
+
+class ASTNormalizedContext;
+
+/**
+ * @class DeclSubtreeCache
+ * @brief Node subtrees of top-level declarations, shared by the parses of a process.
+ *
+ * Most top-level declarations of an edited header read the same as in the
+ * parse before. An entry is keyed by the whitespace and comment insensitive
+ * source hash of the declaration and a digest of its names and the types it
+ * references (see TreeBuilder::BuildTopLevelDecl), so a declaration written
+ * the same whose types changed in an include misses. A hit copies the
+ * recorded subtree, its usrNodeMap entries and its unhandled declaration
+ * hashes into the context, instead of walking the declaration again.
+ *
+ * Off until enabled, as the long-running modes do (see
+ * armor::ContextCache::keepEntriesInMemory). Thread-safe.
+ */
+class DeclSubtreeCache {
+public:
+    // The cache is emptied when it would hold more nodes than this
+    static constexpr std::size_t DEFAULT_MAX_NODES = std::size_t(1) << 20;
+
+    struct Key {
+        uint64_t sourceHash = 0;
+        uint64_t digest = 0;
+
+        bool operator==(const Key& other) const {
+            return sourceHash == other.sourceHash && digest == other.digest;
+        }
+    };
+
+    /**
+     * @brief What building one top-level declaration added to its context.
+     */
+    struct Entry {
+        APINodeArena arena;
+        // The root node added, or nullptr when the declaration only added hashes
+        APINode* root = nullptr;
+        // usrNodeMap insertions, in order
+        std::vector<std::pair<llvm::StringRef, APINode*>> usrs;
+        // SourceRangeTracker::addUnhandledDeclHash calls, in order
+        std::vector<uint64_t> unhandledHashes;
+        // Main file line the declaration began on; node lines are shifted by the difference
+        unsigned beginLine = 0;
+        std::size_t nodeCount = 0;
+        // What the traversal of the declaration returned
+        bool result = true;
+    };
+
+    explicit DeclSubtreeCache(std::size_t maxNodes = DEFAULT_MAX_NODES) : maxNodes(maxNodes) {}
+
+    /** @brief The cache shared by the parses of this process. */
+    static DeclSubtreeCache& getInstance();
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    /** @brief The entry of `key`, or nullptr. */
+    std::shared_ptr<const Entry> find(const Key& key);
+
+    /** @brief Records `entry` under `key`, replacing an entry already there. */
+    void store(const Key& key, std::shared_ptr<const Entry> entry);
+
+    void clear();
+
+    std::size_t getHits() const { return hits; }
+    std::size_t getMisses() const { return misses; }
+
+    /**
+     * @brief Entry holding copies of `root`, with every node below it, and of
+     *        `usrs`, whose nodes must lie in that subtree.
+     */
+    static std::shared_ptr<Entry> record(const APINode* root,
+                                         const std::vector<std::pair<llvm::StringRef, APINode*>>& usrs);
+
+    /**
+     * @brief Copies `entry` into `context` for a declaration beginning on
+     *        main file line `beginLine`: the root is added as a root node,
+     *        the USRs to usrNodeMap and the hashes to the source range tracker.
+     */
+    static void replay(const Entry& entry, unsigned beginLine, ASTNormalizedContext& context);
+
+    /**
+     * @brief Copies `roots`, built in another context, into `context` as
+     *        replay copies an entry, with the USRs and unhandled hashes that
+     *        came with them; `copies` receives the copy of every node.
+     *
+     * The nodes of `usrs` must lie below `roots`.
+     */
+    static void transplant(llvm::ArrayRef<const APINode*> roots,
+                           const std::vector<std::pair<llvm::StringRef, APINode*>>& usrs,
+                           llvm::ArrayRef<uint64_t> unhandledHashes, long lineShift, ASTNormalizedContext& context,
+                           llvm::DenseMap<const APINode*, APINode*>& copies);
+
+private:
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            return static_cast<std::size_t>(key.sourceHash ^ (key.digest * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    std::atomic<bool> enabled{false};
+    std::size_t maxNodes;
+    std::mutex mutex;
+    std::unordered_map<Key, std::shared_ptr<const Entry>, KeyHash> entries;
+    std::size_t nodes = 0;
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+};
+
+}
@@ -0,0 +1,77 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace beta {
+
+struct APINode;
+
+enum class DiffTag : uint8_t {
+    Added,
+    Removed,
+    Modified,
+    Moved,
+    Reordered
+};
+
+/**
+ * @brief Node fields compared by APINode::diff, combined as DiffEntry::fields.
+ */
+enum DiffField : uint8_t {
+    DIFF_FIELD_DATA_TYPE = 1 << 0,
+    DIFF_FIELD_STORAGE   = 1 << 1,
+    DIFF_FIELD_VIRTUAL   = 1 << 2,
+    DIFF_FIELD_INLINE    = 1 << 3,
+    DIFF_FIELD_CONSTEXPR = 1 << 4,
+    DIFF_FIELD_LAYOUT    = 1 << 5
+};
+
+/**
+ * @struct DiffEntry
+ * @brief One entry of a beta AST diff, referencing the compared nodes instead of copying them.
+ *
+ * - Added / Removed with no `fields`: `node` and its whole subtree appeared or disappeared.
+ * - Added / Removed with `fields`: those fields of `owner` changed; the old
+ *   (Removed) or new (Added) values are read from `node`.
+ * - Modified: `node` has changes, listed in `children`.
+ * - Moved: `owner`, a root of the older tree, reappears as `node` under
+ *   another qualified name with the same shape (see APINode::sameShape).
+ * - Reordered: `owner`, a field, enumerator or parameter, is matched by
+ *   `node` at another place among its siblings of that kind, from
+ *   `oldIndex` to `newIndex`.
+ *
+ * The nodes must outlive the entry. Entries become JSON only when reported,
+ * see toJson().
+ */
+struct DiffEntry {
+    DiffTag tag;
+    uint8_t fields = 0;
+    // Positions among the siblings of the same kind, of Reordered entries only
+    uint32_t oldIndex = 0;
+    uint32_t newIndex = 0;
+    const APINode* node;
+    const APINode* owner;
+    std::vector<DiffEntry> children;
+
+    DiffEntry(DiffTag tag, const APINode& node) : tag(tag), node(&node), owner(&node) {}
+
+    DiffEntry(DiffTag tag, uint8_t fields, const APINode& values, const APINode& owner)
+        : tag(tag), fields(fields), node(&values), owner(&owner) {}
+
+    DiffEntry(DiffTag tag, const APINode& node, const APINode& owner) : tag(tag), node(&node), owner(&owner) {}
+
+    DiffEntry(const APINode& node, const APINode& owner, uint32_t oldIndex, uint32_t newIndex)
+        : tag(DiffTag::Reordered), oldIndex(oldIndex), newIndex(newIndex), node(&node), owner(&owner) {}
+
+    /**
+     * @brief Serializes the entry in the layout of the "astDiff" report array.
+     */
+    nlohmann::json toJson() const;
+};
+
+}
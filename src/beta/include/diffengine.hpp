@@ -2,11 +2,202 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+
 #include "node.hpp"
 #include <nlohmann/json.hpp>
 #include "ast_normalized_context.hpp"
+#include "diff_entry.hpp"
+#include "changed_ranges.hpp"
 #include "comm_def.hpp"
 
+/**
+ * @brief Receives the top-level entries of an AST diff, in the order diffTrees() lists them.
+ */
+using DiffEntrySink = std::function<void(nlohmann::json&&)>;
+
+/**
+ * @brief A DiffEntrySink that ends the diff by returning false.
+ */
+using StoppableDiffEntrySink = std::function<bool(nlohmann::json&&)>;
+
+/**
+ * @brief Whether diffs report macros by name (--macro-diff).
+ *
+ * When enabled, macros added, removed or redefined in the main file are
+ * listed after the declarations as "Macro" entries, sorted by name, and the
+ * #define and #undef lines no longer count as unhandled declarations; a
+ * changed macro makes the header's status supported updates rather than
+ * unsupported ones. Off by default, so existing diff outputs stay as they are.
+ */
+void setMacroDiff(bool enabled);
+
+bool isMacroDiffEnabled();
+
+/**
+ * @brief Collapses the type changes of a replaced type name into one entry (--collapse-type-changes).
+ *
+ * With `minUsers` above 0, a type name spelled by at least `minUsers`
+ * declarations of the older version and by none of the newer one is taken
+ * as replaced. Every declaration whose written type changed by that name
+ * alone then loses its data type change, and a single "type_changed" entry
+ * after the declarations lists the old and new names and the affected
+ * declarations. Declarations with other changes keep those. 0, the
+ * default, turns it off.
+ *
+ * Contexts index their type names when their tree is completed, so this is
+ * set before any header is parsed or loaded.
+ */
+void setTypeChangeCollapsing(unsigned minUsers);
+
+unsigned getTypeChangeCollapsing();
+
+/**
+ * @brief Whether header pairs diff the newer version while it is parsed (--pipeline-diff).
+ *
+ * When enabled, the newer version of a pair is normalized one top-level
+ * declaration at a time, as clang completes it, and a RootDiffPipeline
+ * diffs each new root against the older version on a thread of its own.
+ * The report is the same either way. Off by default.
+ */
+void setPipelinedDiff(bool enabled);
+
+bool isPipelinedDiffEnabled();
+
+/**
+ * @brief Whether diffs compare the layout of records (--record-layouts).
+ *
+ * When enabled, the normalizer lays out every complete, non-dependent
+ * struct, class and union of the header while its AST is alive, and keeps
+ * a compact summary of it on the node: the size and alignment in bytes and
+ * the offset of each field, see APINode::layout. Nothing is laid out
+ * otherwise. The summary is part of the node's fingerprint, so a record
+ * whose layout changed is diffed even when its fields are spelled as
+ * before, as when a field's type is defined in an include; a record whose
+ * layout differs then lists the old and new summary as "layout" entries.
+ * Unchanged records are never diffed, so their summaries are never compared
+ * or reported. Off by default.
+ *
+ * Set before any header is parsed or loaded.
+ */
+void setRecordLayouts(bool enabled);
+
+bool isRecordLayoutEnabled();
+
+/**
+ * @brief Threads building the tree of each parsed header (--tree-build-jobs).
+ *
+ * With more than one, the top-level declarations of a header that parsed
+ * without errors, and those of its namespaces and extern "C" blocks, are
+ * built on that many threads once clang completes the unit, each thread
+ * into a context of its own. They are then taken into the header's context
+ * in order: a declaration whose build looked up none of the nodes built
+ * before it is copied, any other is built again where it belongs. The tree
+ * is the same as built on one thread. The TypePrinter, line lookups and
+ * record layouts, which fill caches of the AST, run one thread at a time.
+ * Units with a precompiled header or modules, whose declarations clang loads
+ * as they are first reached, are built on one thread, as are those normalized
+ * with --pipeline-diff or while the declaration subtree cache is enabled.
+ * 1, the default, builds every tree on one thread.
+ *
+ * Set before any header is parsed.
+ */
+void setTreeBuildJobs(unsigned jobs);
+
+unsigned getTreeBuildJobs();
+
+/**
+ * @class RootDiffPipeline
+ * @brief Diffs the roots of a newer version against a finished baseline while clang still parses it.
+ *
+ * The normalizer of the newer version hands over the roots of each top-level
+ * declaration once it has built them (see ASTNormalizeConsumer::HandleTopLevelDecl).
+ * A worker thread matches each root against the baseline by NSR, or by USR
+ * among overloads, and diffs the pairs whose fingerprints differ. The
+ * normalizer only extends its tree holding treeMutex(), which the worker
+ * holds while it diffs, so either sees whole declarations of the other.
+ *
+ * A later declaration may extend a root already diffed (a reopened namespace,
+ * the definition of a class declared before), and the final matching may pair
+ * it otherwise. streamDiffTreesUntil therefore only takes the diff of a pair
+ * it matched itself, when the newer root has not changed since it was diffed,
+ * and diffs the other pairs as usual.
+ *
+ * The baseline may be set while roots are handed over, as both versions of a
+ * pair are parsed at once; roots wait for it.
+ */
+class RootDiffPipeline {
+public:
+    RootDiffPipeline();
+
+    /** Drops the roots not diffed yet and joins the worker. */
+    ~RootDiffPipeline();
+
+    RootDiffPipeline(const RootDiffPipeline&) = delete;
+    RootDiffPipeline& operator=(const RootDiffPipeline&) = delete;
+
+    /**
+     * @brief Sets the older version, whose tree must be complete; nullptr drops
+     *        every root, as for a baseline that failed to parse.
+     */
+    void setBaseline(const beta::ASTNormalizedContext* baseline);
+
+    /** @brief Held by the normalizer of the newer version while it extends its tree. */
+    std::mutex& treeMutex() { return tree; }
+
+    /**
+     * @brief Fingerprints the roots of `context` from `firstRoot` on and queues them.
+     *
+     * Called with treeMutex() held, on the thread normalizing `context`.
+     */
+    void addRoots(beta::ASTNormalizedContext& context, size_t firstRoot);
+
+    /** @brief Waits until every queued root is diffed; no more roots may be added. */
+    void finish();
+
+    /**
+     * @brief Moves out the diff of `root1` of `baseline` against `root2`, if the
+     *        worker made it and `root2` is as it was then.
+     *
+     * Only after finish(); pairs may be taken concurrently, each once.
+     */
+    bool take(const beta::ASTNormalizedContext* baseline, const beta::APINode& root1, const beta::APINode& root2,
+              std::vector<beta::DiffEntry>& entries, HashMultiset::Fingerprint& addedHashes);
+
+private:
+    struct Result {
+        // subtreeVersion of the newer root when it was diffed
+        uint64_t version = 0;
+        bool taken = false;
+        std::vector<beta::DiffEntry> entries;
+        HashMultiset::Fingerprint addedHashes;
+    };
+
+    void run();
+    void diffRoot(const beta::APINode& root2);
+
+    std::mutex tree;
+    std::mutex queueMutex;
+    std::condition_variable queued;
+    std::deque<const beta::APINode*> pending;
+    const beta::ASTNormalizedContext* baseline = nullptr;
+    bool baselineKnown = false;
+    bool closed = false;
+    bool cancelled = false;
+    // Written by the worker alone, and read once it has been joined
+    llvm::DenseMap<std::pair<const beta::APINode*, const beta::APINode*>, Result> results;
+    std::thread worker;
+};
+
 /**
  * @brief Computes the difference between two AST contexts and returns a structured JSON result.
  * 
@@ -26,9 +217,49 @@
  * 
  * @param context1 The first (old) AST context
  * @param context2 The second (new) AST context
+ * @param changes  Changed lines of the header (--changed-ranges); when set, matched
+ *                 declarations outside every changed line are not compared
+ * @param jobs     Threads the matched root pairs may be diffed on. The trees are only
+ *                 read concurrently; the newer context's unhandled declaration hashes
+ *                 are reconciled on the calling thread, and entries keep their order.
  * @return nlohmann::json A structured JSON object containing diff results and status codes
  */
 nlohmann::json diffTrees(
     beta::ASTNormalizedContext* context1,
-    beta::ASTNormalizedContext* context2
-);
\ No newline at end of file
+    beta::ASTNormalizedContext* context2,
+    const armor::HeaderChanges* changes = nullptr,
+    unsigned jobs = 1
+);
+
+/**
+ * @brief Streaming form of diffTrees(): hands each top-level diff entry to `onEntry`
+ *        as soon as it is produced, so the whole "astDiff" array is never built.
+ *
+ * `onEntry` is always called on the calling thread.
+ *
+ * @return The diffTrees() result without "astDiff".
+ */
+nlohmann::json streamDiffTrees(
+    beta::ASTNormalizedContext* context1,
+    beta::ASTNormalizedContext* context2,
+    const DiffEntrySink& onEntry,
+    const armor::HeaderChanges* changes = nullptr,
+    unsigned jobs = 1
+);
+
+/**
+ * @brief streamDiffTrees() that ends as soon as `onEntry` returns false.
+ *
+ * Nothing after the entry that ended it is diffed, and the source range
+ * trackers are not compared, so a caller looking for one kind of change
+ * pays only for the roots up to the first one.
+ *
+ * @return The streamDiffTrees() result, or null if `onEntry` ended the diff.
+ */
+nlohmann::json streamDiffTreesUntil(
+    beta::ASTNormalizedContext* context1,
+    beta::ASTNormalizedContext* context2,
+    const StoppableDiffEntrySink& onEntry,
+    const armor::HeaderChanges* changes = nullptr,
+    unsigned jobs = 1
+);
@@ -2,10 +2,38 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
+#include "changed_ranges.hpp"
+#include "output_paths.hpp"
 #include "session.hpp"
 
+/**
+ * @brief Beta contexts of a header pair, parsed and not yet reported.
+ */
+struct ParsedHeaderPairBeta {
+    std::unique_ptr<beta::APISession> session;
+    // Owned by `session`; nullptr when the session lost them
+    beta::ASTNormalizedContext* context1 = nullptr;
+    beta::ASTNormalizedContext* context2 = nullptr;
+    PARSING_STATUS status = FATAL_ERRORS;
+};
+
+/**
+ * @brief Parses both versions of a header with the beta parser, without diffing or reporting.
+ *
+ * The first half of processHeaderPairBeta, so a caller can fall back to the
+ * alpha report when the beta parse fails.
+ */
+ParsedHeaderPairBeta parseHeaderPairBeta(const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& projectRoot2,
+                       const std::string& file2,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang);
+
 PARSING_STATUS processHeaderPairBeta(const std::string& projectRoot1,
                        const std::string& file1,
                        const std::string& projectRoot2,
@@ -13,4 +41,53 @@ PARSING_STATUS processHeaderPairBeta(const std::string& projectRoot1,
                        const std::string& reportFormat,
                        const std::vector<std::string>& IncludePaths,
                        const std::vector<std::string>& macroFlags,
-                       const LANG_OPTIONS lang);
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff);
+
+/**
+ * @brief Diffs two already normalized beta contexts and writes the reports.
+ *
+ * This is the second half of processHeaderPairBeta, usable by callers that
+ * populated the contexts through their own frontend run.
+ *
+ * @param projectRoot1 Project root of the older version (used to trim report paths).
+ * @param file1        Older header path; its basename names the report files.
+ * @param reportFormat "html", or "json", "cbor" or "msgpack" for a JSON report in that format too.
+ * @param context1     Normalized context of the older header.
+ * @param context2     Normalized context of the newer header.
+ * @param dumpAstDiff  Also write the raw diff to debug_output/ast_diffs, in the report format.
+ * @param changes      Changed lines of the header, limiting the diff (see diffTrees), or nullptr.
+ * @param outputs      Where the reports and the dump are written.
+ * @param diffJobs     Threads the matched root pairs may be diffed on (see diffTrees).
+ */
+void reportHeaderPairBeta(const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& reportFormat,
+                       beta::ASTNormalizedContext* context1,
+                       beta::ASTNormalizedContext* context2,
+                       bool dumpAstDiff,
+                       const armor::HeaderChanges* changes = nullptr,
+                       const armor::OutputPaths& outputs = {},
+                       unsigned diffJobs = 1);
+
+/**
+ * @brief Overall status of two already normalized beta contexts, without writing reports.
+ *
+ * The --verdict-only form of reportHeaderPairBeta: the diff ends at the first
+ * backward incompatible entry, and no records, descriptions or reports are
+ * made. The overall status is recorded in ReportSummaries, as a written
+ * report's would be.
+ *
+ * @param projectRoot1 Project root of the older version (used to trim the header path).
+ * @param file1        Older header path.
+ * @param context1     Normalized context of the older header.
+ * @param context2     Normalized context of the newer header.
+ * @param changes      Changed lines of the header, limiting the diff (see diffTrees), or nullptr.
+ * @param diffJobs     Threads the matched root pairs may be diffed on (see diffTrees).
+ */
+void reportHeaderPairVerdictBeta(const std::string& projectRoot1,
+                       const std::string& file1,
+                       beta::ASTNormalizedContext* context1,
+                       beta::ASTNormalizedContext* context2,
+                       const armor::HeaderChanges* changes = nullptr,
+                       unsigned diffJobs = 1);
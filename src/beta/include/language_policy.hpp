@@ -0,0 +1,23 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+namespace beta{
+
+/**
+ * @brief Language policies the normalizer and TreeBuilder are instantiated for.
+ *
+ * A unit parsed as C has no namespaces, classes, templates or using
+ * declarations, so the C instantiation compiles out every check and handler
+ * that only looks for them. Which one runs is chosen from the unit's
+ * LangOptions, see ASTNormalizeConsumer.
+ */
+struct CxxLanguage {
+    static constexpr bool CPlusPlus = true;
+};
+
+struct CLanguage {
+    static constexpr bool CPlusPlus = false;
+};
+
+}
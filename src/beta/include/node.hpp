@@ -2,40 +2,210 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/Allocator.h>
 #include <memory>
+#include <new>
+#include <string>
+#include <vector>
 
 #include "comm_def.hpp"
+#include "diff_entry.hpp"
+#include "hash_multiset.hpp"
 #include "nlohmann/json.hpp"
 #include "nlohmann/json_fwd.hpp"
 #include "clang/Basic/SourceLocation.h"
 
 // Main Node structure
-// string can be optimized by SmallString
 
 namespace beta {
 
+struct APINode;
+
+/**
+ * @class APINodeList
+ * @brief Child list of an APINode, stored in the arena of the owning context.
+ *
+ * Grows by doubling into fresh arena storage; a superseded block is not
+ * freed individually but released together with the arena.
+ */
+class APINodeList {
+public:
+    using iterator = APINode* const*;
+
+    iterator begin() const { return items; }
+    iterator end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    APINode* operator[](size_t index) const { return items[index]; }
+    APINode* front() const { return items[0]; }
+
+    /**
+     * @brief Appends `node`, reallocating from `arena` when the list is full.
+     */
+    void push_back(APINode* node, llvm::BumpPtrAllocator& arena) {
+        if (count == capacity) {
+            uint32_t newCapacity = capacity == 0 ? 4 : capacity * 2;
+            APINode** newItems = arena.Allocate<APINode*>(newCapacity);
+            std::copy(items, items + count, newItems);
+            items = newItems;
+            capacity = newCapacity;
+        }
+        items[count++] = node;
+    }
+
+private:
+    APINode** items = nullptr;
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+};
+
 struct APINode {
     NodeKind kind = NodeKind::Unknown;
-    std::string qualifiedName;
-    std::string dataType;         // datatype of variables as written .... (int/float/...)
-    std::string caonicalType;     // underlying datatype of variable after parsing through typedef/typealias chain
+    // String fields reference the string pool of the owning context, see APINodeArena::intern
+    // Name within `scope`, or the qualified name when `scope` is nullptr; see getQualifiedName
+    llvm::StringRef name;
+    // The enclosing node the name is spelled under, an ancestor in the tree
+    const APINode* scope = nullptr;
+    llvm::StringRef dataType;         // datatype of variables as written .... (int/float/...)
+    llvm::StringRef caonicalType;     // underlying datatype of variable after parsing through typedef/typealias chain
+    // Size, alignment and field offsets of a complete record, see setRecordLayouts; empty otherwise
+    llvm::StringRef layout;
     bool isInclined = false;
     bool isConstExpr = false;
     AccessSpec access = AccessSpec::None;
     APINodeStorageClass storage = APINodeStorageClass::None;
     VirtualQualifier virtualQualifier = VirtualQualifier::None;
 
-    std::string USR;
-    std::string NSR;
+    llvm::StringRef USR;
+    llvm::StringRef NSR;
     llvm::SmallVector<uint64_t,4> stmtHashes;
-    std::unique_ptr<llvm::SmallVector<std::shared_ptr<const APINode>,16>> children;
+    APINodeList children;
+
+    // Structural hash of this subtree, see computeFingerprint; 0 until computed
+    uint64_t fingerprint = 0;
+    // The stmtHashes of this subtree as a multiset fingerprint, see computeFingerprint
+    HashMultiset::Fingerprint subtreeStmtHashes;
+
+    // Main file lines spanned by the node's declarations; 0 when it has none of its own
+    unsigned beginLine = 0;
+    unsigned endLine = 0;
+
+    /**
+     * @brief The qualified name, `name` behind the names of its scopes.
+     *
+     * Built on every call, for reports; a node nested in a scope of the
+     * same name, as a function pointer in its parameter, adds nothing.
+     */
+    std::string getQualifiedName() const;
+
+    /**
+     * @brief Appends the field changes from this node to `other` to `out`.
+     *
+     * A node without children records them as a Modified entry of its own;
+     * otherwise they are appended as field entries next to the children's diffs.
+     */
+    void diff(const APINode& other, std::vector<DiffEntry>& out) const;
+
+    /**
+     * @brief Computes and stores the fingerprints of this subtree, bottom-up.
+     *
+     * Covers every field diffNodes and diff() look at, and the children in
+     * order, so two subtrees with equal fingerprints have no diff. Also sums
+     * the statement hashes of the subtree into subtreeStmtHashes.
+     */
+    uint64_t computeFingerprint();
+
+    /**
+     * @brief Structural hash of this subtree that ignores where it is declared.
+     *
+     * Covers the fields of computeFingerprint other than the name, USR and
+     * NSR; children count with their names relative to this node, so
+     * a subtree moved to another scope or renamed keeps its shape hash.
+     * Computed on every call.
+     */
+    uint64_t shapeHash() const;
+
+    /**
+     * @brief Whether `other` has the same shape, the exact comparison behind shapeHash.
+     */
+    bool sameShape(const APINode& other) const;
+
+};
+
+/**
+ * @class APINodeArena
+ * @brief Owns the nodes of a normalized context, their child lists and strings.
+ *
+ * Nodes are bump allocated in slabs rather than individually on the heap,
+ * and are destroyed together with the arena. Node strings are interned, so
+ * a USR or type spelled by many nodes is stored once. Pointers and
+ * references handed out stay valid until the arena is reset or destroyed,
+ * including across a move.
+ */
+class APINodeArena {
+public:
+    APINodeArena() = default;
+    APINodeArena(APINodeArena&&) = default;
+
+    APINodeArena& operator=(APINodeArena&& other) {
+        if (this != &other) {
+            // The allocator's own move assignment frees slabs without running destructors
+            nodes.DestroyAll();
+            nodes = std::move(other.nodes);
+            childLists = std::move(other.childLists);
+            strings = std::move(other.strings);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Allocates a default constructed node.
+     */
+    APINode* create() {
+        return new (nodes.Allocate()) APINode();
+    }
+
+    /**
+     * @brief Appends `child` to the children of `parent`.
+     */
+    void addChild(APINode& parent, APINode* child) {
+        parent.children.push_back(child, childLists);
+    }
+
+    /**
+     * @brief Returns the pooled copy of `value`.
+     *
+     * Equal strings interned in the same arena share their storage, so
+     * they compare equal by data pointer.
+     */
+    llvm::StringRef intern(llvm::StringRef value) {
+        if (value.empty()) {
+            return llvm::StringRef();
+        }
+        return strings.insert(value).first->getKey();
+    }
 
-    nlohmann::json diff(const std::shared_ptr<const APINode>& other) const;
+    /**
+     * @brief Destroys every node and releases all storage.
+     */
+    void reset() {
+        nodes.DestroyAll();
+        childLists.Reset();
+        strings.clear();
+    }
 
+private:
+    llvm::SpecificBumpPtrAllocator<APINode> nodes;
+    llvm::BumpPtrAllocator childLists;
+    // StringMap entries never move on rehash, so keys are stable references
+    llvm::StringSet<llvm::BumpPtrAllocator> strings;
 };
 
 struct Range{
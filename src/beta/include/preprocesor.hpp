@@ -2,15 +2,18 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 #include "clang/AST/ASTContext.h"
+#include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/PPCallbacks.h"
 #include "llvm/ADT/SmallVector.h"
+#include <optional>
 #include <utility>
 
 #include "node.hpp"
 #include "ast_normalized_context.hpp"
+#include "conditional_block_index.hpp"
 
 namespace beta {
 
@@ -18,7 +21,21 @@ class ASTNormalizerPreprocessor : public clang::PPCallbacks {
 
     public:
 
-    ASTNormalizerPreprocessor(clang::SourceManager* SM, ASTNormalizedContext* context);
+    ASTNormalizerPreprocessor(clang::SourceManager* SM, const clang::LangOptions& langOpts,
+                              ASTNormalizedContext* context);
+
+    /**
+     * @brief Tracks whether the file being lexed is the owned one.
+     *
+     * Every other callback returns on its first line outside it, so the
+     * directives of the system and SDK headers a header includes cost no
+     * source location lookups.
+     */
+    void FileChanged(clang::SourceLocation Loc, FileChangeReason Reason,
+                     clang::SrcMgr::CharacteristicKind FileType, clang::FileID PrevFID) override;
+
+    /** @brief Whether the file being lexed is the owned one, see FileChanged. */
+    bool isInOwnedFile() const { return inOwnedFile; }
     
     void InclusionDirective(
         clang::SourceLocation HashLoc,
@@ -65,17 +82,34 @@ class ASTNormalizerPreprocessor : public clang::PPCallbacks {
     private:
 
     clang::SourceManager* SM;
+    // Of the compiler instance, for lexing directive tokens as the parse does
+    const clang::LangOptions& langOpts;
     ASTNormalizedContext* context;
+    // The owned file's text, looked up on the first range
+    std::optional<llvm::StringRef> buffer;
+    bool inOwnedFile = false;
 
     // Temporary storage for preprocessing
+    // Directive ranges, hashed by finalize; kept disjoint and in source order by addRange
     llvm::SmallVector<beta::Range, 16> PPDirectives;
-    std::map<unsigned, beta::Range> inactivePPDirectives;
-    llvm::DenseMap<uint64_t, int> inactiveUnhandledDeclsHash;
+    // The conditional branch of each of PPDirectives, see ConditionalBlockIndex
+    llvm::SmallVector<int, 16> rangeBranches;
+    ConditionalBlockIndex blocks;
+    llvm::SmallVector<beta::Range, 16> inactivePPDirectives;
+    HashMultiset inactiveUnhandledDeclsHash;
+    // Offsets of the #define and #undef lines, also among PPDirectives
+    llvm::SmallVector<std::pair<unsigned, unsigned>, 16> macroDirectives;
     
-    uint64_t generateHashFromOffsets(unsigned startOffset, unsigned endOffset, bool isActive);
-    void addRange(clang::SourceRange range, bool active=true);
-    void removeNestedRanges();
-    void printRanges();
+    llvm::StringRef mainBuffer();
+    uint64_t hashOffsets(unsigned startOffset, unsigned endOffset, bool isActive);
+    void logRange(const beta::Range& R);
+    uint64_t hashMacroDefinition(const clang::MacroInfo& MI);
+    bool addRange(clang::SourceRange range, bool active=true, bool macroDirective=false);
+    // Adds an #elif or #else line, or an #endif one, and moves to the next conditional branch
+    void addElse(clang::SourceRange range);
+    void addEndif(clang::SourceRange range);
+    llvm::StringRef lastDirective();
+    void hashRanges();
 };
 
 }
\ No newline at end of file
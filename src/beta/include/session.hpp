@@ -2,6 +2,11 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "api_filter.hpp"
 #include "ast_normalized_context.hpp"
 #include "comm_def.hpp"
 
@@ -34,12 +39,27 @@ public:
      * @brief Processes a source file, normalizing its AST and storing the context.
      *
      * Runs a Clang tool on the specified file, populates an ASTNormalizedContext,
-     * and stores it in the session, mapped by the filename.
+     * and stores it in the session, mapped by the filename. Different files may
+     * be processed concurrently on the same session.
      *
      * @param filename The path to the source file to process.
      */
     PARSING_STATUS processFile(std::string fileName, std::unique_ptr<clang::tooling::FixedCompilationDatabase> m_compDB);
 
+    /**
+     * @brief Processes several source files through a single Clang tool.
+     *
+     * Batch form of processFile: one ClangTool (and so one FileManager and
+     * file system) serves every file, amortizing tool setup and stat caches.
+     * A context is created for every file, as processFile does.
+     *
+     * @param fileNames The paths of the source files to process.
+     * @param compDB    Database providing a compile command for every file.
+     * @return The status of every file, in the order of `fileNames`.
+     */
+    std::vector<PARSING_STATUS> processFiles(const std::vector<std::string>& fileNames,
+                                             const clang::tooling::CompilationDatabase& compDB);
+
     /**
      * @brief Retrieves the normalized context for a previously processed file.
      * @param filename The path to the source file.
@@ -53,8 +73,51 @@ public:
 
     void createNormalizedASTContext(const std::string& key);
 
+    /**
+     * @brief Frees the context of `fileName` once its pair is reported; pointers to it dangle.
+     */
+    void removeContext(const std::string& fileName);
+
+    /**
+     * @brief Selects what the normalizers of later runs track, FULL_MODE by default.
+     *
+     * API_ONLY_MODE skips the comment handler, the preprocessor callbacks and
+     * the inactive-region filter, so only the node tree (and the hashes of
+     * unhandled declarations) is produced.
+     */
+    void setParseMode(PARSE_MODE mode);
+
+    PARSE_MODE getParseMode() const;
+
+    /**
+     * @brief Skips parsing function bodies declared outside the parsed header, off by default.
+     *
+     * Only signatures of included code reach the normalized tree, so their
+     * bodies are not parsed or analyzed; bodies in the header itself are still
+     * parsed so their hashes keep detecting body changes. Constexpr and
+     * deduced-return-type bodies are always parsed, as clang needs them.
+     */
+    void setSkipForeignBodies(bool skip);
+
+    bool getSkipForeignBodies() const;
+
+    /**
+     * @brief Drops the declarations `filter` excludes, with their subtrees, during traversal.
+     *
+     * `filter` must outlive the session; nullptr, the default, keeps every declaration.
+     */
+    void setApiFilter(const armor::ApiFilter* filter);
+
+    const armor::ApiFilter* getApiFilter() const;
+
 private:
+    PARSE_MODE m_parseMode = FULL_MODE;
+    bool m_skipForeignBodies = false;
+    const armor::ApiFilter* m_apiFilter = nullptr;
+
     // A map from a filename to its fully normalized AST context
+    // Guards m_contexts so both versions of a header can be parsed concurrently
+    mutable std::mutex m_contextsMutex;
     llvm::StringMap<std::unique_ptr<beta::ASTNormalizedContext>> m_contexts;
 };
 
@@ -11,14 +11,21 @@
 #include "clang/AST/TypeLoc.h"
 #include "clang/AST/Stmt.h"
 #include "clang/AST/Expr.h"
+#include <llvm-14/llvm/ADT/STLFunctionalExtras.h>
 #include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/ADT/StringRef.h>
 
 #include "ast_normalized_context.hpp"
+#include "language_policy.hpp"
 #include "node.hpp"
 #include "qualified_name_builder.hpp"
 #include "fibonacci_hash.hpp"
 
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 /**
  * @class TreeBuilder
  * @brief Builds an API node tree from Clang AST declarations.
@@ -31,10 +38,65 @@
 namespace beta{
 
 class TreeBuilder {
+public:
+    // What building one top-level declaration adds to the context and looks up in it,
+    // for the DeclSubtreeCache and speculative builds
+    struct Capture {
+        std::vector<std::pair<llvm::StringRef, beta::APINode*>> usrs;
+        std::vector<uint64_t> hashes;
+        // Whether a node built before the declaration was looked up or replaced
+        bool reused = false;
+        // USRs and canonical declarations looked up without finding a node
+        std::vector<llvm::StringRef> missedUSRs;
+        std::vector<const clang::Decl*> missedDecls;
+        // RegisterDecl calls, by canonical declaration
+        std::vector<std::pair<const clang::Decl*, beta::APINode*>> decls;
+    };
+
+    /**
+     * @brief One top-level declaration built ahead of its turn in another
+     *        context, see SpeculateTopLevelDecl and AdoptTopLevelDecl.
+     */
+    struct Speculation {
+        clang::Decl* decl = nullptr;
+        Capture captured;
+        // The roots the declaration added, in the speculating context
+        std::vector<const beta::APINode*> roots;
+        // What the traversal of the declaration returned
+        bool result = true;
+        // Whether every node the declaration registered lies below its roots
+        bool selfContained = false;
+    };
+
 private:
     beta::ASTNormalizedContext* context;
     StringBuilder qualifiedName;
-    std::vector<std::shared_ptr<beta::APINode>> nodeStack;
+    std::vector<beta::APINode*> nodeStack;
+    // Length of the qualified name when each node of nodeStack was pushed
+    std::vector<size_t> scopeNameLengths;
+    Capture* capture = nullptr;
+    uint64_t declCacheScope = 0;
+
+    // What classifyScope finds in a DeclContext and the scopes enclosing it
+    enum ScopeClass : uint8_t {
+        // A class, class template specialization or namespace
+        SCOPE_CLASS_OR_NAMESPACE = 1,
+        // Any of those or a templated record, see isWrittenInClassOrNamespace
+        SCOPE_WRITTEN_IN_CLASS_OR_NAMESPACE = 2,
+    };
+    // Per DeclContext of the current AST, the classes of its scope chain
+    llvm::DenseMap<const clang::DeclContext*, uint8_t> scopeClasses;
+    // Per canonical declaration of the current AST, its record or enum node
+    llvm::DenseMap<const clang::Decl*, beta::APINode*> declNodes;
+
+    uint8_t classifyScope(const clang::DeclContext* DC);
+    // Whether Decl is in a namespace or class or is templated, which C never is
+    template <typename Language>
+    bool isInNameSpaceOrClassOrTemplated(const clang::Decl* Decl);
+    bool isCacheableTopLevelDecl(const clang::Decl* Decl);
+    uint64_t generateDigestFromDecl(clang::Decl* Decl);
+    // Held around clang calls that fill caches of the shared AST, see ASTNormalizedContext::setASTMutex
+    std::unique_lock<std::mutex> LockAST();
 public:
     /**
      * @brief Constructs a TreeBuilder with the given context.
@@ -44,14 +106,71 @@ public:
     explicit TreeBuilder(beta::ASTNormalizedContext* context);
     
     // Node management
-    void AddNode(const std::shared_ptr<beta::APINode>& node);
-    void PushNode(const std::shared_ptr<beta::APINode>& node);
+    void AddNode(beta::APINode* node);
+    void PushNode(beta::APINode* node);
     void PopNode();
+    // Widens the node's line span to cover Decl, for --changed-ranges
+    void RecordLines(beta::APINode* node, const clang::Decl* Decl);
+    // Summarizes the layout of Decl's definition on the node, for --record-layouts
+    void RecordLayout(beta::APINode* node, const clang::RecordDecl* Decl);
     
+    // usrNodeMap access, noted while a top-level declaration is captured
+    beta::APINode* FindNodeByUSR(llvm::StringRef USR);
+    void RegisterUSR(llvm::StringRef USR, beta::APINode* node);
+
+    // Nodes of records and enums by canonical declaration, found before their USR
+    // is looked up again for a redeclaration; entities sharing a USR merge through it
+    beta::APINode* FindNodeByDecl(const clang::Decl* Decl);
+    void RegisterDecl(const clang::Decl* Decl, beta::APINode* node);
+
+    /**
+     * @brief Builds the top-level declaration `Decl` with `build`, its
+     *        traversal, or copies its subtree from the DeclSubtreeCache.
+     *
+     * When the cache is enabled, a declaration whose source hash and digest
+     * of names and types match an entry is copied from it without being
+     * walked; otherwise what `build` adds is recorded under them. A
+     * declaration extending nodes built before it, as a redeclaration does,
+     * is always built.
+     *
+     * @return The result of `build`, or of the traversal the copy was recorded from.
+     */
+    bool BuildTopLevelDecl(clang::Decl* Decl, llvm::function_ref<bool()> build);
+
+    /**
+     * @brief Builds the top-level declaration `Decl` with `build`, its
+     *        traversal, noting in `speculation` what it added and looked up.
+     *
+     * For a context beside the one the tree is built in, on a thread of its
+     * own: AdoptTopLevelDecl copies the result into the tree when the
+     * declaration turns out not to depend on what was built before it there.
+     */
+    void SpeculateTopLevelDecl(Speculation& speculation, llvm::function_ref<bool()> build);
+
+    /**
+     * @brief Copies what `speculation` built into this builder's context, as
+     *        building its declaration here would have.
+     *
+     * Building a declaration depends on the tree before it only through the
+     * nodes it looks up by USR and declaration. A speculation that found none
+     * of them in its own context, and none of whose lookups or registrations
+     * find a node here either, built what this builder would build.
+     *
+     * @return false, copying nothing, when the declaration must be built here instead.
+     */
+    bool AdoptTopLevelDecl(const Speculation& speculation);
+
+    /**
+     * @brief Sets what else the subtrees of this context depend on, such as
+     *        the language and API filter, mixed into every cache key.
+     */
+    void SetDeclCacheScope(uint64_t scope);
+
     // Name management
     void PushName(llvm::StringRef name);
     void PopName();
-    const std::string GetCurrentQualifiedName();
+    // Names `node` by the current qualified name, relative to the node on top of the stack
+    void SetName(beta::APINode* node);
     
     // Utility methods
     bool IsDeclFromMainFileAndNotLocal(const clang::Decl* Decl);
@@ -59,20 +178,22 @@ public:
     bool isInNameSpaceOrClass(const clang::Decl* Decl);
     bool isWrittenInClassOrNamespace(const clang::Decl* TD);
     void processUnhandledDecl(const clang::Decl* Decl);
-    void processUnhandledStmt(const clang::Stmt* Stmt, const std::shared_ptr<beta::APINode>& node);
+    void processUnhandledStmt(const clang::Stmt* Stmt, beta::APINode* node);
+    uint64_t hashMainFileRange(clang::SourceManager& SM, clang::SourceRange Range);
+    uint64_t hashUnhandledRange(clang::SourceManager& SM, clang::SourceRange Range);
     uint64_t generateSemanticHashFromDecl(const clang::Decl* Decl);
     uint64_t generateSemanticHashFromStmt(const clang::Stmt* Stmt);
     void normalizeFunctionPointerType(std::string_view typeModifiers, clang::FunctionProtoTypeLoc FTL, const clang::NamedDecl* Decl);
     void normalizeValueDeclNode(const clang::ValueDecl *Decl, unsigned int pos = -1);
 
-    // Node building methods (supported)
+    // Node building methods (supported), instantiated for CLanguage and CxxLanguage
     bool BuildCXXRecordNode(clang::CXXRecordDecl* Decl);
-    bool BuildRecordNode(clang::RecordDecl* Decl);
-    bool BuildEnumNode(clang::EnumDecl* Decl);
-    bool BuildFunctionNode(clang::FunctionDecl* Decl);
-    bool BuildTypedefDecl(clang::TypedefDecl *Decl);
-    bool BuildVarDecl(clang::VarDecl *Decl);
-    bool BuildFieldDecl(clang::FieldDecl *Decl);
+    template <typename Language> bool BuildRecordNode(clang::RecordDecl* Decl);
+    template <typename Language> bool BuildEnumNode(clang::EnumDecl* Decl);
+    template <typename Language> bool BuildFunctionNode(clang::FunctionDecl* Decl);
+    template <typename Language> bool BuildTypedefDecl(clang::TypedefDecl *Decl);
+    template <typename Language> bool BuildVarDecl(clang::VarDecl *Decl);
+    template <typename Language> bool BuildFieldDecl(clang::FieldDecl *Decl);
     void BuildReturnTypeNode(clang::QualType type);
     
     // Unsupported declaration handlers (hash-only)
@@ -90,7 +211,7 @@ public:
     void BuildVarTemplateSpecializationDecl(clang::VarTemplateSpecializationDecl* Decl);
     void BuildVarTemplatePartialSpecializationDecl(clang::VarTemplatePartialSpecializationDecl* Decl);
     void BuildTypeAliasTemplateDecl(clang::TypeAliasTemplateDecl* Decl);
-    void BuildValueInitExpr(const clang::Expr* Expr, const std::shared_ptr<beta::APINode>& node);
+    void BuildValueInitExpr(const clang::Expr* Expr, beta::APINode* node);
 };
 
 }
\ No newline at end of file
@@ -2,32 +2,351 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #include "node.hpp"
 #include "ast_normalized_context.hpp"
+#include "diffengine.hpp"
+#include "clang/AST/Attr.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/SourceManager.h"
+#include "tree_builder_utils.hpp"
+#include "profiler.hpp"
+#include "fibonacci_hash.hpp"
+#include "logger.hpp"
 #include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/ADT/StringRef.h>
+#include <llvm-14/llvm/Support/MathExtras.h>
 #include <llvm-14/llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <cassert>
 #include <memory>
 #include <utility>
 
+void beta::NSRNodeMap::insert(llvm::StringRef key, beta::APINode* node) {
+    auto [it, inserted] = slots.try_emplace(key, Slot{node, NO_SPILL});
+    if (inserted) {
+        return;
+    }
+    Slot& slot = it->second;
+    if (slot.spill == NO_SPILL) {
+        slot.spill = static_cast<uint32_t>(spills.size());
+        spills.emplace_back();
+        spills.back().push_back(slot.node);
+    }
+    spills[slot.spill].push_back(node);
+}
+
+llvm::ArrayRef<beta::APINode*> beta::NSRNodeMap::find(llvm::StringRef key) const {
+    auto it = slots.find(key);
+    return it == slots.end() ? llvm::ArrayRef<APINode*>() : nodesOf(it->second);
+}
+
+void beta::NSRNodeMap::clear() {
+    slots.clear();
+    spills.clear();
+}
+
+namespace {
+
+    /**
+     * Whether the NSR of `Decl` is also its USR. The two generators share
+     * their code but for the parameter types of overloadable functions and the
+     * template arguments and parameters, so only a declaration in or under one
+     * of those can have a USR its NSR lacks.
+     */
+    bool isNSRAlsoUSR(const clang::NamedDecl* Decl) {
+        if (Decl->isTemplated()) {
+            return false;
+        }
+        for (const clang::Decl* scope = Decl; scope; scope = llvm::dyn_cast_or_null<clang::Decl>(scope->getDeclContext())) {
+            if (llvm::isa<clang::ClassTemplateSpecializationDecl, clang::VarTemplateSpecializationDecl>(scope)) {
+                return false;
+            }
+            if (const auto* function = llvm::dyn_cast<clang::FunctionDecl>(scope)) {
+                bool overloadable = (function->getASTContext().getLangOpts().CPlusPlus && !function->isExternC()) ||
+                                    function->hasAttr<clang::OverloadableAttr>();
+                if (overloadable || function->getTemplateSpecializationArgs()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Tables of a shared ShardedStringCache, see ASTNormalizedContext::shareASTStrings
+    enum SharedTable : unsigned {
+        SHARED_USR,
+        SHARED_NSR,
+        SHARED_WRITTEN_TYPE,
+        SHARED_CANONICAL_TYPE
+    };
+
+}
+
 beta::ASTNormalizedContext::ASTNormalizedContext() = default;
 
-void beta::ASTNormalizedContext::addNode(llvm::StringRef key, std::shared_ptr<beta::APINode> node) {
-    apiNodesMap[key].emplace_back(std::move(node));
+void beta::ASTNormalizedContext::addNode(llvm::StringRef key, beta::APINode* node) {
+    apiNodesMap.insert(key, node);
 }
 
-void beta::ASTNormalizedContext::addRootNode(std::shared_ptr<const beta::APINode> rootNode) {
+void beta::ASTNormalizedContext::addRootNode(const beta::APINode* rootNode) {
     if (rootNode) {
-        apiNodes.push_back(std::move(rootNode));
+        apiNodes.push_back(rootNode);
     }
 }
 
-const llvm::StringMap<llvm::SmallVector<std::shared_ptr<beta::APINode>,16>>& beta::ASTNormalizedContext::getTree() const {
+beta::APINode* beta::ASTNormalizedContext::createNode() {
+    armor::profile::count(armor::profile::Counter::NODES_BUILT);
+    return nodeArena.create();
+}
+
+void beta::ASTNormalizedContext::addChild(beta::APINode& parent, beta::APINode* child) {
+    nodeArena.addChild(parent, child);
+}
+
+llvm::StringRef beta::ASTNormalizedContext::intern(llvm::StringRef value) {
+    return nodeArena.intern(value);
+}
+
+void beta::ASTNormalizedContext::retainStorage(std::shared_ptr<const void> storage) {
+    retainedStorage.push_back(std::move(storage));
+}
+
+llvm::StringRef beta::ASTNormalizedContext::getUSR(const clang::NamedDecl* Decl) {
+    const clang::Decl* canonical = Decl->getCanonicalDecl();
+    auto inserted = usrCache.try_emplace(canonical);
+    if (inserted.second) {
+        if (isNSRAlsoUSR(Decl)) {
+            // Most declarations: the NSR is needed anyway and costs no second string
+            inserted.first->second = getNSR(Decl);
+        }
+        else if (std::optional<llvm::StringRef> shared = findShared(canonical, SHARED_USR)) {
+            inserted.first->second = *shared;
+        }
+        else {
+            armor::profile::count(armor::profile::Counter::USRS_GENERATED);
+            auto nsr = nsrCache.try_emplace(canonical);
+            if (nsr.second) {
+                // The NSR is needed too; both come from one walk of the declaration
+                generateUSRAndNSRForDecl(Decl, usrBuffer, nsrBuffer);
+                nsr.first->second = internAST(canonical, SHARED_NSR, nsrBuffer.str());
+                inserted.first->second = internAST(canonical, SHARED_USR, usrBuffer.str());
+            }
+            else {
+                inserted.first->second = internAST(canonical, SHARED_USR, generateUSRForDecl(Decl));
+            }
+        }
+    }
+    return inserted.first->second;
+}
+
+llvm::StringRef beta::ASTNormalizedContext::getNSR(const clang::NamedDecl* Decl) {
+    const clang::Decl* canonical = Decl->getCanonicalDecl();
+    auto inserted = nsrCache.try_emplace(canonical);
+    if (inserted.second) {
+        std::optional<llvm::StringRef> shared = findShared(canonical, SHARED_NSR);
+        inserted.first->second = shared ? *shared : internAST(canonical, SHARED_NSR, generateNSRForDecl(Decl));
+    }
+    return inserted.first->second;
+}
+
+std::pair<llvm::StringRef, llvm::StringRef> beta::ASTNormalizedContext::getTypeStrings(clang::QualType T,
+                                                                                       const clang::ASTContext& Ctx) {
+    if (T.isNull()) {
+        return {llvm::StringRef(), llvm::StringRef()};
+    }
+
+    void* writtenKey = T.getAsOpaquePtr();
+    auto written = writtenTypeCache.try_emplace(writtenKey);
+    if (written.second) {
+        if (std::optional<llvm::StringRef> shared = findShared(writtenKey, SHARED_WRITTEN_TYPE)) {
+            written.first->second = *shared;
+        }
+        else {
+            printTypeAsWritten(T, Ctx, typeBuffer, astMutex);
+            written.first->second = internAST(writtenKey, SHARED_WRITTEN_TYPE, typeBuffer.str());
+        }
+    }
+    void* canonicalKey = T.getCanonicalType().getAsOpaquePtr();
+    auto canonical = canonicalTypeCache.try_emplace(canonicalKey);
+    if (canonical.second) {
+        if (std::optional<llvm::StringRef> shared = findShared(canonicalKey, SHARED_CANONICAL_TYPE)) {
+            canonical.first->second = *shared;
+        }
+        else if (printsAsCanonical(T)) {
+            // Most parameter and field types; the written string is already pooled
+            canonical.first->second = internAST(canonicalKey, SHARED_CANONICAL_TYPE, written.first->second);
+        }
+        else {
+            printCanonicalType(T, Ctx, typeBuffer, astMutex);
+            canonical.first->second = internAST(canonicalKey, SHARED_CANONICAL_TYPE, typeBuffer.str());
+        }
+    }
+    return {written.first->second, canonical.first->second};
+}
+
+void beta::ASTNormalizedContext::shareASTStrings(std::shared_ptr<armor::ShardedStringCache> cache) {
+    sharedStrings = cache.get();
+    retainStorage(std::move(cache));
+}
+
+std::unique_ptr<beta::ASTNormalizedContext> beta::ASTNormalizedContext::createSibling() const {
+    auto sibling = std::make_unique<ASTNormalizedContext>();
+    sibling->clangContext = clangContext;
+    sibling->ownedFile = ownedFile;
+    // Kept alive by this context
+    sibling->sharedStrings = sharedStrings;
+    return sibling;
+}
+
+std::optional<llvm::StringRef> beta::ASTNormalizedContext::findShared(const void* key, unsigned table) const {
+    if (!sharedStrings) {
+        return std::nullopt;
+    }
+    return sharedStrings->find(key, table);
+}
+
+llvm::StringRef beta::ASTNormalizedContext::internAST(const void* key, unsigned table, llvm::StringRef value) {
+    return sharedStrings ? sharedStrings->insert(key, table, value) : nodeArena.intern(value);
+}
+
+void beta::ASTNormalizedContext::clearASTCaches() {
+    usrCache.clear();
+    nsrCache.clear();
+    writtenTypeCache.clear();
+    canonicalTypeCache.clear();
+    sharedStrings = nullptr;
+    ownedRangeSM = nullptr;
+}
+
+const beta::NSRNodeMap& beta::ASTNormalizedContext::getTree() const {
     return apiNodesMap;
 }
 
-const llvm::SmallVector<std::shared_ptr<const beta::APINode>,64>& beta::ASTNormalizedContext::getRootNodes() const {
+size_t beta::ASTNormalizedContext::countNodes(llvm::StringRef nsr) const {
+    return apiNodesMap.find(nsr).size();
+}
+
+llvm::ArrayRef<beta::APINode*> beta::ASTNormalizedContext::findNodes(llvm::StringRef nsr) const {
+    return apiNodesMap.find(nsr);
+}
+
+const beta::APINode* beta::ASTNormalizedContext::findNodeByUSR(llvm::StringRef usr) const {
+    if (!frozen) {
+        auto it = usrNodeMap.find(usr);
+        return it == usrNodeMap.end() ? nullptr : it->second;
+    }
+    if (usrSlots.empty()) {
+        return nullptr;
+    }
+    uint64_t hash = FibonacciHash::hash(usr);
+    size_t mask = usrSlots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        uint32_t index = usrSlots[slot];
+        if (index == EMPTY_SLOT) {
+            return nullptr;
+        }
+        const FrozenUSR& entry = frozenUSRs[index];
+        if (entry.hash == hash && entry.usr == usr) {
+            return entry.node;
+        }
+    }
+}
+
+void beta::ASTNormalizedContext::forEachUSR(llvm::function_ref<void(llvm::StringRef, const APINode*)> visit) const {
+    if (!frozen) {
+        for (const auto& entry : usrNodeMap) {
+            visit(entry.getKey(), entry.getValue());
+        }
+        return;
+    }
+    for (const FrozenUSR& entry : frozenUSRs) {
+        visit(entry.usr, entry.node);
+    }
+}
+
+void beta::ASTNormalizedContext::forEachUnsupportedUSR(llvm::function_ref<void(llvm::StringRef)> visit) const {
+    if (!frozen) {
+        for (const auto& entry : unSupportedUsrNodeMap) {
+            visit(entry.getKey());
+        }
+        return;
+    }
+    for (llvm::StringRef usr : frozenUnsupportedUSRs) {
+        visit(usr);
+    }
+}
+
+void beta::ASTNormalizedContext::freeze() {
+    if (frozen) {
+        return;
+    }
+    frozenUSRs.reserve(usrNodeMap.size());
+    for (const auto& entry : usrNodeMap) {
+        // The map owns its keys; nodes almost always carry the same USR in the pool
+        llvm::StringRef key = entry.getKey();
+        APINode* node = entry.getValue();
+        llvm::StringRef usr = node && node->USR == key ? node->USR : nodeArena.intern(key);
+        frozenUSRs.push_back({FibonacciHash::hash(usr), usr, node});
+    }
+    std::sort(frozenUSRs.begin(), frozenUSRs.end(),
+              [](const FrozenUSR& a, const FrozenUSR& b) { return a.usr < b.usr; });
+
+    if (!frozenUSRs.empty()) {
+        usrSlots.assign(llvm::PowerOf2Ceil(frozenUSRs.size() * 2), EMPTY_SLOT);
+        size_t mask = usrSlots.size() - 1;
+        for (uint32_t i = 0; i < frozenUSRs.size(); ++i) {
+            size_t slot = frozenUSRs[i].hash & mask;
+            while (usrSlots[slot] != EMPTY_SLOT) {
+                slot = (slot + 1) & mask;
+            }
+            usrSlots[slot] = i;
+        }
+    }
+
+    frozenUnsupportedUSRs.reserve(unSupportedUsrNodeMap.size());
+    for (const auto& entry : unSupportedUsrNodeMap) {
+        frozenUnsupportedUSRs.push_back(nodeArena.intern(entry.getKey()));
+    }
+    std::sort(frozenUnsupportedUSRs.begin(), frozenUnsupportedUSRs.end());
+
+    // clear() keeps the buckets, so the maps are replaced to give their memory back
+    usrNodeMap = llvm::StringMap<APINode*>();
+    unSupportedUsrNodeMap = llvm::StringSet<>();
+    frozen = true;
+}
+
+const llvm::SmallVector<const beta::APINode*,64>& beta::ASTNormalizedContext::getRootNodes() const {
     return apiNodes;
 }
 
+void beta::ASTNormalizedContext::computeFingerprints() {
+    // Every node of the finished tree passes here once, so --profile=mem counts its kinds here too
+    bool countKinds = armor::profile::Profiler::getInstance().isMemoryProfiling();
+    for (const NSRNodeMap::Entry& entry : apiNodesMap) {
+        for (beta::APINode* node : entry.nodes) {
+            node->computeFingerprint();
+            if (countKinds) {
+                armor::profile::countNodes(node->kind);
+            }
+        }
+    }
+
+    typeUsageIndex.clear();
+    if (getTypeChangeCollapsing() == 0) {
+        return;
+    }
+    llvm::SmallVector<const beta::APINode*, 64> pending(apiNodes.begin(), apiNodes.end());
+    while (!pending.empty()) {
+        const beta::APINode* node = pending.pop_back_val();
+        if (!node->dataType.empty()) {
+            typeUsageIndex.addUser(node->dataType);
+        }
+        pending.append(node->children.begin(), node->children.end());
+    }
+}
+
+const TypeUsageIndex& beta::ASTNormalizedContext::getTypeUsageIndex() const {
+    return typeUsageIndex;
+}
+
 bool beta::ASTNormalizedContext::empty() const {
     return apiNodesMap.empty() && apiNodes.empty();
 }
@@ -35,7 +354,33 @@ bool beta::ASTNormalizedContext::empty() const {
 void beta::ASTNormalizedContext::clear() {
     apiNodesMap.clear();
     apiNodes.clear();
+    usrNodeMap.clear();
+    unSupportedUsrNodeMap.clear();
+    frozenUSRs.clear();
+    usrSlots.clear();
+    frozenUnsupportedUSRs.clear();
+    frozen = false;
+    nodeArena.reset();
+    retainedStorage.clear();
+    clearASTCaches();
     sourceRangeTracker.clear();
+    typeUsageIndex.clear();
+    ownedFile = clang::FileID();
+}
+
+void beta::ASTNormalizedContext::fingerprintRoots(size_t first) {
+    for (size_t i = first; i < apiNodes.size(); ++i) {
+        // The roots are listed const, but the context created them
+        const_cast<beta::APINode*>(apiNodes[i])->computeFingerprint();
+    }
+}
+
+void beta::ASTNormalizedContext::setDiffPipeline(RootDiffPipeline* pipeline) {
+    diffPipeline = pipeline;
+}
+
+RootDiffPipeline* beta::ASTNormalizedContext::getDiffPipeline() const {
+    return diffPipeline;
 }
 
 void beta::ASTNormalizedContext::addClangASTContext(clang::ASTContext *ASTContext){
@@ -46,67 +391,193 @@ clang::ASTContext* beta::ASTNormalizedContext::getClangASTContext() const {
     return clangContext; 
 }
 
+void beta::ASTNormalizedContext::setOwnedFile(clang::FileID file) {
+    ownedFile = file;
+    ownedRangeSM = nullptr;
+}
+
+clang::FileID beta::ASTNormalizedContext::getOwnedFile(const clang::SourceManager& SM) const {
+    return ownedFile.isValid() ? ownedFile : SM.getMainFileID();
+}
+
+bool beta::ASTNormalizedContext::ownsLocation(const clang::SourceManager& SM, clang::SourceLocation loc) const {
+    if (ownedRangeSM != &SM) {
+        // The file's locations are the offsets from its entry's through its size,
+        // the last one being its end of file
+        clang::FileID file = getOwnedFile(SM);
+        bool invalid = file.isInvalid();
+        const clang::SrcMgr::SLocEntry* entry = invalid ? nullptr : &SM.getSLocEntry(file, &invalid);
+        // In the main file, a line marker can place text in an included file
+        ownedRangeExact = !invalid && entry->isFile() &&
+                          (ownedFile.isValid() || !entry->getFile().hasLineDirectives());
+        ownedBegin = ownedRangeExact ? entry->getOffset() : 0;
+        ownedSize = ownedRangeExact ? SM.getFileIDSize(file) : 0;
+        ownedRangeSM = &SM;
+    }
+    if (loc.isInvalid()) {
+        return false;
+    }
+    if (ownedRangeExact) {
+        clang::SourceLocation expansion = loc.isFileID() ? loc : SM.getExpansionLoc(loc);
+        return expansion.getOffset() - ownedBegin <= ownedSize;
+    }
+    if (!ownedFile.isValid()) {
+        return SM.isInMainFile(loc);
+    }
+    return SM.getFileID(SM.getExpansionLoc(loc)) == ownedFile;
+}
+
 const llvm::SmallVector<beta::Range,32>& beta::SourceRangeTracker::getComments() const {
     return comments;
 }
 
-const std::map<unsigned, beta::Range>& beta::SourceRangeTracker::getInactivePPDirectives() const {
+const llvm::SmallVector<beta::Range, 16>& beta::SourceRangeTracker::getInactivePPDirectives() const {
     return inactivePPDirectives;
 }
 
-std::map<unsigned, beta::Range>& beta::SourceRangeTracker::getInactivePPDirectives(){
+llvm::SmallVector<beta::Range, 16>& beta::SourceRangeTracker::getInactivePPDirectives(){
     return inactivePPDirectives;
 }
 
-void beta::SourceRangeTracker::moveInactivePPDirectives(std::map<unsigned, beta::Range>& ranges) {
+void beta::SourceRangeTracker::moveInactivePPDirectives(llvm::SmallVector<beta::Range, 16>& ranges) {
     inactivePPDirectives = std::move(ranges);
 }
 
-void beta::SourceRangeTracker::moveComments(llvm::SmallVector<beta::Range, 32> &ranges){
+void beta::SourceRangeTracker::moveComments(llvm::SmallVector<beta::Range, 32> &ranges, llvm::StringRef mainBuffer){
     comments = std::move(ranges);
+    commentBuffer = mainBuffer;
+    commentsPending = !comments.empty();
 }
 
-void beta::SourceRangeTracker::moveInactiveUnhandledDeclsHashMap(llvm::DenseMap<uint64_t, int>& hashMap) {
+void beta::SourceRangeTracker::moveInactiveUnhandledDeclsHashMap(HashMultiset& hashMap) {
     inactiveUnhandledDeclsHashMap = std::move(hashMap);
 }
 
-void beta::SourceRangeTracker::moveCommentsHashMap(llvm::DenseMap<uint64_t, int>& hashMap) {
-    commentsHashMap = std::move(hashMap);
-}
-
-llvm::DenseMap<uint64_t, int>& beta::SourceRangeTracker::getUnhandledDeclsHashMap() {
+HashMultiset& beta::SourceRangeTracker::getUnhandledDeclsHashMap() {
     return unhandledDeclsHashMap;
 }
 
 void beta::SourceRangeTracker::addUnhandledDeclHash(uint64_t hash) {
-    unhandledDeclsHashMap[hash]++;
+    unhandledDeclsHashMap.insert(hash);
 }
 
-const llvm::DenseMap<uint64_t, int>& beta::SourceRangeTracker::getUnhandledDeclsHashMap() const {
+const HashMultiset& beta::SourceRangeTracker::getUnhandledDeclsHashMap() const {
     return unhandledDeclsHashMap;
 }
 
-llvm::DenseMap<uint64_t, int>& beta::SourceRangeTracker::getInactiveUnhandledDeclsHashMap() {
+HashMultiset& beta::SourceRangeTracker::getInactiveUnhandledDeclsHashMap() {
     return inactiveUnhandledDeclsHashMap;
 }
 
-const llvm::DenseMap<uint64_t, int>& beta::SourceRangeTracker::getInactiveUnhandledDeclsHashMap() const {
+const HashMultiset& beta::SourceRangeTracker::getInactiveUnhandledDeclsHashMap() const {
     return inactiveUnhandledDeclsHashMap;
 }
 
-llvm::DenseMap<uint64_t, int>& beta::SourceRangeTracker::getCommentsHashMap(){
+HashMultiset& beta::SourceRangeTracker::getCommentsHashMap(){
+    hashComments();
     return commentsHashMap;
 }
 
-const llvm::DenseMap<uint64_t, int>& beta::SourceRangeTracker::getCommentsHashMap() const {
+const HashMultiset& beta::SourceRangeTracker::getCommentsHashMap() const {
+    hashComments();
     return commentsHashMap;
 }
 
+void beta::SourceRangeTracker::hashComments() const {
+    std::lock_guard<std::mutex> lock(commentsMutex);
+    if (!commentsPending) {
+        return;
+    }
+    commentsPending = false;
+
+    llvm::StringRef text = rangeDigests.hasSource() ? rangeDigests.getSource() : commentBuffer;
+    auto byStart = [](const beta::Range& a, const beta::Range& b) { return a.startOffset < b.startOffset; };
+    // Both are produced in source order; the sweep below relies on it
+    assert(std::is_sorted(comments.begin(), comments.end(), byStart));
+    assert(std::is_sorted(inactivePPDirectives.begin(), inactivePPDirectives.end(), byStart));
+
+    // One merge of the two sorted lists: the candidate region of a comment is
+    // the last one starting at or before it, and it only moves forward
+    size_t region = 0;
+    for (const beta::Range& comment : comments) {
+        while (region + 1 < inactivePPDirectives.size() &&
+               inactivePPDirectives[region + 1].startOffset <= comment.startOffset) {
+            ++region;
+        }
+        if (region < inactivePPDirectives.size() &&
+            inactivePPDirectives[region].startOffset <= comment.startOffset &&
+            comment.endOffset <= inactivePPDirectives[region].endOffset) {
+            continue;
+        }
+        if (comment.startOffset >= comment.endOffset || comment.endOffset > text.size()) {
+            continue;
+        }
+        llvm::StringRef commentText = text.slice(comment.startOffset, comment.endOffset);
+        uint64_t hash = FibonacciHash::hash(commentText);
+        armor::profile::count(armor::profile::Counter::HASHES_COMPUTED);
+        commentsHashMap.insert(hash);
+        rangeDigests.record(RangeDigests::Category::Comments, hash, comment.startOffset, comment.endOffset,
+                            SourceHashIndex::Normalization::Whitespace);
+        TEST_LOG << hash << "\n";
+        TEST_LOG << commentText << "\n----------------------------------------\n";
+    }
+    comments = {};
+    inactivePPDirectives = {};
+}
+
+MacroTable& beta::SourceRangeTracker::getMacros() {
+    return macros;
+}
+
+const MacroTable& beta::SourceRangeTracker::getMacros() const {
+    return macros;
+}
+
+RangeDigests& beta::SourceRangeTracker::getRangeDigests() {
+    return rangeDigests;
+}
+
+const RangeDigests& beta::SourceRangeTracker::getRangeDigests() const {
+    return rangeDigests;
+}
+
+SourceHashIndex& beta::SourceRangeTracker::getSourceHashIndex(llvm::StringRef mainBuffer) {
+    if (!sourceHashIndex || sourceHashIndex->getBuffer().data() != mainBuffer.data() ||
+        sourceHashIndex->getBuffer().size() != mainBuffer.size()) {
+        sourceHashIndex = std::make_unique<SourceHashIndex>(mainBuffer);
+    }
+    return *sourceHashIndex;
+}
+
+void beta::SourceRangeTracker::releaseSourceHashIndex() {
+    // Unhashed comments need the text as much as the recorded ranges do
+    llvm::StringRef text = sourceHashIndex ? sourceHashIndex->getBuffer() : commentBuffer;
+    if (!text.empty() && (!rangeDigests.empty() || commentsPending)) {
+        rangeDigests.keepSource(text);
+    }
+    commentBuffer = {};
+    sourceHashIndex.reset();
+}
+
+void beta::SourceRangeTracker::releaseRanges() {
+    if (commentsPending) {
+        return;
+    }
+    // Assigning fresh vectors frees their heap storage, which clear() keeps
+    comments = {};
+    inactivePPDirectives = {};
+}
+
 void beta::SourceRangeTracker::clear() {
     comments.clear();
     inactivePPDirectives.clear();
+    commentBuffer = {};
+    commentsPending = false;
     unhandledDeclsHashMap.clear();
     inactiveUnhandledDeclsHashMap.clear();
+    macros.clear();
+    rangeDigests.clear();
+    sourceHashIndex.reset();
 }
 
 bool beta::SourceRangeTracker::empty() const {
@@ -1,16 +1,29 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 #include<iostream>
+#include <llvm-14/llvm/ADT/Hashing.h>
 #include <llvm-14/llvm/Support/Casting.h>
+#include <llvm-14/llvm/Support/Path.h>
 #include <llvm-14/llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "astnormalizer.hpp"
+#include "decl_subtree_cache.hpp"
+#include "diffengine.hpp"
 #include "node.hpp"
 #include "session.hpp"
 #include "tree_builder.hpp"
 #include "comment_handler.hpp"
 #include "preprocesor.hpp"
+#include "profiler.hpp"
+#include "sharded_string_cache.hpp"
+#include "work_pool.hpp"
 #include "clang/AST/APValue.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclTemplate.h"
@@ -20,22 +33,250 @@
 #include "clang/Frontend/CompilerInstance.h"
 
 // --- beta::ASTNormalize ---
-beta::ASTNormalize::ASTNormalize(beta::APISession* session, beta::ASTNormalizedContext* context, clang::ASTContext* clangContext)
-    : session(session), context(context), clangContext(clangContext), treeBuilder(beta::TreeBuilder(context)) {}
+template <typename Language>
+beta::ASTNormalize<Language>::ASTNormalize(beta::APISession* session, beta::ASTNormalizedContext* context, clang::ASTContext* clangContext)
+    : session(session), context(context), clangContext(clangContext), treeBuilder(beta::TreeBuilder(context)) {
+    // USRs of a few declarations spell the file name, an API filter drops declarations below the
+    // top level, and records only carry layouts while those are compared
+    const clang::SourceManager& SM = clangContext->getSourceManager();
+    const clang::FileEntry* file = SM.getFileEntryForID(context->getOwnedFile(SM));
+    const armor::ApiFilter* filter = session->getApiFilter();
+    treeBuilder.SetDeclCacheScope(llvm::hash_combine(
+        clangContext->getLangOpts().CPlusPlus,
+        file ? llvm::sys::path::filename(file->getName()) : llvm::StringRef(),
+        filter ? llvm::StringRef(filter->fingerprint()) : llvm::StringRef(),
+        isRecordLayoutEnabled()));
+}
 // (Implementation of visitor methods remains the same conceptually)
 
 
+namespace {
+
+    // The children of the unit a traversal of the whole unit passes over, as
+    // RecursiveASTVisitor::canIgnoreChildDeclWhileTraversingDeclContext does
+    bool isSkippedChildOfUnit(const clang::Decl* decl) {
+        if (llvm::isa<clang::BlockDecl>(decl) || llvm::isa<clang::CapturedDecl>(decl)) {
+            return true;
+        }
+        const auto* record = llvm::dyn_cast<clang::CXXRecordDecl>(decl);
+        return record && record->isLambda();
+    }
+
+    constexpr size_t NO_UNIT = SIZE_MAX;
+
+    // A step of a traversal of the whole unit: the visit of a namespace
+    // itself, or a declaration with everything below it
+    struct BuildUnit {
+        clang::Decl* decl;
+        // The namespace unit the declaration is listed under, or NO_UNIT
+        size_t parent;
+        bool namespaceOnly;
+        // For a namespace, one past the last unit below it
+        size_t end = 0;
+    };
+
+    // The units of the declarations `scope` lists, in the order a traversal
+    // visits them; namespaces and extern "C" blocks are opened
+    template <typename Language>
+    void collectBuildUnits(beta::ASTNormalize<Language>& visitor, clang::DeclContext* scope, size_t parent,
+                           std::vector<BuildUnit>& units) {
+        for (clang::Decl* decl : scope->decls()) {
+            // Implicit declarations are not visited either
+            if (isSkippedChildOfUnit(decl) || decl->isImplicit() || visitor.skipsDecl(decl)) {
+                continue;
+            }
+            if (auto* linkage = llvm::dyn_cast<clang::LinkageSpecDecl>(decl)) {
+                collectBuildUnits(visitor, linkage, parent, units);
+                continue;
+            }
+            if constexpr (Language::CPlusPlus) {
+                if (auto* space = llvm::dyn_cast<clang::NamespaceDecl>(decl)) {
+                    size_t unit = units.size();
+                    units.push_back({space, parent, true});
+                    collectBuildUnits(visitor, space, unit, units);
+                    units[unit].end = units.size();
+                    continue;
+                }
+            }
+            units.push_back({decl, parent, false});
+        }
+    }
+
+    /**
+     * Builds the tree of `unit` with `visitor` as traversing it would, with
+     * the declarations built ahead on `jobs` threads, see setTreeBuildJobs.
+     *
+     * Each thread builds the declarations it takes into a sibling context
+     * with a visitor of its own. The visitor then goes through the units in
+     * order, adopting what was built ahead where it can and building the rest
+     * itself. A traversal returning false stops the declarations of its
+     * scope, which a namespace's traversal does not pass on.
+     */
+    template <typename Language>
+    void buildUnitsInParallel(beta::ASTNormalize<Language>& visitor, beta::APISession* session,
+                              clang::TranslationUnitDecl* unit, unsigned jobs) {
+        beta::ASTNormalizedContext* context = visitor.context;
+        std::vector<BuildUnit> units;
+        collectBuildUnits(visitor, unit, NO_UNIT, units);
+        if (units.size() < 2) {
+            visitor.TraverseDecl(unit);
+            return;
+        }
+        jobs = static_cast<unsigned>(std::min<size_t>(jobs, units.size()));
+
+        // USRs and type strings one thread generates the others look up
+        if (!context->sharesASTStrings()) {
+            context->shareASTStrings(std::make_shared<armor::ShardedStringCache>());
+        }
+        std::vector<beta::TreeBuilder::Speculation> speculations(units.size());
+        std::vector<std::unique_ptr<beta::ASTNormalizedContext>> siblings(jobs);
+        std::mutex astMutex;
+        std::atomic<size_t> next{0};
+        armor::profile::HeaderProfile* profile = armor::profile::current();
+        armor::parallelFor(jobs, jobs, [&](size_t worker) {
+            armor::profile::HeaderScope scope(profile);
+            siblings[worker] = context->createSibling();
+            siblings[worker]->setASTMutex(&astMutex);
+            beta::ASTNormalize<Language> builder(session, siblings[worker].get(), visitor.clangContext);
+            for (size_t index = next++; index < units.size(); index = next++) {
+                if (units[index].namespaceOnly) {
+                    continue;
+                }
+                beta::TreeBuilder::Speculation& speculation = speculations[index];
+                speculation.decl = units[index].decl;
+                builder.treeBuilder.SpeculateTopLevelDecl(speculation, [&]() {
+                    return builder.TraverseDecl(speculation.decl);
+                });
+            }
+        });
+
+        for (size_t index = 0; index < units.size(); ++index) {
+            const BuildUnit& current = units[index];
+            if (current.namespaceOnly) {
+                if (!visitor.VisitNamespaceDecl(llvm::cast<clang::NamespaceDecl>(current.decl))) {
+                    index = current.end - 1;
+                }
+                continue;
+            }
+            bool result = visitor.treeBuilder.AdoptTopLevelDecl(speculations[index])
+                              ? speculations[index].result
+                              : visitor.TraverseDecl(current.decl);
+            if (!result) {
+                if (current.parent == NO_UNIT) {
+                    break;
+                }
+                index = units[current.parent].end - 1;
+            }
+        }
+        // Ranges the siblings hashed, for the rebuilt declarations as well; digests of a range repeat
+        for (const auto& sibling : siblings) {
+            context->getSourceRangeTracker().getRangeDigests().append(sibling->getSourceRangeTracker().getRangeDigests());
+        }
+    }
+
+}
+
 // --- beta::ASTNormalizeConsumer ---
 // Constructor simply stores the pointers.
 beta::ASTNormalizeConsumer::ASTNormalizeConsumer(APISession* session, beta::ASTNormalizedContext* context)
     : session(session), context(context) {}
 
+void beta::ASTNormalizeConsumer::startVisitor(clang::ASTContext& clangContext) {
+    if (!cVisitor && !cxxVisitor) {
+        context->addClangASTContext(&clangContext);
+        if (clangContext.getLangOpts().CPlusPlus) {
+            cxxVisitor = std::make_unique<beta::ASTNormalize<beta::CxxLanguage>>(session, context, &clangContext);
+        }
+        else {
+            cVisitor = std::make_unique<beta::ASTNormalize<beta::CLanguage>>(session, context, &clangContext);
+        }
+    }
+}
+
+void beta::ASTNormalizeConsumer::traverse(clang::Decl* Decl) {
+    if (cxxVisitor) {
+        cxxVisitor->TraverseDecl(Decl);
+    }
+    else {
+        cVisitor->TraverseDecl(Decl);
+    }
+}
+
+void beta::ASTNormalizeConsumer::buildInParallel(clang::TranslationUnitDecl* unit, unsigned jobs) {
+    if (cxxVisitor) {
+        buildUnitsInParallel(*cxxVisitor, session, unit, jobs);
+    }
+    else {
+        buildUnitsInParallel(*cVisitor, session, unit, jobs);
+    }
+}
+
+void beta::ASTNormalizeConsumer::normalizeUnitFrom(clang::TranslationUnitDecl* unit) {
+    armor::profile::PhaseTimer timer(armor::profile::Phase::TREE_BUILD);
+    clang::DeclContext::decl_iterator next =
+        lastNormalized ? std::next(clang::DeclContext::decl_iterator(lastNormalized)) : unit->decls_begin();
+    for (; next != unit->decls_end(); ++next) {
+        if (!isSkippedChildOfUnit(*next)) {
+            traverse(*next);
+        }
+        lastNormalized = *next;
+    }
+}
+
+bool beta::ASTNormalizeConsumer::HandleTopLevelDecl(clang::DeclGroupRef group) {
+    RootDiffPipeline* pipeline = context->getDiffPipeline();
+    if (!pipeline || chunkingStopped || group.isNull()) {
+        return true;
+    }
+    clang::ASTContext& clangContext = (*group.begin())->getASTContext();
+    if (clangContext.getDiagnostics().hasErrorOccurred()) {
+        chunkingStopped = true;
+        return true;
+    }
+    // Instantiations are handed over too, possibly while a class of the unit
+    // is still being defined; they are not listed in the unit
+    clang::TranslationUnitDecl* unit = clangContext.getTranslationUnitDecl();
+    if (std::none_of(group.begin(), group.end(), [unit](clang::Decl* decl) { return unit->containsDecl(decl); })) {
+        return true;
+    }
+    startVisitor(clangContext);
+
+    std::lock_guard<std::mutex> lock(pipeline->treeMutex());
+    size_t firstRoot = context->getRootNodes().size();
+    // Up to the group, along with what the unit lists without handing over,
+    // such as a class first named by a parameter
+    normalizeUnitFrom(unit);
+    pipeline->addRoots(*context, firstRoot);
+    return true;
+}
+
 void beta::ASTNormalizeConsumer::HandleTranslationUnit(clang::ASTContext &clangContext) {
-    // Creates the visitor, passing along the pointers to the session and the pre-existing context.
-    context->addClangASTContext(&clangContext);
+    startVisitor(clangContext);
+    RootDiffPipeline* pipeline = context->getDiffPipeline();
+    if (!pipeline) {
+        {
+            armor::profile::PhaseTimer timer(armor::profile::Phase::TREE_BUILD);
+            // Declarations clang loads as they are first reached must not be reached on several threads
+            unsigned jobs = getTreeBuildJobs();
+            if (jobs > 1 && !clangContext.getExternalSource() && !clangContext.getDiagnostics().hasErrorOccurred() &&
+                !DeclSubtreeCache::getInstance().isEnabled()) {
+                buildInParallel(clangContext.getTranslationUnitDecl(), jobs);
+            }
+            else {
+                traverse(clangContext.getTranslationUnitDecl());
+            }
+        }
+        context->computeFingerprints();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(pipeline->treeMutex());
+    normalizeUnitFrom(clangContext.getTranslationUnitDecl());
+    context->computeFingerprints();
+}
 
-    beta::ASTNormalize visitor(session, context, &clangContext);
-    visitor.TraverseDecl(clangContext.getTranslationUnitDecl());
+bool beta::ASTNormalizeConsumer::shouldSkipFunctionBody(clang::Decl *D) {
+    return !context->ownsLocation(D->getASTContext().getSourceManager(), D->getLocation());
 }
 
 // --- NormalizeAction ---
@@ -46,17 +287,26 @@ beta::NormalizeAction::NormalizeAction(APISession* session, beta::ASTNormalizedC
 std::unique_ptr<clang::ASTConsumer> beta::NormalizeAction::CreateASTConsumer(clang::CompilerInstance& CI, clang::StringRef) {
     // Store CI reference for cleanup
     this->CI = &CI;
-    
-    // Set up comment handler
-    auto commentHandlerPtr = std::make_unique<beta::CommentHandler>(&CI.getSourceManager(), context);
-    commentHandler = commentHandlerPtr.get(); // Store reference before releasing
-    CI.getPreprocessor().addCommentHandler(commentHandlerPtr.release());
+
+    // Read by ExecuteAction, which runs after the consumer is created
+    if (session->getSkipForeignBodies()) {
+        CI.getFrontendOpts().SkipFunctionBodies = true;
+    }
+
+    if (session->getParseMode() == API_ONLY_MODE) {
+        return std::make_unique<beta::ASTNormalizeConsumer>(session, context);
+    }
     
     // Set up preprocessor callbacks
-    auto preprocessorPtr = std::make_unique<beta::ASTNormalizerPreprocessor>(&CI.getSourceManager(), context);
+    auto preprocessorPtr = std::make_unique<beta::ASTNormalizerPreprocessor>(&CI.getSourceManager(), CI.getLangOpts(), context);
     preprocessor = preprocessorPtr.get(); // Store reference before moving
     CI.getPreprocessor().addPPCallbacks(std::move(preprocessorPtr)); // Preprocessor takes ownership
 
+    // Set up comment handler, gated by the callbacks' view of the file being lexed
+    auto commentHandlerPtr = std::make_unique<beta::CommentHandler>(&CI.getSourceManager(), context, preprocessor);
+    commentHandler = commentHandlerPtr.get(); // Store reference before releasing
+    CI.getPreprocessor().addCommentHandler(commentHandlerPtr.release());
+
     // No creation happens here. It just passes the pointers it already has to the consumer.
     return std::make_unique<beta::ASTNormalizeConsumer>(session, context);
 }
@@ -78,6 +328,31 @@ std::unique_ptr<clang::FrontendAction> beta::NormalizeActionFactory::create() {
     return std::make_unique<NormalizeAction>(session, contextForThisFile);
 }
 
+namespace {
+
+    class BatchNormalizeAction : public beta::NormalizeAction {
+        public:
+            BatchNormalizeAction(beta::APISession* session, const llvm::StringMap<std::string>& fileKeys)
+                : beta::NormalizeAction(session, nullptr), fileKeys(fileKeys) {}
+
+            std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance& CI, clang::StringRef inFile) override {
+                context = session->getContext(fileKeys.lookup(inFile));
+                return beta::NormalizeAction::CreateASTConsumer(CI, inFile);
+            }
+
+        private:
+            const llvm::StringMap<std::string>& fileKeys;
+    };
+
+}
+
+beta::BatchNormalizeActionFactory::BatchNormalizeActionFactory(APISession* session, const llvm::StringMap<std::string>& fileKeys)
+    : session(session), fileKeys(fileKeys) {}
+
+std::unique_ptr<clang::FrontendAction> beta::BatchNormalizeActionFactory::create() {
+    return std::make_unique<BatchNormalizeAction>(session, fileKeys);
+}
+
 void beta::NormalizeAction::EndSourceFileAction() {
 
     // Finalize preprocessor callbacks (must be done before Preprocessor is destroyed)
@@ -95,23 +370,94 @@ void beta::NormalizeAction::EndSourceFileAction() {
         commentHandler = nullptr;
     }
     
-    filterCommentsInInactiveRegions(context, &context->getClangASTContext()->getSourceManager());
+    // Every range is hashed by now; the index must not outlive the source buffer
+    context->getSourceRangeTracker().releaseSourceHashIndex();
+    // Only the hashes are compared from here on, and the comments hashed on demand
+    context->getSourceRangeTracker().releaseRanges();
+    // Nor may the caches keyed by declarations and types outlive the AST
+    context->clearASTCaches();
+    // The tree is complete; from here on it is only read
+    context->freeze();
     
     // Call parent implementation
     clang::ASTFrontendAction::EndSourceFileAction();
 }
 
+namespace {
+
+    // Whether `Decl` was instantiated from a template for a use, rather than written
+    bool isImplicitInstantiation(const clang::Decl* Decl) {
+        if (const auto* Record = llvm::dyn_cast<clang::CXXRecordDecl>(Decl)) {
+            return Record->getTemplateSpecializationKind() == clang::TSK_ImplicitInstantiation;
+        }
+        if (const auto* Function = llvm::dyn_cast<clang::FunctionDecl>(Decl)) {
+            return Function->getTemplateSpecializationKind() == clang::TSK_ImplicitInstantiation;
+        }
+        if (const auto* Var = llvm::dyn_cast<clang::VarDecl>(Decl)) {
+            return Var->getTemplateSpecializationKind() == clang::TSK_ImplicitInstantiation;
+        }
+        if (const auto* Enum = llvm::dyn_cast<clang::EnumDecl>(Decl)) {
+            return Enum->getTemplateSpecializationKind() == clang::TSK_ImplicitInstantiation;
+        }
+        return false;
+    }
+
+}
+
 // === Visit and Traverse Methods ===
-bool beta::ASTNormalize::TraverseNamespaceDecl(clang::NamespaceDecl *Decl) {
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseNamespaceDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::skipsDecl(clang::Decl *Decl) {
+    // The visitor does not descend into instantiations, but an instantiated
+    // member or specialization listed in a scope would still be visited
+    if constexpr (Language::CPlusPlus) {
+        if (Decl && isImplicitInstantiation(Decl)) {
+            return true;
+        }
+    }
+    // A namespace-scope declaration from another file (namespace, extern "C" block,
+    // class, template...) has nothing of the main file below it. The predicate is the
+    // one IsDeclFromMainFileAndNotLocal applies, so nothing it would keep is pruned.
+    if (Decl && !llvm::isa<clang::TranslationUnitDecl>(Decl)) {
+        const clang::DeclContext* lexicalContext = Decl->getLexicalDeclContext();
+        // getRedeclContext() looks through extern "C" blocks to the enclosing scope
+        if (lexicalContext && lexicalContext->getRedeclContext()->isFileContext() &&
+            !context->ownsLocation(clangContext->getSourceManager(), Decl->getLocation())) {
+            return true;
+        }
+        // Excluded subtrees are never visited, so no node of them is built
+        const armor::ApiFilter* filter = session->getApiFilter();
+        if (filter && filter->excludes(Decl)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseDecl(clang::Decl *Decl) {
+    if (skipsDecl(Decl)) {
+        return true;
+    }
+    // Declarations read as in an earlier parse are copied rather than walked
+    return treeBuilder.BuildTopLevelDecl(Decl, [&]() {
+        return Base::TraverseDecl(Decl);
+    });
+}
+
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseNamespaceDecl(clang::NamespaceDecl *Decl) {
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseNamespaceDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseRecordDecl(clang::RecordDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseRecordDecl(clang::RecordDecl *Decl) {
 
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseRecordDecl(Decl);
+    Base::TraverseRecordDecl(Decl);
 
-    if (!llvm::isa<clang::CXXRecordDecl>(Decl) && treeBuilder.IsDeclFromMainFileAndNotLocal(Decl)) {
+    if ((!Language::CPlusPlus || !llvm::isa<clang::CXXRecordDecl>(Decl)) && treeBuilder.IsDeclFromMainFileAndNotLocal(Decl)) {
         treeBuilder.PopName();
         treeBuilder.PopNode();
     }
@@ -119,237 +465,324 @@ bool beta::ASTNormalize::TraverseRecordDecl(clang::RecordDecl *Decl) {
     return true;
 }
 
-bool beta::ASTNormalize::TraverseCXXRecordDecl(clang::CXXRecordDecl *Decl) {
-    
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseCXXRecordDecl(Decl);
-    if(treeBuilder.IsDeclFromMainFileAndNotLocal(Decl) && !Decl->isClass() 
-    && !Decl->isTemplated() && !llvm::isa<clang::ClassTemplateSpecializationDecl>(Decl)){
-        treeBuilder.PopName();
-        treeBuilder.PopNode();
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseCXXRecordDecl(clang::CXXRecordDecl *Decl) {
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseCXXRecordDecl(Decl);
+        if(treeBuilder.IsDeclFromMainFileAndNotLocal(Decl) && !Decl->isClass() 
+        && !Decl->isTemplated() && !llvm::isa<clang::ClassTemplateSpecializationDecl>(Decl)){
+            treeBuilder.PopName();
+            treeBuilder.PopNode();
+        }
     }
 
     return true;
 }
 
-bool beta::ASTNormalize::TraverseCXXConstructorDecl(clang::CXXConstructorDecl *Decl) {
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseCXXConstructorDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseCXXConstructorDecl(clang::CXXConstructorDecl *Decl) {
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseCXXConstructorDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseCXXMethodDecl(clang::CXXMethodDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseCXXMethodDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseCXXMethodDecl(clang::CXXMethodDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseCXXMethodDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseClassTemplateDecl(clang::ClassTemplateDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseClassTemplateDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseClassTemplateDecl(clang::ClassTemplateDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseClassTemplateDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseClassTemplateSpecializationDecl(clang::ClassTemplateSpecializationDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseClassTemplateSpecializationDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseClassTemplateSpecializationDecl(clang::ClassTemplateSpecializationDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseClassTemplateSpecializationDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseClassTemplatePartialSpecializationDecl(clang::ClassTemplatePartialSpecializationDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseClassTemplatePartialSpecializationDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseClassTemplatePartialSpecializationDecl(clang::ClassTemplatePartialSpecializationDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseClassTemplatePartialSpecializationDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseFunctionTemplateDecl(clang::FunctionTemplateDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseFunctionTemplateDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseFunctionTemplateDecl(clang::FunctionTemplateDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseFunctionTemplateDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseEnumDecl(clang::EnumDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseEnumDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseEnumDecl(clang::EnumDecl *Decl){
+    Base::TraverseEnumDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::TraverseFunctionDecl(clang::FunctionDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseFunctionDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseFunctionDecl(clang::FunctionDecl *Decl){
+    Base::TraverseFunctionDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::TraverseTypeAliasDecl(clang::TypeAliasDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseTypeAliasDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseTypeAliasDecl(clang::TypeAliasDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseTypeAliasDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseVarDecl(clang::VarDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseVarDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseVarDecl(clang::VarDecl *Decl){
+    Base::TraverseVarDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::TraverseFieldDecl(clang::FieldDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseFieldDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseFieldDecl(clang::FieldDecl *Decl){
+    Base::TraverseFieldDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::TraverseTypedefDecl(clang::TypedefDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseTypedefDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseTypedefDecl(clang::TypedefDecl *Decl){
+    Base::TraverseTypedefDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::TraverseUsingDecl(clang::UsingDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseUsingDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseUsingDecl(clang::UsingDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseUsingDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseUsingDirectiveDecl(clang::UsingDirectiveDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseUsingDirectiveDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseUsingDirectiveDecl(clang::UsingDirectiveDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseUsingDirectiveDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseNamespaceAliasDecl(clang::NamespaceAliasDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseNamespaceAliasDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseNamespaceAliasDecl(clang::NamespaceAliasDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseNamespaceAliasDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseStaticAssertDecl(clang::StaticAssertDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseStaticAssertDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseStaticAssertDecl(clang::StaticAssertDecl *Decl){
+    Base::TraverseStaticAssertDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::TraverseVarTemplateDecl(clang::VarTemplateDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseVarTemplateDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseVarTemplateDecl(clang::VarTemplateDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseVarTemplateDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseVarTemplateSpecializationDecl(clang::VarTemplateSpecializationDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseVarTemplateSpecializationDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseVarTemplateSpecializationDecl(clang::VarTemplateSpecializationDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseVarTemplateSpecializationDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseVarTemplatePartialSpecializationDecl(clang::VarTemplatePartialSpecializationDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseVarTemplatePartialSpecializationDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseVarTemplatePartialSpecializationDecl(clang::VarTemplatePartialSpecializationDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseVarTemplatePartialSpecializationDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseTypeAliasTemplateDecl(clang::TypeAliasTemplateDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseTypeAliasTemplateDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseTypeAliasTemplateDecl(clang::TypeAliasTemplateDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseTypeAliasTemplateDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseCXXDeductionGuideDecl(clang::CXXDeductionGuideDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseCXXDeductionGuideDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseCXXDeductionGuideDecl(clang::CXXDeductionGuideDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseCXXDeductionGuideDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseTemplateTypeParmDecl(clang::TemplateTypeParmDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseTemplateTypeParmDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseTemplateTypeParmDecl(clang::TemplateTypeParmDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseTemplateTypeParmDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseNonTypeTemplateParmDecl(clang::NonTypeTemplateParmDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseNonTypeTemplateParmDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseNonTypeTemplateParmDecl(clang::NonTypeTemplateParmDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseNonTypeTemplateParmDecl(Decl);
+    }
     return true;
 }
 
-bool beta::ASTNormalize::TraverseTemplateTemplateParmDecl(clang::TemplateTemplateParmDecl *Decl){
-    RecursiveASTVisitor<beta::ASTNormalize>::TraverseTemplateTemplateParmDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseTemplateTemplateParmDecl(clang::TemplateTemplateParmDecl *Decl){
+    if constexpr (Language::CPlusPlus) {
+        Base::TraverseTemplateTemplateParmDecl(Decl);
+    }
     return true;
 }
 
-// bool beta::ASTNormalize::TraverseCompoundStmt(clang::CompoundStmt *Stmt) {
-//     RecursiveASTVisitor<beta::ASTNormalize>::TraverseCompoundStmt(Stmt);
+// template <typename Language>
+bool beta::ASTNormalize<Language>::TraverseCompoundStmt(clang::CompoundStmt *Stmt) {
+//     Base::TraverseCompoundStmt(Stmt);
 //     return true;
 // }
 
-bool beta::ASTNormalize::VisitNamespaceDecl(clang::NamespaceDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitNamespaceDecl(clang::NamespaceDecl *Decl) {
     treeBuilder.BuildNamespaceDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitRecordDecl(clang::RecordDecl *Decl) {
-    return treeBuilder.BuildRecordNode(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitRecordDecl(clang::RecordDecl *Decl) {
+    return treeBuilder.BuildRecordNode<Language>(Decl);
 }
 
-bool beta::ASTNormalize::VisitCXXRecordDecl(clang::CXXRecordDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitCXXRecordDecl(clang::CXXRecordDecl *Decl) {
     return treeBuilder.BuildCXXRecordNode(Decl);
 }
 
-bool beta::ASTNormalize::VisitEnumDecl(clang::EnumDecl *Decl) {
-    return treeBuilder.BuildEnumNode(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitEnumDecl(clang::EnumDecl *Decl) {
+    return treeBuilder.BuildEnumNode<Language>(Decl);
 }
 
-bool beta::ASTNormalize::VisitFunctionDecl(clang::FunctionDecl *Decl) {
-    return treeBuilder.BuildFunctionNode(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitFunctionDecl(clang::FunctionDecl *Decl) {
+    return treeBuilder.BuildFunctionNode<Language>(Decl);
 }
 
-bool beta::ASTNormalize::VisitTypeAliasDecl(clang::TypeAliasDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitTypeAliasDecl(clang::TypeAliasDecl *Decl) {
     treeBuilder.BuildTypeAliasDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitTypedefDecl(clang::TypedefDecl *Decl) {
-    return treeBuilder.BuildTypedefDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitTypedefDecl(clang::TypedefDecl *Decl) {
+    return treeBuilder.BuildTypedefDecl<Language>(Decl);
 }
 
-bool beta::ASTNormalize::VisitVarDecl(clang::VarDecl *Decl) {
-    return treeBuilder.BuildVarDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitVarDecl(clang::VarDecl *Decl) {
+    return treeBuilder.BuildVarDecl<Language>(Decl);
 }
 
-bool beta::ASTNormalize::VisitFieldDecl(clang::FieldDecl *Decl) {
-    return treeBuilder.BuildFieldDecl(Decl);
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitFieldDecl(clang::FieldDecl *Decl) {
+    return treeBuilder.BuildFieldDecl<Language>(Decl);
 }
 
-bool beta::ASTNormalize::VisitFunctionTemplateDecl(clang::FunctionTemplateDecl *Decl){
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitFunctionTemplateDecl(clang::FunctionTemplateDecl *Decl){
     treeBuilder.BuildFunctionTemplateDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitClassTemplateDecl(clang::ClassTemplateDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitClassTemplateDecl(clang::ClassTemplateDecl *Decl) {
     treeBuilder.BuildClassTemplateDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitClassTemplateSpecializationDecl(clang::ClassTemplateSpecializationDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitClassTemplateSpecializationDecl(clang::ClassTemplateSpecializationDecl *Decl) {
     treeBuilder.BuildClassTemplateSpecializationDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitClassTemplatePartialSpecializationDecl(clang::ClassTemplatePartialSpecializationDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitClassTemplatePartialSpecializationDecl(clang::ClassTemplatePartialSpecializationDecl *Decl) {
     treeBuilder.BuildClassTemplatePartialSpecializationDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitUsingDecl(clang::UsingDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitUsingDecl(clang::UsingDecl *Decl) {
     treeBuilder.BuildUsingDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitUsingDirectiveDecl(clang::UsingDirectiveDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitUsingDirectiveDecl(clang::UsingDirectiveDecl *Decl) {
     treeBuilder.BuildUsingDirectiveDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitNamespaceAliasDecl(clang::NamespaceAliasDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitNamespaceAliasDecl(clang::NamespaceAliasDecl *Decl) {
     treeBuilder.BuildNamespaceAliasDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitStaticAssertDecl(clang::StaticAssertDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitStaticAssertDecl(clang::StaticAssertDecl *Decl) {
     treeBuilder.BuildStaticAssertDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitVarTemplateDecl(clang::VarTemplateDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitVarTemplateDecl(clang::VarTemplateDecl *Decl) {
     treeBuilder.BuildVarTemplateDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitVarTemplateSpecializationDecl(clang::VarTemplateSpecializationDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitVarTemplateSpecializationDecl(clang::VarTemplateSpecializationDecl *Decl) {
     treeBuilder.BuildVarTemplateSpecializationDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitVarTemplatePartialSpecializationDecl(clang::VarTemplatePartialSpecializationDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitVarTemplatePartialSpecializationDecl(clang::VarTemplatePartialSpecializationDecl *Decl) {
     treeBuilder.BuildVarTemplatePartialSpecializationDecl(Decl);
     return true;
 }
 
-bool beta::ASTNormalize::VisitTypeAliasTemplateDecl(clang::TypeAliasTemplateDecl *Decl) {
+template <typename Language>
+bool beta::ASTNormalize<Language>::VisitTypeAliasTemplateDecl(clang::TypeAliasTemplateDecl *Decl) {
     treeBuilder.BuildTypeAliasTemplateDecl(Decl);
     return true;
 }
+
+template class beta::ASTNormalize<beta::CLanguage>;
+template class beta::ASTNormalize<beta::CxxLanguage>;
@@ -0,0 +1,145 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include "decl_subtree_cache.hpp"
+#include "ast_normalized_context.hpp"
+
+#include "llvm/ADT/DenseMap.h"
+
+namespace {
+
+    /**
+     * Copies `node` and the nodes below it through the target's `create`,
+     * `addChild` and `intern`, moving their lines by `lineShift` and noting
+     * every copy in `copies`, through which the scopes of the copies are set.
+     */
+    template <typename Create, typename AddChild, typename Intern>
+    beta::APINode* copySubtree(const beta::APINode& node, Create& create, AddChild& addChild, Intern& intern,
+                               long lineShift, llvm::DenseMap<const beta::APINode*, beta::APINode*>& copies) {
+        beta::APINode* copy = create();
+        copy->kind = node.kind;
+        auto scope = copies.find(node.scope);
+        if (scope != copies.end()) {
+            copy->scope = scope->second;
+            copy->name = intern(node.name);
+        } else {
+            // Named under a node outside the subtree
+            copy->name = node.scope ? intern(node.getQualifiedName()) : intern(node.name);
+        }
+        copy->dataType = intern(node.dataType);
+        copy->caonicalType = intern(node.caonicalType);
+        copy->layout = intern(node.layout);
+        copy->isInclined = node.isInclined;
+        copy->isConstExpr = node.isConstExpr;
+        copy->access = node.access;
+        copy->storage = node.storage;
+        copy->virtualQualifier = node.virtualQualifier;
+        copy->USR = intern(node.USR);
+        copy->NSR = intern(node.NSR);
+        copy->stmtHashes = node.stmtHashes;
+        // Recomputed once the context is complete, as records can still be reopened
+        copy->fingerprint = 0;
+        copy->subtreeStmtHashes = HashMultiset::Fingerprint();
+        copy->beginLine = node.beginLine == 0 ? 0 : static_cast<unsigned>(node.beginLine + lineShift);
+        copy->endLine = node.endLine == 0 ? 0 : static_cast<unsigned>(node.endLine + lineShift);
+        copies[&node] = copy;
+        for (const beta::APINode* child : node.children) {
+            addChild(*copy, copySubtree(*child, create, addChild, intern, lineShift, copies));
+        }
+        return copy;
+    }
+
+}
+
+beta::DeclSubtreeCache& beta::DeclSubtreeCache::getInstance() {
+    static DeclSubtreeCache instance;
+    return instance;
+}
+
+std::shared_ptr<const beta::DeclSubtreeCache::Entry> beta::DeclSubtreeCache::find(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    return it->second;
+}
+
+void beta::DeclSubtreeCache::store(const Key& key, std::shared_ptr<const Entry> entry) {
+    if (!entry || entry->nodeCount > maxNodes) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        nodes -= it->second->nodeCount;
+        entries.erase(it);
+    }
+    // Entries of declarations since edited away are never looked up again
+    if (nodes + entry->nodeCount > maxNodes) {
+        entries.clear();
+        nodes = 0;
+    }
+    nodes += entry->nodeCount;
+    entries[key] = std::move(entry);
+}
+
+void beta::DeclSubtreeCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    nodes = 0;
+    hits = 0;
+    misses = 0;
+}
+
+std::shared_ptr<beta::DeclSubtreeCache::Entry>
+beta::DeclSubtreeCache::record(const APINode* root, const std::vector<std::pair<llvm::StringRef, APINode*>>& usrs) {
+    auto entry = std::make_shared<Entry>();
+    llvm::DenseMap<const APINode*, APINode*> copies;
+    if (root) {
+        auto create = [&]() { return entry->arena.create(); };
+        auto addChild = [&](APINode& parent, APINode* child) { entry->arena.addChild(parent, child); };
+        auto intern = [&](llvm::StringRef value) { return entry->arena.intern(value); };
+        entry->root = copySubtree(*root, create, addChild, intern, 0, copies);
+    }
+    for (const auto& [usr, node] : usrs) {
+        auto copy = copies.find(node);
+        if (copy == copies.end()) {
+            // A node outside the subtree; the entry would not be self-contained
+            return nullptr;
+        }
+        entry->usrs.emplace_back(entry->arena.intern(usr), copy->second);
+    }
+    entry->nodeCount = copies.size();
+    return entry;
+}
+
+void beta::DeclSubtreeCache::replay(const Entry& entry, unsigned beginLine, ASTNormalizedContext& context) {
+    llvm::DenseMap<const APINode*, APINode*> copies;
+    llvm::ArrayRef<const APINode*> roots = entry.root ? llvm::ArrayRef<const APINode*>(entry.root)
+                                                      : llvm::ArrayRef<const APINode*>();
+    long lineShift = static_cast<long>(beginLine) - static_cast<long>(entry.beginLine);
+    transplant(roots, entry.usrs, entry.unhandledHashes, lineShift, context, copies);
+}
+
+void beta::DeclSubtreeCache::transplant(llvm::ArrayRef<const APINode*> roots,
+                                        const std::vector<std::pair<llvm::StringRef, APINode*>>& usrs,
+                                        llvm::ArrayRef<uint64_t> unhandledHashes, long lineShift,
+                                        ASTNormalizedContext& context,
+                                        llvm::DenseMap<const APINode*, APINode*>& copies) {
+    auto create = [&]() { return context.createNode(); };
+    auto addChild = [&](APINode& parent, APINode* child) { context.addChild(parent, child); };
+    auto intern = [&](llvm::StringRef value) { return context.intern(value); };
+    for (const APINode* root : roots) {
+        APINode* copy = copySubtree(*root, create, addChild, intern, lineShift, copies);
+        context.addRootNode(copy);
+        context.addNode(copy->NSR, copy);
+    }
+    for (const auto& [usr, node] : usrs) {
+        context.usrNodeMap.insert_or_assign(usr, copies[node]);
+    }
+    for (uint64_t hash : unhandledHashes) {
+        context.getSourceRangeTracker().addUnhandledDeclHash(hash);
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <utility>
+
+#include "llvm/ADT/SmallVector.h"
+
+#include "diff_entry.hpp"
+#include "diff_utils.hpp"
+#include "node.hpp"
+#include "subtree_summary.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+    // An array of `size` elements' capacity, so filling it allocates once
+    json reservedArray(size_t size) {
+        json array = json::array();
+        array.get_ref<json::array_t&>().reserve(size);
+        return array;
+    }
+
+    // Summarizes the subtree of `root` into `json_node` if it declares more
+    // than SUMMARIZED_SUBTREE_SIZE nodes; counting them costs little beside
+    // serializing them
+    bool summarize(const beta::APINode& root, json& json_node) {
+        SubtreeSummary summary;
+        llvm::SmallVector<const beta::APINode*, 32> pending(root.children.begin(), root.children.end());
+        while (!pending.empty()) {
+            const beta::APINode* node = pending.pop_back_val();
+            summary.count(node->kind);
+            pending.append(node->children.begin(), node->children.end());
+        }
+        if (summary.size() <= SUMMARIZED_SUBTREE_SIZE) {
+            return false;
+        }
+        for (size_t i = 0; i < root.children.size() && i < SUMMARY_LISTED_NAMES; ++i) {
+            summary.name(root.children[i]->getQualifiedName());
+        }
+
+        std::string qualifiedName = root.getQualifiedName();
+        if (!qualifiedName.empty()) json_node[QUALIFIED_NAME] = std::move(qualifiedName);
+        json_node[NODE_TYPE] = serialize(root.kind);
+        if (!root.dataType.empty()) json_node[DATA_TYPE] = root.dataType.str();
+        json_node[SUMMARY] = summary.toJson();
+        return true;
+    }
+
+    /*
+        Serializes the subtree of `root`, or its summary when it is large. Each children array is sized to its
+        node's children up front and filled in place from an explicit stack,
+        so deep nesting costs no call stack and no JSON is copied.
+    */
+    json nodeToJson(const beta::APINode& root) {
+        json result;
+        if (!isSubtreeExpansionEnabled() && summarize(root, result)) {
+            return result;
+        }
+        llvm::SmallVector<std::pair<const beta::APINode*, json*>, 32> pending{{&root, &result}};
+        while (!pending.empty()) {
+            auto [node, json_node] = pending.pop_back_val();
+
+            std::string qualifiedName = node->getQualifiedName();
+            if (!qualifiedName.empty()) (*json_node)[QUALIFIED_NAME] = std::move(qualifiedName);
+            (*json_node)[NODE_TYPE] = serialize(node->kind);
+            if (!node->dataType.empty()) (*json_node)[DATA_TYPE] = node->dataType.str();
+
+            if (!node->children.empty()) {
+                json& children = (*json_node)[CHILDREN] = reservedArray(node->children.size());
+                for (const auto& childNode : node->children) {
+                    pending.emplace_back(childNode, &children.emplace_back());
+                }
+            }
+        }
+        return result;
+    }
+
+    // Only the changed fields that are set on this side of the pair are listed
+    json fieldsToJson(const beta::DiffEntry& entry) {
+        const beta::APINode& values = *entry.node;
+        json fields;
+        if (entry.fields & beta::DIFF_FIELD_DATA_TYPE) {
+            // Function pointers compare as written, everything else by canonical type
+            fields[DATA_TYPE] = serialize(entry.owner->kind == NodeKind::FunctionPointer ? values.dataType
+                                                                                          : values.caonicalType);
+        }
+        if (entry.fields & beta::DIFF_FIELD_STORAGE) fields[STORAGE_QUALIFIER] = serialize(values.storage);
+        if (entry.fields & beta::DIFF_FIELD_VIRTUAL) fields[VIRTUAL_QUALIFIER] = serialize(values.virtualQualifier);
+        if (entry.fields & beta::DIFF_FIELD_INLINE) fields[INLINE] = serialize(values.isInclined);
+        if (entry.fields & beta::DIFF_FIELD_CONSTEXPR) fields[CONST_EXPR] = serialize(values.isConstExpr);
+        if (entry.fields & beta::DIFF_FIELD_LAYOUT) fields[LAYOUT] = serialize(values.layout);
+        fields[NODE_TYPE] = serialize(entry.owner->kind);
+        fields[QUALIFIED_NAME] = entry.owner->getQualifiedName();
+        return fields;
+    }
+
+}
+
+json beta::DiffEntry::toJson() const {
+    json result;
+    // Entries still to serialize, each into its slot of the children array reserved by its parent
+    llvm::SmallVector<std::pair<const DiffEntry*, json*>, 32> pending{{this, &result}};
+    while (!pending.empty()) {
+        auto [entry, out] = pending.pop_back_val();
+        switch (entry->tag) {
+            case DiffTag::Added:
+            case DiffTag::Removed:
+                *out = entry->fields != 0 ? fieldsToJson(*entry) : nodeToJson(*entry->node);
+                (*out)[TAG] = entry->tag == DiffTag::Added ? ADDED : REMOVED;
+                break;
+            case DiffTag::Modified:
+                (*out)[QUALIFIED_NAME] = entry->node->getQualifiedName();
+                (*out)[NODE_TYPE] = serialize(entry->node->kind);
+                (*out)[TAG] = MODIFIED;
+                {
+                    json& childEntries = (*out)[CHILDREN] = reservedArray(entry->children.size());
+                    for (const DiffEntry& child : entry->children) {
+                        pending.emplace_back(&child, &childEntries.emplace_back());
+                    }
+                }
+                break;
+            case DiffTag::Moved:
+                // Only the names: the subtree is the same on both sides
+                (*out)[QUALIFIED_NAME] = entry->node->getQualifiedName();
+                (*out)[OLD_QUALIFIED_NAME] = entry->owner->getQualifiedName();
+                (*out)[NODE_TYPE] = serialize(entry->node->kind);
+                (*out)[TAG] = MOVED;
+                break;
+            case DiffTag::Reordered:
+                (*out)[QUALIFIED_NAME] = entry->node->getQualifiedName();
+                (*out)[NODE_TYPE] = serialize(entry->node->kind);
+                (*out)[OLD_INDEX] = entry->oldIndex;
+                (*out)[NEW_INDEX] = entry->newIndex;
+                (*out)[TAG] = REORDERED;
+                break;
+        }
+    }
+    return result;
+}
@@ -1,31 +1,46 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <string>
 #include <llvm-14/llvm/ADT/StringRef.h>
 #include <llvm-14/llvm/Support/raw_ostream.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/MapVector.h>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "ast_normalized_context.hpp"
+#include "diff_entry.hpp"
 #include "diffengine.hpp"
 #include "diff_utils.hpp"
 #include "logger.hpp"
+#include "profiler.hpp"
+#include "work_pool.hpp"
 #include "node.hpp"
 #include "comm_def.hpp"
 
 using json = nlohmann::json;
 
-const bool inline hasChildren(const std::shared_ptr<const beta::APINode>& node) {
-    return node->children == nullptr ? false : !node->children->empty();
+const bool inline hasChildren(const beta::APINode& node) {
+    return !node.children.empty();
 }
 
 namespace{
 
     #ifdef TESTING_ENABLED
-        void printDenseMap(const llvm::DenseMap<uint64_t, int>& map, const std::string_view& mapName) {
+        void printDenseMap(const HashMultiset& map, const std::string_view& mapName) {
             TEST_LOG << mapName << "\n";
             if (map.empty()) {
                 TEST_LOG << "(empty)" << "\n";
@@ -38,62 +53,138 @@ namespace{
         }
     #endif
 
-    const json toJson(const std::shared_ptr<const beta::APINode>& node) {
-    
-        json json_node;
-
-        if(!node->qualifiedName.empty()) json_node[QUALIFIED_NAME] = node->qualifiedName;
-        json_node[NODE_TYPE] = serialize(node->kind);
+    // The statement hashes of an added subtree, which the newer version's
+    // unhandled declaration hashes still count; summed rather than erased
+    // in place so roots can be diffed concurrently, and precomputed per
+    // subtree by computeFingerprint so an added subtree costs one addition
+    void collectAddedHashes(const beta::APINode& node, HashMultiset::Fingerprint& addedHashes) {
+        addedHashes += node.subtreeStmtHashes;
+    }
 
-        if(hasChildren(node)) {
-            json_node[CHILDREN] = json::array();
-            for (const auto& childNode : *node->children) {
-                json_node[CHILDREN].emplace_back(toJson(childNode));
+    // Serializes the entries of one root to the sink, until it asks to stop;
+    // entries are typed up to here so only what is reported is ever turned into JSON
+    bool emitDiff(const StoppableDiffEntrySink& onEntry, std::vector<beta::DiffEntry>& entries, bool& stopped) {
+        if (entries.empty()) {
+            return false;
+        }
+        for (const beta::DiffEntry& entry : entries) {
+            if (!onEntry(entry.toJson())) {
+                stopped = true;
+                break;
             }
         }
+        entries.clear();
+        return true;
+    }
 
-        if(!node->dataType.empty()) json_node[DATA_TYPE] = node->dataType;
+    std::atomic<bool> macroDiffEnabled{false};
 
-        return json_node;
+    json macroEntry(const MacroTable::Change& change) {
+        json entry;
+        entry[QUALIFIED_NAME] = change.name;
+        entry[NODE_TYPE] = serialize(NodeKind::Macro);
+        entry[TAG] = change.kind == MacroTable::ChangeKind::Added     ? ADDED
+                     : change.kind == MacroTable::ChangeKind::Removed ? REMOVED
+                                                                      : MODIFIED;
+        return entry;
     }
 
-    const json get_json_from_node(const std::shared_ptr<const beta::APINode> node, const std::string& tag) {
-        json json_node = toJson(node);
-        json_node[TAG] = tag;
-        return json_node;
-    }
+    std::atomic<unsigned> typeChangeMinUsers{0};
 
-    void reconcileUnhandledDeclHashes(beta::ASTNormalizedContext* context, const std::shared_ptr<const beta::APINode>& node){
-        beta::SourceRangeTracker& tracker = context->getSourceRangeTracker();
-        llvm::DenseMap<uint64_t, int>& unhandledDeclsHashMap = tracker.getUnhandledDeclsHashMap();
-        if(node->stmtHashes.size()) TEST_LOG << "reconcileUnhandledDeclHashes\n" << node->qualifiedName << "\n";
-        for(uint64_t stmtHash : node->stmtHashes ){
-            auto it = unhandledDeclsHashMap.find(stmtHash);
-            if (it != unhandledDeclsHashMap.end()) {
-                it->second--;
-                if (it->second <= 0) unhandledDeclsHashMap.erase(it);
-                TEST_LOG << stmtHash << "\n----------------------------------------\n";
-            }
-        }
-        if(hasChildren(node)) {
-            for (const auto& childNode : *node->children) {
-                reconcileUnhandledDeclHashes(context, childNode);
+    /*
+        Takes the data type changes a replaced type name accounts for out of
+        the entries of each root, and gathers the declarations they were of by
+        that name, see setTypeChangeCollapsing. Runs on the calling thread, so
+        the gathered declarations keep root order.
+    */
+    class TypeChangeCollapser {
+        public:
+            TypeChangeCollapser(const TypeUsageIndex& older, const TypeUsageIndex& newer, unsigned minUsers)
+                : older(older), newer(newer), minUsers(minUsers) {}
+
+            void collapse(std::vector<beta::DiffEntry>& entries) {
+                for (beta::DiffEntry& entry : entries) {
+                    if (entry.tag == beta::DiffTag::Modified) {
+                        collapse(entry.children);
+                    }
+                }
+                // APINode::diff lists the old values as Removed and the new ones
+                // as Added, both owned by the older node
+                for (beta::DiffEntry& added : entries) {
+                    if (added.tag != beta::DiffTag::Added || !(added.fields & beta::DIFF_FIELD_DATA_TYPE)) {
+                        continue;
+                    }
+                    const beta::APINode& before = *added.owner;
+                    llvm::StringRef oldName;
+                    llvm::StringRef newName;
+                    if (!TypeUsageIndex::replacedName(before.dataType, added.node->dataType, oldName, newName) ||
+                        older.users(oldName) < minUsers || newer.users(oldName) != 0) {
+                        continue;
+                    }
+                    for (beta::DiffEntry& entry : entries) {
+                        if (entry.fields != 0 && entry.owner == &before) {
+                            dropDataType(entry);
+                        }
+                    }
+                    replaced[{oldName, newName}].push_back(before.getQualifiedName() + ":" + serialize(before.kind));
+                }
+                entries.erase(std::remove_if(entries.begin(), entries.end(), [](const beta::DiffEntry& entry) {
+                    return entry.node == nullptr ||
+                           (entry.tag == beta::DiffTag::Modified && entry.children.empty());
+                }), entries.end());
             }
-        }
-    }
 
-    bool hasHashMapDifference(const llvm::DenseMap<uint64_t, int>& map1, 
-                              const llvm::DenseMap<uint64_t, int>& map2) {
-        for (const auto& [x,y] : map1) {
-            auto itr = map2.find(x);
-            if ( itr == map2.end()) {
+            // One entry per replaced name, in the order the names were first met
+            template <typename Emit>
+            bool emit(Emit&& onEntry) {
+                for (auto& [names, affected] : replaced) {
+                    json entry;
+                    entry[QUALIFIED_NAME] = names.first.str();
+                    entry[NEW_TYPE] = names.second.str();
+                    entry[AFFECTED] = std::move(affected);
+                    entry[TAG] = TYPE_CHANGED;
+                    if (!onEntry(std::move(entry))) {
+                        return false;
+                    }
+                }
                 return true;
             }
-            else{
-                if( itr->second != y ) return true;
+
+            bool empty() const { return replaced.empty(); }
+
+        private:
+            // A field entry left without fields would read as a whole node; it is marked for removal
+            static void dropDataType(beta::DiffEntry& entry) {
+                entry.fields &= static_cast<uint8_t>(~beta::DIFF_FIELD_DATA_TYPE);
+                if (entry.fields == 0) {
+                    entry.node = nullptr;
+                }
             }
+
+            const TypeUsageIndex& older;
+            const TypeUsageIndex& newer;
+            unsigned minUsers;
+            llvm::MapVector<std::pair<llvm::StringRef, llvm::StringRef>, std::vector<std::string>> replaced;
+    };
+
+    // The unhandled declaration hashes less the #define and #undef lines, once
+    // the macros are diffed by name; a copy, as a context may be diffed again
+    HashMultiset withoutMacroDirectives(const beta::SourceRangeTracker& tracker) {
+        HashMultiset unhandledDeclsHashMap = tracker.getUnhandledDeclsHashMap();
+        for (uint64_t hash : tracker.getMacros().getDirectiveHashes()) {
+            unhandledDeclsHashMap.eraseOne(hash);
         }
-        
+        return unhandledDeclsHashMap;
+    }
+
+    // Matching fingerprints are confirmed from the ranges behind the hashes;
+    // two texts sharing a 64-bit hash then count as a change
+    bool confirmedUnchanged(const beta::SourceRangeTracker& tracker1, const beta::SourceRangeTracker& tracker2,
+                            RangeDigests::Category category, const HashMultiset& matched, const char* what) {
+        if (RangeDigests::confirm(tracker1.getRangeDigests(), tracker2.getRangeDigests(), category, matched)) {
+            return true;
+        }
+        ARMOR_DEBUG_LOG << "64-bit hash collision among " << what << "; counted as changed\n";
         return false;
     }
 
@@ -113,283 +204,794 @@ namespace{
 
         return ParsedDiffStatus::NON_FUNCTIONAL_CHANGES ;
     }
-}
 
-json diffNodes(
-    beta::ASTNormalizedContext* contextA,
-    beta::ASTNormalizedContext* contextB,
-    const std::shared_ptr<const beta::APINode>& a, 
-    const std::shared_ptr<const beta::APINode>& b) // we are not using the map for now.
-{
-    
-    // Any node can have children.
-    assert(a->kind == b->kind);
+    // Under --changed-ranges a matched pair is taken as unchanged when neither
+    // side's declarations touch a changed line; additions and removals are
+    // still found by the matching of the enclosing level
+    bool isUntouched(const beta::APINode& a, const beta::APINode& b, const armor::HeaderChanges* changes) {
+        if (changes == nullptr || a.beginLine == 0 || b.beginLine == 0) {
+            return false;
+        }
+        return !armor::HeaderChanges::intersects(changes->oldLines, a.beginLine, a.endLine) &&
+               !armor::HeaderChanges::intersects(changes->newLines, b.beginLine, b.endLine);
+    }
 
-    if (hasChildren(a) && hasChildren(b)) {
-        json childrenDiff = json::array();
+    // Position of the match of a child that has none
+    constexpr uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
 
-        // Create StringMaps for a->children and b->children
-        llvm::StringMap<llvm::SmallVector<std::shared_ptr<const beta::APINode>,16>> aNSRMap;
-        llvm::StringMap<llvm::SmallVector<std::shared_ptr<const beta::APINode>,16>> bNSRMap;
-        llvm::StringMap<std::shared_ptr<const beta::APINode>> aUSRMap;
-        llvm::StringMap<std::shared_ptr<const beta::APINode>> bUSRMap;
-        
-        // Populate maps
-        for (const auto& childNode : *a->children) {
-            aNSRMap[childNode->NSR].emplace_back(std::move(childNode));
-            if (!childNode->USR.empty()) {
-                aUSRMap.try_emplace(childNode->USR,std::move(childNode));
+    // A child with the keys it is matched by, which reference the context's string pool
+    struct KeyedChild {
+        llvm::StringRef nsr;
+        llvm::StringRef usr;
+        // Index of the child among its parent's children
+        uint32_t position;
+    };
+
+    /**
+     * Children of one node, sorted by NSR and then USR. Sorting is stable,
+     * so children with the same keys stay in declaration order.
+     *
+     * The index is a contiguous column of key records, so sorting and
+     * matching only read the keys rather than dereferencing a whole node for
+     * every comparison.
+     */
+    class ChildIndex {
+        public:
+            // Indexes the children of `node` from position `first` on
+            void build(const beta::APINode& node, uint32_t first = 0) {
+                keys.clear();
+                for (uint32_t i = first; i < node.children.size(); ++i) {
+                    keys.push_back({node.children[i]->NSR, node.children[i]->USR, i});
+                }
+                std::stable_sort(keys.begin(), keys.end(), [](const KeyedChild& lhs, const KeyedChild& rhs) {
+                    int order = lhs.nsr.compare(rhs.nsr);
+                    return order != 0 ? order < 0 : lhs.usr < rhs.usr;
+                });
             }
+
+            llvm::ArrayRef<KeyedChild> sorted() const { return keys; }
+
+        private:
+            llvm::SmallVector<KeyedChild, 16> keys;
+    };
+
+    /**
+     * Child indexes reused by every diff run on a thread, see threadScratch().
+     * Each pair on the diffNodes stack owns a level; buffers are cleared,
+     * never freed, and only grow when a level first sees more children than
+     * before.
+     */
+    class DiffScratch {
+        public:
+            struct Level {
+                ChildIndex a;
+                ChildIndex b;
+                // Per child of a, the position of its match in b or NO_MATCH; per child of b, whether it was added
+                llvm::SmallVector<uint32_t, 16> matchOfA;
+                llvm::SmallVector<bool, 16> addedB;
+                // Matched ordered children and their ranks among their kind, see appendReorders
+                llvm::SmallVector<uint32_t, 16> order;
+                llvm::SmallVector<uint32_t, 16> orderedA;
+                llvm::SmallVector<bool, 16> kept;
+                llvm::SmallVector<uint32_t, 16> tails;
+                llvm::SmallVector<uint32_t, 16> previous;
+                llvm::SmallVector<uint32_t, 16> rankA;
+                llvm::SmallVector<uint32_t, 16> rankB;
+            };
+
+            // Claims the pair of the next depth for the lifetime of the guard
+            class LevelGuard {
+                public:
+                    explicit LevelGuard(DiffScratch& scratch) : scratch(scratch) {
+                        if (scratch.depth == scratch.levels.size()) {
+                            scratch.levels.emplace_back();
+                        }
+                        level = &scratch.levels[scratch.depth++];
+                    }
+                    ~LevelGuard() { --scratch.depth; }
+
+                    Level& operator*() const { return *level; }
+                    Level* operator->() const { return level; }
+
+                private:
+                    DiffScratch& scratch;
+                    Level* level;
+            };
+
+            /**
+             * A pair of nodes with children on both sides, whose Modified
+             * entry collects the diffs of its children, walked from `next`.
+             * Once complete the entry goes to `out`, the children of the
+             * frame below or the caller's entries, if it has any.
+             */
+            struct Frame {
+                Frame(const beta::APINode& a, const beta::APINode& b, std::vector<beta::DiffEntry>& out,
+                      DiffScratch& scratch)
+                    : a(a), b(b), out(out), modified(beta::DiffTag::Modified, a), level(scratch) {}
+
+                const beta::APINode& a;
+                const beta::APINode& b;
+                std::vector<beta::DiffEntry>& out;
+                beta::DiffEntry modified;
+                LevelGuard level;
+                size_t next = 0;
+            };
+
+            // The pairs diffNodes is walking the children of, innermost last
+            std::deque<Frame>& frames() { return stack; }
+
+        private:
+            // std::deque keeps the levels and frames below in place while more are added
+            std::deque<Level> levels;
+            size_t depth = 0;
+            std::deque<Frame> stack;
+    };
+
+    // The scratch of the calling thread, kept for its lifetime: a job thread
+    // reuses it for every header pair it compares, and a parallelFor worker
+    // for every root it pulls, rather than each root allocating its own
+    // buffers while the other workers do the same
+    DiffScratch& threadScratch() {
+        thread_local DiffScratch scratch;
+        return scratch;
+    }
+
+    // End of the run of keys from `begin` sharing its NSR
+    size_t nsrRunEnd(llvm::ArrayRef<KeyedChild> keys, size_t begin) {
+        size_t end = begin + 1;
+        while (end < keys.size() && keys[end].nsr == keys[begin].nsr) {
+            ++end;
         }
-        
-        for (const auto& childNode : *b->children) {
-            bNSRMap[childNode->NSR].emplace_back(childNode);
-            if (!childNode->USR.empty()) {
-                bUSRMap.try_emplace(childNode->USR,std::move(childNode));
+        return end;
+    }
+
+    // Matches the children of two runs sharing one NSR by USR, a child of a
+    // to the first child of b with its USR; both runs are sorted by USR
+    void matchRunByUSR(llvm::ArrayRef<KeyedChild> aRun, llvm::ArrayRef<KeyedChild> bRun,
+                       DiffScratch::Level& level) {
+        size_t p = 0;
+        size_t q = 0;
+        while (p < aRun.size() && q < bRun.size()) {
+            assert(!aRun[p].usr.empty() && !bRun[q].usr.empty());
+            if (aRun[p].usr.empty() || aRun[p].usr < bRun[q].usr) {
+                ++p;
+            }
+            else if (bRun[q].usr < aRun[p].usr) {
+                level.addedB[bRun[q].position] = true;
+                ++q;
             }
-        }
-        
-        for (const auto& childNodeA : *a->children) {
-            llvm::StringRef key = childNodeA->NSR;
-            auto it = bNSRMap.find(key);
-            if (it == bNSRMap.end()) {
-                childrenDiff.emplace_back(get_json_from_node(childNodeA, REMOVED));
-            } 
             else {
-                size_t countA = aNSRMap[key].size();
-                size_t countB = bNSRMap[key].size();
-                if (countA + countB > 2) {
-                    assert(!childNodeA->USR.empty());
-                    key = childNodeA->USR;
-                    auto usrIt = bUSRMap.find(key);
-                    if (usrIt != bUSRMap.end()) {
-                        const std::shared_ptr<const beta::APINode> childNodeB = usrIt->second;
-                        json sameScopeDiff = diffNodes(contextA, contextB,childNodeA, childNodeB);
-                        if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()) {
-                            if (sameScopeDiff.is_array()) {
-                                childrenDiff.insert(childrenDiff.end(), sameScopeDiff.begin(), sameScopeDiff.end());
-                            } 
-                            else {
-                                childrenDiff.emplace_back(sameScopeDiff);
-                            }
-                        }
-                    } 
-                    else {
-                        childrenDiff.emplace_back(get_json_from_node(childNodeA, REMOVED));
-                    }
-                } 
-                else {
-                    assert(countA+countB == 2);
-                    const std::shared_ptr<const beta::APINode> childNodeB = it->second[0];
-                    json sameScopeDiff = diffNodes(contextA, contextB,childNodeA, childNodeB);
-                    if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()) {
-                        if (sameScopeDiff.is_array()) {
-                            childrenDiff.insert(childrenDiff.end(), sameScopeDiff.begin(), sameScopeDiff.end());
-                        } 
-                        else {
-                            childrenDiff.emplace_back(sameScopeDiff);
-                        }
-                    }
+                llvm::StringRef usr = bRun[q].usr;
+                uint32_t match = bRun[q].position;
+                for (; p < aRun.size() && aRun[p].usr == usr; ++p) {
+                    level.matchOfA[aRun[p].position] = match;
+                }
+                for (; q < bRun.size() && bRun[q].usr == usr; ++q) {
                 }
             }
         }
-    
-        for (const auto& childNodeB : *b->children) {
+        for (; q < bRun.size(); ++q) {
+            level.addedB[bRun[q].position] = true;
+        }
+    }
 
-            llvm::StringRef key = childNodeB->NSR;
+    /**
+     * Pairs the children of `a` and `b` in one merge-join of their indexes.
+     * A child whose NSR is spelled once on each side is matched by it; in a
+     * longer run of equal NSRs children are matched by USR. Children of a
+     * left without a match were removed.
+     */
+    void matchChildren(const beta::APINode& a, const beta::APINode& b, DiffScratch::Level& level) {
+        level.matchOfA.assign(a.children.size(), NO_MATCH);
+        level.addedB.assign(b.children.size(), false);
 
-            auto it = aNSRMap.find(key);
-            if (aNSRMap.find(childNodeB->NSR) == aNSRMap.end()) {
-                childrenDiff.emplace_back(get_json_from_node(childNodeB, ADDED));
-                reconcileUnhandledDeclHashes(contextB, childNodeB);
+        // The enumerators of an enum have distinct names, so the leading ones
+        // named alike pair by position; only the rest, often a few appended
+        // to thousands, are sorted
+        uint32_t aligned = 0;
+        if (a.kind == NodeKind::Enum) {
+            size_t common = std::min(a.children.size(), b.children.size());
+            while (aligned < common && a.children[aligned]->NSR == b.children[aligned]->NSR) {
+                level.matchOfA[aligned] = aligned;
+                ++aligned;
             }
-            else{
-                size_t count1 = aNSRMap[key].size();
-                size_t count2 = bNSRMap[key].size();
-                if (count1 + count2 > 2) {
-                    assert(!childNodeB->USR.empty());
-                    key = childNodeB->USR;
-                    auto usrIt = aUSRMap.find(key);
-                    if (usrIt == aUSRMap.end()){
-                        childrenDiff.emplace_back(get_json_from_node(childNodeB, ADDED));
-                        reconcileUnhandledDeclHashes(contextB, childNodeB);
-                    }
+        }
+        level.a.build(a, aligned);
+        level.b.build(b, aligned);
+
+        llvm::ArrayRef<KeyedChild> aKeys = level.a.sorted();
+        llvm::ArrayRef<KeyedChild> bKeys = level.b.sorted();
+        size_t i = 0;
+        size_t j = 0;
+        while (i < aKeys.size() || j < bKeys.size()) {
+            int order = i == aKeys.size() ? 1 : j == bKeys.size() ? -1 : aKeys[i].nsr.compare(bKeys[j].nsr);
+            if (order < 0) {
+                i = nsrRunEnd(aKeys, i);
+                continue;
+            }
+            if (order > 0) {
+                size_t end = nsrRunEnd(bKeys, j);
+                for (; j < end; ++j) {
+                    level.addedB[bKeys[j].position] = true;
                 }
-                // No else as we already computed if count1 + count 2 == 2 we do not have to compute it again.
+                continue;
+            }
+            size_t aEnd = nsrRunEnd(aKeys, i);
+            size_t bEnd = nsrRunEnd(bKeys, j);
+            if (aEnd - i == 1 && bEnd - j == 1) {
+                level.matchOfA[aKeys[i].position] = bKeys[j].position;
+            }
+            else {
+                matchRunByUSR(aKeys.slice(i, aEnd - i), bKeys.slice(j, bEnd - j), level);
             }
+            i = aEnd;
+            j = bEnd;
         }
-        
-        json APINodeDiff = a->diff(b);
-        if (!APINodeDiff.empty()) {
-            if (APINodeDiff.is_array()) {
-                childrenDiff.insert(childrenDiff.end(), APINodeDiff.begin(), APINodeDiff.end());
-            } else {
-                childrenDiff.emplace_back(APINodeDiff);
+    }
+
+    // Whether the order of `child` among the children of `parent` is part of
+    // the API: fields are laid out, enumerators numbered and parameters
+    // passed in order. The fields of a union all sit at its start.
+    bool isOrdered(const beta::APINode& parent, const beta::APINode& child) {
+        switch (child.kind) {
+            case NodeKind::Field:
+                return parent.kind != NodeKind::Union;
+            case NodeKind::Enumerator:
+            case NodeKind::Parameter:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Per child of `node`, its position among the children of its kind
+    void rankByKind(const beta::APINode& node, llvm::SmallVectorImpl<uint32_t>& ranks) {
+        std::array<uint32_t, static_cast<size_t>(NodeKind::Unknown) + 1> seen{};
+        ranks.clear();
+        for (const beta::APINode* child : node.children) {
+            ranks.push_back(seen[static_cast<size_t>(child->kind)]++);
+        }
+    }
+
+    /*
+        Appends a Reordered entry for each ordered child of `a` whose match
+        in `b` changed places: the matched children outside one longest run
+        that kept its order, found in O(n log n). A field moved across a
+        thousand others is one entry, and an enum whose enumerators all kept
+        their order costs one pass.
+    */
+    void appendReorders(const beta::APINode& a, const beta::APINode& b, DiffScratch::Level& level,
+                        std::vector<beta::DiffEntry>& out) {
+        level.order.clear();
+        level.orderedA.clear();
+        for (uint32_t i = 0; i < a.children.size(); ++i) {
+            if (level.matchOfA[i] != NO_MATCH && isOrdered(a, *a.children[i])) {
+                level.order.push_back(level.matchOfA[i]);
+                level.orderedA.push_back(i);
             }
         }
-        
+        if (std::is_sorted(level.order.begin(), level.order.end())) {
+            return;
+        }
+        markLongestNonDecreasing(level.order, level.kept, level.tails, level.previous);
+        rankByKind(a, level.rankA);
+        rankByKind(b, level.rankB);
+        for (size_t k = 0; k < level.order.size(); ++k) {
+            if (!level.kept[k]) {
+                uint32_t i = level.orderedA[k];
+                uint32_t j = level.order[k];
+                out.emplace_back(*b.children[j], *a.children[i], level.rankA[i], level.rankB[j]);
+            }
+        }
+    }
+}
+
+namespace {
+
+    /*
+        Diffs `a` and `b` into `out` if they have no children on one side;
+        a pair with children on both is pushed on the stack to be walked.
+    */
+    void enterPair(const beta::APINode& a,
+                   const beta::APINode& b,
+                   DiffScratch& scratch,
+                   const armor::HeaderChanges* changes,
+                   std::vector<beta::DiffEntry>& out,
+                   HashMultiset::Fingerprint& addedHashes)
+    {
+        // Any node can have children.
+        assert(a.kind == b.kind);
+
+        // Identical subtrees have no diff, and contain no added node whose
+        // unhandled hashes would need reconciling
+        if (a.fingerprint != 0 && a.fingerprint == b.fingerprint) {
+            return;
+        }
+        if (isUntouched(a, b, changes)) {
+            return;
+        }
+
+        if (!hasChildren(a) && !hasChildren(b)) {
+            a.diff(b, out);
+            return;
+        }
+
+        if (hasChildren(a) && hasChildren(b)) {
+            DiffScratch::Frame& frame = scratch.frames().emplace_back(a, b, out, scratch);
+            matchChildren(a, b, *frame.level);
+            return;
+        }
+
+        beta::DiffEntry modified(beta::DiffTag::Modified, a);
+        if (hasChildren(a)) {
+            for (const auto& removedNode : a.children) {
+                modified.children.emplace_back(beta::DiffTag::Removed, *removedNode);
+            }
+        }
+        else {
+            for (const auto& addedNode : b.children) {
+                modified.children.emplace_back(beta::DiffTag::Added, *addedNode);
+                collectAddedHashes(*addedNode, addedHashes);
+            }
+        }
+        out.push_back(std::move(modified));
+    }
+
+}
+
+/*
+    Only reads the two trees: the statement hashes of added nodes go to
+    `addedHashes`, for the caller to reconcile with the newer context.
+
+    Walks the trees with an explicit stack of frames, so the depth of
+    nesting costs no call stack; each entry is built once in the children
+    of the entry it belongs to.
+*/
+void diffNodes(
+    const beta::APINode& a, 
+    const beta::APINode& b,
+    DiffScratch& scratch,
+    const armor::HeaderChanges* changes,
+    std::vector<beta::DiffEntry>& out,
+    HashMultiset::Fingerprint& addedHashes)
+{
+    std::deque<DiffScratch::Frame>& frames = scratch.frames();
+    const size_t bottom = frames.size();
+    enterPair(a, b, scratch, changes, out, addedHashes);
+
+    while (frames.size() > bottom) {
+        DiffScratch::Frame& frame = frames.back();
+        const DiffScratch::Level& level = *frame.level;
+        std::vector<beta::DiffEntry>& childrenDiff = frame.modified.children;
+
+        // Reported in declaration order, removals and matches before additions;
+        // a matched child with children of its own is walked before the next
+        bool entered = false;
+        while (frame.next < frame.a.children.size() && !entered) {
+            size_t i = frame.next++;
+            if (uint32_t match = level.matchOfA[i]; match != NO_MATCH) {
+                size_t depth = frames.size();
+                enterPair(*frame.a.children[i], *frame.b.children[match], scratch, changes, childrenDiff,
+                          addedHashes);
+                entered = frames.size() != depth;
+            }
+            else {
+                childrenDiff.emplace_back(beta::DiffTag::Removed, *frame.a.children[i]);
+            }
+        }
+        if (entered) {
+            continue;
+        }
+
+        for (size_t j = 0; j < frame.b.children.size(); ++j) {
+            if (level.addedB[j]) {
+                childrenDiff.emplace_back(beta::DiffTag::Added, *frame.b.children[j]);
+                collectAddedHashes(*frame.b.children[j], addedHashes);
+            }
+        }
+        appendReorders(frame.a, frame.b, *frame.level, childrenDiff);
+
+        frame.a.diff(frame.b, childrenDiff);
+
         if (!childrenDiff.empty()) {
-            json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
-            diff[NODE_TYPE] = serialize(a->kind);
-            if (!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
-            diff[TAG] = MODIFIED;
-            return json::array().emplace_back(diff);
+            frame.out.push_back(std::move(frame.modified));
         }
+        frames.pop_back();
     }
-    else if(hasChildren(a)){
+}
+
 
-        json childrenDiff = json::array();
+namespace {
 
-        for (const auto& removedNode : *a->children) {
-            childrenDiff.emplace_back(get_json_from_node(removedNode, REMOVED));
+    // Matched roots diffed per worker in one window, see streamDiffTreesUntil
+    constexpr size_t ROOTS_PER_JOB = 4;
+
+    struct RootDiff {
+        std::vector<beta::DiffEntry> entries;
+        HashMultiset::Fingerprint addedHashes;
+    };
+
+    // The root of `context2` that `root1` is diffed against; nullptr if it was removed
+    const beta::APINode* matchRoot(const beta::ASTNormalizedContext* context1,
+                                   const beta::ASTNormalizedContext* context2,
+                                   const beta::APINode& root1) {
+        llvm::ArrayRef<beta::APINode*> matches2 = context2->findNodes(root1.NSR);
+        if (matches2.empty()) {
+            return nullptr;
         }
+        size_t count1 = context1->countNodes(root1.NSR);
+        size_t count2 = matches2.size();
+        if (count1 + count2 > 2) {
+            assert(!root1.USR.empty());
+            return context2->findNodeByUSR(root1.USR);
+        }
+        assert(count1+count2 == 2);
+        return matches2[0];
+    }
 
-        if(!childrenDiff.empty()){
-            json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
-            diff[NODE_TYPE] = serialize(a->kind);
-            if(!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
-            diff[TAG] = MODIFIED;
-            return json::array().emplace_back(diff);
+    // Whether `root2` has no counterpart among the roots of `context1`
+    bool isAddedRoot(const beta::ASTNormalizedContext* context1,
+                     const beta::ASTNormalizedContext* context2,
+                     const beta::APINode& root2) {
+        llvm::ArrayRef<beta::APINode*> matches1 = context1->findNodes(root2.NSR);
+        if (matches1.empty()) {
+            return true;
         }
+        size_t count1 = matches1.size();
+        size_t count2 = context2->countNodes(root2.NSR);
+        if (count1 + count2 > 2) {
+            assert(!root2.USR.empty());
+            return context1->findNodeByUSR(root2.USR) == nullptr;
+        }
+        return false;
+    }
+
+    // A shape found on one side of the diff, and how many unmatched roots there have it
+    struct ShapeCandidate {
+        const beta::APINode* node = nullptr;
+        uint32_t count = 0;
+    };
 
+    void indexShapes(llvm::ArrayRef<const beta::APINode*> roots, llvm::DenseMap<uint64_t, ShapeCandidate>& shapes) {
+        for (const beta::APINode* root : roots) {
+            // Leaves such as variables and typedefs share shapes too easily to tell a move
+            if (!hasChildren(*root)) {
+                continue;
+            }
+            ShapeCandidate& candidate = shapes[root->shapeHash()];
+            candidate.node = root;
+            ++candidate.count;
+        }
     }
-    else if(hasChildren(b)){
 
-        json childrenDiff = json::array();
+    /*
+        Pairs removed and added roots with the same shape, keyed by the removed
+        root. A shape is only taken as a move when exactly one removed and one
+        added root have it, so ambiguous shapes are still reported as removed
+        and added subtrees.
+    */
+    llvm::DenseMap<const beta::APINode*, const beta::APINode*> pairMovedRoots(
+        llvm::ArrayRef<const beta::APINode*> removed,
+        llvm::ArrayRef<const beta::APINode*> added) {
+        llvm::DenseMap<const beta::APINode*, const beta::APINode*> moves;
+        if (removed.empty() || added.empty()) {
+            return moves;
+        }
+        llvm::DenseMap<uint64_t, ShapeCandidate> removedShapes;
+        llvm::DenseMap<uint64_t, ShapeCandidate> addedShapes;
+        indexShapes(removed, removedShapes);
+        indexShapes(added, addedShapes);
+        for (const auto& [shape, from] : removedShapes) {
+            auto to = addedShapes.find(shape);
+            if (from.count == 1 && to != addedShapes.end() && to->second.count == 1 &&
+                from.node->sameShape(*to->second.node)) {
+                moves[from.node] = to->second.node;
+            }
+        }
+        return moves;
+    }
 
-        for (const auto& addedNode : *b->children) {
-            childrenDiff.emplace_back(get_json_from_node(addedNode, ADDED));
-            reconcileUnhandledDeclHashes(contextB, addedNode);
+    std::atomic<bool> pipelinedDiffEnabled{false};
+    std::atomic<bool> recordLayoutsEnabled{false};
+    std::atomic<unsigned> treeBuildJobs{1};
+
+    // The fingerprint of a subtree with the statement hashes it holds, which
+    // a diff reconciles but the fingerprint leaves out
+    uint64_t subtreeVersion(const beta::APINode& node) {
+        llvm::hash_code hash = llvm::hash_combine(
+            node.fingerprint, llvm::hash_combine_range(node.stmtHashes.begin(), node.stmtHashes.end()));
+        for (const beta::APINode* child : node.children) {
+            hash = llvm::hash_combine(hash, subtreeVersion(*child));
         }
+        return static_cast<uint64_t>(hash);
+    }
 
-        if(!childrenDiff.empty()){
-            json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
-            diff[NODE_TYPE] = serialize(a->kind);
-            if(!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
-            diff[TAG] = MODIFIED;
-            return json::array().emplace_back(diff);
+}
+
+RootDiffPipeline::RootDiffPipeline() : worker(&RootDiffPipeline::run, this) {}
+
+RootDiffPipeline::~RootDiffPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        cancelled = true;
+    }
+    queued.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void RootDiffPipeline::setBaseline(const beta::ASTNormalizedContext* older) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        baseline = older;
+        baselineKnown = true;
+        if (baseline == nullptr) {
+            pending.clear();
         }
-        
     }
-    else return a->diff(b);
+    queued.notify_one();
+}
 
-    return json::array();
-    
+void RootDiffPipeline::addRoots(beta::ASTNormalizedContext& context, size_t firstRoot) {
+    // The worker skips the roots the baseline has unchanged by their fingerprints
+    context.fingerprintRoots(firstRoot);
+    const llvm::SmallVector<const beta::APINode*, 64>& roots = context.getRootNodes();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (closed || (baselineKnown && baseline == nullptr)) {
+            return;
+        }
+        pending.insert(pending.end(), roots.begin() + firstRoot, roots.end());
+    }
+    queued.notify_one();
 }
 
+void RootDiffPipeline::finish() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        closed = true;
+    }
+    queued.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
 
-json diffTrees(
+bool RootDiffPipeline::take(const beta::ASTNormalizedContext* older, const beta::APINode& root1,
+                            const beta::APINode& root2, std::vector<beta::DiffEntry>& entries,
+                            HashMultiset::Fingerprint& addedHashes) {
+    if (older != baseline) {
+        return false;
+    }
+    auto it = results.find({&root1, &root2});
+    if (it == results.end() || it->second.taken || it->second.version != subtreeVersion(root2)) {
+        return false;
+    }
+    it->second.taken = true;
+    entries = std::move(it->second.entries);
+    addedHashes = std::move(it->second.addedHashes);
+    return true;
+}
+
+void RootDiffPipeline::run() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    for (;;) {
+        queued.wait(lock, [this] { return cancelled || closed || (baselineKnown && !pending.empty()); });
+        // Closed with roots queued, they are still diffed; without a baseline there is nothing to diff them against
+        if (cancelled || !baselineKnown || pending.empty()) {
+            return;
+        }
+        const beta::APINode* root2 = pending.front();
+        pending.pop_front();
+        lock.unlock();
+        diffRoot(*root2);
+        lock.lock();
+    }
+}
+
+void RootDiffPipeline::diffRoot(const beta::APINode& root2) {
+    std::lock_guard<std::mutex> lock(tree);
+    llvm::ArrayRef<beta::APINode*> matches1 = baseline->findNodes(root2.NSR);
+    const beta::APINode* root1 = matches1.size() == 1 ? matches1.front()
+                                 : root2.USR.empty() ? nullptr
+                                                     : baseline->findNodeByUSR(root2.USR);
+    // Unchanged pairs end at their fingerprints however they are diffed
+    if (root1 == nullptr || root1->kind != root2.kind || root1->fingerprint == root2.fingerprint) {
+        return;
+    }
+    Result result;
+    diffNodes(*root1, root2, threadScratch(), nullptr, result.entries, result.addedHashes);
+    result.version = subtreeVersion(root2);
+    results[{root1, &root2}] = std::move(result);
+}
+
+json streamDiffTreesUntil(
     beta::ASTNormalizedContext* context1,
-    beta::ASTNormalizedContext* context2
+    beta::ASTNormalizedContext* context2,
+    const StoppableDiffEntrySink& onEntry,
+    const armor::HeaderChanges* changes,
+    unsigned jobs
 ) {
-    
-    json astDiff = json::array();
-    llvm::StringMap<llvm::SmallVector<std::shared_ptr<beta::APINode>,16>> tree1 = context1->getTree();
-    llvm::StringMap<llvm::SmallVector<std::shared_ptr<beta::APINode>,16>> tree2 = context2->getTree();
+    armor::profile::PhaseTimer timer(armor::profile::Phase::DIFF_TREES);
 
-    for (auto const &rootNode1 : context1->getRootNodes()) {
+    bool hasASTDiff = false;
+    bool stopped = false;
 
-        llvm::StringRef key = rootNode1->NSR;
-        
-        auto it = tree2.find(key);
-        if (it == tree2.end()) {
-            astDiff.emplace_back(get_json_from_node(rootNode1, REMOVED));
-        } 
+    const llvm::SmallVector<const beta::APINode*,64>& roots1 = context1->getRootNodes();
+    const llvm::SmallVector<const beta::APINode*,64>& roots2 = context2->getRootNodes();
+
+    // Unmatched roots of the two sides with the same shape are reported as
+    // one compact Moved entry, in place of the removed root
+    std::vector<const beta::APINode*> matches(roots1.size());
+    std::vector<const beta::APINode*> removedRoots;
+    std::vector<const beta::APINode*> addedRoots;
+    for (size_t i = 0; i < roots1.size(); ++i) {
+        matches[i] = matchRoot(context1, context2, *roots1[i]);
+        if (matches[i] == nullptr) {
+            removedRoots.push_back(roots1[i]);
+        }
+    }
+    for (const beta::APINode* root2 : roots2) {
+        if (isAddedRoot(context1, context2, *root2)) {
+            addedRoots.push_back(root2);
+        }
+    }
+    llvm::DenseMap<const beta::APINode*, const beta::APINode*> moves = pairMovedRoots(removedRoots, addedRoots);
+    llvm::DenseSet<const beta::APINode*> movedTo;
+    for (const auto& [from, to] : moves) {
+        movedTo.insert(to);
+    }
+
+    // Roots are matched and diffed a window at a time, the matched pairs of a
+    // window concurrently when jobs > 1, and emitted in root order; a window
+    // bounds how many diffs are held before the sink sees them
+    const size_t window = jobs <= 1 ? 1 : jobs * ROOTS_PER_JOB;
+    std::vector<RootDiff> diffs;
+    // Statement hashes of the newer version's added declarations, taken out of
+    // its unhandled declaration hashes when they are compared
+    HashMultiset::Fingerprint reconciled;
+
+    // Pairs the pipeline diffed while the newer version was parsed are taken
+    // from it; --changed-ranges skips pairs it did not look at
+    RootDiffPipeline* pipeline = changes == nullptr ? context2->getDiffPipeline() : nullptr;
+    if (pipeline) {
+        pipeline->finish();
+    }
+
+    std::optional<TypeChangeCollapser> typeChanges;
+    if (unsigned minUsers = getTypeChangeCollapsing()) {
+        typeChanges.emplace(context1->getTypeUsageIndex(), context2->getTypeUsageIndex(), minUsers);
+    }
+
+    for (size_t begin = 0; begin < roots1.size(); begin += window) {
+        size_t count = std::min(window, roots1.size() - begin);
+        diffs.resize(count);
+
+        auto diffRoot = [&](size_t i) {
+            if (matches[begin + i] != nullptr &&
+                !(pipeline && pipeline->take(context1, *roots1[begin + i], *matches[begin + i],
+                                             diffs[i].entries, diffs[i].addedHashes))) {
+                diffNodes(*roots1[begin + i], *matches[begin + i], threadScratch(), changes,
+                          diffs[i].entries, diffs[i].addedHashes);
+            }
+        };
+        if (count == 1) {
+            diffRoot(0);
+        }
         else {
-            size_t count1 = tree1[key].size();
-            size_t count2 = tree2[key].size();
-            if (count1 + count2 > 2) {
-                assert(!rootNode1->USR.empty());
-                key = rootNode1->USR;
-                auto usrIt = context2->usrNodeMap.find(key);
-                if (usrIt != context2->usrNodeMap.end()) {
-                    const std::shared_ptr<const beta::APINode> rootNode2 = usrIt->second;
-                    json sameScopeDiff = diffNodes(context1, context2, rootNode1, rootNode2);
-                    if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()){
-                        if (sameScopeDiff.is_array()){ 
-                            astDiff.insert(astDiff.end(), sameScopeDiff.begin(), sameScopeDiff.end());
-                        }
-                        else astDiff.emplace_back(sameScopeDiff);
-                    }
-                } 
-                else astDiff.emplace_back(get_json_from_node(rootNode1, REMOVED));
-            } 
-            else {
-                assert(count1+count2 == 2);
-                const std::shared_ptr<const beta::APINode> rootNode2 = it->second[0];
-                json sameScopeDiff = diffNodes(context1, context2, rootNode1, rootNode2);
-                if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()){
-                    if (sameScopeDiff.is_array()){ 
-                        astDiff.insert(astDiff.end(), sameScopeDiff.begin(), sameScopeDiff.end());
-                    }
-                    else astDiff.emplace_back(sameScopeDiff);
+            armor::parallelFor(count, jobs, diffRoot);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const beta::APINode& root1 = *roots1[begin + i];
+            if (matches[begin + i] == nullptr) {
+                auto move = moves.find(&root1);
+                beta::DiffEntry entry = move == moves.end() ? beta::DiffEntry(beta::DiffTag::Removed, root1)
+                                                            : beta::DiffEntry(beta::DiffTag::Moved, *move->second, root1);
+                if (!onEntry(entry.toJson())) {
+                    return json();
                 }
+                hasASTDiff = true;
+                continue;
+            }
+            reconciled += diffs[i].addedHashes;
+            diffs[i].addedHashes = HashMultiset::Fingerprint();
+            if (typeChanges) {
+                typeChanges->collapse(diffs[i].entries);
+            }
+            hasASTDiff |= emitDiff(onEntry, diffs[i].entries, stopped);
+            if (stopped) {
+                return json();
             }
         }
     }
 
-    for (const auto & rootNode2 : context2->getRootNodes()) {
-        
-        llvm::StringRef key = rootNode2->NSR;
-
-        auto it = tree1.find(key);
-        if (it == tree1.end()) {
-            astDiff.emplace_back(get_json_from_node(rootNode2, ADDED));
-            reconcileUnhandledDeclHashes(context2, rootNode2);
-        }
-        else{
-            size_t count1 = tree1[key].size();
-            size_t count2 = tree2[key].size();
-            if (count1 + count2 > 2) {
-                assert(!rootNode2->USR.empty());
-                key = rootNode2->USR;
-                auto usrIt = context1->usrNodeMap.find(key);
-                if (usrIt == context1->usrNodeMap.end()){
-                    astDiff.emplace_back(get_json_from_node(rootNode2, ADDED));
-                    reconcileUnhandledDeclHashes(context2, rootNode2);
+    // A moved root was reported with its removed counterpart, but its
+    // declarations still account for statement hashes of the newer version
+    for (const beta::APINode* rootNode2 : addedRoots) {
+        if (!movedTo.contains(rootNode2)) {
+            if (!onEntry(beta::DiffEntry(beta::DiffTag::Added, *rootNode2).toJson())) {
+                return json();
+            }
+            hasASTDiff = true;
+        }
+        collectAddedHashes(*rootNode2, reconciled);
+    }
+
+    if (typeChanges && !typeChanges->empty()) {
+        if (!typeChanges->emit(onEntry)) {
+            return json();
+        }
+        hasASTDiff = true;
+    }
+
+    bool macroDiff = isMacroDiffEnabled();
+    if (macroDiff) {
+        const MacroTable& macros1 = context1->getSourceRangeTracker().getMacros();
+        const MacroTable& macros2 = context2->getSourceRangeTracker().getMacros();
+        if (macros1.differs(macros2)) {
+            for (const MacroTable::Change& change : MacroTable::diff(macros1, macros2)) {
+                if (!onEntry(macroEntry(change))) {
+                    return json();
                 }
+                hasASTDiff = true;
             }
-            // No else as we already computed if count1 + count 2 == 2 we do not have to compute it again.
         }
     }
 
     const beta::SourceRangeTracker& tracker1 = context1->getSourceRangeTracker();
     const beta::SourceRangeTracker& tracker2 = context2->getSourceRangeTracker();
     
-    const llvm::DenseMap<uint64_t, int>& commentsHashMap1 = tracker1.getCommentsHashMap();
-    const llvm::DenseMap<uint64_t, int>& commentsHashMap2 = tracker2.getCommentsHashMap();
-
-    const llvm::DenseMap<uint64_t, int>& unhandledDeclsHashMap1 = tracker1.getUnhandledDeclsHashMap();
-    const llvm::DenseMap<uint64_t, int>& unhandledDeclsHashMap2 = tracker2.getUnhandledDeclsHashMap();
+    HashMultiset macrolessDecls1 = macroDiff ? withoutMacroDirectives(tracker1) : HashMultiset();
+    HashMultiset macrolessDecls2 = macroDiff ? withoutMacroDirectives(tracker2) : HashMultiset();
+    const HashMultiset& unhandledDeclsHashMap1 = macroDiff ? macrolessDecls1 : tracker1.getUnhandledDeclsHashMap();
+    const HashMultiset& unhandledDeclsHashMap2 = macroDiff ? macrolessDecls2 : tracker2.getUnhandledDeclsHashMap();
 
-    const llvm::DenseMap<uint64_t, int>& inactiveUnhandledDeclsHashMap1 = tracker1.getInactiveUnhandledDeclsHashMap();
-    const llvm::DenseMap<uint64_t, int>& inactiveUnhandledDeclsHashMap2 = tracker2.getInactiveUnhandledDeclsHashMap();
+    const HashMultiset& inactiveUnhandledDeclsHashMap1 = tracker1.getInactiveUnhandledDeclsHashMap();
+    const HashMultiset& inactiveUnhandledDeclsHashMap2 = tracker2.getInactiveUnhandledDeclsHashMap();
 
     #ifdef TESTING_ENABLED
         TEST_LOG << "\n############ CONTEXT 1 MAPS ############" << "\n";
-        printDenseMap(commentsHashMap1, "comments1");
+        printDenseMap(tracker1.getCommentsHashMap(), "comments1");
         printDenseMap(unhandledDeclsHashMap1, "unhandledDecls1");
         printDenseMap(inactiveUnhandledDeclsHashMap1, "inactiveUnhandledDecls1");
         
         TEST_LOG << "\n############ CONTEXT 2 MAPS ############" << "\n";
-        printDenseMap(commentsHashMap2, "comments2");
+        printDenseMap(tracker2.getCommentsHashMap(), "comments2");
         printDenseMap(unhandledDeclsHashMap2, "unhandledDecls2");
         printDenseMap(inactiveUnhandledDeclsHashMap2, "inactiveUnhandledDecls2");
     #endif
 
-    bool hasASTDiff = !astDiff.empty();
-    
-    bool hasCommentsDiff = hasHashMapDifference(commentsHashMap1, commentsHashMap2) || 
-                           hasHashMapDifference(commentsHashMap2, commentsHashMap1);
+    // Fingerprint compares; the multisets are never walked here. The newer
+    // version's hashes, less those of its added declarations, match the older's
+    HashMultiset::Fingerprint unreconciled2 = unhandledDeclsHashMap2.getFingerprint();
+    unreconciled2 -= reconciled;
+    #ifdef TESTING_ENABLED
+        TEST_LOG << "reconciled " << reconciled.total << " statement hashes of added declarations\n";
+    #endif
+    bool hasUnhandledDeclsDiff = unhandledDeclsHashMap1.getFingerprint() != unreconciled2;
 
-    bool hasUnhandledDeclsDiff = hasHashMapDifference(unhandledDeclsHashMap1, unhandledDeclsHashMap2) || 
-                                 hasHashMapDifference(unhandledDeclsHashMap2, unhandledDeclsHashMap1);
+    bool hasInactiveUnhandledDeclsDiff = inactiveUnhandledDeclsHashMap1.differs(inactiveUnhandledDeclsHashMap2);
 
-    bool hasInactiveUnhandledDeclsDiff = hasHashMapDifference(inactiveUnhandledDeclsHashMap1, inactiveUnhandledDeclsHashMap2) || 
-                                         hasHashMapDifference(inactiveUnhandledDeclsHashMap2, inactiveUnhandledDeclsHashMap1);
+    if (!hasUnhandledDeclsDiff) {
+        hasUnhandledDeclsDiff = !confirmedUnchanged(tracker1, tracker2, RangeDigests::Category::UnhandledDecls,
+                                                    unhandledDeclsHashMap1, "unhandled declarations");
+    }
+    if (!hasInactiveUnhandledDeclsDiff) {
+        hasInactiveUnhandledDeclsDiff =
+            !confirmedUnchanged(tracker1, tracker2, RangeDigests::Category::InactiveUnhandledDecls,
+                                inactiveUnhandledDeclsHashMap1, "inactive regions");
+    }
+    // Comments only decide the status when nothing else changed, and are only hashed then
+    bool hasCommentsDiff = false;
+    if (!hasUnhandledDeclsDiff && !hasASTDiff) {
+        const HashMultiset& commentsHashMap1 = tracker1.getCommentsHashMap();
+        const HashMultiset& commentsHashMap2 = tracker2.getCommentsHashMap();
+        hasCommentsDiff = commentsHashMap1.differs(commentsHashMap2) ||
+                          !confirmedUnchanged(tracker1, tracker2, RangeDigests::Category::Comments,
+                                              commentsHashMap1, "comments");
+    }
 
     ParsedDiffStatus parsedStatus = determineStatus(hasASTDiff, hasCommentsDiff, hasUnhandledDeclsDiff);
     UnParsedDiffStatus unparsedStatus = hasInactiveUnhandledDeclsDiff ? UnParsedDiffStatus::CHANGED : UnParsedDiffStatus::UN_CHANGED;
@@ -398,7 +1000,70 @@ json diffTrees(
     result[PARSED_STATUS] = parsedStatus;
     result[UNPARSED_STATUS] = unparsedStatus;
     result[HEADER_RESOLUTION_FAILURES] = json::array();
-    result[AST_DIFF] = astDiff;
 
+    return result;
+}
+
+void setMacroDiff(bool enabled) {
+    macroDiffEnabled = enabled;
+}
+
+bool isMacroDiffEnabled() {
+    return macroDiffEnabled;
+}
+
+void setTypeChangeCollapsing(unsigned minUsers) {
+    typeChangeMinUsers = minUsers;
+}
+
+unsigned getTypeChangeCollapsing() {
+    return typeChangeMinUsers;
+}
+
+void setPipelinedDiff(bool enabled) {
+    pipelinedDiffEnabled = enabled;
+}
+
+bool isPipelinedDiffEnabled() {
+    return pipelinedDiffEnabled;
+}
+
+void setRecordLayouts(bool enabled) {
+    recordLayoutsEnabled = enabled;
+}
+
+bool isRecordLayoutEnabled() {
+    return recordLayoutsEnabled;
+}
+
+void setTreeBuildJobs(unsigned jobs) {
+    treeBuildJobs = jobs;
+}
+
+unsigned getTreeBuildJobs() {
+    return treeBuildJobs;
+}
+
+json streamDiffTrees(
+    beta::ASTNormalizedContext* context1,
+    beta::ASTNormalizedContext* context2,
+    const DiffEntrySink& onEntry,
+    const armor::HeaderChanges* changes,
+    unsigned jobs
+) {
+    return streamDiffTreesUntil(
+        context1, context2, [&onEntry](json&& entry) { onEntry(std::move(entry)); return true; }, changes, jobs);
+}
+
+json diffTrees(
+    beta::ASTNormalizedContext* context1,
+    beta::ASTNormalizedContext* context2,
+    const armor::HeaderChanges* changes,
+    unsigned jobs
+) {
+    json astDiff = json::array();
+    json result = streamDiffTrees(
+        context1, context2, [&astDiff](json&& entry) { astDiff.emplace_back(std::move(entry)); }, changes, jobs);
+    result[AST_DIFF] = std::move(astDiff);
     return result;
 }
\ No newline at end of file
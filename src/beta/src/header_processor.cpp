@@ -1,9 +1,11 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 #include <filesystem>
+#include <future>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <optional>
 #include <string>
 #include <sys/stat.h>
 #include <utility>
@@ -20,10 +22,16 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include "comm_def.hpp"
+#include "compressed_output.hpp"
 #include "report_generator.hpp"
 #include "report_utils.hpp"
 #include "diffengine.hpp"
+#include "diff_utils.hpp"
+#include "json_stream.hpp"
+#include "report_format.hpp"
 #include "logger.hpp"
+#include "output_writer.hpp"
+#include "compile_flags.hpp"
 #include "header_processor.hpp"
 #include "session.hpp"
 
@@ -34,97 +42,164 @@ using namespace llvm;
 
 namespace {
 
-    std::vector<std::string> getClangFlags(const std::vector<std::string>& includePaths,
-                                           const std::vector<std::string>& macroFlags,
-                                           const LANG_OPTIONS lang) {
-        std::vector<std::string> flags;
-
-        const char* rawFlags;
-        switch (lang) {
-            case LANG_OPTIONS::C:
-                rawFlags = CLANG_FLAGS_C;
-                break;
-            case LANG_OPTIONS::CPP:
-                rawFlags = CLANG_FLAGS_CPP;
-                break;
-            default:
-                rawFlags = CLANG_FLAGS_CPP;
-                break;
+    // Diff entries held per diff job before their records are made in parallel
+    constexpr std::size_t PENDING_CHANGES_PER_JOB = 1024;
+
+}
+
+void reportHeaderPairBeta(const std::string& project1,
+                       const std::string& file1,
+                       const std::string& reportFormat,
+                       beta::ASTNormalizedContext* context1,
+                       beta::ASTNormalizedContext* context2,
+                       bool dumpAstDiff,
+                       const armor::HeaderChanges* changes,
+                       const armor::OutputPaths& outputs,
+                       unsigned diffJobs) {
+
+    std::string headerName = std::filesystem::path(file1).filename().c_str();
+    fs::path relative_path = fs::relative(file1, project1);
+    std::string trimmed_path = relative_path.string();
+
+    // The diff entries are grouped into report rows as they are produced and
+    // then dropped; the JSON dump is a debugging aid only and is streamed too.
+    // A CBOR or MessagePack dump is encoded whole once the diff ends
+    armor::ReportFormat dumpFormat = armor::reportFormatOf(reportFormat);
+    std::optional<armor::OutputFile> dumpFile;
+    // Writes through gzip with --compress-debug-output
+    std::unique_ptr<armor::GzipOStream> compressedDump;
+    std::ostream* dumpOut = nullptr;
+    std::unique_ptr<armor::JsonStreamWriter> dump;
+    nlohmann::json binaryDump;
+    if (dumpAstDiff) {
+        std::string outputFile = outputs.astDiffFile(headerName, dumpFormat);
+        dumpFile.emplace(outputFile, true);
+        dumpOut = &dumpFile->stream();
+        if (*dumpFile && outputs.compressDebugOutput) {
+            compressedDump = std::make_unique<armor::GzipOStream>(*dumpOut);
+            dumpOut = compressedDump.get();
         }
-        
-        std::istringstream iss(rawFlags);
-        std::string flag;
-        while (iss >> flag) {
-            flags.emplace_back(std::move(flag));
+        if (*dumpFile && dumpFormat != armor::ReportFormat::JSON) {
+            binaryDump[AST_DIFF] = nlohmann::json::array();
         }
-
-        // Add runtime include paths
-        for (const auto& path : includePaths) {
-            flags.emplace_back("-I" + path);
+        else if (*dumpFile) {
+            dump = std::make_unique<armor::JsonStreamWriter>(*dumpOut);
+            dump->beginObject();
+            dump->key(AST_DIFF);
+            dump->beginArray();
         }
-
-        // Add full macro flags directly
-        for (const auto& macro : macroFlags) {
-            flags.emplace_back(macro);
+        else {
+            armor::user_error() << "Error generating AST diff: cannot open " << outputFile << "\n";
         }
-
-        return flags;
     }
 
+    // With several diff jobs, the records of the entries are made in parallel
+    // chunks; a bounded batch of entries is held for them and added in order
+    ApiChangeGroups groups(trimmed_path);
+    nlohmann::json pendingChanges = nlohmann::json::array();
+    const std::size_t pendingLimit = diffJobs > 1 ? PENDING_CHANGES_PER_JOB * diffJobs : 0;
+    nlohmann::json status = streamDiffTrees(
+        context1,
+        context2,
+        [&](nlohmann::json&& entry) {
+            if (dump) {
+                dump->value(entry);
+            }
+            if (pendingLimit == 0) {
+                groups.addChange(entry);
+            }
+            else {
+                pendingChanges.push_back(binaryDump.is_null() ? std::move(entry) : entry);
+                if (pendingChanges.size() >= pendingLimit) {
+                    groups.addChanges(pendingChanges, diffJobs);
+                    pendingChanges.clear();
+                }
+            }
+            if (!binaryDump.is_null()) {
+                binaryDump[AST_DIFF].push_back(std::move(entry));
+            }
+        },
+        changes,
+        diffJobs
+    );
+    groups.addChanges(pendingChanges, diffJobs);
 
-    std::vector<std::string> resolveInternalIncludePaths(const std::vector<std::string>& internalPaths,
-                                                         const std::string& workspacePath) {
-
-        std::vector<std::string> resolvedPaths;
-        for (const auto& path : internalPaths) {
-            resolvedPaths.push_back(workspacePath + "/" + path);
+    if (dump) {
+        dump->endArray();
+        for (const auto& member : status.items()) {
+            dump->field(member.key(), member.value());
+        }
+        dump->endObject();
+        if (compressedDump) {
+            compressedDump->finish();
         }
-        return resolvedPaths;
+        dumpFile->close();
     }
-
-    std::vector<std::string> generateIncludePaths(const std::string& projectPath, const std::string& headerPath) {
-        std::vector<std::string> includePaths;
-
-        // Ensure the header path starts with the project path
-        if (headerPath.find(projectPath) != 0) {
-            armor::user_error() << "Warning: Header file " << headerPath << " is not within project path " << projectPath << "\n";
-            return includePaths;
+    else if (!binaryDump.is_null()) {
+        for (const auto& member : status.items()) {
+            binaryDump[member.key()] = member.value();
         }
+        armor::writeReportDocument(*dumpOut, binaryDump, dumpFormat);
+        if (compressedDump) {
+            compressedDump->finish();
+        }
+        dumpFile->close();
+    }
 
-        // Get the directory of the header file
-        llvm::SmallString<256> headerDir(headerPath);
-        llvm::sys::path::remove_filename(headerDir);
+    if (!outputs.writeReports) {
+        submit_report(std::move(groups), status.value(PARSED_STATUS, 0), status.value(UNPARSED_STATUS, 0),
+                      "", "", BETA_PARSER);
+        return;
+    }
 
-        // Start with the directory containing the header file
-        llvm::SmallString<256> currentPath = headerDir;
+    // The report directories are created as the reports are written
+    std::string htmlReportFile = outputs.htmlReportFile(headerName);
 
-        // Add all parent directories up to and including the project path
-        while (llvm::StringRef(currentPath).str().length() >= projectPath.length()) {
-            includePaths.push_back("-I" + llvm::StringRef(currentPath).str());
+    bool generate_json = (reportFormat != "html");
+    std::string jsonReportFile;
+    if (generate_json) {
+        jsonReportFile = outputs.jsonReportFile(headerName, armor::reportFormatOf(reportFormat));
+    }
+    submit_report(std::move(groups), status.value(PARSED_STATUS, 0), status.value(UNPARSED_STATUS, 0),
+                  htmlReportFile, jsonReportFile, BETA_PARSER, generate_json);
+}
 
-            // Move up one directory
-            llvm::sys::path::remove_filename(currentPath);
+void reportHeaderPairVerdictBeta(const std::string& project1,
+                       const std::string& file1,
+                       beta::ASTNormalizedContext* context1,
+                       beta::ASTNormalizedContext* context2,
+                       const armor::HeaderChanges* changes,
+                       unsigned diffJobs) {
 
-            // If we've reached the root directory, break
-            if (currentPath.empty()) {
-                break;
-            }
-        }
+    std::string trimmed_path = fs::relative(file1, project1).string();
 
-        // Make sure the project path itself is included
-        if (std::find(includePaths.begin(), includePaths.end(), "-I" + projectPath) == includePaths.end()) {
-            includePaths.push_back("-I" + projectPath);
-        }
+    // One incompatible entry makes the header backward incompatible whatever
+    // the statuses of the rest of the diff would be
+    bool backwardIncompatible = false;
+    nlohmann::json status = streamDiffTreesUntil(
+        context1,
+        context2,
+        [&](nlohmann::json&& entry) {
+            backwardIncompatible = is_backward_incompatible_change(entry);
+            return !backwardIncompatible;
+        },
+        changes,
+        diffJobs
+    );
 
-        return includePaths;
+    if (backwardIncompatible) {
+        report_verdict(trimmed_path, static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                       static_cast<int>(UnParsedDiffStatus::UN_CHANGED), true);
+    }
+    else {
+        report_verdict(trimmed_path, status.value(PARSED_STATUS, 0), status.value(UNPARSED_STATUS, 0), false);
     }
 }
 
-PARSING_STATUS processHeaderPairBeta(const std::string& project1,
+ParsedHeaderPairBeta parseHeaderPairBeta(const std::string& project1,
                        const std::string& file1,
                        const std::string& project2,
                        const std::string& file2,
-                       const std::string& reportFormat,
                        const std::vector<std::string>& IncludePaths,
                        const std::vector<std::string>& macroFlags,
                        const LANG_OPTIONS lang) {
@@ -133,100 +208,64 @@ PARSING_STATUS processHeaderPairBeta(const std::string& project1,
         armor::user_error() << "Failed to open diagnostics log <" << LOG_FILE_PATH << ">, using stderr\n";
     }
 
-    std::vector<std::string> inclusion_paths1 = generateIncludePaths(project1, file1);
-    std::vector<std::string> inclusion_paths2 = generateIncludePaths(project2, file2);
-
-    std::vector<std::string> inclusionPaths1 = resolveInternalIncludePaths(IncludePaths, project1);
-    std::vector<std::string> inclusionPaths2 = resolveInternalIncludePaths(IncludePaths, project2);
-
-    std::vector<std::string> Flags1 = getClangFlags(inclusionPaths1, macroFlags, lang);
-    std::vector<std::string> Flags2 = getClangFlags(inclusionPaths2, macroFlags, lang);
-
-    Flags1.insert(Flags1.end(), inclusion_paths1.begin(), inclusion_paths1.end());
-    Flags2.insert(Flags2.end(), inclusion_paths2.begin(), inclusion_paths2.end());
+    std::vector<std::string> Flags1 = armor::buildCompileFlags(project1, file1, IncludePaths, macroFlags, lang);
+    std::vector<std::string> Flags2 = armor::buildCompileFlags(project2, file2, IncludePaths, macroFlags, lang);
 
     // 1. Set up the Session
     auto compDB1 = std::make_unique<FixedCompilationDatabase>(project1, Flags1);
     auto compDB2 = std::make_unique<FixedCompilationDatabase>(project2, Flags2);
-    auto session = std::make_unique<beta::APISession>();
-
-    std::string headerName = std::filesystem::path(file1).filename().c_str();
+    ParsedHeaderPairBeta parsed;
+    parsed.session = std::make_unique<beta::APISession>();
+    beta::APISession* session = parsed.session.get();
 
     armor::info() << "Processing File1 : " << file1 << "\n";
     for (auto& x : Flags1) {
         armor::info() << "Clang search path : " << x << "\n";
     }
-
-    // 2. Process the files. The session handles the tools and contexts.
-    PARSING_STATUS header1ParsingStatus = session->processFile(file1, std::move(compDB1));
-
     armor::info() << "Processing File2 : " << file2 << "\n";
     for (auto& x : Flags2) {
         armor::info() << "Clang search path : " << x << "\n";
     }
 
-    PARSING_STATUS header2ParsingStatus = session->processFile(file2, std::move(compDB2));
+    // 2. Process the files. The two translation units share no state, so the
+    //    newer version is parsed on a second thread while this one parses the older.
+    std::future<PARSING_STATUS> header2Future = std::async(std::launch::async,
+        [session, &file2, compDB = std::move(compDB2)]() mutable {
+            return session->processFile(file2, std::move(compDB));
+        });
+    PARSING_STATUS header1ParsingStatus = session->processFile(file1, std::move(compDB1));
+    PARSING_STATUS header2ParsingStatus = header2Future.get();
 
     // 3. Retrieve the results from the session
-    beta::ASTNormalizedContext* context1 = session->getContext(file1);
-    beta::ASTNormalizedContext* context2 = session->getContext(file2);
-
-    if (!context1 || !context2) {
+    parsed.context1 = session->getContext(file1);
+    parsed.context2 = session->getContext(file2);
+    parsed.status = header1ParsingStatus == header2ParsingStatus ? header1ParsingStatus : FATAL_ERRORS;
+    if (!parsed.context1 || !parsed.context2) {
         armor::user_error() << "Failed to retrieve processing results from session\n";
-        return FATAL_ERRORS;
+        parsed.status = FATAL_ERRORS;
     }
+    return parsed;
+}
 
-    // 4. Perform the diff using the retrieved contexts
-    nlohmann::json diffResult;
-
-    diffResult = diffTrees(
-        context1,
-        context2
-    );
+PARSING_STATUS processHeaderPairBeta(const std::string& project1,
+                       const std::string& file1,
+                       const std::string& project2,
+                       const std::string& file2,
+                       const std::string& reportFormat,
+                       const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macroFlags,
+                       const LANG_OPTIONS lang,
+                       bool dumpAstDiff) {
 
-    std::string dumpDir = "debug_output/ast_diffs";
-    std::filesystem::create_directories(dumpDir);
-    std::string outputFile = dumpDir + "/ast_diff_output_" + headerName + ".json";
-
-    try {
-        if (!diffResult.empty()) {
-            std::ofstream out(outputFile,std::ios::trunc);
-            out << diffResult.dump(4);
-            out.close();
-        } 
-    } catch (const std::exception& e) {
-        armor::user_error() << "Error generating AST diff: " << e.what() << "\n";
+    ParsedHeaderPairBeta parsed = parseHeaderPairBeta(project1, file1, project2, file2, IncludePaths, macroFlags, lang);
+    if (!parsed.context1 || !parsed.context2) {
+        return FATAL_ERRORS;
     }
 
-    std::string reportDir = "armor_reports/html_reports";
-    std::filesystem::create_directories(reportDir);
-    std::string htmlReportFile = reportDir + "/api_diff_report_" + headerName + ".html";
-
-    if (!diffResult.empty()) {
-        bool generate_json = (reportFormat == "json");
-        std::string jsonReportFile;
-        if (generate_json) {
-            std::string jsonReportDir = "armor_reports/json_reports";
-            std::filesystem::create_directories(jsonReportDir);
-            jsonReportFile = jsonReportDir + "/api_diff_report_" + headerName + ".json";
-        }
-        fs::path relative_path = fs::relative(file1, project1);
-        std::string trimmed_path = relative_path.string();
-        report_generator(outputFile, trimmed_path, htmlReportFile, jsonReportFile, BETA_PARSER, generate_json);
-    }
-    else {
-        try {
-            std::vector<json> emptyData;
-            // generate_html_report(emptyData, htmlReportFile, BETA_PARSER);
-            armor::user_print() << "HTML report generated at: " << htmlReportFile << "\n";
-        }
-        catch (const std::exception& e) {
-            armor::user_error() << "Failed to generate HTML report: " << e.what() << "\n";
-        }
-    }
+    reportHeaderPairBeta(project1, file1, reportFormat, parsed.context1, parsed.context2, dumpAstDiff);
 
     DebugConfig::getInstance().flush();
 
-    return  header1ParsingStatus == header2ParsingStatus ? header1ParsingStatus : FATAL_ERRORS;
+    return parsed.status;
 
 }
@@ -3,98 +3,183 @@
 #include "diff_utils.hpp"
 #include "node.hpp"
 #include <cassert>
+#include <llvm/ADT/Hashing.h>
 #include <iostream>
 #include <string>
 
-nlohmann::json beta::APINode::diff(const std::shared_ptr<const beta::APINode>& other) const {
-    nlohmann::json result, removed, added;
+namespace {
 
-    // Helper to add metadata to a diff JSON node
-    auto appendNodeMetadata  = [&](nlohmann::json& node) {
-        node[NODE_TYPE] = serialize(kind);
-        node[QUALIFIED_NAME] = qualifiedName;
-    };
-    
-    // Define a lambda function to compare fields
-    auto compare = [&](const std::string& field, const auto &lhs, const auto &rhs, const auto &emptyValue) {
-        if (lhs != rhs) {
-            if (lhs != emptyValue) {
-                removed[field] = serialize(lhs);
-            }
-            if (rhs != emptyValue) {
-                added[field] = serialize(rhs);
-            }
+    // Name of `child` within `parent`: its own name when spelled under the
+    // parent, otherwise the last component of it
+    llvm::StringRef relativeName(const beta::APINode& parent, const beta::APINode& child) {
+        if (child.scope == &parent) {
+            return child.name;
         }
-    };
+        size_t scope = child.name.rfind("::");
+        return scope == llvm::StringRef::npos ? child.name : child.name.substr(scope + 2);
+    }
 
-    // Compare fields
-    if( dataType != other->dataType ){
+    /**
+     * A field APINode::diff reports: its DiffField bit, the value compared
+     * (`value`, given the kind of the older node so the data type can pick
+     * by it), the value standing for "not set", which is reported on neither
+     * side, and whether the field applies to a pair at all.
+     */
+    template <typename T>
+    struct DiffableField {
+        beta::DiffField field;
+        T (*value)(const beta::APINode&, NodeKind);
+        T emptyValue;
+        bool (*applies)(const beta::APINode&, const beta::APINode&);
 
-        if(kind == NodeKind::FunctionPointer){
-            compare(DATA_TYPE, dataType, other->dataType, std::string{});
+        bool differs(const beta::APINode& a, const beta::APINode& b) const {
+            return applies(a, b) && value(a, a.kind) != value(b, a.kind);
         }
-        else{
-            assert(!caonicalType.empty());
-            assert(!other->caonicalType.empty());
-            compare(DATA_TYPE, caonicalType, other->caonicalType, std::string{});
+
+        bool isEmpty(const beta::APINode& node, NodeKind kind) const {
+            return value(node, kind) == emptyValue;
         }
+    };
+
+    constexpr bool always(const beta::APINode&, const beta::APINode&) {
+        return true;
     }
-    
-    compare(
-        STORAGE_QUALIFIER, 
-        storage, 
-        other->storage, 
-        APINodeStorageClass::None
-    );
-    compare(
-        VIRTUAL_QUALIFIER, 
-        virtualQualifier, 
-        other->virtualQualifier, 
-        VirtualQualifier::None
-    );
-    compare(
-        INLINE, 
-        isInclined, 
-        other->isInclined, 
-        false
-    );
-    compare(
-        CONST_EXPR, 
-        isConstExpr, 
-        other->isConstExpr, 
-        false
-    );
-    // If there are any changes
-    if (!removed.empty() || !added.empty()) {
-        // Helper to process removed and added changes
-        auto processChanges = [&](nlohmann::json& parent) {
-            if (!removed.empty()) {
-                removed[TAG] = REMOVED;
-                appendNodeMetadata(removed);
-                parent.emplace_back(std::move(removed));
-            }
-            if (!added.empty()) {
-                added[TAG] = ADDED;
-                appendNodeMetadata(added);
-                parent.emplace_back(std::move(added));
-            }
-        };
-
-        if (this->children == nullptr) {
-            nlohmann::json children = nlohmann::json::array();
-            processChanges(children);
-
-            if (!children.empty()) {
-                result[CHILDREN] = std::move(children);
-                appendNodeMetadata(result);
-                result[TAG] = MODIFIED;
-            }
-        } 
-        else {
-            result = nlohmann::json::array();
-            processChanges(result);
+
+    // Function pointers compare their written type, other nodes their
+    // canonical one, and only once the written types differ
+    constexpr DiffableField<llvm::StringRef> DATA_TYPE_FIELD{
+        beta::DIFF_FIELD_DATA_TYPE,
+        [](const beta::APINode& node, NodeKind kind) {
+            return kind == NodeKind::FunctionPointer ? node.dataType : node.caonicalType;
+        },
+        llvm::StringRef(),
+        [](const beta::APINode& a, const beta::APINode& b) { return a.dataType != b.dataType; }};
+    constexpr DiffableField<APINodeStorageClass> STORAGE_FIELD{
+        beta::DIFF_FIELD_STORAGE, [](const beta::APINode& node, NodeKind) { return node.storage; },
+        APINodeStorageClass::None, always};
+    constexpr DiffableField<VirtualQualifier> VIRTUAL_FIELD{
+        beta::DIFF_FIELD_VIRTUAL, [](const beta::APINode& node, NodeKind) { return node.virtualQualifier; },
+        VirtualQualifier::None, always};
+    constexpr DiffableField<bool> INLINE_FIELD{
+        beta::DIFF_FIELD_INLINE, [](const beta::APINode& node, NodeKind) { return node.isInclined; }, false, always};
+    constexpr DiffableField<bool> CONSTEXPR_FIELD{
+        beta::DIFF_FIELD_CONSTEXPR, [](const beta::APINode& node, NodeKind) { return node.isConstExpr; }, false, always};
+    // Only records laid out on both sides compare, so enabling layouts adds no change of its own
+    constexpr DiffableField<llvm::StringRef> LAYOUT_FIELD{
+        beta::DIFF_FIELD_LAYOUT, [](const beta::APINode& node, NodeKind) { return node.layout; }, llvm::StringRef(),
+        [](const beta::APINode& a, const beta::APINode& b) { return !a.layout.empty() && !b.layout.empty(); }};
+
+    // Calls `visit` on every DiffableField, unrolled at compile time
+    template <typename Visit>
+    void forEachDiffableField(Visit&& visit) {
+        visit(DATA_TYPE_FIELD);
+        visit(STORAGE_FIELD);
+        visit(VIRTUAL_FIELD);
+        visit(INLINE_FIELD);
+        visit(CONSTEXPR_FIELD);
+        visit(LAYOUT_FIELD);
+    }
+
+    bool sameFields(const beta::APINode& a, const beta::APINode& b) {
+        return a.kind == b.kind && a.dataType == b.dataType && a.caonicalType == b.caonicalType &&
+               a.isInclined == b.isInclined && a.isConstExpr == b.isConstExpr && a.access == b.access &&
+               a.storage == b.storage && a.virtualQualifier == b.virtualQualifier && a.layout == b.layout;
+    }
+
+}
+
+void beta::APINode::diff(const beta::APINode& other, std::vector<DiffEntry>& out) const {
+    assert(kind == NodeKind::FunctionPointer || dataType == other.dataType ||
+           (!caonicalType.empty() && !other.caonicalType.empty()));
+
+    // Bitmask equality first; most matched pairs stop here
+    uint8_t differing = 0;
+    forEachDiffableField([&](const auto& descriptor) {
+        differing |= descriptor.differs(*this, other) ? descriptor.field : 0;
+    });
+    if (differing == 0) {
+        return;
+    }
+    uint8_t removedFields = 0;
+    uint8_t addedFields = 0;
+    forEachDiffableField([&](const auto& descriptor) {
+        if (differing & descriptor.field) {
+            removedFields |= descriptor.isEmpty(*this, kind) ? 0 : descriptor.field;
+            addedFields |= descriptor.isEmpty(other, kind) ? 0 : descriptor.field;
         }
+    });
+
+    // If there are any changes
+    if (removedFields == 0 && addedFields == 0) {
+        return;
     }
 
+    std::vector<DiffEntry>* parent = &out;
+    if (this->children.empty()) {
+        out.emplace_back(DiffTag::Modified, *this);
+        parent = &out.back().children;
+    }
+    if (removedFields != 0) {
+        parent->emplace_back(DiffTag::Removed, removedFields, *this, *this);
+    }
+    if (addedFields != 0) {
+        parent->emplace_back(DiffTag::Added, addedFields, other, *this);
+    }
+}
+
+std::string beta::APINode::getQualifiedName() const {
+    llvm::SmallVector<llvm::StringRef, 8> names;
+    for (const APINode* node = this; node; node = node->scope) {
+        if (!node->name.empty()) {
+            names.push_back(node->name);
+        }
+    }
+    std::string result;
+    for (auto it = names.rbegin(); it != names.rend(); ++it) {
+        if (!result.empty()) {
+            result += "::";
+        }
+        result.append(it->data(), it->size());
+    }
     return result;
-}
\ No newline at end of file
+}
+
+uint64_t beta::APINode::computeFingerprint() {
+    llvm::hash_code hash = llvm::hash_combine(kind, name, dataType, caonicalType,
+                                              isInclined, isConstExpr, access, storage,
+                                              virtualQualifier, layout, USR, NSR);
+    subtreeStmtHashes = HashMultiset::Fingerprint();
+    for (uint64_t stmtHash : stmtHashes) {
+        subtreeStmtHashes += HashMultiset::fingerprintOf(stmtHash);
+    }
+    for (APINode* child : children) {
+        hash = llvm::hash_combine(hash, child->computeFingerprint());
+        subtreeStmtHashes += child->subtreeStmtHashes;
+    }
+    // 0 is reserved for "not computed"
+    fingerprint = static_cast<uint64_t>(hash) | 1;
+    return fingerprint;
+}
+
+uint64_t beta::APINode::shapeHash() const {
+    llvm::hash_code hash = llvm::hash_combine(kind, dataType, caonicalType, isInclined, isConstExpr,
+                                              access, storage, virtualQualifier, layout);
+    for (const APINode* child : children) {
+        hash = llvm::hash_combine(hash, relativeName(*this, *child), child->shapeHash());
+    }
+    return static_cast<uint64_t>(hash);
+}
+
+bool beta::APINode::sameShape(const APINode& other) const {
+    if (!sameFields(*this, other) || children.size() != other.children.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < children.size(); ++i) {
+        const APINode& child = *children[i];
+        const APINode& otherChild = *other.children[i];
+        if (relativeName(*this, child) != relativeName(other, otherChild) || !child.sameShape(otherChild)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -7,8 +7,11 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
-#include "fibonacci_hash.hpp"
+#include "source_hash_index.hpp"
+#include "conditional_block_index.hpp"
 #include "clang/Lex/Lexer.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/xxhash.h"
 #include <cassert>
 #include <algorithm>
 #include <cstddef>
@@ -21,9 +24,10 @@
 
 namespace beta{
 
-inline bool isLocationInMainFile(clang::SourceManager* SM, clang::SourceLocation Loc) {
+inline bool isLocationInOwnedFile(clang::SourceManager* SM, const ASTNormalizedContext* context,
+                                  clang::SourceLocation Loc) {
     if (!Loc.isValid()) return false;
-    return SM->isInMainFile(Loc);
+    return context->ownsLocation(*SM, Loc);
 }
 
 inline bool isBuiltinOrPredefinedMacro(clang::SourceManager* SM, const clang::MacroInfo* MI) {
@@ -63,26 +67,45 @@ inline bool isBuiltinOrPredefinedInclude(clang::SourceManager* SM, clang::Source
     return false;
 }
 
-ASTNormalizerPreprocessor::ASTNormalizerPreprocessor(clang::SourceManager* SM, ASTNormalizedContext* context) 
-: SM(SM), context(context) {}
+ASTNormalizerPreprocessor::ASTNormalizerPreprocessor(clang::SourceManager* SM, const clang::LangOptions& langOpts,
+                                                     ASTNormalizedContext* context)
+: SM(SM), langOpts(langOpts), context(context) {}
+
+void ASTNormalizerPreprocessor::FileChanged(clang::SourceLocation Loc, FileChangeReason Reason,
+                                            clang::SrcMgr::CharacteristicKind FileType, clang::FileID PrevFID) {
+    // Entering a file or returning to its includer: Loc is in the file lexed from now on
+    if (Reason == EnterFile || Reason == ExitFile) {
+        inOwnedFile = isLocationInOwnedFile(SM, context, Loc);
+    }
+}
+
+llvm::StringRef ASTNormalizerPreprocessor::mainBuffer() {
+    if (!buffer) {
+        buffer = SM->getBufferData(context->getOwnedFile(*SM));
+    }
+    return *buffer;
+}
 
 void ASTNormalizerPreprocessor::finalize(){
     
-    removeNestedRanges();
     beta::SourceRangeTracker& SRT = context->getSourceRangeTracker();
+    hashRanges();
     
-    llvm::StringRef buffer = SM->getBufferData(SM->getMainFileID());
-    
-    for(beta::Range& R : PPDirectives){
-        uint64_t hash = generateHashFromOffsets(R.startOffset, R.endOffset,R.isActive);
-        if(hash != 0) {
-            R.hash = hash;
+    // addRange folded nested ranges away as they arrived, so what is left is
+    // disjoint, in source order and hashed by hashRanges
+    for(const beta::Range& R : PPDirectives){
+        if(R.hash != 0) {
+            logRange(R);
             if(R.isActive) {
-                SRT.addUnhandledDeclHash(hash);
+                SRT.addUnhandledDeclHash(R.hash);
+                SRT.getRangeDigests().record(RangeDigests::Category::UnhandledDecls, R.hash, R.startOffset,
+                                             R.endOffset, SourceHashIndex::Normalization::Source);
             } 
             else {
-                inactiveUnhandledDeclsHash[hash]++;;
-                inactivePPDirectives[R.startOffset] = R;
+                SRT.getRangeDigests().record(RangeDigests::Category::InactiveUnhandledDecls, R.hash, R.startOffset,
+                                             R.endOffset, SourceHashIndex::Normalization::Whitespace);
+                inactiveUnhandledDeclsHash.insert(R.hash);
+                inactivePPDirectives.push_back(R);
             }
         }
     }
@@ -90,90 +113,144 @@ void ASTNormalizerPreprocessor::finalize(){
     SRT.moveInactivePPDirectives(inactivePPDirectives);
     SRT.moveInactiveUnhandledDeclsHashMap(inactiveUnhandledDeclsHash);
 
+    // The hashes the macro lines were counted under, unless merged into an
+    // enclosing range; hashed quietly, as they were logged above already
+    if (!macroDirectives.empty()) {
+        llvm::StringRef text = mainBuffer();
+        SourceHashIndex& index = SRT.getSourceHashIndex(text);
+        for (const auto& [startOffset, endOffset] : macroDirectives) {
+            if (startOffset < endOffset && endOffset <= text.size()) {
+                SRT.getMacros().addDirectiveHash(
+                    index.hash(startOffset, endOffset, SourceHashIndex::Normalization::Source));
+            }
+        }
+    }
+
 }
 
-uint64_t ASTNormalizerPreprocessor::generateHashFromOffsets(unsigned startOffset, unsigned endOffset, bool isActive) {
+void ASTNormalizerPreprocessor::hashRanges() {
+    // With the conditional block cache on, the branches an edit since the
+    // last parse of the file left alone take their hashes from that parse
+    ConditionalBlockCache& cache = ConditionalBlockCache::getInstance();
+    const clang::FileEntry* file = nullptr;
+    if (cache.isEnabled() && !PPDirectives.empty()) {
+        file = SM->getFileEntryForID(context->getOwnedFile(*SM));
+    }
+    if (file) {
+        blocks.reuseFrom(cache.find(file->getName()), mainBuffer());
+    }
+    for (size_t i = 0; i < PPDirectives.size(); ++i) {
+        beta::Range& R = PPDirectives[i];
+        std::optional<uint64_t> previous;
+        if (file) {
+            previous = blocks.previousHash(rangeBranches[i], R.startOffset, R.endOffset, R.isActive);
+        }
+        R.hash = previous ? *previous : hashOffsets(R.startOffset, R.endOffset, R.isActive);
+        if (file) {
+            blocks.record(rangeBranches[i], R.startOffset, R.endOffset, R.isActive, R.hash);
+        }
+    }
+    if (file) {
+        cache.store(file->getName(), blocks.takeSnapshot(mainBuffer()));
+        cache.count(blocks.getReusedBranches(), blocks.getHashedBranches());
+    }
+}
+
+llvm::StringRef ASTNormalizerPreprocessor::lastDirective() {
+    const beta::Range& R = PPDirectives.back();
+    return mainBuffer().slice(R.startOffset, R.endOffset);
+}
+
+uint64_t ASTNormalizerPreprocessor::hashMacroDefinition(const clang::MacroInfo& MI) {
+    // Parameters and replacement token spellings; the separators keep token
+    // boundaries, while the spacing between tokens does not change an expansion
+    llvm::SmallString<256> material;
+    if (MI.isFunctionLike()) {
+        material += '(';
+        for (const clang::IdentifierInfo* param : MI.params()) {
+            material += param->getName();
+            material += ',';
+        }
+        if (MI.isGNUVarargs()) {
+            material += "...";
+        }
+        material += ')';
+    }
+    llvm::SmallString<64> spellingBuffer;
+    for (const clang::Token& token : MI.tokens()) {
+        material += '\0';
+        material += clang::Lexer::getSpelling(token.getLocation(), spellingBuffer, *SM, langOpts);
+    }
+    return llvm::xxHash64(material);
+}
+
+uint64_t ASTNormalizerPreprocessor::hashOffsets(unsigned startOffset, unsigned endOffset, bool isActive) {
     if (startOffset >= endOffset) return -1;
     
-    llvm::StringRef buffer = SM->getBufferData(SM->getMainFileID());
+    llvm::StringRef text = mainBuffer();
     
-    if (endOffset > buffer.size()) return -1;
+    if (endOffset > text.size()) return -1;
     
-    llvm::StringRef sourceText = buffer.substr(startOffset, endOffset - startOffset);
-    uint64_t semanticHash = -1;
-    if(isActive){
-        semanticHash = FibonacciHash::hashFromOffsets(SM, startOffset, endOffset);
-    }
-    else{
-        semanticHash = FibonacciHash::hash(sourceText);
+    SourceHashIndex& index = context->getSourceRangeTracker().getSourceHashIndex(text);
+    return index.hash(startOffset, endOffset,
+                      isActive ? SourceHashIndex::Normalization::Source
+                               : SourceHashIndex::Normalization::Whitespace);
+}
+
+void ASTNormalizerPreprocessor::logRange(const beta::Range& R) {
+    // Ranges outside the file were never hashed
+    if (R.startOffset >= R.endOffset || R.endOffset > mainBuffer().size()) return;
+    if(!R.isActive) {
+        TEST_LOG << "(IN-ACTIVE)\n";
     }
-    if(!isActive) TEST_LOG << "(IN-ACTIVE)\n";
-    TEST_LOG << semanticHash << "\n";
-    TEST_LOG << sourceText << "\n----------------------------------------\n";
-    
-    return semanticHash;
+    TEST_LOG << R.hash << "\n";
+    TEST_LOG << mainBuffer().substr(R.startOffset, R.endOffset - R.startOffset) << "\n----------------------------------------\n";
 }
 
-void ASTNormalizerPreprocessor::addRange(clang::SourceRange range, bool active) {
-    if (!range.isValid()) return;
+bool ASTNormalizerPreprocessor::addRange(clang::SourceRange range, bool active, bool macroDirective) {
+    if (!range.isValid()) return false;
     unsigned startOffset = SM->getFileOffset(range.getBegin());
     
     // Get the actual end of the last token, not just its start location
-    clang::SourceLocation endLoc = clang::Lexer::getLocForEndOfToken(
-        range.getEnd(), 0, *SM, clang::LangOptions());
+    clang::SourceLocation endLoc = clang::Lexer::getLocForEndOfToken(range.getEnd(), 0, *SM, langOpts);
 
     unsigned endOffset = SM->getFileOffset(endLoc);
-    PPDirectives.emplace_back(beta::Range(startOffset, endOffset, -1, active));
-}
-
-void ASTNormalizerPreprocessor::removeNestedRanges() {
-    if (PPDirectives.size() <= 1) return;
-    
-    llvm::SmallVector<beta::Range, 16> filteredRanges;
-    
-    size_t size = PPDirectives.size();
-    unsigned refStartOffset = PPDirectives[size-1].startOffset;
-    unsigned refEndOffset = PPDirectives[size-1].endOffset;
-    bool refStatus = PPDirectives[size-1].isActive;
-
-    llvm::StringRef buffer = SM->getBufferData(SM->getMainFileID());
+    if (macroDirective) {
+        macroDirectives.emplace_back(startOffset, endOffset);
+    }
 
-    for (int idx = size - 2; idx >= 0; --idx) {
-        unsigned currentStart = PPDirectives[idx].startOffset;
-        unsigned currentEnd = PPDirectives[idx].endOffset;
-        bool currentStatus = PPDirectives[idx].isActive;
-    
-        if (refStartOffset <= currentStart && currentEnd <= refEndOffset) {
-            continue;
-        }
-        else if (currentStart < refStartOffset && (currentEnd <= refStartOffset || refStartOffset < currentEnd)) {
-            filteredRanges.emplace_back(beta::Range(refStartOffset, refEndOffset,-1,refStatus));
-            refStatus = currentStatus;
-            refStartOffset = currentStart;
-            refEndOffset = currentEnd;
-        }
-        else {
-            armor::user_error()<<"Out of order PPDirective ranges detected\n";
-            armor::user_error()<<"["<<currentStart<<","<<currentEnd<<"]"<<"\n";
-            armor::user_error()<<"["<<refStartOffset<<","<<refEndOffset<<"]"<<"\n";
-            // physically never possible
-            assert(false && "Out of order ranges detected");
-        }
+    // Directives arrive in source order, except that a skipped block is
+    // reported after the #if, #else and #endif lines it spans: fold away the
+    // ranges the new one encloses
+    while (!PPDirectives.empty() && startOffset <= PPDirectives.back().startOffset &&
+           PPDirectives.back().endOffset <= endOffset) {
+        PPDirectives.pop_back();
+        rangeBranches.pop_back();
     }
-    
-    filteredRanges.emplace_back(
-        beta::Range(
-            refStartOffset, 
-            refEndOffset ,
-            -1,
-            refStatus
-        )
-    );
-    
-    std::reverse(filteredRanges.begin(), filteredRanges.end());
+    if (!PPDirectives.empty() && startOffset <= PPDirectives.back().startOffset) {
+        armor::user_error()<<"Out of order PPDirective ranges detected\n";
+        armor::user_error()<<"["<<startOffset<<","<<endOffset<<"]"<<"\n";
+        armor::user_error()<<"["<<PPDirectives.back().startOffset<<","<<PPDirectives.back().endOffset<<"]"<<"\n";
+        // physically never possible
+        assert(false && "Out of order ranges detected");
+    }
+    // Hashed by finalize, which can take the hashes of unchanged conditional branches from the last parse
+    PPDirectives.emplace_back(beta::Range(startOffset, endOffset, 0, active));
+    rangeBranches.push_back(blocks.currentBranch());
+    return true;
+}
 
-    PPDirectives = std::move(filteredRanges);
+void ASTNormalizerPreprocessor::addElse(clang::SourceRange range) {
+    if (addRange(range)) {
+        blocks.nextBranch(lastDirective(), PPDirectives.back().startOffset, PPDirectives.back().endOffset);
+        rangeBranches.back() = blocks.currentBranch();
+    }
+}
 
+void ASTNormalizerPreprocessor::addEndif(clang::SourceRange range) {
+    if (addRange(range)) {
+        blocks.closeConditional(PPDirectives.back().endOffset);
+    }
 }
 
 void ASTNormalizerPreprocessor::InclusionDirective(
@@ -188,23 +265,23 @@ void ASTNormalizerPreprocessor::InclusionDirective(
     const clang::Module *Imported, 
     clang::SrcMgr::CharacteristicKind FileType){
     
-    if (!isLocationInMainFile(SM, HashLoc)) return;
+    if (!inOwnedFile) return;
 
     if (isBuiltinOrPredefinedInclude(SM, HashLoc)) return;
 
     if(!File){ 
-        armor::debug() << "Failed include - RelativePath: " << RelativePath;
+        ARMOR_DEBUG_LOG << "Failed include - RelativePath: " << RelativePath;
         
         if (HashLoc.isValid()) {
             clang::PresumedLoc PLoc = SM->getPresumedLoc(HashLoc);
             if (PLoc.isValid()) {
-                armor::debug() << " at " << PLoc.getFilename();
+                ARMOR_DEBUG_LOG << " at " << PLoc.getFilename();
             } else {
-                armor::debug() << " at hash: " << HashLoc.getHashValue();
+                ARMOR_DEBUG_LOG << " at hash: " << HashLoc.getHashValue();
             }
         }
         
-        armor::debug() << "\n";
+        ARMOR_DEBUG_LOG << "\n";
     } 
     else {
         clang::SourceRange Range(HashLoc, FilenameRange.getEnd());
@@ -215,13 +292,13 @@ void ASTNormalizerPreprocessor::InclusionDirective(
 }
 
 void ASTNormalizerPreprocessor::MacroDefined(const clang::Token &MacroNameTok, const clang::MacroDirective *MD) {
+    if (!inOwnedFile) return;
+
     if (!MD) return;
     
     const clang::MacroInfo *MI = MD->getMacroInfo();
     if (!MI) return;
     
-    if (!isLocationInMainFile(SM, MI->getDefinitionLoc())) return;
-    
     if (isBuiltinOrPredefinedMacro(SM, MI)) return;
     
     clang::SourceLocation DefLoc = MI->getDefinitionLoc();
@@ -235,12 +312,16 @@ void ASTNormalizerPreprocessor::MacroDefined(const clang::Token &MacroNameTok, c
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        addRange(Range, true, true);
+    }
+
+    if (const clang::IdentifierInfo* name = MacroNameTok.getIdentifierInfo()) {
+        context->getSourceRangeTracker().getMacros().define(name->getName(), hashMacroDefinition(*MI));
     }
 }
 
 void ASTNormalizerPreprocessor::MacroUndefined(const clang::Token &MacroNameTok, const clang::MacroDefinition &MD, const clang::MacroDirective *Undef) {
-    if (!isLocationInMainFile(SM, MacroNameTok.getLocation())) return;
+    if (!inOwnedFile) return;
     
     const clang::MacroInfo *MI = MD.getMacroInfo();
     
@@ -257,12 +338,16 @@ void ASTNormalizerPreprocessor::MacroUndefined(const clang::Token &MacroNameTok,
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        addRange(Range, true, true);
+    }
+
+    if (const clang::IdentifierInfo* name = MacroNameTok.getIdentifierInfo()) {
+        context->getSourceRangeTracker().getMacros().undefine(name->getName());
     }
 }
 
 void ASTNormalizerPreprocessor::If(clang::SourceLocation Loc, clang::SourceRange ConditionRange, clang::PPCallbacks::ConditionValueKind ConditionValue) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid() || !ConditionRange.isValid()) return;
     
@@ -274,12 +359,15 @@ void ASTNormalizerPreprocessor::If(clang::SourceLocation Loc, clang::SourceRange
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        if (addRange(Range)) {
+            blocks.openConditional(lastDirective(), PPDirectives.back().startOffset);
+            rangeBranches.back() = blocks.currentBranch();
+        }
     }
 }
 
 void ASTNormalizerPreprocessor::Elif(clang::SourceLocation Loc, clang::SourceRange ConditionRange, clang::PPCallbacks::ConditionValueKind ConditionValue, clang::SourceLocation IfLoc) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid() || !ConditionRange.isValid()) return;
     
@@ -291,12 +379,15 @@ void ASTNormalizerPreprocessor::Elif(clang::SourceLocation Loc, clang::SourceRan
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        if (addRange(Range)) {
+            blocks.nextBranch(lastDirective(), PPDirectives.back().startOffset, PPDirectives.back().endOffset);
+            rangeBranches.back() = blocks.currentBranch();
+        }
     }
 }
 
 void ASTNormalizerPreprocessor::Ifdef(clang::SourceLocation Loc, const clang::Token &MacroNameTok, const clang::MacroDefinition &MD) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid() || !MacroNameTok.getLocation().isValid()) return;
     
@@ -308,12 +399,15 @@ void ASTNormalizerPreprocessor::Ifdef(clang::SourceLocation Loc, const clang::To
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        if (addRange(Range)) {
+            blocks.openConditional(lastDirective(), PPDirectives.back().startOffset);
+            rangeBranches.back() = blocks.currentBranch();
+        }
     }
 }
 
 void ASTNormalizerPreprocessor::Elifdef(clang::SourceLocation Loc, clang::SourceRange ConditionRange, clang::SourceLocation IfLoc) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid() || !ConditionRange.isValid()) return;
     
@@ -325,12 +419,15 @@ void ASTNormalizerPreprocessor::Elifdef(clang::SourceLocation Loc, clang::Source
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        if (addRange(Range)) {
+            blocks.nextBranch(lastDirective(), PPDirectives.back().startOffset, PPDirectives.back().endOffset);
+            rangeBranches.back() = blocks.currentBranch();
+        }
     }
 }
 
 void ASTNormalizerPreprocessor::Ifndef(clang::SourceLocation Loc, const clang::Token &MacroNameTok, const clang::MacroDefinition &MD) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid() || !MacroNameTok.getLocation().isValid()) return;
 
@@ -342,12 +439,15 @@ void ASTNormalizerPreprocessor::Ifndef(clang::SourceLocation Loc, const clang::T
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        if (addRange(Range)) {
+            blocks.openConditional(lastDirective(), PPDirectives.back().startOffset);
+            rangeBranches.back() = blocks.currentBranch();
+        }
     }
 }
 
 void ASTNormalizerPreprocessor::Elifndef(clang::SourceLocation Loc, clang::SourceRange ConditionRange, clang::SourceLocation IfLoc) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid() || !ConditionRange.isValid()) return;
     
@@ -359,12 +459,15 @@ void ASTNormalizerPreprocessor::Elifndef(clang::SourceLocation Loc, clang::Sourc
     
     if (LineStart.isValid() && End.isValid()) {
         clang::SourceRange Range(LineStart, End);
-        addRange(Range);
+        if (addRange(Range)) {
+            blocks.nextBranch(lastDirective(), PPDirectives.back().startOffset, PPDirectives.back().endOffset);
+            rangeBranches.back() = blocks.currentBranch();
+        }
     }
 }
 
 void ASTNormalizerPreprocessor::Else(clang::SourceLocation Loc, clang::SourceLocation IfLoc) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid()) return;
 
@@ -373,21 +476,21 @@ void ASTNormalizerPreprocessor::Else(clang::SourceLocation Loc, clang::SourceLoc
     clang::SourceLocation LineStart = SM->translateLineCol(FID, LineNo, 1);
     
     clang::Token Token;
-    if (clang::Lexer::getRawToken(Loc, Token, *SM, clang::LangOptions())) {
+    if (clang::Lexer::getRawToken(Loc, Token, *SM, langOpts)) {
         clang::SourceRange Range(LineStart, Loc.getLocWithOffset(3));
-        addRange(Range);
+        addElse(Range);
         return;
     }
 
     clang::SourceLocation TokenEnd = Token.getEndLoc();
     if (LineStart.isValid() && TokenEnd.isValid()) {
         clang::SourceRange Range(LineStart, TokenEnd);
-        addRange(Range);
+        addElse(Range);
     }
 }
 
 void ASTNormalizerPreprocessor::Endif(clang::SourceLocation Loc, clang::SourceLocation IfLoc) {
-    if (!isLocationInMainFile(SM, Loc)) return;
+    if (!inOwnedFile) return;
     
     if (!Loc.isValid()) return;
 
@@ -396,21 +499,21 @@ void ASTNormalizerPreprocessor::Endif(clang::SourceLocation Loc, clang::SourceLo
     clang::SourceLocation LineStart = SM->translateLineCol(FID, LineNo, 1);
     
     clang::Token Token;
-    if (clang::Lexer::getRawToken(Loc, Token, *SM, clang::LangOptions())) {
+    if (clang::Lexer::getRawToken(Loc, Token, *SM, langOpts)) {
         clang::SourceRange Range(LineStart, Loc.getLocWithOffset(5));
-        addRange(Range);
+        addEndif(Range);
         return;
     }
 
     clang::SourceLocation TokenEnd = Token.getEndLoc();
     if (LineStart.isValid() && TokenEnd.isValid()) {
         clang::SourceRange Range(LineStart, TokenEnd);
-        addRange(Range);
+        addEndif(Range);
     }
 }
 
 void ASTNormalizerPreprocessor::SourceRangeSkipped(clang::SourceRange Range, clang::SourceLocation EndifLoc) {
-    if (!isLocationInMainFile(SM, Range.getBegin())) return;
+    if (!inOwnedFile) return;
     
     clang::SourceLocation StartLoc = Range.getBegin();
     
@@ -422,7 +525,10 @@ void ASTNormalizerPreprocessor::SourceRangeSkipped(clang::SourceRange Range, cla
     
     if (LineStart.isValid() && Range.getEnd().isValid()) {
         clang::SourceRange FullRange(LineStart, Range.getEnd());
-        addRange(FullRange, false);
+        // Reported after the directive ending the skipped branch
+        if (addRange(FullRange, false)) {
+            rangeBranches.back() = blocks.lastClosedBranch();
+        }
     }
 
 }
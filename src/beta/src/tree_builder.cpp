@@ -10,19 +10,28 @@
 #include "iostream"
 #include "node.hpp"
 #include "fibonacci_hash.hpp"
+#include "source_hash_index.hpp"
+#include "decl_subtree_cache.hpp"
+#include "diffengine.hpp"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclBase.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/AST/ODRHash.h"
+#include "clang/AST/RecordLayout.h"
+#include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/Stmt.h"
 #include "clang/AST/Expr.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Lex/Lexer.h"
 #include "type_utils.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <llvm-14/llvm/ADT/DenseSet.h>
+#include <llvm-14/llvm/ADT/Hashing.h>
 #include <llvm-14/llvm/ADT/SmallString.h>
 #include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/ADT/StringRef.h>
@@ -30,6 +39,7 @@
 #include <llvm-14/llvm/Support/Casting.h>
 #include <llvm-14/llvm/Support/raw_ostream.h>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -39,7 +49,8 @@ beta::TreeBuilder::TreeBuilder(beta::ASTNormalizedContext* context): context(con
 
 inline bool beta::TreeBuilder::IsDeclFromMainFileAndNotLocal(const clang::Decl* Decl) {
     clang::ASTContext* clangContext = &Decl->getASTContext();
-    return clangContext->getSourceManager().isInMainFile(Decl->getLocation()) && Decl->getParentFunctionOrMethod() == nullptr;
+    return context->ownsLocation(clangContext->getSourceManager(), Decl->getLocation()) &&
+           Decl->getParentFunctionOrMethod() == nullptr;
 }
 
 inline bool beta::TreeBuilder::IsStmtFromMainFile(const clang::Stmt* Stmt) {
@@ -48,87 +59,94 @@ inline bool beta::TreeBuilder::IsStmtFromMainFile(const clang::Stmt* Stmt) {
     clang::SourceManager& SM = context->getClangASTContext()->getSourceManager();
     clang::SourceLocation StartLoc = Stmt->getBeginLoc();
     
-    return StartLoc.isValid() && SM.isInMainFile(StartLoc);
+    return StartLoc.isValid() && context->ownsLocation(SM, StartLoc);
 }
 
-inline bool beta::TreeBuilder::isInNameSpaceOrClass(const clang::Decl* Decl){
-
-    const clang::DeclContext* DC = Decl->getDeclContext();
-
-    while(DC && !DC->isTranslationUnit()){
-
-        if(const clang::CXXRecordDecl* RD = 
-            llvm::dyn_cast_or_null<clang::CXXRecordDecl>(DC); RD && RD->isClass()){
-            return true;
-        }
-        
-        if(llvm::isa<clang::ClassTemplateSpecializationDecl>(DC)){
-            return true;
-        }
+uint8_t beta::TreeBuilder::classifyScope(const clang::DeclContext* DC) {
+    if (!DC || DC->isTranslationUnit()) return 0;
 
-        if(llvm::isa<clang::NamespaceDecl>(DC)){
-            return true;
-        }
+    auto cached = scopeClasses.find(DC);
+    if (cached != scopeClasses.end()) return cached->second;
 
-        DC = DC->getParent();
+    uint8_t classes = 0;
+    if (llvm::isa<clang::ClassTemplateSpecializationDecl>(DC) || llvm::isa<clang::NamespaceDecl>(DC)) {
+        classes = SCOPE_CLASS_OR_NAMESPACE | SCOPE_WRITTEN_IN_CLASS_OR_NAMESPACE;
     }
+    else if (const clang::CXXRecordDecl* RD = llvm::dyn_cast<clang::CXXRecordDecl>(DC)) {
+        if (RD->isClass()) classes |= SCOPE_CLASS_OR_NAMESPACE | SCOPE_WRITTEN_IN_CLASS_OR_NAMESPACE;
+        if (RD->isTemplated()) classes |= SCOPE_WRITTEN_IN_CLASS_OR_NAMESPACE;
+    }
+    // The enclosing scopes count as well; inserted after them, as they grow the map
+    classes |= classifyScope(DC->getParent());
+    scopeClasses[DC] = classes;
+    return classes;
+}
 
-    return false;
-
+inline bool beta::TreeBuilder::isInNameSpaceOrClass(const clang::Decl* Decl){
+    return classifyScope(Decl->getDeclContext()) & SCOPE_CLASS_OR_NAMESPACE;
 }
 
 inline bool beta::TreeBuilder::isWrittenInClassOrNamespace(const clang::Decl* D) {
-    
     if (!D) return false;
-    
-    const clang::DeclContext* LexicalDC = D->getLexicalDeclContext();
-    
-    while (LexicalDC && !LexicalDC->isTranslationUnit()) {
-        
-        if (const clang::CXXRecordDecl* RD = 
-            llvm::dyn_cast<clang::CXXRecordDecl>(LexicalDC); RD && (RD->isClass() || RD->isTemplated())) {
-            return true;
-        }
-        
-        if (llvm::isa<clang::ClassTemplateSpecializationDecl>(LexicalDC)) {
-            return true;
-        }
-        
-        if (llvm::isa<clang::NamespaceDecl>(LexicalDC)) {
-            return true;
-        }
-        
-        LexicalDC = LexicalDC->getParent();
+    return classifyScope(D->getLexicalDeclContext()) & SCOPE_WRITTEN_IN_CLASS_OR_NAMESPACE;
+}
+
+template <typename Language>
+inline bool beta::TreeBuilder::isInNameSpaceOrClassOrTemplated(const clang::Decl* Decl) {
+    if constexpr (Language::CPlusPlus) {
+        return isInNameSpaceOrClass(Decl) || Decl->isTemplated();
     }
-    
-    return false;
+    else {
+        return false;
+    }
+}
 
+uint64_t beta::TreeBuilder::hashMainFileRange(clang::SourceManager& SM, clang::SourceRange Range) {
+    unsigned startOffset = 0;
+    unsigned endOffset = 0;
+    if (!FibonacciHash::offsetsFromSourceRange(&SM, Range, startOffset, endOffset)) return 0;
+
+    SourceHashIndex& index = context->getSourceRangeTracker().getSourceHashIndex(SM.getBufferData(context->getOwnedFile(SM)));
+    return index.hash(startOffset, endOffset, SourceHashIndex::Normalization::Source);
+}
+
+uint64_t beta::TreeBuilder::hashUnhandledRange(clang::SourceManager& SM, clang::SourceRange Range) {
+    unsigned startOffset = 0;
+    unsigned endOffset = 0;
+    if (!FibonacciHash::offsetsFromSourceRange(&SM, Range, startOffset, endOffset)) return 0;
+
+    beta::SourceRangeTracker& SRT = context->getSourceRangeTracker();
+    SourceHashIndex& index = SRT.getSourceHashIndex(SM.getBufferData(context->getOwnedFile(SM)));
+    uint64_t semanticHash = index.hash(startOffset, endOffset, SourceHashIndex::Normalization::Source);
+    SRT.getRangeDigests().record(RangeDigests::Category::UnhandledDecls, semanticHash, startOffset, endOffset,
+                                 SourceHashIndex::Normalization::Source);
+    return semanticHash;
 }
 
 uint64_t beta::TreeBuilder::generateSemanticHashFromDecl(const clang::Decl* Decl) {
     clang::SourceManager& SM = Decl->getASTContext().getSourceManager();
     clang::SourceLocation StartLoc = Decl->getBeginLoc();
     clang::SourceLocation EndLoc = Decl->getEndLoc();
-    
-    llvm::StringRef sourceText;
-    
-    llvm::SmallString<128> nameBuf;
-    llvm::raw_svector_ostream OS(nameBuf);
-    
-    if(llvm::isa<clang::NamedDecl>(Decl)){
-        llvm::dyn_cast<clang::NamedDecl>(Decl)->printName(OS);
-        armor::debug()<< "Excluding : " << nameBuf << "\n";
-    }
-    else{
-        armor::debug() << "Excluding : " << Decl->getDeclKindName() << "\n";
+
+    // The name is printed for the debug log alone, and compiled out with it
+    if (DebugConfig::getInstance().isEnabled(DebugConfig::Level::DEBUG)) {
+        llvm::SmallString<128> nameBuf;
+        llvm::raw_svector_ostream OS(nameBuf);
+        if(llvm::isa<clang::NamedDecl>(Decl)){
+            llvm::dyn_cast<clang::NamedDecl>(Decl)->printName(OS);
+            ARMOR_DEBUG_LOG << "Excluding : " << nameBuf << "\n";
+        }
+        else{
+            ARMOR_DEBUG_LOG << "Excluding : " << Decl->getDeclKindName() << "\n";
+        }
     }
 
     if (StartLoc.isValid() && EndLoc.isValid()) {
-        clang::CharSourceRange Range = clang::CharSourceRange::getTokenRange(StartLoc, EndLoc);
-        sourceText = clang::Lexer::getSourceText(Range, SM, Decl->getASTContext().getLangOpts());
-        uint64_t semanticHash = FibonacciHash::hashFromSourceRange(&SM,clang::SourceRange(StartLoc, EndLoc));
+        uint64_t semanticHash = hashUnhandledRange(SM, clang::SourceRange(StartLoc, EndLoc));
         TEST_LOG << semanticHash << "\n";
-        TEST_LOG << sourceText << "\n----------------------------------------\n";
+        TEST_LOG << clang::Lexer::getSourceText(clang::CharSourceRange::getTokenRange(StartLoc, EndLoc), SM,
+                                                Decl->getASTContext().getLangOpts())
+                 << "\n----------------------------------------\n";
         return semanticHash;
     }
 
@@ -141,15 +159,13 @@ uint64_t beta::TreeBuilder::generateSemanticHashFromStmt(const clang::Stmt* Stmt
     clang::SourceManager& SM = context->getClangASTContext()->getSourceManager();
     clang::SourceLocation StartLoc = Stmt->getBeginLoc();
     clang::SourceLocation EndLoc = Stmt->getEndLoc();
-    
-    llvm::StringRef sourceText;
-    
+
     if (StartLoc.isValid() && EndLoc.isValid()) {
-        clang::CharSourceRange Range = clang::CharSourceRange::getTokenRange(StartLoc, EndLoc);
-        sourceText = clang::Lexer::getSourceText(Range, SM, context->getClangASTContext()->getLangOpts());
-        uint64_t semanticHash = FibonacciHash::hashFromSourceRange(&SM, clang::SourceRange(StartLoc, EndLoc));
+        uint64_t semanticHash = hashUnhandledRange(SM, clang::SourceRange(StartLoc, EndLoc));
         TEST_LOG << semanticHash << "\n";
-        TEST_LOG << sourceText << "\n----------------------------------------\n";
+        TEST_LOG << clang::Lexer::getSourceText(clang::CharSourceRange::getTokenRange(StartLoc, EndLoc), SM,
+                                                context->getClangASTContext()->getLangOpts())
+                 << "\n----------------------------------------\n";
         return semanticHash;
     }
 
@@ -159,36 +175,309 @@ uint64_t beta::TreeBuilder::generateSemanticHashFromStmt(const clang::Stmt* Stmt
 void beta::TreeBuilder::processUnhandledDecl(const clang::Decl* Decl) {
     uint64_t hash = generateSemanticHashFromDecl(Decl);
     context->getSourceRangeTracker().addUnhandledDeclHash(hash);
+    if (capture) capture->hashes.push_back(hash);
 }
 
-void beta::TreeBuilder::processUnhandledStmt(const clang::Stmt* Stmt, const std::shared_ptr<beta::APINode>& node) {
+void beta::TreeBuilder::processUnhandledStmt(const clang::Stmt* Stmt, beta::APINode* node) {
     uint64_t hash = generateSemanticHashFromStmt(Stmt);
     context->getSourceRangeTracker().addUnhandledDeclHash(hash);
+    if (capture) capture->hashes.push_back(hash);
     node->stmtHashes.emplace_back(hash);
 }
 
-inline void beta::TreeBuilder::AddNode(const std::shared_ptr<APINode>& node) {
+beta::APINode* beta::TreeBuilder::FindNodeByUSR(llvm::StringRef USR) {
+    const auto it = context->usrNodeMap.find(USR);
+    if (it == context->usrNodeMap.end()) {
+        if (capture) capture->missedUSRs.push_back(USR);
+        return nullptr;
+    }
+    // The declaration extends a node built before it, so what it builds is not its own
+    if (capture) capture->reused = true;
+    return it->second;
+}
+
+beta::APINode* beta::TreeBuilder::FindNodeByDecl(const clang::Decl* Decl) {
+    const clang::Decl* canonical = Decl->getCanonicalDecl();
+    const auto it = declNodes.find(canonical);
+    if (it == declNodes.end()) {
+        if (capture) capture->missedDecls.push_back(canonical);
+        return nullptr;
+    }
+    if (capture) capture->reused = true;
+    return it->second;
+}
+
+void beta::TreeBuilder::RegisterDecl(const clang::Decl* Decl, beta::APINode* node) {
+    const clang::Decl* canonical = Decl->getCanonicalDecl();
+    declNodes[canonical] = node;
+    if (capture) capture->decls.emplace_back(canonical, node);
+}
+
+void beta::TreeBuilder::RegisterUSR(llvm::StringRef USR, beta::APINode* node) {
+    bool inserted = context->usrNodeMap.insert_or_assign(USR, node).second;
+    if (capture) {
+        capture->reused = capture->reused || !inserted;
+        capture->usrs.emplace_back(USR, node);
+    }
+}
+
+void beta::TreeBuilder::SetDeclCacheScope(uint64_t scope) {
+    declCacheScope = scope;
+}
+
+namespace {
+
+    /**
+     * Digest of the names a declaration declares and the types it spells,
+     * with the flags of its nodes that macros can change. Statements are
+     * skipped: the nodes keep only their source hashes.
+     */
+    class DeclDigestVisitor : public clang::RecursiveASTVisitor<DeclDigestVisitor> {
+        public:
+            bool TraverseStmt(clang::Stmt*, DataRecursionQueue* = nullptr) { return true; }
+
+            bool VisitDecl(clang::Decl* Decl) {
+                flags = llvm::hash_combine(flags, Decl->getKind(), Decl->getAccessUnsafe());
+                return true;
+            }
+
+            bool VisitNamedDecl(clang::NamedDecl* Decl) {
+                types.AddDeclarationName(Decl->getDeclName());
+                return true;
+            }
+
+            bool VisitValueDecl(clang::ValueDecl* Decl) {
+                types.AddQualType(Decl->getType());
+                return true;
+            }
+
+            bool VisitTypedefNameDecl(clang::TypedefNameDecl* Decl) {
+                types.AddQualType(Decl->getUnderlyingType());
+                return true;
+            }
+
+            bool VisitEnumDecl(clang::EnumDecl* Decl) {
+                types.AddQualType(Decl->getIntegerType());
+                return true;
+            }
+
+            bool VisitFunctionDecl(clang::FunctionDecl* Decl) {
+                flags = llvm::hash_combine(flags, Decl->getStorageClass(), Decl->isInlined());
+                return true;
+            }
+
+            bool VisitCXXMethodDecl(clang::CXXMethodDecl* Decl) {
+                flags = llvm::hash_combine(flags, Decl->isVirtual(), Decl->isPure());
+                return true;
+            }
+
+            bool VisitVarDecl(clang::VarDecl* Decl) {
+                flags = llvm::hash_combine(flags, Decl->getStorageClass(), Decl->isInlineSpecified(), Decl->isConstexpr());
+                return true;
+            }
+
+            bool VisitFieldDecl(clang::FieldDecl* Decl) {
+                if (Decl->isBitField() && !Decl->getBitWidth()->isValueDependent()) {
+                    flags = llvm::hash_combine(flags, Decl->getBitWidthValue(Decl->getASTContext()));
+                }
+                return true;
+            }
+
+            bool VisitCXXRecordDecl(clang::CXXRecordDecl* Decl) {
+                if (Decl->hasDefinition()) {
+                    for (const clang::CXXBaseSpecifier& base : Decl->bases()) {
+                        types.AddQualType(base.getType());
+                    }
+                }
+                return true;
+            }
+
+            uint64_t digest() {
+                return llvm::hash_combine(flags, types.CalculateHash());
+            }
+
+        private:
+            clang::ODRHash types;
+            llvm::hash_code flags = llvm::hash_code(0);
+    };
+
+}
+
+uint64_t beta::TreeBuilder::generateDigestFromDecl(clang::Decl* Decl) {
+    DeclDigestVisitor visitor;
+    visitor.TraverseDecl(Decl);
+    return llvm::hash_combine(declCacheScope, visitor.digest());
+}
+
+bool beta::TreeBuilder::isCacheableTopLevelDecl(const clang::Decl* Decl) {
+    if (!Decl || llvm::isa<clang::LinkageSpecDecl>(Decl)) return false;
+    const clang::DeclContext* lexicalContext = Decl->getLexicalDeclContext();
+    if (!lexicalContext || !lexicalContext->getRedeclContext()->isTranslationUnit()) return false;
+    // An unnamed tag is named after the declaration following it, outside its source range
+    if (const auto* tag = llvm::dyn_cast<clang::TagDecl>(Decl)) {
+        if (!tag->getIdentifier()) return false;
+    }
+    return IsDeclFromMainFileAndNotLocal(Decl);
+}
+
+bool beta::TreeBuilder::BuildTopLevelDecl(clang::Decl* Decl, llvm::function_ref<bool()> build) {
+    DeclSubtreeCache& cache = DeclSubtreeCache::getInstance();
+    if (!cache.isEnabled() || capture || !nodeStack.empty() || !isCacheableTopLevelDecl(Decl)) {
+        return build();
+    }
+
+    clang::SourceManager& SM = Decl->getASTContext().getSourceManager();
+    DeclSubtreeCache::Key key;
+    key.sourceHash = hashMainFileRange(SM, Decl->getSourceRange());
+    if (key.sourceHash == 0) {
+        return build();
+    }
+    key.digest = generateDigestFromDecl(Decl);
+    unsigned beginLine = SM.getExpansionLineNumber(Decl->getBeginLoc());
+
+    if (std::shared_ptr<const DeclSubtreeCache::Entry> entry = cache.find(key)) {
+        // A redeclaration extends the nodes built for an earlier one, which a copy cannot
+        bool redeclared = std::any_of(entry->usrs.begin(), entry->usrs.end(), [&](const auto& usr) {
+            return context->usrNodeMap.count(usr.first) != 0;
+        });
+        if (!redeclared) {
+            DeclSubtreeCache::replay(*entry, beginLine, *context);
+            return entry->result;
+        }
+    }
+
+    Capture captured;
+    size_t rootsBefore = context->getRootNodes().size();
+    capture = &captured;
+    bool result = build();
+    capture = nullptr;
+
+    size_t rootsAdded = context->getRootNodes().size() - rootsBefore;
+    if (captured.reused || rootsAdded > 1 || (rootsAdded == 0 && !captured.usrs.empty())) {
+        return result;
+    }
+    const APINode* root = rootsAdded == 1 ? context->getRootNodes().back() : nullptr;
+    if (std::shared_ptr<DeclSubtreeCache::Entry> entry = DeclSubtreeCache::record(root, captured.usrs)) {
+        entry->result = result;
+        entry->unhandledHashes = std::move(captured.hashes);
+        entry->beginLine = beginLine;
+        cache.store(key, std::move(entry));
+    }
+    return result;
+}
+
+void beta::TreeBuilder::SpeculateTopLevelDecl(Speculation& speculation, llvm::function_ref<bool()> build) {
+    size_t rootsBefore = context->getRootNodes().size();
+    capture = &speculation.captured;
+    speculation.result = build();
+    capture = nullptr;
+
+    const auto& roots = context->getRootNodes();
+    speculation.roots.assign(roots.begin() + rootsBefore, roots.end());
+    // A node registered outside the roots belongs to a declaration before, which a copy cannot extend
+    llvm::DenseSet<const APINode*> built;
+    llvm::SmallVector<const APINode*, 32> pending(speculation.roots.begin(), speculation.roots.end());
+    while (!pending.empty()) {
+        const APINode* node = pending.pop_back_val();
+        built.insert(node);
+        pending.append(node->children.begin(), node->children.end());
+    }
+    const Capture& captured = speculation.captured;
+    speculation.selfContained =
+        std::all_of(captured.usrs.begin(), captured.usrs.end(), [&](const auto& usr) { return built.count(usr.second); }) &&
+        std::all_of(captured.decls.begin(), captured.decls.end(), [&](const auto& decl) { return built.count(decl.second); });
+}
+
+bool beta::TreeBuilder::AdoptTopLevelDecl(const Speculation& speculation) {
+    const Capture& captured = speculation.captured;
+    if (captured.reused || !speculation.selfContained || capture || !nodeStack.empty()) {
+        return false;
+    }
+    // What the speculating context lacked must be missing here too
+    auto inTree = [this](llvm::StringRef usr) { return context->usrNodeMap.count(usr) != 0; };
+    auto declared = [this](const clang::Decl* decl) { return declNodes.count(decl) != 0; };
+    if (std::any_of(captured.missedUSRs.begin(), captured.missedUSRs.end(), inTree) ||
+        std::any_of(captured.usrs.begin(), captured.usrs.end(), [&](const auto& usr) { return inTree(usr.first); }) ||
+        std::any_of(captured.missedDecls.begin(), captured.missedDecls.end(), declared) ||
+        std::any_of(captured.decls.begin(), captured.decls.end(), [&](const auto& decl) { return declared(decl.first); })) {
+        return false;
+    }
+
+    llvm::DenseMap<const APINode*, APINode*> copies;
+    DeclSubtreeCache::transplant(speculation.roots, captured.usrs, captured.hashes, 0, *context, copies);
+    for (const auto& [decl, node] : captured.decls) {
+        declNodes[decl] = copies[node];
+    }
+    return true;
+}
+
+std::unique_lock<std::mutex> beta::TreeBuilder::LockAST() {
+    std::mutex* mutex = context->getASTMutex();
+    return mutex ? std::unique_lock<std::mutex>(*mutex) : std::unique_lock<std::mutex>();
+}
+
+inline void beta::TreeBuilder::AddNode(APINode* node) {
     
     assert(!node->NSR.empty());
     
     if (!nodeStack.empty()) {
-        if (nodeStack.back()->children == nullptr) {
-            nodeStack.back()->children = std::make_unique<llvm::SmallVector<std::shared_ptr<const APINode>, 16>>();
-        }
-        nodeStack.back()->children->push_back(node);
+        context->addChild(*nodeStack.back(), node);
     }
     else context->addRootNode(node);
     
     if (nodeStack.empty()) context->addNode(node->NSR, node);
 }
 
-inline void beta::TreeBuilder::PushNode(const std::shared_ptr<APINode>& node) {
+void beta::TreeBuilder::RecordLines(APINode* node, const clang::Decl* Decl) {
+    const clang::SourceManager& SM = Decl->getASTContext().getSourceManager();
+    clang::SourceRange range = Decl->getSourceRange();
+    if (range.isInvalid()) return;
+
+    // The SourceManager remembers the last line looked up
+    std::unique_lock<std::mutex> lock = LockAST();
+    unsigned beginLine = SM.getExpansionLineNumber(range.getBegin());
+    unsigned endLine = SM.getExpansionLineNumber(SM.getExpansionRange(range.getEnd()).getEnd());
+    if (beginLine == 0 || endLine < beginLine) return;
+
+    // A node reopened by a redeclaration spans all of its declarations
+    if (node->beginLine == 0 || beginLine < node->beginLine) node->beginLine = beginLine;
+    if (endLine > node->endLine) node->endLine = endLine;
+}
+
+void beta::TreeBuilder::RecordLayout(APINode* node, const clang::RecordDecl* Decl) {
+    if (!isRecordLayoutEnabled()) return;
+    // Only a complete record of known types has a layout; a forward declaration
+    // lays out its definition, which clang computes once
+    const clang::RecordDecl* definition = Decl->getDefinition();
+    if (!definition || definition->isInvalidDecl() || definition->isDependentType()) return;
+
+    // Layouts are computed once and kept by the ASTContext
+    std::unique_lock<std::mutex> lock = LockAST();
+    const clang::ASTRecordLayout& layout = definition->getASTContext().getASTRecordLayout(definition);
+    llvm::SmallString<128> summary;
+    llvm::raw_svector_ostream OS(summary);
+    OS << "size=" << layout.getSize().getQuantity() << " align=" << layout.getAlignment().getQuantity();
+    // Fields as name@byte, with .bit behind bit-fields not starting on a byte
+    for (const clang::FieldDecl* field : definition->fields()) {
+        uint64_t offset = layout.getFieldOffset(field->getFieldIndex());
+        OS << ' ';
+        if (field->getIdentifier()) OS << field->getName();
+        else OS << '#' << field->getFieldIndex();
+        OS << '@' << offset / 8;
+        if (offset % 8 != 0) OS << '.' << offset % 8;
+    }
+    node->layout = context->intern(summary);
+}
+
+inline void beta::TreeBuilder::PushNode(APINode* node) {
     nodeStack.push_back(node);
+    scopeNameLengths.push_back(qualifiedName.get().size());
 }
 
 inline void beta::TreeBuilder::PopNode() {
     if (!nodeStack.empty()) {
         nodeStack.pop_back();
+        scopeNameLengths.pop_back();
     }
 }
 
@@ -200,43 +489,55 @@ inline void beta::TreeBuilder::PopName() {
     qualifiedName.pop();
 }
 
-inline const std::string beta::TreeBuilder::GetCurrentQualifiedName() {
-    return qualifiedName.getAsString();
+void beta::TreeBuilder::SetName(APINode* node) {
+    llvm::StringRef name = qualifiedName.get();
+    node->scope = nullptr;
+    // Nodes are pushed while their own name is the current one, so the name
+    // of the node on top of the stack prefixes the names built under it
+    if (!nodeStack.empty() && scopeNameLengths.back() <= name.size()) {
+        llvm::StringRef relative = name.substr(scopeNameLengths.back());
+        if (relative.empty() || relative.consume_front("::")) {
+            node->scope = nodeStack.back();
+            name = relative;
+        }
+    }
+    node->name = context->intern(name);
 }
 
 void beta::TreeBuilder::BuildReturnTypeNode(clang::QualType type) {
-    auto returnNode = std::make_shared<APINode>();
+    auto returnNode = context->createNode();
     returnNode->kind = NodeKind::ReturnType;
-    auto [dataType,canonicalType] = getTypesWithAndWithoutTypeResolution(type, *context->getClangASTContext());    
+    auto [dataType,canonicalType] = context->getTypeStrings(type, *context->getClangASTContext());
     PushName("(ReturnType)");
     returnNode->dataType = dataType;
     returnNode->caonicalType = canonicalType;
-    returnNode->NSR = "(ReturnType)";
-    returnNode->qualifiedName = GetCurrentQualifiedName();
+    returnNode->NSR = context->intern("(ReturnType)");
+    SetName(returnNode);
     AddNode(returnNode);
     PopName();
 
-    armor::debug() << "BuildReturnType V2: " << returnNode->dataType << "\n";
+    ARMOR_DEBUG_LOG << "BuildReturnType V2: " << returnNode->dataType << "\n";
 }
 
 void beta::TreeBuilder::normalizeFunctionPointerType(std::string_view typeModifiers, const clang::FunctionProtoTypeLoc FTL, const clang::NamedDecl* Decl) {
-    auto functionPointerNode = std::make_shared<APINode>();
+    auto functionPointerNode = context->createNode();
     functionPointerNode->kind = NodeKind::FunctionPointer;
-    functionPointerNode->qualifiedName = GetCurrentQualifiedName();
-    functionPointerNode->dataType = typeModifiers;
+    SetName(functionPointerNode);
+    RecordLines(functionPointerNode, Decl);
+    functionPointerNode->dataType = context->intern(llvm::StringRef(typeModifiers.data(), typeModifiers.size()));
     if(llvm::isa<clang::ParmVarDecl>(Decl)){
         // If ParamVarDecl is a functionPointer then the NSR is QualifiedName.
-        functionPointerNode->NSR = functionPointerNode->qualifiedName;
+        functionPointerNode->NSR = context->intern(qualifiedName.get());
     }
     else{
-        functionPointerNode->NSR = generateNSRForDecl(Decl);
-        functionPointerNode->USR = generateUSRForDecl(Decl);
+        functionPointerNode->NSR = context->getNSR(Decl);
+        functionPointerNode->USR = context->getUSR(Decl);
     }
     
     AddNode(functionPointerNode);
     PushNode(functionPointerNode);
     
-    armor::debug() << "BuildFunctionPointerType V2: " << functionPointerNode->qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "BuildFunctionPointerType V2: " << qualifiedName.get() << "\n";
     
     const size_t numParams = FTL.getNumParams();
     for (unsigned int pos=0 ; pos < numParams ; ++pos) {
@@ -249,9 +550,9 @@ void beta::TreeBuilder::normalizeFunctionPointerType(std::string_view typeModifi
 
 void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, unsigned int pos) {
     
-    const std::string USR = generateUSRForDecl(Decl);
-    const auto it = context->usrNodeMap.find(USR);
-    std::shared_ptr<APINode> ValueNode = (it != context->usrNodeMap.end()) ? it->second : std::make_shared<APINode>();
+    llvm::StringRef USR = context->getUSR(Decl);
+    APINode* existing = FindNodeByUSR(USR);
+    APINode* ValueNode = existing ? existing : context->createNode();
     clang::QualType unDecayedDeclType = clang::QualType();
     clang::TypeSourceInfo *TSI = nullptr;
     llvm::SmallString<128> nameBuf;
@@ -265,7 +566,7 @@ void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, uns
         pos++;
         PushName(std::to_string(pos));
         if(paramDecl->hasInit()){
-            armor::debug()<<"Excluding ParamVar init\n";
+            ARMOR_DEBUG_LOG <<"Excluding ParamVar init\n";
             TEST_LOG<<"ParamVar init\n";
             BuildValueInitExpr( paramDecl->getInit(),ValueNode);
         }
@@ -277,7 +578,7 @@ void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, uns
         Decl->printName(OS);
         PushName(nameBuf);
         if (fieldDecl->hasInClassInitializer()) {
-            armor::debug()<<"Excluding Field init\n" << nameBuf << "\n";
+            ARMOR_DEBUG_LOG <<"Excluding Field init\n" << nameBuf << "\n";
             TEST_LOG<<"Field init\n" << nameBuf << "\n";
             BuildValueInitExpr(fieldDecl->getInClassInitializer(), ValueNode);
         }
@@ -292,43 +593,47 @@ void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, uns
         Decl->printName(OS);
         PushName(nameBuf);
         if(varDecl->hasInit()){
-            armor::debug()<<"Excluding Var init\n" << nameBuf << "\n";
+            ARMOR_DEBUG_LOG <<"Excluding Var init\n" << nameBuf << "\n";
             TEST_LOG<<"Var init\n" << nameBuf << "\n";
             BuildValueInitExpr(varDecl->getInit(), ValueNode);
         }
     } 
     else return;
 
-    auto [dataType, canonicalType] = getTypesWithAndWithoutTypeResolution(unDecayedDeclType, Decl->getASTContext());
+    auto [dataType, canonicalType] = context->getTypeStrings(unDecayedDeclType, Decl->getASTContext());
 
     if (llvm::isa<clang::ParmVarDecl>(Decl)) {
         // NSR for param Decl is the position as they should be identified by position.
-        ValueNode->NSR = std::to_string(pos);
-        ValueNode->qualifiedName = GetCurrentQualifiedName();
-        armor::debug() << "VisitParamDecl V2: " << ValueNode->qualifiedName << "\n";
+        ValueNode->NSR = context->intern(std::to_string(pos));
+        SetName(ValueNode);
+        RecordLines(ValueNode, Decl);
+        ARMOR_DEBUG_LOG << "VisitParamDecl V2: " << qualifiedName.get() << "\n";
     } 
     else if (llvm::isa<clang::FieldDecl>(Decl)) {
-        ValueNode->qualifiedName = GetCurrentQualifiedName();
-        ValueNode->NSR = generateNSRForDecl(Decl);
+        SetName(ValueNode);
+        RecordLines(ValueNode, Decl);
+        ValueNode->NSR = context->getNSR(Decl);
         ValueNode->USR = USR;
-        context->usrNodeMap.insert_or_assign(std::move(USR),ValueNode);
-        armor::debug() << "VisitFeildDecl V2: " << ValueNode->qualifiedName << "\n";
+        RegisterUSR(USR, ValueNode);
+        ARMOR_DEBUG_LOG << "VisitFeildDecl V2: " << qualifiedName.get() << "\n";
     } 
     else if (llvm::dyn_cast_or_null<clang::VarDecl>(Decl)) {
-        ValueNode->qualifiedName = GetCurrentQualifiedName();
-        ValueNode->NSR = generateNSRForDecl(Decl);
+        SetName(ValueNode);
+        RecordLines(ValueNode, Decl);
+        ValueNode->NSR = context->getNSR(Decl);
         ValueNode->USR = USR;
-        context->usrNodeMap.insert_or_assign(std::move(USR),ValueNode);
-        armor::debug() << "VisitVarDecl V2: " << ValueNode->qualifiedName << "\n";
+        RegisterUSR(USR, ValueNode);
+        ARMOR_DEBUG_LOG << "VisitVarDecl V2: " << qualifiedName.get() << "\n";
     } 
 
     AddNode(ValueNode);
 
     if (TSI) {
-        auto [typeModifiers,unwrappedTL] = unwrapTypeLoc(TSI->getTypeLoc());
+        llvm::SmallString<32> typeModifiers;
+        clang::TypeLoc unwrappedTL = unwrapTypeLoc(TSI->getTypeLoc(), typeModifiers);
         if (const clang::FunctionProtoTypeLoc FTL = unwrappedTL.getAs<clang::FunctionProtoTypeLoc>()) {
             PushNode(ValueNode);
-            normalizeFunctionPointerType(typeModifiers, FTL, Decl);
+            normalizeFunctionPointerType(typeModifiers.str(), FTL, Decl);
             PopNode();
         }
         else{
@@ -340,12 +645,15 @@ void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, uns
     PopName();
 }
 
+template <typename Language>
 bool beta::TreeBuilder::BuildRecordNode(clang::RecordDecl* Decl) {
     
     // Building RecordDecl for C specifaically
     if (!IsDeclFromMainFileAndNotLocal(Decl)) return false;
 
-    if(llvm::isa<clang::CXXRecordDecl>(Decl)) return true;
+    if constexpr (Language::CPlusPlus) {
+        if (llvm::isa<clang::CXXRecordDecl>(Decl)) return true;
+    }
 
     llvm::SmallString<128> nameBuf;
     llvm::raw_svector_ostream OS(nameBuf);
@@ -385,19 +693,23 @@ bool beta::TreeBuilder::BuildRecordNode(clang::RecordDecl* Decl) {
         }
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
-    const std::string NSR = generateNSRForDecl(Decl);
-
-    const auto it = context->usrNodeMap.find(USR);
-    std::shared_ptr<APINode> recordNode =
-        (it != context->usrNodeMap.end()) ? it->second : std::make_shared<APINode>();
-    recordNode->NSR = NSR;
-    recordNode->USR = USR;
-    if (it == context->usrNodeMap.end()) AddNode(recordNode);
-    recordNode->qualifiedName = GetCurrentQualifiedName();
-    context->usrNodeMap.insert_or_assign(std::move(USR), recordNode);
+    // A redeclaration reuses the node, and with it the NSR and USR
+    APINode* existing = FindNodeByDecl(Decl);
+    llvm::StringRef USR = existing ? existing->USR : context->getUSR(Decl);
+    if (!existing) existing = FindNodeByUSR(USR);
+    APINode* recordNode = existing ? existing : context->createNode();
+    if (!existing) {
+        recordNode->NSR = context->getNSR(Decl);
+        recordNode->USR = USR;
+        AddNode(recordNode);
+        RegisterUSR(USR, recordNode);
+    }
+    RegisterDecl(Decl, recordNode);
+    SetName(recordNode);
+    RecordLines(recordNode, Decl);
+    RecordLayout(recordNode, Decl);
 
-    armor::debug() << "VisitRecordDecl (C): " << recordNode->qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitRecordDecl (C): " << qualifiedName.get() << "\n";
 
     if (Decl->isStruct()) {
         recordNode->kind = NodeKind::Struct;
@@ -416,7 +728,7 @@ bool beta::TreeBuilder::BuildCXXRecordNode(clang::CXXRecordDecl* Decl) {
     if( isInNameSpaceOrClass(Decl) || Decl->isClass() || Decl->isTemplated() 
     || llvm::isa<clang::ClassTemplateSpecializationDecl>(Decl) ){
         if(!isWrittenInClassOrNamespace(Decl)){
-            armor::debug()<<"Excluding CXXRecordNode\n";
+            ARMOR_DEBUG_LOG <<"Excluding CXXRecordNode\n";
             TEST_LOG<<"CXXRecordNode\n";
             processUnhandledDecl(Decl);
         }
@@ -459,18 +771,23 @@ bool beta::TreeBuilder::BuildCXXRecordNode(clang::CXXRecordDecl* Decl) {
         }
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
-    const std::string NSR = generateNSRForDecl(Decl);
-
-    const auto it = context->usrNodeMap.find(USR);
-    std::shared_ptr<APINode> cxxRecordNode = (it != context->usrNodeMap.end()) ? it->second : std::make_shared<APINode>();
-    cxxRecordNode->NSR = NSR;
-    cxxRecordNode->USR = USR;
-    if(it == context->usrNodeMap.end()) AddNode(cxxRecordNode);
-    cxxRecordNode->qualifiedName = GetCurrentQualifiedName();
-    context->usrNodeMap.insert_or_assign(std::move(USR),cxxRecordNode);
+    // A redeclaration reuses the node, and with it the NSR and USR
+    APINode* existing = FindNodeByDecl(Decl);
+    llvm::StringRef USR = existing ? existing->USR : context->getUSR(Decl);
+    if (!existing) existing = FindNodeByUSR(USR);
+    APINode* cxxRecordNode = existing ? existing : context->createNode();
+    if (!existing) {
+        cxxRecordNode->NSR = context->getNSR(Decl);
+        cxxRecordNode->USR = USR;
+        AddNode(cxxRecordNode);
+        RegisterUSR(USR, cxxRecordNode);
+    }
+    RegisterDecl(Decl, cxxRecordNode);
+    SetName(cxxRecordNode);
+    RecordLines(cxxRecordNode, Decl);
+    RecordLayout(cxxRecordNode, Decl);
 
-    armor::debug() << "VisitCxxRecordDecl V2: " << cxxRecordNode->qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitCxxRecordDecl V2: " << qualifiedName.get() << "\n";
 
     if( Decl->isStruct() ){
         cxxRecordNode->kind = NodeKind::Struct;
@@ -485,13 +802,14 @@ bool beta::TreeBuilder::BuildCXXRecordNode(clang::CXXRecordDecl* Decl) {
 }
 
 
+template <typename Language>
 bool beta::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
 
     if (!IsDeclFromMainFileAndNotLocal(Decl)) return false;
 
-    if (isInNameSpaceOrClass(Decl) || Decl->isTemplated()){
+    if (isInNameSpaceOrClassOrTemplated<Language>(Decl)){
         if( !isWrittenInClassOrNamespace(Decl)){
-            armor::debug() << "Excluding EnumNode\n";
+            ARMOR_DEBUG_LOG << "Excluding EnumNode\n";
             TEST_LOG << "EnumNode\n";
             processUnhandledDecl(Decl);
         }
@@ -533,44 +851,55 @@ bool beta::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
         }
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
-    const std::string NSR = generateNSRForDecl(Decl);
-
-    const auto it = context->usrNodeMap.find(USR);
-    std::shared_ptr<APINode> enumNode = (it != context->usrNodeMap.end()) ? it->second : std::make_shared<APINode>();
-    enumNode->NSR = NSR;
-    enumNode->USR = USR;
-    if(it == context->usrNodeMap.end()) AddNode(enumNode);
-    enumNode->qualifiedName = GetCurrentQualifiedName();
-    context->usrNodeMap.insert_or_assign(std::move(USR),enumNode);
+    // A redeclaration reuses the node, and with it the NSR and USR
+    APINode* existing = FindNodeByDecl(Decl);
+    llvm::StringRef USR = existing ? existing->USR : context->getUSR(Decl);
+    if (!existing) existing = FindNodeByUSR(USR);
+    APINode* enumNode = existing ? existing : context->createNode();
+    if (!existing) {
+        enumNode->NSR = context->getNSR(Decl);
+        enumNode->USR = USR;
+        AddNode(enumNode);
+        RegisterUSR(USR, enumNode);
+    }
+    RegisterDecl(Decl, enumNode);
+    SetName(enumNode);
+    RecordLines(enumNode, Decl);
     
-    armor::debug() << "VisitEnumDecl V2: " << enumNode->qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitEnumDecl V2: " << qualifiedName.get() << "\n";
     
     enumNode->kind = NodeKind::Enum;
     PushNode(enumNode);
 
-    const clang::QualType enumType = Decl->getIntegerType();
-    std::string enumaratorDataType = enumType.getAsString();
-     
-    for (const auto* EnumConstDecl : Decl->enumerators()) {
-        if(!Decl->isThisDeclarationADefinition()) continue;
-        auto enumValNode = std::make_shared<APINode>();
-        llvm::StringRef enumConstName = EnumConstDecl->getName();
-        PushName(enumConstName);
-        enumValNode->qualifiedName = GetCurrentQualifiedName();
-        enumValNode->dataType = enumaratorDataType;
-        enumValNode->NSR = generateNSRForDecl(EnumConstDecl);
-        enumValNode->USR = generateUSRForDecl(EnumConstDecl);
-        const clang::Expr* expr = EnumConstDecl->getInitExpr();
-        if(expr){
-            armor::debug() << "Excluding EnumConst\n" << nameBuf << ":" << enumConstName << "\n";
-            TEST_LOG << "EnumConst\n" << nameBuf << ":" << enumConstName << "\n";
-            processUnhandledStmt(EnumConstDecl->getInitExpr(), enumValNode);
+    // Enumerators are only listed by the definition
+    if (Decl->isThisDeclarationADefinition()) {
+        llvm::StringRef enumaratorDataType;
+        {
+            // Printed by the TypePrinter, see printTypeAsWritten
+            std::unique_lock<std::mutex> lock = LockAST();
+            enumaratorDataType = context->intern(Decl->getIntegerType().getAsString());
+        }
+        for (const auto* EnumConstDecl : Decl->enumerators()) {
+            auto enumValNode = context->createNode();
+            llvm::StringRef enumConstName = EnumConstDecl->getName();
+            PushName(enumConstName);
+            SetName(enumValNode);
+            RecordLines(enumValNode, EnumConstDecl);
+            enumValNode->dataType = enumaratorDataType;
+            // Enumerators of one enum have distinct names, so the name alone
+            // matches them within it; generated headers list thousands
+            enumValNode->NSR = context->intern(enumConstName);
+            const clang::Expr* expr = EnumConstDecl->getInitExpr();
+            if(expr){
+                ARMOR_DEBUG_LOG << "Excluding EnumConst\n" << nameBuf << ":" << enumConstName << "\n";
+                TEST_LOG << "EnumConst\n" << nameBuf << ":" << enumConstName << "\n";
+                processUnhandledStmt(EnumConstDecl->getInitExpr(), enumValNode);
+            }
+            ARMOR_DEBUG_LOG << "VisitEnumConstDecl V2: "<< qualifiedName.get() << "\n";
+            PopName();
+            enumValNode->kind = NodeKind::Enumerator;
+            AddNode(enumValNode);
         }
-        armor::debug() << "VisitEnumConstDecl V2: "<< enumValNode->qualifiedName << "\n";
-        PopName();
-        enumValNode->kind = NodeKind::Enumerator;
-        AddNode(enumValNode);
     }
 
     PopNode();
@@ -580,44 +909,46 @@ bool beta::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
 }
 
 
+template <typename Language>
 bool beta::TreeBuilder::BuildFunctionNode(clang::FunctionDecl* Decl){
 
     if (!IsDeclFromMainFileAndNotLocal(Decl)) return false;
 
-    if (isInNameSpaceOrClass(Decl) || Decl->isTemplated()){
+    if (isInNameSpaceOrClassOrTemplated<Language>(Decl)){
         if(!isWrittenInClassOrNamespace(Decl)){
-            armor::debug()<<"Excluding FunctionNode\n";
+            ARMOR_DEBUG_LOG <<"Excluding FunctionNode\n";
             TEST_LOG<<"FunctionNode\n";
             processUnhandledDecl(Decl);
         }
         return true;
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
-    if( context->usrNodeMap.find(USR) != context->usrNodeMap.end() ) return true;
+    llvm::StringRef USR = context->getUSR(Decl);
+    if (FindNodeByUSR(USR)) return true;
 
     llvm::SmallString<128> nameBuf;
     llvm::raw_svector_ostream OS(nameBuf);
 
-    auto functionNode = std::make_shared<APINode>();
+    auto functionNode = context->createNode();
     Decl->printName(OS);
     PushName(nameBuf);
 
     if(Decl->isThisDeclarationADefinition()){
-        armor::debug()<<"Excluding Function Body : "<< nameBuf << "\n";
+        ARMOR_DEBUG_LOG <<"Excluding Function Body : "<< nameBuf << "\n";
         TEST_LOG<<"Function Body\n" << nameBuf << "\n";
         processUnhandledStmt(Decl->getBody(), functionNode);
     }
 
-    functionNode->qualifiedName = GetCurrentQualifiedName();
+    SetName(functionNode);
+    RecordLines(functionNode, Decl);
     functionNode->kind = NodeKind::Function;
     functionNode->isInclined = Decl->isInlined();
     functionNode->storage = getStorageClass(Decl->getStorageClass());
-    functionNode->NSR = generateNSRForDecl(Decl);
+    functionNode->NSR = context->getNSR(Decl);
     functionNode->USR = USR;
-    context->usrNodeMap.insert_or_assign(std::move(USR),functionNode);
+    RegisterUSR(USR, functionNode);
 
-    armor::debug() << "VisitFunctionDecl V2: " << functionNode->qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitFunctionDecl V2: " << qualifiedName.get() << "\n";
 
     AddNode(functionNode);
     PushNode(functionNode);
@@ -636,46 +967,49 @@ bool beta::TreeBuilder::BuildFunctionNode(clang::FunctionDecl* Decl){
 }
 
 
+template <typename Language>
 bool beta::TreeBuilder::BuildTypedefDecl(clang::TypedefDecl *Decl) {
 
-    if(!IsDeclFromMainFileAndNotLocal(Decl) || isInNameSpaceOrClass(Decl) || Decl->isTemplated()){
+    if(!IsDeclFromMainFileAndNotLocal(Decl) || isInNameSpaceOrClassOrTemplated<Language>(Decl)){
         if(IsDeclFromMainFileAndNotLocal(Decl) && !isWrittenInClassOrNamespace(Decl)){
-            armor::debug()<<"Excluding TypedefDecl\n";
+            ARMOR_DEBUG_LOG <<"Excluding TypedefDecl\n";
             TEST_LOG<<"TypedefDecl\n";
             processUnhandledDecl(Decl);
         }
         return false;
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
-    if( context->usrNodeMap.find(USR) != context->usrNodeMap.end() ) return true;
+    llvm::StringRef USR = context->getUSR(Decl);
+    if (FindNodeByUSR(USR)) return true;
 
     llvm::SmallString<128> nameBuf;
     llvm::raw_svector_ostream OS(nameBuf);
 
     const clang::QualType underlyingType = Decl->getUnderlyingType();
 
-    auto typeDefNode = std::make_shared<APINode>();
+    auto typeDefNode = context->createNode();
     Decl->printName(OS);
     PushName(nameBuf);
-    typeDefNode->qualifiedName = GetCurrentQualifiedName();
+    SetName(typeDefNode);
+    RecordLines(typeDefNode, Decl);
     typeDefNode->kind = NodeKind::Typedef;
-    auto [dataType, canonicalType] = getTypesWithAndWithoutTypeResolution(underlyingType, Decl->getASTContext());
+    auto [dataType, canonicalType] = context->getTypeStrings(underlyingType, Decl->getASTContext());
     typeDefNode->dataType = dataType;
     typeDefNode->caonicalType = canonicalType;
     typeDefNode->USR = USR;
-    typeDefNode->NSR = generateNSRForDecl(Decl);
-    context->usrNodeMap.insert_or_assign(std::move(USR), typeDefNode);
+    typeDefNode->NSR = context->getNSR(Decl);
+    RegisterUSR(USR, typeDefNode);
     
-    armor::debug() << "VisitTypeDefDecl V2: " << typeDefNode->qualifiedName << "\n";
+    ARMOR_DEBUG_LOG << "VisitTypeDefDecl V2: " << qualifiedName.get() << "\n";
 
     if (!llvm::isa<clang::TypedefType>(underlyingType)) {
         if (const clang::TypeSourceInfo *TSI = Decl->getTypeSourceInfo()) {
-            auto [typeModifiers,unwrappedTL] = unwrapTypeLoc(TSI->getTypeLoc());
+            llvm::SmallString<32> typeModifiers;
+            clang::TypeLoc unwrappedTL = unwrapTypeLoc(TSI->getTypeLoc(), typeModifiers);
             if (const clang::FunctionProtoTypeLoc FTL = unwrappedTL.getAs<clang::FunctionProtoTypeLoc>()) {
-                typeDefNode->dataType = std::string{};
+                typeDefNode->dataType = llvm::StringRef();
                 PushNode(typeDefNode);
-                normalizeFunctionPointerType(typeModifiers, FTL, Decl);
+                normalizeFunctionPointerType(typeModifiers.str(), FTL, Decl);
                 PopNode();
             }
         }
@@ -687,35 +1021,38 @@ bool beta::TreeBuilder::BuildTypedefDecl(clang::TypedefDecl *Decl) {
     return true;
 }
 
+template <typename Language>
 bool beta::TreeBuilder::BuildVarDecl(clang::VarDecl *Decl) {
 
-    if (!IsDeclFromMainFileAndNotLocal(Decl) || isInNameSpaceOrClass(Decl) || !Decl->hasGlobalStorage() 
-    || Decl->isTemplated()){
-        if(Decl->hasGlobalStorage() && IsDeclFromMainFileAndNotLocal(Decl) && !isWrittenInClassOrNamespace(Decl) && (isInNameSpaceOrClass(Decl) || Decl->isTemplated())){
-            armor::debug()<<"Excluding TemplatedVarDecl\n";
+    if (!IsDeclFromMainFileAndNotLocal(Decl) || !Decl->hasGlobalStorage() 
+    || isInNameSpaceOrClassOrTemplated<Language>(Decl)){
+        if(Decl->hasGlobalStorage() && IsDeclFromMainFileAndNotLocal(Decl) && !isWrittenInClassOrNamespace(Decl) && isInNameSpaceOrClassOrTemplated<Language>(Decl)){
+            ARMOR_DEBUG_LOG <<"Excluding TemplatedVarDecl\n";
             TEST_LOG<<"TemplatedVarDecl\n";
             processUnhandledDecl(Decl);
         } 
         return false;
     }
 
-    if(llvm::isa<clang::VarTemplateDecl>(Decl) || llvm::isa<clang::VarTemplatePartialSpecializationDecl>(Decl) 
-    || llvm::isa<clang::VarTemplateSpecializationDecl>(Decl)){
-        if(!isWrittenInClassOrNamespace(Decl)){
-            armor::debug()<<"Excluding TempletSpecVarDecl\n";
-            TEST_LOG<<"TempletSpecVarDecl\n";
-            processUnhandledDecl(Decl);
+    if constexpr (Language::CPlusPlus) {
+        if(llvm::isa<clang::VarTemplateDecl>(Decl) || llvm::isa<clang::VarTemplatePartialSpecializationDecl>(Decl) 
+        || llvm::isa<clang::VarTemplateSpecializationDecl>(Decl)){
+            if(!isWrittenInClassOrNamespace(Decl)){
+                ARMOR_DEBUG_LOG <<"Excluding TempletSpecVarDecl\n";
+                TEST_LOG<<"TempletSpecVarDecl\n";
+                processUnhandledDecl(Decl);
+            }
+            return true;
         }
-        return true;
     }
 
     normalizeValueDeclNode(Decl);
     return true;
 }
 
+template <typename Language>
 bool beta::TreeBuilder::BuildFieldDecl(clang::FieldDecl *Decl) {
-    if (!IsDeclFromMainFileAndNotLocal(Decl) || isInNameSpaceOrClass(Decl) 
-    || Decl->isTemplated()){
+    if (!IsDeclFromMainFileAndNotLocal(Decl) || isInNameSpaceOrClassOrTemplated<Language>(Decl)){
         return false;
     }
 
@@ -723,12 +1060,25 @@ bool beta::TreeBuilder::BuildFieldDecl(clang::FieldDecl *Decl) {
     return true;
 }
 
+template bool beta::TreeBuilder::BuildRecordNode<beta::CLanguage>(clang::RecordDecl* Decl);
+template bool beta::TreeBuilder::BuildRecordNode<beta::CxxLanguage>(clang::RecordDecl* Decl);
+template bool beta::TreeBuilder::BuildEnumNode<beta::CLanguage>(clang::EnumDecl* Decl);
+template bool beta::TreeBuilder::BuildEnumNode<beta::CxxLanguage>(clang::EnumDecl* Decl);
+template bool beta::TreeBuilder::BuildFunctionNode<beta::CLanguage>(clang::FunctionDecl* Decl);
+template bool beta::TreeBuilder::BuildFunctionNode<beta::CxxLanguage>(clang::FunctionDecl* Decl);
+template bool beta::TreeBuilder::BuildTypedefDecl<beta::CLanguage>(clang::TypedefDecl* Decl);
+template bool beta::TreeBuilder::BuildTypedefDecl<beta::CxxLanguage>(clang::TypedefDecl* Decl);
+template bool beta::TreeBuilder::BuildVarDecl<beta::CLanguage>(clang::VarDecl* Decl);
+template bool beta::TreeBuilder::BuildVarDecl<beta::CxxLanguage>(clang::VarDecl* Decl);
+template bool beta::TreeBuilder::BuildFieldDecl<beta::CLanguage>(clang::FieldDecl* Decl);
+template bool beta::TreeBuilder::BuildFieldDecl<beta::CxxLanguage>(clang::FieldDecl* Decl);
+
 // === Unsupported Declaration Handlers ===
 
 void beta::TreeBuilder::BuildNamespaceDecl(clang::NamespaceDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug()<<"Excluding NamespaceDecl\n";
+    ARMOR_DEBUG_LOG <<"Excluding NamespaceDecl\n";
     TEST_LOG<<"NamespaceDecl\n";
 
     processUnhandledDecl(Decl);
@@ -737,7 +1087,7 @@ void beta::TreeBuilder::BuildNamespaceDecl(clang::NamespaceDecl* Decl) {
 void beta::TreeBuilder::BuildFunctionTemplateDecl(clang::FunctionTemplateDecl* Decl){
     if(!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
 
-    armor::debug() << "Excluding FunctionTemplateDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding FunctionTemplateDecl\n";
     TEST_LOG << "FunctionTemplateDecl\n";
 
     processUnhandledDecl(Decl);
@@ -746,7 +1096,7 @@ void beta::TreeBuilder::BuildFunctionTemplateDecl(clang::FunctionTemplateDecl* D
 void beta::TreeBuilder::BuildClassTemplateDecl(clang::ClassTemplateDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding ClassTemplateDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding ClassTemplateDecl\n";
     TEST_LOG << "ClassTemplateDecl\n";
         
     processUnhandledDecl(Decl);
@@ -755,7 +1105,7 @@ void beta::TreeBuilder::BuildClassTemplateDecl(clang::ClassTemplateDecl* Decl) {
 void beta::TreeBuilder::BuildClassTemplateSpecializationDecl(clang::ClassTemplateSpecializationDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding ClassTemplateSpecializationDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding ClassTemplateSpecializationDecl\n";
     TEST_LOG << "ClassTemplateSpecializationDecl\n";
     
     processUnhandledDecl(Decl);
@@ -764,7 +1114,7 @@ void beta::TreeBuilder::BuildClassTemplateSpecializationDecl(clang::ClassTemplat
 void beta::TreeBuilder::BuildClassTemplatePartialSpecializationDecl(clang::ClassTemplatePartialSpecializationDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding ClassTemplatePartialSpecializationDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding ClassTemplatePartialSpecializationDecl\n";
     TEST_LOG << "ClassTemplatePartialSpecializationDecl\n";
 
     processUnhandledDecl(Decl);
@@ -773,7 +1123,7 @@ void beta::TreeBuilder::BuildClassTemplatePartialSpecializationDecl(clang::Class
 void beta::TreeBuilder::BuildTypeAliasDecl(clang::TypeAliasDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding TypeAliasDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding TypeAliasDecl\n";
     TEST_LOG << "TypeAliasDecl\n";
 
     processUnhandledDecl(Decl);
@@ -782,7 +1132,7 @@ void beta::TreeBuilder::BuildTypeAliasDecl(clang::TypeAliasDecl* Decl) {
 void beta::TreeBuilder::BuildUsingDecl(clang::UsingDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding UsingDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding UsingDecl\n";
     TEST_LOG << "UsingDecl\n";
     
     processUnhandledDecl(Decl);
@@ -791,7 +1141,7 @@ void beta::TreeBuilder::BuildUsingDecl(clang::UsingDecl* Decl) {
 void beta::TreeBuilder::BuildUsingDirectiveDecl(clang::UsingDirectiveDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding UsingDirectiveDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding UsingDirectiveDecl\n";
     TEST_LOG << "UsingDirectiveDecl\n";
     
     processUnhandledDecl(Decl);
@@ -800,7 +1150,7 @@ void beta::TreeBuilder::BuildUsingDirectiveDecl(clang::UsingDirectiveDecl* Decl)
 void beta::TreeBuilder::BuildNamespaceAliasDecl(clang::NamespaceAliasDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding NamespaceAliasDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding NamespaceAliasDecl\n";
     TEST_LOG << "NamespaceAliasDecl\n";
 
     processUnhandledDecl(Decl);
@@ -809,7 +1159,7 @@ void beta::TreeBuilder::BuildNamespaceAliasDecl(clang::NamespaceAliasDecl* Decl)
 void beta::TreeBuilder::BuildStaticAssertDecl(clang::StaticAssertDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding StaticAssertDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding StaticAssertDecl\n";
     TEST_LOG << "StaticAssertDecl\n";
     
     processUnhandledDecl(Decl);
@@ -818,7 +1168,7 @@ void beta::TreeBuilder::BuildStaticAssertDecl(clang::StaticAssertDecl* Decl) {
 void beta::TreeBuilder::BuildVarTemplateDecl(clang::VarTemplateDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding VarTemplateDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding VarTemplateDecl\n";
     TEST_LOG << "VarTemplateDecl\n";
     
     processUnhandledDecl(Decl);
@@ -827,7 +1177,7 @@ void beta::TreeBuilder::BuildVarTemplateDecl(clang::VarTemplateDecl* Decl) {
 void beta::TreeBuilder::BuildVarTemplateSpecializationDecl(clang::VarTemplateSpecializationDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding VarTemplateSpecializationDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding VarTemplateSpecializationDecl\n";
     TEST_LOG << "VarTemplateSpecializationDecl\n";
     
     processUnhandledDecl(Decl);
@@ -836,7 +1186,7 @@ void beta::TreeBuilder::BuildVarTemplateSpecializationDecl(clang::VarTemplateSpe
 void beta::TreeBuilder::BuildVarTemplatePartialSpecializationDecl(clang::VarTemplatePartialSpecializationDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding VarTemplatePartialSpecializationDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding VarTemplatePartialSpecializationDecl\n";
     TEST_LOG << "VarTemplatePartialSpecializationDecl\n";
     
     processUnhandledDecl(Decl);
@@ -845,13 +1195,13 @@ void beta::TreeBuilder::BuildVarTemplatePartialSpecializationDecl(clang::VarTemp
 void beta::TreeBuilder::BuildTypeAliasTemplateDecl(clang::TypeAliasTemplateDecl* Decl) {
     if (!IsDeclFromMainFileAndNotLocal(Decl) || isWrittenInClassOrNamespace(Decl)) return;
     
-    armor::debug() << "Excluding TypeAliasTemplateDecl\n";
+    ARMOR_DEBUG_LOG << "Excluding TypeAliasTemplateDecl\n";
     TEST_LOG << "TypeAliasTemplateDecl\n";
     
     processUnhandledDecl(Decl);
 }
 
-void beta::TreeBuilder::BuildValueInitExpr(const clang::Expr* Expr, const std::shared_ptr<beta::APINode>& node){
+void beta::TreeBuilder::BuildValueInitExpr(const clang::Expr* Expr, beta::APINode* node){
     if (Expr && !IsStmtFromMainFile(Expr)) return;
 
     if (const clang::CXXConstructExpr* cxxConstructExpr = llvm::dyn_cast<clang::CXXConstructExpr>(Expr)) {
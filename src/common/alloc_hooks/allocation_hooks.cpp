@@ -0,0 +1,76 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstdlib>
+#include <new>
+
+#include "profiler.hpp"
+
+// The global allocation functions, replaced to count the calls and bytes of
+// each thread for --profile=mem. Every allocation of the process pays the
+// thread-local add, so only executables configured with ARMOR_ALLOC_PROFILING
+// link this file; see armor::profile::allocationsCounted.
+
+namespace {
+
+    const bool registered = (armor::profile::detail::allocationHooksLinked = true);
+
+}
+
+void* operator new(std::size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void* memory = std::malloc(size)) {
+            armor::profile::detail::ThreadAllocations& allocations = armor::profile::detail::threadAllocations;
+            allocations.bytes += size;
+            ++allocations.count;
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
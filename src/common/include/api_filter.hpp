@@ -0,0 +1,106 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/GlobPattern.h"
+
+namespace clang { class Decl; }
+
+namespace armor {
+
+/**
+ * @class ApiFilter
+ * @brief Which declarations of a header count as public API (--api-filter).
+ *
+ * The input is a JSON object, every key of which is optional:
+ *
+ *     {
+ *       "include": ["mylib::*"],
+ *       "exclude": ["*::detail", "*::impl", "*::_*", "_*"],
+ *       "excludeHidden": true,
+ *       "exportMacros": ["MYLIB_API"],
+ *       "symbols": ["mylib::Widget::resize"]
+ *     }
+ *
+ * Patterns are globs (`*`, `?`, `[...]`) matched against whole qualified
+ * names such as `mylib::detail`. A declaration matching an exclude pattern is
+ * dropped with everything declared inside it, so excluding a namespace prunes
+ * its subtree. With include patterns, namespace-scope declarations other than
+ * namespaces must match one of them. `excludeHidden` drops declarations with
+ * an explicit hidden visibility, and with `exportMacros` non-inline
+ * namespace-scope functions, variables and classes must carry an attribute
+ * spelled through one of those macros. `symbols` (or --symbol) narrows
+ * everything down to the named declarations: only they, the namespaces and
+ * classes enclosing them and what they declare are kept, so the rest of the
+ * header is neither normalized nor diffed.
+ */
+class ApiFilter {
+public:
+    /**
+     * @brief Loads an API filter file.
+     * @throws std::runtime_error if the file cannot be read or is malformed.
+     */
+    static ApiFilter load(const std::string& path);
+
+    /**
+     * @brief Whether `qualifiedName` matches an exclude pattern.
+     */
+    bool excludesName(llvm::StringRef qualifiedName) const;
+
+    /**
+     * @brief Whether `qualifiedName` matches an include pattern; true without include patterns.
+     */
+    bool includesName(llvm::StringRef qualifiedName) const;
+
+    bool excludeHidden() const { return hidden; }
+
+    bool requiresExportMacro() const { return !exportMacros.empty(); }
+
+    bool isExportMacro(llvm::StringRef macroName) const { return exportMacros.count(macroName) != 0; }
+
+    /**
+     * @brief Narrows the filter down to the declarations named `qualifiedName`, e.g. "ns::Foo::bar".
+     */
+    void addSymbol(llvm::StringRef qualifiedName);
+
+    bool hasSymbols() const { return !symbols.empty(); }
+
+    /**
+     * @brief Whether `qualifiedName` names a requested symbol, a scope enclosing one or a
+     *        declaration inside one; true without symbols.
+     */
+    bool selectsSymbol(llvm::StringRef qualifiedName) const;
+
+    /**
+     * @brief Whether the normalizers drop `decl` and its subtree.
+     */
+    bool excludes(const clang::Decl* decl) const;
+
+    /**
+     * @brief Canonical text of the filter; normalized contexts of distinct filters differ.
+     */
+    const std::string& fingerprint() const { return canonical; }
+
+private:
+    void updateCanonical();
+
+    // Source text of the patterns, which they may point into
+    llvm::BumpPtrAllocator patternText;
+    std::vector<llvm::GlobPattern> includePatterns;
+    std::vector<llvm::GlobPattern> excludePatterns;
+    bool hidden = false;
+    llvm::StringSet<> exportMacros;
+    // Sorted and unique
+    std::vector<std::string> symbols;
+    // Canonical text of the file without its symbols, and with them
+    std::string document;
+    std::string canonical;
+};
+
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <llvm/ADT/StringRef.h>
+
+namespace armor {
+
+/**
+ * @brief Buffered log backend: per-thread ring buffers drained by one background thread.
+ *
+ * Every producing thread appends whole records to its own single-producer
+ * ring without taking a lock; the drain thread (or flush()) hands the
+ * accumulated bytes of each ring to the writer. Records are never split, so
+ * lines from different threads do not interleave, and the order of one
+ * thread's records is kept. Rings of exited threads are reused by new ones.
+ *
+ * A producer whose ring is full wakes the drain thread and waits for space;
+ * a record larger than a ring is written synchronously after a flush.
+ */
+class AsyncLogSink {
+public:
+    /** Receives drained bytes; `flush` is set once a drain pass is complete. */
+    using Writer = std::function<void(llvm::StringRef text, bool flush)>;
+
+    static constexpr size_t DEFAULT_RING_CAPACITY = 64 * 1024;
+
+    /** @param ringCapacity Bytes per thread ring, rounded up to a power of two. */
+    explicit AsyncLogSink(Writer writer, size_t ringCapacity = DEFAULT_RING_CAPACITY);
+
+    /** Drains every ring and joins the drain thread. */
+    ~AsyncLogSink();
+
+    /**
+     * @brief Appends one formatted record from the calling thread.
+     */
+    void submit(llvm::StringRef record);
+
+    /**
+     * @brief Writes out every record submitted before the call, from any thread.
+     */
+    void flush();
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    // Opaque; named here so the per-thread bookkeeping can hold rings
+    struct Ring;
+
+private:
+    Ring& threadRing();
+    void requestDrain();
+    void drainAll(bool flushWriter);
+    void drainLoop();
+
+    Writer writer;
+    size_t ringCapacity;
+    // Tells apart the rings threads hold for different sinks
+    uint64_t id;
+
+    // Held by whoever drains; producers never take it
+    std::mutex drainMutex;
+
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeDrain;
+    std::condition_variable spaceFreed;
+    std::atomic<bool> drainRequested{false};
+    bool stopping = false;
+
+    std::thread drainThread;
+};
+
+}
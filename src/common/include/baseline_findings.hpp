@@ -0,0 +1,68 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "report_utils.hpp"
+
+namespace armor {
+
+/**
+ * @class BaselineFindings
+ * @brief Findings of an accepted earlier run (--baseline), so reports only show what changed since.
+ *
+ * A finding is one report row, keyed by its header, API name, change type
+ * and compatibility; its description is not part of the key, so rewording a
+ * known change does not make it new. The findings are loaded once before any
+ * header is compared and only read afterwards, from any thread.
+ */
+class BaselineFindings {
+public:
+    static BaselineFindings& getInstance();
+
+    /**
+     * @brief Loads the reports at `path`: the output root of a run, whose JSON,
+     *        CBOR or MessagePack reports are read, or a single report file such
+     *        as the summary of `armor merge`.
+     *
+     * @return Number of reports read.
+     * @throws std::runtime_error if a report cannot be read or is malformed.
+     */
+    std::size_t load(const std::string& path);
+
+    /**
+     * @brief Whether reports are limited to the delta against a loaded baseline.
+     */
+    bool isLoaded() const { return loaded; }
+
+    void clear();
+
+    /**
+     * @brief The groups of `groups` that are not baseline findings.
+     *
+     * @param summary Set to {"known": <groups left out>, "resolved": [<rows>]}, the
+     *                resolved rows being the baseline findings of the header
+     *                that `groups` no longer has.
+     */
+    ApiChangeGroups delta(const ApiChangeGroups& groups, json& summary) const;
+
+private:
+    struct HeaderFindings {
+        std::unordered_set<std::string> keys;
+        std::vector<json> rows;
+    };
+
+    static std::string keyOf(const std::string& name, const std::string& changeType, const std::string& compatibility);
+
+    std::map<std::string, HeaderFindings> headers;
+    bool loaded = false;
+};
+
+}
@@ -0,0 +1,81 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace armor {
+
+/**
+ * @struct BenchSweepConfig
+ * @brief A recorded corpus and the fixed settings `armor bench-sweep` runs it with.
+ */
+struct BenchSweepConfig {
+    // The two project roots, as given to run_armor.sh
+    std::string base;
+    std::string head;
+    // Header config of the action and the branch whose patterns select the headers
+    std::string headerConfig;
+    std::string branch;
+    // As the HEADER_DIR, INCLUDE_PATHS and MACRO_FLAGS of run_armor.sh
+    std::string headerDir;
+    std::vector<std::string> includePaths;
+    std::string macroFlags;
+    // cpp or c; empty for the default
+    std::string lang;
+    // --jobs of every run; 0 picks the CPUs available
+    unsigned jobs = 0;
+    // Times the whole sweep is run
+    unsigned repeat = 1;
+};
+
+/**
+ * @brief Reads the config of `armor bench-sweep`:
+ *
+ *     base: corpus/base
+ *     head: corpus/head
+ *     header-config: corpus/armor.yml
+ *     branch: main
+ *     header-dir: include
+ *     include-paths: [corpus/deps/include]
+ *     macro-flags: -DNET_SHARED
+ *     lang: cpp
+ *     jobs: 8
+ *     repeat: 3
+ *
+ * base, head, header-config and branch are required. Relative paths are
+ * taken relative to the directory of the file.
+ *
+ * @throws std::runtime_error if the file cannot be read or is not such a mapping.
+ */
+BenchSweepConfig loadBenchSweepConfig(const std::string& path);
+
+/**
+ * @brief Splits `headers` into the rounds run_armor.sh runs one armor process each.
+ *
+ * Reports are named after the basename of a header, so a header whose
+ * basename an earlier one took goes to the next round; the headers keep
+ * their order within a round.
+ */
+std::vector<std::vector<std::string>> scheduleHeaderRounds(const std::vector<std::string>& headers);
+
+/**
+ * @struct LatencySummary
+ * @brief Nearest-rank percentiles of a set of latencies, in their unit.
+ */
+struct LatencySummary {
+    std::size_t count = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+/**
+ * @brief Summarizes `latencies`; all zero when there are none.
+ */
+LatencySummary summarizeLatencies(std::vector<double> latencies);
+
+}
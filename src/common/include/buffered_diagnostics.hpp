@@ -0,0 +1,69 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace armor {
+
+/**
+ * @struct DiagnosticCounts
+ * @brief How many diagnostics of each kind one translation unit reported.
+ */
+struct DiagnosticCounts {
+    unsigned warnings = 0;
+    // Fatal errors included
+    unsigned errors = 0;
+    unsigned fatals = 0;
+    // `#include` directives naming a file that was not found
+    unsigned missingIncludes = 0;
+};
+
+/**
+ * @class BufferedDiagnosticConsumer
+ * @brief Prints the diagnostics of one translation unit into a buffer of its
+ *        own and counts them, so workers parsing at once neither interleave
+ *        their diagnostics nor contend on the log.
+ *
+ * flush() hands the buffered text to the log in one write once the unit is
+ * done; clear() restarts the counts for the next unit of a batch.
+ */
+class BufferedDiagnosticConsumer : public clang::DiagnosticConsumer {
+public:
+    explicit BufferedDiagnosticConsumer(clang::DiagnosticOptions* options)
+        : stream(buffer), printer(stream, options) {}
+
+    ~BufferedDiagnosticConsumer() override { flush(); }
+
+    void BeginSourceFile(const clang::LangOptions& langOpts, const clang::Preprocessor* pp) override {
+        printer.BeginSourceFile(langOpts, pp);
+    }
+
+    void EndSourceFile() override { printer.EndSourceFile(); }
+
+    void finish() override { printer.finish(); }
+
+    void clear() override {
+        clang::DiagnosticConsumer::clear();
+        counts = DiagnosticCounts();
+    }
+
+    void HandleDiagnostic(clang::DiagnosticsEngine::Level level, const clang::Diagnostic& info) override;
+
+    const DiagnosticCounts& getCounts() const { return counts; }
+
+    /** @brief Writes what was printed so far to the log in one block and empties the buffer. */
+    void flush();
+
+private:
+    std::string buffer;
+    llvm::raw_string_ostream stream;
+    clang::TextDiagnosticPrinter printer;
+    DiagnosticCounts counts;
+};
+
+}
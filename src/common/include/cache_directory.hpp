@@ -0,0 +1,95 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @brief Writes `bytes` to `path` through a temporary file next to it that is
+ *        renamed into place, so concurrent readers see the old file or the
+ *        new one and never a partial one.
+ * @param error Set to the reason when false is returned; the temporary file is then removed.
+ */
+bool publishCacheFile(const std::string& path, llvm::StringRef bytes, std::string& error);
+
+/**
+ * @brief `payload` followed by a footer holding its xxHash64, so a truncated
+ *        or corrupted entry is told apart from a valid one (see unsealCacheEntry).
+ */
+std::string sealCacheEntry(llvm::StringRef payload);
+
+/**
+ * @brief Sets `payload` to the bytes a sealCacheEntry footer covers.
+ * @return false if `bytes` has no footer or its checksum does not match.
+ */
+bool unsealCacheEntry(llvm::StringRef bytes, llvm::StringRef& payload);
+
+/**
+ * @brief Marks the cache file at `path` as used now, for eviction by least
+ *        recent use; its modification time is what evictCacheEntries orders by.
+ */
+void touchCacheFile(const std::string& path);
+
+/**
+ * @brief Bounds of a cache directory (--cache-max-size, --cache-max-age); 0 is unbounded.
+ */
+struct CacheLimits {
+    uint64_t maxBytes = 0;
+    std::chrono::seconds maxAge{0};
+
+    bool bounded() const { return maxBytes > 0 || maxAge.count() > 0; }
+};
+
+struct EvictionResult {
+    // Nothing was done: another process holds the lock, or evicted within EVICTION_INTERVAL
+    bool skipped = false;
+    std::size_t keptFiles = 0;
+    uint64_t keptBytes = 0;
+    std::size_t evictedFiles = 0;
+    uint64_t evictedBytes = 0;
+};
+
+// Eviction runs at most this often per cache directory, whatever number of processes share it
+constexpr std::chrono::seconds EVICTION_INTERVAL{60};
+
+/**
+ * @brief Removes the least recently used files under `cacheDir` until it
+ *        holds at most 90% of `limits.maxBytes`, and any unused for longer
+ *        than `limits.maxAge`.
+ *
+ * Every regular file counts, except the clang module cache under modules/,
+ * which clang prunes itself. Temporary files of writers that died are
+ * removed once an hour old. A process holding an evicted entry open or
+ * mapped keeps reading it, and a later lookup simply misses, so readers
+ * take no lock. Evicting processes serialize on a lock file in `cacheDir`
+ * without waiting: while one holds it, or did within EVICTION_INTERVAL, the
+ * others skip.
+ */
+EvictionResult evictCacheEntries(const std::string& cacheDir, const CacheLimits& limits);
+
+/**
+ * @class BackgroundEviction
+ * @brief Runs evictCacheEntries on a thread of its own while the caller goes
+ *        on; waited for when destroyed.
+ */
+class BackgroundEviction {
+public:
+    BackgroundEviction(std::string cacheDir, CacheLimits limits);
+    ~BackgroundEviction();
+
+    BackgroundEviction(const BackgroundEviction&) = delete;
+    BackgroundEviction& operator=(const BackgroundEviction&) = delete;
+
+private:
+    std::thread thread;
+};
+
+}
@@ -36,7 +36,9 @@ enum class OverAllStatus{
   NON_FUNCTIONAL_CHANGES = 6,
   IN_ACTIVE = 7,
   CATEGORIZATION_ERROR=8,
-  NOT_CATEGORIZED = 9
+  NOT_CATEGORIZED = 9,
+  // Parsing a version ran past --header-timeout; nothing was compared
+  TIMED_OUT = 10
 };
 
 const char* serialize(OverAllStatus status);
@@ -0,0 +1,62 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+
+namespace armor {
+
+/**
+ * @brief Inclusive range of 1-based source lines.
+ */
+struct LineRange {
+    unsigned begin;
+    unsigned end;
+};
+
+/**
+ * @brief Lines changed in one header, on each side of the comparison.
+ */
+struct HeaderChanges {
+    std::vector<LineRange> oldLines;
+    std::vector<LineRange> newLines;
+
+    /**
+     * @brief Checks whether [begin, end] overlaps any range of `lines`.
+     */
+    static bool intersects(const std::vector<LineRange>& lines, unsigned begin, unsigned end);
+};
+
+/**
+ * @class ChangedRanges
+ * @brief Per-header changed line ranges, as produced from `git diff -U0`.
+ *
+ * The input is a JSON object keyed by header path relative to the project
+ * root:
+ *
+ *     { "include/foo.h": { "old": [[10, 12]], "new": [[10, 14]] } }
+ *
+ * A pure insertion or deletion is recorded as the single line it sits at on
+ * the side where it has no lines, so declarations around it count as touched.
+ */
+class ChangedRanges {
+public:
+    /**
+     * @brief Loads a changed ranges file.
+     * @throws std::runtime_error if the file cannot be read or is malformed.
+     */
+    static ChangedRanges load(const std::string& path);
+
+    /**
+     * @brief Returns the changes recorded for `file` under `projectRoot`, or nullptr if none.
+     */
+    const HeaderChanges* find(const std::string& projectRoot, const std::string& file) const;
+
+private:
+    llvm::StringMap<HeaderChanges> headers;
+};
+
+}
@@ -0,0 +1,87 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @brief Splits `bytes` at content-defined boundaries.
+ *
+ * A boundary is placed where a rolling hash of the last 64 bytes has its top
+ * bits clear, so the chunks are about 80 KiB, never under 16 KiB unless the
+ * last, and never over 256 KiB. As boundaries depend only on nearby bytes,
+ * an edit changes the chunks around it and the boundaries after it fall
+ * where they did before, so two versions of an entry share their other
+ * chunks. The boundaries are the same on every machine and build.
+ *
+ * @return Views of consecutive ranges of `bytes` covering all of it; none for empty bytes.
+ */
+std::vector<llvm::StringRef> splitIntoChunks(llvm::StringRef bytes);
+
+/**
+ * @class ChunkStore
+ * @brief Content-addressed chunks of cache entries, kept under chunks/ of a cache directory.
+ *
+ * An entry is stored as a manifest listing the keys of its chunks (see
+ * splitIntoChunks) and each chunk once under its key, so entries of
+ * consecutive versions of a header, which differ in a few chunks, share the
+ * rest. A key is the xxHash64 and size of the chunk's bytes, and a chunk is
+ * checked against its key whenever it is read, as the manifest checks the
+ * reassembled entry against a checksum of its own.
+ *
+ * Chunk files are written to a temporary file and renamed into place, so
+ * processes may share the directory, and count for --cache-max-size like
+ * any cache file; a manifest whose chunk was evicted just fails to assemble.
+ */
+class ChunkStore {
+public:
+    /** @brief Creates a store under `cacheDir`; the directory is created on first store. */
+    explicit ChunkStore(const std::string& cacheDir);
+
+    static std::string keyOf(llvm::StringRef chunk);
+
+    /**
+     * @brief The manifest of `bytes`.
+     * @param chunks Set to the chunks of `bytes`, in the order the manifest lists their keys.
+     */
+    static std::string manifestOf(llvm::StringRef bytes, std::vector<llvm::StringRef>& chunks);
+
+    /** @brief Whether the chunk stored under `key` is held, without reading it. */
+    bool contains(const std::string& key) const;
+
+    /**
+     * @brief Stores `chunk` under its key, keyOf(`chunk`).
+     *
+     * Failures are logged and otherwise ignored; the chunk is then fetched again when needed.
+     */
+    void store(llvm::StringRef chunk) const;
+
+    /**
+     * @brief Reassembles the bytes `manifest` lists.
+     *
+     * Chunks not held are asked from `fetch`, which returns false for one
+     * it cannot supply; what it supplies is checked against the key and
+     * stored. Every chunk used is marked as recently used.
+     *
+     * @param fetched If not null, set to the number of chunks `fetch` supplied.
+     * @return false if `manifest` is not one, a chunk cannot be had, or the
+     *         reassembled bytes fail the manifest's checksum.
+     */
+    bool assemble(llvm::StringRef manifest,
+                  const std::function<bool(const std::string& key, std::string& chunk)>& fetch,
+                  std::string& bytes, std::size_t* fetched = nullptr) const;
+
+private:
+    std::string chunkPath(const std::string& key) const;
+
+    std::string chunkDir;
+};
+
+}
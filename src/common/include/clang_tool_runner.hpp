@@ -0,0 +1,106 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "comm_def.hpp"
+
+namespace clang { namespace tooling {
+    class CompilationDatabase;
+    class FrontendActionFactory;
+} }
+
+namespace llvm { namespace vfs {
+    class FileSystem;
+} }
+
+namespace armor {
+
+class SourceBuffers;
+
+/** Creates the file system layered over the real one for one tool. */
+using ToolFileSystemFactory = std::function<llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>()>;
+
+/**
+ * @brief Layers a file system over the real one in every tool created afterwards.
+ *
+ * `factory` is called once per tool, since each tool moves the working
+ * directory of its file system. Meant to be set before any header is parsed;
+ * an empty factory parses from disk only.
+ */
+void setToolFileSystemOverlay(ToolFileSystemFactory factory);
+
+/**
+ * @brief Parses with the lean frontend profile in every tool created afterwards (--lean-frontend).
+ *
+ * Adds -Wno-everything, -fno-spell-checking and backtrace limits of 1 to
+ * every command line, and drops the include stacks of notes. Tools already
+ * run -fsyntax-only. A header that parses cleanly normalizes identically
+ * either way; one with errors may be reported with fewer diagnostics, and
+ * one that only failed on warnings made errors (-Werror) now parses.
+ */
+void setLeanFrontend(bool enabled);
+
+/**
+ * @brief Runs a frontend action over one header with ARMOR's diagnostic setup.
+ *
+ * Builds a ClangTool for `fileName`, wires a BufferedDiagnosticConsumer into
+ * it (flushed to the log sink in one write once the TU finishes, a failure
+ * logged with its error and missing include counts) and applies the common
+ * diagnostic argument adjusters.
+ *
+ * @param fileName Header to parse.
+ * @param compDB   Compilation database providing the command line.
+ * @param factory  Factory producing the action to run.
+ * @return PARSING_STATUS FATAL_ERRORS if the TU failed to compile, NO_FATAL_ERRORS otherwise.
+ */
+PARSING_STATUS runFrontendAction(const std::string& fileName,
+                                 const clang::tooling::CompilationDatabase& compDB,
+                                 clang::tooling::FrontendActionFactory& factory);
+
+/**
+ * @brief runFrontendAction for a source that only exists in memory.
+ *
+ * `contents` is mapped into the tool's file system at `fileName`, which is
+ * parsed as if it were on disk; its includes resolve against the real files.
+ *
+ * @param fileName Path the source is parsed as; needs a command in `compDB`.
+ * @param contents Text of the source.
+ */
+PARSING_STATUS runFrontendActionOnBuffer(const std::string& fileName,
+                                         llvm::StringRef contents,
+                                         const clang::tooling::CompilationDatabase& compDB,
+                                         clang::tooling::FrontendActionFactory& factory);
+
+/**
+ * @brief Runs a frontend action over several headers through one ClangTool.
+ *
+ * The headers share the tool's FileManager and file system, so stat results
+ * and tool setup are amortized over the batch. The diagnostics of each
+ * header reach the log in one write once that header is done.
+ *
+ * @param fileNames Headers to parse.
+ * @param compDB    Compilation database with a command for every header.
+ * @param factory   Factory producing the action to run; the actions receive
+ *                  the absolute path of their header (see mapBatchInputs).
+ * @param buffers   Unsaved files layered over all others, headers included; may be nullptr.
+ * @return The status of every header, in the order of `fileNames`.
+ */
+std::vector<PARSING_STATUS> runFrontendActionBatch(const std::vector<std::string>& fileNames,
+                                                   const clang::tooling::CompilationDatabase& compDB,
+                                                   clang::tooling::FrontendActionFactory& factory,
+                                                   const SourceBuffers* buffers = nullptr);
+
+/**
+ * @brief Maps the absolute path ClangTool hands to an action back to the caller's file name.
+ */
+llvm::StringMap<std::string> mapBatchInputs(const std::vector<std::string>& fileNames);
+
+}
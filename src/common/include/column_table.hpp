@@ -0,0 +1,60 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <nlohmann/json.hpp>
+
+namespace armor {
+
+/**
+ * @class ColumnTable
+ * @brief Rows appended a value per column, kept and written column by column.
+ *
+ * A string column stores each distinct value once, in a dictionary in order
+ * of first appearance, and a row as its index there; names, kinds and types
+ * repeat a lot across an API. toJson() gives
+ *
+ *     {"rows": N, "columns": [{"name": ..., "type": "string",
+ *                              "dictionary": [...], "indices": [...]},
+ *                             {"name": ..., "type": "int64", "values": [...]}, ...]}
+ *
+ * with the columns in the order they were added.
+ */
+class ColumnTable {
+public:
+    /** @brief Adds a dictionary-encoded string column; appended to by its returned index. */
+    std::size_t addStringColumn(std::string name);
+
+    /** @brief Adds an integer column; appended to by its returned index. */
+    std::size_t addIntColumn(std::string name);
+
+    void append(std::size_t column, llvm::StringRef value);
+    void append(std::size_t column, int64_t value);
+
+    /** @brief Rows of the table; every column must have had a value appended for each. */
+    std::size_t rows() const;
+
+    nlohmann::json toJson() const;
+
+private:
+    struct Column {
+        std::string name;
+        bool isString = false;
+        // String columns: distinct values by first appearance, and their indices
+        std::vector<std::string> dictionary;
+        llvm::StringMap<int64_t> dictionaryIndex;
+        // Dictionary indices of a string column, values of an integer column
+        std::vector<int64_t> values;
+    };
+
+    std::vector<Column> columns;
+};
+
+}
@@ -66,10 +66,20 @@ enum LANG_OPTIONS{
     CPP = 1
 };
 
+// FULL_MODE tracks comments and preprocessor regions besides the API nodes;
+// API_ONLY_MODE builds the normalized node tree alone
+enum PARSE_MODE{
+    FULL_MODE = 0,
+    API_ONLY_MODE = 1
+};
+
 // Language option string constants
 const std::string LANG_C = "c";
 const std::string LANG_CPP = "cpp";
 
+const std::string MODE_FULL = "full";
+const std::string MODE_API_ONLY = "api-only";
+
 const std::string LOG_FILE_PATH = "debug_output/logs/diagnostics.log";
 
 const std::string TEST_LOG_FILE_PATH = "output.txt";
\ No newline at end of file
@@ -0,0 +1,43 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+#include <vector>
+#include "comm_def.hpp"
+
+namespace armor {
+
+/**
+ * @brief Builds the part of the clang command line shared by every header of a project version.
+ *
+ * The built-in language flags, the user include paths resolved against the
+ * project root and the user macro flags; buildCompileFlags appends the
+ * header-specific include paths to this.
+ */
+std::vector<std::string> buildBaseCompileFlags(const std::string& projectRoot,
+                                               const std::vector<std::string>& includePaths,
+                                               const std::vector<std::string>& macroFlags,
+                                               LANG_OPTIONS lang);
+
+/**
+ * @brief Builds the clang command line used to parse one version of a header.
+ *
+ * The result contains, in order: the built-in language flags, the user include
+ * paths resolved against the project root, the user macro flags, and a -I for
+ * every directory from the header's own directory up to the project root.
+ *
+ * @param projectRoot  Root directory of the project version being parsed.
+ * @param headerPath   Path of the header inside projectRoot.
+ * @param includePaths Include paths relative to projectRoot.
+ * @param macroFlags   Extra macro flags passed verbatim.
+ * @param lang         Language mode selecting the built-in flags.
+ * @return std::vector<std::string> Flags for a FixedCompilationDatabase.
+ */
+std::vector<std::string> buildCompileFlags(const std::string& projectRoot,
+                                           const std::string& headerPath,
+                                           const std::vector<std::string>& includePaths,
+                                           const std::vector<std::string>& macroFlags,
+                                           LANG_OPTIONS lang);
+
+}
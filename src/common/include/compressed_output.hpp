@@ -0,0 +1,102 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace armor {
+
+/** Extension of the files written gzip-compressed. */
+constexpr llvm::StringLiteral GZIP_EXTENSION = ".gz";
+
+/** @brief Whether `path` names a gzip-compressed file. */
+inline bool isGzipPath(llvm::StringRef path) {
+    return path.endswith(GZIP_EXTENSION);
+}
+
+/**
+ * @class GzipEncoder
+ * @brief Compresses a byte stream into one gzip member as it is written.
+ *
+ * Compressed bytes are handed to the sink as soon as zlib produces them, so
+ * neither the input nor the output is ever held whole. Members written one
+ * after another, as by appending runs to one file, read back as one stream.
+ */
+class GzipEncoder {
+public:
+    using Sink = std::function<void(const char* data, std::size_t size)>;
+
+    /** @throws std::runtime_error if zlib cannot be initialized. */
+    explicit GzipEncoder(Sink sink);
+
+    /** Does not finish the member; finish() must be called for a readable member. */
+    ~GzipEncoder();
+
+    GzipEncoder(const GzipEncoder&) = delete;
+    GzipEncoder& operator=(const GzipEncoder&) = delete;
+
+    void write(const char* data, std::size_t size);
+
+    /** @brief Hands everything written so far to the sink, decodable without the rest. */
+    void sync();
+
+    /** @brief Writes out what is pending and the gzip trailer; later calls do nothing. */
+    void finish();
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+/**
+ * @class GzipOStream
+ * @brief std::ostream writing gzip-compressed to another stream.
+ *
+ * Used for the --dump-ast-diff dumps; the target stream must outlive this one.
+ */
+class GzipOStream : public std::ostream {
+public:
+    explicit GzipOStream(std::ostream& target);
+
+    /** Finishes the member unless finish() did. */
+    ~GzipOStream() override;
+
+    /** @brief Writes the gzip trailer to the target; no output may follow. */
+    void finish();
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer;
+};
+
+/**
+ * @class GzipRawOStream
+ * @brief llvm::raw_ostream writing gzip-compressed to the stream it owns.
+ *
+ * Used for a diagnostics log named *.gz. The member is finished when the
+ * stream is destroyed; a log cut short by a crash still decompresses up to
+ * the last flush, with a warning about the missing trailer.
+ */
+class GzipRawOStream : public llvm::raw_ostream {
+public:
+    explicit GzipRawOStream(std::unique_ptr<llvm::raw_ostream> target);
+    ~GzipRawOStream() override;
+
+private:
+    void write_impl(const char* data, size_t size) override;
+    uint64_t current_pos() const override { return written; }
+
+    std::unique_ptr<llvm::raw_ostream> target;
+    GzipEncoder encoder;
+    // Uncompressed bytes written
+    uint64_t written = 0;
+};
+
+}
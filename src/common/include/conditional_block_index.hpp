@@ -0,0 +1,185 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+/**
+ * @class ConditionalBlockIndex
+ * @brief The preprocessor ranges of one parse grouped by the conditional branch they sit in.
+ *
+ * Every branch of an #if, #ifdef or #ifndef chain, from the directive that
+ * opens it to the end of the one that closes it, is keyed by the text of its
+ * opening directive and those of the branches enclosing it, so a branch keeps
+ * its key when text elsewhere moves it. The directive and inactive ranges of
+ * a parse are recorded under their innermost branch with their hashes, and
+ * the snapshot is kept for the next parse of the same file (see
+ * ConditionalBlockCache).
+ *
+ * Against that snapshot, a branch found under the same key whose bytes the
+ * edit between the two buffers did not touch reads the same as before, so
+ * its ranges take their hashes from the snapshot instead of being hashed
+ * again. Ranges outside every conditional are always hashed.
+ */
+class ConditionalBlockIndex {
+public:
+    // Branch of ranges outside every conditional
+    static constexpr int NO_BRANCH = -1;
+
+    struct Branch {
+        uint64_t key = 0;
+        unsigned startOffset = 0;
+        unsigned endOffset = 0;
+        // Whether the directive ending the branch was seen, and endOffset set
+        bool closed = false;
+    };
+
+    /**
+     * @brief A parse's ranges by branch key, with the buffer they were hashed from.
+     */
+    struct Snapshot {
+        struct HashedRange {
+            // Relative to the start of the branch
+            unsigned startOffset;
+            unsigned endOffset;
+            uint64_t hash;
+            bool isActive;
+        };
+        struct Block {
+            unsigned startOffset = 0;
+            unsigned endOffset = 0;
+            // In the order recorded, which is source order
+            std::vector<HashedRange> ranges;
+        };
+
+        std::string text;
+        llvm::DenseMap<uint64_t, Block> blocks;
+    };
+
+    /** @brief Opens the first branch of a conditional at its #if, #ifdef or #ifndef line. */
+    void openConditional(llvm::StringRef directive, unsigned startOffset);
+
+    /**
+     * @brief Ends the current branch with the #elif or #else line [startOffset, endOffset)
+     *        and opens the next branch of its conditional there.
+     */
+    void nextBranch(llvm::StringRef directive, unsigned startOffset, unsigned endOffset);
+
+    /** @brief Ends the current branch, and its conditional, with the #endif line ending at `endOffset`. */
+    void closeConditional(unsigned endOffset);
+
+    /** @brief The innermost open branch, or NO_BRANCH. */
+    int currentBranch() const;
+
+    /**
+     * @brief The branch the last nextBranch or closeConditional ended, or NO_BRANCH.
+     *
+     * Clang reports the text it skipped in a branch after the directive ending it.
+     */
+    int lastClosedBranch() const { return lastClosed; }
+
+    const std::vector<Branch>& getBranches() const { return branches; }
+
+    /**
+     * @brief Looks up hashes in `previous`, the snapshot of the parse before, while
+     *        `text` is the buffer this parse hashes.
+     */
+    void reuseFrom(std::shared_ptr<const Snapshot> previous, llvm::StringRef text);
+
+    /**
+     * @brief The hash the parse before gave the range [startOffset, endOffset) of
+     *        `branch`, if the branch is unchanged since and had that range.
+     */
+    std::optional<uint64_t> previousHash(int branch, unsigned startOffset, unsigned endOffset, bool isActive);
+
+    /** @brief Records the hash of a range of `branch` in the snapshot taken by takeSnapshot. */
+    void record(int branch, unsigned startOffset, unsigned endOffset, bool isActive, uint64_t hash);
+
+    /** @brief The ranges recorded so far with a copy of `text`, their buffer. */
+    std::shared_ptr<const Snapshot> takeSnapshot(llvm::StringRef text);
+
+    /** @brief Branches whose ranges were taken from the parse before, and those hashed. */
+    std::size_t getReusedBranches() const { return reusedBranches; }
+    std::size_t getHashedBranches() const { return hashedBranches; }
+
+private:
+    enum class Reuse : uint8_t { UNKNOWN, REUSED, HASHED };
+
+    const Snapshot::Block* reusableBlock(int branch);
+
+    std::vector<Branch> branches;
+    // Open branches, innermost last
+    llvm::SmallVector<int, 8> open;
+    int lastClosed = NO_BRANCH;
+    // Branches keyed so far, by the key of their directive and nesting path
+    llvm::DenseMap<uint64_t, unsigned> occurrences;
+
+    std::shared_ptr<const Snapshot> previous;
+    // The bytes before prefixLength are shared with the previous buffer, as are those from suffixStart
+    unsigned prefixLength = 0;
+    unsigned suffixStart = 0;
+    // Previous offset minus current offset of the shared suffix
+    int64_t suffixShift = 0;
+    std::vector<Reuse> reuse;
+    std::vector<const Snapshot::Block*> reusedBlocks;
+    std::size_t reusedBranches = 0;
+    std::size_t hashedBranches = 0;
+
+    std::unique_ptr<Snapshot> recording;
+};
+
+/**
+ * @class ConditionalBlockCache
+ * @brief The ConditionalBlockIndex snapshot of the last parse of each file, shared by the parses of a process.
+ *
+ * Off until enabled, as the long-running modes do (see
+ * armor::ContextCache::keepEntriesInMemory). Thread-safe.
+ */
+class ConditionalBlockCache {
+public:
+    // The cache is emptied when its snapshots would hold more buffer bytes than this
+    static constexpr std::size_t DEFAULT_MAX_BYTES = std::size_t(256) << 20;
+
+    explicit ConditionalBlockCache(std::size_t maxBytes = DEFAULT_MAX_BYTES) : maxBytes(maxBytes) {}
+
+    /** @brief The cache shared by the parses of this process. */
+    static ConditionalBlockCache& getInstance();
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    /** @brief The snapshot of the last parse of `file`, or nullptr. */
+    std::shared_ptr<const ConditionalBlockIndex::Snapshot> find(llvm::StringRef file);
+
+    /** @brief Keeps `snapshot` as the last parse of `file`, replacing the one before. */
+    void store(llvm::StringRef file, std::shared_ptr<const ConditionalBlockIndex::Snapshot> snapshot);
+
+    /** @brief Counts the branches of one parse that were reused and hashed. */
+    void count(std::size_t reused, std::size_t hashed);
+
+    void clear();
+
+    std::size_t getReusedBranches() const { return reusedBranches; }
+    std::size_t getHashedBranches() const { return hashedBranches; }
+
+private:
+    std::atomic<bool> enabled{false};
+    std::size_t maxBytes;
+    std::mutex mutex;
+    llvm::StringMap<std::shared_ptr<const ConditionalBlockIndex::Snapshot>> snapshots;
+    std::size_t bytes = 0;
+    std::atomic<std::size_t> reusedBranches{0};
+    std::atomic<std::size_t> hashedBranches{0};
+};
@@ -8,7 +8,8 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "clang/Basic/LLVM.h"
-#include "llvm/ADT/StringRef.h"
+
+#include <utility>
 
 namespace armor {
 
@@ -20,6 +21,13 @@ static inline llvm::StringRef getUSRSpacePrefix() {
 /// \returns true if the results should be ignored, false otherwise.
 bool generateUSRForDecl(const clang::Decl *D, llvm::SmallVectorImpl<char> &Buf);
 
+/// Generate the USR and the NSR (see generateNSRForDecl) of a Decl in one
+/// traversal, appending to USRBuf and NSRBuf.
+/// \returns whether each result should be ignored, the USR's first.
+std::pair<bool, bool> generateUSRAndNSRForDecl(const clang::Decl *D,
+                                               llvm::SmallVectorImpl<char> &USRBuf,
+                                               llvm::SmallVectorImpl<char> &NSRBuf);
+
 /// Generate USR fragment for a global (non-nested) enum.
 void generateUSRForGlobalEnum(llvm::StringRef EnumName, llvm::raw_ostream &OS,
                               llvm::StringRef ExtSymbolDefinedIn = "");
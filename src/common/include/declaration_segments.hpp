@@ -0,0 +1,62 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @brief One top-level declaration of a header, as its raw tokens delimit it.
+ */
+struct DeclarationSegment {
+    // The declared name behind the namespaces enclosing it, or the text of a directive
+    std::string name;
+    // function, variable, struct, class, union, enum, typedef, alias, using, macro, directive or declaration
+    std::string kind;
+    // Hash of the tokens, so comments and layout do not count
+    uint64_t hash = 0;
+    // Line the declaration starts on, from 1
+    unsigned line = 0;
+};
+
+/**
+ * @brief Splits `text` into its top-level declarations without preprocessing or parsing it (--quick).
+ *
+ * Comments, layout and line splices are dropped and the rest is cut into
+ * tokens. A declaration runs to a semicolon outside of braces, or to the
+ * brace closing a function body. Namespaces and extern "C" blocks are
+ * entered, their declarations named behind the namespace; the braces of
+ * classes, enums and initializers are kept whole, so a changed member
+ * changes its class. Every preprocessor directive between declarations is
+ * one of its own, a #define named by its macro.
+ *
+ * Names are found by the shape of the tokens alone, so macros that expand
+ * to declaration syntax can make them wrong: the result is approximate.
+ */
+std::vector<DeclarationSegment> segmentDeclarations(llvm::StringRef text);
+
+/**
+ * @brief The declarations two versions of a header do not share, see quickDiff.
+ */
+struct QuickDiff {
+    std::vector<DeclarationSegment> added;
+    std::vector<DeclarationSegment> removed;
+    // The newer version of each declaration whose tokens changed
+    std::vector<DeclarationSegment> modified;
+};
+
+/**
+ * @brief Compares the segmentDeclarations of `text1` and `text2` by kind and name.
+ *
+ * Declarations sharing a kind and name, such as overloads, are first paired
+ * by equal hashes; the rest pair in order as modified, and those left over
+ * on one side were removed or added. Each list is in line order.
+ */
+QuickDiff quickDiff(llvm::StringRef text1, llvm::StringRef text2);
+
+}
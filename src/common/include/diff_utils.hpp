@@ -2,33 +2,49 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <llvm-14/llvm/ADT/ArrayRef.h>
 #include <llvm-14/llvm/ADT/SmallString.h>
+#include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/ADT/StringRef.h>
 #include <string>
+#include <string_view>
 #include "comm_def.hpp"
 
-extern std::string DATA_TYPE_PLACE_HOLDER;
+// Immutable, so sessions on any thread read them without synchronization
+inline constexpr std::string_view DATA_TYPE_PLACE_HOLDER = "(un-resolved Type)";
 
-extern std::string ADDED;
-extern std::string REMOVED;
-extern std::string MODIFIED;
-extern std::string REORDERED;
+inline constexpr std::string_view ADDED = "added";
+inline constexpr std::string_view REMOVED = "removed";
+inline constexpr std::string_view MODIFIED = "modified";
+inline constexpr std::string_view REORDERED = "re-ordered";
+inline constexpr std::string_view MOVED = "moved";
+inline constexpr std::string_view TYPE_CHANGED = "type_changed";
 
 // JSON keys
-extern std::string QUALIFIED_NAME;
-extern std::string NODE_TYPE;
-extern std::string TAG;
-extern std::string CHILDREN;
-extern std::string DATA_TYPE;
-extern std::string STORAGE_QUALIFIER;
-extern std::string CONST_QUALIFIER;
-extern std::string VIRTUAL_QUALIFIER;
-extern std::string INLINE;
-extern std::string PARSED_STATUS;
-extern std::string UNPARSED_STATUS;
-extern std::string HEADER_RESOLUTION_FAILURES;
-extern std::string AST_DIFF;
-extern std::string CONST_EXPR;
+inline constexpr std::string_view QUALIFIED_NAME = "qualifiedName";
+inline constexpr std::string_view OLD_QUALIFIED_NAME = "oldQualifiedName";
+inline constexpr std::string_view NODE_TYPE = "nodeType";
+inline constexpr std::string_view TAG = "tag";
+inline constexpr std::string_view CHILDREN = "children";
+inline constexpr std::string_view DATA_TYPE = "dataType";
+inline constexpr std::string_view STORAGE_QUALIFIER = "storageQualifier";
+inline constexpr std::string_view CONST_QUALIFIER = "constQualifier";
+inline constexpr std::string_view VIRTUAL_QUALIFIER = "virtualQualifier";
+inline constexpr std::string_view INLINE = "inline";
+inline constexpr std::string_view PARSED_STATUS = "parsed_status";
+inline constexpr std::string_view UNPARSED_STATUS = "unparsed_status";
+inline constexpr std::string_view HEADER_RESOLUTION_FAILURES = "headerResolutionFailures";
+inline constexpr std::string_view AST_DIFF = "astDiff";
+inline constexpr std::string_view CONST_EXPR = "constexpr";
+inline constexpr std::string_view LAYOUT = "layout";
+inline constexpr std::string_view NEW_TYPE = "newType";
+inline constexpr std::string_view AFFECTED = "affected";
+inline constexpr std::string_view SUMMARY = "summary";
+inline constexpr std::string_view DESCENDANTS = "descendants";
+inline constexpr std::string_view KINDS = "kinds";
+inline constexpr std::string_view NAMES = "names";
+inline constexpr std::string_view OLD_INDEX = "oldIndex";
+inline constexpr std::string_view NEW_INDEX = "newIndex";
 
 enum class ParsedDiffStatus {
     FATAL_ERRORS = 0,          // Critical errors occurred (e.g., header resolution failures)
@@ -43,16 +59,29 @@ enum class UnParsedDiffStatus{
     CHANGED = 1
 };
 
-const std::string serialize(const APINodeStorageClass& storageClass);
+const char* serialize(const APINodeStorageClass& storageClass);
 
-const std::string serialize(const VirtualQualifier& qualifier);
+const char* serialize(const VirtualQualifier& qualifier);
 
-const std::string serialize(const NodeKind& node);
+const char* serialize(const NodeKind& node);
 
-const std::string serialize(const std::string& str);
+const std::string& serialize(const std::string& str);
 
-const bool serialize(const bool& val);
+std::string serialize(llvm::StringRef str);
 
-const std::string serialize(const ParsedDiffStatus& diff_status);
+bool serialize(bool val);
 
-const std::string serialize(const UnParsedDiffStatus& diff_status);
\ No newline at end of file
+const char* serialize(const ParsedDiffStatus& diff_status);
+
+const char* serialize(const UnParsedDiffStatus& diff_status);
+
+/**
+ * @brief Marks the elements of one longest non-decreasing subsequence of `values`.
+ *
+ * `kept` is resized to `values` and set where the element belongs to the
+ * subsequence. Runs in O(n log n), with `tails` and `previous` as scratch.
+ * Given the positions of matched children in the newer version, in the
+ * order of the older one, the unmarked children are the fewest that moved.
+ */
+void markLongestNonDecreasing(llvm::ArrayRef<uint32_t> values, llvm::SmallVectorImpl<bool>& kept,
+                              llvm::SmallVectorImpl<uint32_t>& tails, llvm::SmallVectorImpl<uint32_t>& previous);
@@ -0,0 +1,57 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace armor {
+
+/**
+ * @class DigestManifest
+ * @brief Content digests of the headers one run compared, as found in its newer version.
+ *
+ * Written after every run and given to a later run as --base-manifest, whose
+ * older version is that newer one: a header whose digest, and include
+ * closure digest when one was recorded, still match is unchanged without
+ * reading the older tree. Stored keyed by header path relative to the
+ * project root, digests in hexadecimal:
+ *
+ *     { "format": 1, "headers": { "include/foo.h": { "digest": "9f3c...", "closure": "1a2b..." } } }
+ */
+class DigestManifest {
+public:
+    struct Entry {
+        // xxHash64 of the header
+        uint64_t digest = 0;
+        // IncludeGraph::closureDigest of the header, when its includes were known
+        bool hasClosure = false;
+        uint64_t closure = 0;
+    };
+
+    /**
+     * @brief Loads a manifest written by an earlier run.
+     * @throws std::runtime_error if the file cannot be read or is malformed.
+     */
+    static DigestManifest load(const std::string& path);
+
+    /**
+     * @brief Writes the manifest to `path`, replacing it atomically.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save(const std::string& path) const;
+
+    /** @brief Entry recorded for `header`, false if it has none. */
+    bool find(const std::string& header, Entry& entry) const;
+
+    void record(const std::string& header, const Entry& entry);
+
+    std::size_t size() const { return headers.size(); }
+
+private:
+    // Ordered, so manifests of the same tree are identical
+    std::map<std::string, Entry> headers;
+};
+
+}
@@ -0,0 +1,49 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+namespace armor {
+
+/**
+ * @class EventStream
+ * @brief Lifecycle events of a run, one JSON object per line (--events ndjson).
+ *
+ * Every line holds the name of the event as "event", the seconds since the
+ * stream was opened as "time", and the members the event adds. A line is
+ * written whole under a lock, in one write() when it fits, so lines of
+ * concurrent threads and of --isolate workers, which inherit the stream, do
+ * not interleave. Closed, the stream drops events. Thread-safe.
+ */
+class EventStream {
+public:
+    static EventStream& getInstance();
+
+    /**
+     * @brief Starts writing events to `target`: "-" for stdout, or a path,
+     *        e.g. of a FIFO, which is opened for appending and created as a
+     *        regular file if it does not exist. Opening a FIFO waits for a reader.
+     * @throws std::runtime_error if `target` cannot be opened.
+     */
+    void open(const std::string& target);
+
+    void close();
+
+    bool isOpen() const;
+
+    /** @brief Writes the event `event` with `fields`, a JSON object; nothing if closed. */
+    void emit(const char* event, nlohmann::json fields = nlohmann::json::object());
+
+private:
+    mutable std::mutex mutex;
+    int fd = -1;
+    bool ownsFd = false;
+    std::chrono::steady_clock::time_point start;
+};
+
+}
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace clang {
@@ -13,18 +14,35 @@ namespace clang {
 }
 
 /**
- * FibonacciHash - A fast, non-cryptographic hash function based on the golden ratio.
+ * FibonacciHash - Fast, non-cryptographic hashes of source text.
  * 
- * This implementation uses the Fibonacci hashing technique which multiplies by
- * a constant derived from the golden ratio (φ = 1.618...) to achieve excellent
- * hash distribution with minimal collisions for typical string data.
- * 
- * The algorithm is optimized for speed over security and provides good avalanche
- * properties for text hashing applications.
+ * The 64-bit hashes key the hash multisets of comments and unhandled
+ * declarations. They run four independent lanes over 32-byte stripes, as
+ * XXH3 does, so long texts hash at several bytes per cycle.
+ *
+ * A 64-bit collision between an old and a new text would hide a change, so
+ * the same bytes can also be digested to 128 bits. Digests are only taken
+ * when two versions' 64-bit hashes match (see RangeDigests), which keeps
+ * the cost off the common path of hashing.
  */
 class FibonacciHash {
 
 public:
+    /**
+     * 128-bit digest of the bytes a hash covers, from two independently
+     * seeded hashes.
+     */
+    struct Digest128 {
+        uint64_t low = 0;
+        uint64_t high = 0;
+
+        bool operator==(const Digest128& other) const { return low == other.low && high == other.high; }
+        bool operator!=(const Digest128& other) const { return !(*this == other); }
+        bool operator<(const Digest128& other) const {
+            return low != other.low ? low < other.low : high < other.high;
+        }
+    };
+
     /**
      * Compute hash for std::string
      */
@@ -49,10 +67,18 @@ public:
      * @return Hash value, or 0 if range is invalid
      */
     static uint64_t hashFromSourceRange(clang::SourceManager* SM, clang::SourceRange Range);
+
+    /**
+     * Resolve the main file offsets hashFromSourceRange hashes for Range.
+     * A range whose ends coincide is extended to the end of its token.
+     *
+     * @return false if the range is invalid
+     */
+    static bool offsetsFromSourceRange(clang::SourceManager* SM, clang::SourceRange Range,
+                                       unsigned& startOffset, unsigned& endOffset);
     
     /**
-     * Compute normalized hash from file offsets using Clang Lexer.
-     * Excludes comments, normalizes whitespace, and hashes only tokens.
+     * Compute normalized hash from main file offsets, see hashNormalizedSource.
      * 
      * @param SM Source manager for accessing source text
      * @param startOffset Starting byte offset in the main file
@@ -61,12 +87,48 @@ public:
      */
     static uint64_t hashFromOffsets(clang::SourceManager* SM, unsigned startOffset, unsigned endOffset);
 
+    /**
+     * Compute normalized hash of buffer[startOffset, endOffset) in a single scan.
+     * Excludes comments, line splices and all whitespace outside string and
+     * character literals, and hashes the remaining bytes: the spellings of
+     * the tokens clang's raw lexer finds in the range, back to back. A token
+     * crossing endOffset is cut at it.
+     * 
+     * @param buffer Source text the offsets refer to
+     * @param startOffset Starting byte offset, outside any comment or literal
+     * @param endOffset Ending byte offset (exclusive)
+     * @return Hash value, or 0 if offsets are invalid
+     */
+    static uint64_t hashNormalizedSource(llvm::StringRef buffer, unsigned startOffset, unsigned endOffset);
+
+    /**
+     * 128-bit digest of the bytes hash() hashes, that is every non-whitespace byte.
+     */
+    static Digest128 digest(llvm::StringRef text);
+
+    /**
+     * 128-bit digest of the bytes hashNormalizedSource hashes.
+     *
+     * @return A zero digest if offsets are invalid
+     */
+    static Digest128 digestNormalizedSource(llvm::StringRef buffer, unsigned startOffset, unsigned endOffset);
+
+    /**
+     * Enumerate the bytes hashNormalizedSource hashes, as runs of
+     * onRun(offset, length) into `buffer`, in order.
+     */
+    static void forEachNormalizedRun(llvm::StringRef buffer, unsigned startOffset, unsigned endOffset,
+                                     llvm::function_ref<void(size_t, size_t)> onRun);
+
+    /**
+     * Enumerate the bytes hash() hashes, that is every non-whitespace byte,
+     * as runs of onRun(offset, length) into `text`, in order.
+     */
+    static void forEachNonWhitespaceRun(llvm::StringRef text, llvm::function_ref<void(size_t, size_t)> onRun);
+
 private:
     /**
      * Core hashing algorithm implementation
      */
     static uint64_t fibonacci_hash_impl(const uint8_t* data, size_t length);
-
-    // Golden ratio constant: 2^64 / φ where φ = (1 + √5) / 2
-    static constexpr uint64_t GOLDEN_RATIO_64 = 0x9E3779B97F4A7C15ULL;
 };
\ No newline at end of file
@@ -0,0 +1,143 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+namespace armor {
+
+/**
+ * @class SharedFileCache
+ * @brief Stat results and file contents shared by every tool of a process.
+ *
+ * Each ClangTool has a FileManager of its own, which would stat and read
+ * every include again for every header. Tools reading through wrap() share
+ * the results instead: each path is stat'ed once, missing paths included,
+ * and each file read once. Entries are kept until revalidate() finds the
+ * file's size or modification time changed.
+ *
+ * Buffers handed out stay valid until revalidate(), forget() or clear(),
+ * which must not run while a tool is parsing.
+ */
+class SharedFileCache {
+public:
+    // Files are no longer cached once this many bytes are; stat results still are
+    static constexpr std::size_t DEFAULT_MAX_BUFFER_BYTES = std::size_t(512) << 20;
+
+    explicit SharedFileCache(std::size_t maxBufferBytes = DEFAULT_MAX_BUFFER_BYTES)
+        : maxBufferBytes(maxBufferBytes) {}
+
+    /** @brief The cache shared by the tools of this process. */
+    static SharedFileCache& getInstance();
+
+    /**
+     * @brief File system over `underlying` that stats and reads through this cache.
+     *
+     * One per tool: the working directory stays that of `underlying`, while
+     * the entries, keyed by absolute path, are shared. Thread-safe.
+     */
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> wrap(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying);
+
+    /**
+     * @brief Answers the lookups of missing paths under `root` from directory listings.
+     *
+     * Header search probes every -I directory in turn, and under a project
+     * root that is the whole chain of ancestors of the header. Under a listed
+     * tree each directory is read once, when first probed, and a path missing
+     * from its directory is answered without a stat. Files created under the
+     * tree after their directory was read would not be found, so directories
+     * armor writes into belong in `excluded`. Paths through symbolic links and
+     * ".." are looked up as usual.
+     */
+    void listTree(llvm::StringRef root, const std::vector<std::string>& excluded = {});
+
+    void clearListedTrees();
+
+    /**
+     * @brief Leaves the paths under `dirs` to the file system, replacing the
+     *        previous list: directories clang writes into while parsing, such
+     *        as the implicit module cache, whose files must be found as soon
+     *        as they are written.
+     */
+    void setUncachedTrees(const std::vector<std::string>& dirs);
+
+    /**
+     * @brief Stats every cached path again and drops the entries whose file
+     *        appeared, disappeared, or changed size or modification time.
+     *        Directory listings are read again as well.
+     * @return Number of entries dropped.
+     */
+    std::size_t revalidate();
+
+    /** @brief Drops the entry of `absolutePath`, e.g. a file armor just wrote. */
+    void forget(llvm::StringRef absolutePath);
+
+    void clear();
+
+    /** @brief Stats and opens answered from the cache. */
+    uint64_t getHits() const { return hits.load(std::memory_order_relaxed); }
+
+    /** @brief Stats and opens that went to the underlying file system. */
+    uint64_t getMisses() const { return misses.load(std::memory_order_relaxed); }
+
+    std::size_t getBufferBytes() const;
+
+private:
+    class CachingFileSystem;
+
+    struct Entry {
+        llvm::ErrorOr<llvm::vfs::Status> status = std::make_error_code(std::errc::no_such_file_or_directory);
+        // Contents of a regular file once it was opened, null terminated
+        std::shared_ptr<const llvm::MemoryBuffer> buffer;
+    };
+
+    struct ListedTree {
+        std::string root;
+        std::vector<std::string> excluded;
+    };
+
+    // Names in one directory, and whether each is a directory
+    using Listing = llvm::StringMap<bool>;
+
+    // Whether `path` lies under one of the uncached trees
+    bool isUncached(llvm::StringRef path) const;
+
+    // Cached entry of `path`, or null
+    std::shared_ptr<const Entry> lookup(llvm::StringRef path) const;
+
+    // Whether the listings of a listed tree show that `path` does not exist;
+    // directories not read yet are listed through `fs`
+    bool knownMissing(llvm::StringRef path, llvm::vfs::FileSystem& fs);
+
+    // Listing of `dir`, read through `fs` the first time; null if it cannot be read
+    std::shared_ptr<const Listing> listing(const std::string& dir, llvm::vfs::FileSystem& fs);
+
+    // Keeps `entry` for `path` unless one is there already; returns the one kept
+    std::shared_ptr<const Entry> insert(llvm::StringRef path, std::shared_ptr<const Entry> entry);
+
+    std::size_t maxBufferBytes;
+    mutable std::shared_mutex mutex;
+    llvm::StringMap<std::shared_ptr<const Entry>> entries;
+    std::vector<ListedTree> listedTrees;
+    std::vector<std::string> uncachedTrees;
+    llvm::StringMap<std::shared_ptr<const Listing>> listings;
+    std::size_t bufferBytes = 0;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+};
+
+}
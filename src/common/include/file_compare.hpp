@@ -0,0 +1,23 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+namespace armor {
+
+/**
+ * @brief Checks whether two files differ byte for byte, without spawning a process.
+ *
+ * Sizes are compared first; only same-sized files are mapped (via
+ * llvm::MemoryBuffer, which mmaps large files) and compared with memcmp.
+ * A file that cannot be read is reported as different, matching `diff -q`
+ * which exits non-zero on errors.
+ *
+ * @param file1 Path of the first file.
+ * @param file2 Path of the second file.
+ * @return true if the contents differ or either file cannot be read.
+ */
+bool filesDiffer(const std::string& file1, const std::string& file2);
+
+}
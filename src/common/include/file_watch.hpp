@@ -0,0 +1,26 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace armor {
+
+/**
+ * @brief Calls `run` once, then again after every change of a file under
+ *        `root`, for as long as `run` returns true (--watch).
+ *
+ * `run` is given the paths that changed since its last call, empty the
+ * first time. Changes arriving less than 200 ms apart, such as the writes of
+ * one save, make one call. Changes under `excluded`, the directories the
+ * runs write to, are ignored. Directories created under `root` are watched
+ * too. Uses inotify.
+ *
+ * @return false if `root` cannot be watched, before `run` is called.
+ */
+bool watchAndRerun(const std::string& root, const std::vector<std::string>& excluded,
+                   const std::function<bool(const std::vector<std::string>& changed)>& run);
+
+}
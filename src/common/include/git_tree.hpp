@@ -0,0 +1,125 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem/UniqueID.h"
+
+namespace llvm { namespace vfs {
+    class FileSystem;
+} }
+
+namespace armor {
+
+/**
+ * @brief Reads blobs of a git repository through one long-lived `git cat-file --batch`.
+ *
+ * Every blob is read once and then served from memory for the lifetime of
+ * the store, so revisions sharing a file share its contents. Thread-safe.
+ */
+class GitObjectStore {
+public:
+    /** @throws std::runtime_error if git cannot be started. */
+    explicit GitObjectStore(std::string repoPath);
+
+    /** Closes the cat-file process. */
+    ~GitObjectStore();
+
+    const std::string& getRepoPath() const { return repoPath; }
+
+    /**
+     * @brief Contents of the blob `oid`, null terminated.
+     *
+     * @throws std::runtime_error if the object is missing or git fails.
+     */
+    llvm::StringRef readBlob(const std::string& oid);
+
+    GitObjectStore(const GitObjectStore&) = delete;
+    GitObjectStore& operator=(const GitObjectStore&) = delete;
+
+private:
+    std::string repoPath;
+
+    std::mutex mutex;
+    int pid = -1;
+    FILE* toGit = nullptr;
+    FILE* fromGit = nullptr;
+    llvm::StringMap<std::unique_ptr<std::string>> blobs;
+};
+
+/**
+ * @brief The file tree of one revision, mounted at a directory path.
+ *
+ * The listing comes from one `git ls-tree`; contents are only read, through
+ * the shared GitObjectStore, for the files that are opened. Paths are looked
+ * up as the absolute paths they have under the mount point, with symbolic
+ * links of the tree resolved inside it.
+ */
+class GitRevisionTree {
+public:
+    struct Entry {
+        std::string oid;
+        uint64_t size = 0;
+        llvm::sys::fs::UniqueID uniqueId;
+        bool isDirectory = false;
+        bool isSymlink = false;
+    };
+
+    /**
+     * @param store      Object store of the repository.
+     * @param rev        Any revision git accepts, e.g. a branch, tag or commit id.
+     * @param mountPoint Absolute directory the tree appears at.
+     * @throws std::runtime_error if `rev` cannot be listed.
+     */
+    GitRevisionTree(std::shared_ptr<GitObjectStore> store, const std::string& rev, std::string mountPoint);
+
+    const std::string& getMountPoint() const { return mountPoint; }
+
+    /**
+     * @brief Entry at the absolute `path`; the mount point itself is the root directory.
+     *
+     * @return nullptr if `path` is outside the mount point or not in the tree.
+     */
+    const Entry* lookup(llvm::StringRef path) const;
+
+    /** @brief Names of the files directly inside the directory at `path`, sorted. */
+    std::vector<std::string> listFiles(llvm::StringRef path) const;
+
+    /**
+     * @brief Contents of a file entry.
+     *
+     * @throws std::runtime_error if the blob cannot be read.
+     */
+    llvm::StringRef readFile(const Entry& entry) const;
+
+private:
+    // Repository-relative form of `path`, false outside the mount point
+    bool relativize(llvm::StringRef path, std::string& relative) const;
+    const Entry* resolve(const std::string& relative) const;
+
+    std::shared_ptr<GitObjectStore> store;
+    std::string mountPoint;
+    Entry root;
+    // Keyed by repository-relative path, directories included
+    llvm::StringMap<Entry> entries;
+};
+
+/**
+ * @brief Read-only file system serving a GitRevisionTree.
+ *
+ * Paths outside the mount point do not exist in it, so it is meant to be
+ * layered over the real file system. Directory iteration is not supported;
+ * header search only needs status and open.
+ */
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> createGitTreeFileSystem(std::shared_ptr<const GitRevisionTree> tree);
+
+}
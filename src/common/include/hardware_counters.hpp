@@ -0,0 +1,44 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor::profile {
+
+enum class HardwareEvent : uint8_t {
+    CYCLES,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    COUNT
+};
+
+constexpr std::size_t HARDWARE_EVENT_COUNT = static_cast<std::size_t>(HardwareEvent::COUNT);
+
+using HardwareSample = std::array<uint64_t, HARDWARE_EVENT_COUNT>;
+
+llvm::StringRef hardwareEventName(HardwareEvent event);
+
+/**
+ * @brief Reads the user-space hardware counters of the calling thread (--profile=hw).
+ *
+ * The counters are opened as one perf_event_open group on a thread's first
+ * read and closed when it exits. Totals are scaled up for the time the PMU
+ * multiplexed the group out; an event the CPU lacks stays 0.
+ * @return false, leaving `sample` alone, if the counters cannot be opened,
+ *         e.g. under perf_event_paranoid or in a container; see hardwareCountersError().
+ */
+bool readHardwareCounters(HardwareSample& sample);
+
+/**
+ * @brief Why a thread could not open its counters, empty if none failed.
+ */
+std::string hardwareCountersError();
+
+}
@@ -0,0 +1,110 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+
+/**
+ * @class HashMultiset
+ * @brief Counted set of 64-bit source hashes with an order-independent fingerprint.
+ *
+ * Every insertion and removal updates a fingerprint of the contents: the
+ * number of hashes and two sums of independently mixed hashes, all modulo
+ * 2^64. Equal multisets have equal fingerprints whatever order they were
+ * built in, so comparing two multisets is O(1); unequal ones collide with
+ * probability about 2^-128, far below the odds of the source hashes
+ * themselves colliding.
+ */
+class HashMultiset {
+public:
+    using Counts = llvm::DenseMap<uint64_t, int>;
+
+    struct Fingerprint {
+        uint64_t total = 0;
+        uint64_t sum = 0;
+        uint64_t mixedSum = 0;
+
+        // Fingerprints of disjoint parts of a multiset add up to the fingerprint of the whole
+        Fingerprint& operator+=(const Fingerprint& other) {
+            total += other.total;
+            sum += other.sum;
+            mixedSum += other.mixedSum;
+            return *this;
+        }
+        Fingerprint& operator-=(const Fingerprint& other) {
+            total -= other.total;
+            sum -= other.sum;
+            mixedSum -= other.mixedSum;
+            return *this;
+        }
+
+        bool operator==(const Fingerprint& other) const {
+            return total == other.total && sum == other.sum && mixedSum == other.mixedSum;
+        }
+        bool operator!=(const Fingerprint& other) const { return !(*this == other); }
+    };
+
+    HashMultiset() = default;
+    HashMultiset(const HashMultiset&) = default;
+    HashMultiset& operator=(const HashMultiset&) = default;
+
+    // A moved-from multiset is empty, fingerprint included
+    HashMultiset(HashMultiset&& other) noexcept
+        : counts(std::move(other.counts)), fingerprint(std::exchange(other.fingerprint, Fingerprint())) {
+        other.counts.clear();
+    }
+    HashMultiset& operator=(HashMultiset&& other) noexcept {
+        counts = std::move(other.counts);
+        fingerprint = std::exchange(other.fingerprint, Fingerprint());
+        other.counts.clear();
+        return *this;
+    }
+
+    /** @brief The fingerprint of a multiset holding `hash` once. */
+    static Fingerprint fingerprintOf(uint64_t hash);
+
+    /** @brief Adds `count` occurrences of `hash`; `count` must be positive. */
+    void insert(uint64_t hash, int count = 1);
+
+    /**
+     * @brief Removes one occurrence of `hash`.
+     * @return false if `hash` was not in the multiset.
+     */
+    bool eraseOne(uint64_t hash);
+
+    void clear();
+
+    /** @brief Occurrences of `hash`, 0 if absent. */
+    int count(uint64_t hash) const;
+
+    /** @brief Number of distinct hashes. */
+    std::size_t size() const { return counts.size(); }
+
+    bool empty() const { return counts.empty(); }
+
+    Counts::const_iterator begin() const { return counts.begin(); }
+    Counts::const_iterator end() const { return counts.end(); }
+
+    const Fingerprint& getFingerprint() const { return fingerprint; }
+
+    /** @brief Whether the two multisets hold different hashes or counts, from the fingerprints. */
+    bool differs(const HashMultiset& other) const;
+
+    /**
+     * @brief Exact comparison, walking the counts once.
+     *
+     * Equal distinct sizes and every count of this one matched by `other`
+     * imply the reverse direction, so one direction suffices.
+     */
+    bool countsDiffer(const HashMultiset& other) const;
+
+private:
+    void account(uint64_t hash, int64_t count);
+
+    Counts counts;
+    Fingerprint fingerprint;
+};
@@ -0,0 +1,43 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace armor {
+
+/**
+ * @class HeaderCompilationDatabase
+ * @brief Compilation database holding a separate command line for every header.
+ *
+ * Lets one ClangTool parse headers whose flags differ (each header adds its
+ * own directory chain to the include path). The command returned for a
+ * header is exactly what a FixedCompilationDatabase built from the same
+ * directory and flags returns, so both produce identical parses.
+ */
+class HeaderCompilationDatabase : public clang::tooling::CompilationDatabase {
+public:
+    /**
+     * @brief Registers the command line of `headerPath`.
+     * @param headerPath Header the flags apply to.
+     * @param directory  Working directory of the compile command.
+     * @param flags      Compiler flags, as for FixedCompilationDatabase.
+     */
+    void addHeader(const std::string& headerPath, const std::string& directory,
+                   const std::vector<std::string>& flags);
+
+    std::vector<clang::tooling::CompileCommand> getCompileCommands(llvm::StringRef filePath) const override;
+
+    std::vector<std::string> getAllFiles() const override;
+
+private:
+    // Keyed by absolute path, the form in which ClangTool asks for commands
+    llvm::StringMap<std::unique_ptr<clang::tooling::FixedCompilationDatabase>> headers;
+};
+
+}
@@ -0,0 +1,91 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @class HeaderCostHistory
+ * @brief Seconds each header took to compare in earlier runs (--cost-history).
+ *
+ * Stored as a JSON object keyed by header path relative to the project root:
+ *
+ *     { "format": 1, "headers": { "include/foo.h": 2.5 } }
+ *
+ * Only the latest measurement of a header is kept.
+ */
+class HeaderCostHistory {
+public:
+    /**
+     * @brief Loads a history file; a file that does not exist yet is an empty history.
+     * @throws std::runtime_error if the file cannot be read or is malformed.
+     */
+    static HeaderCostHistory load(const std::string& path);
+
+    /**
+     * @brief Writes the history to `path`, replacing it atomically.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save(const std::string& path) const;
+
+    /** @brief Seconds last recorded for `header`, false if it was never measured. */
+    bool find(const std::string& header, double& seconds) const;
+
+    void record(const std::string& header, double seconds);
+
+private:
+    // Ordered, so a saved history does not change between runs measuring the same
+    std::map<std::string, double> headers;
+};
+
+/** @brief Number of #include directives in `contents`. */
+unsigned countIncludeDirectives(llvm::StringRef contents);
+
+/**
+ * @brief Cost of a header never measured, in arbitrary units.
+ *
+ * Grows with the header's size and, as every include is parsed with it, with
+ * its number of includes.
+ */
+double estimateHeaderCost(uint64_t bytes, unsigned includeCount);
+
+/**
+ * @brief Predicted seconds to compare each of `headers`.
+ *
+ * A header in `history` costs what it last took. The others cost their entry
+ * of `estimates`, converted to seconds with the seconds per unit the measured
+ * headers took, or taken as seconds when none was measured.
+ */
+std::vector<double> predictHeaderCosts(const std::vector<std::string>& headers,
+                                       const std::vector<double>& estimates,
+                                       const HeaderCostHistory& history);
+
+/**
+ * @brief Indices of `costs` from the most to the least costly.
+ *
+ * Feeding a work pool in this order (longest processing time first) keeps a
+ * large header from starting last and holding up the end of the run. Ties
+ * keep their original order.
+ */
+std::vector<std::size_t> longestFirstOrder(const std::vector<double>& costs);
+
+/**
+ * @brief Splits items into `shardCount` shards of balanced total cost.
+ *
+ * Items are assigned longest first, each to the shard with the lowest total
+ * so far, the lowest numbered one on ties. The result only depends on
+ * `costs`, so every node computing it from the same costs agrees on it.
+ *
+ * @return The shard of every item, in [0, shardCount).
+ */
+std::vector<unsigned> partitionByCost(const std::vector<double>& costs, unsigned shardCount);
+
+}
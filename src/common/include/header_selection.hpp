@@ -0,0 +1,99 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace armor {
+
+/**
+ * @brief Lists the headers under several project roots in one parallel walk.
+ *
+ * Every subdirectory at the top of a root is walked by a task of its own,
+ * on up to `jobs` threads. Regular files whose name ends with one of
+ * `extensions` are listed, symbolic links are not followed.
+ *
+ * @return Paths relative to their root, found under any root, sorted and unique.
+ */
+std::vector<std::string> walkHeaderFiles(const std::vector<std::string>& roots,
+                                         const std::vector<std::string>& extensions, unsigned jobs);
+
+/**
+ * @struct HeaderDiscovery
+ * @brief Headers found under the two versions of a directory, relative to it, sorted.
+ */
+struct HeaderDiscovery {
+    // Under both versions
+    std::vector<std::string> common;
+    // Only under the older version
+    std::vector<std::string> removed;
+    // Only under the newer version
+    std::vector<std::string> added;
+};
+
+/**
+ * @brief Pairs the headers below `dir1` and `dir2` (--header-dir --recursive).
+ *
+ * Both directories are walked in the same parallel walk as walkHeaderFiles.
+ * A header whose relative path or file name matches one of the globs of
+ * `ignorePatterns` is left out, as is everything below a directory whose
+ * relative path matches one.
+ *
+ * @throws std::runtime_error if an ignore pattern is not a valid glob.
+ */
+HeaderDiscovery discoverHeaderPairs(const std::string& dir1, const std::string& dir2,
+                                    const std::vector<std::string>& extensions,
+                                    const std::vector<std::string>& ignorePatterns, unsigned jobs);
+
+/**
+ * @struct HeaderPatterns
+ * @brief The header patterns a branch config lists for each mode.
+ */
+struct HeaderPatterns {
+    std::vector<std::string> blocking;
+    std::vector<std::string> nonBlocking;
+};
+
+/**
+ * @brief Reads the patterns of `branch` from the config of the GitHub action:
+ *
+ *     branches:
+ *       main:
+ *         modes:
+ *           blocking:
+ *             headers: [include/api/, include/<name>.h]
+ *           non-blocking:
+ *             headers: [include/internal/util.h]
+ *
+ * A branch or mode the file does not list has no patterns.
+ *
+ * @throws std::runtime_error if the file cannot be read or is not valid YAML.
+ */
+HeaderPatterns loadHeaderPatterns(const std::string& configFile, const std::string& branch);
+
+/**
+ * @struct HeaderSelection
+ * @brief Headers the patterns of a branch select, sorted and unique.
+ */
+struct HeaderSelection {
+    std::vector<std::string> blocking;
+    std::vector<std::string> nonBlocking;
+    // Both of the above
+    std::vector<std::string> headers;
+};
+
+/**
+ * @brief Expands the patterns of both modes against the headers of `roots`.
+ *
+ * The roots are walked once (see walkHeaderFiles, with `.h` and `.hpp`) and
+ * each pattern is matched in memory, as action_script/parse_headers.sh
+ * expands it: a pattern ending with '/' or naming a directory under a root
+ * selects every header below it, one with `*`, `?` or `[` is a glob matched
+ * against whole relative paths (`*` matching '/' too), and any other names
+ * one header. A leading "./" is ignored. A header selected by both modes is
+ * listed in both.
+ */
+HeaderSelection selectHeaders(const HeaderPatterns& patterns, const std::vector<std::string>& roots, unsigned jobs);
+
+}
@@ -2,51 +2,171 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
-#include <string>
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
 
-const std::string ALPHA_HTML_HEADER = R"(
-<html><head><style>
-table { border-collapse: collapse; width: 100%; }
+// Reports are assembled from the chunks below, written one after another
+// with write_chunks(); the style rules shared by the pages are kept once
+
+inline constexpr std::string_view HTML_HEAD_OPEN = "\n<html><head><style>\n";
+
+inline constexpr std::string_view TABLE_STYLE = R"(table { border-collapse: collapse; width: 100%; }
 th, td { border: 1px solid black; padding: 8px; text-align: left; }
 th { background-color:#add8e6; }
 tr:nth-child(even) { background-color:#f2f2f2; }
 tr:hover { background-color: #ddd; }
-.backward-incompatible { color: red; }
-.backward-compatible { color: green; }
-</style></head><body><h1>API Compatibility Report</h1>
-<h2>ARMOR Report</h2>
-<p>Note: Compiler errors (For more info please run using DEBUG flags and check logs)</p>
-<table>
-<tr><th>Header Name</th><th>API Name</th><th>Description</th><th>Change Type</th><th>Source Compatibility</th></tr>
 )";
 
-const std::string BETA_HTML_HEADER = R"(
-<html><head><style>
-table { border-collapse: collapse; width: 100%; }
-th, td { border: 1px solid black; padding: 8px; text-align: left; }
-th { background-color:#add8e6; }
-tr:nth-child(even) { background-color:#f2f2f2; }
-tr:hover { background-color: #ddd; }
-.backward-incompatible { color: red; }
+inline constexpr std::string_view COMPATIBILITY_STYLE = R"(.backward-incompatible { color: red; }
 .backward-compatible { color: green; }
-</style></head><body><h1>API Compatibility Report</h1>
-<h2>ARMOR Report</h2>
-<table>
-<tr><th>Header Name</th><th>API Name</th><th>Description</th><th>Change Type</th><th>Source Compatibility</th></tr>
 )";
 
-const std::string SIMPLE_HEADER = R"(
-<html><head><style>
-table { border-collapse: collapse; width: 100%; }
-th, td { border: 1px solid black; padding: 8px; text-align: left; }
-th { background-color:#add8e6; }
-tr:nth-child(even) { background-color:#f2f2f2; }
-tr:hover { background-color: #ddd; }
-.backward-incompatible { color: red; }
-.backward-compatible { color: green; }
+// The index is written last but shown first, see CombinedHtmlReport
+inline constexpr std::string_view COMBINED_STYLE = R"(.page { display: flex; flex-direction: column; }
+.index { order: -1; }
+section { margin-top: 24px; }
+)";
+
+inline constexpr std::string_view HTML_HEAD_CLOSE = "</style></head><body><h1>API Compatibility Report</h1>\n";
+
+inline constexpr std::string_view REPORT_TITLE = "<h2>ARMOR Report</h2>\n";
+
+// Shown for ALPHA_PARSER reports
+inline constexpr std::string_view COMPILER_ERRORS_NOTE =
+    "<p>Note: Compiler errors (For more info please run using DEBUG flags and check logs)</p>\n";
+
+inline constexpr std::string_view TABLE_OPEN = "<table>\n";
+
+inline constexpr std::string_view API_TABLE_COLUMNS =
+    "<tr><th>Header Name</th><th>API Name</th><th>Description</th><th>Change Type</th>"
+    "<th>Source Compatibility</th></tr>\n";
+
+inline constexpr std::array<std::string_view, 8> ALPHA_HTML_HEADER = {
+    HTML_HEAD_OPEN, TABLE_STYLE, COMPATIBILITY_STYLE, HTML_HEAD_CLOSE,
+    REPORT_TITLE, COMPILER_ERRORS_NOTE, TABLE_OPEN, API_TABLE_COLUMNS};
+
+inline constexpr std::array<std::string_view, 7> BETA_HTML_HEADER = {
+    HTML_HEAD_OPEN, TABLE_STYLE, COMPATIBILITY_STYLE, HTML_HEAD_CLOSE,
+    REPORT_TITLE, TABLE_OPEN, API_TABLE_COLUMNS};
+
+inline constexpr std::array<std::string_view, 6> SIMPLE_HEADER = {
+    HTML_HEAD_OPEN, TABLE_STYLE, COMPATIBILITY_STYLE, HTML_HEAD_CLOSE,
+    REPORT_TITLE, TABLE_OPEN};
+
+inline constexpr std::string_view HTML_FOOTER = "</table></body></html>";
+
+inline constexpr std::array<std::string_view, 5> COMBINED_HTML_HEADER = {
+    HTML_HEAD_OPEN, TABLE_STYLE, COMBINED_STYLE, HTML_HEAD_CLOSE, "<div class=\"page\">\n"};
+
+inline constexpr std::array<std::string_view, 2> COMBINED_API_TABLE_HEADER = {TABLE_OPEN, API_TABLE_COLUMNS};
+
+inline constexpr std::string_view COMBINED_HTML_FOOTER = "</div></body></html>";
+
+// Report of --html-mode lazy: the rows are data of the armor-rows script
+// element, see write_lazy_rows(), and only those in view are rendered
+inline constexpr std::string_view LAZY_HTML_HEADER = R"(
+<html><head><meta charset="utf-8"><style>
+.controls { margin: 8px 0; }
+.controls input { width: 40%; }
+.grid { display: grid; grid-template-columns: 15% 20% 37% 13% 15%; }
+.grid > div { border: 1px solid black; padding: 0 8px; line-height: 27px; white-space: nowrap; overflow: hidden; text-overflow: ellipsis; }
+.head > div { background-color:#add8e6; font-weight: bold; }
+#armor-view { height: 70vh; overflow-y: auto; position: relative; }
+#armor-spacer { position: relative; }
+#armor-spacer .grid { position: absolute; left: 0; right: 0; height: 28px; cursor: pointer; }
+#armor-spacer .grid:nth-child(even) { background-color:#f2f2f2; }
+#armor-spacer .grid:hover { background-color: #ddd; }
+#armor-detail { white-space: pre-wrap; margin: 8px 0; padding: 8px; border: 1px solid #ccc; }
 </style></head><body><h1>API Compatibility Report</h1>
 <h2>ARMOR Report</h2>
-<table>
 )";
 
-const std::string HTML_FOOTER = "</table></body></html>";
+inline constexpr std::string_view LAZY_HTML_TABLE = R"(<div class="controls">
+<input id="armor-filter" type="search" placeholder="Filter by API name or description">
+<select id="armor-compat">
+<option value="">All changes</option>
+<option value="1">backward_incompatible</option>
+<option value="0">backward_compatible</option>
+</select>
+<span id="armor-count"></span>
+</div>
+<div class="grid head"><div>Header Name</div><div>API Name</div><div>Description</div><div>Change Type</div><div>Source Compatibility</div></div>
+<div id="armor-view"><div id="armor-spacer"></div></div>
+<div id="armor-detail">Select a row to show its full description.</div>
+)";
+
+// Rows are [header index, API name, description, compatibility changed, backward incompatible]
+inline constexpr std::string_view LAZY_HTML_SCRIPT = R"(<script>
+(async function () {
+  const ROW = 28, OVERSCAN = 20;
+  const source = document.getElementById('armor-rows');
+  let text = source.textContent;
+  if (source.dataset.encoding === 'deflate-base64') {
+    const bytes = Uint8Array.from(atob(text.trim()), c => c.charCodeAt(0));
+    const stream = new Blob([bytes]).stream().pipeThrough(new DecompressionStream('deflate'));
+    text = await new Response(stream).text();
+  }
+  const data = JSON.parse(text);
+  const view = document.getElementById('armor-view');
+  const spacer = document.getElementById('armor-spacer');
+  const detail = document.getElementById('armor-detail');
+  const filter = document.getElementById('armor-filter');
+  const compat = document.getElementById('armor-compat');
+  const count = document.getElementById('armor-count');
+  const esc = s => s.replace(/[&<>"']/g, c => ({'&': '&amp;', '<': '&lt;', '>': '&gt;', '"': '&quot;', "'": '&#39;'})[c]);
+  let shown = data.rows;
+
+  function render() {
+    const first = Math.max(0, Math.floor(view.scrollTop / ROW) - OVERSCAN);
+    const last = Math.min(shown.length, Math.ceil((view.scrollTop + view.clientHeight) / ROW) + OVERSCAN);
+    let html = '';
+    for (let i = first; i < last; ++i) {
+      const r = shown[i];
+      const color = r[4] ? '#d32f2f' : '#2e7d32';
+      html += '<div class="grid" data-i="' + i + '" style="top:' + i * ROW + 'px">' +
+        '<div>' + esc(data.headers[r[0]]) + '</div><div>' + esc(r[1]) + '</div><div>' + esc(r[2]) + '</div>' +
+        '<div>' + (r[3] ? 'Compatibility Changed' : 'Functionality Added') + '</div>' +
+        '<div style="color:' + color + ';font-weight:600">' + (r[4] ? 'backward_incompatible' : 'backward_compatible') + '</div></div>';
+    }
+    spacer.innerHTML = html;
+  }
+
+  function applyFilter() {
+    const needle = filter.value.toLowerCase();
+    const wanted = compat.value;
+    shown = data.rows.filter(r => (wanted === '' || String(r[4]) === wanted) &&
+      (needle === '' || r[1].toLowerCase().includes(needle) || r[2].toLowerCase().includes(needle)));
+    spacer.style.height = shown.length * ROW + 'px';
+    count.textContent = shown.length + ' of ' + data.rows.length + ' APIs';
+    view.scrollTop = 0;
+    render();
+  }
+
+  view.addEventListener('scroll', () => requestAnimationFrame(render));
+  spacer.addEventListener('click', e => {
+    const row = e.target.closest('.grid');
+    if (row) {
+      const r = shown[row.dataset.i];
+      detail.textContent = data.headers[r[0]] + '\n' + r[1] + '\n\n' + r[2];
+    }
+  });
+  filter.addEventListener('input', applyFilter);
+  compat.addEventListener('change', applyFilter);
+  applyFilter();
+})();
+</script>
+)";
+
+inline constexpr std::string_view LAZY_HTML_FOOTER = "</body></html>";
+
+/**
+ * @brief Writes `chunks` to `out` in order, each as one write of its known size.
+ */
+template <std::size_t N>
+void write_chunks(std::ostream& out, const std::array<std::string_view, N>& chunks) {
+    for (std::string_view chunk : chunks) {
+        out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+}
@@ -0,0 +1,96 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "llvm/ADT/StringSet.h"
+
+namespace armor {
+
+/**
+ * @brief Headers parsed ahead of the current one whose include closures are
+ *        prefetched (--prefetch-includes); 0, the default, prefetches nothing.
+ */
+void setIncludePrefetchDepth(unsigned depth);
+
+unsigned includePrefetchDepth();
+
+/**
+ * @brief The include directories of a compile command, in search order:
+ *        `-iquote`, then `-I`, then `-isystem` and `-idirafter`. Relative
+ *        directories are resolved against `directory`.
+ */
+std::vector<std::string> includeDirsOf(const std::vector<std::string>& commandLine, const std::string& directory);
+
+/**
+ * @brief Reads `file` and every file it includes, transitively, into the page cache.
+ *
+ * The `#include`, `#include_next` and `#import` directives are found by a
+ * scan of the text, ignoring conditionals, so the closure may hold files
+ * the preprocessor would skip. A quoted include is looked up next to its
+ * includer first, then in `includeDirs`; includes spelled through a macro
+ * are not followed. Each file is advised with POSIX_FADV_WILLNEED before it
+ * is read. Files in `visited` are neither read nor scanned again, and the
+ * files read are added to it.
+ *
+ * @return The number of files read.
+ */
+std::size_t prefetchIncludeClosure(const std::string& file, const std::vector<std::string>& includeDirs,
+                                   llvm::StringSet<>& visited, const std::atomic<bool>* cancel = nullptr);
+
+/**
+ * @class IncludePrefetcher
+ * @brief Thread warming the include closures of the next headers to parse while the current ones parse.
+ *
+ * On a cold network file system the first parse of a header mostly waits
+ * for its includes to be read one at a time. The prefetcher walks the
+ * headers in the order they are scheduled on a thread of its own and reads
+ * the closure of each (see prefetchIncludeClosure) once fewer than `ahead`
+ * headers separate it from the count of headerDone() calls, so the parsers
+ * find the files cached. Closures shared by several headers are read once.
+ */
+class IncludePrefetcher {
+public:
+    struct Header {
+        std::string file;
+        std::vector<std::string> includeDirs;
+    };
+
+    /**
+     * @brief Starts prefetching `headers`, in order; the headers being parsed count among the `ahead`.
+     */
+    IncludePrefetcher(std::vector<Header> headers, std::size_t ahead);
+
+    /** @brief Stops the thread, abandoning what is left to prefetch. */
+    ~IncludePrefetcher();
+
+    IncludePrefetcher(const IncludePrefetcher&) = delete;
+    IncludePrefetcher& operator=(const IncludePrefetcher&) = delete;
+
+    /** @brief One more header finished parsing, whichever it was. */
+    void headerDone();
+
+    /** @brief Files read so far. */
+    std::size_t filesRead() const { return readCount; }
+
+private:
+    void run();
+
+    std::vector<Header> headers;
+    std::size_t ahead;
+    std::mutex mutex;
+    std::condition_variable progress;
+    std::size_t done = 0;
+    std::atomic<bool> stopping{false};
+    std::atomic<std::size_t> readCount{0};
+    std::thread worker;
+};
+
+}
@@ -0,0 +1,54 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @class IncludeResolver
+ * @brief Index from header file names to the headers of a project root, to find includes the -I list misses.
+ *
+ * An include that failed, spelled `sub/foo.h`, resolves to a directory D of
+ * the root holding `D/sub/foo.h`; passing -I D lets the header parse. When
+ * several directories hold it, the one sharing the longest path with the
+ * including file wins, then the first in path order.
+ */
+class IncludeResolver {
+public:
+    /**
+     * @brief Index of `headers`, paths relative to `root` in generic form.
+     */
+    IncludeResolver(std::string root, const std::vector<std::string>& headers);
+
+    /**
+     * @brief The index of the headers under `root`, walked on first use and
+     *        shared by later calls for the same root. Thread-safe.
+     */
+    static std::shared_ptr<const IncludeResolver> forRoot(const std::string& root);
+
+    /**
+     * @brief The absolute directory to add to the include path so that
+     *        `#include <spelling>` in `includer` finds a header of the root.
+     *
+     * @return Empty if no header of the root matches, or if `spelling` is
+     *         absolute or climbs out of its directory with "..".
+     */
+    std::string resolve(llvm::StringRef spelling, llvm::StringRef includer) const;
+
+    std::size_t size() const { return headerCount; }
+
+private:
+    std::string root;
+    // File name to the relative paths of the headers of that name, in path order
+    llvm::StringMap<std::vector<std::string>> byName;
+    std::size_t headerCount = 0;
+};
+
+}
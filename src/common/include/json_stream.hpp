@@ -0,0 +1,66 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace armor {
+
+/**
+ * @class JsonStreamWriter
+ * @brief Writes a JSON document to a stream piece by piece, laid out like json::dump(4).
+ *
+ * Containers are opened and closed explicitly and values are written as soon
+ * as they are produced, so a document of thousands of records never exists in
+ * memory as a whole. Object keys are written in the order given; writing them
+ * in sorted order reproduces the output of json::dump exactly.
+ */
+class JsonStreamWriter {
+public:
+    explicit JsonStreamWriter(std::ostream& out) : out(out) {}
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /**
+     * @brief Writes the key of the next object member; the member's value or container must follow.
+     */
+    void key(std::string_view name);
+
+    /**
+     * @brief Writes a complete value as an array element, member value or the whole document.
+     */
+    void value(const nlohmann::json& value);
+
+    /**
+     * @brief Writes a member holding a complete value.
+     */
+    void field(std::string_view name, const nlohmann::json& value) {
+        key(name);
+        this->value(value);
+    }
+
+private:
+    struct Frame {
+        bool isArray;
+        bool empty;
+    };
+
+    void beginValue();
+    void open(char bracket, bool isArray);
+    void close(char bracket);
+    void newline(size_t depth);
+
+    std::ostream& out;
+    std::vector<Frame> frames;
+    bool afterKey = false;
+};
+
+}
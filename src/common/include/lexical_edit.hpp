@@ -0,0 +1,49 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @brief What an edit between two versions of a header changed, as far as
+ *        their text alone tells.
+ */
+enum class LexicalEdit {
+    // The tokens differ, or may: only a parse can tell what changed
+    TOKENS,
+    // Same tokens, different comments
+    COMMENTS,
+    // Same tokens and comments, laid out differently
+    WHITESPACE
+};
+
+/**
+ * @brief The token stream of `text`, without its comments and layout, as a string.
+ *
+ * Holds the bytes FibonacciHash::hashNormalizedSource hashes, with a marker
+ * wherever dropped whitespace or comments kept apart two tokens that could
+ * otherwise lex as one (`a b`, `+ +`, `u8 "s"`), wherever a line break ends
+ * or starts a preprocessor directive, and wherever a line splice was
+ * dropped. Inside a directive every separation is marked, since
+ * `#define F(x)` and `#define F (x)` define different macros. Two texts
+ * with equal streams lex to the same tokens on the same directive lines; a
+ * stream difference may still be a harmless one, such as `>>` split into
+ * `> >`.
+ */
+std::string lexicalTokens(llvm::StringRef text);
+
+/**
+ * @brief Classifies the edit from `text1` to `text2` without preprocessing or parsing either.
+ *
+ * Equal lexicalTokens() make the edit COMMENTS if the texts differ in more
+ * than whitespace, by their FibonacciHash::digest, and WHITESPACE otherwise.
+ * Nothing included is read, and conditionals are not evaluated: with the
+ * same tokens and includes the two versions preprocess alike.
+ */
+LexicalEdit classifyLexicalEdit(llvm::StringRef text1, llvm::StringRef text2);
+
+}
@@ -17,8 +17,18 @@
 #include <llvm/Support/Path.h>
 #include <utility>
 
+#include "async_log_sink.hpp"
+#include "compressed_output.hpp"
 #include "comm_def.hpp"
 
+// Most verbose level compiled into production code, set from ARMOR_MAX_LOG_LEVEL
+// in CMakeLists.txt; testing builds keep every level
+#if defined(TESTING_ENABLED) || !defined(ARMOR_MAX_LOG_LEVEL)
+    #define ARMOR_COMPILED_LOG_LEVEL 5
+#else
+    #define ARMOR_COMPILED_LOG_LEVEL ARMOR_MAX_LOG_LEVEL
+#endif
+
 class BaseLogStream;
 
 class DebugConfig {
@@ -41,36 +51,36 @@ enum class ConsoleOption{
     class LogStream;
     class TestLogStream;
 
+    /** Records above this level are dropped at compile time, see ARMOR_LOG_AT. */
+    static constexpr Level MAX_COMPILED_LEVEL = static_cast<Level>(ARMOR_COMPILED_LOG_LEVEL);
+
+    static constexpr bool isCompiledIn(Level lvl) {
+        return lvl != Level::NONE && static_cast<int>(lvl) <= static_cast<int>(MAX_COMPILED_LEVEL);
+    }
+
     static DebugConfig& getInstance() {
         static DebugConfig inst;
         return inst;
     }
 
+    /**
+     * @brief Opens the log at `logFilePath`; a later call with another path
+     *        moves the log there, so each run of a long-lived process keeps its own.
+     */
     bool initialize(llvm::StringRef logFilePath = LOG_FILE_PATH) {
+        openPending.store(false, std::memory_order_release);
+        if (isInitialized.load(std::memory_order_acquire)) {
+            return reopen(logFilePath);
+        }
         std::scoped_lock<std::mutex> lock(mutex);
         
         if (isInitialized.load(std::memory_order_relaxed)) {
             return true;
         }
 
-        llvm::SmallString<256> logPath(logFilePath);
-        llvm::StringRef parentDir = llvm::sys::path::parent_path(logPath);
-        if (!parentDir.empty()) {
-            std::filesystem::create_directories(parentDir.str());
-        }
-        
-        std::error_code ec;
-        fileStream = std::make_unique<llvm::raw_fd_ostream>(
-            logFilePath, ec, 
-            llvm::sys::fs::OF_Text | llvm::sys::fs::OF_Append
-        );
-        
-        if (ec) {
-            activeStream = &llvm::errs();
+        if (!openLogFile(logFilePath)) {
             return false;
         }
-        
-        activeStream = fileStream.get();
 
         #ifdef TESTING_ENABLED
             std::error_code debugEc;
@@ -86,11 +96,38 @@ enum class ConsoleOption{
     
             debugStream = debugFileStream.get();
         #endif
-        
-        isInitialized.store(true, std::memory_order_relaxed);
+
+        // From here on records reach the file through per-thread rings, off the workers' path
+        asyncSinkOwner = std::make_unique<armor::AsyncLogSink>([this](llvm::StringRef text, bool flushSink) {
+            std::scoped_lock<std::mutex> sinkLock(mutex);
+            llvm::raw_ostream* out = externalSink ? externalSink : activeStream;
+            if (out) {
+                *out << text;
+                if (flushSink) {
+                    out->flush();
+                }
+            }
+        });
+        asyncSink.store(asyncSinkOwner.get(), std::memory_order_release);
+
+        isInitialized.store(true, std::memory_order_release);
         return true;
     }
 
+    /**
+     * @brief initialize() at `logFilePath` once the first record reaches the
+     *        log, or the next initialize() call, whichever comes first.
+     *
+     * A run logging nothing, as one whose headers are all unchanged at the
+     * default level, then creates neither the log nor its directory, and
+     * starts no drain thread.
+     */
+    void initializeOnFirstRecord(llvm::StringRef logFilePath = LOG_FILE_PATH) {
+        std::scoped_lock<std::mutex> lock(pendingMutex);
+        pendingLogFile = logFilePath.str();
+        openPending.store(true, std::memory_order_release);
+    }
+
     void setLevel(Level lvl) { 
         logLevel.store(lvl, std::memory_order_relaxed);
     }
@@ -99,6 +136,14 @@ enum class ConsoleOption{
         return logLevel.load(std::memory_order_relaxed);
     }
 
+    /**
+     * @brief Whether records of `lvl` reach the log; lets callers skip building them.
+     */
+    bool isEnabled(Level lvl) const {
+        return isCompiledIn(lvl) &&
+               static_cast<int>(lvl) <= static_cast<int>(logLevel.load(std::memory_order_relaxed));
+    }
+
     void setSink(llvm::raw_ostream* sink) {
         std::scoped_lock<std::mutex> lock(mutex);
         externalSink = sink;
@@ -109,6 +154,32 @@ enum class ConsoleOption{
         return externalSink ? externalSink : activeStream;
     }
 
+    /**
+     * @brief Appends an already formatted block to the active sink in one write.
+     *
+     * Used for output produced outside the LogStream helpers (e.g. buffered
+     * clang diagnostics) so that blocks coming from different threads never
+     * interleave.
+     */
+    void write(llvm::StringRef text) const {
+        if (text.empty()) {
+            return;
+        }
+        if (openPending.load(std::memory_order_acquire)) {
+            openPendingLog();
+        }
+        if (armor::AsyncLogSink* sink = asyncSink.load(std::memory_order_acquire)) {
+            sink->submit(text);
+            return;
+        }
+        std::scoped_lock<std::mutex> lock(mutex);
+        llvm::raw_ostream* out = externalSink ? externalSink : activeStream;
+        if (out) {
+            *out << text;
+            out->flush();
+        }
+    }
+
     LogStream getStream(Level lvl) const;
 
     LogStream getConsoleAndStream(Level lvl, ConsoleOption consoleOption) const;
@@ -117,19 +188,134 @@ enum class ConsoleOption{
     TestLogStream getTestStream() const;
     #endif
 
+    /**
+     * @brief Writes out everything logged so far; only needed before reading the log
+     *        file or at the end of a run, the drain thread writes it out regardless.
+     */
     void flush() const {
+        if (armor::AsyncLogSink* sink = asyncSink.load(std::memory_order_acquire)) {
+            sink->flush();
+            return;
+        }
         std::scoped_lock<std::mutex> lock(mutex);
         if (activeStream) {
             activeStream->flush();
         }
     }
 
+    /**
+     * @brief Holds the log still across a fork(): everything logged so far is
+     *        written out, and no record is half-written when the process is copied.
+     */
+    void prepareFork() {
+        flush();
+        mutex.lock();
+    }
+
+    /** @brief In the parent, once fork() returned; releases prepareFork(). */
+    void afterForkInParent() {
+        mutex.unlock();
+    }
+
+    /**
+     * @brief In the child, once fork() returned; releases prepareFork() and
+     *        lets go of the parent's log.
+     *
+     * The drain thread did not survive the fork and the file is the parent's,
+     * so neither is destroyed: records go to stderr, synchronously, until
+     * initialize() opens a log of the child's own.
+     */
+    void afterForkInChild() {
+        openPending.store(false, std::memory_order_release);
+        (void)asyncSinkOwner.release();
+        asyncSink.store(nullptr, std::memory_order_release);
+        (void)fileStream.release();
+        activeStream = &llvm::errs();
+        logFile.clear();
+        mutex.unlock();
+    }
+
+    /**
+     * @brief Writes out and finishes the log file, e.g. before a process ends
+     *        through _exit(); records go to stderr afterwards.
+     */
+    void closeLogFile() {
+        openPending.store(false, std::memory_order_release);
+        asyncSink.store(nullptr, std::memory_order_release);
+        asyncSinkOwner.reset();
+        std::scoped_lock<std::mutex> lock(mutex);
+        fileStream.reset();
+        activeStream = &llvm::errs();
+        logFile.clear();
+    }
+
     ~DebugConfig() {
+        // Drains the rings while the streams they write to still exist
+        asyncSink.store(nullptr, std::memory_order_release);
+        asyncSinkOwner.reset();
         flush();
     }
 
 private:
 
+    // The initialize() initializeOnFirstRecord() put off
+    void openPendingLog() const {
+        std::scoped_lock<std::mutex> lock(pendingMutex);
+        if (!openPending.load(std::memory_order_acquire)) {
+            return;
+        }
+        // Not through the log, which this call is opening
+        if (!const_cast<DebugConfig*>(this)->initialize(pendingLogFile)) {
+            llvm::errs() << "Failed to open diagnostics log <" << pendingLogFile << ">, using stderr\n";
+        }
+    }
+
+    // Caller holds `mutex`
+    bool openLogFile(llvm::StringRef logFilePath) {
+        llvm::SmallString<256> logPath(logFilePath);
+        llvm::StringRef parentDir = llvm::sys::path::parent_path(logPath);
+        if (!parentDir.empty()) {
+            std::filesystem::create_directories(parentDir.str());
+        }
+
+        // The previous log is finished before the new one is opened
+        fileStream.reset();
+        std::error_code ec;
+        std::unique_ptr<llvm::raw_ostream> stream = std::make_unique<llvm::raw_fd_ostream>(
+            logFilePath, ec,
+            armor::isGzipPath(logFilePath) ? llvm::sys::fs::OF_Append
+                                           : llvm::sys::fs::OF_Text | llvm::sys::fs::OF_Append
+        );
+
+        if (ec) {
+            activeStream = &llvm::errs();
+            logFile.clear();
+            return false;
+        }
+
+        // Each run appends a gzip member of its own
+        if (armor::isGzipPath(logFilePath)) {
+            stream = std::make_unique<armor::GzipRawOStream>(std::move(stream));
+        }
+        fileStream = std::move(stream);
+        activeStream = fileStream.get();
+        logFile = logFilePath.str();
+        return true;
+    }
+
+    bool reopen(llvm::StringRef logFilePath) {
+        {
+            std::scoped_lock<std::mutex> lock(mutex);
+            if (logFile == logFilePath) {
+                return true;
+            }
+        }
+        // Records of the previous run belong in the previous file
+        flush();
+        std::scoped_lock<std::mutex> lock(mutex);
+        return openLogFile(logFilePath);
+    }
+
     friend class LogStream;
     friend class TestLogStream;
 
@@ -157,13 +343,22 @@ private:
     mutable std::mutex mutex;
     std::atomic<Level> logLevel;
     std::atomic<bool> isInitialized;
-    std::unique_ptr<llvm::raw_fd_ostream> fileStream;
+    // Compressed when the log file is named *.gz
+    std::unique_ptr<llvm::raw_ostream> fileStream;
     llvm::raw_ostream* activeStream;
+    // Path fileStream writes to
+    std::string logFile;
     #ifdef TESTING_ENABLED
         std::unique_ptr<llvm::raw_fd_ostream> debugFileStream;
         llvm::raw_ostream* debugStream;
     #endif
     llvm::raw_ostream* externalSink;
+    std::unique_ptr<armor::AsyncLogSink> asyncSinkOwner;
+    std::atomic<armor::AsyncLogSink*> asyncSink{nullptr};
+    // Set by initializeOnFirstRecord() until the log is opened
+    mutable std::mutex pendingMutex;
+    std::string pendingLogFile;
+    mutable std::atomic<bool> openPending{false};
 
     DebugConfig(const DebugConfig&) = delete;
     DebugConfig& operator=(const DebugConfig&) = delete;
@@ -260,7 +455,7 @@ public:
             isActive = false;
         }
         else{
-            isActive = static_cast<int>(lvl) <= static_cast<int>(config.logLevel.load(std::memory_order_relaxed));
+            isActive = config.isEnabled(lvl);
             if (isActive){
                 OS << "[" << config.levelToString(lvl) << "] ";
             }
@@ -275,28 +470,27 @@ public:
     }
 
     ~LogStream() override {
-        bool shouldLogToFile = isActive && !bufferStorage.empty() && config.activeStream;
+        // write() picks the stream under the lock, which reopen() may be swapping
+        bool shouldLogToFile = isActive && !bufferStorage.empty();
         bool shouldLogToConsole = isConsoleActive && !consoleBufferStorage.empty();
-        if (shouldLogToConsole || shouldLogToFile) {
+        if (shouldLogToFile) {
+            config.write(bufferStorage);
+        }
+        if (shouldLogToConsole) {
+            // Console output stays synchronous so it keeps its place among stdout/stderr writes
             std::scoped_lock<std::mutex> lock(config.mutex);
-            if (shouldLogToFile) {
-                *config.activeStream << bufferStorage;
-                config.activeStream->flush();
-            }
-            if(shouldLogToConsole){
-                switch (consoleOption) {
-                    case DebugConfig::ConsoleOption::INFO:
-                        llvm::outs() << consoleBufferStorage;
-                        llvm::outs().flush();
-                        break;
-                    case DebugConfig::ConsoleOption::ERROR:
-                        llvm::errs() << consoleBufferStorage;
-                        llvm::errs().flush();
-                        break;
-                    case DebugConfig::ConsoleOption::NONE:
-                    default:
-                        break;
-                }
+            switch (consoleOption) {
+                case DebugConfig::ConsoleOption::INFO:
+                    llvm::outs() << consoleBufferStorage;
+                    llvm::outs().flush();
+                    break;
+                case DebugConfig::ConsoleOption::ERROR:
+                    llvm::errs() << consoleBufferStorage;
+                    llvm::errs().flush();
+                    break;
+                case DebugConfig::ConsoleOption::NONE:
+                default:
+                    break;
             }
         }
     }
@@ -387,4 +581,22 @@ namespace armor {
 
 }
 
-#define TEST_LOG armor::test()
\ No newline at end of file
+/**
+ * Statement-position logging whose operands are only evaluated when the record
+ * is kept: `ARMOR_DEBUG_LOG << expensive();`. A level above MAX_COMPILED_LEVEL
+ * is discarded by `if constexpr`, so its operands are not even compiled into
+ * the binary; otherwise they are skipped when the level is disabled at runtime.
+ */
+#define ARMOR_LOG_AT(lvl) \
+    if constexpr (!DebugConfig::isCompiledIn(lvl)) {} \
+    else if (!DebugConfig::getInstance().isEnabled(lvl)) {} \
+    else DebugConfig::getInstance().getStream(lvl)
+
+#define ARMOR_DEBUG_LOG ARMOR_LOG_AT(DebugConfig::Level::DEBUG)
+
+#ifdef TESTING_ENABLED
+    #define TEST_LOG armor::test()
+#else
+    // Test-only traces never reach a production binary
+    #define TEST_LOG if constexpr (true) {} else armor::test()
+#endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "diff_utils.hpp"
+#include "output_paths.hpp"
+#include "report_utils.hpp"
+
+namespace armor {
+
+/**
+ * @struct MacroConfiguration
+ * @brief One build configuration of the headers, as --macro-matrix lists it.
+ */
+struct MacroConfiguration {
+    // Names the configuration in reports and its output directory
+    std::string name;
+    // Added to the --macro-flags of the command line
+    std::string macroFlags;
+};
+
+/**
+ * @brief Whether `name` can name a configuration, and so a directory of its
+ *        own: letters, digits, '.', '_' and '-', other than "." and "..".
+ */
+bool isValidConfigurationName(const std::string& name);
+
+/**
+ * @brief Reads the configurations of a --macro-matrix file.
+ *
+ * The file is a YAML sequence of configurations:
+ *
+ *     - name: feature_x
+ *       macro-flags: -DFEATURE_X
+ *     - name: platform_y
+ *       macro-flags: -DPLATFORM_Y -DFEATURE_X
+ *
+ * Names are unique and valid (see isValidConfigurationName).
+ *
+ * @throws std::runtime_error if the file cannot be read or is not such a list.
+ */
+std::vector<MacroConfiguration> loadMacroMatrix(const std::string& path);
+
+/**
+ * @class MatrixReport
+ * @brief The findings of every configuration of a --macro-matrix run, each
+ *        with the configurations it applies to.
+ *
+ * A finding is one report row: its header, API name, description, change
+ * type and compatibility. The combined statuses are the worst of all
+ * configurations, as MergedReports combines runs.
+ */
+class MatrixReport {
+public:
+    /**
+     * @brief Adds the JSON reports the run of configuration `name` wrote under the output root `root`.
+     *
+     * @return Number of reports read; 0 if the run wrote none.
+     * @throws std::runtime_error if a report cannot be read or is malformed.
+     */
+    std::size_t addConfiguration(const std::string& name, const std::string& root);
+
+    /**
+     * @brief Writes outputs.matrixHtmlFile(), where each description names its
+     *        configurations, and outputs.matrixJsonFile(), see toJson().
+     */
+    void write(const OutputPaths& outputs) const;
+
+    /**
+     * @brief {"configurations": [{"name", "reports", "compatibility"}],
+     *         "api_diff": [<report row> + "configurations": [<name>]]}
+     */
+    nlohmann::json toJson() const;
+
+    bool hasBackwardIncompatible() const { return backwardIncompatible; }
+
+    std::size_t findingCount() const { return findings.size(); }
+
+private:
+    struct Configuration {
+        std::string name;
+        std::size_t reports = 0;
+        bool backwardIncompatible = false;
+    };
+
+    struct Finding {
+        ChangeRecord record;
+        // Indices into `configurations`, in the order they were added
+        std::vector<std::size_t> configurations;
+    };
+
+    // Names of the configurations of `finding`
+    std::string configurationList(const Finding& finding) const;
+
+    std::vector<Configuration> configurations;
+    std::vector<Finding> findings;
+    std::unordered_map<std::string, std::size_t> index;
+    ParsedDiffStatus parsedStatus = ParsedDiffStatus::NON_FUNCTIONAL_CHANGES;
+    UnParsedDiffStatus unparsedStatus = UnParsedDiffStatus::UN_CHANGED;
+    bool backwardIncompatible = false;
+};
+
+}
@@ -0,0 +1,85 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+/**
+ * @class MacroTable
+ * @brief The macros a header leaves defined, by name, with a hash of each definition.
+ *
+ * Names are spread over a fixed number of buckets by their hash, and every
+ * bucket keeps an order-independent fingerprint of its (name, definition)
+ * pairs, as HashMultiset does for its hashes. Diffing two tables compares
+ * the bucket fingerprints and only walks the buckets that differ, so
+ * unchanged macros cost nothing beyond the fingerprint compares.
+ *
+ * The table also lists the hashes of the header's #define and #undef lines,
+ * which the unhandled declaration hashes count as well, so a diff that
+ * reports macros by name can take them out of those.
+ */
+class MacroTable {
+public:
+    static constexpr unsigned BUCKETS = 64;
+
+    enum class ChangeKind { Added, Removed, Modified };
+
+    struct Change {
+        std::string name;
+        ChangeKind kind;
+    };
+
+    /** @brief Defines `name`, replacing an earlier definition. */
+    void define(llvm::StringRef name, uint64_t definitionHash);
+
+    /** @brief Removes the definition of `name`, if any. */
+    void undefine(llvm::StringRef name);
+
+    /**
+     * @brief Definition hash of `name`.
+     * @return false if `name` is not defined.
+     */
+    bool lookup(llvm::StringRef name, uint64_t& definitionHash) const;
+
+    /** @brief Calls `visit` with every defined name and its definition hash, in no particular order. */
+    void forEach(llvm::function_ref<void(llvm::StringRef, uint64_t)> visit) const;
+
+    void addDirectiveHash(uint64_t hash) { directiveHashes.push_back(hash); }
+
+    const std::vector<uint64_t>& getDirectiveHashes() const { return directiveHashes; }
+
+    /** @brief Number of defined macros. */
+    std::size_t size() const { return count; }
+
+    bool empty() const { return count == 0 && directiveHashes.empty(); }
+
+    void clear();
+
+    /** @brief Whether the two tables define different macros, from the bucket fingerprints. */
+    bool differs(const MacroTable& other) const;
+
+    /**
+     * @brief Macros added, removed or redefined from `older` to `newer`, sorted by name.
+     *
+     * Only buckets whose fingerprints differ are walked.
+     */
+    static std::vector<Change> diff(const MacroTable& older, const MacroTable& newer);
+
+private:
+    struct Bucket {
+        llvm::StringMap<uint64_t> macros;
+        uint64_t fingerprint = 0;
+    };
+
+    std::array<Bucket, BUCKETS> buckets;
+    std::size_t count = 0;
+    std::vector<uint64_t> directiveHashes;
+};
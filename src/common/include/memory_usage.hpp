@@ -0,0 +1,21 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+
+namespace armor {
+
+/**
+ * @brief Resident set size of this process in bytes, from /proc/self/statm;
+ *        0 where it cannot be read.
+ */
+std::size_t residentBytes();
+
+/**
+ * @brief Largest resident set size this process has had, in bytes, from
+ *        getrusage; 0 where it cannot be read.
+ */
+std::size_t peakResidentBytes();
+
+}
@@ -0,0 +1,135 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @class Metrics
+ * @brief Process wide counters of a daemon or cache deployment, in the
+ *        Prometheus text format (--metrics-file, the serve "metrics" command).
+ *
+ * Counts requests, parse failures and the hits and misses of every cache
+ * tier, and keeps latency histograms of requests and of the phases of each
+ * header. Rendering adds the resident set and the time spent busy, whose
+ * rate is the utilization of the process, so a fleet can be sized from the
+ * series of its workers.
+ *
+ * Updates are relaxed atomic increments and always on; only rendering costs
+ * more than that. Thread-safe.
+ */
+class Metrics {
+public:
+    enum class Phase : uint8_t {
+        // A whole serve request
+        REQUEST,
+        CACHE_LOAD,
+        PARSE,
+        DIFF,
+        COUNT
+    };
+
+    enum class CacheTier : uint8_t {
+        // Normalized contexts: kept in memory by serve, the --cache-dir entry files, --remote-cache
+        MEMORY,
+        DISK,
+        REMOTE,
+        // --ast-cache and --result-cache
+        AST,
+        RESULT,
+        COUNT
+    };
+
+    // Upper bounds of the latency buckets, in seconds, from a cached header to a stuck parse
+    static constexpr std::array<double, 14> BUCKET_BOUNDS{0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+                                                          1,     2.5,  5,     10,   30,  60,  300};
+
+    static Metrics& getInstance();
+
+    static llvm::StringRef phaseName(Phase phase);
+
+    static llvm::StringRef tierName(CacheTier tier);
+
+    /** @brief Counts an answered request of `kind` (args, compare, invalid) and its latency. */
+    void countRequest(llvm::StringRef kind, bool ok, std::chrono::nanoseconds elapsed);
+
+    void observe(Phase phase, std::chrono::nanoseconds elapsed);
+
+    void countCache(CacheTier tier, bool hit);
+
+    /** @brief Counts a version of a header whose parse had errors or ran out of time. */
+    void countParseFailure(bool timedOut);
+
+    /** @brief Headers queued in the current run and not yet compared. */
+    void setQueueDepth(std::size_t headers);
+
+    /** @brief Marks the process busy with a request or run until endBusy(); calls may nest. */
+    void beginBusy();
+
+    void endBusy();
+
+    /**
+     * @brief The metrics in the Prometheus text exposition format, every
+     *        series carrying `labels`, e.g. {"worker": "2"}.
+     */
+    std::string render(const std::map<std::string, std::string>& labels = {}) const;
+
+    /**
+     * @brief Writes render(`labels`) to `path`, replacing it atomically as the
+     *        node_exporter textfile collector expects; false if it cannot be written.
+     */
+    bool writeTextfile(const std::string& path, const std::map<std::string, std::string>& labels = {}) const;
+
+private:
+    Metrics();
+
+    struct Histogram {
+        // Not cumulative; render() sums them up
+        std::array<std::atomic<uint64_t>, BUCKET_BOUNDS.size() + 1> buckets{};
+        std::atomic<uint64_t> sumNanos{0};
+    };
+
+    static constexpr std::size_t PHASE_COUNT = static_cast<std::size_t>(Phase::COUNT);
+    static constexpr std::size_t TIER_COUNT = static_cast<std::size_t>(CacheTier::COUNT);
+    // Kinds of request: args, compare, invalid
+    static constexpr std::size_t REQUEST_KIND_COUNT = 3;
+
+    std::chrono::system_clock::time_point startTime;
+    std::array<std::array<std::atomic<uint64_t>, 2>, REQUEST_KIND_COUNT> requests{};
+    std::array<Histogram, PHASE_COUNT> phases;
+    std::array<std::array<std::atomic<uint64_t>, 2>, TIER_COUNT> cacheLookups{};
+    std::array<std::atomic<uint64_t>, 2> parseFailures{};
+    std::atomic<uint64_t> queueDepth{0};
+    std::atomic<int64_t> busyDepth{0};
+    std::atomic<uint64_t> busyNanos{0};
+    // When the outermost beginBusy() ran, in steady clock nanoseconds
+    std::atomic<int64_t> busySince{0};
+};
+
+/**
+ * @class MetricsTimer
+ * @brief Observes the time from construction to destruction as a phase of Metrics.
+ */
+class MetricsTimer {
+public:
+    explicit MetricsTimer(Metrics::Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~MetricsTimer() { Metrics::getInstance().observe(phase, std::chrono::steady_clock::now() - start); }
+    MetricsTimer(const MetricsTimer&) = delete;
+    MetricsTimer& operator=(const MetricsTimer&) = delete;
+
+private:
+    Metrics::Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+}
@@ -0,0 +1,115 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+#include "report_format.hpp"
+
+namespace armor {
+
+/**
+ * @brief Where one run writes its reports, debug dumps, log and scratch files.
+ *
+ * Everything lives under `root` (the working directory when empty) in the
+ * layout of a plain run: armor_reports/ for the reports and profiles,
+ * debug_output/ for AST diff dumps, the diagnostics log and scratch space.
+ * Runs with distinct roots share no files.
+ */
+struct OutputPaths {
+    std::string root;
+    // Diagnostics log (--log-file); empty for the default under `root`
+    std::string logPath;
+    // Write the AST diff dumps and the diagnostics log gzip-compressed (--compress-debug-output)
+    bool compressDebugOutput = false;
+    // Write the per-header reports; when off they are only recorded in ReportSummaries (armor::Comparator)
+    bool writeReports = true;
+
+    std::string htmlReportDir() const;
+    std::string jsonReportDir() const;
+    std::string profileDir() const;
+    std::string astDiffDir() const;
+
+    /**
+     * @brief AST diff dump of the header with basename `headerName`, with the
+     *        extension of `format`, and .gz when compressing debug output.
+     */
+    std::string astDiffFile(const std::string& headerName, ReportFormat format = ReportFormat::JSON) const;
+
+    /**
+     * @brief Diagnostics log, by default debug_output/logs/diagnostics.log;
+     *        .gz is appended when compressing debug output.
+     */
+    std::string logFile() const;
+
+    /**
+     * @brief Log of the worker process numbered `worker` (--isolate), next to
+     *        logFile(), e.g. debug_output/logs/diagnostics.worker0.log.
+     */
+    std::string workerLogFile(unsigned worker) const;
+
+    /** @brief Scratch directory of one feature, e.g. "pch", under debug_output/. */
+    std::string scratchDir(const std::string& name) const;
+
+    /** @brief HTML report of the header with basename `headerName`. */
+    std::string htmlReportFile(const std::string& headerName) const;
+
+    /** @brief JSON report of the header with basename `headerName`, with the extension of `format`. */
+    std::string jsonReportFile(const std::string& headerName, ReportFormat format = ReportFormat::JSON) const;
+
+    /** @brief HTML report of every header of one run (--combined-report). */
+    std::string combinedHtmlFile() const;
+
+    /** @brief Combined HTML report of every header, written by `armor merge`. */
+    std::string summaryHtmlFile() const;
+
+    /** @brief Combined JSON report of every header, written by `armor merge`. */
+    std::string summaryJsonFile() const;
+
+    /** @brief Output root of one configuration of --macro-matrix, named `name`. */
+    std::string configurationRoot(const std::string& name) const;
+
+    /** @brief Output root of one project of --pairs-file, named `name`. */
+    std::string pairsProjectRoot(const std::string& name) const;
+
+    /** @brief HTML report of the findings of every --macro-matrix configuration. */
+    std::string matrixHtmlFile() const;
+
+    /** @brief JSON report of the findings of every --macro-matrix configuration. */
+    std::string matrixJsonFile() const;
+
+    /** @brief Output root of one comparison of `armor chain`, named `name`, e.g. "v1_v2". */
+    std::string chainStepRoot(const std::string& name) const;
+
+    /** @brief JSON summary of every comparison of `armor chain`. */
+    std::string chainJsonFile() const;
+
+    /** @brief Output root of the comparison of `armor multibase` against one base, e.g. "base1". */
+    std::string multiBaseRoot(const std::string& name) const;
+
+    /** @brief JSON summary of every comparison of `armor multibase` and of their combined statuses. */
+    std::string multiBaseJsonFile() const;
+
+    /** @brief Output root of the comparison of one `armor whatif` candidate, e.g. "patch1". */
+    std::string whatIfRoot(const std::string& name) const;
+
+    /** @brief JSON summary of the verdict of every `armor whatif` candidate. */
+    std::string whatIfJsonFile() const;
+
+    /** @brief API inventory of the header with basename `headerName` written by `armor dump-api`. */
+    std::string apiDumpFile(const std::string& headerName, ReportFormat format = ReportFormat::JSON) const;
+
+    /** @brief JSON summary of the statuses of `armor check` against a lock file. */
+    std::string checkJsonFile() const;
+
+    /** @brief Content digests of the newer version's headers, read back by --base-manifest. */
+    std::string digestManifestFile() const;
+
+    /** @brief Output root of one round of one run of `armor bench-sweep`, e.g. "sweep/run1/round2". */
+    std::string sweepRoundRoot(unsigned run, unsigned round) const;
+
+    /** @brief JSON summary of the throughput, latencies and peak RSS measured by `armor bench-sweep`. */
+    std::string sweepJsonFile() const;
+};
+
+}
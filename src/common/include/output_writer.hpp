@@ -0,0 +1,145 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <llvm/ADT/StringSet.h>
+
+namespace armor {
+
+/**
+ * @class OutputWriter
+ * @brief Writes finished report and dump files, on a thread of its own once started (--async-output).
+ *
+ * Until start() the files are written by the caller. Once started, the
+ * callers hand over whole files and go on; the writer thread takes every
+ * file queued since its last pass at once and writes each with one write.
+ * A caller handing over a file while more than the pending limit waits
+ * blocks until the writer catches up.
+ *
+ * Either way the directory of a file is created the first time a file is
+ * written into it, not once per file.
+ */
+class OutputWriter {
+public:
+    static constexpr std::size_t DEFAULT_MAX_PENDING_BYTES = 256 * 1024 * 1024;
+
+    static OutputWriter& getInstance();
+
+    /** @brief Starts the writer thread; files handed over later are written by it. */
+    void start(std::size_t maxPendingBytes = DEFAULT_MAX_PENDING_BYTES);
+
+    /** @brief Whether the writer thread is running. */
+    bool isAsync() const;
+
+    /**
+     * @brief Writes `contents` to `path`, replacing it, on the writer thread if started.
+     * @return False if the file was written here and could not be; failures of
+     *         the writer thread are logged and counted by finish().
+     */
+    bool write(const std::string& path, std::string contents);
+
+    /**
+     * @brief Writes every file handed over so far and stops the writer thread.
+     * @return Number of files the writer thread failed to write.
+     */
+    std::size_t finish();
+
+    /**
+     * @brief Creates `dir` and its parents unless an earlier call did.
+     *
+     * A file that cannot be opened in a directory created earlier has its
+     * directory created again.
+     */
+    bool createDirectories(const std::string& dir);
+
+    /** @brief createDirectories() of the directory `path` is in. */
+    bool createParentDirectories(const std::string& path);
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+private:
+    OutputWriter() = default;
+    ~OutputWriter();
+
+    struct PendingFile {
+        std::string path;
+        std::string contents;
+    };
+
+    friend class OutputFile;
+
+    bool writeFile(const PendingFile& file);
+    void writeLoop();
+    // For a directory removed since it was created, as the AST diff directory between --watch runs
+    void forgetParentDirectories(const std::string& path);
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable spaceFreed;
+    std::deque<PendingFile> pending;
+    std::size_t pendingBytes = 0;
+    std::size_t maxPendingBytes = DEFAULT_MAX_PENDING_BYTES;
+    bool stopping = false;
+    std::thread writerThread;
+    std::atomic<std::size_t> failures{0};
+
+    std::mutex directoriesMutex;
+    llvm::StringSet<> directories;
+};
+
+/**
+ * @class OutputFile
+ * @brief A report or dump file written through OutputWriter.
+ *
+ * Without the writer thread, stream() writes to the file itself through a
+ * large buffer. With it, stream() collects the file in memory and close()
+ * hands it to the writer.
+ */
+class OutputFile {
+public:
+    /** Creates the file's directory, and opens the file unless the writer thread is running. */
+    explicit OutputFile(std::string path, bool binary = false);
+
+    /** Closes the file if close() was not called. */
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    std::ostream& stream();
+
+    /** @brief Whether the stream has not failed so far. */
+    explicit operator bool() const;
+
+    /** @brief Bytes written to stream() so far. */
+    std::size_t size();
+
+    /**
+     * @brief Finishes the file: closes it, or hands it to the writer thread.
+     * @return Whether every write so far succeeded.
+     */
+    bool close();
+
+private:
+    std::string path;
+    bool async;
+    bool closed = false;
+    std::vector<char> buffer;
+    std::ofstream file;
+    std::ostringstream memory;
+};
+
+}
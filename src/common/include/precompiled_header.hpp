@@ -0,0 +1,61 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+
+namespace armor {
+
+/**
+ * @class PrecompiledHeaderCache
+ * @brief Builds a PCH of a user supplied prefix header once per include configuration.
+ *
+ * The prefix header lists the system and SDK includes shared by the compared
+ * headers. It is precompiled on first use for every distinct base command
+ * line (see buildBaseCompileFlags) and force-included with -include-pch into
+ * each header parsed with that configuration, so the shared include set is
+ * parsed once per run instead of once per header.
+ *
+ * Declarations deserialized from the PCH are located in the prefix's files,
+ * never in the main file, so the normalizers skip them exactly as they skip
+ * declarations from textually included headers.
+ *
+ * Safe to share between parallel workers.
+ */
+class PrecompiledHeaderCache {
+public:
+    /**
+     * @param prefixHeader Header to precompile.
+     * @param outputDir    Directory receiving the .pch files.
+     */
+    PrecompiledHeaderCache(const std::string& prefixHeader, const std::string& outputDir);
+
+    /**
+     * @brief Returns the PCH built for `baseFlags`, building it on first use.
+     *
+     * @param projectRoot Working directory of the build.
+     * @param baseFlags   Command line shared by the headers that will include the PCH.
+     * @return Absolute path of the PCH, or an empty string if it failed to
+     *         build; callers then parse without it.
+     */
+    std::string get(const std::string& projectRoot, const std::vector<std::string>& baseFlags);
+
+    /**
+     * @brief Appends the -include-pch flags for `pchPath` if it is not empty.
+     */
+    static void addIncludeFlags(std::vector<std::string>& flags, const std::string& pchPath);
+
+private:
+    std::string prefixHeader;
+    std::string outputDir;
+
+    // Held across a build so concurrent workers wait for the first one
+    std::mutex buildMutex;
+    llvm::StringMap<std::string> builtHeaders;
+};
+
+}
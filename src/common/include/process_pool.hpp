@@ -0,0 +1,99 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace armor {
+
+/**
+ * @class ProcessPool
+ * @brief Long-lived worker processes running tasks in isolation: a task that
+ *        crashes its worker fails alone, and the worker is replaced.
+ *
+ * Workers are forked from the calling process by the first run(), so they
+ * start with everything it set up (LLVM, caches, options) and keep what they
+ * build across tasks and runs. A task is sent to an idle worker as its index,
+ * and its result comes back as a string, over a pair of pipes per worker.
+ * The log is held still while forking, see DebugConfig::prepareFork(); no
+ * other thread of the calling process may hold a lock a task needs.
+ */
+class ProcessPool {
+public:
+    // Runs in a worker; what it returns is handed to Done in the calling process
+    using Work = std::function<std::string(std::size_t task)>;
+    // Runs in a new worker before its first task, with a number no other worker of the pool had
+    using WorkerStart = std::function<void(unsigned worker)>;
+    // `result` is null if the task failed, with `failure` saying how
+    using Done = std::function<void(std::size_t task, const std::string* result, const std::string& failure)>;
+
+    // The failure of a task whose worker was killed for running past the task timeout
+    static constexpr const char* TIMEOUT_FAILURE = "timed out";
+
+    /**
+     * @param workers Worker processes, at least 1.
+     */
+    ProcessPool(unsigned workers, Work work, WorkerStart onStart = {});
+
+    /** Lets the workers finish their logs and exit, and waits for them. */
+    ~ProcessPool();
+
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    /**
+     * @brief Runs every task of `tasks` on the workers, handing them out in
+     *        that order, and calls `done` for each, on the calling thread, as
+     *        it finishes. Returns once all are done.
+     *
+     * A task whose worker dies, or whose Work throws, fails; only the dead
+     * worker is replaced.
+     */
+    void run(const std::vector<std::size_t>& tasks, const Done& done);
+
+    /**
+     * @brief Kills a worker whose task runs longer than `timeout` and fails the
+     *        task with TIMEOUT_FAILURE; the worker is replaced. Zero, the
+     *        default, lets tasks run for as long as they take.
+     */
+    void setTaskTimeout(std::chrono::milliseconds timeout) { taskTimeout = timeout; }
+
+    /** @brief Workers replaced after dying, since construction. */
+    unsigned getRestarts() const { return restarts; }
+
+    /** @brief Workers killed and replaced for running past the task timeout, since construction. */
+    unsigned getTimeouts() const { return timeouts; }
+
+private:
+    struct Worker {
+        pid_t pid = -1;
+        // Task indices go down requestFd, results come up resultFd
+        int requestFd = -1;
+        int resultFd = -1;
+        bool busy = false;
+        std::size_t task = 0;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    void spawn(Worker& worker);
+    // Closes the pipes of `worker` and waits for it; how it ended
+    std::string reap(Worker& worker);
+    [[noreturn]] void serve(int requestFd, int resultFd);
+
+    unsigned workerCount;
+    Work work;
+    WorkerStart onStart;
+    std::vector<Worker> workers;
+    unsigned spawned = 0;
+    unsigned restarts = 0;
+    std::chrono::milliseconds taskTimeout{0};
+    unsigned timeouts = 0;
+};
+
+}
@@ -0,0 +1,482 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "comm_def.hpp"
+#include "hardware_counters.hpp"
+#include "memory_usage.hpp"
+
+namespace armor::profile {
+
+enum class Phase : uint8_t {
+    PROCESS_FILE,
+    CACHE_LOAD,
+    HANDLE_TRANSLATION_UNIT,
+    // Nested in HANDLE_TRANSLATION_UNIT: the beta TreeBuilder walk, and the
+    // SourceHashIndex prefix tables built during it
+    TREE_BUILD,
+    HASH_INDEX,
+    DIFF_TREES,
+    PREPROCESS_API_CHANGES,
+    GENERATE_HTML_REPORT,
+    GENERATE_JSON_REPORT,
+    COUNT
+};
+
+enum class Counter : uint8_t {
+    NODES_BUILT,
+    USRS_GENERATED,
+    HASHES_COMPUTED,
+    JSON_BYTES_WRITTEN,
+    COUNT
+};
+
+constexpr std::size_t PHASE_COUNT = static_cast<std::size_t>(Phase::COUNT);
+constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(Counter::COUNT);
+constexpr std::size_t NODE_KIND_COUNT = static_cast<std::size_t>(NodeKind::Unknown) + 1;
+
+llvm::StringRef phaseName(Phase phase);
+
+llvm::StringRef counterName(Counter counter);
+
+namespace detail {
+    // Global operator new calls of one thread, counted by the replaced allocation functions
+    struct ThreadAllocations {
+        uint64_t bytes = 0;
+        uint64_t count = 0;
+    };
+
+    extern thread_local ThreadAllocations threadAllocations;
+    extern bool allocationHooksLinked;
+}
+
+/**
+ * @brief Whether the executable replaces the global allocation functions to count allocations.
+ *
+ * Only builds configured with -DARMOR_ALLOC_PROFILING=ON link them; elsewhere
+ * the allocation columns of --profile=mem stay 0.
+ */
+bool allocationsCounted();
+
+/**
+ * @class HeaderProfile
+ * @brief Phase times and counters of one compared header.
+ *
+ * Both versions of a header record into the same profile, possibly from
+ * different threads at once, so phase times are summed over threads and
+ * can exceed the wall time of the header.
+ *
+ * With memory profiling (--profile=mem), every phase also sums the bytes and
+ * calls of global operator new made by the thread running it (see
+ * allocationsCounted), and keeps the largest resident set seen at the end of
+ * its once-per-header timers.
+ * Allocations clang makes straight through malloc, such as its AST slabs,
+ * only show in the resident set.
+ *
+ * With hardware profiling (--profile=hw), every phase also sums the
+ * hardware counter deltas of the thread running it.
+ */
+class HeaderProfile {
+public:
+    explicit HeaderProfile(std::string header) : header(std::move(header)) {}
+
+    const std::string& getHeader() const { return header; }
+
+    void addPhase(Phase phase, std::chrono::nanoseconds elapsed) {
+        std::size_t i = static_cast<std::size_t>(phase);
+        phaseNanos[i].fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+        phaseCalls[i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add(Counter counter, uint64_t amount) {
+        counters[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void addAllocations(Phase phase, uint64_t bytes, uint64_t count) {
+        std::size_t i = static_cast<std::size_t>(phase);
+        phaseAllocatedBytes[i].fetch_add(bytes, std::memory_order_relaxed);
+        phaseAllocations[i].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void noteResident(Phase phase, uint64_t bytes) {
+        std::atomic<uint64_t>& peak = phasePeakResident[static_cast<std::size_t>(phase)];
+        uint64_t seen = peak.load(std::memory_order_relaxed);
+        while (seen < bytes && !peak.compare_exchange_weak(seen, bytes, std::memory_order_relaxed)) {
+        }
+    }
+
+    void addHardware(Phase phase, const HardwareSample& delta) {
+        std::array<std::atomic<uint64_t>, HARDWARE_EVENT_COUNT>& events = phaseHardware[static_cast<std::size_t>(phase)];
+        for (std::size_t i = 0; i < HARDWARE_EVENT_COUNT; ++i) {
+            events[i].fetch_add(delta[i], std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Widens the wall-clock span of the header to cover [start, end].
+     *
+     * The span runs from the first once-per-header timer started to the last
+     * one ended, on any thread: the latency of the header as a run sees it.
+     */
+    void noteSpan(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        int64_t from = start.time_since_epoch().count();
+        int64_t to = end.time_since_epoch().count();
+        int64_t seen = spanStart.load(std::memory_order_relaxed);
+        while (from < seen && !spanStart.compare_exchange_weak(seen, from, std::memory_order_relaxed)) {
+        }
+        seen = spanEnd.load(std::memory_order_relaxed);
+        while (to > seen && !spanEnd.compare_exchange_weak(seen, to, std::memory_order_relaxed)) {
+        }
+    }
+
+    void addNodes(NodeKind kind, uint64_t amount) {
+        nodeKinds[static_cast<std::size_t>(kind)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint64_t getPhaseNanos(Phase phase) const {
+        return phaseNanos[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getPhaseCalls(Phase phase) const {
+        return phaseCalls[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getCounter(Counter counter) const {
+        return counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getAllocatedBytes(Phase phase) const {
+        return phaseAllocatedBytes[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getAllocations(Phase phase) const {
+        return phaseAllocations[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getPeakResident(Phase phase) const {
+        return phasePeakResident[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getHardware(Phase phase, HardwareEvent event) const {
+        return phaseHardware[static_cast<std::size_t>(phase)][static_cast<std::size_t>(event)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getNodes(NodeKind kind) const {
+        return nodeKinds[static_cast<std::size_t>(kind)].load(std::memory_order_relaxed);
+    }
+
+    /** @brief Nanoseconds of the span noted by noteSpan; 0 if none was. */
+    uint64_t getWallNanos() const {
+        int64_t from = spanStart.load(std::memory_order_relaxed);
+        int64_t to = spanEnd.load(std::memory_order_relaxed);
+        return to > from ? static_cast<uint64_t>(to - from) : 0;
+    }
+
+    /**
+     * @brief Returns {"header", "phases": {name: {"calls", "ms"}}, "counters": {name: value}},
+     *        with "allocated_bytes", "allocations" and "peak_rss_bytes" in every phase and
+     *        "node_kinds": {kind: nodes} when `memory`, and "hardware": {event: count}
+     *        in every phase when `hardware`.
+     */
+    nlohmann::json toJson(bool memory = false, bool hardware = false) const;
+
+private:
+    std::string header;
+    std::array<std::atomic<uint64_t>, PHASE_COUNT> phaseNanos{};
+    std::array<std::atomic<uint64_t>, PHASE_COUNT> phaseCalls{};
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    std::array<std::atomic<uint64_t>, PHASE_COUNT> phaseAllocatedBytes{};
+    std::array<std::atomic<uint64_t>, PHASE_COUNT> phaseAllocations{};
+    std::array<std::atomic<uint64_t>, PHASE_COUNT> phasePeakResident{};
+    std::array<std::atomic<uint64_t>, NODE_KIND_COUNT> nodeKinds{};
+    std::array<std::array<std::atomic<uint64_t>, HARDWARE_EVENT_COUNT>, PHASE_COUNT> phaseHardware{};
+    // steady_clock ticks, see noteSpan
+    std::atomic<int64_t> spanStart{INT64_MAX};
+    std::atomic<int64_t> spanEnd{INT64_MIN};
+};
+
+/**
+ * @class Profiler
+ * @brief Process wide registry of header profiles, enabled by --profile.
+ *
+ * With --trace-out it also records every PhaseTimer and TraceSpan as a
+ * Chrome trace event, one track per thread. Each thread appends to its own
+ * buffer, so recording takes no lock.
+ *
+ * While neither is enabled no profile is handed out, so every PhaseTimer
+ * and count() reduces to a null check of the calling thread's current profile.
+ */
+class Profiler {
+public:
+    static Profiler& getInstance() {
+        static Profiler inst;
+        return inst;
+    }
+
+    void setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    void setTracing(bool value) { tracing.store(value, std::memory_order_relaxed); }
+
+    bool isTracing() const { return tracing.load(std::memory_order_relaxed); }
+
+    /** @brief Whether enabled profiles also account memory per phase (--profile=mem). */
+    void setMemoryProfiling(bool value) { memory.store(value, std::memory_order_relaxed); }
+
+    bool isMemoryProfiling() const { return memory.load(std::memory_order_relaxed); }
+
+    /** @brief Whether enabled profiles also read hardware counters per phase (--profile=hw). */
+    void setHardwareProfiling(bool value) { hardware.store(value, std::memory_order_relaxed); }
+
+    bool isHardwareProfiling() const { return hardware.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the profile of `filePath`, created on first use.
+     *
+     * Profiles are keyed by file name, as the reports are, so both versions
+     * of a header share one.
+     * @return nullptr while neither profiling nor tracing is enabled.
+     */
+    HeaderProfile* forHeader(llvm::StringRef filePath);
+
+    /**
+     * @brief Prints the phase and counter totals over all headers as a table.
+     */
+    void printSummary() const;
+
+    /**
+     * @brief Writes profile_<header>.json for every header into `outputDir`.
+     */
+    void writeReports(const std::string& outputDir) const;
+
+    /**
+     * @brief Calls `visit` with every header profile, in header order.
+     */
+    void forEachProfile(llvm::function_ref<void(const HeaderProfile&)> visit) const;
+
+    /**
+     * @brief Records a span of `profile`'s header on the calling thread's track, if tracing.
+     * @param name Event name; must outlive the trace, e.g. a string literal.
+     */
+    void recordSpan(llvm::StringRef name, const HeaderProfile* profile,
+                    std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    /**
+     * @brief Writes the recorded spans as a Chrome / Perfetto trace-event JSON file.
+     *
+     * Must only be called once the threads that recorded spans are done.
+     * @return false if `path` cannot be written.
+     */
+    bool writeTrace(const std::string& path) const;
+
+    /**
+     * @brief Drops all profiles and spans, e.g. between two runs of a daemon.
+     */
+    void reset();
+
+private:
+    struct TraceEvent {
+        llvm::StringRef name;
+        const HeaderProfile* profile;
+        int64_t startNanos;
+        int64_t durationNanos;
+    };
+
+    struct ThreadTrace {
+        unsigned tid;
+        std::vector<TraceEvent> events;
+    };
+
+    Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    ThreadTrace& getThreadTrace();
+
+    // The calling thread's trace buffer, valid while threadGeneration == traceGeneration
+    static thread_local ThreadTrace* threadTrace;
+    static thread_local uint64_t threadGeneration;
+
+    mutable std::mutex mutex;
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> tracing{false};
+    std::atomic<bool> memory{false};
+    std::atomic<bool> hardware{false};
+    std::map<std::string, std::unique_ptr<HeaderProfile>> headers;
+    std::vector<std::unique_ptr<ThreadTrace>> threadTraces;
+    // Bumped by reset() so threads drop their cached ThreadTrace
+    std::atomic<uint64_t> traceGeneration{0};
+    std::chrono::steady_clock::time_point traceStart;
+};
+
+namespace detail {
+    extern thread_local HeaderProfile* currentProfile;
+    // The phase of the innermost PhaseTimer of the thread, Phase::COUNT outside any; read by StackSampler
+    extern thread_local Phase currentPhase;
+}
+
+/**
+ * @brief Returns the profile the calling thread records into, or nullptr.
+ */
+inline HeaderProfile* current() {
+    return detail::currentProfile;
+}
+
+/**
+ * @brief Adds `amount` to `counter` of the calling thread's current profile.
+ */
+inline void count(Counter counter, uint64_t amount = 1) {
+    if (HeaderProfile* profile = detail::currentProfile) {
+        profile->add(counter, amount);
+    }
+}
+
+/**
+ * @class HeaderScope
+ * @brief Makes the profile of a header current on this thread until destroyed.
+ */
+class HeaderScope {
+public:
+    explicit HeaderScope(llvm::StringRef filePath)
+        : HeaderScope(Profiler::getInstance().forHeader(filePath)) {}
+
+    explicit HeaderScope(HeaderProfile* profile) : previous(detail::currentProfile) {
+        detail::currentProfile = profile;
+    }
+
+    ~HeaderScope() { detail::currentProfile = previous; }
+
+    HeaderScope(const HeaderScope&) = delete;
+    HeaderScope& operator=(const HeaderScope&) = delete;
+
+private:
+    HeaderProfile* previous;
+};
+
+/**
+ * @brief Adds `amount` nodes of `kind` to the calling thread's current profile, if memory is profiled.
+ */
+inline void countNodes(NodeKind kind, uint64_t amount = 1) {
+    if (HeaderProfile* profile = detail::currentProfile) {
+        if (Profiler::getInstance().isMemoryProfiling()) {
+            profile->addNodes(kind, amount);
+        }
+    }
+}
+
+/**
+ * @class PhaseTimer
+ * @brief Adds its lifetime to `phase` of the profile current at construction.
+ *
+ * The lifetime is also traced unless `traced` is false, which suits timers
+ * run once per diff entry rather than once per header; such timers account
+ * allocations but do not sample the resident set.
+ *
+ * Under hardware profiling it reads the thread's counters when constructed
+ * and destroyed, a system call each. Until destroyed, StackSampler tags the
+ * samples of the thread with `phase`.
+ */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase, bool traced = true)
+        : profile(detail::currentProfile), phase(phase), traced(traced) {
+        if (profile) {
+            previousPhase = detail::currentPhase;
+            detail::currentPhase = phase;
+            memory = Profiler::getInstance().isMemoryProfiling();
+            startAllocations = detail::threadAllocations;
+            start = std::chrono::steady_clock::now();
+            hardware = Profiler::getInstance().isHardwareProfiling() && readHardwareCounters(startCounters);
+        }
+    }
+
+    ~PhaseTimer() {
+        if (profile) {
+            HardwareSample endCounters;
+            if (hardware && readHardwareCounters(endCounters)) {
+                // Scaled totals can step back by a rounding error
+                for (std::size_t i = 0; i < HARDWARE_EVENT_COUNT; ++i) {
+                    endCounters[i] = endCounters[i] > startCounters[i] ? endCounters[i] - startCounters[i] : 0;
+                }
+                profile->addHardware(phase, endCounters);
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            profile->addPhase(phase, end - start);
+            if (memory) {
+                const detail::ThreadAllocations& now = detail::threadAllocations;
+                profile->addAllocations(phase, now.bytes - startAllocations.bytes, now.count - startAllocations.count);
+                if (traced) {
+                    profile->noteResident(phase, armor::residentBytes());
+                }
+            }
+            if (traced) {
+                profile->noteSpan(start, end);
+                Profiler::getInstance().recordSpan(phaseName(phase), profile, start, end);
+            }
+            detail::currentPhase = previousPhase;
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    HeaderProfile* profile;
+    Phase phase;
+    Phase previousPhase = Phase::COUNT;
+    bool traced;
+    bool memory = false;
+    bool hardware = false;
+    detail::ThreadAllocations startAllocations;
+    HardwareSample startCounters;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @class TraceSpan
+ * @brief Traces its lifetime under `name` without adding it to a profile phase.
+ * @param name Event name; must outlive the trace, e.g. a string literal.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(llvm::StringRef name) : profile(detail::currentProfile), name(name) {
+        if (profile) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceSpan() {
+        if (profile) {
+            Profiler::getInstance().recordSpan(name, profile, start, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    HeaderProfile* profile;
+    llvm::StringRef name;
+    std::chrono::steady_clock::time_point start;
+};
+
+}
@@ -0,0 +1,55 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace armor {
+
+/**
+ * @struct ProjectPair
+ * @brief One library of a --pairs-file: its two versions and how to parse them.
+ */
+struct ProjectPair {
+    // Names the project in the output and its output directory
+    std::string name;
+    std::string root1;
+    std::string root2;
+    // As --header-dir; with no headers, every header below it is compared (--recursive)
+    std::string headerDir;
+    std::vector<std::string> headers;
+    std::vector<std::string> includePaths;
+    // Added to the --macro-flags of the command line
+    std::string macroFlags;
+    // cpp or c; empty uses the --lang of the command line
+    std::string lang;
+};
+
+/**
+ * @brief Reads the projects of a --pairs-file.
+ *
+ * The file is a YAML sequence of projects:
+ *
+ *     - name: net
+ *       root1: old/libs/net
+ *       root2: new/libs/net
+ *       header-dir: include
+ *       include-paths: [third_party/asio/include]
+ *       macro-flags: -DNET_SHARED
+ *     - name: codec
+ *       root1: old/libs/codec
+ *       root2: new/libs/codec
+ *       headers: [include/codec.h, include/frame.h]
+ *       lang: c
+ *
+ * name, root1 and root2 are required; a project lists headers, a
+ * header-dir, or both. Names are unique and valid configuration names (see
+ * isValidConfigurationName). Relative roots and include paths are taken
+ * relative to the directory of the file.
+ *
+ * @throws std::runtime_error if the file cannot be read or is not such a list.
+ */
+std::vector<ProjectPair> loadProjectPairs(const std::string& path);
+
+}
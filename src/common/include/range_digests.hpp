@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "fibonacci_hash.hpp"
+#include "hash_multiset.hpp"
+#include "source_hash_index.hpp"
+
+/**
+ * @class RangeDigests
+ * @brief The source ranges behind a header's 64-bit range hashes, to confirm matching hashes with 128-bit digests.
+ *
+ * Two versions' hash multisets compare by fingerprint, so a 64-bit
+ * collision between a changed range and the range it replaced would read
+ * as no change. While a header is parsed, the producers of those hashes
+ * record here the range each one covers, and the main file's text is kept
+ * once the AST goes away. Only when two versions' multisets match does
+ * confirm() digest the ranges behind each hash on both sides and compare
+ * the digests.
+ *
+ * Hashes recorded without a range, such as those replayed from the
+ * declaration subtree cache, and versions without their text, such as
+ * contexts read from the context cache, are taken at their 64-bit word.
+ */
+class RangeDigests {
+public:
+    enum class Category : uint8_t {
+        UnhandledDecls,
+        InactiveUnhandledDecls,
+        Comments
+    };
+
+    /** @brief Records that `hash` covers [startOffset, endOffset) of the main file under `normalization`. */
+    void record(Category category, uint64_t hash, unsigned startOffset, unsigned endOffset,
+                SourceHashIndex::Normalization normalization);
+
+    /** @brief Adds the ranges `other` recorded over the same main file, as by builders beside this one's. */
+    void append(const RangeDigests& other);
+
+    /** @brief Keeps a copy of the main file the recorded ranges refer to. */
+    void keepSource(llvm::StringRef text);
+
+    bool hasSource() const { return sourceKept; }
+
+    /** @brief The kept copy of the main file; empty unless hasSource(). */
+    llvm::StringRef getSource() const { return source; }
+
+    /** @brief Whether no range was recorded. */
+    bool empty() const;
+
+    /**
+     * @brief Whether the ranges behind every hash of `matched` digest alike in both versions.
+     *
+     * False means two different texts of the two versions share a 64-bit
+     * hash. True when either version has no text to digest.
+     */
+    static bool confirm(const RangeDigests& older, const RangeDigests& newer, Category category,
+                        const HashMultiset& matched);
+
+    void clear();
+
+private:
+    struct HashedRange {
+        uint64_t hash;
+        uint32_t startOffset;
+        uint32_t endOffset;
+        SourceHashIndex::Normalization normalization;
+    };
+
+    FibonacciHash::Digest128 digestOf(const HashedRange& range) const;
+
+    std::array<std::vector<HashedRange>, 3> ranges;
+    std::string source;
+    bool sourceKept = false;
+};
@@ -0,0 +1,52 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+namespace armor {
+
+/**
+ * @brief Encoding of the machine-readable reports and AST diff dumps (--report-format).
+ *
+ * The documents are the same in every format. CBOR and MessagePack are the
+ * binary encodings of nlohmann::json, which aggregation tools decode much
+ * faster than JSON text. A file's format is told by its extension.
+ */
+enum class ReportFormat { JSON, CBOR, MSGPACK };
+
+/**
+ * @brief The format named by --report-format; html, which adds no such report, gives JSON.
+ */
+ReportFormat reportFormatOf(const std::string& name);
+
+/** @brief ".json", ".cbor" or ".msgpack". */
+const char* reportExtension(ReportFormat format);
+
+/**
+ * @brief Whether `path` has the extension of a report or dump file in any format.
+ */
+bool isReportFile(const std::string& path);
+
+/**
+ * @brief The format of a report or dump file, from its extension; JSON for other extensions.
+ */
+ReportFormat reportFormatOfPath(const std::string& path);
+
+/**
+ * @brief Writes `document` in `format`; JSON is laid out as json::dump(4).
+ *
+ * `out` must be opened in binary mode for CBOR and MessagePack.
+ */
+void writeReportDocument(std::ostream& out, const nlohmann::json& document, ReportFormat format);
+
+/**
+ * @brief Reads a report or dump file in the format of its extension.
+ * @throws std::runtime_error if the file cannot be opened, nlohmann::json::exception if it is malformed.
+ */
+nlohmann::json readReportDocument(const std::string& path);
+
+}
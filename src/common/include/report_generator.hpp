@@ -2,13 +2,127 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <nlohmann/json.hpp>
 #include "comm_def.hpp"
+#include "report_utils.hpp"
 
+/**
+ * @brief Generate the HTML (and optionally JSON) report from an AST diff JSON file.
+ *
+ * Convenience wrapper that loads `diff_json_path` and forwards to the
+ * in-memory overload.
+ */
 void report_generator(const std::string& diff_json_path,
                           const std::string& header_file_path,
                           const std::string& output_html_path,
                           const std::string& output_json_path,
                           PARSER parser,
                           bool generate_json = false
-                        );
\ No newline at end of file
+                        );
+
+/**
+ * @brief Generate the HTML (and optionally JSON) report from an in-memory AST diff.
+ *
+ * @param diff_root        Result of diffTrees(): either the legacy array or the
+ *                         object carrying the statuses and "astDiff".
+ * @param header_file_path Header path (relative to the project root) shown in the report.
+ * @param output_html_path Path to write the HTML report.
+ * @param output_json_path Path of the JSON report (used when generate_json is set).
+ * @param parser           Parser that produced the diff.
+ * @param generate_json    Also emit the JSON report.
+ */
+void report_generator(const nlohmann::json& diff_root,
+                          const std::string& header_file_path,
+                          const std::string& output_html_path,
+                          const std::string& output_json_path,
+                          PARSER parser,
+                          bool generate_json = false
+                        );
+
+/**
+ * @brief Generate the HTML (and optionally JSON) report from API changes grouped while diffing.
+ *
+ * Used with streamDiffTrees(), which hands the diff entries to `groups` as
+ * they are produced instead of returning them. While CombinedHtmlReport is
+ * open, the HTML report is a section of it instead of `output_html_path`.
+ * While armor::BaselineFindings is loaded, only the changes missing from the
+ * baseline are reported, and the statuses only account for those. With an
+ * empty `output_html_path` and no JSON, the report is only recorded in
+ * ReportSummaries.
+ *
+ * @param groups           Grouped changes of the header.
+ * @param parsed_status    ParsedDiffStatus returned by the diff.
+ * @param unparsed_status  UnParsedDiffStatus returned by the diff.
+ * @param output_html_path Path to write the HTML report.
+ * @param output_json_path Path of the JSON report (used when generate_json is set).
+ * @param parser           Parser that produced the diff.
+ * @param generate_json    Also emit the JSON report.
+ */
+void report_generator(const ApiChangeGroups& groups,
+                          int parsed_status,
+                          int unparsed_status,
+                          const std::string& output_html_path,
+                          const std::string& output_json_path,
+                          PARSER parser,
+                          bool generate_json = false
+                        );
+
+/**
+ * @brief report_generator() of groups the caller hands over, on a render
+ *        thread while report rendering is started, else before returning.
+ *
+ * A diff_root of report_generator() is grouped on the calling thread and
+ * rendered the same way.
+ */
+void submit_report(ApiChangeGroups&& groups,
+                   int parsed_status,
+                   int unparsed_status,
+                   const std::string& output_html_path,
+                   const std::string& output_json_path,
+                   PARSER parser,
+                   bool generate_json = false);
+
+/**
+ * @brief Renders the reports of submit_report() on `threads` threads of their own (--render-jobs).
+ *
+ * Workers comparing headers then hand each report over and go on with the
+ * next header, so parsing never waits on report I/O. At most `capacity`
+ * reports wait to be rendered; a worker submitting one more waits for a slot.
+ */
+void start_report_rendering(unsigned threads, std::size_t capacity);
+
+/**
+ * @brief Waits until every submitted report is written and stops the render threads.
+ *
+ * Run-level outputs reading ReportSummaries must wait for this.
+ *
+ * @return Number of reports whose rendering failed; each is logged.
+ */
+std::size_t finish_report_rendering();
+
+/**
+ * @brief Records the overall status of a header in ReportSummaries, as
+ *        report_generator() would, without grouping records or writing reports.
+ *
+ * Used by --verdict-only, where a single backward incompatible change settles the header.
+ *
+ * @param header_file_path      Header path (relative to the project root).
+ * @param parsed_status         ParsedDiffStatus returned by the diff.
+ * @param unparsed_status       UnParsedDiffStatus returned by the diff.
+ * @param backward_incompatible Whether any change of the header is backward incompatible.
+ * @return The overall status, as getOverAllCategory() names it.
+ */
+const char* report_verdict(const std::string& header_file_path,
+                           int parsed_status,
+                           int unparsed_status,
+                           bool backward_incompatible);
+
+/**
+ * @brief report_verdict() of an in-memory AST diff, read as report_generator() reads it.
+ *
+ * Stops looking at the entries at the first backward incompatible one.
+ */
+const char* report_verdict(const nlohmann::json& diff_root,
+                           const std::string& header_file_path);
@@ -0,0 +1,58 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "diff_utils.hpp"
+#include "output_paths.hpp"
+#include "report_utils.hpp"
+
+namespace armor {
+
+/**
+ * @class MergedReports
+ * @brief The per-header JSON reports of several runs, such as the shards of one sweep, as one report.
+ *
+ * Rows keep the header they came from. The combined statuses are the worst
+ * of all reports: the lowest ParsedDiffStatus, CHANGED if any unparsed
+ * region changed, and backward incompatible if any report is, including the
+ * reports of headers missing from one version, which have no rows.
+ */
+class MergedReports {
+public:
+    /**
+     * @brief Adds every JSON report a run wrote under the output root `root`.
+     *
+     * @return Number of reports read; 0 if the run wrote none.
+     * @throws std::runtime_error if a report cannot be read or is malformed.
+     */
+    std::size_t addRun(const std::string& root);
+
+    /**
+     * @brief Writes the combined HTML and JSON report to outputs.summaryHtmlFile()
+     *        and outputs.summaryJsonFile(), through generate_html_report and
+     *        generate_json_report.
+     */
+    void write(const OutputPaths& outputs) const;
+
+    bool hasBackwardIncompatible() const { return backwardIncompatible; }
+
+    std::size_t reportCount() const { return reports; }
+
+    const ApiChangeGroups& getGroups() const { return groups; }
+
+    ParsedDiffStatus getParsedStatus() const { return parsedStatus; }
+
+    UnParsedDiffStatus getUnparsedStatus() const { return unparsedStatus; }
+
+private:
+    ApiChangeGroups groups;
+    ParsedDiffStatus parsedStatus = ParsedDiffStatus::NON_FUNCTIONAL_CHANGES;
+    UnParsedDiffStatus unparsedStatus = UnParsedDiffStatus::UN_CHANGED;
+    bool backwardIncompatible = false;
+    std::size_t reports = 0;
+};
+
+}
@@ -2,19 +2,28 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "comm_def.hpp"
+#include "output_paths.hpp"
+#include "report_format.hpp"
 
 using json = nlohmann::json;
 
 /**
- * @brief Preprocess API differences into a normalized list of change records.
+ * @struct ChangeRecord
+ * @brief One change of an API, as preprocess_api_changes() makes it from the diff.
  *
- * @param api_differences JSON array describing API changes (diff tree).
- * @param header_file_path Path to the header file being analyzed.
- * @return std::vector<json> Each element contains:
+ * Records stay typed until a report writes them; toJson() is their JSON form:
  *         {
  *           "headerfile": <string>,
  *           "name": <API name>,
@@ -23,16 +32,321 @@ using json = nlohmann::json;
  *           "compatibility": "backward_compatible" | "backward_incompatible"
  *         }
  */
-std::vector<json> preprocess_api_changes(const json& api_differences,
-                                         const std::string& header_file_path);
+struct ChangeRecord {
+    std::string headerfile;
+    std::string name;
+    std::string description;
+    bool compatibilityChanged = false;
+    bool backwardIncompatible = false;
+
+    json toJson() const;
+
+    /**
+     * @brief The record of the JSON form, or of a report row (Group::toRecord);
+     *        missing fields read as empty strings.
+     */
+    static ChangeRecord fromJson(const json& record);
+};
+
+/**
+ * @brief Preprocess API differences into a normalized list of change records.
+ *
+ * The records of each top-level entry depend on that entry alone, so with
+ * several jobs chunks of entries are processed in parallel; the records are
+ * returned in the order of the entries whatever the number of jobs.
+ *
+ * @param api_differences JSON array describing API changes (diff tree).
+ * @param header_file_path Path to the header file being analyzed.
+ * @param jobs Threads the chunks are spread over.
+ */
+std::vector<ChangeRecord> preprocess_api_changes(const json& api_differences,
+                                                 const std::string& header_file_path,
+                                                 unsigned jobs = 1);
+
+/**
+ * @brief Whether any record preprocess_api_changes() makes of one top-level diff
+ *        entry is backward_incompatible, decided without building the records.
+ */
+bool is_backward_incompatible_change(const json& change);
+
+/**
+ * @class DescriptionTemplates
+ * @brief Descriptions of non-function diff entries, memoized by the shape of the entry.
+ *
+ * A bulk edit repeats one change across many declarations, such as the
+ * same field added to many structs. The shape of an entry is the node type,
+ * tag and children of each of its nodes, with every qualified name, data
+ * type, layout and summarized name replaced by a slot. Siblings with equal
+ * names share a slot, and slots are ranked as the names sort, so the
+ * description made from the slots pairs and orders children as the names
+ * would. The first entry of a shape describes it; later ones only fill in
+ * their names. Entries with a function below them are described directly,
+ * since overloads and parameters are matched by the parts of their names.
+ * Not thread-safe; each thread making records keeps its own.
+ */
+class DescriptionTemplates {
+public:
+    /**
+     * @brief The description preprocess_api_changes() gives the non-function entry `change`.
+     */
+    std::string describe(const json& change);
+
+    /** @brief Shapes described so far. */
+    std::size_t size() const { return templates.size(); }
+
+    /** @brief Descriptions filled in from an earlier entry of the same shape. */
+    std::size_t reused() const { return hits; }
+
+private:
+    std::unordered_map<std::string, std::string> templates;
+    std::size_t hits = 0;
+};
 
 /**
- * @brief Generate an HTML report from processed API changes.
+ * @class ApiChangeGroups
+ * @brief Change records grouped by (headerfile, name), so each API gets a single report row.
  *
- * @param processed_data Vector of JSON records from preprocess_api_changes().
- * @param output_html_path Path to write the HTML file.
+ * Diff entries can be added one at a time as the diff engine produces them;
+ * only the grouped descriptions are kept, never the entries or their records.
+ * Records find their group through a hash index keyed by an interned header
+ * id and a view of the API name, so adding one allocates nothing but its
+ * description. The groups are sorted by (headerfile, name) the first time
+ * they are iterated after an addition; iterating is therefore not thread-safe.
  */
-void generate_html_report(const std::vector<json>& processed_data,
+class ApiChangeGroups {
+public:
+    struct Group {
+        std::string headerfile;
+        std::string name;
+        std::vector<std::string> descriptions;
+        bool anyCompatibilityChanged = false;
+        bool anyBackwardIncompatible = false;
+
+        /**
+         * @brief Report row of the group: the record fields with all descriptions joined.
+         */
+        json toRecord() const;
+
+        /**
+         * @brief The descriptions of the group, one per line.
+         */
+        std::string description() const;
+
+        /** @brief "Compatibility Changed" or "Functionality Added". */
+        const char* changeType() const;
+
+        /** @brief "backward_incompatible" or "backward_compatible". */
+        const char* compatibility() const;
+    };
+
+    ApiChangeGroups() = default;
+    explicit ApiChangeGroups(std::string header_file_path) : header_file_path(std::move(header_file_path)) {}
+
+    // The index views names inside the groups, which a move keeps in place and a copy would not
+    ApiChangeGroups(const ApiChangeGroups&) = delete;
+    ApiChangeGroups& operator=(const ApiChangeGroups&) = delete;
+    ApiChangeGroups(ApiChangeGroups&&) = default;
+    ApiChangeGroups& operator=(ApiChangeGroups&&) = default;
+
+    /**
+     * @brief Adds the records of one top-level diff entry, as preprocess_api_changes() would.
+     */
+    void addChange(const json& change);
+
+    /**
+     * @brief Adds the records of every entry of the array `changes`, made on up to
+     *        `jobs` threads and added in the order of the entries (see preprocess_api_changes()).
+     */
+    void addChanges(const json& changes, unsigned jobs);
+
+    /**
+     * @brief Adds one record as returned by preprocess_api_changes().
+     */
+    void addRecord(ChangeRecord&& record);
+
+    /**
+     * @brief Adds one record in its JSON form, e.g. a row of a JSON report.
+     */
+    void addRecord(const json& record);
+
+    bool empty() const { return groups.empty(); }
+    std::size_t size() const { return groups.size(); }
+    bool hasBackwardIncompatible() const { return backwardIncompatible; }
+    const std::string& headerFile() const { return header_file_path; }
+
+    /** @brief A sentence the reports of the header add to their reason, such as the copies it stands for. */
+    void setNote(std::string text) { note_text = std::move(text); }
+    const std::string& note() const { return note_text; }
+
+    std::deque<Group>::const_iterator begin() const;
+    std::deque<Group>::const_iterator end() const;
+
+private:
+    // Views the name of its group, which the deque never moves on insertion
+    struct GroupKey {
+        std::size_t header;
+        std::string_view name;
+
+        bool operator==(const GroupKey& other) const { return header == other.header && name == other.name; }
+    };
+
+    struct GroupKeyHash {
+        std::size_t operator()(const GroupKey& key) const {
+            return std::hash<std::string_view>()(key.name) * 31 + key.header;
+        }
+    };
+
+    // Sorts the groups and re-points the index at them
+    void sortGroups() const;
+
+    std::string header_file_path;
+    std::string note_text;
+    // Of the entries added one at a time
+    DescriptionTemplates descriptionTemplates;
+    std::unordered_map<std::string, std::size_t> headerIds;
+    mutable std::deque<Group> groups;
+    mutable std::unordered_map<GroupKey, std::size_t, GroupKeyHash> index;
+    mutable bool sorted = true;
+    bool backwardIncompatible = false;
+};
+
+/**
+ * @class ReportSummaries
+ * @brief Outcome of the last report written for each header of a run.
+ *
+ * Feeds run-level outputs such as `--ndjson-out`. A later report of a header
+ * replaces the earlier one, as the beta report replaces the alpha one on
+ * disk. Thread-safe.
+ */
+class ReportSummaries {
+public:
+    struct Summary {
+        std::string overallStatus;
+        std::vector<std::string> apiNames;
+        // What the report was written from, set only while keepRecords() is on
+        int parsedStatus = 0;
+        int unparsedStatus = 0;
+        PARSER parser = NO_PARSER;
+        std::vector<ChangeRecord> records;
+    };
+
+    static ReportSummaries& getInstance();
+
+    /**
+     * @brief Whether summaries keep the grouped records and statuses of their
+     *        report, enough to write it again (--history); off until set.
+     */
+    void keepRecords(bool keep);
+    bool keepsRecords() const;
+
+    /**
+     * @brief Records the report of `headerFile`, the header path relative to its project root.
+     */
+    void record(const std::string& headerFile, Summary summary);
+
+    /**
+     * @return false if no report of `headerFile` was recorded since the last clear().
+     */
+    bool find(const std::string& headerFile, Summary& summary) const;
+
+    /**
+     * @brief find() that also forgets the report, for callers that record one header at a time.
+     */
+    bool take(const std::string& headerFile, Summary& summary);
+
+    void clear();
+
+private:
+    mutable std::mutex mutex;
+    std::map<std::string, Summary> summaries;
+    bool keepingRecords = false;
+};
+
+/**
+ * @class CombinedHtmlReport
+ * @brief One HTML page for every header report of a run (--combined-report).
+ *
+ * An index of the headers' overall statuses links to one section per
+ * header. The page head and style are written once by open(), each section
+ * is appended as soon as its header is reported, from any thread, and only
+ * the index rows are held until close() writes them. The page layout shows
+ * the index above the sections, so the file is written in a single pass.
+ * Sections appear in the order the headers finish; the index is sorted by
+ * header path. Thread-safe.
+ */
+class CombinedHtmlReport {
+public:
+    static CombinedHtmlReport& getInstance();
+
+    /**
+     * @brief Starts the page at `path`, creating its directory.
+     * @throws std::runtime_error if the file cannot be created.
+     */
+    void open(const std::string& path);
+
+    /**
+     * @brief Whether header reports go to this page instead of their own files.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Appends the section of one header, with the rows generate_html_report() would write.
+     */
+    void addHeader(const ApiChangeGroups& groups, const char* overall_status, const char* reason);
+
+    /**
+     * @brief Appends the section of a header present in only one version.
+     */
+    void addMissingHeader(const std::string& header_file_path, const char* overall_status, const char* reason);
+
+    /**
+     * @brief Writes the index and ends the page.
+     * @return false if the page could not be written completely.
+     */
+    bool close();
+
+private:
+    struct IndexRow {
+        std::string headerFile;
+        std::string overallStatus;
+        std::size_t apiCount;
+        std::size_t section;
+    };
+
+    // Starts a section and adds its index row; `mutex` must be held
+    void beginSection(const std::string& header_file_path, const char* overall_status, std::size_t apiCount);
+
+    mutable std::mutex mutex;
+    // Declared before `page`, which writes through it until destroyed
+    std::vector<char> pageBuffer;
+    std::ofstream page;
+    std::vector<IndexRow> index;
+};
+
+/**
+ * @brief How generate_html_report() writes the API rows of a header (--html-mode).
+ *
+ * TABLE writes one table row per API. LAZY embeds the rows as compact JSON,
+ * zlib-compressed once it is large, and a small script renders only the rows
+ * in view and filters them in the browser, so the file and the time to write
+ * it no longer grow with the row markup. AUTO uses LAZY for headers with at
+ * least LAZY_HTML_MIN_ROWS APIs and TABLE otherwise.
+ */
+enum class HtmlReportMode { TABLE, LAZY, AUTO };
+
+constexpr std::size_t LAZY_HTML_MIN_ROWS = 10000;
+
+/**
+ * @brief Sets the HTML report mode of the run; TABLE until set.
+ */
+void setHtmlReportMode(HtmlReportMode mode);
+
+HtmlReportMode getHtmlReportMode();
+
+/**
+ * @brief Generate an HTML report from grouped API changes.
+ */
+void generate_html_report(const ApiChangeGroups& groups,
                           const std::string& output_html_path,
                           PARSER parser,
                           int parsed_status,
@@ -44,30 +358,38 @@ void generate_html_report(const std::vector<json>& processed_data,
                         );
 
 /**
- * @brief Create the standard output directories for reports and AST debug dumps,
- *        and return the path to the HTML report file for the given header.
+ * @brief Create the report output directories and return the report paths for the given header.
  *
- * Creates:
- *   - debug_output/ast_diffs
- *   - armor_reports/html_reports
+ * Creates armor_reports/html_reports and armor_reports/json_reports under
+ * the output root.
  *
  * @param headerName  Basename of the header file (e.g. "foo.h").
- * @return std::string  Full path to the HTML report file
- *                      ("armor_reports/html_reports/api_diff_report_<headerName>.html").
+ * @param outputs     Output root of the run.
+ * @param format      Format of the JSON report, which gives its extension.
+ * @return std::pair  Paths of the JSON and HTML report files
+ *                    ("armor_reports/json_reports/api_diff_report_<headerName>.json", ...).
  */
-std::pair<std::string, std::string> prepare_report_output_dirs(const std::string& headerName);
+std::pair<std::string, std::string> prepare_report_output_dirs(const std::string& headerName,
+                                                               const armor::OutputPaths& outputs = {},
+                                                               armor::ReportFormat format = armor::ReportFormat::JSON);
 
 /**
- * @brief Generate a JSON report from processed API changes.
+ * @brief Generate a JSON report from grouped API changes.
+ *
+ * A JSON report is streamed to the file group by group, one row per API with
+ * the fields of Group::toRecord(). CBOR and MessagePack reports are encoded
+ * whole.
  *
- * @param processed_data Vector of JSON records from preprocess_api_changes().
- * @param output_json_path Path to write the JSON file.
+ * @param output_json_path Path to write the JSON file; a .cbor or .msgpack
+ *                         extension writes the same document in that format.
+ * @param baseline         Written as the "baseline" member unless null (see
+ *                         armor::BaselineFindings::delta).
  */
-void generate_json_report(const std::vector<json>& processed_data,
+void generate_json_report(const ApiChangeGroups& groups,
                           const std::string& output_json_path,
                           int parsed_status,
                           int unparsed_status,
                           const std::string& agg_compatibility,
                           const char* overall_status,
-                          const char* reason);
-
+                          const char* reason,
+                          const json& baseline = json());
@@ -0,0 +1,111 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+namespace armor {
+
+/**
+ * @class ReproBundle
+ * @brief What a run parsed, enough to parse it again offline (--capture-bundle, armor --replay).
+ *
+ * A bundle directory holds a copy of every file the parses read, under
+ * files/ at its absolute path, the VFS overlay mapping the original paths to
+ * those copies (overlay.yaml, also usable as `clang -ivfsoverlay`), the JSON
+ * profile of every header under profiles/, and bundle.json:
+ *
+ *     { "format": 1, "arguments": ["armor", ...], "parse_mode": "full", "skip_foreign_bodies": false,
+ *       "pairs": [ { "header": "include/foo.h", "seconds": 1.5,
+ *                    "older": { "project_root": "/src/v1", "file": "/src/v1/include/foo.h", "flags": [...] },
+ *                    "newer": { ... } } ],
+ *       "files": ["/src/v1/include/foo.h", ...] }
+ */
+struct ReproBundle {
+    struct Version {
+        std::string projectRoot;
+        std::string file;
+        // The compile flags the version was parsed with, exactly
+        std::vector<std::string> flags;
+    };
+
+    struct HeaderPair {
+        std::string header;
+        Version older;
+        Version newer;
+        double seconds = 0;
+    };
+
+    // The command line of the captured run
+    std::vector<std::string> arguments;
+    std::string parseMode = "full";
+    bool skipForeignBodies = false;
+    std::vector<HeaderPair> pairs;
+    // Absolute paths of the files read
+    std::vector<std::string> files;
+
+    /**
+     * @brief Writes bundle.json and overlay.yaml to `dir` and copies `files` under it.
+     * @throws std::runtime_error if the directory or a copy cannot be written.
+     */
+    void save(const std::string& dir) const;
+
+    /**
+     * @brief Loads the bundle.json of a bundle directory.
+     * @throws std::runtime_error if it cannot be read or is malformed.
+     */
+    static ReproBundle load(const std::string& dir);
+
+    /**
+     * @brief The files of the bundle in `dir`, at their original paths.
+     * @throws std::runtime_error if overlay.yaml cannot be read.
+     */
+    static llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> createFileSystem(const std::string& dir);
+};
+
+/**
+ * @class BundleCapture
+ * @brief Collects a ReproBundle while a run parses its headers.
+ *
+ * Tools reading through wrap() record every file they open while capturing.
+ * Thread-safe.
+ */
+class BundleCapture {
+public:
+    static BundleCapture& getInstance();
+
+    /** @brief Starts capturing, forgetting what an earlier capture recorded. */
+    void start();
+
+    /** @brief Stops capturing and hands over what was recorded; `files` sorted. */
+    ReproBundle finish();
+
+    bool isCapturing() const;
+
+    void recordPair(ReproBundle::HeaderPair pair);
+
+    /** @brief Sets the seconds the pair of `header` took, once it is reported. */
+    void recordSeconds(const std::string& header, double seconds);
+
+    /** @brief `underlying`, recording the absolute path of every file opened through it. */
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> wrap(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying);
+
+private:
+    class RecordingFileSystem;
+
+    void recordRead(std::string path);
+
+    mutable std::mutex mutex;
+    bool capturing = false;
+    std::vector<ReproBundle::HeaderPair> pairs;
+    std::set<std::string> files;
+};
+
+}
@@ -0,0 +1,99 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace armor {
+
+/**
+ * @brief CPUs this process may use: the fewest of the host's hardware
+ *        threads, the CPUs of its affinity mask and its cgroup's CPU quota
+ *        (cgroup v2 cpu.max or v1 cpu.cfs_quota_us), rounded up. At least 1.
+ *
+ * A container given two CPUs of a 64-core runner thus gets 2, where
+ * std::thread::hardware_concurrency() reports 64.
+ */
+unsigned availableCpus();
+
+/**
+ * @brief Memory limit of this process's cgroup in bytes (cgroup v2
+ *        memory.max or v1 memory.limit_in_bytes); 0 when it has none, it
+ *        exceeds physical memory or it cannot be read.
+ */
+std::size_t cgroupMemoryLimit();
+
+namespace detail {
+
+    // CPUs granted by the text of a cgroup v2 cpu.max, "<quota> <period>" or
+    // "max <period>", rounded up; 0 when unlimited or malformed
+    unsigned cpusFromCpuMax(const std::string& text);
+
+    // CPUs granted by a cgroup v1 CFS quota and period, rounded up; 0 when unlimited
+    unsigned cpusFromCfsQuota(long long quota, long long period);
+
+    // Bytes of the text of a memory.max or memory.limit_in_bytes; 0 for "max" or malformed text
+    std::size_t bytesFromMemoryLimit(const std::string& text);
+
+}
+
+/**
+ * @class MemoryGate
+ * @brief Holds back new work while resident memory is near a limit.
+ *
+ * Each unit of work enters the gate before it starts and leaves it once
+ * done. While the process is above the high-water mark, entering waits for
+ * another unit to leave, so parallelism drops as memory fills up rather
+ * than the process being killed for it. A unit entering while no other is
+ * active always goes ahead, so work never stops altogether. Thread-safe.
+ */
+class MemoryGate {
+public:
+    // Fraction of the limit above which new work waits
+    static constexpr double HIGH_WATER = 0.9;
+
+    /**
+     * @param limitBytes Memory limit; 0 never holds anything back.
+     * @param resident   Resident bytes of the process, residentBytes() unless tested.
+     */
+    explicit MemoryGate(std::size_t limitBytes, std::function<std::size_t()> resident = {});
+
+    /** @brief Waits for room, see the class comment, then counts the caller as active. */
+    void enter();
+
+    /** @brief Counts the caller as done, letting a waiting unit re-check the memory. */
+    void leave();
+
+    /** @brief Units that had to wait to enter. */
+    unsigned getThrottled() const;
+
+    // Enters a gate for the lifetime of the entry
+    class Entry {
+    public:
+        explicit Entry(MemoryGate& gate) : gate(gate) { gate.enter(); }
+        ~Entry() { gate.leave(); }
+        Entry(const Entry&) = delete;
+        Entry& operator=(const Entry&) = delete;
+
+    private:
+        MemoryGate& gate;
+    };
+
+private:
+    // Memory is re-checked this often while waiting, as freed memory wakes no one
+    static constexpr std::chrono::milliseconds RECHECK_INTERVAL{100};
+
+    std::size_t threshold;
+    std::function<std::size_t()> resident;
+    mutable std::mutex mutex;
+    std::condition_variable released;
+    unsigned active = 0;
+    unsigned throttled = 0;
+};
+
+}
@@ -0,0 +1,51 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+#include "result_history.hpp"
+
+namespace armor {
+
+/**
+ * @class ResultCache
+ * @brief Results of compared header pairs kept under a cache directory (--result-cache).
+ *
+ * Where the context cache saves the parse of one version, an entry here is
+ * the final result of a pair: statuses and the records its reports are
+ * rendered from, stored as a HistoryEntry. Entries are keyed by a digest
+ * of everything the result depends on, which the caller computes from both
+ * versions' include closures and the options of the run, so a hit stands
+ * for parsing, diffing and categorizing alike.
+ *
+ * One file per key, written to a temporary file and renamed into place, so
+ * processes may share the directory as they share the context cache. Each
+ * file carries a checksum (see sealCacheEntry); one that fails it is removed.
+ */
+class ResultCache {
+public:
+    /** @brief Creates a cache under `cacheDir`; the directory is created on first store. */
+    explicit ResultCache(const std::string& cacheDir);
+
+    /**
+     * @brief Loads the entry stored under `key`.
+     * @return false if there is none, or it cannot be read or was stored for another key.
+     *         A hit marks the entry as recently used for --cache-max-size.
+     */
+    bool load(const std::string& key, HistoryEntry& entry) const;
+
+    /**
+     * @brief Stores `entry` under `key`, replacing an earlier one.
+     *
+     * Failures are logged and otherwise ignored; the pair is then compared again next time.
+     */
+    void store(const std::string& key, const HistoryEntry& entry) const;
+
+private:
+    std::string entryPath(const std::string& key) const;
+
+    std::string resultDir;
+};
+
+}
@@ -0,0 +1,91 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "comm_def.hpp"
+#include "report_utils.hpp"
+
+namespace armor {
+
+/**
+ * @struct HistoryEntry
+ * @brief Result of comparing one header pair, as kept by ResultHistory.
+ */
+struct HistoryEntry {
+    // Header path relative to the project root, as the reports name it
+    std::string header;
+    // Hash of everything the result depends on, so equal digests give equal reports
+    std::string digest;
+    // The compared versions, as the run named them
+    std::string base;
+    std::string head;
+    // Seconds since the epoch when the run recorded the entry
+    int64_t time = 0;
+    // Seconds the comparison took; 0 for headers sharing a --batch parse
+    double seconds = 0;
+    std::string overallStatus;
+    int parsedStatus = 0;
+    int unparsedStatus = 0;
+    PARSER parser = NO_PARSER;
+    // One per reported API, with the descriptions of its group joined
+    std::vector<ChangeRecord> records;
+
+    nlohmann::json toJson() const;
+
+    /**
+     * @throws nlohmann::json::exception if a field is missing or mistyped.
+     */
+    static HistoryEntry fromJson(const nlohmann::json& entry);
+};
+
+/**
+ * @class ResultHistory
+ * @brief Per-header results of earlier runs (--history).
+ *
+ * Stored as JSON lines, one entry per compared header pair, appended by every
+ * run in a single write, so concurrent runs may share a file and none
+ * rewrites what the others recorded. Entries are kept in the order they
+ * were appended. A line that cannot be read, such as the tail of an
+ * interrupted append, is skipped.
+ */
+class ResultHistory {
+public:
+    /**
+     * @brief Loads a history file; a file that does not exist yet is an empty history.
+     * @throws std::runtime_error if the file cannot be read.
+     */
+    static ResultHistory load(const std::string& path);
+
+    /**
+     * @brief Appends `entries` to the history file at `path`, creating it if needed.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    static void append(const std::string& path, const std::vector<HistoryEntry>& entries);
+
+    /**
+     * @brief Latest entry of `header` with `digest`, or nullptr if none was recorded.
+     */
+    const HistoryEntry* find(const std::string& header, const std::string& digest) const;
+
+    const std::vector<HistoryEntry>& getEntries() const { return entries; }
+
+    /** @brief Number of lines load() could not read. */
+    std::size_t getSkippedLines() const { return skippedLines; }
+
+private:
+    std::vector<HistoryEntry> entries;
+    // Index of the latest entry of each (header, digest)
+    std::map<std::pair<std::string, std::string>, std::size_t> latest;
+    std::size_t skippedLines = 0;
+};
+
+}
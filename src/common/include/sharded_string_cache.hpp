@@ -0,0 +1,66 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+
+namespace armor {
+
+/**
+ * @class ShardedStringCache
+ * @brief Strings computed for the nodes of one AST, shared by every context normalizing it.
+ *
+ * Entries are keyed by an AST node address (a canonical declaration, or a
+ * type's opaque pointer) and a caller-chosen table number, so one cache holds
+ * the USRs, NSRs and type spellings of an AST side by side. Keys are spread
+ * over SHARD_COUNT shards, each behind its own reader-writer lock, so lookups
+ * only ever share a lock and writers only contend within one shard.
+ *
+ * The strings live in the cache until it is destroyed; contexts referencing
+ * them keep it alive. Keys are only meaningful while the AST exists, so a
+ * cache must not outlive its AST's use.
+ */
+class ShardedStringCache {
+public:
+    static constexpr std::size_t SHARD_COUNT = 16;
+
+    ShardedStringCache() = default;
+    ShardedStringCache(const ShardedStringCache&) = delete;
+    ShardedStringCache& operator=(const ShardedStringCache&) = delete;
+
+    /** @brief The string stored for `key` in `table`, if any. */
+    std::optional<llvm::StringRef> find(const void* key, unsigned table) const;
+
+    /**
+     * @brief Stores a copy of `value` for `key` in `table`.
+     * @return The stored string; the one stored first if another thread raced ahead.
+     */
+    llvm::StringRef insert(const void* key, unsigned table, llvm::StringRef value);
+
+    /** @brief Number of entries over all shards and tables. */
+    std::size_t size() const;
+
+private:
+    using Key = std::pair<const void*, unsigned>;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        llvm::DenseMap<Key, llvm::StringRef> strings;
+        llvm::BumpPtrAllocator storage;
+    };
+
+    Shard& shardOf(const void* key) const;
+
+    mutable std::array<Shard, SHARD_COUNT> shards;
+};
+
+}
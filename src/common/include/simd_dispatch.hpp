@@ -0,0 +1,54 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+// x86 builds compile an AVX2 variant of each byte scanner next to the SSE2
+// one whatever -march says, and pick between them at run time
+#if defined(__x86_64__) || defined(__i386__)
+#define ARMOR_SIMD_X86 1
+#define ARMOR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace armor { namespace simd {
+
+/**
+ * @brief Instruction sets of the vectorized byte scanners (the
+ *        whitespace-stripping hash and HTML escaping).
+ */
+enum class Kernel {
+    SCALAR,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+/**
+ * @brief Best kernel this CPU runs among those compiled in: AVX2 where the
+ *        CPU has it and SSE2 otherwise on x86, NEON on AArch64. Detected once.
+ */
+Kernel detectedKernel();
+
+/**
+ * @brief Kernel the byte scanners run: detectedKernel() unless setKernel()
+ *        picked another. Read on every scan, so a change applies to the next one.
+ */
+Kernel activeKernel();
+
+/**
+ * @brief Whether `kernel` is compiled in and this CPU runs it; SCALAR always is.
+ */
+bool supportsKernel(Kernel kernel);
+
+/**
+ * @brief Runs the byte scanners with `kernel` from now on (--simd=off picks
+ *        SCALAR; benchmarks compare the variants).
+ *
+ * Every kernel produces the same results, so a switch is only visible in speed.
+ *
+ * @return false, leaving the active kernel as it was, if `kernel` is not supported.
+ */
+bool setKernel(Kernel kernel);
+
+const char* kernelName(Kernel kernel);
+
+} }
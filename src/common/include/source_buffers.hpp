@@ -0,0 +1,65 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm { namespace vfs {
+    class FileSystem;
+} }
+
+namespace armor {
+
+/**
+ * @class SourceBuffers
+ * @brief Unsaved contents of files of one project root, parsed in place of what is on disk.
+ *
+ * Lets an editor or a review bot compare a candidate version without writing
+ * it out: the buffers are layered over the root by createFileSystem(), so a
+ * buffered file shadows the one on disk, a buffer for a missing file adds it,
+ * and every other file, the root's own included, is read from disk as usual.
+ * Paths are kept absolute and lexically normal, as clang opens them.
+ */
+class SourceBuffers {
+public:
+    explicit SourceBuffers(const std::string& projectRoot);
+
+    /**
+     * @brief Buffers `contents` as the file at `path`, replacing an earlier buffer of it.
+     *
+     * @param path Relative to the project root, or absolute under it.
+     * @throws std::invalid_argument if `path` is outside the project root.
+     */
+    void add(const std::string& path, std::string contents);
+
+    /** @brief Contents buffered for the file at `path`, nullptr if it has none. */
+    const std::string* find(const std::string& path) const;
+
+    /** @brief Whether `path` lies under the project root, where a buffer may shadow its includes. */
+    bool covers(const std::string& path) const;
+
+    bool empty() const { return buffers.empty(); }
+
+    const std::string& getProjectRoot() const { return projectRoot; }
+
+    /**
+     * @brief In-memory file system holding every buffer at its path, to be
+     *        layered over the real one.
+     *
+     * The files reference the buffers without copying them, so this object
+     * must outlive the file system.
+     */
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> createFileSystem() const;
+
+private:
+    std::string absolutePath(const std::string& path) const;
+
+    std::string projectRoot;
+    std::map<std::string, std::string> buffers;
+};
+
+}
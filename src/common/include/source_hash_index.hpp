@@ -0,0 +1,70 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+/**
+ * @class SourceHashIndex
+ * @brief Answers normalized range hashes of one source buffer in O(1).
+ *
+ * The buffer is scanned once per normalization, recording for every raw
+ * offset how many normalized bytes precede it and polynomial prefix hashes
+ * (mod 2^61 - 1) of the normalized bytes. A range hash is then derived from
+ * two prefix entries, so hashing every declaration, statement and directive
+ * of a header costs one pass over it instead of one pass per range.
+ *
+ * Equal normalized text hashes equally wherever it sits, in this buffer or
+ * another one. The Source normalization is computed over the whole buffer,
+ * so ranges must start outside comments and literals, as token-aligned
+ * ranges do.
+ *
+ * The index refers to the buffer without copying it; it must not outlive it.
+ */
+class SourceHashIndex {
+public:
+    enum class Normalization : uint8_t {
+        // Comments, line splices and whitespace outside literals are dropped,
+        // as in FibonacciHash::hashNormalizedSource
+        Source,
+        // Whitespace is dropped, as in FibonacciHash::hash
+        Whitespace
+    };
+
+    explicit SourceHashIndex(llvm::StringRef buffer);
+
+    /**
+     * @brief Returns the buffer this index was built for.
+     */
+    llvm::StringRef getBuffer() const;
+
+    /**
+     * @brief Hashes the raw range [startOffset, endOffset) under `normalization`.
+     *
+     * The prefix tables of a normalization are built on first use.
+     * @return 0 for an empty range or one that ends past the buffer.
+     */
+    uint64_t hash(unsigned startOffset, unsigned endOffset, Normalization normalization);
+
+private:
+    struct PrefixTable {
+        // keptBefore[i]: normalized bytes in the raw range [0, i)
+        std::vector<uint32_t> keptBefore;
+        // prefix[k]: hash of the first k normalized bytes
+        std::vector<uint64_t> prefix;
+        bool built = false;
+    };
+
+    const PrefixTable& getTable(Normalization normalization);
+
+    void build(PrefixTable& table, Normalization normalization);
+
+    llvm::StringRef buffer;
+    PrefixTable source;
+    PrefixTable whitespace;
+    // powers[k]: BASE^k, sized for the longest table built so far
+    std::vector<uint64_t> powers;
+};
@@ -0,0 +1,87 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace armor::profile {
+
+/**
+ * @class StackSampler
+ * @brief In-process sampling profiler behind --profile=sample.
+ *
+ * While running, a SIGPROF arrives for every 1/hertz seconds of CPU time the
+ * process uses, on the thread using it. The handler records that thread's
+ * call stack with backtrace(), with the header profile current on it and the
+ * phase of its innermost PhaseTimer, into a buffer allocated by start(); the
+ * samples that do not fit are only counted. Nothing is symbolized until the
+ * stacks are folded, so a sample costs a stack walk.
+ *
+ * Only armor's exported functions and those of the shared libraries are
+ * named; other frames read `<object>+0x<offset>`, which addr2line resolves.
+ */
+class StackSampler {
+public:
+    static constexpr unsigned DEFAULT_HERTZ = 99;
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 16;
+
+    static StackSampler& getInstance() {
+        static StackSampler inst;
+        return inst;
+    }
+
+    /**
+     * @brief Drops earlier samples and starts sampling `hertz` times per CPU second.
+     * @return false if already running or the timer cannot be set, see getError().
+     */
+    bool start(unsigned hertz = DEFAULT_HERTZ, std::size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Stops sampling; the samples are kept until the next start() or reset().
+     */
+    void stop();
+
+    bool isRunning() const { return running; }
+
+    std::size_t getSampleCount() const;
+
+    /** @brief Samples taken once the buffer was full. */
+    std::size_t getDroppedCount() const;
+
+    /** @brief Why start() failed, empty if it did not. */
+    const std::string& getError() const { return error; }
+
+    /**
+     * @brief Returns the samples as folded stacks, `header;phase;outermost;...;innermost count`,
+     *        one line per distinct stack in byte order, as flamegraph.pl and speedscope read them.
+     *
+     * Samples outside any header or phase are tagged `(no header)` or `(no phase)`.
+     * Must only be called once stopped.
+     */
+    std::vector<std::string> foldedStacks() const;
+
+    /**
+     * @brief Writes foldedStacks() to `path`.
+     * @return false if `path` cannot be written.
+     */
+    bool writeFolded(const std::string& path) const;
+
+    /**
+     * @brief Stops sampling and frees the samples.
+     */
+    void reset();
+
+private:
+    StackSampler() = default;
+    ~StackSampler();
+
+    StackSampler(const StackSampler&) = delete;
+    StackSampler& operator=(const StackSampler&) = delete;
+
+    bool running = false;
+    std::string error;
+};
+
+}
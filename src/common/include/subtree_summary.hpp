@@ -0,0 +1,65 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "comm_def.hpp"
+#include "nlohmann/json.hpp"
+
+// An added or removed subtree with more declarations than this is summarized, see SubtreeSummary
+inline constexpr size_t SUMMARIZED_SUBTREE_SIZE = 256;
+
+// Names of the children a summary lists, the first in declaration order
+inline constexpr size_t SUMMARY_LISTED_NAMES = 10;
+
+/**
+ * @class SubtreeSummary
+ * @brief What a large added or removed subtree declares, reported in place of its children.
+ *
+ * A whole namespace or class appearing or disappearing is one change; its
+ * summary gives the number of declarations below it, how many are of each
+ * kind, and the names of its first children, as the "summary" of the entry:
+ *
+ *     {"descendants": 1200, "kinds": {"Function": 900, "Parameter": 300},
+ *      "names": ["ns::open", "ns::close"]}
+ *
+ * With setSubtreeExpansion(true) every subtree is serialized in full.
+ */
+class SubtreeSummary {
+public:
+    /** @brief Counts one declaration below the root, of `kind`. */
+    void count(NodeKind kind) {
+        ++descendants;
+        ++kinds[kind];
+    }
+
+    /** @brief Lists a child of the root, until SUMMARY_LISTED_NAMES are. */
+    void name(std::string qualifiedName) {
+        if (names.size() < SUMMARY_LISTED_NAMES) {
+            names.push_back(std::move(qualifiedName));
+        }
+    }
+
+    size_t size() const { return descendants; }
+
+    nlohmann::json toJson() const;
+
+private:
+    size_t descendants = 0;
+    std::map<NodeKind, uint32_t> kinds;
+    std::vector<std::string> names;
+};
+
+/**
+ * @brief Whether added and removed subtrees are always serialized in full,
+ *        for --expand-subtrees; otherwise those larger than
+ *        SUMMARIZED_SUBTREE_SIZE are summarized. Off by default.
+ */
+void setSubtreeExpansion(bool enabled);
+
+bool isSubtreeExpansionEnabled();
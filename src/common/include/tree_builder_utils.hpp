@@ -2,12 +2,15 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include <cstdint>
+#include <mutex>
 #include <string>
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLoc.h"
+#include "llvm/ADT/SmallVector.h"
 
 #include "custom_usr_generator.hpp"
 #include "comm_def.hpp"
@@ -18,10 +21,60 @@ clang::QualType unwrapType(clang::QualType type);
 
 std::pair<std::string, clang::TypeLoc> unwrapTypeLoc(clang::TypeLoc TL);
 
-const std::string generateUSRForDecl(const clang::NamedDecl * Decl);
+/**
+ * @brief Unwraps TL as above, writing the modifiers into Out instead, replacing its contents.
+ */
+clang::TypeLoc unwrapTypeLoc(clang::TypeLoc TL, llvm::SmallVectorImpl<char> &Out);
 
-const std::string generateNSRForDecl(const clang::NamedDecl * Decl);
+std::string generateUSRForDecl(const clang::NamedDecl * Decl);
 
-const std::pair<const std::string,const std::string> getTypesWithAndWithoutTypeResolution(const clang::QualType T, const clang::ASTContext &Ctx);
+std::string generateNSRForDecl(const clang::NamedDecl * Decl);
 
-const std::string generateHash( llvm::StringRef qualifiedName , const NodeKind& node );
\ No newline at end of file
+/**
+ * @brief Generates the USR and the NSR of Decl in one traversal into USR and
+ * NSR, replacing their contents, so callers can reuse the buffers.
+ */
+void generateUSRAndNSRForDecl(const clang::NamedDecl * Decl, llvm::SmallVectorImpl<char> &USR, llvm::SmallVectorImpl<char> &NSR);
+
+std::string printTypeAsWritten(const clang::QualType T, const clang::ASTContext &Ctx);
+
+/**
+ * @brief Prints T as written into Out, replacing its contents, so callers
+ * printing many types can reuse one buffer.
+ *
+ * The TypePrinter can create types in Ctx as it prints template arguments;
+ * threads printing types of one AST pass a `printerMutex` it runs under.
+ * Types composed without it are not locked.
+ */
+void printTypeAsWritten(const clang::QualType T, const clang::ASTContext &Ctx, llvm::SmallVectorImpl<char> &Out,
+                        std::mutex *printerMutex = nullptr);
+
+std::string printCanonicalType(const clang::QualType T, const clang::ASTContext &Ctx);
+
+/**
+ * @brief Prints the canonical type of T into Out, replacing its contents,
+ * under `printerMutex` as printTypeAsWritten.
+ */
+void printCanonicalType(const clang::QualType T, const clang::ASTContext &Ctx, llvm::SmallVectorImpl<char> &Out,
+                        std::mutex *printerMutex = nullptr);
+
+/**
+ * @brief Whether printCanonicalType would print T exactly as printTypeAsWritten does.
+ *
+ * True for a type without sugar made of builtin types and tags, through
+ * pointers, references and arrays of constant or no size, as most
+ * parameter and field types are. Tags of or inside a class template
+ * specialization are excluded, as the canonical policy prints their
+ * template arguments resolved. A caller holding the written string can
+ * then skip the second print.
+ */
+bool printsAsCanonical(const clang::QualType T);
+
+std::pair<std::string, std::string> getTypesWithAndWithoutTypeResolution(const clang::QualType T, const clang::ASTContext &Ctx);
+
+/**
+ * @brief 64-bit hash of an alpha node's key, its kind and qualified name.
+ *
+ * Distinct keys can share a hash; alpha::NodeKey compares the key itself.
+ */
+uint64_t generateHash( llvm::StringRef qualifiedName , const NodeKind& node );
\ No newline at end of file
@@ -0,0 +1,48 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+/**
+ * @class TypeUsageIndex
+ * @brief Reverse index from the type names a header spells to the number of declarations spelling them.
+ *
+ * Every declaration with a written type counts once for each distinct name
+ * in it, so `const struct foo *` counts toward `struct` and `foo`.
+ * Qualified names count as one name.
+ *
+ * A diff uses the index to tell a root cause: when a name some declarations
+ * of the older version spelled is spelled by none of the newer version, every
+ * written type that changed from it to another name is one change, the name
+ * being replaced, rather than one change per declaration.
+ */
+class TypeUsageIndex {
+public:
+    /** @brief Counts one declaration written with type `writtenType`. */
+    void addUser(llvm::StringRef writtenType);
+
+    /** @brief Number of declarations whose written type spells `name`. */
+    uint32_t users(llvm::StringRef name) const;
+
+    bool empty() const { return counts.empty(); }
+
+    void clear() { counts.clear(); }
+
+    /**
+     * @brief The one name a written type changed by, if that is all that changed.
+     *
+     * Strips the tokens both spellings start and end with; true if what is
+     * left is a single name on each side, set to `oldName` and `newName`.
+     * `const foo_v1 *` and `const foo_v2 *` changed by `foo_v1` to `foo_v2`;
+     * `int` and `long long` by no single name.
+     */
+    static bool replacedName(llvm::StringRef oldType, llvm::StringRef newType, llvm::StringRef& oldName,
+                             llvm::StringRef& newName);
+
+private:
+    llvm::StringMap<uint32_t> counts;
+};
@@ -0,0 +1,67 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace armor {
+
+/**
+ * @struct FilePatch
+ * @brief The changes of one file in a unified diff, as `diff -u` and `git diff` write them.
+ */
+struct FilePatch {
+    struct Hunk {
+        // As the @@ line gives them: 1-based first lines, 0 starts for empty ranges
+        std::size_t oldStart = 0;
+        std::size_t oldCount = 0;
+        std::size_t newStart = 0;
+        std::size_t newCount = 0;
+        // Every line with its ' ', '-' or '+' prefix and without its newline
+        std::vector<std::string> lines;
+        // "\ No newline at end of file" after the last old or new line
+        bool oldMissingNewline = false;
+        bool newMissingNewline = false;
+    };
+
+    // Without their first component, as `patch -p1` takes them; empty for /dev/null
+    std::string oldPath;
+    std::string newPath;
+    std::vector<Hunk> hunks;
+
+    bool createsFile() const { return oldPath.empty(); }
+    bool deletesFile() const { return newPath.empty(); }
+
+    /** @brief The path of the file in the patched tree, or of the file deleted. */
+    const std::string& path() const { return deletesFile() ? oldPath : newPath; }
+};
+
+/**
+ * @brief Reads the files and hunks of a unified diff.
+ *
+ * Lines outside the ---/+++ headers and hunks, such as the `diff --git`
+ * and `index` lines of git, are skipped. An empty line in a hunk is taken
+ * as an empty context line, as editors strip its trailing space.
+ *
+ * @throws std::runtime_error if a hunk header is malformed, a hunk comes
+ *         before any file header, or a hunk ends before its line counts do.
+ */
+std::vector<FilePatch> parseUnifiedDiff(llvm::StringRef text);
+
+/**
+ * @brief The contents of `original` with the hunks of `patch` applied.
+ *
+ * As `patch` does, a hunk whose context is not at its line is looked for at
+ * the nearest offset from there, and later hunks are shifted by that offset;
+ * no fuzz is applied. The file ends in a newline unless a hunk ending the
+ * file says otherwise.
+ *
+ * @throws std::runtime_error if a hunk's context and removed lines are not found.
+ */
+std::string applyFilePatch(llvm::StringRef original, const FilePatch& patch);
+
+}
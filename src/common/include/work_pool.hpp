@@ -0,0 +1,89 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace armor {
+
+/**
+ * @brief Resolves a user supplied job count to the number of workers to start.
+ *
+ * A value of 0 selects the CPUs available to the process (see availableCpus),
+ * which honours the CPU quota of a container.
+ *
+ * @param requested Requested number of jobs.
+ * @return Number of worker threads to use, never 0.
+ */
+unsigned resolveJobCount(unsigned requested);
+
+/**
+ * @brief Runs task(i) for every i in [0, count) on up to `jobs` worker threads.
+ *
+ * Workers pull the next index from a shared atomic cursor, so a slow item never
+ * holds back the rest of the queue. With `jobs <= 1` (or a single item) the
+ * tasks run inline on the calling thread, in order.
+ *
+ * If a task throws, the remaining items are still processed and the first
+ * exception is rethrown on the calling thread once all workers have joined.
+ *
+ * @param count Number of work items.
+ * @param jobs  Maximum number of concurrent workers.
+ * @param task  Callable invoked with the index of each work item.
+ */
+void parallelFor(std::size_t count, unsigned jobs, const std::function<void(std::size_t)>& task);
+
+/**
+ * @class WorkQueue
+ * @brief Threads of their own running jobs from a bounded queue, one stage of a pipeline.
+ *
+ * Producers hand jobs over with submit() and go on; a producer finding the
+ * queue full waits for a slot, which bounds what the queue holds. Jobs run
+ * in no particular order. An exception escaping a job is logged and
+ * counted, and the stage goes on; finish() tells how many jobs failed.
+ */
+class WorkQueue {
+public:
+    /**
+     * @param threads  Threads running jobs, at least 1.
+     * @param capacity Jobs that may wait in the queue, at least 1.
+     */
+    WorkQueue(unsigned threads, std::size_t capacity);
+
+    /** Runs every job submitted so far and joins the threads, unless finish() did. */
+    ~WorkQueue();
+
+    WorkQueue(const WorkQueue&) = delete;
+    WorkQueue& operator=(const WorkQueue&) = delete;
+
+    /**
+     * @brief Queues `job`, waiting while the queue is full. Thread-safe.
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * @brief Runs every job submitted so far and joins the threads; no job may be submitted after.
+     * @return Number of jobs an exception escaped from.
+     */
+    std::size_t finish();
+
+private:
+    void run();
+
+    std::size_t capacity;
+    std::mutex mutex;
+    std::condition_variable jobAdded;
+    std::condition_variable slotFreed;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+    std::size_t failures = 0;
+    std::vector<std::thread> threads;
+};
+
+}
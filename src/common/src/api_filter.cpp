@@ -0,0 +1,222 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "clang/AST/Attr.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "api_filter.hpp"
+
+namespace {
+
+    // A GlobPattern may reference its source text, so `saver` keeps it alive
+    std::vector<llvm::GlobPattern> readPatterns(const nlohmann::json& in, llvm::StringSaver& saver) {
+        if (!in.is_array()) {
+            throw std::runtime_error("Expected an array of patterns, got " + in.dump());
+        }
+        std::vector<llvm::GlobPattern> patterns;
+        for (const nlohmann::json& entry : in) {
+            llvm::StringRef text = saver.save(entry.get<std::string>());
+            llvm::Expected<llvm::GlobPattern> pattern = llvm::GlobPattern::create(text);
+            if (!pattern) {
+                throw std::runtime_error("Invalid pattern \"" + text.str() + "\" : " + llvm::toString(pattern.takeError()));
+            }
+            patterns.push_back(std::move(*pattern));
+        }
+        return patterns;
+    }
+
+    bool anyMatch(const std::vector<llvm::GlobPattern>& patterns, llvm::StringRef name) {
+        for (const llvm::GlobPattern& pattern : patterns) {
+            if (pattern.match(name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Template and function parameters are part of their owner, never API of their own
+    bool isParameter(const clang::Decl* decl) {
+        return llvm::isa<clang::ParmVarDecl>(decl) || llvm::isa<clang::TemplateTypeParmDecl>(decl) ||
+               llvm::isa<clang::NonTypeTemplateParmDecl>(decl) || llvm::isa<clang::TemplateTemplateParmDecl>(decl);
+    }
+
+    // Declarations a shared library exports individually; inline and templated
+    // code is compiled into its users and never carries an export macro
+    bool needsExport(const clang::Decl* decl) {
+        if (const auto* function = llvm::dyn_cast<clang::FunctionDecl>(decl)) {
+            return !function->isInlined() && !function->isTemplated();
+        }
+        if (const auto* var = llvm::dyn_cast<clang::VarDecl>(decl)) {
+            return var->isExternallyVisible() && !var->isInline() && !var->isConstexpr() && !var->isTemplated();
+        }
+        if (const auto* record = llvm::dyn_cast<clang::CXXRecordDecl>(decl)) {
+            return record->isThisDeclarationADefinition() && !record->isUnion() && !record->isTemplated() &&
+                   !llvm::isa<clang::ClassTemplateSpecializationDecl>(record);
+        }
+        return false;
+    }
+
+    // Whether an attribute of `decl` was written through one of the filter's export macros
+    bool hasExportMacro(const armor::ApiFilter& filter, const clang::Decl* decl) {
+        const clang::SourceManager& SM = decl->getASTContext().getSourceManager();
+        const clang::LangOptions& langOpts = decl->getASTContext().getLangOpts();
+        for (const clang::Attr* attr : decl->attrs()) {
+            for (clang::SourceLocation loc = attr->getLocation(); loc.isMacroID(); loc = SM.getImmediateMacroCallerLoc(loc)) {
+                if (filter.isExportMacro(clang::Lexer::getImmediateMacroName(loc, SM, langOpts))) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+}
+
+armor::ApiFilter armor::ApiFilter::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open API filter file: " + path);
+    }
+
+    ApiFilter result;
+    llvm::StringSaver saver(result.patternText);
+    try {
+        nlohmann::json root = nlohmann::json::parse(file);
+        if (!root.is_object()) {
+            throw std::runtime_error("Malformed API filter file " + path + " : expected an object");
+        }
+        for (const auto& entry : root.items()) {
+            const std::string& key = entry.key();
+            if (key == "include") {
+                result.includePatterns = readPatterns(entry.value(), saver);
+            }
+            else if (key == "exclude") {
+                result.excludePatterns = readPatterns(entry.value(), saver);
+            }
+            else if (key == "excludeHidden") {
+                result.hidden = entry.value().get<bool>();
+            }
+            else if (key == "exportMacros") {
+                if (!entry.value().is_array()) {
+                    throw std::runtime_error("Expected an array of macro names in API filter file " + path);
+                }
+                for (const nlohmann::json& macro : entry.value()) {
+                    result.exportMacros.insert(macro.get<std::string>());
+                }
+            }
+            else if (key == "symbols") {
+                if (!entry.value().is_array()) {
+                    throw std::runtime_error("Expected an array of qualified names in API filter file " + path);
+                }
+                for (const nlohmann::json& symbol : entry.value()) {
+                    result.addSymbol(symbol.get<std::string>());
+                }
+            }
+            else {
+                throw std::runtime_error("Unknown key \"" + key + "\" in API filter file " + path);
+            }
+        }
+        // Keys are ordered, so equal filters have one text; the symbols are
+        // appended to it, as --symbol adds to them
+        root.erase("symbols");
+        result.document = root.dump();
+        result.updateCanonical();
+    }
+    catch (const nlohmann::json::exception& e) {
+        throw std::runtime_error("Malformed API filter file " + path + " : " + e.what());
+    }
+    return result;
+}
+
+bool armor::ApiFilter::excludesName(llvm::StringRef qualifiedName) const {
+    return anyMatch(excludePatterns, qualifiedName);
+}
+
+bool armor::ApiFilter::includesName(llvm::StringRef qualifiedName) const {
+    return includePatterns.empty() || anyMatch(includePatterns, qualifiedName);
+}
+
+void armor::ApiFilter::addSymbol(llvm::StringRef qualifiedName) {
+    qualifiedName.consume_front("::");
+    if (qualifiedName.empty()) {
+        return;
+    }
+    auto it = std::lower_bound(symbols.begin(), symbols.end(), qualifiedName);
+    if (it == symbols.end() || *it != qualifiedName) {
+        symbols.insert(it, qualifiedName.str());
+    }
+    updateCanonical();
+}
+
+void armor::ApiFilter::updateCanonical() {
+    canonical = document;
+    if (!symbols.empty()) {
+        canonical += " symbols:";
+        for (const std::string& symbol : symbols) {
+            canonical += symbol + ",";
+        }
+    }
+}
+
+bool armor::ApiFilter::selectsSymbol(llvm::StringRef qualifiedName) const {
+    if (symbols.empty()) {
+        return true;
+    }
+    for (llvm::StringRef symbol : symbols) {
+        // The symbol itself, a scope enclosing it or a declaration inside it
+        llvm::StringRef longer = symbol.size() < qualifiedName.size() ? qualifiedName : symbol;
+        llvm::StringRef shorter = symbol.size() < qualifiedName.size() ? symbol : qualifiedName;
+        if (longer.startswith(shorter) &&
+            (longer.size() == shorter.size() || longer.substr(shorter.size()).startswith("::"))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool armor::ApiFilter::excludes(const clang::Decl* decl) const {
+    const auto* named = llvm::dyn_cast<clang::NamedDecl>(decl);
+    if (named == nullptr || named->getDeclName().isEmpty() || isParameter(decl) ||
+        llvm::isa<clang::UsingDirectiveDecl>(decl)) {
+        return false;
+    }
+    const clang::DeclContext* scope = decl->getDeclContext()->getRedeclContext();
+    if (!scope->isFileContext() && !scope->isRecord()) {
+        return false;
+    }
+
+    llvm::SmallString<128> qualifiedName;
+    llvm::raw_svector_ostream os(qualifiedName);
+    named->printQualifiedName(os);
+
+    if (excludesName(qualifiedName) || !selectsSymbol(qualifiedName)) {
+        return true;
+    }
+    if (scope->isFileContext() && !llvm::isa<clang::NamespaceDecl>(decl) && !includesName(qualifiedName)) {
+        return true;
+    }
+    if (hidden) {
+        clang::NamedDecl::ExplicitVisibilityKind kind = llvm::isa<clang::TypeDecl>(decl)
+            ? clang::NamedDecl::VisibilityForType : clang::NamedDecl::VisibilityForValue;
+        llvm::Optional<clang::Visibility> visibility = named->getExplicitVisibility(kind);
+        if (visibility && *visibility == clang::HiddenVisibility) {
+            return true;
+        }
+    }
+    return requiresExportMacro() && scope->isFileContext() && needsExport(decl) && !hasExportMacro(*this, decl);
+}
@@ -0,0 +1,191 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "async_log_sink.hpp"
+
+namespace {
+
+    // Upper bound on how long a record waits in a ring when nobody asks for a drain
+    constexpr std::chrono::milliseconds DRAIN_INTERVAL(50);
+
+    constexpr size_t MIN_RING_CAPACITY = 4096;
+
+    std::atomic<uint64_t> nextSinkId{1};
+
+    size_t roundUpToPowerOfTwo(size_t value) {
+        size_t capacity = MIN_RING_CAPACITY;
+        while (capacity < value) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+}
+
+struct armor::AsyncLogSink::Ring {
+    explicit Ring(size_t capacity) : data(new char[capacity]), capacity(capacity) {}
+
+    size_t used() const {
+        return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire);
+    }
+
+    std::unique_ptr<char[]> data;
+    const size_t capacity;
+    // Monotonic byte counters; the producer advances head, the drainer tail
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    // Cleared when the producing thread exits, so a new thread may take the ring over
+    std::atomic<bool> owned{true};
+};
+
+namespace {
+
+    // The rings this thread produces into, one per live sink
+    struct ThreadRings {
+        std::vector<std::pair<uint64_t, std::shared_ptr<armor::AsyncLogSink::Ring>>> rings;
+
+        ~ThreadRings() {
+            for (auto& entry : rings) {
+                entry.second->owned.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local ThreadRings threadRings;
+
+}
+
+armor::AsyncLogSink::AsyncLogSink(Writer writer, size_t ringCapacity)
+    : writer(std::move(writer)),
+      ringCapacity(roundUpToPowerOfTwo(ringCapacity)),
+      id(nextSinkId.fetch_add(1, std::memory_order_relaxed)),
+      drainThread([this]() { drainLoop(); }) {}
+
+armor::AsyncLogSink::~AsyncLogSink() {
+    {
+        std::scoped_lock<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeDrain.notify_all();
+    drainThread.join();
+    drainAll(true);
+}
+
+armor::AsyncLogSink::Ring& armor::AsyncLogSink::threadRing() {
+    for (auto& entry : threadRings.rings) {
+        if (entry.first == id) {
+            return *entry.second;
+        }
+    }
+
+    std::shared_ptr<Ring> ring;
+    {
+        std::scoped_lock<std::mutex> lock(registryMutex);
+        for (const auto& candidate : rings) {
+            bool expected = false;
+            if (candidate->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                ring = candidate;
+                break;
+            }
+        }
+        if (!ring) {
+            ring = std::make_shared<Ring>(ringCapacity);
+            rings.push_back(ring);
+        }
+    }
+    threadRings.rings.emplace_back(id, ring);
+    return *ring;
+}
+
+void armor::AsyncLogSink::submit(llvm::StringRef record) {
+    if (record.empty()) {
+        return;
+    }
+    if (record.size() > ringCapacity / 2) {
+        // Would hold the ring for a whole drain; keep it in order behind this thread's records instead
+        flush();
+        std::scoped_lock<std::mutex> lock(drainMutex);
+        writer(record, true);
+        return;
+    }
+
+    Ring& ring = threadRing();
+    while (ring.capacity - ring.used() < record.size()) {
+        requestDrain();
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        spaceFreed.wait_for(lock, std::chrono::milliseconds(1));
+    }
+
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    size_t start = head & (ring.capacity - 1);
+    size_t first = std::min(record.size(), ring.capacity - start);
+    std::memcpy(ring.data.get() + start, record.data(), first);
+    std::memcpy(ring.data.get(), record.data() + first, record.size() - first);
+    ring.head.store(head + record.size(), std::memory_order_release);
+
+    if (ring.used() > ring.capacity / 2) {
+        requestDrain();
+    }
+}
+
+void armor::AsyncLogSink::flush() {
+    drainAll(true);
+    spaceFreed.notify_all();
+}
+
+void armor::AsyncLogSink::requestDrain() {
+    if (!drainRequested.exchange(true, std::memory_order_acq_rel)) {
+        // Taking the lock orders this request against the drain thread's predicate check
+        { std::scoped_lock<std::mutex> lock(wakeMutex); }
+        wakeDrain.notify_one();
+    }
+}
+
+void armor::AsyncLogSink::drainAll(bool flushWriter) {
+    std::scoped_lock<std::mutex> drainLock(drainMutex);
+
+    std::vector<std::shared_ptr<Ring>> snapshot;
+    {
+        std::scoped_lock<std::mutex> lock(registryMutex);
+        snapshot = rings;
+    }
+
+    bool wrote = false;
+    for (const auto& ring : snapshot) {
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        size_t head = ring->head.load(std::memory_order_acquire);
+        if (head == tail) {
+            continue;
+        }
+        size_t start = tail & (ring->capacity - 1);
+        size_t size = head - tail;
+        size_t first = std::min(size, ring->capacity - start);
+        writer(llvm::StringRef(ring->data.get() + start, first), false);
+        if (size > first) {
+            writer(llvm::StringRef(ring->data.get(), size - first), false);
+        }
+        ring->tail.store(head, std::memory_order_release);
+        wrote = true;
+    }
+    if (wrote && flushWriter) {
+        writer(llvm::StringRef(), true);
+    }
+}
+
+void armor::AsyncLogSink::drainLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeDrain.wait_for(lock, DRAIN_INTERVAL, [this]() {
+            return stopping || drainRequested.load(std::memory_order_acquire);
+        });
+        drainRequested.store(false, std::memory_order_release);
+        lock.unlock();
+        drainAll(true);
+        spaceFreed.notify_all();
+        lock.lock();
+    }
+}
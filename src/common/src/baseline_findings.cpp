@@ -0,0 +1,106 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "baseline_findings.hpp"
+#include "output_paths.hpp"
+#include "report_format.hpp"
+
+armor::BaselineFindings& armor::BaselineFindings::getInstance() {
+    static BaselineFindings instance;
+    return instance;
+}
+
+std::size_t armor::BaselineFindings::load(const std::string& path) {
+    std::vector<std::filesystem::path> files;
+    if (std::filesystem::is_directory(path)) {
+        std::filesystem::path reportDir = OutputPaths{path}.jsonReportDir();
+        if (std::filesystem::is_directory(reportDir)) {
+            for (const auto& entry : std::filesystem::directory_iterator(reportDir)) {
+                if (isReportFile(entry.path().string())) {
+                    files.push_back(entry.path());
+                }
+            }
+        }
+    }
+    else {
+        files.push_back(path);
+    }
+
+    for (const auto& file : files) {
+        if (!std::ifstream(file)) {
+            throw std::runtime_error("Failed to open baseline report " + file.string());
+        }
+        try {
+            json report = readReportDocument(file.string());
+            for (const json& row : report.at("api_diff")) {
+                HeaderFindings& findings = headers[row.at("headerfile").get<std::string>()];
+                if (findings.keys.insert(keyOf(row.at("name").get<std::string>(),
+                                               row.at("changetype").get<std::string>(),
+                                               row.at("compatibility").get<std::string>())).second) {
+                    findings.rows.push_back(row);
+                }
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Malformed baseline report " + file.string() + ": " + e.what());
+        }
+    }
+    loaded = true;
+    return files.size();
+}
+
+void armor::BaselineFindings::clear() {
+    headers.clear();
+    loaded = false;
+}
+
+ApiChangeGroups armor::BaselineFindings::delta(const ApiChangeGroups& groups, json& summary) const {
+    ApiChangeGroups result(groups.headerFile());
+    json resolved = json::array();
+    std::size_t known = 0;
+    auto it = headers.find(groups.headerFile());
+    if (it == headers.end()) {
+        for (const ApiChangeGroups::Group& group : groups) {
+            result.addRecord(ChangeRecord{group.headerfile, group.name, group.description(),
+                                          group.anyCompatibilityChanged, group.anyBackwardIncompatible});
+        }
+    }
+    else {
+        const HeaderFindings& findings = it->second;
+        std::unordered_set<std::string> current;
+        for (const ApiChangeGroups::Group& group : groups) {
+            std::string key = keyOf(group.name, group.changeType(), group.compatibility());
+            if (findings.keys.count(key)) {
+                ++known;
+                current.insert(std::move(key));
+                continue;
+            }
+            result.addRecord(ChangeRecord{group.headerfile, group.name, group.description(),
+                                          group.anyCompatibilityChanged, group.anyBackwardIncompatible});
+        }
+        for (const json& row : findings.rows) {
+            if (!current.count(keyOf(row["name"].get<std::string>(), row["changetype"].get<std::string>(),
+                                     row["compatibility"].get<std::string>()))) {
+                resolved.push_back(row);
+            }
+        }
+    }
+    summary = json{{"known", known}, {"resolved", std::move(resolved)}};
+    return result;
+}
+
+std::string armor::BaselineFindings::keyOf(const std::string& name, const std::string& changeType,
+                                           const std::string& compatibility) {
+    std::string key = name;
+    key += '\0';
+    key += changeType;
+    key += '\0';
+    key += compatibility;
+    return key;
+}
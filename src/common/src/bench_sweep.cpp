@@ -0,0 +1,112 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/YAMLTraits.h"
+
+#include "bench_sweep.hpp"
+
+namespace llvm::yaml {
+
+    template <>
+    struct MappingTraits<armor::BenchSweepConfig> {
+        static void mapping(IO& io, armor::BenchSweepConfig& config) {
+            io.mapRequired("base", config.base);
+            io.mapRequired("head", config.head);
+            io.mapRequired("header-config", config.headerConfig);
+            io.mapRequired("branch", config.branch);
+            io.mapOptional("header-dir", config.headerDir);
+            io.mapOptional("include-paths", config.includePaths);
+            io.mapOptional("macro-flags", config.macroFlags);
+            io.mapOptional("lang", config.lang);
+            io.mapOptional("jobs", config.jobs);
+            io.mapOptional("repeat", config.repeat);
+        }
+    };
+
+}
+
+namespace {
+
+    void resolveAgainst(const std::filesystem::path& base, std::string& path) {
+        if (!path.empty() && std::filesystem::path(path).is_relative()) {
+            path = (base / path).lexically_normal().string();
+        }
+    }
+
+}
+
+armor::BenchSweepConfig armor::loadBenchSweepConfig(const std::string& path) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        throw std::runtime_error("Failed to read sweep config " + path + ": " + buffer.getError().message());
+    }
+
+    BenchSweepConfig config;
+    std::string diagnostics;
+    llvm::yaml::Input in((*buffer)->getBuffer(), nullptr,
+                         [](const llvm::SMDiagnostic& diagnostic, void* context) {
+                             *static_cast<std::string*>(context) = diagnostic.getMessage().str();
+                         },
+                         &diagnostics);
+    in >> config;
+    if (in.error()) {
+        throw std::runtime_error("Malformed sweep config " + path + ": " + diagnostics);
+    }
+    if (config.repeat == 0) {
+        throw std::runtime_error("repeat of sweep config " + path + " must be at least 1");
+    }
+    if (!config.lang.empty() && config.lang != "cpp" && config.lang != "c") {
+        throw std::runtime_error("Invalid lang '" + config.lang + "' in " + path);
+    }
+
+    std::filesystem::path base = std::filesystem::absolute(path).parent_path();
+    resolveAgainst(base, config.base);
+    resolveAgainst(base, config.head);
+    resolveAgainst(base, config.headerConfig);
+    for (std::string& includePath : config.includePaths) {
+        resolveAgainst(base, includePath);
+    }
+    return config;
+}
+
+std::vector<std::vector<std::string>> armor::scheduleHeaderRounds(const std::vector<std::string>& headers) {
+    std::vector<std::vector<std::string>> rounds;
+    std::unordered_map<std::string, size_t> taken;
+    for (const std::string& header : headers) {
+        size_t round = taken[llvm::sys::path::filename(header).str()]++;
+        if (round == rounds.size()) {
+            rounds.emplace_back();
+        }
+        rounds[round].push_back(header);
+    }
+    return rounds;
+}
+
+armor::LatencySummary armor::summarizeLatencies(std::vector<double> latencies) {
+    LatencySummary summary;
+    summary.count = latencies.size();
+    if (latencies.empty()) {
+        return summary;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    // The smallest latency at least `share` of the set does not exceed
+    auto rank = [&latencies](double share) {
+        size_t index = static_cast<size_t>(std::ceil(share * static_cast<double>(latencies.size())));
+        return latencies[std::max<size_t>(index, 1) - 1];
+    };
+    summary.p50 = rank(0.50);
+    summary.p95 = rank(0.95);
+    summary.p99 = rank(0.99);
+    summary.max = latencies.back();
+    return summary;
+}
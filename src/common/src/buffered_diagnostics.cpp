@@ -0,0 +1,39 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include "clang/Basic/DiagnosticLex.h"
+
+#include "buffered_diagnostics.hpp"
+#include "logger.hpp"
+
+void armor::BufferedDiagnosticConsumer::HandleDiagnostic(clang::DiagnosticsEngine::Level level,
+                                                         const clang::Diagnostic& info) {
+    // Keeps getNumErrors(), by which the frontend action decides success
+    clang::DiagnosticConsumer::HandleDiagnostic(level, info);
+    switch (level) {
+        case clang::DiagnosticsEngine::Fatal:
+            ++counts.fatals;
+            ++counts.errors;
+            break;
+        case clang::DiagnosticsEngine::Error:
+            ++counts.errors;
+            break;
+        case clang::DiagnosticsEngine::Warning:
+            ++counts.warnings;
+            break;
+        default:
+            break;
+    }
+    if (info.getID() == clang::diag::err_pp_file_not_found) {
+        ++counts.missingIncludes;
+    }
+    printer.HandleDiagnostic(level, info);
+}
+
+void armor::BufferedDiagnosticConsumer::flush() {
+    stream.flush();
+    if (buffer.empty()) {
+        return;
+    }
+    DebugConfig::getInstance().write(buffer);
+    buffer.clear();
+}
@@ -0,0 +1,242 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+#include "cache_directory.hpp"
+#include "logger.hpp"
+
+namespace {
+
+    constexpr char SEAL_MAGIC[8] = {'A', 'R', 'M', 'O', 'R', 'S', 'U', 'M'};
+
+    struct SealFooter {
+        char magic[8];
+        uint64_t checksum;
+    };
+
+    constexpr const char* LOCK_FILE = ".eviction.lock";
+
+    // Writers that died leave their temporary files; a live writer renames its own within seconds
+    constexpr std::chrono::hours ABANDONED_TEMP_AGE{1};
+
+    struct CacheFile {
+        std::filesystem::path path;
+        uint64_t size;
+        std::filesystem::file_time_type lastUse;
+    };
+
+    // Holds the eviction lock of a cache directory, if it could take it without waiting
+    class EvictionLock {
+        public:
+            explicit EvictionLock(const std::string& cacheDir) {
+                std::string path = (std::filesystem::path(cacheDir) / LOCK_FILE).string();
+                fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+                if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) != 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            ~EvictionLock() {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+            EvictionLock(const EvictionLock&) = delete;
+            EvictionLock& operator=(const EvictionLock&) = delete;
+
+            bool held() const { return fd >= 0; }
+
+            // The lock file holds when the last eviction ended, in seconds since the epoch
+            bool evictedRecently() const {
+                char buffer[32] = {};
+                ssize_t n = pread(fd, buffer, sizeof(buffer) - 1, 0);
+                if (n <= 0) {
+                    return false;
+                }
+                long long last = std::atoll(buffer);
+                long long now = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                return now - last < armor::EVICTION_INTERVAL.count();
+            }
+
+            void markEvicted() const {
+                std::string now = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count());
+                if (ftruncate(fd, 0) != 0 || pwrite(fd, now.data(), now.size(), 0) < 0) {
+                    ARMOR_DEBUG_LOG << "Cannot record the eviction time : " << std::strerror(errno) << "\n";
+                }
+            }
+
+        private:
+            int fd = -1;
+    };
+
+    void removeFile(const CacheFile& file, armor::EvictionResult& result) {
+        std::error_code ec;
+        std::filesystem::remove(file.path, ec);
+        // Another process may have removed it first; either way it is gone
+        ++result.evictedFiles;
+        result.evictedBytes += file.size;
+    }
+
+}
+
+bool armor::publishCacheFile(const std::string& path, llvm::StringRef bytes, std::string& error) {
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, tempPath)) {
+        error = ec.message();
+        return false;
+    }
+    {
+        llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+        out << bytes;
+        out.close();
+        if (out.has_error()) {
+            error = out.error().message();
+            out.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return false;
+        }
+    }
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path)) {
+        error = ec.message();
+        llvm::sys::fs::remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+std::string armor::sealCacheEntry(llvm::StringRef payload) {
+    SealFooter footer{};
+    std::memcpy(footer.magic, SEAL_MAGIC, sizeof(SEAL_MAGIC));
+    footer.checksum = llvm::xxHash64(payload);
+    std::string sealed;
+    sealed.reserve(payload.size() + sizeof(footer));
+    sealed.append(payload.data(), payload.size());
+    sealed.append(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    return sealed;
+}
+
+bool armor::unsealCacheEntry(llvm::StringRef bytes, llvm::StringRef& payload) {
+    if (bytes.size() < sizeof(SealFooter)) {
+        return false;
+    }
+    SealFooter footer{};
+    std::memcpy(&footer, bytes.data() + bytes.size() - sizeof(footer), sizeof(footer));
+    llvm::StringRef covered = bytes.drop_back(sizeof(footer));
+    if (std::memcmp(footer.magic, SEAL_MAGIC, sizeof(SEAL_MAGIC)) != 0 || footer.checksum != llvm::xxHash64(covered)) {
+        return false;
+    }
+    payload = covered;
+    return true;
+}
+
+void armor::touchCacheFile(const std::string& path) {
+    // A failure only makes the entry look older than it is
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+}
+
+armor::EvictionResult armor::evictCacheEntries(const std::string& cacheDir, const CacheLimits& limits) {
+    EvictionResult result;
+    std::error_code ec;
+    if (!limits.bounded() || !std::filesystem::is_directory(cacheDir, ec)) {
+        result.skipped = true;
+        return result;
+    }
+    EvictionLock lock(cacheDir);
+    if (!lock.held() || lock.evictedRecently()) {
+        result.skipped = true;
+        return result;
+    }
+
+    std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+    std::vector<CacheFile> files;
+    std::filesystem::recursive_directory_iterator it(
+        cacheDir, std::filesystem::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        const std::filesystem::directory_entry& entry = *it;
+        std::error_code statError;
+        if (it.depth() == 0 && entry.path().filename() == "modules") {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (!entry.is_regular_file(statError) || (it.depth() == 0 && entry.path().filename() == LOCK_FILE)) {
+            continue;
+        }
+        CacheFile file{entry.path(), entry.file_size(statError), entry.last_write_time(statError)};
+        if (statError) {
+            // Removed since it was listed
+            continue;
+        }
+        if (llvm::StringRef(file.path.filename().string()).endswith(".tmp")) {
+            if (now - file.lastUse > ABANDONED_TEMP_AGE) {
+                removeFile(file, result);
+            }
+            continue;
+        }
+        if (limits.maxAge.count() > 0 && now - file.lastUse > limits.maxAge) {
+            removeFile(file, result);
+            continue;
+        }
+        files.push_back(std::move(file));
+    }
+    if (ec) {
+        ARMOR_DEBUG_LOG << "Stopped listing cache directory " << cacheDir << " : " << ec.message() << "\n";
+    }
+
+    uint64_t total = 0;
+    for (const CacheFile& file : files) {
+        total += file.size;
+    }
+    std::size_t evicted = 0;
+    // Evicting down to 90% leaves room for a run's new entries before the next eviction
+    if (limits.maxBytes > 0 && total > limits.maxBytes) {
+        std::sort(files.begin(), files.end(), [](const CacheFile& lhs, const CacheFile& rhs) {
+            return lhs.lastUse < rhs.lastUse;
+        });
+        uint64_t target = limits.maxBytes - limits.maxBytes / 10;
+        for (; evicted < files.size() && total > target; ++evicted) {
+            removeFile(files[evicted], result);
+            total -= files[evicted].size;
+        }
+    }
+    result.keptFiles = files.size() - evicted;
+    result.keptBytes = total;
+    lock.markEvicted();
+    return result;
+}
+
+armor::BackgroundEviction::BackgroundEviction(std::string cacheDir, CacheLimits limits)
+    : thread([cacheDir = std::move(cacheDir), limits]() {
+          EvictionResult result = evictCacheEntries(cacheDir, limits);
+          if (!result.skipped) {
+              armor::info() << "Cache " << cacheDir << ": evicted " << result.evictedFiles << " files ("
+                            << (result.evictedBytes >> 20) << " MiB), kept " << result.keptFiles << " files ("
+                            << (result.keptBytes >> 20) << " MiB)\n";
+          }
+      }) {}
+
+armor::BackgroundEviction::~BackgroundEviction() {
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
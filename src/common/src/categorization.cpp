@@ -16,6 +16,7 @@ const char* serialize(OverAllStatus status){
         case OverAllStatus::IN_ACTIVE: return "IN_ACTIVE";
         case OverAllStatus::CATEGORIZATION_ERROR: return "CATEGORIZATION_ERROR";
         case OverAllStatus::NOT_CATEGORIZED: return "NOT_CATEGORIZED";
+        case OverAllStatus::TIMED_OUT: return "TIMED_OUT";
         default: return "UNKNOWN_STATUS";
     }
 }
@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Path.h"
+
+#include "changed_ranges.hpp"
+
+namespace {
+
+    std::string normalizePath(llvm::StringRef path) {
+        llvm::SmallString<256> normalized(path);
+        llvm::sys::path::remove_dots(normalized, /*remove_dot_dot=*/true);
+        return normalized.str().str();
+    }
+
+    std::vector<armor::LineRange> readLineRanges(const nlohmann::json& in) {
+        std::vector<armor::LineRange> ranges;
+        for (const nlohmann::json& range : in) {
+            unsigned begin = range.at(0).get<unsigned>();
+            unsigned end = range.at(1).get<unsigned>();
+            if (end < begin) {
+                throw std::runtime_error("Invalid line range [" + std::to_string(begin) + ", " +
+                                         std::to_string(end) + "]");
+            }
+            ranges.push_back({begin, end});
+        }
+        return ranges;
+    }
+
+}
+
+bool armor::HeaderChanges::intersects(const std::vector<LineRange>& lines, unsigned begin, unsigned end) {
+    for (const LineRange& range : lines) {
+        if (range.begin <= end && begin <= range.end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+armor::ChangedRanges armor::ChangedRanges::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open changed ranges file: " + path);
+    }
+
+    ChangedRanges result;
+    try {
+        nlohmann::json root = nlohmann::json::parse(file);
+        for (const auto& entry : root.items()) {
+            HeaderChanges changes;
+            changes.oldLines = readLineRanges(entry.value().at("old"));
+            changes.newLines = readLineRanges(entry.value().at("new"));
+            result.headers.insert_or_assign(normalizePath(entry.key()), std::move(changes));
+        }
+    }
+    catch (const nlohmann::json::exception& e) {
+        throw std::runtime_error("Malformed changed ranges file " + path + " : " + e.what());
+    }
+    return result;
+}
+
+const armor::HeaderChanges* armor::ChangedRanges::find(const std::string& projectRoot, const std::string& file) const {
+    std::string root = normalizePath(projectRoot);
+    std::string header = normalizePath(file);
+
+    llvm::StringRef relative(header);
+    if (!root.empty() && relative.consume_front(root)) {
+        relative = relative.ltrim(llvm::sys::path::get_separator());
+    }
+
+    auto it = headers.find(relative);
+    return it == headers.end() ? nullptr : &it->second;
+}
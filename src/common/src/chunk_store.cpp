@@ -0,0 +1,175 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+#include "cache_directory.hpp"
+#include "chunk_store.hpp"
+#include "logger.hpp"
+
+namespace {
+
+    // Bump whenever the manifest layout or the chunk boundaries change
+    constexpr int MANIFEST_FORMAT_VERSION = 1;
+
+    // Large enough that a cold load from a remote cache makes few requests
+    constexpr std::size_t MIN_CHUNK_SIZE = 16 << 10;
+    constexpr std::size_t MAX_CHUNK_SIZE = 256 << 10;
+    // 16 clear bits end a chunk about every 64 KiB past the minimum; the top
+    // ones, as a low bit of the gear hash only depends on the last few bytes
+    constexpr uint64_t BOUNDARY_MASK = ~uint64_t(0) << (64 - 16);
+
+    // A fixed random value per byte for the gear hash; generated rather than
+    // listed, but the same everywhere, as the boundaries must be
+    constexpr std::array<uint64_t, 256> makeGearTable() {
+        std::array<uint64_t, 256> table{};
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        for (uint64_t& value : table) {
+            // splitmix64
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            value = z ^ (z >> 31);
+        }
+        return table;
+    }
+
+    constexpr std::array<uint64_t, 256> GEAR = makeGearTable();
+
+}
+
+std::vector<llvm::StringRef> armor::splitIntoChunks(llvm::StringRef bytes) {
+    std::vector<llvm::StringRef> chunks;
+    while (!bytes.empty()) {
+        std::size_t end = bytes.size();
+        if (end > MIN_CHUNK_SIZE) {
+            std::size_t limit = std::min(end, MAX_CHUNK_SIZE);
+            // Each byte shifts the older ones up, so the hash covers the last 64 bytes
+            uint64_t hash = 0;
+            end = limit;
+            for (std::size_t i = 0; i < limit; ++i) {
+                hash = (hash << 1) + GEAR[static_cast<unsigned char>(bytes[i])];
+                if (i + 1 >= MIN_CHUNK_SIZE && (hash & BOUNDARY_MASK) == 0) {
+                    end = i + 1;
+                    break;
+                }
+            }
+        }
+        chunks.push_back(bytes.take_front(end));
+        bytes = bytes.drop_front(end);
+    }
+    return chunks;
+}
+
+armor::ChunkStore::ChunkStore(const std::string& cacheDir) {
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(path, "chunks");
+    chunkDir = path.str().str();
+}
+
+std::string armor::ChunkStore::chunkPath(const std::string& key) const {
+    llvm::SmallString<256> path(chunkDir);
+    llvm::sys::path::append(path, key);
+    return path.str().str();
+}
+
+std::string armor::ChunkStore::keyOf(llvm::StringRef chunk) {
+    return llvm::utohexstr(llvm::xxHash64(chunk)) + "-" + std::to_string(chunk.size()) + ".chunk";
+}
+
+std::string armor::ChunkStore::manifestOf(llvm::StringRef bytes, std::vector<llvm::StringRef>& chunks) {
+    chunks = splitIntoChunks(bytes);
+    nlohmann::json keys = nlohmann::json::array();
+    for (llvm::StringRef chunk : chunks) {
+        keys.push_back(keyOf(chunk));
+    }
+    nlohmann::json manifest{{"format", MANIFEST_FORMAT_VERSION},
+                            {"size", bytes.size()},
+                            {"checksum", llvm::xxHash64(bytes)},
+                            {"chunks", std::move(keys)}};
+    std::vector<std::uint8_t> cbor = nlohmann::json::to_cbor(manifest);
+    return sealCacheEntry(llvm::StringRef(reinterpret_cast<const char*>(cbor.data()), cbor.size()));
+}
+
+bool armor::ChunkStore::contains(const std::string& key) const {
+    return llvm::sys::fs::exists(chunkPath(key));
+}
+
+void armor::ChunkStore::store(llvm::StringRef chunk) const {
+    if (std::error_code ec = llvm::sys::fs::create_directories(chunkDir)) {
+        ARMOR_DEBUG_LOG << "Cannot create chunk directory " << chunkDir << " : " << ec.message() << "\n";
+        return;
+    }
+    std::string error;
+    if (!publishCacheFile(chunkPath(keyOf(chunk)), chunk, error)) {
+        ARMOR_DEBUG_LOG << "Cannot store cache chunk " << keyOf(chunk) << " : " << error << "\n";
+    }
+}
+
+bool armor::ChunkStore::assemble(llvm::StringRef manifest,
+                                 const std::function<bool(const std::string& key, std::string& chunk)>& fetch,
+                                 std::string& bytes, std::size_t* fetched) const {
+    llvm::StringRef payload;
+    if (!unsealCacheEntry(manifest, payload)) {
+        return false;
+    }
+    std::size_t fetchedChunks = 0;
+    std::string assembled;
+    try {
+        nlohmann::json parsed = nlohmann::json::from_cbor(payload.begin(), payload.end());
+        if (parsed.at("format").get<int>() != MANIFEST_FORMAT_VERSION) {
+            return false;
+        }
+        assembled.reserve(parsed.at("size").get<std::size_t>());
+        for (const nlohmann::json& entry : parsed.at("chunks")) {
+            std::string key = entry.get<std::string>();
+            std::string path = chunkPath(key);
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> held =
+                llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+            if (held && keyOf((*held)->getBuffer()) == key) {
+                assembled.append((*held)->getBuffer().data(), (*held)->getBuffer().size());
+                touchCacheFile(path);
+                continue;
+            }
+            if (held) {
+                ARMOR_DEBUG_LOG << "Removing corrupt cache chunk " << path << "\n";
+                llvm::sys::fs::remove(path);
+            }
+            std::string chunk;
+            if (!fetch(key, chunk) || keyOf(chunk) != key) {
+                return false;
+            }
+            store(chunk);
+            assembled += chunk;
+            ++fetchedChunks;
+        }
+        if (assembled.size() != parsed.at("size").get<std::size_t>() ||
+            llvm::xxHash64(assembled) != parsed.at("checksum").get<uint64_t>()) {
+            return false;
+        }
+    } catch (const std::exception& e) {
+        ARMOR_DEBUG_LOG << "Ignoring unreadable cache manifest : " << e.what() << "\n";
+        return false;
+    }
+    bytes = std::move(assembled);
+    if (fetched) {
+        *fetched = fetchedChunks;
+    }
+    return true;
+}
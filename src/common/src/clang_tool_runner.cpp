@@ -0,0 +1,384 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendOptions.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileManager.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "buffered_diagnostics.hpp"
+#include "clang_tool_runner.hpp"
+#include "file_cache.hpp"
+#include "include_prefetch.hpp"
+#include "logger.hpp"
+#include "repro_bundle.hpp"
+#include "source_buffers.hpp"
+
+namespace {
+
+    // Diagnostic options, one instance per worker thread since the
+    // reference count of DiagnosticOptions is not atomic
+    clang::DiagnosticOptions* threadDiagOptions() {
+        static thread_local llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> sDiagOpts;
+        if (!sDiagOpts) {
+            sDiagOpts = llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions>(new clang::DiagnosticOptions());
+            sDiagOpts->ShowColors = 0; // cleaner logs
+        }
+        return &*sDiagOpts;
+    }
+
+    armor::ToolFileSystemFactory& toolFileSystemOverlay() {
+        static armor::ToolFileSystemFactory sFactory;
+        return sFactory;
+    }
+
+    std::atomic<bool>& leanFrontend() {
+        static std::atomic<bool> sLean{false};
+        return sLean;
+    }
+
+    // A physical file system with its own working directory: the default real
+    // file system makes ClangTool chdir the whole process into the compile
+    // directory, which races with any other TU parsed at the same time. Stats
+    // and reads go through SharedFileCache, so includes shared by the headers
+    // are read once per process. `buffers`, if any, shadow every other layer
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> createToolFileSystem(const armor::SourceBuffers* buffers = nullptr) {
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> physical = armor::SharedFileCache::getInstance().wrap(
+            llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(llvm::vfs::createPhysicalFileSystem().release()));
+        const armor::ToolFileSystemFactory& overlayFactory = toolFileSystemOverlay();
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = physical;
+        if (overlayFactory || (buffers && !buffers->empty())) {
+            auto overlay = llvm::makeIntrusiveRefCnt<llvm::vfs::OverlayFileSystem>(physical);
+            if (overlayFactory) {
+                overlay->pushOverlay(overlayFactory());
+            }
+            if (buffers && !buffers->empty()) {
+                overlay->pushOverlay(buffers->createFileSystem());
+            }
+            fileSystem = overlay;
+        }
+        // --capture-bundle records what the tool reads, from whichever layer
+        armor::BundleCapture& capture = armor::BundleCapture::getInstance();
+        return capture.isCapturing() ? capture.wrap(fileSystem) : fileSystem;
+    }
+
+    // The diagnostic flags every tool adds, combined once for the process
+    const clang::tooling::ArgumentsAdjuster& diagnosticArgumentsAdjuster() {
+        // Make logged diagnostics clean and informative
+        static const clang::tooling::ArgumentsAdjuster sAdjuster = clang::tooling::combineAdjusters(
+            clang::tooling::combineAdjusters(
+                clang::tooling::getInsertArgumentAdjuster("-fno-color-diagnostics"),
+                clang::tooling::getInsertArgumentAdjuster("-fno-caret-diagnostics")),
+            clang::tooling::combineAdjusters(
+                clang::tooling::getInsertArgumentAdjuster("-fdiagnostics-show-note-include-stack"),
+                clang::tooling::getInsertArgumentAdjuster("-fdiagnostics-absolute-paths")));
+        // Nothing reads warnings, typo corrections or the notes of a backtrace,
+        // which only cost time once the AST is built (--lean-frontend). Errors
+        // stay unlimited, as the missing includes are counted from them
+        static const clang::tooling::ArgumentsAdjuster sLeanAdjuster = clang::tooling::getInsertArgumentAdjuster(
+            clang::tooling::CommandLineArguments{"-fno-color-diagnostics", "-fno-caret-diagnostics",
+                                                 "-fdiagnostics-absolute-paths", "-Wno-everything",
+                                                 "-fno-spell-checking", "-fmacro-backtrace-limit=1",
+                                                 "-ftemplate-backtrace-limit=1", "-fconstexpr-backtrace-limit=1"},
+            clang::tooling::ArgumentInsertPosition::END);
+        return leanFrontend() ? sLeanAdjuster : sAdjuster;
+    }
+
+    void logFailure(const std::string& fileName, const armor::DiagnosticCounts& counts) {
+        armor::error() << "Error while processing " << fileName << " (" << counts.errors << " errors, "
+                       << counts.missingIncludes << " missing includes)." << "\n";
+    }
+
+    void configureTool(clang::tooling::ClangTool& tool, clang::DiagnosticConsumer* diagPrinter) {
+        tool.setRestoreWorkingDir(false);
+        tool.setDiagnosticConsumer(diagPrinter);
+        tool.appendArgumentsAdjuster(diagnosticArgumentsAdjuster());
+
+        //suppress ClangTool'son stderr
+        tool.setPrintErrorMessage(false);
+    }
+
+    /**
+     * Compiler invocations the clang driver built, by compile directory,
+     * header extension and command line without the header. A header whose
+     * command matches one, as the other headers of its directory and every
+     * later parse of it do, copies the invocation with only the input
+     * swapped instead of running the driver again.
+     */
+    class PreparedInvocations {
+        public:
+            // Distinct commands come from distinct header directories; past this many the cache restarts
+            static constexpr size_t MAX_ENTRIES = 4096;
+
+            static PreparedInvocations& getInstance() {
+                static PreparedInvocations instance;
+                return instance;
+            }
+
+            static std::string keyOf(const clang::tooling::CompileCommand& command) {
+                // The driver saw the flags of the profile too
+                std::string key = leanFrontend() ? "lean" : "full";
+                key += '\0';
+                key += command.Directory;
+                key += '\0';
+                key += llvm::sys::path::extension(command.Filename);
+                for (const std::string& arg : command.CommandLine) {
+                    if (arg != command.Filename) {
+                        key += '\0';
+                        key += arg;
+                    }
+                }
+                return key;
+            }
+
+            std::shared_ptr<const clang::CompilerInvocation> find(const std::string& key) {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = invocations.find(key);
+                return it == invocations.end() ? nullptr : it->second;
+            }
+
+            void store(const std::string& key, std::shared_ptr<const clang::CompilerInvocation> invocation) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (invocations.size() >= MAX_ENTRIES) {
+                    invocations.clear();
+                }
+                invocations[key] = std::move(invocation);
+            }
+
+        private:
+            std::mutex mutex;
+            llvm::StringMap<std::shared_ptr<const clang::CompilerInvocation>> invocations;
+    };
+
+    /**
+     * Runs the wrapped factory, keeping a copy of the invocation the driver
+     * built for it before the action can change it.
+     */
+    class CapturingAction : public clang::tooling::ToolAction {
+        public:
+            explicit CapturingAction(clang::tooling::FrontendActionFactory& factory) : factory(factory) {}
+
+            bool runInvocation(std::shared_ptr<clang::CompilerInvocation> invocation,
+                               clang::FileManager* files,
+                               std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                               clang::DiagnosticConsumer* diagConsumer) override {
+                captured = std::make_shared<const clang::CompilerInvocation>(*invocation);
+                return factory.runInvocation(std::move(invocation), files, std::move(pchContainerOps), diagConsumer);
+            }
+
+            std::shared_ptr<const clang::CompilerInvocation> captured;
+
+        private:
+            clang::tooling::FrontendActionFactory& factory;
+    };
+
+    // Runs `factory` over `fileName` with a copy of `prepared`, as ClangTool would after the driver
+    bool runPrepared(const clang::CompilerInvocation& prepared, const std::string& fileName,
+                     const std::string& directory, clang::tooling::FrontendActionFactory& factory,
+                     clang::DiagnosticConsumer* diagConsumer) {
+        auto invocation = std::make_shared<clang::CompilerInvocation>(prepared);
+        auto& inputs = invocation->getFrontendOpts().Inputs;
+        if (inputs.size() != 1) {
+            return false;
+        }
+        inputs.front() = clang::FrontendInputFile(fileName, inputs.front().getKind(), inputs.front().isSystem());
+
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = createToolFileSystem();
+        if (fileSystem->setCurrentWorkingDirectory(directory)) {
+            return false;
+        }
+        llvm::IntrusiveRefCntPtr<clang::FileManager> files(
+            new clang::FileManager(clang::FileSystemOptions(), std::move(fileSystem)));
+        return factory.runInvocation(std::move(invocation), files.get(),
+                                     std::make_shared<clang::PCHContainerOperations>(), diagConsumer);
+    }
+
+    /**
+     * Runs the wrapped factory for each header of a batch and records whether
+     * it compiled, since ClangTool::run only reports the batch as a whole.
+     */
+    class StatusRecordingAction : public clang::tooling::ToolAction {
+        public:
+            StatusRecordingAction(clang::tooling::FrontendActionFactory& factory,
+                                  armor::BufferedDiagnosticConsumer& diagnostics,
+                                  llvm::StringMap<PARSING_STATUS>& statuses,
+                                  armor::IncludePrefetcher* prefetcher = nullptr)
+                : factory(factory), diagnostics(diagnostics), statuses(statuses), prefetcher(prefetcher) {}
+
+            bool runInvocation(std::shared_ptr<clang::CompilerInvocation> invocation,
+                               clang::FileManager* files,
+                               std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                               clang::DiagnosticConsumer* diagConsumer) override {
+                const auto& inputs = invocation->getFrontendOpts().Inputs;
+                std::string fileName = inputs.empty() ? std::string() : inputs.front().getFile().str();
+
+                // The consumer is shared by the whole batch and its error count
+                // decides success, so restart it for every header
+                diagnostics.clear();
+                bool success = factory.runInvocation(std::move(invocation), files,
+                                                     std::move(pchContainerOps), diagConsumer);
+                // Each header's diagnostics reach the log as soon as it is done
+                diagnostics.flush();
+                statuses[fileName] = success ? NO_FATAL_ERRORS : FATAL_ERRORS;
+                if (!success) {
+                    logFailure(fileName, diagnostics.getCounts());
+                }
+                if (prefetcher) {
+                    prefetcher->headerDone();
+                }
+                return success;
+            }
+
+        private:
+            clang::tooling::FrontendActionFactory& factory;
+            armor::BufferedDiagnosticConsumer& diagnostics;
+            llvm::StringMap<PARSING_STATUS>& statuses;
+            armor::IncludePrefetcher* prefetcher;
+    };
+
+    // The headers of a batch with their include directories, in the order the tool parses them
+    std::vector<armor::IncludePrefetcher::Header> prefetchOrder(const std::vector<std::string>& fileNames,
+                                                                const clang::tooling::CompilationDatabase& compDB) {
+        std::vector<armor::IncludePrefetcher::Header> headers;
+        headers.reserve(fileNames.size());
+        for (const std::string& fileName : fileNames) {
+            std::string absoluteFile = clang::tooling::getAbsolutePath(fileName);
+            std::vector<clang::tooling::CompileCommand> commands = compDB.getCompileCommands(absoluteFile);
+            std::vector<std::string> includeDirs;
+            if (!commands.empty()) {
+                includeDirs = armor::includeDirsOf(commands.front().CommandLine, commands.front().Directory);
+            }
+            headers.push_back({std::move(absoluteFile), std::move(includeDirs)});
+        }
+        return headers;
+    }
+
+    PARSING_STATUS runTool(const std::string& fileName,
+                           const llvm::StringRef* contents,
+                           const clang::tooling::CompilationDatabase& compDB,
+                           clang::tooling::FrontendActionFactory& factory) {
+        // Clang diagnostics for this TU are buffered locally and handed to the
+        // shared sink in one write, so concurrent workers never interleave
+        armor::BufferedDiagnosticConsumer diagnostics(threadDiagOptions());
+
+        // A header in memory is mapped into the tool's file system, so only one on disk is prepared
+        std::string preparedKey;
+        std::string absoluteFile = clang::tooling::getAbsolutePath(fileName);
+        std::vector<clang::tooling::CompileCommand> commands = compDB.getCompileCommands(absoluteFile);
+        if (!contents && commands.size() == 1) {
+            preparedKey = PreparedInvocations::keyOf(commands.front());
+            if (auto prepared = PreparedInvocations::getInstance().find(preparedKey)) {
+                bool success = runPrepared(*prepared, absoluteFile, commands.front().Directory, factory, &diagnostics);
+                diagnostics.flush();
+                if (!success) {
+                    logFailure(fileName, diagnostics.getCounts());
+                    return FATAL_ERRORS;
+                }
+                return NO_FATAL_ERRORS;
+            }
+        }
+
+        clang::tooling::ClangTool tool(compDB, {fileName},
+                                       std::make_shared<clang::PCHContainerOperations>(), createToolFileSystem());
+        configureTool(tool, &diagnostics);
+        if (contents) {
+            tool.mapVirtualFile(fileName, *contents);
+        }
+
+        CapturingAction action(factory);
+        int rc = tool.run(&action);
+        if (!preparedKey.empty() && action.captured) {
+            PreparedInvocations::getInstance().store(preparedKey, std::move(action.captured));
+        }
+        diagnostics.flush();
+        if (rc != 0) {
+            logFailure(fileName, diagnostics.getCounts());
+            return rc == 1 ? FATAL_ERRORS : NO_FATAL_ERRORS;
+        }
+
+        return NO_FATAL_ERRORS;
+    }
+
+}
+
+void armor::setToolFileSystemOverlay(ToolFileSystemFactory factory) {
+    toolFileSystemOverlay() = std::move(factory);
+}
+
+void armor::setLeanFrontend(bool enabled) {
+    leanFrontend() = enabled;
+}
+
+PARSING_STATUS armor::runFrontendAction(const std::string& fileName,
+                                        const clang::tooling::CompilationDatabase& compDB,
+                                        clang::tooling::FrontendActionFactory& factory) {
+    return runTool(fileName, nullptr, compDB, factory);
+}
+
+PARSING_STATUS armor::runFrontendActionOnBuffer(const std::string& fileName,
+                                                llvm::StringRef contents,
+                                                const clang::tooling::CompilationDatabase& compDB,
+                                                clang::tooling::FrontendActionFactory& factory) {
+    return runTool(fileName, &contents, compDB, factory);
+}
+
+std::vector<PARSING_STATUS> armor::runFrontendActionBatch(const std::vector<std::string>& fileNames,
+                                                          const clang::tooling::CompilationDatabase& compDB,
+                                                          clang::tooling::FrontendActionFactory& factory,
+                                                          const SourceBuffers* buffers) {
+    armor::BufferedDiagnosticConsumer diagnostics(threadDiagOptions());
+
+    // One tool, hence one FileManager, for the whole batch
+    clang::tooling::ClangTool tool(compDB, fileNames,
+                                   std::make_shared<clang::PCHContainerOperations>(), createToolFileSystem(buffers));
+    configureTool(tool, &diagnostics);
+
+    // Reads the includes of the current header and the next ones while the tool parses
+    std::unique_ptr<armor::IncludePrefetcher> prefetcher;
+    if (armor::includePrefetchDepth() > 0 && fileNames.size() > 1) {
+        prefetcher = std::make_unique<armor::IncludePrefetcher>(prefetchOrder(fileNames, compDB),
+                                                                armor::includePrefetchDepth() + 1);
+    }
+
+    llvm::StringMap<PARSING_STATUS> statusByInput;
+    StatusRecordingAction action(factory, diagnostics, statusByInput, prefetcher.get());
+    tool.run(&action);
+
+    std::vector<PARSING_STATUS> statuses;
+    statuses.reserve(fileNames.size());
+    for (const auto& fileName : fileNames) {
+        auto it = statusByInput.find(clang::tooling::getAbsolutePath(fileName));
+        // Headers the tool never got to (no compile command) count as failed
+        if (it == statusByInput.end()) {
+            armor::error() << "Error while processing " << fileName << "." << "\n";
+            statuses.push_back(FATAL_ERRORS);
+            continue;
+        }
+        statuses.push_back(it->second);
+    }
+
+    return statuses;
+}
+
+llvm::StringMap<std::string> armor::mapBatchInputs(const std::vector<std::string>& fileNames) {
+    // Same resolution as ClangTool::run, which hands actions absolute paths
+    llvm::StringMap<std::string> inputs;
+    for (const auto& fileName : fileNames) {
+        inputs.try_emplace(clang::tooling::getAbsolutePath(fileName), fileName);
+    }
+    return inputs;
+}
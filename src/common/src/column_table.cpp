@@ -0,0 +1,54 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cassert>
+#include <utility>
+
+#include "column_table.hpp"
+
+std::size_t armor::ColumnTable::addStringColumn(std::string name) {
+    Column& column = columns.emplace_back();
+    column.name = std::move(name);
+    column.isString = true;
+    return columns.size() - 1;
+}
+
+std::size_t armor::ColumnTable::addIntColumn(std::string name) {
+    columns.emplace_back().name = std::move(name);
+    return columns.size() - 1;
+}
+
+void armor::ColumnTable::append(std::size_t column, llvm::StringRef value) {
+    Column& target = columns[column];
+    assert(target.isString);
+    auto [it, inserted] = target.dictionaryIndex.try_emplace(value, static_cast<int64_t>(target.dictionary.size()));
+    if (inserted) {
+        target.dictionary.push_back(value.str());
+    }
+    target.values.push_back(it->second);
+}
+
+void armor::ColumnTable::append(std::size_t column, int64_t value) {
+    assert(!columns[column].isString);
+    columns[column].values.push_back(value);
+}
+
+std::size_t armor::ColumnTable::rows() const {
+    return columns.empty() ? 0 : columns.front().values.size();
+}
+
+nlohmann::json armor::ColumnTable::toJson() const {
+    nlohmann::json encoded = nlohmann::json::array();
+    for (const Column& column : columns) {
+        assert(column.values.size() == rows());
+        if (column.isString) {
+            encoded.push_back({{"name", column.name},
+                               {"type", "string"},
+                               {"dictionary", column.dictionary},
+                               {"indices", column.values}});
+        }
+        else {
+            encoded.push_back({{"name", column.name}, {"type", "int64"}, {"values", column.values}});
+        }
+    }
+    return {{"rows", rows()}, {"columns", std::move(encoded)}};
+}
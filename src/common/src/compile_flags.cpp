@@ -0,0 +1,118 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+
+#include "compile_flags.hpp"
+#include "logger.hpp"
+
+namespace {
+
+    std::vector<std::string> splitFlags(const char* rawFlags) {
+        std::vector<std::string> flags;
+        std::istringstream iss(rawFlags);
+        std::string flag;
+        while (iss >> flag) {
+            flags.emplace_back(std::move(flag));
+        }
+        return flags;
+    }
+
+    // The built-in flags of `lang`, split once for the process
+    const std::vector<std::string>& builtInFlags(const LANG_OPTIONS lang) {
+        static const std::vector<std::string> cFlags = splitFlags(CLANG_FLAGS_C);
+        static const std::vector<std::string> cppFlags = splitFlags(CLANG_FLAGS_CPP);
+        return lang == LANG_OPTIONS::C ? cFlags : cppFlags;
+    }
+
+    std::vector<std::string> getClangFlags(const std::vector<std::string>& includePaths,
+                                           const std::vector<std::string>& macroFlags,
+                                           const LANG_OPTIONS lang) {
+        const std::vector<std::string>& langFlags = builtInFlags(lang);
+        std::vector<std::string> flags;
+        flags.reserve(langFlags.size() + includePaths.size() + macroFlags.size());
+        flags.insert(flags.end(), langFlags.begin(), langFlags.end());
+
+        // Add runtime include paths
+        for (const auto& path : includePaths) {
+            flags.emplace_back("-I" + path);
+        }
+
+        // Add full macro flags directly
+        for (const auto& macro : macroFlags) {
+            flags.emplace_back(macro);
+        }
+
+        return flags;
+    }
+
+    std::vector<std::string> resolveInternalIncludePaths(const std::vector<std::string>& internalPaths,
+                                                         const std::string& workspacePath) {
+
+        std::vector<std::string> resolvedPaths;
+        for (const auto& path : internalPaths) {
+            resolvedPaths.push_back(workspacePath + "/" + path);
+        }
+        return resolvedPaths;
+    }
+
+    std::vector<std::string> generateIncludePaths(const std::string& projectPath, const std::string& headerPath) {
+        std::vector<std::string> includePaths;
+
+        // Ensure the header path starts with the project path
+        if (headerPath.find(projectPath) != 0) {
+            armor::user_error() << "Warning: Header file " << headerPath << " is not within project path " << projectPath << "\n";
+            return includePaths;
+        }
+
+        // Get the directory of the header file
+        llvm::SmallString<256> headerDir(headerPath);
+        llvm::sys::path::remove_filename(headerDir);
+
+        // Start with the directory containing the header file
+        llvm::SmallString<256> currentPath = headerDir;
+
+        // Add all parent directories up to and including the project path
+        while (llvm::StringRef(currentPath).str().length() >= projectPath.length()) {
+            includePaths.push_back("-I" + llvm::StringRef(currentPath).str());
+
+            // Move up one directory
+            llvm::sys::path::remove_filename(currentPath);
+
+            // If we've reached the root directory, break
+            if (currentPath.empty()) {
+                break;
+            }
+        }
+
+        // Make sure the project path itself is included
+        if (std::find(includePaths.begin(), includePaths.end(), "-I" + projectPath) == includePaths.end()) {
+            includePaths.push_back("-I" + projectPath);
+        }
+
+        return includePaths;
+    }
+}
+
+std::vector<std::string> armor::buildBaseCompileFlags(const std::string& projectRoot,
+                                                      const std::vector<std::string>& includePaths,
+                                                      const std::vector<std::string>& macroFlags,
+                                                      LANG_OPTIONS lang) {
+    return getClangFlags(resolveInternalIncludePaths(includePaths, projectRoot), macroFlags, lang);
+}
+
+std::vector<std::string> armor::buildCompileFlags(const std::string& projectRoot,
+                                                  const std::string& headerPath,
+                                                  const std::vector<std::string>& includePaths,
+                                                  const std::vector<std::string>& macroFlags,
+                                                  LANG_OPTIONS lang) {
+    std::vector<std::string> flags = buildBaseCompileFlags(projectRoot, includePaths, macroFlags, lang);
+    std::vector<std::string> headerPaths = generateIncludePaths(projectRoot, headerPath);
+    flags.insert(flags.end(), headerPaths.begin(), headerPaths.end());
+    return flags;
+}
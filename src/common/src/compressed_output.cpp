@@ -0,0 +1,159 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "compressed_output.hpp"
+
+namespace {
+
+    // zlib window bits plus 16: a gzip header and trailer instead of zlib's
+    constexpr int GZIP_WINDOW_BITS = 15 + 16;
+    constexpr int GZIP_MEMORY_LEVEL = 8;
+    constexpr std::size_t CHUNK_BYTES = 64 * 1024;
+
+}
+
+struct armor::GzipEncoder::State {
+    z_stream stream{};
+    Sink sink;
+    std::vector<char> out = std::vector<char>(CHUNK_BYTES);
+    bool finished = false;
+
+    // Runs deflate over the pending input with `flush`, handing every filled chunk to the sink
+    void deflateWith(int flush) {
+        int status = Z_OK;
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(out.data());
+            stream.avail_out = static_cast<uInt>(out.size());
+            status = deflate(&stream, flush);
+            if (status == Z_STREAM_ERROR) {
+                throw std::runtime_error("gzip compression failed");
+            }
+            std::size_t produced = out.size() - stream.avail_out;
+            if (produced) {
+                sink(out.data(), produced);
+            }
+        } while (stream.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+    }
+};
+
+armor::GzipEncoder::GzipEncoder(Sink sink) : state(std::make_unique<State>()) {
+    state->sink = std::move(sink);
+    if (deflateInit2(&state->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, GZIP_MEMORY_LEVEL,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Failed to initialize gzip compression");
+    }
+}
+
+armor::GzipEncoder::~GzipEncoder() {
+    deflateEnd(&state->stream);
+}
+
+void armor::GzipEncoder::write(const char* data, std::size_t size) {
+    if (state->finished) {
+        return;
+    }
+    // avail_in is 32 bits wide
+    while (size > 0) {
+        uInt part = static_cast<uInt>(std::min<std::size_t>(size, CHUNK_BYTES));
+        state->stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        state->stream.avail_in = part;
+        state->deflateWith(Z_NO_FLUSH);
+        data += part;
+        size -= part;
+    }
+}
+
+void armor::GzipEncoder::sync() {
+    if (!state->finished) {
+        state->deflateWith(Z_SYNC_FLUSH);
+    }
+}
+
+void armor::GzipEncoder::finish() {
+    if (!state->finished) {
+        state->deflateWith(Z_FINISH);
+        state->finished = true;
+    }
+}
+
+// Collects output in a chunk and compresses it whole
+class armor::GzipOStream::Buffer : public std::streambuf {
+public:
+    explicit Buffer(std::ostream& target)
+        : encoder([&target](const char* data, std::size_t size) {
+              target.write(data, static_cast<std::streamsize>(size));
+          }) {
+        setp(pending.data(), pending.data() + pending.size());
+    }
+
+    void finish() {
+        compressPending();
+        encoder.finish();
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        compressPending();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        compressPending();
+        return 0;
+    }
+
+private:
+    void compressPending() {
+        encoder.write(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+        setp(pending.data(), pending.data() + pending.size());
+    }
+
+    std::vector<char> pending = std::vector<char>(CHUNK_BYTES);
+    GzipEncoder encoder;
+};
+
+armor::GzipOStream::GzipOStream(std::ostream& target)
+    : std::ostream(nullptr), buffer(std::make_unique<Buffer>(target)) {
+    rdbuf(buffer.get());
+}
+
+armor::GzipOStream::~GzipOStream() {
+    try {
+        finish();
+    }
+    catch (...) {
+    }
+}
+
+void armor::GzipOStream::finish() {
+    buffer->finish();
+}
+
+armor::GzipRawOStream::GzipRawOStream(std::unique_ptr<llvm::raw_ostream> target)
+    : target(std::move(target)),
+      encoder([this](const char* data, std::size_t size) { this->target->write(data, size); }) {}
+
+armor::GzipRawOStream::~GzipRawOStream() {
+    flush();
+    encoder.finish();
+    target->flush();
+}
+
+void armor::GzipRawOStream::write_impl(const char* data, size_t size) {
+    written += size;
+    encoder.write(data, size);
+    // Each flush of the log leaves a readable file behind
+    encoder.sync();
+    target->flush();
+}
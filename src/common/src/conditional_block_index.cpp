@@ -0,0 +1,206 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/xxhash.h"
+
+#include "conditional_block_index.hpp"
+
+namespace {
+
+    uint64_t combine(uint64_t seed, llvm::StringRef text) {
+        llvm::SmallString<128> material;
+        material.append(reinterpret_cast<const char*>(&seed), reinterpret_cast<const char*>(&seed) + sizeof(seed));
+        material += text;
+        return llvm::xxHash64(material);
+    }
+
+}
+
+void ConditionalBlockIndex::openConditional(llvm::StringRef directive, unsigned startOffset) {
+    uint64_t parentKey = open.empty() ? 0 : branches[open.back()].key;
+    uint64_t key = combine(parentKey, directive);
+    // Identical conditionals at the same nesting path are told apart by their order
+    unsigned occurrence = occurrences[key]++;
+    if (occurrence != 0) {
+        key = combine(key, llvm::StringRef(reinterpret_cast<const char*>(&occurrence), sizeof(occurrence)));
+    }
+    Branch branch;
+    branch.key = key;
+    branch.startOffset = startOffset;
+    branches.push_back(branch);
+    open.push_back(static_cast<int>(branches.size() - 1));
+}
+
+void ConditionalBlockIndex::nextBranch(llvm::StringRef directive, unsigned startOffset, unsigned endOffset) {
+    if (open.empty()) {
+        return;
+    }
+    Branch& ended = branches[open.back()];
+    ended.endOffset = endOffset;
+    ended.closed = true;
+    lastClosed = open.back();
+    // A sibling is keyed under the branch it follows, so every branch of a chain differs
+    uint64_t key = combine(ended.key, directive);
+    open.pop_back();
+    Branch branch;
+    branch.key = key;
+    branch.startOffset = startOffset;
+    branches.push_back(branch);
+    open.push_back(static_cast<int>(branches.size() - 1));
+}
+
+void ConditionalBlockIndex::closeConditional(unsigned endOffset) {
+    if (open.empty()) {
+        return;
+    }
+    Branch& ended = branches[open.back()];
+    ended.endOffset = endOffset;
+    ended.closed = true;
+    lastClosed = open.back();
+    open.pop_back();
+}
+
+int ConditionalBlockIndex::currentBranch() const {
+    return open.empty() ? NO_BRANCH : open.back();
+}
+
+void ConditionalBlockIndex::reuseFrom(std::shared_ptr<const Snapshot> snapshot, llvm::StringRef text) {
+    previous = std::move(snapshot);
+    reuse.assign(branches.size(), Reuse::UNKNOWN);
+    reusedBlocks.assign(branches.size(), nullptr);
+    if (!previous) {
+        return;
+    }
+    llvm::StringRef before = previous->text;
+    std::size_t shared = std::min(before.size(), text.size());
+    std::size_t prefix = 0;
+    while (prefix < shared && before[prefix] == text[prefix]) {
+        ++prefix;
+    }
+    std::size_t suffix = 0;
+    while (suffix < shared - prefix && before[before.size() - 1 - suffix] == text[text.size() - 1 - suffix]) {
+        ++suffix;
+    }
+    prefixLength = static_cast<unsigned>(prefix);
+    suffixStart = static_cast<unsigned>(text.size() - suffix);
+    suffixShift = static_cast<int64_t>(before.size()) - static_cast<int64_t>(text.size());
+}
+
+const ConditionalBlockIndex::Snapshot::Block* ConditionalBlockIndex::reusableBlock(int branch) {
+    if (!previous || branch < 0 || static_cast<std::size_t>(branch) >= reuse.size()) {
+        return nullptr;
+    }
+    if (reuse[branch] != Reuse::UNKNOWN) {
+        return reusedBlocks[branch];
+    }
+    const Branch& current = branches[branch];
+    const Snapshot::Block* block = nullptr;
+    auto it = previous->blocks.find(current.key);
+    if (current.closed && it != previous->blocks.end()) {
+        // Where the branch sat in the previous buffer, if the edit left its bytes alone
+        std::optional<int64_t> before;
+        if (current.endOffset <= prefixLength) {
+            before = current.startOffset;
+        } else if (current.startOffset >= suffixStart) {
+            before = static_cast<int64_t>(current.startOffset) + suffixShift;
+        }
+        const Snapshot::Block& candidate = it->second;
+        if (before && candidate.startOffset == *before &&
+            candidate.endOffset - candidate.startOffset == current.endOffset - current.startOffset) {
+            block = &candidate;
+        }
+    }
+    reuse[branch] = block ? Reuse::REUSED : Reuse::HASHED;
+    reusedBlocks[branch] = block;
+    ++(block ? reusedBranches : hashedBranches);
+    return block;
+}
+
+std::optional<uint64_t> ConditionalBlockIndex::previousHash(int branch, unsigned startOffset, unsigned endOffset,
+                                                            bool isActive) {
+    const Snapshot::Block* block = reusableBlock(branch);
+    // Only the bytes of the branch itself are known to be unchanged
+    if (!block || startOffset < branches[branch].startOffset || endOffset > branches[branch].endOffset) {
+        return std::nullopt;
+    }
+    unsigned relativeStart = startOffset - branches[branch].startOffset;
+    unsigned relativeEnd = endOffset - branches[branch].startOffset;
+    auto it = std::lower_bound(block->ranges.begin(), block->ranges.end(), relativeStart,
+                               [](const Snapshot::HashedRange& range, unsigned start) {
+                                   return range.startOffset < start;
+                               });
+    for (; it != block->ranges.end() && it->startOffset == relativeStart; ++it) {
+        if (it->endOffset == relativeEnd && it->isActive == isActive) {
+            return it->hash;
+        }
+    }
+    return std::nullopt;
+}
+
+void ConditionalBlockIndex::record(int branch, unsigned startOffset, unsigned endOffset, bool isActive,
+                                   uint64_t hash) {
+    if (branch < 0 || static_cast<std::size_t>(branch) >= branches.size() || !branches[branch].closed) {
+        return;
+    }
+    if (!recording) {
+        recording = std::make_unique<Snapshot>();
+    }
+    const Branch& owner = branches[branch];
+    Snapshot::Block& block = recording->blocks[owner.key];
+    block.startOffset = owner.startOffset;
+    block.endOffset = owner.endOffset;
+    block.ranges.push_back({startOffset - owner.startOffset, endOffset - owner.startOffset, hash, isActive});
+}
+
+std::shared_ptr<const ConditionalBlockIndex::Snapshot> ConditionalBlockIndex::takeSnapshot(llvm::StringRef text) {
+    if (!recording) {
+        recording = std::make_unique<Snapshot>();
+    }
+    recording->text.assign(text.data(), text.size());
+    return std::shared_ptr<const Snapshot>(std::move(recording));
+}
+
+ConditionalBlockCache& ConditionalBlockCache::getInstance() {
+    static ConditionalBlockCache instance;
+    return instance;
+}
+
+std::shared_ptr<const ConditionalBlockIndex::Snapshot> ConditionalBlockCache::find(llvm::StringRef file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = snapshots.find(file);
+    return it == snapshots.end() ? nullptr : it->second;
+}
+
+void ConditionalBlockCache::store(llvm::StringRef file,
+                                  std::shared_ptr<const ConditionalBlockIndex::Snapshot> snapshot) {
+    if (!snapshot) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = snapshots.find(file);
+    if (it != snapshots.end()) {
+        bytes -= it->second->text.size();
+        snapshots.erase(it);
+    }
+    if (bytes + snapshot->text.size() > maxBytes) {
+        snapshots.clear();
+        bytes = 0;
+    }
+    bytes += snapshot->text.size();
+    snapshots[file] = std::move(snapshot);
+}
+
+void ConditionalBlockCache::count(std::size_t reused, std::size_t hashed) {
+    reusedBranches += reused;
+    hashedBranches += hashed;
+}
+
+void ConditionalBlockCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    snapshots.clear();
+    bytes = 0;
+}
@@ -90,6 +90,41 @@ namespace {
     }
   };
 
+  /// Forwards a template argument to the list being printed, remembering
+  /// its first and last characters so the list can be punctuated without
+  /// printing every argument into a temporary buffer first.
+  class TemplateArgumentStream : public raw_ostream {
+    raw_ostream &Out;
+    bool SpaceBeforeScope;
+    bool Written = false;
+    char Last = 0;
+    uint64_t Pos = 0;
+
+    void write_impl(const char *Ptr, size_t Size) override {
+      if (Size == 0)
+        return;
+      // An argument starting with '::' must not form the digraph '<:'
+      if (!Written && SpaceBeforeScope && Ptr[0] == ':')
+        Out << ' ';
+      Written = true;
+      Last = Ptr[Size - 1];
+      Pos += Size;
+      Out.write(Ptr, Size);
+    }
+
+    uint64_t current_pos() const override { return Pos; }
+
+  public:
+    TemplateArgumentStream(raw_ostream &Out, bool SpaceBeforeScope)
+        : Out(Out), SpaceBeforeScope(SpaceBeforeScope) {
+      SetUnbuffered();
+    }
+
+    bool empty() const { return !Written; }
+
+    char back() const { return Last; }
+  };
+
   class TypePrinter {
     PrintingPolicy Policy;
     unsigned Indentation;
@@ -889,8 +924,12 @@ void TypePrinter::printFunctionProtoAfter(const FunctionProtoType *T,
 
   printFunctionAfter(Info, OS);
 
-  if (!T->getMethodQuals().empty())
-    OS << " " << T->getMethodQuals().getAsString();
+  if (!T->getMethodQuals().empty()) {
+    // Printed as Qualifiers::getAsString() would, without the temporary string
+    LangOptions LO;
+    OS << " ";
+    T->getMethodQuals().print(OS, PrintingPolicy(LO));
+  }
 
   switch (T->getRefQualifier()) {
   case RQ_None:
@@ -2036,37 +2075,33 @@ printTo(raw_ostream &OS, ArrayRef<TA> Args, const PrintingPolicy &Policy,
   bool NeedSpace = false;
   bool FirstArg = true;
   for (const auto &Arg : Args) {
-    // Print the argument into a string.
-    SmallString<128> Buf;
-    llvm::raw_svector_ostream ArgOS(Buf);
     const TemplateArgument &Argument = getArgument(Arg);
     if (Argument.getKind() == TemplateArgument::Pack) {
       if (Argument.pack_size() && !FirstArg)
         OS << Comma;
-      printTo(ArgOS, Argument.getPackAsArray(), Policy, TPL,
-              /*IsPack*/ true, ParmIndex);
     } else {
       if (!FirstArg)
         OS << Comma;
+    }
+
+    // The argument is streamed straight into OS. If this is the first
+    // argument and it begins with the global scope specifier ('::foo'),
+    // a space is written ahead of it to avoid printing the digraph '<:'.
+    TemplateArgumentStream ArgOS(OS, /*SpaceBeforeScope=*/FirstArg);
+    if (Argument.getKind() == TemplateArgument::Pack) {
+      printTo(ArgOS, Argument.getPackAsArray(), Policy, TPL,
+              /*IsPack*/ true, ParmIndex);
+    } else {
       // Tries to print the argument with location info if exists.
       printArgument(Arg, Policy, ArgOS,
                     TemplateParameterList::shouldIncludeTypeForArgument(
                         Policy, TPL, ParmIndex));
     }
-    StringRef ArgString = ArgOS.str();
-
-    // If this is the first argument and its string representation
-    // begins with the global scope specifier ('::foo'), add a space
-    // to avoid printing the diagraph '<:'.
-    if (FirstArg && !ArgString.empty() && ArgString[0] == ':')
-      OS << ' ';
-
-    OS << ArgString;
 
     // If the last character of our string is '>', add another space to
     // keep the two '>''s separate tokens.
-    if (!ArgString.empty()) {
-      NeedSpace = Policy.SplitTemplateClosers && ArgString.back() == '>';
+    if (!ArgOS.empty()) {
+      NeedSpace = Policy.SplitTemplateClosers && ArgOS.back() == '>';
       FirstArg = false;
     }
 
@@ -2282,6 +2317,5 @@ void QualType::getAsStringInternal(const Type *ty, Qualifiers qs,
   SmallString<256> Buf;
   llvm::raw_svector_ostream StrOS(Buf);
   TypePrinter(policy).print(ty, qs, StrOS, buffer);
-  std::string str = std::string(StrOS.str());
-  buffer.swap(str);
+  buffer.assign(Buf.data(), Buf.size());
 }
\ No newline at end of file
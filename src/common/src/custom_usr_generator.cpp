@@ -1,6 +1,7 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 #include "custom_usr_generator.hpp"
+#include "nsr_generator.hpp"
 #include "type_utils.hpp"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Attr.h"
@@ -16,6 +17,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "clang/Index/USRGeneration.h"
 #include <llvm-14/llvm/Support/Casting.h>
+#include <array>
 
 using namespace clang;
 
@@ -63,29 +65,112 @@ static StringRef GetExternalSourceContainer(const NamedDecl *D) {
   return StringRef();
 }
 
+static void printQualifier(llvm::raw_ostream &Out, ASTContext &Ctx, NestedNameSpecifier *NNS) {
+  // FIXME: Encode the qualifier, don't just print it.
+  PrintingPolicy PO(Ctx.getLangOpts());
+  PO.SuppressTagKeyword = true;
+  PO.SuppressUnwrittenScope = true;
+  PO.ConstantArraySizeAsWritten = false;
+  PO.AnonymousTagLocations = false;
+  NNS->print(Out, PO);
+}
+
 namespace {
-class USRGenerator : public ConstDeclVisitor<USRGenerator> {
-  SmallVectorImpl<char> &Buf;
-  llvm::raw_svector_ostream Out;
-  bool IgnoreResults;
+
+// The strings a generator spells, as bits of its emit policy. An NSR is the
+// USR without the parameter types of overloads and without template
+// parameters and arguments; everything else is generated once for both.
+enum : unsigned {
+  USR_SPELLING = 1u << 0,
+  NSR_SPELLING = 1u << 1,
+};
+
+constexpr unsigned spellingIndex(unsigned Spelling) {
+  return Spelling == USR_SPELLING ? 0 : 1;
+}
+
+/// Unbuffered stream appending to the buffer of every active spelling.
+class SpellingStream : public llvm::raw_ostream {
+public:
+  SpellingStream(SmallVectorImpl<char> *USRBuf, SmallVectorImpl<char> *NSRBuf,
+                 unsigned Active)
+  : llvm::raw_ostream(/*unbuffered=*/true),
+    Bufs{USRBuf, NSRBuf},
+    Active(Active) {}
+
+  unsigned active() const { return Active; }
+
+  /// Position of the last character written to each buffer.
+  std::array<size_t, 2> lastWritten() const {
+    std::array<size_t, 2> At{0, 0};
+    for (unsigned I = 0; I != 2; ++I)
+      if (Bufs[I] && !Bufs[I]->empty())
+        At[I] = Bufs[I]->size() - 1;
+    return At;
+  }
+
+  /// Replaces the character at `At` in the buffers of the active spellings.
+  void overwrite(const std::array<size_t, 2> &At, char C) {
+    for (unsigned I = 0; I != 2; ++I)
+      if (Active & (1u << I))
+        (*Bufs[I])[At[I]] = C;
+  }
+
+  /// Restricts writes to the spellings of `Mask` for the lifetime of the guard.
+  class Only {
+  public:
+    Only(SpellingStream &Out, unsigned Mask) : Out(Out), Saved(Out.Active) {
+      Out.Active &= Mask;
+    }
+    ~Only() { Out.Active = Saved; }
+
+  private:
+    SpellingStream &Out;
+    unsigned Saved;
+  };
+
+private:
+  void write_impl(const char *Ptr, size_t Size) override {
+    for (unsigned I = 0; I != 2; ++I)
+      if (Active & (1u << I))
+        Bufs[I]->append(Ptr, Ptr + Size);
+    Written += Size;
+  }
+
+  uint64_t current_pos() const override { return Written; }
+
+  SmallVectorImpl<char> *Bufs[2];
+  unsigned Active;
+  uint64_t Written = 0;
+};
+
+/// USR and NSR generator, specialized at compile time on the spellings it
+/// writes (`Spellings`). The USR-only parts are compiled out of the NSR
+/// generator, and a generator of both walks the declaration context chain
+/// and prints the names once.
+template <unsigned Spellings>
+class RefGenerator : public ConstDeclVisitor<RefGenerator<Spellings>> {
+  SpellingStream Out;
+  bool IgnoreResults[2] = {false, false};
   ASTContext *Context;
-  bool generatedLoc;
+  bool generatedLoc[2] = {false, false};
 
   llvm::DenseMap<const Type *, unsigned> TypeSubstitutions;
 
 public:
-  explicit USRGenerator(ASTContext *Ctx, SmallVectorImpl<char> &Buf)
-  : Buf(Buf),
-    Out(Buf),
-    IgnoreResults(false),
-    Context(Ctx),
-    generatedLoc(false)
+  explicit RefGenerator(ASTContext *Ctx, SmallVectorImpl<char> *USRBuf,
+                        SmallVectorImpl<char> *NSRBuf)
+  : Out(USRBuf, NSRBuf, Spellings),
+    Context(Ctx)
   {
-    // Add the USR space prefix.
-    Out << getUSRSpacePrefix();
+    // Add the USR and NSR space prefixes.
+    only<USR_SPELLING>([&] { Out << getUSRSpacePrefix(); });
+    only<NSR_SPELLING>([&] { Out << getNSRSpacePrefix(); });
   }
 
-  bool ignoreResults() const { return IgnoreResults; }
+  bool ignoreResults(unsigned Spelling) const {
+    return IgnoreResults[spellingIndex(Spelling)];
+  }
 
   // Visitation methods from generating USRs from AST elements.
   void VisitDeclContext(const DeclContext *D);
@@ -107,11 +192,11 @@ public:
   void VisitUnresolvedUsingTypenameDecl(const UnresolvedUsingTypenameDecl *D);
 
   void VisitLinkageSpecDecl(const LinkageSpecDecl *D) {
-    IgnoreResults = true; // No USRs for linkage specs themselves.
+    setIgnored(); // No USRs for linkage specs themselves.
   }
 
   void VisitUsingDirectiveDecl(const UsingDirectiveDecl *D) {
-    IgnoreResults = true;
+    setIgnored();
   }
 
   void VisitUsingDecl(const UsingDecl *D) {
@@ -148,6 +233,35 @@ public:
   /// Emit a Decl's name using NamedDecl::printName() and return true if
   ///  the decl had no name.
   bool EmitDeclName(const NamedDecl *D);
+
+private:
+  /// Runs `Emit` writing only the spellings of `Mask` that are active;
+  /// compiled out of generators writing none of them.
+  template <unsigned Mask, typename EmitFn>
+  void only(EmitFn &&Emit) {
+    if constexpr ((Spellings & Mask) != 0) {
+      if (Out.active() & Mask) {
+        SpellingStream::Only Guard(Out, Mask);
+        Emit();
+      }
+    }
+  }
+
+  /// Marks the results of the active spellings as ignored.
+  void setIgnored() {
+    for (unsigned I = 0; I != 2; ++I)
+      if (Out.active() & (1u << I))
+        IgnoreResults[I] = true;
+  }
+
+  /// The active spellings whose results are not ignored.
+  unsigned notIgnored() const {
+    unsigned Mask = 0;
+    for (unsigned I = 0; I != 2; ++I)
+      if (!IgnoreResults[I])
+        Mask |= 1u << I;
+    return Out.active() & Mask;
+  }
 };
 } // end anonymous namespace
 
@@ -155,14 +269,16 @@ public:
 // Generating USRs from ASTS.
 //===----------------------------------------------------------------------===//
 
-bool USRGenerator::EmitDeclName(const NamedDecl *D) {
-  const unsigned startSize = Buf.size();
+template <unsigned Spellings>
+bool RefGenerator<Spellings>::EmitDeclName(const NamedDecl *D) {
+  const uint64_t startSize = Out.tell();
   D->printName(Out);
-  const unsigned endSize = Buf.size();
+  const uint64_t endSize = Out.tell();
   return startSize == endSize;
 }
 
-bool USRGenerator::ShouldGenerateLocation(const NamedDecl *D) {
+template <unsigned Spellings>
+bool RefGenerator<Spellings>::ShouldGenerateLocation(const NamedDecl *D) {
   // Always include location for parameters and template parameters
   if (isa<ParmVarDecl>(D)||
     isa<TemplateTypeParmDecl>(D) || 
@@ -181,38 +297,44 @@ bool USRGenerator::ShouldGenerateLocation(const NamedDecl *D) {
   
 }
 
-void USRGenerator::VisitDeclContext(const DeclContext *DC) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitDeclContext(const DeclContext *DC) {
   if (const NamedDecl *D = dyn_cast<NamedDecl>(DC))
-    Visit(D);
+    this->Visit(D);
   else if (isa<LinkageSpecDecl>(DC)) // Linkage specs are transparent in USRs.
     VisitDeclContext(DC->getParent());
 }
 
-void USRGenerator::VisitFieldDecl(const FieldDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitFieldDecl(const FieldDecl *D) {
   // The USR for an ivar declared in a class extension is based on the
   VisitDeclContext(D->getDeclContext());
   Out << "@FI@";
   if (EmitDeclName(D)) {
     // Bit fields can be anonymous.
-    IgnoreResults = true;
+    setIgnored();
     return;
   }
 }
 
-void USRGenerator::VisitFunctionDecl(const FunctionDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitFunctionDecl(const FunctionDecl *D) {
   if (ShouldGenerateLocation(D) && GenLoc(D, /*IncludeOffset=*/isLocal(D)))
     return;
 
-  const unsigned StartSize = Buf.size();
+  const uint64_t StartSize = Out.tell();
   VisitDeclContext(D->getDeclContext());
-  if (Buf.size() == StartSize)
+  if (Out.tell() == StartSize)
     GenExtSymbolContainer(D);
 
-  bool IsTemplate = false;
-  if (FunctionTemplateDecl *FunTmpl = D->getDescribedFunctionTemplate()) {
-    IsTemplate = true;
-    Out << "@FT@";
-    VisitTemplateParameterList(FunTmpl->getTemplateParameters());
+  FunctionTemplateDecl *FunTmpl = D->getDescribedFunctionTemplate();
+  if (FunTmpl) {
+    only<USR_SPELLING>([&] {
+      Out << "@FT@";
+      VisitTemplateParameterList(FunTmpl->getTemplateParameters());
+    });
+    // NSRs spell function templates as functions
+    only<NSR_SPELLING>([&] { Out << "@F@"; });
   } else
     Out << "@F@";
 
@@ -227,39 +349,45 @@ void USRGenerator::VisitFunctionDecl(const FunctionDecl *D) {
       !D->hasAttr<OverloadableAttr>())
     return;
 
-  if (const TemplateArgumentList *
-        SpecArgs = D->getTemplateSpecializationArgs()) {
-    Out << '<';
-    for (unsigned I = 0, N = SpecArgs->size(); I != N; ++I) {
-      Out << '#';
-      VisitTemplateArgument(SpecArgs->get(I));
+  only<USR_SPELLING>([&] {
+    if (const TemplateArgumentList *
+          SpecArgs = D->getTemplateSpecializationArgs()) {
+      Out << '<';
+      for (unsigned I = 0, N = SpecArgs->size(); I != N; ++I) {
+        Out << '#';
+        VisitTemplateArgument(SpecArgs->get(I));
+      }
+      Out << '>';
     }
-    Out << '>';
-  }
 
-  // Mangle in type information for the arguments.
-  for (auto PD : D->parameters()) {
-    Out << '#';
-    VisitType(PD->getType());
-  }
+    // Mangle in type information for the arguments.
+    for (auto PD : D->parameters()) {
+      Out << '#';
+      VisitType(PD->getType());
+    }
+  });
   if (D->isVariadic())
     Out << '.';
-  if (IsTemplate) {
+  if (FunTmpl) {
     // Function templates can be overloaded by return type, for example:
     // \code
     //   template <class T> typename T::A foo() {}
     //   template <class T> typename T::B foo() {}
     // \endcode
-    Out << '#';
-    VisitType(D->getReturnType());
+    only<USR_SPELLING>([&] {
+      Out << '#';
+      VisitType(D->getReturnType());
+    });
   }
   Out << '#';
   if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(D)) {
-    if (MD->isStatic())
-      Out << 'S';
-    // FIXME: OpenCL: Need to consider address spaces
-    if (unsigned quals = MD->getMethodQualifiers().getCVRUQualifiers())
-      Out << (char)('0' + quals);
+    only<USR_SPELLING>([&] {
+      if (MD->isStatic())
+        Out << 'S';
+      // FIXME: OpenCL: Need to consider address spaces
+      if (unsigned quals = MD->getMethodQualifiers().getCVRUQualifiers())
+        Out << (char)('0' + quals);
+    });
     switch (MD->getRefQualifier()) {
     case RQ_None: break;
     case RQ_LValue: Out << '&'; break;
@@ -268,7 +396,8 @@ void USRGenerator::VisitFunctionDecl(const FunctionDecl *D) {
   }
 }
 
-void USRGenerator::VisitNamedDecl(const NamedDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitNamedDecl(const NamedDecl *D) {
   VisitDeclContext(D->getDeclContext());
   Out << "@";
 
@@ -277,11 +406,12 @@ void USRGenerator::VisitNamedDecl(const NamedDecl *D) {
     // the ParmDecl with no name for declaration of a function pointer type,
     // e.g.: void  (*f)(void *);
     // In this case, don't generate a USR.
-    IgnoreResults = true;
+    setIgnored();
   }
 }
 
-void USRGenerator::VisitVarDecl(const VarDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitVarDecl(const VarDecl *D) {
   // VarDecls can be declared 'extern' within a function or method body,
   // but their enclosing DeclContext is the function, not the TU.  We need
   // to check the storage class to correctly generate the USR.
@@ -290,14 +420,16 @@ void USRGenerator::VisitVarDecl(const VarDecl *D) {
 
   VisitDeclContext(D->getDeclContext());
 
-  if (VarTemplateDecl *VarTmpl = D->getDescribedVarTemplate()) {
-    Out << "@VT";
-    VisitTemplateParameterList(VarTmpl->getTemplateParameters());
-  } else if (const VarTemplatePartialSpecializationDecl *PartialSpec
-             = dyn_cast<VarTemplatePartialSpecializationDecl>(D)) {
-    Out << "@VP";
-    VisitTemplateParameterList(PartialSpec->getTemplateParameters());
-  }
+  only<USR_SPELLING>([&] {
+    if (VarTemplateDecl *VarTmpl = D->getDescribedVarTemplate()) {
+      Out << "@VT";
+      VisitTemplateParameterList(VarTmpl->getTemplateParameters());
+    } else if (const VarTemplatePartialSpecializationDecl *PartialSpec
+               = dyn_cast<VarTemplatePartialSpecializationDecl>(D)) {
+      Out << "@VP";
+      VisitTemplateParameterList(PartialSpec->getTemplateParameters());
+    }
+  });
 
   // Variables always have simple names.
   StringRef s = D->getName();
@@ -307,7 +439,7 @@ void USRGenerator::VisitVarDecl(const VarDecl *D) {
   //    void  (*f)(void *);
   // In this case, don't generate a USR.
   if (s.empty())
-    IgnoreResults = true;
+    setIgnored();
   else{
     if(D->isCXXClassMember()) 
       Out << "@FI@" << s;
@@ -316,59 +448,73 @@ void USRGenerator::VisitVarDecl(const VarDecl *D) {
   }
 
   // For a template specialization, mangle the template arguments.
-  if (const VarTemplateSpecializationDecl *Spec
-                              = dyn_cast<VarTemplateSpecializationDecl>(D)) {
-    const TemplateArgumentList &Args = Spec->getTemplateArgs();
-    Out << '>';
-    for (unsigned I = 0, N = Args.size(); I != N; ++I) {
-      Out << '#';
-      VisitTemplateArgument(Args.get(I));
+  only<USR_SPELLING>([&] {
+    if (const VarTemplateSpecializationDecl *Spec
+                                = dyn_cast<VarTemplateSpecializationDecl>(D)) {
+      const TemplateArgumentList &Args = Spec->getTemplateArgs();
+      Out << '>';
+      for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+        Out << '#';
+        VisitTemplateArgument(Args.get(I));
+      }
     }
-  }
+  });
 }
 
-void USRGenerator::VisitBindingDecl(const BindingDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitBindingDecl(const BindingDecl *D) {
   if (isLocal(D) && GenLoc(D, /*IncludeOffset=*/true))
     return;
   VisitNamedDecl(D);
 }
 
-void USRGenerator::VisitNonTypeTemplateParmDecl(
+// NSRs spell template parameters as any other named declaration
+
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitNonTypeTemplateParmDecl(
                                         const NonTypeTemplateParmDecl *D) {
-  GenLoc(D, /*IncludeOffset=*/true);
+  only<USR_SPELLING>([&] { GenLoc(D, /*IncludeOffset=*/true); });
+  only<NSR_SPELLING>([&] { VisitNamedDecl(D); });
 }
 
-void USRGenerator::VisitTemplateTemplateParmDecl(
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitTemplateTemplateParmDecl(
                                         const TemplateTemplateParmDecl *D) {
-  GenLoc(D, /*IncludeOffset=*/true);
+  only<USR_SPELLING>([&] { GenLoc(D, /*IncludeOffset=*/true); });
+  only<NSR_SPELLING>([&] { VisitNamedDecl(D); });
 }
 
-void USRGenerator::VisitNamespaceDecl(const NamespaceDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitNamespaceDecl(const NamespaceDecl *D) {
   if (D->isAnonymousNamespace()) {
     Out << "@aN";
     return;
   }
 
   VisitDeclContext(D->getDeclContext());
-  if (!IgnoreResults)
-    Out << "@N@" << D->getName();
+  SpellingStream::Only Named(Out, notIgnored());
+  Out << "@N@" << D->getName();
 }
 
-void USRGenerator::VisitFunctionTemplateDecl(const FunctionTemplateDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitFunctionTemplateDecl(const FunctionTemplateDecl *D) {
   VisitFunctionDecl(D->getTemplatedDecl());
 }
 
-void USRGenerator::VisitClassTemplateDecl(const ClassTemplateDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitClassTemplateDecl(const ClassTemplateDecl *D) {
   VisitTagDecl(D->getTemplatedDecl());
 }
 
-void USRGenerator::VisitNamespaceAliasDecl(const NamespaceAliasDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitNamespaceAliasDecl(const NamespaceAliasDecl *D) {
   VisitDeclContext(D->getDeclContext());
-  if (!IgnoreResults)
-    Out << "@NA@" << D->getName();
+  SpellingStream::Only Named(Out, notIgnored());
+  Out << "@NA@" << D->getName();
 }
 
-void USRGenerator::VisitTagDecl(const TagDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitTagDecl(const TagDecl *D) {
   // Add the location of the tag decl to handle resolution across
   // translation units.
   if (!isa<EnumDecl>(D) &&
@@ -380,35 +526,40 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
   D = D->getCanonicalDecl();
   VisitDeclContext(D->getDeclContext());
 
+  // Whether the USR spelled the kind of a class template or partial
+  // specialization; the NSR spells it as a plain tag
   bool AlreadyStarted = false;
-  if (const CXXRecordDecl *CXXRecord = dyn_cast<CXXRecordDecl>(D)) {
-    if (ClassTemplateDecl *ClassTmpl = CXXRecord->getDescribedClassTemplate()) {
-      AlreadyStarted = true;
-
-      switch (D->getTagKind()) {
-      case TTK_Interface:
-      case TTK_Class:
-      case TTK_Struct: Out << "@ST"; break;
-      case TTK_Union:  Out << "@UT"; break;
-      case TTK_Enum: llvm_unreachable("enum template");
-      }
-      VisitTemplateParameterList(ClassTmpl->getTemplateParameters());
-    } else if (const ClassTemplatePartialSpecializationDecl *PartialSpec
-                = dyn_cast<ClassTemplatePartialSpecializationDecl>(CXXRecord)) {
-      AlreadyStarted = true;
-
-      switch (D->getTagKind()) {
-      case TTK_Interface:
-      case TTK_Class:
-      case TTK_Struct: Out << "@SP"; break;
-      case TTK_Union:  Out << "@UP"; break;
-      case TTK_Enum: llvm_unreachable("enum partial specialization");
+  only<USR_SPELLING>([&] {
+    if (const CXXRecordDecl *CXXRecord = dyn_cast<CXXRecordDecl>(D)) {
+      if (ClassTemplateDecl *ClassTmpl = CXXRecord->getDescribedClassTemplate()) {
+        AlreadyStarted = true;
+
+        switch (D->getTagKind()) {
+        case TTK_Interface:
+        case TTK_Class:
+        case TTK_Struct: Out << "@ST"; break;
+        case TTK_Union:  Out << "@UT"; break;
+        case TTK_Enum: llvm_unreachable("enum template");
+        }
+        VisitTemplateParameterList(ClassTmpl->getTemplateParameters());
+      } else if (const ClassTemplatePartialSpecializationDecl *PartialSpec
+                  = dyn_cast<ClassTemplatePartialSpecializationDecl>(CXXRecord)) {
+        AlreadyStarted = true;
+
+        switch (D->getTagKind()) {
+        case TTK_Interface:
+        case TTK_Class:
+        case TTK_Struct: Out << "@SP"; break;
+        case TTK_Union:  Out << "@UP"; break;
+        case TTK_Enum: llvm_unreachable("enum partial specialization");
+        }
+        VisitTemplateParameterList(PartialSpec->getTemplateParameters());
       }
-      VisitTemplateParameterList(PartialSpec->getTemplateParameters());
     }
-  }
+  });
 
-  if (!AlreadyStarted) {
+  {
+    SpellingStream::Only NotStarted(Out, AlreadyStarted ? NSR_SPELLING : USR_SPELLING | NSR_SPELLING);
     switch (D->getTagKind()) {
       case TTK_Interface:
       case TTK_Class:
@@ -419,12 +570,11 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
   }
 
   Out << '@';
-  assert(Buf.size() > 0);
-  const unsigned off = Buf.size() - 1;
+  const std::array<size_t, 2> off = Out.lastWritten();
 
   if (EmitDeclName(D)) {
     if (const TypedefNameDecl *TD = D->getTypedefNameForAnonDecl()) {
-      Buf[off] = 'A';
+      Out.overwrite(off, 'A');
       Out << '@' << *TD;
     }
     else {
@@ -446,7 +596,7 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
           else if(const TypedefDecl * TD = dyn_cast_or_null<clang::TypedefDecl>(D->getNextDeclInContext())){
             const QualType QT = unwrapTypeModifiers(TD->getUnderlyingType());
             if(QT->getAsTagDecl()->Equals(D)){
-              Buf[off] = 'A';
+              Out.overwrite(off, 'A');
               Out << '@';
               TD->printName(Out);
             }
@@ -457,99 +607,80 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
         } 
         else {
           // Completely anonymous tag decl.
-          Buf[off] = 'a';
+          Out.overwrite(off, 'a');
       }
     }
   }
 
   // For a class template specialization, mangle the template arguments.
-  if (const ClassTemplateSpecializationDecl *Spec
-                              = dyn_cast<ClassTemplateSpecializationDecl>(D)) {
-    const TemplateArgumentList &Args = Spec->getTemplateArgs();
-    Out << '>';
-    for (unsigned I = 0, N = Args.size(); I != N; ++I) {
-      Out << '#';
-      VisitTemplateArgument(Args.get(I));
+  only<USR_SPELLING>([&] {
+    if (const ClassTemplateSpecializationDecl *Spec
+                                = dyn_cast<ClassTemplateSpecializationDecl>(D)) {
+      const TemplateArgumentList &Args = Spec->getTemplateArgs();
+      Out << '>';
+      for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+        Out << '#';
+        VisitTemplateArgument(Args.get(I));
+      }
     }
-  }
+  });
 }
 
-void USRGenerator::VisitTypedefDecl(const TypedefDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitTypedefDecl(const TypedefDecl *D) {
   if (ShouldGenerateLocation(D) && GenLoc(D, /*IncludeOffset=*/isLocal(D)))
     return;
   const DeclContext *DC = D->getDeclContext();
   if (const NamedDecl *DCN = dyn_cast<NamedDecl>(DC))
-    Visit(DCN);
+    this->Visit(DCN);
   Out << "@T@";
   Out << D->getName();
 }
 
-void USRGenerator::VisitTemplateTypeParmDecl(const TemplateTypeParmDecl *D) {
-  GenLoc(D, /*IncludeOffset=*/true);
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitTemplateTypeParmDecl(const TemplateTypeParmDecl *D) {
+  only<USR_SPELLING>([&] { GenLoc(D, /*IncludeOffset=*/true); });
+  only<NSR_SPELLING>([&] { VisitNamedDecl(D); });
 }
 
-void USRGenerator::GenExtSymbolContainer(const NamedDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::GenExtSymbolContainer(const NamedDecl *D) {
   StringRef Container = GetExternalSourceContainer(D);
   if (!Container.empty())
     Out << "@M@" << Container;
 }
 
-bool USRGenerator::GenLoc(const Decl *D, bool IncludeOffset) {
-  llvm::outs() << "[DEBUG] GenLoc called for: " 
-               << (D ? D->getDeclKindName() : "null") 
-               << ", IncludeOffset: " << (IncludeOffset ? "true" : "false") 
-               << ", generatedLoc: " << (generatedLoc ? "true" : "false") 
-               << ", IgnoreResults: " << (IgnoreResults ? "true" : "false") << "\n";
-  
-  if (generatedLoc) {
-    llvm::outs() << "[DEBUG] GenLoc returning early because generatedLoc is true\n";
-    return IgnoreResults;
-  }
-  generatedLoc = true;
-
-  // Guard against null declarations in invalid code.
-  if (!D) {
-    llvm::outs() << "[DEBUG] GenLoc received null declaration\n";
-    IgnoreResults = true;
-    return true;
-  }
-
-  // Use the location of canonical decl.
-  D = D->getCanonicalDecl();
-
-  if (const NamedDecl *ND = dyn_cast<NamedDecl>(D)) {
-    llvm::outs() << "[DEBUG] GenLoc for named decl: " << ND->getNameAsString() << "\n";
+template <unsigned Spellings>
+bool RefGenerator<Spellings>::GenLoc(const Decl *D, bool IncludeOffset) {
+  // Runs before the spellings part, on the declaration and its contexts,
+  // so the active spellings agree on the result
+  bool Result = false;
+  for (unsigned I = 0; I != 2; ++I) {
+    if (!(Out.active() & (1u << I)))
+      continue;
+    SpellingStream::Only Spelling(Out, 1u << I);
+    if (!generatedLoc[I]) {
+      generatedLoc[I] = true;
+      // Guard against null declarations in invalid code.
+      // Use the location of canonical decl.
+      IgnoreResults[I] =
+          IgnoreResults[I] || !D ||
+          printLoc(Out, D->getCanonicalDecl()->getBeginLoc(),
+                   Context->getSourceManager(), IncludeOffset);
+    }
+    Result = IgnoreResults[I];
   }
-  
-  llvm::outs() << "[DEBUG] GenLoc calling printLoc with BeginLoc: " 
-               << (D->getBeginLoc().isValid() ? "valid" : "invalid") << "\n";
-  
-  bool PrevIgnoreResults = IgnoreResults;
-  IgnoreResults =
-      IgnoreResults || printLoc(Out, D->getBeginLoc(),
-                                Context->getSourceManager(), IncludeOffset);
-  
-  llvm::outs() << "[DEBUG] GenLoc after printLoc, IgnoreResults changed from " 
-               << (PrevIgnoreResults ? "true" : "false") 
-               << " to " << (IgnoreResults ? "true" : "false") << "\n";
-
-  return IgnoreResults;
-}
-
-static void printQualifier(llvm::raw_ostream &Out, ASTContext &Ctx, NestedNameSpecifier *NNS) {
-  // FIXME: Encode the qualifier, don't just print it.
-  PrintingPolicy PO(Ctx.getLangOpts());
-  PO.SuppressTagKeyword = true;
-  PO.SuppressUnwrittenScope = true;
-  PO.ConstantArraySizeAsWritten = false;
-  PO.AnonymousTagLocations = false;
-  NNS->print(Out, PO);
+  return Result;
 }
 
-void USRGenerator::VisitType(QualType T) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitType(QualType T) {
   // This method mangles in USR information for types.  It can possibly
   // just reuse the naming-mangling logic used by codegen, although the
   // requirements for USRs might not be the same.
+  // Declarations only reach it from the USR-only parts; the NSR of a type
+  // skips the template specialization arguments the USR spells
+  assert(Out.active() != (USR_SPELLING | NSR_SPELLING) && "types are spelled for one spelling at a time");
   ASTContext &Ctx = *Context;
 
   do {
@@ -674,7 +805,7 @@ void USRGenerator::VisitType(QualType T) {
         case BuiltinType::SatUFract:
         case BuiltinType::SatULongFract:
         case BuiltinType::BFloat16:
-          IgnoreResults = true;
+          setIgnored();
           return;
         case BuiltinType::ObjCId:
           break;
@@ -747,14 +878,18 @@ void USRGenerator::VisitType(QualType T) {
       Out << 't' << TTP->getDepth() << '.' << TTP->getIndex();
       return;
     }
-    if (const TemplateSpecializationType *Spec
-                                    = T->getAs<TemplateSpecializationType>()) {
-      Out << '>';
-      VisitTemplateName(Spec->getTemplateName());
-      Out << Spec->getNumArgs();
-      for (unsigned I = 0, N = Spec->getNumArgs(); I != N; ++I)
-        VisitTemplateArgument(Spec->getArg(I));
-      return;
+    if constexpr ((Spellings & USR_SPELLING) != 0) {
+      if (Out.active() & USR_SPELLING) {
+        if (const TemplateSpecializationType *Spec
+                                        = T->getAs<TemplateSpecializationType>()) {
+          Out << '>';
+          VisitTemplateName(Spec->getTemplateName());
+          Out << Spec->getNumArgs();
+          for (unsigned I = 0, N = Spec->getNumArgs(); I != N; ++I)
+            VisitTemplateArgument(Spec->getArg(I));
+          return;
+        }
+      }
     }
     if (const DependentNameType *DNT = T->getAs<DependentNameType>()) {
       Out << '^';
@@ -798,7 +933,8 @@ void USRGenerator::VisitType(QualType T) {
   } while (true);
 }
 
-void USRGenerator::VisitTemplateParameterList(
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitTemplateParameterList(
                                          const TemplateParameterList *Params) {
   if (!Params)
     return;
@@ -830,7 +966,8 @@ void USRGenerator::VisitTemplateParameterList(
   }
 }
 
-void USRGenerator::VisitTemplateName(TemplateName Name) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitTemplateName(TemplateName Name) {
   if (TemplateDecl *Template = Name.getAsTemplateDecl()) {
     if (TemplateTemplateParmDecl *TTP
                               = dyn_cast<TemplateTemplateParmDecl>(Template)) {
@@ -838,20 +975,21 @@ void USRGenerator::VisitTemplateName(TemplateName Name) {
       return;
     }
 
-    Visit(Template);
+    this->Visit(Template);
     return;
   }
 
   // FIXME: Visit dependent template names.
 }
 
-void USRGenerator::VisitTemplateArgument(const TemplateArgument &Arg) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitTemplateArgument(const TemplateArgument &Arg) {
   switch (Arg.getKind()) {
   case TemplateArgument::Null:
     break;
 
   case TemplateArgument::Declaration:
-    Visit(Arg.getAsDecl());
+    this->Visit(Arg.getAsDecl());
     break;
 
   case TemplateArgument::NullPtr:
@@ -886,7 +1024,8 @@ void USRGenerator::VisitTemplateArgument(const TemplateArgument &Arg) {
   }
 }
 
-void USRGenerator::VisitUnresolvedUsingValueDecl(const UnresolvedUsingValueDecl *D) {
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitUnresolvedUsingValueDecl(const UnresolvedUsingValueDecl *D) {
   if (ShouldGenerateLocation(D) && GenLoc(D, /*IncludeOffset=*/isLocal(D)))
     return;
   VisitDeclContext(D->getDeclContext());
@@ -895,13 +1034,18 @@ void USRGenerator::VisitUnresolvedUsingValueDecl(const UnresolvedUsingValueDecl
   EmitDeclName(D);
 }
 
-void USRGenerator::VisitUnresolvedUsingTypenameDecl(const UnresolvedUsingTypenameDecl *D) {
-  if (ShouldGenerateLocation(D) && GenLoc(D, /*IncludeOffset=*/isLocal(D)))
-    return;
-  VisitDeclContext(D->getDeclContext());
-  Out << "@UUT@";
-  printQualifier(Out, D->getASTContext(), D->getQualifier());
-  Out << D->getName(); // Simple name.
+template <unsigned Spellings>
+void RefGenerator<Spellings>::VisitUnresolvedUsingTypenameDecl(const UnresolvedUsingTypenameDecl *D) {
+  only<USR_SPELLING>([&] {
+    if (ShouldGenerateLocation(D) && GenLoc(D, /*IncludeOffset=*/isLocal(D)))
+      return;
+    VisitDeclContext(D->getDeclContext());
+    Out << "@UUT@";
+    printQualifier(Out, D->getASTContext(), D->getQualifier());
+    Out << D->getName(); // Simple name.
+  });
+  // NSRs spell it as any other named declaration
+  only<NSR_SPELLING>([&] { VisitNamedDecl(D); });
 }
 
 //===----------------------------------------------------------------------===//
@@ -928,9 +1072,20 @@ bool generateUSRForDecl(const Decl *D,
   // C++'s operator new function, can have invalid locations but it is fine to
   // create USRs that can identify them.
 
-  USRGenerator UG(&D->getASTContext(), Buf);
+  RefGenerator<USR_SPELLING> UG(&D->getASTContext(), &Buf, nullptr);
   UG.Visit(D);
-  return UG.ignoreResults();
+  return UG.ignoreResults(USR_SPELLING);
+}
+
+std::pair<bool, bool> generateUSRAndNSRForDecl(const Decl *D,
+                                               SmallVectorImpl<char> &USRBuf,
+                                               SmallVectorImpl<char> &NSRBuf) {
+  if (!D)
+    return {true, true};
+
+  RefGenerator<USR_SPELLING | NSR_SPELLING> UG(&D->getASTContext(), &USRBuf, &NSRBuf);
+  UG.Visit(D);
+  return {UG.ignoreResults(USR_SPELLING), UG.ignoreResults(NSR_SPELLING)};
 }
 
 bool generateUSRForMacro(const MacroDefinitionRecord *MD,
@@ -969,9 +1124,56 @@ bool generateUSRForType(QualType T, ASTContext &Ctx,
     return true;
   T = T.getCanonicalType();
 
-  USRGenerator UG(&Ctx, Buf);
+  RefGenerator<USR_SPELLING> UG(&Ctx, &Buf, nullptr);
+  UG.VisitType(T);
+  return UG.ignoreResults(USR_SPELLING);
+}
+
+//===----------------------------------------------------------------------===//
+// NSR generation functions.
+//===----------------------------------------------------------------------===//
+
+void generateNSRForGlobalEnum(StringRef EnumName, raw_ostream &OS,
+                                            StringRef ExtSymDefinedIn) {
+  generateUSRForGlobalEnum(EnumName, OS, ExtSymDefinedIn);
+}
+
+void generateNSRForEnumConstant(StringRef EnumConstantName,
+                                              raw_ostream &OS) {
+  generateUSRForEnumConstant(EnumConstantName, OS);
+}
+
+bool generateNSRForDecl(const Decl *D,
+                                      SmallVectorImpl<char> &Buf) {
+  if (!D)
+    return true;
+
+  RefGenerator<NSR_SPELLING> UG(&D->getASTContext(), nullptr, &Buf);
+  UG.Visit(D);
+  return UG.ignoreResults(NSR_SPELLING);
+}
+
+bool generateNSRForMacro(const MacroDefinitionRecord *MD,
+                                       const SourceManager &SM,
+                                       SmallVectorImpl<char> &Buf) {
+  return generateUSRForMacro(MD, SM, Buf);
+}
+
+bool generateNSRForMacro(StringRef MacroName, SourceLocation Loc,
+                                       const SourceManager &SM,
+                                       SmallVectorImpl<char> &Buf) {
+  return generateUSRForMacro(MacroName, Loc, SM, Buf);
+}
+
+bool generateNSRForType(QualType T, ASTContext &Ctx,
+                                      SmallVectorImpl<char> &Buf) {
+  if (T.isNull())
+    return true;
+  T = T.getCanonicalType();
+
+  RefGenerator<NSR_SPELLING> UG(&Ctx, nullptr, &Buf);
   UG.VisitType(T);
-  return UG.ignoreResults();
+  return UG.ignoreResults(NSR_SPELLING);
 }
 
-} // namespace armor
\ No newline at end of file
+} // namespace armor
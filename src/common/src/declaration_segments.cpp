@@ -0,0 +1,783 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/xxhash.h"
+
+#include "declaration_segments.hpp"
+
+namespace {
+
+    struct Token {
+        llvm::StringRef text;
+        unsigned line;
+        // A whole preprocessor directive, with its splices and comments
+        bool directive;
+    };
+
+    bool isIdentifierByte(unsigned char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' ||
+               c >= 0x80;
+    }
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    // Whether the newline at `newline` continues the line, after a backslash and blanks
+    bool isSpliced(llvm::StringRef text, size_t newline) {
+        return text.substr(0, newline).rtrim(" \t\r").endswith("\\");
+    }
+
+    // End of the string or character literal opening at `begin`; an unterminated one ends with its line
+    size_t literalEnd(llvm::StringRef text, size_t begin) {
+        char quote = text[begin];
+        size_t i = begin + 1;
+        while (i < text.size() && text[i] != quote && text[i] != '\n') {
+            i += text[i] == '\\' ? 2 : 1;
+        }
+        return std::min(text.size(), i + 1);
+    }
+
+    // End of the raw string literal whose quote is at `quote`: R"delim( ... )delim"
+    size_t rawStringEnd(llvm::StringRef text, size_t quote) {
+        size_t open = text.find('(', quote);
+        if (open == llvm::StringRef::npos) {
+            return literalEnd(text, quote);
+        }
+        std::string close = ")" + text.slice(quote + 1, open).str() + "\"";
+        size_t end = text.find(close, open);
+        return end == llvm::StringRef::npos ? text.size() : end + close.size();
+    }
+
+    // The newline ending the line comment at `begin`, or the end of the text
+    size_t lineCommentEnd(llvm::StringRef text, size_t begin) {
+        size_t newline = text.find('\n', begin);
+        while (newline != llvm::StringRef::npos && isSpliced(text, newline)) {
+            newline = text.find('\n', newline + 1);
+        }
+        return newline == llvm::StringRef::npos ? text.size() : newline;
+    }
+
+    size_t blockCommentEnd(llvm::StringRef text, size_t begin) {
+        size_t close = text.find("*/", begin + 2);
+        return close == llvm::StringRef::npos ? text.size() : close + 2;
+    }
+
+    // The newline ending the directive at `begin`, past splices and comments spanning lines
+    size_t directiveEnd(llvm::StringRef text, size_t begin) {
+        size_t i = begin;
+        while (i < text.size()) {
+            char c = text[i];
+            if (c == '\n') {
+                if (!isSpliced(text, i)) {
+                    return i;
+                }
+                ++i;
+            }
+            else if (c == '/' && text.substr(i).startswith("/*")) {
+                i = blockCommentEnd(text, i);
+            }
+            else if (c == '/' && text.substr(i).startswith("//")) {
+                return lineCommentEnd(text, i);
+            }
+            else if (c == '"' || c == '\'') {
+                i = literalEnd(text, i);
+            }
+            else {
+                ++i;
+            }
+        }
+        return i;
+    }
+
+    bool isRawStringPrefix(llvm::StringRef prefix) {
+        return prefix == "R" || prefix == "u8R" || prefix == "uR" || prefix == "UR" || prefix == "LR";
+    }
+
+    // Cuts `text` into tokens: identifiers and numbers, literals, `::` and single punctuators,
+    // and whole directives; comments, whitespace and line splices are dropped
+    std::vector<Token> lex(llvm::StringRef text) {
+        std::vector<Token> tokens;
+        unsigned line = 1;
+        bool atLineStart = true;
+        size_t i = 0;
+        while (i < text.size()) {
+            char c = text[i];
+            size_t start = i;
+            if (c == '\n') {
+                ++line;
+                atLineStart = true;
+                ++i;
+                continue;
+            }
+            if (isBlank(c)) {
+                ++i;
+                continue;
+            }
+            if (c == '\\') {
+                size_t next = i + 1;
+                while (next < text.size() && isBlank(text[next])) {
+                    ++next;
+                }
+                if (next < text.size() && text[next] == '\n') {
+                    ++line;
+                    i = next + 1;
+                    continue;
+                }
+            }
+            if (c == '/' && text.substr(i).startswith("//")) {
+                i = lineCommentEnd(text, i);
+                line += text.slice(start, i).count('\n');
+                continue;
+            }
+            if (c == '/' && text.substr(i).startswith("/*")) {
+                i = blockCommentEnd(text, i);
+                line += text.slice(start, i).count('\n');
+                continue;
+            }
+
+            bool directive = atLineStart && (c == '#' || text.substr(i).startswith("%:"));
+            atLineStart = false;
+            if (directive) {
+                i = directiveEnd(text, i);
+            }
+            else if (c == '"' || c == '\'') {
+                i = literalEnd(text, i);
+            }
+            else if (isIdentifierByte(c) || (c == '.' && i + 1 < text.size() && isDigit(text[i + 1]))) {
+                // pp-numbers take the sign of an exponent, as in 1e+5
+                bool number = isDigit(c) || c == '.';
+                ++i;
+                while (i < text.size() &&
+                       (isIdentifierByte(text[i]) ||
+                        (number && (text[i] == '.' || text[i] == '\'' ||
+                                    ((text[i] == '+' || text[i] == '-') && llvm::StringRef("eEpP").contains(text[i - 1])))))) {
+                    ++i;
+                }
+                if (i < text.size() && text[i] == '"' && isRawStringPrefix(text.slice(start, i))) {
+                    i = rawStringEnd(text, i);
+                }
+                else if (i < text.size() && (text[i] == '"' || text[i] == '\'') && !number) {
+                    // Encoding prefixes and the literals they qualify are one token: u8"s", L'c'
+                    llvm::StringRef prefix = text.slice(start, i);
+                    if (prefix == "u8" || prefix == "u" || prefix == "U" || prefix == "L") {
+                        i = literalEnd(text, i);
+                    }
+                }
+            }
+            else if (c == ':' && text.substr(i).startswith("::")) {
+                i += 2;
+            }
+            else {
+                ++i;
+            }
+            tokens.push_back({text.slice(start, i), line, directive});
+            line += tokens.back().text.count('\n');
+        }
+        return tokens;
+    }
+
+    // A directive with its comments, splices and runs of whitespace each turned into one space
+    std::string normalizeDirective(llvm::StringRef text) {
+        std::string out;
+        bool space = false;
+        size_t i = 0;
+        while (i < text.size()) {
+            char c = text[i];
+            size_t next = i + 1;
+            if (c == '/' && text.substr(i).startswith("/*")) {
+                next = blockCommentEnd(text, i);
+            }
+            else if (c == '/' && text.substr(i).startswith("//")) {
+                next = text.size();
+            }
+            else if (c == '\\' && text.substr(i + 1).ltrim(" \t\r").startswith("\n")) {
+                next = text.find('\n', i) + 1;
+            }
+            else if (!isBlank(c) && c != '\n') {
+                if (c == '"' || c == '\'') {
+                    next = literalEnd(text, i);
+                }
+                if (space && !out.empty()) {
+                    out += ' ';
+                }
+                out.append(text.data() + i, next - i);
+                space = false;
+                i = next;
+                continue;
+            }
+            space = true;
+            i = next;
+        }
+        // "# define" and "%:define" are #define
+        llvm::StringRef body = llvm::StringRef(out);
+        if (!body.consume_front("#")) {
+            body.consume_front("%:");
+        }
+        return "#" + body.ltrim(' ').str();
+    }
+
+    // Names no declaration can have: keywords, and the specifiers and attributes of common compilers
+    const llvm::StringSet<>& keywords() {
+        static const llvm::StringSet<> sKeywords = {
+            "alignas", "alignof", "asm", "auto", "bool", "char", "char8_t", "char16_t", "char32_t", "class",
+            "const", "consteval", "constexpr", "constinit", "decltype", "delete", "double", "enum", "explicit",
+            "export", "extern", "false", "final", "float", "friend", "inline", "int", "long", "mutable",
+            "namespace", "noexcept", "nullptr", "operator", "override", "register", "requires", "return", "short",
+            "signed", "sizeof", "static", "static_assert", "struct", "template", "thread_local", "throw", "true",
+            "typedef", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+            "_Alignas", "_Alignof", "_Atomic", "_Bool", "_Complex", "_Noreturn", "_Static_assert", "_Thread_local",
+            "__attribute__", "__declspec", "__extension__", "__inline", "__inline__", "__restrict", "__restrict__",
+            "restrict", "__typeof__", "typeof", "__asm__", "__asm", "__cdecl", "__stdcall", "__fastcall"};
+        return sKeywords;
+    }
+
+    bool isName(llvm::StringRef token) {
+        return !token.empty() && isIdentifierByte(token[0]) && !isDigit(token[0]) && !keywords().contains(token);
+    }
+
+    bool isTagKeyword(llvm::StringRef token) {
+        return token == "struct" || token == "class" || token == "union" || token == "enum";
+    }
+
+    // Tokens spelled back as source, a space only between two words
+    std::string spell(llvm::ArrayRef<llvm::StringRef> tokens) {
+        std::string out;
+        for (llvm::StringRef token : tokens) {
+            if (!out.empty() && isIdentifierByte(out.back()) && isIdentifierByte(token.front())) {
+                out += ' ';
+            }
+            out += token.str();
+        }
+        return out;
+    }
+
+    /**
+     * Names one declaration from its tokens, directives left out. Depths
+     * count the parentheses, brackets and braces open before each token;
+     * only tokens at depth 0 name it.
+     */
+    class DeclarationNamer {
+        public:
+            explicit DeclarationNamer(std::vector<llvm::StringRef> tokens) : toks(std::move(tokens)) {
+                int open = 0;
+                for (llvm::StringRef token : toks) {
+                    if (token == ")" || token == "]" || token == "}") {
+                        open = std::max(0, open - 1);
+                    }
+                    depth.push_back(open);
+                    if (token == "(" || token == "[" || token == "{") {
+                        ++open;
+                    }
+                }
+            }
+
+            // Sets `name` and `kind`
+            void describe(std::string& name, std::string& kind) const {
+                if (toks.empty()) {
+                    return;
+                }
+                if (toks[0] == "using") {
+                    if (toks.size() > 3 && toks[2] == "=") {
+                        name = toks[1].str();
+                        kind = "alias";
+                    }
+                    else {
+                        name = spell(llvm::ArrayRef<llvm::StringRef>(toks).slice(1, statementEnd() - 1));
+                        kind = "using";
+                    }
+                    return;
+                }
+                bool typedefs = false;
+                for (size_t i = 0; i < toks.size(); ++i) {
+                    typedefs |= depth[i] == 0 && toks[i] == "typedef";
+                }
+                if (!typedefs && tagName(name, kind)) {
+                    return;
+                }
+                if (functionOrDeclarator(name, kind)) {
+                    if (typedefs) {
+                        kind = "typedef";
+                    }
+                    return;
+                }
+                name = declaratorName();
+                if (!name.empty()) {
+                    kind = typedefs ? "typedef" : "variable";
+                    return;
+                }
+                // static_assert and whatever else declares no name: named by its text
+                kind = "declaration";
+                name = spell(llvm::ArrayRef<llvm::StringRef>(toks).take_front(statementEnd()));
+                if (name.size() > 80) {
+                    name = name.substr(0, 77) + "...";
+                }
+            }
+
+        private:
+            // Index of the closing `;`, or the token count
+            size_t statementEnd() const {
+                return toks.back() == ";" ? toks.size() - 1 : toks.size();
+            }
+
+            // Past `template <...>`, `extern template` and attributes starting at `i`
+            size_t skipPreamble(size_t i) const {
+                while (i < toks.size()) {
+                    if (toks[i] == "template" && i + 1 < toks.size() && toks[i + 1] == "<") {
+                        int angles = 0;
+                        for (++i; i < toks.size(); ++i) {
+                            angles += toks[i] == "<" ? 1 : toks[i] == ">" ? -1 : 0;
+                            if (angles == 0) {
+                                break;
+                            }
+                        }
+                        ++i;
+                    }
+                    else if (toks[i] == "extern" || toks[i] == "template" || toks[i] == "export") {
+                        ++i;
+                    }
+                    else if (i + 1 < toks.size() && toks[i + 1] == "(" &&
+                             (toks[i] == "__attribute__" || toks[i] == "__declspec" || toks[i] == "alignas")) {
+                        i = closing(i + 1) + 1;
+                    }
+                    else if (toks[i] == "[" && i + 1 < toks.size() && toks[i + 1] == "[") {
+                        i = closing(i) + 1;
+                    }
+                    else {
+                        break;
+                    }
+                }
+                return i;
+            }
+
+            // The bracket closing the one at `open`
+            size_t closing(size_t open) const {
+                for (size_t i = open + 1; i < toks.size(); ++i) {
+                    if (depth[i] == depth[open] && (toks[i] == ")" || toks[i] == "]" || toks[i] == "}")) {
+                        return i;
+                    }
+                }
+                return toks.size() - 1;
+            }
+
+            // A name and the `::` qualifiers spelled before its last token at `end`
+            std::string qualifiedBefore(size_t end) const {
+                size_t begin = end;
+                while (begin >= 2 && toks[begin - 1] == "::" && isName(toks[begin - 2])) {
+                    begin -= 2;
+                }
+                if (begin >= 1 && toks[begin - 1] == "~") {
+                    --begin;
+                }
+                return spell(llvm::ArrayRef<llvm::StringRef>(toks).slice(begin, end - begin + 1));
+            }
+
+            // A struct, class, union or enum defined or declared without a declarator
+            bool tagName(std::string& name, std::string& kind) const {
+                size_t i = skipPreamble(0);
+                if (i >= toks.size() || !isTagKeyword(toks[i])) {
+                    return false;
+                }
+                llvm::StringRef tag = toks[i++];
+                if (tag == "enum" && i < toks.size() && (toks[i] == "class" || toks[i] == "struct")) {
+                    ++i;
+                }
+                i = skipPreamble(i);
+                if (i >= toks.size() || !isName(toks[i])) {
+                    return false;
+                }
+                size_t last = i;
+                while (last + 2 < toks.size() && toks[last + 1] == "::" && isName(toks[last + 2])) {
+                    last += 2;
+                }
+                size_t next = last + 1;
+                // The arguments of a specialization are part of its name
+                if (next < toks.size() && toks[next] == "<") {
+                    int angles = 0;
+                    for (; next < toks.size(); ++next) {
+                        angles += toks[next] == "<" ? 1 : toks[next] == ">" ? -1 : 0;
+                        if (angles == 0) {
+                            break;
+                        }
+                    }
+                    ++next;
+                }
+                if (next < toks.size() && toks[next] == "final") {
+                    ++next;
+                }
+                if (next >= toks.size() ||
+                    (toks[next] != "{" && toks[next] != ":" && toks[next] != ";")) {
+                    return false;
+                }
+                name = spell(llvm::ArrayRef<llvm::StringRef>(toks).slice(i, std::min(next, toks.size()) - i));
+                kind = tag.str();
+                return true;
+            }
+
+            // The name inside a declarator in parentheses, as of `int (*handler)(int)`
+            std::optional<size_t> parenthesizedName(size_t open) const {
+                size_t i = open + 1;
+                while (i < toks.size()) {
+                    if (toks[i] == "*" || toks[i] == "^" || toks[i] == "&" || toks[i] == "const" ||
+                        toks[i] == "volatile" || (isName(toks[i]) && i + 1 < toks.size() && toks[i + 1] == "*")) {
+                        ++i;
+                    }
+                    else if (toks[i] == "(") {
+                        open = i++;
+                    }
+                    else {
+                        break;
+                    }
+                }
+                if (i + 1 < toks.size() && isName(toks[i]) &&
+                    (toks[i + 1] == ")" || toks[i + 1] == "[" || toks[i + 1] == "(")) {
+                    return i;
+                }
+                return std::nullopt;
+            }
+
+            /*
+                Functions, by the name before the first parameter list, and
+                declarators in parentheses. The list is the first parenthesis
+                at depth 0 after a name, other than of an attribute or
+                specifier; an `=` before it makes the declaration a variable.
+            */
+            bool functionOrDeclarator(std::string& name, std::string& kind) const {
+                for (size_t i = skipPreamble(0); i < toks.size(); ++i) {
+                    if (depth[i] != 0) {
+                        continue;
+                    }
+                    llvm::StringRef token = toks[i];
+                    if (token == "=" || token == ";" || token == "{") {
+                        return false;
+                    }
+                    if (token == "operator") {
+                        // operator() lists its parameters after its own parentheses
+                        size_t end = i + 1;
+                        if (end + 1 < toks.size() && toks[end] == "(" && toks[end + 1] == ")") {
+                            end += 2;
+                        }
+                        while (end < toks.size() && toks[end] != "(") {
+                            ++end;
+                        }
+                        std::string qualifier = i >= 2 && toks[i - 1] == "::" ? qualifiedBefore(i - 2) + "::" : "";
+                        name = qualifier + spell(llvm::ArrayRef<llvm::StringRef>(toks).slice(i, end - i));
+                        kind = "function";
+                        return true;
+                    }
+                    if (token != "(") {
+                        continue;
+                    }
+                    if (std::optional<size_t> inner = parenthesizedName(i)) {
+                        name = qualifiedBefore(*inner);
+                        kind = toks[*inner + 1] == "(" ? "function" : "variable";
+                        return true;
+                    }
+                    if (i > 0 && isName(toks[i - 1])) {
+                        name = qualifiedBefore(i - 1);
+                        kind = "function";
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // The last name at depth 0 before the first declarator ends, as of `int count = 0;`
+            std::string declaratorName() const {
+                std::optional<size_t> last;
+                for (size_t i = skipPreamble(0); i < toks.size(); ++i) {
+                    if (depth[i] != 0) {
+                        continue;
+                    }
+                    llvm::StringRef token = toks[i];
+                    if (token == "," || token == ";" || token == "=" || token == "[" || token == ":" ||
+                        (token == "{" && last && *last + 1 == i)) {
+                        break;
+                    }
+                    if (isName(token)) {
+                        last = i;
+                    }
+                }
+                return last ? qualifiedBefore(*last) : std::string();
+            }
+
+            std::vector<llvm::StringRef> toks;
+            std::vector<int> depth;
+    };
+
+    /**
+     * Cuts the tokens of a header into top-level declarations, see
+     * segmentDeclarations. Braces of namespaces and extern blocks are
+     * entered; any others are kept whole in the declaration they open in.
+     */
+    class Segmenter {
+        public:
+            explicit Segmenter(const std::vector<Token>& tokens) : tokens(tokens) {}
+
+            std::vector<armor::DeclarationSegment> run() {
+                for (size_t i = 0; i < tokens.size(); ++i) {
+                    const Token& token = tokens[i];
+                    llvm::StringRef text = token.text;
+                    if (token.directive) {
+                        if (current.empty()) {
+                            emitDirective(token);
+                        }
+                        else {
+                            current.push_back(&token);
+                        }
+                        continue;
+                    }
+                    if (text == "(" || text == "[") {
+                        ++open;
+                    }
+                    else if ((text == ")" || text == "]") && open > 0) {
+                        --open;
+                    }
+                    else if (text == "{") {
+                        if (open == 0) {
+                            if (std::optional<std::string> scope = enteredScope()) {
+                                scopes.push_back(std::move(*scope));
+                                current.clear();
+                                continue;
+                            }
+                        }
+                        size_t head = current.size();
+                        i = appendBlock(i);
+                        if (open == 0 && isFunctionBody(head)) {
+                            emit();
+                        }
+                        continue;
+                    }
+                    else if (text == "}") {
+                        // Closes a namespace or extern block, and a declaration left open in it
+                        if (!current.empty()) {
+                            emit();
+                        }
+                        if (!scopes.empty()) {
+                            scopes.pop_back();
+                        }
+                        continue;
+                    }
+                    current.push_back(&token);
+                    if (text == ";" && open == 0) {
+                        emit();
+                    }
+                }
+                if (!current.empty()) {
+                    emit();
+                }
+                return std::move(segments);
+            }
+
+        private:
+            std::vector<llvm::StringRef> words(size_t count) const {
+                std::vector<llvm::StringRef> result;
+                for (size_t i = 0; i < count; ++i) {
+                    if (!current[i]->directive) {
+                        result.push_back(current[i]->text);
+                    }
+                }
+                return result;
+            }
+
+            // The name of the namespace or extern block the current tokens open, if they do
+            std::optional<std::string> enteredScope() const {
+                std::vector<llvm::StringRef> head = words(current.size());
+                if (head.size() == 2 && head[0] == "extern" && head[1].startswith("\"")) {
+                    return std::string();
+                }
+                size_t i = !head.empty() && head[0] == "inline" ? 1 : 0;
+                if (i >= head.size() || head[i] != "namespace") {
+                    return std::nullopt;
+                }
+                if (i + 1 == head.size()) {
+                    return std::string("(anonymous namespace)");
+                }
+                for (size_t j = i + 1; j < head.size(); ++j) {
+                    if (!(isName(head[j]) || head[j] == "::")) {
+                        return std::nullopt;
+                    }
+                }
+                return spell(llvm::ArrayRef<llvm::StringRef>(head).drop_front(i + 1));
+            }
+
+            // Appends the block opening at `open` to the current declaration; returns its closing brace
+            size_t appendBlock(size_t open) {
+                int depth = 0;
+                size_t i = open;
+                for (; i < tokens.size(); ++i) {
+                    current.push_back(&tokens[i]);
+                    if (tokens[i].directive) {
+                        continue;
+                    }
+                    depth += tokens[i].text == "{" ? 1 : tokens[i].text == "}" ? -1 : 0;
+                    if (depth == 0) {
+                        break;
+                    }
+                }
+                return std::min(i, tokens.size() - 1);
+            }
+
+            // Whether the block after the first `head` tokens is a function body, which ends the declaration
+            bool isFunctionBody(size_t head) const {
+                std::string name;
+                std::string kind;
+                std::vector<llvm::StringRef> before = words(head);
+                before.push_back(";");
+                DeclarationNamer(std::move(before)).describe(name, kind);
+                return kind == "function";
+            }
+
+            std::string scopePrefix() const {
+                std::string prefix;
+                for (const std::string& scope : scopes) {
+                    if (!scope.empty()) {
+                        prefix += scope + "::";
+                    }
+                }
+                return prefix;
+            }
+
+            void emit() {
+                std::vector<llvm::StringRef> tokenTexts;
+                std::string hashed;
+                for (const Token* token : current) {
+                    if (token->directive) {
+                        hashed += normalizeDirective(token->text);
+                    }
+                    else {
+                        tokenTexts.push_back(token->text);
+                        hashed += token->text.str();
+                    }
+                    hashed += '\x01';
+                }
+                armor::DeclarationSegment segment;
+                DeclarationNamer(tokenTexts).describe(segment.name, segment.kind);
+                segment.name = scopePrefix() + segment.name;
+                segment.hash = llvm::xxHash64(hashed);
+                segment.line = current.front()->line;
+                // A stray semicolon declares nothing
+                if (!(tokenTexts.size() == 1 && tokenTexts[0] == ";")) {
+                    segments.push_back(std::move(segment));
+                }
+                current.clear();
+                open = 0;
+            }
+
+            void emitDirective(const Token& token) {
+                armor::DeclarationSegment segment;
+                std::string text = normalizeDirective(token.text);
+                llvm::StringRef rest(text);
+                if (rest.consume_front("#define ")) {
+                    size_t end = 0;
+                    while (end < rest.size() && isIdentifierByte(rest[end])) {
+                        ++end;
+                    }
+                    segment.name = rest.take_front(end).str();
+                    segment.kind = "macro";
+                }
+                else {
+                    segment.name = text;
+                    segment.kind = "directive";
+                }
+                segment.hash = llvm::xxHash64(text);
+                segment.line = token.line;
+                segments.push_back(std::move(segment));
+            }
+
+            const std::vector<Token>& tokens;
+            std::vector<const Token*> current;
+            // Parentheses and brackets open in the current declaration
+            unsigned open = 0;
+            // Namespaces entered, empty for extern blocks
+            std::vector<std::string> scopes;
+            std::vector<armor::DeclarationSegment> segments;
+    };
+
+    void sortByLine(std::vector<armor::DeclarationSegment>& segments) {
+        std::stable_sort(segments.begin(), segments.end(),
+                         [](const armor::DeclarationSegment& lhs, const armor::DeclarationSegment& rhs) {
+                             return lhs.line < rhs.line;
+                         });
+    }
+
+}
+
+std::vector<armor::DeclarationSegment> armor::segmentDeclarations(llvm::StringRef text) {
+    std::vector<Token> tokens = lex(text);
+    return Segmenter(tokens).run();
+}
+
+armor::QuickDiff armor::quickDiff(llvm::StringRef text1, llvm::StringRef text2) {
+    std::vector<DeclarationSegment> older = segmentDeclarations(text1);
+    std::vector<DeclarationSegment> newer = segmentDeclarations(text2);
+
+    // Per kind and name, the declarations of each version in line order
+    llvm::StringMap<std::pair<std::vector<size_t>, std::vector<size_t>>> byKey;
+    for (size_t i = 0; i < older.size(); ++i) {
+        byKey[older[i].kind + '\0' + older[i].name].first.push_back(i);
+    }
+    for (size_t i = 0; i < newer.size(); ++i) {
+        byKey[newer[i].kind + '\0' + newer[i].name].second.push_back(i);
+    }
+
+    QuickDiff diff;
+    for (auto& entry : byKey) {
+        std::vector<size_t>& before = entry.getValue().first;
+        std::vector<size_t>& after = entry.getValue().second;
+        // Equal declarations pair off first, by a merge of both sides sorted by hash
+        auto byHash = [](const std::vector<DeclarationSegment>& segments) {
+            return [&segments](size_t lhs, size_t rhs) {
+                return segments[lhs].hash != segments[rhs].hash ? segments[lhs].hash < segments[rhs].hash
+                                                                : lhs < rhs;
+            };
+        };
+        std::sort(before.begin(), before.end(), byHash(older));
+        std::sort(after.begin(), after.end(), byHash(newer));
+        std::vector<size_t> leftBefore;
+        std::vector<size_t> leftAfter;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < before.size() || j < after.size()) {
+            if (j == after.size() || (i < before.size() && older[before[i]].hash < newer[after[j]].hash)) {
+                leftBefore.push_back(before[i++]);
+            }
+            else if (i == before.size() || newer[after[j]].hash < older[before[i]].hash) {
+                leftAfter.push_back(after[j++]);
+            }
+            else {
+                ++i;
+                ++j;
+            }
+        }
+        // The rest pair in order; those left over were removed or added
+        std::sort(leftBefore.begin(), leftBefore.end());
+        std::sort(leftAfter.begin(), leftAfter.end());
+        size_t paired = std::min(leftBefore.size(), leftAfter.size());
+        for (size_t k = 0; k < paired; ++k) {
+            diff.modified.push_back(newer[leftAfter[k]]);
+        }
+        for (size_t k = paired; k < leftBefore.size(); ++k) {
+            diff.removed.push_back(older[leftBefore[k]]);
+        }
+        for (size_t k = paired; k < leftAfter.size(); ++k) {
+            diff.added.push_back(newer[leftAfter[k]]);
+        }
+    }
+    sortByLine(diff.added);
+    sortByLine(diff.removed);
+    sortByLine(diff.modified);
+    return diff;
+}
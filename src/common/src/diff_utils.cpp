@@ -1,52 +1,31 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 #include "diff_utils.hpp"
+#include <algorithm>
+#include <limits>
 #include <llvm-14/llvm/ADT/SmallString.h>
 #include <llvm-14/llvm/Support/raw_ostream.h>
 
-std::string DATA_TYPE_PLACE_HOLDER = "(un-resolved Type)";
-
-std::string ADDED = "added";
-std::string REMOVED = "removed";
-std::string MODIFIED = "modified";
-std::string REORDERED = "re-ordered";
-
-// JSON keys
-std::string QUALIFIED_NAME = "qualifiedName";
-std::string NODE_TYPE = "nodeType";
-std::string TAG = "tag";
-std::string CHILDREN = "children";
-std::string DATA_TYPE = "dataType";
-std::string STORAGE_QUALIFIER = "storageQualifier";
-std::string CONST_QUALIFIER = "constQualifier";
-std::string VIRTUAL_QUALIFIER = "virtualQualifier";
-std::string INLINE = "inline";
-std::string PARSED_STATUS = "parsed_status";
-std::string UNPARSED_STATUS = "unparsed_status";
-std::string HEADER_RESOLUTION_FAILURES = "headerResolutionFailures";
-std::string AST_DIFF = "astDiff";
-std::string CONST_EXPR = "constexpr";
-
-const std::string serialize(const APINodeStorageClass& storageClass) {
+const char* serialize(const APINodeStorageClass& storageClass) {
     switch (storageClass) {
         case APINodeStorageClass::Static:   return "Static";
         case APINodeStorageClass::Extern:   return "Extern";
         case APINodeStorageClass::Register: return "Register";
         case APINodeStorageClass::Auto:     return "Auto";
-        default:                            return std::string{};
+        default:                            return "";
     }
 }
 
-const std::string serialize(const VirtualQualifier& qualifier) {
+const char* serialize(const VirtualQualifier& qualifier) {
     switch (qualifier) {
         case VirtualQualifier::Virtual:     return "Virtual";
         case VirtualQualifier::PureVirtual: return "PureVirtual";
         case VirtualQualifier::Override:    return "Override";
-        default:                            return std::string{};
+        default:                            return "";
     }
 }
 
-const std::string serialize(const NodeKind& node) {
+const char* serialize(const NodeKind& node) {
     switch (node) {
         case NodeKind::Namespace:              return "Namespace";
         case NodeKind::Class:                  return "Class";
@@ -72,15 +51,19 @@ const std::string serialize(const NodeKind& node) {
 }
 
 
-const std::string serialize(const std::string& str){
+const std::string& serialize(const std::string& str){
     return str;
 }
 
-const bool serialize(const bool& val){
+std::string serialize(llvm::StringRef str){
+    return str.str();
+}
+
+bool serialize(bool val){
     return val;
 }
 
-const std::string serialize(const ParsedDiffStatus& diff_status){
+const char* serialize(const ParsedDiffStatus& diff_status){
     switch (diff_status) {
         case ParsedDiffStatus::FATAL_ERRORS:           return "FATAL_ERRORS";
         case ParsedDiffStatus::UNSUPPORTED_UPDATES:    return "UNSUPPORTED_UPDATES";
@@ -90,10 +73,34 @@ const std::string serialize(const ParsedDiffStatus& diff_status){
         default:                                       return "UNKNOWN";
     }
 }
-const std::string serialize(const UnParsedDiffStatus& diff_status){
+const char* serialize(const UnParsedDiffStatus& diff_status){
     switch (diff_status) {
         case UnParsedDiffStatus::UN_CHANGED: return "UNCHANGED";
         case UnParsedDiffStatus::CHANGED:    return "CHANGED";
         default:                             return "FATAL_ERRORS";
     }
-}
\ No newline at end of file
+}
+
+void markLongestNonDecreasing(llvm::ArrayRef<uint32_t> values, llvm::SmallVectorImpl<bool>& kept,
+                              llvm::SmallVectorImpl<uint32_t>& tails, llvm::SmallVectorImpl<uint32_t>& previous) {
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    kept.assign(values.size(), false);
+    // tails[k]: index of the smallest last value of a subsequence of length k + 1
+    tails.clear();
+    previous.assign(values.size(), NONE);
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        auto slot = std::upper_bound(tails.begin(), tails.end(), values[i],
+                                     [&](uint32_t value, uint32_t tail) { return value < values[tail]; });
+        if (slot != tails.begin()) {
+            previous[i] = *(slot - 1);
+        }
+        if (slot == tails.end()) {
+            tails.push_back(i);
+        } else {
+            *slot = i;
+        }
+    }
+    for (uint32_t i = tails.empty() ? NONE : tails.back(); i != NONE; i = previous[i]) {
+        kept[i] = true;
+    }
+}
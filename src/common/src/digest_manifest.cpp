@@ -0,0 +1,94 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "digest_manifest.hpp"
+
+namespace {
+
+    constexpr int MANIFEST_FORMAT_VERSION = 1;
+
+    uint64_t parseDigest(const nlohmann::json& value) {
+        uint64_t digest = 0;
+        if (llvm::StringRef(value.get<std::string>()).getAsInteger(16, digest)) {
+            throw std::runtime_error("invalid digest " + value.dump());
+        }
+        return digest;
+    }
+
+}
+
+armor::DigestManifest armor::DigestManifest::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open digest manifest: " + path);
+    }
+    DigestManifest manifest;
+    try {
+        nlohmann::json root = nlohmann::json::parse(file);
+        if (root.at("format").get<int>() != MANIFEST_FORMAT_VERSION) {
+            throw std::runtime_error("unsupported format " + root.at("format").dump());
+        }
+        for (const auto& header : root.at("headers").items()) {
+            Entry entry;
+            entry.digest = parseDigest(header.value().at("digest"));
+            if (header.value().contains("closure")) {
+                entry.hasClosure = true;
+                entry.closure = parseDigest(header.value().at("closure"));
+            }
+            manifest.headers[header.key()] = entry;
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Malformed digest manifest " + path + ": " + e.what());
+    }
+    return manifest;
+}
+
+void armor::DigestManifest::save(const std::string& path) const {
+    nlohmann::json entries = nlohmann::json::object();
+    for (const auto& [header, entry] : headers) {
+        nlohmann::json& digests = entries[header];
+        digests["digest"] = llvm::utohexstr(entry.digest);
+        if (entry.hasClosure) {
+            digests["closure"] = llvm::utohexstr(entry.closure);
+        }
+    }
+    nlohmann::json root = {{"format", MANIFEST_FORMAT_VERSION}, {"headers", std::move(entries)}};
+    // Written next to the manifest and renamed, so an interrupted run leaves the previous one
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        out << root.dump(2) << "\n";
+        if (!out) {
+            std::remove(tempPath.c_str());
+            throw std::runtime_error("Failed to write digest manifest: " + path);
+        }
+    }
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path)) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Failed to write digest manifest " + path + ": " + ec.message());
+    }
+}
+
+bool armor::DigestManifest::find(const std::string& header, Entry& entry) const {
+    auto it = headers.find(header);
+    if (it == headers.end()) {
+        return false;
+    }
+    entry = it->second;
+    return true;
+}
+
+void armor::DigestManifest::record(const std::string& header, const Entry& entry) {
+    headers[header] = entry;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "event_stream.hpp"
+
+armor::EventStream& armor::EventStream::getInstance() {
+    static EventStream instance;
+    return instance;
+}
+
+void armor::EventStream::open(const std::string& target) {
+    int opened = STDOUT_FILENO;
+    if (target != "-") {
+        opened = ::open(target.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (opened < 0) {
+            throw std::runtime_error("Cannot open event stream " + target + ": " + std::strerror(errno));
+        }
+    }
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    fd = opened;
+    ownsFd = target != "-";
+    start = std::chrono::steady_clock::now();
+}
+
+void armor::EventStream::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ownsFd) {
+        ::close(fd);
+    }
+    fd = -1;
+    ownsFd = false;
+}
+
+bool armor::EventStream::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fd >= 0;
+}
+
+void armor::EventStream::emit(const char* event, nlohmann::json fields) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return;
+    }
+    fields["event"] = event;
+    fields["time"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::string line = fields.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    line += '\n';
+    // A reader that went away loses the events, not the run
+    const char* data = line.data();
+    std::size_t size = line.size();
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
@@ -7,6 +7,436 @@
 #include "clang/Lex/Lexer.h"
 #include "clang/Basic/LangOptions.h"
 #include <llvm-14/llvm/Support/raw_ostream.h>
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MathExtras.h"
+#include <cstring>
+
+#include "simd_dispatch.hpp"
+
+#if defined(ARMOR_SIMD_X86)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+    // Golden ratio constant: 2^64 / φ where φ = (1 + √5) / 2
+    constexpr uint64_t GOLDEN_RATIO_64 = 0x9E3779B97F4A7C15ULL;
+
+    inline bool isWhitespace(uint8_t byte) {
+        // ASCII whitespace: space(32), tab(9), LF(10), VT(11), FF(12), CR(13)
+        return byte == 32 || (byte >= 9 && byte <= 13);
+    }
+
+    inline bool isHorizontalWhitespace(uint8_t byte) {
+        return byte == ' ' || byte == '\t' || byte == '\f' || byte == '\v';
+    }
+
+    /**
+     * The streaming hash shared by every hash of this file, in the manner of
+     * XXH3: 32-byte stripes feed four 64-bit lanes. Each 8-byte word is
+     * xored with its lane's secret and the product of its halves is added
+     * to the lane, while the word itself goes to the neighbouring lane. The
+     * lanes never wait on each other, so a stripe costs about one multiply
+     * latency where a single chained lane paid one per word.
+     *
+     * Words are read little-endian whatever the host, so hashes are
+     * reproducible. The last stripe is padded with zeros, and the byte count
+     * enters the final mix, so padding cannot make two inputs equal. Seeds
+     * give independent hashes of the same bytes.
+     */
+    class StripeHasher {
+        public:
+            static constexpr size_t STRIPE = 32;
+
+            explicit StripeHasher(uint64_t seed = 0) {
+                for (unsigned i = 0; i < 4; ++i) {
+                    secret[i] = SECRETS[i] + seed;
+                    lanes[i] = LANE_SEEDS[i] ^ seed;
+                }
+            }
+
+            void add(uint8_t byte) {
+                pending[pendingBytes++] = byte;
+                ++total;
+                if (pendingBytes == STRIPE) {
+                    consume(pending);
+                    pendingBytes = 0;
+                }
+            }
+
+            void add(const uint8_t* data, size_t length) {
+                total += length;
+                // Most runs are a token or so and only extend the pending stripe
+                if (pendingBytes + length < STRIPE) {
+                    std::memcpy(pending + pendingBytes, data, length);
+                    pendingBytes += length;
+                    return;
+                }
+                // Top up a partial stripe, then take whole stripes in place
+                if (pendingBytes != 0) {
+                    size_t take = STRIPE - pendingBytes;
+                    std::memcpy(pending + pendingBytes, data, take);
+                    data += take;
+                    length -= take;
+                    consume(pending);
+                    pendingBytes = 0;
+                }
+                while (length >= STRIPE) {
+                    consume(data);
+                    data += STRIPE;
+                    length -= STRIPE;
+                }
+                std::memcpy(pending, data, length);
+                pendingBytes = length;
+            }
+
+            uint64_t finish() {
+                if (pendingBytes > 0) {
+                    std::memset(pending + pendingBytes, 0, STRIPE - pendingBytes);
+                    consume(pending);
+                    pendingBytes = 0;
+                }
+                uint64_t hash = total * GOLDEN_RATIO_64;
+                for (unsigned i = 0; i < 4; ++i) {
+                    hash = avalanche(hash ^ avalanche(lanes[i] + secret[i]));
+                }
+                return hash;
+            }
+
+        private:
+            static constexpr uint64_t SECRETS[4] = {
+                0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL};
+            static constexpr uint64_t LANE_SEEDS[4] = {
+                0x9E3779B185EBCA87ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0x85EBCA77C2B2AE63ULL};
+
+            // splitmix64 finalizer
+            static uint64_t avalanche(uint64_t value) {
+                value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+                return value ^ (value >> 31);
+            }
+
+            void consume(const uint8_t* stripe) {
+                for (unsigned i = 0; i < 4; ++i) {
+                    uint64_t word = llvm::support::endian::read64le(stripe + 8 * i);
+                    uint64_t keyed = word ^ secret[i];
+                    lanes[i] += (keyed & 0xffffffffULL) * (keyed >> 32);
+                    lanes[i ^ 1] += word;
+                }
+            }
+
+            uint64_t lanes[4];
+            uint64_t secret[4];
+            uint8_t pending[STRIPE];
+            size_t pendingBytes = 0;
+            uint64_t total = 0;
+    };
+
+    // Two hashes of unrelated seeds; a Digest128 differs where either does
+    class DigestBuilder {
+        public:
+            void add(const uint8_t* data, size_t length) {
+                low.add(data, length);
+                high.add(data, length);
+            }
+
+            FibonacciHash::Digest128 finish() {
+                return {low.finish(), high.finish()};
+            }
+
+        private:
+            StripeHasher low{0x243f6a8885a308d3ULL};
+            StripeHasher high{0x13198a2e03707344ULL};
+    };
+
+    /**
+     * Bytes a scan stops at: every byte <= 0x20 when `controls` is set, plus
+     * up to four specific bytes (unused slots repeat one of them).
+     */
+    struct StopSet {
+        bool controls;
+        uint8_t bytes[4];
+
+        bool contains(uint8_t byte) const {
+            return (controls && byte <= 32) ||
+                   byte == bytes[0] || byte == bytes[1] || byte == bytes[2] || byte == bytes[3];
+        }
+    };
+
+    // The vector scanners return the offset of the first byte of `stops`, or
+    // where their whole blocks end; the scalar loop of skipUntil finishes either
+
+#if defined(ARMOR_SIMD_X86)
+    ARMOR_TARGET_AVX2
+    size_t skipUntilAvx2(const uint8_t* data, size_t length, const StopSet& stops) {
+        size_t i = 0;
+        const __m256i space = _mm256_set1_epi8(32);
+        const __m256i b0 = _mm256_set1_epi8(static_cast<char>(stops.bytes[0]));
+        const __m256i b1 = _mm256_set1_epi8(static_cast<char>(stops.bytes[1]));
+        const __m256i b2 = _mm256_set1_epi8(static_cast<char>(stops.bytes[2]));
+        const __m256i b3 = _mm256_set1_epi8(static_cast<char>(stops.bytes[3]));
+        for (; i + 32 <= length; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, b0), _mm256_cmpeq_epi8(v, b1)),
+                                          _mm256_or_si256(_mm256_cmpeq_epi8(v, b2), _mm256_cmpeq_epi8(v, b3)));
+            if (stops.controls) {
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_min_epu8(v, space), v));
+            }
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+            if (mask != 0) {
+                return i + llvm::countTrailingZeros(mask);
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__)
+    size_t skipUntilSse2(const uint8_t* data, size_t length, const StopSet& stops) {
+        size_t i = 0;
+        const __m128i space = _mm_set1_epi8(32);
+        const __m128i b0 = _mm_set1_epi8(static_cast<char>(stops.bytes[0]));
+        const __m128i b1 = _mm_set1_epi8(static_cast<char>(stops.bytes[1]));
+        const __m128i b2 = _mm_set1_epi8(static_cast<char>(stops.bytes[2]));
+        const __m128i b3 = _mm_set1_epi8(static_cast<char>(stops.bytes[3]));
+        for (; i + 16 <= length; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, b0), _mm_cmpeq_epi8(v, b1)),
+                                       _mm_or_si128(_mm_cmpeq_epi8(v, b2), _mm_cmpeq_epi8(v, b3)));
+            if (stops.controls) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(v, space), v));
+            }
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+            if (mask != 0) {
+                return i + llvm::countTrailingZeros(mask);
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__ARM_NEON)
+    size_t skipUntilNeon(const uint8_t* data, size_t length, const StopSet& stops) {
+        size_t i = 0;
+        const uint8x16_t space = vdupq_n_u8(32);
+        const uint8x16_t b0 = vdupq_n_u8(stops.bytes[0]);
+        const uint8x16_t b1 = vdupq_n_u8(stops.bytes[1]);
+        const uint8x16_t b2 = vdupq_n_u8(stops.bytes[2]);
+        const uint8x16_t b3 = vdupq_n_u8(stops.bytes[3]);
+        for (; i + 16 <= length; i += 16) {
+            uint8x16_t v = vld1q_u8(data + i);
+            uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, b0), vceqq_u8(v, b1)),
+                                      vorrq_u8(vceqq_u8(v, b2), vceqq_u8(v, b3)));
+            if (stops.controls) {
+                hit = vorrq_u8(hit, vcleq_u8(v, space));
+            }
+            // Narrow each byte lane to a nibble: 4 mask bits per input byte
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+            if (mask != 0) {
+                return i + llvm::countTrailingZeros(mask) / 4;
+            }
+        }
+        return i;
+    }
+#endif
+
+    // Length of the prefix of [data, data + length) holding no byte of `stops`
+    size_t skipUntil(const uint8_t* data, size_t length, const StopSet& stops) {
+        size_t i = 0;
+        switch (armor::simd::activeKernel()) {
+#if defined(ARMOR_SIMD_X86)
+            case armor::simd::Kernel::AVX2:
+                i = skipUntilAvx2(data, length, stops);
+                break;
+#endif
+#if defined(__SSE2__)
+            case armor::simd::Kernel::SSE2:
+                i = skipUntilSse2(data, length, stops);
+                break;
+#endif
+#if defined(__ARM_NEON)
+            case armor::simd::Kernel::NEON:
+                i = skipUntilNeon(data, length, stops);
+                break;
+#endif
+            default:
+                break;
+        }
+        for (; i < length; ++i) {
+            if (stops.contains(data[i])) {
+                return i;
+            }
+        }
+        return length;
+    }
+
+    // Length of the line splice (backslash, optional blanks, newline) at `pos`, or 0
+    size_t spliceLength(const uint8_t* data, size_t size, size_t pos) {
+        size_t i = pos + 1;
+        while (i < size && isHorizontalWhitespace(data[i])) {
+            ++i;
+        }
+        if (i >= size || (data[i] != '\n' && data[i] != '\r')) {
+            return 0;
+        }
+        if (data[i] == '\r' && i + 1 < size && data[i + 1] == '\n') {
+            ++i;
+        }
+        return i + 1 - pos;
+    }
+
+    constexpr StopSet WHITESPACE_STOPS{true, {32, 32, 32, 32}};
+    constexpr StopSet CODE_STOPS{true, {'/', '"', '\'', '\\'}};
+    constexpr StopSet BLOCK_COMMENT_STOPS{false, {'*', '*', '*', '*'}};
+    constexpr StopSet LINE_COMMENT_STOPS{false, {'\n', '\r', '\\', '\\'}};
+
+    // Hands every maximal run of non-whitespace bytes to emit(offset, length)
+    template <typename Emit>
+    void scanNonWhitespace(const uint8_t* data, size_t length, Emit&& emit) {
+        // The scan stops at every byte <= 32; control bytes that are not
+        // whitespace are still kept
+        size_t i = 0;
+        while (i < length) {
+            size_t run = skipUntil(data + i, length - i, WHITESPACE_STOPS);
+            if (run > 0) {
+                emit(i, run);
+            }
+            i += run;
+            if (i < length) {
+                if (!isWhitespace(data[i])) {
+                    emit(i, 1);
+                }
+                ++i;
+            }
+        }
+    }
+
+    /**
+     * Hands the bytes of data[start, end) that survive normalization to
+     * emit(offset, length), as runs in buffer order: comments, line splices
+     * and whitespace outside literals are dropped. Lookahead (comment
+     * openers, splices) may read past the range, never past `size`.
+     */
+    template <typename Emit>
+    void scanNormalizedSource(const uint8_t* data, size_t size, size_t start, size_t end, Emit&& emit) {
+        enum class State { Code, Literal, BlockComment, LineComment };
+        State state = State::Code;
+        uint8_t quote = 0;
+        StopSet literalStops{false, {0, '\\', '\n', '\r'}};
+
+        size_t i = start;
+        while (i < end) {
+            switch (state) {
+                case State::Code: {
+                    size_t run = skipUntil(data + i, end - i, CODE_STOPS);
+                    if (run > 0) {
+                        emit(i, run);
+                    }
+                    i += run;
+                    if (i == end) {
+                        break;
+                    }
+                    uint8_t byte = data[i];
+                    if (byte == '\\') {
+                        size_t splice = spliceLength(data, size, i);
+                        if (splice == 0) {
+                            emit(i, 1);
+                            ++i;
+                        }
+                        i += splice;
+                    }
+                    else if (byte == '/' && i + 1 < size && data[i + 1] == '*') {
+                        state = State::BlockComment;
+                        i += 2;
+                    }
+                    // As clang's raw lexer does without line comments enabled, "//*" is a '/' and a block comment
+                    else if (byte == '/' && i + 1 < size && data[i + 1] == '/' && (i + 2 >= size || data[i + 2] != '*')) {
+                        state = State::LineComment;
+                        i += 2;
+                    }
+                    else if (byte == '"' || byte == '\'') {
+                        quote = byte;
+                        literalStops.bytes[0] = quote;
+                        state = State::Literal;
+                        emit(i, 1);
+                        ++i;
+                    }
+                    else {
+                        if (!isWhitespace(byte)) {
+                            emit(i, 1);
+                        }
+                        ++i;
+                    }
+                    break;
+                }
+                case State::Literal: {
+                    // Whitespace is part of a literal's spelling and is hashed
+                    size_t run = skipUntil(data + i, end - i, literalStops);
+                    if (run > 0) {
+                        emit(i, run);
+                    }
+                    i += run;
+                    if (i == end) {
+                        break;
+                    }
+                    uint8_t byte = data[i];
+                    if (byte == quote) {
+                        emit(i, 1);
+                        state = State::Code;
+                        ++i;
+                    }
+                    else if (byte == '\\') {
+                        size_t splice = spliceLength(data, size, i);
+                        if (splice != 0) {
+                            i += splice;
+                            break;
+                        }
+                        // Escape sequence: the escaped byte never ends the literal
+                        emit(i, i + 1 < end ? 2 : 1);
+                        i += 2;
+                    }
+                    else {
+                        // Unterminated literal ends at the newline, like an unknown token
+                        state = State::Code;
+                    }
+                    break;
+                }
+                case State::BlockComment: {
+                    i += skipUntil(data + i, end - i, BLOCK_COMMENT_STOPS);
+                    if (i == end) {
+                        break;
+                    }
+                    if (i + 1 < size && data[i + 1] == '/') {
+                        state = State::Code;
+                        i += 2;
+                    }
+                    else {
+                        ++i;
+                    }
+                    break;
+                }
+                case State::LineComment: {
+                    i += skipUntil(data + i, end - i, LINE_COMMENT_STOPS);
+                    if (i == end) {
+                        break;
+                    }
+                    if (data[i] == '\\') {
+                        // A spliced line comment continues on the next line
+                        size_t splice = spliceLength(data, size, i);
+                        i += splice == 0 ? 1 : splice;
+                    }
+                    else {
+                        state = State::Code;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+}
 
 uint64_t FibonacciHash::hash(const std::string& str) {
     return fibonacci_hash_impl(reinterpret_cast<const uint8_t*>(str.data()), str.length());
@@ -21,66 +451,77 @@ uint64_t FibonacciHash::hash(const llvm::StringRef& str) {
 }
 
 uint64_t FibonacciHash::fibonacci_hash_impl(const uint8_t* data, size_t length) {
-    uint64_t hash = 0x9E3779B97F4A7C15ULL; // Initial seed based on golden ratio
-    
-    // Process bytes while skipping whitespace
-    uint64_t chunk = 0;
-    int chunkPos = 0;
-    
-    for (size_t i = 0; i < length; ++i) {
-        uint8_t byte = data[i];
-        
-        // Skip all whitespace characters (optimized with single comparison range check)
-        // ASCII whitespace: space(32), tab(9), LF(10), VT(11), FF(12), CR(13)
-        if (byte <= 32 && (byte == 32 || byte == 9 || (byte >= 10 && byte <= 13))) {
-            continue;
-        }
-        
-        // Add byte to current chunk in little-endian order (reproducible)
-        chunk |= static_cast<uint64_t>(byte) << (chunkPos * 8);
-        chunkPos++;
-        
-        // Process chunk when we have 8 bytes
-        if (chunkPos == 8) {
-            hash ^= chunk;
-            hash *= GOLDEN_RATIO_64;
-            hash ^= hash >> 32; // Avalanche effect
-            
-            chunk = 0;
-            chunkPos = 0;
-        }
+    StripeHasher mixer;
+    scanNonWhitespace(data, length, [&](size_t offset, size_t runLength) { mixer.add(data + offset, runLength); });
+    return mixer.finish();
+}
+
+uint64_t FibonacciHash::hashNormalizedSource(llvm::StringRef buffer, unsigned startOffset, unsigned endOffset) {
+    if (startOffset >= endOffset || endOffset > buffer.size()) {
+        return 0;
     }
-    
-    // Process remaining bytes (0-7 bytes)
-    if (chunkPos > 0) {
-        hash ^= chunk;
-        hash *= GOLDEN_RATIO_64;
-        hash ^= hash >> 32;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+    StripeHasher mixer;
+    scanNormalizedSource(data, buffer.size(), startOffset, endOffset,
+                         [&](size_t offset, size_t length) { mixer.add(data + offset, length); });
+    return mixer.finish();
+}
+
+FibonacciHash::Digest128 FibonacciHash::digest(llvm::StringRef text) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+    DigestBuilder builder;
+    scanNonWhitespace(data, text.size(), [&](size_t offset, size_t length) { builder.add(data + offset, length); });
+    return builder.finish();
+}
+
+FibonacciHash::Digest128 FibonacciHash::digestNormalizedSource(llvm::StringRef buffer, unsigned startOffset,
+                                                               unsigned endOffset) {
+    if (startOffset >= endOffset || endOffset > buffer.size()) {
+        return {};
     }
-    
-    // Final avalanche mixing for better distribution
-    hash ^= hash >> 16;
-    hash *= 0x85EBCA6B;
-    hash ^= hash >> 13;
-    hash *= 0xC2B2AE35;
-    hash ^= hash >> 16;
-    
-    return hash;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+    DigestBuilder builder;
+    scanNormalizedSource(data, buffer.size(), startOffset, endOffset,
+                         [&](size_t offset, size_t length) { builder.add(data + offset, length); });
+    return builder.finish();
+}
+
+void FibonacciHash::forEachNormalizedRun(llvm::StringRef buffer, unsigned startOffset, unsigned endOffset,
+                                         llvm::function_ref<void(size_t, size_t)> onRun) {
+    if (startOffset >= endOffset || endOffset > buffer.size()) {
+        return;
+    }
+    scanNormalizedSource(reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size(), startOffset, endOffset, onRun);
+}
+
+void FibonacciHash::forEachNonWhitespaceRun(llvm::StringRef text, llvm::function_ref<void(size_t, size_t)> onRun) {
+    scanNonWhitespace(reinterpret_cast<const uint8_t*>(text.data()), text.size(), onRun);
 }
 
 uint64_t FibonacciHash::hashFromSourceRange(clang::SourceManager* SM, clang::SourceRange Range) {
-    if (!SM || !Range.isValid()) return 0;
+    unsigned startOffset = 0;
+    unsigned endOffset = 0;
+    if (!offsetsFromSourceRange(SM, Range, startOffset, endOffset)) return 0;
+
+    return hashFromOffsets(SM, startOffset, endOffset);
+}
+
+bool FibonacciHash::offsetsFromSourceRange(clang::SourceManager* SM, clang::SourceRange Range,
+                                           unsigned& startOffset, unsigned& endOffset) {
+    if (!SM || !Range.isValid()) return false;
     
     clang::SourceLocation StartLoc = Range.getBegin();
     clang::SourceLocation EndLoc = Range.getEnd();
     
     if (!StartLoc.isValid() || !EndLoc.isValid()){
         TEST_LOG << "Invalid SourceRange\n";
-        return 0;
+        return false;
     }
     
-    unsigned startOffset = SM->getFileOffset(StartLoc);
-    unsigned endOffset = SM->getFileOffset(EndLoc);
+    startOffset = SM->getFileOffset(StartLoc);
+    endOffset = SM->getFileOffset(EndLoc);
 
     if(startOffset == endOffset){
         TEST_LOG << "Get the actual end location (after the last token) startOffset == endOffset \n";
@@ -89,138 +530,23 @@ uint64_t FibonacciHash::hashFromSourceRange(clang::SourceManager* SM, clang::Sou
         endOffset = SM->getFileOffset(EndLoc);
     }
     
-    return hashFromOffsets(SM, startOffset, endOffset);
+    return true;
 }
 
 uint64_t FibonacciHash::hashFromOffsets(clang::SourceManager* SM, unsigned startOffset, unsigned endOffset) {
     if (!SM || startOffset >= endOffset){
-        if(startOffset >= endOffset) TEST_LOG << "Error while computing Hash  startOffset >= endOffset \n";
+        if(startOffset >= endOffset) {
+            TEST_LOG << "Error while computing Hash  startOffset >= endOffset \n";
+        }
         return 0;
     }
     
-    clang::FileID FID = SM->getMainFileID();
-    llvm::StringRef buffer = SM->getBufferData(FID);
+    llvm::StringRef buffer = SM->getBufferData(SM->getMainFileID());
     
     if (endOffset > buffer.size()){
         TEST_LOG << "Error while computing Hash\n";
         return 0;
     }
-    
-    // Hash tokens directly without building intermediate string
-    uint64_t hash = 0x9E3779B97F4A7C15ULL; // Initial seed
-    uint64_t chunk = 0;
-    int chunkPos = 0;
-    
-    clang::SourceLocation currentLoc = SM->getLocForStartOfFile(FID).getLocWithOffset(startOffset);
-    clang::Token tok;
-    
-    // Static LangOptions to avoid repeated construction
-    static const clang::LangOptions langOpts;
-    
-    // Cache to avoid repeated getFileOffset calls
-    unsigned currentOffset;
-    
-    while (currentLoc.isValid()) {
-        currentOffset = SM->getFileOffset(currentLoc);
-        if (currentOffset >= endOffset) break;
-        
-        // Try to get the next token
-        if (clang::Lexer::getRawToken(currentLoc, tok, *SM, langOpts)) {
-            currentLoc = currentLoc.getLocWithOffset(1);
-            continue;
-        }
-        
-        // Get token kind once
-        clang::tok::TokenKind kind = tok.getKind();
-        
-        // Skip comments and EOF (combined check)
-        if (kind == clang::tok::comment || kind == clang::tok::eof) {
-            currentLoc = tok.getEndLoc();
-            continue;
-        }
-        
-        // Get token location and length
-        clang::SourceLocation tokLoc = tok.getLocation();
-        unsigned tokOffset = SM->getFileOffset(tokLoc);
-        
-        // Early exit if token is beyond range
-        if (tokOffset >= endOffset) break;
-        
-        unsigned tokLen = tok.getLength();
-        if (tokLen > 0) {
-            // Get token data pointer
-            bool invalid = false;
-            const uint8_t* data = reinterpret_cast<const uint8_t*>(
-                SM->getCharacterData(tokLoc, &invalid));
-            
-            if (!invalid) {
-                // Truncate token if it exceeds range
-                unsigned tokEndOffset = tokOffset + tokLen;
-                if (tokEndOffset > endOffset) {
-                    tokLen = endOffset - tokOffset;
-                }
-                
-                // Hash token bytes with unrolled loop for better performance
-                const uint8_t* end = data + tokLen;
-                const uint8_t* ptr = data;
-                
-                // Process 8 bytes at a time when possible
-                while (ptr + 8 <= end && chunkPos == 0) {
-                    // Fast path: directly load 8 bytes when chunk is empty
-                    chunk = static_cast<uint64_t>(ptr[0]) |
-                           (static_cast<uint64_t>(ptr[1]) << 8) |
-                           (static_cast<uint64_t>(ptr[2]) << 16) |
-                           (static_cast<uint64_t>(ptr[3]) << 24) |
-                           (static_cast<uint64_t>(ptr[4]) << 32) |
-                           (static_cast<uint64_t>(ptr[5]) << 40) |
-                           (static_cast<uint64_t>(ptr[6]) << 48) |
-                           (static_cast<uint64_t>(ptr[7]) << 56);
-                    
-                    hash ^= chunk;
-                    hash *= GOLDEN_RATIO_64;
-                    hash ^= hash >> 32;
-                    
-                    ptr += 8;
-                    chunk = 0;
-                }
-                
-                // Process remaining bytes
-                while (ptr < end) {
-                    chunk |= static_cast<uint64_t>(*ptr) << (chunkPos * 8);
-                    chunkPos++;
-                    ptr++;
-                    
-                    if (chunkPos == 8) {
-                        hash ^= chunk;
-                        hash *= GOLDEN_RATIO_64;
-                        hash ^= hash >> 32;
-                        chunk = 0;
-                        chunkPos = 0;
-                    }
-                }
-                
-                // Early exit if we've processed beyond range
-                if (tokEndOffset > endOffset) break;
-            }
-        }
-        
-        // Move to end of current token
-        currentLoc = tok.getEndLoc();
-    }
-    
-    // Process remaining bytes (0-7 bytes)
-    if (chunkPos > 0) {
-        hash ^= chunk;
-        hash *= GOLDEN_RATIO_64;
-        hash ^= hash >> 32;
-    }
-    
-    // Final avalanche mixing
-    hash ^= hash >> 16;
-    hash *= 0x85EBCA6B;
-    hash ^= hash >> 13;
-    hash *= 0xC2B2AE35;
-    hash ^= hash >> 16;
-    
-    return hash;
-}
\ No newline at end of file
+
+    return hashNormalizedSource(buffer, startOffset, endOffset);
+}
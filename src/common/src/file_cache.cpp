@@ -0,0 +1,363 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include "file_cache.hpp"
+
+namespace {
+
+    // Serves a cached buffer; the cache outlives the parse, see SharedFileCache
+    class CachedFile : public llvm::vfs::File {
+        public:
+            CachedFile(llvm::vfs::Status status, std::shared_ptr<const llvm::MemoryBuffer> buffer)
+                : fileStatus(std::move(status)), buffer(std::move(buffer)) {}
+
+            llvm::ErrorOr<llvm::vfs::Status> status() override {
+                return fileStatus;
+            }
+
+            llvm::ErrorOr<std::string> getName() override {
+                return fileStatus.getName().str();
+            }
+
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> getBuffer(const llvm::Twine& name, int64_t,
+                                                                         bool requiresNullTerminator,
+                                                                         bool) override {
+                return llvm::MemoryBuffer::getMemBuffer(buffer->getBuffer(), name.str(), requiresNullTerminator);
+            }
+
+            std::error_code close() override {
+                return {};
+            }
+
+        private:
+            llvm::vfs::Status fileStatus;
+            std::shared_ptr<const llvm::MemoryBuffer> buffer;
+    };
+
+    // Whether `path` is `dir` or a path below it
+    bool isWithin(llvm::StringRef path, llvm::StringRef dir) {
+        return path.startswith(dir) &&
+               (path.size() == dir.size() || llvm::sys::path::is_separator(path[dir.size()]));
+    }
+
+    // Absolute `path` without "." components, as the cache keys paths
+    std::string normalizedPath(llvm::StringRef path) {
+        llvm::SmallString<256> normalized(path);
+        llvm::sys::fs::make_absolute(normalized);
+        llvm::sys::path::remove_dots(normalized, /*remove_dot_dot=*/false);
+        return normalized.str().str();
+    }
+
+    // Whether a file must be read again: it appeared, disappeared or changed
+    bool changed(const llvm::ErrorOr<llvm::vfs::Status>& before, const llvm::ErrorOr<llvm::vfs::Status>& now) {
+        if (!before || !now) {
+            return static_cast<bool>(before) != static_cast<bool>(now);
+        }
+        return before->getSize() != now->getSize() ||
+               before->getLastModificationTime() != now->getLastModificationTime() ||
+               before->getType() != now->getType();
+    }
+
+}
+
+class armor::SharedFileCache::CachingFileSystem : public llvm::vfs::ProxyFileSystem {
+    public:
+        CachingFileSystem(SharedFileCache& cache, llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying)
+            : ProxyFileSystem(std::move(underlying)), cache(cache) {}
+
+        llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override {
+            llvm::SmallString<256> key;
+            if (!cacheKey(path, key)) {
+                return ProxyFileSystem::status(path);
+            }
+            if (std::shared_ptr<const Entry> entry = cache.lookup(key)) {
+                cache.hits.fetch_add(1, std::memory_order_relaxed);
+                return named(entry->status, path);
+            }
+            if (cache.knownMissing(key, getUnderlyingFS())) {
+                cache.hits.fetch_add(1, std::memory_order_relaxed);
+                return std::make_error_code(std::errc::no_such_file_or_directory);
+            }
+            cache.misses.fetch_add(1, std::memory_order_relaxed);
+            auto entry = std::make_shared<Entry>();
+            entry->status = ProxyFileSystem::status(key);
+            return named(cache.insert(key, std::move(entry))->status, path);
+        }
+
+        llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override {
+            llvm::SmallString<256> key;
+            if (!cacheKey(path, key)) {
+                return ProxyFileSystem::openFileForRead(path);
+            }
+            std::shared_ptr<const Entry> entry = cache.lookup(key);
+            if (entry && (!entry->status || entry->buffer)) {
+                cache.hits.fetch_add(1, std::memory_order_relaxed);
+                if (!entry->status) {
+                    return entry->status.getError();
+                }
+                return std::unique_ptr<llvm::vfs::File>(
+                    new CachedFile(llvm::vfs::Status::copyWithNewName(*entry->status, path.str()), entry->buffer));
+            }
+            if (!entry && cache.knownMissing(key, getUnderlyingFS())) {
+                cache.hits.fetch_add(1, std::memory_order_relaxed);
+                return std::make_error_code(std::errc::no_such_file_or_directory);
+            }
+            cache.misses.fetch_add(1, std::memory_order_relaxed);
+
+            auto file = ProxyFileSystem::openFileForRead(key);
+            if (!file) {
+                auto missing = std::make_shared<Entry>();
+                missing->status = file.getError();
+                cache.insert(key, std::move(missing));
+                return file.getError();
+            }
+            llvm::ErrorOr<llvm::vfs::Status> fileStatus = (*file)->status();
+            if (!fileStatus || !fileStatus->isRegularFile()) {
+                return file;
+            }
+            // Read, not mapped, so a file changed later cannot change the cached text
+            auto buffer = (*file)->getBuffer(key, fileStatus->getSize(), /*RequiresNullTerminator=*/true,
+                                             /*IsVolatile=*/true);
+            if (!buffer) {
+                return buffer.getError();
+            }
+            auto loaded = std::make_shared<Entry>();
+            loaded->status = fileStatus;
+            loaded->buffer = std::shared_ptr<const llvm::MemoryBuffer>(std::move(*buffer));
+            std::shared_ptr<const Entry> kept = cache.insert(key, loaded);
+            if (!kept->buffer) {
+                // Over the cache's budget: this tool reads the file it loaded
+                kept = loaded;
+            }
+            return std::unique_ptr<llvm::vfs::File>(
+                new CachedFile(llvm::vfs::Status::copyWithNewName(*kept->status, path.str()), kept->buffer));
+        }
+
+    private:
+        // Absolute path of `path` without "." components; false if it cannot be made
+        // absolute or is not to be cached
+        bool cacheKey(const llvm::Twine& path, llvm::SmallVectorImpl<char>& key) {
+            path.toVector(key);
+            if (makeAbsolute(key)) {
+                return false;
+            }
+            // ".." is kept: it may leave a symlinked directory elsewhere than its parent
+            llvm::sys::path::remove_dots(key, /*remove_dot_dot=*/false);
+            return !cache.isUncached(llvm::StringRef(key.data(), key.size()));
+        }
+
+        static llvm::ErrorOr<llvm::vfs::Status> named(const llvm::ErrorOr<llvm::vfs::Status>& status,
+                                                      const llvm::Twine& path) {
+            if (!status) {
+                return status.getError();
+            }
+            return llvm::vfs::Status::copyWithNewName(*status, path.str());
+        }
+
+        SharedFileCache& cache;
+};
+
+armor::SharedFileCache& armor::SharedFileCache::getInstance() {
+    static SharedFileCache sCache;
+    return sCache;
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+armor::SharedFileCache::wrap(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying) {
+    return llvm::makeIntrusiveRefCnt<CachingFileSystem>(*this, std::move(underlying));
+}
+
+std::shared_ptr<const armor::SharedFileCache::Entry> armor::SharedFileCache::lookup(llvm::StringRef path) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = entries.find(path);
+    return it == entries.end() ? nullptr : it->second;
+}
+
+void armor::SharedFileCache::listTree(llvm::StringRef root, const std::vector<std::string>& excluded) {
+    ListedTree tree{normalizedPath(root), {}};
+    for (const std::string& dir : excluded) {
+        tree.excluded.push_back(normalizedPath(dir));
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    listedTrees.push_back(std::move(tree));
+}
+
+void armor::SharedFileCache::clearListedTrees() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    listedTrees.clear();
+    listings.clear();
+}
+
+void armor::SharedFileCache::setUncachedTrees(const std::vector<std::string>& dirs) {
+    std::vector<std::string> normalized;
+    for (const std::string& dir : dirs) {
+        normalized.push_back(normalizedPath(dir));
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    uncachedTrees = std::move(normalized);
+}
+
+bool armor::SharedFileCache::isUncached(llvm::StringRef path) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const std::string& dir : uncachedTrees) {
+        if (isWithin(path, dir)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool armor::SharedFileCache::knownMissing(llvm::StringRef path, llvm::vfs::FileSystem& fs) {
+    llvm::SmallString<256> dir;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const ListedTree& tree : listedTrees) {
+            if (!isWithin(path, tree.root)) {
+                continue;
+            }
+            for (const std::string& excluded : tree.excluded) {
+                if (isWithin(path, excluded)) {
+                    return false;
+                }
+            }
+            dir = tree.root;
+            break;
+        }
+    }
+    if (dir.empty()) {
+        return false;
+    }
+    // Down from the root, one listing per directory, to the first name missing
+    llvm::StringRef rest = path.drop_front(dir.size());
+    for (auto it = llvm::sys::path::begin(rest), end = llvm::sys::path::end(rest); it != end;) {
+        llvm::StringRef name = *it;
+        ++it;
+        if (name.size() == 1 && llvm::sys::path::is_separator(name[0])) {
+            continue;
+        }
+        if (name == "..") {
+            return false;
+        }
+        std::shared_ptr<const Listing> names = listing(dir.str().str(), fs);
+        if (!names) {
+            return false;
+        }
+        auto found = names->find(name);
+        if (found == names->end()) {
+            return true;
+        }
+        // Symbolic links and files are left to the file system
+        if (it == end || !found->second) {
+            return false;
+        }
+        llvm::sys::path::append(dir, name);
+    }
+    return false;
+}
+
+std::shared_ptr<const armor::SharedFileCache::Listing>
+armor::SharedFileCache::listing(const std::string& dir, llvm::vfs::FileSystem& fs) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = listings.find(dir);
+        if (it != listings.end()) {
+            return it->second;
+        }
+    }
+    auto names = std::make_shared<Listing>();
+    std::error_code ec;
+    for (llvm::vfs::directory_iterator it = fs.dir_begin(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        names->try_emplace(llvm::sys::path::filename(it->path()),
+                           it->type() == llvm::sys::fs::file_type::directory_file);
+    }
+    if (ec) {
+        return nullptr;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return listings.try_emplace(dir, std::move(names)).first->second;
+}
+
+std::shared_ptr<const armor::SharedFileCache::Entry>
+armor::SharedFileCache::insert(llvm::StringRef path, std::shared_ptr<const Entry> entry) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = entries.find(path);
+    if (it != entries.end() && (it->second->buffer || !entry->buffer)) {
+        // Another tool got there first
+        return it->second;
+    }
+    if (entry->buffer) {
+        std::size_t size = entry->buffer->getBufferSize();
+        if (bufferBytes + size > maxBufferBytes) {
+            // Keeps the stat result only
+            auto statOnly = std::make_shared<Entry>();
+            statOnly->status = entry->status;
+            entry = std::move(statOnly);
+        }
+        else {
+            bufferBytes += size;
+        }
+    }
+    if (it != entries.end()) {
+        it->second = entry;
+        return entry;
+    }
+    return entries.try_emplace(path, std::move(entry)).first->second;
+}
+
+std::size_t armor::SharedFileCache::revalidate() {
+    std::vector<std::pair<std::string, llvm::ErrorOr<llvm::vfs::Status>>> cached;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        cached.reserve(entries.size());
+        for (const auto& entry : entries) {
+            cached.emplace_back(entry.getKey().str(), entry.getValue()->status);
+        }
+    }
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> disk = llvm::vfs::getRealFileSystem();
+    std::vector<std::string> stale;
+    for (const auto& [path, status] : cached) {
+        if (changed(status, disk->status(path))) {
+            stale.push_back(path);
+        }
+    }
+    for (const std::string& path : stale) {
+        forget(path);
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    listings.clear();
+    return stale.size();
+}
+
+void armor::SharedFileCache::forget(llvm::StringRef absolutePath) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = entries.find(absolutePath);
+    if (it == entries.end()) {
+        return;
+    }
+    if (it->second->buffer) {
+        bufferBytes -= it->second->buffer->getBufferSize();
+    }
+    entries.erase(it);
+}
+
+void armor::SharedFileCache::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    entries.clear();
+    listings.clear();
+    bufferBytes = 0;
+}
+
+std::size_t armor::SharedFileCache::getBufferBytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return bufferBytes;
+}
@@ -0,0 +1,38 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "file_compare.hpp"
+
+bool armor::filesDiffer(const std::string& file1, const std::string& file2) {
+    uint64_t size1 = 0;
+    uint64_t size2 = 0;
+    if (llvm::sys::fs::file_size(file1, size1) || llvm::sys::fs::file_size(file2, size2)) {
+        return true;
+    }
+    if (size1 != size2) {
+        return true;
+    }
+    if (size1 == 0) {
+        return false;
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer1 =
+        llvm::MemoryBuffer::getFile(file1, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer2 =
+        llvm::MemoryBuffer::getFile(file2, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer1 || !buffer2) {
+        return true;
+    }
+
+    const llvm::MemoryBuffer& a = **buffer1;
+    const llvm::MemoryBuffer& b = **buffer2;
+    return a.getBufferSize() != b.getBufferSize() ||
+           std::memcmp(a.getBufferStart(), b.getBufferStart(), a.getBufferSize()) != 0;
+}
@@ -0,0 +1,158 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "file_watch.hpp"
+
+namespace {
+
+    // Writes of one save arrive within this many milliseconds of each other
+    constexpr int SETTLE_MS = 200;
+
+    constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+    std::string normalized(const std::string& path) {
+        std::error_code ec;
+        std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+        std::string result = (ec ? std::filesystem::path(path) : absolute).lexically_normal().string();
+        if (result.size() > 1 && result.back() == '/') {
+            result.pop_back();
+        }
+        return result;
+    }
+
+    class TreeWatch {
+        public:
+            TreeWatch(const std::vector<std::string>& excluded) : fd(inotify_init1(IN_CLOEXEC)) {
+                for (const std::string& dir : excluded) {
+                    this->excluded.push_back(normalized(dir));
+                }
+            }
+
+            ~TreeWatch() {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+
+            TreeWatch(const TreeWatch&) = delete;
+            TreeWatch& operator=(const TreeWatch&) = delete;
+
+            // Watches `dir` and every directory below it; false if `dir` itself cannot be watched
+            bool addTree(const std::string& dir) {
+                if (fd < 0 || !addDirectory(dir)) {
+                    return false;
+                }
+                std::error_code ec;
+                auto options = std::filesystem::directory_options::skip_permission_denied;
+                for (auto it = std::filesystem::recursive_directory_iterator(dir, options, ec);
+                     !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+                    if (!it->is_directory(ec) || it->is_symlink(ec)) {
+                        continue;
+                    }
+                    std::string path = it->path().string();
+                    if (isExcluded(path)) {
+                        it.disable_recursion_pending();
+                        continue;
+                    }
+                    addDirectory(path);
+                }
+                return true;
+            }
+
+            /**
+             * Adds the files changed to `changed`, waiting up to `timeoutMs`
+             * (-1: forever) for the first event; false if none came in time.
+             */
+            bool readChanges(int timeoutMs, std::unordered_set<std::string>& changed) {
+                pollfd pollFd{fd, POLLIN, 0};
+                int ready = poll(&pollFd, 1, timeoutMs);
+                if (ready <= 0) {
+                    return false;
+                }
+                alignas(inotify_event) char buffer[64 * 1024];
+                ssize_t length = read(fd, buffer, sizeof(buffer));
+                if (length <= 0) {
+                    return false;
+                }
+                for (char* at = buffer; at < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+                    at += sizeof(inotify_event) + event->len;
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        // Too many changes to tell apart; the next run finds them
+                        changed.insert(root);
+                        continue;
+                    }
+                    auto dir = directories.find(event->wd);
+                    if (dir == directories.end() || event->len == 0) {
+                        continue;
+                    }
+                    std::string path = dir->second + "/" + event->name;
+                    if (isExcluded(path)) {
+                        continue;
+                    }
+                    if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                        addTree(path);
+                    }
+                    changed.insert(path);
+                }
+                return true;
+            }
+
+            std::string root;
+
+        private:
+            bool addDirectory(const std::string& dir) {
+                int wd = inotify_add_watch(fd, dir.c_str(), WATCH_MASK | IN_ONLYDIR);
+                if (wd < 0) {
+                    return false;
+                }
+                directories[wd] = dir;
+                return true;
+            }
+
+            bool isExcluded(const std::string& path) const {
+                for (const std::string& dir : excluded) {
+                    if (path.compare(0, dir.size(), dir) == 0 && (path.size() == dir.size() || path[dir.size()] == '/')) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            int fd;
+            std::vector<std::string> excluded;
+            std::unordered_map<int, std::string> directories;
+    };
+
+}
+
+bool armor::watchAndRerun(const std::string& root, const std::vector<std::string>& excluded,
+                          const std::function<bool(const std::vector<std::string>& changed)>& run) {
+    TreeWatch watch(excluded);
+    watch.root = normalized(root);
+    if (!watch.addTree(watch.root)) {
+        return false;
+    }
+
+    std::vector<std::string> changed;
+    while (run(changed)) {
+        std::unordered_set<std::string> paths;
+        // Events under excluded directories alone do not start a run
+        while (paths.empty()) {
+            watch.readChanges(-1, paths);
+        }
+        while (watch.readChanges(SETTLE_MS, paths)) {
+        }
+        changed.assign(paths.begin(), paths.end());
+    }
+    return true;
+}
@@ -0,0 +1,459 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include "git_tree.hpp"
+
+extern char** environ;
+
+namespace {
+
+    // Symbolic links followed while resolving one path, as in the kernel
+    constexpr unsigned MAX_SYMLINK_HOPS = 40;
+
+    constexpr const char* SYMLINK_MODE = "120000";
+
+    // A git child process; `input` and `output` are our ends of its stdin and stdout
+    struct GitChild {
+        pid_t pid = -1;
+        int input = -1;
+        int output = -1;
+    };
+
+    GitChild spawnGit(const std::string& repoPath, const std::vector<std::string>& args, bool withInput) {
+        llvm::ErrorOr<std::string> git = llvm::sys::findProgramByName("git");
+        if (!git) {
+            throw std::runtime_error("git not found in PATH");
+        }
+
+        int inPipe[2] = {-1, -1};
+        int outPipe[2] = {-1, -1};
+        if ((withInput && pipe2(inPipe, O_CLOEXEC) != 0) || pipe2(outPipe, O_CLOEXEC) != 0) {
+            for (int fd : {inPipe[0], inPipe[1]}) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+            throw std::runtime_error("Cannot create pipes for git");
+        }
+
+        std::vector<std::string> argStrings = {"git", "-C", repoPath};
+        argStrings.insert(argStrings.end(), args.begin(), args.end());
+        std::vector<char*> argv;
+        for (std::string& arg : argStrings) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+
+        // dup2 onto stdin/stdout drops O_CLOEXEC there; every other end stays ours
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        if (withInput) {
+            posix_spawn_file_actions_adddup2(&actions, inPipe[0], STDIN_FILENO);
+        }
+        posix_spawn_file_actions_adddup2(&actions, outPipe[1], STDOUT_FILENO);
+
+        GitChild child;
+        int rc = posix_spawn(&child.pid, git->c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+
+        if (withInput) {
+            close(inPipe[0]);
+        }
+        close(outPipe[1]);
+        if (rc != 0) {
+            if (withInput) {
+                close(inPipe[1]);
+            }
+            close(outPipe[0]);
+            throw std::runtime_error("Cannot start git: " + std::string(strerror(rc)));
+        }
+        child.input = inPipe[1];
+        child.output = outPipe[0];
+        return child;
+    }
+
+    // Exit code of the child, -1 if it did not exit normally
+    int waitGit(pid_t pid) {
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                return -1;
+            }
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    // Everything `git <args>` prints, or an error if it fails
+    std::string runGit(const std::string& repoPath, const std::vector<std::string>& args) {
+        GitChild child = spawnGit(repoPath, args, false);
+        std::string output;
+        char buffer[64 * 1024];
+        for (;;) {
+            ssize_t n = read(child.output, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            output.append(buffer, static_cast<size_t>(n));
+        }
+        close(child.output);
+        if (waitGit(child.pid) != 0) {
+            throw std::runtime_error("git " + args.front() + " failed in " + repoPath);
+        }
+        return output;
+    }
+
+    llvm::vfs::Status makeStatus(llvm::StringRef path, const armor::GitRevisionTree::Entry& entry) {
+        return llvm::vfs::Status(path, entry.uniqueId, llvm::sys::TimePoint<>(), 0, 0, entry.size,
+                                 entry.isDirectory ? llvm::sys::fs::file_type::directory_file
+                                                   : llvm::sys::fs::file_type::regular_file,
+                                 llvm::sys::fs::perms::all_read);
+    }
+
+    class GitTreeFile : public llvm::vfs::File {
+        public:
+            GitTreeFile(std::shared_ptr<const armor::GitRevisionTree> tree,
+                        const armor::GitRevisionTree::Entry& entry, std::string path)
+                : tree(std::move(tree)), entry(entry), path(std::move(path)) {}
+
+            llvm::ErrorOr<llvm::vfs::Status> status() override {
+                return makeStatus(path, entry);
+            }
+
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+            getBuffer(const llvm::Twine& name, int64_t, bool requiresNullTerminator, bool) override {
+                try {
+                    // The store keeps the blob alive, so the buffer needs no copy
+                    return llvm::MemoryBuffer::getMemBuffer(tree->readFile(entry), name.str(),
+                                                            requiresNullTerminator);
+                } catch (const std::runtime_error&) {
+                    return std::make_error_code(std::errc::io_error);
+                }
+            }
+
+            std::error_code close() override {
+                return {};
+            }
+
+        private:
+            std::shared_ptr<const armor::GitRevisionTree> tree;
+            const armor::GitRevisionTree::Entry& entry;
+            std::string path;
+    };
+
+    class GitTreeFileSystem : public llvm::vfs::FileSystem {
+        public:
+            explicit GitTreeFileSystem(std::shared_ptr<const armor::GitRevisionTree> tree)
+                : tree(std::move(tree)), workingDirectory(this->tree->getMountPoint()) {}
+
+            llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override {
+                llvm::SmallString<256> absolute;
+                const armor::GitRevisionTree::Entry* entry = lookup(path, absolute);
+                if (!entry) {
+                    return std::make_error_code(std::errc::no_such_file_or_directory);
+                }
+                return makeStatus(absolute, *entry);
+            }
+
+            llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override {
+                llvm::SmallString<256> absolute;
+                const armor::GitRevisionTree::Entry* entry = lookup(path, absolute);
+                if (!entry) {
+                    return std::make_error_code(std::errc::no_such_file_or_directory);
+                }
+                if (entry->isDirectory) {
+                    return std::make_error_code(std::errc::is_a_directory);
+                }
+                return std::unique_ptr<llvm::vfs::File>(new GitTreeFile(tree, *entry, absolute.str().str()));
+            }
+
+            llvm::vfs::directory_iterator dir_begin(const llvm::Twine& dir, std::error_code& ec) override {
+                llvm::SmallString<256> absolute;
+                ec = lookup(dir, absolute) ? std::make_error_code(std::errc::operation_not_supported)
+                                           : std::make_error_code(std::errc::no_such_file_or_directory);
+                return {};
+            }
+
+            std::error_code setCurrentWorkingDirectory(const llvm::Twine& path) override {
+                llvm::SmallString<256> absolute;
+                path.toVector(absolute);
+                if (std::error_code ec = makeAbsolute(absolute)) {
+                    return ec;
+                }
+                workingDirectory = absolute.str().str();
+                return {};
+            }
+
+            llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+                return workingDirectory;
+            }
+
+            std::error_code getRealPath(const llvm::Twine& path, llvm::SmallVectorImpl<char>& output) const override {
+                llvm::SmallString<256> absolute;
+                path.toVector(absolute);
+                if (std::error_code ec = makeAbsolute(absolute)) {
+                    return ec;
+                }
+                llvm::sys::path::remove_dots(absolute, true);
+                if (!tree->lookup(absolute)) {
+                    return std::make_error_code(std::errc::no_such_file_or_directory);
+                }
+                output.assign(absolute.begin(), absolute.end());
+                return {};
+            }
+
+            std::error_code isLocal(const llvm::Twine&, bool& result) override {
+                result = true;
+                return {};
+            }
+
+        private:
+            const armor::GitRevisionTree::Entry* lookup(const llvm::Twine& path, llvm::SmallString<256>& absolute) {
+                path.toVector(absolute);
+                if (makeAbsolute(absolute)) {
+                    return nullptr;
+                }
+                llvm::sys::path::remove_dots(absolute, true);
+                return tree->lookup(absolute);
+            }
+
+            std::shared_ptr<const armor::GitRevisionTree> tree;
+            std::string workingDirectory;
+    };
+
+}
+
+armor::GitObjectStore::GitObjectStore(std::string repoPath) : repoPath(std::move(repoPath)) {
+    GitChild child = spawnGit(this->repoPath, {"cat-file", "--batch"}, true);
+    pid = child.pid;
+    toGit = fdopen(child.input, "w");
+    fromGit = fdopen(child.output, "r");
+    if (!toGit || !fromGit) {
+        throw std::runtime_error("Cannot talk to git cat-file in " + this->repoPath);
+    }
+}
+
+armor::GitObjectStore::~GitObjectStore() {
+    // cat-file exits at the end of its input
+    if (toGit) {
+        fclose(toGit);
+    }
+    if (fromGit) {
+        fclose(fromGit);
+    }
+    if (pid > 0) {
+        waitGit(pid);
+    }
+}
+
+llvm::StringRef armor::GitObjectStore::readBlob(const std::string& oid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto cached = blobs.find(oid);
+    if (cached != blobs.end()) {
+        return *cached->second;
+    }
+
+    if (fprintf(toGit, "%s\n", oid.c_str()) < 0 || fflush(toGit) != 0) {
+        throw std::runtime_error("git cat-file exited in " + repoPath);
+    }
+
+    // "<oid> <type> <size>\n<contents>\n", or "<oid> missing\n"
+    std::string header;
+    for (int c = fgetc(fromGit); c != '\n'; c = fgetc(fromGit)) {
+        if (c == EOF) {
+            throw std::runtime_error("git cat-file exited in " + repoPath);
+        }
+        header.push_back(static_cast<char>(c));
+    }
+    llvm::StringRef rest(header);
+    llvm::StringRef type;
+    std::tie(std::ignore, rest) = rest.split(' ');
+    std::tie(type, rest) = rest.split(' ');
+    unsigned long long size = 0;
+    if (type != "blob" || rest.getAsInteger(10, size)) {
+        throw std::runtime_error("Not a blob in " + repoPath + ": " + header);
+    }
+
+    auto blob = std::make_unique<std::string>(size, '\0');
+    if (fread(blob->data(), 1, size, fromGit) != size || fgetc(fromGit) != '\n') {
+        throw std::runtime_error("Truncated blob " + oid + " from git cat-file");
+    }
+    return *blobs.try_emplace(oid, std::move(blob)).first->second;
+}
+
+armor::GitRevisionTree::GitRevisionTree(std::shared_ptr<GitObjectStore> store, const std::string& rev,
+                                        std::string mountPoint)
+    : store(std::move(store)), mountPoint(std::move(mountPoint)) {
+    llvm::SmallString<256> normalized(this->mountPoint);
+    llvm::sys::path::remove_dots(normalized, true);
+    this->mountPoint = normalized.str().str();
+    while (this->mountPoint.size() > 1 && this->mountPoint.back() == '/') {
+        this->mountPoint.pop_back();
+    }
+
+    root.isDirectory = true;
+    root.uniqueId = llvm::vfs::getNextVirtualUniqueID();
+
+    // -t lists the trees too, so directories exist without scanning paths
+    std::string listing = runGit(this->store->getRepoPath(),
+                                 {"ls-tree", "-r", "-t", "-l", "-z", "--full-tree", rev});
+
+    // "<mode> <type> <oid> <size>\t<path>\0", the size padded and "-" for trees
+    llvm::StringRef records(listing);
+    while (!records.empty()) {
+        llvm::StringRef record;
+        std::tie(record, records) = records.split('\0');
+        llvm::StringRef meta, path;
+        std::tie(meta, path) = record.split('\t');
+        llvm::SmallVector<llvm::StringRef, 4> fields;
+        meta.split(fields, ' ', -1, false);
+        if (fields.size() != 4 || path.empty()) {
+            continue;
+        }
+
+        Entry entry;
+        if (fields[1] == "tree") {
+            entry.isDirectory = true;
+        } else if (fields[1] == "blob") {
+            entry.isSymlink = fields[0] == SYMLINK_MODE;
+            fields[3].getAsInteger(10, entry.size);
+        } else {
+            // Submodule commits have no contents here
+            continue;
+        }
+        entry.oid = fields[2].str();
+        entry.uniqueId = llvm::vfs::getNextVirtualUniqueID();
+        entries.try_emplace(path, std::move(entry));
+    }
+}
+
+bool armor::GitRevisionTree::relativize(llvm::StringRef path, std::string& relative) const {
+    llvm::SmallString<256> normalized(path);
+    llvm::sys::path::remove_dots(normalized, true);
+    if (!normalized.startswith(mountPoint)) {
+        return false;
+    }
+    llvm::StringRef rest = normalized.str().drop_front(mountPoint.size());
+    if (!rest.empty() && rest.front() != '/') {
+        return false;
+    }
+    relative = rest.ltrim('/').rtrim('/').str();
+    return true;
+}
+
+const armor::GitRevisionTree::Entry* armor::GitRevisionTree::resolve(const std::string& relative) const {
+    if (relative.empty()) {
+        return &root;
+    }
+    // Listed paths have no link above them, so only the last component can be one
+    auto direct = entries.find(relative);
+    if (direct != entries.end() && !direct->second.isSymlink) {
+        return &direct->second;
+    }
+
+    std::string pending = relative;
+    unsigned hops = 0;
+    for (;;) {
+        std::string resolved;
+        bool followed = false;
+        for (auto it = llvm::sys::path::begin(pending), end = llvm::sys::path::end(pending); it != end; ++it) {
+            std::string candidate = resolved.empty() ? it->str() : resolved + "/" + it->str();
+            auto found = entries.find(candidate);
+            if (found == entries.end()) {
+                return nullptr;
+            }
+            if (!found->second.isSymlink) {
+                resolved = std::move(candidate);
+                continue;
+            }
+
+            llvm::StringRef target = store->readBlob(found->second.oid);
+            if (++hops > MAX_SYMLINK_HOPS || llvm::sys::path::is_absolute(target)) {
+                return nullptr;
+            }
+            // The target is relative to the link's directory; the rest of the path follows it
+            llvm::SmallString<256> next(resolved);
+            llvm::sys::path::append(next, target);
+            for (++it; it != end; ++it) {
+                llvm::sys::path::append(next, *it);
+            }
+            llvm::sys::path::remove_dots(next, true);
+            if (next.str() == ".." || next.str().startswith("../")) {
+                return nullptr;
+            }
+            pending = next.str() == "." ? std::string() : next.str().str();
+            followed = true;
+            break;
+        }
+        if (!followed) {
+            return resolved.empty() ? &root : &entries.find(resolved)->second;
+        }
+        if (pending.empty()) {
+            return &root;
+        }
+    }
+}
+
+const armor::GitRevisionTree::Entry* armor::GitRevisionTree::lookup(llvm::StringRef path) const {
+    std::string relative;
+    if (!relativize(path, relative)) {
+        return nullptr;
+    }
+    try {
+        return resolve(relative);
+    } catch (const std::runtime_error&) {
+        // An unreadable link leads nowhere
+        return nullptr;
+    }
+}
+
+std::vector<std::string> armor::GitRevisionTree::listFiles(llvm::StringRef path) const {
+    std::vector<std::string> files;
+    std::string relative;
+    if (!relativize(path, relative)) {
+        return files;
+    }
+    std::string prefix = relative.empty() ? std::string() : relative + "/";
+    for (const auto& item : entries) {
+        llvm::StringRef key = item.getKey();
+        if (item.getValue().isDirectory || !key.startswith(prefix)) {
+            continue;
+        }
+        llvm::StringRef name = key.drop_front(prefix.size());
+        if (!name.contains('/')) {
+            files.push_back(name.str());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+llvm::StringRef armor::GitRevisionTree::readFile(const Entry& entry) const {
+    return store->readBlob(entry.oid);
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+armor::createGitTreeFileSystem(std::shared_ptr<const GitRevisionTree> tree) {
+    return llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(new GitTreeFileSystem(std::move(tree)));
+}
@@ -0,0 +1,122 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "hardware_counters.hpp"
+
+namespace {
+
+    constexpr uint64_t EVENT_CONFIGS[armor::profile::HARDWARE_EVENT_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    std::mutex errorMutex;
+    std::string openError;
+
+    // The layout read() fills for PERF_FORMAT_GROUP with both times
+    struct GroupReading {
+        uint64_t events;
+        uint64_t timeEnabled;
+        uint64_t timeRunning;
+        uint64_t values[armor::profile::HARDWARE_EVENT_COUNT];
+    };
+
+    int openEvent(uint64_t config, int groupFd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    // The counter group of one thread; the leader counts cycles
+    class ThreadCounters {
+        public:
+            ~ThreadCounters() {
+                for (int fd : fds) {
+                    if (fd >= 0) {
+                        close(fd);
+                    }
+                }
+            }
+
+            bool read(armor::profile::HardwareSample& sample) {
+                if (!opened) {
+                    open();
+                }
+                if (fds[0] < 0) {
+                    return false;
+                }
+                GroupReading reading{};
+                if (::read(fds[0], &reading, sizeof(reading)) <= 0 || reading.timeRunning == 0) {
+                    return false;
+                }
+                double scale = static_cast<double>(reading.timeEnabled) / static_cast<double>(reading.timeRunning);
+                for (std::size_t i = 0; i < armor::profile::HARDWARE_EVENT_COUNT; ++i) {
+                    sample[i] = slots[i] < 0 ? 0 : static_cast<uint64_t>(static_cast<double>(reading.values[slots[i]]) * scale);
+                }
+                return true;
+            }
+
+        private:
+            void open() {
+                opened = true;
+                fds.fill(-1);
+                slots.fill(-1);
+                fds[0] = openEvent(EVENT_CONFIGS[0], -1);
+                if (fds[0] < 0) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    openError = std::string("perf_event_open: ") + std::strerror(errno);
+                    return;
+                }
+                int members = 0;
+                slots[0] = members++;
+                for (std::size_t i = 1; i < armor::profile::HARDWARE_EVENT_COUNT; ++i) {
+                    fds[i] = openEvent(EVENT_CONFIGS[i], fds[0]);
+                    if (fds[i] >= 0) {
+                        slots[i] = members++;
+                    }
+                }
+            }
+
+            bool opened = false;
+            std::array<int, armor::profile::HARDWARE_EVENT_COUNT> fds{};
+            // Position of each event in a group reading, -1 if it could not be opened
+            std::array<int, armor::profile::HARDWARE_EVENT_COUNT> slots{};
+    };
+
+    thread_local ThreadCounters threadCounters;
+
+}
+
+llvm::StringRef armor::profile::hardwareEventName(HardwareEvent event) {
+    switch (event) {
+        case HardwareEvent::CYCLES:        return "cycles";
+        case HardwareEvent::INSTRUCTIONS:  return "instructions";
+        case HardwareEvent::CACHE_MISSES:  return "cache_misses";
+        case HardwareEvent::BRANCH_MISSES: return "branch_misses";
+        default:                           return "unknown";
+    }
+}
+
+bool armor::profile::readHardwareCounters(HardwareSample& sample) {
+    return threadCounters.read(sample);
+}
+
+std::string armor::profile::hardwareCountersError() {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return openError;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cassert>
+#include <cstdint>
+
+#include "hash_multiset.hpp"
+
+namespace {
+
+    // splitmix64 finalizer; the two sums mix with different offsets so a
+    // set of hashes cancelling in one sum does not cancel in the other
+    uint64_t mix(uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    constexpr uint64_t FIRST_OFFSET = 0x9e3779b97f4a7c15ULL;
+    constexpr uint64_t SECOND_OFFSET = 0xd6e8feb86659fd93ULL;
+
+}
+
+HashMultiset::Fingerprint HashMultiset::fingerprintOf(uint64_t hash) {
+    Fingerprint single;
+    single.total = 1;
+    single.sum = mix(hash + FIRST_OFFSET);
+    single.mixedSum = mix(hash ^ SECOND_OFFSET);
+    return single;
+}
+
+void HashMultiset::account(uint64_t hash, int64_t count) {
+    // Unsigned arithmetic wraps, so a removal undoes its insertion exactly
+    uint64_t times = static_cast<uint64_t>(count);
+    Fingerprint single = fingerprintOf(hash);
+    fingerprint.total += times;
+    fingerprint.sum += single.sum * times;
+    fingerprint.mixedSum += single.mixedSum * times;
+}
+
+void HashMultiset::insert(uint64_t hash, int count) {
+    assert(count > 0);
+    counts[hash] += count;
+    account(hash, count);
+}
+
+bool HashMultiset::eraseOne(uint64_t hash) {
+    auto it = counts.find(hash);
+    if (it == counts.end()) {
+        return false;
+    }
+    if (--it->second <= 0) {
+        counts.erase(it);
+    }
+    account(hash, -1);
+    return true;
+}
+
+void HashMultiset::clear() {
+    counts.clear();
+    fingerprint = Fingerprint();
+}
+
+int HashMultiset::count(uint64_t hash) const {
+    auto it = counts.find(hash);
+    return it == counts.end() ? 0 : it->second;
+}
+
+bool HashMultiset::differs(const HashMultiset& other) const {
+    return fingerprint != other.fingerprint;
+}
+
+bool HashMultiset::countsDiffer(const HashMultiset& other) const {
+    if (counts.size() != other.counts.size()) {
+        return true;
+    }
+    for (const auto& [hash, count] : counts) {
+        if (other.count(hash) != count) {
+            return true;
+        }
+    }
+    return false;
+}
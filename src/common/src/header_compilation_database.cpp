@@ -0,0 +1,33 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/Tooling.h"
+
+#include "header_compilation_database.hpp"
+
+void armor::HeaderCompilationDatabase::addHeader(const std::string& headerPath, const std::string& directory,
+                                                 const std::vector<std::string>& flags) {
+    headers.insert_or_assign(clang::tooling::getAbsolutePath(headerPath),
+                             std::make_unique<clang::tooling::FixedCompilationDatabase>(directory, flags));
+}
+
+std::vector<clang::tooling::CompileCommand>
+armor::HeaderCompilationDatabase::getCompileCommands(llvm::StringRef filePath) const {
+    auto it = headers.find(clang::tooling::getAbsolutePath(filePath));
+    if (it == headers.end()) {
+        return {};
+    }
+    return it->second->getCompileCommands(filePath);
+}
+
+std::vector<std::string> armor::HeaderCompilationDatabase::getAllFiles() const {
+    std::vector<std::string> files;
+    files.reserve(headers.size());
+    for (const auto& entry : headers) {
+        files.push_back(entry.getKey().str());
+    }
+    return files;
+}
@@ -0,0 +1,150 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "header_costs.hpp"
+
+namespace {
+
+    constexpr int HISTORY_FORMAT_VERSION = 1;
+
+    // What one include adds to a header's cost, as the bytes of a typical included header
+    constexpr double INCLUDE_COST = 16384;
+
+}
+
+armor::HeaderCostHistory armor::HeaderCostHistory::load(const std::string& path) {
+    HeaderCostHistory history;
+    if (!llvm::sys::fs::exists(path)) {
+        return history;
+    }
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open cost history file: " + path);
+    }
+    try {
+        nlohmann::json root = nlohmann::json::parse(file);
+        if (root.at("format").get<int>() != HISTORY_FORMAT_VERSION) {
+            throw std::runtime_error("unsupported format " + root.at("format").dump());
+        }
+        for (const auto& entry : root.at("headers").items()) {
+            history.headers[entry.key()] = entry.value().get<double>();
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Malformed cost history file " + path + ": " + e.what());
+    }
+    return history;
+}
+
+void armor::HeaderCostHistory::save(const std::string& path) const {
+    nlohmann::json root = {{"format", HISTORY_FORMAT_VERSION}, {"headers", headers}};
+    // Written next to the history and renamed, so an interrupted run leaves the previous one
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        out << root.dump(2) << "\n";
+        if (!out) {
+            std::remove(tempPath.c_str());
+            throw std::runtime_error("Failed to write cost history file: " + path);
+        }
+    }
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path)) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Failed to write cost history file " + path + ": " + ec.message());
+    }
+}
+
+bool armor::HeaderCostHistory::find(const std::string& header, double& seconds) const {
+    auto it = headers.find(header);
+    if (it == headers.end()) {
+        return false;
+    }
+    seconds = it->second;
+    return true;
+}
+
+void armor::HeaderCostHistory::record(const std::string& header, double seconds) {
+    headers[header] = seconds;
+}
+
+unsigned armor::countIncludeDirectives(llvm::StringRef contents) {
+    unsigned count = 0;
+    while (!contents.empty()) {
+        llvm::StringRef line;
+        std::tie(line, contents) = contents.split('\n');
+        line = line.ltrim();
+        if (!line.consume_front("#")) {
+            continue;
+        }
+        line = line.ltrim();
+        if (line.startswith("include") || line.startswith("import")) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+double armor::estimateHeaderCost(uint64_t bytes, unsigned includeCount) {
+    return static_cast<double>(bytes) + includeCount * INCLUDE_COST;
+}
+
+std::vector<double> armor::predictHeaderCosts(const std::vector<std::string>& headers,
+                                              const std::vector<double>& estimates,
+                                              const HeaderCostHistory& history) {
+    std::vector<double> costs(headers.size());
+    std::vector<bool> measured(headers.size(), false);
+    double measuredSeconds = 0;
+    double measuredUnits = 0;
+    for (size_t i = 0; i < headers.size(); ++i) {
+        double seconds = 0;
+        if (history.find(headers[i], seconds)) {
+            costs[i] = seconds;
+            measured[i] = true;
+            measuredSeconds += seconds;
+            measuredUnits += estimates[i];
+        }
+    }
+    double secondsPerUnit = measuredSeconds > 0 && measuredUnits > 0 ? measuredSeconds / measuredUnits : 1;
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (!measured[i]) {
+            costs[i] = estimates[i] * secondsPerUnit;
+        }
+    }
+    return costs;
+}
+
+std::vector<std::size_t> armor::longestFirstOrder(const std::vector<double>& costs) {
+    std::vector<std::size_t> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&costs](std::size_t a, std::size_t b) { return costs[a] > costs[b]; });
+    return order;
+}
+
+std::vector<unsigned> armor::partitionByCost(const std::vector<double>& costs, unsigned shardCount) {
+    std::vector<unsigned> shards(costs.size(), 0);
+    if (shardCount <= 1) {
+        return shards;
+    }
+    std::vector<double> totals(shardCount, 0);
+    for (std::size_t i : longestFirstOrder(costs)) {
+        unsigned lightest = static_cast<unsigned>(std::min_element(totals.begin(), totals.end()) - totals.begin());
+        shards[i] = lightest;
+        totals[lightest] += costs[i];
+    }
+    return shards;
+}
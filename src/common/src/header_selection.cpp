@@ -0,0 +1,293 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/GlobPattern.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLParser.h"
+#include <nlohmann/json.hpp>
+
+#include "header_selection.hpp"
+#include "work_pool.hpp"
+
+namespace {
+
+    const std::vector<std::string> HEADER_EXTENSIONS = {".h", ".hpp"};
+
+    bool hasExtension(const std::string& name, const std::vector<std::string>& extensions) {
+        return std::any_of(extensions.begin(), extensions.end(),
+                           [&](const std::string& extension) { return llvm::StringRef(name).endswith(extension); });
+    }
+
+    // What a walk leaves out: paths and file names matching a glob
+    using IgnoreList = std::vector<llvm::GlobPattern>;
+
+    IgnoreList compileIgnorePatterns(const std::vector<std::string>& patterns) {
+        IgnoreList globs;
+        for (const std::string& pattern : patterns) {
+            llvm::Expected<llvm::GlobPattern> glob = llvm::GlobPattern::create(pattern);
+            if (!glob) {
+                throw std::runtime_error("Invalid ignore pattern '" + pattern + "': " + llvm::toString(glob.takeError()));
+            }
+            globs.push_back(std::move(*glob));
+        }
+        return globs;
+    }
+
+    bool isIgnored(const IgnoreList& ignore, const std::string& relative, const std::string& name) {
+        return std::any_of(ignore.begin(), ignore.end(), [&](const llvm::GlobPattern& glob) {
+            return glob.match(relative) || glob.match(name);
+        });
+    }
+
+    // Lists the matching files below `dir`, relative to `root`
+    void walkDirectory(const std::filesystem::path& root, const std::filesystem::path& dir,
+                       const std::vector<std::string>& extensions, const IgnoreList& ignore,
+                       std::vector<std::string>& files) {
+        std::error_code ec;
+        for (std::filesystem::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code statusError;
+            if (it->is_symlink(statusError)) {
+                continue;
+            }
+            std::string name = it->path().filename().string();
+            std::string relative = it->path().lexically_relative(root).generic_string();
+            if (it->is_directory(statusError)) {
+                if (isIgnored(ignore, relative, name)) {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            if (it->is_regular_file(statusError) && hasExtension(name, extensions) &&
+                !isIgnored(ignore, relative, name)) {
+                files.push_back(std::move(relative));
+            }
+        }
+    }
+
+    /**
+     * Lists the matching files under every root, each relative to its root,
+     * sorted. Every subdirectory at the top of a root is walked by a task of
+     * its own; the files at the top of a root are listed here.
+     */
+    std::vector<std::vector<std::string>> walkRoots(const std::vector<std::string>& roots,
+                                                    const std::vector<std::string>& extensions,
+                                                    const IgnoreList& ignore, unsigned jobs) {
+        std::vector<std::vector<std::string>> files(roots.size());
+        // (root index, subdirectory)
+        std::vector<std::pair<std::size_t, std::filesystem::path>> subdirectories;
+        for (std::size_t r = 0; r < roots.size(); ++r) {
+            std::filesystem::path root(roots[r]);
+            std::error_code ec;
+            for (std::filesystem::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+                std::error_code statusError;
+                std::string name = it->path().filename().string();
+                if (it->is_symlink(statusError) || isIgnored(ignore, name, name)) {
+                    continue;
+                }
+                if (it->is_directory(statusError)) {
+                    subdirectories.emplace_back(r, it->path());
+                }
+                else if (it->is_regular_file(statusError) && hasExtension(name, extensions)) {
+                    files[r].push_back(name);
+                }
+            }
+        }
+
+        std::vector<std::vector<std::string>> found(subdirectories.size());
+        armor::parallelFor(subdirectories.size(), jobs, [&](std::size_t i) {
+            const auto& [r, dir] = subdirectories[i];
+            walkDirectory(roots[r], dir, extensions, ignore, found[i]);
+        });
+        for (std::size_t i = 0; i < subdirectories.size(); ++i) {
+            std::vector<std::string>& rootFiles = files[subdirectories[i].first];
+            rootFiles.insert(rootFiles.end(), std::make_move_iterator(found[i].begin()),
+                             std::make_move_iterator(found[i].end()));
+        }
+        for (std::vector<std::string>& rootFiles : files) {
+            std::sort(rootFiles.begin(), rootFiles.end());
+        }
+        return files;
+    }
+
+    // The whole document, as YAML nodes can only be visited once and in order
+    nlohmann::json toJson(llvm::yaml::Node* node) {
+        if (auto* scalar = llvm::dyn_cast_or_null<llvm::yaml::ScalarNode>(node)) {
+            llvm::SmallString<64> storage;
+            return scalar->getValue(storage).str();
+        }
+        if (auto* sequence = llvm::dyn_cast_or_null<llvm::yaml::SequenceNode>(node)) {
+            nlohmann::json items = nlohmann::json::array();
+            for (llvm::yaml::Node& item : *sequence) {
+                items.push_back(toJson(&item));
+            }
+            return items;
+        }
+        if (auto* mapping = llvm::dyn_cast_or_null<llvm::yaml::MappingNode>(node)) {
+            nlohmann::json members = nlohmann::json::object();
+            for (llvm::yaml::KeyValueNode& entry : *mapping) {
+                nlohmann::json key = toJson(entry.getKey());
+                nlohmann::json value = toJson(entry.getValue());
+                if (key.is_string()) {
+                    members[key.get<std::string>()] = std::move(value);
+                }
+            }
+            return members;
+        }
+        return nullptr;
+    }
+
+    // The strings listed at modes.<mode>.headers of a branch
+    std::vector<std::string> headersOf(const nlohmann::json& modes, const char* mode) {
+        std::vector<std::string> headers;
+        if (!modes.is_object() || !modes.contains(mode) || !modes[mode].is_object() ||
+            !modes[mode].contains("headers") || !modes[mode]["headers"].is_array()) {
+            return headers;
+        }
+        for (const nlohmann::json& header : modes[mode]["headers"]) {
+            if (header.is_string()) {
+                headers.push_back(header.get<std::string>());
+            }
+        }
+        return headers;
+    }
+
+    bool isGlob(llvm::StringRef pattern) {
+        return pattern.find_first_of("*?[") != llvm::StringRef::npos;
+    }
+
+    // Appends the headers of `files` (sorted) that `pattern` selects
+    void expand(llvm::StringRef pattern, const std::vector<std::string>& files, const std::vector<std::string>& roots,
+                std::vector<std::string>& selected) {
+        pattern = pattern.trim();
+        if (pattern.startswith("./")) {
+            pattern = pattern.drop_front(2);
+        }
+        if (pattern.empty()) {
+            return;
+        }
+
+        bool directory = pattern.endswith("/");
+        for (size_t r = 0; r < roots.size() && !directory; ++r) {
+            std::error_code ec;
+            directory = std::filesystem::is_directory(std::filesystem::path(roots[r]) / pattern.str(), ec);
+        }
+        if (directory) {
+            std::string prefix = pattern.rtrim('/').str() + "/";
+            auto first = std::lower_bound(files.begin(), files.end(), prefix);
+            for (auto it = first; it != files.end() && llvm::StringRef(*it).startswith(prefix); ++it) {
+                selected.push_back(*it);
+            }
+            return;
+        }
+
+        if (isGlob(pattern)) {
+            llvm::Expected<llvm::GlobPattern> glob = llvm::GlobPattern::create(pattern);
+            if (!glob) {
+                throw std::runtime_error("Invalid header pattern '" + pattern.str() + "': " +
+                                         llvm::toString(glob.takeError()));
+            }
+            std::copy_if(files.begin(), files.end(), std::back_inserter(selected),
+                         [&](const std::string& file) { return glob->match(file); });
+            return;
+        }
+
+        if (std::binary_search(files.begin(), files.end(), pattern.str())) {
+            selected.push_back(pattern.str());
+        }
+    }
+
+    std::vector<std::string> expandAll(const std::vector<std::string>& patterns, const std::vector<std::string>& files,
+                                       const std::vector<std::string>& roots) {
+        std::vector<std::string> selected;
+        for (const std::string& pattern : patterns) {
+            expand(pattern, files, roots, selected);
+        }
+        std::sort(selected.begin(), selected.end());
+        selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+        return selected;
+    }
+
+}
+
+std::vector<std::string> armor::walkHeaderFiles(const std::vector<std::string>& roots,
+                                                const std::vector<std::string>& extensions, unsigned jobs) {
+    std::vector<std::string> files;
+    for (std::vector<std::string>& rootFiles : walkRoots(roots, extensions, IgnoreList(), jobs)) {
+        files.insert(files.end(), std::make_move_iterator(rootFiles.begin()), std::make_move_iterator(rootFiles.end()));
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+armor::HeaderDiscovery armor::discoverHeaderPairs(const std::string& dir1, const std::string& dir2,
+                                                  const std::vector<std::string>& extensions,
+                                                  const std::vector<std::string>& ignorePatterns, unsigned jobs) {
+    std::vector<std::vector<std::string>> files =
+        walkRoots({dir1, dir2}, extensions, compileIgnorePatterns(ignorePatterns), jobs);
+    const std::vector<std::string>& older = files[0];
+    const std::vector<std::string>& newer = files[1];
+    HeaderDiscovery discovery;
+    std::set_intersection(older.begin(), older.end(), newer.begin(), newer.end(),
+                          std::back_inserter(discovery.common));
+    std::set_difference(older.begin(), older.end(), newer.begin(), newer.end(),
+                        std::back_inserter(discovery.removed));
+    std::set_difference(newer.begin(), newer.end(), older.begin(), older.end(),
+                        std::back_inserter(discovery.added));
+    return discovery;
+}
+
+armor::HeaderPatterns armor::loadHeaderPatterns(const std::string& configFile, const std::string& branch) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(configFile);
+    if (!buffer) {
+        throw std::runtime_error("Failed to read header config " + configFile + ": " + buffer.getError().message());
+    }
+
+    llvm::SourceMgr sourceManager;
+    std::string diagnostics;
+    sourceManager.setDiagHandler([](const llvm::SMDiagnostic& diagnostic, void* context) {
+        *static_cast<std::string*>(context) = diagnostic.getMessage().str();
+    }, &diagnostics);
+    llvm::yaml::Stream stream((*buffer)->getBuffer(), sourceManager);
+    nlohmann::json config;
+    for (llvm::yaml::Document& document : stream) {
+        config = toJson(document.getRoot());
+        break;
+    }
+    if (stream.failed()) {
+        throw std::runtime_error("Invalid header config " + configFile + ": " + diagnostics);
+    }
+    nlohmann::json modes;
+    if (config.is_object() && config.contains("branches") && config["branches"].is_object() &&
+        config["branches"].contains(branch) && config["branches"][branch].is_object()) {
+        modes = config["branches"][branch].value("modes", nlohmann::json());
+    }
+    HeaderPatterns patterns;
+    patterns.blocking = headersOf(modes, "blocking");
+    patterns.nonBlocking = headersOf(modes, "non-blocking");
+    return patterns;
+}
+
+armor::HeaderSelection armor::selectHeaders(const HeaderPatterns& patterns, const std::vector<std::string>& roots,
+                                            unsigned jobs) {
+    std::vector<std::string> files = walkHeaderFiles(roots, HEADER_EXTENSIONS, jobs);
+    HeaderSelection selection;
+    selection.blocking = expandAll(patterns.blocking, files, roots);
+    selection.nonBlocking = expandAll(patterns.nonBlocking, files, roots);
+    std::set_union(selection.blocking.begin(), selection.blocking.end(),
+                   selection.nonBlocking.begin(), selection.nonBlocking.end(),
+                   std::back_inserter(selection.headers));
+    return selection;
+}
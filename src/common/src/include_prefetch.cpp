@@ -0,0 +1,205 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include "include_prefetch.hpp"
+#include "logger.hpp"
+
+namespace {
+
+    std::atomic<unsigned> gPrefetchDepth{0};
+
+    // Whole contents of `path`, advised as needed first; false if it cannot be read
+    bool readAhead(const std::string& path, std::string& contents) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+#ifdef POSIX_FADV_WILLNEED
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+        contents.clear();
+        char chunk[16384];
+        ssize_t n;
+        while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+            contents.append(chunk, static_cast<std::size_t>(n));
+        }
+        ::close(fd);
+        return n == 0;
+    }
+
+    struct IncludeDirective {
+        llvm::StringRef spelling;
+        bool quoted;
+        bool next;
+    };
+
+    // The include directives of `text` with a literal file name, conditionals ignored
+    std::vector<IncludeDirective> scanIncludes(llvm::StringRef text) {
+        std::vector<IncludeDirective> directives;
+        while (!text.empty()) {
+            auto [line, rest] = text.split('\n');
+            text = rest;
+            line = line.ltrim(" \t");
+            if (!line.consume_front("#")) {
+                continue;
+            }
+            line = line.ltrim(" \t");
+            bool next = line.consume_front("include_next");
+            if (!next && !line.consume_front("include") && !line.consume_front("import")) {
+                continue;
+            }
+            line = line.ltrim(" \t");
+            char close = line.startswith("\"") ? '"' : line.startswith("<") ? '>' : '\0';
+            if (close == '\0') {
+                continue;
+            }
+            std::size_t end = line.find(close, 1);
+            if (end == llvm::StringRef::npos || end == 1) {
+                continue;
+            }
+            directives.push_back({line.substr(1, end - 1), close == '"', next});
+        }
+        return directives;
+    }
+
+    std::string joined(llvm::StringRef dir, llvm::StringRef spelling) {
+        llvm::SmallString<256> path(dir);
+        llvm::sys::path::append(path, spelling);
+        llvm::sys::path::remove_dots(path, true);
+        return std::string(path);
+    }
+
+    // The file `directive` in `includerDir` names, or empty if none is found
+    std::string resolve(const IncludeDirective& directive, llvm::StringRef includerDir,
+                        const std::vector<std::string>& includeDirs) {
+        if (llvm::sys::path::is_absolute(directive.spelling)) {
+            return llvm::sys::fs::is_regular_file(directive.spelling) ? directive.spelling.str() : std::string();
+        }
+        if (directive.quoted && !directive.next) {
+            std::string candidate = joined(includerDir, directive.spelling);
+            if (llvm::sys::fs::is_regular_file(candidate)) {
+                return candidate;
+            }
+        }
+        // An #include_next may name a file of any directory after the includer's; all are warmed
+        for (const std::string& dir : includeDirs) {
+            std::string candidate = joined(dir, directive.spelling);
+            if (llvm::sys::fs::is_regular_file(candidate)) {
+                return candidate;
+            }
+        }
+        return std::string();
+    }
+
+}
+
+void armor::setIncludePrefetchDepth(unsigned depth) {
+    gPrefetchDepth = depth;
+}
+
+unsigned armor::includePrefetchDepth() {
+    return gPrefetchDepth;
+}
+
+std::vector<std::string> armor::includeDirsOf(const std::vector<std::string>& commandLine,
+                                              const std::string& directory) {
+    // Search order of the flags; the value follows the flag or is glued to it
+    static const char* const FLAGS[] = {"-iquote", "-I", "-isystem", "-idirafter"};
+    std::vector<std::string> groups[4];
+    for (std::size_t a = 0; a < commandLine.size(); ++a) {
+        llvm::StringRef arg = commandLine[a];
+        for (std::size_t f = 0; f < 4; ++f) {
+            if (!arg.startswith(FLAGS[f])) {
+                continue;
+            }
+            llvm::StringRef value = arg.substr(llvm::StringRef(FLAGS[f]).size());
+            if (value.empty() && a + 1 < commandLine.size()) {
+                value = commandLine[++a];
+            }
+            if (!value.empty()) {
+                groups[f].push_back(llvm::sys::path::is_absolute(value) ? value.str() : joined(directory, value));
+            }
+            break;
+        }
+    }
+    std::vector<std::string> dirs;
+    for (std::vector<std::string>& group : groups) {
+        dirs.insert(dirs.end(), std::make_move_iterator(group.begin()), std::make_move_iterator(group.end()));
+    }
+    return dirs;
+}
+
+std::size_t armor::prefetchIncludeClosure(const std::string& file, const std::vector<std::string>& includeDirs,
+                                          llvm::StringSet<>& visited, const std::atomic<bool>* cancel) {
+    std::size_t read = 0;
+    std::vector<std::string> pending{joined("", file)};
+    std::string contents;
+    while (!pending.empty() && !(cancel && *cancel)) {
+        std::string path = std::move(pending.back());
+        pending.pop_back();
+        if (!visited.insert(path).second || !readAhead(path, contents)) {
+            continue;
+        }
+        ++read;
+        llvm::StringRef includerDir = llvm::sys::path::parent_path(path);
+        for (const IncludeDirective& directive : scanIncludes(contents)) {
+            std::string included = resolve(directive, includerDir, includeDirs);
+            if (!included.empty() && !visited.count(included)) {
+                pending.push_back(std::move(included));
+            }
+        }
+    }
+    return read;
+}
+
+armor::IncludePrefetcher::IncludePrefetcher(std::vector<Header> headers, std::size_t ahead)
+    : headers(std::move(headers)), ahead(ahead) {
+    if (!this->headers.empty() && ahead > 0) {
+        worker = std::thread([this]() { run(); });
+    }
+}
+
+armor::IncludePrefetcher::~IncludePrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    progress.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    armor::debug() << "Prefetched " << readCount << " include files for " << headers.size() << " headers\n";
+}
+
+void armor::IncludePrefetcher::headerDone() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++done;
+    }
+    progress.notify_all();
+}
+
+void armor::IncludePrefetcher::run() {
+    llvm::StringSet<> visited;
+    for (std::size_t h = 0; h < headers.size(); ++h) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            progress.wait(lock, [&]() { return stopping || h < done + ahead; });
+            if (stopping) {
+                return;
+            }
+        }
+        readCount += prefetchIncludeClosure(headers[h].file, headers[h].includeDirs, visited, &stopping);
+    }
+}
@@ -0,0 +1,95 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+
+#include "header_selection.hpp"
+#include "include_resolver.hpp"
+
+namespace {
+
+    // Everything a project may #include besides sources
+    const std::vector<std::string> INCLUDE_EXTENSIONS = {".h", ".hh", ".hpp", ".hxx", ".inc", ".def", ".ipp", ".tcc"};
+
+    // Number of leading path components `a` and `b` share
+    size_t sharedComponents(llvm::StringRef a, llvm::StringRef b) {
+        size_t shared = 0;
+        auto itA = llvm::sys::path::begin(a, llvm::sys::path::Style::posix);
+        auto itB = llvm::sys::path::begin(b, llvm::sys::path::Style::posix);
+        auto endA = llvm::sys::path::end(a);
+        auto endB = llvm::sys::path::end(b);
+        for (; itA != endA && itB != endB && *itA == *itB; ++itA, ++itB) {
+            ++shared;
+        }
+        return shared;
+    }
+
+}
+
+armor::IncludeResolver::IncludeResolver(std::string root, const std::vector<std::string>& headers)
+    : root(std::move(root)), headerCount(headers.size()) {
+    for (const std::string& header : headers) {
+        byName[llvm::sys::path::filename(header, llvm::sys::path::Style::posix)].push_back(header);
+    }
+}
+
+std::shared_ptr<const armor::IncludeResolver> armor::IncludeResolver::forRoot(const std::string& root) {
+    static std::mutex sMutex;
+    static std::map<std::string, std::shared_ptr<const IncludeResolver>> sResolvers;
+    std::lock_guard<std::mutex> lock(sMutex);
+    std::shared_ptr<const IncludeResolver>& resolver = sResolvers[root];
+    if (!resolver) {
+        unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+        resolver = std::make_shared<IncludeResolver>(root, walkHeaderFiles({root}, INCLUDE_EXTENSIONS, jobs));
+    }
+    return resolver;
+}
+
+std::string armor::IncludeResolver::resolve(llvm::StringRef spelling, llvm::StringRef includer) const {
+    spelling = spelling.trim();
+    while (spelling.startswith("./")) {
+        spelling = spelling.drop_front(2);
+    }
+    if (spelling.empty() || spelling.startswith("/")) {
+        return std::string();
+    }
+    for (auto it = llvm::sys::path::begin(spelling, llvm::sys::path::Style::posix),
+              end = llvm::sys::path::end(spelling); it != end; ++it) {
+        if (*it == "..") {
+            return std::string();
+        }
+    }
+
+    auto candidates = byName.find(llvm::sys::path::filename(spelling, llvm::sys::path::Style::posix));
+    if (candidates == byName.end()) {
+        return std::string();
+    }
+    llvm::StringRef includerDir = llvm::sys::path::parent_path(includer);
+    std::string best;
+    size_t bestShared = 0;
+    for (const std::string& header : candidates->getValue()) {
+        llvm::StringRef path(header);
+        if (path != spelling && !(path.endswith(spelling) && path.drop_back(spelling.size()).endswith("/"))) {
+            continue;
+        }
+        llvm::SmallString<256> dir(root);
+        llvm::sys::path::append(dir, path.drop_back(spelling.size()));
+        llvm::sys::path::remove_dots(dir);
+        while (dir.size() > 1 && llvm::sys::path::is_separator(dir.back())) {
+            dir.pop_back();
+        }
+        // Ties keep the first directory, in path order
+        size_t shared = sharedComponents(dir, includerDir);
+        if (best.empty() || shared > bestShared) {
+            best = dir.str().str();
+            bestShared = shared;
+        }
+    }
+    return best;
+}
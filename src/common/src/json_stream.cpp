@@ -0,0 +1,101 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cassert>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "json_stream.hpp"
+
+namespace {
+
+    constexpr size_t INDENT_STEP = 4;
+
+}
+
+void armor::JsonStreamWriter::newline(size_t depth) {
+    out << '\n' << std::string(depth * INDENT_STEP, ' ');
+}
+
+void armor::JsonStreamWriter::beginValue() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (frames.empty()) {
+        return;
+    }
+    Frame& frame = frames.back();
+    assert(frame.isArray && "object members need a key");
+    if (!frame.empty) {
+        out << ',';
+    }
+    frame.empty = false;
+    newline(frames.size());
+}
+
+void armor::JsonStreamWriter::open(char bracket, bool isArray) {
+    beginValue();
+    out << bracket;
+    frames.push_back({isArray, true});
+}
+
+void armor::JsonStreamWriter::close(char bracket) {
+    assert(!frames.empty() && !afterKey);
+    bool empty = frames.back().empty;
+    frames.pop_back();
+    if (!empty) {
+        newline(frames.size());
+    }
+    out << bracket;
+}
+
+void armor::JsonStreamWriter::beginObject() {
+    open('{', /*isArray=*/false);
+}
+
+void armor::JsonStreamWriter::endObject() {
+    assert(!frames.empty() && !frames.back().isArray);
+    close('}');
+}
+
+void armor::JsonStreamWriter::beginArray() {
+    open('[', /*isArray=*/true);
+}
+
+void armor::JsonStreamWriter::endArray() {
+    assert(!frames.empty() && frames.back().isArray);
+    close(']');
+}
+
+void armor::JsonStreamWriter::key(std::string_view name) {
+    assert(!frames.empty() && !frames.back().isArray && !afterKey);
+    Frame& frame = frames.back();
+    if (!frame.empty) {
+        out << ',';
+    }
+    frame.empty = false;
+    newline(frames.size());
+    out << nlohmann::json(name).dump() << ": ";
+    afterKey = true;
+}
+
+void armor::JsonStreamWriter::value(const nlohmann::json& value) {
+    beginValue();
+    std::string text = value.dump(INDENT_STEP);
+    if (frames.empty()) {
+        out << text;
+        return;
+    }
+
+    // dump() indents from column 0; strings never hold a raw newline, so
+    // every newline starts a line that needs the current depth prepended
+    std::string indent(frames.size() * INDENT_STEP, ' ');
+    size_t start = 0;
+    for (size_t pos = text.find('\n'); pos != std::string::npos; pos = text.find('\n', start)) {
+        out.write(text.data() + start, static_cast<std::streamsize>(pos + 1 - start));
+        out << indent;
+        start = pos + 1;
+    }
+    out.write(text.data() + start, static_cast<std::streamsize>(text.size() - start));
+}
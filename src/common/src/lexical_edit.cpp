@@ -0,0 +1,131 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "fibonacci_hash.hpp"
+#include "lexical_edit.hpp"
+
+namespace {
+
+    // Markers of lexicalTokens(); control bytes, which no token spells
+    constexpr char SEPARATED = '\x01';
+    constexpr char LINE_BREAK = '\x02';
+    constexpr char SPLICE = '\x03';
+
+    bool isIdentifierByte(unsigned char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' ||
+               c >= 0x80;
+    }
+
+    bool isPunctuatorByte(char c) {
+        return llvm::StringRef("+-*/%&|^!=<>:.#?").contains(c);
+    }
+
+    // Whether `left` and `right`, last and first bytes of two tokens, could lex
+    // as one token, or as other tokens, once the separation between them is gone
+    bool couldJoin(char left, char right) {
+        bool leftWord = isIdentifierByte(left) || left == '.';
+        bool rightWord = isIdentifierByte(right) || right == '.';
+        if ((leftWord && rightWord) || (isPunctuatorByte(left) && isPunctuatorByte(right))) {
+            return true;
+        }
+        // Encoding prefixes and literal suffixes: u8"s", L'c', "s"_x
+        if ((isIdentifierByte(left) && (right == '"' || right == '\'')) ||
+            ((left == '"' || left == '\'') && isIdentifierByte(right))) {
+            return true;
+        }
+        // Exponents of pp-numbers: 1e+5
+        return llvm::StringRef("eEpP").contains(left) && (right == '+' || right == '-');
+    }
+
+    struct Gap {
+        bool lineBreak = false;
+        bool splice = false;
+    };
+
+    // What the whitespace, comments and line splices of `gap` amount to; a
+    // newline inside a comment or after a splice breaks no line
+    Gap scanGap(llvm::StringRef gap) {
+        Gap result;
+        std::size_t i = 0;
+        while (i < gap.size()) {
+            char c = gap[i];
+            if (c == '\\') {
+                result.splice = true;
+                std::size_t newline = gap.find('\n', i);
+                i = newline == llvm::StringRef::npos ? gap.size() : newline + 1;
+            }
+            else if (c == '/' && i + 1 < gap.size() && gap[i + 1] == '*') {
+                std::size_t close = gap.find("*/", i + 2);
+                i = close == llvm::StringRef::npos ? gap.size() : close + 2;
+            }
+            else if (c == '/' && i + 1 < gap.size() && gap[i + 1] == '/') {
+                // The comment runs to the first newline its line does not splice
+                std::size_t newline = gap.find('\n', i + 2);
+                while (newline != llvm::StringRef::npos && gap.substr(0, newline).rtrim(" \t\r").endswith("\\")) {
+                    result.splice = true;
+                    newline = gap.find('\n', newline + 1);
+                }
+                i = newline == llvm::StringRef::npos ? gap.size() : newline;
+            }
+            else {
+                result.lineBreak |= c == '\n';
+                ++i;
+            }
+        }
+        return result;
+    }
+
+    bool startsDirective(llvm::StringRef text) {
+        return text.startswith("#") || text.startswith("%:");
+    }
+
+}
+
+std::string armor::lexicalTokens(llvm::StringRef text) {
+    std::string tokens;
+    tokens.reserve(text.size());
+    std::size_t previousEnd = 0;
+    bool atLineStart = true;
+    bool inDirective = false;
+    FibonacciHash::forEachNormalizedRun(text, 0, text.size(), [&](std::size_t offset, std::size_t length) {
+        if (offset > previousEnd) {
+            Gap gap = scanGap(text.slice(previousEnd, offset));
+            bool separated = previousEnd > 0;
+            if (gap.splice) {
+                tokens += SPLICE;
+            }
+            if (gap.lineBreak) {
+                bool directiveEdge = inDirective || startsDirective(text.substr(offset));
+                if (directiveEdge && separated) {
+                    tokens += LINE_BREAK;
+                }
+                else if (separated && couldJoin(text[previousEnd - 1], text[offset])) {
+                    tokens += SEPARATED;
+                }
+                atLineStart = true;
+                inDirective = false;
+            }
+            else if (separated && (inDirective || couldJoin(text[previousEnd - 1], text[offset]))) {
+                tokens += SEPARATED;
+            }
+        }
+        if (atLineStart) {
+            inDirective = startsDirective(text.substr(offset));
+            atLineStart = false;
+        }
+        tokens.append(text.data() + offset, length);
+        previousEnd = offset + length;
+    });
+    return tokens;
+}
+
+armor::LexicalEdit armor::classifyLexicalEdit(llvm::StringRef text1, llvm::StringRef text2) {
+    if (lexicalTokens(text1) != lexicalTokens(text2)) {
+        return LexicalEdit::TOKENS;
+    }
+    return FibonacciHash::digest(text1) == FibonacciHash::digest(text2) ? LexicalEdit::WHITESPACE
+                                                                        : LexicalEdit::COMMENTS;
+}
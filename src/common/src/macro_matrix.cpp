@@ -0,0 +1,191 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/YAMLTraits.h"
+
+#include "categorization.hpp"
+#include "macro_matrix.hpp"
+#include "report_format.hpp"
+#include "report_merge.hpp"
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(armor::MacroConfiguration)
+
+namespace llvm::yaml {
+
+    template <>
+    struct MappingTraits<armor::MacroConfiguration> {
+        static void mapping(IO& io, armor::MacroConfiguration& configuration) {
+            io.mapRequired("name", configuration.name);
+            io.mapOptional("macro-flags", configuration.macroFlags);
+        }
+    };
+
+}
+
+namespace {
+
+    std::string findingKey(const ChangeRecord& record) {
+        std::string key;
+        key.reserve(record.headerfile.size() + record.name.size() + record.description.size() + 5);
+        key += record.headerfile;
+        key += '\0';
+        key += record.name;
+        key += '\0';
+        key += record.description;
+        key += '\0';
+        key += record.compatibilityChanged ? '1' : '0';
+        key += record.backwardIncompatible ? '1' : '0';
+        return key;
+    }
+
+}
+
+bool armor::isValidConfigurationName(const std::string& name) {
+    if (name.empty() || name == "." || name == "..") {
+        return false;
+    }
+    for (char c : name) {
+        bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                       c == '.' || c == '_' || c == '-';
+        if (!allowed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<armor::MacroConfiguration> armor::loadMacroMatrix(const std::string& path) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        throw std::runtime_error("Failed to read macro matrix " + path + ": " + buffer.getError().message());
+    }
+
+    std::vector<MacroConfiguration> configurations;
+    std::string diagnostics;
+    llvm::yaml::Input in((*buffer)->getBuffer(), nullptr,
+                         [](const llvm::SMDiagnostic& diagnostic, void* context) {
+                             *static_cast<std::string*>(context) = diagnostic.getMessage().str();
+                         },
+                         &diagnostics);
+    in >> configurations;
+    if (in.error()) {
+        throw std::runtime_error("Malformed macro matrix " + path + ": " + diagnostics);
+    }
+    if (configurations.empty()) {
+        throw std::runtime_error("Macro matrix " + path + " lists no configurations");
+    }
+
+    std::unordered_set<std::string> names;
+    for (const MacroConfiguration& configuration : configurations) {
+        if (!isValidConfigurationName(configuration.name)) {
+            throw std::runtime_error("Invalid configuration name '" + configuration.name + "' in " + path);
+        }
+        if (!names.insert(configuration.name).second) {
+            throw std::runtime_error("Duplicate configuration name '" + configuration.name + "' in " + path);
+        }
+    }
+    return configurations;
+}
+
+std::size_t armor::MatrixReport::addConfiguration(const std::string& name, const std::string& root) {
+    MergedReports run;
+    std::size_t reports = run.addRun(root);
+
+    std::size_t configuration = configurations.size();
+    bool incompatible = run.hasBackwardIncompatible() || run.getGroups().hasBackwardIncompatible();
+    configurations.push_back({name, reports, incompatible});
+
+    for (const ApiChangeGroups::Group& group : run.getGroups()) {
+        ChangeRecord record = ChangeRecord::fromJson(group.toRecord());
+        auto [it, added] = index.try_emplace(findingKey(record), findings.size());
+        if (added) {
+            findings.push_back({std::move(record), {}});
+        }
+        findings[it->second].configurations.push_back(configuration);
+    }
+
+    parsedStatus = std::min(parsedStatus, run.getParsedStatus());
+    if (run.getUnparsedStatus() == UnParsedDiffStatus::CHANGED) {
+        unparsedStatus = UnParsedDiffStatus::CHANGED;
+    }
+    backwardIncompatible = backwardIncompatible || incompatible;
+    return reports;
+}
+
+std::string armor::MatrixReport::configurationList(const Finding& finding) const {
+    std::string list;
+    for (std::size_t configuration : finding.configurations) {
+        if (!list.empty()) {
+            list += ", ";
+        }
+        list += configurations[configuration].name;
+    }
+    return list;
+}
+
+nlohmann::json armor::MatrixReport::toJson() const {
+    json configurationsJson = json::array();
+    for (const Configuration& configuration : configurations) {
+        configurationsJson.push_back({
+            {"name",          configuration.name},
+            {"reports",       configuration.reports},
+            {"compatibility", configuration.backwardIncompatible ? "backward_incompatible" : "backward_compatible"}
+        });
+    }
+
+    json apiDiff = json::array();
+    for (const Finding& finding : findings) {
+        json row = finding.record.toJson();
+        json names = json::array();
+        for (std::size_t configuration : finding.configurations) {
+            names.push_back(configurations[configuration].name);
+        }
+        row["configurations"] = std::move(names);
+        apiDiff.push_back(std::move(row));
+    }
+
+    unsigned parsed = static_cast<unsigned>(parsedStatus);
+    unsigned unparsed = static_cast<unsigned>(unparsedStatus);
+    return json{{"api_diff",       std::move(apiDiff)},
+                {"compatibility",  backwardIncompatible ? "backward_incompatible" : "backward_compatible"},
+                {"configurations", std::move(configurationsJson)},
+                {"overall_status", getOverAllCategory(parsed, unparsed, !backwardIncompatible)},
+                {"parsed_status",  serialize(parsedStatus)},
+                {"reason",         getReasonForCategorization(parsed, unparsed, !backwardIncompatible)},
+                {"unparsed_staus", serialize(unparsedStatus)}};
+}
+
+void armor::MatrixReport::write(const OutputPaths& outputs) const {
+    // Findings of one API share its row, each description naming its configurations
+    ApiChangeGroups groups;
+    for (const Finding& finding : findings) {
+        ChangeRecord record = finding.record;
+        record.description += " [" + configurationList(finding) + "]";
+        groups.addRecord(std::move(record));
+    }
+
+    std::string aggCompatibility = backwardIncompatible ? "backward_incompatible" : "backward_compatible";
+    unsigned parsed = static_cast<unsigned>(parsedStatus);
+    unsigned unparsed = static_cast<unsigned>(unparsedStatus);
+    const char* overallStatus = getOverAllCategory(parsed, unparsed, !backwardIncompatible);
+    const char* reason = getReasonForCategorization(parsed, unparsed, !backwardIncompatible);
+
+    std::filesystem::create_directories(std::filesystem::path(outputs.matrixJsonFile()).parent_path());
+    generate_html_report(groups, outputs.matrixHtmlFile(), BETA_PARSER, parsed, unparsed,
+                         aggCompatibility, overallStatus, reason);
+    std::ofstream out(outputs.matrixJsonFile());
+    if (!out) {
+        throw std::runtime_error("Failed to write " + outputs.matrixJsonFile());
+    }
+    writeReportDocument(out, toJson(), ReportFormat::JSON);
+}
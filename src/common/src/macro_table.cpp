@@ -0,0 +1,126 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+
+#include "llvm/Support/xxhash.h"
+
+#include "macro_table.hpp"
+
+namespace {
+
+    // splitmix64 finalizer, as for HashMultiset's fingerprints
+    uint64_t mix(uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t nameHash(llvm::StringRef name) {
+        return llvm::xxHash64(name);
+    }
+
+    unsigned bucketOf(uint64_t hashOfName) {
+        return static_cast<unsigned>(hashOfName % MacroTable::BUCKETS);
+    }
+
+    uint64_t pairHash(uint64_t hashOfName, uint64_t definitionHash) {
+        return mix(hashOfName ^ mix(definitionHash + 0x9e3779b97f4a7c15ULL));
+    }
+
+}
+
+void MacroTable::define(llvm::StringRef name, uint64_t definitionHash) {
+    uint64_t hashOfName = nameHash(name);
+    Bucket& bucket = buckets[bucketOf(hashOfName)];
+    auto inserted = bucket.macros.try_emplace(name, definitionHash);
+    if (inserted.second) {
+        ++count;
+    }
+    else {
+        // Unsigned arithmetic wraps, so a removal undoes its insertion exactly
+        bucket.fingerprint -= pairHash(hashOfName, inserted.first->second);
+        inserted.first->second = definitionHash;
+    }
+    bucket.fingerprint += pairHash(hashOfName, definitionHash);
+}
+
+void MacroTable::undefine(llvm::StringRef name) {
+    uint64_t hashOfName = nameHash(name);
+    Bucket& bucket = buckets[bucketOf(hashOfName)];
+    auto it = bucket.macros.find(name);
+    if (it == bucket.macros.end()) {
+        return;
+    }
+    bucket.fingerprint -= pairHash(hashOfName, it->second);
+    bucket.macros.erase(it);
+    --count;
+}
+
+bool MacroTable::lookup(llvm::StringRef name, uint64_t& definitionHash) const {
+    const Bucket& bucket = buckets[bucketOf(nameHash(name))];
+    auto it = bucket.macros.find(name);
+    if (it == bucket.macros.end()) {
+        return false;
+    }
+    definitionHash = it->second;
+    return true;
+}
+
+void MacroTable::forEach(llvm::function_ref<void(llvm::StringRef, uint64_t)> visit) const {
+    for (const Bucket& bucket : buckets) {
+        for (const auto& entry : bucket.macros) {
+            visit(entry.getKey(), entry.getValue());
+        }
+    }
+}
+
+void MacroTable::clear() {
+    for (Bucket& bucket : buckets) {
+        bucket.macros.clear();
+        bucket.fingerprint = 0;
+    }
+    count = 0;
+    directiveHashes.clear();
+}
+
+bool MacroTable::differs(const MacroTable& other) const {
+    if (count != other.count) {
+        return true;
+    }
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+        if (buckets[i].fingerprint != other.buckets[i].fingerprint ||
+            buckets[i].macros.size() != other.buckets[i].macros.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<MacroTable::Change> MacroTable::diff(const MacroTable& older, const MacroTable& newer) {
+    std::vector<Change> changes;
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+        const Bucket& before = older.buckets[i];
+        const Bucket& after = newer.buckets[i];
+        if (before.fingerprint == after.fingerprint && before.macros.size() == after.macros.size()) {
+            continue;
+        }
+        for (const auto& entry : before.macros) {
+            auto it = after.macros.find(entry.getKey());
+            if (it == after.macros.end()) {
+                changes.push_back({entry.getKey().str(), ChangeKind::Removed});
+            }
+            else if (it->getValue() != entry.getValue()) {
+                changes.push_back({entry.getKey().str(), ChangeKind::Modified});
+            }
+        }
+        for (const auto& entry : after.macros) {
+            if (!before.macros.count(entry.getKey())) {
+                changes.push_back({entry.getKey().str(), ChangeKind::Added});
+            }
+        }
+    }
+    std::sort(changes.begin(), changes.end(), [](const Change& lhs, const Change& rhs) {
+        return lhs.name < rhs.name;
+    });
+    return changes;
+}
@@ -0,0 +1,28 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <fstream>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "memory_usage.hpp"
+
+std::size_t armor::residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t totalPages = 0;
+    std::size_t residentPages = 0;
+    if (!(statm >> totalPages >> residentPages)) {
+        return 0;
+    }
+    long pageSize = sysconf(_SC_PAGESIZE);
+    return pageSize > 0 ? residentPages * static_cast<std::size_t>(pageSize) : 0;
+}
+
+std::size_t armor::peakResidentBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0 || usage.ru_maxrss < 0) {
+        return 0;
+    }
+    // Kilobytes on Linux
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+}
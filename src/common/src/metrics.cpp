@@ -0,0 +1,245 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include "llvm/Support/FileSystem.h"
+
+#include "memory_usage.hpp"
+#include "metrics.hpp"
+
+namespace {
+
+    const char* const REQUEST_KINDS[] = {"args", "compare", "invalid"};
+
+    int64_t steadyNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string escapeLabel(const std::string& value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                escaped += '\\';
+                escaped += c;
+            }
+            else if (c == '\n') {
+                escaped += "\\n";
+            }
+            else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    /**
+     * Writes series in the exposition format. Every series of a family
+     * follows its # HELP and # TYPE lines, and every one carries the labels
+     * of the process before its own.
+     */
+    class Exposition {
+        public:
+            explicit Exposition(const std::map<std::string, std::string>& labels) {
+                // Counts print whole up to 15 digits, and bounds and sums without rounding noise
+                out.precision(15);
+                for (const auto& [name, value] : labels) {
+                    common += (common.empty() ? "" : ",") + name + "=\"" + escapeLabel(value) + "\"";
+                }
+            }
+
+            void family(const char* name, const char* type, const char* help) {
+                out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+            }
+
+            void series(const std::string& name, const std::string& labels, double value) {
+                out << name;
+                if (!common.empty() || !labels.empty()) {
+                    out << "{" << common << (!common.empty() && !labels.empty() ? "," : "") << labels << "}";
+                }
+                out << " " << value << "\n";
+            }
+
+            std::string str() const { return out.str(); }
+
+        private:
+            std::string common;
+            std::ostringstream out;
+    };
+
+}
+
+armor::Metrics& armor::Metrics::getInstance() {
+    static Metrics inst;
+    return inst;
+}
+
+armor::Metrics::Metrics() : startTime(std::chrono::system_clock::now()) {}
+
+llvm::StringRef armor::Metrics::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::REQUEST:    return "request";
+        case Phase::CACHE_LOAD: return "cache_load";
+        case Phase::PARSE:      return "parse";
+        case Phase::DIFF:       return "diff";
+        case Phase::COUNT:      break;
+    }
+    return "unknown";
+}
+
+llvm::StringRef armor::Metrics::tierName(CacheTier tier) {
+    switch (tier) {
+        case CacheTier::MEMORY: return "memory";
+        case CacheTier::DISK:   return "disk";
+        case CacheTier::REMOTE: return "remote";
+        case CacheTier::AST:    return "ast";
+        case CacheTier::RESULT: return "result";
+        case CacheTier::COUNT:  break;
+    }
+    return "unknown";
+}
+
+void armor::Metrics::countRequest(llvm::StringRef kind, bool ok, std::chrono::nanoseconds elapsed) {
+    std::size_t i = 0;
+    while (i + 1 < REQUEST_KIND_COUNT && kind != REQUEST_KINDS[i]) {
+        ++i;
+    }
+    requests[i][ok ? 1 : 0].fetch_add(1, std::memory_order_relaxed);
+    observe(Phase::REQUEST, elapsed);
+}
+
+void armor::Metrics::observe(Phase phase, std::chrono::nanoseconds elapsed) {
+    Histogram& histogram = phases[static_cast<std::size_t>(phase)];
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    std::size_t bucket = 0;
+    while (bucket < BUCKET_BOUNDS.size() && seconds > BUCKET_BOUNDS[bucket]) {
+        ++bucket;
+    }
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    histogram.sumNanos.fetch_add(static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count())),
+                                 std::memory_order_relaxed);
+}
+
+void armor::Metrics::countCache(CacheTier tier, bool hit) {
+    cacheLookups[static_cast<std::size_t>(tier)][hit ? 1 : 0].fetch_add(1, std::memory_order_relaxed);
+}
+
+void armor::Metrics::countParseFailure(bool timedOut) {
+    parseFailures[timedOut ? 1 : 0].fetch_add(1, std::memory_order_relaxed);
+}
+
+void armor::Metrics::setQueueDepth(std::size_t headers) {
+    queueDepth.store(headers, std::memory_order_relaxed);
+}
+
+void armor::Metrics::beginBusy() {
+    if (busyDepth.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        busySince.store(steadyNanos(), std::memory_order_release);
+    }
+}
+
+void armor::Metrics::endBusy() {
+    if (busyDepth.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        int64_t since = busySince.exchange(0, std::memory_order_acq_rel);
+        busyNanos.fetch_add(static_cast<uint64_t>(std::max<int64_t>(0, steadyNanos() - since)),
+                            std::memory_order_relaxed);
+    }
+}
+
+std::string armor::Metrics::render(const std::map<std::string, std::string>& labels) const {
+    Exposition out(labels);
+
+    out.family("armor_requests_total", "counter", "Requests answered by armor serve, by kind and result.");
+    for (std::size_t i = 0; i < REQUEST_KIND_COUNT; ++i) {
+        for (int ok = 0; ok < 2; ++ok) {
+            out.series("armor_requests_total",
+                       std::string("kind=\"") + REQUEST_KINDS[i] + "\",result=\"" + (ok ? "ok" : "error") + "\"",
+                       static_cast<double>(requests[i][ok].load(std::memory_order_relaxed)));
+        }
+    }
+
+    out.family("armor_phase_duration_seconds", "histogram",
+               "Seconds of whole serve requests, and of loading, parsing and diffing each header.");
+    for (std::size_t p = 0; p < PHASE_COUNT; ++p) {
+        const Histogram& histogram = phases[p];
+        std::string phase = "phase=\"" + phaseName(static_cast<Phase>(p)).str() + "\"";
+        uint64_t cumulative = 0;
+        for (std::size_t b = 0; b <= BUCKET_BOUNDS.size(); ++b) {
+            cumulative += histogram.buckets[b].load(std::memory_order_relaxed);
+            std::ostringstream bound;
+            bound.precision(15);
+            if (b < BUCKET_BOUNDS.size()) {
+                bound << BUCKET_BOUNDS[b];
+            }
+            else {
+                bound << "+Inf";
+            }
+            out.series("armor_phase_duration_seconds_bucket", phase + ",le=\"" + bound.str() + "\"",
+                       static_cast<double>(cumulative));
+        }
+        out.series("armor_phase_duration_seconds_sum", phase,
+                   static_cast<double>(histogram.sumNanos.load(std::memory_order_relaxed)) / 1e9);
+        out.series("armor_phase_duration_seconds_count", phase, static_cast<double>(cumulative));
+    }
+
+    out.family("armor_cache_lookups_total", "counter",
+               "Lookups of each cache tier, by result; a lookup missing a tier goes on to the next.");
+    for (std::size_t t = 0; t < TIER_COUNT; ++t) {
+        for (int hit = 0; hit < 2; ++hit) {
+            out.series("armor_cache_lookups_total",
+                       "tier=\"" + tierName(static_cast<CacheTier>(t)).str() + "\",result=\"" +
+                           (hit ? "hit" : "miss") + "\"",
+                       static_cast<double>(cacheLookups[t][hit].load(std::memory_order_relaxed)));
+        }
+    }
+
+    out.family("armor_parse_failures_total", "counter",
+               "Header versions whose parse had errors, or was cancelled by --header-timeout.");
+    out.series("armor_parse_failures_total", "reason=\"errors\"",
+               static_cast<double>(parseFailures[0].load(std::memory_order_relaxed)));
+    out.series("armor_parse_failures_total", "reason=\"timeout\"",
+               static_cast<double>(parseFailures[1].load(std::memory_order_relaxed)));
+
+    out.family("armor_queue_depth", "gauge", "Headers of the current run not yet compared.");
+    out.series("armor_queue_depth", "", static_cast<double>(queueDepth.load(std::memory_order_relaxed)));
+
+    // A request still running counts up to now
+    uint64_t busy = busyNanos.load(std::memory_order_relaxed);
+    int64_t since = busySince.load(std::memory_order_acquire);
+    if (busyDepth.load(std::memory_order_acquire) > 0 && since > 0) {
+        busy += static_cast<uint64_t>(std::max<int64_t>(0, steadyNanos() - since));
+    }
+    out.family("armor_busy_seconds_total", "counter",
+               "Seconds spent serving requests or running; its rate is the utilization of the process.");
+    out.series("armor_busy_seconds_total", "", static_cast<double>(busy) / 1e9);
+
+    out.family("process_resident_memory_bytes", "gauge", "Resident set size in bytes.");
+    out.series("process_resident_memory_bytes", "", static_cast<double>(residentBytes()));
+
+    out.family("process_start_time_seconds", "gauge", "Start time of the process since the Unix epoch in seconds.");
+    out.series("process_start_time_seconds", "",
+               std::chrono::duration<double>(startTime.time_since_epoch()).count());
+    return out.str();
+}
+
+bool armor::Metrics::writeTextfile(const std::string& path, const std::map<std::string, std::string>& labels) const {
+    // The collector reads *.prom files whenever scraped, so a half-written one must never show
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        out << render(labels);
+        if (!out) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (llvm::sys::fs::rename(tempPath, path)) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,156 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <string>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+
+#include "comm_def.hpp"
+#include "compressed_output.hpp"
+#include "output_paths.hpp"
+
+namespace {
+
+    // `relative` under `root`; as is when the root is the working directory
+    std::string under(const std::string& root, const std::string& relative) {
+        if (root.empty()) {
+            return relative;
+        }
+        llvm::SmallString<256> path(root);
+        llvm::sys::path::append(path, relative);
+        return path.str().str();
+    }
+
+}
+
+std::string armor::OutputPaths::htmlReportDir() const {
+    return under(root, "armor_reports/html_reports");
+}
+
+std::string armor::OutputPaths::jsonReportDir() const {
+    return under(root, "armor_reports/json_reports");
+}
+
+std::string armor::OutputPaths::profileDir() const {
+    return under(root, "armor_reports/profiles");
+}
+
+std::string armor::OutputPaths::astDiffDir() const {
+    return under(root, "debug_output/ast_diffs");
+}
+
+std::string armor::OutputPaths::astDiffFile(const std::string& headerName, ReportFormat format) const {
+    std::string path = astDiffDir() + "/ast_diff_output_" + headerName + reportExtension(format);
+    if (compressDebugOutput) {
+        path += GZIP_EXTENSION;
+    }
+    return path;
+}
+
+std::string armor::OutputPaths::logFile() const {
+    std::string path = logPath.empty() ? under(root, LOG_FILE_PATH) : logPath;
+    if (compressDebugOutput && !isGzipPath(path)) {
+        path += GZIP_EXTENSION;
+    }
+    return path;
+}
+
+std::string armor::OutputPaths::workerLogFile(unsigned worker) const {
+    std::string path = logFile();
+    bool compressed = isGzipPath(path);
+    if (compressed) {
+        path.resize(path.size() - GZIP_EXTENSION.size());
+    }
+    std::filesystem::path log(path);
+    path = (log.parent_path() / (log.stem().string() + ".worker" + std::to_string(worker) +
+                                 log.extension().string())).string();
+    if (compressed) {
+        path += GZIP_EXTENSION;
+    }
+    return path;
+}
+
+std::string armor::OutputPaths::scratchDir(const std::string& name) const {
+    return under(root, "debug_output/" + name);
+}
+
+std::string armor::OutputPaths::htmlReportFile(const std::string& headerName) const {
+    return htmlReportDir() + "/api_diff_report_" + headerName + ".html";
+}
+
+std::string armor::OutputPaths::jsonReportFile(const std::string& headerName, ReportFormat format) const {
+    return jsonReportDir() + "/api_diff_report_" + headerName + reportExtension(format);
+}
+
+std::string armor::OutputPaths::combinedHtmlFile() const {
+    return under(root, "armor_reports/api_diff_report.html");
+}
+
+std::string armor::OutputPaths::summaryHtmlFile() const {
+    return under(root, "armor_reports/summary_report.html");
+}
+
+std::string armor::OutputPaths::summaryJsonFile() const {
+    return under(root, "armor_reports/summary_report.json");
+}
+
+std::string armor::OutputPaths::configurationRoot(const std::string& name) const {
+    return under(root, "configurations/" + name);
+}
+
+std::string armor::OutputPaths::pairsProjectRoot(const std::string& name) const {
+    return under(root, "projects/" + name);
+}
+
+std::string armor::OutputPaths::matrixHtmlFile() const {
+    return under(root, "armor_reports/matrix_report.html");
+}
+
+std::string armor::OutputPaths::matrixJsonFile() const {
+    return under(root, "armor_reports/matrix_report.json");
+}
+
+std::string armor::OutputPaths::chainStepRoot(const std::string& name) const {
+    return under(root, "chain/" + name);
+}
+
+std::string armor::OutputPaths::chainJsonFile() const {
+    return under(root, "armor_reports/chain_report.json");
+}
+
+std::string armor::OutputPaths::multiBaseRoot(const std::string& name) const {
+    return under(root, "multibase/" + name);
+}
+
+std::string armor::OutputPaths::multiBaseJsonFile() const {
+    return under(root, "armor_reports/multibase_report.json");
+}
+
+std::string armor::OutputPaths::whatIfRoot(const std::string& name) const {
+    return under(root, "whatif/" + name);
+}
+
+std::string armor::OutputPaths::whatIfJsonFile() const {
+    return under(root, "armor_reports/whatif_report.json");
+}
+
+std::string armor::OutputPaths::apiDumpFile(const std::string& headerName, ReportFormat format) const {
+    return under(root, "armor_reports/api_dump/api_dump_" + headerName + reportExtension(format));
+}
+
+std::string armor::OutputPaths::checkJsonFile() const {
+    return under(root, "armor_reports/check_report.json");
+}
+
+std::string armor::OutputPaths::digestManifestFile() const {
+    return under(root, "armor_reports/digest_manifest.json");
+}
+
+std::string armor::OutputPaths::sweepRoundRoot(unsigned run, unsigned round) const {
+    return under(root, "sweep/run" + std::to_string(run) + "/round" + std::to_string(round));
+}
+
+std::string armor::OutputPaths::sweepJsonFile() const {
+    return under(root, "armor_reports/sweep_report.json");
+}
@@ -0,0 +1,221 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include "output_writer.hpp"
+
+#include <memory>
+#include <system_error>
+#include <utility>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "logger.hpp"
+
+namespace {
+
+    // Buffer of the files written directly, so a report of thousands of rows
+    // is written in a few large writes
+    constexpr std::size_t DIRECT_WRITE_BUFFER_BYTES = 1 << 20;
+
+}
+
+armor::OutputWriter& armor::OutputWriter::getInstance() {
+    static OutputWriter instance;
+    return instance;
+}
+
+armor::OutputWriter::~OutputWriter() {
+    finish();
+}
+
+void armor::OutputWriter::start(std::size_t maxPending) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (writerThread.joinable()) {
+        return;
+    }
+    maxPendingBytes = maxPending;
+    stopping = false;
+    failures = 0;
+    writerThread = std::thread([this] { writeLoop(); });
+}
+
+bool armor::OutputWriter::isAsync() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writerThread.joinable() && !stopping;
+}
+
+bool armor::OutputWriter::write(const std::string& path, std::string contents) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!writerThread.joinable() || stopping) {
+        lock.unlock();
+        return writeFile({path, std::move(contents)});
+    }
+    // A file larger than the limit still goes through, once the queue is empty
+    spaceFreed.wait(lock, [&] {
+        return pending.empty() || pendingBytes + contents.size() <= maxPendingBytes;
+    });
+    pendingBytes += contents.size();
+    pending.push_back({path, std::move(contents)});
+    wakeWriter.notify_one();
+    return true;
+}
+
+std::size_t armor::OutputWriter::finish() {
+    std::thread writer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!writerThread.joinable()) {
+            return 0;
+        }
+        stopping = true;
+        writer = std::move(writerThread);
+    }
+    wakeWriter.notify_one();
+    writer.join();
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+    return failures.exchange(0);
+}
+
+bool armor::OutputWriter::createDirectories(const std::string& dir) {
+    if (dir.empty()) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(directoriesMutex);
+    if (directories.count(dir)) {
+        return true;
+    }
+    if (std::error_code ec = llvm::sys::fs::create_directories(dir)) {
+        armor::user_error() << "Failed to create directory " << dir << ": " << ec.message() << "\n";
+        return false;
+    }
+    directories.insert(dir);
+    return true;
+}
+
+bool armor::OutputWriter::createParentDirectories(const std::string& path) {
+    return createDirectories(llvm::sys::path::parent_path(path).str());
+}
+
+bool armor::OutputWriter::writeFile(const PendingFile& file) {
+    if (!createParentDirectories(file.path)) {
+        return false;
+    }
+    std::error_code ec;
+    auto out = std::make_unique<llvm::raw_fd_ostream>(file.path, ec);
+    if (ec == std::errc::no_such_file_or_directory) {
+        forgetParentDirectories(file.path);
+        createParentDirectories(file.path);
+        out = std::make_unique<llvm::raw_fd_ostream>(file.path, ec);
+    }
+    if (!ec) {
+        // The whole file is at hand; one write rather than the stream's buffer-sized ones
+        out->SetUnbuffered();
+        *out << file.contents;
+        out->close();
+        ec = out->error();
+    }
+    if (ec) {
+        armor::user_error() << "Failed to write " << file.path << ": " << ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
+
+void armor::OutputWriter::forgetParentDirectories(const std::string& path) {
+    std::lock_guard<std::mutex> lock(directoriesMutex);
+    for (llvm::StringRef dir = llvm::sys::path::parent_path(path); !dir.empty();
+         dir = llvm::sys::path::parent_path(dir)) {
+        directories.erase(dir);
+    }
+}
+
+void armor::OutputWriter::writeLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWriter.wait(lock, [&] { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return;
+        }
+        // Everything queued since the last pass, written without the lock
+        std::deque<PendingFile> batch;
+        batch.swap(pending);
+        lock.unlock();
+        for (PendingFile& file : batch) {
+            if (!writeFile(file)) {
+                ++failures;
+            }
+            std::size_t written = file.contents.size();
+            std::string().swap(file.contents);
+            lock.lock();
+            pendingBytes -= written;
+            lock.unlock();
+            spaceFreed.notify_all();
+        }
+        lock.lock();
+    }
+}
+
+armor::OutputFile::OutputFile(std::string filePath, bool binary)
+    : path(std::move(filePath)), async(OutputWriter::getInstance().isAsync()) {
+    if (async) {
+        return;
+    }
+    OutputWriter::getInstance().createParentDirectories(path);
+    buffer.resize(DIRECT_WRITE_BUFFER_BYTES);
+    file.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    std::ios::openmode mode = binary ? std::ios::trunc | std::ios::binary : std::ios::trunc;
+    file.open(path, mode);
+    if (!file.is_open()) {
+        OutputWriter::getInstance().forgetParentDirectories(path);
+        OutputWriter::getInstance().createParentDirectories(path);
+        file.clear();
+        file.open(path, mode);
+    }
+}
+
+armor::OutputFile::~OutputFile() {
+    if (!closed) {
+        close();
+    }
+}
+
+std::ostream& armor::OutputFile::stream() {
+    if (async) {
+        return memory;
+    }
+    return file;
+}
+
+armor::OutputFile::operator bool() const {
+    if (async) {
+        return static_cast<bool>(memory);
+    }
+    return static_cast<bool>(file);
+}
+
+std::size_t armor::OutputFile::size() {
+    std::streamoff position = stream().tellp();
+    return position > 0 ? static_cast<std::size_t>(position) : 0;
+}
+
+bool armor::OutputFile::close() {
+    if (closed) {
+        return true;
+    }
+    closed = true;
+    if (async) {
+        if (!memory) {
+            return false;
+        }
+        std::string contents = memory.str();
+        memory.str(std::string());
+        return OutputWriter::getInstance().write(path, std::move(contents));
+    }
+    if (!file.is_open()) {
+        return false;
+    }
+    file.close();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,143 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+#include "precompiled_header.hpp"
+#include "clang_tool_runner.hpp"
+#include "file_cache.hpp"
+#include "logger.hpp"
+
+namespace {
+
+    class EmitPrecompiledHeaderAction : public clang::GeneratePCHAction {
+        public:
+            explicit EmitPrecompiledHeaderAction(const std::string& outputPath) : outputPath(outputPath) {}
+
+        protected:
+            bool BeginInvocation(clang::CompilerInstance& CI) override {
+                CI.getFrontendOpts().OutputFile = outputPath;
+                return true;
+            }
+
+        private:
+            const std::string& outputPath;
+    };
+
+    class EmitPrecompiledHeaderActionFactory : public clang::tooling::FrontendActionFactory {
+        public:
+            explicit EmitPrecompiledHeaderActionFactory(const std::string& outputPath) : outputPath(outputPath) {}
+
+            std::unique_ptr<clang::FrontendAction> create() override {
+                return std::make_unique<EmitPrecompiledHeaderAction>(outputPath);
+            }
+
+        private:
+            const std::string& outputPath;
+    };
+
+    std::string makeAbsolute(const std::string& path) {
+        llvm::SmallString<256> absolute(path);
+        llvm::sys::fs::make_absolute(absolute);
+        llvm::sys::path::remove_dots(absolute, /*remove_dot_dot=*/true);
+        return absolute.str().str();
+    }
+
+    // The prefix must be compiled as a header for clang to emit a PCH from it
+    std::vector<std::string> toHeaderFlags(const std::vector<std::string>& flags) {
+        std::vector<std::string> headerFlags;
+        headerFlags.reserve(flags.size());
+        for (const auto& flag : flags) {
+            if (flag == "-xc++") {
+                headerFlags.emplace_back("-xc++-header");
+            }
+            else if (flag == "-xc") {
+                headerFlags.emplace_back("-xc-header");
+            }
+            else {
+                headerFlags.push_back(flag);
+            }
+        }
+        return headerFlags;
+    }
+
+}
+
+armor::PrecompiledHeaderCache::PrecompiledHeaderCache(const std::string& prefixHeader, const std::string& outputDir)
+    : prefixHeader(makeAbsolute(prefixHeader)), outputDir(makeAbsolute(outputDir)) {}
+
+std::string armor::PrecompiledHeaderCache::get(const std::string& projectRoot,
+                                                const std::vector<std::string>& baseFlags) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> prefix =
+        llvm::MemoryBuffer::getFile(prefixHeader, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!prefix) {
+        armor::user_error() << "Cannot read PCH prefix header " << prefixHeader << " : "
+                            << prefix.getError().message() << "\n";
+        return "";
+    }
+
+    std::string material = projectRoot;
+    material += '\0';
+    for (const auto& flag : baseFlags) {
+        material += flag;
+        material += '\0';
+    }
+    material += (*prefix)->getBuffer();
+    std::string key = llvm::utohexstr(llvm::xxHash64(material));
+
+    std::scoped_lock<std::mutex> lock(buildMutex);
+    auto it = builtHeaders.find(key);
+    if (it != builtHeaders.end()) {
+        return it->second;
+    }
+
+    llvm::SmallString<256> pchPath(outputDir);
+    llvm::sys::path::append(pchPath, key + ".pch");
+    std::string outputPath = pchPath.str().str();
+
+    std::string result;
+    if (std::error_code ec = llvm::sys::fs::create_directories(outputDir)) {
+        armor::user_error() << "Cannot create PCH directory " << outputDir << " : " << ec.message() << "\n";
+    }
+    else {
+        armor::info() << "Precompiling " << prefixHeader << " into " << outputPath << "\n";
+        clang::tooling::FixedCompilationDatabase compDB(projectRoot, toHeaderFlags(baseFlags));
+        EmitPrecompiledHeaderActionFactory factory(outputPath);
+        PARSING_STATUS status = armor::runFrontendAction(prefixHeader, compDB, factory);
+        // Parses that stat'ed the PCH before it was written must not keep it missing
+        llvm::SmallString<256> absolutePch(outputPath);
+        llvm::sys::fs::make_absolute(absolutePch);
+        armor::SharedFileCache::getInstance().forget(absolutePch);
+        if (status == NO_FATAL_ERRORS && llvm::sys::fs::exists(outputPath)) {
+            result = outputPath;
+        }
+        else {
+            armor::user_error() << "Failed to precompile " << prefixHeader << ", parsing without it\n";
+        }
+    }
+
+    // Failures are remembered too, so a broken prefix is only attempted once
+    builtHeaders.try_emplace(key, result);
+    return result;
+}
+
+void armor::PrecompiledHeaderCache::addIncludeFlags(std::vector<std::string>& flags, const std::string& pchPath) {
+    if (pchPath.empty()) {
+        return;
+    }
+    flags.emplace_back("-include-pch");
+    flags.push_back(pchPath);
+}
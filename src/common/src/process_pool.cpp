@@ -0,0 +1,309 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "llvm/Support/raw_ostream.h"
+
+#include "logger.hpp"
+#include "process_pool.hpp"
+
+namespace {
+
+    bool writeAll(int fd, const void* data, std::size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    // false if the pipe closed first
+    bool readAll(int fd, void* data, std::size_t size) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t got = ::read(fd, bytes, size);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                return false;
+            }
+            bytes += got;
+            size -= static_cast<std::size_t>(got);
+        }
+        return true;
+    }
+
+    void closeFd(int& fd) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    // Writing to a dead worker fails with EPIPE instead of ending this process
+    class IgnoreSigpipe {
+    public:
+        IgnoreSigpipe() {
+            struct sigaction ignore {};
+            ignore.sa_handler = SIG_IGN;
+            sigemptyset(&ignore.sa_mask);
+            sigaction(SIGPIPE, &ignore, &previous);
+        }
+
+        ~IgnoreSigpipe() {
+            sigaction(SIGPIPE, &previous, nullptr);
+        }
+
+    private:
+        struct sigaction previous {};
+    };
+
+}
+
+armor::ProcessPool::ProcessPool(unsigned workers, Work work, WorkerStart onStart)
+    : workerCount(workers == 0 ? 1 : workers), work(std::move(work)), onStart(std::move(onStart)) {}
+
+armor::ProcessPool::~ProcessPool() {
+    for (Worker& worker : workers) {
+        reap(worker);
+    }
+}
+
+void armor::ProcessPool::spawn(Worker& worker) {
+    int requestPipe[2];
+    int resultPipe[2];
+    if (pipe2(requestPipe, O_CLOEXEC) != 0) {
+        throw std::runtime_error(std::string("Cannot create a worker pipe: ") + std::strerror(errno));
+    }
+    if (pipe2(resultPipe, O_CLOEXEC) != 0) {
+        int error = errno;
+        ::close(requestPipe[0]);
+        ::close(requestPipe[1]);
+        throw std::runtime_error(std::string("Cannot create a worker pipe: ") + std::strerror(error));
+    }
+
+    unsigned number = spawned++;
+    DebugConfig& debugConfig = DebugConfig::getInstance();
+    llvm::outs().flush();
+    llvm::errs().flush();
+    debugConfig.prepareFork();
+    pid_t pid = fork();
+    if (pid == 0) {
+        debugConfig.afterForkInChild();
+        ::close(requestPipe[1]);
+        ::close(resultPipe[0]);
+        // A worker holding the pipes of another would keep it from seeing its end
+        for (Worker& other : workers) {
+            closeFd(other.requestFd);
+            closeFd(other.resultFd);
+        }
+        if (onStart) {
+            onStart(number);
+        }
+        serve(requestPipe[0], resultPipe[1]);
+    }
+    debugConfig.afterForkInParent();
+    ::close(requestPipe[0]);
+    ::close(resultPipe[1]);
+    if (pid < 0) {
+        int error = errno;
+        ::close(requestPipe[1]);
+        ::close(resultPipe[0]);
+        throw std::runtime_error(std::string("Cannot start a worker process: ") + std::strerror(error));
+    }
+    worker.pid = pid;
+    worker.requestFd = requestPipe[1];
+    worker.resultFd = resultPipe[0];
+    worker.busy = false;
+}
+
+std::string armor::ProcessPool::reap(Worker& worker) {
+    closeFd(worker.requestFd);
+    closeFd(worker.resultFd);
+    if (worker.pid <= 0) {
+        return "never started";
+    }
+    int status = 0;
+    pid_t waited;
+    do {
+        waited = waitpid(worker.pid, &status, 0);
+    } while (waited < 0 && errno == EINTR);
+    worker.pid = -1;
+    worker.busy = false;
+    if (waited < 0) {
+        return "was lost";
+    }
+    if (WIFSIGNALED(status)) {
+        int signal = WTERMSIG(status);
+        return "was killed by signal " + std::to_string(signal) + " (" + strsignal(signal) + ")";
+    }
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+void armor::ProcessPool::serve(int requestFd, int resultFd) {
+    uint64_t task = 0;
+    while (readAll(requestFd, &task, sizeof(task))) {
+        uint8_t succeeded = 1;
+        std::string result;
+        try {
+            result = work(static_cast<std::size_t>(task));
+        } catch (const std::exception& e) {
+            succeeded = 0;
+            result = e.what();
+        } catch (...) {
+            succeeded = 0;
+            result = "unknown exception";
+        }
+        uint64_t size = result.size();
+        if (!writeAll(resultFd, &succeeded, sizeof(succeeded)) || !writeAll(resultFd, &size, sizeof(size)) ||
+            !writeAll(resultFd, result.data(), result.size())) {
+            break;
+        }
+    }
+    // Static destructors belong to the process the worker was forked from
+    llvm::outs().flush();
+    llvm::errs().flush();
+    DebugConfig::getInstance().closeLogFile();
+    _exit(0);
+}
+
+void armor::ProcessPool::run(const std::vector<std::size_t>& tasks, const Done& done) {
+    if (tasks.empty()) {
+        return;
+    }
+    IgnoreSigpipe ignoreSigpipe;
+    workers.resize(workerCount);
+    for (Worker& worker : workers) {
+        if (worker.pid <= 0) {
+            spawn(worker);
+        }
+    }
+
+    std::size_t next = 0;
+    std::size_t pending = 0;
+    // Hands `worker` the next task; a worker found dead while idle is replaced once per task
+    auto dispatch = [&](Worker& worker) {
+        while (next < tasks.size()) {
+            std::size_t task = tasks[next++];
+            uint64_t request = task;
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                if (writeAll(worker.requestFd, &request, sizeof(request))) {
+                    worker.busy = true;
+                    worker.task = task;
+                    worker.started = std::chrono::steady_clock::now();
+                    ++pending;
+                    return;
+                }
+                std::string failure = reap(worker);
+                ++restarts;
+                spawn(worker);
+                if (attempt == 1) {
+                    done(task, nullptr, "worker " + failure);
+                }
+            }
+        }
+    };
+    for (Worker& worker : workers) {
+        dispatch(worker);
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<Worker*> polled;
+    while (pending > 0) {
+        fds.clear();
+        polled.clear();
+        // Waits no longer than until the first busy worker runs out of time
+        int waitMs = -1;
+        auto now = std::chrono::steady_clock::now();
+        for (Worker& worker : workers) {
+            if (worker.busy) {
+                fds.push_back({worker.resultFd, POLLIN, 0});
+                polled.push_back(&worker);
+                if (taskTimeout.count() > 0) {
+                    auto left = std::chrono::ceil<std::chrono::milliseconds>(worker.started + taskTimeout - now);
+                    int leftMs = static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, left.count()));
+                    waitMs = waitMs < 0 ? leftMs : std::min(waitMs, leftMs);
+                }
+            }
+        }
+        if (poll(fds.data(), fds.size(), waitMs) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Cannot wait for worker processes: ") + std::strerror(errno));
+        }
+        for (std::size_t k = 0; k < fds.size(); ++k) {
+            if (fds[k].revents == 0) {
+                continue;
+            }
+            Worker& worker = *polled[k];
+            std::size_t task = worker.task;
+            worker.busy = false;
+            --pending;
+
+            uint8_t succeeded = 0;
+            uint64_t size = 0;
+            std::string result;
+            bool complete = readAll(worker.resultFd, &succeeded, sizeof(succeeded)) &&
+                            readAll(worker.resultFd, &size, sizeof(size));
+            if (complete) {
+                result.resize(size);
+                complete = readAll(worker.resultFd, result.data(), result.size());
+            }
+            if (!complete) {
+                std::string failure = reap(worker);
+                ++restarts;
+                spawn(worker);
+                done(task, nullptr, "worker " + failure);
+            }
+            else if (succeeded) {
+                done(task, &result, std::string());
+            }
+            else {
+                done(task, nullptr, result);
+            }
+            dispatch(worker);
+        }
+
+        if (taskTimeout.count() == 0) {
+            continue;
+        }
+        now = std::chrono::steady_clock::now();
+        for (Worker& worker : workers) {
+            if (!worker.busy || now - worker.started < taskTimeout) {
+                continue;
+            }
+            std::size_t task = worker.task;
+            --pending;
+            ::kill(worker.pid, SIGKILL);
+            reap(worker);
+            ++timeouts;
+            spawn(worker);
+            done(task, nullptr, TIMEOUT_FAILURE);
+            dispatch(worker);
+        }
+    }
+}
@@ -0,0 +1,348 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "diff_utils.hpp"
+#include "json_stream.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+
+thread_local armor::profile::HeaderProfile* armor::profile::detail::currentProfile = nullptr;
+thread_local armor::profile::Phase armor::profile::detail::currentPhase = armor::profile::Phase::COUNT;
+thread_local armor::profile::Profiler::ThreadTrace* armor::profile::Profiler::threadTrace = nullptr;
+thread_local uint64_t armor::profile::Profiler::threadGeneration = 0;
+thread_local armor::profile::detail::ThreadAllocations armor::profile::detail::threadAllocations;
+
+// Set by the allocation hooks when a build links them (ARMOR_ALLOC_PROFILING)
+bool armor::profile::detail::allocationHooksLinked = false;
+
+namespace {
+
+    double toMilliseconds(uint64_t nanos) {
+        return static_cast<double>(nanos) / 1e6;
+    }
+
+    double toMicroseconds(int64_t nanos) {
+        return static_cast<double>(nanos) / 1e3;
+    }
+
+    double toMebibytes(uint64_t bytes) {
+        return static_cast<double>(bytes) / (1 << 20);
+    }
+
+}
+
+bool armor::profile::allocationsCounted() {
+    return detail::allocationHooksLinked;
+}
+
+armor::profile::Profiler::Profiler() : traceStart(std::chrono::steady_clock::now()) {}
+
+llvm::StringRef armor::profile::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::PROCESS_FILE:            return "process_file";
+        case Phase::CACHE_LOAD:              return "cache_load";
+        case Phase::HANDLE_TRANSLATION_UNIT: return "handle_translation_unit";
+        case Phase::TREE_BUILD:              return "tree_build";
+        case Phase::HASH_INDEX:              return "hash_index";
+        case Phase::DIFF_TREES:              return "diff_trees";
+        case Phase::PREPROCESS_API_CHANGES:  return "preprocess_api_changes";
+        case Phase::GENERATE_HTML_REPORT:    return "generate_html_report";
+        case Phase::GENERATE_JSON_REPORT:    return "generate_json_report";
+        default:                             return "unknown";
+    }
+}
+
+llvm::StringRef armor::profile::counterName(Counter counter) {
+    switch (counter) {
+        case Counter::NODES_BUILT:        return "nodes_built";
+        case Counter::USRS_GENERATED:     return "usrs_generated";
+        case Counter::HASHES_COMPUTED:    return "hashes_computed";
+        case Counter::JSON_BYTES_WRITTEN: return "json_bytes_written";
+        default:                          return "unknown";
+    }
+}
+
+nlohmann::json armor::profile::HeaderProfile::toJson(bool memory, bool hardware) const {
+    nlohmann::json phases = nlohmann::json::object();
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+        Phase phase = static_cast<Phase>(i);
+        if (getPhaseCalls(phase) == 0) {
+            continue;
+        }
+        nlohmann::json& phaseJson = phases[phaseName(phase).str()];
+        phaseJson = {
+            {"calls", getPhaseCalls(phase)},
+            {"ms", toMilliseconds(getPhaseNanos(phase))}
+        };
+        if (memory) {
+            phaseJson["allocated_bytes"] = getAllocatedBytes(phase);
+            phaseJson["allocations"] = getAllocations(phase);
+            phaseJson["peak_rss_bytes"] = getPeakResident(phase);
+        }
+        if (hardware) {
+            nlohmann::json& events = phaseJson["hardware"];
+            for (std::size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+                HardwareEvent event = static_cast<HardwareEvent>(e);
+                events[hardwareEventName(event).str()] = getHardware(phase, event);
+            }
+        }
+    }
+
+    nlohmann::json counterValues = nlohmann::json::object();
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+        Counter counter = static_cast<Counter>(i);
+        counterValues[counterName(counter).str()] = getCounter(counter);
+    }
+
+    nlohmann::json profile = {
+        {"header", header},
+        {"phases", std::move(phases)},
+        {"counters", std::move(counterValues)}
+    };
+    if (memory) {
+        nlohmann::json kinds = nlohmann::json::object();
+        for (std::size_t i = 0; i < NODE_KIND_COUNT; ++i) {
+            NodeKind kind = static_cast<NodeKind>(i);
+            if (getNodes(kind) > 0) {
+                kinds[serialize(kind)] = getNodes(kind);
+            }
+        }
+        profile["node_kinds"] = std::move(kinds);
+    }
+    return profile;
+}
+
+armor::profile::HeaderProfile* armor::profile::Profiler::forHeader(llvm::StringRef filePath) {
+    if (!isEnabled() && !isTracing()) {
+        return nullptr;
+    }
+    std::string header = llvm::sys::path::filename(filePath).str();
+    std::scoped_lock<std::mutex> lock(mutex);
+    std::unique_ptr<HeaderProfile>& profile = headers[header];
+    if (!profile) {
+        profile = std::make_unique<HeaderProfile>(header);
+    }
+    return profile.get();
+}
+
+void armor::profile::Profiler::printSummary() const {
+    std::scoped_lock<std::mutex> lock(mutex);
+
+    std::string table;
+    llvm::raw_string_ostream OS(table);
+    OS << "Profile of " << headers.size() << " header(s)\n";
+    OS << "  " << llvm::left_justify("phase", 26) << llvm::right_justify("calls", 11)
+       << llvm::right_justify("total ms", 13) << llvm::right_justify("max ms", 13) << "  slowest header\n";
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+        Phase phase = static_cast<Phase>(i);
+        uint64_t calls = 0;
+        uint64_t total = 0;
+        uint64_t slowest = 0;
+        const HeaderProfile* slowestHeader = nullptr;
+        for (const auto& entry : headers) {
+            uint64_t nanos = entry.second->getPhaseNanos(phase);
+            calls += entry.second->getPhaseCalls(phase);
+            total += nanos;
+            if (!slowestHeader || nanos > slowest) {
+                slowest = nanos;
+                slowestHeader = entry.second.get();
+            }
+        }
+        if (calls == 0) {
+            continue;
+        }
+        OS << "  " << llvm::left_justify(phaseName(phase), 26) << llvm::format_decimal(calls, 11)
+           << llvm::format("%13.3f%13.3f", toMilliseconds(total), toMilliseconds(slowest))
+           << "  " << slowestHeader->getHeader() << "\n";
+    }
+    OS << "  " << llvm::left_justify("counter", 26) << llvm::right_justify("total", 11) << "\n";
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+        Counter counter = static_cast<Counter>(i);
+        uint64_t total = 0;
+        for (const auto& entry : headers) {
+            total += entry.second->getCounter(counter);
+        }
+        OS << "  " << llvm::left_justify(counterName(counter), 26) << llvm::format_decimal(total, 11) << "\n";
+    }
+    if (isMemoryProfiling()) {
+        if (!allocationsCounted()) {
+            OS << "  allocations not counted (build with -DARMOR_ALLOC_PROFILING=ON)\n";
+        }
+        OS << "  " << llvm::left_justify("phase memory", 26) << llvm::right_justify("allocations", 13)
+           << llvm::right_justify("alloc MiB", 13) << llvm::right_justify("peak RSS MiB", 14) << "  largest header\n";
+        for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+            Phase phase = static_cast<Phase>(i);
+            uint64_t calls = 0;
+            uint64_t allocations = 0;
+            uint64_t bytes = 0;
+            uint64_t peak = 0;
+            const HeaderProfile* largestHeader = nullptr;
+            uint64_t largest = 0;
+            for (const auto& entry : headers) {
+                calls += entry.second->getPhaseCalls(phase);
+                allocations += entry.second->getAllocations(phase);
+                bytes += entry.second->getAllocatedBytes(phase);
+                peak = std::max(peak, entry.second->getPeakResident(phase));
+                if (!largestHeader || entry.second->getAllocatedBytes(phase) > largest) {
+                    largest = entry.second->getAllocatedBytes(phase);
+                    largestHeader = entry.second.get();
+                }
+            }
+            if (calls == 0) {
+                continue;
+            }
+            OS << "  " << llvm::left_justify(phaseName(phase), 26) << llvm::format_decimal(allocations, 13)
+               << llvm::format("%13.1f%14.1f", toMebibytes(bytes), toMebibytes(peak))
+               << "  " << largestHeader->getHeader() << "\n";
+        }
+        OS << "  " << llvm::left_justify("node kind", 26) << llvm::right_justify("nodes", 13) << "\n";
+        for (std::size_t i = 0; i < NODE_KIND_COUNT; ++i) {
+            NodeKind kind = static_cast<NodeKind>(i);
+            uint64_t total = 0;
+            for (const auto& entry : headers) {
+                total += entry.second->getNodes(kind);
+            }
+            if (total > 0) {
+                OS << "  " << llvm::left_justify(serialize(kind), 26) << llvm::format_decimal(total, 13) << "\n";
+            }
+        }
+    }
+    if (isHardwareProfiling()) {
+        std::string error = hardwareCountersError();
+        if (!error.empty()) {
+            OS << "  hardware counters unavailable (" << error << ")\n";
+        }
+        OS << "  " << llvm::left_justify("phase counters", 26) << llvm::right_justify("Mcycles", 11)
+           << llvm::right_justify("Minstr", 11) << llvm::right_justify("IPC", 7) << llvm::right_justify("Kcache miss", 13)
+           << llvm::right_justify("Kbranch miss", 14) << "  most cache misses\n";
+        for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+            Phase phase = static_cast<Phase>(i);
+            HardwareSample totals{};
+            const HeaderProfile* missiest = nullptr;
+            for (const auto& entry : headers) {
+                for (std::size_t e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+                    totals[e] += entry.second->getHardware(phase, static_cast<HardwareEvent>(e));
+                }
+                if (!missiest || entry.second->getHardware(phase, HardwareEvent::CACHE_MISSES) >
+                                     missiest->getHardware(phase, HardwareEvent::CACHE_MISSES)) {
+                    missiest = entry.second.get();
+                }
+            }
+            uint64_t cycles = totals[static_cast<std::size_t>(HardwareEvent::CYCLES)];
+            if (cycles == 0) {
+                continue;
+            }
+            uint64_t instructions = totals[static_cast<std::size_t>(HardwareEvent::INSTRUCTIONS)];
+            OS << "  " << llvm::left_justify(phaseName(phase), 26)
+               << llvm::format("%11.1f%11.1f%7.2f%13.1f%14.1f", cycles / 1e6, instructions / 1e6,
+                               static_cast<double>(instructions) / static_cast<double>(cycles),
+                               totals[static_cast<std::size_t>(HardwareEvent::CACHE_MISSES)] / 1e3,
+                               totals[static_cast<std::size_t>(HardwareEvent::BRANCH_MISSES)] / 1e3)
+               << "  " << missiest->getHeader() << "\n";
+        }
+    }
+    OS.flush();
+
+    armor::user_print() << table;
+}
+
+void armor::profile::Profiler::writeReports(const std::string& outputDir) const {
+    std::scoped_lock<std::mutex> lock(mutex);
+    if (headers.empty()) {
+        return;
+    }
+    std::filesystem::create_directories(outputDir);
+    for (const auto& entry : headers) {
+        std::string path = outputDir + "/profile_" + entry.first + ".json";
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            armor::user_error() << "Failed to write profile " << path << "\n";
+            continue;
+        }
+        out << entry.second->toJson(isMemoryProfiling(), isHardwareProfiling()).dump(4);
+    }
+}
+
+void armor::profile::Profiler::forEachProfile(llvm::function_ref<void(const HeaderProfile&)> visit) const {
+    std::scoped_lock<std::mutex> lock(mutex);
+    for (const auto& entry : headers) {
+        visit(*entry.second);
+    }
+}
+
+armor::profile::Profiler::ThreadTrace& armor::profile::Profiler::getThreadTrace() {
+    uint64_t generation = traceGeneration.load(std::memory_order_acquire);
+    if (!threadTrace || threadGeneration != generation) {
+        std::scoped_lock<std::mutex> lock(mutex);
+        threadTraces.push_back(std::make_unique<ThreadTrace>());
+        threadTraces.back()->tid = static_cast<unsigned>(threadTraces.size());
+        threadTrace = threadTraces.back().get();
+        threadGeneration = generation;
+    }
+    return *threadTrace;
+}
+
+void armor::profile::Profiler::recordSpan(llvm::StringRef name, const HeaderProfile* profile,
+                                          std::chrono::steady_clock::time_point start,
+                                          std::chrono::steady_clock::time_point end) {
+    if (!isTracing()) {
+        return;
+    }
+    getThreadTrace().events.push_back({
+        name, profile,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - traceStart).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()
+    });
+}
+
+bool armor::profile::Profiler::writeTrace(const std::string& path) const {
+    std::scoped_lock<std::mutex> lock(mutex);
+    llvm::SmallString<256> parentDir = llvm::sys::path::parent_path(path);
+    if (!parentDir.empty()) {
+        std::filesystem::create_directories(parentDir.str().str());
+    }
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        armor::user_error() << "Failed to write trace " << path << "\n";
+        return false;
+    }
+
+    // One track per thread; thread names label them in the trace viewer
+    armor::JsonStreamWriter writer(out);
+    writer.beginObject();
+    writer.field("displayTimeUnit", "ms");
+    writer.key("traceEvents");
+    writer.beginArray();
+    for (const auto& thread : threadTraces) {
+        writer.value({
+            {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", thread->tid},
+            {"args", {{"name", "worker " + std::to_string(thread->tid)}}}
+        });
+        for (const TraceEvent& event : thread->events) {
+            writer.value({
+                {"name", event.name.str()}, {"cat", "armor"}, {"ph", "X"}, {"pid", 1}, {"tid", thread->tid},
+                {"ts", toMicroseconds(event.startNanos)}, {"dur", toMicroseconds(event.durationNanos)},
+                {"args", {{"header", event.profile ? event.profile->getHeader() : std::string()}}}
+            });
+        }
+    }
+    writer.endArray();
+    writer.endObject();
+    return true;
+}
+
+void armor::profile::Profiler::reset() {
+    std::scoped_lock<std::mutex> lock(mutex);
+    headers.clear();
+    threadTraces.clear();
+    traceGeneration.fetch_add(1, std::memory_order_release);
+    traceStart = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,89 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/YAMLTraits.h"
+
+#include "macro_matrix.hpp"
+#include "project_pairs.hpp"
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(armor::ProjectPair)
+
+namespace llvm::yaml {
+
+    template <>
+    struct MappingTraits<armor::ProjectPair> {
+        static void mapping(IO& io, armor::ProjectPair& project) {
+            io.mapRequired("name", project.name);
+            io.mapRequired("root1", project.root1);
+            io.mapRequired("root2", project.root2);
+            io.mapOptional("header-dir", project.headerDir);
+            io.mapOptional("headers", project.headers);
+            io.mapOptional("include-paths", project.includePaths);
+            io.mapOptional("macro-flags", project.macroFlags);
+            io.mapOptional("lang", project.lang);
+        }
+    };
+
+}
+
+namespace {
+
+    void resolveAgainst(const std::filesystem::path& base, std::string& path) {
+        if (!path.empty() && std::filesystem::path(path).is_relative()) {
+            path = (base / path).lexically_normal().string();
+        }
+    }
+
+}
+
+std::vector<armor::ProjectPair> armor::loadProjectPairs(const std::string& path) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        throw std::runtime_error("Failed to read pairs file " + path + ": " + buffer.getError().message());
+    }
+
+    std::vector<ProjectPair> projects;
+    std::string diagnostics;
+    llvm::yaml::Input in((*buffer)->getBuffer(), nullptr,
+                         [](const llvm::SMDiagnostic& diagnostic, void* context) {
+                             *static_cast<std::string*>(context) = diagnostic.getMessage().str();
+                         },
+                         &diagnostics);
+    in >> projects;
+    if (in.error()) {
+        throw std::runtime_error("Malformed pairs file " + path + ": " + diagnostics);
+    }
+    if (projects.empty()) {
+        throw std::runtime_error("Pairs file " + path + " lists no projects");
+    }
+
+    std::filesystem::path base = std::filesystem::absolute(path).parent_path();
+    std::unordered_set<std::string> names;
+    for (ProjectPair& project : projects) {
+        if (!isValidConfigurationName(project.name)) {
+            throw std::runtime_error("Invalid project name '" + project.name + "' in " + path);
+        }
+        if (!names.insert(project.name).second) {
+            throw std::runtime_error("Duplicate project name '" + project.name + "' in " + path);
+        }
+        if (project.headerDir.empty() && project.headers.empty()) {
+            throw std::runtime_error("Project '" + project.name + "' in " + path + " lists neither headers nor a header-dir");
+        }
+        if (!project.lang.empty() && project.lang != "cpp" && project.lang != "c") {
+            throw std::runtime_error("Invalid lang '" + project.lang + "' of project '" + project.name + "' in " + path);
+        }
+        resolveAgainst(base, project.root1);
+        resolveAgainst(base, project.root2);
+        for (std::string& includePath : project.includePaths) {
+            resolveAgainst(base, includePath);
+        }
+    }
+    return projects;
+}
@@ -0,0 +1,90 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include "range_digests.hpp"
+
+namespace {
+
+    using DigestsByHash = llvm::DenseMap<uint64_t, llvm::SmallVector<FibonacciHash::Digest128, 1>>;
+
+    // The distinct digests of each hash, sorted, so the two versions compare as sets
+    void normalize(DigestsByHash& digests) {
+        for (auto& entry : digests) {
+            auto& list = entry.second;
+            std::sort(list.begin(), list.end());
+            list.erase(std::unique(list.begin(), list.end()), list.end());
+        }
+    }
+
+}
+
+void RangeDigests::record(Category category, uint64_t hash, unsigned startOffset, unsigned endOffset,
+                          SourceHashIndex::Normalization normalization) {
+    if (hash == 0 || startOffset >= endOffset) {
+        return;
+    }
+    ranges[static_cast<size_t>(category)].push_back({hash, startOffset, endOffset, normalization});
+}
+
+void RangeDigests::append(const RangeDigests& other) {
+    for (size_t category = 0; category < ranges.size(); ++category) {
+        ranges[category].insert(ranges[category].end(), other.ranges[category].begin(), other.ranges[category].end());
+    }
+}
+
+void RangeDigests::keepSource(llvm::StringRef text) {
+    source.assign(text.data(), text.size());
+    sourceKept = true;
+}
+
+bool RangeDigests::empty() const {
+    return std::all_of(ranges.begin(), ranges.end(), [](const std::vector<HashedRange>& list) { return list.empty(); });
+}
+
+void RangeDigests::clear() {
+    for (std::vector<HashedRange>& list : ranges) {
+        list.clear();
+    }
+    source.clear();
+    sourceKept = false;
+}
+
+FibonacciHash::Digest128 RangeDigests::digestOf(const HashedRange& range) const {
+    if (range.normalization == SourceHashIndex::Normalization::Source) {
+        return FibonacciHash::digestNormalizedSource(source, range.startOffset, range.endOffset);
+    }
+    return FibonacciHash::digest(llvm::StringRef(source).slice(range.startOffset, range.endOffset));
+}
+
+bool RangeDigests::confirm(const RangeDigests& older, const RangeDigests& newer, Category category,
+                           const HashMultiset& matched) {
+    if (!older.hasSource() || !newer.hasSource() || matched.empty()) {
+        return true;
+    }
+
+    auto collect = [&](const RangeDigests& digests) {
+        DigestsByHash byHash;
+        for (const HashedRange& range : digests.ranges[static_cast<size_t>(category)]) {
+            if (range.endOffset <= digests.source.size() && matched.count(range.hash) > 0) {
+                byHash[range.hash].push_back(digests.digestOf(range));
+            }
+        }
+        normalize(byHash);
+        return byHash;
+    };
+    DigestsByHash before = collect(older);
+    DigestsByHash after = collect(newer);
+
+    // A hash with ranges on one side only has nothing to be compared with
+    for (const auto& entry : before) {
+        auto it = after.find(entry.first);
+        if (it != after.end() && it->second != entry.second) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "report_format.hpp"
+
+armor::ReportFormat armor::reportFormatOf(const std::string& name) {
+    if (name == "cbor") {
+        return ReportFormat::CBOR;
+    }
+    if (name == "msgpack") {
+        return ReportFormat::MSGPACK;
+    }
+    return ReportFormat::JSON;
+}
+
+const char* armor::reportExtension(ReportFormat format) {
+    switch (format) {
+        case ReportFormat::CBOR:    return ".cbor";
+        case ReportFormat::MSGPACK: return ".msgpack";
+        default:                    return ".json";
+    }
+}
+
+bool armor::isReportFile(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".json" || extension == ".cbor" || extension == ".msgpack";
+}
+
+armor::ReportFormat armor::reportFormatOfPath(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    if (extension == ".cbor") {
+        return ReportFormat::CBOR;
+    }
+    if (extension == ".msgpack") {
+        return ReportFormat::MSGPACK;
+    }
+    return ReportFormat::JSON;
+}
+
+void armor::writeReportDocument(std::ostream& out, const nlohmann::json& document, ReportFormat format) {
+    switch (format) {
+        case ReportFormat::CBOR:
+            nlohmann::json::to_cbor(document, out);
+            break;
+        case ReportFormat::MSGPACK:
+            nlohmann::json::to_msgpack(document, out);
+            break;
+        default:
+            out << document.dump(4);
+            break;
+    }
+}
+
+nlohmann::json armor::readReportDocument(const std::string& path) {
+    ReportFormat format = reportFormatOfPath(path);
+    std::ifstream in(path, format == ReportFormat::JSON ? std::ios::in : std::ios::in | std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    switch (format) {
+        case ReportFormat::CBOR:    return nlohmann::json::from_cbor(in);
+        case ReportFormat::MSGPACK: return nlohmann::json::from_msgpack(in);
+        default:                    return nlohmann::json::parse(in);
+    }
+}
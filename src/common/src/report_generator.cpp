@@ -1,13 +1,20 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 #include "report_generator.hpp"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include "comm_def.hpp"
 #include "report_utils.hpp"
 #include "categorization.hpp"
+#include "report_format.hpp"
+#include "baseline_findings.hpp"
+#include "profiler.hpp"
+#include "work_pool.hpp"
 
 #include "logger.hpp"
 
@@ -15,14 +22,12 @@ using json = nlohmann::json;
 
 namespace fs = std::filesystem;
 
-static json load_json(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open JSON file: " + path);
-    }
-    json j;
-    file >> j;
-    return j;
+namespace {
+
+    // The render threads of --render-jobs; null while reports are rendered by their submitters
+    std::mutex renderStageMutex;
+    std::unique_ptr<armor::WorkQueue> renderStage;
+
 }
 
 static int read_status_safe(const json& obj, const char* key)
@@ -107,27 +112,94 @@ void report_generator(const std::string& diff_json_path,
                       const std::string& output_json_path,
                       PARSER parser,
                       bool generate_json) {
-    json root = load_json(diff_json_path);
+    report_generator(armor::readReportDocument(diff_json_path), header_file_path, output_html_path,
+                     output_json_path, parser, generate_json);
+}
 
+void report_generator(const json& root,
+                      const std::string& header_file_path,
+                      const std::string& output_html_path,
+                      const std::string& output_json_path,
+                      PARSER parser,
+                      bool generate_json) {
     int parsed_status = 0, unparsed_status = 0;
     std::vector<std::string> header_failures;
 
     json diff_data =
         extract_ast_diff(root, &parsed_status, &unparsed_status, &header_failures);
-    std::vector<json> processed = preprocess_api_changes(diff_data, header_file_path);
 
-    // Determine compatibility
-    bool hasBackwardIncompatible = false;
-    for (auto& r : processed) {
-        if (r.contains("compatibility") &&
-            r["compatibility"].is_string() &&
-            r["compatibility"].get<std::string>() == "backward_incompatible")
-        {
-            hasBackwardIncompatible = true;
-            break;
-        }
+    ApiChangeGroups groups(header_file_path);
+    for (const auto& change : diff_data) {
+        groups.addChange(change);
+    }
+
+    std::string json_out = output_json_path;
+    if (generate_json && json_out.empty()) {
+        std::string header_name =
+            std::filesystem::path(header_file_path).filename().string();
+        json_out = armor::OutputPaths().jsonReportFile(header_name);
+    }
+    submit_report(std::move(groups), parsed_status, unparsed_status, output_html_path,
+                  json_out, parser, generate_json);
+}
+
+void submit_report(ApiChangeGroups&& groups,
+                   int parsed_status,
+                   int unparsed_status,
+                   const std::string& output_html_path,
+                   const std::string& output_json_path,
+                   PARSER parser,
+                   bool generate_json) {
+    std::unique_lock<std::mutex> lock(renderStageMutex);
+    if (!renderStage) {
+        lock.unlock();
+        report_generator(groups, parsed_status, unparsed_status, output_html_path,
+                         output_json_path, parser, generate_json);
+        return;
+    }
+    // Shared, as a job has to be copyable; the render thread times it for the submitter's header
+    auto shared = std::make_shared<ApiChangeGroups>(std::move(groups));
+    armor::profile::HeaderProfile* profile = armor::profile::current();
+    renderStage->submit([=] {
+        armor::profile::HeaderScope scope(profile);
+        report_generator(*shared, parsed_status, unparsed_status, output_html_path,
+                         output_json_path, parser, generate_json);
+    });
+}
+
+void start_report_rendering(unsigned threads, std::size_t capacity) {
+    std::scoped_lock<std::mutex> lock(renderStageMutex);
+    renderStage = std::make_unique<armor::WorkQueue>(threads, capacity);
+}
+
+std::size_t finish_report_rendering() {
+    std::unique_ptr<armor::WorkQueue> stage;
+    {
+        std::scoped_lock<std::mutex> lock(renderStageMutex);
+        stage = std::move(renderStage);
+    }
+    // Joined outside the lock, so late submitters render their reports themselves
+    return stage ? stage->finish() : 0;
+}
+
+void report_generator(const ApiChangeGroups& all_groups,
+                      int parsed_status,
+                      int unparsed_status,
+                      const std::string& output_html_path,
+                      const std::string& output_json_path,
+                      PARSER parser,
+                      bool generate_json) {
+    // With a baseline, only the changes it does not have are reported and judged
+    const armor::BaselineFindings& baselineFindings = armor::BaselineFindings::getInstance();
+    json baseline;
+    ApiChangeGroups delta;
+    if (baselineFindings.isLoaded()) {
+        delta = baselineFindings.delta(all_groups, baseline);
     }
+    const ApiChangeGroups& groups = baselineFindings.isLoaded() ? delta : all_groups;
 
+    // Determine compatibility
+    bool hasBackwardIncompatible = groups.hasBackwardIncompatible();
     std::string aggCompatibility =
         hasBackwardIncompatible ? "backward_incompatible"
                                 : "backward_compatible";
@@ -138,19 +210,52 @@ void report_generator(const std::string& diff_json_path,
                            (unsigned)unparsed_status,
                            !hasBackwardIncompatible);
 
-    const char* reason =
+    std::string reason =
         getReasonForCategorization((unsigned)parsed_status,
                                    (unsigned)unparsed_status,
                                    !hasBackwardIncompatible);
+    if (!baseline.is_null()) {
+        reason += " (" + std::to_string(baseline["known"].get<std::size_t>()) + " changes known from the baseline not shown, " +
+                  std::to_string(baseline["resolved"].size()) + " resolved)";
+    }
+    if (!all_groups.note().empty()) {
+        reason += " " + all_groups.note();
+    }
 
-    // HTML
+    ReportSummaries::Summary summary;
+    summary.overallStatus = overallStatus;
+    for (const ApiChangeGroups::Group& group : groups) {
+        summary.apiNames.push_back(group.name);
+    }
+    // All of them, as the records must still say what the header reports against another baseline
+    bool keepRecords = ReportSummaries::getInstance().keepsRecords();
+    if (keepRecords) {
+        for (const ApiChangeGroups::Group& group : all_groups) {
+            summary.records.push_back({group.headerfile, group.name, group.description(),
+                                       group.anyCompatibilityChanged, group.anyBackwardIncompatible});
+        }
+    }
+    if (keepRecords) {
+        summary.parsedStatus = parsed_status;
+        summary.unparsedStatus = unparsed_status;
+        summary.parser = parser;
+    }
+    ReportSummaries::getInstance().record(groups.headerFile(), std::move(summary));
+
+    // HTML, as a section of the combined report when the run writes one
     try {
-        generate_html_report(processed, output_html_path, parser,
-                             parsed_status, unparsed_status,
-                             aggCompatibility, overallStatus, reason);
+        CombinedHtmlReport& combined = CombinedHtmlReport::getInstance();
+        if (combined.isOpen()) {
+            combined.addHeader(groups, overallStatus, reason.c_str());
+        }
+        else if (!output_html_path.empty()) {
+            generate_html_report(groups, output_html_path, parser,
+                                 parsed_status, unparsed_status,
+                                 aggCompatibility, overallStatus, reason.c_str());
 
-        armor::user_print() << "HTML report generated at: "
-                            << output_html_path << "\n";
+            armor::user_print() << "HTML report generated at: "
+                                << output_html_path << "\n";
+        }
     }
     catch (const std::exception& e) {
         armor::user_error() << "Failed to generate HTML report: "
@@ -160,21 +265,12 @@ void report_generator(const std::string& diff_json_path,
     // JSON
     if (generate_json) {
         try {
-            std::string header_name =
-                std::filesystem::path(header_file_path).filename().string();
-
-            std::string json_report_dir = "armor_reports/json_reports";
-            std::filesystem::create_directories(json_report_dir);
-
-            std::string json_out =
-                json_report_dir + "/api_diff_report_" + header_name + ".json";
-
-            generate_json_report(processed, json_out,
+            generate_json_report(groups, output_json_path,
                                  parsed_status, unparsed_status,
-                                 aggCompatibility, overallStatus, reason);
+                                 aggCompatibility, overallStatus, reason.c_str(), baseline);
 
             armor::user_print() << "JSON report generated at: "
-                                << json_out << "\n";
+                                << output_json_path << "\n";
         }
         catch (const std::exception& e) {
             armor::user_error() << "Failed to generate JSON report: "
@@ -182,3 +278,25 @@ void report_generator(const std::string& diff_json_path,
         }
     }
 }
+
+const char* report_verdict(const std::string& header_file_path,
+                           int parsed_status,
+                           int unparsed_status,
+                           bool backward_incompatible) {
+    const char* overallStatus =
+        getOverAllCategory((unsigned)parsed_status,
+                           (unsigned)unparsed_status,
+                           !backward_incompatible);
+    ReportSummaries::getInstance().record(header_file_path, {overallStatus, {}});
+    return overallStatus;
+}
+
+const char* report_verdict(const json& root,
+                           const std::string& header_file_path) {
+    int parsed_status = 0, unparsed_status = 0;
+    json diff_data = extract_ast_diff(root, &parsed_status, &unparsed_status, nullptr);
+
+    bool backward_incompatible = std::any_of(diff_data.begin(), diff_data.end(),
+        [](const json& change) { return is_backward_incompatible_change(change); });
+    return report_verdict(header_file_path, parsed_status, unparsed_status, backward_incompatible);
+}
@@ -0,0 +1,92 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "categorization.hpp"
+#include "report_format.hpp"
+#include "report_merge.hpp"
+
+namespace {
+
+    ParsedDiffStatus parsedStatusOf(const std::string& name) {
+        for (int status = static_cast<int>(ParsedDiffStatus::FATAL_ERRORS);
+             status <= static_cast<int>(ParsedDiffStatus::NON_FUNCTIONAL_CHANGES); ++status) {
+            if (serialize(static_cast<ParsedDiffStatus>(status)) == name) {
+                return static_cast<ParsedDiffStatus>(status);
+            }
+        }
+        throw std::runtime_error("unknown parsed_status " + name);
+    }
+
+    UnParsedDiffStatus unparsedStatusOf(const std::string& name) {
+        if (name == serialize(UnParsedDiffStatus::UN_CHANGED)) {
+            return UnParsedDiffStatus::UN_CHANGED;
+        }
+        if (name == serialize(UnParsedDiffStatus::CHANGED)) {
+            return UnParsedDiffStatus::CHANGED;
+        }
+        throw std::runtime_error("unknown unparsed status " + name);
+    }
+
+}
+
+std::size_t armor::MergedReports::addRun(const std::string& root) {
+    std::filesystem::path reportDir = OutputPaths{root}.jsonReportDir();
+    if (!std::filesystem::is_directory(reportDir)) {
+        return 0;
+    }
+    // Sorted, so the combined report does not depend on the directory order
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(reportDir)) {
+        if (isReportFile(entry.path().string())) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    for (const auto& file : files) {
+        if (!std::ifstream(file)) {
+            throw std::runtime_error("Failed to open report " + file.string());
+        }
+        try {
+            json report = readReportDocument(file.string());
+            for (const json& record : report.at("api_diff")) {
+                groups.addRecord(record);
+            }
+            parsedStatus = std::min(parsedStatus, parsedStatusOf(report.at("parsed_status").get<std::string>()));
+            // The JSON report has always spelled this key so
+            if (unparsedStatusOf(report.at("unparsed_staus").get<std::string>()) == UnParsedDiffStatus::CHANGED) {
+                unparsedStatus = UnParsedDiffStatus::CHANGED;
+            }
+            if (report.at("compatibility").get<std::string>() == "backward_incompatible") {
+                backwardIncompatible = true;
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Malformed report " + file.string() + ": " + e.what());
+        }
+        ++reports;
+    }
+    return files.size();
+}
+
+void armor::MergedReports::write(const OutputPaths& outputs) const {
+    bool incompatible = backwardIncompatible || groups.hasBackwardIncompatible();
+    std::string aggCompatibility = incompatible ? "backward_incompatible" : "backward_compatible";
+    unsigned parsed = static_cast<unsigned>(parsedStatus);
+    unsigned unparsed = static_cast<unsigned>(unparsedStatus);
+    const char* overallStatus = getOverAllCategory(parsed, unparsed, !incompatible);
+    const char* reason = getReasonForCategorization(parsed, unparsed, !incompatible);
+
+    std::filesystem::create_directories(std::filesystem::path(outputs.summaryJsonFile()).parent_path());
+    generate_html_report(groups, outputs.summaryHtmlFile(), BETA_PARSER, parsed, unparsed,
+                         aggCompatibility, overallStatus, reason);
+    generate_json_report(groups, outputs.summaryJsonFile(), parsed, unparsed,
+                         aggCompatibility, overallStatus, reason);
+}
@@ -2,10 +2,12 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <map>
@@ -13,13 +15,33 @@
 #include <unordered_map>
 #include <tuple>
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Base64.h"
+#include "llvm/Support/Compression.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MathExtras.h"
+
+#include "simd_dispatch.hpp"
+
+#if defined(ARMOR_SIMD_X86)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "categorization.hpp"
 #include "comm_def.hpp"
 #include "report_utils.hpp"
 #include "html_template.hpp"
 #include <nlohmann/json.hpp>
 #include "diff_utils.hpp"
+#include "json_stream.hpp"
+#include "output_writer.hpp"
+#include "profiler.hpp"
+#include "work_pool.hpp"
 
 using json = nlohmann::json;
 
@@ -37,43 +59,253 @@ static std::string compose_api_name(const nlohmann::json& node) {
     return nt.empty() ? qn : (qn + ":" + nt);
 }
 
-// Proper HTML escape for table cells
-static std::string html_escape(const std::string& s) {
-    std::string out;
-    out.reserve(s.size());
-    for (char c : s) {
-        switch (c) {
+// The vector scanners return the offset of the first byte the HTML escape
+// replaces, or where their whole blocks end; skip_html_plain finishes either
+
+#if defined(ARMOR_SIMD_X86)
+ARMOR_TARGET_AVX2
+static size_t skip_html_plain_avx2(const char* data, size_t length) {
+    size_t i = 0;
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i apos = _mm256_set1_epi8('\'');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, amp), _mm256_cmpeq_epi8(v, lt)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, gt), _mm256_cmpeq_epi8(v, quot)));
+        hit = _mm256_or_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi8(v, apos), _mm256_cmpeq_epi8(v, nl)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+            return i + llvm::countTrailingZeros(mask);
+        }
+    }
+    return i;
+}
+#endif
+
+#if defined(__SSE2__)
+static size_t skip_html_plain_sse2(const char* data, size_t length) {
+    size_t i = 0;
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i apos = _mm_set1_epi8('\'');
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, quot)));
+        hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(v, apos), _mm_cmpeq_epi8(v, nl)));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask != 0) {
+            return i + llvm::countTrailingZeros(mask);
+        }
+    }
+    return i;
+}
+#endif
+
+#if defined(__ARM_NEON)
+static size_t skip_html_plain_neon(const char* data, size_t length) {
+    size_t i = 0;
+    const uint8x16_t amp = vdupq_n_u8('&');
+    const uint8x16_t lt = vdupq_n_u8('<');
+    const uint8x16_t gt = vdupq_n_u8('>');
+    const uint8x16_t quot = vdupq_n_u8('"');
+    const uint8x16_t apos = vdupq_n_u8('\'');
+    const uint8x16_t nl = vdupq_n_u8('\n');
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, amp), vceqq_u8(v, lt)),
+                                  vorrq_u8(vceqq_u8(v, gt), vceqq_u8(v, quot)));
+        hit = vorrq_u8(hit, vorrq_u8(vceqq_u8(v, apos), vceqq_u8(v, nl)));
+        // Narrow each byte lane to a nibble: 4 mask bits per input byte
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask != 0) {
+            return i + llvm::countTrailingZeros(mask) / 4;
+        }
+    }
+    return i;
+}
+#endif
+
+// Length of the prefix of [data, data + length) holding no byte the HTML
+// escape replaces: & < > " ' and the '\n' cells render as <br/>
+static size_t skip_html_plain(const char* data, size_t length) {
+    size_t i = 0;
+    switch (armor::simd::activeKernel()) {
+#if defined(ARMOR_SIMD_X86)
+        case armor::simd::Kernel::AVX2:
+            i = skip_html_plain_avx2(data, length);
+            break;
+#endif
+#if defined(__SSE2__)
+        case armor::simd::Kernel::SSE2:
+            i = skip_html_plain_sse2(data, length);
+            break;
+#endif
+#if defined(__ARM_NEON)
+        case armor::simd::Kernel::NEON:
+            i = skip_html_plain_neon(data, length);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; i < length; ++i) {
+        char c = data[i];
+        if (c == '&' || c == '<' || c == '>' || c == '"' || c == '\'' || c == '\n') {
+            return i;
+        }
+    }
+    return length;
+}
+
+// Appends `s` HTML-escaped to `out` in one pass, copying the runs between
+// special characters whole; '\n' becomes <br/> when `nl2br` is set
+static void append_html_escaped(std::string& out, const std::string& s, bool nl2br) {
+    const char* data = s.data();
+    size_t length = s.size();
+    size_t pos = 0;
+    while (pos < length) {
+        size_t plain = skip_html_plain(data + pos, length - pos);
+        out.append(data + pos, plain);
+        pos += plain;
+        if (pos == length) {
+            break;
+        }
+        switch (data[pos]) {
             case '&':  out += "&amp;";  break;
             case '<':  out += "&lt;";   break;
             case '>':  out += "&gt;";   break;
             case '\"': out += "&quot;"; break;
             case '\'': out += "&#39;";  break;
-            default:   out += c;        break;
+            default:   out += nl2br ? "<br/>" : "\n"; break;
         }
+        ++pos;
     }
-    return out;
 }
 
-// Escape then convert '\n' to <br/> so lines render separately within a cell
-static std::string escape_nl2br(const std::string& s) {
-    const std::string e = html_escape(s);
+// Proper HTML escape for table cells
+static std::string html_escape(const std::string& s) {
     std::string out;
-    out.reserve(e.size() + 8);
-    for (char c : e) {
-        if (c == '\n') out += "<br/>";
-        else out += c;
-    }
+    out.reserve(s.size());
+    append_html_escaped(out, s, /*nl2br=*/false);
     return out;
 }
 
-// Render colored compatibility text (only the text inside the cell, no classes)
-static std::string render_colored_compatibility(const std::string& compRaw) {
-    const bool isIncompatible = (compRaw == "backward_incompatible");
-    const char* color = isIncompatible ? "#d32f2f" : "#2e7d32"; // red / green
-    const std::string safe = escape_nl2br(compRaw);
-    std::ostringstream oss;
-    oss << "<span style=\"color:" << color << ";font-weight:600\">" << safe << "</span>";
-    return oss.str();
+// One cell of write_group_rows, lines rendering separately within it
+static void append_cell(std::string& row, const std::string& text) {
+    row += "<td> ";
+    append_html_escaped(row, text, /*nl2br=*/true);
+    row += " </td>\n";
+}
+
+// One table row per API of `groups`; each row is built in one string and
+// written whole
+static void write_group_rows(std::ostream& html, const ApiChangeGroups& groups) {
+    std::string row;
+    for (const ApiChangeGroups::Group& group : groups) {
+        row.clear();
+        row += "<tr>\n";
+        append_cell(row, group.headerfile);
+        append_cell(row, group.name);
+        row += "<td> ";
+        for (size_t i = 0; i < group.descriptions.size(); ++i) {
+            if (i) row += "<br/>";
+            append_html_escaped(row, group.descriptions[i], /*nl2br=*/true);
+        }
+        row += " </td>\n";
+        append_cell(row, group.changeType());
+
+        // Colored compatibility text (only the text inside the cell, no classes)
+        row += "<td> <span style=\"color:";
+        row += group.anyBackwardIncompatible ? "#d32f2f" : "#2e7d32"; // red / green
+        row += ";font-weight:600\">";
+        row += group.compatibility();
+        row += "</span> </td>\n";
+        row += "</tr>\n";
+        html.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+}
+
+// Buffer of the report streams, so a report of thousands of rows is written
+// in a few large writes
+constexpr std::size_t REPORT_WRITE_BUFFER_BYTES = 1 << 20;
+
+// Opens `out` at `path` writing through `buffer`, which must outlive the stream's use
+static void open_buffered(std::ofstream& out, std::vector<char>& buffer, const std::string& path) {
+    buffer.resize(REPORT_WRITE_BUFFER_BYTES);
+    out.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.open(path, std::ios::trunc);
+}
+
+// Size from which write_lazy_rows() compresses the rows, when zlib is available
+constexpr std::size_t LAZY_HTML_COMPRESS_MIN_BYTES = 64 * 1024;
+
+std::atomic<HtmlReportMode> html_report_mode{HtmlReportMode::TABLE};
+
+static bool use_lazy_rows(const ApiChangeGroups& groups) {
+    switch (html_report_mode.load(std::memory_order_relaxed)) {
+        case HtmlReportMode::LAZY: return true;
+        case HtmlReportMode::AUTO: return groups.size() >= LAZY_HTML_MIN_ROWS;
+        default:                   return false;
+    }
+}
+
+// The rows of `groups` as the armor-rows script element LAZY_HTML_SCRIPT reads:
+// the distinct header paths, and per API the index of its header, its name,
+// its descriptions and whether its compatibility changed or broke, as 0 or 1
+static void write_lazy_rows(std::ostream& html, const ApiChangeGroups& groups) {
+    json headers = json::array();
+    json rows = json::array();
+    std::unordered_map<std::string, std::size_t> headerIndex;
+    for (const ApiChangeGroups::Group& group : groups) {
+        auto inserted = headerIndex.emplace(group.headerfile, headerIndex.size());
+        if (inserted.second) {
+            headers.push_back(group.headerfile);
+        }
+        rows.push_back(json::array({inserted.first->second, group.name, group.description(),
+                                    group.anyCompatibilityChanged ? 1 : 0,
+                                    group.anyBackwardIncompatible ? 1 : 0}));
+    }
+    std::string payload = json{{"headers", std::move(headers)}, {"rows", std::move(rows)}}
+                              .dump(-1, ' ', false, json::error_handler_t::replace);
+
+    if (payload.size() >= LAZY_HTML_COMPRESS_MIN_BYTES && llvm::zlib::isAvailable()) {
+        llvm::SmallVector<char, 0> compressed;
+        if (llvm::Error err = llvm::zlib::compress(payload, compressed, llvm::zlib::BestSpeedCompression)) {
+            llvm::consumeError(std::move(err));
+        }
+        else {
+            html << "<script type=\"application/json\" id=\"armor-rows\" data-encoding=\"deflate-base64\">"
+                 << llvm::encodeBase64(compressed) << "</script>\n";
+            return;
+        }
+    }
+
+    // "</" only occurs inside JSON strings, where "<\/" reads the same and does not end the element
+    html << "<script type=\"application/json\" id=\"armor-rows\">";
+    std::size_t from = 0;
+    for (std::size_t at = payload.find("</"); at != std::string::npos; at = payload.find("</", from)) {
+        html.write(payload.data() + from, at + 1 - from);
+        html << "\\";
+        from = at + 1;
+    }
+    html.write(payload.data() + from, payload.size() - from);
+    html << "</script>\n";
+}
+
+static void write_status_box(std::ostream& html, const char* overall_status, const char* reason) {
+    html << "<div style='margin:12px 0;padding:10px;border:1px solid #ccc;"
+        "border-radius:5px;background:#fafafa;font-size:14px;'>\n";
+    html << "<b>Overall status:</b> " << overall_status << "<br/>\n";
+    html << "<b>Reason:</b> " << reason << "<br/>\n";
+    html << "</div>\n";
 }
 
 // Convenience for appending description lines
@@ -87,6 +319,12 @@ static std::string qname_stem(const std::string& qn) {
     return (pos == std::string::npos) ? qn : qn.substr(0, pos);
 }
 
+// Return everything before the last "::", or "" for a name at global scope.
+static std::string qname_scope(const std::string& qn) {
+    const auto pos = qn.rfind("::");
+    return (pos == std::string::npos) ? std::string() : qn.substr(0, pos);
+}
+
 // Return the last "leaf" after the final "::"
 static std::string qn_leaf(const std::string& qn) {
     const auto p = qn.rfind("::");
@@ -209,36 +447,29 @@ static ChildKey make_child_key(const nlohmann::json& j) {
 // Change category + row adapter
 // -----------------------------------------------------------------------------
 
-static std::string to_change_category(const std::string& rawChange, bool isTopLevelAddition) {
-    if (rawChange == "added" && isTopLevelAddition) return "Functionality_changed";
-    return "Compatibility_changed";
-}
-
 struct AtomicChange {
     std::string headerfile;
     std::string apiName;
     std::string detail;
-    std::string rawChange;    // "added", "removed", "modified", "attr_changed"
+    std::string rawChange;    // "added", "removed", "modified", "moved", "re-ordered", "attr_changed"
     bool        topLevel = false;
     std::string compatibility;    // optional override
 };
 
-static json to_record(const AtomicChange& c) {
-    const std::string category =
-        to_change_category(c.rawChange, c.topLevel);
-
-    const std::string compat =
-        !c.compatibility.empty()
-            ? c.compatibility
-            : ((category == "Compatibility_changed") ? "backward_incompatible" : "backward_compatible");
-
-    return json{
-        {"headerfile",    c.headerfile},
-        {"name",          c.apiName},
-        {"description",   c.detail},
-        {"changetype",    category},
-        {"compatibility", compat}
-    };
+// Declarations a replaced type name's row names; the diff entry lists them all
+constexpr size_t MAX_LISTED_TYPE_USERS = 20;
+
+// Only top-level additions change functionality alone; the compatibility
+// defaults to that of the change type unless overridden
+static ChangeRecord to_record(AtomicChange&& c) {
+    ChangeRecord record;
+    record.compatibilityChanged = !(c.rawChange == "added" && c.topLevel);
+    record.backwardIncompatible = c.compatibility.empty() ? record.compatibilityChanged
+                                                          : c.compatibility == "backward_incompatible";
+    record.headerfile  = std::move(c.headerfile);
+    record.name        = std::move(c.apiName);
+    record.description = std::move(c.detail);
+    return record;
 }
 
 // -----------------------------------------------------------------------------
@@ -638,6 +869,28 @@ static void append_child_desc(std::vector<std::string>& lines,
     }
 }
 
+// The line of a large added or removed subtree reported as a summary, see SubtreeSummary
+static void emit_subtree_summary(const json& node, std::vector<std::string>& lines) {
+    if (!node.contains("summary")) return;
+    const json& summary = node["summary"];
+    std::string line = node.value("nodeType", "") + " '" + node.value("qualifiedName", "") + "' summarized: " +
+                       std::to_string(summary.value("descendants", 0)) + " declarations";
+    const auto& kinds = summary.value("kinds", json::object());
+    std::string sep = " (";
+    for (auto it = kinds.begin(); it != kinds.end(); ++it) {
+        line += sep + std::to_string(it.value().get<uint64_t>()) + " " + it.key();
+        sep = ", ";
+    }
+    if (!kinds.empty()) line += ")";
+    const auto& names = summary.value("names", json::array());
+    sep = ", starting with '";
+    for (const auto& name : names) {
+        line += sep + name.get<std::string>() + "'";
+        sep = ", '";
+    }
+    add_desc_line(lines, line);
+}
+
 static void emit_added_removed_children(const json& node,
                                         std::vector<std::string>& lines,
                                         const std::string& parentTag)
@@ -696,6 +949,7 @@ static void describe_non_function_recursive(const json& node, std::vector<std::s
             add_desc_line(lines, nodeType + std::string(" added: '") + qualifiedName + "' with type '" + dataType + "'");
         else
             add_desc_line(lines, nodeType + std::string(" added: '") + qualifiedName + "'");
+        emit_subtree_summary(node, lines);
         emit_added_removed_children(node, lines, "added");
         return;
     }
@@ -705,6 +959,7 @@ static void describe_non_function_recursive(const json& node, std::vector<std::s
             add_desc_line(lines, nodeType + std::string(" removed: '") + qualifiedName + "' with type '" + dataType + "'");
         else
             add_desc_line(lines, nodeType + std::string(" removed: '") + qualifiedName + "'");
+        emit_subtree_summary(node, lines);
         emit_added_removed_children(node, lines, "removed");
         return;
     }
@@ -776,6 +1031,10 @@ static void describe_non_function_recursive(const json& node, std::vector<std::s
             addedItems[key] = ch;
         } else if (chTag == "modified") {
             describe_non_function_recursive(ch, lines);
+        } else if (chTag == "re-ordered") {
+            add_desc_line(lines, chType + " '" + chQN + "' moved from position " +
+                                 std::to_string(ch.value("oldIndex", 0u)) + " to " +
+                                 std::to_string(ch.value("newIndex", 0u)));
         } else if (chTag.empty() && ch.contains("children")) {
             describe_non_function_recursive(ch, lines);
         }
@@ -843,6 +1102,10 @@ static void describe_non_function_recursive(const json& node, std::vector<std::s
                         add_desc_line(lines, "Function '" + funcQN + "': Parameter '" + k + "' added" + (dtA.empty() ? "" : " (type '" + dtA + "')"));
                     }
                 }
+            } else if (removed.contains(LAYOUT) && added.contains(LAYOUT)) {
+                // --record-layouts: the record itself, with its old and new layout summary
+                add_desc_line(lines, subNodeType + " '" + paramQN + "' layout changed from '" +
+                                     removed.value(LAYOUT, "") + "' to '" + added.value(LAYOUT, "") + "'");
             } else {
                 const std::string dtR = removed.value("dataType", "");
                 const std::string dtA = added.value("dataType", "");
@@ -916,6 +1179,7 @@ static void describe_non_function_recursive(const json& node, std::vector<std::s
                     add_desc_line(lines, subNodeType + " removed: '" + paramQN + "' with type '" + dt + "'");
                 else
                     add_desc_line(lines, subNodeType + " removed: '" + paramQN + "'");
+                emit_subtree_summary(removed, lines);
             }
         }
     }
@@ -944,6 +1208,7 @@ static void describe_non_function_recursive(const json& node, std::vector<std::s
                     add_desc_line(lines, subNodeType + " added: '" + qn + "' with type '" + dt + "'");
                 else
                     add_desc_line(lines, subNodeType + " added: '" + qn + "'");
+                emit_subtree_summary(added, lines);
             }
         }
     }
@@ -968,182 +1233,647 @@ static std::string generate_non_function_description(const json& item) {
 }
 
 // -----------------------------------------------------------------------------
-// Group rows by (headerfile, name) so each API has a single description cell
+// Shapes of non-function entries, see DescriptionTemplates
 // -----------------------------------------------------------------------------
 
-static std::vector<json> group_records_by_function(const std::vector<json>& rows) {
-    using Key = std::pair<std::string,std::string>;
-    struct Agg {
-        std::string headerfile;
-        std::string name;
-        std::vector<std::string> descriptions;
-        bool anyCompatibilityChanged = false;
-        bool anyFunctionalityChanged = false;
-        bool anyBackwardIncompatible = false;
-    };
+// A slot in a description template: the rank of its name among the names of
+// its siblings, in SLOT_RANK_DIGITS digits so slots sort as the names do, then
+// the index of the name
+constexpr char SLOT_OPEN = '\x01';
+constexpr char SLOT_CLOSE = '\x02';
+constexpr size_t SLOT_RANK_DIGITS = 6;
+constexpr size_t MAX_SLOT_RANKS = 1000000;
+
+struct ShapeWalk {
+    std::string key;
+    std::vector<std::string> names;
+
+    std::string slot(std::string name, size_t rank = 0) {
+        const std::string digits = std::to_string(rank);
+        std::string token(1, SLOT_OPEN);
+        token.append(SLOT_RANK_DIGITS - digits.size(), '0');
+        token += digits;
+        token += std::to_string(names.size());
+        token += SLOT_CLOSE;
+        names.push_back(std::move(name));
+        return token;
+    }
+};
 
-    std::map<Key, Agg> buckets;
-    for (const auto& row : rows) {
-        const std::string hf   = row.value("headerfile", "");
-        const std::string nm   = row.value("name", "");
-        const std::string ct   = row.value("changetype", "");
-        const std::string desc = row.value("description", "");
-        const std::string comp = row.value("compatibility", "");
-
-        Key k{hf, nm};
-        auto& agg = buckets[k];
-        if (agg.headerfile.empty()) {
-            agg.headerfile = hf;
-            agg.name       = nm;
+// `field` of `node`, empty if missing; false if it is not a string
+static bool string_field(const json& node, std::string_view field, std::string& value) {
+    const auto it = node.find(field);
+    if (it == node.end()) {
+        value.clear();
+        return true;
+    }
+    if (!it->is_string()) return false;
+    value = it->get<std::string>();
+    return true;
+}
+
+// Appends the shape of `node` to `walk` and makes `out` the node with the fields
+// the describer reads, its names replaced by slots; `qnSlot` is the slot of its
+// qualified name. False below a function, whose overloads and parameters the
+// describer matches by the parts of their names.
+static bool tokenize_shape(const json& node, std::string qnSlot, ShapeWalk& walk, json& out) {
+    std::string nodeType, tag, dataType, layout;
+    if (!node.is_object() || !string_field(node, "nodeType", nodeType) || !string_field(node, "tag", tag) ||
+        !string_field(node, "dataType", dataType) || !string_field(node, LAYOUT, layout)) {
+        return false;
+    }
+    if (nodeType == "Function" || nodeType == "Parameter" || nodeType == "ReturnType") return false;
+
+    walk.key += nodeType;
+    walk.key += '|';
+    walk.key += tag;
+    walk.key += '|';
+    out = json{{"nodeType", nodeType}, {"tag", tag}, {"qualifiedName", std::move(qnSlot)}};
+    if (!dataType.empty()) {
+        walk.key += 't';
+        out["dataType"] = walk.slot(std::move(dataType));
+    }
+    if (node.contains(LAYOUT)) {
+        walk.key += 'l';
+        out[std::string(LAYOUT)] = walk.slot(std::move(layout));
+    }
+    for (const char* index : {"oldIndex", "newIndex"}) {
+        if (node.contains(index)) {
+            out[index] = node[index];
+            walk.key += index[0];
+            walk.key += out[index].dump();
+        }
+    }
+    if (node.contains("summary")) {
+        json summary = node["summary"];
+        if (!summary.is_object()) return false;
+        const auto names = summary.find("names");
+        if (names != summary.end()) {
+            if (!names->is_array()) return false;
+            for (json& name : *names) {
+                if (!name.is_string()) return false;
+                name = walk.slot(name.get<std::string>());
+            }
         }
-        if (!desc.empty()) agg.descriptions.push_back(desc);
-        if (ct == "Compatibility_changed") agg.anyCompatibilityChanged = true;
-        else if (ct == "Functionality_changed") agg.anyFunctionalityChanged = true;
+        walk.key += 's';
+        walk.key += summary.dump();
+        out["summary"] = std::move(summary);
+    }
+    if (!node.contains("children")) {
+        return true;
+    }
 
-        if (comp == "backward_incompatible") agg.anyBackwardIncompatible = true;
+    const json& children = node["children"];
+    if (!children.is_array()) return false;
+    std::vector<std::string> names;
+    names.reserve(children.size());
+    for (const auto& ch : children) {
+        std::string qn;
+        if (!ch.is_object() || !string_field(ch, "qualifiedName", qn)) return false;
+        names.push_back(std::move(qn));
+    }
+    // Siblings of one name share its slot, as the describer pairs them by name
+    std::vector<std::string> distinct = names;
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    if (distinct.size() >= MAX_SLOT_RANKS) return false;
+    std::vector<std::string> slots;
+    slots.reserve(distinct.size());
+    for (size_t rank = 0; rank < distinct.size(); ++rank) {
+        slots.push_back(walk.slot(distinct[rank], rank));
     }
 
-    std::vector<json> out;
-    out.reserve(buckets.size());
-    for (const auto& kv : buckets) {
-        const Agg& a = kv.second;
-        const bool anyCompChanged = a.anyCompatibilityChanged;
-        const std::string changetype = anyCompChanged ? "Compatibility Changed" : "Functionality Added";
-        const std::string compatibility = a.anyBackwardIncompatible ? "backward_incompatible" : "backward_compatible";
+    json shapedChildren = json::array();
+    walk.key += '[';
+    for (size_t i = 0; i < children.size(); ++i) {
+        const size_t rank = std::lower_bound(distinct.begin(), distinct.end(), names[i]) - distinct.begin();
+        walk.key += std::to_string(rank);
+        walk.key += ':';
+        json shaped;
+        if (!tokenize_shape(children[i], slots[rank], walk, shaped)) return false;
+        shapedChildren.push_back(std::move(shaped));
+    }
+    walk.key += ']';
+    out["children"] = std::move(shapedChildren);
+    return true;
+}
 
-        std::ostringstream d;
-        for (size_t i = 0; i < a.descriptions.size(); ++i) {
-            if (i) d << "\n";
-            d << a.descriptions[i];
+// `text` with every slot replaced by its name
+static std::string fill_slots(const std::string& text, const std::vector<std::string>& names) {
+    std::string filled;
+    filled.reserve(text.size());
+    size_t pos = 0;
+    while (true) {
+        const size_t open = text.find(SLOT_OPEN, pos);
+        if (open == std::string::npos) {
+            filled.append(text, pos, std::string::npos);
+            return filled;
         }
-
-        out.push_back(json{
-            {"headerfile",    a.headerfile},
-            {"name",          a.name},
-            {"description",   d.str()},
-            {"changetype",    changetype},
-            {"compatibility", compatibility}
-        });
+        filled.append(text, pos, open - pos);
+        const size_t close = text.find(SLOT_CLOSE, open);
+        filled += names[std::strtoul(text.c_str() + open + 1 + SLOT_RANK_DIGITS, nullptr, 10)];
+        pos = close + 1;
     }
-    return out;
 }
 
-} // anonymous namespace
+// A modified non-function entry that only adds enumerators or fields
+static bool is_compatible_modification(const json& change) {
+    return change.value("tag", "") == "modified" &&
+           (is_enum_only_value_additions(change) || is_aggregate_only_field_additions_deep(change));
+}
 
 // -----------------------------------------------------------------------------
-// Public API
+// Records of one top-level diff entry, handed to `emit` one at a time
 // -----------------------------------------------------------------------------
 
-std::pair<std::string, std::string> prepare_report_output_dirs(const std::string& headerName)
+template <typename Emit>
+static void emit_change_records(const json& change,
+                                const std::string& header_file_path,
+                                DescriptionTemplates& templates,
+                                Emit&& emit)
 {
-    std::filesystem::create_directories("armor_reports/html_reports");
-    std::filesystem::create_directories("armor_reports/json_reports");
-    std::string json_out = "armor_reports/json_reports/api_diff_report_" + headerName + ".json";
-    std::string html_out = "armor_reports/html_reports/api_diff_report_" + headerName + ".html";
-    return {json_out, html_out};
-}
+    const std::string nodeType = change.value("nodeType", "");
+    const std::string tag      = change.value("tag", "");
+    const std::string api_name = compose_api_name(change);
+
+    // ---------------- Moved nodes: the old name is gone, the declaration itself is unchanged
+    if (tag == "moved") {
+        const std::string oldQN = change.value("oldQualifiedName", "");
+        const std::string newQN = change.value("qualifiedName", "");
+        const char* how = qname_scope(oldQN) == qname_scope(newQN) ? " renamed: '" : " moved: '";
+        json oldNode{{"qualifiedName", oldQN}, {"nodeType", nodeType}};
+        AtomicChange row{header_file_path, compose_api_name(oldNode),
+                         nodeType + how + oldQN + "' to '" + newQN + "'", "moved", /*topLevel*/false, ""};
+        emit(to_record(std::move(row)));
+        return;
+    }
 
-std::vector<json> preprocess_api_changes(const json& api_differences,
-                                         const std::string& header_file_path)
-{
-    std::vector<json> processed;
+    // ---------------- A replaced type name: one row for every declaration it changed
+    if (tag == "type_changed") {
+        const std::string oldType = change.value("qualifiedName", "");
+        const std::string newType = change.value("newType", "");
+        const auto& affected = change.value("affected", json::array());
+        std::string detail = "Type '" + oldType + "' replaced by '" + newType + "' in " +
+                             std::to_string(affected.size()) + " declarations: ";
+        size_t listed = std::min<size_t>(affected.size(), MAX_LISTED_TYPE_USERS);
+        for (size_t i = 0; i < listed; ++i) {
+            detail += i ? ", " : "";
+            detail += affected[i].get<std::string>();
+        }
+        if (listed < affected.size()) {
+            detail += " and " + std::to_string(affected.size() - listed) + " more";
+        }
+        AtomicChange row{header_file_path, oldType, std::move(detail), "modified", /*topLevel*/false, ""};
+        emit(to_record(std::move(row)));
+        return;
+    }
 
-    for (const auto& change : api_differences) {
-        const std::string nodeType = change.value("nodeType", "");
-        const std::string tag      = change.value("tag", "");
-        const std::string api_name = compose_api_name(change);
+    // ---------------- Non-Function nodes
+    if (nodeType != "Function") {
+        AtomicChange row;
+        row.headerfile = header_file_path;
+        row.apiName    = api_name;
+        row.detail     = templates.describe(change);
+        row.rawChange  = tag;
+        row.topLevel   = (tag == "added");
+
+        if (is_compatible_modification(change)) {
+            row.compatibility = "backward_compatible";
+        }
 
-        // ---------------- Non-Function nodes
-        if (nodeType != "Function") {
-            AtomicChange row;
-            row.headerfile = header_file_path;
-            row.apiName    = api_name;
-            row.detail     = generate_non_function_description(change);
-            row.rawChange  = tag;
-            row.topLevel   = (tag == "added");
-
-            if (tag == "modified" &&
-                (is_enum_only_value_additions(change) ||
-                 is_aggregate_only_field_additions_deep(change))) {
-                row.compatibility = "backward_compatible";
-            }
+        emit(to_record(std::move(row)));
+        return;
+    }
+
+    // ---------------- Function nodes
+    if (tag == "added") {
+        AtomicChange row{header_file_path, api_name, "Function added", "added", /*topLevel*/true, ""};
+        emit(to_record(std::move(row)));
+        return;
+    }
+    if (tag == "removed") {
+        AtomicChange row{header_file_path, api_name, "Function removed", "removed", /*topLevel*/false, ""};
+        emit(to_record(std::move(row)));
+        return;
+    }
+
+    // tag == "modified" -> inspect internals
+    const auto& children = change.value("children", json::array());
+    std::vector<AtomicChange> rows;
+    std::vector<json> directAddedParams, directRemovedParams;
+    json removedFn, addedFn;
+
+    for (const auto& ch : children) {
+        const std::string chType = ch.value("nodeType", "");
+        const std::string chTag  = ch.value("tag", "");
 
-            processed.push_back(to_record(row));
+        if (chType == "Function" && (chTag == "removed" || chTag == "added")) {
+            if (chTag == "removed") removedFn = ch;
+            else                     addedFn  = ch;
             continue;
         }
 
-        // ---------------- Function nodes
-        if (tag == "added") {
-            AtomicChange row{header_file_path, api_name, "Function added", "added", /*topLevel*/true, ""};
-            processed.push_back(to_record(row));
+        if ((chType == "Parameter" || chType == "ReturnType") && chTag == "modified") {
+            auto sub = diff_nested_mod_node(header_file_path, api_name, ch);
+            rows.insert(rows.end(), sub.begin(), sub.end());
             continue;
         }
-        if (tag == "removed") {
-            AtomicChange row{header_file_path, api_name, "Function removed", "removed", /*topLevel*/false, ""};
-            processed.push_back(to_record(row));
+
+        if (chType == "Parameter" && (chTag == "added" || chTag == "removed")) {
+            if (chTag == "added") directAddedParams.push_back(ch);
+            else                  directRemovedParams.push_back(ch);
             continue;
         }
 
-        // tag == "modified" -> inspect internals
-        const auto& children = change.value("children", json::array());
-        std::vector<AtomicChange> rows;
-        std::vector<json> directAddedParams, directRemovedParams;
-        json removedFn, addedFn;
+        if (chType == "Parameter" && chTag == "re-ordered") {
+            AtomicChange row{header_file_path, api_name,
+                             "Parameter '" + ch.value("qualifiedName", "") + "' moved from position " +
+                                 std::to_string(ch.value("oldIndex", 0u)) + " to " +
+                                 std::to_string(ch.value("newIndex", 0u)),
+                             "re-ordered", /*topLevel*/false, ""};
+            rows.push_back(std::move(row));
+            continue;
+        }
+    }
 
-        for (const auto& ch : children) {
-            const std::string chType = ch.value("nodeType", "");
-            const std::string chTag  = ch.value("tag", "");
+    if (!removedFn.is_null() || !addedFn.is_null()) {
+        auto attrRows = diff_function_attributes(header_file_path, api_name, removedFn, addedFn);
+        rows.insert(rows.end(), attrRows.begin(), attrRows.end());
+    }
 
-            if (chType == "Function" && (chTag == "removed" || chTag == "added")) {
-                if (chTag == "removed") removedFn = ch;
-                else                     addedFn  = ch;
-                continue;
-            }
+    if (!directAddedParams.empty() || !directRemovedParams.empty()) {
+        auto paramRows = diff_direct_param_nodes(header_file_path, api_name,
+                                                 directRemovedParams, directAddedParams);
+        rows.insert(rows.end(), paramRows.begin(), paramRows.end());
+    }
 
-            if ((chType == "Parameter" || chType == "ReturnType") && chTag == "modified") {
-                auto sub = diff_nested_mod_node(header_file_path, api_name, ch);
-                rows.insert(rows.end(), sub.begin(), sub.end());
-                continue;
-            }
+    if (rows.empty()) {
+        AtomicChange row;
+        row.headerfile = header_file_path;
+        row.apiName    = api_name;
+        row.detail     = "Function modified";
+        row.rawChange  = "modified";
+        row.topLevel   = false;
+        rows.push_back(std::move(row));
+    }
 
-            if (chType == "Parameter" && (chTag == "added" || chTag == "removed")) {
-                if (chTag == "added") directAddedParams.push_back(ch);
-                else                  directRemovedParams.push_back(ch);
-                continue;
-            }
-        }
+    for (auto& r : rows) {
+        r.topLevel = false;
+        emit(to_record(std::move(r)));
+    }
+}
 
-        if (!removedFn.is_null() || !addedFn.is_null()) {
-            auto attrRows = diff_function_attributes(header_file_path, api_name, removedFn, addedFn);
-            rows.insert(rows.end(), attrRows.begin(), attrRows.end());
-        }
+// -----------------------------------------------------------------------------
+// Records of a whole diff, made in chunks of entries on `jobs` threads and
+// handed to `emit` in the order of the entries
+// -----------------------------------------------------------------------------
 
-        if (!directAddedParams.empty() || !directRemovedParams.empty()) {
-            auto paramRows = diff_direct_param_nodes(header_file_path, api_name,
-                                                     directRemovedParams, directAddedParams);
-            rows.insert(rows.end(), paramRows.begin(), paramRows.end());
-        }
+// Top-level entries one task makes the records of
+constexpr size_t RECORD_CHUNK = 256;
 
-        if (rows.empty()) {
-            AtomicChange row;
-            row.headerfile = header_file_path;
-            row.apiName    = api_name;
-            row.detail     = "Function modified";
-            row.rawChange  = "modified";
-            row.topLevel   = false;
-            rows.push_back(std::move(row));
+template <typename Emit>
+static void emit_change_records_chunked(const json& changes,
+                                        const std::string& header_file_path,
+                                        unsigned jobs,
+                                        Emit&& emit)
+{
+    if (jobs <= 1 || changes.size() <= RECORD_CHUNK) {
+        DescriptionTemplates templates;
+        for (const auto& change : changes) {
+            emit_change_records(change, header_file_path, templates, emit);
         }
+        return;
+    }
 
-        for (auto& r : rows) {
-            r.topLevel = false;
-            processed.push_back(to_record(r));
+    const size_t chunkCount = (changes.size() + RECORD_CHUNK - 1) / RECORD_CHUNK;
+    std::vector<std::vector<ChangeRecord>> chunks(chunkCount);
+    armor::parallelFor(chunkCount, jobs, [&](size_t c) {
+        const size_t end = std::min(changes.size(), (c + 1) * RECORD_CHUNK);
+        DescriptionTemplates templates;
+        for (size_t i = c * RECORD_CHUNK; i < end; ++i) {
+            emit_change_records(changes[i], header_file_path, templates,
+                                [&](ChangeRecord&& record) { chunks[c].push_back(std::move(record)); });
         }
+    });
+    for (auto& chunk : chunks) {
+        for (auto& record : chunk) {
+            emit(std::move(record));
+        }
+        std::vector<ChangeRecord>().swap(chunk);
     }
+}
+
+} // anonymous namespace
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+std::pair<std::string, std::string> prepare_report_output_dirs(const std::string& headerName,
+                                                               const armor::OutputPaths& outputs,
+                                                               armor::ReportFormat format)
+{
+    std::filesystem::create_directories(outputs.htmlReportDir());
+    std::filesystem::create_directories(outputs.jsonReportDir());
+    return {outputs.jsonReportFile(headerName, format), outputs.htmlReportFile(headerName)};
+}
+
+std::vector<ChangeRecord> preprocess_api_changes(const json& api_differences,
+                                                 const std::string& header_file_path,
+                                                 unsigned jobs)
+{
+    armor::profile::PhaseTimer timer(armor::profile::Phase::PREPROCESS_API_CHANGES);
+    std::vector<ChangeRecord> processed;
+
+    emit_change_records_chunked(api_differences, header_file_path, jobs,
+                                [&](ChangeRecord&& record) { processed.push_back(std::move(record)); });
 
     return processed;
 }
 
-void generate_html_report(const std::vector<json>& processed_data,
+std::string DescriptionTemplates::describe(const json& change) {
+    ShapeWalk walk;
+    std::string qn;
+    json shaped;
+    if (!change.is_object() || !string_field(change, "qualifiedName", qn) ||
+        !tokenize_shape(change, walk.slot(std::move(qn)), walk, shaped)) {
+        return generate_non_function_description(change);
+    }
+    auto it = templates.find(walk.key);
+    if (it == templates.end()) {
+        it = templates.emplace(std::move(walk.key), generate_non_function_description(shaped)).first;
+    } else {
+        ++hits;
+    }
+    return fill_slots(it->second, walk.names);
+}
+
+json ChangeRecord::toJson() const {
+    return json{
+        {"headerfile",    headerfile},
+        {"name",          name},
+        {"description",   description},
+        {"changetype",    compatibilityChanged ? "Compatibility_changed" : "Functionality_changed"},
+        {"compatibility", backwardIncompatible ? "backward_incompatible" : "backward_compatible"}
+    };
+}
+
+ChangeRecord ChangeRecord::fromJson(const json& record) {
+    ChangeRecord result;
+    result.headerfile           = record.value("headerfile", "");
+    result.name                 = record.value("name", "");
+    result.description          = record.value("description", "");
+    // Records spell the change type as Compatibility_changed, report rows as Compatibility Changed
+    const std::string changeType = record.value("changetype", "");
+    result.compatibilityChanged = changeType == "Compatibility_changed" || changeType == "Compatibility Changed";
+    result.backwardIncompatible = record.value("compatibility", "") == "backward_incompatible";
+    return result;
+}
+
+bool is_backward_incompatible_change(const json& change)
+{
+    // Mirrors the compatibility emit_change_records gives its records: only
+    // additions, and non-function modifications adding enumerators or fields,
+    // are compatible; every record of a modified function is incompatible
+    const std::string tag = change.value("tag", "");
+    if (tag == "added") {
+        return false;
+    }
+    if (change.value("nodeType", "") == "Function") {
+        return true;
+    }
+    return !is_compatible_modification(change);
+}
+
+json ApiChangeGroups::Group::toRecord() const {
+    return json{
+        {"headerfile",    headerfile},
+        {"name",          name},
+        {"description",   description()},
+        {"changetype",    changeType()},
+        {"compatibility", compatibility()}
+    };
+}
+
+const char* ApiChangeGroups::Group::changeType() const {
+    return anyCompatibilityChanged ? "Compatibility Changed" : "Functionality Added";
+}
+
+const char* ApiChangeGroups::Group::compatibility() const {
+    return anyBackwardIncompatible ? "backward_incompatible" : "backward_compatible";
+}
+
+std::string ApiChangeGroups::Group::description() const {
+    std::ostringstream d;
+    for (size_t i = 0; i < descriptions.size(); ++i) {
+        if (i) d << "\n";
+        d << descriptions[i];
+    }
+    return d.str();
+}
+
+void setHtmlReportMode(HtmlReportMode mode) {
+    html_report_mode.store(mode, std::memory_order_relaxed);
+}
+
+HtmlReportMode getHtmlReportMode() {
+    return html_report_mode.load(std::memory_order_relaxed);
+}
+
+ReportSummaries& ReportSummaries::getInstance() {
+    static ReportSummaries instance;
+    return instance;
+}
+
+void ReportSummaries::record(const std::string& headerFile, Summary summary) {
+    std::lock_guard<std::mutex> lock(mutex);
+    summaries[headerFile] = std::move(summary);
+}
+
+bool ReportSummaries::find(const std::string& headerFile, Summary& summary) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = summaries.find(headerFile);
+    if (it == summaries.end()) {
+        return false;
+    }
+    summary = it->second;
+    return true;
+}
+
+bool ReportSummaries::take(const std::string& headerFile, Summary& summary) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = summaries.find(headerFile);
+    if (it == summaries.end()) {
+        return false;
+    }
+    summary = std::move(it->second);
+    summaries.erase(it);
+    return true;
+}
+
+void ReportSummaries::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    summaries.clear();
+}
+
+void ReportSummaries::keepRecords(bool keep) {
+    std::lock_guard<std::mutex> lock(mutex);
+    keepingRecords = keep;
+}
+
+bool ReportSummaries::keepsRecords() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return keepingRecords;
+}
+
+void ApiChangeGroups::addChange(const json& change) {
+    armor::profile::PhaseTimer timer(armor::profile::Phase::PREPROCESS_API_CHANGES, /*traced=*/false);
+    emit_change_records(change, header_file_path, descriptionTemplates,
+                        [this](ChangeRecord&& record) { addRecord(std::move(record)); });
+}
+
+void ApiChangeGroups::addChanges(const json& changes, unsigned jobs) {
+    armor::profile::PhaseTimer timer(armor::profile::Phase::PREPROCESS_API_CHANGES, /*traced=*/false);
+    emit_change_records_chunked(changes, header_file_path, jobs,
+                                [this](ChangeRecord&& record) { addRecord(std::move(record)); });
+}
+
+void ApiChangeGroups::addRecord(const json& record) {
+    addRecord(ChangeRecord::fromJson(record));
+}
+
+void ApiChangeGroups::addRecord(ChangeRecord&& record) {
+    std::size_t header = headerIds.size();
+    auto headerIt = headerIds.find(record.headerfile);
+    if (headerIt != headerIds.end()) {
+        header = headerIt->second;
+    }
+    else {
+        headerIds.emplace(record.headerfile, header);
+    }
+
+    Group* group;
+    auto it = index.find(GroupKey{header, record.name});
+    if (it != index.end()) {
+        group = &groups[it->second];
+    }
+    else {
+        group = &groups.emplace_back();
+        group->headerfile = std::move(record.headerfile);
+        group->name       = std::move(record.name);
+        index.emplace(GroupKey{header, group->name}, groups.size() - 1);
+        sorted = false;
+    }
+
+    if (!record.description.empty()) group->descriptions.push_back(std::move(record.description));
+    if (record.compatibilityChanged) group->anyCompatibilityChanged = true;
+
+    if (record.backwardIncompatible) {
+        group->anyBackwardIncompatible = true;
+        backwardIncompatible = true;
+    }
+}
+
+void ApiChangeGroups::sortGroups() const {
+    std::sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) {
+        return std::tie(a.headerfile, a.name) < std::tie(b.headerfile, b.name);
+    });
+    index.clear();
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+        index.emplace(GroupKey{headerIds.at(groups[i].headerfile), groups[i].name}, i);
+    }
+    sorted = true;
+}
+
+std::deque<ApiChangeGroups::Group>::const_iterator ApiChangeGroups::begin() const {
+    if (!sorted) {
+        sortGroups();
+    }
+    return groups.cbegin();
+}
+
+std::deque<ApiChangeGroups::Group>::const_iterator ApiChangeGroups::end() const {
+    return groups.cend();
+}
+
+CombinedHtmlReport& CombinedHtmlReport::getInstance() {
+    static CombinedHtmlReport instance;
+    return instance;
+}
+
+void CombinedHtmlReport::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty()) {
+        std::filesystem::create_directories(dir);
+    }
+    index.clear();
+    open_buffered(page, pageBuffer, path);
+    if (!page) {
+        throw std::runtime_error("Failed to create combined report " + path);
+    }
+    write_chunks(page, COMBINED_HTML_HEADER);
+}
+
+bool CombinedHtmlReport::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return page.is_open();
+}
+
+void CombinedHtmlReport::beginSection(const std::string& header_file_path, const char* overall_status,
+                                      std::size_t apiCount) {
+    index.push_back({header_file_path, overall_status, apiCount, index.size()});
+    page << "<section id=\"header-" << index.back().section << "\">\n";
+    page << "<h2>" << html_escape(header_file_path) << "</h2>\n";
+}
+
+void CombinedHtmlReport::addHeader(const ApiChangeGroups& groups, const char* overall_status, const char* reason) {
+    armor::profile::PhaseTimer timer(armor::profile::Phase::GENERATE_HTML_REPORT);
+    std::size_t apiCount = groups.size();
+    std::lock_guard<std::mutex> lock(mutex);
+    beginSection(groups.headerFile(), overall_status, apiCount);
+    if (!groups.empty()) {
+        write_chunks(page, COMBINED_API_TABLE_HEADER);
+        write_group_rows(page, groups);
+        page << "</table>\n";
+    }
+    write_status_box(page, overall_status, reason);
+    page << "</section>\n";
+}
+
+void CombinedHtmlReport::addMissingHeader(const std::string& header_file_path, const char* overall_status,
+                                          const char* reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    beginSection(header_file_path, overall_status, 0);
+    write_status_box(page, overall_status, reason);
+    page << "</section>\n";
+}
+
+bool CombinedHtmlReport::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::sort(index.begin(), index.end(),
+              [](const IndexRow& a, const IndexRow& b) { return a.headerFile < b.headerFile; });
+    page << "<div class=\"index\">\n";
+    page << "<h2>Headers (" << index.size() << ")</h2>\n";
+    page << "<table>\n<tr><th>Header Name</th><th>Overall Status</th><th>Changed APIs</th></tr>\n";
+    for (const IndexRow& row : index) {
+        page << "<tr>\n";
+        page << "<td><a href=\"#header-" << row.section << "\">" << html_escape(row.headerFile) << "</a></td>\n";
+        const bool incompatible = row.overallStatus == serialize(OverAllStatus::BACKWARD_INCOMPATIBLE);
+        page << "<td><span style=\"color:" << (incompatible ? "#d32f2f" : "#2e7d32") << ";font-weight:600\">"
+             << html_escape(row.overallStatus) << "</span></td>\n";
+        page << "<td> " << row.apiCount << " </td>\n";
+        page << "</tr>\n";
+    }
+    page << "</table>\n</div>\n";
+    page << COMBINED_HTML_FOOTER;
+    bool written = static_cast<bool>(page);
+    page.close();
+    index.clear();
+    return written;
+}
+
+void generate_html_report(const ApiChangeGroups& groups,
                           const std::string& output_html_path,
                           PARSER parser,
                           int parsed_status,
@@ -1153,11 +1883,13 @@ void generate_html_report(const std::vector<json>& processed_data,
                           const char* reason,
                           std::pair<bool, bool> files_exists
                         ) {
-    std::ofstream html(output_html_path);
+    armor::profile::PhaseTimer timer(armor::profile::Phase::GENERATE_HTML_REPORT);
+    armor::OutputFile output(output_html_path);
+    std::ostream& html = output.stream();
     ParsedDiffStatus parsedStatus = static_cast<ParsedDiffStatus>(parsed_status);
     UnParsedDiffStatus unParsedStatus = static_cast<UnParsedDiffStatus>(unparsed_status);
 
-    if (processed_data.empty()) {
+    if (groups.empty()) {
 
         const auto& [file1_exists, file2_exists] = files_exists;
 
@@ -1173,72 +1905,100 @@ void generate_html_report(const std::vector<json>& processed_data,
         }
         else{
             assert( file1_exists | file2_exists );
-            html << SIMPLE_HEADER; 
-            html << "<div style='margin:12px 0;padding:10px;border:1px solid #ccc;"
-            "border-radius:5px;background:#fafafa;font-size:14px;'>\n";
-            html << "<b>Overall status:</b> " << overall_status << "<br/>\n";
-            html << "<b>Reason:</b> " << reason << "<br/>\n";
-            html << "</div>\n";
+            write_chunks(html, SIMPLE_HEADER);
+            write_status_box(html, overall_status, reason);
             
         }
     } 
+    else if (use_lazy_rows(groups)) {
+        html << LAZY_HTML_HEADER;
+        if (parser == ALPHA_PARSER) {
+            html << COMPILER_ERRORS_NOTE;
+        }
+        html << LAZY_HTML_TABLE;
+        write_lazy_rows(html, groups);
+        html << LAZY_HTML_SCRIPT;
+        write_status_box(html, overall_status, reason);
+        html << LAZY_HTML_FOOTER;
+        output.close();
+        return;
+    }
     else {
 
         switch (parser) {
             case ALPHA_PARSER:
-                html << ALPHA_HTML_HEADER;
+                write_chunks(html, ALPHA_HTML_HEADER);
                 break;
             case BETA_PARSER:
-                html << BETA_HTML_HEADER;
+                write_chunks(html, BETA_HTML_HEADER);
                 break;
             default:
                 break;
         }
         
-        auto grouped = group_records_by_function(processed_data);
-        for (const auto& entry : grouped) {
-            html << "<tr>\n";
-            html << "<td> " << escape_nl2br(entry.value("headerfile", ""))   << " </td>\n";
-            html << "<td> " << escape_nl2br(entry.value("name", ""))         << " </td>\n";
-            html << "<td> " << escape_nl2br(entry.value("description", ""))  << " </td>\n";
-            html << "<td> " << escape_nl2br(entry.value("changetype", ""))   << " </td>\n";
-
-            const std::string comp = entry.value("compatibility", "");
-            html << "<td> " << render_colored_compatibility(comp) << " </td>\n";
-            html << "</tr>\n";
-        }
-
-        html << "<div style='margin:12px 0;padding:10px;border:1px solid #ccc;"
-            "border-radius:5px;background:#fafafa;font-size:14px;'>\n";
-        html << "<b>Overall status:</b> " << overall_status << "<br/>\n";
-        html << "<b>Reason:</b> " << reason << "<br/>\n";
-        html << "</div>\n";
+        write_group_rows(html, groups);
+        write_status_box(html, overall_status, reason);
     }
 
     html << HTML_FOOTER;
-    html.close();
+    output.close();
 }
 
-void generate_json_report(const std::vector<json>& processed_data,
+void generate_json_report(const ApiChangeGroups& groups,
                           const std::string& output_json_path,
                           int parsed_status,
                           int unparsed_status,
                           const std::string& agg_compatibility,
                           const char* overall_status,
-                          const char* reason)
+                          const char* reason,
+                          const json& baseline)
 {
     if (output_json_path.empty()) return;
-    std::ofstream jf(output_json_path);
+    armor::profile::PhaseTimer timer(armor::profile::Phase::GENERATE_JSON_REPORT);
+    armor::ReportFormat format = armor::reportFormatOfPath(output_json_path);
+    armor::OutputFile output(output_json_path, format != armor::ReportFormat::JSON);
+    std::ostream& jf = output.stream();
     ParsedDiffStatus parsedStatus = static_cast<ParsedDiffStatus>(parsed_status);
     UnParsedDiffStatus unParsedStatus = static_cast<UnParsedDiffStatus>(unparsed_status);
-    auto grouped = group_records_by_function(processed_data);
-    json wrapper;
-    wrapper["api_diff"]       = grouped;
-    wrapper["parsed_status"]  = serialize(parsedStatus);
-    wrapper["unparsed_staus"] = serialize(unParsedStatus);
-    wrapper["compatibility"]  = agg_compatibility;
-    wrapper["overall_status"] = overall_status;
-    wrapper["reason"]         = reason; 
-    jf << wrapper.dump(4);
-    jf.close();
+
+    if (format != armor::ReportFormat::JSON) {
+        json apiDiff = json::array();
+        for (const ApiChangeGroups::Group& group : groups) {
+            apiDiff.push_back(group.toRecord());
+        }
+        json report{{"api_diff",       std::move(apiDiff)},
+                    {"compatibility",  agg_compatibility},
+                    {"overall_status", overall_status},
+                    {"parsed_status",  serialize(parsedStatus)},
+                    {"reason",         reason},
+                    {"unparsed_staus", serialize(unParsedStatus)}};
+        if (!baseline.is_null()) {
+            report["baseline"] = baseline;
+        }
+        armor::writeReportDocument(jf, report, format);
+        armor::profile::count(armor::profile::Counter::JSON_BYTES_WRITTEN, output.size());
+        output.close();
+        return;
+    }
+
+    // Members in key order, as json::dump() of the whole report used to write them
+    armor::JsonStreamWriter writer(jf);
+    writer.beginObject();
+    writer.key("api_diff");
+    writer.beginArray();
+    for (const ApiChangeGroups::Group& group : groups) {
+        writer.value(group.toRecord());
+    }
+    writer.endArray();
+    if (!baseline.is_null()) {
+        writer.field("baseline", baseline);
+    }
+    writer.field("compatibility",  agg_compatibility);
+    writer.field("overall_status", overall_status);
+    writer.field("parsed_status",  serialize(parsedStatus));
+    writer.field("reason",         reason);
+    writer.field("unparsed_staus", serialize(unParsedStatus));
+    writer.endObject();
+    armor::profile::count(armor::profile::Counter::JSON_BYTES_WRITTEN, output.size());
+    output.close();
 }
@@ -0,0 +1,252 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include "repro_bundle.hpp"
+
+namespace {
+
+    constexpr int BUNDLE_FORMAT_VERSION = 1;
+    constexpr const char* BUNDLE_FILE = "bundle.json";
+    constexpr const char* OVERLAY_FILE = "overlay.yaml";
+    constexpr const char* FILES_DIR = "files";
+
+    // Where the copy of the file at absolute `path` goes, relative to the bundle
+    std::string copyPathOf(const std::string& path) {
+        return (std::filesystem::path(FILES_DIR) / std::filesystem::path(path).relative_path()).generic_string();
+    }
+
+    // A directory of the overlay, nested as the VFS overlay format wants it
+    struct OverlayDirectory {
+        std::map<std::string, OverlayDirectory> directories;
+        std::map<std::string, std::string> files;
+
+        nlohmann::json contents() const {
+            nlohmann::json entries = nlohmann::json::array();
+            for (const auto& [name, directory] : directories) {
+                entries.push_back({{"type", "directory"}, {"name", name}, {"contents", directory.contents()}});
+            }
+            for (const auto& [name, copy] : files) {
+                entries.push_back({{"type", "file"}, {"name", name}, {"external-contents", copy}});
+            }
+            return entries;
+        }
+    };
+
+    nlohmann::json versionToJson(const armor::ReproBundle::Version& version) {
+        return {{"project_root", version.projectRoot}, {"file", version.file}, {"flags", version.flags}};
+    }
+
+    armor::ReproBundle::Version versionFromJson(const nlohmann::json& json) {
+        armor::ReproBundle::Version version;
+        version.projectRoot = json.at("project_root").get<std::string>();
+        version.file = json.at("file").get<std::string>();
+        version.flags = json.at("flags").get<std::vector<std::string>>();
+        return version;
+    }
+
+    void collectDiagnostic(const llvm::SMDiagnostic& diagnostic, void* context) {
+        *static_cast<std::string*>(context) += diagnostic.getMessage().str();
+    }
+
+}
+
+void armor::ReproBundle::save(const std::string& dir) const {
+    std::filesystem::path root(dir);
+    OverlayDirectory overlay;
+    for (const std::string& file : files) {
+        std::string copy = copyPathOf(file);
+        std::error_code ec;
+        std::filesystem::create_directories((root / copy).parent_path(), ec);
+        if (ec || !std::filesystem::copy_file(file, root / copy, std::filesystem::copy_options::overwrite_existing, ec)) {
+            throw std::runtime_error("Failed to copy " + file + " into bundle " + dir +
+                                     (ec ? ": " + ec.message() : std::string()));
+        }
+        std::filesystem::path path(file);
+        OverlayDirectory* directory = &overlay.directories[path.root_path().generic_string()];
+        for (const auto& component : path.relative_path().parent_path()) {
+            directory = &directory->directories[component.string()];
+        }
+        directory->files[path.filename().string()] = copy;
+    }
+
+    // Paths keep their original names, so diagnostics and reports read as in the
+    // captured run; the overlay parser wants the version as a string
+    nlohmann::json overlayJson{{"version", "0"},
+                               {"overlay-relative", true},
+                               {"use-external-names", false},
+                               {"roots", overlay.contents()}};
+    nlohmann::json pairsJson = nlohmann::json::array();
+    for (const HeaderPair& pair : pairs) {
+        pairsJson.push_back({{"header", pair.header},
+                             {"seconds", pair.seconds},
+                             {"older", versionToJson(pair.older)},
+                             {"newer", versionToJson(pair.newer)}});
+    }
+    nlohmann::json bundleJson{{"format", BUNDLE_FORMAT_VERSION},
+                              {"arguments", arguments},
+                              {"parse_mode", parseMode},
+                              {"skip_foreign_bodies", skipForeignBodies},
+                              {"pairs", std::move(pairsJson)},
+                              {"files", files}};
+    for (const auto& [name, json] : {std::make_pair(OVERLAY_FILE, &overlayJson),
+                                     std::make_pair(BUNDLE_FILE, &bundleJson)}) {
+        std::ofstream out(root / name, std::ios::trunc);
+        out << json->dump(2) << "\n";
+        if (!out) {
+            throw std::runtime_error("Failed to write " + (root / name).string());
+        }
+    }
+}
+
+armor::ReproBundle armor::ReproBundle::load(const std::string& dir) {
+    std::string path = (std::filesystem::path(dir) / BUNDLE_FILE).string();
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open repro bundle: " + path);
+    }
+    ReproBundle bundle;
+    try {
+        nlohmann::json root = nlohmann::json::parse(file);
+        if (root.at("format").get<int>() != BUNDLE_FORMAT_VERSION) {
+            throw std::runtime_error("unsupported format " + root.at("format").dump());
+        }
+        bundle.arguments = root.at("arguments").get<std::vector<std::string>>();
+        bundle.parseMode = root.at("parse_mode").get<std::string>();
+        bundle.skipForeignBodies = root.at("skip_foreign_bodies").get<bool>();
+        for (const nlohmann::json& pairJson : root.at("pairs")) {
+            HeaderPair pair;
+            pair.header = pairJson.at("header").get<std::string>();
+            pair.seconds = pairJson.at("seconds").get<double>();
+            pair.older = versionFromJson(pairJson.at("older"));
+            pair.newer = versionFromJson(pairJson.at("newer"));
+            bundle.pairs.push_back(std::move(pair));
+        }
+        bundle.files = root.at("files").get<std::vector<std::string>>();
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Malformed repro bundle " + path + ": " + e.what());
+    }
+    return bundle;
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> armor::ReproBundle::createFileSystem(const std::string& dir) {
+    std::string path = std::filesystem::absolute(std::filesystem::path(dir) / OVERLAY_FILE).string();
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        throw std::runtime_error("Failed to read " + path + ": " + buffer.getError().message());
+    }
+    std::string errors;
+    // Its own working directory, so tools moving it leave the process alone
+    std::unique_ptr<llvm::vfs::FileSystem> fileSystem = llvm::vfs::getVFSFromYAML(
+        std::move(*buffer), collectDiagnostic, path, &errors,
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(llvm::vfs::createPhysicalFileSystem().release()));
+    if (!fileSystem) {
+        throw std::runtime_error("Malformed overlay " + path + ": " + errors);
+    }
+    return llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(fileSystem.release());
+}
+
+class armor::BundleCapture::RecordingFileSystem : public llvm::vfs::ProxyFileSystem {
+    public:
+        RecordingFileSystem(BundleCapture& capture, llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying)
+            : ProxyFileSystem(std::move(underlying)), capture(capture) {}
+
+        // Files only probed, as by __has_include, have to answer the same on replay
+        llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override {
+            llvm::ErrorOr<llvm::vfs::Status> result = ProxyFileSystem::status(path);
+            if (result && result->isRegularFile()) {
+                record(path);
+            }
+            return result;
+        }
+
+        llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override {
+            auto file = ProxyFileSystem::openFileForRead(path);
+            if (file) {
+                record(path);
+            }
+            return file;
+        }
+
+    private:
+        void record(const llvm::Twine& path) {
+            llvm::SmallString<256> absolute;
+            path.toVector(absolute);
+            if (makeAbsolute(absolute)) {
+                return;
+            }
+            llvm::sys::path::remove_dots(absolute, /*remove_dot_dot=*/true);
+            capture.recordRead(absolute.str().str());
+        }
+
+        BundleCapture& capture;
+};
+
+armor::BundleCapture& armor::BundleCapture::getInstance() {
+    static BundleCapture instance;
+    return instance;
+}
+
+void armor::BundleCapture::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    capturing = true;
+    pairs.clear();
+    files.clear();
+}
+
+armor::ReproBundle armor::BundleCapture::finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    capturing = false;
+    ReproBundle bundle;
+    bundle.pairs = std::move(pairs);
+    bundle.files.assign(files.begin(), files.end());
+    pairs.clear();
+    files.clear();
+    return bundle;
+}
+
+bool armor::BundleCapture::isCapturing() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capturing;
+}
+
+void armor::BundleCapture::recordPair(ReproBundle::HeaderPair pair) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capturing) {
+        pairs.push_back(std::move(pair));
+    }
+}
+
+void armor::BundleCapture::recordSeconds(const std::string& header, double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (ReproBundle::HeaderPair& pair : pairs) {
+        if (pair.header == header) {
+            pair.seconds = seconds;
+        }
+    }
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> armor::BundleCapture::wrap(
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> underlying) {
+    return llvm::makeIntrusiveRefCnt<RecordingFileSystem>(*this, std::move(underlying));
+}
+
+void armor::BundleCapture::recordRead(std::string path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capturing) {
+        files.insert(std::move(path));
+    }
+}
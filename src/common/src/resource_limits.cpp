@@ -0,0 +1,159 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include <sched.h>
+#include <unistd.h>
+
+#include "memory_usage.hpp"
+#include "resource_limits.hpp"
+
+namespace {
+
+    // The first line of `path`, empty where it cannot be read
+    std::string readLine(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    // The cgroup v2 directory of this process, from its "0::<path>" line in /proc/self/cgroup
+    std::string cgroupV2Directory() {
+        std::ifstream in("/proc/self/cgroup");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, 3, "0::") == 0) {
+                return "/sys/fs/cgroup" + (line.size() > 4 ? line.substr(3) : std::string());
+            }
+        }
+        return "/sys/fs/cgroup";
+    }
+
+    // The first readable line of `file` in this process's cgroup v2 directory or the root of its namespace
+    std::string readCgroupV2(const char* file) {
+        std::string line = readLine(cgroupV2Directory() + "/" + file);
+        return line.empty() ? readLine(std::string("/sys/fs/cgroup/") + file) : line;
+    }
+
+    unsigned affinityCpus() {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+            return 0;
+        }
+        return static_cast<unsigned>(CPU_COUNT(&set));
+    }
+
+    unsigned quotaCpus() {
+        std::string cpuMax = readCgroupV2("cpu.max");
+        if (!cpuMax.empty()) {
+            return armor::detail::cpusFromCpuMax(cpuMax);
+        }
+        for (const char* dir : {"/sys/fs/cgroup/cpu,cpuacct/", "/sys/fs/cgroup/cpu/"}) {
+            std::string quota = readLine(std::string(dir) + "cpu.cfs_quota_us");
+            std::string period = readLine(std::string(dir) + "cpu.cfs_period_us");
+            if (!quota.empty() && !period.empty()) {
+                try {
+                    return armor::detail::cpusFromCfsQuota(std::stoll(quota), std::stoll(period));
+                } catch (const std::exception&) {
+                    return 0;
+                }
+            }
+        }
+        return 0;
+    }
+
+    std::size_t physicalMemory() {
+        long pages = sysconf(_SC_PHYS_PAGES);
+        long pageSize = sysconf(_SC_PAGESIZE);
+        return pages > 0 && pageSize > 0 ? static_cast<std::size_t>(pages) * static_cast<std::size_t>(pageSize) : 0;
+    }
+
+}
+
+unsigned armor::detail::cpusFromCpuMax(const std::string& text) {
+    std::istringstream in(text);
+    std::string quota;
+    long long period = 0;
+    if (!(in >> quota >> period) || quota == "max") {
+        return 0;
+    }
+    try {
+        return cpusFromCfsQuota(std::stoll(quota), period);
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+unsigned armor::detail::cpusFromCfsQuota(long long quota, long long period) {
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return static_cast<unsigned>((quota + period - 1) / period);
+}
+
+std::size_t armor::detail::bytesFromMemoryLimit(const std::string& text) {
+    if (text.empty() || text == "max") {
+        return 0;
+    }
+    try {
+        unsigned long long bytes = std::stoull(text);
+        return static_cast<std::size_t>(bytes);
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+unsigned armor::availableCpus() {
+    unsigned cpus = std::thread::hardware_concurrency();
+    for (unsigned limit : {affinityCpus(), quotaCpus()}) {
+        if (limit != 0 && (cpus == 0 || limit < cpus)) {
+            cpus = limit;
+        }
+    }
+    return std::max(cpus, 1u);
+}
+
+std::size_t armor::cgroupMemoryLimit() {
+    std::string text = readCgroupV2("memory.max");
+    if (text.empty()) {
+        text = readLine("/sys/fs/cgroup/memory/memory.limit_in_bytes");
+    }
+    std::size_t limit = detail::bytesFromMemoryLimit(text);
+    // cgroup v1 spells "no limit" as the largest page-aligned value
+    std::size_t physical = physicalMemory();
+    return physical != 0 && limit >= physical ? 0 : limit;
+}
+
+armor::MemoryGate::MemoryGate(std::size_t limitBytes, std::function<std::size_t()> resident)
+    : threshold(static_cast<std::size_t>(static_cast<double>(limitBytes) * HIGH_WATER)),
+      resident(resident ? std::move(resident) : std::function<std::size_t()>(residentBytes)) {}
+
+void armor::MemoryGate::enter() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (threshold != 0 && active > 0 && resident() > threshold) {
+        ++throttled;
+        do {
+            released.wait_for(lock, RECHECK_INTERVAL);
+        } while (active > 0 && resident() > threshold);
+    }
+    ++active;
+}
+
+void armor::MemoryGate::leave() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        --active;
+    }
+    released.notify_one();
+}
+
+unsigned armor::MemoryGate::getThrottled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return throttled;
+}
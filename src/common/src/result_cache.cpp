@@ -0,0 +1,70 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+#include "cache_directory.hpp"
+#include "logger.hpp"
+#include "result_cache.hpp"
+
+armor::ResultCache::ResultCache(const std::string& cacheDir) {
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(path, "results");
+    resultDir = path.str().str();
+}
+
+std::string armor::ResultCache::entryPath(const std::string& key) const {
+    llvm::SmallString<256> path(resultDir);
+    llvm::sys::path::append(path, key + ".json");
+    return path.str().str();
+}
+
+bool armor::ResultCache::load(const std::string& key, HistoryEntry& entry) const {
+    std::string path = entryPath(key);
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        return false;
+    }
+    llvm::StringRef payload;
+    if (!unsealCacheEntry((*buffer)->getBuffer(), payload)) {
+        ARMOR_DEBUG_LOG << "Removing corrupt result cache entry " << path << "\n";
+        llvm::sys::fs::remove(path);
+        return false;
+    }
+    try {
+        nlohmann::json stored = nlohmann::json::parse(payload.begin(), payload.end());
+        HistoryEntry loaded = HistoryEntry::fromJson(stored);
+        if (loaded.digest != key) {
+            return false;
+        }
+        entry = std::move(loaded);
+    } catch (const std::exception& e) {
+        ARMOR_DEBUG_LOG << "Ignoring unreadable result cache entry " << path << " : " << e.what() << "\n";
+        return false;
+    }
+    touchCacheFile(path);
+    return true;
+}
+
+void armor::ResultCache::store(const std::string& key, const HistoryEntry& entry) const {
+    if (std::error_code ec = llvm::sys::fs::create_directories(resultDir)) {
+        ARMOR_DEBUG_LOG << "Cannot create result cache directory " << resultDir << " : " << ec.message() << "\n";
+        return;
+    }
+    HistoryEntry keyed = entry;
+    keyed.digest = key;
+    // Published atomically, as processes may share the cache directory
+    std::string error;
+    if (!publishCacheFile(entryPath(key), sealCacheEntry(keyed.toJson().dump()), error)) {
+        ARMOR_DEBUG_LOG << "Cannot store the result of " << entry.header << " : " << error << "\n";
+    }
+}
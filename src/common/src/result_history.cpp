@@ -0,0 +1,149 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "logger.hpp"
+#include "result_history.hpp"
+
+namespace {
+
+    constexpr int HISTORY_FORMAT_VERSION = 1;
+
+    // Whether the file at `path` is non-empty and does not end with a newline
+    bool endsInPartialLine(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file || !file.seekg(-1, std::ios::end)) {
+            return false;
+        }
+        char last = '\n';
+        file.get(last);
+        return file && last != '\n';
+    }
+
+}
+
+nlohmann::json armor::HistoryEntry::toJson() const {
+    nlohmann::json rows = nlohmann::json::array();
+    for (const ChangeRecord& record : records) {
+        nlohmann::json row = record.toJson();
+        // Always the entry's header
+        row.erase("headerfile");
+        rows.push_back(std::move(row));
+    }
+    return nlohmann::json{{"format", HISTORY_FORMAT_VERSION},
+                          {"header", header},
+                          {"digest", digest},
+                          {"base", base},
+                          {"head", head},
+                          {"time", time},
+                          {"seconds", seconds},
+                          {"overall_status", overallStatus},
+                          {"parsed_status", parsedStatus},
+                          {"unparsed_status", unparsedStatus},
+                          {"parser", static_cast<int>(parser)},
+                          {"records", std::move(rows)}};
+}
+
+armor::HistoryEntry armor::HistoryEntry::fromJson(const nlohmann::json& entry) {
+    HistoryEntry result;
+    result.header = entry.at("header").get<std::string>();
+    result.digest = entry.at("digest").get<std::string>();
+    result.base = entry.at("base").get<std::string>();
+    result.head = entry.at("head").get<std::string>();
+    result.time = entry.at("time").get<int64_t>();
+    result.seconds = entry.at("seconds").get<double>();
+    result.overallStatus = entry.at("overall_status").get<std::string>();
+    result.parsedStatus = entry.at("parsed_status").get<int>();
+    result.unparsedStatus = entry.at("unparsed_status").get<int>();
+    result.parser = static_cast<PARSER>(entry.at("parser").get<int>());
+    for (const auto& row : entry.at("records")) {
+        ChangeRecord record = ChangeRecord::fromJson(row);
+        record.headerfile = result.header;
+        result.records.push_back(std::move(record));
+    }
+    return result;
+}
+
+armor::ResultHistory armor::ResultHistory::load(const std::string& path) {
+    ResultHistory history;
+    if (!llvm::sys::fs::exists(path)) {
+        return history;
+    }
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open history file: " + path);
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            nlohmann::json entry = nlohmann::json::parse(line);
+            if (entry.at("format").get<int>() != HISTORY_FORMAT_VERSION) {
+                throw std::runtime_error("unsupported format " + entry.at("format").dump());
+            }
+            history.entries.push_back(HistoryEntry::fromJson(entry));
+        } catch (const std::exception& e) {
+            ARMOR_DEBUG_LOG << "Skipping unreadable line of history file " << path << " : " << e.what() << "\n";
+            ++history.skippedLines;
+            continue;
+        }
+        const HistoryEntry& added = history.entries.back();
+        history.latest[{added.header, added.digest}] = history.entries.size() - 1;
+    }
+    if (file.bad()) {
+        throw std::runtime_error("Failed to read history file: " + path);
+    }
+    return history;
+}
+
+void armor::ResultHistory::append(const std::string& path, const std::vector<HistoryEntry>& entries) {
+    if (entries.empty()) {
+        return;
+    }
+    std::string lines;
+    // An interrupted append leaves a line without its newline, which must not take in the first new entry
+    if (endsInPartialLine(path)) {
+        lines += '\n';
+    }
+    for (const HistoryEntry& entry : entries) {
+        lines += entry.toJson().dump();
+        lines += '\n';
+    }
+
+    llvm::StringRef dir = llvm::sys::path::parent_path(path);
+    if (!dir.empty()) {
+        if (std::error_code ec = llvm::sys::fs::create_directories(dir)) {
+            throw std::runtime_error("Failed to create directory of history file " + path + ": " + ec.message());
+        }
+    }
+    std::error_code ec;
+    llvm::raw_fd_ostream out(path, ec, llvm::sys::fs::OF_Append);
+    if (ec) {
+        throw std::runtime_error("Failed to open history file " + path + ": " + ec.message());
+    }
+    // One write, so the lines of concurrent runs never interleave
+    out.write(lines.data(), lines.size());
+    out.close();
+    if (out.has_error()) {
+        std::string message = out.error().message();
+        out.clear_error();
+        throw std::runtime_error("Failed to write history file " + path + ": " + message);
+    }
+}
+
+const armor::HistoryEntry* armor::ResultHistory::find(const std::string& header, const std::string& digest) const {
+    auto it = latest.find({header, digest});
+    return it == latest.end() ? nullptr : &entries[it->second];
+}
@@ -0,0 +1,43 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstring>
+#include <mutex>
+
+#include "sharded_string_cache.hpp"
+
+armor::ShardedStringCache::Shard& armor::ShardedStringCache::shardOf(const void* key) const {
+    // AST nodes are at least 8-byte aligned; the bits above pick the shard
+    uintptr_t address = reinterpret_cast<uintptr_t>(key);
+    return shards[((address >> 4) ^ (address >> 12)) % SHARD_COUNT];
+}
+
+std::optional<llvm::StringRef> armor::ShardedStringCache::find(const void* key, unsigned table) const {
+    Shard& shard = shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.strings.find({key, table});
+    if (it == shard.strings.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+llvm::StringRef armor::ShardedStringCache::insert(const void* key, unsigned table, llvm::StringRef value) {
+    Shard& shard = shardOf(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto inserted = shard.strings.try_emplace({key, table});
+    if (inserted.second) {
+        char* copy = shard.storage.Allocate<char>(value.size());
+        std::memcpy(copy, value.data(), value.size());
+        inserted.first->second = llvm::StringRef(copy, value.size());
+    }
+    return inserted.first->second;
+}
+
+std::size_t armor::ShardedStringCache::size() const {
+    std::size_t total = 0;
+    for (const Shard& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.strings.size();
+    }
+    return total;
+}
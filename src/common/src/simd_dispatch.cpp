@@ -0,0 +1,80 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <atomic>
+
+#include "simd_dispatch.hpp"
+
+namespace {
+
+    armor::simd::Kernel detectKernel() {
+#if defined(__AVX2__)
+        return armor::simd::Kernel::AVX2;
+#elif defined(ARMOR_SIMD_X86)
+        // Callable before static constructors have run
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return armor::simd::Kernel::AVX2;
+        }
+#if defined(__SSE2__)
+        return armor::simd::Kernel::SSE2;
+#else
+        return armor::simd::Kernel::SCALAR;
+#endif
+#elif defined(__ARM_NEON)
+        return armor::simd::Kernel::NEON;
+#else
+        return armor::simd::Kernel::SCALAR;
+#endif
+    }
+
+    std::atomic<armor::simd::Kernel>& activeKernelSlot() {
+        static std::atomic<armor::simd::Kernel> sKernel{armor::simd::detectedKernel()};
+        return sKernel;
+    }
+
+}
+
+armor::simd::Kernel armor::simd::detectedKernel() {
+    static const Kernel sKernel = detectKernel();
+    return sKernel;
+}
+
+armor::simd::Kernel armor::simd::activeKernel() {
+    return activeKernelSlot().load(std::memory_order_relaxed);
+}
+
+bool armor::simd::supportsKernel(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return true;
+        case Kernel::SSE2:
+#if defined(__SSE2__)
+            return true;
+#else
+            return false;
+#endif
+        case Kernel::AVX2:
+            return detectedKernel() == Kernel::AVX2;
+        case Kernel::NEON:
+            return detectedKernel() == Kernel::NEON;
+    }
+    return false;
+}
+
+bool armor::simd::setKernel(Kernel kernel) {
+    if (!supportsKernel(kernel)) {
+        return false;
+    }
+    activeKernelSlot().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+const char* armor::simd::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR: return "scalar";
+        case Kernel::SSE2:   return "sse2";
+        case Kernel::AVX2:   return "avx2";
+        case Kernel::NEON:   return "neon";
+    }
+    return "scalar";
+}
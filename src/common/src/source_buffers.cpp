@@ -0,0 +1,53 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include "source_buffers.hpp"
+
+armor::SourceBuffers::SourceBuffers(const std::string& projectRoot)
+    : projectRoot(std::filesystem::absolute(projectRoot).lexically_normal().string()) {
+    // "root/" and "root" name the same directory
+    if (this->projectRoot.size() > 1 && this->projectRoot.back() == '/') {
+        this->projectRoot.pop_back();
+    }
+}
+
+std::string armor::SourceBuffers::absolutePath(const std::string& path) const {
+    std::filesystem::path resolved(path);
+    if (resolved.is_relative()) {
+        resolved = std::filesystem::path(projectRoot) / resolved;
+    }
+    return resolved.lexically_normal().string();
+}
+
+void armor::SourceBuffers::add(const std::string& path, std::string contents) {
+    std::string absolute = absolutePath(path);
+    if (!covers(absolute)) {
+        throw std::invalid_argument("Buffer " + path + " is outside the project root " + projectRoot);
+    }
+    buffers[absolute] = std::move(contents);
+}
+
+const std::string* armor::SourceBuffers::find(const std::string& path) const {
+    auto it = buffers.find(absolutePath(path));
+    return it == buffers.end() ? nullptr : &it->second;
+}
+
+bool armor::SourceBuffers::covers(const std::string& path) const {
+    std::string absolute = absolutePath(path);
+    return absolute.size() > projectRoot.size() && absolute.compare(0, projectRoot.size(), projectRoot) == 0 &&
+           (absolute[projectRoot.size()] == '/' || projectRoot == "/");
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> armor::SourceBuffers::createFileSystem() const {
+    auto fileSystem = llvm::makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+    for (const auto& [path, contents] : buffers) {
+        fileSystem->addFile(path, 0, llvm::MemoryBuffer::getMemBuffer(contents, path, false));
+    }
+    return fileSystem;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include "source_hash_index.hpp"
+#include "fibonacci_hash.hpp"
+#include "profiler.hpp"
+
+namespace {
+
+    constexpr uint64_t MODULUS = (uint64_t(1) << 61) - 1;
+    constexpr uint64_t BASE = 0x1c5a3f9b2d47e61ULL % MODULUS;
+    constexpr uint64_t GOLDEN_RATIO_64 = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t mulMod(uint64_t a, uint64_t b) {
+        __uint128_t product = static_cast<__uint128_t>(a) * b;
+        uint64_t folded = static_cast<uint64_t>(product & MODULUS) + static_cast<uint64_t>(product >> 61);
+        return folded >= MODULUS ? folded - MODULUS : folded;
+    }
+
+    // Bytes enter as byte + 1 so a leading NUL still changes the hash
+    uint64_t append(uint64_t hash, uint8_t byte) {
+        uint64_t next = mulMod(hash, BASE) + byte + 1;
+        return next >= MODULUS ? next - MODULUS : next;
+    }
+
+    // Spreads the residue over all 64 bits (splitmix64 finalizer)
+    uint64_t finalize(uint64_t residue, uint64_t length) {
+        uint64_t h = residue ^ (length * GOLDEN_RATIO_64);
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+}
+
+SourceHashIndex::SourceHashIndex(llvm::StringRef buffer) : buffer(buffer) {
+    powers.push_back(1);
+}
+
+llvm::StringRef SourceHashIndex::getBuffer() const {
+    return buffer;
+}
+
+uint64_t SourceHashIndex::hash(unsigned startOffset, unsigned endOffset, Normalization normalization) {
+    if (startOffset >= endOffset || endOffset > buffer.size()) {
+        return 0;
+    }
+    armor::profile::count(armor::profile::Counter::HASHES_COMPUTED);
+
+    const PrefixTable& table = getTable(normalization);
+    uint32_t first = table.keptBefore[startOffset];
+    uint32_t last = table.keptBefore[endOffset];
+    uint32_t length = last - first;
+
+    uint64_t shifted = mulMod(table.prefix[first], powers[length]);
+    uint64_t residue = table.prefix[last] >= shifted ? table.prefix[last] - shifted
+                                                     : table.prefix[last] + MODULUS - shifted;
+    return finalize(residue, length);
+}
+
+const SourceHashIndex::PrefixTable& SourceHashIndex::getTable(Normalization normalization) {
+    PrefixTable& table = normalization == Normalization::Source ? source : whitespace;
+    if (!table.built) {
+        build(table, normalization);
+    }
+    return table;
+}
+
+void SourceHashIndex::build(PrefixTable& table, Normalization normalization) {
+    armor::profile::PhaseTimer timer(armor::profile::Phase::HASH_INDEX);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+    const size_t size = buffer.size();
+
+    table.keptBefore.assign(size + 1, 0);
+    table.prefix.clear();
+    table.prefix.reserve(size + 1);
+    table.prefix.push_back(0);
+
+    // Raw offsets below `next` already have their keptBefore entry
+    size_t next = 0;
+    auto onRun = [&](size_t offset, size_t length) {
+        uint32_t kept = static_cast<uint32_t>(table.prefix.size() - 1);
+        for (; next < offset; ++next) {
+            table.keptBefore[next] = kept;
+        }
+        for (size_t i = offset; i < offset + length; ++i) {
+            table.keptBefore[i] = kept++;
+            table.prefix.push_back(append(table.prefix.back(), data[i]));
+        }
+        next = offset + length;
+    };
+
+    if (normalization == Normalization::Source) {
+        FibonacciHash::forEachNormalizedRun(buffer, 0, static_cast<unsigned>(size), onRun);
+    }
+    else {
+        FibonacciHash::forEachNonWhitespaceRun(buffer, onRun);
+    }
+
+    uint32_t kept = static_cast<uint32_t>(table.prefix.size() - 1);
+    for (; next <= size; ++next) {
+        table.keptBefore[next] = kept;
+    }
+
+    while (powers.size() < table.prefix.size()) {
+        powers.push_back(mulMod(powers.back(), BASE));
+    }
+    table.built = true;
+}
@@ -0,0 +1,194 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Demangle/Demangle.h"
+#include "llvm/Support/Path.h"
+
+#include "profiler.hpp"
+#include "stack_sampler.hpp"
+
+namespace {
+
+    constexpr int MAX_FRAMES = 64;
+    // The handler and the signal trampoline that called it
+    constexpr int SKIPPED_FRAMES = 2;
+
+    struct Sample {
+        void* frames[MAX_FRAMES];
+        int depth;
+        const armor::profile::HeaderProfile* profile;
+        armor::profile::Phase phase;
+        // Set last, as another thread's handler may still be writing once sampling stops
+        std::atomic<bool> complete;
+    };
+
+    // Set before the timer is armed, read by the handler
+    std::unique_ptr<Sample[]> samples;
+    std::size_t capacity = 0;
+    std::atomic<std::size_t> taken{0};
+    struct sigaction previousAction;
+
+    // Only async-signal-safe work: backtrace() was called once before the timer was armed
+    void onProfSignal(int) {
+        int savedErrno = errno;
+        std::size_t index = taken.fetch_add(1, std::memory_order_relaxed);
+        if (index < capacity) {
+            Sample& sample = samples[index];
+            sample.depth = backtrace(sample.frames, MAX_FRAMES);
+            sample.profile = armor::profile::detail::currentProfile;
+            sample.phase = armor::profile::detail::currentPhase;
+            sample.complete.store(true, std::memory_order_release);
+        }
+        errno = savedErrno;
+    }
+
+    // Folded stacks separate frames with ';'
+    std::string withoutSemicolons(std::string name) {
+        std::replace(name.begin(), name.end(), ';', ':');
+        return name;
+    }
+
+    std::string frameName(const void* address) {
+        Dl_info info{};
+        if (!dladdr(address, &info) || !info.dli_fname) {
+            return "0x" + llvm::utohexstr(reinterpret_cast<uintptr_t>(address));
+        }
+        if (info.dli_sname) {
+            return withoutSemicolons(llvm::demangle(info.dli_sname));
+        }
+        uintptr_t offset = reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+        return (llvm::sys::path::filename(info.dli_fname) + "+0x" + llvm::utohexstr(offset)).str();
+    }
+
+}
+
+armor::profile::StackSampler::~StackSampler() {
+    stop();
+}
+
+bool armor::profile::StackSampler::start(unsigned hertz, std::size_t sampleCapacity) {
+    if (running) {
+        error = "already sampling";
+        return false;
+    }
+    if (hertz == 0 || sampleCapacity == 0) {
+        error = "no samples to take";
+        return false;
+    }
+    samples.reset(new Sample[sampleCapacity]());
+    capacity = sampleCapacity;
+    taken.store(0, std::memory_order_relaxed);
+    // The first call loads the unwinder, which a signal handler must not do
+    void* warmup[1];
+    backtrace(warmup, 1);
+
+    struct sigaction action{};
+    action.sa_handler = onProfSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(SIGPROF, &action, &previousAction) != 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    // ITIMER_PROF counts the CPU time of all threads of the process
+    long micros = std::max(1L, 1000000L / static_cast<long>(hertz));
+    itimerval interval{};
+    interval.it_interval.tv_sec = micros / 1000000;
+    interval.it_interval.tv_usec = micros % 1000000;
+    interval.it_value = interval.it_interval;
+    if (setitimer(ITIMER_PROF, &interval, nullptr) != 0) {
+        error = std::strerror(errno);
+        sigaction(SIGPROF, &previousAction, nullptr);
+        return false;
+    }
+    error.clear();
+    running = true;
+    return true;
+}
+
+void armor::profile::StackSampler::stop() {
+    if (!running) {
+        return;
+    }
+    itimerval off{};
+    setitimer(ITIMER_PROF, &off, nullptr);
+    // Ignoring the signal discards one still pending, which the previous action may not expect
+    signal(SIGPROF, SIG_IGN);
+    sigaction(SIGPROF, &previousAction, nullptr);
+    running = false;
+}
+
+std::size_t armor::profile::StackSampler::getSampleCount() const {
+    return std::min(taken.load(std::memory_order_relaxed), capacity);
+}
+
+std::size_t armor::profile::StackSampler::getDroppedCount() const {
+    std::size_t all = taken.load(std::memory_order_relaxed);
+    return all > capacity ? all - capacity : 0;
+}
+
+std::vector<std::string> armor::profile::StackSampler::foldedStacks() const {
+    std::map<std::string, uint64_t> stacks;
+    std::unordered_map<const void*, std::string> names;
+    std::size_t count = getSampleCount();
+    for (std::size_t i = 0; i < count; ++i) {
+        const Sample& sample = samples[i];
+        if (!sample.complete.load(std::memory_order_acquire) || sample.depth <= SKIPPED_FRAMES) {
+            continue;
+        }
+        std::string stack = sample.profile ? withoutSemicolons(sample.profile->getHeader()) : "(no header)";
+        stack += ';';
+        stack += sample.phase == Phase::COUNT ? "(no phase)" : phaseName(sample.phase).str();
+        for (int frame = sample.depth - 1; frame >= SKIPPED_FRAMES; --frame) {
+            // Return addresses point past their call, which may be the start of the next function
+            const char* address = static_cast<const char*>(sample.frames[frame]);
+            if (frame > SKIPPED_FRAMES) {
+                --address;
+            }
+            auto named = names.try_emplace(address);
+            if (named.second) {
+                named.first->second = frameName(address);
+            }
+            stack += ';';
+            stack += named.first->second;
+        }
+        ++stacks[stack];
+    }
+
+    std::vector<std::string> lines;
+    lines.reserve(stacks.size());
+    for (const auto& entry : stacks) {
+        lines.push_back(entry.first + " " + std::to_string(entry.second));
+    }
+    return lines;
+}
+
+bool armor::profile::StackSampler::writeFolded(const std::string& path) const {
+    std::ofstream out(path);
+    for (const std::string& line : foldedStacks()) {
+        out << line << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+void armor::profile::StackSampler::reset() {
+    stop();
+    samples.reset();
+    capacity = 0;
+    taken.store(0, std::memory_order_relaxed);
+}
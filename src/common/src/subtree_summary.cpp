@@ -0,0 +1,31 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <atomic>
+
+#include "diff_utils.hpp"
+#include "subtree_summary.hpp"
+
+namespace {
+
+    std::atomic<bool> subtreeExpansionEnabled{false};
+
+}
+
+nlohmann::json SubtreeSummary::toJson() const {
+    nlohmann::json summary;
+    summary[DESCENDANTS] = descendants;
+    nlohmann::json& byKind = summary[KINDS] = nlohmann::json::object();
+    for (const auto& [kind, count] : kinds) {
+        byKind[serialize(kind)] = count;
+    }
+    summary[NAMES] = names;
+    return summary;
+}
+
+void setSubtreeExpansion(bool enabled) {
+    subtreeExpansionEnabled = enabled;
+}
+
+bool isSubtreeExpansionEnabled() {
+    return subtreeExpansionEnabled;
+}
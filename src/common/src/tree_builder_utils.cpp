@@ -6,10 +6,14 @@
 #include "nsr_generator.hpp"
 
 #include "clang/AST/Decl.h"
+#include "clang/AST/DeclTemplate.h"
 #include "clang/Lex/Lexer.h"
 #include <llvm-14/llvm/ADT/SmallString.h>
+#include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/Support/raw_ostream.h>
+#include "llvm/Support/xxhash.h"
 #include <string>
+#include <utility>
 #include "diff_utils.hpp"
 
 clang::QualType unwrapType(clang::QualType type) {
@@ -40,9 +44,10 @@ clang::QualType unwrapType(clang::QualType type) {
     return type;
 }
 
-std::pair<std::string, clang::TypeLoc> unwrapTypeLoc(clang::TypeLoc TL) {
+clang::TypeLoc unwrapTypeLoc(clang::TypeLoc TL, llvm::SmallVectorImpl<char> &Out) {
+    Out.clear();
     if (TL.isNull()) {
-        return {std::string{}, TL};
+        return TL;
     }
 
     llvm::SmallVector<const char*, 128> modifiers;
@@ -96,13 +101,18 @@ std::pair<std::string, clang::TypeLoc> unwrapTypeLoc(clang::TypeLoc TL) {
         }
     }
 
-    llvm::SmallString<32> resultBuffer;
     while (!modifiers.empty()) {
-        const char* mod = modifiers.pop_back_val();
-        resultBuffer.append(mod);
+        llvm::StringRef mod = modifiers.pop_back_val();
+        Out.append(mod.begin(), mod.end());
     }
 
-    return {std::string(resultBuffer.str()), TL};
+    return TL;
+}
+
+std::pair<std::string, clang::TypeLoc> unwrapTypeLoc(clang::TypeLoc TL) {
+    llvm::SmallString<32> modifiers;
+    TL = unwrapTypeLoc(TL, modifiers);
+    return {std::string(modifiers.str()), TL};
 }
 
 APINodeStorageClass getStorageClass(const clang::StorageClass storage) {
@@ -120,7 +130,7 @@ APINodeStorageClass getStorageClass(const clang::StorageClass storage) {
     }
 };
 
-const std::string generateUSRForDecl(const clang::NamedDecl * Decl){
+std::string generateUSRForDecl(const clang::NamedDecl * Decl){
     
     if (llvm::isa<clang::ParmVarDecl>(Decl)|| llvm::isa<clang::TemplateTypeParmDecl>(Decl) 
     || llvm::isa<clang::NonTypeTemplateParmDecl>(Decl) || llvm::isa<clang::TemplateTemplateParmDecl>(Decl)) {
@@ -131,11 +141,11 @@ const std::string generateUSRForDecl(const clang::NamedDecl * Decl){
     llvm::SmallString<256> Buf;
     armor::generateUSRForDecl(Decl, Buf);
 
-    return Buf.c_str();
+    return std::string(Buf.str());
 
 }
 
-const std::string generateNSRForDecl(const clang::NamedDecl * Decl){
+std::string generateNSRForDecl(const clang::NamedDecl * Decl){
 
     if (llvm::isa<clang::ParmVarDecl>(Decl)|| llvm::isa<clang::TemplateTypeParmDecl>(Decl) 
     || llvm::isa<clang::NonTypeTemplateParmDecl>(Decl) || llvm::isa<clang::TemplateTemplateParmDecl>(Decl)) {
@@ -146,63 +156,227 @@ const std::string generateNSRForDecl(const clang::NamedDecl * Decl){
     llvm::SmallString<256> Buf;
     armor::generateNSRForDecl(Decl, Buf);
 
-    return Buf.c_str();
+    return std::string(Buf.str());
 
 }
 
+void generateUSRAndNSRForDecl(const clang::NamedDecl * Decl, llvm::SmallVectorImpl<char> &USR, llvm::SmallVectorImpl<char> &NSR){
+
+    USR.clear();
+    NSR.clear();
+    if (llvm::isa<clang::ParmVarDecl>(Decl)|| llvm::isa<clang::TemplateTypeParmDecl>(Decl) 
+    || llvm::isa<clang::NonTypeTemplateParmDecl>(Decl) || llvm::isa<clang::TemplateTemplateParmDecl>(Decl)) {
+        armor::info() << "No USR or NSR for Param type declerations \n";
+        return;
+    }
+
+    armor::generateUSRAndNSRForDecl(Decl, USR, NSR);
+
+}
+
+
+namespace {
+
+    clang::PrintingPolicy getTypePrintingPolicy(const clang::ASTContext &Ctx, bool canonical) {
+        clang::PrintingPolicy Policy(Ctx.getLangOpts());
+        Policy.SuppressTagKeyword = false;
+        Policy.SuppressScope = false;
+        Policy.FullyQualifiedName = true;
+        Policy.AnonymousTagLocations = false;
+        Policy.PrintCanonicalTypes = canonical;
+        return Policy;
+    }
+
+    // Qualifiers of a builtin type or after a declarator, by hasConst() | hasVolatile() << 1
+    constexpr llvm::StringLiteral CV_QUALIFIERS[] = {"", "const", "volatile", "const volatile"};
+
+    // Index into CV_QUALIFIERS, or -1 for qualifiers the fast path leaves to the TypePrinter
+    int cvIndex(clang::Qualifiers Quals) {
+        if (Quals.hasRestrict() || Quals.hasUnaligned() || Quals.hasNonFastQualifiers()) {
+            return -1;
+        }
+        return (Quals.hasConst() ? 1 : 0) | (Quals.hasVolatile() ? 2 : 0);
+    }
+
+    /**
+     * Prints a builtin type reached through pointers and at most one
+     * outermost reference, with const and volatile qualifiers and no sugar
+     * at any level, as the TypePrinter would: "int", "const char *",
+     * "unsigned long *const *", "const double &". Most types of C APIs are
+     * such types, and the TypePrinter spends far longer on them than
+     * composing their strings takes. Both policies print them alike.
+     *
+     * @return false, leaving Out unspecified, for any other type.
+     */
+    bool printSimpleTypeInto(clang::QualType T, const clang::PrintingPolicy &Policy, llvm::SmallVectorImpl<char> &Out) {
+        // Declarators from the outermost in, each with the qualifiers after it
+        llvm::SmallVector<std::pair<llvm::StringRef, int>, 4> declarators;
+        while (true) {
+            clang::SplitQualType split = T.split();
+            int cv = cvIndex(split.Quals);
+            if (cv < 0) {
+                return false;
+            }
+            const clang::Type* type = split.Ty;
+            if (const auto* builtin = llvm::dyn_cast<clang::BuiltinType>(type)) {
+                Out.clear();
+                if (cv != 0) {
+                    Out.append(CV_QUALIFIERS[cv].begin(), CV_QUALIFIERS[cv].end());
+                    Out.push_back(' ');
+                }
+                llvm::StringRef name = builtin->getName(Policy);
+                Out.append(name.begin(), name.end());
+                break;
+            }
+            if (const auto* pointer = llvm::dyn_cast<clang::PointerType>(type)) {
+                declarators.push_back({"*", cv});
+                T = pointer->getPointeeType();
+            }
+            else if (const auto* reference = llvm::dyn_cast<clang::ReferenceType>(type)) {
+                // References are unqualified, and only the outermost declarator may be one
+                if (!declarators.empty() || cv != 0) {
+                    return false;
+                }
+                declarators.push_back({llvm::isa<clang::RValueReferenceType>(type) ? "&&" : "&", 0});
+                T = reference->getPointeeTypeAsWritten();
+            }
+            else {
+                return false;
+            }
+        }
+        for (auto it = declarators.rbegin(); it != declarators.rend(); ++it) {
+            // "int *", "int **", "int *const *"
+            if (Out.back() != '*') {
+                Out.push_back(' ');
+            }
+            Out.append(it->first.begin(), it->first.end());
+            if (it->second != 0) {
+                Out.append(CV_QUALIFIERS[it->second].begin(), CV_QUALIFIERS[it->second].end());
+            }
+        }
+        return true;
+    }
+
+    void printTypeInto(const clang::QualType T, const clang::PrintingPolicy &Policy, llvm::SmallVectorImpl<char> &Out,
+                       std::mutex *printerMutex = nullptr) {
+        if (printSimpleTypeInto(T, Policy, Out)) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock = printerMutex ? std::unique_lock<std::mutex>(*printerMutex)
+                                                         : std::unique_lock<std::mutex>();
+        Out.clear();
+        llvm::raw_svector_ostream OS(Out);
+        try {
+            T.print(OS, Policy);
+        }
+        catch (...) {
+            Out.clear();
+        }
+    }
+
+}
+
+void printTypeAsWritten(const clang::QualType T, const clang::ASTContext &Ctx, llvm::SmallVectorImpl<char> &Out,
+                        std::mutex *printerMutex) {
 
-const std::pair<const std::string,const std::string> getTypesWithAndWithoutTypeResolution(const clang::QualType T, const clang::ASTContext &Ctx) {
-    
     if (T.isNull()) {
-        return {std::string{}, std::string{}};
+        Out.clear();
+        return;
     }
-    
-    clang::PrintingPolicy Policy1(Ctx.getLangOpts());
-    Policy1.SuppressTagKeyword = false;
-    Policy1.SuppressScope = false;
-    Policy1.FullyQualifiedName = true;
-    Policy1.AnonymousTagLocations = false;
-    Policy1.PrintCanonicalTypes = false;
-    
-    std::string TypeStr;
-    llvm::raw_string_ostream OS(TypeStr);
-    
-    try {
-        T.print(OS, Policy1);
-    } 
-    catch (...) {
-        TypeStr = std::string{};
-    }
-
-    clang::PrintingPolicy Policy2(Ctx.getLangOpts());
-    Policy2.SuppressTagKeyword = false;
-    Policy2.SuppressScope = false;
-    Policy2.FullyQualifiedName = true;
-    Policy2.AnonymousTagLocations = false;
-    Policy2.PrintCanonicalTypes = false;
-    Policy2.PrintCanonicalTypes = true;
-
-    std::string CanonicalTypeStr;
-    llvm::raw_string_ostream COS(CanonicalTypeStr);
-
-    try {
-        T.getCanonicalType().print(COS, Policy2);
-    } 
-    catch (...) {
-        CanonicalTypeStr = std::string{};
+
+    printTypeInto(T, getTypePrintingPolicy(Ctx, false), Out, printerMutex);
+}
+
+void printCanonicalType(const clang::QualType T, const clang::ASTContext &Ctx, llvm::SmallVectorImpl<char> &Out,
+                        std::mutex *printerMutex) {
+
+    if (T.isNull()) {
+        Out.clear();
+        return;
     }
-    
-    return {TypeStr,CanonicalTypeStr};
-    
+
+    printTypeInto(T.getCanonicalType(), getTypePrintingPolicy(Ctx, true), Out, printerMutex);
 }
 
-const std::string generateHash( llvm::StringRef qualifiedName , const NodeKind& node ){
-    
-    llvm::SmallString<128> hashBuf;
-    llvm::raw_svector_ostream OS(hashBuf);
+std::string printTypeAsWritten(const clang::QualType T, const clang::ASTContext &Ctx) {
+    llvm::SmallString<128> Buf;
+    printTypeAsWritten(T, Ctx, Buf);
+    return std::string(Buf.str());
+}
 
-    OS << serialize(node) << ":" <<  qualifiedName;
-    
-    return hashBuf.c_str();
+std::string printCanonicalType(const clang::QualType T, const clang::ASTContext &Ctx) {
+    llvm::SmallString<128> Buf;
+    printCanonicalType(T, Ctx, Buf);
+    return std::string(Buf.str());
+}
+
+bool printsAsCanonical(const clang::QualType T) {
+
+    if (T.isNull() || !T.isCanonical()) {
+        return false;
+    }
+    // Qualifiers and declarators print alike under both policies; only what they apply to matters
+    const clang::Type* type = T.getTypePtr();
+    while (true) {
+        if (const auto* pointer = llvm::dyn_cast<clang::PointerType>(type)) {
+            type = pointer->getPointeeType().getTypePtr();
+        }
+        else if (const auto* reference = llvm::dyn_cast<clang::ReferenceType>(type)) {
+            type = reference->getPointeeType().getTypePtr();
+        }
+        else if (llvm::isa<clang::ConstantArrayType>(type) || llvm::isa<clang::IncompleteArrayType>(type)) {
+            type = llvm::cast<clang::ArrayType>(type)->getElementType().getTypePtr();
+        }
+        else {
+            break;
+        }
+    }
+    if (llvm::isa<clang::BuiltinType>(type)) {
+        return true;
+    }
+    const auto* tag = llvm::dyn_cast<clang::TagType>(type);
+    if (!tag) {
+        return false;
+    }
+    for (const clang::DeclContext* DC = tag->getDecl(); DC; DC = DC->getParent()) {
+        if (llvm::isa<clang::ClassTemplateSpecializationDecl>(DC)) {
+            return false;
+        }
+    }
+    return true;
+
+}
+
+std::pair<std::string, std::string> getTypesWithAndWithoutTypeResolution(const clang::QualType T, const clang::ASTContext &Ctx) {
+
+    std::pair<std::string, std::string> types;
+    if (T.isNull()) {
+        return types;
+    }
+    // One policy and buffer serve both prints; only the canonical flag differs
+    clang::PrintingPolicy Policy = getTypePrintingPolicy(Ctx, false);
+    llvm::SmallString<128> Buf;
+    printTypeInto(T, Policy, Buf);
+    types.first.assign(Buf.data(), Buf.size());
+    if (printsAsCanonical(T)) {
+        types.second = types.first;
+        return types;
+    }
+    Policy.PrintCanonicalTypes = true;
+    printTypeInto(T.getCanonicalType(), Policy, Buf);
+    types.second.assign(Buf.data(), Buf.size());
+    return types;
+
+}
+
+uint64_t generateHash( llvm::StringRef qualifiedName , const NodeKind& node ){
+
+    // The kind is folded in through a multiplicative mix, so nodes of one
+    // name but different kinds, e.g. a struct and its typedef, hash apart
+    uint64_t hash = llvm::xxHash64(qualifiedName) + (static_cast<uint64_t>(node) + 1) * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 31;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 29;
+    return hash;
 
 }
\ No newline at end of file
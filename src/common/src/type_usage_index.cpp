@@ -0,0 +1,80 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include "type_usage_index.hpp"
+
+namespace {
+
+    bool isNameChar(char c) {
+        return llvm::isAlnum(c) || c == '_' || c == ':';
+    }
+
+    // Names, qualified ones whole, and every other non-blank character on its own
+    void tokenize(llvm::StringRef type, llvm::SmallVectorImpl<llvm::StringRef>& tokens) {
+        size_t i = 0;
+        while (i < type.size()) {
+            char c = type[i];
+            if (llvm::isSpace(c)) {
+                ++i;
+                continue;
+            }
+            size_t end = i + 1;
+            if (isNameChar(c)) {
+                while (end < type.size() && isNameChar(type[end])) {
+                    ++end;
+                }
+            }
+            tokens.push_back(type.slice(i, end));
+            i = end;
+        }
+    }
+
+    bool isName(llvm::StringRef token) {
+        return !token.empty() && (llvm::isAlpha(token.front()) || token.front() == '_' || token.front() == ':');
+    }
+
+}
+
+void TypeUsageIndex::addUser(llvm::StringRef writtenType) {
+    llvm::SmallVector<llvm::StringRef, 8> tokens;
+    tokenize(writtenType, tokens);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        // Once per declaration, however often its type spells the name
+        if (isName(tokens[i]) && std::find(tokens.begin(), tokens.begin() + i, tokens[i]) == tokens.begin() + i) {
+            ++counts[tokens[i]];
+        }
+    }
+}
+
+uint32_t TypeUsageIndex::users(llvm::StringRef name) const {
+    auto it = counts.find(name);
+    return it == counts.end() ? 0 : it->second;
+}
+
+bool TypeUsageIndex::replacedName(llvm::StringRef oldType, llvm::StringRef newType, llvm::StringRef& oldName,
+                                  llvm::StringRef& newName) {
+    llvm::SmallVector<llvm::StringRef, 8> before;
+    llvm::SmallVector<llvm::StringRef, 8> after;
+    tokenize(oldType, before);
+    tokenize(newType, after);
+    size_t prefix = 0;
+    while (prefix < before.size() && prefix < after.size() && before[prefix] == after[prefix]) {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < before.size() - prefix && suffix < after.size() - prefix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) {
+        ++suffix;
+    }
+    if (before.size() - prefix - suffix != 1 || after.size() - prefix - suffix != 1 || !isName(before[prefix]) ||
+        !isName(after[prefix])) {
+        return false;
+    }
+    oldName = before[prefix];
+    newName = after[prefix];
+    return true;
+}
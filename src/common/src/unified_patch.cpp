@@ -0,0 +1,176 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+#include "llvm/ADT/SmallVector.h"
+
+#include "unified_patch.hpp"
+
+namespace {
+
+    // The path of a ---/+++ line: up to a tab before a timestamp, without its first component
+    std::string headerPath(llvm::StringRef line) {
+        llvm::StringRef path = line.drop_front(4).split('\t').first.rtrim();
+        if (path == "/dev/null") {
+            return "";
+        }
+        size_t slash = path.find('/');
+        return (slash == llvm::StringRef::npos ? path : path.drop_front(slash + 1)).str();
+    }
+
+    // "start[,count]" of a hunk header; the count defaults to 1
+    bool parseRange(llvm::StringRef range, size_t& start, size_t& count) {
+        llvm::StringRef startText;
+        llvm::StringRef countText;
+        std::tie(startText, countText) = range.split(',');
+        count = 1;
+        return !startText.getAsInteger(10, start) && (countText.empty() || !countText.getAsInteger(10, count));
+    }
+
+    armor::FilePatch::Hunk parseHunkHeader(llvm::StringRef line) {
+        // @@ -oldStart,oldCount +newStart,newCount @@ optional section heading
+        llvm::SmallVector<llvm::StringRef, 4> fields;
+        line.split(fields, ' ', 3, false);
+        armor::FilePatch::Hunk hunk;
+        if (fields.size() < 3 || !fields[1].consume_front("-") || !fields[2].consume_front("+") ||
+            !parseRange(fields[1], hunk.oldStart, hunk.oldCount) ||
+            !parseRange(fields[2], hunk.newStart, hunk.newCount) || (hunk.oldStart == 0 && hunk.oldCount > 0)) {
+            throw std::runtime_error("Malformed hunk header '" + line.str() + "'");
+        }
+        return hunk;
+    }
+
+    // Lines of `text` without their newlines; whether the last one had one
+    std::vector<llvm::StringRef> splitLines(llvm::StringRef text, bool& finalNewline) {
+        std::vector<llvm::StringRef> lines;
+        finalNewline = text.empty() || text.endswith("\n");
+        while (!text.empty()) {
+            llvm::StringRef line;
+            std::tie(line, text) = text.split('\n');
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+}
+
+std::vector<armor::FilePatch> armor::parseUnifiedDiff(llvm::StringRef text) {
+    std::vector<FilePatch> patches;
+    bool finalNewline;
+    std::vector<llvm::StringRef> lines = splitLines(text, finalNewline);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        llvm::StringRef line = lines[i].rtrim('\r');
+        if (line.startswith("--- ") && i + 1 < lines.size() && lines[i + 1].startswith("+++ ")) {
+            FilePatch patch;
+            patch.oldPath = headerPath(line);
+            patch.newPath = headerPath(lines[++i].rtrim('\r'));
+            patches.push_back(std::move(patch));
+            continue;
+        }
+        if (!line.startswith("@@ ")) {
+            continue;
+        }
+        if (patches.empty()) {
+            throw std::runtime_error("Hunk '" + line.str() + "' before any file header");
+        }
+
+        FilePatch::Hunk hunk = parseHunkHeader(line);
+        size_t oldLeft = hunk.oldCount;
+        size_t newLeft = hunk.newCount;
+        char last = ' ';
+        while (oldLeft > 0 || newLeft > 0 || (i + 1 < lines.size() && lines[i + 1].startswith("\\"))) {
+            if (++i == lines.size()) {
+                throw std::runtime_error("Hunk '" + line.str() + "' of " + patches.back().path() + " is cut short");
+            }
+            // Kept with a carriage return, which the lines of a CRLF file have too
+            llvm::StringRef body = lines[i];
+            char kind = body.empty() ? ' ' : body.front();
+            if (kind == '\\') {
+                hunk.oldMissingNewline |= last != '+';
+                hunk.newMissingNewline |= last != '-';
+                continue;
+            }
+            if ((kind == ' ' && (oldLeft == 0 || newLeft == 0)) || (kind == '-' && oldLeft == 0) ||
+                (kind == '+' && newLeft == 0) || (kind != ' ' && kind != '-' && kind != '+')) {
+                throw std::runtime_error("Hunk '" + line.str() + "' of " + patches.back().path() + " is cut short");
+            }
+            oldLeft -= kind != '+';
+            newLeft -= kind != '-';
+            hunk.lines.push_back(body.empty() ? std::string(" ") : body.str());
+            last = kind;
+        }
+        patches.back().hunks.push_back(std::move(hunk));
+    }
+    return patches;
+}
+
+std::string armor::applyFilePatch(llvm::StringRef original, const FilePatch& patch) {
+    bool finalNewline;
+    std::vector<llvm::StringRef> lines = splitLines(original, finalNewline);
+    std::vector<llvm::StringRef> patched;
+    size_t next = 0;
+    long offset = 0;
+    for (size_t h = 0; h < patch.hunks.size(); ++h) {
+        const FilePatch::Hunk& hunk = patch.hunks[h];
+        std::vector<llvm::StringRef> removed;
+        std::vector<llvm::StringRef> added;
+        for (const std::string& line : hunk.lines) {
+            llvm::StringRef text = llvm::StringRef(line).drop_front();
+            if (line.front() != '+') {
+                removed.push_back(text);
+            }
+            if (line.front() != '-') {
+                added.push_back(text);
+            }
+        }
+
+        // An empty old range starts after its line rather than at it
+        long expected = static_cast<long>(hunk.oldCount == 0 ? hunk.oldStart : hunk.oldStart - 1) + offset;
+        auto matchesAt = [&](long at) {
+            if (at < static_cast<long>(next) || static_cast<size_t>(at) + removed.size() > lines.size()) {
+                return false;
+            }
+            for (size_t k = 0; k < removed.size(); ++k) {
+                if (lines[at + k] != removed[k]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        long at = -1;
+        long farthest = static_cast<long>(lines.size()) + std::max(expected, 0L);
+        for (long distance = 0; distance <= farthest; ++distance) {
+            if (matchesAt(expected - distance)) {
+                at = expected - distance;
+                break;
+            }
+            if (matchesAt(expected + distance)) {
+                at = expected + distance;
+                break;
+            }
+        }
+        if (at < 0) {
+            throw std::runtime_error("Hunk " + std::to_string(h + 1) + " of " + patch.path() + " does not apply");
+        }
+
+        patched.insert(patched.end(), lines.begin() + next, lines.begin() + at);
+        patched.insert(patched.end(), added.begin(), added.end());
+        next = at + removed.size();
+        offset += at - expected;
+        if (next == lines.size()) {
+            finalNewline = !hunk.newMissingNewline;
+        }
+    }
+    patched.insert(patched.end(), lines.begin() + next, lines.end());
+
+    std::string result;
+    for (size_t i = 0; i < patched.size(); ++i) {
+        result += patched[i];
+        if (i + 1 < patched.size() || finalNewline) {
+            result += '\n';
+        }
+    }
+    return result;
+}
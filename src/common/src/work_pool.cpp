@@ -0,0 +1,137 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "logger.hpp"
+#include "resource_limits.hpp"
+#include "work_pool.hpp"
+
+unsigned armor::resolveJobCount(unsigned requested) {
+    return requested != 0 ? requested : availableCpus();
+}
+
+void armor::parallelFor(std::size_t count, unsigned jobs, const std::function<void(std::size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    if (jobs <= 1 || count == 1) {
+        std::exception_ptr firstError;
+        for (std::size_t i = 0; i < count; ++i) {
+            try {
+                task(i);
+            } catch (...) {
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+            }
+        }
+        if (firstError) {
+            std::rethrow_exception(firstError);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> cursor{0};
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        for (std::size_t i = cursor.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = cursor.fetch_add(1, std::memory_order_relaxed)) {
+            try {
+                task(i);
+            } catch (...) {
+                std::scoped_lock<std::mutex> lock(errorMutex);
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::size_t workerCount = std::min<std::size_t>(jobs, count);
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+    for (std::size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    // The calling thread participates as one of the workers
+    worker();
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+armor::WorkQueue::WorkQueue(unsigned threadCount, std::size_t capacity) : capacity(std::max<std::size_t>(capacity, 1)) {
+    threadCount = std::max(threadCount, 1u);
+    threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this] { run(); });
+    }
+}
+
+armor::WorkQueue::~WorkQueue() {
+    finish();
+}
+
+std::size_t armor::WorkQueue::finish() {
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAdded.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+    threads.clear();
+    std::scoped_lock<std::mutex> lock(mutex);
+    return std::exchange(failures, 0);
+}
+
+void armor::WorkQueue::submit(std::function<void()> job) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        slotFreed.wait(lock, [this] { return jobs.size() < capacity; });
+        jobs.push_back(std::move(job));
+    }
+    jobAdded.notify_one();
+}
+
+void armor::WorkQueue::run() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAdded.wait(lock, [this] { return stopping || !jobs.empty(); });
+            // Stopping only ends the thread once the queue is drained
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        slotFreed.notify_one();
+        try {
+            job();
+        } catch (const std::exception& e) {
+            armor::user_error() << "Queued job failed : " << e.what() << "\n";
+            std::scoped_lock<std::mutex> lock(mutex);
+            ++failures;
+        } catch (...) {
+            armor::user_error() << "Queued job failed\n";
+            std::scoped_lock<std::mutex> lock(mutex);
+            ++failures;
+        }
+    }
+}
@@ -0,0 +1,144 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "api_filter.hpp"
+#include "comparator.hpp"
+
+namespace py = pybind11;
+
+namespace {
+
+    // The JSON report row of `record`, see ChangeRecord::toJson
+    py::dict recordToDict(const ChangeRecord& record) {
+        py::dict row;
+        row["headerfile"] = record.headerfile;
+        row["name"] = record.name;
+        row["description"] = record.description;
+        row["changetype"] = record.compatibilityChanged ? "Compatibility_changed" : "Functionality_changed";
+        row["compatibility"] = record.backwardIncompatible ? "backward_incompatible" : "backward_compatible";
+        return row;
+    }
+
+    py::dict resultToDict(const armor::CompareResult& result) {
+        py::list changes;
+        for (const ChangeRecord& record : result.changes) {
+            changes.append(recordToDict(record));
+        }
+        py::dict dict;
+        dict["outcome"] = py::cast(result.outcome).attr("name");
+        dict["header"] = result.header;
+        dict["overall_status"] = result.overallStatus;
+        dict["backward_incompatible"] = result.backwardIncompatible;
+        dict["parsed_status"] = py::cast(result.parsedStatus).attr("name");
+        dict["unparsed_status"] = py::cast(result.unparsedStatus).attr("name");
+        dict["parser"] = py::cast(result.parser).attr("name");
+        dict["changes"] = changes;
+        dict["error"] = result.error;
+        return dict;
+    }
+
+}
+
+PYBIND11_MODULE(armor, m) {
+    m.doc() = "In-process ARMOR header comparisons over armor::Comparator.";
+
+    py::enum_<LANG_OPTIONS>(m, "Lang")
+        .value("C", LANG_OPTIONS::C)
+        .value("CPP", LANG_OPTIONS::CPP);
+
+    py::enum_<PARSE_MODE>(m, "ParseMode")
+        .value("FULL", FULL_MODE)
+        .value("API_ONLY", API_ONLY_MODE);
+
+    py::enum_<PARSER>(m, "Parser")
+        .value("ALPHA", ALPHA_PARSER)
+        .value("BETA", BETA_PARSER)
+        .value("NONE", NO_PARSER);
+
+    py::enum_<ParsedDiffStatus>(m, "ParsedDiffStatus")
+        .value("FATAL_ERRORS", ParsedDiffStatus::FATAL_ERRORS)
+        .value("UNSUPPORTED_UPDATES", ParsedDiffStatus::UNSUPPORTED_UPDATES)
+        .value("SUPPORTED_UPDATES", ParsedDiffStatus::SUPPORTED_UPDATES)
+        .value("COMMENTS_UPDATED", ParsedDiffStatus::COMMENTS_UPDATED)
+        .value("NON_FUNCTIONAL_CHANGES", ParsedDiffStatus::NON_FUNCTIONAL_CHANGES);
+
+    py::enum_<UnParsedDiffStatus>(m, "UnParsedDiffStatus")
+        .value("UN_CHANGED", UnParsedDiffStatus::UN_CHANGED)
+        .value("CHANGED", UnParsedDiffStatus::CHANGED);
+
+    py::enum_<armor::CompareOutcome>(m, "CompareOutcome")
+        .value("COMPARED", armor::CompareOutcome::COMPARED)
+        .value("IDENTICAL", armor::CompareOutcome::IDENTICAL)
+        .value("MISSING_IN_OLDER", armor::CompareOutcome::MISSING_IN_OLDER)
+        .value("MISSING_IN_NEWER", armor::CompareOutcome::MISSING_IN_NEWER)
+        .value("FAILED", armor::CompareOutcome::FAILED);
+
+    py::class_<armor::CompareOptions>(m, "CompareOptions")
+        .def(py::init<>())
+        .def_readwrite("include_paths", &armor::CompareOptions::includePaths)
+        .def_readwrite("macro_flags", &armor::CompareOptions::macroFlags)
+        .def_readwrite("lang", &armor::CompareOptions::lang)
+        .def_readwrite("parse_mode", &armor::CompareOptions::parseMode)
+        .def_readwrite("skip_foreign_bodies", &armor::CompareOptions::skipForeignBodies)
+        .def_readwrite("verdict_only", &armor::CompareOptions::verdictOnly)
+        .def_readwrite("cache_dir", &armor::CompareOptions::cacheDir)
+        .def_readwrite("output_dir", &armor::CompareOptions::outputDir)
+        .def_readwrite("report_format", &armor::CompareOptions::reportFormat)
+        .def_readwrite("log_file", &armor::CompareOptions::logFile)
+        .def("load_api_filter", [](armor::CompareOptions& options, const std::string& path) {
+                 options.apiFilter = std::make_shared<const armor::ApiFilter>(armor::ApiFilter::load(path));
+             },
+             py::arg("path"), "Selects the public API from an --api-filter JSON file.");
+
+    py::class_<ChangeRecord>(m, "ChangeRecord")
+        .def_readonly("headerfile", &ChangeRecord::headerfile)
+        .def_readonly("name", &ChangeRecord::name)
+        .def_readonly("description", &ChangeRecord::description)
+        .def_readonly("compatibility_changed", &ChangeRecord::compatibilityChanged)
+        .def_readonly("backward_incompatible", &ChangeRecord::backwardIncompatible)
+        .def("to_dict", &recordToDict, "The row as the JSON report writes it.")
+        .def("__repr__", [](const ChangeRecord& record) {
+            return "<ChangeRecord " + record.name + ": " + record.description + ">";
+        });
+
+    py::class_<armor::CompareResult>(m, "CompareResult")
+        .def_readonly("outcome", &armor::CompareResult::outcome)
+        .def_readonly("header", &armor::CompareResult::header)
+        .def_readonly("overall_status", &armor::CompareResult::overallStatus)
+        .def_readonly("backward_incompatible", &armor::CompareResult::backwardIncompatible)
+        .def_readonly("parsed_status", &armor::CompareResult::parsedStatus)
+        .def_readonly("unparsed_status", &armor::CompareResult::unparsedStatus)
+        .def_readonly("parser", &armor::CompareResult::parser)
+        .def_readonly("changes", &armor::CompareResult::changes)
+        .def_readonly("error", &armor::CompareResult::error)
+        .def("to_dict", &resultToDict, "The result as plain Python values, enums by name.")
+        .def("__repr__", [](const armor::CompareResult& result) {
+            return "<CompareResult " + result.header + ": " + result.overallStatus + ">";
+        });
+
+    py::class_<armor::Comparator>(m, "Comparator")
+        .def(py::init<armor::CompareOptions>(), py::arg("options") = armor::CompareOptions())
+        // Other Python threads run while clang parses
+        .def("compare",
+             [](const armor::Comparator& comparator, const std::string& projectRoot1,
+                const std::string& projectRoot2, const std::string& header,
+                std::map<std::string, std::string> buffers) {
+                 return comparator.compare({projectRoot1, projectRoot2, header, std::move(buffers)});
+             },
+             py::arg("project_root1"), py::arg("project_root2"), py::arg("header"),
+             py::arg("buffers") = std::map<std::string, std::string>(),
+             py::call_guard<py::gil_scoped_release>(),
+             "Compares the two versions of `header`, a path relative to both project roots.\n\n"
+             "`buffers` maps paths relative to project_root2 to unsaved contents read in place of\n"
+             "those files, so a candidate version is compared without writing it to disk.")
+        .def("refresh", &armor::Comparator::refresh,
+             "Forgets the cached contents of files changed on disk since they were read.")
+        .def_property_readonly("options", &armor::Comparator::getOptions);
+}
@@ -10,6 +10,7 @@
 #include "options_handler.hpp"
 #include "alpha/include/header_processor.hpp"
 #include "logger.hpp"
+#include "file_compare.hpp"
 
 #ifndef TOOL_VERSION
 #define TOOL_VERSION ""
@@ -30,8 +31,7 @@ LANG_OPTIONS stringToLangOption(const std::string& lang) {
 }
 
 bool filesAreDifferentUsingDiff(const std::string &file1, const std::string &file2) {
-    std::string command = "diff -q " + file1 + " " + file2 + " > /dev/null";
-    return std::system(command.c_str()) != 0;
+    return armor::filesDiffer(file1, file2);
 }
 
 bool runArmorTool(int argc, const char **argv) {
@@ -137,7 +137,7 @@ bool runArmorTool(int argc, const char **argv) {
                 armor::user_error() << "Missing header in newer version: " << file2;
             } else if (filesAreDifferentUsingDiff(file1, file2)) {
                 processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                IncludePaths, macros, langOption);
+                                IncludePaths, macros, langOption, dumpAstDiff);
                 processed = true;
             } 
             else {
@@ -170,7 +170,7 @@ bool runArmorTool(int argc, const char **argv) {
             } 
             else if (filesAreDifferentUsingDiff(file1, file2)) {
                 processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                IncludePaths, macros, langOption);
+                                IncludePaths, macros, langOption, dumpAstDiff);
                 processed = true;
             } 
             else {
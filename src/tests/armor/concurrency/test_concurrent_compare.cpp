@@ -0,0 +1,129 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "comparator.hpp"
+
+namespace {
+
+    constexpr size_t THREADS = 8;
+    // Every pair is compared once per round, by whichever thread takes it
+    constexpr size_t ROUNDS = 4;
+
+    // What a report says of a pair, in one comparable string
+    std::string describe(const armor::CompareResult& result) {
+        std::string text = std::to_string(static_cast<int>(result.outcome)) + " " + result.overallStatus + " " +
+                           std::to_string(static_cast<int>(result.parsedStatus)) + " " +
+                           std::to_string(static_cast<int>(result.unparsedStatus)) + " " + result.error + "\n";
+        for (const ChangeRecord& record : result.changes) {
+            text += record.name + " | " + record.description + " | " +
+                    (record.backwardIncompatible ? "incompatible" : "compatible") + "\n";
+        }
+        return text;
+    }
+
+    /**
+     * The fixtures of the beta functional tests, laid out as two project roots
+     * holding `<fixture>/mylib.h`, so that every pair has a header path of its
+     * own and may be compared alongside the others.
+     */
+    class ConcurrentCompareTest : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                root = std::filesystem::temp_directory_path() / "armor_concurrency_test";
+                std::filesystem::remove_all(root);
+                for (const auto& fixture : std::filesystem::directory_iterator(ARMOR_FIXTURES_DIR)) {
+                    std::filesystem::path older = fixture.path() / "v1" / "mylib.h";
+                    std::filesystem::path newer = fixture.path() / "v2" / "mylib.h";
+                    if (!std::filesystem::exists(older) || !std::filesystem::exists(newer)) {
+                        continue;
+                    }
+                    std::string name = fixture.path().filename().string();
+                    std::filesystem::create_directories(root / "v1" / name);
+                    std::filesystem::create_directories(root / "v2" / name);
+                    std::filesystem::copy_file(older, root / "v1" / name / "mylib.h");
+                    std::filesystem::copy_file(newer, root / "v2" / name / "mylib.h");
+                    headers.push_back(name + "/mylib.h");
+                }
+                std::sort(headers.begin(), headers.end());
+            }
+
+            void TearDown() override {
+                std::filesystem::remove_all(root);
+            }
+
+            armor::HeaderPair pair(const std::string& header) const {
+                return {(root / "v1").string(), (root / "v2").string(), header};
+            }
+
+            std::filesystem::path root;
+            std::vector<std::string> headers;
+    };
+
+}
+
+TEST_F(ConcurrentCompareTest, ConcurrentComparisonsMatchSequentialOnes) {
+    ASSERT_FALSE(headers.empty());
+    armor::Comparator comparator{armor::CompareOptions()};
+
+    std::vector<std::string> expected;
+    for (const std::string& header : headers) {
+        expected.push_back(describe(comparator.compare(pair(header))));
+    }
+
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        std::vector<std::string> actual(headers.size());
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&]() {
+                for (size_t i = next++; i < headers.size(); i = next++) {
+                    actual[i] = describe(comparator.compare(pair(headers[i])));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (size_t i = 0; i < headers.size(); ++i) {
+            EXPECT_EQ(actual[i], expected[i]) << headers[i] << " in round " << round;
+        }
+    }
+}
+
+TEST_F(ConcurrentCompareTest, SeparateComparatorsRunSideBySide) {
+    ASSERT_FALSE(headers.empty());
+    armor::CompareOptions verdictOnly;
+    verdictOnly.verdictOnly = true;
+    armor::Comparator full{armor::CompareOptions()};
+    armor::Comparator verdicts{verdictOnly};
+
+    std::vector<std::string> expected;
+    for (const std::string& header : headers) {
+        expected.push_back(full.compare(pair(header)).overallStatus);
+    }
+
+    // The halves take disjoint headers, as two embedders sharing the process would
+    std::vector<std::string> actual(headers.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            const armor::Comparator& comparator = t % 2 == 0 ? full : verdicts;
+            for (size_t i = t; i < headers.size(); i += THREADS) {
+                actual[i] = comparator.compare(pair(headers[i])).overallStatus;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < headers.size(); ++i) {
+        EXPECT_EQ(actual[i], expected[i]) << headers[i];
+    }
+}
@@ -0,0 +1,55 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+import os
+import sys
+import json
+import subprocess
+import pytest
+from deepdiff import DeepDiff
+
+FIXTURE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "supported_code_update")
+
+
+@pytest.fixture
+def armor(binary_path):
+    """The armor module next to the binary, built with -DARMOR_BUILD_PYTHON=ON."""
+    build_dir = binary_path[:binary_path.index("/src/tests/")]
+    sys.path.insert(0, os.path.join(build_dir, "src/python"))
+    return pytest.importorskip("armor")
+
+
+def test_compare_matches_json_report(armor, binary_path, tmp_path):
+    prj_root1 = os.path.join(FIXTURE_DIR, "v1")
+    prj_root2 = os.path.join(FIXTURE_DIR, "v2")
+
+    subprocess.run([binary_path, prj_root1, prj_root2, "mylib.h", "-r", "json"], check=True, cwd=tmp_path)
+    with open(tmp_path / "armor_reports/json_reports/api_diff_report_mylib.h.json", 'r') as f:
+        report = json.load(f)
+
+    result = armor.Comparator().compare(prj_root1, prj_root2, "mylib.h")
+
+    assert result.outcome == armor.CompareOutcome.COMPARED
+    assert result.overall_status == report["overall_status"]
+    rows = [change.to_dict() for change in result.changes]
+    assert DeepDiff(report["api_diff"], rows, ignore_order=True) == {}
+
+
+def test_compare_writes_nothing_by_default(armor, tmp_path):
+    prj_root1 = os.path.join(FIXTURE_DIR, "v1")
+    prj_root2 = os.path.join(FIXTURE_DIR, "v2")
+    cwd = os.getcwd()
+    os.chdir(tmp_path)
+    try:
+        comparator = armor.Comparator()
+        results = [comparator.compare(prj_root1, prj_root2, "mylib.h") for _ in range(3)]
+    finally:
+        os.chdir(cwd)
+
+    assert len({json.dumps(result.to_dict(), sort_keys=True) for result in results}) == 1
+    assert list(tmp_path.iterdir()) == []
+
+
+def test_missing_header(armor, tmp_path):
+    result = armor.Comparator().compare(str(tmp_path), os.path.join(FIXTURE_DIR, "v2"), "mylib.h")
+    assert result.outcome == armor.CompareOutcome.MISSING_IN_OLDER
+    assert not result.backward_incompatible
@@ -13,6 +13,7 @@
 #include "alpha/include/header_processor.hpp"
 #include "beta/include/header_processor.hpp"
 #include "logger.hpp"
+#include "file_compare.hpp"
 
 #ifndef TOOL_VERSION
 #define TOOL_VERSION ""
@@ -33,8 +34,32 @@ LANG_OPTIONS stringToLangOption(const std::string& lang) {
 }
 
 bool filesAreDifferentUsingDiff(const std::string &file1, const std::string &file2) {
-    std::string command = "diff -q " + file1 + " " + file2 + " > /dev/null";
-    return std::system(command.c_str()) != 0;
+    return armor::filesDiffer(file1, file2);
+}
+
+// Parses the pair with alpha, then beta, and reports only the last parser that succeeded
+void processHeaderPair(const std::string& projectRoot1, const std::string& file1,
+                       const std::string& projectRoot2, const std::string& file2,
+                       const std::string& reportFormat, const std::vector<std::string>& IncludePaths,
+                       const std::vector<std::string>& macros, LANG_OPTIONS langOption, bool dumpAstDiff) {
+    ParsedHeaderPairAlpha alphaParsed = parseHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2,
+                                IncludePaths, macros, langOption);
+    if (alphaParsed.status == NO_FATAL_ERRORS) {
+        armor::info() << "Processing Headers again via beta parser\n";
+        ParsedHeaderPairBeta betaParsed = parseHeaderPairBeta(projectRoot1, file1, projectRoot2, file2,
+                                IncludePaths, macros, langOption);
+        if (betaParsed.status == NO_FATAL_ERRORS) {
+            reportHeaderPairBeta(projectRoot1, file1, reportFormat, betaParsed.context1, betaParsed.context2, dumpAstDiff);
+            return;
+        }
+        armor::info() << "Beta parser failed, reporting the alpha results\n";
+    }
+    else {
+        armor::info() << "Processing Headers stopped at alpha parser\n";
+    }
+    if (alphaParsed.context1 && alphaParsed.context2) {
+        reportHeaderPairAlpha(projectRoot1, file1, reportFormat, alphaParsed.context1, alphaParsed.context2, dumpAstDiff);
+    }
 }
 
 bool runArmorTool(int argc, const char **argv) {
@@ -145,18 +170,8 @@ bool runArmorTool(int argc, const char **argv) {
                 armor::user_error() << "Missing header in newer version: " << file2 << "\n";
             } 
             else if (filesAreDifferentUsingDiff(file1, file2)) {
-                PARSING_STATUS parsingStatus = processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                IncludePaths, macros, langOption);
-                switch (parsingStatus) {
-                    case NO_FATAL_ERRORS:
-                        armor::info() << "Processing Headers again via beta parser\n";
-                        processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                    IncludePaths, macros, langOption);
-                        break;
-                    case FATAL_ERRORS:
-                        armor::info() << "Processing Headers stopped at alpha parser\n";
-                        break;
-                }
+                processHeaderPair(projectRoot1, file1, projectRoot2, file2, reportFormat,
+                                IncludePaths, macros, langOption, dumpAstDiff);
                 processed = true;
             } 
             else {
@@ -188,18 +203,8 @@ bool runArmorTool(int argc, const char **argv) {
                 armor::user_error() << "Missing header in newer version: " << file2 << "\n";
             } 
             else if (filesAreDifferentUsingDiff(file1, file2)) {
-                PARSING_STATUS parsingStatus = processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                IncludePaths, macros, langOption);
-                switch (parsingStatus) {
-                    case NO_FATAL_ERRORS:
-                        armor::info() << "Processing Headers again via v2\n";
-                        processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                    IncludePaths, macros, langOption);
-                        break;
-                    case FATAL_ERRORS:
-                        armor::info() << "Processing Headers stopped at v1\n";
-                        break;
-                }
+                processHeaderPair(projectRoot1, file1, projectRoot2, file2, reportFormat,
+                                IncludePaths, macros, langOption, dumpAstDiff);
                 processed = true;
             } 
             else {
@@ -0,0 +1,42 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <string>
+
+#include "beta_contexts.hpp"
+
+namespace {
+
+    beta::APINode* makeNode(beta::ASTNormalizedContext& context, NodeKind kind, const std::string& name,
+                            const std::string& usr, const std::string& type) {
+        beta::APINode* node = context.createNode();
+        node->kind = kind;
+        node->name = context.intern(name);
+        node->NSR = node->name;
+        node->USR = context.intern(usr);
+        node->dataType = context.intern(type);
+        node->caonicalType = node->dataType;
+        node->access = AccessSpec::Public;
+        return node;
+    }
+
+}
+
+void armor::unittest::buildBetaContext(beta::ASTNormalizedContext& context, const std::string& fieldType) {
+    beta::APINode* s = makeNode(context, NodeKind::Struct, "ns::S", "c:@N@ns@S@S", "ns::S");
+    beta::APINode* inner = makeNode(context, NodeKind::Struct, "ns::S::Inner", "c:@N@ns@S@S@S@Inner",
+                                    "ns::S::Inner");
+    context.addChild(*s, inner);
+    context.addChild(*s, makeNode(context, NodeKind::Field, "ns::S::b", "c:@N@ns@S@S@FI@b", fieldType));
+    context.addChild(*inner, makeNode(context, NodeKind::Field, "ns::S::Inner::x", "c:@N@ns@S@S@S@Inner@FI@x",
+                                      "int"));
+    beta::APINode* f = makeNode(context, NodeKind::Function, "ns::f", "c:@N@ns@F@f#", "void ()");
+    f->stmtHashes.push_back(42);
+    for (beta::APINode* root : {s, f}) {
+        context.addNode(root->NSR, root);
+        context.addRootNode(root);
+        context.usrNodeMap[root->USR] = root;
+    }
+    context.addNode(inner->NSR, inner);
+    context.computeFingerprints();
+    context.freeze();
+}
@@ -0,0 +1,21 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+#include "ast_normalized_context.hpp"
+
+namespace armor::unittest {
+
+/**
+ * @brief Fills `context` as the beta normalizer would for
+ *        `namespace ns { struct S { struct Inner { int x; } inner; <fieldType> b; }; void f(); }`.
+ *
+ * Fingerprints are computed and the context is frozen, as after a real
+ * parse. Written as a flat image, the last child ids are those of Inner,
+ * the deepest node.
+ */
+void buildBetaContext(beta::ASTNormalizedContext& context, const std::string& fieldType);
+
+}
@@ -0,0 +1,150 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "ast_cache.hpp"
+
+namespace {
+
+    void writeFile(const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    // Whether the translation unit declares a top-level `name`
+    bool declares(clang::ASTUnit& unit, const std::string& name) {
+        clang::ASTContext& context = unit.getASTContext();
+        return !context.getTranslationUnitDecl()->lookup(&context.Idents.get(name)).empty();
+    }
+
+}
+
+class AstCacheTest : public ::testing::Test {
+protected:
+    std::filesystem::path root;
+    std::string cacheDir;
+    std::string header;
+    std::string dependency;
+    std::vector<std::string> flags;
+    std::vector<std::string> commandLine;
+
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "armor_ast_cache_test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "include");
+        cacheDir = (root / "cache").string();
+        header = (root / "include" / "foo.h").string();
+        dependency = (root / "include" / "types.h").string();
+        writeFile(header, "#include \"types.h\"\nfoo_int foo(foo_int value);\n");
+        writeFile(dependency, "typedef int foo_int;\n");
+        flags = {"-xc++", "-I" + (root / "include").string()};
+        commandLine = {"clang"};
+        commandLine.insert(commandLine.end(), flags.begin(), flags.end());
+        commandLine.push_back(header);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    // Parses the header from disk and serializes its AST, as a clean parse stores it
+    std::string serializedAst() {
+        clang::tooling::FixedCompilationDatabase compilations(root.string(), flags);
+        clang::tooling::ClangTool tool(compilations, {header});
+        std::vector<std::unique_ptr<clang::ASTUnit>> units;
+        EXPECT_EQ(tool.buildASTs(units), 0);
+        if (units.size() != 1) {
+            return std::string();
+        }
+        llvm::SmallString<0> bytes;
+        llvm::raw_svector_ostream out(bytes);
+        EXPECT_FALSE(units[0]->serialize(out));
+        return bytes.str().str();
+    }
+
+    void store(const armor::AstCache& cache) {
+        std::string ast = serializedAst();
+        ASSERT_FALSE(ast.empty());
+        cache.store(header, commandLine, {header, dependency}, ast);
+    }
+};
+
+TEST_F(AstCacheTest, MissesBeforeTheFirstStore) {
+    armor::AstCache cache(cacheDir, false);
+    EXPECT_EQ(cache.load(header, commandLine), nullptr);
+}
+
+TEST_F(AstCacheTest, StoredAstLoadsBack) {
+    armor::AstCache cache(cacheDir, false);
+    store(cache);
+
+    std::vector<std::string> dependencies;
+    std::unique_ptr<clang::ASTUnit> unit = cache.load(header, commandLine, &dependencies);
+    ASSERT_NE(unit, nullptr);
+    EXPECT_TRUE(declares(*unit, "foo"));
+    EXPECT_TRUE(declares(*unit, "foo_int"));
+    EXPECT_EQ(dependencies, (std::vector<std::string>{header, dependency}));
+}
+
+TEST_F(AstCacheTest, OtherCommandLineOrBodySkippingMisses) {
+    armor::AstCache cache(cacheDir, false);
+    store(cache);
+
+    std::vector<std::string> other = commandLine;
+    other.insert(other.end() - 1, "-DFOO");
+    EXPECT_EQ(cache.load(header, other), nullptr);
+    armor::AstCache skipping(cacheDir, true);
+    EXPECT_EQ(skipping.load(header, commandLine), nullptr);
+}
+
+TEST_F(AstCacheTest, EditedHeaderOrDependencyInvalidates) {
+    armor::AstCache cache(cacheDir, false);
+    store(cache);
+
+    writeFile(dependency, "typedef long foo_int;\n");
+    EXPECT_EQ(cache.load(header, commandLine), nullptr);
+
+    writeFile(dependency, "typedef int foo_int;\n");
+    writeFile(header, "#include \"types.h\"\nfoo_int foo(foo_int value, int flags);\n");
+    EXPECT_EQ(cache.load(header, commandLine), nullptr);
+}
+
+TEST_F(AstCacheTest, CorruptAstIsRemoved) {
+    armor::AstCache cache(cacheDir, false);
+    store(cache);
+
+    std::vector<std::filesystem::path> asts;
+    for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(cacheDir) / "asts")) {
+        if (entry.path().extension() == ".ast") {
+            asts.push_back(entry.path());
+        }
+    }
+    ASSERT_EQ(asts.size(), 1u);
+    std::filesystem::resize_file(asts[0], std::filesystem::file_size(asts[0]) / 2);
+
+    EXPECT_EQ(cache.load(header, commandLine), nullptr);
+    EXPECT_FALSE(std::filesystem::exists(asts[0]));
+}
+
+TEST_F(AstCacheTest, UnitsImportingAstFilesAreNotStored) {
+    EXPECT_TRUE(armor::AstCache::canStore(commandLine));
+    EXPECT_FALSE(armor::AstCache::canStore({"clang", "-include-pch", "pch.h.pch", "foo.h"}));
+    EXPECT_FALSE(armor::AstCache::canStore({"clang", "-fmodules", "foo.h"}));
+
+    armor::AstCache cache(cacheDir, false);
+    std::vector<std::string> withPch = {"clang", "-include-pch", "pch.h.pch", header};
+    cache.store(header, withPch, {header}, "not an AST");
+    EXPECT_FALSE(std::filesystem::exists(std::filesystem::path(cacheDir) / "asts"));
+}
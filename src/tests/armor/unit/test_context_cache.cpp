@@ -0,0 +1,230 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/Support/xxhash.h"
+
+#include "beta_contexts.hpp"
+#include "context_cache.hpp"
+#include "diffengine.hpp"
+#include "remote_cache.hpp"
+
+namespace {
+
+    // The layout context_cache.cpp writes: magic, format, metadata size and a
+    // checksum of what follows, then the metadata and the 8-aligned beta image
+    constexpr size_t METADATA_SIZE_OFFSET = 8;
+    constexpr size_t CHECKSUM_OFFSET = 16;
+    constexpr size_t ENTRY_HEADER_SIZE = 24;
+
+    void writeFile(const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // The entry files directly under `dir`, without the chunks of a remote cache
+    std::vector<std::filesystem::path> entryFiles(const std::filesystem::path& dir) {
+        std::vector<std::filesystem::path> files;
+        if (std::filesystem::exists(dir)) {
+            for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".cbor") {
+                    files.push_back(entry.path());
+                }
+            }
+        }
+        return files;
+    }
+
+    // A remote store held in memory, standing in for an HTTP one
+    class MemoryRemoteCache : public armor::RemoteCache {
+        public:
+            bool fetch(const std::string& key, std::string& bytes) override {
+                std::scoped_lock<std::mutex> lock(mutex);
+                auto found = entries.find(key);
+                if (found == entries.end()) {
+                    return false;
+                }
+                bytes = found->second;
+                return true;
+            }
+
+            void publish(const std::string& key, llvm::StringRef bytes) override {
+                std::scoped_lock<std::mutex> lock(mutex);
+                entries[key] = bytes.str();
+            }
+
+            size_t size() {
+                std::scoped_lock<std::mutex> lock(mutex);
+                return entries.size();
+            }
+
+        private:
+            std::mutex mutex;
+            std::map<std::string, std::string> entries;
+    };
+
+}
+
+class ContextCacheTest : public ::testing::Test {
+protected:
+    std::filesystem::path root;
+    std::filesystem::path cacheDir;
+    std::string header;
+    std::string dependency;
+    std::vector<std::string> commandLine;
+
+    alpha::ASTNormalizedContext alphaStored;
+    beta::ASTNormalizedContext betaStored;
+
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "armor_context_cache_test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "include");
+        cacheDir = root / "cache";
+        header = (root / "include" / "foo.h").string();
+        dependency = (root / "include" / "types.h").string();
+        writeFile(header, "#include \"types.h\"\nnamespace ns { struct S { struct Inner { int x; } inner; long b; }; }\n");
+        writeFile(dependency, "typedef int foo_int;\n");
+        commandLine = {"clang", "-xc++", "-I" + (root / "include").string(), header};
+        armor::unittest::buildBetaContext(betaStored, "long");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    void store(const armor::ContextCache& cache) {
+        cache.store(header, commandLine, {header, dependency}, alphaStored, betaStored);
+    }
+};
+
+TEST_F(ContextCacheTest, HitDiffsAsTheStoredParse) {
+    armor::ContextCache cache(cacheDir.string());
+    store(cache);
+
+    alpha::ASTNormalizedContext alphaLoaded;
+    beta::ASTNormalizedContext betaLoaded;
+    std::vector<std::string> dependencies;
+    ASSERT_TRUE(cache.load(header, commandLine, alphaLoaded, betaLoaded, &dependencies));
+    EXPECT_EQ(dependencies, (std::vector<std::string>{header, dependency}));
+
+    beta::ASTNormalizedContext older;
+    armor::unittest::buildBetaContext(older, "int");
+    nlohmann::json fresh = diffTrees(&older, &betaStored);
+    nlohmann::json cached = diffTrees(&older, &betaLoaded);
+    EXPECT_FALSE(fresh["astDiff"].empty());
+    EXPECT_EQ(fresh, cached);
+}
+
+TEST_F(ContextCacheTest, OtherCommandLineMisses) {
+    armor::ContextCache cache(cacheDir.string());
+    store(cache);
+
+    std::vector<std::string> other = commandLine;
+    other.insert(other.end() - 1, "-DFOO");
+    alpha::ASTNormalizedContext alphaLoaded;
+    beta::ASTNormalizedContext betaLoaded;
+    EXPECT_FALSE(cache.load(header, other, alphaLoaded, betaLoaded));
+}
+
+TEST_F(ContextCacheTest, TouchedDependencyMakesTheEntryStale) {
+    armor::ContextCache cache(cacheDir.string());
+    store(cache);
+    writeFile(dependency, "typedef long foo_int;\n");
+
+    alpha::ASTNormalizedContext alphaLoaded;
+    beta::ASTNormalizedContext betaLoaded;
+    EXPECT_FALSE(cache.load(header, commandLine, alphaLoaded, betaLoaded));
+}
+
+TEST_F(ContextCacheTest, CorruptEntryIsIgnoredAndRemoved) {
+    armor::ContextCache cache(cacheDir.string());
+    store(cache);
+    std::vector<std::filesystem::path> entries = entryFiles(cacheDir);
+    ASSERT_EQ(entries.size(), 1u);
+    std::string bytes = readFile(entries[0]);
+    bytes[bytes.size() / 2] ^= 0x5a;
+    writeFile(entries[0], bytes);
+
+    alpha::ASTNormalizedContext alphaLoaded;
+    beta::ASTNormalizedContext betaLoaded;
+    EXPECT_FALSE(cache.load(header, commandLine, alphaLoaded, betaLoaded));
+    EXPECT_TRUE(entryFiles(cacheDir).empty());
+}
+
+TEST_F(ContextCacheTest, MalformedBetaImageLeavesTheCallersContextsUntouched) {
+    armor::ContextCache cache(cacheDir.string());
+    store(cache);
+    std::vector<std::filesystem::path> entries = entryFiles(cacheDir);
+    ASSERT_EQ(entries.size(), 1u);
+
+    // Breaks the magic of the beta image, then fixes up the checksum so the
+    // entry decodes and only reading the image fails
+    std::string bytes = readFile(entries[0]);
+    uint64_t metadataSize = 0;
+    std::memcpy(&metadataSize, bytes.data() + METADATA_SIZE_OFFSET, sizeof(metadataSize));
+    size_t imageOffset = (ENTRY_HEADER_SIZE + metadataSize + 7) & ~size_t{7};
+    ASSERT_LT(imageOffset, bytes.size());
+    bytes[imageOffset] = 'X';
+    uint64_t checksum = llvm::xxHash64(llvm::StringRef(bytes).drop_front(ENTRY_HEADER_SIZE));
+    std::memcpy(&bytes[CHECKSUM_OFFSET], &checksum, sizeof(checksum));
+    writeFile(entries[0], bytes);
+
+    alpha::ASTNormalizedContext alphaLoaded;
+    beta::ASTNormalizedContext betaLoaded;
+    armor::unittest::buildBetaContext(betaLoaded, "short");
+    ASSERT_EQ(betaLoaded.getRootNodes().size(), 2u);
+    EXPECT_FALSE(cache.load(header, commandLine, alphaLoaded, betaLoaded));
+    ASSERT_EQ(betaLoaded.getRootNodes().size(), 2u);
+    EXPECT_EQ(betaLoaded.findNodeByUSR("c:@N@ns@S@S")->children[1]->dataType, "short");
+    EXPECT_TRUE(alphaLoaded.getRootNodes().empty());
+}
+
+TEST_F(ContextCacheTest, ValidRemoteEntryIsPublishedAndKeptLocally) {
+    auto remote = std::make_shared<MemoryRemoteCache>();
+    armor::ContextCache publisher((root / "cache_a").string(), FULL_MODE, false, remote);
+    store(publisher);
+    EXPECT_GT(remote->size(), 0u);
+
+    // Another machine, with an empty local cache
+    armor::ContextCache fetcher((root / "cache_b").string(), FULL_MODE, false, remote);
+    alpha::ASTNormalizedContext alphaLoaded;
+    beta::ASTNormalizedContext betaLoaded;
+    ASSERT_TRUE(fetcher.load(header, commandLine, alphaLoaded, betaLoaded));
+    EXPECT_EQ(betaLoaded.getRootNodes().size(), 2u);
+    EXPECT_EQ(entryFiles(root / "cache_b").size(), 1u);
+
+    // Served locally from now on, without the remote store
+    armor::ContextCache offline((root / "cache_b").string());
+    alpha::ASTNormalizedContext alphaAgain;
+    beta::ASTNormalizedContext betaAgain;
+    EXPECT_TRUE(offline.load(header, commandLine, alphaAgain, betaAgain));
+}
+
+TEST_F(ContextCacheTest, RemoteEntryFailingValidationIsNotKeptLocally) {
+    auto remote = std::make_shared<MemoryRemoteCache>();
+    armor::ContextCache publisher((root / "cache_a").string(), FULL_MODE, false, remote);
+    store(publisher);
+    // The fetching machine's copy of an included header differs
+    writeFile(dependency, "typedef long foo_int;\n");
+
+    armor::ContextCache fetcher((root / "cache_b").string(), FULL_MODE, false, remote);
+    alpha::ASTNormalizedContext alphaLoaded;
+    beta::ASTNormalizedContext betaLoaded;
+    EXPECT_FALSE(fetcher.load(header, commandLine, alphaLoaded, betaLoaded));
+    EXPECT_TRUE(entryFiles(root / "cache_b").empty());
+}
@@ -0,0 +1,144 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ast_normalized_context.hpp"
+#include "beta_contexts.hpp"
+#include "diffengine.hpp"
+#include "flat_context.hpp"
+
+namespace {
+
+    // The image layout flat_context.cpp writes: a 64-byte header of magic,
+    // version and the element counts of the sections, then 8-byte aligned
+    // sections, nodes first and their child ids second
+    constexpr size_t VERSION_OFFSET = 4;
+    constexpr size_t COUNTS_OFFSET = 8;
+    constexpr size_t SECTIONS_OFFSET = 64;
+    constexpr size_t NODE_SIZE = 84;
+    constexpr size_t NODE_SCOPE_OFFSET = 72;
+
+    uint32_t readU32(const std::string& image, size_t offset) {
+        uint32_t value = 0;
+        std::memcpy(&value, image.data() + offset, sizeof(value));
+        return value;
+    }
+
+    void writeU32(std::string& image, size_t offset, uint32_t value) {
+        std::memcpy(&image[offset], &value, sizeof(value));
+    }
+
+    size_t childrenOffset(const std::string& image) {
+        size_t nodes = readU32(image, COUNTS_OFFSET) * NODE_SIZE;
+        return SECTIONS_OFFSET + ((nodes + 7) & ~size_t{7});
+    }
+
+    void expectSameSubtree(const beta::APINode& expected, const beta::APINode& actual) {
+        EXPECT_EQ(expected.kind, actual.kind);
+        EXPECT_EQ(expected.name, actual.name);
+        EXPECT_EQ(expected.USR, actual.USR);
+        EXPECT_EQ(expected.dataType, actual.dataType);
+        EXPECT_EQ(expected.fingerprint, actual.fingerprint);
+        EXPECT_EQ(std::vector<uint64_t>(expected.stmtHashes.begin(), expected.stmtHashes.end()),
+                  std::vector<uint64_t>(actual.stmtHashes.begin(), actual.stmtHashes.end()));
+        ASSERT_EQ(expected.children.size(), actual.children.size()) << expected.name.str();
+        for (size_t i = 0; i < expected.children.size(); ++i) {
+            expectSameSubtree(*expected.children[i], *actual.children[i]);
+        }
+    }
+
+}
+
+class FlatContextTest : public ::testing::Test {
+protected:
+    beta::ASTNormalizedContext older;
+    beta::ASTNormalizedContext newer;
+    std::string image;
+
+    void SetUp() override {
+        armor::unittest::buildBetaContext(older, "int");
+        armor::unittest::buildBetaContext(newer, "long");
+        image = armor::writeFlatBetaContext(newer);
+    }
+
+    static bool load(const std::string& bytes, beta::ASTNormalizedContext& context) {
+        auto storage = std::make_shared<std::string>(bytes);
+        return armor::readFlatBetaContext(*storage, storage, context);
+    }
+};
+
+TEST_F(FlatContextTest, RoundTripKeepsNodesFingerprintsAndDiff) {
+    beta::ASTNormalizedContext loaded;
+    ASSERT_TRUE(load(image, loaded));
+
+    ASSERT_EQ(newer.getRootNodes().size(), loaded.getRootNodes().size());
+    for (size_t i = 0; i < newer.getRootNodes().size(); ++i) {
+        expectSameSubtree(*newer.getRootNodes()[i], *loaded.getRootNodes()[i]);
+    }
+    ASSERT_NE(loaded.findNodeByUSR("c:@N@ns@F@f#"), nullptr);
+    EXPECT_EQ(loaded.findNodeByUSR("c:@N@ns@F@f#")->name, "ns::f");
+
+    nlohmann::json fresh = diffTrees(&older, &newer);
+    nlohmann::json flat = diffTrees(&older, &loaded);
+    EXPECT_FALSE(fresh["astDiff"].empty());
+    EXPECT_EQ(fresh, flat);
+}
+
+TEST_F(FlatContextTest, TruncatedImageIsRejected) {
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image.substr(0, image.size() / 2), loaded));
+    beta::ASTNormalizedContext headerOnly;
+    EXPECT_FALSE(load(image.substr(0, 10), headerOnly));
+}
+
+TEST_F(FlatContextTest, BadMagicIsRejected) {
+    image[0] = 'X';
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image, loaded));
+}
+
+TEST_F(FlatContextTest, OtherVersionIsRejected) {
+    writeU32(image, VERSION_OFFSET, readU32(image, VERSION_OFFSET) + 1);
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image, loaded));
+}
+
+TEST_F(FlatContextTest, OutOfRangeStringOffsetIsRejected) {
+    // The name of the first node
+    writeU32(image, SECTIONS_OFFSET, 0xFFFFFF00u);
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image, loaded));
+}
+
+TEST_F(FlatContextTest, OutOfRangeNodeIdIsRejected) {
+    uint32_t nodeCount = readU32(image, COUNTS_OFFSET);
+    writeU32(image, SECTIONS_OFFSET + NODE_SCOPE_OFFSET, nodeCount + 5);
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image, loaded));
+}
+
+TEST_F(FlatContextTest, OutOfRangeChildIdIsRejected) {
+    writeU32(image, childrenOffset(image), readU32(image, COUNTS_OFFSET));
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image, loaded));
+}
+
+TEST_F(FlatContextTest, ChildPointingBackAtAnAncestorIsRejected) {
+    // Inner's only child, the last id written, pointed at S, the first node
+    uint32_t childCount = readU32(image, COUNTS_OFFSET + 4);
+    ASSERT_EQ(childCount, 3u);
+    writeU32(image, childrenOffset(image) + (childCount - 1) * 4, 0);
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image, loaded));
+}
+
+TEST_F(FlatContextTest, ChildPointingAtItselfIsRejected) {
+    writeU32(image, childrenOffset(image), 0);
+    beta::ASTNormalizedContext loaded;
+    EXPECT_FALSE(load(image, loaded));
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "gate_verdict.hpp"
+
+namespace {
+
+    armor::GateHeader settled(const std::string& header, bool blocking, bool incompatible, bool failed) {
+        armor::GateHeader gateHeader;
+        gateHeader.header = header;
+        gateHeader.blocking = blocking;
+        gateHeader.backwardIncompatible = incompatible;
+        gateHeader.failed = failed;
+        return gateHeader;
+    }
+
+}
+
+TEST(GateVerdictTest, CompatibleBlockingHeadersPass) {
+    armor::GateVerdict verdict = armor::decideGateVerdict({settled("a.h", true, false, false),
+                                                           settled("b.h", true, false, false)});
+    EXPECT_EQ(verdict.exitCode(), 0);
+    EXPECT_EQ(verdict.toJson(), nlohmann::json::parse(
+        R"({"backward_incompatible": false, "blocking_headers": 2, "headers": [], "failed": []})"));
+}
+
+TEST(GateVerdictTest, FailedBlockingHeaderFails) {
+    armor::GateVerdict verdict = armor::decideGateVerdict({settled("a.h", true, false, false),
+                                                           settled("b.h", true, false, true)});
+    EXPECT_EQ(verdict.exitCode(), 1);
+    EXPECT_EQ(verdict.failedHeaders, std::vector<std::string>{"b.h"});
+    EXPECT_TRUE(verdict.incompatibleHeaders.empty());
+    EXPECT_EQ(verdict.toJson()["backward_incompatible"], false);
+}
+
+TEST(GateVerdictTest, IncompatibleBlockingHeaderFails) {
+    armor::GateVerdict verdict = armor::decideGateVerdict({settled("a.h", true, true, false),
+                                                           settled("b.h", true, true, true)});
+    EXPECT_EQ(verdict.exitCode(), 1);
+    // Listed once, as incompatible, even though its comparison failed as well
+    EXPECT_EQ(verdict.incompatibleHeaders, (std::vector<std::string>{"a.h", "b.h"}));
+    EXPECT_TRUE(verdict.failedHeaders.empty());
+    EXPECT_EQ(verdict.toJson()["backward_incompatible"], true);
+}
+
+TEST(GateVerdictTest, NonBlockingFailuresDoNotFail) {
+    armor::GateVerdict verdict = armor::decideGateVerdict({settled("a.h", true, false, false),
+                                                           settled("b.h", false, false, true),
+                                                           settled("c.h", false, true, false)});
+    EXPECT_EQ(verdict.exitCode(), 0);
+    EXPECT_EQ(verdict.blockingHeaders, 1u);
+    EXPECT_TRUE(verdict.incompatibleHeaders.empty());
+    EXPECT_TRUE(verdict.failedHeaders.empty());
+}
+
+TEST(GateVerdictTest, NoBlockingHeadersPass) {
+    armor::GateVerdict verdict = armor::decideGateVerdict({settled("a.h", false, true, true)});
+    EXPECT_EQ(verdict.exitCode(), 0);
+    EXPECT_EQ(verdict.blockingHeaders, 0u);
+}
@@ -0,0 +1,212 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+#include "server.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+    void writeFile(const std::filesystem::path& path, const std::string& contents) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    sockaddr_un addressOf(const std::string& socketPath) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        return address;
+    }
+
+    // Sends `payload` as one request and returns the reply line; empty if the daemon is not there
+    std::string exchange(const std::string& socketPath, const std::string& payload) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address = addressOf(socketPath);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            close(fd);
+            return std::string();
+        }
+        std::string line = payload + "\n";
+        send(fd, line.data(), line.size(), MSG_NOSIGNAL);
+        std::string reply;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            reply.append(buffer, static_cast<size_t>(n));
+            if (reply.find('\n') != std::string::npos) {
+                break;
+            }
+        }
+        close(fd);
+        return reply.substr(0, reply.find('\n'));
+    }
+
+}
+
+/**
+ * The daemon runs in a child process, as it keeps cache entries in memory
+ * and enters the working directories of requests for the rest of its life.
+ */
+class ServerTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+    std::string socketPath;
+    pid_t daemon = -1;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_server_test";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        socketPath = (dir / "armor.sock").string();
+        writeFile(dir / "old" / "include" / "foo.h", "struct foo_config { int size; };\n");
+        writeFile(dir / "new" / "include" / "foo.h", "struct foo_config { long size; };\n");
+    }
+
+    void TearDown() override {
+        if (daemon > 0) {
+            exchange(socketPath, R"({"command": "shutdown"})");
+            waitpid(daemon, nullptr, 0);
+        }
+        std::filesystem::remove_all(dir);
+    }
+
+    // Forks a process running `armor --serve <socket>`
+    pid_t forkDaemon() {
+        pid_t pid = fork();
+        if (pid == 0) {
+            const char* argv[] = {"armor", "--serve", socketPath.c_str()};
+            _exit(armor::runArmorServer(3, argv) ? 0 : 1);
+        }
+        return pid;
+    }
+
+    // The exit code of the daemon, once it ended within `seconds`; -1 otherwise
+    int exitCode(int seconds) {
+        for (int attempt = 0; attempt < seconds * 100; ++attempt) {
+            int status = 0;
+            if (waitpid(daemon, &status, WNOHANG) == daemon) {
+                daemon = -1;
+                return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            }
+            usleep(10000);
+        }
+        return -1;
+    }
+
+    // Starts the daemon and waits until it accepts connections
+    void start() {
+        daemon = forkDaemon();
+        ASSERT_GT(daemon, 0);
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            if (!exchange(socketPath, R"({"command": "metrics"})").empty()) {
+                return;
+            }
+            ASSERT_EQ(waitpid(daemon, nullptr, WNOHANG), 0) << "The daemon stopped before accepting";
+            usleep(10000);
+        }
+        FAIL() << "The daemon never accepted on " << socketPath;
+    }
+
+    json request(const std::string& payload) {
+        std::string reply = exchange(socketPath, payload);
+        EXPECT_FALSE(reply.empty());
+        return json::parse(reply, nullptr, /*allow_exceptions=*/false);
+    }
+};
+
+TEST_F(ServerTest, CompareRequestIsAnswered) {
+    start();
+    json compare = {{"cwd", dir.string()},
+                    {"compare", {{"project_root1", "old"},
+                                 {"project_root2", "new"},
+                                 {"header", "include/foo.h"},
+                                 {"buffers", {{"include/foo.h", "struct foo_config { short size; };\n"}}}}}};
+    json reply = request(compare.dump());
+    EXPECT_EQ(reply.value("ok", false), true) << reply.dump();
+    EXPECT_EQ(reply.value("outcome", ""), "COMPARED");
+    EXPECT_EQ(reply.value("header", ""), "include/foo.h");
+    EXPECT_EQ(reply.value("backward_incompatible", false), true);
+    EXPECT_FALSE(reply["changes"].empty());
+    // The buffer was compared, not the file under new/
+    EXPECT_EQ(readFile(dir / "new" / "include" / "foo.h"), "struct foo_config { long size; };\n");
+}
+
+TEST_F(ServerTest, ArgsRequestRepliesWithItsReports) {
+    start();
+    json args = {{"cwd", dir.string()}, {"args", {"old", "new", "include/foo.h"}}};
+    json reply = request(args.dump());
+    EXPECT_EQ(reply.value("ok", false), true) << reply.dump();
+    ASSERT_TRUE(reply.contains("reports"));
+    EXPECT_TRUE(reply["reports"].contains("api_diff_report_foo.h.json")) << reply["reports"].dump();
+}
+
+TEST_F(ServerTest, MalformedRequestsAreRefusedAndTheDaemonKeepsServing) {
+    start();
+    json notJson = request("{\"args\": [");
+    EXPECT_EQ(notJson.value("ok", true), false);
+    EXPECT_EQ(notJson.value("error", ""), "Request is not a JSON object");
+
+    json notObject = request("[1, 2]");
+    EXPECT_EQ(notObject.value("ok", true), false);
+
+    json nonStringCommand = request(R"({"command": 42})");
+    EXPECT_EQ(nonStringCommand.value("ok", true), false);
+    EXPECT_EQ(nonStringCommand.value("error", ""), "Request \"command\" is not a string");
+
+    json noArgs = request(R"({"cwd": "/"})");
+    EXPECT_EQ(noArgs.value("ok", true), false);
+    EXPECT_EQ(noArgs.value("error", ""), "Request has no \"args\" array");
+
+    json metrics = request(R"({"command": "metrics"})");
+    EXPECT_EQ(metrics.value("ok", false), true);
+    EXPECT_NE(metrics.value("metrics", "").find("armor_requests_total"), std::string::npos);
+}
+
+TEST_F(ServerTest, ShutdownStopsTheDaemonAndRemovesItsSocket) {
+    start();
+    json reply = request(R"({"command": "shutdown"})");
+    EXPECT_EQ(reply, json({{"ok", true}}));
+    EXPECT_EQ(exitCode(10), 0);
+    EXPECT_FALSE(std::filesystem::exists(socketPath));
+    EXPECT_TRUE(exchange(socketPath, R"({"command": "metrics"})").empty());
+}
+
+TEST_F(ServerTest, StaleSocketIsReplaced) {
+    // A socket left behind by a daemon that did not shut down cleanly
+    int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = addressOf(socketPath);
+    ASSERT_EQ(bind(stale, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    close(stale);
+    ASSERT_TRUE(std::filesystem::is_socket(socketPath));
+
+    start();
+    json reply = request(R"({"command": "metrics"})");
+    EXPECT_EQ(reply.value("ok", false), true);
+}
+
+TEST_F(ServerTest, RegularFileAtTheSocketPathIsLeftAlone) {
+    writeFile(socketPath, "not a socket\n");
+    daemon = forkDaemon();
+    ASSERT_GT(daemon, 0);
+    EXPECT_EQ(exitCode(10), 1);
+    EXPECT_EQ(readFile(socketPath), "not a socket\n");
+}
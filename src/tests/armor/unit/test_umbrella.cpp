@@ -0,0 +1,110 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include "compile_flags.hpp"
+#include "diffengine.hpp"
+#include "header_compilation_database.hpp"
+#include "single_pass.hpp"
+
+namespace {
+
+    void writeFile(const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    std::set<std::string> rootNames(const beta::ASTNormalizedContext& context) {
+        std::set<std::string> names;
+        for (const beta::APINode* root : context.getRootNodes()) {
+            names.insert(root->getQualifiedName());
+        }
+        return names;
+    }
+
+}
+
+/**
+ * Two headers sharing an include, as --batch --umbrella parses a version:
+ * each header's contexts must hold what a parse of it alone holds, and
+ * nothing of the shared include or of the other header.
+ */
+class UmbrellaTest : public ::testing::Test {
+protected:
+    std::filesystem::path root;
+    std::string rootDir;
+    std::string headerA;
+    std::string headerB;
+    std::string umbrellaName;
+
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "armor_umbrella_test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "include");
+        rootDir = root.string();
+        headerA = (root / "include" / "a.h").string();
+        headerB = (root / "include" / "b.h").string();
+        umbrellaName = (root / "armor_umbrella.h").string();
+        writeFile(root / "include" / "common.h",
+                  "#ifndef COMMON_H\n#define COMMON_H\ntypedef int common_t;\n#define COMMON_LIMIT 8\n#endif\n");
+        writeFile(headerA,
+                  "#ifndef A_H\n#define A_H\n#include \"common.h\"\n"
+                  "/* A's config */\nstruct A { common_t x; };\nvoid a_fn(struct A* a);\n#endif\n");
+        writeFile(headerB,
+                  "#ifndef B_H\n#define B_H\n#include \"common.h\"\n"
+                  "struct B { common_t y[COMMON_LIMIT]; };\n#endif\n");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    std::vector<std::string> flagsOf(const std::string& file) const {
+        return armor::buildCompileFlags(rootDir, file, {}, {}, LANG_OPTIONS::CPP);
+    }
+
+    PARSING_STATUS parseUmbrella(armor::SinglePassSession& session, const std::vector<std::string>& files) const {
+        clang::tooling::FixedCompilationDatabase compDB(rootDir, flagsOf(headerA));
+        return session.processUmbrella(files, umbrellaName, compDB);
+    }
+};
+
+TEST_F(UmbrellaTest, EachHeaderGetsWhatItsOwnParseGets) {
+    armor::SinglePassSession umbrella(nullptr);
+    ASSERT_EQ(parseUmbrella(umbrella, {headerA, headerB}), NO_FATAL_ERRORS);
+
+    armor::SinglePassSession separate(nullptr);
+    armor::HeaderCompilationDatabase compDB;
+    compDB.addHeader(headerA, rootDir, flagsOf(headerA));
+    compDB.addHeader(headerB, rootDir, flagsOf(headerB));
+    std::vector<PARSING_STATUS> statuses = separate.processFiles({headerA, headerB}, compDB);
+    ASSERT_EQ(statuses, (std::vector<PARSING_STATUS>{NO_FATAL_ERRORS, NO_FATAL_ERRORS}));
+
+    std::set<std::string> namesA = rootNames(*umbrella.getBetaContext(headerA));
+    std::set<std::string> namesB = rootNames(*umbrella.getBetaContext(headerB));
+    EXPECT_EQ(namesA.count("A"), 1u);
+    EXPECT_EQ(namesA.count("B") + namesA.count("common_t"), 0u);
+    EXPECT_EQ(namesB.count("B"), 1u);
+    EXPECT_EQ(namesB.count("A") + namesB.count("common_t"), 0u);
+    for (const std::string& header : {headerA, headerB}) {
+        SCOPED_TRACE(header);
+        beta::ASTNormalizedContext* alone = separate.getBetaContext(header);
+        beta::ASTNormalizedContext* shared = umbrella.getBetaContext(header);
+        EXPECT_EQ(rootNames(*alone), rootNames(*shared));
+        nlohmann::json diff = diffTrees(alone, shared);
+        EXPECT_TRUE(diff["astDiff"].empty()) << diff.dump();
+    }
+}
+
+TEST_F(UmbrellaTest, HeaderThatFailsToCompileFailsTheUmbrella) {
+    std::string broken = (root / "include" / "broken.h").string();
+    writeFile(broken, "struct Broken { missing_t field; };\n");
+    armor::SinglePassSession session(nullptr);
+    EXPECT_EQ(parseUmbrella(session, {headerA, broken, headerB}), FATAL_ERRORS);
+}
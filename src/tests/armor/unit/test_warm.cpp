@@ -0,0 +1,108 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "comparator.hpp"
+#include "metrics.hpp"
+#include "warm.hpp"
+
+namespace {
+
+    void writeFile(const std::filesystem::path& path, const std::string& contents) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    size_t entryCount(const std::filesystem::path& dir) {
+        size_t count = 0;
+        if (std::filesystem::exists(dir)) {
+            for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+                count += entry.path().extension() == ".cbor";
+            }
+        }
+        return count;
+    }
+
+    // Disk tier hits of the context cache so far in this process
+    double diskHits() {
+        const std::string series = "armor_cache_lookups_total{tier=\"disk\",result=\"hit\"} ";
+        std::istringstream lines(armor::Metrics::getInstance().render());
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (line.compare(0, series.size(), series) == 0) {
+                return std::stod(line.substr(series.size()));
+            }
+        }
+        ADD_FAILURE() << "No disk hit series";
+        return -1;
+    }
+
+}
+
+class WarmTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+    std::string oldRoot;
+    std::string newRoot;
+    std::string cacheDir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_warm_test";
+        std::filesystem::remove_all(dir);
+        oldRoot = (dir / "old").string();
+        newRoot = (dir / "new").string();
+        cacheDir = (dir / "cache").string();
+        writeFile(dir / "old" / "include" / "foo.h", "struct foo_config { int size; };\nint foo(int value);\n");
+        writeFile(dir / "new" / "include" / "foo.h", "struct foo_config { long size; };\nint foo(int value);\n");
+        writeFile(dir / "old" / "include" / "bar.h", "void bar(void);\n");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    bool warm(std::vector<std::string> headers) {
+        std::string output = (dir / "out").string();
+        std::vector<const char*> argv = {"armor", "warm", "--cache-dir", cacheDir.c_str(),
+                                         "--output-dir", output.c_str(), oldRoot.c_str()};
+        for (const std::string& header : headers) {
+            argv.push_back(header.c_str());
+        }
+        return armor::runArmorWarm(static_cast<int>(argv.size()), argv.data());
+    }
+};
+
+TEST_F(WarmTest, FillsTheCacheForTheNextComparison) {
+    ASSERT_TRUE(warm({"include/foo.h"}));
+    EXPECT_EQ(entryCount(cacheDir), 1u);
+
+    armor::CompareOptions options;
+    options.cacheDir = cacheDir;
+    armor::Comparator comparator(options);
+    double hitsBefore = diskHits();
+    armor::CompareResult result = comparator.compare({oldRoot, newRoot, "include/foo.h", {}});
+    // The older version came from the entry warm stored; the newer was parsed
+    EXPECT_EQ(diskHits() - hitsBefore, 1);
+    EXPECT_EQ(result.outcome, armor::CompareOutcome::COMPARED);
+    EXPECT_FALSE(result.changes.empty());
+}
+
+TEST_F(WarmTest, WarmedHeadersAreOnlyValidatedAgain) {
+    ASSERT_TRUE(warm({}));
+    EXPECT_EQ(entryCount(cacheDir), 2u);
+
+    double hitsBefore = diskHits();
+    ASSERT_TRUE(warm({}));
+    EXPECT_EQ(diskHits() - hitsBefore, 2);
+    EXPECT_EQ(entryCount(cacheDir), 2u);
+}
+
+TEST_F(WarmTest, MissingHeaderFails) {
+    EXPECT_FALSE(warm({"include/missing.h"}));
+    EXPECT_EQ(entryCount(cacheDir), 0u);
+}
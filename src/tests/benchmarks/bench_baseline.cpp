@@ -0,0 +1,162 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "bench_baseline.hpp"
+
+namespace {
+
+    constexpr int BASELINE_FORMAT_VERSION = 1;
+
+    // `nanos` in the largest unit keeping it at or above 1, as the console reporter prints times
+    std::string formatTime(double nanos) {
+        static const char* const UNITS[] = {"ns", "us", "ms", "s"};
+        size_t unit = 0;
+        for (; unit < 3 && nanos >= 1000; ++unit) {
+            nanos /= 1000;
+        }
+        return llvm::formatv("{0:f2} {1}", nanos, UNITS[unit]).str();
+    }
+
+}
+
+void armor::bench::saveBaseline(const BenchmarkTimings& timings, const std::string& path) {
+    nlohmann::json benchmarks = nlohmann::json::object();
+    for (const auto& [name, timing] : timings) {
+        benchmarks[name] = {{"mean_ns", timing.meanNanos},
+                            {"stddev_ns", timing.stddevNanos},
+                            {"repetitions", timing.repetitions}};
+    }
+    std::ofstream out(path, std::ios::trunc);
+    out << nlohmann::json{{"format", BASELINE_FORMAT_VERSION}, {"benchmarks", std::move(benchmarks)}}.dump(2) << "\n";
+    if (!out) {
+        throw std::runtime_error("Failed to write benchmark baseline: " + path);
+    }
+}
+
+armor::bench::BenchmarkTimings armor::bench::loadBaseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open benchmark baseline: " + path);
+    }
+    BenchmarkTimings timings;
+    try {
+        nlohmann::json root = nlohmann::json::parse(in);
+        if (root.at("format").get<int>() != BASELINE_FORMAT_VERSION) {
+            throw std::runtime_error("unsupported format " + root.at("format").dump());
+        }
+        for (const auto& [name, entry] : root.at("benchmarks").items()) {
+            BenchmarkTiming& timing = timings[name];
+            timing.meanNanos = entry.at("mean_ns").get<double>();
+            timing.stddevNanos = entry.at("stddev_ns").get<double>();
+            timing.repetitions = entry.at("repetitions").get<unsigned>();
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Malformed benchmark baseline " + path + ": " + e.what());
+    }
+    return timings;
+}
+
+unsigned armor::bench::compareToBaseline(const BenchmarkTimings& baseline, const BenchmarkTimings& current,
+                                         const RegressionPolicy& policy) {
+    size_t nameWidth = 9;
+    for (const auto& entry : current) {
+        nameWidth = std::max(nameWidth, entry.first.size());
+    }
+
+    unsigned regressions = 0;
+    llvm::raw_ostream& OS = llvm::outs();
+    OS << "\n" << llvm::left_justify("benchmark", nameWidth) << llvm::right_justify("baseline", 14)
+       << llvm::right_justify("current", 14) << llvm::right_justify("delta", 10) << llvm::right_justify("allowed", 10)
+       << "\n";
+    for (const auto& [name, timing] : current) {
+        OS << llvm::left_justify(name, nameWidth);
+        auto it = baseline.find(name);
+        if (it == baseline.end() || it->second.meanNanos <= 0) {
+            OS << llvm::right_justify("-", 14) << llvm::right_justify(formatTime(timing.meanNanos), 14) << "  new\n";
+            continue;
+        }
+        const BenchmarkTiming& before = it->second;
+        double delta = (timing.meanNanos - before.meanNanos) / before.meanNanos;
+        // Standard deviation of the difference of the two means, relative to the baseline
+        double noise = std::sqrt(std::pow(before.stddevNanos, 2) / std::max(before.repetitions, 1u) +
+                                 std::pow(timing.stddevNanos, 2) / std::max(timing.repetitions, 1u)) / before.meanNanos;
+        double allowed = std::max(policy.threshold, policy.noiseSigmas * noise);
+        OS << llvm::right_justify(formatTime(before.meanNanos), 14) << llvm::right_justify(formatTime(timing.meanNanos), 14)
+           << llvm::format("%+9.1f%%%9.1f%%", delta * 100, allowed * 100);
+        if (delta > allowed) {
+            ++regressions;
+            OS << "  REGRESSED";
+        } else if (delta < -allowed) {
+            OS << "  improved";
+        }
+        OS << "\n";
+    }
+    for (const auto& entry : baseline) {
+        if (!current.count(entry.first)) {
+            OS << llvm::left_justify(entry.first, nameWidth) << llvm::right_justify(formatTime(entry.second.meanNanos), 14)
+               << llvm::right_justify("-", 14) << "  not run\n";
+        }
+    }
+    OS << regressions << " regression(s)\n";
+    OS.flush();
+    return regressions;
+}
+
+armor::bench::RecordingReporter::RecordingReporter(std::unique_ptr<benchmark::BenchmarkReporter> display)
+    : display(std::move(display)) {}
+
+bool armor::bench::RecordingReporter::ReportContext(const Context& context) {
+    return display->ReportContext(context);
+}
+
+void armor::bench::RecordingReporter::ReportRuns(const std::vector<Run>& runs) {
+    for (const Run& run : runs) {
+        if (run.skipped) {
+            continue;
+        }
+        double nanos = run.GetAdjustedRealTime() * 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+        if (run.run_type == Run::RT_Iteration) {
+            samples[run.run_name.str()].push_back(nanos);
+        } else if (run.aggregate_name == "mean" || run.aggregate_name == "stddev") {
+            // Only used when --benchmark_display_aggregates_only hides the repetitions
+            BenchmarkTiming& timing = aggregates[run.run_name.str()];
+            (run.aggregate_name == "mean" ? timing.meanNanos : timing.stddevNanos) = nanos;
+            timing.repetitions = static_cast<unsigned>(run.repetitions);
+        }
+    }
+    display->ReportRuns(runs);
+}
+
+void armor::bench::RecordingReporter::Finalize() {
+    display->Finalize();
+}
+
+armor::bench::BenchmarkTimings armor::bench::RecordingReporter::timings() const {
+    BenchmarkTimings timings = aggregates;
+    for (const auto& [name, values] : samples) {
+        BenchmarkTiming timing;
+        timing.repetitions = static_cast<unsigned>(values.size());
+        for (double value : values) {
+            timing.meanNanos += value;
+        }
+        timing.meanNanos /= static_cast<double>(values.size());
+        if (values.size() > 1) {
+            double squares = 0;
+            for (double value : values) {
+                squares += std::pow(value - timing.meanNanos, 2);
+            }
+            timing.stddevNanos = std::sqrt(squares / static_cast<double>(values.size() - 1));
+        }
+        timings[name] = timing;
+    }
+    return timings;
+}
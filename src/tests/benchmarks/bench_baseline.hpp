@@ -0,0 +1,86 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+namespace armor::bench {
+
+/**
+ * @brief Real time of one benchmark over its repetitions.
+ */
+struct BenchmarkTiming {
+    double meanNanos = 0;
+    double stddevNanos = 0;
+    unsigned repetitions = 0;
+};
+
+/**
+ * @brief Benchmark timings by name, as saved with --save_baseline:
+ *
+ *     { "format": 1, "benchmarks": { "BM_DiffTrees/1024": { "mean_ns": 1.5e6, "stddev_ns": 2e4, "repetitions": 5 } } }
+ */
+using BenchmarkTimings = std::map<std::string, BenchmarkTiming>;
+
+/**
+ * @brief Writes `timings` to `path`.
+ * @throws std::runtime_error if it cannot be written.
+ */
+void saveBaseline(const BenchmarkTimings& timings, const std::string& path);
+
+/**
+ * @brief Reads timings saved by saveBaseline.
+ * @throws std::runtime_error if the file cannot be read or is malformed.
+ */
+BenchmarkTimings loadBaseline(const std::string& path);
+
+/**
+ * @brief How far a benchmark may slow down before it counts as regressed.
+ *
+ * A benchmark regresses when its mean exceeds the baseline mean by more
+ * than `threshold` (relative) and by more than `noiseSigmas` standard
+ * deviations of the difference, so a noisy benchmark needs a larger slowdown
+ * than a steady one. Run with --benchmark_repetitions to measure the noise.
+ */
+struct RegressionPolicy {
+    double threshold = 0.05;
+    double noiseSigmas = 3;
+};
+
+/**
+ * @brief Prints a delta per benchmark of `current` against `baseline`.
+ * @return Number of benchmarks that regressed.
+ */
+unsigned compareToBaseline(const BenchmarkTimings& baseline, const BenchmarkTimings& current,
+                           const RegressionPolicy& policy);
+
+/**
+ * @class RecordingReporter
+ * @brief Forwards to the display reporter and records the real time of every run.
+ */
+class RecordingReporter : public benchmark::BenchmarkReporter {
+public:
+    explicit RecordingReporter(std::unique_ptr<benchmark::BenchmarkReporter> display);
+
+    bool ReportContext(const Context& context) override;
+    void ReportRuns(const std::vector<Run>& runs) override;
+    void Finalize() override;
+
+    /** @brief Mean and standard deviation of the runs of each benchmark that ran without error. */
+    BenchmarkTimings timings() const;
+
+private:
+    std::unique_ptr<benchmark::BenchmarkReporter> display;
+    // Real time of every repetition, by benchmark name
+    std::map<std::string, std::vector<double>> samples;
+    // Mean and stddev aggregates, by benchmark name
+    BenchmarkTimings aggregates;
+};
+
+}
@@ -0,0 +1,89 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ast_normalized_context.hpp"
+#include "diffengine.hpp"
+#include "synthetic_trees.hpp"
+
+namespace {
+
+    void runDiff(benchmark::State& state, double changeRate) {
+        armor::bench::SyntheticTreeOptions options;
+        options.nodeCount = static_cast<size_t>(state.range(0));
+        options.changeRate = changeRate;
+        beta::ASTNormalizedContext older;
+        beta::ASTNormalizedContext newer;
+        armor::bench::buildSyntheticContext(older, options, false);
+        armor::bench::buildSyntheticContext(newer, options, true);
+
+        size_t entries = 0;
+        for (auto _ : state) {
+            entries = 0;
+            nlohmann::json status = streamDiffTrees(&older, &newer, [&entries](nlohmann::json&& entry) {
+                benchmark::DoNotOptimize(entry);
+                ++entries;
+            });
+            benchmark::DoNotOptimize(status);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+        state.counters["entries"] = static_cast<double>(entries);
+    }
+
+    // Mostly unchanged trees: the fingerprints settle almost every struct at once
+    void BM_DiffTrees(benchmark::State& state) {
+        runDiff(state, 0.01);
+    }
+    BENCHMARK(BM_DiffTrees)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+    // Every struct carries changes, so every one is walked field by field
+    void BM_DiffTreesHeavyChurn(benchmark::State& state) {
+        runDiff(state, 0.5);
+    }
+    BENCHMARK(BM_DiffTreesHeavyChurn)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+    // The in-memory form, which also collects every entry into one JSON array
+    void BM_DiffTreesCollected(benchmark::State& state) {
+        armor::bench::SyntheticTreeOptions options;
+        options.nodeCount = static_cast<size_t>(state.range(0));
+        beta::ASTNormalizedContext older;
+        beta::ASTNormalizedContext newer;
+        armor::bench::buildSyntheticContext(older, options, false);
+        armor::bench::buildSyntheticContext(newer, options, true);
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(diffTrees(&older, &newer));
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_DiffTreesCollected)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+    // USR lookups as overloads are matched: Arg(0) in the build-time map, Arg(1) in the frozen index
+    void BM_UsrLookup(benchmark::State& state) {
+        armor::bench::SyntheticTreeOptions options;
+        options.nodeCount = 1 << 18;
+        options.freeze = state.range(0) != 0;
+        beta::ASTNormalizedContext context;
+        armor::bench::buildSyntheticContext(context, options, false);
+        std::vector<std::string> usrs;
+        context.forEachUSR([&usrs](llvm::StringRef usr, const beta::APINode*) { usrs.push_back(usr.str()); });
+        // Probe in an order unrelated to either layout, and miss as often as overloads do
+        for (size_t i = 0, n = usrs.size(); i < n; i += 2) {
+            usrs.push_back(usrs[i] + "#");
+        }
+        std::reverse(usrs.begin(), usrs.end());
+
+        for (auto _ : state) {
+            for (const std::string& usr : usrs) {
+                benchmark::DoNotOptimize(context.findNodeByUSR(usr));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * usrs.size()));
+    }
+    BENCHMARK(BM_UsrLookup)->Arg(0)->Arg(1);
+
+}
@@ -0,0 +1,149 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include "bench_fixtures.hpp"
+#include "clang_tool_runner.hpp"
+#include "compile_flags.hpp"
+#include "diffengine.hpp"
+#include "report_utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr const char* FIXTURE_HEADER = "mylib.h";
+
+    bool usesCArguments(const fs::path& fixtureDir) {
+        for (const auto& entry : fs::directory_iterator(fixtureDir)) {
+            if (entry.path().extension() != ".py") {
+                continue;
+            }
+            std::ifstream in(entry.path());
+            std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (text.find("binary_args_c") != std::string::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // What one header pair costs end to end, short of writing the reports
+    void runFixturePair(benchmark::State& state, const std::string& root1, const std::string& root2, LANG_OPTIONS lang) {
+        for (auto _ : state) {
+            beta::APISession session;
+            if (armor::bench::parseHeader(session, root1, FIXTURE_HEADER, lang) != NO_FATAL_ERRORS ||
+                armor::bench::parseHeader(session, root2, FIXTURE_HEADER, lang) != NO_FATAL_ERRORS) {
+                state.SkipWithError("fixture does not parse cleanly");
+                break;
+            }
+            ApiChangeGroups groups(FIXTURE_HEADER);
+            nlohmann::json status = streamDiffTrees(
+                session.getContext(root1 + "/" + FIXTURE_HEADER), session.getContext(root2 + "/" + FIXTURE_HEADER),
+                [&groups](nlohmann::json&& entry) { groups.addChange(entry); });
+            benchmark::DoNotOptimize(status);
+            benchmark::DoNotOptimize(groups);
+        }
+    }
+
+    struct FixtureVersion {
+        std::string root;
+        LANG_OPTIONS lang;
+    };
+
+    // Diff entries between `version` parsed with the full and the lean frontend
+    // profile; only a clean parse is promised to normalize the same
+    size_t profileDifferences(const FixtureVersion& version) {
+        beta::APISession full;
+        beta::APISession lean;
+        armor::setLeanFrontend(false);
+        PARSING_STATUS fullStatus = armor::bench::parseHeader(full, version.root, FIXTURE_HEADER, version.lang);
+        armor::setLeanFrontend(true);
+        PARSING_STATUS leanStatus = armor::bench::parseHeader(lean, version.root, FIXTURE_HEADER, version.lang);
+        armor::setLeanFrontend(false);
+        if (fullStatus != NO_FATAL_ERRORS) {
+            return 0;
+        }
+        if (leanStatus != NO_FATAL_ERRORS) {
+            return 1;
+        }
+        std::string file = version.root + "/" + FIXTURE_HEADER;
+        size_t entries = 0;
+        streamDiffTrees(full.getContext(file), lean.getContext(file), [&entries](nlohmann::json&&) { ++entries; });
+        return entries;
+    }
+
+    // Parses every fixture version with the profile of range(0), 1 being lean,
+    // once both profiles were checked to normalize every version the same
+    void runFrontendProfile(benchmark::State& state, const std::vector<FixtureVersion>& versions) {
+        bool lean = state.range(0) != 0;
+        for (const FixtureVersion& version : versions) {
+            if (profileDifferences(version) != 0) {
+                state.SkipWithError(("lean profile normalizes " + version.root + " differently").c_str());
+                return;
+            }
+        }
+        armor::setLeanFrontend(lean);
+        for (auto _ : state) {
+            for (const FixtureVersion& version : versions) {
+                beta::APISession session;
+                benchmark::DoNotOptimize(armor::bench::parseHeader(session, version.root, FIXTURE_HEADER, version.lang));
+            }
+        }
+        armor::setLeanFrontend(false);
+        state.SetLabel(lean ? "lean" : "full");
+        state.counters["headers"] = static_cast<double>(versions.size());
+    }
+
+}
+
+PARSING_STATUS armor::bench::parseHeader(beta::APISession& session, const std::string& projectRoot,
+                                        const std::string& header, LANG_OPTIONS lang) {
+    std::string file = projectRoot + "/" + header;
+    std::vector<std::string> flags = armor::buildCompileFlags(projectRoot, file, {}, {}, lang);
+    return session.processFile(file, std::make_unique<clang::tooling::FixedCompilationDatabase>(projectRoot, flags));
+}
+
+unsigned armor::bench::registerFixtureBenchmarks(const std::string& fixturesDir) {
+    std::error_code ec;
+    if (!fs::is_directory(fixturesDir, ec)) {
+        return 0;
+    }
+
+    std::vector<fs::path> fixtures;
+    for (const auto& entry : fs::directory_iterator(fixturesDir)) {
+        if (fs::exists(entry.path() / "v1" / FIXTURE_HEADER) && fs::exists(entry.path() / "v2" / FIXTURE_HEADER)) {
+            fixtures.push_back(entry.path());
+        }
+    }
+    // directory_iterator order is unspecified; keep runs comparable
+    std::sort(fixtures.begin(), fixtures.end());
+
+    std::vector<FixtureVersion> versions;
+    for (const fs::path& fixture : fixtures) {
+        std::string root1 = (fixture / "v1").string();
+        std::string root2 = (fixture / "v2").string();
+        LANG_OPTIONS lang = usesCArguments(fixture) ? LANG_OPTIONS::C : LANG_OPTIONS::CPP;
+        versions.push_back({root1, lang});
+        versions.push_back({root2, lang});
+        std::string name = "BM_FixturePair/" + fixture.filename().string();
+        benchmark::RegisterBenchmark(name.c_str(), [root1, root2, lang](benchmark::State& state) {
+            runFixturePair(state, root1, root2, lang);
+        })->Unit(benchmark::kMillisecond);
+    }
+    if (!versions.empty()) {
+        benchmark::RegisterBenchmark("BM_FrontendProfile", [versions](benchmark::State& state) {
+            runFrontendProfile(state, versions);
+        })->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+    }
+    return static_cast<unsigned>(fixtures.size());
+}
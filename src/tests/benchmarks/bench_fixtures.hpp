@@ -0,0 +1,34 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+#include "comm_def.hpp"
+#include "session.hpp"
+
+namespace armor::bench {
+
+/**
+ * @brief Parses `projectRoot`/`header` into `session` with the flags armor would use.
+ *
+ * The context is then available as session.getContext(projectRoot + "/" + header).
+ */
+PARSING_STATUS parseHeader(beta::APISession& session, const std::string& projectRoot,
+                           const std::string& header, LANG_OPTIONS lang);
+
+/**
+ * @brief Registers a parse + diff + group benchmark per functional fixture under `fixturesDir`.
+ *
+ * Every subdirectory holding v1/mylib.h and v2/mylib.h becomes
+ * BM_FixturePair/<name>. Fixtures whose pytest uses the C arguments
+ * (binary_args_c) are parsed as C, the others as C++. BM_FrontendProfile
+ * parses every version with the full (0) and the lean (1) frontend profile
+ * (see setLeanFrontend), after checking that both normalize every cleanly
+ * parsing version the same.
+ *
+ * @return Number of fixtures registered.
+ */
+unsigned registerFixtureBenchmarks(const std::string& fixturesDir);
+
+}
@@ -0,0 +1,81 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "bench_growth.hpp"
+
+namespace {
+
+    // Least squares slope of log(time) over log(size)
+    double growthExponent(const std::vector<std::pair<double, double>>& sizeTimes) {
+        double meanX = 0;
+        double meanY = 0;
+        for (const auto& [size, nanos] : sizeTimes) {
+            meanX += std::log(size);
+            meanY += std::log(nanos);
+        }
+        meanX /= static_cast<double>(sizeTimes.size());
+        meanY /= static_cast<double>(sizeTimes.size());
+        double covariance = 0;
+        double variance = 0;
+        for (const auto& [size, nanos] : sizeTimes) {
+            covariance += (std::log(size) - meanX) * (std::log(nanos) - meanY);
+            variance += std::pow(std::log(size) - meanX, 2);
+        }
+        return variance > 0 ? covariance / variance : 0;
+    }
+
+}
+
+unsigned armor::bench::checkGrowth(const BenchmarkTimings& timings, const std::string& prefix,
+                                   const GrowthPolicy& policy) {
+    std::map<std::string, std::vector<std::pair<double, double>>> families;
+    for (const auto& [name, timing] : timings) {
+        llvm::StringRef ref(name);
+        auto [family, size] = ref.rsplit('/');
+        unsigned long long value = 0;
+        if (!ref.startswith(prefix) || size.empty() || size.getAsInteger(10, value) || value == 0 ||
+            timing.meanNanos <= 0) {
+            continue;
+        }
+        families[family.str()].emplace_back(static_cast<double>(value), timing.meanNanos);
+    }
+    for (auto it = families.begin(); it != families.end();) {
+        it = it->second.size() < 2 ? families.erase(it) : std::next(it);
+    }
+    if (families.empty()) {
+        return 0;
+    }
+
+    size_t nameWidth = 6;
+    for (const auto& entry : families) {
+        nameWidth = std::max(nameWidth, entry.first.size());
+    }
+
+    unsigned superLinear = 0;
+    llvm::raw_ostream& OS = llvm::outs();
+    OS << "\n" << llvm::left_justify("family", nameWidth) << llvm::right_justify("sizes", 7)
+       << llvm::right_justify("exponent", 10) << llvm::right_justify("allowed", 9) << "\n";
+    for (const auto& [family, sizeTimes] : families) {
+        double exponent = growthExponent(sizeTimes);
+        OS << llvm::left_justify(family, nameWidth) << llvm::format("%7zu%10.2f%9.2f", sizeTimes.size(), exponent,
+                                                                      policy.maxExponent);
+        if (exponent > policy.maxExponent) {
+            ++superLinear;
+            OS << "  SUPER-LINEAR";
+        }
+        OS << "\n";
+    }
+    OS << superLinear << " super-linear famil" << (superLinear == 1 ? "y" : "ies") << "\n";
+    OS.flush();
+    return superLinear;
+}
@@ -0,0 +1,34 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <string>
+
+#include "bench_baseline.hpp"
+
+namespace armor::bench {
+
+/**
+ * @brief How fast a benchmark may grow with its input before it counts as super-linear.
+ *
+ * The exponent is the slope of log(time) over log(size), fitted over every
+ * size a benchmark ran at: 1 for linear growth, 2 for quadratic. The
+ * default leaves room for noise and for the cache misses of larger inputs.
+ */
+struct GrowthPolicy {
+    double maxExponent = 1.3;
+};
+
+/**
+ * @brief Prints the growth exponent of every benchmark family named `prefix`*.
+ *
+ * A family is every benchmark whose name differs only in its last
+ * component, the size: BM_StressDiff/overloads/1 to BM_StressDiff/overloads/8.
+ * Families that ran at fewer than two sizes are skipped; nothing is
+ * printed if no family is left.
+ *
+ * @return Number of families that grew faster than policy.maxExponent.
+ */
+unsigned checkGrowth(const BenchmarkTimings& timings, const std::string& prefix, const GrowthPolicy& policy);
+
+}
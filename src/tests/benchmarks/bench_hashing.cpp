@@ -0,0 +1,116 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "clang/Basic/SourceManager.h"
+
+#include "fibonacci_hash.hpp"
+#include "simd_dispatch.hpp"
+#include "source_hash_index.hpp"
+
+namespace {
+
+    // Header-like text: declarations, comments and indentation, `size` bytes long
+    std::string makeSource(size_t size) {
+        static const char* const lines[] = {
+            "namespace api {\n",
+            "    /* Returns the number of widgets. */\n",
+            "    int widgetCount(const char* name, unsigned flags = 0);\n",
+            "    struct Widget { int id; double weight; }; // plain data\n",
+            "    static const char* kName = \"widget /* not a comment */\";\n",
+            "}\n",
+        };
+        std::string source;
+        source.reserve(size);
+        for (size_t i = 0; source.size() < size; ++i) {
+            source += lines[i % (sizeof(lines) / sizeof(lines[0]))];
+        }
+        source.resize(size);
+        return source;
+    }
+
+    void BM_FibonacciHash(benchmark::State& state) {
+        std::string text = makeSource(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(FibonacciHash::hash(text));
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_FibonacciHash)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+    void BM_HashNormalizedSource(benchmark::State& state) {
+        std::string text = makeSource(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(
+                FibonacciHash::hashNormalizedSource(text, 0, static_cast<unsigned>(text.size())));
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_HashNormalizedSource)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+    // The same hash on each byte-scanner kernel (--simd); those the CPU lacks are skipped
+    void BM_HashNormalizedSourceKernel(benchmark::State& state) {
+        auto kernel = static_cast<armor::simd::Kernel>(state.range(0));
+        armor::simd::Kernel previous = armor::simd::activeKernel();
+        if (!armor::simd::setKernel(kernel)) {
+            state.SkipWithError("kernel not supported on this CPU");
+            return;
+        }
+        state.SetLabel(armor::simd::kernelName(kernel));
+        std::string text = makeSource(static_cast<size_t>(state.range(1)));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(
+                FibonacciHash::hashNormalizedSource(text, 0, static_cast<unsigned>(text.size())));
+        }
+        armor::simd::setKernel(previous);
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(1));
+    }
+    BENCHMARK(BM_HashNormalizedSourceKernel)
+        ->ArgsProduct({{static_cast<int64_t>(armor::simd::Kernel::SCALAR), static_cast<int64_t>(armor::simd::Kernel::SSE2),
+                        static_cast<int64_t>(armor::simd::Kernel::AVX2), static_cast<int64_t>(armor::simd::Kernel::NEON)},
+                       {1 << 12, 1 << 18}});
+
+    // One declaration-sized range of a 256 KiB main file per iteration, as TreeBuilder hashes them
+    void BM_HashFromOffsets(benchmark::State& state) {
+        std::string text = makeSource(1 << 18);
+        clang::SourceManagerForFile file("bench.h", text);
+        clang::SourceManager& SM = file.get();
+        const unsigned rangeSize = static_cast<unsigned>(state.range(0));
+        unsigned start = 0;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(FibonacciHash::hashFromOffsets(&SM, start, start + rangeSize));
+            start = (start + 4099) % static_cast<unsigned>(text.size() - rangeSize);
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_HashFromOffsets)->RangeMultiplier(8)->Range(64, 1 << 12);
+
+    void BM_SourceHashIndexRange(benchmark::State& state) {
+        std::string text = makeSource(1 << 18);
+        SourceHashIndex index(text);
+        const unsigned rangeSize = static_cast<unsigned>(state.range(0));
+        unsigned start = 0;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(index.hash(start, start + rangeSize, SourceHashIndex::Normalization::Source));
+            start = (start + 4099) % static_cast<unsigned>(text.size() - rangeSize);
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_SourceHashIndexRange)->RangeMultiplier(8)->Range(64, 1 << 12);
+
+    // Building both prefix tables is the one pass over the file the range hashes rely on
+    void BM_SourceHashIndexBuild(benchmark::State& state) {
+        std::string text = makeSource(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            SourceHashIndex index(text);
+            benchmark::DoNotOptimize(index.hash(0, static_cast<unsigned>(text.size()),
+                                                SourceHashIndex::Normalization::Source));
+            benchmark::DoNotOptimize(index.hash(0, static_cast<unsigned>(text.size()),
+                                                SourceHashIndex::Normalization::Whitespace));
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_SourceHashIndexBuild)->RangeMultiplier(8)->Range(1 << 12, 1 << 21);
+
+}
@@ -0,0 +1,30 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstdint>
+
+namespace armor::bench {
+
+/**
+ * @brief splitmix64 finaliser.
+ */
+inline uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Uniform value in [0, 1) fixed by (`seed`, `key`).
+ *
+ * Inputs are generated from independent rolls rather than one sequential
+ * engine, so both versions of a tree or header agree on every decision
+ * whatever the other decisions were.
+ */
+inline double roll(uint64_t seed, uint64_t key) {
+    return static_cast<double>(mix(seed ^ mix(key)) >> 11) / static_cast<double>(1ULL << 53);
+}
+
+}
@@ -0,0 +1,92 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "ast_normalized_context.hpp"
+#include "diff_utils.hpp"
+#include "diffengine.hpp"
+#include "report_utils.hpp"
+#include "synthetic_trees.hpp"
+
+namespace {
+
+    // The "astDiff" array of two synthetic versions: a few thousand entries at 1M nodes
+    nlohmann::json makeDiffArray(size_t nodeCount) {
+        armor::bench::SyntheticTreeOptions options;
+        options.nodeCount = nodeCount;
+        options.changeRate = 0.05;
+        beta::ASTNormalizedContext older;
+        beta::ASTNormalizedContext newer;
+        armor::bench::buildSyntheticContext(older, options, false);
+        armor::bench::buildSyntheticContext(newer, options, true);
+        return diffTrees(&older, &newer)[AST_DIFF];
+    }
+
+    std::string reportPath(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void BM_PreprocessApiChanges(benchmark::State& state) {
+        nlohmann::json diff = makeDiffArray(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(preprocess_api_changes(diff, "include/bench.h"));
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * diff.size()));
+        state.counters["entries"] = static_cast<double>(diff.size());
+    }
+    BENCHMARK(BM_PreprocessApiChanges)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+    // The streaming grouping reportHeaderPairBeta uses instead
+    void BM_ApiChangeGroups(benchmark::State& state) {
+        nlohmann::json diff = makeDiffArray(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            ApiChangeGroups groups("include/bench.h");
+            for (const auto& change : diff) {
+                groups.addChange(change);
+            }
+            benchmark::DoNotOptimize(groups);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * diff.size()));
+    }
+    BENCHMARK(BM_ApiChangeGroups)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+    void BM_GenerateHtmlReport(benchmark::State& state) {
+        nlohmann::json diff = makeDiffArray(static_cast<size_t>(state.range(0)));
+        ApiChangeGroups groups("include/bench.h");
+        for (const auto& change : diff) {
+            groups.addChange(change);
+        }
+        std::string path = reportPath("armor_bench_report.html");
+        for (auto _ : state) {
+            generate_html_report(groups, path, BETA_PARSER,
+                                 static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                                 static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                                 "backward_incompatible", "BACKWARD_INCOMPATIBLE", "benchmark");
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::filesystem::file_size(path)));
+        std::filesystem::remove(path);
+    }
+    BENCHMARK(BM_GenerateHtmlReport)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+    void BM_GenerateJsonReport(benchmark::State& state) {
+        nlohmann::json diff = makeDiffArray(static_cast<size_t>(state.range(0)));
+        ApiChangeGroups groups("include/bench.h");
+        for (const auto& change : diff) {
+            groups.addChange(change);
+        }
+        std::string path = reportPath("armor_bench_report.json");
+        for (auto _ : state) {
+            generate_json_report(groups, path,
+                                 static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                                 static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                                 "backward_incompatible", "BACKWARD_INCOMPATIBLE", "benchmark");
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::filesystem::file_size(path)));
+        std::filesystem::remove(path);
+    }
+    BENCHMARK(BM_GenerateJsonReport)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+}
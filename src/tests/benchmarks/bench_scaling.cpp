@@ -0,0 +1,161 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench_fixtures.hpp"
+#include "diff_utils.hpp"
+#include "diffengine.hpp"
+#include "header_generator.hpp"
+#include "report_utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr const char* GENERATED_HEADER = "mylib.h";
+
+    // A generated pair of `declCount` declarations, written once per run
+    struct GeneratedPair {
+        std::string root1;
+        std::string root2;
+        size_t lines = 0;
+    };
+
+    const GeneratedPair& generatedPair(size_t declCount) {
+        static std::map<size_t, GeneratedPair> pairs;
+        auto it = pairs.find(declCount);
+        if (it != pairs.end()) {
+            return it->second;
+        }
+
+        armor::bench::HeaderGeneratorOptions options;
+        options.declCount = declCount;
+        fs::path dir = fs::temp_directory_path() / "armor_bench_scaling" / std::to_string(declCount);
+        armor::bench::writeHeaderPair(options, dir.string(), GENERATED_HEADER);
+
+        GeneratedPair pair;
+        pair.root1 = (dir / "v1").string();
+        pair.root2 = (dir / "v2").string();
+        std::ifstream in(dir / "v1" / GENERATED_HEADER);
+        pair.lines = static_cast<size_t>(
+            std::count(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(), '\n'));
+        return pairs.emplace(declCount, std::move(pair)).first->second;
+    }
+
+    bool parsePair(benchmark::State& state, beta::APISession& session, const GeneratedPair& pair) {
+        if (armor::bench::parseHeader(session, pair.root1, GENERATED_HEADER, CPP) != NO_FATAL_ERRORS ||
+            armor::bench::parseHeader(session, pair.root2, GENERATED_HEADER, CPP) != NO_FATAL_ERRORS) {
+            state.SkipWithError("generated header does not parse cleanly");
+            return false;
+        }
+        return true;
+    }
+
+    beta::ASTNormalizedContext* context(const beta::APISession& session, const std::string& root) {
+        return session.getContext(root + "/" + GENERATED_HEADER);
+    }
+
+    // Parse and normalize: the TreeBuilder share of a header pair
+    void BM_ScalingTreeBuilder(benchmark::State& state) {
+        const GeneratedPair& pair = generatedPair(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            beta::APISession session;
+            if (armor::bench::parseHeader(session, pair.root1, GENERATED_HEADER, CPP) != NO_FATAL_ERRORS) {
+                state.SkipWithError("generated header does not parse cleanly");
+                break;
+            }
+            benchmark::DoNotOptimize(context(session, pair.root1));
+        }
+        state.counters["lines"] = static_cast<double>(pair.lines);
+        state.counters["lines/s"] = benchmark::Counter(static_cast<double>(pair.lines * state.iterations()),
+                                                       benchmark::Counter::kIsRate);
+    }
+    BENCHMARK(BM_ScalingTreeBuilder)->RangeMultiplier(4)->Range(1 << 8, 1 << 14)->Unit(benchmark::kMillisecond);
+
+    void BM_ScalingDiffTrees(benchmark::State& state) {
+        const GeneratedPair& pair = generatedPair(static_cast<size_t>(state.range(0)));
+        beta::APISession session;
+        if (!parsePair(state, session, pair)) {
+            return;
+        }
+        size_t entries = 0;
+        for (auto _ : state) {
+            entries = 0;
+            nlohmann::json status = streamDiffTrees(context(session, pair.root1), context(session, pair.root2),
+                                                    [&entries](nlohmann::json&&) { ++entries; });
+            benchmark::DoNotOptimize(status);
+        }
+        state.counters["lines"] = static_cast<double>(pair.lines);
+        state.counters["entries"] = static_cast<double>(entries);
+    }
+    BENCHMARK(BM_ScalingDiffTrees)->RangeMultiplier(4)->Range(1 << 8, 1 << 14)->Unit(benchmark::kMillisecond);
+
+    // Grouping plus both report writers, from an already computed diff
+    void BM_ScalingReport(benchmark::State& state) {
+        const GeneratedPair& pair = generatedPair(static_cast<size_t>(state.range(0)));
+        beta::APISession session;
+        if (!parsePair(state, session, pair)) {
+            return;
+        }
+        nlohmann::json diff = diffTrees(context(session, pair.root1), context(session, pair.root2))[AST_DIFF];
+
+        std::string htmlPath = (fs::temp_directory_path() / "armor_bench_scaling.html").string();
+        std::string jsonPath = (fs::temp_directory_path() / "armor_bench_scaling.json").string();
+        for (auto _ : state) {
+            ApiChangeGroups groups(GENERATED_HEADER);
+            for (const auto& change : diff) {
+                groups.addChange(change);
+            }
+            generate_html_report(groups, htmlPath, BETA_PARSER,
+                                 static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                                 static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                                 "backward_incompatible", "BACKWARD_INCOMPATIBLE", "benchmark");
+            generate_json_report(groups, jsonPath,
+                                 static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                                 static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                                 "backward_incompatible", "BACKWARD_INCOMPATIBLE", "benchmark");
+        }
+        state.counters["lines"] = static_cast<double>(pair.lines);
+        state.counters["entries"] = static_cast<double>(diff.size());
+        fs::remove(htmlPath);
+        fs::remove(jsonPath);
+    }
+    BENCHMARK(BM_ScalingReport)->RangeMultiplier(4)->Range(1 << 8, 1 << 14)->Unit(benchmark::kMillisecond);
+
+    // A header pair end to end, as armor compares it: both parses, the diff and both reports
+    void BM_ScalingEndToEnd(benchmark::State& state) {
+        const GeneratedPair& pair = generatedPair(static_cast<size_t>(state.range(0)));
+        std::string htmlPath = (fs::temp_directory_path() / "armor_bench_end_to_end.html").string();
+        std::string jsonPath = (fs::temp_directory_path() / "armor_bench_end_to_end.json").string();
+        for (auto _ : state) {
+            beta::APISession session;
+            if (!parsePair(state, session, pair)) {
+                break;
+            }
+            ApiChangeGroups groups(GENERATED_HEADER);
+            nlohmann::json status = streamDiffTrees(context(session, pair.root1), context(session, pair.root2),
+                                                    [&groups](nlohmann::json&& entry) { groups.addChange(entry); });
+            benchmark::DoNotOptimize(status);
+            generate_html_report(groups, htmlPath, BETA_PARSER,
+                                 static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                                 static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                                 "backward_incompatible", "BACKWARD_INCOMPATIBLE", "benchmark");
+            generate_json_report(groups, jsonPath,
+                                 static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                                 static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                                 "backward_incompatible", "BACKWARD_INCOMPATIBLE", "benchmark");
+        }
+        state.counters["lines"] = static_cast<double>(pair.lines);
+        fs::remove(htmlPath);
+        fs::remove(jsonPath);
+    }
+    BENCHMARK(BM_ScalingEndToEnd)->RangeMultiplier(4)->Range(1 << 8, 1 << 14)->Unit(benchmark::kMillisecond);
+
+}
@@ -0,0 +1,78 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "options_handler.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // Two project roots holding `headerCount` identical headers under include/
+    fs::path identicalRoots(size_t headerCount) {
+        fs::path dir = fs::temp_directory_path() / "armor_bench_startup" / std::to_string(headerCount);
+        if (fs::exists(dir)) {
+            return dir;
+        }
+        for (const char* version : {"v1", "v2"}) {
+            fs::create_directories(dir / version / "include");
+            for (size_t i = 0; i < headerCount; ++i) {
+                std::ofstream(dir / version / "include" / ("api" + std::to_string(i) + ".h"))
+                    << "#pragma once\nint api" << i << "(int value);\n";
+            }
+        }
+        return dir;
+    }
+
+    // Sends stdout, where armor lists the headers it compares, to /dev/null while in scope
+    class SilencedStdout {
+    public:
+        SilencedStdout() : saved(::dup(STDOUT_FILENO)) {
+            int null = ::open("/dev/null", O_WRONLY);
+            ::dup2(null, STDOUT_FILENO);
+            ::close(null);
+        }
+
+        ~SilencedStdout() {
+            ::dup2(saved, STDOUT_FILENO);
+            ::close(saved);
+        }
+
+    private:
+        int saved;
+    };
+
+    // A run over unchanged headers, as a pre-commit hook makes it: no parse, no
+    // log and no report, only the command line, the byte comparisons and the
+    // digest manifest. It should stay within a few milliseconds
+    void BM_StartupNoChange(benchmark::State& state) {
+        fs::path dir = identicalRoots(static_cast<size_t>(state.range(0)));
+        std::string root1 = (dir / "v1").string();
+        std::string root2 = (dir / "v2").string();
+        std::string outputDir = (dir / "out").string();
+        std::vector<const char*> args{"armor", root1.c_str(), root2.c_str(), "--header-dir", "include",
+                                      "--output-dir", outputDir.c_str()};
+        bool succeeded = true;
+        {
+            SilencedStdout silenced;
+            for (auto _ : state) {
+                succeeded &= runArmorTool(static_cast<int>(args.size()), args.data());
+            }
+        }
+        if (!succeeded) {
+            state.SkipWithError("run over unchanged headers failed");
+        }
+        else if (fs::exists(fs::path(outputDir) / "debug_output" / "logs")) {
+            state.SkipWithError("run over unchanged headers created the diagnostics log");
+        }
+        state.counters["headers"] = static_cast<double>(state.range(0));
+    }
+    BENCHMARK(BM_StartupNoChange)->Arg(1)->Arg(64)->Unit(benchmark::kMillisecond);
+
+}
@@ -0,0 +1,110 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "bench_fixtures.hpp"
+#include "diff_utils.hpp"
+#include "diffengine.hpp"
+#include "report_utils.hpp"
+#include "stress_corpus.hpp"
+
+namespace fs = std::filesystem;
+
+using armor::bench::StressShape;
+
+namespace {
+
+    constexpr const char* STRESS_HEADER = "mylib.h";
+
+    // A stress pair of `shape` at `scale`, written once per run
+    struct StressPair {
+        std::string root1;
+        std::string root2;
+    };
+
+    const StressPair& stressPair(StressShape shape, size_t scale) {
+        static std::map<std::pair<StressShape, size_t>, StressPair> pairs;
+        auto it = pairs.find({shape, scale});
+        if (it != pairs.end()) {
+            return it->second;
+        }
+
+        fs::path dir = fs::temp_directory_path() / "armor_bench_stress" / armor::bench::stressShapeName(shape) /
+                       std::to_string(scale);
+        armor::bench::writeStressPair(shape, scale, dir.string(), STRESS_HEADER);
+        StressPair pair{(dir / "v1").string(), (dir / "v2").string()};
+        return pairs.emplace(std::make_pair(shape, scale), std::move(pair)).first->second;
+    }
+
+    bool parsePair(benchmark::State& state, beta::APISession& session, const StressPair& pair) {
+        if (armor::bench::parseHeader(session, pair.root1, STRESS_HEADER, CPP) != NO_FATAL_ERRORS ||
+            armor::bench::parseHeader(session, pair.root2, STRESS_HEADER, CPP) != NO_FATAL_ERRORS) {
+            state.SkipWithError("stress header does not parse cleanly");
+            return false;
+        }
+        return true;
+    }
+
+    beta::ASTNormalizedContext* context(const beta::APISession& session, const std::string& root) {
+        return session.getContext(root + "/" + STRESS_HEADER);
+    }
+
+    // Parse and normalize one version, directive range folding included
+    void BM_StressParse(benchmark::State& state, StressShape shape) {
+        const StressPair& pair = stressPair(shape, static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            beta::APISession session;
+            if (armor::bench::parseHeader(session, pair.root1, STRESS_HEADER, CPP) != NO_FATAL_ERRORS) {
+                state.SkipWithError("stress header does not parse cleanly");
+                break;
+            }
+            benchmark::DoNotOptimize(context(session, pair.root1));
+        }
+    }
+
+    void BM_StressDiff(benchmark::State& state, StressShape shape) {
+        const StressPair& pair = stressPair(shape, static_cast<size_t>(state.range(0)));
+        beta::APISession session;
+        if (!parsePair(state, session, pair)) {
+            return;
+        }
+        nlohmann::json diff;
+        for (auto _ : state) {
+            diff = diffTrees(context(session, pair.root1), context(session, pair.root2));
+            benchmark::DoNotOptimize(diff);
+        }
+        state.counters["entries"] = static_cast<double>(diff[AST_DIFF].size());
+    }
+
+    void BM_StressPreprocess(benchmark::State& state, StressShape shape) {
+        const StressPair& pair = stressPair(shape, static_cast<size_t>(state.range(0)));
+        beta::APISession session;
+        if (!parsePair(state, session, pair)) {
+            return;
+        }
+        nlohmann::json diff = diffTrees(context(session, pair.root1), context(session, pair.root2))[AST_DIFF];
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(preprocess_api_changes(diff, STRESS_HEADER));
+        }
+        state.counters["entries"] = static_cast<double>(diff.size());
+    }
+
+    // Scales 1x to 8x of every shape; main fails the run if one grows super-linearly, see checkGrowth
+    BENCHMARK_CAPTURE(BM_StressParse, overloads, StressShape::OVERLOADS)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressParse, huge_enum, StressShape::HUGE_ENUM)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressParse, nested_namespaces, StressShape::NESTED_NAMESPACES)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressParse, inactive_blocks, StressShape::INACTIVE_BLOCKS)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressDiff, overloads, StressShape::OVERLOADS)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressDiff, huge_enum, StressShape::HUGE_ENUM)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressDiff, nested_namespaces, StressShape::NESTED_NAMESPACES)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressDiff, inactive_blocks, StressShape::INACTIVE_BLOCKS)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressPreprocess, overloads, StressShape::OVERLOADS)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressPreprocess, huge_enum, StressShape::HUGE_ENUM)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressPreprocess, nested_namespaces, StressShape::NESTED_NAMESPACES)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(BM_StressPreprocess, inactive_blocks, StressShape::INACTIVE_BLOCKS)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond);
+
+}
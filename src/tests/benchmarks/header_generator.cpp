@@ -0,0 +1,225 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "bench_random.hpp"
+#include "header_generator.hpp"
+
+namespace {
+
+    using armor::bench::HeaderGeneratorOptions;
+
+    const char* const TYPES[] = {"int", "unsigned", "double", "const char*", "long long", "float", "bool", "short"};
+    constexpr unsigned TYPE_COUNT = sizeof(TYPES) / sizeof(TYPES[0]);
+
+    // Independent decisions taken for every declaration
+    enum Roll : uint64_t { KIND, TEMPLATE, CHANGED, MUTATION, TARGET, ADDED, ROLL_COUNT };
+
+    enum class DeclKind { STRUCT, ENUM, FUNCTIONS, ALIAS };
+
+    enum class Mutation { RETYPE, EXTEND, REMOVE };
+
+    struct Decl {
+        size_t index;
+        DeclKind kind;
+        bool isTemplate;
+        bool changed;
+        Mutation mutation;
+        // Member, enumerator or overload the mutation applies to
+        unsigned target;
+        bool addedAfter;
+    };
+
+    double rollFor(const HeaderGeneratorOptions& options, size_t index, Roll purpose) {
+        return armor::bench::roll(options.seed, index * ROLL_COUNT + purpose);
+    }
+
+    Decl describe(const HeaderGeneratorOptions& options, size_t index) {
+        Decl decl;
+        decl.index = index;
+
+        // Roughly the mix of a large SDK header: records and overloads dominate
+        double kind = rollFor(options, index, KIND);
+        decl.kind = kind < 0.4 ? DeclKind::STRUCT : kind < 0.55 ? DeclKind::ENUM
+                                                  : kind < 0.9 ? DeclKind::FUNCTIONS : DeclKind::ALIAS;
+        decl.isTemplate = (decl.kind == DeclKind::STRUCT || decl.kind == DeclKind::FUNCTIONS) &&
+                          rollFor(options, index, TEMPLATE) < options.templateRatio;
+
+        decl.changed = rollFor(options, index, CHANGED) < options.changeRate;
+        double mutation = rollFor(options, index, MUTATION);
+        decl.mutation = mutation < 0.6 ? Mutation::RETYPE : mutation < 0.9 ? Mutation::EXTEND : Mutation::REMOVE;
+
+        unsigned width = decl.kind == DeclKind::STRUCT ? options.fieldsPerStruct
+                         : decl.kind == DeclKind::ENUM ? options.enumSize
+                         : decl.kind == DeclKind::FUNCTIONS ? options.overloadsPerFunction : 1;
+        decl.target = width == 0 ? 0 : static_cast<unsigned>(rollFor(options, index, TARGET) * width);
+        if (decl.isTemplate && decl.target == 0 && width > 1) {
+            // Slot 0 of a template is spelled T in both versions
+            decl.target = 1;
+        }
+        decl.addedAfter = rollFor(options, index, ADDED) < options.changeRate / 4;
+        return decl;
+    }
+
+    const char* typeAt(size_t index, unsigned slot) {
+        return TYPES[(index + slot) % TYPE_COUNT];
+    }
+
+    // The type the newer version gives a retyped slot
+    const char* retyped(size_t index, unsigned slot) {
+        return TYPES[(index + slot + 1) % TYPE_COUNT];
+    }
+
+    void emitStruct(std::string& out, const HeaderGeneratorOptions& options, const Decl& decl, bool newer,
+                    const std::string& indent) {
+        std::string name = "S" + std::to_string(decl.index);
+        bool mutated = newer && decl.changed;
+
+        out += indent + "/** Record " + name + ". */\n";
+        if (decl.isTemplate) {
+            out += indent + "template <typename T, int N = 4>\n";
+        }
+        out += indent + "struct " + name + " {\n";
+        for (unsigned f = 0; f < options.fieldsPerStruct; ++f) {
+            std::string type = decl.isTemplate && f == 0 ? "T"
+                               : mutated && decl.mutation == Mutation::RETYPE && f == decl.target
+                                   ? retyped(decl.index, f) : typeAt(decl.index, f);
+            out += indent + "    " + type + " field" + std::to_string(f) + ";\n";
+        }
+        if (mutated && decl.mutation == Mutation::EXTEND) {
+            out += indent + "    int extra;\n";
+        }
+        if (decl.isTemplate) {
+            out += indent + "    T values[N];\n";
+        }
+        out += indent + "    int get() const;\n";
+        out += indent + "    void set(" + std::string(typeAt(decl.index, 0)) + " value);\n";
+        out += indent + "};\n\n";
+    }
+
+    void emitEnum(std::string& out, const HeaderGeneratorOptions& options, const Decl& decl, bool newer,
+                  const std::string& indent) {
+        std::string name = "E" + std::to_string(decl.index);
+        bool mutated = newer && decl.changed;
+
+        out += indent + "enum class " + name + " : int {\n";
+        for (unsigned e = 0; e < options.enumSize; ++e) {
+            // Renumbering an enumerator is the enum's retype
+            unsigned value = mutated && decl.mutation == Mutation::RETYPE && e == decl.target ? e + 1000 : e;
+            out += indent + "    " + name + "_" + std::to_string(e) + " = " + std::to_string(value) + ",\n";
+        }
+        if (mutated && decl.mutation == Mutation::EXTEND) {
+            out += indent + "    " + name + "_" + std::to_string(options.enumSize) + " = " +
+                   std::to_string(options.enumSize) + ",\n";
+        }
+        out += indent + "};\n\n";
+    }
+
+    void emitFunctions(std::string& out, const HeaderGeneratorOptions& options, const Decl& decl, bool newer,
+                       const std::string& indent) {
+        std::string name = "f" + std::to_string(decl.index);
+        bool mutated = newer && decl.changed;
+        unsigned overloads = options.overloadsPerFunction + (mutated && decl.mutation == Mutation::EXTEND);
+
+        // Overload k takes k + 1 parameters, so every overload has its own signature
+        for (unsigned k = 0; k < overloads; ++k) {
+            if (decl.isTemplate) {
+                out += indent + "template <typename T>\n";
+            }
+            out += indent + (decl.isTemplate ? "T " : "int ") + name + "(";
+            for (unsigned p = 0; p <= k; ++p) {
+                std::string type = decl.isTemplate && p == 0 ? "T"
+                                   : mutated && decl.mutation == Mutation::RETYPE && k == decl.target && p == k
+                                       ? retyped(decl.index, p) : typeAt(decl.index, p);
+                out += (p ? ", " : "") + type + " a" + std::to_string(p);
+            }
+            out += ");\n";
+        }
+        out += "\n";
+    }
+
+    void emitAlias(std::string& out, const Decl& decl, bool newer, const std::string& indent) {
+        bool mutated = newer && decl.changed && decl.mutation != Mutation::REMOVE;
+        out += indent + "using Alias" + std::to_string(decl.index) + " = " +
+               (mutated ? retyped(decl.index, 0) : typeAt(decl.index, 0)) + "*;\n\n";
+    }
+
+    void emitDecl(std::string& out, const HeaderGeneratorOptions& options, const Decl& decl, bool newer,
+                  const std::string& indent) {
+        if (newer && decl.changed && decl.mutation == Mutation::REMOVE) {
+            return;
+        }
+        switch (decl.kind) {
+            case DeclKind::STRUCT: emitStruct(out, options, decl, newer, indent); break;
+            case DeclKind::ENUM: emitEnum(out, options, decl, newer, indent); break;
+            case DeclKind::FUNCTIONS: emitFunctions(out, options, decl, newer, indent); break;
+            case DeclKind::ALIAS: emitAlias(out, decl, newer, indent); break;
+        }
+    }
+
+    void emitAdded(std::string& out, const Decl& decl, const std::string& indent) {
+        std::string name = "Added" + std::to_string(decl.index);
+        out += indent + "struct " + name + " {\n";
+        out += indent + "    int value;\n";
+        out += indent + "};\n";
+        out += indent + "int use" + name + "(const " + name + "* item);\n\n";
+    }
+
+}
+
+std::string armor::bench::generateHeader(const HeaderGeneratorOptions& options, bool newer) {
+    std::string out;
+    out += "// Generated by armor_header_gen: " + std::to_string(options.declCount) + " declarations, seed " +
+           std::to_string(options.seed) + (newer ? ", newer version" : ", older version") + "\n";
+    out += "#ifndef ARMOR_GENERATED_HEADER_H\n#define ARMOR_GENERATED_HEADER_H\n\n";
+
+    const unsigned perNamespace = options.declsPerNamespace ? options.declsPerNamespace : 1;
+    for (size_t first = 0; first < options.declCount; first += perNamespace) {
+        std::string indent;
+        for (unsigned d = 0; d < options.namespaceDepth; ++d) {
+            std::string name = d == 0 ? "gen" + std::to_string(first / perNamespace) : "level" + std::to_string(d);
+            out += indent + "namespace " + name + " {\n\n";
+            indent += "    ";
+        }
+
+        size_t last = std::min(options.declCount, first + perNamespace);
+        for (size_t i = first; i < last; ++i) {
+            Decl decl = describe(options, i);
+            emitDecl(out, options, decl, newer, indent);
+            if (newer && decl.addedAfter) {
+                emitAdded(out, decl, indent);
+            }
+        }
+
+        for (unsigned d = options.namespaceDepth; d > 0; --d) {
+            indent.resize(indent.size() - 4);
+            out += indent + "}\n";
+        }
+        out += "\n";
+    }
+
+    out += "#endif\n";
+    return out;
+}
+
+void armor::bench::writeHeaderPair(const HeaderGeneratorOptions& options, const std::string& outDir,
+                                   const std::string& headerName) {
+    for (bool newer : {false, true}) {
+        std::filesystem::path dir = std::filesystem::path(outDir) / (newer ? "v2" : "v1");
+        std::filesystem::create_directories(dir);
+
+        std::filesystem::path path = dir / headerName;
+        std::ofstream out(path);
+        if (!out) {
+            throw std::runtime_error("Cannot write generated header: " + path.string());
+        }
+        out << generateHeader(options, newer);
+        if (!out) {
+            throw std::runtime_error("Failed writing generated header: " + path.string());
+        }
+    }
+}
@@ -0,0 +1,54 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace armor::bench {
+
+/**
+ * @brief Shape of a generated header pair, see generateHeader.
+ */
+struct HeaderGeneratorOptions {
+    // Top-level declarations: structs, enums, overload sets and aliases
+    size_t declCount = 1000;
+    // Namespaces enclosing every declaration; 0 puts them at global scope
+    unsigned namespaceDepth = 3;
+    // Declarations per innermost namespace before a sibling one is opened
+    unsigned declsPerNamespace = 50;
+    // Functions in every overload set
+    unsigned overloadsPerFunction = 3;
+    // Share of structs and overload sets declared as templates, in [0, 1]
+    double templateRatio = 0.2;
+    // Enumerators per enum
+    unsigned enumSize = 32;
+    // Data members per struct
+    unsigned fieldsPerStruct = 8;
+    // Share of declarations that differ in the newer version, in [0, 1]
+    double changeRate = 0.02;
+    uint64_t seed = 1;
+};
+
+/**
+ * @brief Generates one version of a synthetic C++ header.
+ *
+ * Both versions hold the same declarations in the same order; in the newer
+ * one (`newer`) a `changeRate` share of them is modified (retyped member,
+ * appended enumerator, retyped parameter, extra overload), removed, or
+ * followed by an added declaration. The output is self-contained and parses
+ * without any include path.
+ */
+std::string generateHeader(const HeaderGeneratorOptions& options, bool newer);
+
+/**
+ * @brief Writes `outDir`/v1/`headerName` and `outDir`/v2/`headerName`, the layout
+ *        of the functional fixtures.
+ *
+ * @throws std::runtime_error if a header cannot be written.
+ */
+void writeHeaderPair(const HeaderGeneratorOptions& options, const std::string& outDir,
+                     const std::string& headerName = "mylib.h");
+
+}
@@ -0,0 +1,100 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "bench_baseline.hpp"
+#include "bench_fixtures.hpp"
+#include "bench_growth.hpp"
+#include "logger.hpp"
+
+#ifndef ARMOR_FIXTURES_DIR
+#define ARMOR_FIXTURES_DIR ""
+#endif
+
+namespace {
+
+    struct BaselineOptions {
+        std::string baseline;
+        std::string saveBaseline;
+        armor::bench::RegressionPolicy policy;
+        armor::bench::GrowthPolicy growth;
+    };
+
+    // Takes the baseline and growth flags out of argv, leaving the rest to benchmark::Initialize
+    BaselineOptions extractBaselineOptions(int& argc, char** argv) {
+        BaselineOptions options;
+        int kept = 1;
+        for (int i = 1; i < argc; ++i) {
+            auto value = [&](const char* flag) -> const char* {
+                size_t length = std::strlen(flag);
+                return std::strncmp(argv[i], flag, length) == 0 && argv[i][length] == '=' ? argv[i] + length + 1 : nullptr;
+            };
+            if (const char* path = value("--baseline")) {
+                options.baseline = path;
+            } else if (const char* path = value("--save_baseline")) {
+                options.saveBaseline = path;
+            } else if (const char* threshold = value("--regression_threshold")) {
+                options.policy.threshold = std::stod(threshold);
+            } else if (const char* sigmas = value("--noise_sigmas")) {
+                options.policy.noiseSigmas = std::stod(sigmas);
+            } else if (const char* exponent = value("--max_growth_exponent")) {
+                options.growth.maxExponent = std::stod(exponent);
+            } else {
+                argv[kept++] = argv[i];
+            }
+        }
+        argc = kept;
+        return options;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    // Keep the normalizers' logging out of the timings
+    DebugConfig::getInstance().setLevel(DebugConfig::Level::NONE);
+
+    BaselineOptions options;
+    armor::bench::BenchmarkTimings baseline;
+    try {
+        options = extractBaselineOptions(argc, argv);
+        if (!options.baseline.empty()) {
+            baseline = armor::bench::loadBaseline(options.baseline);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    armor::bench::registerFixtureBenchmarks(ARMOR_FIXTURES_DIR);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    armor::bench::RecordingReporter reporter(
+        std::unique_ptr<benchmark::BenchmarkReporter>(benchmark::CreateDefaultDisplayReporter()));
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    armor::bench::BenchmarkTimings timings = reporter.timings();
+    try {
+        if (!options.saveBaseline.empty()) {
+            armor::bench::saveBaseline(timings, options.saveBaseline);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    if (!options.baseline.empty() && armor::bench::compareToBaseline(baseline, timings, options.policy) > 0) {
+        return 2;
+    }
+    if (armor::bench::checkGrowth(timings, "BM_Stress", options.growth) > 0) {
+        return 3;
+    }
+    return 0;
+}
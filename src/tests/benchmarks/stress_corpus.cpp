@@ -0,0 +1,164 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "stress_corpus.hpp"
+
+namespace {
+
+    using armor::bench::StressShape;
+
+    // Declarations at scale 1; each shape is sized to take a few milliseconds to parse
+    constexpr size_t OVERLOADS_PER_SCALE = 1024;
+    constexpr size_t ENUMERATORS_PER_SCALE = 4096;
+    constexpr size_t NAMESPACE_CHAINS_PER_SCALE = 8;
+    constexpr size_t INACTIVE_BLOCKS_PER_SCALE = 256;
+
+    // Nesting of every namespace chain; clang allows 256 levels of braces
+    constexpr unsigned NAMESPACE_DEPTH = 100;
+
+    // Lines of dead code in every #if 0 block
+    constexpr unsigned DEAD_LINES_PER_BLOCK = 8;
+
+    enum class Change { NONE, MODIFIED, REMOVED, ADDED_AFTER };
+
+    // What the newer version does to declaration `index`: one in 64 of each change
+    Change changeOf(size_t index, bool newer) {
+        if (!newer) {
+            return Change::NONE;
+        }
+        switch (index % 64) {
+            case 15: return Change::MODIFIED;
+            case 31: return Change::ADDED_AFTER;
+            case 63: return Change::REMOVED;
+            default: return Change::NONE;
+        }
+    }
+
+    void emitOverloads(std::string& out, size_t scale, bool newer) {
+        out += "template <int N> struct Tag {};\n\n";
+        out += "namespace stress {\n\n";
+        for (size_t i = 0; i < OVERLOADS_PER_SCALE * scale; ++i) {
+            Change change = changeOf(i, newer);
+            if (change == Change::REMOVED) {
+                continue;
+            }
+            std::string tag = "Tag<" + std::to_string(i) + ">";
+            out += std::string(change == Change::MODIFIED ? "long" : "int") + " overloaded(" + tag + " tag);\n";
+            if (change == Change::ADDED_AFTER) {
+                out += "int overloaded(" + tag + " tag, int extra);\n";
+            }
+        }
+        out += "\n}\n";
+    }
+
+    void emitHugeEnum(std::string& out, size_t scale, bool newer) {
+        out += "enum class Huge : long long {\n";
+        for (size_t i = 0; i < ENUMERATORS_PER_SCALE * scale; ++i) {
+            Change change = changeOf(i, newer);
+            if (change == Change::REMOVED) {
+                continue;
+            }
+            std::string name = "Huge_" + std::to_string(i);
+            out += "    " + name + " = " + std::to_string(change == Change::MODIFIED ? i + 1000000 : i) + ",\n";
+            if (change == Change::ADDED_AFTER) {
+                out += "    " + name + "_added = " + std::to_string(i + 2000000) + ",\n";
+            }
+        }
+        out += "};\n";
+    }
+
+    void emitNestedNamespaces(std::string& out, size_t scale, bool newer) {
+        for (size_t chain = 0; chain < NAMESPACE_CHAINS_PER_SCALE * scale; ++chain) {
+            for (unsigned depth = 0; depth < NAMESPACE_DEPTH; ++depth) {
+                out += depth == 0 ? "namespace chain" + std::to_string(chain) + " {\n"
+                                  : "namespace level" + std::to_string(depth) + " {\n";
+                size_t index = chain * NAMESPACE_DEPTH + depth;
+                Change change = changeOf(index, newer);
+                if (change == Change::REMOVED) {
+                    continue;
+                }
+                std::string name = "Level" + std::to_string(depth);
+                out += "struct " + name + " { " + (change == Change::MODIFIED ? "long" : "int") + " value; };\n";
+                if (change == Change::ADDED_AFTER) {
+                    out += "struct " + name + "Added { int value; };\n";
+                }
+            }
+            out += std::string(NAMESPACE_DEPTH, '}') + "\n\n";
+        }
+    }
+
+    void emitInactiveBlocks(std::string& out, size_t scale, bool newer) {
+        for (size_t i = 0; i < INACTIVE_BLOCKS_PER_SCALE * scale; ++i) {
+            std::string id = std::to_string(i);
+            Change change = changeOf(i, newer);
+            if (change != Change::REMOVED) {
+                out += "/** Active declaration " + id + ". */\n";
+                out += std::string(change == Change::MODIFIED ? "long" : "int") + " active" + id + "(int value);\n";
+            }
+            if (change == Change::ADDED_AFTER) {
+                out += "int active" + id + "Added(int value);\n";
+            }
+
+            // Comments here are left out of the comment hashes, nested ranges folded by the preprocessor callbacks
+            out += "#if 0\n";
+            out += "/** Disabled declaration " + id + ". */\n";
+            out += "#ifdef ARMOR_STRESS_" + id + "\n";
+            out += "int nested" + id + "(void);\n";
+            out += "#else\n";
+            out += "// Nested alternative " + id + "\n";
+            out += "#endif\n";
+            for (unsigned line = 0; line < DEAD_LINES_PER_BLOCK; ++line) {
+                out += "int dead" + id + "_" + std::to_string(line) + "(void); // dead " + std::to_string(line) + "\n";
+            }
+            out += "#endif\n\n";
+        }
+    }
+
+}
+
+const char* armor::bench::stressShapeName(StressShape shape) {
+    switch (shape) {
+        case StressShape::OVERLOADS: return "overloads";
+        case StressShape::HUGE_ENUM: return "huge_enum";
+        case StressShape::NESTED_NAMESPACES: return "nested_namespaces";
+        case StressShape::INACTIVE_BLOCKS: return "inactive_blocks";
+    }
+    return "unknown";
+}
+
+std::string armor::bench::generateStressHeader(StressShape shape, size_t scale, bool newer) {
+    std::string out;
+    out += std::string("// Stress header: ") + stressShapeName(shape) + " at scale " + std::to_string(scale) +
+           (newer ? ", newer version" : ", older version") + "\n";
+    out += "#ifndef ARMOR_STRESS_HEADER_H\n#define ARMOR_STRESS_HEADER_H\n\n";
+    switch (shape) {
+        case StressShape::OVERLOADS: emitOverloads(out, scale, newer); break;
+        case StressShape::HUGE_ENUM: emitHugeEnum(out, scale, newer); break;
+        case StressShape::NESTED_NAMESPACES: emitNestedNamespaces(out, scale, newer); break;
+        case StressShape::INACTIVE_BLOCKS: emitInactiveBlocks(out, scale, newer); break;
+    }
+    out += "\n#endif\n";
+    return out;
+}
+
+void armor::bench::writeStressPair(StressShape shape, size_t scale, const std::string& outDir,
+                                   const std::string& headerName) {
+    for (bool newer : {false, true}) {
+        std::filesystem::path dir = std::filesystem::path(outDir) / (newer ? "v2" : "v1");
+        std::filesystem::create_directories(dir);
+
+        std::filesystem::path path = dir / headerName;
+        std::ofstream out(path);
+        if (!out) {
+            throw std::runtime_error("Cannot write stress header: " + path.string());
+        }
+        out << generateStressHeader(shape, scale, newer);
+        if (!out) {
+            throw std::runtime_error("Failed writing stress header: " + path.string());
+        }
+    }
+}
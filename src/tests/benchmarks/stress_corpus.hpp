@@ -0,0 +1,44 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace armor::bench {
+
+/**
+ * @brief Pathological header shapes that have made hot paths near-quadratic.
+ */
+enum class StressShape {
+    // One overload set: every root shares its NSR and is matched by USR
+    OVERLOADS,
+    // One enum with thousands of enumerators
+    HUGE_ENUM,
+    // Declarations at every level of namespaces nested a hundred deep
+    NESTED_NAMESPACES,
+    // #if 0 blocks holding nested conditionals and comments, between active declarations
+    INACTIVE_BLOCKS
+};
+
+/** @brief Lowercase name of `shape`, as used in benchmark names. */
+const char* stressShapeName(StressShape shape);
+
+/**
+ * @brief Generates one version of a stress header of `shape` at `scale`.
+ *
+ * The amount of code grows linearly with `scale`, while its shape does not
+ * change, so the time to process it should too. The newer version
+ * (`newer`) changes, removes and adds one declaration in 64.
+ */
+std::string generateStressHeader(StressShape shape, size_t scale, bool newer);
+
+/**
+ * @brief Writes `outDir`/v1/`headerName` and `outDir`/v2/`headerName`, see generateStressHeader.
+ *
+ * @throws std::runtime_error if a header cannot be written.
+ */
+void writeStressPair(StressShape shape, size_t scale, const std::string& outDir,
+                     const std::string& headerName = "mylib.h");
+
+}
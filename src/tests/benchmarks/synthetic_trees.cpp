@@ -0,0 +1,57 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <string>
+
+#include "bench_random.hpp"
+#include "synthetic_trees.hpp"
+
+namespace {
+
+    // Every (seed, struct, field) triple decides its change independently
+    bool isChanged(const armor::bench::SyntheticTreeOptions& options, size_t structIndex, unsigned fieldIndex) {
+        return armor::bench::roll(options.seed, structIndex * 1024 + fieldIndex) < options.changeRate;
+    }
+
+    beta::APINode* makeNode(beta::ASTNormalizedContext& context, NodeKind kind,
+                            const std::string& qualifiedName, const std::string& usr, llvm::StringRef type) {
+        beta::APINode* node = context.createNode();
+        node->kind = kind;
+        node->name = context.intern(qualifiedName);
+        node->NSR = node->name;
+        node->USR = context.intern(usr);
+        node->dataType = context.intern(type);
+        node->caonicalType = node->dataType;
+        node->access = AccessSpec::Public;
+        return node;
+    }
+
+}
+
+void armor::bench::buildSyntheticContext(beta::ASTNormalizedContext& context, const SyntheticTreeOptions& options,
+                                         bool newer) {
+    const size_t perStruct = options.fieldsPerStruct + 1;
+    const size_t structCount = options.nodeCount / perStruct + (options.nodeCount % perStruct != 0);
+
+    for (size_t s = 0; s < structCount; ++s) {
+        // Every 64th struct is removed in the newer version and replaced by an added one
+        bool replaced = s % 64 == 63;
+        std::string name = replaced && newer ? "bench::Added" + std::to_string(s) : "bench::S" + std::to_string(s);
+        std::string usr = "c:@N@bench@S@" + name.substr(7);
+
+        beta::APINode* record = makeNode(context, NodeKind::Struct, name, usr, name);
+        for (unsigned f = 0; f < options.fieldsPerStruct; ++f) {
+            std::string field = "f" + std::to_string(f);
+            llvm::StringRef type = newer && isChanged(options, s, f) ? "long" : "int";
+            context.addChild(*record, makeNode(context, NodeKind::Field, name + "::" + field,
+                                               usr + "@FI@" + field, type));
+        }
+
+        context.addNode(record->NSR, record);
+        context.addRootNode(record);
+        context.usrNodeMap[record->USR] = record;
+    }
+    context.computeFingerprints();
+    if (options.freeze) {
+        context.freeze();
+    }
+}
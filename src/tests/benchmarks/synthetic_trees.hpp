@@ -0,0 +1,37 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ast_normalized_context.hpp"
+
+namespace armor::bench {
+
+/**
+ * @brief Shape of a synthetic normalized tree, see buildSyntheticContext.
+ */
+struct SyntheticTreeOptions {
+    // Total number of nodes, roots included
+    size_t nodeCount = 1024;
+    // Fields per struct
+    unsigned fieldsPerStruct = 15;
+    // Share of fields whose type differs between the versions, in [0, 1]
+    double changeRate = 0.01;
+    uint64_t seed = 1;
+    // Whether the USR maps are frozen, as after a real parse
+    bool freeze = true;
+};
+
+/**
+ * @brief Fills `context` with structs of int fields, as the beta normalizer would.
+ *
+ * The newer version (`newer`) retypes a `changeRate` share of the fields and
+ * adds one struct per 64, dropping another, so the diff of the two versions
+ * holds modified, added and removed entries in the same proportions for any
+ * tree size. Fingerprints are computed, as after a real parse.
+ */
+void buildSyntheticContext(beta::ASTNormalizedContext& context, const SyntheticTreeOptions& options, bool newer);
+
+}
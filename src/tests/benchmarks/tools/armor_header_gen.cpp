@@ -0,0 +1,43 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <CLI/CLI.hpp>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "header_generator.hpp"
+
+int main(int argc, const char** argv) {
+    CLI::App app{"Generates a v1/v2 pair of synthetic headers for scaling runs"};
+
+    armor::bench::HeaderGeneratorOptions options;
+    std::string outDir;
+    std::string headerName = "mylib.h";
+
+    app.add_option("outdir", outDir, "Directory receiving v1/<header> and v2/<header>")->required();
+    app.add_option("--header", headerName, "Header file name")->capture_default_str();
+    app.add_option("--decls,-n", options.declCount, "Top-level declarations")->capture_default_str();
+    app.add_option("--depth", options.namespaceDepth, "Namespace nesting depth")->capture_default_str();
+    app.add_option("--decls-per-namespace", options.declsPerNamespace, "Declarations per innermost namespace")
+        ->capture_default_str()->check(CLI::PositiveNumber);
+    app.add_option("--overloads", options.overloadsPerFunction, "Functions per overload set")
+        ->capture_default_str()->check(CLI::PositiveNumber);
+    app.add_option("--template-ratio", options.templateRatio, "Share of structs and overload sets that are templates")
+        ->capture_default_str()->check(CLI::Range(0.0, 1.0));
+    app.add_option("--enum-size", options.enumSize, "Enumerators per enum")->capture_default_str();
+    app.add_option("--fields", options.fieldsPerStruct, "Data members per struct")->capture_default_str();
+    app.add_option("--change-rate", options.changeRate, "Share of declarations changed in v2")
+        ->capture_default_str()->check(CLI::Range(0.0, 1.0));
+    app.add_option("--seed", options.seed, "Seed; the same options and seed give the same headers")
+        ->capture_default_str();
+    CLI11_PARSE(app, argc, argv);
+
+    try {
+        armor::bench::writeHeaderPair(options, outDir, headerName);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::cout << outDir << "/v1/" << headerName << "\n" << outDir << "/v2/" << headerName << "\n";
+    return 0;
+}
@@ -0,0 +1,22 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+namespace legacy {
+
+// Moved to another namespace unchanged
+struct Widget {
+    int width;
+    int height;
+    float scale;
+};
+
+// Renamed in the same namespace, same signature
+int open_device(int id, unsigned flags);
+
+}
+
+// Unchanged
+int version();
+
+// Removed, and an unrelated function of a different shape added
+void shutdown(int code);
@@ -0,0 +1,26 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+namespace gui {
+
+// Moved to another namespace unchanged
+struct Widget {
+    int width;
+    int height;
+    float scale;
+};
+
+}
+
+namespace legacy {
+
+// Renamed in the same namespace, same signature
+int device_open(int id, unsigned flags);
+
+}
+
+// Unchanged
+int version();
+
+// Removed, and an unrelated function of a different shape added
+double restart(double delay);
@@ -0,0 +1,57 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <functional>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "diff_utils.hpp"
+#include "profiler.hpp"
+
+namespace {
+
+    // Allocations of one node written as the diff engines write nodes: the
+    // object, its three members, their string values, and the buffers of the
+    // two values longer than the small string buffer. The kind costs no
+    // string of its own before it is copied into the document.
+    constexpr std::size_t NODE_JSON_BUDGET = 9;
+
+    // Global operator new calls of `work`, as the profiler counts them
+    uint64_t allocationsOf(const std::function<void()>& work) {
+        uint64_t before = armor::profile::detail::threadAllocations.count;
+        work();
+        return armor::profile::detail::threadAllocations.count - before;
+    }
+
+}
+
+TEST(AllocationBudgetTest, SerializingEnumsDoesNotAllocate) {
+    uint64_t count = allocationsOf([] {
+        std::size_t length = 0;
+        for (int kind = static_cast<int>(NodeKind::Namespace); kind <= static_cast<int>(NodeKind::Unknown); ++kind) {
+            length += std::char_traits<char>::length(serialize(static_cast<NodeKind>(kind)));
+        }
+        length += std::char_traits<char>::length(serialize(APINodeStorageClass::Static));
+        length += std::char_traits<char>::length(serialize(VirtualQualifier::PureVirtual));
+        length += std::char_traits<char>::length(serialize(ParsedDiffStatus::SUPPORTED_UPDATES));
+        length += std::char_traits<char>::length(serialize(UnParsedDiffStatus::CHANGED));
+        EXPECT_GT(length, 0u);
+    });
+    EXPECT_EQ(count, 0u);
+}
+
+TEST(AllocationBudgetTest, NodeJsonStaysWithinBudget) {
+    constexpr std::size_t NODES = 1000;
+    const std::string qualifiedName = "armor::detail::SomeRecord::someMember";
+    const std::string dataType = "const std::vector<unsigned long> &";
+    nlohmann::json children = nlohmann::json::array();
+    children.get_ref<nlohmann::json::array_t&>().reserve(NODES);
+    uint64_t count = allocationsOf([&] {
+        for (std::size_t i = 0; i < NODES; ++i) {
+            nlohmann::json& node = children.emplace_back();
+            node[QUALIFIED_NAME] = qualifiedName;
+            node[NODE_TYPE] = serialize(NodeKind::Field);
+            node[DATA_TYPE] = dataType;
+        }
+    });
+    EXPECT_LE(count, NODES * NODE_JSON_BUDGET);
+}
@@ -0,0 +1,113 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "api_filter.hpp"
+
+class ApiFilterTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_api_filter_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string write(const std::string& content) {
+        std::filesystem::path p = dir / "filter.json";
+        std::ofstream out(p, std::ios::trunc);
+        out << content;
+        return p.string();
+    }
+};
+
+TEST_F(ApiFilterTest, MatchesWholeQualifiedNames) {
+    armor::ApiFilter filter = armor::ApiFilter::load(
+        write(R"({"include": ["mylib::*"], "exclude": ["*::detail", "*::_*"]})"));
+
+    EXPECT_TRUE(filter.excludesName("mylib::detail"));
+    EXPECT_TRUE(filter.excludesName("mylib::_internal"));
+    EXPECT_FALSE(filter.excludesName("mylib::detail_free"));
+    EXPECT_FALSE(filter.excludesName("mylib::Widget"));
+
+    EXPECT_TRUE(filter.includesName("mylib::Widget"));
+    EXPECT_FALSE(filter.includesName("other::Widget"));
+    EXPECT_FALSE(filter.includesName("mylib"));
+}
+
+TEST_F(ApiFilterTest, EmptyFilterKeepsEverything) {
+    armor::ApiFilter filter = armor::ApiFilter::load(write("{}"));
+
+    EXPECT_FALSE(filter.excludesName("mylib::detail"));
+    EXPECT_TRUE(filter.includesName("anything"));
+    EXPECT_FALSE(filter.excludeHidden());
+    EXPECT_FALSE(filter.requiresExportMacro());
+}
+
+TEST_F(ApiFilterTest, ReadsVisibilityAndExportMacros) {
+    armor::ApiFilter filter = armor::ApiFilter::load(
+        write(R"({"excludeHidden": true, "exportMacros": ["MYLIB_API", "MYLIB_EXPORT"]})"));
+
+    EXPECT_TRUE(filter.excludeHidden());
+    EXPECT_TRUE(filter.requiresExportMacro());
+    EXPECT_TRUE(filter.isExportMacro("MYLIB_EXPORT"));
+    EXPECT_FALSE(filter.isExportMacro("MYLIB"));
+}
+
+TEST_F(ApiFilterTest, FingerprintIgnoresKeyOrder) {
+    std::string first = armor::ApiFilter::load(
+        write(R"({"exclude": ["*::detail"], "excludeHidden": true})")).fingerprint();
+    std::string second = armor::ApiFilter::load(
+        write(R"({"excludeHidden": true, "exclude": ["*::detail"]})")).fingerprint();
+    std::string other = armor::ApiFilter::load(write(R"({"exclude": ["*::impl"]})")).fingerprint();
+
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+}
+
+TEST_F(ApiFilterTest, RejectsMalformedFiles) {
+    EXPECT_THROW(armor::ApiFilter::load((dir / "missing.json").string()), std::runtime_error);
+    EXPECT_THROW(armor::ApiFilter::load(write("[]")), std::runtime_error);
+    EXPECT_THROW(armor::ApiFilter::load(write(R"({"exclude": "detail"})")), std::runtime_error);
+    EXPECT_THROW(armor::ApiFilter::load(write(R"({"exclude": ["[z-a]"]})")), std::runtime_error);
+    EXPECT_THROW(armor::ApiFilter::load(write(R"({"exlude": ["*::detail"]})")), std::runtime_error);
+}
+
+TEST_F(ApiFilterTest, SymbolsKeepTheirScopesAndMembers) {
+    armor::ApiFilter filter = armor::ApiFilter::load(write(R"({"symbols": ["ns::Foo::bar"]})"));
+    filter.addSymbol("::other::baz");
+
+    EXPECT_TRUE(filter.hasSymbols());
+    EXPECT_TRUE(filter.selectsSymbol("ns"));
+    EXPECT_TRUE(filter.selectsSymbol("ns::Foo"));
+    EXPECT_TRUE(filter.selectsSymbol("ns::Foo::bar"));
+    EXPECT_TRUE(filter.selectsSymbol("ns::Foo::bar::Nested"));
+    EXPECT_TRUE(filter.selectsSymbol("other::baz"));
+    EXPECT_FALSE(filter.selectsSymbol("ns::Foo::baz"));
+    EXPECT_FALSE(filter.selectsSymbol("ns::Foo::bar_impl"));
+    EXPECT_FALSE(filter.selectsSymbol("ns::FooBar"));
+    EXPECT_FALSE(filter.selectsSymbol("lib"));
+
+    armor::ApiFilter everything = armor::ApiFilter::load(write("{}"));
+    EXPECT_FALSE(everything.hasSymbols());
+    EXPECT_TRUE(everything.selectsSymbol("ns::Foo::baz"));
+}
+
+TEST_F(ApiFilterTest, FingerprintCoversSymbols) {
+    armor::ApiFilter fromFile = armor::ApiFilter::load(write(R"({"symbols": ["ns::a", "ns::b"]})"));
+    armor::ApiFilter fromFlags = armor::ApiFilter::load(write("{}"));
+    std::string unrestricted = fromFlags.fingerprint();
+    fromFlags.addSymbol("ns::b");
+    fromFlags.addSymbol("ns::a");
+    fromFlags.addSymbol("ns::a");
+
+    EXPECT_EQ(fromFile.fingerprint(), fromFlags.fingerprint());
+    EXPECT_NE(unrestricted, fromFlags.fingerprint());
+}
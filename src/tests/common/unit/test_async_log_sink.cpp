@@ -0,0 +1,98 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "async_log_sink.hpp"
+#include "work_pool.hpp"
+
+class AsyncLogSinkTest : public ::testing::Test {
+protected:
+    void SetUp() override { written.clear(); }
+    void TearDown() override {}
+
+    armor::AsyncLogSink::Writer collect() {
+        return [this](llvm::StringRef text, bool) {
+            std::scoped_lock<std::mutex> lock(writtenMutex);
+            written += text.str();
+        };
+    }
+
+    std::vector<std::string> lines() {
+        std::vector<std::string> result;
+        std::istringstream in(written);
+        for (std::string line; std::getline(in, line);) {
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    std::mutex writtenMutex;
+    std::string written;
+};
+
+TEST_F(AsyncLogSinkTest, Flush_WritesRecordsInSubmitOrder) {
+    armor::AsyncLogSink sink(collect());
+    sink.submit("first\n");
+    sink.submit("second\n");
+    sink.flush();
+    EXPECT_EQ(written, "first\nsecond\n");
+}
+
+TEST_F(AsyncLogSinkTest, Destructor_DrainsPendingRecords) {
+    {
+        armor::AsyncLogSink sink(collect());
+        sink.submit("pending\n");
+    }
+    EXPECT_EQ(written, "pending\n");
+}
+
+TEST_F(AsyncLogSinkTest, FullRing_WaitsForDrainInsteadOfDropping) {
+    // The smallest ring holds 4 KiB, so this wraps it many times over
+    armor::AsyncLogSink sink(collect(), 1);
+    std::string expected;
+    for (int i = 0; i < 2000; ++i) {
+        std::string record = "record " + std::to_string(i) + "\n";
+        sink.submit(record);
+        expected += record;
+    }
+    sink.flush();
+    EXPECT_EQ(written, expected);
+}
+
+TEST_F(AsyncLogSinkTest, OversizedRecord_KeepsItsPlace) {
+    armor::AsyncLogSink sink(collect(), 1);
+    std::string big(10000, 'x');
+    sink.submit("before\n");
+    sink.submit(big + "\n");
+    sink.submit("after\n");
+    sink.flush();
+    EXPECT_EQ(written, "before\n" + big + "\nafter\n");
+}
+
+TEST_F(AsyncLogSinkTest, ManyThreads_RecordsNeitherLostNorInterleaved) {
+    armor::AsyncLogSink sink(collect(), 1);
+    constexpr size_t threads = 8;
+    constexpr int perThread = 500;
+    armor::parallelFor(threads, threads, [&](size_t t) {
+        for (int i = 0; i < perThread; ++i) {
+            sink.submit("thread " + std::to_string(t) + " line " + std::to_string(i) + "\n");
+        }
+    });
+    sink.flush();
+
+    std::vector<int> next(threads, 0);
+    std::vector<std::string> all = lines();
+    ASSERT_EQ(all.size(), threads * perThread);
+    for (const std::string& line : all) {
+        size_t t = 0;
+        int i = 0;
+        ASSERT_EQ(std::sscanf(line.c_str(), "thread %zu line %d", &t, &i), 2) << line;
+        ASSERT_LT(t, threads);
+        // Each thread's records arrive whole and in its own order
+        EXPECT_EQ(i, next[t]++);
+    }
+}
@@ -0,0 +1,121 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "baseline_findings.hpp"
+#include "comm_def.hpp"
+#include "diff_utils.hpp"
+#include "output_paths.hpp"
+#include "report_format.hpp"
+#include "report_generator.hpp"
+#include "report_utils.hpp"
+
+class BaselineFindingsTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+    armor::BaselineFindings baseline;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_baseline_findings_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        armor::BaselineFindings::getInstance().clear();
+        std::filesystem::remove_all(dir);
+    }
+
+    static ChangeRecord record(const std::string& name, const std::string& description, bool incompatible) {
+        return ChangeRecord{"include/foo.h", name, description, true, incompatible};
+    }
+
+    // Writes the report of include/foo.h with `records` into the run rooted at `run`
+    void writeReport(const std::string& run, std::vector<ChangeRecord> records,
+                     armor::ReportFormat format = armor::ReportFormat::JSON) {
+        armor::OutputPaths outputs{(dir / run).string()};
+        std::filesystem::create_directories(outputs.jsonReportDir());
+        ApiChangeGroups groups("include/foo.h");
+        for (ChangeRecord& r : records) {
+            groups.addRecord(std::move(r));
+        }
+        generate_json_report(groups, outputs.jsonReportFile("foo.h", format),
+                             static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                             static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                             "backward_incompatible", "BACKWARD_INCOMPATIBLE", "reason");
+    }
+};
+
+TEST_F(BaselineFindingsTest, OnlyNewFindingsRemain) {
+    writeReport("base", {record("kept", "old wording", true), record("fixed", "gone now", true),
+                         record("weaker", "was compatible", false)},
+                armor::ReportFormat::CBOR);
+    EXPECT_EQ(baseline.load((dir / "base").string()), 1u);
+    EXPECT_TRUE(baseline.isLoaded());
+
+    ApiChangeGroups groups("include/foo.h");
+    // Reworded, still known
+    groups.addRecord(record("kept", "new wording", true));
+    groups.addRecord(record("added", "new", false));
+    // Now incompatible, so a new finding
+    groups.addRecord(record("weaker", "now incompatible", true));
+
+    json summary;
+    ApiChangeGroups delta = baseline.delta(groups, summary);
+    std::vector<std::string> names;
+    for (const ApiChangeGroups::Group& group : delta) {
+        names.push_back(group.name);
+    }
+    EXPECT_EQ(names, (std::vector<std::string>{"added", "weaker"}));
+    EXPECT_TRUE(delta.hasBackwardIncompatible());
+    EXPECT_EQ(summary["known"], 1);
+
+    std::vector<std::string> resolved;
+    for (const json& row : summary["resolved"]) {
+        resolved.push_back(row["name"]);
+    }
+    EXPECT_EQ(resolved, (std::vector<std::string>{"fixed", "weaker"}));
+}
+
+TEST_F(BaselineFindingsTest, HeadersMissingFromTheBaselineAreAllNew) {
+    writeReport("base", {record("kept", "", true)});
+    std::string report = armor::OutputPaths{(dir / "base").string()}.jsonReportFile("foo.h");
+    EXPECT_EQ(baseline.load(report), 1u);
+
+    ApiChangeGroups groups("include/bar.h");
+    groups.addRecord(ChangeRecord{"include/bar.h", "kept", "", true, true});
+    json summary;
+    ApiChangeGroups delta = baseline.delta(groups, summary);
+    EXPECT_EQ(delta.size(), 1u);
+    EXPECT_EQ(summary["known"], 0);
+    EXPECT_TRUE(summary["resolved"].empty());
+}
+
+TEST_F(BaselineFindingsTest, MalformedReportThrows) {
+    std::string path = (dir / "report.json").string();
+    std::ofstream(path) << R"({"api_diff": [{"name": "foo"}]})";
+    EXPECT_THROW(baseline.load(path), std::runtime_error);
+}
+
+TEST_F(BaselineFindingsTest, ReportsJudgeOnlyTheDelta) {
+    writeReport("base", {record("kept", "", true)});
+    armor::BaselineFindings::getInstance().load((dir / "base").string());
+
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(record("kept", "", true));
+    groups.addRecord(record("added", "", false));
+    std::string html = (dir / "report.html").string();
+    std::string json_path = (dir / "report.json").string();
+    report_generator(groups, static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                     static_cast<int>(UnParsedDiffStatus::UN_CHANGED), html, json_path, BETA_PARSER, true);
+
+    json report = armor::readReportDocument(json_path);
+    ASSERT_EQ(report["api_diff"].size(), 1u);
+    EXPECT_EQ(report["api_diff"][0]["name"], "added");
+    EXPECT_EQ(report["compatibility"], "backward_compatible");
+    EXPECT_EQ(report["baseline"]["known"], 1);
+    EXPECT_TRUE(report["baseline"]["resolved"].empty());
+}
@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bench_sweep.hpp"
+
+class BenchSweepTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_bench_sweep_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string writeConfig(const std::string& text) {
+        std::filesystem::path path = dir / "sweep.yaml";
+        std::ofstream(path) << text;
+        return path.string();
+    }
+};
+
+TEST_F(BenchSweepTest, LoadsTheConfig) {
+    armor::BenchSweepConfig config = armor::loadBenchSweepConfig(writeConfig(
+        "base: corpus/base\n"
+        "head: /abs/head\n"
+        "header-config: armor.yml\n"
+        "branch: main\n"
+        "header-dir: include\n"
+        "include-paths: [deps]\n"
+        "jobs: 4\n"
+        "repeat: 3\n"));
+    EXPECT_EQ(config.base, (dir / "corpus/base").string());
+    EXPECT_EQ(config.head, "/abs/head");
+    EXPECT_EQ(config.headerConfig, (dir / "armor.yml").string());
+    EXPECT_EQ(config.branch, "main");
+    EXPECT_EQ(config.headerDir, "include");
+    EXPECT_EQ(config.includePaths, (std::vector<std::string>{(dir / "deps").string()}));
+    EXPECT_EQ(config.jobs, 4u);
+    EXPECT_EQ(config.repeat, 3u);
+
+    EXPECT_THROW(armor::loadBenchSweepConfig((dir / "missing.yaml").string()), std::runtime_error);
+    EXPECT_THROW(armor::loadBenchSweepConfig(writeConfig("base: a\nhead: b\nbranch: main\n")), std::runtime_error);
+    EXPECT_THROW(armor::loadBenchSweepConfig(writeConfig("base: a\nhead: b\nheader-config: c\nbranch: main\n"
+                                                         "repeat: 0\n")),
+                 std::runtime_error);
+}
+
+TEST_F(BenchSweepTest, SchedulesRoundsByBasename) {
+    auto rounds = armor::scheduleHeaderRounds({"a/api.h", "b/api.h", "a/util.h", "c/api.h", "b/util.h", "net.h"});
+    ASSERT_EQ(rounds.size(), 3u);
+    EXPECT_EQ(rounds[0], (std::vector<std::string>{"a/api.h", "a/util.h", "net.h"}));
+    EXPECT_EQ(rounds[1], (std::vector<std::string>{"b/api.h", "b/util.h"}));
+    EXPECT_EQ(rounds[2], (std::vector<std::string>{"c/api.h"}));
+    EXPECT_TRUE(armor::scheduleHeaderRounds({}).empty());
+}
+
+TEST_F(BenchSweepTest, SummarizesNearestRankPercentiles) {
+    std::vector<double> latencies;
+    for (int i = 100; i >= 1; --i) {
+        latencies.push_back(i);
+    }
+    armor::LatencySummary summary = armor::summarizeLatencies(latencies);
+    EXPECT_EQ(summary.count, 100u);
+    EXPECT_DOUBLE_EQ(summary.p50, 50);
+    EXPECT_DOUBLE_EQ(summary.p95, 95);
+    EXPECT_DOUBLE_EQ(summary.p99, 99);
+    EXPECT_DOUBLE_EQ(summary.max, 100);
+
+    armor::LatencySummary single = armor::summarizeLatencies({7});
+    EXPECT_DOUBLE_EQ(single.p50, 7);
+    EXPECT_DOUBLE_EQ(single.p99, 7);
+    EXPECT_EQ(armor::summarizeLatencies({}).count, 0u);
+}
@@ -0,0 +1,56 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticIDs.h"
+#include "clang/Basic/DiagnosticLex.h"
+#include "clang/Basic/DiagnosticOptions.h"
+
+#include "buffered_diagnostics.hpp"
+
+namespace {
+
+    class BufferedDiagnosticsTest : public ::testing::Test {
+        protected:
+            BufferedDiagnosticsTest()
+                : options(new clang::DiagnosticOptions()), consumer(options.get()),
+                  engine(new clang::DiagnosticIDs(), options, &consumer, false) {}
+
+            void report(clang::DiagnosticsEngine::Level level) {
+                engine.Report(engine.getCustomDiagID(level, "%0")) << "message";
+            }
+
+            llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> options;
+            armor::BufferedDiagnosticConsumer consumer;
+            clang::DiagnosticsEngine engine;
+    };
+
+}
+
+TEST_F(BufferedDiagnosticsTest, CountsEachLevel) {
+    report(clang::DiagnosticsEngine::Warning);
+    report(clang::DiagnosticsEngine::Error);
+    report(clang::DiagnosticsEngine::Error);
+    engine.Report(clang::diag::err_pp_file_not_found) << "missing.h";
+
+    const armor::DiagnosticCounts& counts = consumer.getCounts();
+    EXPECT_EQ(counts.warnings, 1u);
+    EXPECT_EQ(counts.errors, 3u);
+    EXPECT_EQ(counts.fatals, 1u);
+    EXPECT_EQ(counts.missingIncludes, 1u);
+    // The frontend action decides success by these
+    EXPECT_EQ(consumer.getNumErrors(), 3u);
+    EXPECT_EQ(consumer.getNumWarnings(), 1u);
+}
+
+TEST_F(BufferedDiagnosticsTest, ClearRestartsTheCounts) {
+    report(clang::DiagnosticsEngine::Error);
+    consumer.clear();
+
+    EXPECT_EQ(consumer.getCounts().errors, 0u);
+    EXPECT_EQ(consumer.getNumErrors(), 0u);
+
+    report(clang::DiagnosticsEngine::Warning);
+    EXPECT_EQ(consumer.getCounts().warnings, 1u);
+}
@@ -0,0 +1,115 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "cache_directory.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    class CacheDirectoryTest : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                dir = fs::temp_directory_path() /
+                      ("armor_cache_directory_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                       "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+                fs::remove_all(dir);
+                fs::create_directories(dir);
+            }
+
+            void TearDown() override { fs::remove_all(dir); }
+
+            // A file of `size` bytes last used `age` ago
+            fs::path writeFile(const std::string& name, size_t size, std::chrono::seconds age) {
+                fs::path path = dir / name;
+                fs::create_directories(path.parent_path());
+                std::ofstream(path, std::ios::binary) << std::string(size, 'x');
+                fs::last_write_time(path, fs::file_time_type::clock::now() - age);
+                return path;
+            }
+
+            fs::path dir;
+    };
+
+}
+
+TEST_F(CacheDirectoryTest, PublishReplacesAtomically) {
+    std::string path = (dir / "entry.cbor").string();
+    std::string error;
+    ASSERT_TRUE(armor::publishCacheFile(path, "first", error)) << error;
+    ASSERT_TRUE(armor::publishCacheFile(path, "second", error)) << error;
+    std::ifstream in(path);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, "second");
+    // No temporary file is left behind
+    EXPECT_EQ(std::distance(fs::directory_iterator(dir), fs::directory_iterator()), 1);
+
+    EXPECT_FALSE(armor::publishCacheFile((dir / "missing" / "entry").string(), "x", error));
+    EXPECT_FALSE(error.empty());
+}
+
+TEST_F(CacheDirectoryTest, SealDetectsCorruption) {
+    std::string sealed = armor::sealCacheEntry("payload bytes");
+    llvm::StringRef payload;
+    ASSERT_TRUE(armor::unsealCacheEntry(sealed, payload));
+    EXPECT_EQ(payload, "payload bytes");
+
+    std::string flipped = sealed;
+    flipped[3] ^= 0x20;
+    EXPECT_FALSE(armor::unsealCacheEntry(flipped, payload));
+    EXPECT_FALSE(armor::unsealCacheEntry(llvm::StringRef(sealed).drop_back(1), payload));
+    EXPECT_FALSE(armor::unsealCacheEntry("payload bytes", payload));
+    EXPECT_TRUE(armor::unsealCacheEntry(armor::sealCacheEntry(""), payload));
+    EXPECT_TRUE(payload.empty());
+}
+
+TEST_F(CacheDirectoryTest, EvictsLeastRecentlyUsedToNinetyPercent) {
+    fs::path oldest = writeFile("a.cbor", 400, std::chrono::seconds(300));
+    fs::path older = writeFile("results/b.json", 400, std::chrono::seconds(200));
+    fs::path used = writeFile("asts/c.ast", 400, std::chrono::seconds(100));
+    fs::path newest = writeFile("d.cbor", 400, std::chrono::seconds(0));
+    // A hit makes the oldest entry the most recently used
+    armor::touchCacheFile(oldest.string());
+    fs::path module = writeFile("modules/m.pcm", 4000, std::chrono::seconds(1000));
+
+    armor::EvictionResult result = armor::evictCacheEntries(dir.string(), {1000, std::chrono::seconds(0)});
+    EXPECT_FALSE(result.skipped);
+    EXPECT_EQ(result.evictedFiles, 2u);
+    EXPECT_EQ(result.evictedBytes, 800u);
+    EXPECT_EQ(result.keptBytes, 800u);
+    EXPECT_TRUE(fs::exists(oldest));
+    EXPECT_FALSE(fs::exists(older));
+    EXPECT_FALSE(fs::exists(used));
+    EXPECT_TRUE(fs::exists(newest));
+    EXPECT_TRUE(fs::exists(module));
+
+    // Within EVICTION_INTERVAL of the last eviction, others skip
+    EXPECT_TRUE(armor::evictCacheEntries(dir.string(), {1, std::chrono::seconds(0)}).skipped);
+    EXPECT_TRUE(fs::exists(newest));
+}
+
+TEST_F(CacheDirectoryTest, EvictsByAgeAndAbandonedTemporaries) {
+    fs::path stale = writeFile("a.cbor", 10, std::chrono::hours(24 * 10));
+    fs::path fresh = writeFile("b.cbor", 10, std::chrono::hours(1));
+    fs::path abandoned = writeFile("c.cbor-abc123.tmp", 10, std::chrono::hours(2));
+    fs::path writing = writeFile("d.cbor-def456.tmp", 10, std::chrono::seconds(5));
+
+    armor::EvictionResult result = armor::evictCacheEntries(dir.string(), {0, std::chrono::hours(24 * 7)});
+    EXPECT_EQ(result.evictedFiles, 2u);
+    EXPECT_FALSE(fs::exists(stale));
+    EXPECT_TRUE(fs::exists(fresh));
+    EXPECT_FALSE(fs::exists(abandoned));
+    EXPECT_TRUE(fs::exists(writing));
+}
+
+TEST_F(CacheDirectoryTest, UnboundedDoesNothing) {
+    fs::path entry = writeFile("a.cbor", 10, std::chrono::hours(24 * 1000));
+    EXPECT_TRUE(armor::evictCacheEntries(dir.string(), {}).skipped);
+    { armor::BackgroundEviction eviction(dir.string(), {}); }
+    EXPECT_TRUE(fs::exists(entry));
+}
@@ -197,4 +197,8 @@ TEST_F(CategorizationTest, InvalidUnparsedStatus) {
         false
     );
     EXPECT_EQ(serialize(OverAllStatus::CATEGORIZATION_ERROR), result);
-}
\ No newline at end of file
+}
+
+TEST_F(CategorizationTest, TimedOutIsSerialized) {
+    EXPECT_STREQ(serialize(OverAllStatus::TIMED_OUT), "TIMED_OUT");
+}
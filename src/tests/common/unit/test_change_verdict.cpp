@@ -0,0 +1,234 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include "comm_def.hpp"
+#include "diff_utils.hpp"
+#include "report_generator.hpp"
+#include "report_utils.hpp"
+
+namespace {
+
+    json node(const std::string& nodeType, const std::string& tag, const std::string& name,
+              json children = json::array()) {
+        return json{{"nodeType", nodeType}, {"tag", tag}, {"qualifiedName", name}, {"children", children}};
+    }
+
+    json moved(const std::string& nodeType, const std::string& oldName, const std::string& name) {
+        return json{{"nodeType", nodeType}, {"tag", "moved"}, {"qualifiedName", name}, {"oldQualifiedName", oldName}};
+    }
+
+    json typeChanged(const std::string& oldType, const std::string& newType, size_t users) {
+        json affected = json::array();
+        for (size_t i = 0; i < users; ++i) {
+            affected.push_back("f" + std::to_string(i) + "::p:Parameter");
+        }
+        return json{{"tag", "type_changed"}, {"qualifiedName", oldType}, {"newType", newType}, {"affected", affected}};
+    }
+
+    // The verdict preprocess_api_changes() gives the records of `change`
+    bool recordsIncompatible(const json& change) {
+        for (const auto& record : preprocess_api_changes(json::array({change}), "include/foo.h")) {
+            if (record.backwardIncompatible) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<json> sampleChanges() {
+        return {
+            node("Struct", "added", "S"),
+            node("Struct", "removed", "S"),
+            node("Enum", "modified", "E", json::array({node("Enumerator", "added", "E::B")})),
+            node("Enum", "modified", "E", json::array({node("Enumerator", "removed", "E::B")})),
+            node("Struct", "modified", "S", json::array({node("Field", "added", "S::b")})),
+            node("Struct", "modified", "S", json::array({node("Field", "removed", "S::b")})),
+            node("Function", "added", "f"),
+            node("Function", "removed", "f"),
+            node("Function", "modified", "f",
+                 json::array({node("Parameter", "added", "f::b"), node("Parameter", "removed", "f::a")})),
+            node("Function", "modified", "f"),
+            moved("Struct", "a::S", "b::S"),
+            moved("Function", "f", "g"),
+            typeChanged("foo_v1", "foo_v2", 3),
+        };
+    }
+
+}
+
+class ChangeVerdictTest : public ::testing::Test {
+protected:
+    void SetUp() override { ReportSummaries::getInstance().clear(); }
+    void TearDown() override { ReportSummaries::getInstance().clear(); }
+};
+
+TEST_F(ChangeVerdictTest, AgreesWithChangeRecords) {
+    for (const json& change : sampleChanges()) {
+        EXPECT_EQ(is_backward_incompatible_change(change), recordsIncompatible(change)) << change.dump();
+    }
+}
+
+TEST_F(ChangeVerdictTest, OnlyAdditionsAreCompatible) {
+    EXPECT_FALSE(is_backward_incompatible_change(node("Struct", "added", "S")));
+    EXPECT_FALSE(is_backward_incompatible_change(
+        node("Enum", "modified", "E", json::array({node("Enumerator", "added", "E::B")}))));
+    EXPECT_TRUE(is_backward_incompatible_change(node("Struct", "removed", "S")));
+    EXPECT_TRUE(is_backward_incompatible_change(node("Function", "modified", "f")));
+}
+
+TEST_F(ChangeVerdictTest, VerdictIsRecordedAsTheReportWouldBe) {
+    json diff{{"parsed_status", static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES)},
+              {"unparsed_status", static_cast<int>(UnParsedDiffStatus::UN_CHANGED)},
+              {"astDiff", json::array({node("Struct", "added", "S"), node("Function", "removed", "f")})}};
+    EXPECT_STREQ(report_verdict(diff, "include/foo.h"), "BACKWARD_INCOMPATIBLE");
+
+    ReportSummaries::Summary summary;
+    ASSERT_TRUE(ReportSummaries::getInstance().find("include/foo.h", summary));
+    EXPECT_EQ(summary.overallStatus, "BACKWARD_INCOMPATIBLE");
+    EXPECT_TRUE(summary.apiNames.empty());
+
+    diff["astDiff"] = json::array({node("Struct", "added", "S")});
+    EXPECT_STREQ(report_verdict(diff, "include/foo.h"), "BACKWARD_COMPATIBLE");
+}
+
+TEST_F(ChangeVerdictTest, MovedDeclarationIsOneIncompatibleRecordUnderItsOldName) {
+    std::vector<ChangeRecord> records = preprocess_api_changes(
+        json::array({moved("Struct", "a::S", "b::S"), moved("Function", "a::f", "a::g")}), "include/foo.h");
+    ASSERT_EQ(records.size(), 2u);
+
+    EXPECT_EQ(records[0].name, "a::S:Struct");
+    EXPECT_EQ(records[0].description, "Struct moved: 'a::S' to 'b::S'");
+    EXPECT_TRUE(records[0].backwardIncompatible);
+
+    EXPECT_EQ(records[1].name, "a::f:Function");
+    EXPECT_EQ(records[1].description, "Function renamed: 'a::f' to 'a::g'");
+    EXPECT_TRUE(records[1].backwardIncompatible);
+}
+
+TEST_F(ChangeVerdictTest, ReplacedTypeNameIsOneIncompatibleRecord) {
+    std::vector<ChangeRecord> records =
+        preprocess_api_changes(json::array({typeChanged("foo_v1", "foo_v2", 2)}), "include/foo.h");
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].name, "foo_v1");
+    EXPECT_EQ(records[0].description,
+              "Type 'foo_v1' replaced by 'foo_v2' in 2 declarations: f0::p:Parameter, f1::p:Parameter");
+    EXPECT_TRUE(records[0].backwardIncompatible);
+
+    // Thousands of users still make one row of bounded length
+    records = preprocess_api_changes(json::array({typeChanged("foo_v1", "foo_v2", 5000)}), "include/foo.h");
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_NE(records[0].description.find("in 5000 declarations"), std::string::npos);
+    EXPECT_NE(records[0].description.find("and 4980 more"), std::string::npos);
+    EXPECT_LT(records[0].description.size(), 1024u);
+}
+
+TEST_F(ChangeVerdictTest, ChangedRecordLayoutIsIncompatible) {
+    json removedLayout = node("Struct", "removed", "S");
+    removedLayout["layout"] = "size=4 align=4 a@0";
+    json addedLayout = node("Struct", "added", "S");
+    addedLayout["layout"] = "size=8 align=4 a@0 b@4";
+    json change =
+        node("Struct", "modified", "S", json::array({node("Field", "added", "S::b"), removedLayout, addedLayout}));
+    EXPECT_TRUE(is_backward_incompatible_change(change));
+
+    std::vector<ChangeRecord> records = preprocess_api_changes(json::array({change}), "include/foo.h");
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_TRUE(records[0].backwardIncompatible);
+    EXPECT_NE(records[0].description.find("Struct 'S' layout changed from 'size=4 align=4 a@0' to "
+                                          "'size=8 align=4 a@0 b@4'"),
+              std::string::npos)
+        << records[0].description;
+}
+
+TEST_F(ChangeVerdictTest, ReorderedMembersAreIncompatibleRecords) {
+    json field = node("Field", "re-ordered", "S::b");
+    field["oldIndex"] = 1;
+    field["newIndex"] = 0;
+    json change = node("Struct", "modified", "S", json::array({field}));
+    EXPECT_TRUE(is_backward_incompatible_change(change));
+    std::vector<ChangeRecord> records = preprocess_api_changes(json::array({change}), "include/foo.h");
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_TRUE(records[0].backwardIncompatible);
+    EXPECT_NE(records[0].description.find("Field 'S::b' moved from position 1 to 0"), std::string::npos)
+        << records[0].description;
+
+    json parameter = node("Parameter", "re-ordered", "f::x");
+    parameter["oldIndex"] = 0;
+    parameter["newIndex"] = 2;
+    records = preprocess_api_changes(json::array({node("Function", "modified", "f", json::array({parameter}))}),
+                                     "include/foo.h");
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].description, "Parameter 'f::x' moved from position 0 to 2");
+    EXPECT_TRUE(records[0].backwardIncompatible);
+}
+
+TEST_F(ChangeVerdictTest, GroupsAreSortedAndMergedWhateverTheRecordOrder) {
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(ChangeRecord{"include/foo.h", "g", "second", true, false});
+    groups.addRecord(ChangeRecord{"include/bar.h", "g", "other header", false, false});
+    groups.addRecord(ChangeRecord{"include/foo.h", "f", "first", true, true});
+    groups.addRecord(ChangeRecord{"include/foo.h", "g", "third", false, true});
+
+    std::vector<std::pair<std::string, std::string>> order;
+    for (const ApiChangeGroups::Group& group : groups) {
+        order.emplace_back(group.headerfile, group.name);
+    }
+    EXPECT_EQ(order, (std::vector<std::pair<std::string, std::string>>{
+        {"include/bar.h", "g"}, {"include/foo.h", "f"}, {"include/foo.h", "g"}}));
+
+    // Records added after iterating still find their group
+    groups.addRecord(ChangeRecord{"include/foo.h", "f", "fourth", false, false});
+    ASSERT_EQ(groups.size(), 3u);
+    const ApiChangeGroups::Group& f = *std::next(groups.begin());
+    EXPECT_EQ(f.descriptions, (std::vector<std::string>{"first", "fourth"}));
+    const ApiChangeGroups::Group& g = *std::next(groups.begin(), 2);
+    EXPECT_EQ(g.description(), "second\nthird");
+    EXPECT_TRUE(g.anyCompatibilityChanged);
+    EXPECT_TRUE(g.anyBackwardIncompatible);
+    EXPECT_TRUE(groups.hasBackwardIncompatible());
+}
+
+TEST_F(ChangeVerdictTest, RecordsRoundTripThroughJson) {
+    ChangeRecord record{"include/foo.h", "f", "changed", true, false};
+    json form = record.toJson();
+    EXPECT_EQ(form["changetype"], "Compatibility_changed");
+    EXPECT_EQ(form["compatibility"], "backward_compatible");
+
+    ChangeRecord back = ChangeRecord::fromJson(form);
+    EXPECT_EQ(back.headerfile, record.headerfile);
+    EXPECT_EQ(back.name, record.name);
+    EXPECT_EQ(back.description, record.description);
+    EXPECT_TRUE(back.compatibilityChanged);
+    EXPECT_FALSE(back.backwardIncompatible);
+}
+
+TEST_F(ChangeVerdictTest, ParallelChunksKeepTheOrderOfTheEntries) {
+    json changes = json::array();
+    for (size_t i = 0; changes.size() < 2000; ++i) {
+        for (json change : sampleChanges()) {
+            change["qualifiedName"] = change.value("qualifiedName", "") + std::to_string(i);
+            changes.push_back(std::move(change));
+        }
+    }
+    std::vector<ChangeRecord> serial = preprocess_api_changes(changes, "include/foo.h");
+    std::vector<ChangeRecord> parallel = preprocess_api_changes(changes, "include/foo.h", 4);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i].toJson(), parallel[i].toJson()) << "record " << i;
+    }
+
+    ApiChangeGroups one("include/foo.h");
+    for (const auto& change : changes) {
+        one.addChange(change);
+    }
+    ApiChangeGroups chunked("include/foo.h");
+    chunked.addChanges(changes, 4);
+    ASSERT_EQ(one.size(), chunked.size());
+    for (auto a = one.begin(), b = chunked.begin(); a != one.end(); ++a, ++b) {
+        EXPECT_EQ(a->toRecord(), b->toRecord());
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "changed_ranges.hpp"
+
+class ChangedRangesTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_changed_ranges_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string write(const std::string& content) {
+        std::filesystem::path p = dir / "ranges.json";
+        std::ofstream out(p, std::ios::trunc);
+        out << content;
+        return p.string();
+    }
+};
+
+TEST_F(ChangedRangesTest, FindsHeaderRelativeToProjectRoot) {
+    armor::ChangedRanges ranges = armor::ChangedRanges::load(
+        write(R"({"include/foo.h": {"old": [[10, 12]], "new": [[10, 14], [20, 20]]}})"));
+
+    const armor::HeaderChanges* changes = ranges.find("/work/head", "/work/head/include/./foo.h");
+    ASSERT_NE(changes, nullptr);
+    ASSERT_EQ(changes->oldLines.size(), 1u);
+    ASSERT_EQ(changes->newLines.size(), 2u);
+    EXPECT_EQ(changes->newLines[1].begin, 20u);
+
+    EXPECT_EQ(ranges.find("/work/head", "/work/head/include/bar.h"), nullptr);
+}
+
+TEST_F(ChangedRangesTest, IntersectsOverlappingLines) {
+    std::vector<armor::LineRange> lines{{10, 12}, {30, 30}};
+    EXPECT_TRUE(armor::HeaderChanges::intersects(lines, 12, 20));
+    EXPECT_TRUE(armor::HeaderChanges::intersects(lines, 25, 35));
+    EXPECT_FALSE(armor::HeaderChanges::intersects(lines, 13, 29));
+    EXPECT_FALSE(armor::HeaderChanges::intersects({}, 1, 100));
+}
+
+TEST_F(ChangedRangesTest, RejectsMalformedInput) {
+    EXPECT_THROW(armor::ChangedRanges::load(write(R"({"foo.h": {"old": [[5, 1]], "new": []}})")),
+                 std::runtime_error);
+    EXPECT_THROW(armor::ChangedRanges::load(write(R"({"foo.h": {"new": []}})")), std::runtime_error);
+    EXPECT_THROW(armor::ChangedRanges::load((dir / "missing.json").string()), std::runtime_error);
+}
@@ -0,0 +1,149 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "chunk_store.hpp"
+
+namespace {
+
+    std::string randomBytes(std::size_t size, uint32_t seed) {
+        std::mt19937 random(seed);
+        std::string bytes(size, '\0');
+        for (char& c : bytes) {
+            c = static_cast<char>(random() & 0xFF);
+        }
+        return bytes;
+    }
+
+}
+
+class ChunkStoreTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_chunk_store_test";
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(ChunkStoreTest, ChunksCoverTheBytesWithinTheirBounds) {
+    std::string bytes = randomBytes(4 << 20, 1);
+    std::vector<llvm::StringRef> chunks = armor::splitIntoChunks(bytes);
+    ASSERT_GT(chunks.size(), 16u);
+    std::string joined;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        EXPECT_LE(chunks[i].size(), 256u << 10);
+        if (i + 1 < chunks.size()) {
+            EXPECT_GE(chunks[i].size(), 16u << 10);
+        }
+        joined += chunks[i].str();
+    }
+    EXPECT_EQ(joined, bytes);
+    EXPECT_TRUE(armor::splitIntoChunks("").empty());
+    EXPECT_EQ(armor::splitIntoChunks("short").size(), 1u);
+}
+
+TEST_F(ChunkStoreTest, AnEditLeavesTheOtherChunksShared) {
+    std::string older = randomBytes(4 << 20, 2);
+    std::string newer = older;
+    newer.insert(1000000, "an inserted declaration");
+    newer[3000000] ^= 0x55;
+
+    std::set<std::string> olderKeys;
+    for (llvm::StringRef chunk : armor::splitIntoChunks(older)) {
+        olderKeys.insert(armor::ChunkStore::keyOf(chunk));
+    }
+    std::vector<llvm::StringRef> newerChunks = armor::splitIntoChunks(newer);
+    std::size_t changed = 0;
+    for (llvm::StringRef chunk : newerChunks) {
+        changed += olderKeys.count(armor::ChunkStore::keyOf(chunk)) == 0;
+    }
+    // Each edit changes the chunk it falls in, and at most the one after it
+    EXPECT_GE(changed, 2u);
+    EXPECT_LE(changed, 4u);
+}
+
+TEST_F(ChunkStoreTest, ManifestsAssembleFromHeldAndFetchedChunks) {
+    armor::ChunkStore store(dir.string());
+    std::string bytes = randomBytes(1 << 20, 3);
+    std::vector<llvm::StringRef> chunks;
+    std::string manifest = armor::ChunkStore::manifestOf(bytes, chunks);
+    ASSERT_GT(chunks.size(), 2u);
+
+    std::map<std::string, std::string> remote;
+    for (llvm::StringRef chunk : chunks) {
+        remote[armor::ChunkStore::keyOf(chunk)] = chunk.str();
+    }
+    auto fetch = [&](const std::string& key, std::string& chunk) {
+        auto it = remote.find(key);
+        if (it == remote.end()) {
+            return false;
+        }
+        chunk = it->second;
+        return true;
+    };
+
+    // Only the chunk held already is not fetched
+    store.store(chunks[1]);
+    EXPECT_TRUE(store.contains(armor::ChunkStore::keyOf(chunks[1])));
+    EXPECT_FALSE(store.contains(armor::ChunkStore::keyOf(chunks[0])));
+    std::string assembled;
+    std::size_t fetched = 0;
+    ASSERT_TRUE(store.assemble(manifest, fetch, assembled, &fetched));
+    EXPECT_EQ(assembled, bytes);
+    EXPECT_EQ(fetched, chunks.size() - 1);
+
+    // Every chunk is held now
+    remote.clear();
+    ASSERT_TRUE(store.assemble(manifest, fetch, assembled, &fetched));
+    EXPECT_EQ(assembled, bytes);
+    EXPECT_EQ(fetched, 0u);
+}
+
+TEST_F(ChunkStoreTest, CorruptChunksAreFetchedAgainAndMissingOnesFail) {
+    armor::ChunkStore store(dir.string());
+    std::string bytes = randomBytes(200000, 4);
+    std::vector<llvm::StringRef> chunks;
+    std::string manifest = armor::ChunkStore::manifestOf(bytes, chunks);
+    for (llvm::StringRef chunk : chunks) {
+        store.store(chunk);
+    }
+    std::string key = armor::ChunkStore::keyOf(chunks[0]);
+    {
+        std::ofstream out(dir / "chunks" / key, std::ios::binary | std::ios::trunc);
+        out << "not the chunk";
+    }
+
+    std::string assembled;
+    auto none = [](const std::string&, std::string&) { return false; };
+    EXPECT_FALSE(store.assemble(manifest, none, assembled));
+    EXPECT_FALSE(store.contains(key));
+
+    // A fetched chunk must match its key
+    auto wrong = [](const std::string&, std::string& chunk) {
+        chunk = "something else";
+        return true;
+    };
+    EXPECT_FALSE(store.assemble(manifest, wrong, assembled));
+    auto right = [&](const std::string& asked, std::string& chunk) {
+        EXPECT_EQ(asked, key);
+        chunk = chunks[0].str();
+        return true;
+    };
+    ASSERT_TRUE(store.assemble(manifest, right, assembled));
+    EXPECT_EQ(assembled, bytes);
+
+    EXPECT_FALSE(store.assemble("not a manifest", right, assembled));
+}
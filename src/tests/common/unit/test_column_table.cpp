@@ -0,0 +1,37 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "column_table.hpp"
+
+TEST(ColumnTableTest, StringColumnsAreDictionaryEncoded) {
+    armor::ColumnTable table;
+    std::size_t kind = table.addStringColumn("kind");
+    std::size_t line = table.addIntColumn("line");
+    table.append(kind, "Function");
+    table.append(line, int64_t{3});
+    table.append(kind, "Parameter");
+    table.append(line, int64_t{3});
+    table.append(kind, "Function");
+    table.append(line, int64_t{7});
+    EXPECT_EQ(table.rows(), 3u);
+
+    nlohmann::json json = table.toJson();
+    EXPECT_EQ(json["rows"], 3);
+    ASSERT_EQ(json["columns"].size(), 2u);
+    const nlohmann::json& kinds = json["columns"][0];
+    EXPECT_EQ(kinds["name"], "kind");
+    EXPECT_EQ(kinds["type"], "string");
+    EXPECT_EQ(kinds["dictionary"], nlohmann::json({"Function", "Parameter"}));
+    EXPECT_EQ(kinds["indices"], nlohmann::json({0, 1, 0}));
+    const nlohmann::json& lines = json["columns"][1];
+    EXPECT_EQ(lines["type"], "int64");
+    EXPECT_EQ(lines["values"], nlohmann::json({3, 3, 7}));
+}
+
+TEST(ColumnTableTest, EmptyTable) {
+    armor::ColumnTable table;
+    EXPECT_EQ(table.rows(), 0u);
+    table.addStringColumn("name");
+    EXPECT_EQ(table.toJson()["columns"][0]["dictionary"], nlohmann::json::array());
+}
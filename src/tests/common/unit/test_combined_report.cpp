@@ -0,0 +1,102 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "comm_def.hpp"
+#include "diff_utils.hpp"
+#include "report_generator.hpp"
+#include "report_utils.hpp"
+
+class CombinedHtmlReportTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_combined_report_test";
+        std::filesystem::create_directories(dir);
+        ReportSummaries::getInstance().clear();
+    }
+
+    void TearDown() override {
+        if (CombinedHtmlReport::getInstance().isOpen()) {
+            CombinedHtmlReport::getInstance().close();
+        }
+        ReportSummaries::getInstance().clear();
+        std::filesystem::remove_all(dir);
+    }
+
+    json record(const std::string& header, const std::string& name, const char* compatibility) {
+        return json{{"headerfile", header},
+                    {"name", name},
+                    {"description", "changed <T>"},
+                    {"changetype", "Compatibility_changed"},
+                    {"compatibility", compatibility}};
+    }
+
+    static std::string read(const std::filesystem::path& path) {
+        std::ifstream in(path);
+        std::ostringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+};
+
+TEST_F(CombinedHtmlReportTest, ReportsBecomeSectionsOfOnePage) {
+    std::filesystem::path page = dir / "armor_reports" / "api_diff_report.html";
+    CombinedHtmlReport& combined = CombinedHtmlReport::getInstance();
+    combined.open(page.string());
+    ASSERT_TRUE(combined.isOpen());
+
+    ApiChangeGroups foo("include/foo.h");
+    foo.addRecord(record("include/foo.h", "foo", "backward_incompatible"));
+    report_generator(foo, static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                     static_cast<int>(UnParsedDiffStatus::UN_CHANGED), (dir / "foo.html").string(), "", BETA_PARSER);
+    combined.addMissingHeader("include/bar.h", "BACKWARD_COMPATIBLE", "Missing header in older version");
+
+    ASSERT_TRUE(combined.close());
+    EXPECT_FALSE(combined.isOpen());
+    EXPECT_FALSE(std::filesystem::exists(dir / "foo.html"));
+
+    // Summaries are still recorded for --ndjson-out
+    ReportSummaries::Summary summary;
+    ASSERT_TRUE(ReportSummaries::getInstance().find("include/foo.h", summary));
+    EXPECT_EQ(summary.overallStatus, "BACKWARD_INCOMPATIBLE");
+
+    std::string html = read(page);
+    EXPECT_NE(html.find("<section id=\"header-0\">\n<h2>include/foo.h</h2>"), std::string::npos);
+    EXPECT_NE(html.find("<section id=\"header-1\">\n<h2>include/bar.h</h2>"), std::string::npos);
+    EXPECT_NE(html.find("changed &lt;T&gt;"), std::string::npos);
+    EXPECT_NE(html.find("Missing header in older version"), std::string::npos);
+
+    // The index comes last in the file, sorted by header path
+    size_t index = html.find("<div class=\"index\">");
+    ASSERT_NE(index, std::string::npos);
+    EXPECT_GT(index, html.find("<section id=\"header-1\">"));
+    size_t bar = html.find("<a href=\"#header-1\">include/bar.h</a>", index);
+    size_t fooRow = html.find("<a href=\"#header-0\">include/foo.h</a>", index);
+    ASSERT_NE(bar, std::string::npos);
+    ASSERT_NE(fooRow, std::string::npos);
+    EXPECT_LT(bar, fooRow);
+    EXPECT_NE(html.find("Headers (2)"), std::string::npos);
+}
+
+TEST_F(CombinedHtmlReportTest, ClosedReportLeavesPerHeaderFiles) {
+    ASSERT_FALSE(CombinedHtmlReport::getInstance().isOpen());
+
+    ApiChangeGroups foo("include/foo.h");
+    foo.addRecord(record("include/foo.h", "foo", "backward_compatible"));
+    report_generator(foo, static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                     static_cast<int>(UnParsedDiffStatus::UN_CHANGED), (dir / "foo.html").string(), "", BETA_PARSER);
+
+    EXPECT_TRUE(std::filesystem::exists(dir / "foo.html"));
+}
+
+TEST_F(CombinedHtmlReportTest, UnwritablePathThrows) {
+    std::filesystem::path blocker = dir / "file";
+    std::ofstream(blocker) << "x";
+    EXPECT_THROW(CombinedHtmlReport::getInstance().open((blocker / "report.html").string()), std::exception);
+    EXPECT_FALSE(CombinedHtmlReport::getInstance().isOpen());
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <zlib.h>
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "compressed_output.hpp"
+
+namespace {
+
+    // Every gzip member of `path`, decompressed and concatenated
+    std::string gunzip(const std::string& path) {
+        std::string text;
+        gzFile file = gzopen(path.c_str(), "rb");
+        if (!file) {
+            return text;
+        }
+        char chunk[4096];
+        int read = 0;
+        while ((read = gzread(file, chunk, sizeof(chunk))) > 0) {
+            text.append(chunk, read);
+        }
+        gzclose(file);
+        return text;
+    }
+
+    std::string sampleText() {
+        std::string text;
+        for (int i = 0; i < 20000; ++i) {
+            text += "[DEBUG] diagnostic line " + std::to_string(i) + " of a translation unit\n";
+        }
+        return text;
+    }
+
+}
+
+TEST(CompressedOutputTest, GzipOStreamRoundTripsAndShrinks) {
+    std::string path = (std::filesystem::temp_directory_path() / "armor_compressed_dump.json.gz").string();
+    std::string text = sampleText();
+    {
+        std::ofstream file(path, std::ios::trunc | std::ios::binary);
+        armor::GzipOStream out(file);
+        out << text;
+        out.finish();
+    }
+    EXPECT_EQ(gunzip(path), text);
+    EXPECT_LT(std::filesystem::file_size(path), text.size() / 4);
+    std::filesystem::remove(path);
+}
+
+TEST(CompressedOutputTest, AppendedRunsReadBackAsOneLog) {
+    std::string path = (std::filesystem::temp_directory_path() / "armor_compressed.log.gz").string();
+    std::filesystem::remove(path);
+    for (const char* run : {"first run\n", "second run\n"}) {
+        std::error_code ec;
+        auto file = std::make_unique<llvm::raw_fd_ostream>(path, ec, llvm::sys::fs::OF_Append);
+        ASSERT_FALSE(ec);
+        armor::GzipRawOStream log(std::move(file));
+        log << run;
+    }
+    EXPECT_EQ(gunzip(path), "first run\nsecond run\n");
+    std::filesystem::remove(path);
+}
+
+TEST(CompressedOutputTest, FlushedLogIsReadableBeforeItIsClosed) {
+    std::string path = (std::filesystem::temp_directory_path() / "armor_flushed.log.gz").string();
+    std::error_code ec;
+    auto file = std::make_unique<llvm::raw_fd_ostream>(path, ec, llvm::sys::fs::OF_None);
+    ASSERT_FALSE(ec);
+    armor::GzipRawOStream log(std::move(file));
+    log << "written before a crash\n";
+    log.flush();
+    EXPECT_EQ(gunzip(path), "written before a crash\n");
+}
+
+TEST(CompressedOutputTest, GzipPathsAreToldByExtension) {
+    EXPECT_TRUE(armor::isGzipPath("debug_output/logs/diagnostics.log.gz"));
+    EXPECT_FALSE(armor::isGzipPath("debug_output/logs/diagnostics.log"));
+}
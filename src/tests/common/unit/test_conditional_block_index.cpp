@@ -0,0 +1,92 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include "conditional_block_index.hpp"
+
+namespace {
+
+    // Indexes every conditional of `text`, each "#if X\n...\n#endif\n",
+    // with one range over each whole conditional, hashed as its length
+    struct Parse {
+        ConditionalBlockIndex index;
+        std::vector<int> branches;
+        std::vector<std::pair<unsigned, unsigned>> ranges;
+
+        explicit Parse(const std::string& text) {
+            std::size_t start = 0;
+            while ((start = text.find("#if", start)) != std::string::npos) {
+                std::size_t end = text.find("#endif", start) + 6;
+                index.openConditional(llvm::StringRef(text).slice(start, text.find('\n', start)), start);
+                branches.push_back(index.currentBranch());
+                ranges.emplace_back(start, end);
+                index.closeConditional(end);
+                start = end;
+            }
+        }
+
+        // How many ranges came from `previous`
+        std::size_t hash(const std::string& text, std::shared_ptr<const ConditionalBlockIndex::Snapshot> previous) {
+            index.reuseFrom(std::move(previous), text);
+            std::size_t reused = 0;
+            for (std::size_t i = 0; i < ranges.size(); ++i) {
+                auto [start, end] = ranges[i];
+                std::optional<uint64_t> hash = index.previousHash(branches[i], start, end, false);
+                if (hash) {
+                    EXPECT_EQ(*hash, end - start);
+                    ++reused;
+                }
+                index.record(branches[i], start, end, false, end - start);
+            }
+            return reused;
+        }
+    };
+
+}
+
+TEST(ConditionalBlockIndexTest, EditRehashesOnlyTheBranchItTouches) {
+    std::string before = "#if A\nint a;\n#endif\n#if B\nint b;\n#endif\n";
+    Parse first(before);
+    EXPECT_EQ(first.hash(before, nullptr), 0u);
+    std::shared_ptr<const ConditionalBlockIndex::Snapshot> snapshot = first.index.takeSnapshot(before);
+
+    // Growing the first block moves the second, which is still reused
+    std::string after = "#if A\nint a, aa;\n#endif\n#if B\nint b;\n#endif\n";
+    Parse second(after);
+    EXPECT_EQ(second.hash(after, snapshot), 1u);
+    EXPECT_EQ(second.index.getReusedBranches(), 1u);
+    EXPECT_EQ(second.index.getHashedBranches(), 1u);
+}
+
+TEST(ConditionalBlockIndexTest, ChangedDirectiveMisses) {
+    std::string before = "#if A\nint a;\n#endif\n";
+    Parse first(before);
+    first.hash(before, nullptr);
+    std::shared_ptr<const ConditionalBlockIndex::Snapshot> snapshot = first.index.takeSnapshot(before);
+
+    std::string after = "int x;\n#if C\nint a;\n#endif\n";
+    Parse second(after);
+    EXPECT_EQ(second.hash(after, snapshot), 0u);
+
+    // Unchanged text reuses everything
+    Parse third(before);
+    EXPECT_EQ(third.hash(before, snapshot), 1u);
+}
+
+TEST(ConditionalBlockIndexTest, SiblingBranchesHaveDistinctKeys) {
+    ConditionalBlockIndex index;
+    index.openConditional("#if A", 0);
+    index.nextBranch("#else", 10, 15);
+    index.closeConditional(30);
+    index.openConditional("#if A", 30);
+    index.closeConditional(50);
+    const std::vector<ConditionalBlockIndex::Branch>& branches = index.getBranches();
+    ASSERT_EQ(branches.size(), 3u);
+    EXPECT_NE(branches[0].key, branches[1].key);
+    EXPECT_NE(branches[0].key, branches[2].key);
+    EXPECT_EQ(branches[0].endOffset, 15u);
+    EXPECT_EQ(branches[1].startOffset, 10u);
+    EXPECT_EQ(index.lastClosedBranch(), 2);
+    EXPECT_EQ(index.currentBranch(), ConditionalBlockIndex::NO_BRANCH);
+}
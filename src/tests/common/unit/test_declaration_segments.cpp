@@ -0,0 +1,104 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "declaration_segments.hpp"
+
+using armor::DeclarationSegment;
+using armor::QuickDiff;
+using armor::quickDiff;
+using armor::segmentDeclarations;
+
+namespace {
+
+    std::vector<std::string> describe(const std::vector<DeclarationSegment>& segments) {
+        std::vector<std::string> result;
+        for (const DeclarationSegment& segment : segments) {
+            result.push_back(segment.kind + " " + segment.name);
+        }
+        return result;
+    }
+
+}
+
+TEST(DeclarationSegmentsTest, NamesTopLevelDeclarations) {
+    const char* header =
+        "#ifndef H\n"
+        "#define H\n"
+        "struct Point { int x; int y; };\n"
+        "enum class Mode : int { A, B };\n"
+        "class Widget;\n"
+        "typedef struct { int v; } Value, *ValuePtr;\n"
+        "typedef int (*Callback)(void*);\n"
+        "using Size = unsigned long;\n"
+        "extern int counter;\n"
+        "static const char* names[] = {\"a\", \"b\"};\n"
+        "int add(int a, int b);\n"
+        "inline int twice(int a) { return a * 2; }\n"
+        "void (*handler)(int);\n"
+        "template <class T> struct Box<T*> { T* p; };\n"
+        "bool operator==(const Point&, const Point&);\n"
+        "static_assert(sizeof(int) == 4, \"int\");\n"
+        "#endif\n";
+    EXPECT_EQ(describe(segmentDeclarations(header)),
+              (std::vector<std::string>{"directive #ifndef H", "macro H", "struct Point", "enum Mode",
+                                        "class Widget", "typedef Value", "typedef Callback", "alias Size",
+                                        "variable counter", "variable names", "function add", "function twice",
+                                        "variable handler", "struct Box<T*>", "function operator==",
+                                        "declaration static_assert(sizeof(int)==4,\"int\")", "directive #endif"}));
+}
+
+TEST(DeclarationSegmentsTest, EntersNamespacesAndExternBlocks) {
+    const char* header =
+        "namespace outer { namespace inner {\n"
+        "int f();\n"
+        "} }\n"
+        "namespace { int hidden; }\n"
+        "extern \"C\" {\n"
+        "void c_api(void);\n"
+        "}\n"
+        "int outer::inner::f() { return 1; }\n";
+    EXPECT_EQ(describe(segmentDeclarations(header)),
+              (std::vector<std::string>{"function outer::inner::f", "variable (anonymous namespace)::hidden",
+                                        "function c_api", "function outer::inner::f"}));
+}
+
+TEST(DeclarationSegmentsTest, LinesAndHashesIgnoreLayout) {
+    std::vector<DeclarationSegment> segments = segmentDeclarations("// doc\n\nint f(\n  int a);\n/* x */ int g();\n");
+    ASSERT_EQ(segments.size(), 2u);
+    EXPECT_EQ(segments[0].line, 3u);
+    EXPECT_EQ(segments[1].line, 5u);
+    EXPECT_EQ(segmentDeclarations("int f(int a);")[0].hash, segments[0].hash);
+    EXPECT_NE(segmentDeclarations("int f(long a);")[0].hash, segments[0].hash);
+    // A directive splitting over lines is the same directive
+    EXPECT_EQ(segmentDeclarations("#define A 1 \\\n  + 2\n")[0].hash, segmentDeclarations("#define A 1 + 2\n")[0].hash);
+}
+
+TEST(DeclarationSegmentsTest, CommentOnlyChangesAreEmpty) {
+    QuickDiff diff = quickDiff("/* v1 */\nint f(int);\nstruct S { int x; };\n",
+                               "/* v2, reworded */\nint f(int); // same\n\nstruct S {\n  int x; // doc\n};\n");
+    EXPECT_TRUE(diff.added.empty());
+    EXPECT_TRUE(diff.removed.empty());
+    EXPECT_TRUE(diff.modified.empty());
+}
+
+TEST(DeclarationSegmentsTest, ReportsAddedRemovedAndModified) {
+    QuickDiff diff = quickDiff("int f(int);\nint g();\nstruct S { int x; };\n#define LIMIT 4\n",
+                               "int f(int);\nstruct S { int x; int y; };\n#define LIMIT 8\nint h();\n");
+    EXPECT_EQ(describe(diff.added), std::vector<std::string>{"function h"});
+    EXPECT_EQ(describe(diff.removed), std::vector<std::string>{"function g"});
+    EXPECT_EQ(describe(diff.modified), (std::vector<std::string>{"struct S", "macro LIMIT"}));
+    EXPECT_EQ(diff.modified[0].line, 2u);
+}
+
+TEST(DeclarationSegmentsTest, OverloadsPairByContent) {
+    // Reordering overloads changes nothing; changing one reports it alone
+    EXPECT_TRUE(quickDiff("int f(int);\nint f(long);\n", "int f(long);\nint f(int);\n").modified.empty());
+    QuickDiff diff = quickDiff("int f(int);\nint f(long);\n", "int f(int);\nint f(short);\n");
+    ASSERT_EQ(diff.modified.size(), 1u);
+    EXPECT_EQ(diff.modified[0].line, 2u);
+    EXPECT_TRUE(diff.added.empty());
+    EXPECT_TRUE(diff.removed.empty());
+}
@@ -0,0 +1,57 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include "report_utils.hpp"
+
+namespace {
+
+    json field(const std::string& qn, const std::string& tag, const std::string& type) {
+        return json{{"nodeType", "Field"}, {"tag", tag}, {"qualifiedName", qn}, {"dataType", type}};
+    }
+
+    json modifiedStruct(const std::string& qn, json children) {
+        return json{{"nodeType", "Struct"}, {"tag", "modified"}, {"qualifiedName", qn}, {"children", std::move(children)}};
+    }
+
+}
+
+TEST(DescriptionTemplatesTest, EntriesOfOneShapeReuseTheirDescription) {
+    DescriptionTemplates templates;
+    EXPECT_EQ(templates.describe(modifiedStruct("S1", json::array({field("S1::x", "added", "int")}))),
+              "Field added: 'S1::x' with type 'int'");
+    EXPECT_EQ(templates.describe(modifiedStruct("S2", json::array({field("S2::y", "added", "long")}))),
+              "Field added: 'S2::y' with type 'long'");
+    EXPECT_EQ(templates.size(), 1u);
+    EXPECT_EQ(templates.reused(), 1u);
+
+    // A removed and an added field of one name pair into a type change
+    EXPECT_EQ(templates.describe(modifiedStruct("S3", json::array({field("S3::z", "removed", "int"),
+                                                                    field("S3::z", "added", "long")}))),
+              "Field 'S3::z' type changed from 'int' to 'long'");
+    EXPECT_EQ(templates.describe(modifiedStruct("S4", json::array({field("S4::z", "removed", "int"),
+                                                                    field("S4::w", "added", "long")}))),
+              "Field removed: 'S4::z' with type 'int'\nField added: 'S4::w' with type 'long'");
+    EXPECT_EQ(templates.size(), 3u);
+}
+
+TEST(DescriptionTemplatesTest, SiblingsKeepTheOrderOfTheirNames) {
+    DescriptionTemplates templates;
+    EXPECT_EQ(templates.describe(modifiedStruct("S", json::array({field("S::b", "added", "int"),
+                                                                  field("S::a", "added", "int")}))),
+              "Field added: 'S::a' with type 'int'\nField added: 'S::b' with type 'int'");
+    // Listed in the same order, but sorting the other way round
+    EXPECT_EQ(templates.describe(modifiedStruct("T", json::array({field("T::a", "added", "int"),
+                                                                  field("T::b", "added", "int")}))),
+              "Field added: 'T::a' with type 'int'\nField added: 'T::b' with type 'int'");
+    EXPECT_EQ(templates.reused(), 0u);
+}
+
+TEST(DescriptionTemplatesTest, EntriesWithFunctionsAreDescribedDirectly) {
+    DescriptionTemplates templates;
+    json method{{"nodeType", "Function"}, {"tag", "added"}, {"qualifiedName", "C::f"}};
+    json changed{{"nodeType", "Class"}, {"tag", "modified"}, {"qualifiedName", "C"},
+                 {"children", json::array({method})}};
+    EXPECT_FALSE(templates.describe(changed).empty());
+    EXPECT_EQ(templates.size(), 0u);
+}
@@ -0,0 +1,43 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "diff_utils.hpp"
+
+namespace {
+
+    std::vector<bool> kept(const std::vector<uint32_t>& values) {
+        llvm::SmallVector<bool, 16> marks;
+        llvm::SmallVector<uint32_t, 16> tails;
+        llvm::SmallVector<uint32_t, 16> previous;
+        markLongestNonDecreasing(values, marks, tails, previous);
+        return std::vector<bool>(marks.begin(), marks.end());
+    }
+
+}
+
+TEST(DiffUtilsTest, InOrderKeepsEverything) {
+    EXPECT_EQ(kept({0, 1, 2, 3}), std::vector<bool>({true, true, true, true}));
+    EXPECT_TRUE(kept({}).empty());
+}
+
+TEST(DiffUtilsTest, OneMovedElementIsTheOnlyOneLeftOut) {
+    // The field at position 3 moved to the front
+    EXPECT_EQ(kept({1, 2, 3, 0, 4}), std::vector<bool>({true, true, true, false, true}));
+    // Two adjacent fields swapped: one of them counts as moved
+    std::vector<bool> swapped = kept({0, 2, 1, 3});
+    EXPECT_EQ(std::count(swapped.begin(), swapped.end(), false), 1);
+    EXPECT_TRUE(swapped[0]);
+    EXPECT_TRUE(swapped[3]);
+}
+
+TEST(DiffUtilsTest, ReversedKeepsOne) {
+    std::vector<bool> reversed = kept({4, 3, 2, 1, 0});
+    EXPECT_EQ(std::count(reversed.begin(), reversed.end(), true), 1);
+}
+
+TEST(DiffUtilsTest, RepeatedValuesAreNotMoves) {
+    EXPECT_EQ(kept({0, 1, 1, 2}), std::vector<bool>({true, true, true, true}));
+}
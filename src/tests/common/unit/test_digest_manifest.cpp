@@ -0,0 +1,56 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "digest_manifest.hpp"
+
+class DigestManifestTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_digest_manifest_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(DigestManifestTest, SavedManifestLoadsBack) {
+    std::string path = (dir / "manifest.json").string();
+    armor::DigestManifest manifest;
+    armor::DigestManifest::Entry foo;
+    foo.digest = 0xfedcba9876543210ull;
+    foo.hasClosure = true;
+    foo.closure = 0x1a2b;
+    manifest.record("include/foo.h", foo);
+    armor::DigestManifest::Entry bar;
+    bar.digest = 42;
+    manifest.record("include/bar.h", bar);
+    manifest.save(path);
+
+    armor::DigestManifest loaded = armor::DigestManifest::load(path);
+    EXPECT_EQ(loaded.size(), 2u);
+    armor::DigestManifest::Entry entry;
+    ASSERT_TRUE(loaded.find("include/foo.h", entry));
+    EXPECT_EQ(entry.digest, 0xfedcba9876543210ull);
+    EXPECT_TRUE(entry.hasClosure);
+    EXPECT_EQ(entry.closure, 0x1a2bu);
+    ASSERT_TRUE(loaded.find("include/bar.h", entry));
+    EXPECT_EQ(entry.digest, 42u);
+    EXPECT_FALSE(entry.hasClosure);
+    EXPECT_FALSE(loaded.find("include/baz.h", entry));
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+}
+
+TEST_F(DigestManifestTest, MissingOrMalformedManifestThrows) {
+    EXPECT_THROW(armor::DigestManifest::load((dir / "missing.json").string()), std::runtime_error);
+    std::string path = (dir / "manifest.json").string();
+    std::ofstream(path) << R"({"format": 1, "headers": {"include/foo.h": {"digest": "not hex"}}})";
+    EXPECT_THROW(armor::DigestManifest::load(path), std::runtime_error);
+}
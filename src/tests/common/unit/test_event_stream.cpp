@@ -0,0 +1,83 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "event_stream.hpp"
+
+class EventStreamTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_event_stream_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        armor::EventStream::getInstance().close();
+        std::filesystem::remove_all(dir);
+    }
+
+    std::vector<nlohmann::json> readEvents(const std::string& path) {
+        std::vector<nlohmann::json> events;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            events.push_back(nlohmann::json::parse(line));
+        }
+        return events;
+    }
+};
+
+TEST_F(EventStreamTest, EventsAreWrittenOnePerLine) {
+    std::string path = (dir / "events.ndjson").string();
+    armor::EventStream& events = armor::EventStream::getInstance();
+    events.emit("dropped");
+    events.open(path);
+    ASSERT_TRUE(events.isOpen());
+    events.emit("run_start", {{"headers", 2}});
+    events.emit("header_reported", {{"header", "include/foo.h"}, {"outcome", "compatible"}});
+    events.close();
+    EXPECT_FALSE(events.isOpen());
+    events.emit("dropped");
+
+    std::vector<nlohmann::json> lines = readEvents(path);
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0]["event"], "run_start");
+    EXPECT_EQ(lines[0]["headers"], 2);
+    EXPECT_GE(lines[0]["time"].get<double>(), 0.0);
+    EXPECT_EQ(lines[1]["event"], "header_reported");
+    EXPECT_EQ(lines[1]["header"], "include/foo.h");
+    EXPECT_GE(lines[1]["time"].get<double>(), lines[0]["time"].get<double>());
+}
+
+TEST_F(EventStreamTest, ConcurrentEventsDoNotInterleave) {
+    std::string path = (dir / "events.ndjson").string();
+    armor::EventStream& events = armor::EventStream::getInstance();
+    events.open(path);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&events, t] {
+            for (int i = 0; i < 100; ++i) {
+                events.emit("parse_end", {{"file", "thread" + std::to_string(t)}, {"index", i}});
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    events.close();
+    EXPECT_EQ(readEvents(path).size(), 400u);
+}
+
+TEST_F(EventStreamTest, UnopenableTargetThrows) {
+    EXPECT_THROW(armor::EventStream::getInstance().open((dir / "missing" / "events.ndjson").string()),
+                 std::runtime_error);
+    EXPECT_FALSE(armor::EventStream::getInstance().isOpen());
+}
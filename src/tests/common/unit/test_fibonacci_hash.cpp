@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include "fibonacci_hash.hpp"
+#include "simd_dispatch.hpp"
+
+class FibonacciHashTest : public ::testing::Test {
+protected:
+    static uint64_t normalized(const std::string& text) {
+        return FibonacciHash::hashNormalizedSource(text, 0, static_cast<unsigned>(text.size()));
+    }
+};
+
+TEST_F(FibonacciHashTest, HashIgnoresWhitespace) {
+    std::string compact = "staticconstexprintkAnswerWithAFairlyLongName=42;";
+    std::string spaced = "static  constexpr\tint\n  kAnswerWithAFairlyLongName = 42 ;\r\n";
+    EXPECT_EQ(FibonacciHash::hash(compact), FibonacciHash::hash(spaced));
+    EXPECT_NE(FibonacciHash::hash(compact), FibonacciHash::hash(std::string("staticconstexprintkAnswer=43;")));
+}
+
+TEST_F(FibonacciHashTest, NormalizedSourceDropsCommentsAndWhitespace) {
+    std::string source = "int /* counts */ value_with_a_long_name = 1; // trailing\n"
+                         "#define TWICE(x) \\\n    ((x) * 2)\n";
+    EXPECT_EQ(normalized(source), FibonacciHash::hash(std::string("intvalue_with_a_long_name=1;#defineTWICE(x)((x)*2)")));
+}
+
+TEST_F(FibonacciHashTest, NormalizedSourceKeepsLiteralSpelling) {
+    EXPECT_NE(normalized("const char* s = \"a b\";"), normalized("const char* s = \"ab\";"));
+    EXPECT_EQ(normalized("const char* s = \"a // b\";"), normalized("const char*s=\"a // b\";"));
+    EXPECT_EQ(normalized("char c = '\\'';  /* x */"), normalized("char c='\\'';"));
+}
+
+TEST_F(FibonacciHashTest, NormalizedSourceHashesSubranges) {
+    std::string source = "int a;   int b;";
+    unsigned second = static_cast<unsigned>(source.find("int b"));
+    EXPECT_EQ(FibonacciHash::hashNormalizedSource(source, second, static_cast<unsigned>(source.size())),
+              normalized("int b;"));
+    EXPECT_EQ(FibonacciHash::hashNormalizedSource(source, 0, second), normalized("int a;"));
+    EXPECT_EQ(FibonacciHash::hashNormalizedSource(source, 4, 4), 0u);
+}
+
+TEST_F(FibonacciHashTest, HashCoversEveryStripeAndTheTail) {
+    // Longer than one 32-byte stripe, with a change in each part
+    std::string text(75, 'x');
+    for (size_t position : {0u, 31u, 32u, 63u, 64u, 74u}) {
+        std::string changed = text;
+        changed[position] = 'y';
+        EXPECT_NE(FibonacciHash::hash(changed), FibonacciHash::hash(text)) << position;
+    }
+    // Zero padding of the last stripe does not make a shorter text equal
+    EXPECT_NE(FibonacciHash::hash(std::string("a")), FibonacciHash::hash(std::string("a\0", 2)));
+}
+
+TEST_F(FibonacciHashTest, DigestFollowsTheHashNormalization) {
+    std::string source = "int /* note */ value = 1;";
+    EXPECT_EQ(FibonacciHash::digestNormalizedSource(source, 0, static_cast<unsigned>(source.size())),
+              FibonacciHash::digest("intvalue=1;"));
+    EXPECT_EQ(FibonacciHash::digest("int value = 1;"), FibonacciHash::digest("int value=1;"));
+    EXPECT_NE(FibonacciHash::digest("int value = 1;"), FibonacciHash::digest("int value = 2;"));
+    EXPECT_EQ(FibonacciHash::digestNormalizedSource(source, 4, 4), FibonacciHash::Digest128());
+}
+
+TEST_F(FibonacciHashTest, EveryKernelHashesAlike) {
+    using armor::simd::Kernel;
+    // Runs of plain text longer than a vector block, with stops at block edges
+    std::string source;
+    for (int i = 0; i < 8; ++i) {
+        source += "static const char* kName" + std::to_string(i) + " = \"a /* b */ c\";   /* note " +
+                  std::string(static_cast<size_t>(i) * 5, '-') + " */\n#define M" + std::to_string(i) +
+                  "(x) \\\n    ((x) + 1) // trailing\n";
+    }
+    Kernel detected = armor::simd::detectedKernel();
+    ASSERT_TRUE(armor::simd::setKernel(Kernel::SCALAR));
+    uint64_t expected = normalized(source);
+    for (Kernel kernel : {Kernel::SSE2, Kernel::AVX2, Kernel::NEON}) {
+        if (armor::simd::setKernel(kernel)) {
+            EXPECT_EQ(normalized(source), expected) << armor::simd::kernelName(kernel);
+        }
+    }
+    armor::simd::setKernel(detected);
+}
@@ -0,0 +1,180 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include "file_cache.hpp"
+
+namespace {
+
+    // Counts what reaches the disk
+    class CountingFileSystem : public llvm::vfs::ProxyFileSystem {
+        public:
+            CountingFileSystem() : ProxyFileSystem(llvm::vfs::getRealFileSystem()) {}
+
+            llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override {
+                ++stats;
+                return ProxyFileSystem::status(path);
+            }
+
+            llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override {
+                ++opens;
+                return ProxyFileSystem::openFileForRead(path);
+            }
+
+            int stats = 0;
+            int opens = 0;
+    };
+
+    std::string readAll(llvm::vfs::FileSystem& fs, const std::string& path) {
+        auto file = fs.openFileForRead(path);
+        if (!file) {
+            return "<missing>";
+        }
+        auto buffer = (*file)->getBuffer(path);
+        return buffer ? (*buffer)->getBuffer().str() : "<unreadable>";
+    }
+
+    class FileCacheTest : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                dir = std::filesystem::temp_directory_path() / "armor_file_cache_test";
+                std::filesystem::remove_all(dir);
+                std::filesystem::create_directories(dir);
+                header = (dir / "common.h").string();
+                std::ofstream(header) << "int shared;\n";
+            }
+
+            void TearDown() override {
+                std::filesystem::remove_all(dir);
+            }
+
+            std::filesystem::path dir;
+            std::string header;
+    };
+
+}
+
+TEST_F(FileCacheTest, ToolsShareStatsAndContents) {
+    armor::SharedFileCache cache;
+    auto disk = llvm::makeIntrusiveRefCnt<CountingFileSystem>();
+    auto first = cache.wrap(disk);
+    auto second = cache.wrap(disk);
+
+    EXPECT_EQ(readAll(*first, header), "int shared;\n");
+    EXPECT_EQ(readAll(*second, header), "int shared;\n");
+    EXPECT_TRUE(second->status(header));
+    EXPECT_EQ(disk->opens, 1);
+    EXPECT_EQ(disk->stats, 0);
+
+    std::string missing = (dir / "missing.h").string();
+    EXPECT_FALSE(first->status(missing));
+    EXPECT_FALSE(second->status(missing));
+    EXPECT_FALSE(second->openFileForRead(missing));
+    EXPECT_EQ(disk->stats, 1);
+    EXPECT_EQ(cache.getBufferBytes(), std::string("int shared;\n").size());
+}
+
+TEST_F(FileCacheTest, StatusKeepsTheRequestedName) {
+    armor::SharedFileCache cache;
+    auto fs = cache.wrap(llvm::vfs::getRealFileSystem());
+    ASSERT_FALSE(fs->setCurrentWorkingDirectory(dir.string()));
+    auto relative = fs->status("./common.h");
+    ASSERT_TRUE(relative);
+    EXPECT_EQ(relative->getName(), "./common.h");
+    auto absolute = fs->status(header);
+    ASSERT_TRUE(absolute);
+    EXPECT_EQ(absolute->getName(), header);
+    EXPECT_EQ(cache.getMisses(), 1u);
+}
+
+TEST_F(FileCacheTest, RevalidateDropsChangedFilesOnly) {
+    armor::SharedFileCache cache;
+    auto fs = cache.wrap(llvm::vfs::getRealFileSystem());
+    std::string other = (dir / "other.h").string();
+    std::ofstream(other) << "int other;\n";
+    std::string added = (dir / "added.h").string();
+    EXPECT_EQ(readAll(*fs, header), "int shared;\n");
+    EXPECT_EQ(readAll(*fs, other), "int other;\n");
+    EXPECT_EQ(readAll(*fs, added), "<missing>");
+
+    std::ofstream(header) << "int shared;\nint more;\n";
+    std::ofstream(added) << "int added;\n";
+    EXPECT_EQ(readAll(*fs, header), "int shared;\n");
+
+    EXPECT_EQ(cache.revalidate(), 2u);
+    EXPECT_EQ(readAll(*fs, header), "int shared;\nint more;\n");
+    EXPECT_EQ(readAll(*fs, added), "int added;\n");
+    uint64_t misses = cache.getMisses();
+    EXPECT_EQ(readAll(*fs, other), "int other;\n");
+    EXPECT_EQ(cache.getMisses(), misses);
+}
+
+TEST_F(FileCacheTest, FilesOverTheBudgetAreReadButNotKept) {
+    armor::SharedFileCache cache(/*maxBufferBytes=*/4);
+    auto disk = llvm::makeIntrusiveRefCnt<CountingFileSystem>();
+    auto fs = cache.wrap(disk);
+    EXPECT_EQ(readAll(*fs, header), "int shared;\n");
+    EXPECT_EQ(readAll(*fs, header), "int shared;\n");
+    EXPECT_EQ(disk->opens, 2);
+    EXPECT_EQ(cache.getBufferBytes(), 0u);
+    EXPECT_TRUE(fs->status(header));
+    EXPECT_EQ(disk->stats, 0);
+}
+
+TEST_F(FileCacheTest, MissesUnderAListedTreeAreAnsweredFromListings) {
+    std::filesystem::create_directories(dir / "a" / "b");
+    std::filesystem::create_directories(dir / "out");
+    armor::SharedFileCache cache;
+    cache.listTree(dir.string(), {(dir / "out").string()});
+    auto disk = llvm::makeIntrusiveRefCnt<CountingFileSystem>();
+    auto fs = cache.wrap(disk);
+
+    // The ancestor chain of a header in a/b probing for one include
+    for (const char* probe : {"a/b/vector", "a/vector", "vector", "a/b/c/d.h", "nowhere/x.h"}) {
+        EXPECT_FALSE(fs->status((dir / probe).string())) << probe;
+        EXPECT_FALSE(fs->openFileForRead((dir / probe).string())) << probe;
+    }
+    EXPECT_EQ(disk->stats, 0);
+    EXPECT_EQ(disk->opens, 0);
+
+    // Existing files and excluded directories still reach the disk
+    EXPECT_EQ(readAll(*fs, header), "int shared;\n");
+    EXPECT_FALSE(fs->status((dir / "out" / "later.pch").string()));
+    EXPECT_EQ(disk->opens, 1);
+    EXPECT_EQ(disk->stats, 1);
+    std::ofstream(dir / "out" / "later.pch") << "pch";
+    cache.forget((dir / "out" / "later.pch").string());
+    EXPECT_TRUE(fs->status((dir / "out" / "later.pch").string()));
+}
+
+TEST_F(FileCacheTest, RevalidateReadsListingsAgain) {
+    armor::SharedFileCache cache;
+    cache.listTree(dir.string());
+    auto fs = cache.wrap(llvm::vfs::getRealFileSystem());
+    std::string added = (dir / "added.h").string();
+    EXPECT_FALSE(fs->status(added));
+    std::ofstream(added) << "int added;\n";
+    EXPECT_FALSE(fs->status(added));
+    cache.revalidate();
+    EXPECT_TRUE(fs->status(added));
+}
+
+TEST_F(FileCacheTest, UncachedTreesGoToTheFileSystem) {
+    armor::SharedFileCache cache;
+    std::filesystem::create_directories(dir / "modules");
+    cache.setUncachedTrees({(dir / "modules").string()});
+    auto fs = cache.wrap(llvm::vfs::getRealFileSystem());
+    std::string module = (dir / "modules" / "m.pcm").string();
+    EXPECT_FALSE(fs->status(module));
+    std::ofstream(module) << "pcm";
+    EXPECT_TRUE(fs->status(module));
+    EXPECT_EQ(readAll(*fs, module), "pcm");
+    EXPECT_EQ(cache.getBufferBytes(), 0u);
+}
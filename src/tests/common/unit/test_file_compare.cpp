@@ -0,0 +1,52 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "file_compare.hpp"
+
+class FileCompareTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_file_compare_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string write(const std::string& name, const std::string& content) {
+        std::filesystem::path p = dir / name;
+        std::ofstream out(p, std::ios::binary | std::ios::trunc);
+        out << content;
+        return p.string();
+    }
+};
+
+TEST_F(FileCompareTest, IdenticalContent) {
+    EXPECT_FALSE(armor::filesDiffer(write("a.h", "int f();\n"), write("b.h", "int f();\n")));
+}
+
+TEST_F(FileCompareTest, SameSizeDifferentContent) {
+    EXPECT_TRUE(armor::filesDiffer(write("a.h", "int f();\n"), write("b.h", "int g();\n")));
+}
+
+TEST_F(FileCompareTest, DifferentSize) {
+    EXPECT_TRUE(armor::filesDiffer(write("a.h", "int f();\n"), write("b.h", "int f(int);\n")));
+}
+
+TEST_F(FileCompareTest, EmptyFiles) {
+    EXPECT_FALSE(armor::filesDiffer(write("a.h", ""), write("b.h", "")));
+}
+
+TEST_F(FileCompareTest, PathsWithSpaces) {
+    EXPECT_FALSE(armor::filesDiffer(write("my header.h", "x"), write("other header.h", "x")));
+}
+
+TEST_F(FileCompareTest, MissingFileIsDifferent) {
+    EXPECT_TRUE(armor::filesDiffer(write("a.h", "x"), (dir / "missing.h").string()));
+}
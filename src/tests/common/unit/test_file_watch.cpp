@@ -0,0 +1,60 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "file_watch.hpp"
+
+namespace fs = std::filesystem;
+
+class FileWatchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = fs::temp_directory_path() / ("armor_file_watch_" + std::to_string(getpid()));
+        fs::remove_all(root);
+        fs::create_directories(root / "include" / "api");
+        fs::create_directories(root / "armor_reports");
+    }
+    void TearDown() override { fs::remove_all(root); }
+
+    void write(const fs::path& path, const std::string& text) {
+        std::ofstream out(path);
+        out << text;
+    }
+
+    fs::path root;
+};
+
+TEST_F(FileWatchTest, RerunsWithTheChangedFilesOutsideExcludedDirectories) {
+    std::vector<std::vector<std::string>> calls;
+    bool watched = armor::watchAndRerun(root.string(), {(root / "armor_reports").string()},
+                                        [&](const std::vector<std::string>& changed) {
+        calls.push_back(changed);
+        if (calls.size() == 1) {
+            // A report written by the run, then one save
+            write(root / "armor_reports" / "foo.h.html", "<html/>");
+            write(root / "include" / "api" / "foo.h", "int foo();\n");
+            write(root / "include" / "api" / "foo.h", "int foo(int);\n");
+        }
+        return calls.size() < 2;
+    });
+    ASSERT_TRUE(watched);
+    ASSERT_EQ(calls.size(), 2u);
+    EXPECT_TRUE(calls[0].empty());
+    std::string saved = (root / "include" / "api" / "foo.h").string();
+    EXPECT_EQ(calls[1], std::vector<std::string>{saved});
+}
+
+TEST_F(FileWatchTest, MissingRootIsNotWatched) {
+    bool called = false;
+    bool watched = armor::watchAndRerun((root / "missing").string(), {}, [&](const std::vector<std::string>&) {
+        called = true;
+        return false;
+    });
+    EXPECT_FALSE(watched);
+    EXPECT_FALSE(called);
+}
@@ -0,0 +1,144 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "git_tree.hpp"
+
+class GitTreeTest : public ::testing::Test {
+protected:
+    std::filesystem::path repo;
+    // An empty real directory, as the real file system must accept it as working directory
+    std::string mount;
+    std::string base;
+    std::string head;
+
+    void SetUp() override {
+        repo = std::filesystem::temp_directory_path() / "armor_git_tree_test";
+        std::filesystem::remove_all(repo);
+        std::filesystem::create_directories(repo);
+        mount = (std::filesystem::temp_directory_path() / "armor_git_tree_mount").string();
+        std::filesystem::create_directories(mount);
+        if (!git("init -q") || !git("config user.email armor@example.com") || !git("config user.name armor")) {
+            GTEST_SKIP() << "git is not available";
+        }
+
+        write("include/api.h", "#include \"detail/impl.h\"\nint api();\n");
+        write("include/detail/impl.h", "int impl();\n");
+        write("include/other.hpp", "struct Other {};\n");
+        write("README", "docs\n");
+        std::filesystem::create_symlink("detail/impl.h", repo / "include" / "alias.h");
+        std::filesystem::create_directory_symlink("include/detail", repo / "detail");
+        ASSERT_TRUE(git("add -A") && git("commit -q -m base"));
+        base = revParse();
+
+        write("include/api.h", "#include \"detail/impl.h\"\nint api(int);\n");
+        std::filesystem::remove(repo / "include" / "other.hpp");
+        ASSERT_TRUE(git("add -A") && git("commit -q -m head"));
+        head = revParse();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(repo);
+        std::filesystem::remove_all(mount);
+    }
+
+    bool git(const std::string& args) {
+        std::string command = "git -C '" + repo.string() + "' " + args + " >/dev/null 2>&1";
+        return std::system(command.c_str()) == 0;
+    }
+
+    std::string revParse() {
+        std::filesystem::path out = repo.parent_path() / "armor_git_tree_test_rev";
+        std::system(("git -C '" + repo.string() + "' rev-parse HEAD > '" + out.string() + "'").c_str());
+        std::ifstream in(out);
+        std::string rev;
+        in >> rev;
+        std::filesystem::remove(out);
+        return rev;
+    }
+
+    void write(const std::string& path, const std::string& content) {
+        std::filesystem::path p = repo / path;
+        std::filesystem::create_directories(p.parent_path());
+        std::ofstream(p, std::ios::binary | std::ios::trunc) << content;
+    }
+
+    std::shared_ptr<armor::GitRevisionTree> tree(const std::string& rev) {
+        auto store = std::make_shared<armor::GitObjectStore>(repo.string());
+        return std::make_shared<armor::GitRevisionTree>(store, rev, mount);
+    }
+};
+
+TEST_F(GitTreeTest, LooksUpFilesAndDirectories) {
+    auto baseTree = tree(base);
+    const armor::GitRevisionTree::Entry* api = baseTree->lookup(mount + "/include/api.h");
+    ASSERT_NE(api, nullptr);
+    EXPECT_FALSE(api->isDirectory);
+    EXPECT_EQ(baseTree->readFile(*api), "#include \"detail/impl.h\"\nint api();\n");
+
+    ASSERT_NE(baseTree->lookup(mount), nullptr);
+    EXPECT_TRUE(baseTree->lookup(mount)->isDirectory);
+    EXPECT_TRUE(baseTree->lookup(mount + "/include/detail")->isDirectory);
+    EXPECT_EQ(baseTree->lookup(mount + "/include/missing.h"), nullptr);
+    EXPECT_EQ(baseTree->lookup("/elsewhere/include/api.h"), nullptr);
+    EXPECT_EQ(baseTree->lookup(mount + "x/include/api.h"), nullptr);
+}
+
+TEST_F(GitTreeTest, RevisionsDifferByBlob) {
+    auto baseTree = tree(base);
+    auto headTree = tree(head);
+    EXPECT_NE(baseTree->lookup(mount + "/include/api.h")->oid, headTree->lookup(mount + "/include/api.h")->oid);
+    EXPECT_EQ(baseTree->lookup(mount + "/include/detail/impl.h")->oid,
+              headTree->lookup(mount + "/include/detail/impl.h")->oid);
+    EXPECT_NE(baseTree->lookup(mount + "/include/other.hpp"), nullptr);
+    EXPECT_EQ(headTree->lookup(mount + "/include/other.hpp"), nullptr);
+}
+
+TEST_F(GitTreeTest, ResolvesSymlinksInsideTheTree) {
+    auto baseTree = tree(base);
+    const armor::GitRevisionTree::Entry* alias = baseTree->lookup(mount + "/include/alias.h");
+    ASSERT_NE(alias, nullptr);
+    EXPECT_EQ(baseTree->readFile(*alias), "int impl();\n");
+    const armor::GitRevisionTree::Entry* viaDir = baseTree->lookup(mount + "/detail/impl.h");
+    ASSERT_NE(viaDir, nullptr);
+    EXPECT_EQ(viaDir, baseTree->lookup(mount + "/include/detail/impl.h"));
+}
+
+TEST_F(GitTreeTest, ListsFilesOfOneDirectory) {
+    EXPECT_EQ(tree(base)->listFiles(mount + "/include"),
+              (std::vector<std::string>{"alias.h", "api.h", "other.hpp"}));
+    EXPECT_EQ(tree(head)->listFiles(mount + "/include"), (std::vector<std::string>{"alias.h", "api.h"}));
+}
+
+TEST_F(GitTreeTest, UnknownRevisionThrows) {
+    EXPECT_THROW(tree("no-such-revision"), std::runtime_error);
+}
+
+TEST_F(GitTreeTest, FileSystemServesTheTreeOverTheRealOne) {
+    auto overlay = llvm::makeIntrusiveRefCnt<llvm::vfs::OverlayFileSystem>(
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(llvm::vfs::createPhysicalFileSystem().release()));
+    overlay->pushOverlay(armor::createGitTreeFileSystem(tree(head)));
+    ASSERT_FALSE(overlay->setCurrentWorkingDirectory(mount));
+
+    auto status = overlay->status("include/detail/../api.h");
+    ASSERT_TRUE(status);
+    EXPECT_TRUE(status->isRegularFile());
+    EXPECT_EQ(status->getSize(), std::string("#include \"detail/impl.h\"\nint api(int);\n").size());
+    EXPECT_EQ(status->getUniqueID(), overlay->status(mount + "/include/api.h")->getUniqueID());
+    EXPECT_TRUE(overlay->status(mount + "/include/detail")->isDirectory());
+    EXPECT_FALSE(overlay->status("include/other.hpp"));
+
+    auto buffer = overlay->getBufferForFile(mount + "/include/detail/impl.h");
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ((*buffer)->getBuffer(), "int impl();\n");
+
+    // Paths outside the mount point still come from disk
+    EXPECT_TRUE(overlay->status(repo.string() + "/README"));
+}
@@ -0,0 +1,85 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <utility>
+#include "hash_multiset.hpp"
+
+TEST(HashMultisetTest, InsertionOrderDoesNotMatter) {
+    HashMultiset a;
+    a.insert(1);
+    a.insert(2);
+    a.insert(1);
+    HashMultiset b;
+    b.insert(1, 2);
+    b.insert(2);
+    EXPECT_EQ(a.getFingerprint(), b.getFingerprint());
+    EXPECT_FALSE(a.differs(b));
+    EXPECT_EQ(a.count(1), 2);
+}
+
+TEST(HashMultisetTest, CountsMatter) {
+    HashMultiset a;
+    a.insert(7, 2);
+    HashMultiset b;
+    b.insert(7);
+    EXPECT_TRUE(a.differs(b));
+    EXPECT_TRUE(b.differs(a));
+}
+
+TEST(HashMultisetTest, RemovalRestoresTheFingerprint) {
+    HashMultiset a;
+    a.insert(3);
+    HashMultiset b;
+    b.insert(3);
+    b.insert(4);
+    EXPECT_TRUE(b.eraseOne(4));
+    EXPECT_FALSE(b.eraseOne(4));
+    EXPECT_EQ(b.size(), 1u);
+    EXPECT_FALSE(a.differs(b));
+}
+
+TEST(HashMultisetTest, ClearedIsEmpty) {
+    HashMultiset a;
+    a.insert(5);
+    a.clear();
+    EXPECT_TRUE(a.empty());
+    EXPECT_FALSE(a.differs(HashMultiset()));
+}
+
+TEST(HashMultisetTest, SameDistinctSizeDifferentHashes) {
+    HashMultiset a;
+    a.insert(1);
+    a.insert(2);
+    HashMultiset b;
+    b.insert(1);
+    b.insert(3);
+    EXPECT_TRUE(a.countsDiffer(b));
+    EXPECT_TRUE(a.differs(b));
+}
+TEST(HashMultisetTest, MovedFromIsEmpty) {
+    HashMultiset a;
+    a.insert(9);
+    HashMultiset b = std::move(a);
+    EXPECT_EQ(b.count(9), 1);
+    EXPECT_TRUE(a.empty());
+    EXPECT_FALSE(a.differs(HashMultiset()));
+}
+
+TEST(HashMultisetTest, FingerprintsOfPartsAddUp) {
+    HashMultiset whole;
+    whole.insert(1);
+    whole.insert(2, 2);
+    HashMultiset::Fingerprint parts = HashMultiset::fingerprintOf(1);
+    parts += HashMultiset::fingerprintOf(2);
+    parts += HashMultiset::fingerprintOf(2);
+    EXPECT_EQ(parts, whole.getFingerprint());
+
+    HashMultiset rest;
+    rest.insert(1);
+    HashMultiset::Fingerprint remaining = whole.getFingerprint();
+    remaining -= HashMultiset::fingerprintOf(2);
+    EXPECT_NE(remaining, rest.getFingerprint());
+    remaining -= HashMultiset::fingerprintOf(2);
+    EXPECT_EQ(remaining, rest.getFingerprint());
+}
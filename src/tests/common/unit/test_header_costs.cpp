@@ -0,0 +1,75 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "header_costs.hpp"
+
+class HeaderCostsTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_header_costs_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(HeaderCostsTest, MissingHistoryIsEmpty) {
+    armor::HeaderCostHistory history = armor::HeaderCostHistory::load((dir / "missing.json").string());
+    double seconds = 0;
+    EXPECT_FALSE(history.find("include/foo.h", seconds));
+}
+
+TEST_F(HeaderCostsTest, SavedHistoryLoadsBack) {
+    std::string path = (dir / "costs.json").string();
+    armor::HeaderCostHistory history;
+    history.record("include/foo.h", 2.5);
+    history.record("include/foo.h", 3.0);
+    history.record("include/bar.h", 0.25);
+    history.save(path);
+
+    armor::HeaderCostHistory loaded = armor::HeaderCostHistory::load(path);
+    double seconds = 0;
+    ASSERT_TRUE(loaded.find("include/foo.h", seconds));
+    EXPECT_DOUBLE_EQ(seconds, 3.0);
+    ASSERT_TRUE(loaded.find("include/bar.h", seconds));
+    EXPECT_DOUBLE_EQ(seconds, 0.25);
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+}
+
+TEST_F(HeaderCostsTest, MalformedHistoryThrows) {
+    std::string path = (dir / "costs.json").string();
+    std::ofstream(path) << R"({"format": 1, "headers": {"include/foo.h": "slow"}})";
+    EXPECT_THROW(armor::HeaderCostHistory::load(path), std::runtime_error);
+}
+
+TEST_F(HeaderCostsTest, CountsIncludeDirectives) {
+    EXPECT_EQ(armor::countIncludeDirectives("#include <a.h>\n  #  include \"b.h\"\n#define X\n"
+                                            "int include;\n#import <c.h>"), 3u);
+}
+
+TEST_F(HeaderCostsTest, UnmeasuredHeadersAreScaledToMeasuredOnes) {
+    armor::HeaderCostHistory history;
+    history.record("a.h", 2.0);
+    std::vector<double> costs = armor::predictHeaderCosts({"a.h", "b.h"}, {100, 300}, history);
+    EXPECT_DOUBLE_EQ(costs[0], 2.0);
+    EXPECT_DOUBLE_EQ(costs[1], 6.0);
+}
+
+TEST_F(HeaderCostsTest, OrdersLongestFirstKeepingTies) {
+    EXPECT_EQ(armor::longestFirstOrder({1, 5, 3, 5}), (std::vector<std::size_t>{1, 3, 2, 0}));
+}
+
+TEST_F(HeaderCostsTest, PartitionBalancesShards) {
+    std::vector<unsigned> shards = armor::partitionByCost({8, 7, 6, 5, 4}, 2);
+    EXPECT_EQ(shards, (std::vector<unsigned>{0, 1, 1, 0, 0}));
+    EXPECT_EQ(armor::partitionByCost({8, 7}, 1), (std::vector<unsigned>{0, 0}));
+}
@@ -0,0 +1,134 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "header_selection.hpp"
+
+class HeaderSelectionTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_header_selection_test";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    void touch(const std::string& relative) {
+        std::filesystem::path path = dir / relative;
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path) << "";
+    }
+
+    std::string writeConfig(const std::string& text) {
+        std::filesystem::path path = dir / "config.yml";
+        std::ofstream(path) << text;
+        return path.string();
+    }
+
+    std::string root(const std::string& name) const {
+        return (dir / name).string();
+    }
+};
+
+TEST_F(HeaderSelectionTest, WalksEveryRootOnce) {
+    touch("v1/top.h");
+    touch("v1/include/a.h");
+    touch("v1/include/deep/b.hpp");
+    touch("v1/include/notes.txt");
+    touch("v2/include/a.h");
+    touch("v2/src/c.h");
+
+    std::vector<std::string> files = armor::walkHeaderFiles({root("v1"), root("v2")}, {".h", ".hpp"}, 4);
+    EXPECT_EQ(files, (std::vector<std::string>{"include/a.h", "include/deep/b.hpp", "src/c.h", "top.h"}));
+}
+
+TEST_F(HeaderSelectionTest, ReadsThePatternsOfTheBranch) {
+    std::string config = writeConfig(
+        "branches:\n"
+        "  main:\n"
+        "    modes:\n"
+        "      blocking:\n"
+        "        headers:\n"
+        "          - include/api/\n"
+        "          - ./include/*.h\n"
+        "      non-blocking:\n"
+        "        headers: [include/internal/util.h]\n"
+        "  release:\n"
+        "    modes:\n"
+        "      blocking:\n"
+        "        headers: [other.h]\n");
+
+    armor::HeaderPatterns patterns = armor::loadHeaderPatterns(config, "main");
+    EXPECT_EQ(patterns.blocking, (std::vector<std::string>{"include/api/", "./include/*.h"}));
+    EXPECT_EQ(patterns.nonBlocking, (std::vector<std::string>{"include/internal/util.h"}));
+
+    armor::HeaderPatterns missing = armor::loadHeaderPatterns(config, "unknown");
+    EXPECT_TRUE(missing.blocking.empty());
+    EXPECT_TRUE(missing.nonBlocking.empty());
+}
+
+TEST_F(HeaderSelectionTest, RejectsMalformedConfigs) {
+    EXPECT_THROW(armor::loadHeaderPatterns(writeConfig("branches: [unclosed\n"), "main"), std::runtime_error);
+    EXPECT_THROW(armor::loadHeaderPatterns(root("absent.yml"), "main"), std::runtime_error);
+}
+
+TEST_F(HeaderSelectionTest, ExpandsDirectoriesGlobsAndFiles) {
+    touch("head/include/api/a.h");
+    touch("head/include/api/sub/b.hpp");
+    touch("head/include/top.h");
+    touch("head/include/internal/util.h");
+    touch("head/include/internal/other.h");
+    touch("head/include/api/readme.md");
+
+    armor::HeaderPatterns patterns;
+    patterns.blocking = {"include/api", "./include/*.h"};
+    patterns.nonBlocking = {"include/internal/util.h", "include/absent.h", "include/api/a.h"};
+    armor::HeaderSelection selection = armor::selectHeaders(patterns, {root("head")}, 2);
+
+    // `*` matches '/' too, as in `find -path`
+    EXPECT_EQ(selection.blocking, (std::vector<std::string>{"include/api/a.h", "include/api/sub/b.hpp",
+                                                            "include/internal/other.h", "include/internal/util.h",
+                                                            "include/top.h"}));
+    EXPECT_EQ(selection.nonBlocking, (std::vector<std::string>{"include/api/a.h", "include/internal/util.h"}));
+    EXPECT_EQ(selection.headers, selection.blocking);
+}
+
+TEST_F(HeaderSelectionTest, SelectsHeadersOfEitherRoot) {
+    touch("base/include/removed.h");
+    touch("base/include/kept.h");
+    touch("head/include/kept.h");
+    touch("head/include/added.h");
+
+    armor::HeaderPatterns patterns;
+    patterns.blocking = {"include/"};
+    armor::HeaderSelection selection = armor::selectHeaders(patterns, {root("base"), root("head")}, 2);
+    EXPECT_EQ(selection.blocking, (std::vector<std::string>{"include/added.h", "include/kept.h", "include/removed.h"}));
+    EXPECT_TRUE(selection.nonBlocking.empty());
+}
+
+TEST_F(HeaderSelectionTest, PairsTheHeadersOfBothDirectories) {
+    touch("v1/api/kept.h");
+    touch("v1/api/deep/removed.hpp");
+    touch("v1/api/detail/skipped.h");
+    touch("v2/api/kept.h");
+    touch("v2/api/added.hh");
+    touch("v2/api/generated_config.h");
+    touch("v2/api/detail/skipped.h");
+
+    armor::HeaderDiscovery discovery = armor::discoverHeaderPairs(root("v1"), root("v2"), {".h", ".hpp", ".hh"},
+                                                                  {"api/detail", "generated_*"}, 3);
+    EXPECT_EQ(discovery.common, (std::vector<std::string>{"api/kept.h"}));
+    EXPECT_EQ(discovery.removed, (std::vector<std::string>{"api/deep/removed.hpp"}));
+    EXPECT_EQ(discovery.added, (std::vector<std::string>{"api/added.hh"}));
+
+    EXPECT_THROW(armor::discoverHeaderPairs(root("v1"), root("v2"), {".h"}, {"[unclosed"}, 1), std::runtime_error);
+}
@@ -0,0 +1,94 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "comm_def.hpp"
+#include "report_utils.hpp"
+
+class HtmlReportTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_html_report_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string report(const ApiChangeGroups& groups) {
+        std::filesystem::path path = dir / "report.html";
+        generate_html_report(groups, path.string(), BETA_PARSER, 0, 0, "backward_incompatible",
+                             "BACKWARD_INCOMPATIBLE", "reason");
+        std::ifstream in(path);
+        std::ostringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    // The escape of a table cell, one character at a time
+    static std::string expectedCell(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            switch (c) {
+                case '&':  out += "&amp;";  break;
+                case '<':  out += "&lt;";   break;
+                case '>':  out += "&gt;";   break;
+                case '"':  out += "&quot;"; break;
+                case '\'': out += "&#39;";  break;
+                case '\n': out += "<br/>";  break;
+                default:   out += c;        break;
+            }
+        }
+        return out;
+    }
+};
+
+TEST_F(HtmlReportTest, RowLayout) {
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(json{{"headerfile", "include/foo.h"},
+                          {"name", "foo"},
+                          {"description", "first"},
+                          {"changetype", "Compatibility_changed"},
+                          {"compatibility", "backward_incompatible"}});
+    groups.addRecord(json{{"headerfile", "include/foo.h"},
+                          {"name", "foo"},
+                          {"description", "second"},
+                          {"changetype", "Functionality_changed"},
+                          {"compatibility", "backward_compatible"}});
+
+    EXPECT_NE(report(groups).find("<tr>\n"
+                                  "<td> include/foo.h </td>\n"
+                                  "<td> foo </td>\n"
+                                  "<td> first<br/>second </td>\n"
+                                  "<td> Compatibility Changed </td>\n"
+                                  "<td> <span style=\"color:#d32f2f;font-weight:600\">backward_incompatible</span> </td>\n"
+                                  "</tr>\n"),
+              std::string::npos);
+}
+
+TEST_F(HtmlReportTest, EscapesSpecialCharactersAtEveryOffset) {
+    // Special characters before, inside and across the vector blocks of the scan
+    const std::string specials = "&<>\"'\n";
+    std::string description;
+    for (size_t i = 0; i < 200; ++i) {
+        description += (i % 7 == 0 || i % 31 == 30) ? specials[i % specials.size()] : static_cast<char>('a' + i % 26);
+    }
+    description += "template<typename T> void f(const T&)";
+
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(json{{"headerfile", "include/a&b.h"},
+                          {"name", "ns::f<T>"},
+                          {"description", description},
+                          {"changetype", "Compatibility_changed"},
+                          {"compatibility", "backward_incompatible"}});
+
+    std::string html = report(groups);
+    EXPECT_NE(html.find("<td> include/a&amp;b.h </td>\n<td> ns::f&lt;T&gt; </td>\n"), std::string::npos);
+    EXPECT_NE(html.find("<td> " + expectedCell(description) + " </td>\n"), std::string::npos);
+}
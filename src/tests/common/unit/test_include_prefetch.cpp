@@ -0,0 +1,75 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "include_prefetch.hpp"
+
+class IncludePrefetchTest : public ::testing::Test {
+protected:
+    std::filesystem::path root;
+
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "armor_include_prefetch_test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "include" / "lib");
+        std::filesystem::create_directories(root / "src");
+        write("src/a.h", "#include \"local.h\"\n#  include <lib/common.h>\n#include MACRO_HEADER\n");
+        write("src/local.h", "#pragma once\n#include <missing.h>\n");
+        write("src/b.h", "#import <lib/common.h>\n#include \"lib/other.h\"\n");
+        write("include/lib/common.h", "#if 0\n#include \"lib/other.h\"\n#endif\n");
+        write("include/lib/other.h", "int other;\n");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    void write(const std::string& path, const std::string& contents) {
+        std::ofstream(root / path) << contents;
+    }
+
+    std::string path(const std::string& relative) const {
+        return (root / relative).string();
+    }
+};
+
+TEST_F(IncludePrefetchTest, IncludeDirsFollowTheSearchOrder) {
+    std::vector<std::string> commandLine{"clang", "-isystem", "/usr/include", "-Iinclude", "-iquote", "quoted",
+                                         "-I", "/abs", "-include", "pre.h", "-idirafter/late", "a.h"};
+    std::vector<std::string> dirs = armor::includeDirsOf(commandLine, "/work");
+    EXPECT_EQ(dirs, (std::vector<std::string>{"/work/quoted", "/work/include", "/abs", "/usr/include", "/late"}));
+}
+
+TEST_F(IncludePrefetchTest, ReadsTheClosureOnce) {
+    std::vector<std::string> dirs{path("include")};
+    llvm::StringSet<> visited;
+    // a.h, local.h and lib/common.h; the conditional include of common.h is followed too
+    EXPECT_EQ(armor::prefetchIncludeClosure(path("src/a.h"), dirs, visited), 4u);
+    EXPECT_TRUE(visited.count(path("include/lib/other.h")));
+    // Only b.h itself is new
+    EXPECT_EQ(armor::prefetchIncludeClosure(path("src/b.h"), dirs, visited), 1u);
+    EXPECT_EQ(armor::prefetchIncludeClosure(path("src/missing.h"), dirs, visited), 0u);
+}
+
+TEST_F(IncludePrefetchTest, StaysAheadOfTheParsedHeaders) {
+    std::vector<std::string> dirs{path("include")};
+    armor::IncludePrefetcher prefetcher({{path("src/local.h"), dirs}, {path("src/b.h"), dirs}}, 1);
+    auto waitFor = [&](std::size_t files) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (prefetcher.filesRead() < files && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return prefetcher.filesRead();
+    };
+    EXPECT_EQ(waitFor(1), 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // b.h waits for local.h to be done
+    EXPECT_EQ(prefetcher.filesRead(), 1u);
+    prefetcher.headerDone();
+    EXPECT_EQ(waitFor(4), 4u);
+}
@@ -0,0 +1,47 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "include_resolver.hpp"
+
+TEST(IncludeResolverTest, ResolvesSpellingToTheDirectoryHoldingIt) {
+    armor::IncludeResolver resolver("/proj", {"include/api/types.h", "src/detail/util.hpp", "config.h"});
+
+    EXPECT_EQ(resolver.resolve("api/types.h", "/proj/include/api/foo.h"), "/proj/include");
+    EXPECT_EQ(resolver.resolve("types.h", "/proj/include/foo.h"), "/proj/include/api");
+    EXPECT_EQ(resolver.resolve("./detail/util.hpp", "/proj/src/a.h"), "/proj/src");
+    EXPECT_EQ(resolver.resolve("config.h", "/proj/include/foo.h"), "/proj");
+
+    // Only whole path components match
+    EXPECT_EQ(resolver.resolve("pi/types.h", "/proj/include/foo.h"), "");
+    EXPECT_EQ(resolver.resolve("missing.h", "/proj/include/foo.h"), "");
+    EXPECT_EQ(resolver.resolve("../api/types.h", "/proj/include/foo.h"), "");
+    EXPECT_EQ(resolver.resolve("/proj/config.h", "/proj/include/foo.h"), "");
+}
+
+TEST(IncludeResolverTest, PrefersTheDirectoryClosestToTheIncluder) {
+    armor::IncludeResolver resolver("/proj", {"a/common/log.h", "b/common/log.h"});
+
+    EXPECT_EQ(resolver.resolve("common/log.h", "/proj/b/x/foo.h"), "/proj/b");
+    EXPECT_EQ(resolver.resolve("common/log.h", "/proj/a/foo.h"), "/proj/a");
+    // Equally close, the first in path order
+    EXPECT_EQ(resolver.resolve("common/log.h", "/proj/c/foo.h"), "/proj/a");
+}
+
+TEST(IncludeResolverTest, IndexesTheHeadersUnderARoot) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "armor_include_resolver_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "third_party" / "zlib");
+    std::ofstream(dir / "third_party" / "zlib" / "zconf.h") << "";
+    std::ofstream(dir / "third_party" / "zlib" / "zlib.c") << "";
+
+    std::shared_ptr<const armor::IncludeResolver> resolver = armor::IncludeResolver::forRoot(dir.string());
+    EXPECT_EQ(resolver->size(), 1u);
+    EXPECT_EQ(resolver->resolve("zconf.h", (dir / "api.h").string()), (dir / "third_party" / "zlib").string());
+    EXPECT_EQ(resolver->resolve("zlib.c", (dir / "api.h").string()), "");
+    EXPECT_EQ(armor::IncludeResolver::forRoot(dir.string()), resolver);
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,50 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "json_stream.hpp"
+
+using json = nlohmann::json;
+
+class JsonStreamWriterTest : public ::testing::Test {
+protected:
+    std::ostringstream out;
+    armor::JsonStreamWriter writer{out};
+};
+
+TEST_F(JsonStreamWriterTest, MatchesDumpOfWholeDocument) {
+    json records = json::array({
+        {{"name", "foo"}, {"children", json::array({1, 2})}, {"empty", json::object()}},
+        {{"name", "bar\nbaz"}, {"children", json::array()}}
+    });
+
+    writer.beginObject();
+    writer.key("api_diff");
+    writer.beginArray();
+    for (const auto& record : records) {
+        writer.value(record);
+    }
+    writer.endArray();
+    writer.field("reason", "none");
+    writer.field("status", 2);
+    writer.endObject();
+
+    json expected{{"api_diff", records}, {"reason", "none"}, {"status", 2}};
+    EXPECT_EQ(out.str(), expected.dump(4));
+}
+
+TEST_F(JsonStreamWriterTest, WritesEmptyContainersInline) {
+    writer.beginObject();
+    writer.key("entries");
+    writer.beginArray();
+    writer.endArray();
+    writer.key("nested");
+    writer.beginObject();
+    writer.endObject();
+    writer.endObject();
+
+    json expected{{"entries", json::array()}, {"nested", json::object()}};
+    EXPECT_EQ(out.str(), expected.dump(4));
+}
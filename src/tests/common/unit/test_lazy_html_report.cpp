@@ -0,0 +1,106 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "llvm/Support/Compression.h"
+#include "comm_def.hpp"
+#include "report_utils.hpp"
+
+class LazyHtmlReportTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_lazy_html_report_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        setHtmlReportMode(HtmlReportMode::TABLE);
+        std::filesystem::remove_all(dir);
+    }
+
+    static json record(const std::string& name, const std::string& description, const char* compatibility) {
+        return json{{"headerfile", "include/foo.h"},
+                    {"name", name},
+                    {"description", description},
+                    {"changetype", "Compatibility_changed"},
+                    {"compatibility", compatibility}};
+    }
+
+    std::string report(const ApiChangeGroups& groups) {
+        std::filesystem::path path = dir / "report.html";
+        generate_html_report(groups, path.string(), BETA_PARSER, 0, 0, "backward_incompatible",
+                             "BACKWARD_INCOMPATIBLE", "Backward incompatible changes");
+        std::ifstream in(path);
+        std::ostringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+};
+
+TEST_F(LazyHtmlReportTest, TableIsTheDefault) {
+    EXPECT_EQ(getHtmlReportMode(), HtmlReportMode::TABLE);
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(record("foo", "changed", "backward_incompatible"));
+
+    std::string html = report(groups);
+    EXPECT_NE(html.find("<td> foo </td>"), std::string::npos);
+    EXPECT_EQ(html.find("armor-rows"), std::string::npos);
+}
+
+TEST_F(LazyHtmlReportTest, LazyEmbedsRowsAsJson) {
+    setHtmlReportMode(HtmlReportMode::LAZY);
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(record("foo", "first", "backward_incompatible"));
+    groups.addRecord(record("foo", "second</script>", "backward_incompatible"));
+    groups.addRecord(record("bar", "added", "backward_compatible"));
+
+    std::string html = report(groups);
+    EXPECT_EQ(html.find("<td>"), std::string::npos);
+    EXPECT_NE(html.find("Backward incompatible changes"), std::string::npos);
+
+    const std::string open = "<script type=\"application/json\" id=\"armor-rows\">";
+    size_t begin = html.find(open);
+    ASSERT_NE(begin, std::string::npos);
+    begin += open.size();
+    size_t end = html.find("</script>", begin);
+    ASSERT_NE(end, std::string::npos);
+
+    // The description's "</" must not end the element early
+    json data = json::parse(html.substr(begin, end - begin));
+    EXPECT_EQ(data["headers"], json::array({"include/foo.h"}));
+    ASSERT_EQ(data["rows"].size(), 2u);
+    EXPECT_EQ(data["rows"][0], json::array({0, "bar", "added", 1, 0}));
+    EXPECT_EQ(data["rows"][1], json::array({0, "foo", "first\nsecond</script>", 1, 1}));
+}
+
+TEST_F(LazyHtmlReportTest, LargeRowsAreCompressed) {
+    if (!llvm::zlib::isAvailable()) {
+        GTEST_SKIP() << "LLVM was built without zlib";
+    }
+    setHtmlReportMode(HtmlReportMode::LAZY);
+    ApiChangeGroups groups("include/foo.h");
+    for (int i = 0; i < 2000; ++i) {
+        groups.addRecord(record("api_" + std::to_string(i), "Function signature changed", "backward_incompatible"));
+    }
+
+    std::string html = report(groups);
+    EXPECT_NE(html.find("id=\"armor-rows\" data-encoding=\"deflate-base64\">"), std::string::npos);
+    EXPECT_EQ(html.find("api_1999"), std::string::npos);
+}
+
+TEST_F(LazyHtmlReportTest, AutoSwitchesAtTheRowThreshold) {
+    setHtmlReportMode(HtmlReportMode::AUTO);
+    ApiChangeGroups groups("include/foo.h");
+    for (size_t i = 0; i + 1 < LAZY_HTML_MIN_ROWS; ++i) {
+        groups.addRecord(record("api_" + std::to_string(i), "", "backward_compatible"));
+    }
+    EXPECT_EQ(report(groups).find("armor-rows"), std::string::npos);
+
+    groups.addRecord(record("last", "", "backward_compatible"));
+    EXPECT_NE(report(groups).find("armor-rows"), std::string::npos);
+}
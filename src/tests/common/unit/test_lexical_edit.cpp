@@ -0,0 +1,45 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include "lexical_edit.hpp"
+
+using armor::LexicalEdit;
+using armor::classifyLexicalEdit;
+
+TEST(LexicalEditTest, LayoutOnlyIsWhitespace) {
+    EXPECT_EQ(classifyLexicalEdit("int f(int a,int b);\nstruct S{int x;};\n",
+                                  "int f(int a, int b);\n\nstruct S {\n    int x;\n};\n"),
+              LexicalEdit::WHITESPACE);
+    EXPECT_EQ(classifyLexicalEdit("#define A  1\n#if A\nint x;\n#endif\n", "#define A 1\n#if   A\nint x;\n#endif"),
+              LexicalEdit::WHITESPACE);
+    EXPECT_EQ(classifyLexicalEdit("int *p;", "int* p;"), LexicalEdit::WHITESPACE);
+}
+
+TEST(LexicalEditTest, CommentEditsAreComments) {
+    EXPECT_EQ(classifyLexicalEdit("// old\nint f(); /* x */\n", "// new text\nint f();\n"), LexicalEdit::COMMENTS);
+    EXPECT_EQ(classifyLexicalEdit("#define A 1\n", "#define A /* one */ 1\n"), LexicalEdit::COMMENTS);
+    EXPECT_EQ(classifyLexicalEdit("int a, b;", "int a,/**/b;"), LexicalEdit::COMMENTS);
+}
+
+TEST(LexicalEditTest, TokenEditsAreTokens) {
+    EXPECT_EQ(classifyLexicalEdit("int f();", "long f();"), LexicalEdit::TOKENS);
+    EXPECT_EQ(classifyLexicalEdit("const char* s = \"a b\";", "const char* s = \"ab\";"), LexicalEdit::TOKENS);
+    // Separations that keep tokens apart
+    EXPECT_EQ(classifyLexicalEdit("unsigned int x;", "unsignedint x;"), LexicalEdit::TOKENS);
+    EXPECT_EQ(classifyLexicalEdit("int x = a - -b;", "int x = a --b;"), LexicalEdit::TOKENS);
+    EXPECT_EQ(classifyLexicalEdit("int/**/x;", "intx;"), LexicalEdit::TOKENS);
+    EXPECT_EQ(classifyLexicalEdit("auto s = u8 \"x\";", "auto s = u8\"x\";"), LexicalEdit::TOKENS);
+}
+
+TEST(LexicalEditTest, DirectiveLinesAreKept) {
+    // A function-like macro differs from an object-like one by a space
+    EXPECT_EQ(classifyLexicalEdit("#define F(x) x\n", "#define F (x) x\n"), LexicalEdit::TOKENS);
+    // Joining or splitting a directive's lines changes what it covers
+    EXPECT_EQ(classifyLexicalEdit("#define A 1\nint x;\n", "#define A 1 int x;\n"), LexicalEdit::TOKENS);
+    EXPECT_EQ(classifyLexicalEdit("int x; #define A 1\n", "int x;\n#define A 1\n"), LexicalEdit::TOKENS);
+    EXPECT_EQ(classifyLexicalEdit("#define A 1 \\\n  + 2\n", "#define A 1 + 2\n"), LexicalEdit::TOKENS);
+    // A comment spanning lines continues the directive it starts on
+    EXPECT_EQ(classifyLexicalEdit("#define A 1 /*\n*/ + 2\n", "#define A 1 /* c */ + 2\n"), LexicalEdit::COMMENTS);
+    // Ordinary lines may be joined and split at will
+    EXPECT_EQ(classifyLexicalEdit("int\nx\n;\n", "int x;\n"), LexicalEdit::WHITESPACE);
+}
@@ -0,0 +1,96 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "diff_utils.hpp"
+#include "macro_matrix.hpp"
+#include "output_paths.hpp"
+#include "report_utils.hpp"
+
+class MacroMatrixTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_macro_matrix_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string writeMatrix(const std::string& text) {
+        std::filesystem::path path = dir / "matrix.yaml";
+        std::ofstream(path) << text;
+        return path.string();
+    }
+
+    // Writes the JSON report of a.h, with one row per description, under the run rooted at `run`
+    void writeReport(const std::string& run, const std::vector<std::string>& descriptions) {
+        armor::OutputPaths outputs{(dir / run).string()};
+        std::filesystem::create_directories(outputs.jsonReportDir());
+        ApiChangeGroups groups("a.h");
+        for (const auto& description : descriptions) {
+            groups.addRecord(json{{"headerfile", "a.h"},
+                                  {"name", description},
+                                  {"description", "changed"},
+                                  {"changetype", "Compatibility_changed"},
+                                  {"compatibility", "backward_incompatible"}});
+        }
+        generate_json_report(groups, outputs.jsonReportFile("a.h"),
+                             static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                             static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                             "backward_incompatible", "STATUS", "reason");
+    }
+};
+
+TEST_F(MacroMatrixTest, LoadsTheConfigurations) {
+    auto configurations = armor::loadMacroMatrix(writeMatrix(
+        "- name: feature_x\n"
+        "  macro-flags: -DFEATURE_X\n"
+        "- name: plain\n"));
+    ASSERT_EQ(configurations.size(), 2u);
+    EXPECT_EQ(configurations[0].name, "feature_x");
+    EXPECT_EQ(configurations[0].macroFlags, "-DFEATURE_X");
+    EXPECT_EQ(configurations[1].name, "plain");
+    EXPECT_EQ(configurations[1].macroFlags, "");
+}
+
+TEST_F(MacroMatrixTest, RejectsInvalidMatrices) {
+    EXPECT_THROW(armor::loadMacroMatrix((dir / "missing.yaml").string()), std::runtime_error);
+    EXPECT_THROW(armor::loadMacroMatrix(writeMatrix("[]\n")), std::runtime_error);
+    EXPECT_THROW(armor::loadMacroMatrix(writeMatrix("- macro-flags: -DX\n")), std::runtime_error);
+    EXPECT_THROW(armor::loadMacroMatrix(writeMatrix("- name: ../up\n")), std::runtime_error);
+    EXPECT_THROW(armor::loadMacroMatrix(writeMatrix("- name: x\n- name: x\n")), std::runtime_error);
+}
+
+TEST_F(MacroMatrixTest, ListsTheConfigurationsOfEachFinding) {
+    writeReport("one", {"shared", "only_one"});
+    writeReport("two", {"shared"});
+
+    armor::MatrixReport report;
+    EXPECT_EQ(report.addConfiguration("one", (dir / "one").string()), 1u);
+    EXPECT_EQ(report.addConfiguration("two", (dir / "two").string()), 1u);
+    EXPECT_EQ(report.addConfiguration("none", (dir / "none").string()), 0u);
+    EXPECT_EQ(report.findingCount(), 2u);
+    EXPECT_TRUE(report.hasBackwardIncompatible());
+
+    armor::OutputPaths outputs{(dir / "matrix").string()};
+    report.write(outputs);
+    EXPECT_TRUE(std::filesystem::exists(outputs.matrixHtmlFile()));
+    std::ifstream in(outputs.matrixJsonFile());
+    json matrix = json::parse(in);
+    ASSERT_EQ(matrix["configurations"].size(), 3u);
+    EXPECT_EQ(matrix["configurations"][2]["reports"], 0);
+    ASSERT_EQ(matrix["api_diff"].size(), 2u);
+    EXPECT_EQ(matrix["api_diff"][0]["name"], "only_one");
+    EXPECT_EQ(matrix["api_diff"][0]["configurations"], json::array({"one"}));
+    EXPECT_EQ(matrix["api_diff"][1]["name"], "shared");
+    EXPECT_EQ(matrix["api_diff"][1]["configurations"], json::array({"one", "two"}));
+    EXPECT_EQ(matrix["compatibility"], "backward_incompatible");
+}
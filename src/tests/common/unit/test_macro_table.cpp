@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "macro_table.hpp"
+
+TEST(MacroTableTest, DefinitionOrderDoesNotMatter) {
+    MacroTable a;
+    a.define("VERSION", 1);
+    a.define("MAX", 2);
+    MacroTable b;
+    b.define("MAX", 2);
+    b.define("VERSION", 1);
+    EXPECT_FALSE(a.differs(b));
+    EXPECT_TRUE(MacroTable::diff(a, b).empty());
+    EXPECT_EQ(a.size(), 2u);
+}
+
+TEST(MacroTableTest, LastDefinitionWins) {
+    MacroTable a;
+    a.define("MAX", 1);
+    a.define("MAX", 2);
+    MacroTable b;
+    b.define("MAX", 2);
+    EXPECT_FALSE(a.differs(b));
+    uint64_t hash = 0;
+    ASSERT_TRUE(a.lookup("MAX", hash));
+    EXPECT_EQ(hash, 2u);
+}
+
+TEST(MacroTableTest, UndefineRemovesTheMacro) {
+    MacroTable a;
+    a.define("GUARD", 7);
+    a.define("TEMP", 8);
+    a.undefine("TEMP");
+    a.undefine("NEVER_DEFINED");
+    MacroTable b;
+    b.define("GUARD", 7);
+    EXPECT_FALSE(a.differs(b));
+    EXPECT_EQ(a.size(), 1u);
+    uint64_t hash = 0;
+    EXPECT_FALSE(a.lookup("TEMP", hash));
+}
+
+TEST(MacroTableTest, DiffListsChangesByName) {
+    MacroTable older;
+    older.define("KEPT", 1);
+    older.define("REDEFINED", 2);
+    older.define("GONE", 3);
+    for (int i = 0; i < 500; ++i) {
+        older.define("SAME_" + std::to_string(i), i);
+    }
+    MacroTable newer;
+    newer.define("KEPT", 1);
+    newer.define("REDEFINED", 20);
+    newer.define("ADDED", 4);
+    for (int i = 0; i < 500; ++i) {
+        newer.define("SAME_" + std::to_string(i), i);
+    }
+
+    EXPECT_TRUE(older.differs(newer));
+    std::vector<MacroTable::Change> changes = MacroTable::diff(older, newer);
+    ASSERT_EQ(changes.size(), 3u);
+    EXPECT_EQ(changes[0].name, "ADDED");
+    EXPECT_EQ(changes[0].kind, MacroTable::ChangeKind::Added);
+    EXPECT_EQ(changes[1].name, "GONE");
+    EXPECT_EQ(changes[1].kind, MacroTable::ChangeKind::Removed);
+    EXPECT_EQ(changes[2].name, "REDEFINED");
+    EXPECT_EQ(changes[2].kind, MacroTable::ChangeKind::Modified);
+}
+
+TEST(MacroTableTest, ClearForgetsDirectiveHashes) {
+    MacroTable a;
+    a.define("X", 1);
+    a.addDirectiveHash(42);
+    EXPECT_FALSE(a.empty());
+    a.clear();
+    EXPECT_TRUE(a.empty());
+    EXPECT_FALSE(a.differs(MacroTable()));
+}
@@ -0,0 +1,24 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+#include "memory_usage.hpp"
+
+TEST(MemoryUsageTest, GrowsWithTouchedMemory) {
+    std::size_t before = armor::residentBytes();
+    ASSERT_GT(before, 0u);
+    constexpr std::size_t size = std::size_t(64) << 20;
+    std::unique_ptr<char[]> block(new char[size]);
+    std::memset(block.get(), 1, size);
+    EXPECT_GE(armor::residentBytes(), before + size / 2);
+}
+
+TEST(MemoryUsageTest, PeakCoversTheCurrentResidentSet) {
+    std::size_t resident = armor::residentBytes();
+    ASSERT_GT(resident, 0u);
+    // Pages are counted a little differently by the two sources
+    EXPECT_GE(armor::peakResidentBytes() + (std::size_t(1) << 20), resident);
+}
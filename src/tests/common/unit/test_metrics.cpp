@@ -0,0 +1,88 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "metrics.hpp"
+
+using armor::Metrics;
+
+namespace {
+
+    // The value of the series `name` exactly as rendered, e.g. `armor_queue_depth{worker="1"}`
+    double valueOf(const std::string& text, const std::string& series) {
+        std::istringstream lines(text);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (line.compare(0, series.size() + 1, series + " ") == 0) {
+                return std::stod(line.substr(series.size() + 1));
+            }
+        }
+        ADD_FAILURE() << "No series " << series;
+        return -1;
+    }
+
+}
+
+TEST(MetricsTest, CountsRequestsCachesAndFailures) {
+    Metrics& metrics = Metrics::getInstance();
+    std::string before = metrics.render();
+    metrics.countRequest("args", true, std::chrono::milliseconds(20));
+    metrics.countRequest("compare", false, std::chrono::milliseconds(2));
+    metrics.countRequest("bogus", false, std::chrono::milliseconds(1));
+    metrics.countCache(Metrics::CacheTier::MEMORY, false);
+    metrics.countCache(Metrics::CacheTier::DISK, true);
+    metrics.countParseFailure(true);
+    std::string after = metrics.render();
+
+    auto delta = [&](const std::string& series) { return valueOf(after, series) - valueOf(before, series); };
+    EXPECT_EQ(delta("armor_requests_total{kind=\"args\",result=\"ok\"}"), 1);
+    EXPECT_EQ(delta("armor_requests_total{kind=\"compare\",result=\"error\"}"), 1);
+    EXPECT_EQ(delta("armor_requests_total{kind=\"invalid\",result=\"error\"}"), 1);
+    EXPECT_EQ(delta("armor_cache_lookups_total{tier=\"memory\",result=\"miss\"}"), 1);
+    EXPECT_EQ(delta("armor_cache_lookups_total{tier=\"disk\",result=\"hit\"}"), 1);
+    EXPECT_EQ(delta("armor_cache_lookups_total{tier=\"remote\",result=\"hit\"}"), 0);
+    EXPECT_EQ(delta("armor_parse_failures_total{reason=\"timeout\"}"), 1);
+    EXPECT_EQ(delta("armor_parse_failures_total{reason=\"errors\"}"), 0);
+}
+
+TEST(MetricsTest, HistogramBucketsAreCumulative) {
+    Metrics& metrics = Metrics::getInstance();
+    std::string before = metrics.render();
+    metrics.observe(Metrics::Phase::PARSE, std::chrono::milliseconds(30));
+    metrics.observe(Metrics::Phase::PARSE, std::chrono::seconds(400));
+    std::string after = metrics.render();
+
+    auto delta = [&](const std::string& series) { return valueOf(after, series) - valueOf(before, series); };
+    EXPECT_EQ(delta("armor_phase_duration_seconds_bucket{phase=\"parse\",le=\"0.025\"}"), 0);
+    EXPECT_EQ(delta("armor_phase_duration_seconds_bucket{phase=\"parse\",le=\"0.05\"}"), 1);
+    EXPECT_EQ(delta("armor_phase_duration_seconds_bucket{phase=\"parse\",le=\"300\"}"), 1);
+    EXPECT_EQ(delta("armor_phase_duration_seconds_bucket{phase=\"parse\",le=\"+Inf\"}"), 2);
+    EXPECT_EQ(delta("armor_phase_duration_seconds_count{phase=\"parse\"}"), 2);
+    EXPECT_NEAR(delta("armor_phase_duration_seconds_sum{phase=\"parse\"}"), 400.03, 1e-6);
+    EXPECT_EQ(delta("armor_phase_duration_seconds_count{phase=\"diff\"}"), 0);
+}
+
+TEST(MetricsTest, TextfileCarriesProcessLabels) {
+    Metrics& metrics = Metrics::getInstance();
+    metrics.setQueueDepth(7);
+    metrics.beginBusy();
+    metrics.endBusy();
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "armor_test_metrics.prom";
+    ASSERT_TRUE(metrics.writeTextfile(path.string(), {{"worker", "2"}}));
+    std::ifstream in(path);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(valueOf(text, "armor_queue_depth{worker=\"2\"}"), 7);
+    EXPECT_EQ(valueOf(text, "armor_requests_total{worker=\"2\",kind=\"args\",result=\"ok\"}"),
+              valueOf(metrics.render(), "armor_requests_total{kind=\"args\",result=\"ok\"}"));
+    EXPECT_GE(valueOf(text, "armor_busy_seconds_total{worker=\"2\"}"), 0);
+    EXPECT_NE(text.find("# TYPE armor_phase_duration_seconds histogram\n"), std::string::npos);
+    EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+    metrics.setQueueDepth(0);
+}
@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include "comm_def.hpp"
+#include "output_paths.hpp"
+
+TEST(OutputPathsTest, EmptyRootKeepsTheWorkingDirectoryLayout) {
+    armor::OutputPaths outputs;
+    EXPECT_EQ(outputs.jsonReportDir(), "armor_reports/json_reports");
+    EXPECT_EQ(outputs.htmlReportFile("foo.h"), "armor_reports/html_reports/api_diff_report_foo.h.html");
+    EXPECT_EQ(outputs.logFile(), LOG_FILE_PATH);
+    EXPECT_EQ(outputs.astDiffDir(), "debug_output/ast_diffs");
+}
+
+TEST(OutputPathsTest, EverythingLivesUnderTheRoot) {
+    armor::OutputPaths outputs{"/tmp/run1"};
+    EXPECT_EQ(outputs.jsonReportFile("foo.h"), "/tmp/run1/armor_reports/json_reports/api_diff_report_foo.h.json");
+    EXPECT_EQ(outputs.profileDir(), "/tmp/run1/armor_reports/profiles");
+    EXPECT_EQ(outputs.logFile(), "/tmp/run1/" + LOG_FILE_PATH);
+    EXPECT_EQ(outputs.scratchDir("pch"), "/tmp/run1/debug_output/pch");
+}
+
+TEST(OutputPathsTest, ExplicitLogFileWins) {
+    armor::OutputPaths outputs{"/tmp/run1", "/var/log/armor.log"};
+    EXPECT_EQ(outputs.logFile(), "/var/log/armor.log");
+    EXPECT_EQ(outputs.astDiffDir(), "/tmp/run1/debug_output/ast_diffs");
+}
+
+TEST(OutputPathsTest, SummaryReportsSitNextToTheReportDirectories) {
+    armor::OutputPaths outputs{"/tmp/run1"};
+    EXPECT_EQ(outputs.summaryHtmlFile(), "/tmp/run1/armor_reports/summary_report.html");
+    EXPECT_EQ(outputs.summaryJsonFile(), "/tmp/run1/armor_reports/summary_report.json");
+    EXPECT_EQ(outputs.combinedHtmlFile(), "/tmp/run1/armor_reports/api_diff_report.html");
+}
+
+TEST(OutputPathsTest, CompressedDebugOutputIsNamedGz) {
+    armor::OutputPaths outputs{"/tmp/run1", "", true};
+    EXPECT_EQ(outputs.logFile(), "/tmp/run1/" + LOG_FILE_PATH + ".gz");
+    EXPECT_EQ(outputs.astDiffFile("foo.h"), "/tmp/run1/debug_output/ast_diffs/ast_diff_output_foo.h.json.gz");
+    armor::OutputPaths named{"", "armor.log.gz", true};
+    EXPECT_EQ(named.logFile(), "armor.log.gz");
+}
+
+TEST(OutputPathsTest, WorkerLogsSitNextToTheLog) {
+    armor::OutputPaths outputs{"/tmp/run1", "/var/log/armor.log"};
+    EXPECT_EQ(outputs.workerLogFile(2), "/var/log/armor.worker2.log");
+    armor::OutputPaths compressed{"", "armor.log", true};
+    EXPECT_EQ(compressed.workerLogFile(0), "armor.worker0.log.gz");
+}
+
+TEST(OutputPathsTest, ChainStepsGetRootsOfTheirOwn) {
+    armor::OutputPaths outputs{"/tmp/run1"};
+    EXPECT_EQ(outputs.chainStepRoot("v1_v2"), "/tmp/run1/chain/v1_v2");
+    EXPECT_EQ(outputs.chainJsonFile(), "/tmp/run1/armor_reports/chain_report.json");
+    EXPECT_EQ(outputs.checkJsonFile(), "/tmp/run1/armor_reports/check_report.json");
+    armor::OutputPaths step{outputs.chainStepRoot("v1_v2")};
+    EXPECT_EQ(step.jsonReportDir(), "/tmp/run1/chain/v1_v2/armor_reports/json_reports");
+}
+
+TEST(OutputPathsTest, SweepRoundsGetRootsOfTheirOwn) {
+    armor::OutputPaths outputs{"/tmp/run1"};
+    EXPECT_EQ(outputs.sweepRoundRoot(2, 1), "/tmp/run1/sweep/run2/round1");
+    EXPECT_EQ(outputs.sweepJsonFile(), "/tmp/run1/armor_reports/sweep_report.json");
+}
+
+TEST(OutputPathsTest, BasesGetRootsOfTheirOwn) {
+    armor::OutputPaths outputs{"/tmp/run1"};
+    EXPECT_EQ(outputs.multiBaseRoot("base2"), "/tmp/run1/multibase/base2");
+    EXPECT_EQ(outputs.multiBaseJsonFile(), "/tmp/run1/armor_reports/multibase_report.json");
+}
+
+TEST(OutputPathsTest, WhatIfCandidatesGetRootsOfTheirOwn) {
+    armor::OutputPaths outputs{"/tmp/run1"};
+    EXPECT_EQ(outputs.whatIfRoot("patch3"), "/tmp/run1/whatif/patch3");
+    EXPECT_EQ(outputs.whatIfJsonFile(), "/tmp/run1/armor_reports/whatif_report.json");
+}
+
+TEST(OutputPathsTest, DigestManifestIsWrittenWithTheReports) {
+    armor::OutputPaths outputs{"/tmp/run1"};
+    EXPECT_EQ(outputs.digestManifestFile(), "/tmp/run1/armor_reports/digest_manifest.json");
+}
@@ -0,0 +1,97 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "output_writer.hpp"
+
+class OutputWriterTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_output_writer_test";
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        armor::OutputWriter::getInstance().finish();
+        std::filesystem::remove_all(dir);
+    }
+
+    static std::string read(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+};
+
+TEST_F(OutputWriterTest, WritesDirectlyUntilStarted) {
+    armor::OutputWriter& writer = armor::OutputWriter::getInstance();
+    EXPECT_FALSE(writer.isAsync());
+    std::string path = (dir / "html" / "a.html").string();
+    EXPECT_TRUE(writer.write(path, "<p>a</p>"));
+    EXPECT_EQ(read(path), "<p>a</p>");
+
+    armor::OutputFile file((dir / "json" / "a.json").string());
+    file.stream() << "{}";
+    EXPECT_EQ(file.size(), 2u);
+    EXPECT_TRUE(file.close());
+    EXPECT_EQ(read(dir / "json" / "a.json"), "{}");
+}
+
+TEST_F(OutputWriterTest, WriterThreadWritesEverythingHandedOverByFinish) {
+    armor::OutputWriter& writer = armor::OutputWriter::getInstance();
+    // Small enough that the submitters wait for the writer
+    writer.start(64);
+    EXPECT_TRUE(writer.isAsync());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 25; ++i) {
+                std::string name = std::to_string(t) + "_" + std::to_string(i);
+                armor::OutputFile file((dir / std::to_string(t) / (name + ".txt")).string());
+                file.stream() << std::string(40, 'x') << name;
+                file.close();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(writer.finish(), 0u);
+    EXPECT_FALSE(writer.isAsync());
+
+    for (int t = 0; t < 4; ++t) {
+        for (int i = 0; i < 25; ++i) {
+            std::string name = std::to_string(t) + "_" + std::to_string(i);
+            EXPECT_EQ(read(dir / std::to_string(t) / (name + ".txt")), std::string(40, 'x') + name);
+        }
+    }
+}
+
+TEST_F(OutputWriterTest, RecreatesARemovedDirectory) {
+    armor::OutputWriter& writer = armor::OutputWriter::getInstance();
+    std::string first = (dir / "ast_diff" / "a.json").string();
+    EXPECT_TRUE(writer.write(first, "1"));
+    std::filesystem::remove_all(dir);
+
+    writer.start();
+    writer.write((dir / "ast_diff" / "b.json").string(), "2");
+    EXPECT_EQ(writer.finish(), 0u);
+    EXPECT_EQ(read(dir / "ast_diff" / "b.json"), "2");
+
+    armor::OutputFile file((dir / "html" / "c.html").string());
+    std::filesystem::remove_all(dir);
+    file.close();
+    armor::OutputFile again((dir / "html" / "c.html").string());
+    again.stream() << "3";
+    EXPECT_TRUE(again.close());
+    EXPECT_EQ(read(dir / "html" / "c.html"), "3");
+}
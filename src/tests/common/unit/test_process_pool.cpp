@@ -0,0 +1,142 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "logger.hpp"
+#include "process_pool.hpp"
+
+class ProcessPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(ProcessPoolTest, ResultsComeBackFromWorkerProcesses) {
+    pid_t parent = getpid();
+    armor::ProcessPool pool(3, [parent](std::size_t task) {
+        return std::to_string(task * task) + (getpid() == parent ? "" : "+");
+    });
+    std::map<std::size_t, std::string> results;
+    pool.run({0, 1, 2, 3, 4, 5, 6, 7}, [&](std::size_t task, const std::string* result, const std::string& failure) {
+        ASSERT_NE(result, nullptr) << failure;
+        results[task] = *result;
+    });
+    ASSERT_EQ(results.size(), 8u);
+    EXPECT_EQ(results[7], "49+");
+    EXPECT_EQ(pool.getRestarts(), 0u);
+}
+
+TEST_F(ProcessPoolTest, CrashFailsOnlyItsTask) {
+    armor::ProcessPool pool(2, [](std::size_t task) {
+        if (task == 3) {
+            std::abort();
+        }
+        return std::to_string(task);
+    });
+    std::map<std::size_t, std::string> results;
+    std::map<std::size_t, std::string> failures;
+    pool.run({0, 1, 2, 3, 4, 5}, [&](std::size_t task, const std::string* result, const std::string& failure) {
+        if (result) {
+            results[task] = *result;
+        } else {
+            failures[task] = failure;
+        }
+    });
+    EXPECT_EQ(results.size(), 5u);
+    ASSERT_EQ(failures.size(), 1u);
+    EXPECT_NE(failures[3].find("signal"), std::string::npos);
+    EXPECT_EQ(pool.getRestarts(), 1u);
+
+    // The replacement serves later runs
+    results.clear();
+    pool.run({6, 7}, [&](std::size_t task, const std::string* result, const std::string&) {
+        ASSERT_NE(result, nullptr);
+        results[task] = *result;
+    });
+    EXPECT_EQ(results.size(), 2u);
+}
+
+TEST_F(ProcessPoolTest, ExceptionFailsTaskWithoutRestart) {
+    armor::ProcessPool pool(1, [](std::size_t task) -> std::string {
+        if (task == 1) {
+            throw std::runtime_error("bad header");
+        }
+        return "ok";
+    });
+    std::string failure;
+    int succeeded = 0;
+    pool.run({0, 1, 2}, [&](std::size_t, const std::string* result, const std::string& why) {
+        if (result) {
+            ++succeeded;
+        } else {
+            failure = why;
+        }
+    });
+    EXPECT_EQ(succeeded, 2);
+    EXPECT_EQ(failure, "bad header");
+    EXPECT_EQ(pool.getRestarts(), 0u);
+}
+
+TEST_F(ProcessPoolTest, WorkersLogToFilesOfTheirOwn) {
+    std::string dir = ::testing::TempDir() + "process_pool_logs";
+    DebugConfig& debugConfig = DebugConfig::getInstance();
+    ASSERT_TRUE(debugConfig.initialize(dir + "/parent.log"));
+    {
+        armor::ProcessPool pool(2, [](std::size_t task) {
+            armor::info() << "worker task " << task << "\n";
+            return std::string();
+        }, [&](unsigned worker) {
+            DebugConfig::getInstance().initialize(dir + "/worker" + std::to_string(worker) + ".log");
+        });
+        pool.run({0, 1, 2, 3}, [](std::size_t, const std::string* result, const std::string& failure) {
+            ASSERT_NE(result, nullptr) << failure;
+        });
+    }
+    armor::info() << "parent still logging\n";
+    debugConfig.flush();
+
+    std::string workerLogs;
+    for (const char* name : {"/worker0.log", "/worker1.log"}) {
+        std::ifstream in(dir + name);
+        workerLogs += std::string(std::istreambuf_iterator<char>(in), {});
+    }
+    for (const char* line : {"worker task 0", "worker task 1", "worker task 2", "worker task 3"}) {
+        EXPECT_NE(workerLogs.find(line), std::string::npos) << line;
+    }
+    std::ifstream parentLog(dir + "/parent.log");
+    std::string parent((std::istreambuf_iterator<char>(parentLog)), {});
+    EXPECT_EQ(parent.find("worker task"), std::string::npos);
+    EXPECT_NE(parent.find("parent still logging"), std::string::npos);
+}
+
+TEST_F(ProcessPoolTest, TaskPastTheTimeoutIsKilled) {
+    armor::ProcessPool pool(2, [](std::size_t task) {
+        if (task == 1) {
+            sleep(30);
+        }
+        return std::to_string(task);
+    });
+    pool.setTaskTimeout(std::chrono::milliseconds(300));
+    std::map<std::size_t, std::string> results;
+    std::map<std::size_t, std::string> failures;
+    pool.run({0, 1, 2, 3}, [&](std::size_t task, const std::string* result, const std::string& failure) {
+        if (result) {
+            results[task] = *result;
+        } else {
+            failures[task] = failure;
+        }
+    });
+    EXPECT_EQ(results.size(), 3u);
+    ASSERT_EQ(failures.size(), 1u);
+    EXPECT_EQ(failures[1], armor::ProcessPool::TIMEOUT_FAILURE);
+    EXPECT_EQ(pool.getTimeouts(), 1u);
+    EXPECT_EQ(pool.getRestarts(), 0u);
+}
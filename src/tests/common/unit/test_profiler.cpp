@@ -0,0 +1,205 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "profiler.hpp"
+
+using namespace armor::profile;
+
+class ProfilerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Profiler::getInstance().reset();
+        Profiler::getInstance().setEnabled(true);
+    }
+
+    void TearDown() override {
+        Profiler::getInstance().setEnabled(false);
+        Profiler::getInstance().setTracing(false);
+        Profiler::getInstance().setMemoryProfiling(false);
+        Profiler::getInstance().setHardwareProfiling(false);
+        Profiler::getInstance().reset();
+    }
+};
+
+TEST_F(ProfilerTest, DisabledProfilerRecordsNothing) {
+    Profiler::getInstance().setEnabled(false);
+    EXPECT_EQ(Profiler::getInstance().forHeader("include/foo.h"), nullptr);
+
+    HeaderScope scope("include/foo.h");
+    EXPECT_EQ(current(), nullptr);
+    PhaseTimer timer(Phase::DIFF_TREES);
+    count(Counter::NODES_BUILT);
+}
+
+TEST_F(ProfilerTest, VersionsOfAHeaderShareOneProfile) {
+    HeaderProfile* older = Profiler::getInstance().forHeader("old/include/foo.h");
+    HeaderProfile* newer = Profiler::getInstance().forHeader("new/include/foo.h");
+    ASSERT_NE(older, nullptr);
+    EXPECT_EQ(older, newer);
+    EXPECT_EQ(older->getHeader(), "foo.h");
+    EXPECT_NE(older, Profiler::getInstance().forHeader("new/include/bar.h"));
+}
+
+TEST_F(ProfilerTest, ScopesRouteTimersAndCounters) {
+    HeaderProfile* foo = Profiler::getInstance().forHeader("foo.h");
+    HeaderProfile* bar = Profiler::getInstance().forHeader("bar.h");
+    {
+        HeaderScope outer("foo.h");
+        count(Counter::USRS_GENERATED, 3);
+        {
+            HeaderScope inner("bar.h");
+            PhaseTimer timer(Phase::GENERATE_HTML_REPORT);
+            count(Counter::USRS_GENERATED);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(current(), foo);
+    }
+    EXPECT_EQ(current(), nullptr);
+
+    EXPECT_EQ(foo->getCounter(Counter::USRS_GENERATED), 3u);
+    EXPECT_EQ(bar->getCounter(Counter::USRS_GENERATED), 1u);
+    EXPECT_EQ(foo->getPhaseCalls(Phase::GENERATE_HTML_REPORT), 0u);
+    EXPECT_EQ(bar->getPhaseCalls(Phase::GENERATE_HTML_REPORT), 1u);
+    EXPECT_GE(bar->getPhaseNanos(Phase::GENERATE_HTML_REPORT), 1000000u);
+}
+
+TEST_F(ProfilerTest, ProfileJsonListsPhasesThatRan) {
+    HeaderProfile* foo = Profiler::getInstance().forHeader("foo.h");
+    foo->addPhase(Phase::DIFF_TREES, std::chrono::milliseconds(2));
+    foo->addPhase(Phase::DIFF_TREES, std::chrono::milliseconds(3));
+    foo->add(Counter::JSON_BYTES_WRITTEN, 42);
+
+    nlohmann::json profile = foo->toJson();
+    EXPECT_EQ(profile["header"], "foo.h");
+    EXPECT_EQ(profile["phases"].size(), 1u);
+    EXPECT_EQ(profile["phases"]["diff_trees"]["calls"], 2);
+    EXPECT_DOUBLE_EQ(profile["phases"]["diff_trees"]["ms"].get<double>(), 5.0);
+    EXPECT_EQ(profile["counters"]["json_bytes_written"], 42);
+    EXPECT_EQ(profile["counters"]["nodes_built"], 0);
+}
+
+TEST_F(ProfilerTest, WallSpanCoversTracedTimersOnly) {
+    HeaderProfile* foo = Profiler::getInstance().forHeader("foo.h");
+    EXPECT_EQ(foo->getWallNanos(), 0u);
+    auto start = std::chrono::steady_clock::now();
+    foo->noteSpan(start + std::chrono::milliseconds(5), start + std::chrono::milliseconds(7));
+    foo->noteSpan(start, start + std::chrono::milliseconds(2));
+    EXPECT_EQ(foo->getWallNanos(), 7000000u);
+
+    HeaderProfile* bar = Profiler::getInstance().forHeader("bar.h");
+    {
+        HeaderScope scope("bar.h");
+        PhaseTimer perEntry(Phase::PREPROCESS_API_CHANGES, /*traced=*/false);
+    }
+    EXPECT_EQ(bar->getWallNanos(), 0u);
+    {
+        HeaderScope scope("bar.h");
+        PhaseTimer timer(Phase::DIFF_TREES);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GE(bar->getWallNanos(), 1000000u);
+
+    std::vector<std::string> visited;
+    Profiler::getInstance().forEachProfile([&visited](const HeaderProfile& profile) {
+        visited.push_back(profile.getHeader());
+    });
+    EXPECT_EQ(visited, (std::vector<std::string>{"bar.h", "foo.h"}));
+}
+
+TEST_F(ProfilerTest, MemoryProfilingAccountsAllocationsAndNodes) {
+    Profiler::getInstance().setMemoryProfiling(true);
+    HeaderProfile* foo = Profiler::getInstance().forHeader("foo.h");
+    {
+        HeaderScope scope("foo.h");
+        PhaseTimer timer(Phase::DIFF_TREES);
+        std::unique_ptr<std::vector<char>> buffer = std::make_unique<std::vector<char>>(1 << 16);
+        countNodes(NodeKind::Function, 2);
+        countNodes(NodeKind::Struct);
+    }
+    // Counted only where the build links the allocation hooks (ARMOR_ALLOC_PROFILING)
+    if (allocationsCounted()) {
+        EXPECT_GE(foo->getAllocations(Phase::DIFF_TREES), 2u);
+        EXPECT_GE(foo->getAllocatedBytes(Phase::DIFF_TREES), 1u << 16);
+    }
+    else {
+        EXPECT_EQ(foo->getAllocations(Phase::DIFF_TREES), 0u);
+    }
+    EXPECT_GT(foo->getPeakResident(Phase::DIFF_TREES), 0u);
+    EXPECT_EQ(foo->getNodes(NodeKind::Function), 2u);
+    EXPECT_EQ(foo->getAllocations(Phase::GENERATE_JSON_REPORT), 0u);
+
+    nlohmann::json profile = foo->toJson(true);
+    EXPECT_EQ(profile["phases"]["diff_trees"]["allocations"], foo->getAllocations(Phase::DIFF_TREES));
+    EXPECT_EQ(profile["node_kinds"].size(), 2u);
+    EXPECT_FALSE(foo->toJson().contains("node_kinds"));
+
+    Profiler::getInstance().setMemoryProfiling(false);
+    {
+        HeaderScope scope("foo.h");
+        countNodes(NodeKind::Function);
+    }
+    EXPECT_EQ(foo->getNodes(NodeKind::Function), 2u);
+}
+
+TEST_F(ProfilerTest, HardwareProfilingCountsWhereThePmuIsReadable) {
+    Profiler::getInstance().setHardwareProfiling(true);
+    HeaderProfile* foo = Profiler::getInstance().forHeader("foo.h");
+    volatile uint64_t sum = 0;
+    {
+        HeaderScope scope("foo.h");
+        PhaseTimer timer(Phase::TREE_BUILD);
+        for (uint64_t i = 0; i < 100000; ++i) {
+            sum = sum + i;
+        }
+    }
+    HardwareSample sample{};
+    if (!readHardwareCounters(sample)) {
+        // Sandboxes and containers commonly deny perf_event_open
+        EXPECT_FALSE(hardwareCountersError().empty());
+        EXPECT_EQ(foo->getHardware(Phase::TREE_BUILD, HardwareEvent::CYCLES), 0u);
+        return;
+    }
+    EXPECT_GT(foo->getHardware(Phase::TREE_BUILD, HardwareEvent::INSTRUCTIONS), 100000u);
+    nlohmann::json profile = foo->toJson(false, true);
+    EXPECT_EQ(profile["phases"]["tree_build"]["hardware"]["cycles"], foo->getHardware(Phase::TREE_BUILD, HardwareEvent::CYCLES));
+}
+
+TEST_F(ProfilerTest, TraceHasOneTrackPerThread) {
+    Profiler::getInstance().setEnabled(false);
+    Profiler::getInstance().setTracing(true);
+
+    auto compare = [](const char* file) {
+        HeaderScope scope(file);
+        TraceSpan span("compare_header");
+        PhaseTimer timer(Phase::DIFF_TREES);
+        PhaseTimer untraced(Phase::PREPROCESS_API_CHANGES, /*traced=*/false);
+    };
+    compare("foo.h");
+    std::thread worker(compare, "bar.h");
+    worker.join();
+
+    std::string path = ::testing::TempDir() + "armor_profiler_trace.json";
+    ASSERT_TRUE(Profiler::getInstance().writeTrace(path));
+    std::ifstream in(path);
+    nlohmann::json trace = nlohmann::json::parse(in);
+
+    std::set<int> tracks;
+    std::set<std::string> spans;
+    for (const auto& event : trace["traceEvents"]) {
+        if (event["ph"] == "X") {
+            tracks.insert(event["tid"].get<int>());
+            spans.insert(event["name"].get<std::string>() + "@" + event["args"]["header"].get<std::string>());
+            EXPECT_GE(event["dur"].get<double>(), 0.0);
+        }
+    }
+    EXPECT_EQ(tracks.size(), 2u);
+    EXPECT_EQ(spans, (std::set<std::string>{"compare_header@bar.h", "compare_header@foo.h",
+                                            "diff_trees@bar.h", "diff_trees@foo.h"}));
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "project_pairs.hpp"
+
+class ProjectPairsTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_project_pairs_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string writePairs(const std::string& text) {
+        std::filesystem::path path = dir / "pairs.yaml";
+        std::ofstream(path) << text;
+        return path.string();
+    }
+};
+
+TEST_F(ProjectPairsTest, LoadsTheProjects) {
+    auto projects = armor::loadProjectPairs(writePairs(
+        "- name: net\n"
+        "  root1: old/net\n"
+        "  root2: /abs/new/net\n"
+        "  header-dir: include\n"
+        "  include-paths: [deps/asio, /usr/include/x]\n"
+        "  macro-flags: -DNET_SHARED\n"
+        "- name: codec\n"
+        "  root1: old/codec\n"
+        "  root2: new/codec\n"
+        "  headers: [include/codec.h, include/frame.h]\n"
+        "  lang: c\n"));
+    ASSERT_EQ(projects.size(), 2u);
+    EXPECT_EQ(projects[0].name, "net");
+    EXPECT_EQ(projects[0].root1, (dir / "old/net").string());
+    EXPECT_EQ(projects[0].root2, "/abs/new/net");
+    EXPECT_EQ(projects[0].headerDir, "include");
+    EXPECT_TRUE(projects[0].headers.empty());
+    EXPECT_EQ(projects[0].includePaths, (std::vector<std::string>{(dir / "deps/asio").string(), "/usr/include/x"}));
+    EXPECT_EQ(projects[0].macroFlags, "-DNET_SHARED");
+    EXPECT_EQ(projects[0].lang, "");
+    EXPECT_EQ(projects[1].headers, (std::vector<std::string>{"include/codec.h", "include/frame.h"}));
+    EXPECT_EQ(projects[1].lang, "c");
+}
+
+TEST_F(ProjectPairsTest, RejectsInvalidFiles) {
+    EXPECT_THROW(armor::loadProjectPairs((dir / "missing.yaml").string()), std::runtime_error);
+    EXPECT_THROW(armor::loadProjectPairs(writePairs("[]\n")), std::runtime_error);
+    EXPECT_THROW(armor::loadProjectPairs(writePairs("- name: a\n  root1: x\n  headers: [a.h]\n")),
+                 std::runtime_error);
+    EXPECT_THROW(armor::loadProjectPairs(writePairs("- name: a\n  root1: x\n  root2: y\n")), std::runtime_error);
+    EXPECT_THROW(armor::loadProjectPairs(writePairs("- name: a/b\n  root1: x\n  root2: y\n  header-dir: i\n")),
+                 std::runtime_error);
+    EXPECT_THROW(armor::loadProjectPairs(writePairs("- name: a\n  root1: x\n  root2: y\n  header-dir: i\n"
+                                                    "  lang: rust\n")),
+                 std::runtime_error);
+    EXPECT_THROW(armor::loadProjectPairs(writePairs("- name: a\n  root1: x\n  root2: y\n  header-dir: i\n"
+                                                    "- name: a\n  root1: x\n  root2: y\n  header-dir: j\n")),
+                 std::runtime_error);
+}
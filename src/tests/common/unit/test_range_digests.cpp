@@ -0,0 +1,80 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include "range_digests.hpp"
+
+using Category = RangeDigests::Category;
+using Normalization = SourceHashIndex::Normalization;
+
+class RangeDigestsTest : public ::testing::Test {
+protected:
+    // Records the whole of `text` under `hash`, as a producer would
+    static RangeDigests version(const std::string& text, uint64_t hash) {
+        RangeDigests digests;
+        digests.record(Category::UnhandledDecls, hash, 0, static_cast<unsigned>(text.size()), Normalization::Source);
+        digests.keepSource(text);
+        return digests;
+    }
+
+    static HashMultiset hashes(uint64_t hash) {
+        HashMultiset matched;
+        matched.insert(hash);
+        return matched;
+    }
+};
+
+TEST_F(RangeDigestsTest, EqualTextsConfirm) {
+    RangeDigests older = version("struct S { int a; };", 7);
+    RangeDigests newer = version("struct S {\n    int a; // kept\n};", 7);
+    EXPECT_TRUE(RangeDigests::confirm(older, newer, Category::UnhandledDecls, hashes(7)));
+}
+
+TEST_F(RangeDigestsTest, CollidingTextsDoNotConfirm) {
+    // Two different texts given the same 64-bit hash, as a collision would
+    RangeDigests older = version("struct S { int a; };", 7);
+    RangeDigests newer = version("struct S { long a; };", 7);
+    EXPECT_FALSE(RangeDigests::confirm(older, newer, Category::UnhandledDecls, hashes(7)));
+    // Only the matched hashes and the given category are compared
+    EXPECT_TRUE(RangeDigests::confirm(older, newer, Category::UnhandledDecls, hashes(8)));
+    EXPECT_TRUE(RangeDigests::confirm(older, newer, Category::Comments, hashes(7)));
+}
+
+TEST_F(RangeDigestsTest, VersionsWithoutTextAreTrusted) {
+    RangeDigests older = version("int a;", 7);
+    RangeDigests newer;
+    newer.record(Category::UnhandledDecls, 7, 0, 7, Normalization::Source);
+    EXPECT_FALSE(newer.hasSource());
+    EXPECT_TRUE(RangeDigests::confirm(older, newer, Category::UnhandledDecls, hashes(7)));
+}
+
+TEST_F(RangeDigestsTest, WhitespaceNormalizedRangesKeepComments) {
+    std::string oldText = "/* width in px */";
+    std::string newText = "/* height in px */";
+    RangeDigests older;
+    older.record(Category::Comments, 3, 0, static_cast<unsigned>(oldText.size()), Normalization::Whitespace);
+    older.keepSource(oldText);
+    RangeDigests newer;
+    newer.record(Category::Comments, 3, 0, static_cast<unsigned>(newText.size()), Normalization::Whitespace);
+    newer.keepSource(newText);
+    EXPECT_FALSE(RangeDigests::confirm(older, newer, Category::Comments, hashes(3)));
+}
+
+TEST_F(RangeDigestsTest, AppendedRangesConfirmLikeRecordedOnes) {
+    std::string text = "struct S { int a; };";
+    RangeDigests older = version(text, 7);
+    // A builder beside the one recording `newer` covered the colliding range
+    RangeDigests beside;
+    beside.record(Category::UnhandledDecls, 7, 0, 10, Normalization::Source);
+    RangeDigests newer;
+    newer.keepSource(text);
+    EXPECT_TRUE(newer.empty());
+    newer.append(beside);
+    EXPECT_FALSE(newer.empty());
+    EXPECT_FALSE(RangeDigests::confirm(older, newer, Category::UnhandledDecls, hashes(7)));
+    // The same range twice digests once
+    newer = version(text, 7);
+    newer.append(version(text, 7));
+    EXPECT_TRUE(RangeDigests::confirm(older, newer, Category::UnhandledDecls, hashes(7)));
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "report_format.hpp"
+
+using armor::ReportFormat;
+
+class ReportFormatTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_report_format_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string write(const std::string& name, const nlohmann::json& document, ReportFormat format) {
+        std::string path = (dir / name).string();
+        std::ofstream out(path, std::ios::binary);
+        armor::writeReportDocument(out, document, format);
+        return path;
+    }
+};
+
+TEST_F(ReportFormatTest, NamesAndExtensions) {
+    EXPECT_EQ(armor::reportFormatOf("html"), ReportFormat::JSON);
+    EXPECT_EQ(armor::reportFormatOf("json"), ReportFormat::JSON);
+    EXPECT_EQ(armor::reportFormatOf("cbor"), ReportFormat::CBOR);
+    EXPECT_EQ(armor::reportFormatOf("msgpack"), ReportFormat::MSGPACK);
+
+    EXPECT_EQ(armor::reportFormatOfPath("a/api_diff_report_x.h.cbor"), ReportFormat::CBOR);
+    EXPECT_EQ(armor::reportFormatOfPath("a/api_diff_report_x.h.msgpack"), ReportFormat::MSGPACK);
+    EXPECT_EQ(armor::reportFormatOfPath("a/api_diff_report_x.h.json"), ReportFormat::JSON);
+    EXPECT_TRUE(armor::isReportFile("x.h.msgpack"));
+    EXPECT_FALSE(armor::isReportFile("x.h.html"));
+}
+
+TEST_F(ReportFormatTest, EveryFormatReadsBackTheSameDocument) {
+    nlohmann::json document{{"astDiff", {{{"qualifiedName", "ns::f"}, {"tag", "removed"}}}},
+                            {"parsed_status", 3},
+                            {"unparsed_status", 0}};
+    for (ReportFormat format : {ReportFormat::JSON, ReportFormat::CBOR, ReportFormat::MSGPACK}) {
+        std::string path = write(std::string("diff") + armor::reportExtension(format), document, format);
+        EXPECT_EQ(armor::readReportDocument(path), document) << path;
+    }
+
+    // The binary encodings are smaller than the indented JSON
+    EXPECT_LT(std::filesystem::file_size(dir / "diff.cbor"), std::filesystem::file_size(dir / "diff.json"));
+    EXPECT_LT(std::filesystem::file_size(dir / "diff.msgpack"), std::filesystem::file_size(dir / "diff.json"));
+}
+
+TEST_F(ReportFormatTest, MissingFileThrows) {
+    EXPECT_THROW(armor::readReportDocument((dir / "missing.cbor").string()), std::runtime_error);
+}
@@ -0,0 +1,110 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "diff_utils.hpp"
+#include "output_paths.hpp"
+#include "report_merge.hpp"
+#include "report_utils.hpp"
+
+class ReportMergeTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_report_merge_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    // Writes the JSON report of `header` into the run rooted at `run`
+    void writeReport(const std::string& run, const std::string& header, const char* compatibility,
+                     ParsedDiffStatus parsed, armor::ReportFormat format = armor::ReportFormat::JSON) {
+        armor::OutputPaths outputs{(dir / run).string()};
+        std::filesystem::create_directories(outputs.jsonReportDir());
+        ApiChangeGroups groups(header);
+        groups.addRecord(json{{"headerfile", header},
+                              {"name", "foo"},
+                              {"description", "changed"},
+                              {"changetype", "Compatibility_changed"},
+                              {"compatibility", compatibility}});
+        generate_json_report(groups, outputs.jsonReportFile(std::filesystem::path(header).filename().string(), format),
+                             static_cast<int>(parsed), static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                             compatibility, "STATUS", "reason");
+    }
+
+    json readSummary(const armor::OutputPaths& outputs) {
+        std::ifstream in(outputs.summaryJsonFile());
+        return json::parse(in);
+    }
+};
+
+TEST_F(ReportMergeTest, CombinesTheRowsOfEveryShard) {
+    writeReport("shard0", "include/a.h", "backward_compatible", ParsedDiffStatus::SUPPORTED_UPDATES);
+    writeReport("shard1", "include/b.h", "backward_incompatible", ParsedDiffStatus::SUPPORTED_UPDATES);
+
+    armor::MergedReports merged;
+    EXPECT_EQ(merged.addRun((dir / "shard0").string()), 1u);
+    EXPECT_EQ(merged.addRun((dir / "shard1").string()), 1u);
+    EXPECT_EQ(merged.addRun((dir / "missing").string()), 0u);
+    EXPECT_TRUE(merged.hasBackwardIncompatible());
+
+    armor::OutputPaths outputs{(dir / "merged").string()};
+    merged.write(outputs);
+    json summary = readSummary(outputs);
+    ASSERT_EQ(summary.at("api_diff").size(), 2u);
+    EXPECT_EQ(summary.at("api_diff")[0].at("headerfile"), "include/a.h");
+    EXPECT_EQ(summary.at("api_diff")[1].at("headerfile"), "include/b.h");
+    EXPECT_EQ(summary.at("compatibility"), "backward_incompatible");
+    EXPECT_TRUE(std::filesystem::exists(outputs.summaryHtmlFile()));
+}
+
+TEST_F(ReportMergeTest, KeepsTheWorstParsedStatus) {
+    writeReport("shard0", "include/a.h", "backward_compatible", ParsedDiffStatus::COMMENTS_UPDATED);
+    writeReport("shard1", "include/b.h", "backward_compatible", ParsedDiffStatus::UNSUPPORTED_UPDATES);
+
+    armor::MergedReports merged;
+    merged.addRun((dir / "shard0").string());
+    merged.addRun((dir / "shard1").string());
+    EXPECT_FALSE(merged.hasBackwardIncompatible());
+
+    armor::OutputPaths outputs{(dir / "merged").string()};
+    merged.write(outputs);
+    EXPECT_EQ(readSummary(outputs).at("parsed_status"), "UNSUPPORTED_UPDATES");
+}
+
+TEST_F(ReportMergeTest, ReadsBinaryReports) {
+    writeReport("shard0", "include/a.h", "backward_compatible", ParsedDiffStatus::SUPPORTED_UPDATES,
+                armor::ReportFormat::CBOR);
+    writeReport("shard1", "include/b.h", "backward_incompatible", ParsedDiffStatus::UNSUPPORTED_UPDATES,
+                armor::ReportFormat::MSGPACK);
+    armor::OutputPaths shard0{(dir / "shard0").string()};
+    EXPECT_TRUE(std::filesystem::exists(shard0.jsonReportFile("a.h", armor::ReportFormat::CBOR)));
+
+    armor::MergedReports merged;
+    EXPECT_EQ(merged.addRun((dir / "shard0").string()), 1u);
+    EXPECT_EQ(merged.addRun((dir / "shard1").string()), 1u);
+    EXPECT_TRUE(merged.hasBackwardIncompatible());
+
+    // The summary stays JSON
+    armor::OutputPaths outputs{(dir / "merged").string()};
+    merged.write(outputs);
+    json summary = readSummary(outputs);
+    ASSERT_EQ(summary.at("api_diff").size(), 2u);
+    EXPECT_EQ(summary.at("parsed_status"), "UNSUPPORTED_UPDATES");
+}
+
+TEST_F(ReportMergeTest, MalformedReportThrows) {
+    armor::OutputPaths outputs{(dir / "shard0").string()};
+    std::filesystem::create_directories(outputs.jsonReportDir());
+    std::ofstream(outputs.jsonReportFile("a.h")) << R"({"api_diff": []})";
+
+    armor::MergedReports merged;
+    EXPECT_THROW(merged.addRun(outputs.root), std::runtime_error);
+}
@@ -0,0 +1,107 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "comm_def.hpp"
+#include "diff_utils.hpp"
+#include "report_format.hpp"
+#include "report_generator.hpp"
+#include "report_utils.hpp"
+
+class ReportSummariesTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_report_summaries_test";
+        std::filesystem::create_directories(dir);
+        ReportSummaries::getInstance().clear();
+    }
+
+    void TearDown() override {
+        ReportSummaries::getInstance().clear();
+        std::filesystem::remove_all(dir);
+    }
+
+    json record(const std::string& name, const char* compatibility) {
+        return json{{"headerfile", "include/foo.h"},
+                    {"name", name},
+                    {"description", "changed"},
+                    {"changetype", "Compatibility_changed"},
+                    {"compatibility", compatibility}};
+    }
+};
+
+TEST_F(ReportSummariesTest, MissingHeaderIsNotFound) {
+    ReportSummaries::Summary summary;
+    EXPECT_FALSE(ReportSummaries::getInstance().find("include/foo.h", summary));
+}
+
+TEST_F(ReportSummariesTest, ReportGeneratorRecordsStatusAndNames) {
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(record("foo", "backward_incompatible"));
+    groups.addRecord(record("bar", "backward_compatible"));
+    report_generator(groups, static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                     static_cast<int>(UnParsedDiffStatus::UN_CHANGED), (dir / "foo.html").string(), "", BETA_PARSER);
+
+    ReportSummaries::Summary summary;
+    ASSERT_TRUE(ReportSummaries::getInstance().find("include/foo.h", summary));
+    EXPECT_EQ(summary.overallStatus, "BACKWARD_INCOMPATIBLE");
+    EXPECT_EQ(summary.apiNames, (std::vector<std::string>{"bar", "foo"}));
+}
+
+TEST_F(ReportSummariesTest, NoteIsAddedToTheReason) {
+    ApiChangeGroups groups("include/compat/foo.h");
+    groups.addRecord(record("foo", "backward_compatible"));
+    groups.setNote("Same contents as include/foo.h; compared once for all of them.");
+    std::string jsonPath = (dir / "foo.json").string();
+    report_generator(groups, static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                     static_cast<int>(UnParsedDiffStatus::UN_CHANGED), "", jsonPath, BETA_PARSER, true);
+
+    std::string reason = armor::readReportDocument(jsonPath)["reason"].get<std::string>();
+    EXPECT_NE(reason.find(" Same contents as include/foo.h; compared once for all of them."), std::string::npos);
+}
+
+TEST_F(ReportSummariesTest, ReportWithoutPathsIsOnlyRecorded) {
+    ApiChangeGroups groups("include/foo.h");
+    groups.addRecord(record("foo", "backward_compatible"));
+    report_generator(groups, static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                     static_cast<int>(UnParsedDiffStatus::UN_CHANGED), "", "", BETA_PARSER);
+
+    ReportSummaries::Summary summary;
+    ASSERT_TRUE(ReportSummaries::getInstance().take("include/foo.h", summary));
+    EXPECT_EQ(summary.apiNames, (std::vector<std::string>{"foo"}));
+    EXPECT_FALSE(ReportSummaries::getInstance().find("include/foo.h", summary));
+    EXPECT_TRUE(std::filesystem::is_empty(dir));
+}
+
+TEST_F(ReportSummariesTest, LaterReportReplacesEarlier) {
+    ReportSummaries::getInstance().record("include/foo.h", {"ALPHA", {"a"}});
+    ReportSummaries::getInstance().record("include/foo.h", {"BETA", {}});
+
+    ReportSummaries::Summary summary;
+    ASSERT_TRUE(ReportSummaries::getInstance().find("include/foo.h", summary));
+    EXPECT_EQ(summary.overallStatus, "BETA");
+    EXPECT_TRUE(summary.apiNames.empty());
+}
+
+TEST_F(ReportSummariesTest, SubmittedReportsAreRecordedOnceRenderingFinishes) {
+    start_report_rendering(2, 2);
+    for (int i = 0; i < 8; ++i) {
+        std::string header = "include/foo" + std::to_string(i) + ".h";
+        ApiChangeGroups groups(header);
+        groups.addRecord(ChangeRecord{header, "foo", "changed", true, i % 2 == 0});
+        submit_report(std::move(groups), static_cast<int>(ParsedDiffStatus::SUPPORTED_UPDATES),
+                      static_cast<int>(UnParsedDiffStatus::UN_CHANGED),
+                      (dir / ("foo" + std::to_string(i) + ".html")).string(), "", BETA_PARSER);
+    }
+    finish_report_rendering();
+
+    for (int i = 0; i < 8; ++i) {
+        ReportSummaries::Summary summary;
+        ASSERT_TRUE(ReportSummaries::getInstance().find("include/foo" + std::to_string(i) + ".h", summary));
+        EXPECT_EQ(summary.overallStatus, i % 2 == 0 ? "BACKWARD_INCOMPATIBLE" : "BACKWARD_COMPATIBLE");
+        EXPECT_TRUE(std::filesystem::exists(dir / ("foo" + std::to_string(i) + ".html")));
+    }
+}
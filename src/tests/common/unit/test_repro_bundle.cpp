@@ -0,0 +1,76 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "llvm/Support/MemoryBuffer.h"
+#include "repro_bundle.hpp"
+
+class ReproBundleTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::absolute(std::filesystem::temp_directory_path() / "armor_repro_bundle_test");
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir / "v1" / "include");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(ReproBundleTest, CapturedFilesReplayAtTheirOriginalPaths) {
+    std::string header = (dir / "v1" / "include" / "foo.h").string();
+    std::string probed = (dir / "v1" / "include" / "config.h").string();
+    std::ofstream(header) << "int foo();\n";
+    std::ofstream(probed) << "#define CONFIG 1\n";
+
+    armor::BundleCapture& capture = armor::BundleCapture::getInstance();
+    capture.start();
+    auto fileSystem = capture.wrap(llvm::vfs::getRealFileSystem());
+    ASSERT_TRUE(static_cast<bool>(fileSystem->getBufferForFile((dir / "v1" / "include" / ".." / "include" / "foo.h").string())));
+    ASSERT_TRUE(static_cast<bool>(fileSystem->status(probed)));
+    EXPECT_FALSE(static_cast<bool>(fileSystem->status((dir / "v1" / "missing.h").string())));
+    armor::ReproBundle::HeaderPair pair;
+    pair.header = "include/foo.h";
+    pair.older = {(dir / "v1").string(), header, {"-xc++-header", "-std=c++17"}};
+    pair.newer = pair.older;
+    capture.recordPair(pair);
+    capture.recordSeconds("include/foo.h", 0.5);
+    armor::ReproBundle bundle = capture.finish();
+    EXPECT_FALSE(capture.isCapturing());
+    ASSERT_EQ(bundle.files.size(), 2u);
+    EXPECT_EQ(bundle.files[0], probed);
+    EXPECT_EQ(bundle.files[1], header);
+    bundle.arguments = {"armor", "v1", "v2", "include/foo.h"};
+    std::string bundleDir = (dir / "bundle").string();
+    bundle.save(bundleDir);
+    std::filesystem::remove_all(dir / "v1");
+
+    armor::ReproBundle loaded = armor::ReproBundle::load(bundleDir);
+    EXPECT_EQ(loaded.arguments, bundle.arguments);
+    ASSERT_EQ(loaded.pairs.size(), 1u);
+    EXPECT_EQ(loaded.pairs[0].header, "include/foo.h");
+    EXPECT_EQ(loaded.pairs[0].seconds, 0.5);
+    EXPECT_EQ(loaded.pairs[0].older.flags, pair.older.flags);
+    EXPECT_EQ(loaded.files, bundle.files);
+
+    auto replayed = armor::ReproBundle::createFileSystem(bundleDir);
+    auto buffer = replayed->getBufferForFile(header);
+    ASSERT_TRUE(static_cast<bool>(buffer));
+    EXPECT_EQ((*buffer)->getBuffer(), "int foo();\n");
+    auto status = replayed->status(probed);
+    ASSERT_TRUE(static_cast<bool>(status));
+    EXPECT_EQ(status->getName(), probed);
+    EXPECT_TRUE(static_cast<bool>(replayed->status((dir / "v1" / "include").string())));
+    EXPECT_FALSE(static_cast<bool>(replayed->status((dir / "v1" / "missing.h").string())));
+}
+
+TEST_F(ReproBundleTest, MissingBundleThrows) {
+    EXPECT_THROW(armor::ReproBundle::load((dir / "missing").string()), std::runtime_error);
+    EXPECT_THROW(armor::ReproBundle::createFileSystem((dir / "missing").string()), std::runtime_error);
+}
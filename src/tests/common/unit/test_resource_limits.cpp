@@ -0,0 +1,58 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "resource_limits.hpp"
+
+TEST(ResourceLimitsTest, CpuQuotaRoundsUp) {
+    EXPECT_EQ(armor::detail::cpusFromCpuMax("200000 100000"), 2u);
+    EXPECT_EQ(armor::detail::cpusFromCpuMax("150000 100000"), 2u);
+    EXPECT_EQ(armor::detail::cpusFromCpuMax("50000 100000"), 1u);
+    EXPECT_EQ(armor::detail::cpusFromCpuMax("max 100000"), 0u);
+    EXPECT_EQ(armor::detail::cpusFromCpuMax("garbage"), 0u);
+    EXPECT_EQ(armor::detail::cpusFromCfsQuota(-1, 100000), 0u);
+    EXPECT_EQ(armor::detail::cpusFromCfsQuota(400000, 100000), 4u);
+}
+
+TEST(ResourceLimitsTest, MemoryLimitParses) {
+    EXPECT_EQ(armor::detail::bytesFromMemoryLimit("max"), 0u);
+    EXPECT_EQ(armor::detail::bytesFromMemoryLimit("1073741824"), std::size_t(1) << 30);
+    EXPECT_EQ(armor::detail::bytesFromMemoryLimit(""), 0u);
+}
+
+TEST(ResourceLimitsTest, AvailableCpusNeverExceedsTheHost) {
+    unsigned cpus = armor::availableCpus();
+    EXPECT_GE(cpus, 1u);
+    if (std::thread::hardware_concurrency() != 0) {
+        EXPECT_LE(cpus, std::thread::hardware_concurrency());
+    }
+}
+
+TEST(ResourceLimitsTest, GateHoldsBackSecondUnitAboveHighWater) {
+    std::atomic<std::size_t> resident{950};
+    armor::MemoryGate gate(1000, [&]() { return resident.load(); });
+
+    // Alone, a unit always goes ahead
+    gate.enter();
+    std::atomic<bool> entered{false};
+    std::thread second([&]() {
+        armor::MemoryGate::Entry entry(gate);
+        entered = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(entered.load());
+
+    // Room frees up once the first leaves
+    gate.leave();
+    second.join();
+    EXPECT_TRUE(entered.load());
+    EXPECT_EQ(gate.getThrottled(), 1u);
+}
+
+TEST(ResourceLimitsTest, GateWithoutLimitNeverWaits) {
+    armor::MemoryGate gate(0, []() { return std::size_t(-1); });
+    armor::MemoryGate::Entry first(gate);
+    armor::MemoryGate::Entry second(gate);
+    EXPECT_EQ(gate.getThrottled(), 0u);
+}
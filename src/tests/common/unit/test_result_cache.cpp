@@ -0,0 +1,79 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "comm_def.hpp"
+#include "report_utils.hpp"
+#include "result_cache.hpp"
+
+class ResultCacheTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_result_cache_test";
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static armor::HistoryEntry entry(const std::string& head) {
+        armor::HistoryEntry e;
+        e.header = "include/foo.h";
+        e.base = "v1";
+        e.head = head;
+        e.overallStatus = "BACKWARD_INCOMPATIBLE";
+        e.parsedStatus = 1;
+        e.unparsedStatus = 2;
+        e.parser = BETA_PARSER;
+        e.records.push_back({"include/foo.h", "foo:Function", "removed", true, true});
+        return e;
+    }
+};
+
+TEST_F(ResultCacheTest, StoredEntryLoadsBackUnderItsKey) {
+    armor::ResultCache cache(dir.string());
+    armor::HistoryEntry loaded;
+    EXPECT_FALSE(cache.load("A1", loaded));
+
+    cache.store("A1", entry("v2"));
+    ASSERT_TRUE(cache.load("A1", loaded));
+    EXPECT_EQ(loaded.digest, "A1");
+    EXPECT_EQ(loaded.head, "v2");
+    EXPECT_EQ(loaded.parser, BETA_PARSER);
+    ASSERT_EQ(loaded.records.size(), 1u);
+    EXPECT_EQ(loaded.records[0].headerfile, "include/foo.h");
+    EXPECT_TRUE(loaded.records[0].backwardIncompatible);
+    EXPECT_FALSE(cache.load("B2", loaded));
+
+    // A later store of the same key replaces the entry
+    cache.store("A1", entry("v3"));
+    ASSERT_TRUE(cache.load("A1", loaded));
+    EXPECT_EQ(loaded.head, "v3");
+}
+
+TEST_F(ResultCacheTest, UnreadableOrMisplacedEntriesMiss) {
+    armor::ResultCache cache(dir.string());
+    cache.store("A1", entry("v2"));
+    std::filesystem::copy_file(dir / "results" / "A1.json", dir / "results" / "B2.json");
+    std::ofstream(dir / "results" / "C3.json") << "{\"header\": ";
+
+    armor::HistoryEntry loaded;
+    loaded.head = "untouched";
+    EXPECT_FALSE(cache.load("B2", loaded));
+    EXPECT_FALSE(cache.load("C3", loaded));
+    EXPECT_EQ(loaded.head, "untouched");
+    // A corrupted entry fails its checksum and is removed
+    EXPECT_FALSE(std::filesystem::exists(dir / "results" / "C3.json"));
+    {
+        std::fstream file(dir / "results" / "A1.json", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(2);
+        file.put('#');
+    }
+    EXPECT_FALSE(cache.load("A1", loaded));
+    EXPECT_FALSE(std::filesystem::exists(dir / "results" / "A1.json"));
+}
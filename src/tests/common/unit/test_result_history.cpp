@@ -0,0 +1,95 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "comm_def.hpp"
+#include "report_utils.hpp"
+#include "result_history.hpp"
+
+class ResultHistoryTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "armor_result_history_test";
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static armor::HistoryEntry entry(const std::string& header, const std::string& digest, const std::string& head) {
+        armor::HistoryEntry e;
+        e.header = header;
+        e.digest = digest;
+        e.base = "v1";
+        e.head = head;
+        e.time = 1760000000;
+        e.seconds = 1.5;
+        e.overallStatus = "BACKWARD_INCOMPATIBLE";
+        e.parsedStatus = 1;
+        e.unparsedStatus = 2;
+        e.parser = BETA_PARSER;
+        e.records.push_back({header, "foo:Function", "first\nsecond", true, true});
+        e.records.push_back({header, "bar:Function", "", false, false});
+        return e;
+    }
+};
+
+TEST_F(ResultHistoryTest, MissingHistoryIsEmpty) {
+    armor::ResultHistory history = armor::ResultHistory::load((dir / "missing.jsonl").string());
+    EXPECT_TRUE(history.getEntries().empty());
+    EXPECT_EQ(history.find("include/foo.h", "1"), nullptr);
+}
+
+TEST_F(ResultHistoryTest, AppendedEntriesLoadBack) {
+    std::string path = (dir / "nested" / "history.jsonl").string();
+    armor::ResultHistory::append(path, {entry("include/foo.h", "1", "v2")});
+    armor::ResultHistory::append(path, {entry("include/bar.h", "2", "v2"), entry("include/foo.h", "1", "v3")});
+
+    armor::ResultHistory history = armor::ResultHistory::load(path);
+    ASSERT_EQ(history.getEntries().size(), 3u);
+    EXPECT_EQ(history.getSkippedLines(), 0u);
+
+    // The latest entry of equal inputs wins
+    const armor::HistoryEntry* found = history.find("include/foo.h", "1");
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->head, "v3");
+    EXPECT_EQ(found->base, "v1");
+    EXPECT_EQ(found->time, 1760000000);
+    EXPECT_DOUBLE_EQ(found->seconds, 1.5);
+    EXPECT_EQ(found->overallStatus, "BACKWARD_INCOMPATIBLE");
+    EXPECT_EQ(found->parsedStatus, 1);
+    EXPECT_EQ(found->unparsedStatus, 2);
+    EXPECT_EQ(found->parser, BETA_PARSER);
+    ASSERT_EQ(found->records.size(), 2u);
+    EXPECT_EQ(found->records[0].headerfile, "include/foo.h");
+    EXPECT_EQ(found->records[0].name, "foo:Function");
+    EXPECT_EQ(found->records[0].description, "first\nsecond");
+    EXPECT_TRUE(found->records[0].compatibilityChanged);
+    EXPECT_TRUE(found->records[0].backwardIncompatible);
+    EXPECT_FALSE(found->records[1].compatibilityChanged);
+    EXPECT_FALSE(found->records[1].backwardIncompatible);
+
+    EXPECT_EQ(history.find("include/foo.h", "2"), nullptr);
+    EXPECT_NE(history.find("include/bar.h", "2"), nullptr);
+}
+
+TEST_F(ResultHistoryTest, UnreadableLinesAreSkipped) {
+    std::string path = (dir / "history.jsonl").string();
+    armor::ResultHistory::append(path, {entry("include/foo.h", "1", "v2")});
+    // An append cut short, without its newline
+    std::ofstream(path, std::ios::app) << R"({"format": 1, "header": "include/ba)";
+    armor::ResultHistory::append(path, {entry("include/bar.h", "2", "v2")});
+    std::ofstream(path, std::ios::app) << R"({"format": 2})" << "\n";
+
+    armor::ResultHistory history = armor::ResultHistory::load(path);
+    EXPECT_EQ(history.getEntries().size(), 2u);
+    EXPECT_EQ(history.getSkippedLines(), 2u);
+    EXPECT_NE(history.find("include/foo.h", "1"), nullptr);
+    EXPECT_NE(history.find("include/bar.h", "2"), nullptr);
+}
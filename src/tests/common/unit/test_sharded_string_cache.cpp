@@ -0,0 +1,57 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sharded_string_cache.hpp"
+
+TEST(ShardedStringCacheTest, FindsWhatWasInsertedPerTable) {
+    armor::ShardedStringCache cache;
+    int node = 0;
+    EXPECT_FALSE(cache.find(&node, 0));
+
+    std::string usr = "c:@F@f";
+    llvm::StringRef stored = cache.insert(&node, 0, usr);
+    usr.assign("overwritten");
+    EXPECT_EQ(stored, "c:@F@f");
+    ASSERT_TRUE(cache.find(&node, 0));
+    EXPECT_EQ(*cache.find(&node, 0), "c:@F@f");
+    EXPECT_FALSE(cache.find(&node, 1));
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(ShardedStringCacheTest, KeepsTheFirstInsertedString) {
+    armor::ShardedStringCache cache;
+    int node = 0;
+    cache.insert(&node, 2, "int");
+    EXPECT_EQ(cache.insert(&node, 2, "signed int"), "int");
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(ShardedStringCacheTest, ConcurrentWritersAgreeOnEveryString) {
+    armor::ShardedStringCache cache;
+    std::vector<int> nodes(512);
+    constexpr int THREADS = 8;
+    std::vector<std::vector<llvm::StringRef>> seen(THREADS, std::vector<llvm::StringRef>(nodes.size()));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                std::optional<llvm::StringRef> found = cache.find(&nodes[i], 0);
+                seen[t][i] = found ? *found : cache.insert(&nodes[i], 0, std::to_string(i));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(cache.size(), nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(seen[0][i], std::to_string(i));
+        for (int t = 1; t < THREADS; ++t) {
+            // The very same storage, not just an equal string
+            EXPECT_EQ(seen[t][i].data(), seen[0][i].data());
+        }
+    }
+}
@@ -0,0 +1,44 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include "simd_dispatch.hpp"
+
+TEST(SimdDispatchTest, PicksTheBestKernelOfThisCpu) {
+    armor::simd::Kernel kernel = armor::simd::activeKernel();
+    EXPECT_EQ(kernel, armor::simd::activeKernel());
+#if defined(ARMOR_SIMD_X86)
+    __builtin_cpu_init();
+    EXPECT_EQ(kernel == armor::simd::Kernel::AVX2, __builtin_cpu_supports("avx2") != 0);
+#elif defined(__ARM_NEON)
+    EXPECT_EQ(kernel, armor::simd::Kernel::NEON);
+#endif
+    EXPECT_FALSE(std::string(armor::simd::kernelName(kernel)).empty());
+}
+
+TEST(SimdDispatchTest, KernelNames) {
+    EXPECT_STREQ(armor::simd::kernelName(armor::simd::Kernel::SCALAR), "scalar");
+    EXPECT_STREQ(armor::simd::kernelName(armor::simd::Kernel::SSE2), "sse2");
+    EXPECT_STREQ(armor::simd::kernelName(armor::simd::Kernel::AVX2), "avx2");
+    EXPECT_STREQ(armor::simd::kernelName(armor::simd::Kernel::NEON), "neon");
+}
+
+TEST(SimdDispatchTest, SetKernelOverridesOnlySupportedKernels) {
+    using armor::simd::Kernel;
+    Kernel detected = armor::simd::detectedKernel();
+    EXPECT_TRUE(armor::simd::supportsKernel(Kernel::SCALAR));
+    EXPECT_TRUE(armor::simd::supportsKernel(detected));
+
+    EXPECT_TRUE(armor::simd::setKernel(Kernel::SCALAR));
+    EXPECT_EQ(armor::simd::activeKernel(), Kernel::SCALAR);
+    EXPECT_EQ(armor::simd::detectedKernel(), detected);
+#if defined(ARMOR_SIMD_X86)
+    EXPECT_FALSE(armor::simd::setKernel(Kernel::NEON));
+#else
+    EXPECT_FALSE(armor::simd::setKernel(Kernel::AVX2));
+#endif
+    EXPECT_EQ(armor::simd::activeKernel(), Kernel::SCALAR);
+
+    EXPECT_TRUE(armor::simd::setKernel(detected));
+    EXPECT_EQ(armor::simd::activeKernel(), detected);
+}
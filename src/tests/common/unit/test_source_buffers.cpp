@@ -0,0 +1,66 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "source_buffers.hpp"
+
+class SourceBuffersTest : public ::testing::Test {
+protected:
+    std::filesystem::path root;
+
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "armor_source_buffers_test";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "include");
+        std::ofstream(root / "include" / "api.h") << "int api();\n";
+        std::ofstream(root / "include" / "other.h") << "int other();\n";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    // `path` as read through the buffers layered over the real file system
+    static std::string read(const armor::SourceBuffers& buffers, const std::string& path) {
+        auto overlay = llvm::makeIntrusiveRefCnt<llvm::vfs::OverlayFileSystem>(llvm::vfs::getRealFileSystem());
+        overlay->pushOverlay(buffers.createFileSystem());
+        auto buffer = overlay->getBufferForFile(path);
+        return buffer ? (*buffer)->getBuffer().str() : "<missing>";
+    }
+};
+
+TEST_F(SourceBuffersTest, BuffersShadowAndAddFiles) {
+    armor::SourceBuffers buffers(root.string());
+    buffers.add("include/api.h", "int api(int);\n");
+    buffers.add((root / "include" / "new.h").string(), "int added();\n");
+
+    EXPECT_EQ(read(buffers, (root / "include" / "api.h").string()), "int api(int);\n");
+    EXPECT_EQ(read(buffers, (root / "include" / "new.h").string()), "int added();\n");
+    // Files without a buffer are read from disk
+    EXPECT_EQ(read(buffers, (root / "include" / "other.h").string()), "int other();\n");
+}
+
+TEST_F(SourceBuffersTest, PathsAreResolvedAgainstTheRoot) {
+    armor::SourceBuffers buffers(root.string() + "/");
+    buffers.add("include/../include/api.h", "int api(int);\n");
+    ASSERT_NE(buffers.find((root / "include" / "api.h").string()), nullptr);
+    EXPECT_EQ(*buffers.find("include/api.h"), "int api(int);\n");
+    EXPECT_EQ(buffers.find("include/other.h"), nullptr);
+
+    EXPECT_TRUE(buffers.covers((root / "include" / "other.h").string()));
+    EXPECT_FALSE(buffers.covers(root.string() + "_sibling/api.h"));
+    EXPECT_FALSE(buffers.covers(root.string()));
+}
+
+TEST_F(SourceBuffersTest, PathsOutsideTheRootAreRejected) {
+    armor::SourceBuffers buffers(root.string());
+    EXPECT_THROW(buffers.add("../elsewhere.h", ""), std::invalid_argument);
+    EXPECT_THROW(buffers.add("/tmp/elsewhere.h", ""), std::invalid_argument);
+    EXPECT_TRUE(buffers.empty());
+}
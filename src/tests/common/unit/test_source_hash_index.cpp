@@ -0,0 +1,68 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include "source_hash_index.hpp"
+
+using Normalization = SourceHashIndex::Normalization;
+
+class SourceHashIndexTest : public ::testing::Test {
+protected:
+    static uint64_t whole(const std::string& text, Normalization normalization) {
+        SourceHashIndex index(text);
+        return index.hash(0, static_cast<unsigned>(text.size()), normalization);
+    }
+
+    static unsigned offsetOf(const std::string& text, const char* needle) {
+        return static_cast<unsigned>(text.find(needle));
+    }
+};
+
+TEST_F(SourceHashIndexTest, RangeHashIgnoresPositionAndWhitespace) {
+    std::string source = "int first;\n  int   value = 1;\nint value=1;\n";
+    SourceHashIndex index(source);
+
+    unsigned spaced = offsetOf(source, "int   value");
+    unsigned compact = offsetOf(source, "int value=1");
+    uint64_t spacedHash = index.hash(spaced, offsetOf(source, "\nint value=1"), Normalization::Source);
+    uint64_t compactHash = index.hash(compact, static_cast<unsigned>(source.size()), Normalization::Source);
+
+    EXPECT_EQ(spacedHash, compactHash);
+    EXPECT_NE(spacedHash, index.hash(0, offsetOf(source, "\n"), Normalization::Source));
+    EXPECT_EQ(index.hash(spaced, spaced, Normalization::Source), 0u);
+    EXPECT_EQ(index.hash(0, static_cast<unsigned>(source.size()) + 1, Normalization::Source), 0u);
+}
+
+TEST_F(SourceHashIndexTest, SourceNormalizationDropsComments) {
+    std::string source = "int /* counts */ value; // trailing\n"
+                         "const char* s = \"a /* b */\";";
+    SourceHashIndex index(source);
+
+    unsigned literal = offsetOf(source, "const char*");
+    EXPECT_EQ(index.hash(0, literal, Normalization::Source), whole("int value;", Normalization::Source));
+    EXPECT_EQ(index.hash(literal, static_cast<unsigned>(source.size()), Normalization::Source),
+              whole("const char*s=\"a /* b */\";", Normalization::Source));
+    EXPECT_NE(index.hash(0, literal, Normalization::Whitespace), whole("int value;", Normalization::Whitespace));
+}
+
+TEST_F(SourceHashIndexTest, WhitespaceNormalizationKeepsComments) {
+    std::string source = "#if 0\n  int  legacy; // old\n#endif\n";
+    SourceHashIndex index(source);
+
+    unsigned begin = offsetOf(source, "int");
+    unsigned end = offsetOf(source, "\n#endif");
+    EXPECT_EQ(index.hash(begin, end, Normalization::Whitespace), whole("intlegacy;//old", Normalization::Whitespace));
+    EXPECT_NE(index.hash(begin, end, Normalization::Whitespace), index.hash(begin, end, Normalization::Source));
+}
+
+TEST_F(SourceHashIndexTest, EqualTextHashesEquallyAcrossBuffers) {
+    std::string oldHeader = "struct A { int x; };\nvoid f(int);\n";
+    std::string newHeader = "// moved\nvoid f(int);\n\nstruct A {\n    int x;\n};\n";
+    SourceHashIndex oldIndex(oldHeader);
+    SourceHashIndex newIndex(newHeader);
+
+    EXPECT_EQ(oldIndex.hash(0, offsetOf(oldHeader, "\nvoid"), Normalization::Source),
+              newIndex.hash(offsetOf(newHeader, "struct"), static_cast<unsigned>(newHeader.size()), Normalization::Source));
+    EXPECT_EQ(oldIndex.hash(offsetOf(oldHeader, "void"), static_cast<unsigned>(oldHeader.size()), Normalization::Source),
+              newIndex.hash(offsetOf(newHeader, "void"), offsetOf(newHeader, "\n\nstruct"), Normalization::Source));
+}
@@ -0,0 +1,103 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "profiler.hpp"
+#include "stack_sampler.hpp"
+
+using namespace armor::profile;
+
+namespace {
+
+    // Uses CPU time, which the sampling timer counts, for about `millis`
+    uint64_t spin(int millis) {
+        volatile uint64_t sum = 0;
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(millis);
+        while (std::chrono::steady_clock::now() < until) {
+            for (int i = 0; i < 10000; ++i) {
+                sum = sum + i;
+            }
+        }
+        return sum;
+    }
+
+}
+
+class StackSamplerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Profiler::getInstance().reset();
+        Profiler::getInstance().setEnabled(true);
+    }
+
+    void TearDown() override {
+        StackSampler::getInstance().reset();
+        Profiler::getInstance().setEnabled(false);
+        Profiler::getInstance().reset();
+    }
+};
+
+TEST_F(StackSamplerTest, FoldsStacksTaggedWithHeaderAndPhase) {
+    StackSampler& sampler = StackSampler::getInstance();
+    ASSERT_TRUE(sampler.start(1000)) << sampler.getError();
+    EXPECT_FALSE(sampler.start(1000));
+    {
+        HeaderScope scope("include/busy.h");
+        PhaseTimer timer(Phase::DIFF_TREES);
+        spin(300);
+    }
+    sampler.stop();
+    EXPECT_FALSE(sampler.isRunning());
+    ASSERT_GT(sampler.getSampleCount(), 0u);
+    EXPECT_EQ(sampler.getDroppedCount(), 0u);
+
+    std::vector<std::string> lines = sampler.foldedStacks();
+    uint64_t tagged = 0;
+    for (const std::string& line : lines) {
+        size_t space = line.rfind(' ');
+        ASSERT_NE(space, std::string::npos) << line;
+        uint64_t count = std::stoull(line.substr(space + 1));
+        EXPECT_GT(count, 0u);
+        if (line.rfind("busy.h;diff_trees;", 0) == 0) {
+            tagged += count;
+        }
+    }
+    EXPECT_GT(tagged, 0u);
+
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "armor_stack_sampler_test.folded";
+    ASSERT_TRUE(sampler.writeFolded(file.string()));
+    std::ifstream in(file);
+    std::string line;
+    size_t read = 0;
+    while (std::getline(in, line)) {
+        ++read;
+    }
+    EXPECT_EQ(read, lines.size());
+    std::filesystem::remove(file);
+}
+
+TEST_F(StackSamplerTest, CountsSamplesBeyondCapacityAsDropped) {
+    StackSampler& sampler = StackSampler::getInstance();
+    ASSERT_TRUE(sampler.start(1000, 2)) << sampler.getError();
+    spin(300);
+    sampler.stop();
+    EXPECT_EQ(sampler.getSampleCount(), 2u);
+    EXPECT_GT(sampler.getDroppedCount(), 0u);
+
+    // Phase timers restore the phase of the one they are nested in
+    HeaderScope scope("include/nested.h");
+    {
+        PhaseTimer outer(Phase::HANDLE_TRANSLATION_UNIT);
+        {
+            PhaseTimer inner(Phase::TREE_BUILD);
+            EXPECT_EQ(detail::currentPhase, Phase::TREE_BUILD);
+        }
+        EXPECT_EQ(detail::currentPhase, Phase::HANDLE_TRANSLATION_UNIT);
+    }
+    EXPECT_EQ(detail::currentPhase, Phase::COUNT);
+}
@@ -0,0 +1,50 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "comm_def.hpp"
+#include "report_utils.hpp"
+#include "subtree_summary.hpp"
+
+TEST(SubtreeSummaryTest, CountsKindsAndListsTheFirstNames) {
+    SubtreeSummary summary;
+    for (size_t i = 0; i < SUMMARY_LISTED_NAMES + 2; ++i) {
+        summary.count(NodeKind::Function);
+        summary.count(NodeKind::Parameter);
+        summary.name("ns::f" + std::to_string(i));
+    }
+    summary.count(NodeKind::Variable);
+    EXPECT_EQ(summary.size(), 2 * (SUMMARY_LISTED_NAMES + 2) + 1);
+
+    json out = summary.toJson();
+    EXPECT_EQ(out["descendants"], summary.size());
+    EXPECT_EQ(out["kinds"]["Function"], SUMMARY_LISTED_NAMES + 2);
+    EXPECT_EQ(out["kinds"]["Parameter"], SUMMARY_LISTED_NAMES + 2);
+    EXPECT_EQ(out["kinds"]["Variable"], 1);
+    ASSERT_EQ(out["names"].size(), SUMMARY_LISTED_NAMES);
+    EXPECT_EQ(out["names"][0], "ns::f0");
+}
+
+TEST(SubtreeSummaryTest, SummarizedSubtreeIsOneReportLine) {
+    SubtreeSummary summary;
+    summary.count(NodeKind::Function);
+    summary.count(NodeKind::Parameter);
+    summary.name("ns::open");
+    json added{{"nodeType", "Namespace"}, {"tag", "added"}, {"qualifiedName", "ns"}, {"summary", summary.toJson()}};
+    json removed = added;
+    removed["tag"] = "removed";
+    json modified{{"nodeType", "Class"}, {"tag", "modified"}, {"qualifiedName", "C"},
+                  {"children", json::array({removed})}};
+
+    std::vector<ChangeRecord> records = preprocess_api_changes(json::array({added, modified}), "include/foo.h");
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].description, "Namespace added: 'ns'\n"
+                                      "Namespace 'ns' summarized: 2 declarations (1 Function, 1 Parameter), "
+                                      "starting with 'ns::open'");
+    EXPECT_FALSE(records[0].backwardIncompatible);
+    EXPECT_EQ(records[1].description, "Namespace removed: 'ns'\n"
+                                      "Namespace 'ns' summarized: 2 declarations (1 Function, 1 Parameter), "
+                                      "starting with 'ns::open'");
+    EXPECT_TRUE(records[1].backwardIncompatible);
+}
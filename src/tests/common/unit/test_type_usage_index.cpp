@@ -0,0 +1,37 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include "type_usage_index.hpp"
+
+TEST(TypeUsageIndexTest, CountsEachNameOncePerDeclaration) {
+    TypeUsageIndex index;
+    index.addUser("const struct foo *");
+    index.addUser("foo");
+    index.addUser("std::pair<foo, foo>");
+    index.addUser("int");
+
+    EXPECT_EQ(index.users("foo"), 3u);
+    EXPECT_EQ(index.users("struct"), 1u);
+    EXPECT_EQ(index.users("std::pair"), 1u);
+    EXPECT_EQ(index.users("int"), 1u);
+    EXPECT_EQ(index.users("pair"), 0u);
+    EXPECT_EQ(index.users("*"), 0u);
+}
+
+TEST(TypeUsageIndexTest, ReplacedNameIsTheOneNameThatChanged) {
+    llvm::StringRef oldName;
+    llvm::StringRef newName;
+    ASSERT_TRUE(TypeUsageIndex::replacedName("const struct foo_v1 *", "const struct foo_v2 *", oldName, newName));
+    EXPECT_EQ(oldName, "foo_v1");
+    EXPECT_EQ(newName, "foo_v2");
+
+    ASSERT_TRUE(TypeUsageIndex::replacedName("ns::handle", "handle_t", oldName, newName));
+    EXPECT_EQ(oldName, "ns::handle");
+    EXPECT_EQ(newName, "handle_t");
+
+    // More than one token changed, or not a name
+    EXPECT_FALSE(TypeUsageIndex::replacedName("int", "long long", oldName, newName));
+    EXPECT_FALSE(TypeUsageIndex::replacedName("foo *", "foo &", oldName, newName));
+    EXPECT_FALSE(TypeUsageIndex::replacedName("foo", "const bar", oldName, newName));
+    EXPECT_FALSE(TypeUsageIndex::replacedName("foo", "foo", oldName, newName));
+}
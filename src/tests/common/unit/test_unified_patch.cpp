@@ -0,0 +1,77 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "unified_patch.hpp"
+
+TEST(UnifiedPatchTest, ReadsTheFilesAndHunksOfAGitDiff) {
+    std::vector<armor::FilePatch> patches = armor::parseUnifiedDiff(
+        "diff --git a/include/api.h b/include/api.h\n"
+        "index 1111111..2222222 100644\n"
+        "--- a/include/api.h\n"
+        "+++ b/include/api.h\n"
+        "@@ -1,3 +1,3 @@ struct api\n"
+        " struct api {\n"
+        "-    int size;\n"
+        "+    long size;\n"
+        " };\n"
+        "diff --git a/include/new.h b/include/new.h\n"
+        "new file mode 100644\n"
+        "--- /dev/null\n"
+        "+++ b/include/new.h\n"
+        "@@ -0,0 +1 @@\n"
+        "+int added();\n"
+        "--- a/include/old.h\t2024-01-01 00:00:00\n"
+        "+++ /dev/null\n"
+        "@@ -1 +0,0 @@\n"
+        "-int gone();\n");
+    ASSERT_EQ(patches.size(), 3u);
+    EXPECT_EQ(patches[0].path(), "include/api.h");
+    ASSERT_EQ(patches[0].hunks.size(), 1u);
+    EXPECT_EQ(patches[0].hunks[0].oldStart, 1u);
+    EXPECT_EQ(patches[0].hunks[0].newCount, 3u);
+    EXPECT_EQ(patches[0].hunks[0].lines.size(), 4u);
+    EXPECT_TRUE(patches[1].createsFile());
+    EXPECT_EQ(patches[1].path(), "include/new.h");
+    EXPECT_TRUE(patches[2].deletesFile());
+    EXPECT_EQ(patches[2].path(), "include/old.h");
+
+    EXPECT_THROW(armor::parseUnifiedDiff("@@ -1 +1 @@\n-a\n+b\n"), std::runtime_error);
+    EXPECT_THROW(armor::parseUnifiedDiff("--- a/x.h\n+++ b/x.h\n@@ -1,2 +1,2 @@\n-a\n+b\n"), std::runtime_error);
+    EXPECT_THROW(armor::parseUnifiedDiff("--- a/x.h\n+++ b/x.h\n@@ -x +1 @@\n"), std::runtime_error);
+}
+
+TEST(UnifiedPatchTest, AppliesHunksAtAnOffset) {
+    armor::FilePatch patch = armor::parseUnifiedDiff(
+        "--- a/x.h\n+++ b/x.h\n"
+        "@@ -2,3 +2,3 @@\n"
+        " int a();\n"
+        "-int b();\n"
+        "+int b(int);\n"
+        " int c();\n"
+        "@@ -8,2 +8,3 @@\n"
+        " int g();\n"
+        "+int h();\n"
+        "\n")[0];
+    // Two lines were added above both hunks since the patch was made
+    std::string original = "// one\n// two\n#pragma once\nint a();\nint b();\nint c();\nint d();\nint e();\nint f();\n"
+                           "int g();\n\n";
+    EXPECT_EQ(armor::applyFilePatch(original, patch),
+              "// one\n// two\n#pragma once\nint a();\nint b(int);\nint c();\nint d();\nint e();\nint f();\n"
+              "int g();\nint h();\n\n");
+
+    EXPECT_THROW(armor::applyFilePatch("int a();\nint x();\nint c();\n", patch), std::runtime_error);
+}
+
+TEST(UnifiedPatchTest, CreatesFilesAndKeepsAMissingFinalNewline) {
+    std::vector<armor::FilePatch> patches = armor::parseUnifiedDiff(
+        "--- /dev/null\n+++ b/n.h\n@@ -0,0 +1,2 @@\n+int n();\n+int m();\n"
+        "--- a/e.h\n+++ b/e.h\n@@ -1 +1,2 @@\n int e();\n+int f();\n\\ No newline at end of file\n");
+    ASSERT_EQ(patches.size(), 2u);
+    EXPECT_EQ(armor::applyFilePatch("", patches[0]), "int n();\nint m();\n");
+    EXPECT_TRUE(patches[1].hunks[0].newMissingNewline);
+    EXPECT_FALSE(patches[1].hunks[0].oldMissingNewline);
+    EXPECT_EQ(armor::applyFilePatch("int e();\n", patches[1]), "int e();\nint f();");
+}
@@ -0,0 +1,120 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "work_pool.hpp"
+
+class WorkPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(WorkPoolTest, ResolveJobCount_ZeroUsesHardware) {
+    EXPECT_GE(armor::resolveJobCount(0), 1u);
+    EXPECT_EQ(armor::resolveJobCount(3), 3u);
+}
+
+TEST_F(WorkPoolTest, Serial_RunsInOrder) {
+    std::vector<std::size_t> order;
+    armor::parallelFor(5, 1, [&](std::size_t i) { order.push_back(i); });
+    EXPECT_EQ(order, (std::vector<std::size_t>{0, 1, 2, 3, 4}));
+}
+
+TEST_F(WorkPoolTest, Serial_RethrowsAfterFinishingRemainingItems) {
+    std::vector<std::size_t> done;
+    EXPECT_THROW(
+        armor::parallelFor(5, 1, [&](std::size_t i) {
+            if (i == 0) {
+                throw std::runtime_error("boom");
+            }
+            done.push_back(i);
+        }),
+        std::runtime_error);
+    EXPECT_EQ(done, (std::vector<std::size_t>{1, 2, 3, 4}));
+}
+
+TEST_F(WorkPoolTest, Parallel_VisitsEveryItemOnce) {
+    std::vector<std::atomic<int>> hits(1000);
+    armor::parallelFor(hits.size(), 8, [&](std::size_t i) { hits[i].fetch_add(1); });
+    for (const auto& h : hits) {
+        EXPECT_EQ(h.load(), 1);
+    }
+}
+
+TEST_F(WorkPoolTest, Parallel_RethrowsAfterFinishingRemainingItems) {
+    std::atomic<int> done{0};
+    EXPECT_THROW(
+        armor::parallelFor(64, 4, [&](std::size_t i) {
+            if (i == 3) {
+                throw std::runtime_error("boom");
+            }
+            done.fetch_add(1);
+        }),
+        std::runtime_error);
+    EXPECT_EQ(done.load(), 63);
+}
+
+TEST_F(WorkPoolTest, EmptyRange_DoesNothing) {
+    bool called = false;
+    armor::parallelFor(0, 4, [&](std::size_t) { called = true; });
+    EXPECT_FALSE(called);
+}
+
+TEST_F(WorkPoolTest, Queue_RunsEveryJobBeforeJoining) {
+    std::atomic<int> done{0};
+    {
+        armor::WorkQueue queue(3, 2);
+        for (int i = 0; i < 100; ++i) {
+            queue.submit([&done, i] {
+                if (i == 7) {
+                    throw std::runtime_error("boom");
+                }
+                done.fetch_add(1);
+            });
+        }
+    }
+    EXPECT_EQ(done.load(), 99);
+}
+
+TEST_F(WorkPoolTest, Queue_FinishCountsFailedJobs) {
+    std::atomic<int> done{0};
+    armor::WorkQueue queue(2, 4);
+    for (int i = 0; i < 20; ++i) {
+        queue.submit([&done, i] {
+            if (i % 5 == 0) {
+                throw std::runtime_error("boom");
+            }
+            done.fetch_add(1);
+        });
+    }
+    EXPECT_EQ(queue.finish(), 4u);
+    EXPECT_EQ(done.load(), 16);
+}
+
+TEST_F(WorkPoolTest, Queue_SubmitWaitsForAFreeSlot) {
+    std::mutex gate;
+    std::unique_lock<std::mutex> closed(gate);
+    std::atomic<int> submitted{0};
+    armor::WorkQueue queue(1, 1);
+    std::thread producer([&] {
+        for (int i = 0; i < 3; ++i) {
+            queue.submit([&gate] { std::scoped_lock<std::mutex> wait(gate); });
+            submitted.fetch_add(1);
+        }
+    });
+    // One job runs and blocks on the gate, one waits in the queue, the third cannot be queued
+    while (submitted.load() < 2) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(submitted.load(), 2);
+    closed.unlock();
+    producer.join();
+    EXPECT_EQ(submitted.load(), 3);
+}
@@ -0,0 +1,208 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "alpha/include/diffengine.hpp"
+#include "alpha/include/header_processor.hpp"
+#include "beta/include/diffengine.hpp"
+#include "beta/include/header_processor.hpp"
+#include "work_pool.hpp"
+
+namespace {
+
+    // The binary a fixture's pytest script runs, see the conftest.py of each suite
+    enum class Pipeline { ALPHA, BETA, ARMOR };
+
+    /**
+     * One run of a fixture, as its test script makes it: the arguments of
+     * one of the conftest.py fixtures, and the AST diff dump compared with
+     * expected_output.json, whole or its "astDiff" member.
+     */
+    struct FixtureCase {
+        std::string name;
+        std::filesystem::path dir;
+        Pipeline pipeline = Pipeline::BETA;
+        LANG_OPTIONS lang = LANG_OPTIONS::CPP;
+        std::vector<std::string> includePaths;
+        bool wholeDocument = false;
+    };
+
+    struct FixtureResult {
+        nlohmann::json actual;
+        nlohmann::json expected;
+        std::string error;
+    };
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream in(path);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * The cases of every fixture under <suite>/functional whose test script
+     * compares the AST diff dump of v1/mylib.h and v2/mylib.h with
+     * expected_output.json. Checks of the test log (expected_output.txt) and
+     * of the exit code stay with pytest.
+     */
+    std::vector<FixtureCase> discoverCases() {
+        const std::pair<const char*, Pipeline> suites[] = {
+            {"alpha", Pipeline::ALPHA}, {"beta", Pipeline::BETA}, {"armor", Pipeline::ARMOR}};
+        std::vector<FixtureCase> cases;
+        for (const auto& [suite, pipeline] : suites) {
+            std::filesystem::path functional = std::filesystem::path(ARMOR_TESTS_DIR) / suite / "functional";
+            std::vector<std::filesystem::path> fixtures;
+            for (const auto& entry : std::filesystem::directory_iterator(functional)) {
+                if (std::filesystem::exists(entry.path() / "v1" / "mylib.h") &&
+                    std::filesystem::exists(entry.path() / "v2" / "mylib.h") &&
+                    std::filesystem::exists(entry.path() / "expected_output.json")) {
+                    fixtures.push_back(entry.path());
+                }
+            }
+            std::sort(fixtures.begin(), fixtures.end());
+
+            for (const std::filesystem::path& fixture : fixtures) {
+                std::string script;
+                for (const auto& entry : std::filesystem::directory_iterator(fixture)) {
+                    std::string file = entry.path().filename().string();
+                    if (file.rfind("test_", 0) == 0 && entry.path().extension() == ".py") {
+                        script += readFile(entry.path());
+                    }
+                }
+                if (script.find("ast_diff_output_mylib.h.json") == std::string::npos) {
+                    continue;
+                }
+                FixtureCase base;
+                base.dir = fixture;
+                base.pipeline = pipeline;
+                base.wholeDocument = script.find("DeepDiff(expected_json, actual_json,") != std::string::npos;
+                std::string name = std::string(suite) + "_" + fixture.filename().string();
+                // Tests take the binary, then the arguments fixture they run it with
+                auto usesArguments = [&](const std::string& arguments) {
+                    return script.find("binary_path, " + arguments + ",") != std::string::npos;
+                };
+                if (usesArguments("binary_args")) {
+                    FixtureCase cpp = base;
+                    cpp.name = name;
+                    cases.push_back(cpp);
+                }
+                if (usesArguments("binary_args_c")) {
+                    FixtureCase c = base;
+                    c.name = name + "_c";
+                    c.lang = LANG_OPTIONS::C;
+                    cases.push_back(c);
+                }
+                if (usesArguments("dependent_binary_args")) {
+                    FixtureCase dependent = base;
+                    dependent.name = name + "_dependent";
+                    dependent.includePaths = {"include"};
+                    cases.push_back(dependent);
+                }
+            }
+        }
+        return cases;
+    }
+
+    const std::vector<FixtureCase>& fixtureCases() {
+        static const std::vector<FixtureCase> cases = discoverCases();
+        return cases;
+    }
+
+    // The document the test binary of the case dumps to debug_output/ast_diffs, made in memory
+    nlohmann::json runCase(const FixtureCase& fixture) {
+        std::string root1 = (fixture.dir / "v1").string();
+        std::string root2 = (fixture.dir / "v2").string();
+        std::string file1 = root1 + "/mylib.h";
+        std::string file2 = root2 + "/mylib.h";
+        const std::vector<std::string> macros;
+
+        if (fixture.pipeline == Pipeline::BETA) {
+            ParsedHeaderPairBeta beta = parseHeaderPairBeta(root1, file1, root2, file2,
+                                                            fixture.includePaths, macros, fixture.lang);
+            return beta.context1 && beta.context2 ? diffTrees(beta.context1, beta.context2) : nlohmann::json();
+        }
+        ParsedHeaderPairAlpha alpha = parseHeaderPairAlpha(root1, file1, root2, file2,
+                                                           fixture.includePaths, macros, fixture.lang);
+        // armor_debug tries beta once alpha parsed, and reports the last parser that succeeded
+        if (fixture.pipeline == Pipeline::ARMOR && alpha.status == NO_FATAL_ERRORS) {
+            ParsedHeaderPairBeta beta = parseHeaderPairBeta(root1, file1, root2, file2,
+                                                            fixture.includePaths, macros, fixture.lang);
+            if (beta.status == NO_FATAL_ERRORS) {
+                return diffTrees(beta.context1, beta.context2);
+            }
+        }
+        return alpha.context1 && alpha.context2 ? diffTrees(alpha.context1, alpha.context2) : nlohmann::json();
+    }
+
+    // Every case is run once, all of them side by side, by the first test that asks
+    const std::vector<FixtureResult>& fixtureResults() {
+        static std::vector<FixtureResult> results;
+        static std::once_flag once;
+        std::call_once(once, [] {
+            const std::vector<FixtureCase>& cases = fixtureCases();
+            results.resize(cases.size());
+            armor::parallelFor(cases.size(), armor::resolveJobCount(0), [&](std::size_t i) {
+                FixtureResult& result = results[i];
+                try {
+                    result.expected = nlohmann::json::parse(readFile(cases[i].dir / "expected_output.json"));
+                    nlohmann::json dump = runCase(cases[i]);
+                    result.actual = cases[i].wholeDocument ? std::move(dump) : dump.value("astDiff", nlohmann::json());
+                } catch (const std::exception& e) {
+                    result.error = e.what();
+                }
+            });
+        });
+        return results;
+    }
+
+    // `json` with every array sorted, so documents compare as DeepDiff(ignore_order=True) does
+    nlohmann::json canonical(const nlohmann::json& json) {
+        if (json.is_object()) {
+            nlohmann::json sorted = nlohmann::json::object();
+            for (const auto& member : json.items()) {
+                sorted[member.key()] = canonical(member.value());
+            }
+            return sorted;
+        }
+        if (!json.is_array()) {
+            return json;
+        }
+        std::vector<std::pair<std::string, nlohmann::json>> elements;
+        for (const nlohmann::json& element : json) {
+            nlohmann::json sorted = canonical(element);
+            elements.emplace_back(sorted.dump(), std::move(sorted));
+        }
+        std::sort(elements.begin(), elements.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        nlohmann::json sorted = nlohmann::json::array();
+        for (auto& element : elements) {
+            sorted.push_back(std::move(element.second));
+        }
+        return sorted;
+    }
+
+    class FunctionalFixtureTest : public ::testing::TestWithParam<std::size_t> {};
+
+}
+
+TEST_P(FunctionalFixtureTest, AstDiffMatchesExpectedOutput) {
+    const FixtureCase& fixture = fixtureCases()[GetParam()];
+    const FixtureResult& result = fixtureResults()[GetParam()];
+    ASSERT_TRUE(result.error.empty()) << fixture.dir << ": " << result.error;
+    EXPECT_EQ(canonical(result.actual), canonical(result.expected)) << fixture.dir;
+}
+
+INSTANTIATE_TEST_SUITE_P(Fixtures, FunctionalFixtureTest,
+                         ::testing::Range<std::size_t>(0, fixtureCases().size()),
+                         [](const ::testing::TestParamInfo<std::size_t>& info) {
+                             return fixtureCases()[info.param].name;
+                         });